@@ -0,0 +1,526 @@
+// what an app embedding liblokinet gets out of it: two contexts in one process, one serving a tcp
+// echo over lokinet_inbound_stream and a udp echo over lokinet_udp_bind, the other connecting out
+// to them, for stream and flow setup latency, throughput and round trip times.
+//
+//     ./bench /path/to/bootstrap.signed --netid gamma --duration 10 --json bench.json
+//
+// run it against a local testnet or hive (and its netid) to track builds against each other;
+// setup latencies include building paths to the other context, the first one most of all.
+
+#include <lokinet.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using Lokinet_ptr = std::shared_ptr<lokinet_context>;
+
+struct Settings
+{
+  std::string bootstrap;
+  std::string netid;
+  double duration = 10;
+  size_t size = 1024;
+  int streams = 1;
+  int connections = 10;
+  double udpRate = 100;
+  uint16_t streamPort = 10001;
+  uint16_t udpPort = 10000;
+  std::string json;
+};
+
+double
+Millis(Clock::duration d)
+{
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+/// percentiles of some samples, as a json object
+std::string
+Summary(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  auto at = [&values](double q) {
+    if (values.empty())
+      return 0.0;
+    return values[std::min(values.size() - 1, static_cast<size_t>(q * values.size()))];
+  };
+  std::ostringstream ss;
+  ss << "{\"n\": " << values.size() << ", \"p50\": " << at(0.5) << ", \"p90\": " << at(0.9)
+     << ", \"p99\": " << at(0.99) << ", \"max\": " << (values.empty() ? 0 : values.back())
+     << "}";
+  return ss.str();
+}
+
+[[nodiscard]] auto
+MakeLokinet(const std::vector<char>& bootstrap)
+{
+  auto ctx = std::shared_ptr<lokinet_context>(lokinet_context_new(), lokinet_context_free);
+  if (auto err = lokinet_add_bootstrap_rc(bootstrap.data(), bootstrap.size(), ctx.get()))
+    throw std::runtime_error{strerror(err)};
+  if (lokinet_context_start(ctx.get()))
+    throw std::runtime_error{"could not start context"};
+  while (lokinet_wait_for_ready(1000, ctx.get()))
+    std::cout << "waiting for context..." << std::endl;
+  return ctx;
+}
+
+std::string
+Address(const Lokinet_ptr& ctx)
+{
+  char* addr = lokinet_address(ctx.get());
+  if (addr == nullptr)
+    throw std::runtime_error{"context has no address"};
+  std::string str{addr};
+  free(addr);
+  return str;
+}
+
+bool
+WriteAll(int fd, const char* data, size_t len)
+{
+  while (len > 0)
+  {
+    const auto n = ::send(fd, data, len, 0);
+    if (n <= 0)
+      return false;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool
+ReadAll(int fd, char* data, size_t len)
+{
+  while (len > 0)
+  {
+    const auto n = ::recv(fd, data, len, 0);
+    if (n <= 0)
+      return false;
+    data += n;
+    len -= n;
+  }
+  return true;
+}
+
+int
+Connect(const char* host, int port)
+{
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+    return -1;
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd >= 0 and ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+  {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/// echo back what every connection to 127.0.0.1:port sends, for the stream tests' far end
+void
+ServeEcho(uint16_t port)
+{
+  const int server = ::socket(AF_INET, SOCK_STREAM, 0);
+  const int on = 1;
+  ::setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::bind(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+      or ::listen(server, 64) != 0)
+    throw std::runtime_error{"could not listen on 127.0.0.1:" + std::to_string(port)};
+  std::thread{[server] {
+    int fd;
+    while ((fd = ::accept(server, nullptr, nullptr)) >= 0)
+    {
+      std::thread{[fd] {
+        char buf[16384];
+        ssize_t n;
+        while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0 and WriteAll(fd, buf, n))
+          ;
+        ::close(fd);
+      }}.detach();
+    }
+  }}.detach();
+}
+
+/// a stream to the far end's echo, from mapping it to the first byte echoed back
+struct Stream
+{
+  lokinet_context* ctx;
+  lokinet_stream_result result{};
+  int fd = -1;
+  double mapMs = 0;
+  double setupMs = 0;
+
+  Stream(lokinet_context* c, const std::string& remote) : ctx{c}
+  {
+    const auto start = Clock::now();
+    lokinet_outbound_stream(&result, remote.c_str(), nullptr, ctx);
+    if (result.error)
+      throw std::runtime_error{std::string{"could not map stream: "} + strerror(result.error)};
+    mapMs = Millis(Clock::now() - start);
+    fd = Connect(result.local_address, result.local_port);
+    char byte = 'x';
+    if (fd < 0 or not WriteAll(fd, &byte, 1) or not ReadAll(fd, &byte, 1))
+      throw std::runtime_error{"stream did not echo"};
+    setupMs = Millis(Clock::now() - start);
+  }
+
+  ~Stream()
+  {
+    if (fd >= 0)
+      ::close(fd);
+    lokinet_close_stream(result.stream_id, ctx);
+  }
+};
+
+std::string
+BenchStreams(const Settings& settings, const Lokinet_ptr& sender, const std::string& remote)
+{
+  std::vector<double> setups, maps, rtts;
+  double first = 0;
+  for (int idx = 0; idx < std::max(1, settings.connections); ++idx)
+  {
+    Stream stream{sender.get(), remote};
+    if (idx == 0)
+      first = stream.setupMs;
+    else
+      setups.push_back(stream.setupMs);
+    maps.push_back(stream.mapMs);
+  }
+  std::cout << "stream setup: first " << first << "ms" << std::endl;
+
+  {
+    Stream stream{sender.get(), remote};
+    std::vector<char> msg(64, 'r');
+    const auto until = Clock::now() + std::chrono::duration<double>{settings.duration / 2};
+    while (Clock::now() < until)
+    {
+      const auto start = Clock::now();
+      if (not WriteAll(stream.fd, msg.data(), msg.size())
+          or not ReadAll(stream.fd, msg.data(), msg.size()))
+        throw std::runtime_error{"stream closed during rtt test"};
+      rtts.push_back(Millis(Clock::now() - start));
+    }
+  }
+
+  // every stream writes for the duration on one thread and reads the echo back on another, as
+  // the echo would stall on a full window if we did not read while we wrote
+  std::vector<std::unique_ptr<Stream>> streams;
+  for (int idx = 0; idx < std::max(1, settings.streams); ++idx)
+    streams.push_back(std::make_unique<Stream>(sender.get(), remote));
+  std::atomic<uint64_t> echoed{0};
+  std::vector<std::thread> threads;
+  const auto start = Clock::now();
+  const auto until = start + std::chrono::duration<double>{settings.duration};
+  for (auto& stream : streams)
+  {
+    const int fd = stream->fd;
+    threads.emplace_back([fd, until, size = settings.size] {
+      std::vector<char> chunk(size, 't');
+      while (Clock::now() < until and WriteAll(fd, chunk.data(), chunk.size()))
+        ;
+      ::shutdown(fd, SHUT_WR);
+    });
+    // a closed write side need not reach the far end's echo, so rather than wait for it to hang
+    // up, stop reading once nothing has come back for a while
+    timeval timeout{2, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    threads.emplace_back([fd, &echoed] {
+      char buf[16384];
+      ssize_t n;
+      while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0)
+        echoed += n;
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  const auto elapsed = std::chrono::duration<double>(until - start).count();
+
+  std::ostringstream ss;
+  ss << "{\"firstSetupMs\": " << first << ", \"setupMs\": " << Summary(setups)
+     << ", \"mapMs\": " << Summary(maps) << ", \"rttMs\": " << Summary(rtts)
+     << ", \"streams\": " << streams.size() << ", \"echoedBytes\": " << echoed.load()
+     << ", \"bytesPerSec\": " << echoed / elapsed << "}";
+  return ss.str();
+}
+
+/// what the udp sender heard back.  the top bit of a packet's sequence number says which phase
+/// it was sent in: clear for the paced round trip phase, set for the flat out throughput phase
+struct Echoes
+{
+  static constexpr uint64_t Throughput = uint64_t{1} << 63;
+
+  std::mutex lock;
+  std::vector<double> rtts;
+  uint64_t received = 0;
+  uint64_t receivedBytes = 0;
+};
+
+struct Flow
+{
+  lokinet_context* ctx;
+  Echoes* echoes;
+};
+
+int
+AcceptFlow(void* user, const lokinet_udp_flowinfo*, void** flowdata, int* timeout)
+{
+  *flowdata = user;
+  *timeout = 30;
+  return 0;
+}
+
+void
+CreateOutboundFlow(void* user, void** flowdata, int* timeout)
+{
+  *flowdata = user;
+  *timeout = 30;
+}
+
+void
+DeleteFlow(const lokinet_udp_flowinfo*, void*)
+{}
+
+void
+BounceUDPPacket(const lokinet_udp_flowinfo* remote, const char* pkt, size_t len, void* flowdata)
+{
+  auto* flow = static_cast<Flow*>(flowdata);
+  lokinet_udp_flow_send(remote, pkt, len, flow->ctx);
+}
+
+void
+HandleEcho(const lokinet_udp_flowinfo*, const char* pkt, size_t len, void* flowdata)
+{
+  const auto now = Clock::now().time_since_epoch();
+  uint64_t header[2];
+  if (len < sizeof(header))
+    return;
+  std::memcpy(header, pkt, sizeof(header));
+  auto* echoes = static_cast<Flow*>(flowdata)->echoes;
+  std::lock_guard<std::mutex> lock{echoes->lock};
+  if (header[0] & Echoes::Throughput)
+  {
+    ++echoes->received;
+    echoes->receivedBytes += len;
+  }
+  else
+    echoes->rtts.push_back(Millis(now - Clock::duration{static_cast<Clock::rep>(header[1])}));
+}
+
+std::string
+BenchUDP(
+    const Settings& settings,
+    const Lokinet_ptr& recip,
+    const Lokinet_ptr& sender,
+    const std::string& recipAddr)
+{
+  static Echoes echoes;
+  static Flow bounce{recip.get(), nullptr};
+  static Flow receive{sender.get(), &echoes};
+
+  lokinet_udp_bind_result recipBind{}, senderBind{};
+  if (auto err = lokinet_udp_bind(
+          settings.udpPort,
+          AcceptFlow,
+          BounceUDPPacket,
+          DeleteFlow,
+          &bounce,
+          &recipBind,
+          recip.get()))
+    throw std::runtime_error{std::string{"could not bind udp: "} + strerror(err)};
+  if (auto err = lokinet_udp_bind(
+          settings.udpPort,
+          AcceptFlow,
+          HandleEcho,
+          DeleteFlow,
+          &receive,
+          &senderBind,
+          sender.get()))
+    throw std::runtime_error{std::string{"could not bind udp: "} + strerror(err)};
+
+  lokinet_udp_flowinfo remote{};
+  remote.socket_id = senderBind.socket_id;
+  remote.remote_port = settings.udpPort;
+  std::copy_n(
+      recipAddr.c_str(),
+      std::min(recipAddr.size(), sizeof(remote.remote_host) - 1),
+      remote.remote_host);
+
+  const auto establishStart = Clock::now();
+  while (auto err = lokinet_udp_establish(CreateOutboundFlow, &receive, &remote, sender.get()))
+  {
+    if (Clock::now() - establishStart > std::chrono::seconds{60})
+      throw std::runtime_error{std::string{"could not establish flow: "} + strerror(err)};
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+  }
+  const auto establishMs = Millis(Clock::now() - establishStart);
+  std::cout << "udp flow established in " << establishMs << "ms" << std::endl;
+
+  std::vector<char> pkt(std::max(settings.size, 2 * sizeof(uint64_t)), 'u');
+  auto send = [&](uint64_t seq) {
+    const auto now = Clock::now().time_since_epoch().count();
+    const uint64_t header[2] = {seq, static_cast<uint64_t>(now)};
+    std::memcpy(pkt.data(), header, sizeof(header));
+    return lokinet_udp_flow_send(&remote, pkt.data(), pkt.size(), sender.get()) == 0;
+  };
+
+  uint64_t paced = 0;
+  const auto interval = std::chrono::duration<double>{1 / std::max(1.0, settings.udpRate)};
+  auto next = Clock::now();
+  for (const auto until = next + std::chrono::duration<double>{settings.duration / 2};
+       Clock::now() < until;)
+  {
+    paced += send(paced);
+    next += std::chrono::duration_cast<Clock::duration>(interval);
+    std::this_thread::sleep_until(next);
+  }
+
+  uint64_t sent = 0;
+  const auto start = Clock::now();
+  for (const auto until = start + std::chrono::duration<double>{settings.duration};
+       Clock::now() < until;)
+    sent += send(Echoes::Throughput | sent);
+  // give what is in flight a moment to come back
+  std::this_thread::sleep_for(std::chrono::seconds{2});
+  const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  lokinet_udp_close(senderBind.socket_id, sender.get());
+  lokinet_udp_close(recipBind.socket_id, recip.get());
+
+  std::lock_guard<std::mutex> lock{echoes.lock};
+  std::ostringstream ss;
+  ss << "{\"establishMs\": " << establishMs << ", \"rttMs\": " << Summary(echoes.rtts)
+     << ", \"rttLoss\": " << (paced ? 1 - double(echoes.rtts.size()) / paced : 0)
+     << ", \"sent\": " << sent << ", \"received\": " << echoes.received
+     << ", \"loss\": " << (sent ? 1 - double(echoes.received) / sent : 0)
+     << ", \"packetsPerSec\": " << echoes.received / elapsed
+     << ", \"bytesPerSec\": " << echoes.receivedBytes / elapsed << "}";
+  return ss.str();
+}
+
+bool
+Parse(int argc, char* argv[], Settings& settings)
+{
+  for (int idx = 1; idx < argc; ++idx)
+  {
+    const std::string arg{argv[idx]};
+    if (arg.rfind("--", 0) != 0)
+    {
+      settings.bootstrap = arg;
+      continue;
+    }
+    if (idx + 1 == argc)
+      return false;
+    const std::string val{argv[++idx]};
+    if (arg == "--netid")
+      settings.netid = val;
+    else if (arg == "--duration")
+      settings.duration = std::stod(val);
+    else if (arg == "--size")
+      settings.size = std::stoul(val);
+    else if (arg == "--streams")
+      settings.streams = std::stoi(val);
+    else if (arg == "--connections")
+      settings.connections = std::stoi(val);
+    else if (arg == "--udp-rate")
+      settings.udpRate = std::stod(val);
+    else if (arg == "--json")
+      settings.json = val;
+    else
+      return false;
+  }
+  return not settings.bootstrap.empty();
+}
+
+int
+main(int argc, char* argv[])
+{
+  Settings settings;
+  if (not Parse(argc, argv, settings))
+  {
+    std::cout << "usage: " << argv[0]
+              << " bootstrap.signed [--netid id] [--duration seconds] [--size bytes]"
+                 " [--streams n] [--connections n] [--udp-rate pps] [--json path|-]"
+              << std::endl;
+    return 1;
+  }
+
+  std::vector<char> bootstrap;
+  {
+    std::ifstream inf{settings.bootstrap, std::ifstream::ate | std::ifstream::binary};
+    if (not inf)
+    {
+      std::cout << "cannot read " << settings.bootstrap << std::endl;
+      return 1;
+    }
+    size_t len = inf.tellg();
+    inf.seekg(0);
+    bootstrap.resize(len);
+    inf.read(bootstrap.data(), bootstrap.size());
+  }
+
+  if (auto* loglevel = getenv("LOKINET_LOG"))
+    lokinet_log_level(loglevel);
+  else
+    lokinet_log_level("none");
+  if (not settings.netid.empty())
+    lokinet_set_netid(settings.netid.c_str());
+
+  try
+  {
+    ServeEcho(settings.streamPort);
+    const auto startup = Clock::now();
+    auto recip = MakeLokinet(bootstrap);
+    auto sender = MakeLokinet(bootstrap);
+    const auto readyMs = Millis(Clock::now() - startup);
+    const auto recipAddr = Address(recip);
+    std::cout << "contexts ready in " << readyMs << "ms, far end at " << recipAddr << std::endl;
+    if (lokinet_inbound_stream(settings.streamPort, recip.get()) < 0)
+      throw std::runtime_error{"could not accept inbound streams"};
+
+    const auto stream = BenchStreams(
+        settings, sender, recipAddr + ":" + std::to_string(settings.streamPort));
+    const auto udp = BenchUDP(settings, recip, sender, recipAddr);
+
+    std::ostringstream out;
+    out << "{\"duration\": " << settings.duration << ", \"size\": " << settings.size
+        << ", \"readyMs\": " << readyMs << ", \"stream\": " << stream << ", \"udp\": " << udp
+        << "}";
+    if (settings.json == "-" or settings.json.empty())
+      std::cout << out.str() << std::endl;
+    else
+      std::ofstream{settings.json} << out.str() << std::endl;
+  }
+  catch (const std::exception& ex)
+  {
+    std::cout << "bench failed: " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -1,12 +1,20 @@
 #include <cpr/cpr.h>
+#include <llarp/bootstrap.hpp>
 #include <llarp/constants/files.hpp>
 #include <llarp/constants/version.hpp>
+#include <llarp/crypto/crypto.hpp>
+#include <llarp/crypto/crypto_libsodium.hpp>
 #include <llarp/util/buffer.hpp>
 #include <llarp/util/fs.hpp>
 
+#include <atomic>
 #include <fstream>
-#include <sstream>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 #include <unordered_map>
 #include <unordered_set>
@@ -15,12 +23,6 @@
 #include <openssl/x509.h>
 #endif
 
-#include <sstream>
-
-#ifndef _WIN32
-#include <openssl/x509.h>
-#endif
-
 namespace
 {
   int
@@ -43,12 +45,89 @@ Usage: )" << exe
 
 bootstrap_url can be specified as a full URL, or a special named value
 ("mainnet" or "testnet") to download from the pre-defined mainnet or testnet
-bootstrap URLs.
+bootstrap URLs.  Several URLs may be given, separated by commas: all of them
+are fetched at once, and the first to come in whole with signed RCs is kept.
 
 )";
     return 0;
   }
 
+  /// what came of fetching a bootstrap file from one url
+  struct Fetch
+  {
+    std::string url;
+    std::string data;
+    llarp::BootstrapStream stream;
+    std::string error;
+  };
+
+  /// fetches every url at once, checking each rc as it comes in; returns the first to come in
+  /// whole with an rc we could use, and gives up on the others then
+  std::optional<std::string>
+  fetch_first(const std::vector<std::string>& urls)
+  {
+    std::vector<Fetch> fetches(urls.size());
+    std::atomic<bool> done{false};
+    std::optional<std::string> result;
+    std::mutex resultMutex;
+    std::vector<std::thread> threads;
+    for (size_t idx = 0; idx < urls.size(); ++idx)
+    {
+      auto& fetch = fetches[idx];
+      fetch.url = urls[idx];
+      threads.emplace_back([&fetch, &done, &result, &resultMutex] {
+        // generic, as what cpr passes callbacks differs between its versions
+        const cpr::WriteCallback onData{[&fetch, &done](const auto& data, auto&&...) -> bool {
+          if (done)
+            return false;
+          fetch.data += data;
+          return fetch.stream.Feed(data);
+        }};
+        // called while waiting on a slow server too, so that one doesn't hold us up
+        const cpr::ProgressCallback onProgress{[&done](auto&&...) -> bool { return not done; }};
+        const cpr::Header header{{"User-Agent", std::string{llarp::VERSION_FULL}}};
+        const cpr::Response resp =
+#ifdef _WIN32
+            cpr::Get(cpr::Url{fetch.url}, header, onData, onProgress);
+#else
+            cpr::Get(
+                cpr::Url{fetch.url},
+                header,
+                cpr::Ssl(cpr::ssl::CaPath{X509_get_default_cert_dir()}),
+                onData,
+                onProgress);
+#endif
+        if (resp.status_code != 200)
+          fetch.error = "HTTP " + std::to_string(resp.status_code);
+        else if (fetch.stream.Failed())
+          fetch.error = "invalid bootstrap file content";
+        else if (not fetch.stream.Complete())
+          fetch.error = "bootstrap file cut short";
+        else if (fetch.stream.RCs().empty())
+          fetch.error = "no validly signed RCs in bootstrap file";
+        else
+        {
+          std::lock_guard lock{resultMutex};
+          if (not done.exchange(true))
+            result = std::move(fetch.data);
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+
+    for (const auto& fetch : fetches)
+    {
+      if (not fetch.error.empty() and not done)
+        std::cout << "failed to fetch '" << fetch.url << "': " << fetch.error << std::endl;
+      else if (fetch.error.empty())
+        std::cout << "fetched " << fetch.stream.RCs().size() << " RCs from " << fetch.url
+                  << (fetch.stream.Rejected() ? ", leaving out badly signed ones" : "")
+                  << std::endl;
+    }
+    return result;
+  }
+
 }  // namespace
 
 int
@@ -87,38 +166,38 @@ main(int argc, char* argv[])
   {
     outputfile = fs::path{argv[2]};
   }
-  std::cout << "fetching " << bootstrap_url << std::endl;
-  cpr::Response resp =
-#ifdef _WIN32
-      cpr::Get(
-          cpr::Url{bootstrap_url}, cpr::Header{{"User-Agent", std::string{llarp::VERSION_FULL}}});
-#else
-      cpr::Get(
-          cpr::Url{bootstrap_url},
-          cpr::Header{{"User-Agent", std::string{llarp::VERSION_FULL}}},
-          cpr::Ssl(cpr::ssl::CaPath{X509_get_default_cert_dir()}));
-#endif
-  if (resp.status_code != 200)
+  std::vector<std::string> urls;
+  for (size_t pos = 0; pos <= bootstrap_url.size();)
   {
-    return fail("failed to fetch '" + bootstrap_url + "' HTTP " + std::to_string(resp.status_code));
+    auto end = bootstrap_url.find(',', pos);
+    if (end == std::string::npos)
+      end = bootstrap_url.size();
+    if (end > pos)
+      urls.push_back(bootstrap_url.substr(pos, end - pos));
+    pos = end + 1;
   }
-  std::stringstream ss;
-  ss << resp.text;
-  std::string data{ss.str()};
-  if (data[0] == 'l' or data[0] == 'd')
+  if (urls.empty())
+    return fail("no bootstrap url given");
+
+  // to check the rcs' signatures with
+  llarp::sodium::CryptoLibSodium crypto;
+  llarp::CryptoManager cryptoManager{&crypto};
+
+  for (const auto& url : urls)
+    std::cout << "fetching " << url << std::endl;
+  const auto data = fetch_first(urls);
+  if (not data)
+    return fail("could not fetch a bootstrap file");
+  try
   {
-    try
-    {
-      std::cout << "writing bootstrap file to: " << outputfile << std::endl;
-      fs::ofstream ofs{outputfile, std::ios::binary};
-      ofs.exceptions(fs::ofstream::failbit);
-      ofs << data;
-      return 0;
-    }
-    catch (std::exception& ex)
-    {
-      return fail(std::string{"failed to write bootstrap file: "} + ex.what());
-    }
+    std::cout << "writing bootstrap file to: " << outputfile << std::endl;
+    fs::ofstream ofs{outputfile, std::ios::binary};
+    ofs.exceptions(fs::ofstream::failbit);
+    ofs << *data;
+    return 0;
+  }
+  catch (std::exception& ex)
+  {
+    return fail(std::string{"failed to write bootstrap file: "} + ex.what());
   }
-  return fail("got invalid bootstrap file content");
 }
@@ -13,6 +13,7 @@ namespace llarp
   namespace vpn
   {
     class Platform;
+    struct AndroidRings;
   }
 
   class EventLoop;
@@ -101,6 +102,8 @@ namespace llarp
     makeVPNPlatform();
 
     int androidFD = -1;
+    /// when set, the android vpn moves packets through these rather than androidFD
+    std::shared_ptr<vpn::AndroidRings> androidRings;
 
    protected:
     std::shared_ptr<Config> config = nullptr;
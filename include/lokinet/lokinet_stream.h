@@ -54,6 +54,61 @@ extern "C"
   void EXPORT
   lokinet_close_stream(int stream_id, struct lokinet_context* context);
 
+  /// callbacks for a direct stream, whose data goes to and from the app in process rather than
+  /// through a local tcp socket.  all are called on the lokinet thread and must not block; they
+  /// may call lokinet_direct_stream_write and lokinet_direct_stream_close.
+  struct lokinet_stream_callbacks
+  {
+    /// called once the stream is connected end to end, with error 0, or with an errno value if it
+    /// could not be
+    void (*on_open)(int stream_id, int error, void* user);
+    /// called with data from the remote, which is only valid for the duration of the call
+    void (*on_data)(int stream_id, const char* data, size_t len, void* user);
+    /// called once a stream lokinet_direct_stream_write refused with EAGAIN can take more; may
+    /// be null
+    void (*on_writable)(int stream_id, void* user);
+    /// called once when an open stream closes; error is 0 for a graceful close, otherwise the
+    /// error code the remote closed it with
+    void (*on_close)(int stream_id, uint64_t error, void* user);
+    /// passed to each of the above
+    void* user;
+  };
+
+  /// connect out to a remote endpoint like lokinet_outbound_stream, but as a direct stream with
+  /// callbacks.  remoteAddr is in the form of "name:port".  does not wait for the stream to open;
+  /// on_open says when it has.  on success result's stream_id is the id for
+  /// lokinet_direct_stream_write and lokinet_direct_stream_close, and its local address and port
+  /// are left empty.
+  void EXPORT
+  lokinet_direct_stream_open(
+      struct lokinet_stream_result* result,
+      const char* remoteAddr,
+      const struct lokinet_stream_callbacks* callbacks,
+      struct lokinet_context* context);
+
+  /// accept inbound streams like lokinet_inbound_stream_filter, but as direct streams with
+  /// callbacks: each one acceptFilter accepts gets a stream id of its own, given to on_open.
+  /// returns an id for lokinet_close_stream to stop accepting them, or -1 on error
+  int EXPORT
+  lokinet_direct_stream_listen(
+      lokinet_stream_filter acceptFilter,
+      void* user,
+      const struct lokinet_stream_callbacks* callbacks,
+      struct lokinet_context* context);
+
+  /// queue data to send on an open direct stream, copying it.  may be called from any thread.
+  /// returns 0 on success, EAGAIN if the stream has too much in flight to take more (none of it
+  /// is queued, and on_writable is called once it has room), ENOTCONN if the stream is not open,
+  /// or EBADF if there is no such stream
+  int EXPORT
+  lokinet_direct_stream_write(
+      int stream_id, const void* data, size_t len, struct lokinet_context* context);
+
+  /// close a direct stream gracefully, once what was written to it has been sent.  closing one
+  /// still opening means it is closed as soon as it opens, with no more callbacks
+  void EXPORT
+  lokinet_direct_stream_close(int stream_id, struct lokinet_context* context);
+
 #ifdef __cplusplus
 }
 #endif
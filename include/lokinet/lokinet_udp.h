@@ -25,6 +25,30 @@ extern "C"
     int socket_id;
   };
 
+  /// one datagram to send with lokinet_udp_flow_send_many
+  struct lokinet_udp_packet
+  {
+    /// pointer to the data to send
+    const void* data;
+    /// the length of the data
+    size_t len;
+  };
+
+  /// a buffer for lokinet_udp_recv_many to receive one datagram into
+  struct lokinet_udp_datagram
+  {
+    /// set to the flow the datagram came in on
+    struct lokinet_udp_flowinfo remote;
+    /// set to the flow's user data, as given by the flow filter
+    void* flow_userdata;
+    /// caller provided buffer to copy the datagram into
+    char* data;
+    /// the size of data; datagrams larger than this are truncated to it
+    size_t capacity;
+    /// set to the length of what was copied into data
+    size_t len;
+  };
+
   /// flow acceptor hook, return 0 success, return nonzero with errno on failure
   typedef int (*lokinet_udp_flow_filter)(
       void* userdata,
@@ -108,6 +132,82 @@ extern "C"
       size_t len,
       struct lokinet_context* ctx);
 
+  /// @brief send many datagrams on an established flow to remote endpoint
+  /// blocks until we have sent them, with one hop onto the lokinet thread for all of them
+  ///
+  /// @param remote remote flow to use for sending
+  ///
+  /// @param pkts the datagrams to send
+  ///
+  /// @param num how many datagrams pkts holds
+  ///
+  /// @param sent if not null, set to how many of the datagrams were sent, in order from the first
+  ///
+  /// @param ctx the lokinet context to use
+  ///
+  /// @returns 0 if all of them were sent and non zero errno on fail
+  int EXPORT
+  lokinet_udp_flow_send_many(
+      const struct lokinet_udp_flowinfo* remote,
+      const struct lokinet_udp_packet* pkts,
+      size_t num,
+      size_t* sent,
+      struct lokinet_context* ctx);
+
+  /// @brief inbound listen udp socket whose datagrams are queued for lokinet_udp_recv_many
+  /// rather than handed to a callback on the lokinet thread one at a time
+  ///
+  /// like lokinet_udp_bind, with filter and timeout working the same
+  ///
+  /// @param queue_size the most datagrams we hold for the app; ones past it are dropped until
+  /// the app receives some
+  ///
+  /// @returns nonzero on error in which it is an errno value
+  int EXPORT
+  lokinet_udp_bind_polled(
+      uint16_t exposedPort,
+      lokinet_udp_flow_filter filter,
+      lokinet_udp_flow_timeout_func timeout,
+      void* user,
+      size_t queue_size,
+      struct lokinet_udp_bind_result* result,
+      struct lokinet_context* ctx);
+
+  /// @brief receive queued datagrams from a socket bound with lokinet_udp_bind_polled
+  /// does not block
+  ///
+  /// @param socket_id the bound udp socket's id
+  ///
+  /// @param datagrams buffers to receive into, with data and capacity set by the caller
+  ///
+  /// @param num how many buffers datagrams holds
+  ///
+  /// @param received set to how many datagrams were received, 0 if none were queued
+  ///
+  /// @param ctx lokinet context
+  ///
+  /// @returns 0 on success and non zero errno on fail
+  int EXPORT
+  lokinet_udp_recv_many(
+      int socket_id,
+      struct lokinet_udp_datagram* datagrams,
+      size_t num,
+      size_t* received,
+      struct lokinet_context* ctx);
+
+  /// @brief get a file descriptor that polls readable while a polled socket has datagrams
+  /// queued, for apps to wait on in their own event loop before calling lokinet_udp_recv_many.
+  /// owned by the socket, and closed with it.
+  ///
+  /// @param socket_id the bound udp socket's id
+  ///
+  /// @param ctx lokinet context
+  ///
+  /// @returns the file descriptor, or -1 if the socket is not polled or the platform has no
+  /// eventfd, in which case apps call lokinet_udp_recv_many on their own schedule
+  int EXPORT
+  lokinet_udp_poll_fd(int socket_id, struct lokinet_context* ctx);
+
   /// @brief close a bound udp socket
   /// closes all flows immediately
   ///
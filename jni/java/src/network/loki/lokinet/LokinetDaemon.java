@@ -28,6 +28,19 @@ public class LokinetDaemon extends VpnService
 
   public native String DumpStatus();
 
+  // batched mode: instead of InjectVPNFD, InjectVPNRings(slots) before Configure sets up a ring
+  // of slots each way, shared with lokinet in m_InRing and m_OutRing.  a slot is RingSlotSize()
+  // bytes, slot N at (N % slots) * RingSlotSize(): a native order int length then the packet.
+  // put packets into m_InRing from where you left off and hand them over a batch at a time with
+  // SubmitPackets(n), which returns how many slots are free; take packets out of m_OutRing from
+  // where you left off, handing back what you took with ReceivePackets(taken, timeoutMs), which
+  // waits up to the timeout for more and returns how many there are.  the rings' memory goes with
+  // impl, so drop them before Free.
+  private static native int RingSlotSize();
+  public native boolean InjectVPNRings(int slots);
+  public native int SubmitPackets(int count);
+  public native int ReceivePackets(int consumed, int timeoutMs);
+
 
   public static final String LOG_TAG = "LokinetDaemon";
 
@@ -35,6 +48,8 @@ public class LokinetDaemon extends VpnService
   ParcelFileDescriptor iface;
   int m_FD = -1;
   int m_UDPSocket = -1;
+  ByteBuffer m_InRing = null;
+  ByteBuffer m_OutRing = null;
 
   @Override
     public void onCreate()
@@ -3,6 +3,9 @@
 #include <llarp.hpp>
 #include <llarp/config/config.hpp>
 #include <llarp/router/abstractrouter.hpp>
+#include <llarp/vpn/packet_ring.hpp>
+
+#include <poll.h>
 
 extern "C"
 {
@@ -81,6 +84,64 @@ extern "C"
       ptr->androidFD = GetObjectMemberAsInt<int>(env, self, "m_FD");
   }
 
+  JNIEXPORT jint JNICALL
+  Java_network_loki_lokinet_LokinetDaemon_RingSlotSize(JNIEnv*, jclass)
+  {
+    return llarp::vpn::PacketRing::SlotSize;
+  }
+
+  JNIEXPORT jboolean JNICALL
+  Java_network_loki_lokinet_LokinetDaemon_InjectVPNRings(JNIEnv* env, jobject self, jint slots)
+  {
+    auto ptr = GetImpl<llarp::Context>(env, self);
+    if (ptr == nullptr or slots <= 0)
+      return JNI_FALSE;
+    try
+    {
+      ptr->androidRings = std::make_shared<llarp::vpn::AndroidRings>(slots);
+    }
+    catch (...)
+    {
+      return JNI_FALSE;
+    }
+    auto& rings = *ptr->androidRings;
+    SetObjectMemberAsBuffer(
+        env, self, "m_InRing", env->NewDirectByteBuffer(rings.in.Data(), rings.in.Bytes()));
+    SetObjectMemberAsBuffer(
+        env, self, "m_OutRing", env->NewDirectByteBuffer(rings.out.Data(), rings.out.Bytes()));
+    return JNI_TRUE;
+  }
+
+  JNIEXPORT jint JNICALL
+  Java_network_loki_lokinet_LokinetDaemon_SubmitPackets(JNIEnv* env, jobject self, jint count)
+  {
+    auto ptr = GetImpl<llarp::Context>(env, self);
+    if (ptr == nullptr or not ptr->androidRings)
+      return -1;
+    auto& ring = ptr->androidRings->in;
+    ring.Publish(std::min<uint32_t>(std::max(count, 0), ring.Free()));
+    return ring.Free();
+  }
+
+  JNIEXPORT jint JNICALL
+  Java_network_loki_lokinet_LokinetDaemon_ReceivePackets(
+      JNIEnv* env, jobject self, jint consumed, jint timeoutMs)
+  {
+    auto ptr = GetImpl<llarp::Context>(env, self);
+    if (ptr == nullptr or not ptr->androidRings)
+      return -1;
+    auto& ring = ptr->androidRings->out;
+    if (auto avail = ring.Release(std::min<uint32_t>(std::max(consumed, 0), ring.Available())))
+      return avail;
+    // clear first and look again, so that what is put in after we look wakes us
+    ring.ClearWakeup();
+    if (auto avail = ring.Available())
+      return avail;
+    pollfd pfd{ring.PollFD(), POLLIN, 0};
+    ::poll(&pfd, 1, timeoutMs);
+    return ring.Available();
+  }
+
   JNIEXPORT jint JNICALL
   Java_network_loki_lokinet_LokinetDaemon_GetUDPSocket(JNIEnv* env, jobject self)
   {
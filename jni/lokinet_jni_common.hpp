@@ -49,6 +49,15 @@ FromObjectMember(JNIEnv* env, jobject self, const char* membername)
   return FromBuffer<T>(env, buffer);
 }
 
+/// set object member called membername to a ByteBuffer
+static void
+SetObjectMemberAsBuffer(JNIEnv* env, jobject self, const char* membername, jobject buffer)
+{
+  jclass cl = env->GetObjectClass(self);
+  jfieldID name = env->GetFieldID(cl, membername, "Ljava/nio/ByteBuffer;");
+  env->SetObjectField(self, name, buffer);
+}
+
 /// visit object string member called membername as bytes
 template <typename T, typename V>
 static T
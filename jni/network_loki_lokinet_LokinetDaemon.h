@@ -88,6 +88,38 @@ extern "C"
   JNIEXPORT jstring JNICALL
   Java_network_loki_lokinet_LokinetDaemon_DumpStatus(JNIEnv*, jobject);
 
+  /*
+   * Class:     network_loki_lokinet_LokinetDaemon
+   * Method:    RingSlotSize
+   * Signature: ()I
+   */
+  JNIEXPORT jint JNICALL
+  Java_network_loki_lokinet_LokinetDaemon_RingSlotSize(JNIEnv*, jclass);
+
+  /*
+   * Class:     network_loki_lokinet_LokinetDaemon
+   * Method:    InjectVPNRings
+   * Signature: (I)Z
+   */
+  JNIEXPORT jboolean JNICALL
+  Java_network_loki_lokinet_LokinetDaemon_InjectVPNRings(JNIEnv*, jobject, jint);
+
+  /*
+   * Class:     network_loki_lokinet_LokinetDaemon
+   * Method:    SubmitPackets
+   * Signature: (I)I
+   */
+  JNIEXPORT jint JNICALL
+  Java_network_loki_lokinet_LokinetDaemon_SubmitPackets(JNIEnv*, jobject, jint);
+
+  /*
+   * Class:     network_loki_lokinet_LokinetDaemon
+   * Method:    ReceivePackets
+   * Signature: (II)I
+   */
+  JNIEXPORT jint JNICALL
+  Java_network_loki_lokinet_LokinetDaemon_ReceivePackets(JNIEnv*, jobject, jint, jint);
+
 #ifdef __cplusplus
 }
 #endif
@@ -40,14 +40,22 @@ nslogger(const char* msg)
 }
 
 static void
-packet_writer(int af, const void* data, size_t size, void* ctx)
+packet_writer(const llarp_outgoing_packet* packets, size_t count, void* ctx)
 {
-  if (ctx == nil || data == nil)
+  if (ctx == nil || packets == nil || count == 0)
     return;
 
-  NSData* buf = [NSData dataWithBytesNoCopy:(void*)data length:size freeWhenDone:NO];
+  NSMutableArray<NSData*>* bufs = [NSMutableArray arrayWithCapacity:count];
+  NSMutableArray<NSNumber*>* protos = [NSMutableArray arrayWithCapacity:count];
+  for (size_t i = 0; i < count; i++)
+  {
+    [bufs addObject:[NSData dataWithBytesNoCopy:(void*)packets[i].bytes
+                                         length:packets[i].size
+                                   freeWhenDone:NO]];
+    [protos addObject:[NSNumber numberWithInt:packets[i].af]];
+  }
   LLARPPacketTunnel* t = (__bridge LLARPPacketTunnel*)ctx;
-  [t.packetFlow writePackets:@[buf] withProtocols:@[[NSNumber numberWithInt:af]]];
+  [t.packetFlow writePackets:bufs withProtocols:protos];
 }
 
 static void
@@ -123,10 +123,16 @@ llarp_apple_start(void* lokinet, void* callback_context)
 
   inst->context.callback_context = callback_context;
 
-  inst->context.m_PacketWriter = [inst, callback_context](int af_family, void* data, size_t size) {
-    inst->packet_writer(af_family, data, size, callback_context);
-    return true;
-  };
+  inst->context.m_PacketWriter =
+      [inst, callback_context, out = std::vector<llarp_outgoing_packet>{}](
+          const std::vector<llarp::net::IPPacket>& pkts) mutable {
+        // only ever called from the event loop, so one array serves every batch
+        out.clear();
+        for (const auto& pkt : pkts)
+          out.push_back({pkt.IsV6() ? AF_INET6 : AF_INET, pkt.data(), pkt.size()});
+        inst->packet_writer(out.data(), out.size(), callback_context);
+        return true;
+      };
 
   inst->context.m_OnReadable = [inst, callback_context](llarp::apple::VPNInterface& iface) {
     inst->iface = iface.weak_from_this();
@@ -180,16 +186,19 @@ llarp_apple_incoming(void* lokinet, const llarp_incoming_packet* packets, size_t
   if (!iface)
     return -1;
 
-  int count = 0;
+  std::vector<llarp::net::IPPacket> pkts;
+  pkts.reserve(size);
   for (size_t i = 0; i < size; i++)
   {
     llarp_buffer_t buf{static_cast<const uint8_t*>(packets[i].bytes), packets[i].size};
-    if (iface->OfferReadPacket(buf))
-      count++;
+    if (llarp::net::IPPacket pkt; pkt.Load(buf))
+      pkts.emplace_back(std::move(pkt));
     else
       llarp::LogError("invalid IP packet: ", llarp::buffer_printer(buf));
   }
 
+  const int count = pkts.size();
+  iface->OfferReadPackets(std::move(pkts));
   iface->MaybeWakeUpperLayers();
   return count;
 }
@@ -16,8 +16,18 @@ extern "C"
   // when in exit mode.
   extern const uint16_t dns_trampoline_port;
 
-  /// C callback function for us to invoke when we need to write a packet
-  typedef void (*packet_writer_callback)(int af, const void* data, size_t size, void* ctx);
+  /// Struct of packet data; a C array of these gets passed to the packet writer callback
+  typedef struct llarp_outgoing_packet
+  {
+    int af;
+    const void* bytes;
+    size_t size;
+  } llarp_outgoing_packet;
+
+  /// C callback function for us to invoke when we need to write packets, with as many as we have
+  /// to write at once; the packet data is only valid for the duration of the call
+  typedef void (*packet_writer_callback)(
+      const llarp_outgoing_packet* packets, size_t count, void* ctx);
 
   /// C callback function to invoke once we are ready to start receiving packets
   typedef void (*start_reading_callback)(void* ctx);
@@ -97,9 +107,9 @@ extern "C"
     /// simple wrapper around NSLog for lokinet message logging
     ns_logger_callback ns_logger;
 
-    /// C function callback that will be called when we need to write a packet to the packet
-    /// tunnel.  Will be passed AF_INET or AF_INET6, a void pointer to the data, and the size of
-    /// the data in bytes.
+    /// C function callback that will be called when we need to write packets to the packet
+    /// tunnel.  Will be passed a C array of packets, each with AF_INET or AF_INET6, a void
+    /// pointer to the data, and the size of the data in bytes, and how many there are.
     packet_writer_callback packet_writer;
 
     /// C function callback that will be called when lokinet is setup and ready to start receiving
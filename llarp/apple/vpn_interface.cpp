@@ -19,13 +19,11 @@ namespace llarp::apple
   }
 
   bool
-  VPNInterface::OfferReadPacket(const llarp_buffer_t& buf)
+  VPNInterface::OfferReadPackets(std::vector<net::IPPacket> pkts)
   {
-    llarp::net::IPPacket pkt;
-    if (!pkt.Load(buf))
-      return false;
-    m_ReadQueue.tryPushBack(std::move(pkt));
-    return true;
+    if (pkts.empty())
+      return true;
+    return m_ReadQueue.tryPushBack(std::move(pkts)) == thread::QueueReturn::Success;
   }
 
   void
@@ -43,17 +41,47 @@ namespace llarp::apple
   net::IPPacket
   VPNInterface::ReadNextPacket()
   {
-    net::IPPacket pkt{};
-    if (not m_ReadQueue.empty())
-      pkt = m_ReadQueue.popFront();
-    return pkt;
+    std::vector<net::IPPacket> one;
+    if (ReadPackets(one, 1) == 0)
+      return net::IPPacket{};
+    return std::move(one.front());
+  }
+
+  size_t
+  VPNInterface::ReadPackets(std::vector<net::IPPacket>& into, size_t max)
+  {
+    size_t n = 0;
+    while (n < max)
+    {
+      if (m_ReadingAt == m_Reading.size())
+      {
+        auto maybe = m_ReadQueue.tryPopFront();
+        if (not maybe)
+          break;
+        m_Reading = std::move(*maybe);
+        m_ReadingAt = 0;
+        continue;
+      }
+      into.emplace_back(std::move(m_Reading[m_ReadingAt++]));
+      ++n;
+    }
+    return n;
   }
 
   bool
   VPNInterface::WritePacket(net::IPPacket pkt)
   {
-    int af_family = pkt.IsV6() ? AF_INET6 : AF_INET;
-    return m_PacketWriter(af_family, pkt.data(), pkt.size());
+    std::vector<net::IPPacket> one;
+    one.emplace_back(std::move(pkt));
+    return WritePackets(one) == 1;
+  }
+
+  size_t
+  VPNInterface::WritePackets(std::vector<net::IPPacket>& pkts)
+  {
+    if (pkts.empty() or not m_PacketWriter(pkts))
+      return 0;
+    return pkts.size();
   }
 
 }  // namespace llarp::apple
@@ -4,6 +4,7 @@
 #include <llarp/vpn/platform.hpp>
 #include <llarp/util/thread/queue.hpp>
 #include <memory>
+#include <vector>
 
 namespace llarp::apple
 {
@@ -13,7 +14,8 @@ namespace llarp::apple
                              public std::enable_shared_from_this<VPNInterface>
   {
    public:
-    using packet_write_callback = std::function<bool(int af_family, void* data, int size)>;
+    /// hands the packets to the OS all at once; should return true if they were handed off
+    using packet_write_callback = std::function<bool(const std::vector<net::IPPacket>& pkts)>;
     using on_readable_callback = std::function<void(VPNInterface&)>;
 
     explicit VPNInterface(
@@ -22,9 +24,9 @@ namespace llarp::apple
         on_readable_callback on_readable,
         AbstractRouter* router);
 
-    // Method to call when a packet has arrived to deliver the packet to lokinet
+    // Method to call when packets have arrived to deliver them to lokinet, all at once
     bool
-    OfferReadPacket(const llarp_buffer_t& buf);
+    OfferReadPackets(std::vector<net::IPPacket> pkts);
 
     int
     PollFD() const override;
@@ -32,9 +34,15 @@ namespace llarp::apple
     net::IPPacket
     ReadNextPacket() override;
 
+    size_t
+    ReadPackets(std::vector<net::IPPacket>& into, size_t max) override;
+
     bool
     WritePacket(net::IPPacket pkt) override;
 
+    size_t
+    WritePackets(std::vector<net::IPPacket>& pkts) override;
+
     void
     MaybeWakeUpperLayers() const override;
 
@@ -46,9 +54,14 @@ namespace llarp::apple
     // Called when we are ready to start reading packets
     on_readable_callback m_OnReadable;
 
-    static inline constexpr auto PacketQueueSize = 1024;
+    // Batches of packets, as many as came in one read off the packet tunnel each
+    static inline constexpr auto BatchQueueSize = 64;
+
+    thread::Queue<std::vector<net::IPPacket>> m_ReadQueue{BatchQueueSize};
 
-    thread::Queue<net::IPPacket> m_ReadQueue{PacketQueueSize};
+    // The batch ReadPackets is taking packets from, and how far it has got; event loop only
+    std::vector<net::IPPacket> m_Reading;
+    size_t m_ReadingAt = 0;
 
     AbstractRouter* const _router;
   };
@@ -4,8 +4,154 @@
 #include "util/logging/buffer.hpp"
 #include "util/fs.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <optional>
+
 namespace llarp
 {
+  namespace
+  {
+    /// how long the first bencoded value in data is, or nullopt if it goes on past its end;
+    /// throws if it can't be bencode
+    std::optional<size_t>
+    BencodeExtent(std::string_view data)
+    {
+      size_t pos = 0;
+      size_t depth = 0;
+      do
+      {
+        if (pos >= data.size())
+          return std::nullopt;
+        const char c = data[pos];
+        if (c == 'l' or c == 'd')
+        {
+          ++depth;
+          ++pos;
+        }
+        else if (c == 'e')
+        {
+          if (depth == 0)
+            throw std::invalid_argument{"unexpected end of bencoded list"};
+          --depth;
+          ++pos;
+        }
+        else if (c == 'i')
+        {
+          const auto end = data.find('e', pos);
+          if (end == std::string_view::npos)
+            return std::nullopt;
+          pos = end + 1;
+        }
+        else if (std::isdigit(static_cast<unsigned char>(c)))
+        {
+          // far longer than anything in an rc
+          constexpr size_t MaxLengthDigits = 8;
+          const auto colon = data.find(':', pos);
+          if (std::min(colon, data.size()) - pos > MaxLengthDigits)
+            throw std::invalid_argument{"bad string length"};
+          if (colon == std::string_view::npos)
+            return std::nullopt;
+          size_t len = 0;
+          for (auto i = pos; i < colon; ++i)
+          {
+            if (not std::isdigit(static_cast<unsigned char>(data[i])))
+              throw std::invalid_argument{"bad string length"};
+            len = len * 10 + (data[i] - '0');
+          }
+          pos = colon + 1 + len;
+          if (pos > data.size())
+            return std::nullopt;
+        }
+        else
+          throw std::invalid_argument{"not bencode"};
+      } while (depth > 0);
+      return pos;
+    }
+  }  // namespace
+
+  bool
+  BootstrapStream::Feed(std::string_view chunk)
+  {
+    if (m_State == State::Failed)
+      return false;
+    m_Pending.append(chunk);
+    try
+    {
+      while (not m_Pending.empty())
+      {
+        switch (m_State)
+        {
+          case State::Start:
+            if (m_Pending[0] == 'l')
+            {
+              m_State = State::List;
+              m_Pending.erase(0, 1);
+            }
+            else if (m_Pending[0] == 'd')
+              m_State = State::Single;
+            else
+              throw std::invalid_argument{"bootstrap file is neither a list nor an rc"};
+            break;
+          case State::List:
+            if (m_Pending[0] == 'e')
+            {
+              m_State = State::Done;
+              m_Pending.erase(0, 1);
+              break;
+            }
+            [[fallthrough]];
+          case State::Single: {
+            const auto extent = BencodeExtent(m_Pending);
+            if (not extent)
+            {
+              if (m_Pending.size() > MAX_RC_SIZE)
+                throw std::invalid_argument{"rc in bootstrap file is too big"};
+              return true;
+            }
+            if (not TakeRC(*extent))
+              throw std::invalid_argument{"bootstrap file holds something that is not an rc"};
+            if (m_State == State::Single)
+              m_State = State::Done;
+            break;
+          }
+          case State::Done:
+            throw std::invalid_argument{"bootstrap file goes on past its end"};
+          case State::Failed:
+            return false;
+        }
+      }
+    }
+    catch (const std::exception& ex)
+    {
+      LogError("invalid bootstrap file: ", ex.what());
+      m_State = State::Failed;
+      m_Pending.clear();
+      return false;
+    }
+    return true;
+  }
+
+  bool
+  BootstrapStream::TakeRC(size_t size)
+  {
+    if (size > MAX_RC_SIZE)
+      return false;
+    RouterContact rc{};
+    llarp_buffer_t buf{m_Pending.data(), size};
+    if (not rc.BDecode(&buf))
+      return false;
+    m_Pending.erase(0, size);
+    if (rc.VerifySignature())
+      m_RCs.emplace(std::move(rc));
+    else
+    {
+      LogWarn("bootstrap rc ", RouterID{rc.pubkey}, " is not signed right, leaving it out");
+      ++m_Rejected;
+    }
+    return true;
+  }
+
   void
   BootstrapList::Clear()
   {
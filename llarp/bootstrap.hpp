@@ -2,6 +2,8 @@
 
 #include "router_contact.hpp"
 #include <set>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include "llarp/util/fs.hpp"
 
@@ -22,6 +24,67 @@ namespace llarp
     Clear();
   };
 
+  /// decodes a bootstrap file (a bencoded list of rcs, or a single rc) a chunk at a time as it
+  /// downloads, checking the signature of each rc as soon as all of it is in: so that a bad
+  /// download is given up on at the first byte that can't be right, rather than once all of it
+  /// came in.  rcs that don't verify are left out, while anything that doesn't decode fails the
+  /// whole file.
+  class BootstrapStream
+  {
+   public:
+    /// takes the next chunk; false if the file can't be a bootstrap file, after which any more
+    /// is refused too
+    bool
+    Feed(std::string_view chunk);
+
+    /// true once the end of the list (or the single rc) came in
+    bool
+    Complete() const
+    {
+      return m_State == State::Done;
+    }
+
+    bool
+    Failed() const
+    {
+      return m_State == State::Failed;
+    }
+
+    /// the rcs that came in whole and signed so far
+    const BootstrapList&
+    RCs() const
+    {
+      return m_RCs;
+    }
+
+    /// how many rcs came in that weren't signed right
+    size_t
+    Rejected() const
+    {
+      return m_Rejected;
+    }
+
+   private:
+    enum class State
+    {
+      Start,
+      List,
+      Single,
+      Done,
+      Failed
+    };
+
+    /// decodes the rc in the first `size` bytes we hold and drops them
+    bool
+    TakeRC(size_t size);
+
+    State m_State = State::Start;
+    /// what we got of the element we are on
+    std::string m_Pending;
+    BootstrapList m_RCs;
+    size_t m_Rejected = 0;
+  };
+
   std::unordered_map<std::string, BootstrapList>
   load_bootstrap_fallbacks();
 
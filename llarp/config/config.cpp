@@ -61,6 +61,21 @@ namespace llarp
           m_JobQueueSize = arg;
         });
 
+    conf.defineOption<std::string>(
+        "router",
+        "event-loop",
+        Default{"libuv"},
+        Comment{
+            "Event loop backend: 'libuv', or 'io_uring' to do udp and tun io through io_uring",
+            "(linux 6.0 or later, and only if lokinet was built with liburing; otherwise this",
+            "falls back to libuv).",
+        },
+        [this](std::string arg) {
+          if (arg != "libuv" and arg != "io_uring")
+            throw std::invalid_argument{"event-loop must be 'libuv' or 'io_uring'"};
+          m_EventLoop = std::move(arg);
+        });
+
     conf.defineOption<std::string>(
         "router",
         "netid",
@@ -191,6 +206,264 @@ namespace llarp
           m_workerThreads = arg;
         });
 
+    conf.defineOption<int>(
+        "router",
+        "link-crypto-threads",
+        Default{0},
+        Comment{
+            "The number of dedicated threads for link layer packet encryption and decryption.",
+            "Each link session is pinned to one of these (by remote router key) so that its",
+            "packets are always processed in order by the same core.  Useful on relays with",
+            "many peers; should not exceed the number of logical CPU cores.",
+            "0 means link crypto shares the general worker threads.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("link-crypto-threads must be >= 0");
+
+          m_linkCryptoThreads = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "path-crypto-threads",
+        Default{0},
+        Comment{
+            "The number of dedicated threads for onion path traffic encryption and decryption.",
+            "Each path is pinned to one of these (by path id) so that its traffic is always",
+            "processed in order by the same core.  Useful on relays carrying many paths, together",
+            "with link-crypto-threads; the two together should not exceed the number of logical",
+            "CPU cores.  0 means path crypto shares the general worker threads.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("path-crypto-threads must be >= 0");
+
+          m_pathCryptoThreads = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "path-build-threads",
+        RelayOnly,
+        Default{2},
+        Comment{
+            "The number of dedicated threads for the key exchanges of path builds through us,",
+            "which take batches of builds in turn, so that builds don't wait behind traffic.",
+            "Raise this on relays that see many builds at once.  0 means path builds share the",
+            "general worker threads.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("path-build-threads must be >= 0");
+
+          m_pathBuildThreads = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "crypto-threads",
+        Default{0},
+        Comment{
+            "The number of threads in a pool of their own for link and path traffic crypto,",
+            "instead of link-crypto-threads and path-crypto-threads (which are then ignored).",
+            "Each session and path still has its traffic processed in order, but an idle thread",
+            "takes over work queued for a busy one, so the load spreads out evenly.  0 means no",
+            "pool.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("crypto-threads must be >= 0");
+
+          m_cryptoThreads = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "crypto-core",
+        MultiValue,
+        Comment{
+            "CPU core to pin a crypto-threads thread to; give once per core to use.  Threads are",
+            "pinned to these in turn, so keeping to the cores of one NUMA node keeps the pool's",
+            "memory on it too.  Only supported on Linux.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("crypto-core must be >= 0");
+
+          m_cryptoCores.push_back(arg);
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "logic-core",
+        MultiValue,
+        Comment{
+            "CPU core the event loop thread may run on; give once per core to use.  Threads the",
+            "loop starts, such as libunbound's resolvers, run on these too.  Linux puts memory on",
+            "the NUMA node of the thread that first writes to it, so keeping the loop and the",
+            "cores the NIC's interrupts go to on one node keeps packets there.  Only supported",
+            "on Linux.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("logic-core must be >= 0");
+
+          m_logicCores.push_back(arg);
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "worker-core",
+        MultiValue,
+        Comment{
+            "CPU core the worker-threads threads may run on; give once per core to use.  Also",
+            "used by link-crypto-threads and path-crypto-threads, and by crypto-threads unless",
+            "crypto-core is given.  Only supported on Linux.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("worker-core must be >= 0");
+
+          m_workerCores.push_back(arg);
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "disk-core",
+        MultiValue,
+        Comment{
+            "CPU core the thread writing the nodedb and other files to disk may run on; give",
+            "once per core to use.  Without it, the disk thread keeps to worker-core.  Only",
+            "supported on Linux.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("disk-core must be >= 0");
+
+          m_diskCores.push_back(arg);
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "tick-budget",
+        Default{2000},
+        Comment{
+            "Most time in microseconds the router's periodic maintenance may hold up the event",
+            "loop for at once; maintenance that takes longer (on big relays, with many routers",
+            "known and paths open) is carried on over the next loop iterations, so that traffic",
+            "isn't held up behind it.  0 means no limit.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("tick-budget must be >= 0");
+
+          m_tickBudget = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "relay-bandwidth",
+        RelayOnly,
+        Default{0},
+        Comment{
+            "Cap on the path traffic this relay sends, in kB/s, with the bandwidth shared out",
+            "evenly between the paths that have traffic queued.  0 means no cap.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("relay-bandwidth must be >= 0");
+
+          m_RelayBandwidth = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "path-bandwidth",
+        RelayOnly,
+        Default{0},
+        Comment{
+            "Cap on the traffic any one path may send through this relay, in kB/s, so that a",
+            "single busy path cannot take all of it.  0 means no cap.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("path-bandwidth must be >= 0");
+
+          m_PathBandwidth = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "peer-bandwidth",
+        RelayOnly,
+        Default{0},
+        Comment{
+            "Cap on the path traffic this relay sends to any one other router, in kB/s, however",
+            "many paths go through it.  0 means no cap.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("peer-bandwidth must be >= 0");
+
+          m_PeerBandwidth = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "introset-store-size",
+        RelayOnly,
+        Default{16000},
+        Comment{
+            "How much memory, in kB, this relay may use for the hidden service introsets published",
+            "to it.  Once full the least recently looked up introsets make way for new ones.",
+            "0 means no cap.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("introset-store-size must be >= 0");
+
+          m_IntroSetStoreSize = arg;
+        });
+
+    conf.defineOption<int>(
+        "router",
+        "gossip-batch-interval",
+        RelayOnly,
+        Default{1000},
+        Comment{
+            "How long, in milliseconds, to gather up the RCs this relay passes on as gossip before",
+            "sending them on, so that a peer gets all of them in as few messages as fit rather",
+            "than a message each.  0 sends each RC on as it arrives.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("gossip-batch-interval must be >= 0");
+
+          m_GossipBatchInterval = std::chrono::milliseconds{arg};
+        });
+
+    conf.defineOption<std::string>(
+        "router",
+        "memory-limit",
+        MultiValue,
+        Comment{
+            "A soft limit, in kB, on the memory one part of lokinet holds, given as part=kB, where",
+            "part is one of nodedb, path, link, service, dns or quic.  Once over its limit the",
+            "part drops what it can do without, such as the least recently used cache entries.",
+            "May be given once per part; parts not given have no limit.  For example:",
+            "    memory-limit=dns=4096",
+        },
+        [this](std::string arg) {
+          const auto pos = arg.find('=');
+          size_t kB = 0;
+          const auto tag = util::MemTagFromString(std::string_view{arg}.substr(0, pos));
+          if (pos == std::string::npos or not tag
+              or not parse_int(std::string_view{arg}.substr(pos + 1), kB))
+            throw std::invalid_argument{"bad memory-limit: '" + arg + "'"};
+          m_MemoryLimits.emplace_back(*tag, kB);
+        });
+
     // Hidden option because this isn't something that should ever be turned off occasionally when
     // doing dev/testing work.
     conf.defineOption<bool>(
@@ -406,6 +679,24 @@ namespace llarp
         },
         [this](std::string arg) { m_AuthStaticTokens.emplace(std::move(arg)); });
 
+    conf.defineOption<int>(
+        "network",
+        "auth-cache-ttl",
+        ClientOnly,
+        Default{600},
+        Comment{
+            "How many seconds to remember that a client's auth token was accepted, so that it is",
+            "let in again without asking the auth backend.  A token revoked at the backend keeps",
+            "working for clients that used it for up to this long.  With file auth, reloading the",
+            "config forgets what we remembered, so tokens taken out of the files stop working",
+            "at once.  0 asks the backend every time.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument{"[network]:auth-cache-ttl must not be negative"};
+          m_AuthCacheTTL = std::chrono::seconds{arg};
+        });
+
     conf.defineOption<bool>(
         "network",
         "reachable",
@@ -443,6 +734,187 @@ namespace llarp
           m_Paths = arg;
         });
 
+    conf.defineOption<int>(
+        "network",
+        "max-paths",
+        ClientOnly,
+        Default{0},
+        Comment{
+            "Most paths to grow to while the ones we have are busy, from the number set by",
+            "paths=, which is gone back to while they are idle.  0 keeps to paths=.",
+        },
+        [this](int arg) {
+          if (arg < 0 or arg > 16)
+            throw std::invalid_argument("[network]:max-paths must be >= 0 and <= 16");
+          m_MaxPaths = arg;
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "path-pool",
+        ClientOnly,
+        Default{0},
+        Comment{
+            "Number of spare paths to keep built ahead of time, so that a session to a snapp",
+            "reachable through the end of one of them can start without waiting for a build.",
+            "Costs a path build every few minutes each.",
+        },
+        [this](int arg) {
+          if (arg < 0 or arg > 8)
+            throw std::invalid_argument("[network]:path-pool must be >= 0 and <= 8");
+          m_PathPoolSize = arg;
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "lookup-alpha",
+        ClientOnly,
+        Default{3},
+        Comment{
+            "How many relays to ask at once when looking up a snapp or a router; the first good",
+            "answer wins.  A snapp lookup that comes up empty or is slow to answer moves on to the",
+            "next relay storing the snapp.  Higher finds things sooner for more lookup traffic.",
+        },
+        [this](int arg) {
+          if (arg < 1 or arg > 4)
+            throw std::invalid_argument{"[network]:lookup-alpha must be >= 1 and <= 4"};
+          m_LookupAlpha = arg;
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "max-pending-lookups",
+        ClientOnly,
+        Default{32},
+        Comment{
+            "How many snapps to look up at once.  When sessions to more snapps than this start",
+            "together, after a reconnect say, the rest wait their turn rather than all competing",
+            "for the same paths.  Sessions to a snapp already being looked up share that lookup.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument{"[network]:max-pending-lookups must be >= 1"};
+          m_MaxPendingLookups = arg;
+        });
+
+    conf.defineOption<bool>(
+        "network",
+        "multipath",
+        ClientOnly,
+        Default{false},
+        AssignmentAcceptor(m_Multipath),
+        Comment{
+            "Spread each snapp session's traffic over all of our paths to the remote end rather",
+            "than sending it down the fastest one, and put traffic coming in back in order.",
+            "Helps bulk transfers that one slow relay would hold back, at the cost of a little",
+            "latency while waiting on frames that arrive out of order.",
+        });
+
+    conf.defineOption<bool>(
+        "network",
+        "coalesce-frames",
+        ClientOnly,
+        Default{false},
+        AssignmentAcceptor(m_CoalesceFrames),
+        Comment{
+            "Pack small packets of a snapp session that are sent close together into one frame,",
+            "rather than encrypting and sending each on its own.  Cuts per packet overhead for",
+            "chatty flows such as games or VoIP, at the cost of holding a packet until the next",
+            "time we flush, at most a few milliseconds.  Only used with remotes that support it.",
+        });
+
+    conf.defineOption<std::string>(
+        "network",
+        "quic-congestion-control",
+        ClientOnly,
+        Default{"cubic"},
+        Comment{
+            "Congestion controller for quic tunnels: 'cubic', 'reno' or 'bbr'.  bbr keeps more in",
+            "flight on long, lossy paths, which onion paths tend to be.",
+        },
+        [this](std::string arg) {
+          if (arg != "cubic" and arg != "reno" and arg != "bbr")
+            throw std::invalid_argument{
+                "[network]:quic-congestion-control must be 'cubic', 'reno' or 'bbr'"};
+          m_QuicCongestionControl = std::move(arg);
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "quic-stream-window",
+        ClientOnly,
+        Default{64},
+        Comment{
+            "How many kilobytes a quic tunnel lets each stream have in flight to it to begin",
+            "with.  This grows, up to quic-max-stream-window, while the sender keeps using it",
+            "all up within a couple of round trips, so that it ends up about the path's",
+            "bandwidth-delay product.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument{"[network]:quic-stream-window must be at least 1"};
+          m_QuicStreamWindow = static_cast<uint64_t>(arg) * 1024;
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "quic-max-stream-window",
+        ClientOnly,
+        Default{6 * 1024},
+        Comment{
+            "How many kilobytes the stream window of a quic tunnel may grow to.  Set it to",
+            "quic-stream-window to keep the window fixed.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument{"[network]:quic-max-stream-window must be at least 1"};
+          m_QuicMaxStreamWindow = static_cast<uint64_t>(arg) * 1024;
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "quic-connection-window",
+        ClientOnly,
+        Default{1024},
+        Comment{
+            "How many kilobytes a quic tunnel lets all of its streams together have in flight to",
+            "it to begin with.  This grows like the stream window does.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument{"[network]:quic-connection-window must be at least 1"};
+          m_QuicConnectionWindow = static_cast<uint64_t>(arg) * 1024;
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "quic-max-connection-window",
+        ClientOnly,
+        Default{15 * 1024},
+        Comment{
+            "How many kilobytes the connection window of a quic tunnel may grow to.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument{"[network]:quic-max-connection-window must be at least 1"};
+          m_QuicMaxConnectionWindow = static_cast<uint64_t>(arg) * 1024;
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "quic-stream-limit",
+        ClientOnly,
+        Default{32},
+        Comment{
+            "How many streams, i.e. tcp connections, a remote may open over one quic tunnel to us",
+            "at once.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument{"[network]:quic-stream-limit must be at least 1"};
+          m_QuicStreamLimit = arg;
+        });
+
     conf.defineOption<bool>(
         "network",
         "exit",
@@ -494,6 +966,27 @@ namespace llarp
           m_TrafficPolicy->protocols.emplace(arg);
         });
 
+    conf.defineOption<std::string>(
+        "network",
+        "traffic-class",
+        MultiValue,
+        Comment{
+            "Puts exit traffic of a protocol, or of a protocol to or from a port, in a traffic",
+            "class: realtime, interactive or bulk.  Can be specified multiple times; the first",
+            "that matches a packet wins.  Traffic no rule matches has its class picked by the",
+            "DSCP it is marked with; EF and AF4x are realtime, CS1, AF1x and LE bulk, and the",
+            "rest interactive.  Realtime traffic of a session goes ahead of its interactive",
+            "traffic, and that ahead of its bulk traffic, wherever it has to wait to be sent.",
+            "Examples:",
+            "    traffic-class=udp/3478:realtime",
+            "    traffic-class=tcp/ssh:interactive",
+            "    traffic-class=tcp/873:bulk",
+        },
+        [this](std::string arg) {
+          // this will throw on error
+          m_TrafficClassifier.AddRule(arg);
+        });
+
     conf.defineOption<std::string>(
         "network",
         "exit-node",
@@ -613,6 +1106,82 @@ namespace llarp
         },
         AssignmentAcceptor(m_ifname));
 
+    conf.defineOption<int>(
+        "network",
+        "tun-queues",
+        Default{1},
+        Comment{
+            "How many queues to open the interface with, each read on its own thread. Packets",
+            "of one flow always go through the same queue. More than one can take reading the",
+            "interface off the event loop on busy exits. Linux only; ignored elsewhere.",
+        },
+        [this](int arg) {
+          if (arg < 1 or arg > 64)
+            throw std::invalid_argument("[network]:tun-queues must be between 1 and 64");
+          m_TunQueues = arg;
+        });
+
+    conf.defineOption<bool>(
+        "network",
+        "tun-offload",
+        Default{false},
+        AssignmentAcceptor(m_TunOffload),
+        Comment{
+            "Have the kernel hand lokinet tcp traffic from the interface in runs of up to 64k,",
+            "which lokinet cuts up itself, and take runs of tcp segments of one flow written back",
+            "to it in one go, leaving checksums to whichever side needs them. This substantially",
+            "cuts the per packet cost of bulk tcp through the interface. Linux only; ignored",
+            "elsewhere.",
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "fq-codel-rate",
+        ClientOnly,
+        Default{0},
+        Comment{
+            "Shape traffic from the interface to this many kilobits a second, sharing it out",
+            "between flows fq-codel style: a flow that sends now and then goes ahead of bulk",
+            "transfers, and flows that build up a standing queue get their packets dropped. Set",
+            "it a little below what your paths actually carry so that the queue builds up here,",
+            "where it is fair, rather than further along. 0 leaves traffic unshaped.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("[network]:fq-codel-rate must be >= 0");
+          m_FQCoDelRate = arg;
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "fq-codel-target",
+        ClientOnly,
+        Default{5},
+        Comment{
+            "How long, in milliseconds, packets of a flow may wait while shaping before codel",
+            "starts to drop them.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument("[network]:fq-codel-target must be >= 1");
+          m_FQCoDelTarget = std::chrono::milliseconds{arg};
+        });
+
+    conf.defineOption<int>(
+        "network",
+        "fq-codel-interval",
+        ClientOnly,
+        Default{100},
+        Comment{
+            "How long, in milliseconds, packets of a flow have to have been waiting past",
+            "fq-codel-target before codel drops any; around the longest round trip you expect.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument("[network]:fq-codel-interval must be >= 1");
+          m_FQCoDelInterval = std::chrono::milliseconds{arg};
+        });
+
     conf.defineOption<std::string>(
         "network",
         "ifaddr",
@@ -880,6 +1449,49 @@ namespace llarp
           m_hostfiles.emplace_back(std::move(path));
         });
 
+    conf.defineOption<int>(
+        "dns",
+        "cache-size",
+        Default{1024},
+        Comment{
+            "How many kilobytes of upstream dns answers to cache, answering repeat queries",
+            "without asking upstream again until their ttl runs out.  0 disables caching.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument{"[dns]:cache-size must not be negative"};
+          m_CacheSize = static_cast<size_t>(arg) * 1024;
+        });
+
+    conf.defineOption<int>(
+        "dns",
+        "serve-stale",
+        Default{86400},
+        Comment{
+            "How many seconds past their ttl cached answers may still be given when upstream",
+            "dns fails to answer, as in RFC 8767.  0 disables this.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument{"[dns]:serve-stale must not be negative"};
+          m_ServeStale = std::chrono::seconds{arg};
+        });
+
+    conf.defineOption<int>(
+        "dns",
+        "upstream-contexts",
+        Default{1},
+        Comment{
+            "How many resolvers to spread upstream dns queries over, each resolving on its own",
+            "thread.  Raise this on exits forwarding a lot of dns.  Ignored, using one, when",
+            "query-bind is set, as they would all need its port.",
+        },
+        [this](int arg) {
+          if (arg < 1 or arg > 64)
+            throw std::invalid_argument{"[dns]:upstream-contexts must be between 1 and 64"};
+          m_UpstreamContexts = arg;
+        });
+
     // Ignored option (used by the systemd service file to disable resolvconf configuration).
     conf.defineOption<bool>(
         "dns",
@@ -1046,6 +1658,35 @@ namespace llarp
           OutboundLinks.emplace_back(std::move(*addr));
         });
 
+    conf.defineOption<bool>(
+        "bind",
+        "udp-offload",
+        Default{false},
+        AssignmentAcceptor(UDPOffload),
+        Comment{
+            "Use UDP segmentation offload (GSO) and receive offload (GRO) for link traffic where",
+            "the OS supports it (linux 5.0 and newer).  This lets lokinet hand runs of same sized",
+            "packets to the same peer to the kernel in one go, which substantially reduces CPU use",
+            "on busy relays.  Ignored (with a warning) if the system does not support it.",
+        });
+
+    conf.defineOption<int>(
+        "bind",
+        "udp-sockets",
+        Default{1},
+        Comment{
+            "The number of UDP sockets to receive link traffic on.  When more than one, each link",
+            "binds that many sockets to its address with SO_REUSEPORT and all but the first are",
+            "read by their own thread, so that receiving is spread across cores; the kernel sends",
+            "any one peer's traffic to the same socket.  Linux only; ignored (with a warning)",
+            "elsewhere.",
+        },
+        [this](int arg) {
+          if (arg < 1)
+            throw std::invalid_argument("udp-sockets must be >= 1");
+          UDPSockets = arg;
+        });
+
     conf.addUndeclaredHandler(
         "bind", [this, net_ptr](std::string_view, std::string_view key, std::string_view val) {
           LogWarn(
@@ -1152,6 +1793,36 @@ namespace llarp
             "Recommend localhost-only for security purposes.",
         });
 
+    conf.defineOption<std::string>(
+        "api",
+        "metrics-bind",
+        Comment{
+            "IP address and port to serve metrics on over http, at /metrics, in the format",
+            "prometheus scrapes.  Not served unless given.  Recommend localhost-only, e.g.:",
+            "    metrics-bind=127.0.0.1:1191",
+        },
+        [this](std::string arg) {
+          if (arg.empty())
+            return;
+          m_metricsBindAddress = SockAddr{arg};
+          if (m_metricsBindAddress->getPort() == 0)
+            throw std::invalid_argument{"metrics-bind needs a port: '" + arg + "'"};
+        });
+
+    conf.defineOption<int>(
+        "api",
+        "status-push-interval",
+        Default{1000},
+        Comment{
+            "How often, in milliseconds, to push what changed in the router's status to clients",
+            "subscribed with llarp.status_subscribe.  0 turns status subscriptions off.",
+        },
+        [this](int arg) {
+          if (arg < 0)
+            throw std::invalid_argument("[api]:status-push-interval must be >= 0");
+          m_statusPushInterval = std::chrono::milliseconds{arg};
+        });
+
     conf.defineOption<std::string>("api", "authkey", Deprecated);
 
     // TODO: this was from pre-refactor:
@@ -1316,6 +1987,49 @@ namespace llarp
             "of the given size.",
             "E.g. 16 ensures that all routers are using IPs from distinct /16 IP ranges."});
 
+    conf.defineOption<bool>(
+        "paths",
+        "latency-aware",
+        ClientOnly,
+        Default{false},
+        AssignmentAcceptor(m_LatencyAware),
+        Comment{
+            "Prefer routers we measure a low round trip time to when picking path hops, so",
+            "that paths don't needlessly bounce between continents. Trades some anonymity",
+            "for speed; see latency-randomness.",
+        });
+
+    conf.defineOption<int>(
+        "paths",
+        "latency-randomness",
+        ClientOnly,
+        Default{25},
+        [this](int arg) {
+          if (arg < 0 or arg > 100)
+            throw std::invalid_argument{"[paths]:latency-randomness must be between 0 and 100"};
+          m_LatencyRandomness = arg;
+        },
+        Comment{
+            "With latency-aware, the percentage of hops that are still picked uniformly at",
+            "random without regard to latency. Higher keeps hop choice less predictable.",
+        });
+
+    conf.defineOption<int>(
+        "paths",
+        "latency-probe-interval",
+        Default{20},
+        [this](int arg) {
+          if (arg < 1 or arg > 20)
+            throw std::invalid_argument{
+                "[paths]:latency-probe-interval must be between 1 and 20 seconds"};
+          m_LatencyProbeInterval = std::chrono::seconds{arg};
+        },
+        Comment{
+            "How often, in seconds, to measure the latency of each established path. Traffic",
+            "goes over whichever paths measure fastest, so probing more often moves it off a",
+            "path that slows down sooner, at the cost of a small message per path per probe.",
+        });
+
 #ifdef WITH_GEOIP
     conf.defineOption<std::string>(
         "paths",
@@ -1435,6 +2149,8 @@ namespace llarp
       m_Parser.Filename(*filename);
     else
       m_Parser.Filename(fs::path{});
+    // absolute, as the daemon changes into the data dir after loading us
+    m_ConfigFile = filename ? std::make_optional(fs::absolute(*filename)) : std::nullopt;
 
     if (not m_Parser.LoadFromStr(ini))
       return false;
@@ -1483,6 +2199,18 @@ namespace llarp
     return LoadString("", isRelay);
   }
 
+  std::shared_ptr<Config>
+  Config::Reload(bool isRelay) const
+  {
+    if (not m_ConfigFile)
+      return nullptr;
+    auto conf = std::make_shared<Config>(m_DataDir);
+    conf->m_Additional = m_Additional;
+    if (not conf->Load(*m_ConfigFile, isRelay))
+      throw std::runtime_error{"cannot load '" + m_ConfigFile->u8string() + "'"};
+    return conf;
+  }
+
   void
   Config::initializeConfig(ConfigDefinition& conf, const ConfigGenParameters& params)
   {
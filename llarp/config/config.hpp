@@ -8,12 +8,14 @@
 #include <llarp/crypto/types.hpp>
 #include <llarp/router_contact.hpp>
 #include <llarp/util/fs.hpp>
+#include <llarp/util/mem_account.hpp>
 #include <llarp/util/str.hpp>
 #include <llarp/util/logging.hpp>
 #include <llarp/constants/files.hpp>
 #include <llarp/net/ip_address.hpp>
 #include <llarp/net/net_int.hpp>
 #include <llarp/net/ip_range_map.hpp>
+#include <llarp/net/traffic_class.hpp>
 #include <llarp/service/address.hpp>
 #include <llarp/service/auth.hpp>
 #include <llarp/dns/srv_data.hpp>
@@ -66,10 +68,37 @@ namespace llarp
     bool m_blockBogons = false;
 
     int m_workerThreads = -1;
+    int m_linkCryptoThreads = 0;
+    int m_pathCryptoThreads = 0;
+    int m_pathBuildThreads = 2;
+    int m_cryptoThreads = 0;
+    std::vector<unsigned> m_cryptoCores;
+    /// cpu cores each class of thread is kept to, empty to leave it wherever it started
+    std::vector<unsigned> m_logicCores;
+    std::vector<unsigned> m_workerCores;
+    std::vector<unsigned> m_diskCores;
+    /// microseconds of periodic maintenance per event loop iteration, 0 for no limit
+    int m_tickBudget = 2000;
     int m_numNetThreads = -1;
 
+    /// caps on relayed path traffic in kB/s, 0 for none
+    int m_RelayBandwidth = 0;
+    int m_PathBandwidth = 0;
+    int m_PeerBandwidth = 0;
+
+    /// memory budget for the introsets published to us, in kB, 0 for none
+    size_t m_IntroSetStoreSize = 0;
+
+    /// how long to gather RCs for gossip before sending them on together, 0 to send each at once
+    llarp_time_t m_GossipBatchInterval = 0s;
+
+    /// soft limits on the memory each subsystem holds, in kB
+    std::vector<std::pair<util::MemTag, size_t>> m_MemoryLimits;
+
     size_t m_JobQueueSize = 0;
 
+    std::string m_EventLoop = "libuv";
+
     std::string m_routerContactFile;
     std::string m_encryptionKeyFile;
     std::string m_identityKeyFile;
@@ -96,6 +125,15 @@ namespace llarp
     /// set of countrys to exclude from path building (2 char country code)
     std::unordered_set<std::string> m_ExcludeCountries;
 
+    /// bias hop selection toward routers we have low rtt estimates for
+    bool m_LatencyAware = false;
+
+    /// in latency aware mode, the percentage of hops still picked uniformly at random
+    int m_LatencyRandomness = 25;
+
+    /// how often established paths test their latency
+    std::chrono::milliseconds m_LatencyProbeInterval = std::chrono::seconds{20};
+
     void
     defineConfigOptions(ConfigDefinition& conf, const ConfigGenParameters& params);
 
@@ -110,6 +148,12 @@ namespace llarp
     bool m_saveProfiles;
     std::set<RouterID> m_strictConnect;
     std::string m_ifname;
+    size_t m_TunQueues = 1;
+    bool m_TunOffload = false;
+    /// kilobits a second to shape traffic from the interface to, 0 for not at all
+    uint64_t m_FQCoDelRate = 0;
+    llarp_time_t m_FQCoDelTarget = 5ms;
+    llarp_time_t m_FQCoDelInterval = 100ms;
     IPRange m_ifaddr;
 
     std::optional<fs::path> m_keyfile;
@@ -117,6 +161,18 @@ namespace llarp
     bool m_reachable = false;
     std::optional<int> m_Hops;
     std::optional<int> m_Paths;
+    int m_MaxPaths = 0;
+    int m_PathPoolSize = 0;
+    int m_LookupAlpha = 3;
+    int m_MaxPendingLookups = 32;
+    bool m_Multipath = false;
+    bool m_CoalesceFrames = false;
+    std::string m_QuicCongestionControl = "cubic";
+    uint64_t m_QuicConnectionWindow = 1024 * 1024;
+    uint64_t m_QuicMaxConnectionWindow = 15 * 1024 * 1024;
+    uint64_t m_QuicStreamWindow = 64 * 1024;
+    uint64_t m_QuicMaxStreamWindow = 6 * 1024 * 1024;
+    uint64_t m_QuicStreamLimit = 32;
     bool m_AllowExit = false;
     std::set<RouterID> m_snodeBlacklist;
     net::IPRangeMap<service::Address> m_ExitMap;
@@ -134,6 +190,7 @@ namespace llarp
     std::unordered_set<service::Address> m_AuthWhitelist;
     std::unordered_set<std::string> m_AuthStaticTokens;
     std::set<fs::path> m_AuthFiles;
+    llarp_time_t m_AuthCacheTTL = 10min;
 
     std::vector<llarp::dns::SRVData> m_SRVRecords;
 
@@ -141,6 +198,7 @@ namespace llarp
 
     std::set<IPRange> m_OwnedRanges;
     std::optional<net::TrafficPolicy> m_TrafficPolicy;
+    net::TrafficClassifier m_TrafficClassifier;
 
     std::optional<llarp_time_t> m_PathAlignmentTimeout;
 
@@ -160,6 +218,12 @@ namespace llarp
     std::vector<SockAddr> m_upstreamDNS;
     std::vector<fs::path> m_hostfiles;
     std::optional<SockAddr> m_QueryBind;
+    /// bytes of upstream answers to cache; 0 for none
+    size_t m_CacheSize = 1024 * 1024;
+    /// how long past expiry a cached answer may be given when upstream fails; 0 for never
+    llarp_time_t m_ServeStale = 24h;
+    /// how many libunbound contexts to resolve upstream queries with in parallel
+    size_t m_UpstreamContexts = 1;
 
     std::unordered_multimap<std::string, std::string> m_ExtraOpts;
 
@@ -173,6 +237,8 @@ namespace llarp
     std::optional<net::port_t> PublicPort;
     std::vector<SockAddr> OutboundLinks;
     std::vector<SockAddr> InboundListenAddrs;
+    bool UDPOffload = false;
+    int UDPSockets = 1;
 
     void
     defineConfigOptions(ConfigDefinition& conf, const ConfigGenParameters& params);
@@ -190,6 +256,10 @@ namespace llarp
   {
     bool m_enableRPCServer = false;
     std::vector<oxenmq::address> m_rpcBindAddresses;
+    /// where to serve metrics for prometheus to scrape, if anywhere
+    std::optional<SockAddr> m_metricsBindAddress;
+    /// how often to push status deltas to status subscribers; 0 turns subscriptions off
+    llarp_time_t m_statusPushInterval = 1s;
 
     void
     defineConfigOptions(ConfigDefinition& conf, const ConfigGenParameters& params);
@@ -283,6 +353,12 @@ namespace llarp
     static std::shared_ptr<Config>
     EmbeddedConfig();
 
+    /// load the file this config was loaded from, and its overrides, over again into a new config
+    /// with the same added defaults, to apply what changed in it to a running router.  returns
+    /// nullptr if this config did not come from a file; throws if the file no longer loads.
+    std::shared_ptr<Config>
+    Reload(bool isRelay) const;
+
    private:
     /// Load (initialize) a default config.
     ///
@@ -308,6 +384,8 @@ namespace llarp
     std::vector<std::array<std::string, 3>> m_Additional;
     ConfigParser m_Parser;
     const fs::path m_DataDir;
+    /// the file we were last loaded from, if any
+    std::optional<fs::path> m_ConfigFile;
   };
 
   void
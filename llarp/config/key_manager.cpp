@@ -60,6 +60,8 @@ namespace llarp
     // we need to back up keys if our self.signed doesn't appear to have a
     // valid signature
     m_needBackup = (isSNode and not rc.VerifySignature());
+    if (isSNode and exists and not m_needBackup)
+      savedRC = std::move(rc);
 
     // if our RC file can't be verified, assume it is out of date (e.g. uses
     // older encryption) and needs to be regenerated. before doing so, backup
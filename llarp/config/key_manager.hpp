@@ -63,6 +63,10 @@ namespace llarp
     llarp::SecretKey encryptionKey;
     llarp::SecretKey transportKey;
 
+    /// the rc we last saved as a relay, if its signature checks out, for the router to start
+    /// with again if nothing in it changed since
+    std::optional<RouterContact> savedRC;
+
     fs::path m_rcPath;
     fs::path m_idKeyPath;
     fs::path m_encKeyPath;
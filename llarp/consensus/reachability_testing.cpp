@@ -113,21 +113,56 @@ namespace llarp::consensus
     return next_random(router, now, false);
   }
 
-  std::vector<std::pair<RouterID, int>>
-  reachability_testing::get_failing(const time_point_t& now)
+  std::vector<reachability_test>
+  reachability_testing::next_tests(
+      AbstractRouter* router,
+      const std::function<bool(const RouterID&)>& proven,
+      const time_point_t& now)
   {
+    const auto bucket_now = std::chrono::duration_cast<llarp_time_t>(now.time_since_epoch());
+    // whether a test of pk may go now, taking a token for it if it needs a session
+    auto may_go = [&](const RouterID& pk, bool& is_proven) {
+      is_proven = proven and proven(pk);
+      if (is_proven)
+        return true;
+      if (not test_bucket.Ready(bucket_now))
+        return false;
+      test_bucket.Consume(1);
+      return true;
+    };
+
     // Our failing_queue puts the oldest retest times at the top, so pop them off into our result
-    // until the top node should be retested sometime in the future
-    std::vector<std::pair<RouterID, int>> result;
-    while (result.size() < MAX_RETESTS_PER_TICK && !failing_queue.empty())
+    // until the top node should be retested sometime in the future; once one is due, those due
+    // soon after come along with it
+    std::vector<reachability_test> result;
+    bool batching = false;
+    while (!failing_queue.empty())
     {
-      auto& [pk, retest_time, failures] = failing_queue.top();
-      if (retest_time > now)
+      const auto [pk, retest_time, failures] = failing_queue.top();
+      if (retest_time > (batching ? now + RETEST_BATCH_WINDOW : now))
         break;
       if (failing.count(pk))
-        result.emplace_back(pk, failures);
+      {
+        bool is_proven;
+        if (not may_go(pk, is_proven))
+          break;
+        result.push_back({pk, failures, is_proven});
+        batching = true;
+      }
       failing_queue.pop();
     }
+
+    // the random test waits for a token before we pick it, so that it stays due rather than
+    // being lost when the bucket is empty
+    if (next_general_test <= now and test_bucket.Ready(bucket_now))
+    {
+      if (auto pk = next_random(router, now))
+      {
+        bool is_proven;
+        may_go(*pk, is_proven);
+        result.push_back({*pk, 0, is_proven});
+      }
+    }
     return result;
   }
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <chrono>
+#include <functional>
+#include <optional>
 #include <queue>
 #include <random>
 #include <unordered_map>
@@ -8,6 +10,7 @@
 #include <vector>
 
 #include <llarp/util/time.hpp>
+#include <llarp/util/token_bucket.hpp>
 #include <llarp/router_id.hpp>
 
 namespace llarp
@@ -47,6 +50,15 @@ namespace llarp::consensus
   // How often we tick the timer to check whether we need to do any tests.
   constexpr auto REACHABILITY_TESTING_TIMER_INTERVAL = 50ms;
 
+  // A node to test, how many times in a row it has failed before, and whether a live outbound
+  // session to it already proves it reachable, so that the test needs no new session.
+  struct reachability_test
+  {
+    RouterID pk;
+    int previous_failures;
+    bool proven;
+  };
+
   class reachability_testing
   {
    public:
@@ -69,6 +81,16 @@ namespace llarp::consensus
     // failing nodes we want to test right away when we get recommissioned).
     inline static constexpr int MAX_RETESTS_PER_TICK = 4;
 
+    // Tests that need a new session, random and retests alike, take a token from a bucket that
+    // fills at this rate, up to MAX_RETESTS_PER_TICK; so when lots of them fall due at once they
+    // go out evenly spread rather than MAX_RETESTS_PER_TICK every tick.  Those a live session
+    // proves take nothing, as they cost no handshake.
+    inline static constexpr uint64_t TESTS_PER_SECOND = 2;
+
+    // Retests due within this long of one that is due now go along with it, so that a run of
+    // them is done in one tick rather than a tick each.
+    inline static constexpr auto RETEST_BATCH_WINDOW = 2s;
+
     // Maximum time without a ping before we start whining about it.
     //
     // We have a probability of about 0.368* of *not* getting pinged within a ping interval (10s),
@@ -107,6 +129,8 @@ namespace llarp::consensus
     // about possible network issues.
     detail::incoming_test_state last;
 
+    util::TokenBucket test_bucket{TESTS_PER_SECOND, MAX_RETESTS_PER_TICK};
+
    public:
     // If it is time to perform another random test, this returns the next node to test from the
     // testing queue and returns it, also updating the timer for the next test.  If it is not yet
@@ -120,10 +144,16 @@ namespace llarp::consensus
     next_random(
         AbstractRouter* router, const time_point_t& now = clock_t::now(), bool requeue = true);
 
-    // Removes and returns up to MAX_RETESTS_PER_TICK nodes that are due to be tested (i.e.
-    // next-testing-time <= now).  Returns [snrecord, #previous-failures] for each.
-    std::vector<std::pair<RouterID, int>>
-    get_failing(const time_point_t& now = clock_t::now());
+    // Removes and returns the tests due now: the failing nodes due a retest (i.e.
+    // next-testing-time <= now) and any due within RETEST_BATCH_WINDOW of them, then the next
+    // random test if it is time for one.  `proven` says which nodes we have a live outbound
+    // session to, which are marked so and go whatever the bucket says; the rest only go as the
+    // bucket allows, and those it holds back stay due for a later tick.
+    std::vector<reachability_test>
+    next_tests(
+        AbstractRouter* router,
+        const std::function<bool(const RouterID&)>& proven,
+        const time_point_t& now = clock_t::now());
 
     // Adds a bad node pubkey to the failing list, to be re-tested soon (with a backoff depending on
     // `failures`; see TESTING_BACKOFF).  `previous_failures` should be the number of previous
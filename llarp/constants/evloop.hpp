@@ -1,7 +1,23 @@
 #pragma once
 
+#include <cstddef>
+
 namespace llarp
 {
   /// default queue length for logic jobs
   constexpr std::size_t event_loop_queue_size = 1024;
+
+  /// maximum number of datagrams read (or written) per recvmmsg (or sendmmsg) call
+  constexpr std::size_t udp_batch_size = 32;
+
+  /// size of each datagram slot used for batched udp receives; large enough for any udp payload
+  constexpr std::size_t udp_max_datagram_size = 65536;
+
+  /// most datagrams we will coalesce into a single segmentation offloaded (GSO) send; this is the
+  /// kernel's limit
+  constexpr std::size_t udp_gso_max_segments = 64;
+
+  /// most bytes we will coalesce into a single segmentation offloaded (GSO) send; must fit in one
+  /// ip datagram
+  constexpr std::size_t udp_gso_max_bytes = 65000;
 }  // namespace llarp
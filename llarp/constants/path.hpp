@@ -38,9 +38,25 @@ namespace llarp
     constexpr auto latency_interval = 20s;
     /// if a path is inactive for this amount of time it's dead
     constexpr auto alive_timeout = latency_interval * 1.5;
+    /// a path that keeps getting traffic back is plainly alive, so we only test its latency this
+    /// many times less often, to keep its estimate fresh
+    constexpr int busy_latency_factor = 4;
 
-    /// how big transit hop traffic queues are
-    constexpr std::size_t transit_hop_queue_size = 256;
+    /// how often a path set that grows with its load looks at how busy its paths are
+    constexpr auto load_interval = 10s;
+    /// bytes a second each established path carries on average past which we want another path
+    constexpr uint64_t busy_path_rate = 256 * 1024;
+    /// and under which we want one fewer
+    constexpr uint64_t idle_path_rate = 16 * 1024;
+
+    /// most path build requests we hand to a worker in one job
+    constexpr std::size_t commit_batch_size = 32;
+    /// with this many path build requests waiting we refuse new ones with a congestion status
+    constexpr std::size_t commit_backlog_reject = 512;
+    /// and with this many we drop them without a reply
+    constexpr std::size_t commit_backlog_drop = 2048;
+    /// most path build statuses we hand to a worker in one job
+    constexpr std::size_t status_batch_size = 32;
 
   }  // namespace path
 }  // namespace llarp
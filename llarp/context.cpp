@@ -72,7 +72,7 @@ namespace llarp
     if (!loop)
     {
       auto jobQueueSize = std::max(event_loop_queue_size, config->router.m_JobQueueSize);
-      loop = EventLoop::create(jobQueueSize);
+      loop = EventLoop::create(jobQueueSize, config->router.m_EventLoop);
     }
 
     crypto = std::make_shared<sodium::CryptoLibSodium>();
@@ -187,7 +187,26 @@ namespace llarp
 
   void
   Context::Reload()
-  {}
+  {
+    if (not router or not config)
+      return;
+    std::shared_ptr<Config> conf;
+    try
+    {
+      conf = config->Reload(router->IsServiceNode());
+    }
+    catch (const std::exception& ex)
+    {
+      log::error(logcat, "not reloading config: {}", ex.what());
+      return;
+    }
+    if (not conf)
+    {
+      log::warning(logcat, "not reloading config: it was not loaded from a file");
+      return;
+    }
+    loop->call([router = router, conf = std::move(conf)] { router->Reconfigure(conf); });
+  }
 
   void
   Context::SigINT()
@@ -0,0 +1,250 @@
+#include "chacha20.hpp"
+
+#include <oxenc/endian.h>
+#include <sodium/utils.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace llarp
+{
+  namespace chacha20
+  {
+    namespace detail
+    {
+      void
+      InitState(uint32_t* state, const byte_t* key, const byte_t* nonce, uint64_t ic)
+      {
+        // "expand 32-byte k"
+        state[0] = 0x61707865;
+        state[1] = 0x3320646e;
+        state[2] = 0x79622d32;
+        state[3] = 0x6b206574;
+        for (size_t i = 0; i < 8; ++i)
+          state[4 + i] = oxenc::load_little_to_host<uint32_t>(key + 4 * i);
+        state[12] = static_cast<uint32_t>(ic);
+        state[13] = static_cast<uint32_t>(ic >> 32);
+        state[14] = oxenc::load_little_to_host<uint32_t>(nonce);
+        state[15] = oxenc::load_little_to_host<uint32_t>(nonce + 4);
+      }
+
+      static inline uint32_t
+      rotl(uint32_t x, int n)
+      {
+        return (x << n) | (x >> (32 - n));
+      }
+
+#define CHACHA_QR(a, b, c, d) \
+  a += b;                     \
+  d = rotl(d ^ a, 16);        \
+  c += d;                     \
+  b = rotl(b ^ c, 12);        \
+  a += b;                     \
+  d = rotl(d ^ a, 8);         \
+  c += d;                     \
+  b = rotl(b ^ c, 7);
+
+      void
+      xor_scalar(byte_t* out, const byte_t* in, size_t len, const uint32_t* state)
+      {
+        std::array<uint32_t, 16> input;
+        std::copy_n(state, 16, input.begin());
+        std::array<byte_t, BlockSize> ks;
+        while (len > 0)
+        {
+          auto x = input;
+          for (int i = 0; i < 10; ++i)
+          {
+            CHACHA_QR(x[0], x[4], x[8], x[12])
+            CHACHA_QR(x[1], x[5], x[9], x[13])
+            CHACHA_QR(x[2], x[6], x[10], x[14])
+            CHACHA_QR(x[3], x[7], x[11], x[15])
+            CHACHA_QR(x[0], x[5], x[10], x[15])
+            CHACHA_QR(x[1], x[6], x[11], x[12])
+            CHACHA_QR(x[2], x[7], x[8], x[13])
+            CHACHA_QR(x[3], x[4], x[9], x[14])
+          }
+          for (size_t i = 0; i < 16; ++i)
+            oxenc::write_host_as_little(x[i] + input[i], ks.data() + 4 * i);
+
+          const size_t n = std::min(len, BlockSize);
+          for (size_t i = 0; i < n; ++i)
+            out[i] = in[i] ^ ks[i];
+          out += n;
+          in += n;
+          len -= n;
+
+          if (++input[12] == 0)
+            ++input[13];
+        }
+        sodium_memzero(ks.data(), ks.size());
+      }
+
+#undef CHACHA_QR
+
+#ifdef __ARM_NEON
+      template <int N>
+      static inline uint32x4_t
+      rotl_n(uint32x4_t x)
+      {
+        return vsriq_n_u32(vshlq_n_u32(x, N), x, 32 - N);
+      }
+
+      static inline uint32x4_t
+      rotl16(uint32x4_t x)
+      {
+        return vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(x)));
+      }
+
+#define CHACHA_QR_NEON(a, b, c, d) \
+  a = vaddq_u32(a, b);             \
+  d = rotl16(veorq_u32(d, a));     \
+  c = vaddq_u32(c, d);             \
+  b = rotl_n<12>(veorq_u32(b, c)); \
+  a = vaddq_u32(a, b);             \
+  d = rotl_n<8>(veorq_u32(d, a));  \
+  c = vaddq_u32(c, d);             \
+  b = rotl_n<7>(veorq_u32(b, c));
+
+      /// the chacha state for 4 consecutive blocks, one per lane, run and xored into in
+      static void
+      neon_4blocks(byte_t* out, const byte_t* in, const uint32x4_t* input)
+      {
+        uint32x4_t x[16];
+        for (int i = 0; i < 16; ++i)
+          x[i] = input[i];
+        for (int i = 0; i < 10; ++i)
+        {
+          CHACHA_QR_NEON(x[0], x[4], x[8], x[12])
+          CHACHA_QR_NEON(x[1], x[5], x[9], x[13])
+          CHACHA_QR_NEON(x[2], x[6], x[10], x[14])
+          CHACHA_QR_NEON(x[3], x[7], x[11], x[15])
+          CHACHA_QR_NEON(x[0], x[5], x[10], x[15])
+          CHACHA_QR_NEON(x[1], x[6], x[11], x[12])
+          CHACHA_QR_NEON(x[2], x[7], x[8], x[13])
+          CHACHA_QR_NEON(x[3], x[4], x[9], x[14])
+        }
+        for (int i = 0; i < 16; ++i)
+          x[i] = vaddq_u32(x[i], input[i]);
+
+        // word i of block b is lane b of x[i]; transpose each group of 4 words so that it is
+        // contiguous per block
+        for (int g = 0; g < 4; ++g)
+        {
+          const uint32x4x2_t t01 = vtrnq_u32(x[4 * g], x[4 * g + 1]);
+          const uint32x4x2_t t23 = vtrnq_u32(x[4 * g + 2], x[4 * g + 3]);
+          const uint32x4_t blocks[4] = {
+              vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])),
+              vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])),
+              vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])),
+              vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]))};
+          for (int b = 0; b < 4; ++b)
+          {
+            const size_t off = b * BlockSize + g * 16;
+            vst1q_u8(out + off, veorq_u8(vld1q_u8(in + off), vreinterpretq_u8_u32(blocks[b])));
+          }
+        }
+      }
+
+#undef CHACHA_QR_NEON
+
+      void
+      xor_neon(byte_t* out, const byte_t* in, size_t len, const uint32_t* state)
+      {
+        static constexpr size_t chunk = 4 * BlockSize;
+        uint32x4_t input[16];
+        for (int i = 0; i < 16; ++i)
+          input[i] = vdupq_n_u32(state[i]);
+        uint64_t ctr = state[12] | (uint64_t{state[13]} << 32);
+
+        while (len > 0)
+        {
+          uint32_t lo[4], hi[4];
+          for (int b = 0; b < 4; ++b)
+          {
+            lo[b] = static_cast<uint32_t>(ctr + b);
+            hi[b] = static_cast<uint32_t>((ctr + b) >> 32);
+          }
+          input[12] = vld1q_u32(lo);
+          input[13] = vld1q_u32(hi);
+
+          if (len >= chunk)
+          {
+            neon_4blocks(out, in, input);
+          }
+          else
+          {
+            std::array<byte_t, chunk> tail{};
+            std::memcpy(tail.data(), in, len);
+            neon_4blocks(tail.data(), tail.data(), input);
+            std::memcpy(out, tail.data(), len);
+            // past len it is bare keystream
+            sodium_memzero(tail.data(), tail.size());
+            return;
+          }
+          out += chunk;
+          in += chunk;
+          len -= chunk;
+          ctr += 4;
+        }
+      }
+#endif
+
+      std::vector<std::pair<const char*, Impl_t>>
+      Implementations()
+      {
+        std::vector<std::pair<const char*, Impl_t>> impls;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __builtin_cpu_init();
+#ifdef LOKINET_CHACHA20_AVX512
+        if (__builtin_cpu_supports("avx512f"))
+          impls.emplace_back("avx512", &xor_avx512);
+#endif
+#ifdef LOKINET_CHACHA20_AVX2
+        if (__builtin_cpu_supports("avx2"))
+          impls.emplace_back("avx2", &xor_avx2);
+#endif
+#endif
+#ifdef __ARM_NEON
+        impls.emplace_back("neon", &xor_neon);
+#endif
+        impls.emplace_back("scalar", &xor_scalar);
+        return impls;
+      }
+
+      static const std::pair<const char*, Impl_t>&
+      Best()
+      {
+        static const auto best = Implementations().front();
+        return best;
+      }
+    }  // namespace detail
+
+    void
+    xor_ic(
+        byte_t* out,
+        const byte_t* in,
+        size_t len,
+        const byte_t* nonce,
+        uint64_t ic,
+        const byte_t* key)
+    {
+      std::array<uint32_t, 16> state;
+      detail::InitState(state.data(), key, nonce, ic);
+      detail::Best().second(out, in, len, state.data());
+      // it holds the key
+      sodium_memzero(state.data(), sizeof(state));
+    }
+
+    const char*
+    Implementation()
+    {
+      return detail::Best().first;
+    }
+  }  // namespace chacha20
+}  // namespace llarp
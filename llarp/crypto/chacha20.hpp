@@ -0,0 +1,71 @@
+#pragma once
+
+#include <llarp/util/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  /// in-tree chacha20 (the original djb variant: 64 bit nonce, 64 bit block counter, as in
+  /// libsodium's crypto_stream_chacha20_xor_ic) that works on several blocks at once with
+  /// whatever vector unit this cpu has.  which implementation gets used is decided once, the
+  /// first time it is needed, from what the cpu says it supports.
+  namespace chacha20
+  {
+    static constexpr size_t BlockSize = 64;
+    static constexpr size_t KeySize = 32;
+    static constexpr size_t NonceSize = 8;
+
+    /// xor in with the keystream for key and nonce starting at block ic, writing to out, which may
+    /// be the same as in
+    void
+    xor_ic(
+        byte_t* out,
+        const byte_t* in,
+        size_t len,
+        const byte_t* nonce,
+        uint64_t ic,
+        const byte_t* key);
+
+    /// the name of the implementation xor_ic uses on this cpu
+    const char*
+    Implementation();
+
+    namespace detail
+    {
+      /// an implementation: xor len bytes of keystream for the given initial chacha state (the
+      /// block counter in words 12 and 13) into in, writing to out
+      using Impl_t = void (*)(byte_t* out, const byte_t* in, size_t len, const uint32_t* state);
+
+      void
+      xor_scalar(byte_t* out, const byte_t* in, size_t len, const uint32_t* state);
+
+#ifdef LOKINET_CHACHA20_AVX2
+      void
+      xor_avx2(byte_t* out, const byte_t* in, size_t len, const uint32_t* state);
+#endif
+
+#ifdef LOKINET_CHACHA20_AVX512
+      void
+      xor_avx512(byte_t* out, const byte_t* in, size_t len, const uint32_t* state);
+#endif
+
+#ifdef __ARM_NEON
+      void
+      xor_neon(byte_t* out, const byte_t* in, size_t len, const uint32_t* state);
+#endif
+
+      /// every implementation this build has that this cpu can run, best first; the scalar one
+      /// is always last
+      std::vector<std::pair<const char*, Impl_t>>
+      Implementations();
+
+      /// set up the chacha state for key, nonce and block counter
+      void
+      InitState(uint32_t* state, const byte_t* key, const byte_t* nonce, uint64_t ic);
+    }  // namespace detail
+  }    // namespace chacha20
+}  // namespace llarp
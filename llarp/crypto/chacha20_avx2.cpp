@@ -0,0 +1,148 @@
+// built with -mavx2; only called when the cpu says it has avx2
+#include "chacha20.hpp"
+
+#include <immintrin.h>
+#include <sodium/utils.h>
+
+#include <array>
+#include <cstring>
+
+namespace llarp
+{
+  namespace chacha20
+  {
+    namespace detail
+    {
+      static inline __m256i
+      rotl16(__m256i x)
+      {
+        const __m256i mask = _mm256_set_epi8(
+            13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+            13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+        return _mm256_shuffle_epi8(x, mask);
+      }
+
+      static inline __m256i
+      rotl8(__m256i x)
+      {
+        const __m256i mask = _mm256_set_epi8(
+            14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+            14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+        return _mm256_shuffle_epi8(x, mask);
+      }
+
+      template <int N>
+      static inline __m256i
+      rotl_n(__m256i x)
+      {
+        return _mm256_or_si256(_mm256_slli_epi32(x, N), _mm256_srli_epi32(x, 32 - N));
+      }
+
+#define CHACHA_QR_AVX2(a, b, c, d)           \
+  a = _mm256_add_epi32(a, b);                \
+  d = rotl16(_mm256_xor_si256(d, a));        \
+  c = _mm256_add_epi32(c, d);                \
+  b = rotl_n<12>(_mm256_xor_si256(b, c));    \
+  a = _mm256_add_epi32(a, b);                \
+  d = rotl8(_mm256_xor_si256(d, a));         \
+  c = _mm256_add_epi32(c, d);                \
+  b = rotl_n<7>(_mm256_xor_si256(b, c));
+
+      static inline void
+      xor32(byte_t* out, const byte_t* in, __m256i ks)
+      {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_xor_si256(v, ks));
+      }
+
+      /// the chacha state for 8 consecutive blocks, one per lane, run and xored into in
+      static void
+      avx2_8blocks(byte_t* out, const byte_t* in, const __m256i* input)
+      {
+        __m256i x[16];
+        for (int i = 0; i < 16; ++i)
+          x[i] = input[i];
+        for (int i = 0; i < 10; ++i)
+        {
+          CHACHA_QR_AVX2(x[0], x[4], x[8], x[12])
+          CHACHA_QR_AVX2(x[1], x[5], x[9], x[13])
+          CHACHA_QR_AVX2(x[2], x[6], x[10], x[14])
+          CHACHA_QR_AVX2(x[3], x[7], x[11], x[15])
+          CHACHA_QR_AVX2(x[0], x[5], x[10], x[15])
+          CHACHA_QR_AVX2(x[1], x[6], x[11], x[12])
+          CHACHA_QR_AVX2(x[2], x[7], x[8], x[13])
+          CHACHA_QR_AVX2(x[3], x[4], x[9], x[14])
+        }
+        for (int i = 0; i < 16; ++i)
+          x[i] = _mm256_add_epi32(x[i], input[i]);
+
+        // word i of block b is lane b of x[i].  transpose each group of 4 words within the 128
+        // bit halves, after which u[4g + b] holds words 4g..4g+3 of block b in its low half and of
+        // block b + 4 in its high half.
+        __m256i u[16];
+        for (int g = 0; g < 4; ++g)
+        {
+          const __m256i t0 = _mm256_unpacklo_epi32(x[4 * g], x[4 * g + 1]);
+          const __m256i t1 = _mm256_unpackhi_epi32(x[4 * g], x[4 * g + 1]);
+          const __m256i t2 = _mm256_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+          const __m256i t3 = _mm256_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+          u[4 * g] = _mm256_unpacklo_epi64(t0, t2);
+          u[4 * g + 1] = _mm256_unpackhi_epi64(t0, t2);
+          u[4 * g + 2] = _mm256_unpacklo_epi64(t1, t3);
+          u[4 * g + 3] = _mm256_unpackhi_epi64(t1, t3);
+        }
+        for (int b = 0; b < 4; ++b)
+        {
+          byte_t* const lo = out + b * BlockSize;
+          byte_t* const hi = out + (b + 4) * BlockSize;
+          const byte_t* const inlo = in + b * BlockSize;
+          const byte_t* const inhi = in + (b + 4) * BlockSize;
+          xor32(lo, inlo, _mm256_permute2x128_si256(u[b], u[b + 4], 0x20));
+          xor32(lo + 32, inlo + 32, _mm256_permute2x128_si256(u[b + 8], u[b + 12], 0x20));
+          xor32(hi, inhi, _mm256_permute2x128_si256(u[b], u[b + 4], 0x31));
+          xor32(hi + 32, inhi + 32, _mm256_permute2x128_si256(u[b + 8], u[b + 12], 0x31));
+        }
+      }
+
+#undef CHACHA_QR_AVX2
+
+      void
+      xor_avx2(byte_t* out, const byte_t* in, size_t len, const uint32_t* state)
+      {
+        static constexpr size_t chunk = 8 * BlockSize;
+        __m256i input[16];
+        for (int i = 0; i < 16; ++i)
+          input[i] = _mm256_set1_epi32(static_cast<int>(state[i]));
+        uint64_t ctr = state[12] | (uint64_t{state[13]} << 32);
+
+        while (len > 0)
+        {
+          alignas(32) uint32_t lo[8], hi[8];
+          for (int b = 0; b < 8; ++b)
+          {
+            lo[b] = static_cast<uint32_t>(ctr + b);
+            hi[b] = static_cast<uint32_t>((ctr + b) >> 32);
+          }
+          input[12] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lo));
+          input[13] = _mm256_load_si256(reinterpret_cast<const __m256i*>(hi));
+
+          if (len < chunk)
+          {
+            std::array<byte_t, chunk> tail{};
+            std::memcpy(tail.data(), in, len);
+            avx2_8blocks(tail.data(), tail.data(), input);
+            std::memcpy(out, tail.data(), len);
+            // past len it is bare keystream
+            sodium_memzero(tail.data(), tail.size());
+            return;
+          }
+          avx2_8blocks(out, in, input);
+          out += chunk;
+          in += chunk;
+          len -= chunk;
+          ctr += 8;
+        }
+      }
+    }  // namespace detail
+  }    // namespace chacha20
+}  // namespace llarp
@@ -0,0 +1,130 @@
+// built with -mavx512f; only called when the cpu says it has avx512f
+#include "chacha20.hpp"
+
+#include <immintrin.h>
+#include <sodium/utils.h>
+
+#include <array>
+#include <cstring>
+
+namespace llarp
+{
+  namespace chacha20
+  {
+    namespace detail
+    {
+#define CHACHA_QR_AVX512(a, b, c, d)                  \
+  a = _mm512_add_epi32(a, b);                         \
+  d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 16);   \
+  c = _mm512_add_epi32(c, d);                         \
+  b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 12);   \
+  a = _mm512_add_epi32(a, b);                         \
+  d = _mm512_rol_epi32(_mm512_xor_si512(d, a), 8);    \
+  c = _mm512_add_epi32(c, d);                         \
+  b = _mm512_rol_epi32(_mm512_xor_si512(b, c), 7);
+
+      static inline void
+      xor64(byte_t* out, const byte_t* in, __m512i ks)
+      {
+        const __m512i v = _mm512_loadu_si512(in);
+        _mm512_storeu_si512(out, _mm512_xor_si512(v, ks));
+      }
+
+      /// the chacha state for 16 consecutive blocks, one per lane, run and xored into in
+      static void
+      avx512_16blocks(byte_t* out, const byte_t* in, const __m512i* input)
+      {
+        __m512i x[16];
+        for (int i = 0; i < 16; ++i)
+          x[i] = input[i];
+        for (int i = 0; i < 10; ++i)
+        {
+          CHACHA_QR_AVX512(x[0], x[4], x[8], x[12])
+          CHACHA_QR_AVX512(x[1], x[5], x[9], x[13])
+          CHACHA_QR_AVX512(x[2], x[6], x[10], x[14])
+          CHACHA_QR_AVX512(x[3], x[7], x[11], x[15])
+          CHACHA_QR_AVX512(x[0], x[5], x[10], x[15])
+          CHACHA_QR_AVX512(x[1], x[6], x[11], x[12])
+          CHACHA_QR_AVX512(x[2], x[7], x[8], x[13])
+          CHACHA_QR_AVX512(x[3], x[4], x[9], x[14])
+        }
+        for (int i = 0; i < 16; ++i)
+          x[i] = _mm512_add_epi32(x[i], input[i]);
+
+        // word i of block b is lane b of x[i].  transpose each group of 4 words within the 128
+        // bit lanes, after which lane l of u[4g + b] holds words 4g..4g+3 of block 4l + b.
+        __m512i u[16];
+        for (int g = 0; g < 4; ++g)
+        {
+          const __m512i t0 = _mm512_unpacklo_epi32(x[4 * g], x[4 * g + 1]);
+          const __m512i t1 = _mm512_unpackhi_epi32(x[4 * g], x[4 * g + 1]);
+          const __m512i t2 = _mm512_unpacklo_epi32(x[4 * g + 2], x[4 * g + 3]);
+          const __m512i t3 = _mm512_unpackhi_epi32(x[4 * g + 2], x[4 * g + 3]);
+          u[4 * g] = _mm512_unpacklo_epi64(t0, t2);
+          u[4 * g + 1] = _mm512_unpackhi_epi64(t0, t2);
+          u[4 * g + 2] = _mm512_unpacklo_epi64(t1, t3);
+          u[4 * g + 3] = _mm512_unpackhi_epi64(t1, t3);
+        }
+        // then for each b it is a 4x4 transpose of 128 bit lanes across u[b], u[b + 4], u[b + 8]
+        // and u[b + 12] to get whole blocks b, b + 4, b + 8 and b + 12
+        for (int b = 0; b < 4; ++b)
+        {
+          const __m512i s0 = _mm512_shuffle_i32x4(u[b], u[b + 4], 0x44);
+          const __m512i s1 = _mm512_shuffle_i32x4(u[b], u[b + 4], 0xee);
+          const __m512i s2 = _mm512_shuffle_i32x4(u[b + 8], u[b + 12], 0x44);
+          const __m512i s3 = _mm512_shuffle_i32x4(u[b + 8], u[b + 12], 0xee);
+          const __m512i blocks[4] = {
+              _mm512_shuffle_i32x4(s0, s2, 0x88),
+              _mm512_shuffle_i32x4(s0, s2, 0xdd),
+              _mm512_shuffle_i32x4(s1, s3, 0x88),
+              _mm512_shuffle_i32x4(s1, s3, 0xdd)};
+          for (int l = 0; l < 4; ++l)
+          {
+            const size_t off = (4 * l + b) * BlockSize;
+            xor64(out + off, in + off, blocks[l]);
+          }
+        }
+      }
+
+#undef CHACHA_QR_AVX512
+
+      void
+      xor_avx512(byte_t* out, const byte_t* in, size_t len, const uint32_t* state)
+      {
+        static constexpr size_t chunk = 16 * BlockSize;
+        __m512i input[16];
+        for (int i = 0; i < 16; ++i)
+          input[i] = _mm512_set1_epi32(static_cast<int>(state[i]));
+        uint64_t ctr = state[12] | (uint64_t{state[13]} << 32);
+
+        while (len > 0)
+        {
+          alignas(64) uint32_t lo[16], hi[16];
+          for (int b = 0; b < 16; ++b)
+          {
+            lo[b] = static_cast<uint32_t>(ctr + b);
+            hi[b] = static_cast<uint32_t>((ctr + b) >> 32);
+          }
+          input[12] = _mm512_load_si512(lo);
+          input[13] = _mm512_load_si512(hi);
+
+          if (len < chunk)
+          {
+            std::array<byte_t, chunk> tail{};
+            std::memcpy(tail.data(), in, len);
+            avx512_16blocks(tail.data(), tail.data(), input);
+            std::memcpy(out, tail.data(), len);
+            // past len it is bare keystream
+            sodium_memzero(tail.data(), tail.size());
+            return;
+          }
+          avx512_16blocks(out, in, input);
+          out += chunk;
+          in += chunk;
+          len -= chunk;
+          ctr += 16;
+        }
+      }
+    }  // namespace detail
+  }    // namespace chacha20
+}  // namespace llarp
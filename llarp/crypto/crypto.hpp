@@ -4,8 +4,11 @@
 #include "types.hpp"
 
 #include <llarp/util/buffer.hpp>
+#include <llarp/util/status.hpp>
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 #include <cstdint>
 
@@ -18,6 +21,17 @@
 
 namespace llarp
 {
+  /// one signature for Crypto::verify_batch to check.  msg is not owned, so whatever it points at
+  /// has to outlive the call.
+  struct SignatureCheck
+  {
+    PubKey pubkey;
+    llarp_buffer_t msg;
+    Signature sig;
+    /// set by verify_batch
+    bool valid = false;
+  };
+
   /// library crypto configuration
   struct Crypto
   {
@@ -36,6 +50,46 @@ namespace llarp
     xchacha20_alt(
         const llarp_buffer_t&, const llarp_buffer_t&, const SharedSecret&, const byte_t*) = 0;
 
+    /// apply several xchacha20 layers to a buffer in place, the same as calling xchacha20 with
+    /// each key and nonce in turn but in a single pass over the data: every layer is applied to
+    /// one cache sized chunk before moving on to the next.  used for onion layers, so at most
+    /// path::max_len of them; returns false if given more.
+    virtual bool
+    xchacha20_layers(
+        const llarp_buffer_t&, const SharedSecret* keys, const TunnelNonce* nonces, size_t n) = 0;
+
+    /// encrypt a batch of packets in place that all share one key.  each packet is laid out as
+    /// <keyed hash><nonce><body>: the body is xchacha20 encrypted using the nonce and then the keyed
+    /// hash is written over the nonce and body.  returns false if any packet is too short.
+    virtual bool
+    encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&) = 0;
+
+    /// inverse of encrypt_packets: checks the keyed hash of each packet and decrypts the body in
+    /// place.  packets that are too short or fail the hash check are removed from `pkts`.  returns
+    /// the number of packets removed.
+    virtual size_t
+    decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&) = 0;
+
+    /// whether this cpu has the aes and carryless multiply instructions the aes256gcm packet
+    /// crypto below needs
+    virtual bool
+    aes256gcm_available() = 0;
+
+    /// encrypt_packets with aes-256-gcm, keyed from the shared secret, for links that negotiate
+    /// it.  packets are laid out the same and come out the same size: the first 12 bytes of the
+    /// nonce field are the gcm nonce, which the caller fills in and must never repeat under one
+    /// key (at this volume random ones are not good enough); the rest of the nonce field is
+    /// authenticated along with the body.  the tag goes in the first half of the keyed hash
+    /// field and the second half is zeroed, which is how is_aes256gcm_packet tells them apart.
+    /// returns false if any packet is too short or aes256gcm isn't available.
+    virtual bool
+    aes256gcm_encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&) = 0;
+
+    /// inverse of aes256gcm_encrypt_packets, as decrypt_packets is of encrypt_packets: packets
+    /// that are too short or don't authenticate are removed.  returns the number removed.
+    virtual size_t
+    aes256gcm_decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&) = 0;
+
     /// path dh creator's side
     virtual bool
     dh_client(SharedSecret&, const PubKey&, const SecretKey&, const TunnelNonce&) = 0;
@@ -63,6 +117,11 @@ namespace llarp
     /// ed25519 verify
     virtual bool
     verify(const PubKey&, const llarp_buffer_t&, const Signature&) = 0;
+    /// ed25519 verify many signatures, the same as calling verify on each but spread over several
+    /// threads when there are enough of them to be worth it.  sets valid on each check and returns
+    /// how many were valid.
+    virtual size_t
+    verify_batch(std::vector<SignatureCheck>& checks) = 0;
 
     /// derive sub keys for public keys
     virtual bool
@@ -104,10 +163,33 @@ namespace llarp
     /// check if a password hash string matches the challenge
     virtual bool
     check_passwd_hash(std::string pwhash, std::string challenge) = 0;
+
+    /// stats, such as for any caches the implementation keeps
+    virtual util::StatusObject
+    ExtractStatus() const
+    {
+      return util::StatusObject{};
+    }
   };
 
   inline Crypto::~Crypto() = default;
 
+  /// size of the tag aes256gcm_encrypt_packets puts at the front of a packet
+  static constexpr size_t AES256GCMTagSize = 16;
+  /// size of the gcm nonce at the front of a packet's nonce field
+  static constexpr size_t AES256GCMNonceSize = 12;
+
+  /// whether a packet is laid out as Crypto::aes256gcm_encrypt_packets makes them rather than
+  /// encrypt_packets: only the former leaves the second half of the keyed hash field all zero
+  inline bool
+  is_aes256gcm_packet(const std::vector<byte_t>& pkt)
+  {
+    return pkt.size() >= HMACSIZE
+        and std::all_of(pkt.begin() + AES256GCMTagSize, pkt.begin() + HMACSIZE, [](byte_t b) {
+             return b == 0;
+           });
+  }
+
   /// return random 64bit unsigned interger
   uint64_t
   randint();
@@ -1,18 +1,26 @@
 #include "crypto_libsodium.hpp"
+#include "chacha20.hpp"
+#include "fast_crypto.hpp"
 #include <sodium/crypto_generichash.h>
 #include <sodium/crypto_sign.h>
 #include <sodium/crypto_scalarmult.h>
 #include <sodium/crypto_scalarmult_ed25519.h>
-#include <sodium/crypto_stream_xchacha20.h>
+#include <sodium/crypto_core_hchacha20.h>
 #include <sodium/crypto_core_ed25519.h>
+#include <sodium/crypto_aead_aes256gcm.h>
 #include <sodium/crypto_aead_xchacha20poly1305.h>
 #include <sodium/randombytes.h>
 #include <sodium/utils.h>
 #include <oxenc/endian.h>
+#include <llarp/constants/path.hpp>
 #include <llarp/util/mem.hpp>
+#include <llarp/util/metrics.hpp>
 #include <llarp/util/str.hpp>
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstring>
+#include <thread>
 #ifdef HAVE_CRYPT
 #include <crypt.h>
 #endif
@@ -29,17 +37,37 @@ namespace llarp
 {
   namespace sodium
   {
+    static metrics::Counter packetsEncrypted{
+        "lokinet_crypto_packets_encrypted_total", "Link packets we encrypted"};
+    static metrics::Counter packetsDecrypted{
+        "lokinet_crypto_packets_decrypted_total", "Link packets we decrypted"};
+    static metrics::Counter packetsRejected{
+        "lokinet_crypto_packets_rejected_total", "Link packets that failed to authenticate"};
+    static metrics::Counter onionLayers{
+        "lokinet_crypto_onion_layers_total", "Layers of path encryption we added or took off"};
+    static metrics::Counter dhOps{"lokinet_crypto_dh_total", "Key exchanges we did"};
+    static metrics::Counter signaturesVerified{
+        "lokinet_crypto_signatures_verified_total", "Signatures we checked"};
+    static metrics::Counter signaturesInvalid{
+        "lokinet_crypto_signatures_invalid_total", "Signatures we checked that were bad"};
+
     static bool
     dh(llarp::SharedSecret& out,
        const PubKey& client_pk,
        const PubKey& server_pk,
-       const uint8_t* themPub,
-       const SecretKey& usSec)
+       const PubKey& themPub,
+       const SecretKey& usSec,
+       DHCache* cache)
     {
       llarp::SharedSecret shared;
       crypto_generichash_state h;
 
-      if (crypto_scalarmult_curve25519(shared.data(), usSec.data(), themPub))
+      if (cache)
+      {
+        if (not cache->Scalarmult(shared, usSec, themPub))
+          return false;
+      }
+      else if (crypto_scalarmult_curve25519(shared.data(), usSec.data(), themPub.data()))
       {
         return false;
       }
@@ -53,11 +81,15 @@ namespace llarp
 
     static bool
     dh_client_priv(
-        llarp::SharedSecret& shared, const PubKey& pk, const SecretKey& sk, const TunnelNonce& n)
+        llarp::SharedSecret& shared,
+        const PubKey& pk,
+        const SecretKey& sk,
+        const TunnelNonce& n,
+        DHCache* cache = nullptr)
     {
       llarp::SharedSecret dh_result;
 
-      if (dh(dh_result, sk.toPublic(), pk, pk.data(), sk))
+      if (dh(dh_result, sk.toPublic(), pk, pk, sk, cache))
       {
         return crypto_generichash_blake2b(shared.data(), 32, n.data(), 32, dh_result.data(), 32)
             != -1;
@@ -68,10 +100,14 @@ namespace llarp
 
     static bool
     dh_server_priv(
-        llarp::SharedSecret& shared, const PubKey& pk, const SecretKey& sk, const TunnelNonce& n)
+        llarp::SharedSecret& shared,
+        const PubKey& pk,
+        const SecretKey& sk,
+        const TunnelNonce& n,
+        DHCache* cache = nullptr)
     {
       llarp::SharedSecret dh_result;
-      if (dh(dh_result, pk, sk.toPublic(), pk.data(), sk))
+      if (dh(dh_result, pk, sk.toPublic(), pk, sk, cache))
       {
         return crypto_generichash_blake2b(shared.data(), 32, n.data(), 32, dh_result.data(), 32)
             != -1;
@@ -137,7 +173,8 @@ namespace llarp
     CryptoLibSodium::xchacha20(
         const llarp_buffer_t& buff, const SharedSecret& k, const TunnelNonce& n)
     {
-      return crypto_stream_xchacha20_xor(buff.base, buff.base, buff.sz, n.data(), k.data()) == 0;
+      xchacha20_xor(buff.base, buff.base, buff.sz, n.data(), k.data());
+      return true;
     }
 
     bool
@@ -146,13 +183,269 @@ namespace llarp
     {
       if (in.sz > out.sz)
         return false;
-      return crypto_stream_xchacha20_xor(out.base, in.base, in.sz, n, k.data()) == 0;
+      xchacha20_xor(out.base, in.base, in.sz, n, k.data());
+      return true;
+    }
+
+    /// how much of the buffer xchacha20_layers runs every layer over at a time; small enough to
+    /// stay in L1 between layers, and a whole number of 64 byte chacha blocks
+    static constexpr size_t layer_chunk_size = 4096;
+
+    bool
+    xchacha20_layers(
+        const llarp_buffer_t& buff, const SharedSecret* keys, const TunnelNonce* nonces, size_t n)
+    {
+      static_assert(layer_chunk_size % chacha20::BlockSize == 0);
+      if (n > path::max_len)
+        return false;
+      // xchacha20 is chacha20 keyed with hchacha20(key, first 16 bytes of nonce) and using the
+      // last 8 bytes as its nonce, so derive those subkeys once and then we can start each layer
+      // at any block we like
+      std::array<SharedSecret, path::max_len> subkeys;
+      for (size_t idx = 0; idx < n; ++idx)
+        crypto_core_hchacha20(subkeys[idx].data(), nonces[idx].data(), keys[idx].data(), nullptr);
+
+      for (size_t off = 0; off < buff.sz; off += layer_chunk_size)
+      {
+        byte_t* const chunk = buff.base + off;
+        const size_t sz = std::min(layer_chunk_size, buff.sz - off);
+        const uint64_t block = off / chacha20::BlockSize;
+        for (size_t idx = 0; idx < n; ++idx)
+        {
+          chacha20::xor_ic(chunk, chunk, sz, nonces[idx].data() + 16, block, subkeys[idx].data());
+        }
+      }
+      sodium_memzero(subkeys.data(), sizeof(subkeys));
+      return true;
+    }
+
+    /// overhead of the keyed hash and nonce in front of a batched packet's body
+    static constexpr size_t packet_overhead = HMACSIZE + TUNNONCESIZE;
+
+    // The keyed hash state after absorbing the key depends only on the key, so for a batch we set
+    // it up once and copy it for each packet rather than re-keying (which costs a full compression
+    // of the padded key block) every time.
+    static crypto_generichash_blake2b_state
+    keyed_hash_state(const SharedSecret& k)
+    {
+      crypto_generichash_blake2b_state st;
+      crypto_generichash_blake2b_init(&st, k.data(), HMACSECSIZE, HMACSIZE);
+      return st;
+    }
+
+    bool
+    encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      const auto keyed = keyed_hash_state(k);
+      bool ok = true;
+      for (auto& pkt : pkts)
+      {
+        if (pkt.size() < packet_overhead)
+        {
+          ok = false;
+          continue;
+        }
+        byte_t* const nonce = pkt.data() + HMACSIZE;
+        byte_t* const body = nonce + TUNNONCESIZE;
+        const size_t bodysz = pkt.size() - packet_overhead;
+        xchacha20_xor(body, body, bodysz, nonce, k.data());
+        auto st = keyed;
+        crypto_generichash_blake2b_update(&st, nonce, pkt.size() - HMACSIZE);
+        crypto_generichash_blake2b_final(&st, pkt.data(), HMACSIZE);
+      }
+      return ok;
+    }
+
+    size_t
+    decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      const auto keyed = keyed_hash_state(k);
+      // verify and decrypt each packet in place, moving the good ones down over the bad
+      size_t kept = 0;
+      for (auto& pkt : pkts)
+      {
+        if (pkt.size() <= packet_overhead)
+          continue;
+        byte_t* const nonce = pkt.data() + HMACSIZE;
+        byte_t* const body = nonce + TUNNONCESIZE;
+        std::array<byte_t, HMACSIZE> h;
+        auto st = keyed;
+        crypto_generichash_blake2b_update(&st, nonce, pkt.size() - HMACSIZE);
+        crypto_generichash_blake2b_final(&st, h.data(), h.size());
+        if (sodium_memcmp(h.data(), pkt.data(), HMACSIZE) != 0)
+          continue;
+        xchacha20_xor(body, body, pkt.size() - packet_overhead, nonce, k.data());
+        if (&pkt != &pkts[kept])
+          pkts[kept] = std::move(pkt);
+        ++kept;
+      }
+      const size_t dropped = pkts.size() - kept;
+      pkts.resize(kept);
+      return dropped;
+    }
+
+    bool
+    aes256gcm_available()
+    {
+      return crypto_aead_aes256gcm_is_available();
+    }
+
+    static_assert(AES256GCMTagSize == crypto_aead_aes256gcm_ABYTES);
+    static_assert(AES256GCMNonceSize == crypto_aead_aes256gcm_NPUBBYTES);
+
+    /// the aes256gcm key is the keyed hash of this under the shared secret, so that the same key
+    /// never gets used with both ciphers
+    static constexpr std::string_view aes256gcm_key_label = "lokinet aes256gcm packet key";
+
+    static bool
+    aes256gcm_state(crypto_aead_aes256gcm_state& st, const SharedSecret& k)
+    {
+      if (not aes256gcm_available())
+        return false;
+      SharedSecret key;
+      crypto_generichash_blake2b(
+          key.data(),
+          key.size(),
+          reinterpret_cast<const byte_t*>(aes256gcm_key_label.data()),
+          aes256gcm_key_label.size(),
+          k.data(),
+          HMACSECSIZE);
+      // the expanded key schedule, done once for the batch
+      crypto_aead_aes256gcm_beforenm(&st, key.data());
+      sodium_memzero(key.data(), key.size());
+      return true;
+    }
+
+    bool
+    aes256gcm_encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      crypto_aead_aes256gcm_state st;
+      if (not aes256gcm_state(st, k))
+        return false;
+      bool ok = true;
+      for (auto& pkt : pkts)
+      {
+        if (pkt.size() < packet_overhead)
+        {
+          ok = false;
+          continue;
+        }
+        byte_t* const tag = pkt.data();
+        byte_t* const nonce = pkt.data() + HMACSIZE;
+        byte_t* const body = nonce + TUNNONCESIZE;
+        std::fill(tag + AES256GCMTagSize, nonce, 0);
+        crypto_aead_aes256gcm_encrypt_detached_afternm(
+            body,
+            tag,
+            nullptr,
+            body,
+            pkt.size() - packet_overhead,
+            nonce + AES256GCMNonceSize,
+            TUNNONCESIZE - AES256GCMNonceSize,
+            nullptr,
+            nonce,
+            &st);
+      }
+      sodium_memzero(&st, sizeof(st));
+      return ok;
+    }
+
+    size_t
+    aes256gcm_decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      crypto_aead_aes256gcm_state st;
+      if (not aes256gcm_state(st, k))
+      {
+        const size_t dropped = pkts.size();
+        pkts.clear();
+        return dropped;
+      }
+      // as for xchacha20 above: decrypt in place, moving the good ones down over the bad
+      size_t kept = 0;
+      for (auto& pkt : pkts)
+      {
+        if (pkt.size() <= packet_overhead or not is_aes256gcm_packet(pkt))
+          continue;
+        const byte_t* const tag = pkt.data();
+        const byte_t* const nonce = pkt.data() + HMACSIZE;
+        byte_t* const body = pkt.data() + packet_overhead;
+        if (crypto_aead_aes256gcm_decrypt_detached_afternm(
+                body,
+                nullptr,
+                body,
+                pkt.size() - packet_overhead,
+                tag,
+                nonce + AES256GCMNonceSize,
+                TUNNONCESIZE - AES256GCMNonceSize,
+                nonce,
+                &st)
+            != 0)
+          continue;
+        if (&pkt != &pkts[kept])
+          pkts[kept] = std::move(pkt);
+        ++kept;
+      }
+      sodium_memzero(&st, sizeof(st));
+      const size_t dropped = pkts.size() - kept;
+      pkts.resize(kept);
+      return dropped;
+    }
+
+    bool
+    CryptoLibSodium::xchacha20_layers(
+        const llarp_buffer_t& buff, const SharedSecret* keys, const TunnelNonce* nonces, size_t n)
+    {
+      onionLayers.Inc(n);
+      return sodium::xchacha20_layers(buff, keys, nonces, n);
+    }
+
+    bool
+    CryptoLibSodium::encrypt_packets(
+        std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      packetsEncrypted.Inc(pkts.size());
+      return sodium::encrypt_packets(pkts, k);
+    }
+
+    size_t
+    CryptoLibSodium::decrypt_packets(
+        std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      const auto dropped = sodium::decrypt_packets(pkts, k);
+      packetsDecrypted.Inc(pkts.size());
+      packetsRejected.Inc(dropped);
+      return dropped;
+    }
+
+    bool
+    CryptoLibSodium::aes256gcm_available()
+    {
+      return sodium::aes256gcm_available();
+    }
+
+    bool
+    CryptoLibSodium::aes256gcm_encrypt_packets(
+        std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      packetsEncrypted.Inc(pkts.size());
+      return sodium::aes256gcm_encrypt_packets(pkts, k);
+    }
+
+    size_t
+    CryptoLibSodium::aes256gcm_decrypt_packets(
+        std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      const auto dropped = sodium::aes256gcm_decrypt_packets(pkts, k);
+      packetsDecrypted.Inc(pkts.size());
+      packetsRejected.Inc(dropped);
+      return dropped;
     }
 
     bool
     CryptoLibSodium::dh_client(
         llarp::SharedSecret& shared, const PubKey& pk, const SecretKey& sk, const TunnelNonce& n)
     {
+      dhOps.Inc();
       return dh_client_priv(shared, pk, sk, n);
     }
     /// path dh relay side
@@ -160,6 +453,7 @@ namespace llarp
     CryptoLibSodium::dh_server(
         llarp::SharedSecret& shared, const PubKey& pk, const SecretKey& sk, const TunnelNonce& n)
     {
+      dhOps.Inc();
       return dh_server_priv(shared, pk, sk, n);
     }
     /// transport dh client side
@@ -167,30 +461,34 @@ namespace llarp
     CryptoLibSodium::transport_dh_client(
         llarp::SharedSecret& shared, const PubKey& pk, const SecretKey& sk, const TunnelNonce& n)
     {
-      return dh_client_priv(shared, pk, sk, n);
+      dhOps.Inc();
+      return dh_client_priv(shared, pk, sk, n, &m_TransportDH);
     }
     /// transport dh server side
     bool
     CryptoLibSodium::transport_dh_server(
         llarp::SharedSecret& shared, const PubKey& pk, const SecretKey& sk, const TunnelNonce& n)
     {
-      return dh_server_priv(shared, pk, sk, n);
+      dhOps.Inc();
+      return dh_server_priv(shared, pk, sk, n, &m_TransportDH);
+    }
+
+    util::StatusObject
+    CryptoLibSodium::ExtractStatus() const
+    {
+      return util::StatusObject{{"transportDH", m_TransportDH.ExtractStatus()}};
     }
 
     bool
     CryptoLibSodium::shorthash(ShortHash& result, const llarp_buffer_t& buff)
     {
-      return crypto_generichash_blake2b(
-                 result.data(), ShortHash::SIZE, buff.base, buff.sz, nullptr, 0)
-          != -1;
+      return sodium::shorthash(result, buff);
     }
 
     bool
     CryptoLibSodium::hmac(byte_t* result, const llarp_buffer_t& buff, const SharedSecret& secret)
     {
-      return crypto_generichash_blake2b(
-                 result, HMACSIZE, buff.base, buff.sz, secret.data(), HMACSECSIZE)
-          != -1;
+      return sodium::hmac(result, buff, secret);
     }
 
     static bool
@@ -252,7 +550,59 @@ namespace llarp
     bool
     CryptoLibSodium::verify(const PubKey& pub, const llarp_buffer_t& buf, const Signature& sig)
     {
-      return crypto_sign_verify_detached(sig.data(), buf.base, buf.sz, pub.data()) != -1;
+      signaturesVerified.Inc();
+      if (crypto_sign_verify_detached(sig.data(), buf.base, buf.sz, pub.data()) != -1)
+        return true;
+      signaturesInvalid.Inc();
+      return false;
+    }
+
+    /// fewest signatures we hand to a thread of its own in verify_batch; below this starting the
+    /// thread costs more than it saves
+    static constexpr size_t verify_batch_min_per_thread = 64;
+
+    size_t
+    CryptoLibSodium::verify_batch(std::vector<SignatureCheck>& checks)
+    {
+      // libsodium has no batched ed25519 verification, so we get our speedup by running the
+      // single verifies in parallel across cores instead
+      const auto verify_range = [](SignatureCheck* begin, SignatureCheck* end) {
+        for (auto* check = begin; check != end; ++check)
+        {
+          const auto& msg = check->msg;
+          check->valid =
+              crypto_sign_verify_detached(check->sig.data(), msg.base, msg.sz, check->pubkey.data())
+              != -1;
+        }
+      };
+
+      const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+      const size_t nthreads = std::min(hw, checks.size() / verify_batch_min_per_thread);
+      if (nthreads <= 1)
+      {
+        verify_range(checks.data(), checks.data() + checks.size());
+      }
+      else
+      {
+        const size_t per_thread = (checks.size() + nthreads - 1) / nthreads;
+        std::vector<std::thread> threads;
+        threads.reserve(nthreads - 1);
+        // the calling thread takes the first share itself
+        for (size_t off = per_thread; off < checks.size(); off += per_thread)
+        {
+          auto* begin = checks.data() + off;
+          auto* end = checks.data() + std::min(off + per_thread, checks.size());
+          threads.emplace_back(verify_range, begin, end);
+        }
+        verify_range(checks.data(), checks.data() + std::min(per_thread, checks.size()));
+        for (auto& t : threads)
+          t.join();
+      }
+      const size_t valid = std::count_if(
+          checks.begin(), checks.end(), [](const auto& check) { return check.valid; });
+      signaturesVerified.Inc(checks.size());
+      signaturesInvalid.Inc(checks.size() - valid);
+      return valid;
     }
 
     /// clamp a 32 byte ec point
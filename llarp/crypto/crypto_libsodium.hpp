@@ -1,6 +1,7 @@
 #pragma once
 
 #include "crypto.hpp"
+#include "dh_cache.hpp"
 
 namespace llarp
 {
@@ -29,6 +30,35 @@ namespace llarp
           const SharedSecret&,
           const byte_t*) override;
 
+      /// fused multi layer xchacha symmetric cipher
+      bool
+      xchacha20_layers(
+          const llarp_buffer_t&,
+          const SharedSecret* keys,
+          const TunnelNonce* nonces,
+          size_t n) override;
+
+      /// batched packet encryption with one key
+      bool
+      encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&) override;
+
+      /// batched packet decryption with one key
+      size_t
+      decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&) override;
+
+      bool
+      aes256gcm_available() override;
+
+      /// batched aes256gcm packet encryption with one key
+      bool
+      aes256gcm_encrypt_packets(
+          std::vector<std::vector<byte_t>>& pkts, const SharedSecret&) override;
+
+      /// batched aes256gcm packet decryption with one key
+      size_t
+      aes256gcm_decrypt_packets(
+          std::vector<std::vector<byte_t>>& pkts, const SharedSecret&) override;
+
       /// path dh creator's side
       bool
       dh_client(SharedSecret&, const PubKey&, const SecretKey&, const TunnelNonce&) override;
@@ -58,6 +88,9 @@ namespace llarp
       /// ed25519 verify
       bool
       verify(const PubKey&, const llarp_buffer_t&, const Signature&) override;
+      /// ed25519 verify a batch
+      size_t
+      verify_batch(std::vector<SignatureCheck>& checks) override;
 
       /// derive sub keys for public keys.  hash is really only intended for
       /// testing and overrides key_n if given.
@@ -107,6 +140,19 @@ namespace llarp
 
       bool
       check_passwd_hash(std::string pwhash, std::string challenge) override;
+
+      util::StatusObject
+      ExtractStatus() const override;
+
+     private:
+      /// how many transport dh results we keep; about one per relay we might talk to
+      static constexpr size_t TransportDHCacheSize = 4096;
+
+      /// transport key exchanges are between our long lived transport key and theirs, so the same
+      /// pairs come up again on every reconnect and renegotiation.  path dh is not cached: one
+      /// side of it is always a fresh key for that path build, so it would never hit, and keeping
+      /// the results would only hold on to them for longer than they are needed.
+      DHCache m_TransportDH{TransportDHCacheSize};
     };
   }  // namespace sodium
 
@@ -0,0 +1,103 @@
+#include "dh_cache.hpp"
+
+#include <sodium/crypto_scalarmult.h>
+#include <sodium/utils.h>
+
+#include <cstring>
+#include <new>
+
+namespace llarp
+{
+  namespace sodium
+  {
+    DHCache::DHCache(size_t capacity)
+        : m_Capacity{capacity}
+        , m_Slots{static_cast<SharedSecret*>(sodium_allocarray(capacity, sizeof(SharedSecret)))}
+    {
+      if (m_Slots == nullptr)
+        throw std::bad_alloc{};
+      m_Entries.reserve(m_Capacity);
+    }
+
+    DHCache::~DHCache()
+    {
+      // sodium_free wipes it
+      sodium_free(m_Slots);
+    }
+
+    size_t
+    DHCache::KeyHash::operator()(const Key& k) const
+    {
+      // public keys are uniformly distributed enough to use some of their bytes as they are
+      size_t a, b;
+      std::memcpy(&a, k.ours.data(), sizeof(a));
+      std::memcpy(&b, k.theirs.data(), sizeof(b));
+      return a ^ (b * 0x9e3779b97f4a7c15ULL);
+    }
+
+    bool
+    DHCache::Scalarmult(SharedSecret& out, const SecretKey& ours, const PubKey& theirs)
+    {
+      const Key key{ours.toPublic(), theirs};
+      {
+        util::Lock lock{m_Access};
+        if (auto itr = m_Entries.find(key); itr != m_Entries.end())
+        {
+          ++m_Hits;
+          m_LRU.splice(m_LRU.begin(), m_LRU, itr->second.lru);
+          out = m_Slots[itr->second.slot];
+          return true;
+        }
+        ++m_Misses;
+      }
+
+      // do the expensive part without holding the lock
+      if (crypto_scalarmult_curve25519(out.data(), ours.data(), theirs.data()) != 0)
+        return false;
+      if (m_Capacity == 0)
+        return true;
+
+      util::Lock lock{m_Access};
+      // someone else may have got here first
+      if (m_Entries.count(key))
+        return true;
+      size_t slot = m_Entries.size();
+      if (slot == m_Capacity)
+      {
+        auto itr = m_Entries.find(m_LRU.back());
+        slot = itr->second.slot;
+        sodium_memzero(m_Slots[slot].data(), m_Slots[slot].size());
+        m_Entries.erase(itr);
+        m_LRU.pop_back();
+        ++m_Evictions;
+      }
+      m_Slots[slot] = out;
+      m_LRU.push_front(key);
+      m_Entries.emplace(key, Entry{slot, m_LRU.begin()});
+      return true;
+    }
+
+    void
+    DHCache::Clear()
+    {
+      util::Lock lock{m_Access};
+      sodium_memzero(m_Slots, m_Capacity * sizeof(SharedSecret));
+      m_Entries.clear();
+      m_LRU.clear();
+    }
+
+    util::StatusObject
+    DHCache::ExtractStatus() const
+    {
+      util::Lock lock{m_Access};
+      const auto lookups = m_Hits + m_Misses;
+      return util::StatusObject{
+          {"size", m_Entries.size()},
+          {"capacity", m_Capacity},
+          {"hits", m_Hits},
+          {"misses", m_Misses},
+          {"evictions", m_Evictions},
+          {"hitRate", lookups ? double(m_Hits) / lookups : 0.0}};
+    }
+  }  // namespace sodium
+}  // namespace llarp
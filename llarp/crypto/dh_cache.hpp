@@ -0,0 +1,85 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <llarp/util/status.hpp>
+#include <llarp/util/thread/threading.hpp>
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace llarp
+{
+  namespace sodium
+  {
+    /// a bounded cache of x25519 results keyed on our public key and theirs, so that repeated key
+    /// exchanges between the same two long lived keys (reconnects and renegotiation between two
+    /// relays, say) only redo the hashing and not the scalar multiplication.  the results are kept
+    /// in sodium_malloc'd memory, which is locked and guarded, and wiped as entries are evicted
+    /// and when the cache goes away.  least recently used entries go first once it is full.
+    class DHCache
+    {
+     public:
+      explicit DHCache(size_t capacity);
+
+      ~DHCache();
+
+      DHCache(const DHCache&) = delete;
+      DHCache&
+      operator=(const DHCache&) = delete;
+
+      /// put x25519(ours, theirs) into out, from the cache if we have it; returns false if the
+      /// scalar multiplication fails (theirs is a low order point), which is not cached
+      bool
+      Scalarmult(SharedSecret& out, const SecretKey& ours, const PubKey& theirs);
+
+      /// forget everything, clearing the stored results
+      void
+      Clear();
+
+      /// size, capacity and hit/miss counters
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      struct Key
+      {
+        PubKey ours;
+        PubKey theirs;
+
+        bool
+        operator==(const Key& other) const
+        {
+          return ours == other.ours and theirs == other.theirs;
+        }
+      };
+
+      struct KeyHash
+      {
+        size_t
+        operator()(const Key& k) const;
+      };
+
+      struct Entry
+      {
+        /// index into m_Slots of the stored result
+        size_t slot;
+        /// where in m_LRU this entry is
+        std::list<Key>::iterator lru;
+      };
+
+      const size_t m_Capacity;
+      /// m_Capacity results, in secure memory
+      SharedSecret* m_Slots;
+
+      mutable util::Mutex m_Access;
+      std::unordered_map<Key, Entry, KeyHash> m_Entries GUARDED_BY(m_Access);
+      /// most recently used first
+      std::list<Key> m_LRU GUARDED_BY(m_Access);
+      uint64_t m_Hits GUARDED_BY(m_Access) = 0;
+      uint64_t m_Misses GUARDED_BY(m_Access) = 0;
+      uint64_t m_Evictions GUARDED_BY(m_Access) = 0;
+    };
+  }  // namespace sodium
+}  // namespace llarp
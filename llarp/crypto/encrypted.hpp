@@ -6,26 +6,24 @@
 #include <llarp/util/buffer.hpp>
 #include <llarp/util/mem.hpp>
 
+#include <array>
+#include <cstring>
 #include <vector>
 #include <stdexcept>
 
 namespace llarp
 {
-  /// encrypted buffer base type
+  /// encrypted buffer base type.  only the first size() bytes of it mean anything, so copies only
+  /// copy those and nothing zeroes the rest: frames and the like get copied and passed on a lot
+  /// more than they get filled, and most of them are a lot smaller than bufsz.
   template <size_t bufsz = MAX_LINK_MSG_SIZE>
   struct Encrypted
   {
-    Encrypted(Encrypted&& other)
-    {
-      _sz = std::move(other._sz);
-      _buf = std::move(other._buf);
-      UpdateBuffer();
-    }
+    Encrypted(Encrypted&& other) : Encrypted(other.data(), other.size())
+    {}
 
     Encrypted(const Encrypted& other) : Encrypted(other.data(), other.size())
-    {
-      UpdateBuffer();
-    }
+    {}
 
     Encrypted()
     {
@@ -47,7 +45,7 @@ namespace llarp
         if (buf)
           memcpy(_buf.data(), buf, sz);
         else
-          _buf.Zero();
+          memset(_buf.data(), 0, sz);
       }
       else
         _sz = 0;
@@ -78,7 +76,28 @@ namespace llarp
     Encrypted&
     operator=(const Encrypted& other)
     {
-      return Encrypted::operator=(llarp_buffer_t(other));
+      if (this != &other)
+        CopyFrom(byte_view_t{other.data(), other.size()});
+      return *this;
+    }
+
+    Encrypted&
+    operator=(Encrypted&& other)
+    {
+      return *this = static_cast<const Encrypted&>(other);
+    }
+
+    /// copies in data, if it fits
+    bool
+    CopyFrom(byte_view_t data)
+    {
+      if (data.size() > bufsz)
+        return false;
+      _sz = data.size();
+      if (_sz)
+        memcpy(_buf.data(), data.data(), _sz);
+      UpdateBuffer();
+      return true;
     }
 
     Encrypted&
@@ -159,7 +178,7 @@ namespace llarp
       m_Buffer.cur = _buf.data();
       m_Buffer.sz = _sz;
     }
-    AlignedBuffer<bufsz> _buf;
+    alignas(alignof(AlignedBuffer<bufsz>)) std::array<byte_t, bufsz> _buf;
     size_t _sz;
     llarp_buffer_t m_Buffer;
   };  // namespace llarp
@@ -22,11 +22,14 @@ namespace llarp
             std::min(sz, EncryptedFrameBodySize) + EncryptedFrameOverheadSize)
     {}
 
+    /// growing it zeroes what it grows by, as nothing past the old size was ever filled
     void
     Resize(size_t sz)
     {
       if (sz <= EncryptedFrameSize)
       {
+        if (sz > _sz)
+          memset(_buf.data() + _sz, 0, sz - _sz);
         _sz = sz;
         UpdateBuffer();
       }
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "chacha20.hpp"
+#include "crypto.hpp"
+
+#include <sodium/crypto_core_hchacha20.h>
+#include <sodium/crypto_generichash_blake2b.h>
+#include <sodium/randombytes.h>
+#include <sodium/utils.h>
+
+#include <vector>
+
+/**
+ * fast_crypto.hpp
+ *
+ * the crypto the data plane does for every packet (onion layers, transport packets, padding),
+ * called directly on libsodium and our chacha20 kernels rather than through CryptoManager and
+ * the virtual llarp::Crypto, so that these calls can be inlined into the loops that make them.
+ *
+ * built with LOKINET_VIRTUAL_CRYPTO (cmake -DWITH_STATIC_CRYPTO=OFF) these forward to
+ * CryptoManager::instance() instead, for tests that want to put their own llarp::Crypto under the
+ * data plane.  everything else (handshakes, signing, key generation) always goes through
+ * llarp::Crypto.
+ */
+
+namespace llarp
+{
+  namespace sodium
+  {
+    /// xchacha20 on our own chacha20 kernels: the chacha20 key is hchacha20 of the key and the
+    /// first 16 bytes of the nonce, and the last 8 bytes are its nonce
+    inline void
+    xchacha20_xor(byte_t* out, const byte_t* in, size_t len, const byte_t* n, const byte_t* k)
+    {
+      SharedSecret subkey;
+      crypto_core_hchacha20(subkey.data(), n, k, nullptr);
+      chacha20::xor_ic(out, in, len, n + 16, 0, subkey.data());
+      sodium_memzero(subkey.data(), subkey.size());
+    }
+
+    inline bool
+    shorthash(ShortHash& result, const llarp_buffer_t& buf)
+    {
+      return crypto_generichash_blake2b(
+                 result.data(), ShortHash::SIZE, buf.base, buf.sz, nullptr, 0)
+          != -1;
+    }
+
+    inline bool
+    hmac(byte_t* result, const llarp_buffer_t& buf, const SharedSecret& secret)
+    {
+      return crypto_generichash_blake2b(
+                 result, HMACSIZE, buf.base, buf.sz, secret.data(), HMACSECSIZE)
+          != -1;
+    }
+
+    /// the bodies of CryptoLibSodium's methods of the same names, which just call these
+    bool
+    xchacha20_layers(
+        const llarp_buffer_t&, const SharedSecret* keys, const TunnelNonce* nonces, size_t n);
+
+    bool
+    encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&);
+
+    size_t
+    decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&);
+
+    bool
+    aes256gcm_available();
+
+    bool
+    aes256gcm_encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&);
+
+    size_t
+    aes256gcm_decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret&);
+  }  // namespace sodium
+
+  /// the same signatures and semantics as the llarp::Crypto methods of the same names
+  namespace fast_crypto
+  {
+#ifdef LOKINET_VIRTUAL_CRYPTO
+    inline bool
+    xchacha20(const llarp_buffer_t& buf, const SharedSecret& k, const TunnelNonce& n)
+    {
+      return CryptoManager::instance()->xchacha20(buf, k, n);
+    }
+
+    inline bool
+    xchacha20_layers(
+        const llarp_buffer_t& buf, const SharedSecret* keys, const TunnelNonce* nonces, size_t n)
+    {
+      return CryptoManager::instance()->xchacha20_layers(buf, keys, nonces, n);
+    }
+
+    inline bool
+    encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      return CryptoManager::instance()->encrypt_packets(pkts, k);
+    }
+
+    inline size_t
+    decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      return CryptoManager::instance()->decrypt_packets(pkts, k);
+    }
+
+    inline bool
+    aes256gcm_available()
+    {
+      return CryptoManager::instance()->aes256gcm_available();
+    }
+
+    inline bool
+    aes256gcm_encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      return CryptoManager::instance()->aes256gcm_encrypt_packets(pkts, k);
+    }
+
+    inline size_t
+    aes256gcm_decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      return CryptoManager::instance()->aes256gcm_decrypt_packets(pkts, k);
+    }
+
+    inline bool
+    shorthash(ShortHash& result, const llarp_buffer_t& buf)
+    {
+      return CryptoManager::instance()->shorthash(result, buf);
+    }
+
+    inline bool
+    hmac(byte_t* result, const llarp_buffer_t& buf, const SharedSecret& secret)
+    {
+      return CryptoManager::instance()->hmac(result, buf, secret);
+    }
+
+    inline void
+    randbytes(byte_t* ptr, size_t sz)
+    {
+      CryptoManager::instance()->randbytes(ptr, sz);
+    }
+#else
+    inline bool
+    xchacha20(const llarp_buffer_t& buf, const SharedSecret& k, const TunnelNonce& n)
+    {
+      sodium::xchacha20_xor(buf.base, buf.base, buf.sz, n.data(), k.data());
+      return true;
+    }
+
+    inline bool
+    xchacha20_layers(
+        const llarp_buffer_t& buf, const SharedSecret* keys, const TunnelNonce* nonces, size_t n)
+    {
+      return sodium::xchacha20_layers(buf, keys, nonces, n);
+    }
+
+    inline bool
+    encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      return sodium::encrypt_packets(pkts, k);
+    }
+
+    inline size_t
+    decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      return sodium::decrypt_packets(pkts, k);
+    }
+
+    inline bool
+    aes256gcm_available()
+    {
+      return sodium::aes256gcm_available();
+    }
+
+    inline bool
+    aes256gcm_encrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      return sodium::aes256gcm_encrypt_packets(pkts, k);
+    }
+
+    inline size_t
+    aes256gcm_decrypt_packets(std::vector<std::vector<byte_t>>& pkts, const SharedSecret& k)
+    {
+      return sodium::aes256gcm_decrypt_packets(pkts, k);
+    }
+
+    inline bool
+    shorthash(ShortHash& result, const llarp_buffer_t& buf)
+    {
+      return sodium::shorthash(result, buf);
+    }
+
+    inline bool
+    hmac(byte_t* result, const llarp_buffer_t& buf, const SharedSecret& secret)
+    {
+      return sodium::hmac(result, buf, secret);
+    }
+
+    inline void
+    randbytes(byte_t* ptr, size_t sz)
+    {
+      randombytes(ptr, sz);
+    }
+#endif
+  }  // namespace fast_crypto
+}  // namespace llarp
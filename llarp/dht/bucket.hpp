@@ -1,24 +1,30 @@
 #pragma once
 
+#include "closest.hpp"
 #include "kademlia.hpp"
 #include "key.hpp"
 #include <llarp/util/status.hpp>
 
-#include <map>
+#include <algorithm>
+#include <optional>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 namespace llarp
 {
   namespace dht
   {
+    /// the nodes we know of, keyed by their dht location.  besides a hash table of the nodes
+    /// themselves we keep their keys in one sorted flat array, for VisitClosest.
     template <typename Val_t>
     struct Bucket
     {
-      using BucketStorage_t = std::map<Key_t, Val_t, XorMetric>;
       using Random_t = std::function<uint64_t()>;
 
-      Bucket(const Key_t& us, Random_t r) : nodes(XorMetric(us)), random(std::move(r))
+      /// distances are to whatever we are asked about, so where we are ourselves doesn't come
+      /// into it
+      Bucket(const Key_t& /*us*/, Random_t r) : random(std::move(r))
       {}
 
       util::StatusObject
@@ -38,82 +44,66 @@ namespace llarp
         return nodes.size();
       }
 
-      struct SetIntersector
-      {
-        bool
-        operator()(const typename BucketStorage_t::value_type& lhs, const Key_t& rhs)
-        {
-          return lhs.first < rhs;
-        }
-
-        bool
-        operator()(const Key_t& lhs, const typename BucketStorage_t::value_type& rhs)
-        {
-          return lhs < rhs.first;
-        }
-      };
-
       bool
       GetRandomNodeExcluding(Key_t& result, const std::set<Key_t>& exclude) const
       {
-        std::vector<typename BucketStorage_t::value_type> candidates;
-        std::set_difference(
-            nodes.begin(),
-            nodes.end(),
-            exclude.begin(),
-            exclude.end(),
-            std::back_inserter(candidates),
-            SetIntersector());
-
-        if (candidates.empty())
+        if (keys.empty())
+          return false;
+        // O(1) expected while exclude is a small part of what we have
+        for (size_t tries = 0; tries < 8; ++tries)
         {
+          const auto& key = keys[random() % keys.size()];
+          if (exclude.count(key) == 0)
+          {
+            result = key;
+            return true;
+          }
+        }
+        const size_t candidates = std::count_if(
+            keys.begin(), keys.end(), [&exclude](const auto& k) { return exclude.count(k) == 0; });
+        if (candidates == 0)
           return false;
+        auto pick = random() % candidates;
+        for (const auto& key : keys)
+        {
+          if (exclude.count(key))
+            continue;
+          if (pick-- == 0)
+          {
+            result = key;
+            break;
+          }
         }
-        result = candidates[random() % candidates.size()].first;
         return true;
       }
 
       bool
       FindClosest(const Key_t& target, Key_t& result) const
       {
-        Key_t mindist;
-        mindist.Fill(0xff);
-        for (const auto& item : nodes)
-        {
-          auto curDist = item.first ^ target;
-          if (curDist < mindist)
-          {
-            mindist = curDist;
-            result = item.first;
-          }
-        }
-        return nodes.size() > 0;
+        size_t n = 1;
+        WalkClosest(target, n, [](const auto&) { return false; }, [&result](const auto& k) {
+          result = k;
+        });
+        return n == 0;
       }
 
       bool
       GetManyRandom(std::set<Key_t>& result, size_t N) const
       {
-        if (nodes.size() < N || nodes.empty())
+        if (keys.size() < N || keys.empty())
         {
-          llarp::LogWarn("Not enough dht nodes, have ", nodes.size(), " want ", N);
+          llarp::LogWarn("Not enough dht nodes, have ", keys.size(), " want ", N);
           return false;
         }
-        if (nodes.size() == N)
+        if (keys.size() == N)
         {
-          std::transform(
-              nodes.begin(), nodes.end(), std::inserter(result, result.end()), [](const auto& a) {
-                return a.first;
-              });
-
+          result.insert(keys.begin(), keys.end());
           return true;
         }
         size_t expecting = N;
-        size_t sz = nodes.size();
         while (N)
         {
-          auto itr = nodes.begin();
-          std::advance(itr, random() % sz);
-          if (result.insert(itr->first).second)
+          if (result.insert(keys[random() % keys.size()]).second)
           {
             --N;
           }
@@ -124,25 +114,13 @@ namespace llarp
       bool
       FindCloseExcluding(const Key_t& target, Key_t& result, const std::set<Key_t>& exclude) const
       {
-        Key_t maxdist;
-        maxdist.Fill(0xff);
-        Key_t mindist;
-        mindist.Fill(0xff);
-        for (const auto& item : nodes)
-        {
-          if (exclude.count(item.first))
-          {
-            continue;
-          }
-
-          auto curDist = item.first ^ target;
-          if (curDist < mindist)
-          {
-            mindist = curDist;
-            result = item.first;
-          }
-        }
-        return mindist < maxdist;
+        size_t n = 1;
+        WalkClosest(
+            target,
+            n,
+            [&exclude](const auto& k) { return exclude.count(k) > 0; },
+            [&result](const auto& k) { result = k; });
+        return n == 0;
       }
 
       bool
@@ -152,28 +130,26 @@ namespace llarp
           size_t N,
           const std::set<Key_t>& exclude) const
       {
-        std::set<Key_t> s(exclude.begin(), exclude.end());
-
-        Key_t peer;
-        while (N--)
-        {
-          if (!FindCloseExcluding(target, peer, s))
-          {
-            return false;
-          }
-          s.insert(peer);
-          result.insert(peer);
-        }
-        return true;
+        WalkClosest(
+            target,
+            N,
+            [&exclude](const auto& k) { return exclude.count(k) > 0; },
+            [&result](const auto& k) { result.insert(k); });
+        return N == 0;
       }
 
       void
       PutNode(const Val_t& val)
       {
         auto itr = nodes.find(val.ID);
-        if (itr == nodes.end() || itr->second < val)
+        if (itr == nodes.end())
         {
-          nodes[val.ID] = val;
+          keys.insert(std::lower_bound(keys.begin(), keys.end(), val.ID), val.ID);
+          nodes.emplace(val.ID, val);
+        }
+        else if (itr->second < val)
+        {
+          itr->second = val;
         }
       }
 
@@ -184,6 +160,7 @@ namespace llarp
         if (itr != nodes.end())
         {
           nodes.erase(itr);
+          keys.erase(std::lower_bound(keys.begin(), keys.end(), key));
         }
       }
 
@@ -193,19 +170,40 @@ namespace llarp
         return nodes.find(key) != nodes.end();
       }
 
+      std::optional<Val_t>
+      GetNode(const Key_t& key) const
+      {
+        auto itr = nodes.find(key);
+        if (itr == nodes.end())
+          return std::nullopt;
+        return itr->second;
+      }
+
       // remove all nodes who's key matches a predicate
       template <typename Predicate>
       void
       RemoveIf(Predicate pred)
+      {
+        RemoveNodeIf([&pred](const auto& key, const auto&) { return pred(key); });
+      }
+
+      /// remove all nodes for which pred(key, node) is true
+      template <typename Predicate>
+      void
+      RemoveNodeIf(Predicate pred)
       {
         auto itr = nodes.begin();
         while (itr != nodes.end())
         {
-          if (pred(itr->first))
+          if (pred(itr->first, itr->second))
             itr = nodes.erase(itr);
           else
             ++itr;
         }
+        keys.erase(
+            std::remove_if(
+                keys.begin(), keys.end(), [this](const auto& k) { return nodes.count(k) == 0; }),
+            keys.end());
       }
 
       template <typename Visit_t>
@@ -222,10 +220,23 @@ namespace llarp
       Clear()
       {
         nodes.clear();
+        keys.clear();
       }
 
-      BucketStorage_t nodes;
       Random_t random;
+
+     private:
+      std::unordered_map<Key_t, Val_t, std::hash<AlignedBuffer<Key_t::SIZE>>> nodes;
+      /// the keys of nodes, sorted
+      std::vector<Key_t> keys;
+
+      /// VisitClosest over all our keys
+      template <typename Skip, typename Visit>
+      void
+      WalkClosest(const Key_t& target, size_t& n, Skip skip, Visit visit) const
+      {
+        VisitClosest(target, keys.data(), keys.data() + keys.size(), n, skip, visit);
+      }
     };
   }  // namespace dht
 }  // namespace llarp
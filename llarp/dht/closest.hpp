@@ -0,0 +1,128 @@
+#pragma once
+
+#include <oxenc/endian.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace llarp
+{
+  namespace dht
+  {
+    namespace detail
+    {
+      /// runs this short we just sort rather than keep splitting
+      constexpr size_t LinearScanSize = 16;
+
+      template <typename Key>
+      bool
+      Bit(const Key& k, size_t depth)
+      {
+        return (k[depth / 8] >> (7 - depth % 8)) & 1;
+      }
+
+      /// a key as big endian words, so that comparing them compares the keys
+      template <typename Key>
+      using Words = std::array<uint64_t, Key::SIZE / 8>;
+
+      template <typename Key>
+      Words<Key>
+      LoadWords(const Key& k)
+      {
+        static_assert(Key::SIZE % 8 == 0);
+        Words<Key> words;
+        for (size_t i = 0; i < words.size(); ++i)
+          words[i] = oxenc::load_big_to_host<uint64_t>(k.data() + i * 8);
+        return words;
+      }
+
+      /// the xor distances of keys [first, first + len) to target, into dist: one pass of word
+      /// loads and xors that the compiler can vectorise, rather than a key sized xor made for
+      /// every comparison
+      template <typename Key>
+      void
+      Distances(const Words<Key>& target, const Key* const* keys, size_t len, Words<Key>* dist)
+      {
+        for (size_t idx = 0; idx < len; ++idx)
+        {
+          const auto* k = keys[idx]->data();
+          for (size_t i = 0; i < target.size(); ++i)
+            dist[idx][i] = oxenc::load_big_to_host<uint64_t>(k + i * 8) ^ target[i];
+        }
+      }
+
+      /// VisitClosest over [first, last), whose keys all share their first depth bits
+      template <typename Key, typename Skip, typename Visit>
+      void
+      VisitClosest(
+          const Key& target,
+          const Key* first,
+          const Key* last,
+          size_t depth,
+          size_t& n,
+          Skip& skip,
+          Visit& visit)
+      {
+        while (n and first != last)
+        {
+          if (size_t(last - first) <= LinearScanSize or depth == Key::SIZE * 8)
+          {
+            std::array<const Key*, LinearScanSize> run;
+            size_t len = 0;
+            for (; first != last and len < run.size(); ++first)
+            {
+              if (not skip(*first))
+                run[len++] = first;
+            }
+            std::array<Words<Key>, LinearScanSize> dist;
+            Distances(LoadWords(target), run.data(), len, dist.data());
+            std::array<uint8_t, LinearScanSize> order;
+            for (size_t idx = 0; idx < len; ++idx)
+              order[idx] = idx;
+            const auto take = std::min(n, len);
+            std::partial_sort(
+                order.begin(), order.begin() + take, order.begin() + len, [&dist](auto a, auto b) {
+                  return dist[a] < dist[b];
+                });
+            for (size_t idx = 0; idx < take; ++idx)
+              visit(*run[order[idx]]);
+            n -= take;
+            return;
+          }
+          const Key* mid = std::partition_point(
+              first, last, [depth](const auto& k) { return not Bit(k, depth); });
+          // everything on target's side of the split is nearer than anything on the other
+          if (Bit(target, depth))
+          {
+            VisitClosest(target, mid, last, depth + 1, n, skip, visit);
+            last = mid;
+          }
+          else
+          {
+            VisitClosest(target, first, mid, depth + 1, n, skip, visit);
+            first = mid;
+          }
+          ++depth;
+        }
+      }
+    }  // namespace detail
+
+    /// hand visit up to n of the keys in the sorted range [first, last) nearest target by xor and
+    /// that skip says no to, nearest first, taking what it visits off n.
+    ///
+    /// a sorted array of keys is a binary trie laid out in order: the keys sharing any given
+    /// prefix are a contiguous run of it, and the run splits at a binary search into the halves
+    /// whose next bit is 0 and 1.  every key in the half whose next bit matches target's is
+    /// nearer to it than every key in the other half, so this is one walk down that takes
+    /// O(log size + n) and allocates nothing.
+    template <typename Key, typename Skip, typename Visit>
+    void
+    VisitClosest(
+        const Key& target, const Key* first, const Key* last, size_t& n, Skip skip, Visit visit)
+    {
+      detail::VisitClosest(target, first, last, 0, n, skip, visit);
+    }
+  }  // namespace dht
+}  // namespace llarp
@@ -4,6 +4,7 @@
 #include "localrouterlookup.hpp"
 #include "localserviceaddresslookup.hpp"
 #include "localtaglookup.hpp"
+#include <llarp/dht/messages/findrcs.hpp>
 #include <llarp/dht/messages/findrouter.hpp>
 #include <llarp/dht/messages/gotintro.hpp>
 #include <llarp/dht/messages/gotrouter.hpp>
@@ -18,9 +19,11 @@
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/routing/dht_message.hpp>
 #include <llarp/nodedb.hpp>
+#include <llarp/config/config.hpp>
 #include <llarp/profiling.hpp>
 #include <llarp/router/i_rc_lookup_handler.hpp>
 #include <llarp/util/decaying_hashset.hpp>
+#include <algorithm>
 #include <vector>
 
 namespace llarp
@@ -118,7 +121,7 @@ namespace llarp
           const Key_t& requester,
           uint64_t txid,
           const RouterID& target,
-          std::vector<std::unique_ptr<IMessage>>& reply) override;
+          std::vector<IMessage::Ptr_t>& reply) override;
 
       /// handle rc lookup from requester for target
       void
@@ -127,7 +130,7 @@ namespace llarp
           uint64_t txid,
           const Key_t& target,
           bool recursive,
-          std::vector<std::unique_ptr<IMessage>>& replies) override;
+          std::vector<IMessage::Ptr_t>& replies) override;
 
       /// relay a dht message from a local path to the main network
       bool
@@ -171,9 +174,9 @@ namespace llarp
       std::unique_ptr<Bucket<RCNode>> _nodes;
 
       // for introduction sets
-      std::unique_ptr<Bucket<ISNode>> _services;
+      std::unique_ptr<IntroSetStore> _services;
 
-      Bucket<ISNode>*
+      IntroSetStore*
       services() override
       {
         return _services.get();
@@ -236,6 +239,20 @@ namespace llarp
       PendingIntrosetLookups _pendingIntrosetLookups;
       PendingRouterLookups _pendingRouterLookups;
       PendingExploreLookups _pendingExploreLookups;
+      RCAnswerCache _rcAnswers;
+      util::DecayingHashSet<RouterID> _bulkRCRequesters{FindRCsMessage::BulkInterval};
+
+      RCAnswerCache&
+      rcAnswers() override
+      {
+        return _rcAnswers;
+      }
+
+      util::DecayingHashSet<RouterID>&
+      bulkRCRequesters() override
+      {
+        return _bulkRCRequesters;
+      }
 
       PendingIntrosetLookups&
       pendingIntrosetLookups() override
@@ -291,6 +308,10 @@ namespace llarp
       void
       CleanupTX();
 
+      /// how long to wait on peer for an introset it stores, from the rtt we have seen to it
+      llarp_time_t
+      IntroSetLookupTimeout(const Key_t& peer) const;
+
       uint64_t ids;
 
       Key_t ourKey;
@@ -338,34 +359,17 @@ namespace llarp
       if (_nodes)
       {
         // expire router contacts in memory
-        auto& nodes = _nodes->nodes;
-        auto itr = nodes.begin();
-        while (itr != nodes.end())
-        {
-          if (itr->second.rc.IsExpired(now))
-          {
-            itr = nodes.erase(itr);
-          }
-          else
-            ++itr;
-        }
+        _nodes->RemoveNodeIf(
+            [now](const auto&, const auto& node) { return node.rc.IsExpired(now); });
       }
 
       if (_services)
       {
         // expire intro sets
-        auto& nodes = _services->nodes;
-        auto itr = nodes.begin();
-        while (itr != nodes.end())
-        {
-          if (itr->second.introset.IsExpired(now))
-          {
-            itr = nodes.erase(itr);
-          }
-          else
-            ++itr;
-        }
+        _services->Expire(now);
       }
+      _rcAnswers.Decay(now);
+      _bulkRCRequesters.Decay(now);
     }
 
     void
@@ -374,7 +378,7 @@ namespace llarp
         uint64_t txid,
         const Key_t& target,
         bool recursive,
-        std::vector<std::unique_ptr<IMessage>>& replies)
+        std::vector<IMessage::Ptr_t>& replies)
     {
       if (target == ourKey)
       {
@@ -388,6 +392,13 @@ namespace llarp
         replies.emplace_back(new GotRouterMessage(requester, txid, {}, false));
         return;
       }
+      if (auto answer = _rcAnswers.Get(target.as_array(), Now()))
+      {
+        auto* reply = new GotRouterMessage(requester, txid, {}, false);
+        reply->encodedRCs = std::move(answer);
+        replies.emplace_back(reply);
+        return;
+      }
       const auto rc = GetRouter()->nodedb()->FindClosestTo(target);
       const Key_t next(rc.pubkey);
       {
@@ -401,14 +412,18 @@ namespace llarp
           }
           else
           {
-            // send reply with rc we know of
-            replies.emplace_back(new GotRouterMessage(requester, txid, {rc}, false));
+            // send reply with rc we know of, keeping it for whoever asks next
+            auto* reply = new GotRouterMessage(requester, txid, {}, false);
+            reply->encodedRCs = _rcAnswers.Put(rc, Now());
+            if (not reply->encodedRCs)
+              reply->foundRCs.push_back(rc);
+            replies.emplace_back(reply);
           }
         }
         else if (recursive)  // are we doing a recursive lookup?
         {
           // is the next peer we ask closer to the target than us?
-          if ((next ^ target) < (ourKey ^ target))
+          if (target.XorCloser(next, ourKey))
           {
             // yes it is closer, ask neighbour recursively
             LookupRouterRecursive(target.as_array(), requester, txid, next);
@@ -431,10 +446,7 @@ namespace llarp
     std::optional<llarp::service::EncryptedIntroSet>
     Context::GetIntroSetByLocation(const Key_t& key) const
     {
-      auto itr = _services->nodes.find(key);
-      if (itr == _services->nodes.end())
-        return {};
-      return itr->second.introset;
+      return _services->Get(key, Now());
     }
 
     void
@@ -467,7 +479,13 @@ namespace llarp
       router = r;
       ourKey = us;
       _nodes = std::make_unique<Bucket<RCNode>>(ourKey, llarp::randint);
-      _services = std::make_unique<Bucket<ISNode>>(ourKey, llarp::randint);
+      size_t introsetBudget = IntroSetStore::DefaultMaxBytes;
+      if (const auto conf = r->GetConfig())
+        introsetBudget = size_t{1000} * conf->router.m_IntroSetStoreSize;
+      _services = std::make_unique<IntroSetStore>(introsetBudget);
+      // an answer has to go as soon as the rc it was made from does
+      if (auto nodedb = r->nodedb())
+        nodedb->SetChangeHook([this](const RouterID& rid) { _rcAnswers.Invalidate(rid); });
       llarp::LogDebug("initialize dht with key ", ourKey);
       // start cleanup timer
       _timer_keepalive = std::make_shared<int>(0);
@@ -502,6 +520,19 @@ namespace llarp
       return true;
     }
 
+    llarp_time_t
+    Context::IntroSetLookupTimeout(const Key_t& peer) const
+    {
+      // it answers out of its store, so a few round trips covers it even when we have to make a
+      // session to it first.  with no rtt to go by we wait as long as for anything else.
+      static constexpr auto DefaultTimeout = 15s;
+      static constexpr auto MinTimeout = 2s;
+      const auto rtt = router->routerProfiling().GetRTT(RouterID{peer.as_array()});
+      if (not rtt)
+        return DefaultTimeout;
+      return std::clamp<llarp_time_t>(*rtt * 8, MinTimeout, DefaultTimeout);
+    }
+
     void
     Context::LookupIntroSetForPath(
         const Key_t& addr,
@@ -516,7 +547,8 @@ namespace llarp
           peer,
           asker,
           asker,
-          new LocalServiceAddressLookup(path, txid, relayOrder, addr, this, askpeer));
+          new LocalServiceAddressLookup(path, txid, relayOrder, addr, this, askpeer),
+          IntroSetLookupTimeout(askpeer));
     }
 
     void
@@ -562,7 +594,11 @@ namespace llarp
       const TXOwner asker(whoasked, txid);
       const TXOwner peer(askpeer, ++ids);
       _pendingIntrosetLookups.NewTX(
-          peer, asker, asker, new ServiceAddressLookup(asker, addr, this, relayOrder, handler));
+          peer,
+          asker,
+          asker,
+          new ServiceAddressLookup(asker, addr, this, relayOrder, handler),
+          IntroSetLookupTimeout(askpeer));
     }
 
     void
@@ -584,7 +620,7 @@ namespace llarp
         const Key_t& requester,
         uint64_t txid,
         const RouterID& target,
-        std::vector<std::unique_ptr<IMessage>>& reply)
+        std::vector<IMessage::Ptr_t>& reply)
     {
       std::vector<RouterID> closer;
       const Key_t t(target.as_array());
@@ -3,14 +3,17 @@
 
 #include "bucket.hpp"
 #include "dht.h"
+#include "introset_store.hpp"
 #include "key.hpp"
 #include "message.hpp"
 #include <llarp/dht/messages/findintro.hpp>
 #include "node.hpp"
+#include "rc_answer_cache.hpp"
 #include "tx.hpp"
 #include "txholder.hpp"
 #include "txowner.hpp"
 #include <llarp/service/intro_set.hpp>
+#include <llarp/util/decaying_hashset.hpp>
 #include <llarp/util/time.hpp>
 #include <llarp/util/status.hpp>
 
@@ -97,7 +100,7 @@ namespace llarp
           const Key_t& requester,
           uint64_t txid,
           const RouterID& target,
-          std::vector<std::unique_ptr<IMessage>>& reply) = 0;
+          std::vector<IMessage::Ptr_t>& reply) = 0;
 
       /// handle rc lookup from requester for target
       virtual void
@@ -106,7 +109,7 @@ namespace llarp
           uint64_t txid,
           const Key_t& target,
           bool recursive,
-          std::vector<std::unique_ptr<IMessage>>& replies) = 0;
+          std::vector<IMessage::Ptr_t>& replies) = 0;
 
       virtual bool
       RelayRequestForPath(const PathID_t& localPath, const IMessage& msg) = 0;
@@ -168,9 +171,18 @@ namespace llarp
       virtual const PendingExploreLookups&
       pendingExploreLookups() const = 0;
 
-      virtual Bucket<ISNode>*
+      virtual IntroSetStore*
       services() = 0;
 
+      /// the rcs we lately answered lookups with
+      virtual RCAnswerCache&
+      rcAnswers() = 0;
+
+      /// the peers we lately sent every rc updated since some time, so each gets that only so
+      /// often
+      virtual util::DecayingHashSet<RouterID>&
+      bulkRCRequesters() = 0;
+
       virtual bool&
       AllowTransit() = 0;
       virtual const bool&
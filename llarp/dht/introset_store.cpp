@@ -0,0 +1,142 @@
+#include "introset_store.hpp"
+
+#include <llarp/constants/path.hpp>
+
+namespace llarp
+{
+  namespace dht
+  {
+    IntroSetStore::IntroSetStore(size_t maxBytes)
+        : m_MaxBytes{maxBytes}
+        , m_Shedder{util::MemAccount::AddShedder(
+              util::MemTag::Service, [this](size_t over) { Shed(over); })}
+    {}
+
+    IntroSetStore::~IntroSetStore()
+    {
+      util::MemAccount::Freed(util::MemTag::Service, m_Bytes);
+    }
+
+    size_t
+    IntroSetStore::Footprint(const service::EncryptedIntroSet& introset)
+    {
+      // the payload, the entry around it, and the key in each of the three indexes
+      return introset.introsetPayload.size() + sizeof(Entry) + 3 * sizeof(Key_t);
+    }
+
+    void
+    IntroSetStore::Put(service::EncryptedIntroSet introset, const Key_t& source)
+    {
+      const Key_t location{introset.derivedSigningKey.as_array()};
+      if (auto itr = m_Entries.find(location); itr != m_Entries.end())
+      {
+        if (not(itr->second.introset.signedAt < introset.signedAt))
+          return;
+        Erase(itr);
+      }
+      const size_t bytes = Footprint(introset);
+      if (m_MaxBytes and bytes > m_MaxBytes)
+        return;
+      if (m_MaxBytes and m_Bytes + bytes > m_MaxBytes)
+      {
+        const auto held = m_SourceBytes.find(source);
+        if (held != m_SourceBytes.end() and held->second >= m_MaxBytes / SourceShare)
+        {
+          ++m_Refused;
+          return;
+        }
+      }
+      while (m_MaxBytes and m_Bytes + bytes > m_MaxBytes)
+      {
+        Erase(m_Entries.find(m_LRU.back()));
+        ++m_Evictions;
+      }
+      const auto expiresAt = introset.signedAt + path::default_lifetime;
+      m_LRU.push_front(location);
+      const auto expiry = m_Expiry.emplace(expiresAt, location);
+      m_Entries.emplace(
+          location, Entry{std::move(introset), bytes, source, m_LRU.begin(), expiry});
+      m_Bytes += bytes;
+      m_SourceBytes[source] += bytes;
+      util::MemAccount::Allocated(util::MemTag::Service, bytes);
+    }
+
+    bool
+    IntroSetStore::Holds(const service::EncryptedIntroSet& introset) const
+    {
+      const auto itr = m_Entries.find(Key_t{introset.derivedSigningKey.as_array()});
+      if (itr == m_Entries.end())
+        return false;
+      // == leaves out the payload and topic, which the signature covers too
+      const auto& stored = itr->second.introset;
+      return stored == introset and stored.topic == introset.topic
+          and stored.introsetPayload == introset.introsetPayload;
+    }
+
+    std::optional<service::EncryptedIntroSet>
+    IntroSetStore::Get(const Key_t& location, llarp_time_t now)
+    {
+      auto itr = m_Entries.find(location);
+      if (itr == m_Entries.end() or itr->second.introset.IsExpired(now))
+      {
+        ++m_Misses;
+        return std::nullopt;
+      }
+      ++m_Hits;
+      m_LRU.splice(m_LRU.begin(), m_LRU, itr->second.lru);
+      return itr->second.introset;
+    }
+
+    void
+    IntroSetStore::Expire(llarp_time_t now)
+    {
+      while (not m_Expiry.empty() and m_Expiry.begin()->first <= now)
+      {
+        Erase(m_Entries.find(m_Expiry.begin()->second));
+        ++m_Expired;
+      }
+    }
+
+    void
+    IntroSetStore::Shed(size_t bytes)
+    {
+      const auto target = m_Bytes > bytes ? m_Bytes - bytes : 0;
+      while (m_Bytes > target and not m_LRU.empty())
+      {
+        Erase(m_Entries.find(m_LRU.back()));
+        ++m_Evictions;
+      }
+    }
+
+    void
+    IntroSetStore::Erase(Entries::iterator itr)
+    {
+      m_Bytes -= itr->second.bytes;
+      if (auto held = m_SourceBytes.find(itr->second.source);
+          (held->second -= itr->second.bytes) == 0)
+        m_SourceBytes.erase(held);
+      util::MemAccount::Freed(util::MemTag::Service, itr->second.bytes);
+      m_LRU.erase(itr->second.lru);
+      m_Expiry.erase(itr->second.expiry);
+      m_Entries.erase(itr);
+    }
+
+    util::StatusObject
+    IntroSetStore::ExtractStatus() const
+    {
+      util::StatusObject introsets{};
+      for (const auto& [location, entry] : m_Entries)
+        introsets[location.ToString()] = entry.introset.ExtractStatus();
+      return util::StatusObject{
+          {"size", m_Entries.size()},
+          {"bytes", m_Bytes},
+          {"maxBytes", m_MaxBytes},
+          {"hits", m_Hits},
+          {"misses", m_Misses},
+          {"evictions", m_Evictions},
+          {"expired", m_Expired},
+          {"refused", m_Refused},
+          {"introsets", std::move(introsets)}};
+    }
+  }  // namespace dht
+}  // namespace llarp
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "key.hpp"
+#include <llarp/service/intro_set.hpp>
+#include <llarp/util/mem_account.hpp>
+#include <llarp/util/status.hpp>
+#include <llarp/util/time.hpp>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <optional>
+#include <unordered_map>
+
+namespace llarp
+{
+  namespace dht
+  {
+    /// the introsets published to us as a relay, by their location.  held to a memory budget:
+    /// once over it the least recently looked up go first, and they go anyway once they expire,
+    /// soonest to expire first so that expiring never looks at the rest.  each introset is held
+    /// against the peer or path it came from, and one holding 1/SourceShare of the budget or more
+    /// may still fill what is free but not push out anyone else's, so that a flood from one
+    /// source cannot empty the store of everyone else's introsets.
+    class IntroSetStore
+    {
+     public:
+      /// the budget when there is no config to say, as [router]:introset-store-size does
+      static constexpr size_t DefaultMaxBytes = 16'000'000;
+
+      /// the part of the budget past which a source may no longer evict
+      static constexpr size_t SourceShare = 16;
+
+      /// maxBytes of 0 for no budget
+      explicit IntroSetStore(size_t maxBytes);
+
+      ~IntroSetStore();
+
+      IntroSetStore(const IntroSetStore&) = delete;
+      IntroSetStore&
+      operator=(const IntroSetStore&) = delete;
+
+      /// store introset from source under its location unless what we have there is newer,
+      /// evicting to stay within budget if source holds less than its share.  one that would not
+      /// fit even alone, or that source is over its share to make room for, is not kept.
+      void
+      Put(service::EncryptedIntroSet introset, const Key_t& source);
+
+      /// true if what we store at introset's location is introset to the byte, signature and
+      /// all, so that a republish of it needs no checking again but for expiry, which this
+      /// does not look at
+      bool
+      Holds(const service::EncryptedIntroSet& introset) const;
+
+      /// the introset at location if we have one that has not expired, counting it as used
+      std::optional<service::EncryptedIntroSet>
+      Get(const Key_t& location, llarp_time_t now);
+
+      /// drop the introsets that have expired
+      void
+      Expire(llarp_time_t now);
+
+      /// drop the least recently looked up introsets until we hold bytes less, or nothing; what
+      /// we do when the service tag is over its soft limit
+      void
+      Shed(size_t bytes);
+
+      size_t
+      size() const
+      {
+        return m_Entries.size();
+      }
+
+      /// what we reckon the stored introsets take up
+      size_t
+      Bytes() const
+      {
+        return m_Bytes;
+      }
+
+      /// sizes, the budget, hit/miss, eviction and refusal counters, and the introsets themselves
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      struct Entry
+      {
+        service::EncryptedIntroSet introset;
+        size_t bytes;
+        Key_t source;
+        /// where in m_LRU and m_Expiry this entry is
+        std::list<Key_t>::iterator lru;
+        std::multimap<llarp_time_t, Key_t>::iterator expiry;
+      };
+      using Entries = std::unordered_map<Key_t, Entry, std::hash<AlignedBuffer<Key_t::SIZE>>>;
+      using SourceBytes = std::unordered_map<Key_t, size_t, std::hash<AlignedBuffer<Key_t::SIZE>>>;
+
+      /// roughly how much memory introset takes up stored here
+      static size_t
+      Footprint(const service::EncryptedIntroSet& introset);
+
+      void
+      Erase(Entries::iterator itr);
+
+      const size_t m_MaxBytes;
+      size_t m_Bytes = 0;
+      Entries m_Entries;
+      /// what each source's introsets take up, for the sources we hold any from
+      SourceBytes m_SourceBytes;
+      /// most recently used first
+      std::list<Key_t> m_LRU;
+      /// by when they expire
+      std::multimap<llarp_time_t, Key_t> m_Expiry;
+      uint64_t m_Hits = 0;
+      uint64_t m_Misses = 0;
+      uint64_t m_Evictions = 0;
+      uint64_t m_Expired = 0;
+      uint64_t m_Refused = 0;
+      /// last, so that it goes before what it sheds
+      const util::MemAccount::ShedderHandle m_Shedder;
+    };
+  }  // namespace dht
+}  // namespace llarp
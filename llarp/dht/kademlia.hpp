@@ -17,13 +17,13 @@ namespace llarp
       bool
       operator()(const Key_t& left, const Key_t& right) const
       {
-        return (us ^ left) < (us ^ right);
+        return us.XorCloser(left, right);
       }
 
       bool
       operator()(const RouterContact& left, const RouterContact& right) const
       {
-        return (left.pubkey ^ us) < (right.pubkey ^ us);
+        return us.XorCloser(left.pubkey, right.pubkey);
       }
     };
   }  // namespace dht
@@ -44,33 +44,7 @@ namespace llarp
       Key_t
       operator^(const Key_t& other) const
       {
-        Key_t dist;
-        std::transform(begin(), end(), other.begin(), dist.begin(), std::bit_xor<byte_t>());
-        return dist;
-      }
-
-      bool
-      operator==(const Key_t& other) const
-      {
-        return as_array() == other.as_array();
-      }
-
-      bool
-      operator!=(const Key_t& other) const
-      {
-        return as_array() != other.as_array();
-      }
-
-      bool
-      operator<(const Key_t& other) const
-      {
-        return as_array() < other.as_array();
-      }
-
-      bool
-      operator>(const Key_t& other) const
-      {
-        return as_array() > other.as_array();
+        return Key_t{AlignedBuffer<SIZE>::operator^(other)};
       }
     };
   }  // namespace dht
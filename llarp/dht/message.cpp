@@ -1,8 +1,10 @@
 #include "context.hpp"
 
 #include <memory>
+#include <llarp/util/arena.hpp>
 #include <llarp/util/bencode.hpp>
 #include <llarp/dht/messages/findintro.hpp>
+#include <llarp/dht/messages/findrcs.hpp>
 #include <llarp/dht/messages/findrouter.hpp>
 #include <llarp/dht/messages/gotintro.hpp>
 #include <llarp/dht/messages/gotrouter.hpp>
@@ -14,6 +16,32 @@ namespace llarp
 {
   namespace dht
   {
+    void
+    MessageDeleter::operator()(IMessage* msg) const
+    {
+      if (inArena)
+        msg->~IMessage();
+      else
+        delete msg;
+    }
+
+    namespace
+    {
+      /// in the thread's arena while a parser has a scope open around what it decodes, else on
+      /// the heap for whoever decodes outside of one
+      template <typename Msg_t, typename... Args>
+      IMessage::Ptr_t
+      MakeMessage(Args&&... args)
+      {
+        auto& arena = util::Arena::ForThread();
+        if (not arena.InScope())
+          return IMessage::Ptr_t{new Msg_t(std::forward<Args>(args)...)};
+        MessageDeleter deleter;
+        deleter.inArena = true;
+        return IMessage::Ptr_t{arena.Make<Msg_t>(std::forward<Args>(args)...), deleter};
+      }
+    }  // namespace
+
     struct MessageDecoder
     {
       const Key_t& From;
@@ -46,35 +74,41 @@ namespace llarp
           switch (*strbuf.base)
           {
             case 'N':
-              msg = std::make_unique<FindNameMessage>(From, Key_t{}, 0);
+              msg = MakeMessage<FindNameMessage>(From, Key_t{}, 0);
               break;
             case 'M':
-              msg = std::make_unique<GotNameMessage>(From, 0, service::EncryptedName{});
+              msg = MakeMessage<GotNameMessage>(From, 0, service::EncryptedName{});
               break;
             case 'F':
-              msg = std::make_unique<FindIntroMessage>(From, relayed, 0);
+              msg = MakeMessage<FindIntroMessage>(From, relayed, 0);
               break;
             case 'R':
               if (relayed)
-                msg = std::make_unique<RelayedFindRouterMessage>(From);
+                msg = MakeMessage<RelayedFindRouterMessage>(From);
               else
-                msg = std::make_unique<FindRouterMessage>(From);
+                msg = MakeMessage<FindRouterMessage>(From);
               break;
             case 'S':
-              msg = std::make_unique<GotRouterMessage>(From, relayed);
+              msg = MakeMessage<GotRouterMessage>(From, relayed);
+              break;
+            case 'B':
+              // only ever between relays and their direct peers
+              if (relayed)
+                return false;
+              msg = MakeMessage<FindRCsMessage>(From);
               break;
             case 'I':
-              msg = std::make_unique<PublishIntroMessage>(From, relayed);
+              msg = MakeMessage<PublishIntroMessage>(From, relayed);
               break;
             case 'G':
               if (relayed)
               {
-                msg = std::make_unique<RelayedGotIntroMessage>();
+                msg = MakeMessage<RelayedGotIntroMessage>();
                 break;
               }
               else
               {
-                msg = std::make_unique<GotIntroMessage>(From);
+                msg = MakeMessage<GotIntroMessage>(From);
                 break;
               }
             default:
@@ -5,6 +5,7 @@
 #include <llarp/path/path_types.hpp>
 #include <llarp/util/bencode.hpp>
 
+#include <memory>
 #include <vector>
 
 namespace llarp
@@ -13,6 +14,25 @@ namespace llarp
   {
     constexpr size_t MAX_MSG_SIZE = 2048;
 
+    struct IMessage;
+
+    /// deletes a message from the heap, or only destroys it if it was made in the thread's
+    /// util::Arena while decoding; converts from std::default_delete so that replies made with
+    /// new or std::make_unique go in the same vectors as decoded messages
+    struct MessageDeleter
+    {
+      bool inArena = false;
+
+      MessageDeleter() = default;
+
+      template <typename T>
+      MessageDeleter(std::default_delete<T>)
+      {}
+
+      void
+      operator()(IMessage* msg) const;
+    };
+
     struct IMessage
     {
       virtual ~IMessage() = default;
@@ -21,7 +41,7 @@ namespace llarp
       IMessage(const Key_t& from) : From(from)
       {}
 
-      using Ptr_t = std::unique_ptr<IMessage>;
+      using Ptr_t = std::unique_ptr<IMessage, MessageDeleter>;
 
       virtual bool
       HandleMessage(struct llarp_dht_context* dht, std::vector<Ptr_t>& replies) const = 0;
@@ -0,0 +1,124 @@
+#include "findrcs.hpp"
+
+#include <llarp/dht/context.hpp>
+#include "gotrouter.hpp"
+#include <llarp/nodedb.hpp>
+#include <llarp/router/abstractrouter.hpp>
+
+#include <algorithm>
+
+namespace llarp
+{
+  namespace dht
+  {
+    FindRCsMessage::~FindRCsMessage() = default;
+
+    bool
+    FindRCsMessage::BEncode(llarp_buffer_t* buf) const
+    {
+      if (not bencode_start_dict(buf))
+        return false;
+
+      // message type
+      if (not BEncodeWriteDictMsgType(buf, "A", "B"))
+        return false;
+
+      if (not routers.empty())
+      {
+        if (not BEncodeWriteDictList("K", routers, buf))
+          return false;
+      }
+
+      // txid
+      if (not BEncodeWriteDictInt("T", txid, buf))
+        return false;
+
+      // updated after
+      if (not BEncodeWriteDictInt("U", since.count(), buf))
+        return false;
+
+      // version
+      if (not BEncodeWriteDictInt("V", llarp::constants::proto_version, buf))
+        return false;
+
+      return bencode_end(buf);
+    }
+
+    bool
+    FindRCsMessage::DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* val)
+    {
+      bool read = false;
+
+      if (not BEncodeMaybeReadDictList("K", routers, read, key, val))
+        return false;
+
+      if (not BEncodeMaybeReadDictInt("T", txid, read, key, val))
+        return false;
+
+      if (not BEncodeMaybeReadDictInt("U", since, read, key, val))
+        return false;
+
+      if (not BEncodeMaybeVerifyVersion(
+              "V", version, llarp::constants::proto_version, read, key, val))
+        return false;
+
+      return read;
+    }
+
+    bool
+    FindRCsMessage::HandleMessage(
+        llarp_dht_context* ctx, [[maybe_unused]] std::vector<IMessage::Ptr_t>& replies)
+        const
+    {
+      auto& dht = *ctx->impl;
+      if (not dht.AllowTransit())
+      {
+        LogWarn("Got bulk RC request from ", From, " when we are not allowing dht transit");
+        return false;
+      }
+      if (routers.size() > MaxRCs)
+      {
+        LogWarn("Bulk RC request from ", From, " for ", routers.size(), " routers, too many");
+        return false;
+      }
+
+      const RouterID requester{From.as_array()};
+      auto nodedb = dht.GetRouter()->nodedb();
+      std::vector<RouterContact> found;
+      if (routers.empty())
+      {
+        const auto now = dht.Now();
+        if (not dht.bulkRCRequesters().Insert(requester, now))
+        {
+          LogWarn("Bulk RC request from ", From, " too soon after its last one, dropping");
+          return false;
+        }
+        // no further back than a fresh requester asks, so no one can take the whole nodedb
+        const auto after = std::max<llarp_time_t>(since, now - RouterContact::UpdateInterval);
+        nodedb->VisitUpdatedSince([&](const RouterContact& rc) { found.push_back(rc); }, after);
+        // the newest first, should there be more than we send
+        if (found.size() > MaxRCs)
+        {
+          std::nth_element(
+              found.begin(), found.begin() + MaxRCs, found.end(), [](const auto& a, const auto& b) {
+                return a.last_updated > b.last_updated;
+              });
+          found.resize(MaxRCs);
+        }
+      }
+      else
+      {
+        for (const auto& router : routers)
+        {
+          if (auto rc = nodedb->Get(router); rc and rc->last_updated > since)
+            found.push_back(std::move(*rc));
+        }
+      }
+
+      // more than fit in the one reply, so each run goes out as a message of its own
+      for (auto& rcs : SplitForLink(std::move(found)))
+        dht.DHTSendTo(requester, new GotRouterMessage(dht.OurKey(), txid, rcs, false));
+      return true;
+    }
+  }  // namespace dht
+}  // namespace llarp
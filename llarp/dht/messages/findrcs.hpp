@@ -0,0 +1,49 @@
+#pragma once
+#include <llarp/dht/message.hpp>
+#include <llarp/router_id.hpp>
+#include <llarp/util/time.hpp>
+
+#include <vector>
+
+namespace llarp
+{
+  namespace dht
+  {
+    /// ask a peer for many rcs at once: the ones it has that were updated after since, either of
+    /// the given routers or, with none given, of every router it knows, though then no further
+    /// back than RouterContact::UpdateInterval and only once each BulkInterval for each peer.  it
+    /// answers with as many GotRouterMessages under our txid as it takes, which we store like any
+    /// other rc we get.
+    struct FindRCsMessage final : public IMessage
+    {
+      /// the most rcs we send back for one request
+      static constexpr size_t MaxRCs = 256;
+      /// how often one peer may have every rc updated since some time; we ask every 5 minutes.
+      /// that answer is a few hundred times the size of the request, so no more than this.
+      static constexpr auto BulkInterval = 1min;
+
+      // inbound parsing
+      FindRCsMessage(const Key_t& from) : IMessage(from)
+      {}
+
+      FindRCsMessage(uint64_t id, std::vector<RouterID> want, llarp_time_t updatedAfter)
+          : IMessage({}), routers(std::move(want)), since(updatedAfter), txid(id)
+      {}
+
+      ~FindRCsMessage() override;
+
+      bool
+      BEncode(llarp_buffer_t* buf) const override;
+
+      bool
+      DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* val) override;
+
+      bool
+      HandleMessage(llarp_dht_context* ctx, std::vector<IMessage::Ptr_t>& replies) const override;
+
+      std::vector<RouterID> routers;
+      llarp_time_t since = 0s;
+      uint64_t txid = 0;
+    };
+  }  // namespace dht
+}  // namespace llarp
@@ -15,7 +15,7 @@ namespace llarp
   {
     bool
     RelayedFindRouterMessage::HandleMessage(
-        llarp_dht_context* ctx, std::vector<std::unique_ptr<IMessage>>& replies) const
+        llarp_dht_context* ctx, std::vector<IMessage::Ptr_t>& replies) const
     {
       auto& dht = *ctx->impl;
       /// lookup for us, send an immeidate reply
@@ -40,11 +40,24 @@ namespace llarp
         replies.emplace_back(new GotRouterMessage(k, txid, {}, false));
         return true;
       }
+      auto& answers = dht.rcAnswers();
+      if (auto answer = answers.Get(targetKey, dht.Now()))
+      {
+        auto* reply = new GotRouterMessage(k, txid, {}, false);
+        reply->encodedRCs = std::move(answer);
+        replies.emplace_back(reply);
+        return true;
+      }
       // check netdb
       const auto rc = dht.GetRouter()->nodedb()->FindClosestTo(k);
       if (rc.pubkey == targetKey)
       {
-        replies.emplace_back(new GotRouterMessage(k, txid, {rc}, false));
+        auto* reply = new GotRouterMessage(k, txid, {}, false);
+        if (not rc.ExpiresSoon(dht.Now()))
+          reply->encodedRCs = answers.Put(rc, dht.Now());
+        if (not reply->encodedRCs)
+          reply->foundRCs.push_back(rc);
+        replies.emplace_back(reply);
         return true;
       }
       peer = Key_t(rc.pubkey);
@@ -147,7 +160,7 @@ namespace llarp
 
     bool
     FindRouterMessage::HandleMessage(
-        llarp_dht_context* ctx, std::vector<std::unique_ptr<IMessage>>& replies) const
+        llarp_dht_context* ctx, std::vector<IMessage::Ptr_t>& replies) const
     {
       auto& dht = *ctx->impl;
 
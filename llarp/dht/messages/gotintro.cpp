@@ -19,7 +19,7 @@ namespace llarp
 
     bool
     GotIntroMessage::HandleMessage(
-        llarp_dht_context* ctx, std::vector<std::unique_ptr<IMessage>>& /*replies*/) const
+        llarp_dht_context* ctx, std::vector<IMessage::Ptr_t>& /*replies*/) const
     {
       auto& dht = *ctx->impl;
       auto* router = dht.GetRouter();
@@ -62,8 +62,7 @@ namespace llarp
 
     bool
     RelayedGotIntroMessage::HandleMessage(
-        llarp_dht_context* ctx,
-        [[maybe_unused]] std::vector<std::unique_ptr<IMessage>>& replies) const
+        llarp_dht_context* ctx, [[maybe_unused]] std::vector<IMessage::Ptr_t>& replies) const
     {
       // TODO: implement me better?
       auto pathset = ctx->impl->GetRouter()->pathContext().GetLocalPathSet(pathID);
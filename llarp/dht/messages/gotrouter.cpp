@@ -1,7 +1,9 @@
 #include <llarp/dht/context.hpp>
 #include "gotrouter.hpp"
 
+#include <array>
 #include <memory>
+#include <llarp/constants/link_layer.hpp>
 #include <llarp/path/path_context.hpp>
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/router/i_rc_lookup_handler.hpp>
@@ -13,6 +15,32 @@ namespace llarp
   {
     GotRouterMessage::~GotRouterMessage() = default;
 
+    std::vector<std::vector<RouterContact>>
+    SplitForLink(std::vector<RouterContact> rcs)
+    {
+      // what the GotRouterMessage and the DHTImmediateMessage around it take besides the rcs
+      static constexpr size_t Overhead = 128;
+      static constexpr size_t Budget = MAX_LINK_MSG_SIZE / 2 - Overhead;
+      std::vector<std::vector<RouterContact>> runs;
+      size_t used = 0;
+      std::array<byte_t, MAX_RC_SIZE> tmp;
+      for (auto& rc : rcs)
+      {
+        llarp_buffer_t buf{tmp};
+        if (not rc.BEncode(&buf))
+          continue;
+        const size_t size = buf.cur - buf.base;
+        if (runs.empty() or used + size > Budget)
+        {
+          runs.emplace_back();
+          used = 0;
+        }
+        runs.back().push_back(std::move(rc));
+        used += size;
+      }
+      return runs;
+    }
+
     bool
     GotRouterMessage::BEncode(llarp_buffer_t* buf) const
     {
@@ -36,7 +64,13 @@ namespace llarp
           return false;
       }
 
-      if (not BEncodeWriteDictList("R", foundRCs, buf))
+      if (encodedRCs)
+      {
+        if (not(bencode_write_bytestring(buf, "R", 1)
+                and buf->write(encodedRCs->begin(), encodedRCs->end())))
+          return false;
+      }
+      else if (not BEncodeWriteDictList("R", foundRCs, buf))
         return false;
 
       // txid
@@ -81,8 +115,7 @@ namespace llarp
 
     bool
     GotRouterMessage::HandleMessage(
-        llarp_dht_context* ctx,
-        [[maybe_unused]] std::vector<std::unique_ptr<IMessage>>& replies) const
+        llarp_dht_context* ctx, [[maybe_unused]] std::vector<IMessage::Ptr_t>& replies) const
     {
       auto& dht = *ctx->impl;
       if (relayed)
@@ -118,10 +151,17 @@ namespace llarp
         return true;
       }
       // store if valid
-      for (const auto& rc : foundRCs)
+      const auto valid = dht.GetRouter()->rcLookupHandler().CheckRCs(foundRCs);
+      // gossip comes in batches, so one bad rc doesn't stop us taking the rest
+      bool allValid = true;
+      for (size_t idx = 0; idx < foundRCs.size(); ++idx)
       {
-        if (not dht.GetRouter()->rcLookupHandler().CheckRC(rc))
-          return false;
+        if (not valid[idx])
+        {
+          allValid = false;
+          continue;
+        }
+        const auto& rc = foundRCs[idx];
         if (txid == 0)  // txid == 0 on gossip
         {
           auto* router = dht.GetRouter();
@@ -133,7 +173,7 @@ namespace llarp
             peerDb->handleGossipedRC(rc);
         }
       }
-      return true;
+      return allValid;
     }
   }  // namespace dht
 }  // namespace llarp
@@ -3,6 +3,8 @@
 #include <llarp/dht/message.hpp>
 #include <llarp/router_contact.hpp>
 #include <llarp/util/copy_or_nullptr.hpp>
+#include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -36,6 +38,7 @@ namespace llarp
       GotRouterMessage(const GotRouterMessage& other)
           : IMessage(other.From)
           , foundRCs(other.foundRCs)
+          , encodedRCs(other.encodedRCs)
           , nearKeys(other.nearKeys)
           , closerTarget(copy_or_nullptr(other.closerTarget))
           , txid(other.txid)
@@ -53,10 +56,12 @@ namespace llarp
       DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* val) override;
 
       bool
-      HandleMessage(
-          llarp_dht_context* ctx, std::vector<std::unique_ptr<IMessage>>& replies) const override;
+      HandleMessage(llarp_dht_context* ctx, std::vector<IMessage::Ptr_t>& replies) const override;
 
       std::vector<RouterContact> foundRCs;
+      /// if set, written as the R list in place of foundRCs; for answering with one from an
+      /// RCAnswerCache
+      std::shared_ptr<const std::string> encodedRCs;
       std::vector<RouterID> nearKeys;
       std::unique_ptr<Key_t> closerTarget;
       uint64_t txid = 0;
@@ -64,5 +69,9 @@ namespace llarp
     };
 
     using GotRouterMessage_constptr = std::shared_ptr<const GotRouterMessage>;
+
+    /// split rcs into runs that each fit in a GotRouterMessage sent over a link on its own
+    std::vector<std::vector<RouterContact>>
+    SplitForLink(std::vector<RouterContact> rcs);
   }  // namespace dht
 }  // namespace llarp
@@ -6,6 +6,7 @@
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/routing/dht_message.hpp>
 #include <llarp/nodedb.hpp>
+#include <llarp/util/metrics.hpp>
 
 #include <llarp/tooling/dht_event.hpp>
 
@@ -13,6 +14,13 @@ namespace llarp
 {
   namespace dht
   {
+    namespace
+    {
+      metrics::Counter pubsUnchanged{
+          "lokinet_dht_introset_republishes_total",
+          "Introset publishes to us of one we store already, taken without checking it again"};
+    }  // namespace
+
     const uint64_t PublishIntroMessage::MaxPropagationDepth = 5;
     PublishIntroMessage::~PublishIntroMessage() = default;
 
@@ -54,7 +62,7 @@ namespace llarp
 
     bool
     PublishIntroMessage::HandleMessage(
-        llarp_dht_context* ctx, std::vector<std::unique_ptr<IMessage>>& replies) const
+        llarp_dht_context* ctx, std::vector<IMessage::Ptr_t>& replies) const
     {
       const auto now = ctx->impl->Now();
       const llarp::dht::Key_t addr{introset.derivedSigningKey.data()};
@@ -68,7 +76,12 @@ namespace llarp
           relayOrder);
 
       auto& dht = *ctx->impl;
-      if (!introset.Verify(now))
+      // services republish unchanged introsets often, and we checked the one we store already;
+      // but not that it is still current, as it may be waiting on the store to decay it
+      const bool known = dht.services()->Holds(introset);
+      if (known)
+        pubsUnchanged.Inc();
+      if (introset.IsExpired(now) or (not known and not introset.Verify(now)))
       {
         llarp::LogWarn("Received PublishIntroMessage with invalid introset: ", introset);
         // don't propogate or store
@@ -96,6 +109,14 @@ namespace llarp
 
       const auto& us = dht.OurKey();
 
+      // whom the store holds it against: the path it came in on if relayed, else the peer
+      Key_t source{From};
+      if (relayed)
+      {
+        source.Zero();
+        std::copy(pathID.begin(), pathID.end(), source.begin());
+      }
+
       // function to identify the closest 4 routers we know of for this introset
       auto propagateIfNotUs = [&](size_t index) {
         assert(index < IntroSetStorageRedundancy);
@@ -107,7 +128,7 @@ namespace llarp
         {
           llarp::LogInfo("we are peer ", index, " so storing instead of propagating");
 
-          dht.services()->PutNode(introset);
+          dht.services()->Put(introset, source);
           replies.emplace_back(new GotIntroMessage({introset}, txID));
         }
         else
@@ -160,7 +181,7 @@ namespace llarp
               txID,
               " and we are candidate ",
               candidateNumber);
-          dht.services()->PutNode(introset);
+          dht.services()->Put(introset, source);
           replies.emplace_back(new GotIntroMessage({introset}, txID));
         }
         else
@@ -0,0 +1,56 @@
+#include "rc_answer_cache.hpp"
+
+#include <llarp/util/bencode.h>
+
+#include <algorithm>
+#include <array>
+
+namespace llarp
+{
+  namespace dht
+  {
+    std::shared_ptr<const std::string>
+    RCAnswerCache::Get(const RouterID& router, llarp_time_t now) const
+    {
+      if (auto itr = m_Answers.find(router); itr != m_Answers.end() and now < itr->second.until)
+        return itr->second.encoded;
+      return nullptr;
+    }
+
+    std::shared_ptr<const std::string>
+    RCAnswerCache::Put(const RouterContact& rc, llarp_time_t now)
+    {
+      std::array<byte_t, MAX_RC_SIZE + 2> tmp;
+      llarp_buffer_t buf{tmp};
+      if (not(bencode_start_list(&buf) and rc.BEncode(&buf) and bencode_end(&buf)))
+        return nullptr;
+      auto encoded = std::make_shared<const std::string>(
+          reinterpret_cast<const char*>(tmp.data()), buf.cur - buf.base);
+      if (m_Answers.size() >= MaxAnswers)
+        m_Answers.clear();
+      // a relay asks the router itself for an rc that expires soon rather than give it out
+      const auto fresh = rc.TimeUntilExpires(now);
+      const auto until = now + std::min<llarp_time_t>(TTL, fresh > 1min ? fresh - 1min : 0s);
+      m_Answers.insert_or_assign(RouterID{rc.pubkey}, Answer{encoded, until});
+      return encoded;
+    }
+
+    void
+    RCAnswerCache::Invalidate(const RouterID& router)
+    {
+      m_Answers.erase(router);
+    }
+
+    void
+    RCAnswerCache::Decay(llarp_time_t now)
+    {
+      for (auto itr = m_Answers.begin(); itr != m_Answers.end();)
+      {
+        if (itr->second.until <= now)
+          itr = m_Answers.erase(itr);
+        else
+          ++itr;
+      }
+    }
+  }  // namespace dht
+}  // namespace llarp
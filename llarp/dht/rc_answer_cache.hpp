@@ -0,0 +1,61 @@
+#pragma once
+
+#include <llarp/router_contact.hpp>
+#include <llarp/router_id.hpp>
+#include <llarp/util/time.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace llarp
+{
+  namespace dht
+  {
+    /// the rcs we lately answered lookups with as a relay, already encoded as the list a
+    /// GotRouterMessage carries, so that the lookups for popular routers (seeds, well known
+    /// exits) don't go to the nodedb and copy and encode the rc again every time.  the nodedb
+    /// drops a router's answer when its rc changes or goes; answers go on their own a short
+    /// while after we made them, and before the rc would be too close to expiring to give out.
+    class RCAnswerCache
+    {
+     public:
+      /// how long an answer is kept from when we made it
+      static constexpr auto TTL = 30s;
+      /// most answers we keep; past this we drop them all and start over, as the hot ones come
+      /// back soon enough
+      static constexpr size_t MaxAnswers = 1024;
+
+      /// the answer for router, or nullptr if we have none fresh
+      std::shared_ptr<const std::string>
+      Get(const RouterID& router, llarp_time_t now) const;
+
+      /// makes and keeps the answer with rc, returning it; nullptr if rc does not encode
+      std::shared_ptr<const std::string>
+      Put(const RouterContact& rc, llarp_time_t now);
+
+      /// forgets the answer for router, for when its rc changes
+      void
+      Invalidate(const RouterID& router);
+
+      /// forgets the answers that are past it
+      void
+      Decay(llarp_time_t now);
+
+      size_t
+      Size() const
+      {
+        return m_Answers.size();
+      }
+
+     private:
+      struct Answer
+      {
+        std::shared_ptr<const std::string> encoded;
+        llarp_time_t until;
+      };
+
+      std::unordered_map<RouterID, Answer> m_Answers;
+    };
+  }  // namespace dht
+}  // namespace llarp
@@ -46,11 +46,12 @@ namespace llarp
     {
       if (valuesFound.size())
       {
+        const auto valid = parent->GetRouter()->rcLookupHandler().CheckRCs(valuesFound);
         RouterContact found;
-        for (const auto& rc : valuesFound)
+        for (size_t idx = 0; idx < valuesFound.size(); ++idx)
         {
-          if (found.OtherIsNewer(rc) && parent->GetRouter()->rcLookupHandler().CheckRC(rc))
-            found = rc;
+          if (valid[idx] and found.OtherIsNewer(valuesFound[idx]))
+            found = valuesFound[idx];
         }
         valuesFound.clear();
         valuesFound.emplace_back(found);
@@ -0,0 +1,260 @@
+#include "cache.hpp"
+#include "wire.hpp"
+
+#include <oxenc/endian.h>
+
+#include <algorithm>
+#include <cctype>
+
+namespace llarp::dns
+{
+  namespace
+  {
+    constexpr uint16_t RR_SOA = 6;
+    constexpr uint16_t RR_OPT = 41;
+    constexpr uint8_t RCODE_NOERROR = 0;
+    constexpr uint8_t RCODE_NXDOMAIN = 3;
+
+    uint32_t
+    Seconds(llarp_time_t t)
+    {
+      return std::chrono::duration_cast<std::chrono::seconds>(t).count();
+    }
+
+    /// step pos past the name at pos in the sz bytes at buf, returning false if it runs off the
+    /// end; names that point elsewhere end at the pointer, so we never follow one
+    bool
+    SkipName(const byte_t* buf, size_t sz, size_t& pos)
+    {
+      while (pos < sz)
+      {
+        const byte_t len = buf[pos];
+        if ((len & 0xc0) == 0xc0)
+        {
+          pos += 2;
+          return pos <= sz;
+        }
+        if (len & 0xc0)
+          return false;
+        pos += 1 + len;
+        if (len == 0)
+          return true;
+      }
+      return false;
+    }
+
+    /// what we learn walking the records of a reply
+    struct Walked
+    {
+      std::vector<uint16_t> ttls;
+      std::optional<uint32_t> minTTL;
+      /// the least of the ttl and minimum of an soa in the authority section
+      std::optional<uint32_t> negativeTTL;
+    };
+
+    std::optional<Walked>
+    Walk(const byte_t* buf, size_t sz)
+    {
+      if (sz < MessageHeader::Size or sz > 0xffff)
+        return std::nullopt;
+      const auto qd = oxenc::load_big_to_host<uint16_t>(buf + 4);
+      const auto an = oxenc::load_big_to_host<uint16_t>(buf + 6);
+      const auto ns = oxenc::load_big_to_host<uint16_t>(buf + 8);
+      const auto ar = oxenc::load_big_to_host<uint16_t>(buf + 10);
+      size_t pos = MessageHeader::Size;
+      for (size_t i = 0; i < qd; ++i)
+      {
+        if (not SkipName(buf, sz, pos) or pos + 4 > sz)
+          return std::nullopt;
+        pos += 4;
+      }
+      Walked walked;
+      const size_t records = size_t{an} + ns + ar;
+      for (size_t i = 0; i < records; ++i)
+      {
+        if (not SkipName(buf, sz, pos) or pos + 10 > sz)
+          return std::nullopt;
+        const auto type = oxenc::load_big_to_host<uint16_t>(buf + pos);
+        const auto ttl = oxenc::load_big_to_host<uint32_t>(buf + pos + 4);
+        const auto rdlen = oxenc::load_big_to_host<uint16_t>(buf + pos + 8);
+        if (pos + 10 + rdlen > sz)
+          return std::nullopt;
+        // the ttl of the edns pseudo record holds flags
+        if (type != RR_OPT)
+        {
+          walked.ttls.push_back(pos + 4);
+          walked.minTTL = std::min(walked.minTTL.value_or(ttl), ttl);
+        }
+        // the soa's minimum is the last thing in it
+        if (type == RR_SOA and i >= an and i < size_t{an} + ns and rdlen >= 22)
+        {
+          const auto minimum = oxenc::load_big_to_host<uint32_t>(buf + pos + 10 + rdlen - 4);
+          walked.negativeTTL = std::min(ttl, minimum);
+        }
+        pos += 10 + rdlen;
+      }
+      return walked;
+    }
+  }  // namespace
+
+  AnswerCache::AnswerCache(Config conf)
+      : m_Conf{conf}
+      , m_Shedder{util::MemAccount::AddShedder(
+            util::MemTag::DNS, [this](size_t over) { Shed(over); })}
+  {}
+
+  AnswerCache::~AnswerCache()
+  {
+    util::MemAccount::Freed(util::MemTag::DNS, m_Bytes);
+  }
+
+  std::optional<std::string>
+  AnswerCache::Key(const Message& query)
+  {
+    if (query.questions.size() != 1)
+      return std::nullopt;
+    const auto& q = query.questions[0];
+    std::string key = q.qname;
+    std::transform(key.begin(), key.end(), key.begin(), [](unsigned char ch) {
+      return std::tolower(ch);
+    });
+    key += '/';
+    key += std::to_string(q.qtype);
+    key += '/';
+    key += std::to_string(q.qclass);
+    return key;
+  }
+
+  size_t
+  AnswerCache::Cost(const std::string& key, const Entry& entry)
+  {
+    // the key is in the map and the list both, and each has its nodes
+    return entry.wire.size() + sizeof(uint16_t) * entry.ttls.size() + 2 * key.size()
+        + sizeof(Entry) + 64;
+  }
+
+  template <typename TTL_Func>
+  OwnedBuffer
+  AnswerCache::Answer(const Entry& entry, const Message& query, TTL_Func&& ttl)
+  {
+    OwnedBuffer buf{entry.wire.data(), entry.wire.size()};
+    ReplyAs(query, buf.buf.get(), buf.sz);
+    for (const auto at : entry.ttls)
+    {
+      const auto orig = oxenc::load_big_to_host<uint32_t>(buf.buf.get() + at);
+      oxenc::write_host_as_big<uint32_t>(ttl(orig), buf.buf.get() + at);
+    }
+    return buf;
+  }
+
+  void
+  AnswerCache::Erase(std::unordered_map<std::string, Entry>::iterator itr)
+  {
+    const auto cost = Cost(itr->first, itr->second);
+    m_Bytes -= cost;
+    util::MemAccount::Freed(util::MemTag::DNS, cost);
+    m_LRU.erase(itr->second.lru);
+    m_Entries.erase(itr);
+  }
+
+  void
+  AnswerCache::Shed(size_t bytes)
+  {
+    const auto target = m_Bytes > bytes ? m_Bytes - bytes : 0;
+    while (m_Bytes > target and not m_LRU.empty())
+      Erase(m_Entries.find(m_LRU.back()));
+  }
+
+  std::optional<OwnedBuffer>
+  AnswerCache::Get(const Message& query, llarp_time_t now)
+  {
+    const auto key = Key(query);
+    if (not key)
+      return std::nullopt;
+    auto itr = m_Entries.find(*key);
+    if (itr == m_Entries.end())
+      return std::nullopt;
+    auto& entry = itr->second;
+    if (now >= entry.expiresAt)
+    {
+      if (now >= entry.expiresAt + m_Conf.maxStale)
+        Erase(itr);
+      return std::nullopt;
+    }
+    m_LRU.splice(m_LRU.begin(), m_LRU, entry.lru);
+    // no record lives longer than we keep the answer, and they all count down from when we got it
+    const auto elapsed = Seconds(now - entry.storedAt);
+    const auto lifetime = Seconds(entry.expiresAt - entry.storedAt);
+    return Answer(entry, query, [elapsed, lifetime](uint32_t ttl) {
+      ttl = std::min(ttl, lifetime);
+      return ttl > elapsed ? ttl - elapsed : 0;
+    });
+  }
+
+  std::optional<OwnedBuffer>
+  AnswerCache::GetStale(const Message& query, llarp_time_t now)
+  {
+    const auto key = Key(query);
+    if (not key)
+      return std::nullopt;
+    auto itr = m_Entries.find(*key);
+    if (itr == m_Entries.end())
+      return std::nullopt;
+    if (now >= itr->second.expiresAt + m_Conf.maxStale)
+    {
+      Erase(itr);
+      return std::nullopt;
+    }
+    return Answer(itr->second, query, [](uint32_t ttl) { return std::min(ttl, StaleTTL); });
+  }
+
+  void
+  AnswerCache::Put(const Message& query, const byte_t* reply, size_t sz, llarp_time_t now)
+  {
+    if (m_Conf.maxBytes == 0)
+      return;
+    const auto key = Key(query);
+    if (not key or sz < MessageHeader::Size)
+      return;
+    // a truncated answer is no answer
+    if (reply[2] & 0x02)
+      return;
+    const uint8_t rcode = reply[3] & 0x0f;
+    if (rcode != RCODE_NOERROR and rcode != RCODE_NXDOMAIN)
+      return;
+    auto walked = Walk(reply, sz);
+    if (not walked)
+      return;
+
+    llarp_time_t ttl;
+    // no answers at all is as much a denial as no such name
+    if (rcode == RCODE_NXDOMAIN or oxenc::load_big_to_host<uint16_t>(reply + 6) == 0)
+    {
+      if (not walked->negativeTTL)
+        return;
+      ttl = std::min<llarp_time_t>(
+          std::chrono::seconds{*walked->negativeTTL}, m_Conf.maxNegativeTTL);
+    }
+    else
+      ttl = std::min<llarp_time_t>(
+          std::chrono::seconds{walked->minTTL.value_or(0)}, m_Conf.maxTTL);
+    if (ttl < 1s)
+      return;
+
+    if (auto itr = m_Entries.find(*key); itr != m_Entries.end())
+      Erase(itr);
+    m_LRU.push_front(*key);
+    auto& entry = m_Entries[*key];
+    entry.wire.assign(reply, reply + sz);
+    entry.ttls = std::move(walked->ttls);
+    entry.storedAt = now;
+    entry.expiresAt = now + ttl;
+    entry.lru = m_LRU.begin();
+    const auto cost = Cost(*key, entry);
+    m_Bytes += cost;
+    util::MemAccount::Allocated(util::MemTag::DNS, cost);
+
+    while (m_Bytes > m_Conf.maxBytes and not m_LRU.empty())
+      Erase(m_Entries.find(m_LRU.back()));
+  }
+}  // namespace llarp::dns
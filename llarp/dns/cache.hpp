@@ -0,0 +1,121 @@
+#pragma once
+
+#include "message.hpp"
+#include <llarp/util/buffer.hpp>
+#include <llarp/util/mem_account.hpp>
+#include <llarp/util/time.hpp>
+
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp::dns
+{
+  /// upstream answers kept in the wire format they came in, by question.  answers are kept for
+  /// as long as the shortest ttl in them, denials for as long as the soa they come with says
+  /// (rfc 2308), and once expired are kept around a while longer to answer with when upstream
+  /// fails (rfc 8767).  answering from the cache only writes the query's id and spelling of the
+  /// name, and counted down ttls, over a copy of what upstream sent.  holds up to a set number of
+  /// bytes, dropping the least recently used answers past that.
+  class AnswerCache
+  {
+   public:
+    struct Config
+    {
+      /// bytes of answers we hold at most; 0 caches nothing
+      size_t maxBytes = 1024 * 1024;
+      /// the longest we keep an answer for, whatever its ttl
+      llarp_time_t maxTTL = 24h;
+      /// the longest we keep a denial for
+      llarp_time_t maxNegativeTTL = 15min;
+      /// how long past expiry we may still answer with an entry when upstream fails; 0 for
+      /// never
+      llarp_time_t maxStale = 24h;
+    };
+
+    /// the ttl we give stale answers, as rfc 8767 suggests
+    static constexpr uint32_t StaleTTL = 30;
+
+    explicit AnswerCache(Config conf);
+
+    AnswerCache() : AnswerCache{Config{}}
+    {}
+
+    ~AnswerCache();
+
+    AnswerCache(const AnswerCache&) = delete;
+    AnswerCache&
+    operator=(const AnswerCache&) = delete;
+
+    /// an answer to query from the cache that hasn't expired, if we have one
+    std::optional<OwnedBuffer>
+    Get(const Message& query, llarp_time_t now);
+
+    /// an answer to query from the cache that has expired, but not by more than maxStale, if we
+    /// have one
+    std::optional<OwnedBuffer>
+    GetStale(const Message& query, llarp_time_t now);
+
+    /// remember the sz bytes at reply that upstream answered query with, if we can
+    void
+    Put(const Message& query, const byte_t* reply, size_t sz, llarp_time_t now);
+
+    /// the key we keep answers to query under, if it asks one question; queries with the same key
+    /// ask the same thing, whatever the case of their names
+    static std::optional<std::string>
+    Key(const Message& query);
+
+    /// drop the least recently used answers until we hold bytes less, or nothing; what we do
+    /// when the dns tag is over its soft limit
+    void
+    Shed(size_t bytes);
+
+    /// how many answers we hold
+    size_t
+    Size() const
+    {
+      return m_Entries.size();
+    }
+
+    /// how many bytes of memory we count our answers as taking
+    size_t
+    Bytes() const
+    {
+      return m_Bytes;
+    }
+
+   private:
+    struct Entry
+    {
+      std::vector<byte_t> wire;
+      /// where the ttl of each record but the edns pseudo record is in wire
+      std::vector<uint16_t> ttls;
+      llarp_time_t storedAt;
+      llarp_time_t expiresAt;
+      std::list<std::string>::iterator lru;
+    };
+
+    /// wire with the id of query and each ttl set by ttl, which is given a record's ttl from
+    /// upstream
+    template <typename TTL_Func>
+    static OwnedBuffer
+    Answer(const Entry& entry, const Message& query, TTL_Func&& ttl);
+
+    /// how many bytes we count entry as taking
+    static size_t
+    Cost(const std::string& key, const Entry& entry);
+
+    void
+    Erase(std::unordered_map<std::string, Entry>::iterator itr);
+
+    Config m_Conf;
+    std::unordered_map<std::string, Entry> m_Entries;
+    /// keys, most recently used first
+    std::list<std::string> m_LRU;
+    size_t m_Bytes = 0;
+    /// last, so that it goes before what it sheds
+    const util::MemAccount::ShedderHandle m_Shedder;
+  };
+}  // namespace llarp::dns
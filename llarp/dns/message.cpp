@@ -3,6 +3,7 @@
 
 #include "dns.hpp"
 #include "srv_data.hpp"
+#include "wire.hpp"
 #include <llarp/util/buffer.hpp>
 #include <llarp/util/logging.hpp>
 #include <llarp/net/ip.hpp>
@@ -153,11 +154,23 @@ namespace llarp
     OwnedBuffer
     Message::ToBuffer() const
     {
+      // same as Encode, but with names compressed
       std::array<byte_t, 1500> tmp;
-      llarp_buffer_t buf{tmp};
-      if (not Encode(&buf))
+      MessageWriter writer{tmp.data(), tmp.size()};
+      writer.Header(hdr_id, hdr_fields);
+      for (const auto& question : questions)
+        writer.Question(question.qname, question.qtype, question.qclass);
+      for (const auto& answer : answers)
+        writer.Answer(
+            answer.rr_name,
+            answer.rr_type,
+            answer.rr_class,
+            answer.ttl,
+            answer.rData.data(),
+            answer.rData.size());
+      if (not writer.Ok())
         throw std::runtime_error("cannot encode dns message");
-      return OwnedBuffer::copy_used(buf);
+      return OwnedBuffer{tmp.data(), writer.Size()};
     }
 
     void
@@ -424,6 +437,11 @@ namespace llarp
       MessageHeader hdr{};
       if (not hdr.Decode(&buf))
         return std::nullopt;
+      // a question takes at least 5 bytes and a record 11, so don't make room for more than
+      // could be there
+      if (size_t{hdr.qd_count} * 5 + (size_t{hdr.an_count} + hdr.ns_count + hdr.ar_count) * 11
+          > buf.size_left())
+        return std::nullopt;
 
       Message msg{hdr};
       if (not msg.Decode(&buf))
@@ -1,4 +1,6 @@
 #include "server.hpp"
+#include "cache.hpp"
+#include "wire.hpp"
 #include <llarp/constants/platform.hpp>
 #include <llarp/constants/apple.hpp>
 #include "dns.hpp"
@@ -6,8 +8,11 @@
 #include <llarp/crypto/crypto.hpp>
 #include <array>
 #include <stdexcept>
+#include <unordered_map>
 #include <utility>
 #include <llarp/ev/udp_handle.hpp>
+#include <llarp/util/metrics.hpp>
+#include <llarp/util/time.hpp>
 #include <optional>
 #include <memory>
 #include <unbound.h>
@@ -21,6 +26,21 @@ namespace llarp::dns
 {
   static auto logcat = log::Cat("dns");
 
+  static metrics::Counter queries{"lokinet_dns_queries_total", "DNS queries we were sent"};
+  static metrics::Counter invalidQueries{
+      "lokinet_dns_invalid_queries_total", "DNS queries we could not parse"};
+  static metrics::Counter cacheHits{
+      "lokinet_dns_cache_hits_total", "DNS queries answered from the answer cache"};
+  static metrics::Counter staleAnswers{
+      "lokinet_dns_stale_answers_total", "Expired answers given when upstream dns failed"};
+  static metrics::Counter upstreamQueries{
+      "lokinet_dns_upstream_queries_total", "DNS queries we asked upstream"};
+  static metrics::Counter upstreamFailures{
+      "lokinet_dns_upstream_failures_total", "DNS queries upstream failed to answer"};
+  static metrics::Counter coalescedQueries{
+      "lokinet_dns_coalesced_queries_total",
+      "DNS queries answered by waiting on the same query upstream"};
+
   void
   QueryJob_Base::Cancel()
   {
@@ -107,26 +127,39 @@ namespace llarp::dns
       {}
       std::weak_ptr<Resolver> parent;
       int id{};
+      /// queries asking what we ask that came while we were waiting on upstream, which get the
+      /// reply we get
+      std::vector<std::shared_ptr<Query>> followers;
 
       void
       SendReply(llarp::OwnedBuffer replyBuf) override;
+
+      /// answer with a copy of reply, which the query we followed got.  on the main loop only.
+      void
+      SendCopyOf(const OwnedBuffer& reply);
     };
 
     /// Resolver_Base that uses libunbound
     class Resolver final : public Resolver_Base, public std::enable_shared_from_this<Resolver>
     {
-      ub_ctx* m_ctx = nullptr;
+      // the contexts we resolve with, each with its own worker so that they resolve in parallel;
+      // queries are spread over them by question, so each name has the cache of one
+      std::vector<ub_ctx*> m_Contexts;
       std::weak_ptr<EventLoop> m_Loop;
 #ifdef _WIN32
-      // windows is dumb so we do ub mainloop in a thread
-      std::thread runner;
+      // windows is dumb so we do ub mainloop in a thread, one per context
+      std::vector<std::thread> m_Runners;
       std::atomic<bool> running;
 #else
-      std::shared_ptr<uvw::PollHandle> m_Poller;
+      std::vector<std::shared_ptr<uvw::PollHandle>> m_Pollers;
 #endif
+      size_t m_NextContext = 0;
 
       std::optional<SockAddr> m_LocalAddr;
       std::unordered_set<std::shared_ptr<Query>> m_Pending;
+      /// the query we sent upstream for each question we are waiting on, by cache key, for
+      /// others asking the same to follow
+      std::unordered_map<std::string, std::shared_ptr<Query>> m_InFlight;
 
       struct ub_result_deleter
       {
@@ -175,14 +208,14 @@ namespace llarp::dns
       }
 
       void
-      AddUpstreamResolver(const SockAddr& dns)
+      AddUpstreamResolver(ub_ctx* ctx, const SockAddr& dns)
       {
         std::string str = dns.hostString();
 
         if (const auto port = dns.getPort(); port != 53)
           fmt::format_to(std::back_inserter(str), "@{}", port);
 
-        if (auto err = ub_ctx_set_fwd(m_ctx, str.c_str()))
+        if (auto err = ub_ctx_set_fwd(ctx, str.c_str()))
         {
           throw std::runtime_error{
               fmt::format("cannot use {} as upstream dns: {}", str, ub_strerror(err))};
@@ -190,7 +223,7 @@ namespace llarp::dns
       }
 
       bool
-      ConfigureAppleTrampoline(const SockAddr& dns)
+      ConfigureAppleTrampoline(ub_ctx* ctx, const SockAddr& dns)
       {
         // On Apple, when we turn on exit mode, we tear down and then reestablish the unbound
         // resolver: in exit mode, we set use upstream to a localhost trampoline that redirects
@@ -219,12 +252,12 @@ namespace llarp::dns
             // macOS is stupid: the default (0.0.0.0) fails with "send failed: Can't assign
             // requested address" when unbound tries to connect to the localhost address using a
             // source address of 0.0.0.0.  Yay apple.
-            SetOpt("outgoing-interface:", "127.0.0.1");
+            SetOpt(ctx, "outgoing-interface:", "127.0.0.1");
 
             // The trampoline expects just a single source port (and sends everything back to it).
-            SetOpt("outgoing-range:", "1");
-            SetOpt("outgoing-port-avoid:", "0-65535");
-            SetOpt("outgoing-port-permit:", "{}", apple::dns_trampoline_source_port);
+            SetOpt(ctx, "outgoing-range:", "1");
+            SetOpt(ctx, "outgoing-port-avoid:", "0-65535");
+            SetOpt(ctx, "outgoing-port-permit:", "{}", apple::dns_trampoline_source_port);
             return true;
           }
         }
@@ -232,15 +265,15 @@ namespace llarp::dns
       }
 
       void
-      ConfigureUpstream(const llarp::DnsConfig& conf)
+      ConfigureUpstream(ub_ctx* ctx, const llarp::DnsConfig& conf)
       {
         bool is_apple_tramp = false;
 
         // set up forward dns
         for (const auto& dns : conf.m_upstreamDNS)
         {
-          AddUpstreamResolver(dns);
-          is_apple_tramp = is_apple_tramp or ConfigureAppleTrampoline(dns);
+          AddUpstreamResolver(ctx, dns);
+          is_apple_tramp = is_apple_tramp or ConfigureAppleTrampoline(ctx, dns);
         }
 
         if (auto maybe_addr = conf.m_QueryBind; maybe_addr and not is_apple_tramp)
@@ -293,35 +326,89 @@ namespace llarp::dns
 
           log::info(logcat, "sending dns queries from {}:{}", host, addr.getPort());
           // set up query bind port if needed
-          SetOpt("outgoing-interface:", host);
-          SetOpt("outgoing-range:", "1");
-          SetOpt("outgoing-port-avoid:", "0-65535");
-          SetOpt("outgoing-port-permit:", "{}", addr.getPort());
+          SetOpt(ctx, "outgoing-interface:", host);
+          SetOpt(ctx, "outgoing-range:", "1");
+          SetOpt(ctx, "outgoing-port-avoid:", "0-65535");
+          SetOpt(ctx, "outgoing-port-permit:", "{}", addr.getPort());
         }
       }
 
-      void
-      SetOpt(const std::string& key, const std::string& val)
+      static void
+      SetOpt(ub_ctx* ctx, const std::string& key, const std::string& val)
       {
-        ub_ctx_set_option(m_ctx, key.c_str(), val.c_str());
+        ub_ctx_set_option(ctx, key.c_str(), val.c_str());
       }
 
       // Wrapper around the above that takes 3+ arguments: the 2nd arg gets formatted with the
       // remaining args, and the formatted string passed to the above as `val`.
       template <typename... FmtArgs, std::enable_if_t<sizeof...(FmtArgs), int> = 0>
-      void
-      SetOpt(const std::string& key, std::string_view format, FmtArgs&&... args)
+      static void
+      SetOpt(ub_ctx* ctx, const std::string& key, std::string_view format, FmtArgs&&... args)
       {
-        SetOpt(key, fmt::format(format, std::forward<FmtArgs>(args)...));
+        SetOpt(ctx, key, fmt::format(format, std::forward<FmtArgs>(args)...));
+      }
+
+      /// a context set up as conf says, resolving asynchronously
+      ub_ctx*
+      MakeContext(const llarp::DnsConfig& conf)
+      {
+        auto* ctx = ::ub_ctx_create();
+        // set libunbound settings
+
+        SetOpt(ctx, "do-tcp:", "no");
+
+        for (const auto& [k, v] : conf.m_ExtraOpts)
+          SetOpt(ctx, k, v);
+
+        // add host files
+        for (const auto& file : conf.m_hostfiles)
+        {
+          const auto str = file.u8string();
+          if (auto ret = ub_ctx_hosts(ctx, str.c_str()))
+          {
+            throw std::runtime_error{
+                fmt::format("Failed to add host file {}: {}", file, ub_strerror(ret))};
+          }
+        }
+
+        ConfigureUpstream(ctx, conf);
+
+        // set async
+        ub_ctx_async(ctx, 1);
+        return ctx;
+      }
+
+      /// the context to resolve query with
+      ub_ctx*
+      ContextFor(const std::optional<std::string>& key)
+      {
+        if (key)
+          return m_Contexts[std::hash<std::string>{}(*key) % m_Contexts.size()];
+        return m_Contexts[m_NextContext++ % m_Contexts.size()];
       }
 
       // Copy of the DNS config (a copy because on some platforms, like Apple, we change the applied
       // upstream DNS settings when turning on/off exit mode).
       llarp::DnsConfig m_conf;
 
+      // upstream answers, kept across resetting the resolver so we can still give them when the
+      // new upstream doesn't answer.  only touched from the main loop.
+      AnswerCache m_Cache;
+
+      static AnswerCache::Config
+      CacheConfig(const llarp::DnsConfig& conf)
+      {
+        AnswerCache::Config cache;
+        cache.maxBytes = conf.m_CacheSize;
+        cache.maxStale = conf.m_ServeStale;
+        return cache;
+      }
+
      public:
       explicit Resolver(const EventLoop_ptr& loop, llarp::DnsConfig conf)
-          : m_Loop{loop}, m_conf{std::move(conf)}
+          : m_Loop{loop}
+          , m_conf{std::move(conf)}
+          , m_Cache{CacheConfig(m_conf)}
       {
         Up(m_conf);
       }
@@ -349,58 +436,67 @@ namespace llarp::dns
         m_Pending.erase(query);
       }
 
+      /// stop having queries follow query, handing back those that did
+      std::vector<std::shared_ptr<Query>>
+      TakeFollowers(const std::shared_ptr<Query>& query)
+      {
+        if (auto key = AnswerCache::Key(query->Underlying()))
+        {
+          if (auto itr = m_InFlight.find(*key); itr != m_InFlight.end() and itr->second == query)
+            m_InFlight.erase(itr);
+        }
+        return std::exchange(query->followers, {});
+      }
+
       void
       Up(const llarp::DnsConfig& conf)
       {
-        if (m_ctx)
+        if (not m_Contexts.empty())
           throw std::logic_error{"Internal error: attempt to Up() dns server multiple times"};
 
-        m_ctx = ::ub_ctx_create();
-        // set libunbound settings
-
-        SetOpt("do-tcp:", "no");
-
-        for (const auto& [k, v] : conf.m_ExtraOpts)
-          SetOpt(k, v);
-
-        // add host files
-        for (const auto& file : conf.m_hostfiles)
+        size_t contexts = conf.m_UpstreamContexts;
+        // every context would want the one port to send from
+        if (contexts > 1 and (conf.m_QueryBind or platform::is_apple))
         {
-          const auto str = file.u8string();
-          if (auto ret = ub_ctx_hosts(m_ctx, str.c_str()))
-          {
-            throw std::runtime_error{
-                fmt::format("Failed to add host file {}: {}", file, ub_strerror(ret))};
-          }
+          log::warning(
+              logcat,
+              "using one upstream dns context rather than {}, as we send from one port",
+              contexts);
+          contexts = 1;
         }
+        for (size_t i = 0; i < contexts; ++i)
+          m_Contexts.push_back(MakeContext(conf));
 
-        ConfigureUpstream(conf);
-
-        // set async
-        ub_ctx_async(m_ctx, 1);
         // setup mainloop
 #ifdef _WIN32
         running = true;
-        runner = std::thread{[this]() {
-          while (running)
-          {
-            // poll and process callbacks it this thread
-            if (ub_poll(m_ctx))
+        for (auto* ctx : m_Contexts)
+        {
+          m_Runners.emplace_back([this, ctx]() {
+            while (running)
             {
-              ub_process(m_ctx);
+              // poll and process callbacks it this thread
+              if (ub_poll(ctx))
+              {
+                ub_process(ctx);
+              }
+              else  // nothing to do, sleep.
+                std::this_thread::sleep_for(10ms);
             }
-            else  // nothing to do, sleep.
-              std::this_thread::sleep_for(10ms);
-          }
-        }};
+          });
+        }
 #else
         if (auto loop = m_Loop.lock())
         {
           if (auto loop_ptr = loop->MaybeGetUVWLoop())
           {
-            m_Poller = loop_ptr->resource<uvw::PollHandle>(ub_fd(m_ctx));
-            m_Poller->on<uvw::PollEvent>([this](auto&, auto&) { ub_process(m_ctx); });
-            m_Poller->start(uvw::PollHandle::Event::READABLE);
+            for (auto* ctx : m_Contexts)
+            {
+              auto poller = loop_ptr->resource<uvw::PollHandle>(ub_fd(ctx));
+              poller->on<uvw::PollEvent>([ctx](auto&, auto&) { ub_process(ctx); });
+              poller->start(uvw::PollHandle::Event::READABLE);
+              m_Pollers.push_back(std::move(poller));
+            }
             return;
           }
         }
@@ -414,17 +510,21 @@ namespace llarp::dns
 #ifdef _WIN32
         if (running.exchange(false))
         {
-          log::debug(logcat, "shutting down win32 dns thread");
-          runner.join();
+          log::debug(logcat, "shutting down win32 dns threads");
+          for (auto& runner : m_Runners)
+            runner.join();
         }
+        m_Runners.clear();
 #else
-        if (m_Poller)
-          m_Poller->close();
+        for (const auto& poller : m_Pollers)
+          poller->close();
+        m_Pollers.clear();
 #endif
-        if (m_ctx)
+        if (not m_Contexts.empty())
         {
-          ::ub_ctx_delete(m_ctx);
-          m_ctx = nullptr;
+          for (auto* ctx : m_Contexts)
+            ::ub_ctx_delete(ctx);
+          m_Contexts.clear();
 
           // destroy any outstanding queries that unbound hasn't fired yet
           if (not m_Pending.empty())
@@ -465,6 +565,28 @@ namespace llarp::dns
           log::critical(logcat, "no mainloop?");
       }
 
+      /// the reply to give a query that upstream answered with reply: answers are remembered,
+      /// and when upstream failed we give what we remember instead if we still have it
+      OwnedBuffer
+      Remember(const Message& query, OwnedBuffer reply)
+      {
+        const auto now = time_now_ms();
+        // servfail
+        if (reply.sz >= MessageHeader::Size and (reply.buf[3] & 0x0f) == 2)
+        {
+          upstreamFailures.Inc();
+          if (auto stale = m_Cache.GetStale(query, now))
+          {
+            staleAnswers.Inc();
+            log::debug(logcat, "upstream dns failed, giving a stale answer from the cache");
+            return std::move(*stale);
+          }
+          return reply;
+        }
+        m_Cache.Put(query, reply.buf.get(), reply.sz, now);
+        return reply;
+      }
+
       bool
       MaybeHookDNS(
           std::shared_ptr<PacketSource_Base> source,
@@ -500,7 +622,14 @@ namespace llarp::dns
             return true;
           }
         }
-        if (not m_ctx)
+        if (auto cached = m_Cache.Get(query, time_now_ms()))
+        {
+          cacheHits.Inc();
+          log::trace(logcat, "dns from {} to {} answered from the cache", from, to);
+          source->SendTo(from, to, std::move(*cached));
+          return true;
+        }
+        if (m_Contexts.empty())
         {
           // we are down
           log::debug(
@@ -527,9 +656,22 @@ namespace llarp::dns
           return true;
         }
 #endif
+        // when we are already asking upstream the same, wait for that instead of asking again
+        const auto key = AnswerCache::Key(query);
+        if (key)
+        {
+          if (auto itr = m_InFlight.find(*key); itr != m_InFlight.end())
+          {
+            log::trace(logcat, "dns from {} to {} follows the same query in flight", from, to);
+            itr->second->followers.push_back(std::move(tmp));
+            coalescedQueries.Inc();
+            return true;
+          }
+        }
+
         const auto& q = query.questions[0];
         if (auto err = ub_resolve_async(
-                m_ctx,
+                ContextFor(key),
                 q.Name().c_str(),
                 q.qtype,
                 q.qclass,
@@ -539,11 +681,15 @@ namespace llarp::dns
         {
           log::warning(
               logcat, "failed to send upstream query with libunbound: {}", ub_strerror(err));
+          upstreamFailures.Inc();
           tmp->Cancel();
         }
         else
         {
           log::trace(logcat, "dns from {} to {} processing via libunbound", from, to);
+          upstreamQueries.Inc();
+          if (key)
+            m_InFlight.emplace(*key, tmp);
           m_Pending.insert(std::move(tmp));
         }
 
@@ -567,7 +713,11 @@ namespace llarp::dns
                   "askerAddr: {})",
                   self->resolverAddr,
                   self->askerAddr);
-              self->src->SendTo(self->askerAddr, self->resolverAddr, OwnedBuffer::copy_from(buf));
+              auto reply = parent_ptr->Remember(self->Underlying(), OwnedBuffer::copy_from(buf));
+              // and everyone who asked the same while we waited
+              for (const auto& follower : parent_ptr->TakeFollowers(self))
+                follower->SendCopyOf(reply);
+              self->src->SendTo(self->askerAddr, self->resolverAddr, std::move(reply));
               // remove query
               parent_ptr->RemovePending(self);
             });
@@ -575,6 +725,16 @@ namespace llarp::dns
       else
         log::error(logcat, "no parent");
     }
+
+    void
+    Query::SendCopyOf(const OwnedBuffer& reply)
+    {
+      if (m_Done.test_and_set())
+        return;
+      OwnedBuffer copy{reply.buf.get(), reply.sz};
+      ReplyAs(Underlying(), copy.buf.get(), copy.sz);
+      src->SendTo(askerAddr, resolverAddr, std::move(copy));
+    }
   }  // namespace libunbound
 
   Server::Server(EventLoop_ptr loop, llarp::DnsConfig conf, unsigned int netif)
@@ -729,33 +889,53 @@ namespace llarp::dns
       log::warning(logcat, "preventing dns packet replay to={} from={}", to, from);
       return false;
     }
+    queries.Inc();
 
-    auto maybe = MaybeParseDNSMessage(buf);
-    if (not maybe)
+    // read it in place first, so that junk and what we answer here cost no allocations
+    const auto view = MessageView::Parse(buf.buf.get(), buf.sz);
+    if (not view)
     {
+      invalidQueries.Inc();
       log::warning(logcat, "invalid dns message format from {} to dns listener on {}", from, to);
       return false;
     }
 
-    auto& msg = *maybe;
     // we don't provide a DoH resolver because it requires verified TLS
     // TLS needs X509/ASN.1-DER and opting into the Root CA Cabal
     // thankfully mozilla added a backdoor that allows ISPs to turn it off
     // so we disable DoH for firefox using mozilla's ISP backdoor
     // see: https://github.com/oxen-io/lokinet/issues/832
-    for (const auto& q : msg.questions)
+    for (size_t i = 0; i < view->qd_count; ++i)
     {
       // is this firefox looking for their backdoor record?
-      if (q.IsName("use-application-dns.net"))
+      if (view->questions[i].qname.Equals("use-application-dns.net"))
       {
         // yea it is, let's turn off DoH because god is dead.
-        msg.AddNXReply();
+        std::array<byte_t, 512> reply;
+        MessageWriter writer{reply.data(), reply.size()};
+        writer.Header(
+            view->hdr_id,
+            ((view->hdr_fields | flags_QR | flags_AA | flags_RA) & ~flags_RD)
+                | flags_RCODENameError);
+        for (size_t j = 0; j < view->qd_count; ++j)
+          writer.Question(view->questions[j]);
+        if (not writer.Ok())
+          return false;
         // press F to pay respects and send it back where it came from
-        ptr->SendTo(from, to, msg.ToBuffer());
+        ptr->SendTo(from, to, OwnedBuffer{reply.data(), writer.Size()});
         return true;
       }
     }
 
+    // the resolvers want the whole thing
+    auto maybe = MaybeParseDNSMessage(buf);
+    if (not maybe)
+    {
+      log::warning(logcat, "invalid dns message format from {} to dns listener on {}", from, to);
+      return false;
+    }
+    auto& msg = *maybe;
+
     for (const auto& resolver : m_Resolvers)
     {
       if (auto res_ptr = resolver.lock())
@@ -0,0 +1,311 @@
+#include "wire.hpp"
+
+#include <llarp/util/str.hpp>
+
+#include <cstring>
+
+namespace llarp::dns
+{
+  namespace
+  {
+    /// the most bytes a name takes on the wire, root label included
+    constexpr size_t MaxNameSize = 255;
+    constexpr size_t MaxLabelSize = 63;
+  }  // namespace
+
+  std::optional<NameView>
+  NameView::Read(const byte_t* msg, size_t sz, size_t& pos)
+  {
+    size_t at = pos;
+    // where the part of the name we are in starts; pointers have to go before it
+    size_t segment = pos;
+    size_t wire = 1;
+    std::optional<size_t> after;
+    while (true)
+    {
+      if (at >= sz)
+        return std::nullopt;
+      const byte_t len = msg[at];
+      if ((len & 0xc0) == 0xc0)
+      {
+        if (at + 2 > sz)
+          return std::nullopt;
+        const size_t target = oxenc::load_big_to_host<uint16_t>(msg + at) & 0x3fff;
+        if (target >= segment)
+          return std::nullopt;
+        if (not after)
+          after = at + 2;
+        segment = at = target;
+        continue;
+      }
+      // the other two label types were never used
+      if (len & 0xc0)
+        return std::nullopt;
+      if (len == 0)
+        break;
+      wire += 1 + len;
+      if (wire > MaxNameSize or at + 1 + len > sz)
+        return std::nullopt;
+      at += 1 + len;
+    }
+    NameView name{msg, pos};
+    pos = after.value_or(at + 1);
+    return name;
+  }
+
+  bool
+  NameView::Equals(std::string_view name) const
+  {
+    if (not name.empty() and name.back() == '.')
+      name.remove_suffix(1);
+    bool first = true;
+    const bool same = ForEachLabel([&name, &first](std::string_view label) {
+      if (not first)
+      {
+        if (name.empty() or name[0] != '.')
+          return false;
+        name.remove_prefix(1);
+      }
+      first = false;
+      if (not string_iequal(name.substr(0, label.size()), label))
+        return false;
+      name.remove_prefix(label.size());
+      return true;
+    });
+    return same and name.empty();
+  }
+
+  bool
+  NameView::HasTLD(std::string_view tld) const
+  {
+    if (not tld.empty() and tld[0] == '.')
+      tld.remove_prefix(1);
+    std::string_view last;
+    ForEachLabel([&last](std::string_view label) {
+      last = label;
+      return true;
+    });
+    return not last.empty() and string_iequal(last, tld);
+  }
+
+  std::string
+  NameView::ToString() const
+  {
+    std::string name;
+    ForEachLabel([&name](std::string_view label) {
+      name += label;
+      name += '.';
+      return true;
+    });
+    return name;
+  }
+
+  std::optional<MessageView>
+  MessageView::Parse(const byte_t* buf, size_t sz)
+  {
+    if (sz < MessageHeader::Size)
+      return std::nullopt;
+    MessageView msg;
+    msg.hdr_id = oxenc::load_big_to_host<uint16_t>(buf);
+    msg.hdr_fields = oxenc::load_big_to_host<uint16_t>(buf + 2);
+    msg.qd_count = oxenc::load_big_to_host<uint16_t>(buf + 4);
+    msg.an_count = oxenc::load_big_to_host<uint16_t>(buf + 6);
+    msg.ns_count = oxenc::load_big_to_host<uint16_t>(buf + 8);
+    msg.ar_count = oxenc::load_big_to_host<uint16_t>(buf + 10);
+    if (msg.qd_count > MaxQuestions)
+      return std::nullopt;
+
+    size_t pos = MessageHeader::Size;
+    for (size_t i = 0; i < msg.qd_count; ++i)
+    {
+      auto name = NameView::Read(buf, sz, pos);
+      if (not name or pos + 4 > sz)
+        return std::nullopt;
+      msg.questions[i] = QuestionView{
+          *name,
+          oxenc::load_big_to_host<uint16_t>(buf + pos),
+          oxenc::load_big_to_host<uint16_t>(buf + pos + 2)};
+      pos += 4;
+    }
+    return msg;
+  }
+
+  void
+  ReplyAs(const Message& query, byte_t* buf, size_t sz)
+  {
+    if (sz < MessageHeader::Size)
+      return;
+    oxenc::write_host_as_big(query.hdr_id, buf);
+    if (query.questions.size() != 1 or oxenc::load_big_to_host<uint16_t>(buf + 4) != 1)
+      return;
+
+    // the same name ignoring case has labels of the same lengths, so ours can go straight over
+    // theirs once we know it is the same name
+    const auto spell = [&query, buf, sz](bool write) {
+      std::string_view name = query.questions[0].qname;
+      size_t at = MessageHeader::Size;
+      while (at < sz and buf[at])
+      {
+        const size_t len = buf[at];
+        if ((len & 0xc0) or at + 1 + len > sz or name.size() < len)
+          return false;
+        const auto label = name.substr(0, len);
+        if (not string_iequal(label, {reinterpret_cast<const char*>(buf + at + 1), len}))
+          return false;
+        if (write)
+          std::copy(label.begin(), label.end(), buf + at + 1);
+        name.remove_prefix(len);
+        if (not name.empty())
+        {
+          if (name[0] != '.')
+            return false;
+          name.remove_prefix(1);
+        }
+        at += 1 + len;
+      }
+      return at < sz and name.empty();
+    };
+    if (spell(false))
+      spell(true);
+  }
+
+  bool
+  MessageWriter::Put(const void* data, size_t sz)
+  {
+    if (m_Overflow or m_Size + sz > m_Capacity)
+    {
+      m_Overflow = true;
+      return false;
+    }
+    if (sz)
+      std::memcpy(m_Buf + m_Size, data, sz);
+    m_Size += sz;
+    return true;
+  }
+
+  void
+  MessageWriter::Count(size_t at)
+  {
+    if (m_Size < MessageHeader::Size)
+      return;
+    const auto count = oxenc::load_big_to_host<uint16_t>(m_Buf + at);
+    oxenc::write_host_as_big<uint16_t>(count + 1, m_Buf + at);
+  }
+
+  void
+  MessageWriter::Undo(size_t size, size_t names)
+  {
+    m_Size = size;
+    m_NumNames = names;
+  }
+
+  bool
+  MessageWriter::WriteName(std::string_view name)
+  {
+    if (not name.empty() and name.back() == '.')
+      name.remove_suffix(1);
+    if (not name.empty() and name.size() + 2 > MaxNameSize)
+    {
+      m_Overflow = true;
+      return false;
+    }
+
+    // find the longest end of name that we already wrote somewhere
+    size_t start = 0;
+    std::optional<uint16_t> pointer;
+    while (start < name.size() and not pointer)
+    {
+      const auto rest = name.substr(start);
+      for (size_t i = 0; i < m_NumNames and not pointer; ++i)
+      {
+        if (NameView{m_Buf, m_Names[i]}.Equals(rest))
+          pointer = m_Names[i];
+      }
+      if (pointer)
+        break;
+      const auto dot = rest.find('.');
+      start = dot == std::string_view::npos ? name.size() : start + dot + 1;
+    }
+
+    // then write the labels before it
+    auto labels = name.substr(0, start);
+    while (not labels.empty())
+    {
+      const auto dot = labels.find('.');
+      const auto label = labels.substr(0, dot);
+      if (label.empty() or label.size() > MaxLabelSize)
+      {
+        m_Overflow = true;
+        return false;
+      }
+      if (m_Size < 0x4000 and m_NumNames < m_Names.size())
+        m_Names[m_NumNames++] = m_Size;
+      const auto len = static_cast<byte_t>(label.size());
+      if (not Put(&len, 1) or not Put(label.data(), label.size()))
+        return false;
+      labels.remove_prefix(dot == std::string_view::npos ? labels.size() : dot + 1);
+    }
+    if (pointer)
+      return PutInt<uint16_t>(0xc000 | *pointer);
+    const byte_t root = 0;
+    return Put(&root, 1);
+  }
+
+  void
+  MessageWriter::Header(MsgID_t id, Fields_t fields)
+  {
+    PutInt(id);
+    PutInt(fields);
+    const std::array<byte_t, 8> counts{};
+    Put(counts.data(), counts.size());
+  }
+
+  void
+  MessageWriter::Question(std::string_view qname, QType_t qtype, QClass_t qclass)
+  {
+    const auto size = m_Size;
+    const auto names = m_NumNames;
+    if (WriteName(qname) and PutInt(qtype) and PutInt(qclass))
+      Count(QDCount);
+    else
+      Undo(size, names);
+  }
+
+  void
+  MessageWriter::Question(const QuestionView& q)
+  {
+    // the name could be spread around the message it came from, so gather it up first
+    std::array<char, MaxNameSize> name;
+    size_t sz = 0;
+    q.qname.ForEachLabel([&name, &sz](std::string_view label) {
+      std::copy(label.begin(), label.end(), name.data() + sz);
+      sz += label.size();
+      name[sz++] = '.';
+      return true;
+    });
+    Question(std::string_view{name.data(), sz}, q.qtype, q.qclass);
+  }
+
+  void
+  MessageWriter::Answer(
+      std::string_view name,
+      RRType_t type,
+      RRClass_t klass,
+      RR_TTL_t ttl,
+      const byte_t* rdata,
+      size_t rdlen)
+  {
+    if (rdlen > 0xffff)
+    {
+      m_Overflow = true;
+      return;
+    }
+    const auto size = m_Size;
+    const auto names = m_NumNames;
+    if (WriteName(name) and PutInt(type) and PutInt(klass) and PutInt(ttl)
+        and PutInt(static_cast<uint16_t>(rdlen)) and Put(rdata, rdlen))
+      Count(ANCount);
+    else
+      Undo(size, names);
+  }
+}  // namespace llarp::dns
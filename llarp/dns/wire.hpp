@@ -0,0 +1,186 @@
+#pragma once
+
+#include "message.hpp"
+
+#include <oxenc/endian.h>
+
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace llarp::dns
+{
+  class MessageWriter;
+
+  /// a name read in place from the dns message it is in, good for as long as the message's
+  /// memory is.  compression pointers are followed, and may only ever point back in the message,
+  /// so a name can't loop.
+  class NameView
+  {
+   public:
+    NameView() = default;
+
+    /// read the name at pos in the sz bytes at msg, stepping pos past it, or return nullopt if
+    /// there is no valid name there
+    static std::optional<NameView>
+    Read(const byte_t* msg, size_t sz, size_t& pos);
+
+    /// call visit with each label of the name in turn; stops early if visit returns false, in
+    /// which case so do we
+    template <typename Visit>
+    bool
+    ForEachLabel(Visit&& visit) const
+    {
+      size_t pos = m_Offset;
+      while (m_Msg[pos])
+      {
+        if ((m_Msg[pos] & 0xc0) == 0xc0)
+        {
+          pos = oxenc::load_big_to_host<uint16_t>(m_Msg + pos) & 0x3fff;
+          continue;
+        }
+        const std::string_view label{reinterpret_cast<const char*>(m_Msg + pos + 1), m_Msg[pos]};
+        if (not visit(label))
+          return false;
+        pos += 1 + label.size();
+      }
+      return true;
+    }
+
+    /// are we the same name as name, with or without its trailing dot, ignoring case
+    bool
+    Equals(std::string_view name) const;
+
+    /// is our last label tld, given as ".loki", ignoring case
+    bool
+    HasTLD(std::string_view tld) const;
+
+    /// the name with a dot after each label, as DecodeName gives it
+    std::string
+    ToString() const;
+
+   private:
+    friend class MessageWriter;
+
+    NameView(const byte_t* msg, size_t offset) : m_Msg{msg}, m_Offset{offset}
+    {}
+
+    const byte_t* m_Msg = nullptr;
+    size_t m_Offset = 0;
+  };
+
+  struct QuestionView
+  {
+    NameView qname;
+    QType_t qtype;
+    QClass_t qclass;
+  };
+
+  /// the header and questions of a dns message read in place, without allocating.  the records
+  /// after the questions are left unread.  for the hot path of handling queries; use Message
+  /// for anything that needs the whole thing.
+  struct MessageView
+  {
+    /// the most questions we read; nothing asks more than one at a time
+    static constexpr size_t MaxQuestions = 4;
+
+    /// read the message in the sz bytes at buf, or return nullopt if it is malformed or has more
+    /// than MaxQuestions questions
+    static std::optional<MessageView>
+    Parse(const byte_t* buf, size_t sz);
+
+    MsgID_t hdr_id;
+    Fields_t hdr_fields;
+    Count_t qd_count;
+    Count_t an_count;
+    Count_t ns_count;
+    Count_t ar_count;
+    /// the first qd_count of these are the questions
+    std::array<QuestionView, MaxQuestions> questions;
+  };
+
+  /// make the sz byte reply at buf to a query asking the same question as query into a reply to
+  /// query: giving it query's id, and the question's name spelled the way query spells it
+  void
+  ReplyAs(const Message& query, byte_t* buf, size_t sz);
+
+  /// writes a dns message into memory the caller owns without allocating, pointing each name
+  /// back at where it or its end were written before.  sections have to be written in order,
+  /// header first.  once something doesn't fit none of it nor anything after is written, and
+  /// Ok() says so.
+  class MessageWriter
+  {
+   public:
+    MessageWriter(byte_t* buf, size_t capacity) : m_Buf{buf}, m_Capacity{capacity}
+    {}
+
+    /// write the header; the count of each section is kept as we write it
+    void
+    Header(MsgID_t id, Fields_t fields);
+
+    void
+    Question(std::string_view qname, QType_t qtype, QClass_t qclass);
+
+    /// copy a question read from another message
+    void
+    Question(const QuestionView& q);
+
+    /// write an answer record, copying its rdata as is
+    void
+    Answer(
+        std::string_view name,
+        RRType_t type,
+        RRClass_t klass,
+        RR_TTL_t ttl,
+        const byte_t* rdata,
+        size_t rdlen);
+
+    /// did everything fit
+    bool
+    Ok() const
+    {
+      return not m_Overflow;
+    }
+
+    /// how many bytes we wrote
+    size_t
+    Size() const
+    {
+      return m_Size;
+    }
+
+   private:
+    /// the offset of each count in the header
+    static constexpr size_t QDCount = 4, ANCount = 6;
+
+    bool
+    Put(const void* data, size_t sz);
+
+    template <typename Int>
+    bool
+    PutInt(Int val)
+    {
+      Int big = oxenc::host_to_big(val);
+      return Put(&big, sizeof(big));
+    }
+
+    void
+    Count(size_t at);
+
+    /// forget what we wrote of something that didn't fit
+    void
+    Undo(size_t size, size_t names);
+
+    bool
+    WriteName(std::string_view name);
+
+    byte_t* m_Buf;
+    size_t m_Capacity;
+    size_t m_Size = 0;
+    bool m_Overflow = false;
+    /// where the names, and each end of them, we wrote start, to point later names at
+    std::array<uint16_t, 32> m_Names;
+    size_t m_NumNames = 0;
+  };
+}  // namespace llarp::dns
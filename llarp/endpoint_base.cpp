@@ -23,6 +23,21 @@ namespace llarp
     return false;
   }
 
+  bool
+  EndpointBase::SendBatchToOrQueue(
+      service::ConvoTag tag,
+      const std::vector<llarp_buffer_t>& payloads,
+      service::ProtocolType t)
+  {
+    bool sent = true;
+    for (const auto& payload : payloads)
+    {
+      if (not SendToOrQueue(tag, payload, t))
+        sent = false;
+    }
+    return sent;
+  }
+
   std::set<dns::SRVData>
   EndpointBase::SRVRecords() const
   {
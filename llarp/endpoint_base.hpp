@@ -14,6 +14,7 @@
 #include <optional>
 #include <unordered_set>
 #include <set>
+#include <vector>
 #include "oxenc/variant.h"
 
 namespace llarp
@@ -136,6 +137,14 @@ namespace llarp
     SendToOrQueue(
         service::ConvoTag tag, const llarp_buffer_t& payload, service::ProtocolType t) = 0;
 
+    /// send several payloads that are ready at once on the convo.  endpoints that can pack them
+    /// into fewer frames override this; by default each goes through SendToOrQueue on its own.
+    virtual bool
+    SendBatchToOrQueue(
+        service::ConvoTag tag,
+        const std::vector<llarp_buffer_t>& payloads,
+        service::ProtocolType t);
+
     /// lookup srv records async
     virtual void
     LookupServiceAsync(
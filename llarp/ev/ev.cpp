@@ -7,13 +7,37 @@
 #include <string_view>
 
 #include "libuv.hpp"
+#ifdef LOKINET_HAVE_URING
+#include "uring.hpp"
+#endif
 #include <llarp/net/net.hpp>
+#include <llarp/util/logging.hpp>
 
 namespace llarp
 {
   EventLoop_ptr
-  EventLoop::create(size_t queueLength)
+  EventLoop::create(size_t queueLength, std::string_view backend)
   {
+    if (backend == "io_uring")
+    {
+#ifdef LOKINET_HAVE_URING
+      if (uring::Available())
+      {
+        try
+        {
+          return std::make_shared<llarp::uring::Loop>(queueLength);
+        }
+        catch (const std::exception& ex)
+        {
+          LogWarn("cannot use io_uring event loop (", ex.what(), "), using libuv");
+        }
+      }
+      else
+        LogWarn("kernel does not support the io_uring event loop, using libuv");
+#else
+      LogWarn("built without io_uring support, using libuv event loop");
+#endif
+    }
     return std::make_shared<llarp::uv::Loop>(queueLength);
   }
 
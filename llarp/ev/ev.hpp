@@ -1,6 +1,7 @@
 #pragma once
 
 #include <llarp/util/buffer.hpp>
+#include <llarp/util/status.hpp>
 #include <llarp/util/time.hpp>
 #include <llarp/util/thread/threading.hpp>
 #include <llarp/constants/evloop.hpp>
@@ -9,6 +10,7 @@
 #include <deque>
 #include <list>
 #include <future>
+#include <typeinfo>
 #include <utility>
 
 namespace uvw
@@ -20,6 +22,7 @@ namespace llarp
 {
   struct SockAddr;
   struct UDPHandle;
+  struct UDPPacket;
 
   namespace vpn
   {
@@ -59,9 +62,11 @@ namespace llarp
     // destruction only initiates removal of the periodic task.
     virtual ~EventLoopRepeater() = default;
 
-    // Starts the repeater to call `task` every `every` period.
+    // Starts the repeater to call `task` every `every` period.  `name` is what we call the task
+    // when it holds up the event loop; it must outlive the repeater (call_every passes the
+    // callable's type name).
     virtual void
-    start(llarp_time_t every, std::function<void()> task) = 0;
+    start(llarp_time_t every, std::function<void()> task, const char* name) = 0;
   };
 
   // this (nearly!) abstract base class
@@ -140,7 +145,8 @@ namespace llarp
               repeater.reset();  // Trigger timer removal on tied object destruction (we should be
                                  // the only thing holding the repeater; ideally it would be a
                                  // unique_ptr, but std::function says nuh-uh).
-          });
+          },
+          typeid(Callable).name());
     }
 
     // Wraps a lambda with a lambda that triggers it to be called via loop->call()
@@ -207,9 +213,11 @@ namespace llarp
     virtual std::shared_ptr<EventLoopRepeater>
     make_repeater() = 0;
 
-    // Constructs and initializes a new default (libuv) event loop
+    // Constructs and initializes a new event loop.  `backend` is "libuv" (the default) or
+    // "io_uring", which falls back to libuv (with a warning) if we were built without io_uring
+    // support or the kernel doesn't have what it needs.
     static std::shared_ptr<EventLoop>
-    create(size_t queueLength = event_loop_queue_size);
+    create(size_t queueLength = event_loop_queue_size, std::string_view backend = "libuv");
 
     // Returns true if called from within the event loop thread, false otherwise.
     virtual bool
@@ -228,6 +236,14 @@ namespace llarp
     // Idempotent and thread-safe.
     virtual void
     wakeup() = 0;
+
+    // How healthy the loop is: how long iterations, queued calls and timers take, and how often
+    // one of them has stalled it.  (This base class default has nothing to say).
+    virtual util::StatusObject
+    ExtractStatus() const
+    {
+      return util::StatusObject{};
+    }
   };
 
   using EventLoop_ptr = std::shared_ptr<EventLoop>;
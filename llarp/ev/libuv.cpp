@@ -1,17 +1,94 @@
 #include "libuv.hpp"
+#include "udp_receiver.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <memory>
 #include <thread>
 #include <type_traits>
 #include <cstring>
 
 #include <llarp/util/exceptions.hpp>
-#include <llarp/util/thread/queue.hpp>
+#include <llarp/util/logging.hpp>
+#include <llarp/util/metrics.hpp>
 #include <llarp/vpn/platform.hpp>
 
 #include <uvw.hpp>
 
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/udp.h>
+#include <array>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
 namespace llarp::uv
 {
+  static auto logcat = log::Cat("ev");
+
+  namespace
+  {
+    using Clock = std::chrono::steady_clock;
+
+    /// a callback (or an iteration) taking this long holds everything else up long enough to
+    /// notice: paths time out, link sessions miss keepalives, dns answers go stale
+    constexpr auto StallThreshold = 50ms;
+
+    metrics::Histogram loopIteration{
+        "lokinet_loop_iteration_microseconds",
+        "Time the event loop spent busy in an iteration, leaving out waiting for io"};
+    metrics::Histogram loopCallDelay{
+        "lokinet_loop_call_delay_microseconds",
+        "Time a call queued for the event loop waited before it was run"};
+    metrics::Histogram loopCallTime{
+        "lokinet_loop_call_microseconds", "Time spent running a call queued for the event loop"};
+    metrics::Histogram loopTimerTime{
+        "lokinet_loop_timer_microseconds", "Time spent in a repeating timer's callback"};
+    metrics::Counter loopStalls{
+        "lokinet_loop_stalls_total", "Event loop iterations that ran past the stall threshold"};
+
+    uint64_t
+    Micros(Clock::duration d)
+    {
+      return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+    }
+
+    /// a readable name for a type name from typeid, e.g. "llarp::Router::Run()::{lambda()#1}"
+    std::string
+    Demangle(const char* name)
+    {
+#ifdef __GNUG__
+      int status = 0;
+      std::unique_ptr<char, void (*)(void*)> demangled{
+          abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free};
+      if (status == 0 and demangled)
+        return demangled.get();
+#endif
+      return name;
+    }
+
+    void
+    Stalled(std::string_view what, const char* name, Clock::duration took)
+    {
+      log::warning(
+          logcat,
+          "{} {} held up the event loop for {:.1f}ms",
+          what,
+          Demangle(name),
+          Micros(took) / 1000.0);
+    }
+  }  // namespace
+
   std::shared_ptr<uvw::Loop>
   Loop::MaybeGetUVWLoop()
   {
@@ -50,10 +127,17 @@ namespace llarp::uv
     {}
 
     void
-    start(llarp_time_t every, std::function<void()> task) override
+    start(llarp_time_t every, std::function<void()> task, const char* name) override
     {
       timer->start(every, every);
-      timer->on<uvw::TimerEvent>([task = std::move(task)](auto&, auto&) { task(); });
+      timer->on<uvw::TimerEvent>([task = std::move(task), name](auto&, auto&) {
+        const auto started = Clock::now();
+        task();
+        const auto took = Clock::now() - started;
+        loopTimerTime.Record(Micros(took));
+        if (took >= StallThreshold)
+          Stalled("timer", name, took);
+      });
     }
 
     ~UVRepeater() override
@@ -72,6 +156,26 @@ namespace llarp::uv
     bool
     send(const SockAddr& dest, const llarp_buffer_t& buf) override;
 
+#ifdef __linux__
+    bool
+    listen_shared(const SockAddr& addr) override;
+
+    size_t
+    send_batch(const std::vector<UDPSendItem>& pkts) override;
+
+    bool
+    enable_offload() override;
+
+    bool
+    set_dont_fragment() override;
+
+    bool
+    offload_enabled() const override
+    {
+      return offload;
+    }
+#endif
+
     std::optional<SockAddr>
     LocalAddr() const override
     {
@@ -99,17 +203,60 @@ namespace llarp::uv
 
     void
     reset_handle(uvw::Loop& loop);
+
+#ifdef __linux__
+    // On linux we don't let libuv read the socket (which would give us one callback, and one
+    // syscall, per datagram); instead we poll the socket for readability ourselves and drain up to
+    // udp_batch_size datagrams per wakeup with a single recvmmsg.
+    std::shared_ptr<uvw::PollHandle> poll;
+    std::vector<byte_t> recv_buf;
+    std::vector<mmsghdr> recv_hdrs;
+    std::vector<iovec> recv_iovs;
+    std::vector<sockaddr_storage> recv_addrs;
+    std::vector<UDPPacket> recv_batch;
+
+    // Control message space for a single int-valued cmsg (UDP_SEGMENT on send, UDP_GRO on recv).
+    union cmsg_buf_t
+    {
+      char buf[CMSG_SPACE(sizeof(int))];
+      cmsghdr align;
+    };
+    std::vector<cmsg_buf_t> recv_ctrl;
+
+    // Set once GSO has been turned on for the socket.
+    bool offload{false};
+    // Set once GRO has been turned on for the socket, which we only do when we read it through
+    // `poll`: libuv's own recv knows nothing of the UDP_GRO cmsg and would hand coalesced
+    // datagrams up as one.
+    bool gro{false};
+
+    // Sets up the recvmmsg buffers and starts polling the bound socket; returns false if the
+    // socket is not available, in which case the caller should fall back to libuv's recv.
+    bool
+    start_batch_recv();
+
+    void
+    on_batch_readable();
+#endif
   };
 
   void
   Loop::FlushLogic()
   {
     llarp::LogTrace("Loop::FlushLogic() start");
-    while (not m_LogicCalls.empty())
-    {
-      auto f = m_LogicCalls.popFront();
-      f();
-    }
+    // one clock read a call: where one call ends is where the next one starts
+    auto started = Clock::now();
+    const auto calls = [&started](QueuedCall call) {
+      loopCallDelay.Record(Micros(started - call.queued));
+      call.f();
+      const auto ended = Clock::now();
+      loopCallTime.Record(Micros(ended - started));
+      if (ended - started >= StallThreshold)
+        Stalled("call", call.f.target_type().name(), ended - started);
+      started = ended;
+    };
+    if (m_LogicCalls.Drain(calls, m_LogicBatch))
+      m_WakeUp->send();
     llarp::LogTrace("Loop::FlushLogic() end");
   }
 
@@ -120,7 +267,7 @@ namespace llarp::uv
     FlushLogic();
   }
 
-  Loop::Loop(size_t queue_size) : llarp::EventLoop{}, m_LogicCalls{queue_size}
+  Loop::Loop(size_t queue_size) : llarp::EventLoop{}, m_LogicBatch{std::max<size_t>(queue_size, 1)}
   {
     if (!(m_Impl = uvw::Loop::create()))
       throw std::runtime_error{"Failed to construct libuv loop"};
@@ -139,6 +286,44 @@ namespace llarp::uv
     if (!(m_WakeUp = m_Impl->resource<uvw::AsyncHandle>()))
       throw std::runtime_error{"Failed to create libuv async"};
     m_WakeUp->on<uvw::AsyncEvent>([this](const auto&, auto&) { tick_event_loop(); });
+
+#if UV_VERSION_HEX >= 0x012700
+    // telling time spent busy from time spent waiting for io needs libuv to keep count of the
+    // latter (1.39+); without it we don't time iterations, only the callbacks in them
+    if (uv_loop_configure(m_Impl->raw(), UV_METRICS_IDLE_TIME) == 0
+        and (m_Monitor = m_Impl->resource<uvw::PrepareHandle>()))
+    {
+      m_Monitor->on<uvw::PrepareEvent>([this](const auto&, auto&) { MonitorIteration(); });
+      m_Monitor->start();
+      // it only watches, so it mustn't be what keeps the loop running
+      m_Monitor->unreference();
+    }
+#endif
+  }
+
+  void
+  Loop::MonitorIteration()
+  {
+#if UV_VERSION_HEX >= 0x012700
+    const auto now = Clock::now();
+    const auto idle = uv_metrics_idle_time(m_Impl->raw());
+    if (m_LastIteration)
+    {
+      const auto waited = std::chrono::nanoseconds{idle - m_LastIdleTime};
+      const auto busy = std::max<Clock::duration>(now - *m_LastIteration - waited, 0s);
+      loopIteration.Record(Micros(busy));
+      if (busy >= StallThreshold)
+      {
+        loopStalls.Inc();
+        log::warning(
+            logcat,
+            "an event loop iteration took {:.1f}ms; see the calls and timers it ran",
+            Micros(busy) / 1000.0);
+      }
+    }
+    m_LastIteration = now;
+    m_LastIdleTime = idle;
+#endif
   }
 
   bool
@@ -255,19 +440,26 @@ namespace llarp::uv
     if (!handle)
       return false;
 
-    handle->on<event_t>([netif = std::move(netif), handler = std::move(handler)](
-                            const event_t&, [[maybe_unused]] auto& handle) {
-      for (auto pkt = netif->ReadNextPacket(); true; pkt = netif->ReadNextPacket())
+    handle->on<event_t>([netif = std::move(netif),
+                         handler = std::move(handler),
+                         batch = std::vector<llarp::net::IPPacket>{}](
+                            const event_t&, [[maybe_unused]] auto& handle) mutable {
+      constexpr size_t ReadBatch = 64;
+      size_t got;
+      do
       {
-        if (pkt.empty())
-          return;
-        if (handler)
-          handler(std::move(pkt));
-        // on windows/apple, vpn packet io does not happen as an io action that wakes up the event
-        // loop thus, we must manually wake up the event loop when we get a packet on our interface.
-        // on linux/android this is a nop
-        netif->MaybeWakeUpperLayers();
-      }
+        batch.clear();
+        got = netif->ReadPackets(batch, ReadBatch);
+        for (auto& pkt : batch)
+        {
+          if (handler)
+            handler(std::move(pkt));
+          // on windows/apple, vpn packet io does not happen as an io action that wakes up the
+          // event loop thus, we must manually wake up the event loop when we get a packet on our
+          // interface. on linux/android this is a nop
+          netif->MaybeWakeUpperLayers();
+        }
+      } while (got == ReadBatch);
     });
 
 #ifdef __linux__
@@ -282,19 +474,9 @@ namespace llarp::uv
   void
   Loop::call_soon(std::function<void(void)> f)
   {
-    if (not m_EventLoopThreadID.has_value())
-    {
-      m_LogicCalls.tryPushBack(f);
+    // a burst of calls between two flushes needs only the one wakeup
+    if (m_LogicCalls.Push(QueuedCall{std::move(f), Clock::now()}))
       m_WakeUp->send();
-      return;
-    }
-
-    if (inEventLoop() and m_LogicCalls.full())
-    {
-      FlushLogic();
-    }
-    m_LogicCalls.pushBack(f);
-    m_WakeUp->send();
   }
 
   // Sets `handle` to a new uvw UDP handle, first initiating a close and then disowning the handle
@@ -302,6 +484,14 @@ namespace llarp::uv
   void
   UDPHandle::reset_handle(uvw::Loop& loop)
   {
+#ifdef __linux__
+    if (poll)
+    {
+      poll->close();
+      poll.reset();
+    }
+    offload = gro = false;
+#endif
     if (handle)
       handle->close();
     handle = loop.resource<uvw::UDPHandle>();
@@ -321,7 +511,11 @@ namespace llarp::uv
   bool
   UDPHandle::listen(const SockAddr& addr)
   {
-    if (handle->active())
+    bool bound = handle->active();
+#ifdef __linux__
+    bound = bound or poll;
+#endif
+    if (bound)
       reset_handle(handle->loop());
 
     auto err = handle->on<uvw::ErrorEvent>([addr](auto& event, auto&) {
@@ -329,11 +523,218 @@ namespace llarp::uv
           fmt::format("failed to bind udp socket on {}: {}", addr, event.what())};
     });
     handle->bind(*static_cast<const sockaddr*>(addr));
-    handle->recv();
+#ifdef __linux__
+    if (not start_batch_recv())
+#endif
+      handle->recv();
     handle->erase(err);
     return true;
   }
 
+#ifdef __linux__
+  bool
+  UDPHandle::listen_shared(const SockAddr& addr)
+  {
+    if (handle->active() or poll)
+      reset_handle(handle->loop());
+
+    auto fd = bind_reuseport_udp(addr);
+    if (not fd)
+      return false;
+    // libuv takes ownership of the (already bound) socket from here
+    handle->open(*fd);
+    if (not start_batch_recv())
+      handle->recv();
+    return true;
+  }
+
+  bool
+  UDPHandle::start_batch_recv()
+  {
+    const auto fd = file_descriptor();
+    if (not fd)
+      return false;
+
+    recv_buf.resize(udp_batch_size * udp_max_datagram_size);
+    recv_hdrs.resize(udp_batch_size);
+    recv_iovs.resize(udp_batch_size);
+    recv_addrs.resize(udp_batch_size);
+    recv_ctrl.resize(udp_batch_size);
+    recv_batch.reserve(udp_batch_size);
+    for (size_t i = 0; i < udp_batch_size; ++i)
+    {
+      recv_iovs[i].iov_base = recv_buf.data() + (i * udp_max_datagram_size);
+      recv_iovs[i].iov_len = udp_max_datagram_size;
+    }
+
+    poll = handle->loop().resource<uvw::PollHandle>(*fd);
+    if (not poll)
+      return false;
+    poll->on<uvw::PollEvent>([this](const auto&, auto&) { on_batch_readable(); });
+    poll->start(uvw::PollHandle::Event::READABLE);
+    return true;
+  }
+
+  void
+  UDPHandle::on_batch_readable()
+  {
+    const auto fd = file_descriptor();
+    if (not fd)
+      return;
+
+    for (size_t i = 0; i < udp_batch_size; ++i)
+    {
+      auto& hdr = recv_hdrs[i].msg_hdr;
+      hdr = msghdr{};
+      hdr.msg_name = &recv_addrs[i];
+      hdr.msg_namelen = sizeof(sockaddr_storage);
+      hdr.msg_iov = &recv_iovs[i];
+      hdr.msg_iovlen = 1;
+      if (gro)
+      {
+        hdr.msg_control = recv_ctrl[i].buf;
+        hdr.msg_controllen = sizeof(recv_ctrl[i].buf);
+      }
+    }
+
+    // Only one recvmmsg per wakeup: the poll is level triggered so if there is more waiting we'll
+    // be called again on the next loop iteration, after other handles have had a turn.
+    const int n = ::recvmmsg(*fd, recv_hdrs.data(), recv_hdrs.size(), MSG_DONTWAIT, nullptr);
+    if (n <= 0)
+      return;
+
+    recv_batch.clear();
+    for (int i = 0; i < n; ++i)
+    {
+      auto& hdr = recv_hdrs[i];
+      if (hdr.msg_hdr.msg_flags & MSG_TRUNC)
+        continue;
+      const SockAddr from{*reinterpret_cast<const sockaddr*>(&recv_addrs[i])};
+      const auto* data = static_cast<const byte_t*>(recv_iovs[i].iov_base);
+      size_t segsz = hdr.msg_len;
+      // with GRO the kernel may have coalesced several same-sized datagrams from this sender into
+      // one; split them back up so everyone above us only ever sees real datagrams.
+      if (gro)
+      {
+        for (auto* cmsg = CMSG_FIRSTHDR(&hdr.msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr.msg_hdr, cmsg))
+        {
+          if (cmsg->cmsg_level == SOL_UDP and cmsg->cmsg_type == UDP_GRO)
+          {
+            int gso_size;
+            std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+            if (gso_size > 0)
+              segsz = gso_size;
+          }
+        }
+      }
+      for (size_t off = 0; off < hdr.msg_len; off += segsz)
+        recv_batch.push_back(
+            UDPPacket{from, byte_view_t{data + off, std::min(segsz, hdr.msg_len - off)}});
+    }
+    if (not recv_batch.empty())
+      deliver_batch(recv_batch);
+  }
+
+  bool
+  UDPHandle::enable_offload()
+  {
+    const auto fd = file_descriptor();
+    if (not fd)
+      return false;
+    // there is no direct way to ask whether GSO is supported, but setting a zero default segment
+    // size succeeds exactly when it is (and leaves unsegmented sends alone).
+    int zero = 0;
+    if (::setsockopt(*fd, SOL_UDP, UDP_SEGMENT, &zero, sizeof(zero)) != 0)
+      return false;
+    offload = true;
+    // only the recvmmsg path splits coalesced datagrams back up, so without it we leave GRO off
+    // and just send with GSO.  GRO failing to turn on costs us nothing but the syscalls it saves.
+    int one = 1;
+    if (poll and ::setsockopt(*fd, SOL_UDP, UDP_GRO, &one, sizeof(one)) == 0)
+      gro = true;
+    return true;
+  }
+
+  bool
+  UDPHandle::set_dont_fragment()
+  {
+    const auto fd = file_descriptor();
+    return fd and set_udp_pmtu_probe(*fd);
+  }
+
+  size_t
+  UDPHandle::send_batch(const std::vector<UDPSendItem>& pkts)
+  {
+    const auto fd = file_descriptor();
+    if (not fd)
+      return llarp::UDPHandle::send_batch(pkts);
+
+    // One entry per sendmmsg message.  When offload is not available segmented items expand into
+    // one entry per segment; `owner` maps each entry back to the item it came from so that we can
+    // report how many items went out completely.
+    struct entry_t
+    {
+      const SockAddr* dest;
+      byte_view_t data;
+      uint16_t segment_size;
+      size_t owner;
+    };
+    // This gets called from worker threads, so scratch space is per-thread rather than in the
+    // handle.
+    thread_local std::vector<entry_t> entries;
+    entries.clear();
+    for (size_t idx = 0; idx < pkts.size(); ++idx)
+    {
+      const auto& pkt = pkts[idx];
+      if (pkt.segment_size == 0 or offload)
+      {
+        entries.push_back(entry_t{&pkt.dest, pkt.data, pkt.segment_size, idx});
+        continue;
+      }
+      for (size_t off = 0; off < pkt.data.size(); off += pkt.segment_size)
+        entries.push_back(entry_t{&pkt.dest, pkt.data.substr(off, pkt.segment_size), 0, idx});
+    }
+
+    std::array<mmsghdr, udp_batch_size> hdrs;
+    std::array<iovec, udp_batch_size> iovs;
+    std::array<cmsg_buf_t, udp_batch_size> ctrls;
+    size_t sent = 0;
+    while (sent < entries.size())
+    {
+      const size_t n = std::min(entries.size() - sent, udp_batch_size);
+      for (size_t i = 0; i < n; ++i)
+      {
+        const auto& ent = entries[sent + i];
+        iovs[i].iov_base = const_cast<byte_t*>(ent.data.data());
+        iovs[i].iov_len = ent.data.size();
+        auto& hdr = hdrs[i].msg_hdr;
+        hdr = msghdr{};
+        hdr.msg_name = const_cast<sockaddr*>(static_cast<const sockaddr*>(*ent.dest));
+        hdr.msg_namelen = ent.dest->sockaddr_len();
+        hdr.msg_iov = &iovs[i];
+        hdr.msg_iovlen = 1;
+        if (ent.segment_size and ent.segment_size < ent.data.size())
+        {
+          hdr.msg_control = ctrls[i].buf;
+          hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+          auto* cmsg = CMSG_FIRSTHDR(&hdr);
+          cmsg->cmsg_level = SOL_UDP;
+          cmsg->cmsg_type = UDP_SEGMENT;
+          cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+          std::memcpy(CMSG_DATA(cmsg), &ent.segment_size, sizeof(uint16_t));
+        }
+      }
+      const int rc = ::sendmmsg(*fd, hdrs.data(), n, MSG_DONTWAIT);
+      if (rc <= 0)
+        break;
+      sent += rc;
+      if (static_cast<size_t>(rc) < n)
+        break;
+    }
+    return sent == entries.size() ? pkts.size() : entries[sent].owner;
+  }
+#endif
+
   bool
   UDPHandle::send(const SockAddr& to, const llarp_buffer_t& buf)
   {
@@ -347,6 +748,15 @@ namespace llarp::uv
   void
   UDPHandle::close()
   {
+#ifdef __linux__
+    if (poll)
+    {
+      poll->close();
+      poll.reset();
+    }
+#endif
+    if (not handle)
+      return;
     handle->close();
     handle.reset();
   }
@@ -369,6 +779,18 @@ namespace llarp::uv
     return std::static_pointer_cast<EventLoopRepeater>(std::make_shared<UVRepeater>(*m_Impl));
   }
 
+  util::StatusObject
+  Loop::ExtractStatus() const
+  {
+    return util::StatusObject{
+        {"iteration", loopIteration.ExtractStatus()},
+        {"callDelay", loopCallDelay.ExtractStatus()},
+        {"call", loopCallTime.ExtractStatus()},
+        {"timer", loopTimerTime.ExtractStatus()},
+        {"stalls", loopStalls.Value()},
+        {"stallThreshold", Micros(StallThreshold)}};
+  }
+
   bool
   Loop::inEventLoop() const
   {
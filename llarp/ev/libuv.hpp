@@ -1,14 +1,16 @@
 #pragma once
 #include "ev.hpp"
 #include "udp_handle.hpp"
-#include <llarp/util/thread/queue.hpp>
+#include <llarp/util/thread/mpsc_queue.hpp>
 #include <llarp/util/meta/memfn.hpp>
 
 #include <uvw/loop.h>
 #include <uvw/async.h>
 #include <uvw/poll.h>
+#include <uvw/prepare.h>
 #include <uvw/udp.h>
 
+#include <chrono>
 #include <functional>
 #include <map>
 #include <vector>
@@ -75,15 +77,26 @@ namespace llarp::uv
     bool
     inEventLoop() const override;
 
+    util::StatusObject
+    ExtractStatus() const override;
+
    protected:
     std::shared_ptr<uvw::Loop> m_Impl;
     std::optional<std::thread::id> m_EventLoopThreadID;
 
    private:
+    /// a call_soon call, with when it was queued so we can tell how long it waited
+    struct QueuedCall
+    {
+      std::function<void(void)> f;
+      std::chrono::steady_clock::time_point queued;
+    };
+
     std::shared_ptr<uvw::AsyncHandle> m_WakeUp;
     std::atomic<bool> m_Run;
-    using AtomicQueue_t = llarp::thread::Queue<std::function<void(void)>>;
-    AtomicQueue_t m_LogicCalls;
+    llarp::thread::MPSCQueue<QueuedCall> m_LogicCalls;
+    /// most calls we run per wakeup before letting the loop see to io and timers
+    const size_t m_LogicBatch;
 
 #ifdef LOKINET_DEBUG
     uint64_t last_time;
@@ -95,6 +108,14 @@ namespace llarp::uv
 
     std::unordered_map<int, std::shared_ptr<uvw::PollHandle>> m_Polls;
 
+    /// fires once an iteration, just before we block for io, to time the iteration just gone
+    std::shared_ptr<uvw::PrepareHandle> m_Monitor;
+    std::optional<std::chrono::steady_clock::time_point> m_LastIteration;
+    uint64_t m_LastIdleTime{0};
+
+    void
+    MonitorIteration();
+
     void
     wakeup() override;
   };
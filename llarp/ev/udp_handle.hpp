@@ -1,12 +1,37 @@
+#pragma once
 #include "ev.hpp"
 #include "../util/buffer.hpp"
+#include <llarp/net/sock_addr.hpp>
+
+#include <vector>
 
 namespace llarp
 {
+  // A single datagram received as part of a batch.  The payload points into the socket's receive
+  // buffer and is only valid for the duration of the batch receive callback; copy it if you need
+  // to keep it.
+  struct UDPPacket
+  {
+    SockAddr from;
+    byte_view_t data;
+  };
+
+  // A single datagram to send as part of a batch.  The payload is not owned and must remain valid
+  // until the send_batch call returns.
+  struct UDPSendItem
+  {
+    SockAddr dest;
+    byte_view_t data;
+    // If non-zero then `data` is a run of datagrams of this size (the last may be shorter) that are
+    // sent as one segmentation offloaded send when offload is enabled, or one at a time if not.
+    uint16_t segment_size{0};
+  };
+
   // Base type for UDP handling; constructed via EventLoop::make_udp().
   struct UDPHandle
   {
     using ReceiveFunc = EventLoop::UDPReceiveFunc;
+    using ReceiveBatchFunc = std::function<void(UDPHandle&, std::vector<UDPPacket>&)>;
 
     // Starts listening for incoming UDP packets on the given address. Returns true on success,
     // false if the address could not be bound. If you send without calling this first then the
@@ -14,12 +39,77 @@ namespace llarp
     virtual bool
     listen(const SockAddr& addr) = 0;
 
+    // Like listen(), but binds with SO_REUSEPORT so that further sockets (e.g. UDPReceiveThreads)
+    // can bind the same address and share the incoming traffic.  Returns false if not supported
+    // on this platform or if the bind fails.
+    virtual bool
+    listen_shared(const SockAddr& /*addr*/)
+    {
+      return false;
+    }
+
     // Sends a packet to the given recipient, immediately.  Returns true if the send succeeded,
     // false it could not be performed (either because of error, or because it would have blocked).
     // If listen hasn't been called then a random IP/port will be used.
     virtual bool
     send(const SockAddr& dest, const llarp_buffer_t& buf) = 0;
 
+    // Sends a batch of packets, in order, stopping at the first one that fails.  Returns the number
+    // of packets that were sent.  Implementations that can do so (i.e. linux, via sendmmsg) hand
+    // the whole batch to the kernel at once; the default simply calls send() for each.
+    virtual size_t
+    send_batch(const std::vector<UDPSendItem>& pkts)
+    {
+      size_t sent = 0;
+      for (const auto& pkt : pkts)
+      {
+        const size_t segsz = pkt.segment_size ? pkt.segment_size : pkt.data.size();
+        for (size_t off = 0; off < pkt.data.size(); off += segsz)
+        {
+          const auto seg = pkt.data.substr(off, segsz);
+          if (not send(pkt.dest, llarp_buffer_t{seg.data(), seg.size()}))
+            return sent;
+        }
+        ++sent;
+      }
+      return sent;
+    }
+
+    // Turns on UDP segmentation offload (GSO) for segmented sends, and receive offload (GRO) too
+    // when we read the socket in batches and so can split what it coalesces, where the platform
+    // supports it.  Must be called after listen().  Returns true if GSO is active; when it is not,
+    // segmented sends are still accepted but go out one datagram at a time.
+    virtual bool
+    enable_offload()
+    {
+      return false;
+    }
+
+    // Sets the don't fragment bit on outgoing packets and stops the kernel from capping their size
+    // at its cached path MTU, so that oversized packets are dropped along the path rather than
+    // fragmented; needed for probing the path MTU ourselves.  Must be called after listen().
+    // Returns false if not supported on this platform.
+    virtual bool
+    set_dont_fragment()
+    {
+      return false;
+    }
+
+    // Returns true if enable_offload() turned on segmentation offload for this socket.
+    virtual bool
+    offload_enabled() const
+    {
+      return false;
+    }
+
+    // Sets a callback to be invoked with every batch of packets received in one wakeup instead of
+    // invoking the per-packet receive function.  Passing nullptr restores per-packet delivery.
+    void
+    set_batch_recv(ReceiveBatchFunc f)
+    {
+      on_recv_batch = std::move(f);
+    }
+
     // Closes the listening UDP socket (if opened); this is typically called (automatically) during
     // destruction.  Does nothing if the UDP socket is already closed.
     virtual void
@@ -47,7 +137,23 @@ namespace llarp
       assert(this->on_recv);
     }
 
+    // Hands a batch of received packets to the batch receive callback if set, otherwise to the
+    // per-packet callback one at a time.
+    void
+    deliver_batch(std::vector<UDPPacket>& pkts)
+    {
+      if (on_recv_batch)
+        on_recv_batch(*this, pkts);
+      else
+      {
+        for (auto& pkt : pkts)
+          on_recv(*this, pkt.from, OwnedBuffer{pkt.data.data(), pkt.data.size()});
+      }
+    }
+
     // Callback to invoke when data is received
     ReceiveFunc on_recv;
+    // Optional callback to invoke with a batch of received packets
+    ReceiveBatchFunc on_recv_batch;
   };
 }  // namespace llarp
@@ -0,0 +1,184 @@
+#include "udp_receiver.hpp"
+
+#include <llarp/constants/evloop.hpp>
+#include <llarp/util/buffer_pool.hpp>
+#include <llarp/util/logging.hpp>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace llarp
+{
+#ifdef __linux__
+  std::optional<int>
+  bind_reuseport_udp(const SockAddr& addr)
+  {
+    const int fd = ::socket(
+        addr.isIPv6() ? AF_INET6 : AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+      return std::nullopt;
+    const int on = 1;
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0
+        or ::bind(fd, static_cast<const sockaddr*>(addr), addr.sockaddr_len()) != 0)
+    {
+      LogWarn("cannot bind shared udp socket on ", addr, ": ", strerror(errno));
+      ::close(fd);
+      return std::nullopt;
+    }
+    return fd;
+  }
+
+  bool
+  set_udp_pmtu_probe(int fd)
+  {
+    // PMTUDISC_PROBE rather than DO: DF is set but the kernel doesn't cut our sends down to the
+    // path MTU it has cached, so a probe bigger than that still goes out
+    int v4 = IP_PMTUDISC_PROBE;
+    const bool ok4 = ::setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER, &v4, sizeof(v4)) == 0;
+    int v6 = IPV6_PMTUDISC_PROBE;
+    const bool ok6 = ::setsockopt(fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &v6, sizeof(v6)) == 0;
+    return ok4 or ok6;
+  }
+
+  UDPReceiveThread::UDPReceiveThread(BatchFunc on_batch) : m_OnBatch{std::move(on_batch)}
+  {}
+
+  UDPReceiveThread::~UDPReceiveThread()
+  {
+    stop();
+  }
+
+  bool
+  UDPReceiveThread::start(const SockAddr& addr)
+  {
+    if (m_Thread.joinable())
+      return false;
+    auto fd = bind_reuseport_udp(addr);
+    if (not fd)
+      return false;
+    m_FD = *fd;
+    m_WakeFD = ::eventfd(0, EFD_CLOEXEC);
+    if (m_WakeFD < 0)
+    {
+      ::close(m_FD);
+      m_FD = -1;
+      return false;
+    }
+    m_Thread = std::thread{[this] { run(); }};
+    return true;
+  }
+
+  void
+  UDPReceiveThread::stop()
+  {
+    if (m_Thread.joinable())
+    {
+      const uint64_t one = 1;
+      if (::write(m_WakeFD, &one, sizeof(one)) < 0)
+        LogWarn("failed to wake udp receive thread: ", strerror(errno));
+      m_Thread.join();
+    }
+    for (auto* fd : {&m_FD, &m_WakeFD})
+    {
+      if (*fd >= 0)
+        ::close(*fd);
+      *fd = -1;
+    }
+  }
+
+  void
+  UDPReceiveThread::run()
+  {
+    std::vector<byte_t> buf(udp_batch_size * udp_max_datagram_size);
+    std::vector<mmsghdr> hdrs(udp_batch_size);
+    std::vector<iovec> iovs(udp_batch_size);
+    std::vector<sockaddr_storage> addrs(udp_batch_size);
+    for (size_t i = 0; i < udp_batch_size; ++i)
+    {
+      iovs[i].iov_base = buf.data() + (i * udp_max_datagram_size);
+      iovs[i].iov_len = udp_max_datagram_size;
+    }
+
+    std::array<pollfd, 2> fds{pollfd{m_FD, POLLIN, 0}, pollfd{m_WakeFD, POLLIN, 0}};
+    while (true)
+    {
+      if (::poll(fds.data(), fds.size(), -1) < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        LogError("udp receive thread poll failed: ", strerror(errno));
+        return;
+      }
+      if (fds[1].revents)
+        return;
+
+      for (size_t i = 0; i < udp_batch_size; ++i)
+      {
+        auto& hdr = hdrs[i].msg_hdr;
+        hdr = msghdr{};
+        hdr.msg_name = &addrs[i];
+        hdr.msg_namelen = sizeof(sockaddr_storage);
+        hdr.msg_iov = &iovs[i];
+        hdr.msg_iovlen = 1;
+      }
+      const int n = ::recvmmsg(m_FD, hdrs.data(), hdrs.size(), MSG_DONTWAIT, nullptr);
+      if (n <= 0)
+        continue;
+
+      std::vector<UDPDatagram> batch;
+      batch.reserve(n);
+      for (int i = 0; i < n; ++i)
+      {
+        if (hdrs[i].msg_hdr.msg_flags & MSG_TRUNC)
+          continue;
+        batch.push_back(UDPDatagram{
+            SockAddr{*reinterpret_cast<const sockaddr*>(&addrs[i])},
+            util::BufferPool::Acquire(
+                static_cast<const byte_t*>(iovs[i].iov_base), hdrs[i].msg_len)});
+      }
+      if (not batch.empty())
+        m_OnBatch(std::move(batch));
+    }
+  }
+#else
+  std::optional<int>
+  bind_reuseport_udp(const SockAddr&)
+  {
+    return std::nullopt;
+  }
+
+  bool
+  set_udp_pmtu_probe(int)
+  {
+    return false;
+  }
+
+  UDPReceiveThread::UDPReceiveThread(BatchFunc on_batch) : m_OnBatch{std::move(on_batch)}
+  {}
+
+  UDPReceiveThread::~UDPReceiveThread() = default;
+
+  bool
+  UDPReceiveThread::start(const SockAddr&)
+  {
+    return false;
+  }
+
+  void
+  UDPReceiveThread::stop()
+  {}
+
+  void
+  UDPReceiveThread::run()
+  {}
+#endif
+}  // namespace llarp
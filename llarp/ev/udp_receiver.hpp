@@ -0,0 +1,70 @@
+#pragma once
+
+#include <llarp/net/sock_addr.hpp>
+#include <llarp/util/types.hpp>
+
+#include <functional>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace llarp
+{
+  // A datagram received by a UDPReceiveThread; unlike UDPPacket it owns its payload, as it has to
+  // outlive the receive buffer to be handed to another thread.
+  struct UDPDatagram
+  {
+    SockAddr from;
+    std::vector<byte_t> data;
+  };
+
+  // Opens a non-blocking UDP socket bound to addr with SO_REUSEPORT set, so that several sockets
+  // can bind the same address and the kernel spreads incoming flows across them (by a hash of the
+  // addresses, so any one remote always lands on the same socket).  Returns nullopt on failure or
+  // where SO_REUSEPORT is not available.
+  std::optional<int>
+  bind_reuseport_udp(const SockAddr& addr);
+
+  // Sets the don't fragment bit on a UDP socket's sends without letting the kernel cap them at the
+  // path MTU it has cached (IP_PMTUDISC_PROBE), for sockets that probe the path MTU themselves.
+  // Returns false where not supported.
+  bool
+  set_udp_pmtu_probe(int fd);
+
+  // A thread with its own SO_REUSEPORT socket, bound alongside a link's main socket, that does
+  // nothing but receive.  Each recvmmsg batch is copied into pooled buffers and handed to the
+  // callback on the receiving thread; the callback is expected to pass it on to whatever thread
+  // owns the sessions.  Receive only: sends still go out the main socket.
+  //
+  // Linux only; elsewhere start() always fails.
+  struct UDPReceiveThread
+  {
+    using BatchFunc = std::function<void(std::vector<UDPDatagram>)>;
+
+    explicit UDPReceiveThread(BatchFunc on_batch);
+    ~UDPReceiveThread();
+
+    UDPReceiveThread(const UDPReceiveThread&) = delete;
+    UDPReceiveThread&
+    operator=(const UDPReceiveThread&) = delete;
+
+    // Binds a socket to addr (which must already have a SO_REUSEPORT socket bound, e.g. via
+    // UDPHandle::listen_shared) and starts the thread.  Returns false if either fails.
+    bool
+    start(const SockAddr& addr);
+
+    // Stops and joins the thread and closes the socket; does nothing if not running.
+    void
+    stop();
+
+   private:
+    void
+    run();
+
+    BatchFunc m_OnBatch;
+    int m_FD = -1;
+    // written to by stop() to wake the thread out of poll()
+    int m_WakeFD = -1;
+    std::thread m_Thread;
+  };
+}  // namespace llarp
@@ -0,0 +1,760 @@
+#include "uring.hpp"
+#include "udp_receiver.hpp"
+
+#include <llarp/net/ip_packet.hpp>
+#include <llarp/util/exceptions.hpp>
+#include <llarp/util/logging.hpp>
+#include <llarp/vpn/platform.hpp>
+
+#include <liburing.h>
+#include <uvw.hpp>
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp::uring
+{
+  namespace
+  {
+    /// what a completion is for; kept in the top byte of its user data, with the socket,
+    /// interface or slot it belongs to in the rest
+    enum class Op : uint8_t
+    {
+      UDPRecv = 1,
+      UDPSend,
+      TunRead,
+      TunWrite,
+      Cancel,
+    };
+
+    constexpr uint64_t
+    make_tag(Op op, uint64_t idx)
+    {
+      return (uint64_t{static_cast<uint8_t>(op)} << 56) | idx;
+    }
+
+    constexpr Op
+    tag_op(uint64_t tag)
+    {
+      return static_cast<Op>(tag >> 56);
+    }
+
+    constexpr uint64_t
+    tag_index(uint64_t tag)
+    {
+      return tag & ((uint64_t{1} << 56) - 1);
+    }
+
+    constexpr unsigned RingEntries = 4096;
+    /// provided buffers per udp socket, and their size: room for any link layer datagram plus the
+    /// recvmsg header and source address the kernel writes in front of it
+    constexpr unsigned RecvBuffers = 256;
+    constexpr size_t RecvBufferSize = 4096;
+    /// slots for outgoing udp datagrams in flight; sends that find none free, or that are too big
+    /// for one, go out with a plain sendto instead
+    constexpr size_t SendSlots = 2048;
+    constexpr size_t SendSlotSize = 2048;
+    /// registered buffers for network interface io, and how many of them are kept as reads in
+    /// flight on each interface
+    constexpr size_t TunSlots = 512;
+    constexpr size_t TunSlotSize = net::IPPacket::MaxSize;
+    constexpr size_t TunReadsInFlight = 32;
+
+    bool
+    send_now(int fd, const SockAddr& to, const byte_t* data, size_t sz)
+    {
+      return ::sendto(
+                 fd, data, sz, MSG_DONTWAIT, static_cast<const sockaddr*>(to), to.sockaddr_len())
+          >= 0;
+    }
+  }  // namespace
+
+  class UDPHandle;
+
+  /// owns the io_uring and everything registered with it.  submissions can come from any thread
+  /// (link layer sends happen on crypto workers) and are serialized by m_Mutex; completions are
+  /// only ever reaped on the event loop thread.  sockets and interfaces are added and removed on
+  /// the event loop thread (or before it runs).
+  class Ring : public std::enable_shared_from_this<Ring>
+  {
+   public:
+    Ring(llarp::EventLoop& owner, uvw::Loop& loop);
+    ~Ring();
+
+    Ring(const Ring&) = delete;
+    Ring&
+    operator=(const Ring&) = delete;
+
+    /// start receiving on a bound udp socket, handing batches to handle; returns the socket's id
+    /// or nullopt if it could not be set up
+    std::optional<uint32_t>
+    add_socket(UDPHandle* handle, int fd);
+
+    /// stop receiving for a socket; its buffers are freed once the kernel is done with them
+    void
+    remove_socket(uint32_t id);
+
+    /// queue a datagram; returns false if there was no room, in which case the caller should send
+    /// it itself
+    bool
+    send(int fd, const SockAddr& to, byte_view_t data);
+
+    bool
+    add_interface(
+        std::shared_ptr<vpn::NetworkInterface> netif, std::function<void(net::IPPacket)> handler);
+
+    /// queue a packet write to an interface; returns false if there was no room
+    bool
+    write_interface(uint32_t id, const net::IPPacket& pkt);
+
+   private:
+    struct Socket
+    {
+      UDPHandle* handle;
+      int fd;
+      uint16_t bgid;
+      io_uring_buf_ring* br = nullptr;
+      std::vector<byte_t> bufs;
+      /// only the name and control lengths are used by multishot recvmsg
+      msghdr hdr{};
+      /// buffer ids handed to us in the current drain, to give back once delivered
+      std::vector<uint16_t> used;
+      std::vector<UDPPacket> batch;
+      bool armed = false;
+      /// set once removed; we keep it until the final completion of its recv
+      bool closing = false;
+    };
+
+    struct Interface
+    {
+      std::shared_ptr<vpn::NetworkInterface> netif;
+      std::function<void(net::IPPacket)> handler;
+      int fd;
+    };
+
+    struct SendSlot
+    {
+      msghdr hdr;
+      iovec iov;
+      sockaddr_storage addr;
+    };
+
+    /// get a submission entry, flushing the queue to make room if it is full; m_Mutex held
+    io_uring_sqe*
+    get_sqe();
+
+    /// submit now if off the event loop thread, otherwise at the end of this loop iteration;
+    /// m_Mutex held
+    void
+    submit();
+
+    /// m_Mutex held
+    void
+    arm_recv(uint32_t id, Socket& sock);
+
+    /// m_Mutex held
+    void
+    post_read(uint32_t id, Interface& iface, uint32_t slot);
+
+    void
+    recycle(Socket& sock);
+
+    void
+    drain();
+
+    llarp::EventLoop& m_Owner;
+    io_uring m_Ring;
+    int m_EventFD = -1;
+    std::shared_ptr<uvw::PollHandle> m_Poll;
+    std::shared_ptr<uvw::PrepareHandle> m_Prepare;
+
+    std::mutex m_Mutex;
+    bool m_SubmitPending = false;
+
+    std::unordered_map<uint32_t, std::unique_ptr<Socket>> m_Sockets;
+    uint32_t m_NextSocketID = 1;
+
+    std::vector<SendSlot> m_SendSlots;
+    std::vector<byte_t> m_SendArena;
+    std::vector<uint32_t> m_FreeSend;
+
+    std::unordered_map<uint32_t, Interface> m_Interfaces;
+    uint32_t m_NextInterfaceID = 1;
+    /// registered with the ring as fixed buffer 0
+    std::vector<byte_t> m_TunArena;
+    std::vector<uint32_t> m_FreeTun;
+    /// which interface each tun slot is reading for
+    std::vector<uint32_t> m_TunSlotOwner;
+  };
+
+  class UDPHandle final : public llarp::UDPHandle
+  {
+   public:
+    UDPHandle(std::shared_ptr<Ring> ring, ReceiveFunc rf)
+        : llarp::UDPHandle{std::move(rf)}, m_Ring{std::move(ring)}
+    {}
+
+    ~UDPHandle() override
+    {
+      close();
+    }
+
+    bool
+    listen(const SockAddr& addr) override
+    {
+      close();
+      const int fd = ::socket(
+          addr.isIPv6() ? AF_INET6 : AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (fd < 0)
+        return false;
+      if (::bind(fd, static_cast<const sockaddr*>(addr), addr.sockaddr_len()) != 0)
+      {
+        ::close(fd);
+        throw llarp::util::bind_socket_error{
+            fmt::format("failed to bind udp socket on {}: {}", addr, strerror(errno))};
+      }
+      return start(fd);
+    }
+
+    bool
+    listen_shared(const SockAddr& addr) override
+    {
+      close();
+      auto fd = bind_reuseport_udp(addr);
+      return fd and start(*fd);
+    }
+
+    bool
+    send(const SockAddr& dest, const llarp_buffer_t& buf) override
+    {
+      if (m_FD < 0 and not listen(SockAddr{"0.0.0.0:0"}))
+        return false;
+      const byte_view_t data{buf.base, buf.sz};
+      return m_Ring->send(m_FD, dest, data) or send_now(m_FD, dest, data.data(), data.size());
+    }
+
+    size_t
+    send_batch(const std::vector<UDPSendItem>& pkts) override
+    {
+      if (m_FD < 0 and not listen(SockAddr{"0.0.0.0:0"}))
+        return 0;
+      size_t sent = 0;
+      for (const auto& pkt : pkts)
+      {
+        const size_t segsz = pkt.segment_size ? pkt.segment_size : pkt.data.size();
+        for (size_t off = 0; off < pkt.data.size(); off += segsz)
+        {
+          const auto seg = pkt.data.substr(off, segsz);
+          if (not m_Ring->send(m_FD, pkt.dest, seg)
+              and not send_now(m_FD, pkt.dest, seg.data(), seg.size()))
+            return sent;
+        }
+        ++sent;
+      }
+      return sent;
+    }
+
+    bool
+    set_dont_fragment() override
+    {
+      return m_FD >= 0 and set_udp_pmtu_probe(m_FD);
+    }
+
+    void
+    close() override
+    {
+      if (m_ID)
+        m_Ring->remove_socket(*m_ID);
+      m_ID.reset();
+      if (m_FD >= 0)
+        ::close(m_FD);
+      m_FD = -1;
+    }
+
+    std::optional<int>
+    file_descriptor() override
+    {
+      if (m_FD >= 0)
+        return m_FD;
+      return std::nullopt;
+    }
+
+    std::optional<SockAddr>
+    LocalAddr() const override
+    {
+      sockaddr_storage addr{};
+      socklen_t len = sizeof(addr);
+      if (m_FD < 0 or ::getsockname(m_FD, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+        return std::nullopt;
+      return SockAddr{*reinterpret_cast<const sockaddr*>(&addr)};
+    }
+
+    /// called by the ring with everything received on this socket in one drain
+    void
+    deliver(std::vector<UDPPacket>& pkts)
+    {
+      deliver_batch(pkts);
+    }
+
+   private:
+    bool
+    start(int fd)
+    {
+      m_FD = fd;
+      m_ID = m_Ring->add_socket(this, fd);
+      if (not m_ID)
+      {
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    std::shared_ptr<Ring> m_Ring;
+    int m_FD = -1;
+    std::optional<uint32_t> m_ID;
+  };
+
+  Ring::Ring(llarp::EventLoop& owner, uvw::Loop& loop) : m_Owner{owner}
+  {
+    if (const int err = io_uring_queue_init(RingEntries, &m_Ring, 0); err < 0)
+      throw std::runtime_error{fmt::format("cannot set up io_uring: {}", strerror(-err))};
+
+    m_TunArena.resize(TunSlots * TunSlotSize);
+    const iovec arena{m_TunArena.data(), m_TunArena.size()};
+    if (const int err = io_uring_register_buffers(&m_Ring, &arena, 1); err < 0)
+    {
+      io_uring_queue_exit(&m_Ring);
+      throw std::runtime_error{fmt::format("cannot register io_uring buffers: {}", strerror(-err))};
+    }
+    m_TunSlotOwner.resize(TunSlots);
+    for (uint32_t slot = TunSlots; slot > 0; --slot)
+      m_FreeTun.push_back(slot - 1);
+
+    m_SendSlots.resize(SendSlots);
+    m_SendArena.resize(SendSlots * SendSlotSize);
+    for (uint32_t slot = SendSlots; slot > 0; --slot)
+      m_FreeSend.push_back(slot - 1);
+
+    m_EventFD = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_EventFD < 0 or io_uring_register_eventfd(&m_Ring, m_EventFD) < 0)
+    {
+      if (m_EventFD >= 0)
+        ::close(m_EventFD);
+      io_uring_queue_exit(&m_Ring);
+      throw std::runtime_error{"cannot set up io_uring completion eventfd"};
+    }
+
+    m_Poll = loop.resource<uvw::PollHandle>(m_EventFD);
+    m_Prepare = loop.resource<uvw::PrepareHandle>();
+    if (not m_Poll or not m_Prepare)
+    {
+      ::close(m_EventFD);
+      io_uring_queue_exit(&m_Ring);
+      throw std::runtime_error{"cannot poll io_uring completions"};
+    }
+    m_Poll->on<uvw::PollEvent>([this](const auto&, auto&) {
+      uint64_t count;
+      if (::read(m_EventFD, &count, sizeof(count)) < 0 and errno != EAGAIN)
+        LogWarn("io_uring eventfd read failed: ", strerror(errno));
+      drain();
+    });
+    m_Poll->start(uvw::PollHandle::Event::READABLE);
+    // everything the loop thread queued this iteration goes to the kernel in one go
+    m_Prepare->on<uvw::PrepareEvent>([this](const auto&, auto&) {
+      std::lock_guard lock{m_Mutex};
+      if (m_SubmitPending)
+      {
+        m_SubmitPending = false;
+        io_uring_submit(&m_Ring);
+      }
+    });
+    m_Prepare->start();
+  }
+
+  Ring::~Ring()
+  {
+    for (auto& [id, sock] : m_Sockets)
+      io_uring_free_buf_ring(&m_Ring, sock->br, RecvBuffers, sock->bgid);
+    // tearing the ring down cancels anything still in flight
+    io_uring_queue_exit(&m_Ring);
+    ::close(m_EventFD);
+  }
+
+  io_uring_sqe*
+  Ring::get_sqe()
+  {
+    auto* sqe = io_uring_get_sqe(&m_Ring);
+    if (not sqe)
+    {
+      io_uring_submit(&m_Ring);
+      m_SubmitPending = false;
+      sqe = io_uring_get_sqe(&m_Ring);
+    }
+    return sqe;
+  }
+
+  void
+  Ring::submit()
+  {
+    if (m_Owner.inEventLoop())
+      m_SubmitPending = true;
+    else
+      io_uring_submit(&m_Ring);
+  }
+
+  std::optional<uint32_t>
+  Ring::add_socket(UDPHandle* handle, int fd)
+  {
+    std::lock_guard lock{m_Mutex};
+    const auto id = m_NextSocketID++;
+    auto sock = std::make_unique<Socket>();
+    sock->handle = handle;
+    sock->fd = fd;
+    sock->bgid = static_cast<uint16_t>(id);
+    int err = 0;
+    sock->br = io_uring_setup_buf_ring(&m_Ring, RecvBuffers, sock->bgid, 0, &err);
+    if (not sock->br)
+    {
+      LogWarn("cannot set up io_uring receive buffers: ", strerror(-err));
+      return std::nullopt;
+    }
+    sock->bufs.resize(RecvBuffers * RecvBufferSize);
+    const int mask = io_uring_buf_ring_mask(RecvBuffers);
+    for (uint16_t bid = 0; bid < RecvBuffers; ++bid)
+      io_uring_buf_ring_add(
+          sock->br, sock->bufs.data() + bid * RecvBufferSize, RecvBufferSize, bid, mask, bid);
+    io_uring_buf_ring_advance(sock->br, RecvBuffers);
+    sock->hdr.msg_namelen = sizeof(sockaddr_storage);
+    sock->batch.reserve(RecvBuffers);
+    sock->used.reserve(RecvBuffers);
+    arm_recv(id, *sock);
+    m_Sockets.emplace(id, std::move(sock));
+    submit();
+    return id;
+  }
+
+  void
+  Ring::remove_socket(uint32_t id)
+  {
+    std::lock_guard lock{m_Mutex};
+    auto itr = m_Sockets.find(id);
+    if (itr == m_Sockets.end())
+      return;
+    auto& sock = *itr->second;
+    sock.handle = nullptr;
+    sock.closing = true;
+    if (not sock.armed)
+    {
+      io_uring_free_buf_ring(&m_Ring, sock.br, RecvBuffers, sock.bgid);
+      m_Sockets.erase(itr);
+      return;
+    }
+    if (auto* sqe = get_sqe())
+    {
+      io_uring_prep_cancel64(sqe, make_tag(Op::UDPRecv, id), 0);
+      io_uring_sqe_set_data64(sqe, make_tag(Op::Cancel, id));
+      submit();
+    }
+  }
+
+  void
+  Ring::arm_recv(uint32_t id, Socket& sock)
+  {
+    auto* sqe = get_sqe();
+    if (not sqe)
+      return;
+    io_uring_prep_recvmsg_multishot(sqe, sock.fd, &sock.hdr, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = sock.bgid;
+    io_uring_sqe_set_data64(sqe, make_tag(Op::UDPRecv, id));
+    sock.armed = true;
+  }
+
+  bool
+  Ring::send(int fd, const SockAddr& to, byte_view_t data)
+  {
+    if (data.size() > SendSlotSize)
+      return false;
+    std::lock_guard lock{m_Mutex};
+    if (m_FreeSend.empty())
+      return false;
+    auto* sqe = get_sqe();
+    if (not sqe)
+      return false;
+    const auto idx = m_FreeSend.back();
+    m_FreeSend.pop_back();
+    auto& slot = m_SendSlots[idx];
+    auto* buf = m_SendArena.data() + idx * SendSlotSize;
+    std::copy(data.begin(), data.end(), buf);
+    std::memcpy(&slot.addr, static_cast<const sockaddr*>(to), to.sockaddr_len());
+    slot.iov = iovec{buf, data.size()};
+    slot.hdr = msghdr{};
+    slot.hdr.msg_name = &slot.addr;
+    slot.hdr.msg_namelen = to.sockaddr_len();
+    slot.hdr.msg_iov = &slot.iov;
+    slot.hdr.msg_iovlen = 1;
+    io_uring_prep_sendmsg(sqe, fd, &slot.hdr, MSG_DONTWAIT);
+    io_uring_sqe_set_data64(sqe, make_tag(Op::UDPSend, idx));
+    submit();
+    return true;
+  }
+
+  bool
+  Ring::add_interface(
+      std::shared_ptr<vpn::NetworkInterface> netif, std::function<void(net::IPPacket)> handler)
+  {
+    std::lock_guard lock{m_Mutex};
+    if (m_FreeTun.size() < TunReadsInFlight * 2)
+    {
+      LogWarn("no io_uring buffers left for network interface ", netif->Info().ifname);
+      return false;
+    }
+    const auto id = m_NextInterfaceID++;
+    const int fd = netif->PollFD();
+    auto& iface = m_Interfaces.emplace(id, Interface{netif, std::move(handler), fd}).first->second;
+    for (size_t i = 0; i < TunReadsInFlight; ++i)
+    {
+      const auto slot = m_FreeTun.back();
+      m_FreeTun.pop_back();
+      post_read(id, iface, slot);
+    }
+    submit();
+    // writes from here on go through the ring as well, for as long as there is one
+    netif->SetPacketWriter([self = weak_from_this(), id](const net::IPPacket& pkt) {
+      auto ring = self.lock();
+      return ring and ring->write_interface(id, pkt);
+    });
+    return true;
+  }
+
+  void
+  Ring::post_read(uint32_t id, Interface& iface, uint32_t slot)
+  {
+    auto* sqe = get_sqe();
+    if (not sqe)
+    {
+      m_FreeTun.push_back(slot);
+      return;
+    }
+    m_TunSlotOwner[slot] = id;
+    io_uring_prep_read_fixed(
+        sqe, iface.fd, m_TunArena.data() + slot * TunSlotSize, TunSlotSize, 0, 0);
+    io_uring_sqe_set_data64(sqe, make_tag(Op::TunRead, slot));
+  }
+
+  bool
+  Ring::write_interface(uint32_t id, const net::IPPacket& pkt)
+  {
+    if (pkt.size() > TunSlotSize)
+      return false;
+    std::lock_guard lock{m_Mutex};
+    auto itr = m_Interfaces.find(id);
+    // keep a few slots back so that writes can't starve reads of buffers to re-post into
+    if (itr == m_Interfaces.end() or m_FreeTun.size() <= TunReadsInFlight)
+      return false;
+    auto* sqe = get_sqe();
+    if (not sqe)
+      return false;
+    const auto slot = m_FreeTun.back();
+    m_FreeTun.pop_back();
+    auto* buf = m_TunArena.data() + slot * TunSlotSize;
+    std::copy_n(pkt.data(), pkt.size(), buf);
+    io_uring_prep_write_fixed(sqe, itr->second.fd, buf, pkt.size(), 0, 0);
+    io_uring_sqe_set_data64(sqe, make_tag(Op::TunWrite, slot));
+    submit();
+    return true;
+  }
+
+  void
+  Ring::recycle(Socket& sock)
+  {
+    const int mask = io_uring_buf_ring_mask(RecvBuffers);
+    int offset = 0;
+    for (const auto bid : sock.used)
+      io_uring_buf_ring_add(
+          sock.br, sock.bufs.data() + bid * RecvBufferSize, RecvBufferSize, bid, mask, offset++);
+    io_uring_buf_ring_advance(sock.br, offset);
+    sock.used.clear();
+  }
+
+  void
+  Ring::drain()
+  {
+    std::vector<uint32_t> touched;
+    std::vector<std::pair<uint32_t, net::IPPacket>> tunPkts;
+
+    io_uring_cqe* cqe;
+    unsigned head;
+    unsigned count = 0;
+    io_uring_for_each_cqe(&m_Ring, head, cqe)
+    {
+      ++count;
+      const auto tag = io_uring_cqe_get_data64(cqe);
+      const auto idx = tag_index(tag);
+      switch (tag_op(tag))
+      {
+        case Op::UDPRecv: {
+          auto itr = m_Sockets.find(idx);
+          if (itr == m_Sockets.end())
+            break;
+          auto& sock = *itr->second;
+          if (cqe->flags & IORING_CQE_F_BUFFER)
+          {
+            const uint16_t bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+            sock.used.push_back(bid);
+            auto* out = cqe->res > 0 and not sock.closing
+                ? io_uring_recvmsg_validate(
+                    sock.bufs.data() + bid * RecvBufferSize, cqe->res, &sock.hdr)
+                : nullptr;
+            if (out and not(out->flags & MSG_TRUNC))
+            {
+              const auto* from = static_cast<const sockaddr*>(io_uring_recvmsg_name(out));
+              const auto* payload =
+                  static_cast<const byte_t*>(io_uring_recvmsg_payload(out, &sock.hdr));
+              const auto len = io_uring_recvmsg_payload_length(out, cqe->res, &sock.hdr);
+              sock.batch.push_back(UDPPacket{SockAddr{*from}, byte_view_t{payload, len}});
+            }
+          }
+          else if (cqe->res < 0 and cqe->res != -ENOBUFS and cqe->res != -ECANCELED)
+            LogWarn("io_uring udp receive failed: ", strerror(-cqe->res));
+          if (not(cqe->flags & IORING_CQE_F_MORE))
+            sock.armed = false;
+          if (std::find(touched.begin(), touched.end(), idx) == touched.end())
+            touched.push_back(idx);
+          break;
+        }
+        case Op::UDPSend: {
+          if (cqe->res < 0)
+            LogTrace("io_uring udp send failed: ", strerror(-cqe->res));
+          std::lock_guard lock{m_Mutex};
+          m_FreeSend.push_back(idx);
+          break;
+        }
+        case Op::TunRead: {
+          const auto id = m_TunSlotOwner[idx];
+          if (cqe->res > 0)
+            tunPkts.emplace_back(
+                id,
+                net::IPPacket{byte_view_t{
+                    m_TunArena.data() + idx * TunSlotSize, static_cast<size_t>(cqe->res)}});
+          else if (cqe->res < 0 and cqe->res != -EAGAIN)
+            LogWarn("io_uring network interface read failed: ", strerror(-cqe->res));
+          std::lock_guard lock{m_Mutex};
+          auto itr = m_Interfaces.find(id);
+          if (itr != m_Interfaces.end() and cqe->res != -EBADF and cqe->res != -ECANCELED)
+            post_read(id, itr->second, idx);
+          else
+            m_FreeTun.push_back(idx);
+          break;
+        }
+        case Op::TunWrite: {
+          if (cqe->res < 0)
+            LogTrace("io_uring network interface write failed: ", strerror(-cqe->res));
+          std::lock_guard lock{m_Mutex};
+          m_FreeTun.push_back(idx);
+          break;
+        }
+        case Op::Cancel:
+          break;
+      }
+    }
+    io_uring_cq_advance(&m_Ring, count);
+
+    for (const auto id : touched)
+    {
+      auto itr = m_Sockets.find(id);
+      if (itr == m_Sockets.end())
+        continue;
+      auto& sock = *itr->second;
+      if (not sock.batch.empty())
+      {
+        // the handle may close itself from in here, so we only look it up again afterwards
+        if (sock.handle)
+          sock.handle->deliver(sock.batch);
+        itr = m_Sockets.find(id);
+        if (itr == m_Sockets.end())
+          continue;
+        sock.batch.clear();
+      }
+      recycle(sock);
+      std::lock_guard lock{m_Mutex};
+      if (sock.closing and not sock.armed)
+      {
+        io_uring_free_buf_ring(&m_Ring, sock.br, RecvBuffers, sock.bgid);
+        m_Sockets.erase(itr);
+      }
+      else if (not sock.closing and not sock.armed)
+      {
+        // multishot stops when we run out of buffers or on error; we just gave buffers back
+        arm_recv(id, sock);
+        submit();
+      }
+    }
+
+    for (auto& [id, pkt] : tunPkts)
+    {
+      auto itr = m_Interfaces.find(id);
+      if (itr != m_Interfaces.end() and itr->second.handler)
+        itr->second.handler(std::move(pkt));
+    }
+  }
+
+  bool
+  Available()
+  {
+    utsname uts{};
+    int major = 0, minor = 0;
+    if (::uname(&uts) != 0 or std::sscanf(uts.release, "%d.%d", &major, &minor) != 2 or major < 6)
+      return false;
+    io_uring ring;
+    if (io_uring_queue_init(8, &ring, 0) < 0)
+      return false;
+    bool ok = false;
+    if (auto* probe = io_uring_get_probe_ring(&ring))
+    {
+      ok = io_uring_opcode_supported(probe, IORING_OP_RECVMSG)
+          and io_uring_opcode_supported(probe, IORING_OP_SENDMSG)
+          and io_uring_opcode_supported(probe, IORING_OP_READ_FIXED)
+          and io_uring_opcode_supported(probe, IORING_OP_WRITE_FIXED)
+          and io_uring_opcode_supported(probe, IORING_OP_ASYNC_CANCEL);
+      io_uring_free_probe(probe);
+    }
+    io_uring_queue_exit(&ring);
+    return ok;
+  }
+
+  Loop::Loop(size_t queue_size) : llarp::uv::Loop{queue_size}
+  {
+    m_Ring = std::make_shared<Ring>(*this, *m_Impl);
+    LogInfo("using io_uring for udp and network interface io");
+  }
+
+  Loop::~Loop() = default;
+
+  std::shared_ptr<llarp::UDPHandle>
+  Loop::make_udp(UDPReceiveFunc on_recv)
+  {
+    return std::make_shared<UDPHandle>(m_Ring, std::move(on_recv));
+  }
+
+  bool
+  Loop::add_network_interface(
+      std::shared_ptr<llarp::vpn::NetworkInterface> netif,
+      std::function<void(llarp::net::IPPacket)> handler)
+  {
+    if (netif->Queues() == 1 and not netif->Offloaded() and m_Ring->add_interface(netif, handler))
+      return true;
+    return llarp::uv::Loop::add_network_interface(std::move(netif), std::move(handler));
+  }
+}  // namespace llarp::uring
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "libuv.hpp"
+
+#include <memory>
+
+namespace llarp::uring
+{
+  class Ring;
+
+  /// Returns true if the running kernel supports everything Loop needs: multishot recvmsg and
+  /// provided buffer rings, i.e. linux 6.0 or later.
+  bool
+  Available();
+
+  /// An event loop that moves the data plane onto io_uring.  UDP sockets receive with a single
+  /// multishot recvmsg each, into a kernel provided buffer ring, and queue their sends on the ring
+  /// rather than making a syscall per batch; network interfaces are read and written with fixed
+  /// (registered) buffers, keeping several reads in flight at once.
+  ///
+  /// Everything else -- timers, wakeups, call_soon, tickers -- is still libuv, which stays the
+  /// outer loop: the ring signals completions through an eventfd that libuv polls, and submissions
+  /// made from the loop thread are flushed once per loop iteration, just before libuv blocks.
+  ///
+  /// Selected with [router]:event-loop=io_uring; see EventLoop::create.
+  class Loop final : public llarp::uv::Loop
+  {
+   public:
+    /// throws if the ring cannot be set up
+    explicit Loop(size_t queue_size);
+
+    ~Loop() override;
+
+    std::shared_ptr<llarp::UDPHandle>
+    make_udp(UDPReceiveFunc on_recv) override;
+
+    bool
+    add_network_interface(
+        std::shared_ptr<llarp::vpn::NetworkInterface> netif,
+        std::function<void(llarp::net::IPPacket)> handler) override;
+
+   private:
+    std::shared_ptr<Ring> m_Ring;
+  };
+}  // namespace llarp::uring
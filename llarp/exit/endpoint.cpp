@@ -28,7 +28,9 @@ namespace llarp
     Endpoint::~Endpoint()
     {
       if (m_CurrentPath)
-        m_Parent->DelEndpointInfo(m_CurrentPath->RXID());
+        m_Parent->DelEndpointInfo(m_CurrentPath->RXID(), this);
+      if (m_PreviousPath)
+        m_Parent->DelEndpointInfo(*m_PreviousPath, this);
     }
 
     void
@@ -50,15 +52,23 @@ namespace llarp
           {"exiting", !m_RewriteSource},
           {"looksDead", LooksDead(now)},
           {"expiresSoon", ExpiresSoon(now)},
-          {"expired", IsExpired(now)}};
+          {"expired", IsExpired(now)},
+          {"downstreamQueuedBytes", m_Downstream.QueuedBytes()},
+          {"downstreamBufferBytes", m_Downstream.BufferBytes()}};
       return obj;
     }
 
     bool
     Endpoint::UpdateLocalPath(const llarp::PathID_t& nextPath)
     {
-      if (!m_Parent->UpdateEndpointPath(m_remoteSignKey, nextPath))
+      if (!m_Parent->UpdateEndpointPath(this, nextPath))
         return false;
+      // traffic still coming up the path we had finds us until we move on again
+      if (m_PreviousPath)
+        m_Parent->DelEndpointInfo(*m_PreviousPath, this);
+      m_PreviousPath.reset();
+      if (m_CurrentPath)
+        m_PreviousPath = m_CurrentPath->RXID();
       const RouterID us{m_Parent->GetRouter()->pubkey()};
       m_CurrentPath = m_Parent->GetRouter()->pathContext().GetByUpstream(us, nextPath);
       return true;
@@ -163,43 +173,34 @@ namespace llarp
     Endpoint::QueueInboundTraffic(std::vector<byte_t> buf, service::ProtocolType type)
     {
       if (type != service::ProtocolType::QUIC)
-      {
-        llarp::net::IPPacket pkt{std::move(buf)};
-        if (pkt.empty())
-          return false;
-
-        huint128_t src;
-        if (m_RewriteSource)
-          src = m_Parent->GetIfAddr();
-        else
-          src = pkt.srcv6();
-        if (pkt.IsV6())
-          pkt.UpdateIPv6Address(src, m_IP);
-        else
-          pkt.UpdateIPv4Address(xhtonl(net::TruncateV6(src)), xhtonl(net::TruncateV6(m_IP)));
+        return QueueInboundTraffic(net::IPPacket{std::move(buf)});
+      return m_Downstream.Put(
+          llarp_buffer_t{buf}, m_Counter++, type, net::TrafficClass::Interactive, m_Parent->Now());
+    }
 
-        buf = pkt.steal();
-      }
+    bool
+    Endpoint::QueueInboundTraffic(net::IPPacket pkt)
+    {
+      if (pkt.empty())
+        return false;
 
-      const uint8_t queue_idx = buf.size() / llarp::routing::ExitPadSize;
-      if (m_DownstreamQueues.find(queue_idx) == m_DownstreamQueues.end())
-        m_DownstreamQueues.emplace(queue_idx, InboundTrafficQueue_t{});
-      auto& queue = m_DownstreamQueues.at(queue_idx);
-      if (queue.size() == 0)
-      {
-        queue.emplace_back();
-        queue.back().protocol = type;
-        return queue.back().PutBuffer(std::move(buf), m_Counter++);
-      }
-      auto& msg = queue.back();
-      if (msg.Size() + buf.size() > llarp::routing::ExitPadSize)
-      {
-        queue.emplace_back();
-        queue.back().protocol = type;
-        return queue.back().PutBuffer(std::move(buf), m_Counter++);
-      }
-      msg.protocol = type;
-      return msg.PutBuffer(std::move(buf), m_Counter++);
+      huint128_t src;
+      if (m_RewriteSource)
+        src = m_Parent->GetIfAddr();
+      else
+        src = pkt.srcv6();
+      if (pkt.IsV6())
+        pkt.UpdateIPv6Address(src, m_IP);
+      else
+        pkt.UpdateIPv4Address(xhtonl(net::TruncateV6(src)), xhtonl(net::TruncateV6(m_IP)));
+
+      const auto klass = m_Parent->Classifier().Classify(pkt);
+      return m_Downstream.Put(
+          pkt.ConstBuffer(),
+          m_Counter++,
+          service::ProtocolType::TrafficV4,
+          klass,
+          m_Parent->Now());
     }
 
     bool
@@ -217,24 +218,18 @@ namespace llarp
       bool sent = path != nullptr;
       if (path)
       {
-        for (auto& item : m_DownstreamQueues)
-        {
-          auto& queue = item.second;
-          while (queue.size())
+        // the more urgent classes first, so they are ahead in the queues further on too
+        m_Downstream.Flush(m_Parent->Now(), [this, &path, &sent](auto& msg) {
+          msg.S = path->NextSeqNo();
+          if (path->SendRoutingMessage(msg, m_Parent->GetRouter()))
           {
-            auto& msg = queue.front();
-            msg.S = path->NextSeqNo();
-            if (path->SendRoutingMessage(msg, m_Parent->GetRouter()))
-            {
-              m_RxRate += msg.Size();
-              sent = true;
-            }
-            queue.pop_front();
+            m_RxRate += msg.Size();
+            sent = true;
           }
-        }
+        });
       }
-      for (auto& item : m_DownstreamQueues)
-        item.second.clear();
+      else
+        m_Downstream.Clear();
       return sent;
     }
   }  // namespace exit
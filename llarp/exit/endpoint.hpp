@@ -1,12 +1,17 @@
 #pragma once
 
+#include "traffic_packer.hpp"
+
 #include <llarp/crypto/types.hpp>
 #include <llarp/net/ip_packet.hpp>
+#include <llarp/net/traffic_class.hpp>
 #include <llarp/path/ihophandler.hpp>
 #include <llarp/routing/transfer_traffic_message.hpp>
 #include <llarp/service/protocol_type.hpp>
 #include <llarp/util/time.hpp>
 
+#include <array>
+#include <optional>
 #include <queue>
 
 namespace llarp
@@ -60,10 +65,22 @@ namespace llarp
       bool
       QueueInboundTraffic(std::vector<byte_t> data, service::ProtocolType t);
 
-      /// flush inbound and outbound traffic queues
+      /// queue an ip packet from the internet to be transmitted, rewriting it to our address
+      bool
+      QueueInboundTraffic(net::IPPacket pkt);
+
+      /// flush inbound and outbound traffic queues; downstream messages that are not full yet may
+      /// be held back a little for more packets, see HoldingDownstream
       bool
       Flush();
 
+      /// true if Flush held back packets, and should be called again within MaxPackDelay
+      bool
+      HoldingDownstream() const
+      {
+        return m_Downstream.Holding();
+      }
+
       /// queue outbound traffic
       /// does ip rewrite here
       bool
@@ -111,14 +128,13 @@ namespace llarp
       llarp::handlers::ExitEndpoint* m_Parent;
       llarp::PubKey m_remoteSignKey;
       llarp::path::HopHandler_ptr m_CurrentPath;
+      /// the path we had before m_CurrentPath, which the parent still finds us by
+      std::optional<llarp::PathID_t> m_PreviousPath;
       llarp::huint128_t m_IP;
       uint64_t m_TxRate, m_RxRate;
       llarp_time_t m_LastActive;
       bool m_RewriteSource;
-      using InboundTrafficQueue_t = std::deque<llarp::routing::TransferTrafficMessage>;
-      using TieredQueue = std::map<uint8_t, InboundTrafficQueue_t>;
-      // maps number of fragments the message will fit in to the queue for it
-      TieredQueue m_DownstreamQueues;
+      TrafficPacker m_Downstream{llarp::routing::ExitPackSize};
 
       struct UpstreamBuffer
       {
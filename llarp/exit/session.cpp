@@ -1,6 +1,8 @@
 #include "session.hpp"
 
+#include <llarp/config/config.hpp>
 #include <llarp/crypto/crypto.hpp>
+#include <llarp/ev/ev.hpp>
 #include <llarp/nodedb.hpp>
 #include <llarp/path/path_context.hpp>
 #include <llarp/path/path.hpp>
@@ -29,6 +31,8 @@ namespace llarp
         , m_Parent{parent}
     {
       CryptoManager::instance()->identity_keygen(m_ExitIdentity);
+      if (const auto conf = r->GetConfig())
+        m_Classifier = conf->network.m_TrafficClassifier;
     }
 
     BaseSession::~BaseSession() = default;
@@ -47,6 +51,8 @@ namespace llarp
       auto pub = m_ExitIdentity.toPublic();
       obj["exitIdentity"] = pub.ToString();
       obj["endpoint"] = m_ExitRouter.ToString();
+      obj["upstreamQueuedBytes"] = m_Upstream.QueuedBytes();
+      obj["upstreamBufferBytes"] = m_Upstream.BufferBytes();
       return obj;
     }
 
@@ -232,29 +238,10 @@ namespace llarp
     }
 
     bool
-    BaseSession::QueueUpstreamTraffic(
-        llarp::net::IPPacket pkt, const size_t N, service::ProtocolType t)
+    BaseSession::QueueUpstreamTraffic(llarp::net::IPPacket pkt, service::ProtocolType t)
     {
-      auto& queue = m_Upstream[pkt.size() / N];
-      // queue overflow
-      if (queue.size() >= MaxUpstreamQueueLength)
-        return false;
-      if (queue.size() == 0)
-      {
-        queue.emplace_back();
-        queue.back().protocol = t;
-        return queue.back().PutBuffer(llarp_buffer_t{pkt}, m_Counter++);
-      }
-      auto& back = queue.back();
-      // pack to nearest N
-      if (back.Size() + pkt.size() > N)
-      {
-        queue.emplace_back();
-        queue.back().protocol = t;
-        return queue.back().PutBuffer(llarp_buffer_t{pkt}, m_Counter++);
-      }
-      back.protocol = t;
-      return back.PutBuffer(llarp_buffer_t{pkt}, m_Counter++);
+      return m_Upstream.Put(
+          llarp_buffer_t{pkt}, m_Counter++, t, m_Classifier.Classify(pkt), m_router->Now());
     }
 
     bool
@@ -289,25 +276,28 @@ namespace llarp
       auto path = PickEstablishedPath(llarp::path::ePathRoleExit);
       if (path)
       {
-        for (auto& [i, queue] : m_Upstream)
+        m_Upstream.Flush(now, [this, &path](auto& msg) {
+          msg.S = path->NextSeqNo();
+          path->SendRoutingMessage(msg, m_router);
+        });
+        if (m_Upstream.Holding() and not m_UpstreamFlushPending)
         {
-          while (queue.size())
-          {
-            auto& msg = queue.front();
-            msg.S = path->NextSeqNo();
-            path->SendRoutingMessage(msg, m_router);
-            queue.pop_front();
-          }
+          m_UpstreamFlushPending = true;
+          m_router->loop()->call_later(MaxPackDelay, [self = weak_from_this()] {
+            if (auto ptr = self.lock())
+            {
+              ptr->m_UpstreamFlushPending = false;
+              ptr->FlushUpstream();
+            }
+          });
         }
       }
       else
       {
-        if (m_Upstream.size())
-          llarp::LogWarn("no path for exit session");
         // discard upstream
-        for (auto& [i, queue] : m_Upstream)
-          queue.clear();
-        m_Upstream.clear();
+        if (m_Upstream.Holding())
+          llarp::LogWarn("no path for exit session");
+        m_Upstream.Clear();
         if (numHops == 1)
         {
           auto r = m_router;
@@ -371,7 +361,7 @@ namespace llarp
       if (pkt.empty())
         return;
       pkt.ZeroAddresses();
-      QueueUpstreamTraffic(std::move(pkt), llarp::routing::ExitPadSize, t);
+      QueueUpstreamTraffic(std::move(pkt), t);
     }
 
     void
@@ -382,7 +372,7 @@ namespace llarp
         return;
 
       pkt.ZeroSourceAddress();
-      QueueUpstreamTraffic(std::move(pkt), llarp::routing::ExitPadSize, t);
+      QueueUpstreamTraffic(std::move(pkt), t);
     }
   }  // namespace exit
 }  // namespace llarp
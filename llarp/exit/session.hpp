@@ -1,12 +1,15 @@
 #pragma once
 
 #include "exit_messages.hpp"
+#include "traffic_packer.hpp"
 #include <llarp/service/protocol_type.hpp>
 #include <llarp/net/ip_packet.hpp>
+#include <llarp/net/traffic_class.hpp>
 #include <llarp/path/pathbuilder.hpp>
 #include <llarp/routing/transfer_traffic_message.hpp>
 #include <llarp/constants/path.hpp>
 
+#include <array>
 #include <deque>
 #include <queue>
 
@@ -33,8 +36,6 @@ namespace llarp
     struct BaseSession : public llarp::path::Builder,
                          public std::enable_shared_from_this<BaseSession>
     {
-      static constexpr size_t MaxUpstreamQueueLength = 256;
-
       BaseSession(
           const llarp::RouterID& exitRouter,
           std::function<bool(const llarp_buffer_t&)> writepkt,
@@ -90,10 +91,10 @@ namespace llarp
       HandlePathBuilt(llarp::path::Path_ptr p) override;
 
       bool
-      QueueUpstreamTraffic(
-          llarp::net::IPPacket pkt, const size_t packSize, service::ProtocolType t);
+      QueueUpstreamTraffic(llarp::net::IPPacket pkt, service::ProtocolType t);
 
-      /// flush upstream to exit via paths
+      /// flush upstream to exit via paths; messages that are not full yet may wait a little for
+      /// more packets, in which case we flush again once they are due
       bool
       FlushUpstream();
 
@@ -161,9 +162,10 @@ namespace llarp
      private:
       std::set<RouterID> m_SnodeBlacklist;
 
-      using UpstreamTrafficQueue_t = std::deque<llarp::routing::TransferTrafficMessage>;
-      using TieredQueue_t = std::map<uint8_t, UpstreamTrafficQueue_t>;
-      TieredQueue_t m_Upstream;
+      TrafficPacker m_Upstream{llarp::routing::ExitUpstreamPackSize};
+      /// whether a flush is already set to go off for what m_Upstream holds back
+      bool m_UpstreamFlushPending = false;
+      net::TrafficClassifier m_Classifier;
 
       PathID_t m_CurrentPath;
 
@@ -0,0 +1,102 @@
+#include "traffic_packer.hpp"
+
+namespace llarp::exit
+{
+  bool
+  TrafficPacker::Put(
+      const llarp_buffer_t& pkt,
+      uint64_t counter,
+      service::ProtocolType t,
+      net::TrafficClass klass,
+      llarp_time_t now)
+  {
+    if (pkt.sz > routing::MaxExitMTU or m_QueuedBytes + pkt.sz > MaxQueuedBytes)
+      return false;
+    auto& queue = m_Queues[static_cast<size_t>(klass)][pkt.sz / routing::ExitPadSize];
+    if (queue.msgs.empty() or queue.msgs.back().protocol != t
+        or queue.msgs.back().Size() + pkt.sz > m_PackSize)
+    {
+      auto& msg = queue.msgs.emplace_back(NextMessage());
+      msg.protocol = t;
+      msg.priority = net::LinkPriority(klass);
+      queue.openedAt = now;
+    }
+    auto& msg = queue.msgs.back();
+    const auto size = msg.Size();
+    const auto capacity = msg.Capacity();
+    if (not msg.PutBuffer(pkt, counter))
+      return false;
+    m_QueuedBytes += msg.Size() - size;
+    m_BufferBytes += msg.Capacity() - capacity;
+    queue.fed = true;
+    return true;
+  }
+
+  size_t
+  TrafficPacker::Flush(llarp_time_t now, const Send_t& send, bool all)
+  {
+    size_t sent = 0;
+    for (auto& tiers : m_Queues)
+    {
+      for (auto& [tier, queue] : tiers)
+      {
+        while (not queue.msgs.empty())
+        {
+          auto& msg = queue.msgs.front();
+          // the last message may have room for another packet its size: while they keep coming,
+          // give it a little longer to fill
+          const size_t room = (tier + 1) * routing::ExitPadSize + 2 * routing::ExitOverhead;
+          if (not all and queue.msgs.size() == 1 and queue.fed
+              and now - queue.openedAt < MaxPackDelay and msg.Size() + room <= m_PackSize)
+            break;
+          m_QueuedBytes -= msg.Size();
+          send(msg);
+          ++sent;
+          Recycle(std::move(msg));
+          queue.msgs.pop_front();
+        }
+        queue.fed = false;
+      }
+    }
+    return sent;
+  }
+
+  void
+  TrafficPacker::Clear()
+  {
+    for (auto& tiers : m_Queues)
+    {
+      for (auto& [tier, queue] : tiers)
+      {
+        for (auto& msg : queue.msgs)
+          Recycle(std::move(msg));
+        queue.msgs.clear();
+        queue.fed = false;
+      }
+    }
+    m_QueuedBytes = 0;
+  }
+
+  routing::TransferTrafficMessage
+  TrafficPacker::NextMessage()
+  {
+    if (m_Spare.empty())
+      return routing::TransferTrafficMessage{};
+    auto msg = std::move(m_Spare.back());
+    m_Spare.pop_back();
+    // clearing a message leaves it as the parser wants it, not as it goes out
+    msg.version = constants::proto_version;
+    msg.S = 0;
+    return msg;
+  }
+
+  void
+  TrafficPacker::Recycle(routing::TransferTrafficMessage msg)
+  {
+    msg.Clear();
+    if (m_Spare.size() < MaxSpare)
+      m_Spare.emplace_back(std::move(msg));
+    else
+      m_BufferBytes -= msg.Capacity();
+  }
+}  // namespace llarp::exit
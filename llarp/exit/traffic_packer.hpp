@@ -0,0 +1,100 @@
+#pragma once
+
+#include <llarp/net/traffic_class.hpp>
+#include <llarp/routing/transfer_traffic_message.hpp>
+#include <llarp/util/time.hpp>
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace llarp::exit
+{
+  /// the longest a packet waits in a message that is not full yet for more to go in with it
+  static constexpr auto MaxPackDelay = 5ms;
+
+  /// packs the packets of one exit session into as few TransferTrafficMessages as fit them.
+  /// packets of a class and about the same size go together, as many to a message as fit in
+  /// `packSize` bytes; a message goes out as soon as it is full, and one that is not is held back
+  /// for more only while packets are still coming for it, and never for longer than MaxPackDelay.
+  /// sent messages are kept, memory and all, for the next packets to go into.
+  class TrafficPacker
+  {
+   public:
+    using Send_t = std::function<void(routing::TransferTrafficMessage&)>;
+
+    /// how many sent messages we keep for reuse, at most
+    static constexpr size_t MaxSpare = 8;
+
+    explicit TrafficPacker(size_t packSize) : m_PackSize{packSize}
+    {}
+
+    /// puts a packet in the message it goes in; false if it is too big or we are holding too
+    /// many bytes for this session already
+    bool
+    Put(const llarp_buffer_t& pkt,
+        uint64_t counter,
+        service::ProtocolType t,
+        net::TrafficClass klass,
+        llarp_time_t now);
+
+    /// calls `send` on each message that is due, the more urgent classes first, and returns how
+    /// many it sent; with `all` set, messages that could still wait go too
+    size_t
+    Flush(llarp_time_t now, const Send_t& send, bool all = false);
+
+    /// drops every message not sent yet
+    void
+    Clear();
+
+    /// true if there are packets held back for later
+    bool
+    Holding() const
+    {
+      return m_QueuedBytes > 0;
+    }
+
+    /// bytes of packets put in, not yet sent
+    size_t
+    QueuedBytes() const
+    {
+      return m_QueuedBytes;
+    }
+
+    /// memory the messages of this session hold on to, queued and spare
+    size_t
+    BufferBytes() const
+    {
+      return m_BufferBytes;
+    }
+
+    /// the most packet bytes we hold for a session before refusing more
+    static constexpr size_t MaxQueuedBytes = 256 * routing::MaxExitMTU;
+
+   private:
+    struct Queue
+    {
+      /// full messages, then the one packets go into now
+      std::deque<routing::TransferTrafficMessage> msgs;
+      /// when the first packet of the last message went in
+      llarp_time_t openedAt = 0s;
+      /// whether packets went in since the last flush
+      bool fed = false;
+    };
+
+    routing::TransferTrafficMessage
+    NextMessage();
+
+    void
+    Recycle(routing::TransferTrafficMessage msg);
+
+    const size_t m_PackSize;
+    /// for each traffic class, by how big packets are
+    std::array<std::map<uint8_t, Queue>, net::NumTrafficClasses> m_Queues;
+    std::vector<routing::TransferTrafficMessage> m_Spare;
+    size_t m_QueuedBytes = 0;
+    size_t m_BufferBytes = 0;
+  };
+}  // namespace llarp::exit
@@ -6,6 +6,8 @@
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/util/str.hpp>
 #include <llarp/util/bits.hpp>
+#include <llarp/util/metrics.hpp>
+#include <llarp/util/trace.hpp>
 
 #include <llarp/quic/tunnel.hpp>
 #include <llarp/router/i_rc_lookup_handler.hpp>
@@ -17,6 +19,18 @@ namespace llarp
 {
   namespace handlers
   {
+    namespace
+    {
+      metrics::Counter inetPackets{
+          "lokinet_exit_inet_packets_total", "Packets from the internet for our exit sessions"};
+      metrics::Counter inetDropped{
+          "lokinet_exit_inet_dropped_total",
+          "Packets from the internet we had no working exit session for"};
+      metrics::Counter toInterface{
+          "lokinet_exit_outbound_packets_total", "Packets from exit sessions we sent on"};
+      metrics::Gauge activeExits{"lokinet_exit_sessions", "Exit sessions we are serving"};
+    }  // namespace
+
     ExitEndpoint::ExitEndpoint(std::string name, AbstractRouter* r)
         : m_Router(r), m_Name(std::move(name)), m_QUIC{std::make_shared<quic::TunnelManager>(*this)}
     {
@@ -45,14 +59,11 @@ namespace llarp
     std::optional<EndpointBase::AddressVariant_t>
     ExitEndpoint::GetEndpointWithConvoTag(service::ConvoTag tag) const
     {
-      for (const auto& [pathID, pk] : m_Paths)
-      {
-        if (pathID.as_array() == tag.as_array())
-          return RouterID{pk.as_array()};
-      }
+      const PathID_t pathID{tag.as_array()};
+      if (auto itr = m_Paths.find(pathID); itr != m_Paths.end())
+        return RouterID{itr->second->PubKey().as_array()};
       for (const auto& [rid, session] : m_SNodeSessions)
       {
-        PathID_t pathID{tag.as_array()};
         if (session->GetPathByID(pathID))
           return rid;
       }
@@ -238,10 +249,10 @@ namespace llarp
         }
         else
         {
-          auto itr = m_IPToKey.find(*ip);
-          if (itr != m_IPToKey.end() && m_SNodeKeys.find(itr->second) != m_SNodeKeys.end())
+          const auto* key = m_IPPool.KeyFor(*ip);
+          if (key && m_SNodeKeys.find(*key) != m_SNodeKeys.end())
           {
-            RouterID them = itr->second;
+            RouterID them = *key;
             msg.AddAReply(them.ToString());
           }
           else
@@ -309,7 +320,7 @@ namespace llarp
                     std::shared_ptr<exit::BaseSession> session) {
                   if (session && session->IsReady())
                   {
-                    msg->AddINReply(m_KeyToIP[pubKey], isV6);
+                    msg->AddINReply(m_IPPool.IPFor(pubKey).value_or(huint128_t{}), isV6);
                   }
                   else
                   {
@@ -322,10 +333,9 @@ namespace llarp
           else
           {
             // we have it mapped already as a service node
-            auto itr = m_KeyToIP.find(pubKey);
-            if (itr != m_KeyToIP.end())
+            if (auto maybe = m_IPPool.IPFor(pubKey))
             {
-              ip = itr->second;
+              ip = *maybe;
               msg.AddINReply(ip, isV6);
             }
             else  // fallback case that should never happen (probably)
@@ -372,78 +382,94 @@ namespace llarp
     void
     ExitEndpoint::Flush()
     {
-      while (not m_InetToNetwork.empty())
+      LLARP_TRACE(exit_flush, m_InetToNetwork.size(), m_ToInterface.size());
+      // packets to one address come in runs, so we look up where they go when the address changes
+      std::optional<huint128_t> lastDst;
+      const PubKey* pk = nullptr;
+      exit::Endpoint* endpoint = nullptr;
+      exit::SNodeSession* snode = nullptr;
+      inetPackets.Inc(m_InetToNetwork.size());
+      for (auto& pkt : m_InetToNetwork)
       {
-        auto& top = m_InetToNetwork.top();
-
-        // get a session by public key
-        std::optional<PubKey> maybe_pk;
-        {
-          auto itr = m_IPToKey.find(top.dstv6());
-          if (itr != m_IPToKey.end())
-            maybe_pk = itr->second;
-        }
-
-        auto buf = const_cast<net::IPPacket&>(top).steal();
-        m_InetToNetwork.pop();
-        // we have no session for public key so drop
-        if (not maybe_pk)
-          continue;  // we are in a while loop
-
-        const auto& pk = *maybe_pk;
-
-        // check if this key is a service node
-        if (m_SNodeKeys.count(pk))
+        if (const auto dst = pkt.dstv6(); dst != lastDst)
         {
-          // check if it's a service node session we made and queue it via our
-          // snode session that we made otherwise use an inbound session that
-          // was made by the other service node
-          auto itr = m_SNodeSessions.find(pk);
-          if (itr != m_SNodeSessions.end())
-          {
-            itr->second->SendPacketToRemote(std::move(buf), service::ProtocolType::TrafficV4);
-            // we are in a while loop
+          lastDst = dst;
+          endpoint = nullptr;
+          snode = nullptr;
+          // no one has this address, so there is no session to send it on
+          if ((pk = m_IPPool.KeyFor(dst)) == nullptr)
             continue;
+          // check if it's a service node session we made and queue it via our snode session
+          // that we made otherwise use an inbound session that was made by the other service
+          // node
+          if (m_SNodeKeys.count(*pk))
+          {
+            if (auto itr = m_SNodeSessions.find(*pk); itr != m_SNodeSessions.end())
+              snode = itr->second.get();
           }
-        }
-        auto tryFlushingTraffic =
-            [this, buf = std::move(buf), pk](exit::Endpoint* const ep) -> bool {
-          if (!ep->QueueInboundTraffic(buf, service::ProtocolType::TrafficV4))
+          if (auto itr = m_ActiveExits.find(*pk); itr != m_ActiveExits.end())
+            endpoint = itr->second.get();
+          if (snode == nullptr and endpoint == nullptr)
           {
-            LogWarn(
+            // we may have all dead sessions, wtf now?
+            static logging::RateLimit limit{1s};
+            LogWarnLimited(
+                limit,
                 Name(),
                 " dropped inbound traffic for session ",
-                pk,
-                " as we are overloaded (probably)");
-            // continue iteration
-            return true;
+                *pk,
+                " as we have no working endpoints");
           }
-          // break iteration
-          return false;
-        };
-        if (!VisitEndpointsFor(pk, tryFlushingTraffic))
+        }
+        if (snode)
+          snode->SendPacketToRemote(pkt.ConstBuffer(), service::ProtocolType::TrafficV4);
+        else if (not endpoint)
+          inetDropped.Inc();
+        else if (not endpoint->QueueInboundTraffic(std::move(pkt)))
         {
-          // we may have all dead sessions, wtf now?
-          LogWarn(
+          inetDropped.Inc();
+          static logging::RateLimit limit{1s};
+          LogWarnLimited(
+              limit,
               Name(),
               " dropped inbound traffic for session ",
-              pk,
-              " as we have no working endpoints");
+              *pk,
+              " as we are overloaded (probably)");
         }
       }
+      m_InetToNetwork.clear();
 
+      bool holding = false;
       for (auto& [pubkey, endpoint] : m_ActiveExits)
       {
         if (!endpoint->Flush())
         {
-          LogWarn("exit session with ", pubkey, " dropped packets");
+          static logging::RateLimit limit{1s};
+          LogWarnLimited(limit, "exit session with ", pubkey, " dropped packets");
         }
+        holding = holding or endpoint->HoldingDownstream();
+      }
+      // with no more io coming the ticker won't run again, so flush what we held back once it is
+      // due rather than whenever the next packet comes
+      if (holding and not m_FlushPending)
+      {
+        m_FlushPending = true;
+        m_Router->loop()->call_later(exit::MaxPackDelay, [this] {
+          m_FlushPending = false;
+          Flush();
+        });
       }
       for (auto& [id, session] : m_SNodeSessions)
       {
         session->FlushUpstream();
         session->FlushDownstream();
       }
+      if (m_NetIf and not m_ToInterface.empty())
+      {
+        toInterface.Inc(m_ToInterface.size());
+        m_NetIf->WritePackets(m_ToInterface);
+        m_ToInterface.clear();
+      }
     }
 
     bool
@@ -452,15 +478,16 @@ namespace llarp
       // map our address
       const PubKey us(m_Router->pubkey());
       const huint128_t ip = GetIfAddr();
-      m_KeyToIP[us] = ip;
-      m_IPToKey[ip] = us;
-      m_IPActivity[ip] = std::numeric_limits<llarp_time_t>::max();
+      m_IPPool.Assign(ip, us, GetRouter()->Now());
+      m_IPPool.Pin(ip);
       m_SNodeKeys.insert(us);
 
       if (m_ShouldInitTun)
       {
         vpn::InterfaceInfo info;
         info.ifname = m_ifname;
+        info.queues = m_TunQueues;
+        info.offload = m_TunOffload;
         info.addrs.emplace_back(m_OurRange);
 
         m_NetIf = GetRouter()->GetVPNPlatform()->CreateInterface(std::move(info), m_Router);
@@ -519,64 +546,44 @@ namespace llarp
     bool
     ExitEndpoint::HasLocalMappedAddrFor(const PubKey& pk) const
     {
-      return m_KeyToIP.find(pk) != m_KeyToIP.end();
+      return m_IPPool.HasKey(pk);
     }
 
     huint128_t
     ExitEndpoint::GetIPForIdent(const PubKey pk)
     {
       huint128_t found{};
-      if (!HasLocalMappedAddrFor(pk))
+      if (auto maybe = m_IPPool.IPFor(pk))
+        found = *maybe;
+      else
       {
         // allocate and map
-        found = AllocateNewAddress();
-        if (!m_KeyToIP.emplace(pk, found).second)
-        {
-          LogError(Name(), "failed to map ", pk, " to ", found);
-          return found;
-        }
-        if (!m_IPToKey.emplace(found, pk).second)
-        {
-          LogError(Name(), "failed to map ", found, " to ", pk);
-          return found;
-        }
+        found = AllocateNewAddress(pk);
         if (HasLocalMappedAddrFor(pk))
           LogInfo(Name(), " mapping ", pk, " to ", found);
         else
           LogError(Name(), "failed to map ", pk, " to ", found);
       }
-      else
-        found = m_KeyToIP[pk];
 
       MarkIPActive(found);
-      m_KeyToIP.rehash(0);
-      assert(HasLocalMappedAddrFor(pk));
       return found;
     }
 
     huint128_t
-    ExitEndpoint::AllocateNewAddress()
+    ExitEndpoint::AllocateNewAddress(const PubKey& pk)
     {
-      if (m_NextAddr < m_HigestAddr)
-        return ++m_NextAddr;
+      const auto now = GetRouter()->Now();
+      if (auto ip = m_IPPool.Allocate(pk, now))
+        return *ip;
 
-      // find oldest activity ip address
-      huint128_t found = {0};
-      llarp_time_t min = std::numeric_limits<llarp_time_t>::max();
-      for (const auto& [addr, time] : m_IPActivity)
+      // kick ident with the oldest activity off exit
+      // TODO: DoS
+      if (auto oldest = m_IPPool.LeastRecentlyActive())
       {
-        if (time < min)
-        {
-          found.h = addr.h;
-          min = time;
-        }
+        const PubKey old = *m_IPPool.KeyFor(*oldest);
+        KickIdentOffExit(old);
       }
-      // kick old ident off exit
-      // TODO: DoS
-      PubKey pk = m_IPToKey[found];
-      KickIdentOffExit(pk);
-
-      return found;
+      return m_IPPool.Allocate(pk, now).value_or(huint128_t{0});
     }
 
     EndpointBase::AddressVariant_t
@@ -624,9 +631,9 @@ namespace llarp
     ExitEndpoint::AllRemoteEndpoints() const
     {
       std::unordered_set<AddressVariant_t> remote;
-      for (const auto& [path, pubkey] : m_Paths)
+      for (const auto& [path, endpoint] : m_Paths)
       {
-        remote.insert(RouterID{pubkey});
+        remote.insert(RouterID{endpoint->PubKey()});
       }
       return remote;
     }
@@ -634,16 +641,19 @@ namespace llarp
     bool
     ExitEndpoint::QueueOutboundTraffic(net::IPPacket pkt)
     {
-      return m_NetIf && m_NetIf->WritePacket(std::move(pkt));
+      if (not m_NetIf)
+        return false;
+      // written at the end of Flush, in one batch
+      m_ToInterface.emplace_back(std::move(pkt));
+      return true;
     }
 
     void
     ExitEndpoint::KickIdentOffExit(const PubKey& pk)
     {
       LogInfo(Name(), " kicking ", pk, " off exit");
-      huint128_t ip = m_KeyToIP[pk];
-      m_KeyToIP.erase(pk);
-      m_IPToKey.erase(ip);
+      if (auto ip = m_IPPool.IPFor(pk))
+        m_IPPool.Release(*ip);
       for (auto [exit_itr, end] = m_ActiveExits.equal_range(pk); exit_itr != end;)
         exit_itr = m_ActiveExits.erase(exit_itr);
     }
@@ -651,13 +661,13 @@ namespace llarp
     void
     ExitEndpoint::MarkIPActive(huint128_t ip)
     {
-      m_IPActivity[ip] = GetRouter()->Now();
+      m_IPPool.MarkActive(ip, GetRouter()->Now());
     }
 
     void
     ExitEndpoint::OnInetPacket(net::IPPacket pkt)
     {
-      m_InetToNetwork.emplace(std::move(pkt));
+      m_InetToNetwork.emplace_back(std::move(pkt));
     }
 
     bool
@@ -677,28 +687,16 @@ namespace llarp
     exit::Endpoint*
     ExitEndpoint::FindEndpointByPath(const PathID_t& path)
     {
-      exit::Endpoint* endpoint = nullptr;
-      PubKey pk;
       if (auto itr = m_Paths.find(path); itr != m_Paths.end())
-        pk = itr->second;
-      else
-        return nullptr;
-      if (auto itr = m_ActiveExits.find(pk); itr != m_ActiveExits.end())
-      {
-        if (itr->second->PubKey() == pk)
-          endpoint = itr->second.get();
-      }
-      return endpoint;
+        return itr->second;
+      return nullptr;
     }
 
     bool
-    ExitEndpoint::UpdateEndpointPath(const PubKey& remote, const PathID_t& next)
+    ExitEndpoint::UpdateEndpointPath(exit::Endpoint* ep, const PathID_t& next)
     {
       // check if already mapped
-      if (auto itr = m_Paths.find(next); itr != m_Paths.end())
-        return false;
-      m_Paths.emplace(next, remote);
-      return true;
+      return m_Paths.emplace(next, ep).second;
     }
 
     void
@@ -728,6 +726,7 @@ namespace llarp
         m_ShouldInitTun = false;
       }
 
+      m_TrafficClassifier = networkConfig.m_TrafficClassifier;
       m_OurRange = networkConfig.m_ifaddr;
       if (!m_OurRange.addr.h)
       {
@@ -739,11 +738,12 @@ namespace llarp
       const auto host_str = m_OurRange.BaseAddressString();
       // string, or just a plain char array?
       m_IfAddr = m_OurRange.addr;
-      m_NextAddr = m_IfAddr;
-      m_HigestAddr = m_OurRange.HighestAddr();
+      m_IPPool = {m_IfAddr, m_OurRange.HighestAddr()};
       m_UseV6 = not m_OurRange.IsV4();
 
       m_ifname = networkConfig.m_ifname;
+      m_TunQueues = networkConfig.m_TunQueues;
+      m_TunOffload = networkConfig.m_TunOffload;
       if (m_ifname.empty())
       {
         const auto maybe = m_Router->Net().FindFreeTun();
@@ -760,6 +760,23 @@ namespace llarp
       }
     }
 
+    void
+    ExitEndpoint::Reconfigure(const NetworkConfig& networkConfig, const DnsConfig& dnsConfig)
+    {
+      m_TrafficClassifier = networkConfig.m_TrafficClassifier;
+
+      if (m_Resolver and dnsConfig.m_upstreamDNS != m_DNSConf.m_upstreamDNS)
+      {
+        LogInfo(Name(), " reloading upstream dns servers");
+        for (auto weak : m_Resolver->GetAllResolvers())
+        {
+          if (auto ptr = weak.lock())
+            ptr->ResetResolver(dnsConfig.m_upstreamDNS);
+        }
+      }
+      m_DNSConf.m_upstreamDNS = dnsConfig.m_upstreamDNS;
+    }
+
     huint128_t
     ExitEndpoint::ObtainServiceNodeIP(const RouterID& other)
     {
@@ -808,10 +825,9 @@ namespace llarp
         // mark it as such so we don't make an outbound session to them
         m_SNodeKeys.emplace(pk.as_array());
       }
-      m_ActiveExits.emplace(
-          pk, std::make_unique<exit::Endpoint>(pk, handler, !wantInternet, ip, this));
-
-      m_Paths[path] = pk;
+      auto endpoint = std::make_unique<exit::Endpoint>(pk, handler, !wantInternet, ip, this);
+      m_Paths[path] = endpoint.get();
+      m_ActiveExits.emplace(pk, std::move(endpoint));
 
       return HasLocalMappedAddrFor(pk);
     }
@@ -823,9 +839,11 @@ namespace llarp
     }
 
     void
-    ExitEndpoint::DelEndpointInfo(const PathID_t& path)
+    ExitEndpoint::DelEndpointInfo(const PathID_t& path, const exit::Endpoint* ep)
     {
-      m_Paths.erase(path);
+      // the path may have been given to a session made on it since
+      if (auto itr = m_Paths.find(path); itr != m_Paths.end() and itr->second == ep)
+        m_Paths.erase(itr);
     }
 
     void
@@ -868,6 +886,7 @@ namespace llarp
           else
             ++itr;
         }
+        activeExits.Set(m_ActiveExits.size());
         // pick chosen exits and tick
         m_ChosenExits.clear();
         itr = m_ActiveExits.begin();
@@ -3,6 +3,7 @@
 #include <llarp/exit/endpoint.hpp>
 #include "tun.hpp"
 #include <llarp/dns/server.hpp>
+#include <llarp/net/ip_pool.hpp>
 #include <unordered_map>
 
 namespace llarp
@@ -72,6 +73,10 @@ namespace llarp
       void
       Configure(const NetworkConfig& networkConfig, const DnsConfig& dnsConfig);
 
+      /// apply a reloaded config's traffic classes and upstream dns, keeping our sessions
+      void
+      Reconfigure(const NetworkConfig& networkConfig, const DnsConfig& dnsConfig);
+
       std::string
       Name() const;
 
@@ -84,6 +89,13 @@ namespace llarp
       bool
       SupportsV6() const;
 
+      /// what our exit sessions put traffic to their users in classes by
+      const net::TrafficClassifier&
+      Classifier() const
+      {
+        return m_TrafficClassifier;
+      }
+
       bool
       ShouldHookDNSMessage(const dns::Message& msg) const;
 
@@ -105,8 +117,9 @@ namespace llarp
       exit::Endpoint*
       FindEndpointByIP(huint32_t ip);
 
+      /// make next a path ep can be found by as well; false if it is taken
       bool
-      UpdateEndpointPath(const PubKey& remote, const PathID_t& next);
+      UpdateEndpointPath(exit::Endpoint* ep, const PathID_t& next);
 
       /// handle ip packet from outside
       void
@@ -131,7 +144,7 @@ namespace llarp
 
       /// DO NOT CALL ME
       void
-      DelEndpointInfo(const PathID_t& path);
+      DelEndpointInfo(const PathID_t& path, const exit::Endpoint* ep);
 
       /// DO NOT CALL ME
       void
@@ -175,8 +188,10 @@ namespace llarp
       ObtainSNodeSession(const RouterID& router, exit::SessionReadyFunc obtainCb);
 
      private:
+      /// give pk an address, kicking whoever was least recently active off the exit for it once
+      /// our range is full
       huint128_t
-      AllocateNewAddress();
+      AllocateNewAddress(const PubKey& pk);
 
       /// obtain ip for service node session, creates a new session if one does
       /// not existing already
@@ -197,16 +212,14 @@ namespace llarp
       bool m_ShouldInitTun;
       std::string m_Name;
       bool m_PermitExit;
-      std::unordered_map<PathID_t, PubKey> m_Paths;
+      net::TrafficClassifier m_TrafficClassifier;
+      /// the exit session each path belongs to, so traffic on a path finds it in one lookup
+      std::unordered_map<PathID_t, exit::Endpoint*> m_Paths;
 
       std::unordered_map<PubKey, exit::Endpoint*> m_ChosenExits;
 
       std::unordered_multimap<PubKey, std::unique_ptr<exit::Endpoint>> m_ActiveExits;
 
-      using KeyMap_t = std::unordered_map<PubKey, huint128_t>;
-
-      KeyMap_t m_KeyToIP;
-
       using SNodes_t = std::set<PubKey>;
       /// set of pubkeys we treat as snodes
       SNodes_t m_SNodeKeys;
@@ -215,16 +228,14 @@ namespace llarp
       /// snode sessions we are talking to directly
       SNodeSessions_t m_SNodeSessions;
 
-      std::unordered_map<huint128_t, PubKey> m_IPToKey;
+      /// the addresses of our range we gave out, who has each, and when they were last active
+      net::IPPool<PubKey> m_IPPool;
 
       huint128_t m_IfAddr;
-      huint128_t m_HigestAddr;
-
-      huint128_t m_NextAddr;
       IPRange m_OurRange;
       std::string m_ifname;
-
-      std::unordered_map<huint128_t, llarp_time_t> m_IPActivity;
+      size_t m_TunQueues = 1;
+      bool m_TunOffload = false;
 
       std::shared_ptr<vpn::NetworkInterface> m_NetIf;
 
@@ -233,11 +244,12 @@ namespace llarp
 
       std::shared_ptr<quic::TunnelManager> m_QUIC;
 
-      using PacketQueue_t = std::
-          priority_queue<net::IPPacket, std::vector<net::IPPacket>, net::IPPacket::CompareOrder>;
-
-      /// internet to llarp packet queue
-      PacketQueue_t m_InetToNetwork;
+      /// internet to llarp packets in the order they came in, sent on at the start of Flush
+      std::vector<net::IPPacket> m_InetToNetwork;
+      /// llarp to internet packets, written to the interface at the end of Flush
+      std::vector<net::IPPacket> m_ToInterface;
+      /// whether a Flush is already set to go off for what the exits hold back
+      bool m_FlushPending = false;
       bool m_UseV6;
       DnsConfig m_DNSConf;
     };
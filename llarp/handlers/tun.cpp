@@ -8,7 +8,9 @@
 #include <netdb.h>
 #endif
 
+#include <llarp/dns/cache.hpp>
 #include <llarp/dns/dns.hpp>
+#include <llarp/dns/wire.hpp>
 #include <llarp/ev/ev.hpp>
 #include <llarp/net/net.hpp>
 #include <llarp/router/abstractrouter.hpp>
@@ -24,6 +26,7 @@
 #include <llarp/quic/tunnel.hpp>
 #include <llarp/rpc/endpoint_rpc.hpp>
 #include <llarp/util/str.hpp>
+#include <llarp/util/trace.hpp>
 #include <llarp/util/logging/buffer.hpp>
 #include <llarp/dns/srv_data.hpp>
 #include <llarp/constants/net.hpp>
@@ -37,6 +40,10 @@ namespace llarp
   {
     static auto logcat = log::Cat("tun");
 
+    /// how long queries may wait on a lookup someone else asked for before we look it up again;
+    /// every dns client has given up on it by then
+    static constexpr auto DNSFollowTimeout = 10s;
+
     bool
     TunEndpoint::MaybeHookDNS(
         std::shared_ptr<dns::PacketSource_Base> source,
@@ -48,10 +55,52 @@ namespace llarp
         return false;
 
       auto job = std::make_shared<dns::QueryJob>(source, query, to, from);
-      if (HandleHookedDNSMessage(query, [job](auto msg) { job->SendReply(msg.ToBuffer()); }))
+      const auto key = dns::AnswerCache::Key(query);
+      const auto now = Now();
+      // when we are already looking this up, wait for that instead of looking it up again
+      if (key)
+      {
+        if (auto itr = m_PendingDNS.find(*key);
+            itr != m_PendingDNS.end() and now - itr->second->started < DNSFollowTimeout)
+        {
+          log::trace(logcat, "dns query from {} follows the same lookup in flight", from);
+          itr->second->jobs.push_back(std::move(job));
+          return true;
+        }
+      }
+
+      auto pending = std::make_shared<PendingDNS>();
+      pending->started = now;
+      pending->jobs.push_back(std::move(job));
+      if (key)
+        m_PendingDNS[*key] = pending;
+      // the lookup is done, so no one else may wait on it
+      auto take = [this, key, pending] {
+        if (key)
+        {
+          auto itr = m_PendingDNS.find(*key);
+          if (itr != m_PendingDNS.end() and itr->second == pending)
+            m_PendingDNS.erase(itr);
+        }
+        return std::exchange(pending->jobs, {});
+      };
+
+      auto reply = [take](dns::Message msg) {
+        const auto buf = msg.ToBuffer();
+        for (const auto& job : take())
+        {
+          OwnedBuffer copy{buf.buf.get(), buf.sz};
+          dns::ReplyAs(job->Underlying(), copy.buf.get(), copy.sz);
+          job->SendReply(std::move(copy));
+        }
+      };
+      if (HandleHookedDNSMessage(query, std::move(reply)))
         Router()->TriggerPump();
       else
-        job->Cancel();
+      {
+        for (const auto& job : take())
+          job->Cancel();
+      }
       return true;
     }
 
@@ -136,7 +185,9 @@ namespace llarp
       {
         auto ptr = std::make_shared<DnsInterceptor>(
             [ep = m_Endpoint](auto pkt) {
-              ep->HandleWriteIPPacket(pkt.ConstBuffer(), pkt.srcv6(), pkt.dstv6(), 0);
+              const auto src = pkt.srcv6();
+              const auto dst = pkt.dstv6();
+              ep->HandleWriteIPPacket(std::move(pkt), src, dst);
             },
             m_OurIP,
             conf);
@@ -235,23 +286,20 @@ namespace llarp
         obj["localResolver"] = localRes[0];
 
       util::StatusObject ips{};
-      for (const auto& item : m_IPActivity)
-      {
-        util::StatusObject ipObj{{"lastActive", to_json(item.second)}};
+      m_IPPool.ForEach([&](huint128_t ip, const AlignedBuffer<32>& addr, llarp_time_t active) {
+        util::StatusObject ipObj{{"lastActive", to_json(active)}};
         std::string remoteStr;
-        AlignedBuffer<32> addr = m_IPToAddr.at(item.first);
         if (m_SNodes.at(addr))
           remoteStr = RouterID(addr.as_array()).ToString();
         else
           remoteStr = service::Address(addr.as_array()).ToString();
         ipObj["remote"] = remoteStr;
-        std::string ipaddr = item.first.ToString();
-        ips[ipaddr] = ipObj;
-      }
+        ips[ip.ToString()] = ipObj;
+      });
       obj["addrs"] = ips;
       obj["ourIP"] = m_OurIP.ToString();
-      obj["nextIP"] = m_NextIP.ToString();
-      obj["maxIP"] = m_MaxIP.ToString();
+      obj["nextIP"] = m_IPPool.Next().ToString();
+      obj["maxIP"] = m_IPPool.Highest().ToString();
       return obj;
     }
 
@@ -289,31 +337,12 @@ namespace llarp
         LogInfo(Name(), " setting to be not reachable by default");
       }
 
-      if (conf.m_AuthType == service::AuthType::eAuthTypeFile)
-      {
-        m_AuthPolicy = service::MakeFileAuthPolicy(m_router, conf.m_AuthFiles, conf.m_AuthFileType);
-      }
-      else if (conf.m_AuthType != service::AuthType::eAuthTypeNone)
-      {
-        std::string url, method;
-        if (conf.m_AuthUrl.has_value() and conf.m_AuthMethod.has_value())
-        {
-          url = *conf.m_AuthUrl;
-          method = *conf.m_AuthMethod;
-        }
-        auto auth = std::make_shared<rpc::EndpointAuthRPC>(
-            url,
-            method,
-            conf.m_AuthWhitelist,
-            conf.m_AuthStaticTokens,
-            Router()->lmq(),
-            shared_from_this());
-        auth->Start();
-        m_AuthPolicy = std::move(auth);
-      }
+      ConfigureAuth(conf);
 
       m_DnsConfig = dnsConf;
       m_TrafficPolicy = conf.m_TrafficPolicy;
+      if (m_TrafficPolicy)
+        m_CompiledTrafficPolicy = net::CompiledTrafficPolicy{*m_TrafficPolicy};
       m_OwnedRanges = conf.m_OwnedRanges;
 
       m_BaseV6Address = conf.m_baseV6Address;
@@ -325,13 +354,19 @@ namespace llarp
       else
         m_PathAlignmentTimeout = service::Endpoint::PathAlignmentTimeout();
 
-      for (const auto& item : conf.m_mapAddrs)
+      m_IfName = conf.m_ifname;
+      m_TunQueues = conf.m_TunQueues;
+      m_TunOffload = conf.m_TunOffload;
+      if (conf.m_FQCoDelRate)
       {
-        if (not MapAddress(item.second, item.first, false))
-          return false;
+        net::FairQueue::Config queue{};
+        queue.target = conf.m_FQCoDelTarget;
+        queue.interval = conf.m_FQCoDelInterval;
+        m_UserQueue = net::FairQueue{queue};
+        // 20ms worth, and never less than a couple of full packets
+        const uint64_t rate = conf.m_FQCoDelRate * 1000 / 8;
+        m_UserQueueBucket = util::TokenBucket{rate, std::max<uint64_t>(rate / 50, 2 * 1514)};
       }
-
-      m_IfName = conf.m_ifname;
       if (m_IfName.empty())
       {
         const auto maybe = m_router->Net().FindFreeTun();
@@ -353,6 +388,15 @@ namespace llarp
 
       m_OurIP = m_OurRange.addr;
       m_UseV6 = false;
+      // the highest address of the range is left out, as it always has been
+      m_IPPool = {m_OurIP, m_OurRange.HighestAddr() - huint128_t{uint128_t{1}}};
+      llarp::LogInfo(Name(), " allocating up to ", m_IPPool.Highest(), " on range ", m_OurRange);
+
+      for (const auto& item : conf.m_mapAddrs)
+      {
+        if (not MapAddress(item.second, item.first, false))
+          return false;
+      }
 
       m_PersistAddrMapFile = conf.m_AddrMapPersistFile;
       if (m_PersistAddrMapFile)
@@ -432,22 +476,20 @@ namespace llarp
               }
               if (const auto* loki = std::get_if<service::Address>(&addr))
               {
-                m_IPToAddr.emplace(ip, loki->data());
-                m_AddrToIP.emplace(loki->data(), ip);
-                m_SNodes[*loki] = false;
-                LogInfo(Name(), " remapped ", ip, " to ", *loki);
+                if (m_IPPool.Assign(ip, *loki, Now()))
+                {
+                  m_SNodes[*loki] = false;
+                  LogInfo(Name(), " remapped ", ip, " to ", *loki);
+                }
               }
               if (const auto* snode = std::get_if<RouterID>(&addr))
               {
-                m_IPToAddr.emplace(ip, snode->data());
-                m_AddrToIP.emplace(snode->data(), ip);
-                m_SNodes[*snode] = true;
-                LogInfo(Name(), " remapped ", ip, " to ", *snode);
+                if (m_IPPool.Assign(ip, *snode, Now()))
+                {
+                  m_SNodes[*snode] = true;
+                  LogInfo(Name(), " remapped ", ip, " to ", *snode);
+                }
               }
-              if (m_NextIP < ip)
-                m_NextIP = ip;
-              // make sure we dont unmap this guy
-              MarkIPActive(ip);
             }
           }
         }
@@ -467,23 +509,102 @@ namespace llarp
       return Endpoint::Configure(conf, dnsConf);
     }
 
+    void
+    TunEndpoint::ConfigureAuth(const NetworkConfig& conf)
+    {
+      if (conf.m_AuthType == service::AuthType::eAuthTypeFile)
+      {
+        m_AuthPolicy = service::MakeCachedAuthPolicy(
+            m_router,
+            service::MakeFileAuthPolicy(m_router, conf.m_AuthFiles, conf.m_AuthFileType),
+            conf.m_AuthCacheTTL);
+      }
+      else if (conf.m_AuthType != service::AuthType::eAuthTypeNone)
+      {
+        std::string url, method;
+        if (conf.m_AuthUrl.has_value() and conf.m_AuthMethod.has_value())
+        {
+          url = *conf.m_AuthUrl;
+          method = *conf.m_AuthMethod;
+        }
+        auto auth = std::make_shared<rpc::EndpointAuthRPC>(
+            url,
+            method,
+            conf.m_AuthWhitelist,
+            conf.m_AuthStaticTokens,
+            Router()->lmq(),
+            shared_from_this());
+        auth->Start();
+        m_AuthPolicy =
+            service::MakeCachedAuthPolicy(m_router, std::move(auth), conf.m_AuthCacheTTL);
+      }
+      else
+        m_AuthPolicy = nullptr;
+    }
+
+    void
+    TunEndpoint::Reconfigure(
+        const NetworkConfig& was, const NetworkConfig& conf, const DnsConfig& dnsConf)
+    {
+      Endpoint::Reconfigure(was, conf, dnsConf);
+
+      m_PublishIntroSet = conf.m_reachable;
+
+      // sessions already authed stay up; only new ones go through the new policy.  auth files
+      // are read again even if the names are the same, as it is their contents that change, and
+      // the new policy starts with nothing cached, so tokens taken out of them stop working now.
+      if (conf.m_AuthType == service::AuthType::eAuthTypeFile or conf.m_AuthType != was.m_AuthType
+          or conf.m_AuthFileType != was.m_AuthFileType or conf.m_AuthUrl != was.m_AuthUrl
+          or conf.m_AuthMethod != was.m_AuthMethod or conf.m_AuthWhitelist != was.m_AuthWhitelist
+          or conf.m_AuthStaticTokens != was.m_AuthStaticTokens
+          or conf.m_AuthCacheTTL != was.m_AuthCacheTTL)
+      {
+        LogInfo(Name(), " reloading auth policy");
+        ConfigureAuth(conf);
+      }
+
+      m_TrafficPolicy = conf.m_TrafficPolicy;
+      m_CompiledTrafficPolicy = m_TrafficPolicy ? net::CompiledTrafficPolicy{*m_TrafficPolicy}
+                                                : net::CompiledTrafficPolicy{};
+      if (m_OwnedRanges != conf.m_OwnedRanges)
+      {
+        m_OwnedRanges = conf.m_OwnedRanges;
+        ScheduleIntrosetRegen();
+      }
+
+      for (const auto& [ip, addr] : conf.m_mapAddrs)
+      {
+        if (auto itr = was.m_mapAddrs.find(ip); itr == was.m_mapAddrs.end() or itr->second != addr)
+          MapAddress(addr, ip, false);
+      }
+
+      // swap the upstreams under the running resolvers, keeping their caches and binds
+      if (dnsConf.m_upstreamDNS != m_DnsConfig.m_upstreamDNS)
+      {
+        LogInfo(Name(), " reloading upstream dns servers");
+        ReconfigureDNS(dnsConf.m_upstreamDNS);
+      }
+      m_DnsConfig.m_upstreamDNS = dnsConf.m_upstreamDNS;
+    }
+
     bool
     TunEndpoint::HasLocalIP(const huint128_t& ip) const
     {
-      return m_IPToAddr.find(ip) != m_IPToAddr.end();
+      return m_IPPool.InUse(ip);
     }
 
     void
     TunEndpoint::Pump(llarp_time_t now)
     {
-      // flush network to user
-      while (not m_NetworkToUserPktQueue.empty())
+      service::Endpoint::Pump(now);
+      DrainUserQueue();
+
+      // flush network to user, in one batch, including what the pump just delivered
+      if (not m_UserPacketBatch.empty())
       {
-        m_NetIf->WritePacket(m_NetworkToUserPktQueue.top().pkt);
-        m_NetworkToUserPktQueue.pop();
+        m_NetIf->WritePackets(m_UserPacketBatch);
+        m_UserPacketBatch.clear();
       }
-
-      service::Endpoint::Pump(now);
     }
 
     static bool
@@ -511,13 +632,13 @@ namespace llarp
     std::optional<std::variant<service::Address, RouterID>>
     TunEndpoint::ObtainAddrForIP(huint128_t ip) const
     {
-      auto itr = m_IPToAddr.find(ip);
-      if (itr == m_IPToAddr.end())
+      const auto* addr = m_IPPool.KeyFor(ip);
+      if (not addr)
         return std::nullopt;
-      if (m_SNodes.at(itr->second))
-        return RouterID{itr->second.as_array()};
+      if (m_SNodes.at(*addr))
+        return RouterID{addr->as_array()};
       else
-        return service::Address{itr->second.as_array()};
+        return service::Address{addr->as_array()};
     }
 
     bool
@@ -950,17 +1071,19 @@ namespace llarp
     bool
     TunEndpoint::MapAddress(const service::Address& addr, huint128_t ip, bool SNode)
     {
-      auto itr = m_IPToAddr.find(ip);
-      if (itr != m_IPToAddr.end())
+      if (const auto* mapped = m_IPPool.KeyFor(ip))
+      {
+        llarp::LogWarn(ip, " already mapped to ", service::Address(mapped->as_array()).ToString());
+        return false;
+      }
+      if (not m_IPPool.Assign(ip, addr, Now()))
       {
         llarp::LogWarn(
-            ip, " already mapped to ", service::Address(itr->second.as_array()).ToString());
+            Name(), " cannot map ", addr.ToString(), " to ", ip, ", not in ", m_OurRange);
         return false;
       }
       llarp::LogInfo(Name() + " map ", addr.ToString(), " to ", ip);
 
-      m_IPToAddr[ip] = addr;
-      m_AddrToIP[addr] = ip;
       m_SNodes[addr] = SNode;
       MarkIPActiveForever(ip);
       MarkAddressOutbound(addr);
@@ -995,10 +1118,7 @@ namespace llarp
     bool
     TunEndpoint::SetupTun()
     {
-      m_NextIP = m_OurIP;
-      m_MaxIP = m_OurRange.HighestAddr();
       llarp::LogInfo(Name(), " set ", m_IfName, " to have address ", m_OurIP);
-      llarp::LogInfo(Name(), " allocated up to ", m_MaxIP, " on range ", m_OurRange);
 
       const service::Address ourAddr = m_Identity.pub.Addr();
 
@@ -1019,6 +1139,8 @@ namespace llarp
       }
 
       info.ifname = m_IfName;
+      info.queues = m_TunQueues;
+      info.offload = m_TunOffload;
 
       LogInfo(Name(), " setting up network...");
 
@@ -1107,15 +1229,14 @@ namespace llarp
         if (auto maybe = util::OpenFileStream<fs::ofstream>(file, std::ios_base::binary))
         {
           std::map<std::string, std::string> addrmap;
-          for (const auto& [ip, addr] : m_IPToAddr)
-          {
+          m_IPPool.ForEach([&](huint128_t ip, const AlignedBuffer<32>& addr, llarp_time_t) {
             if (not m_SNodes.at(addr))
             {
               const service::Address a{addr.as_array()};
               if (HasInboundConvo(a))
                 addrmap[ip.ToString()] = a.ToString();
             }
-          }
+          });
           const auto data = oxenc::bt_serialize(addrmap);
           maybe->write(data.data(), data.size());
         }
@@ -1165,6 +1286,44 @@ namespace llarp
 
     void
     TunEndpoint::HandleGotUserPacket(net::IPPacket pkt)
+    {
+      LLARP_TRACE(tun_user_packet, pkt.size());
+      if (m_UserQueueBucket.Unlimited())
+      {
+        SendUserPacket(std::move(pkt));
+        return;
+      }
+      m_UserQueue.Enqueue(std::move(pkt), Now());
+      DrainUserQueue();
+    }
+
+    void
+    TunEndpoint::DrainUserQueue()
+    {
+      const auto now = Now();
+      while (not m_UserQueue.Empty() and m_UserQueueBucket.Ready(now))
+      {
+        auto pkt = m_UserQueue.Dequeue(now);
+        if (not pkt)
+          break;
+        m_UserQueueBucket.Consume(pkt->size());
+        SendUserPacket(std::move(*pkt));
+      }
+      if (m_UserQueue.Empty() or m_UserQueueDrainPending)
+        return;
+      // the clock only goes a millisecond at a time, so that is as often as tokens come in
+      m_UserQueueDrainPending = true;
+      Loop()->call_later(1ms, [weak = weak_from_this()]() {
+        if (auto self = weak.lock())
+        {
+          self->m_UserQueueDrainPending = false;
+          self->DrainUserQueue();
+        }
+      });
+    }
+
+    void
+    TunEndpoint::SendUserPacket(net::IPPacket pkt)
     {
       huint128_t dst, src;
       if (pkt.IsV4())
@@ -1182,7 +1341,7 @@ namespace llarp
       {
         if (dst == m_OurIP)
         {
-          HandleWriteIPPacket(pkt.ConstBuffer(), src, dst, 0);
+          HandleWriteIPPacket(std::move(pkt), src, dst);
           return;
         }
       }
@@ -1191,8 +1350,8 @@ namespace llarp
       {
         dst = net::ExpandV4(net::TruncateV6(dst));
       }
-      auto itr = m_IPToAddr.find(dst);
-      if (itr == m_IPToAddr.end())
+      const auto* remote = m_IPPool.KeyFor(dst);
+      if (not remote)
       {
         service::Address addr{};
 
@@ -1201,8 +1360,8 @@ namespace llarp
         else
         {
           // send icmp unreachable as we dont have any exits for this ip
-          if (const auto icmp = pkt.MakeICMPUnreachable())
-            HandleWriteIPPacket(icmp->ConstBuffer(), dst, src, 0);
+          if (auto icmp = pkt.MakeICMPUnreachable())
+            HandleWriteIPPacket(std::move(*icmp), dst, src);
 
           return;
         }
@@ -1231,14 +1390,14 @@ namespace llarp
       }
       std::variant<service::Address, RouterID> to;
       service::ProtocolType type;
-      if (m_SNodes.at(itr->second))
+      if (m_SNodes.at(*remote))
       {
-        to = RouterID{itr->second.as_array()};
+        to = RouterID{remote->as_array()};
         type = service::ProtocolType::TrafficV4;
       }
       else
       {
-        to = service::Address{itr->second.as_array()};
+        to = service::Address{remote->as_array()};
         type = m_state->m_ExitEnabled and src != m_OurIP ? service::ProtocolType::Exit
                                                          : pkt.ServiceProtocol();
       }
@@ -1297,13 +1456,7 @@ namespace llarp
     bool
     TunEndpoint::ShouldAllowTraffic(const net::IPPacket& pkt) const
     {
-      if (const auto exitPolicy = GetExitPolicy())
-      {
-        if (not exitPolicy->AllowsTraffic(pkt))
-          return false;
-      }
-
-      return true;
+      return m_CompiledTrafficPolicy.AllowsTraffic(pkt);
     }
 
     bool
@@ -1311,7 +1464,7 @@ namespace llarp
         const service::ConvoTag tag,
         const llarp_buffer_t& buf,
         service::ProtocolType t,
-        uint64_t seqno)
+        uint64_t /*seqno*/)
     {
       LogTrace("Inbound ", t, " packet (", buf.sz, "B) on convo ", tag);
       if (t == service::ProtocolType::QUIC)
@@ -1409,23 +1562,15 @@ namespace llarp
         src = ObtainIPForAddr(addr);
         dst = m_OurIP;
       }
-      HandleWriteIPPacket(buf, src, dst, seqno);
+      HandleWriteIPPacket(std::move(pkt), src, dst);
       return true;
     }
 
     bool
-    TunEndpoint::HandleWriteIPPacket(
-        const llarp_buffer_t& b, huint128_t src, huint128_t dst, uint64_t seqno)
+    TunEndpoint::HandleWriteIPPacket(net::IPPacket pkt, huint128_t src, huint128_t dst)
     {
-      ManagedBuffer buf(b);
-      WritePacket write;
-      write.seqno = seqno;
-      auto& pkt = write.pkt;
-      // load
-      if (!pkt.Load(buf))
-      {
+      if (pkt.empty())
         return false;
-      }
       if (pkt.IsV4())
       {
         pkt.UpdateIPv4Address(xhtonl(net::TruncateV6(src)), xhtonl(net::TruncateV6(dst)));
@@ -1434,7 +1579,7 @@ namespace llarp
       {
         pkt.UpdateIPv6Address(src, dst);
       }
-      m_NetworkToUserPktQueue.push(std::move(write));
+      m_UserPacketBatch.emplace_back(std::move(pkt));
       // wake up so we ensure that all packets are written to user
       Router()->TriggerPump();
       return true;
@@ -1450,7 +1595,6 @@ namespace llarp
     TunEndpoint::ObtainIPForAddr(std::variant<service::Address, RouterID> addr)
     {
       llarp_time_t now = Now();
-      huint128_t nextIP = {0};
       AlignedBuffer<32> ident{};
       bool snode = false;
 
@@ -1461,84 +1605,55 @@ namespace llarp
         snode = true;
       }
 
+      // previously allocated address
+      if (auto ip = m_IPPool.IPFor(ident))
       {
-        // previously allocated address
-        auto itr = m_AddrToIP.find(ident);
-        if (itr != m_AddrToIP.end())
-        {
-          // mark ip active
-          MarkIPActive(itr->second);
-          return itr->second;
-        }
+        MarkIPActive(*ip);
+        return *ip;
       }
       // allocate new address
-      if (m_NextIP < m_MaxIP)
+      if (auto ip = m_IPPool.Allocate(ident, now))
       {
-        do
-        {
-          nextIP = ++m_NextIP;
-        } while (m_IPToAddr.find(nextIP) != m_IPToAddr.end() && m_NextIP < m_MaxIP);
-        if (nextIP < m_MaxIP)
-        {
-          m_AddrToIP[ident] = nextIP;
-          m_IPToAddr[nextIP] = ident;
-          m_SNodes[ident] = snode;
-          var::visit(
-              [&](auto&& remote) { llarp::LogInfo(Name(), " mapped ", remote, " to ", nextIP); },
-              addr);
-          MarkIPActive(nextIP);
-          return nextIP;
-        }
+        m_SNodes[ident] = snode;
+        var::visit(
+            [&](auto&& remote) { llarp::LogInfo(Name(), " mapped ", remote, " to ", *ip); },
+            addr);
+        return *ip;
       }
 
       // we are full
       // expire least active ip
       // TODO: prevent DoS
-      std::pair<huint128_t, llarp_time_t> oldest = {huint128_t{0}, 0s};
-
-      // find oldest entry
-      auto itr = m_IPActivity.begin();
-      while (itr != m_IPActivity.end())
+      const auto oldest = m_IPPool.LeastRecentlyActive();
+      if (not oldest)
       {
-        if (itr->second <= now)
-        {
-          if ((now - itr->second) > oldest.second)
-          {
-            oldest.first = itr->first;
-            oldest.second = itr->second;
-          }
-        }
-        ++itr;
+        LogWarn(Name(), " every address on ", m_OurRange, " is mapped for good, none to give");
+        return huint128_t{0};
       }
       // remap address
-      m_IPToAddr[oldest.first] = ident;
-      m_AddrToIP[ident] = oldest.first;
+      m_IPPool.Release(*oldest);
+      m_IPPool.Assign(*oldest, ident, now);
       m_SNodes[ident] = snode;
-      nextIP = oldest.first;
-
-      // mark ip active
-      m_IPActivity[nextIP] = std::max(m_IPActivity[nextIP], now);
-
-      return nextIP;
+      return *oldest;
     }
 
     bool
     TunEndpoint::HasRemoteForIP(huint128_t ip) const
     {
-      return m_IPToAddr.find(ip) != m_IPToAddr.end();
+      return m_IPPool.InUse(ip);
     }
 
     void
     TunEndpoint::MarkIPActive(huint128_t ip)
     {
       llarp::LogDebug(Name(), " address ", ip, " is active");
-      m_IPActivity[ip] = std::max(Now(), m_IPActivity[ip]);
+      m_IPPool.MarkActive(ip, Now());
     }
 
     void
     TunEndpoint::MarkIPActiveForever(huint128_t ip)
     {
-      m_IPActivity[ip] = std::numeric_limits<llarp_time_t>::max();
+      m_IPPool.Pin(ip);
     }
 
     TunEndpoint::~TunEndpoint() = default;
@@ -2,13 +2,16 @@
 
 #include <llarp/dns/server.hpp>
 #include <llarp/ev/ev.hpp>
+#include <llarp/net/fair_queue.hpp>
 #include <llarp/net/ip.hpp>
+#include <llarp/net/ip_pool.hpp>
 #include <llarp/net/ip_packet.hpp>
 #include <llarp/net/net.hpp>
 #include <llarp/service/endpoint.hpp>
 #include <llarp/service/protocol_type.hpp>
 #include <llarp/util/priority_queue.hpp>
 #include <llarp/util/thread/threading.hpp>
+#include <llarp/util/token_bucket.hpp>
 #include <llarp/vpn/packet_router.hpp>
 #include <llarp/vpn/platform.hpp>
 
@@ -74,6 +77,10 @@ namespace llarp
       bool
       Configure(const NetworkConfig& conf, const DnsConfig& dnsConf) override;
 
+      void
+      Reconfigure(
+          const NetworkConfig& was, const NetworkConfig& conf, const DnsConfig& dnsConf) override;
+
       void
       SendPacketToRemote(const llarp_buffer_t&, service::ProtocolType) override{};
 
@@ -139,15 +146,24 @@ namespace llarp
           service::ProtocolType t,
           uint64_t seqno) override;
 
-      /// handle inbound traffic
+      /// handle inbound traffic, which comes to us in order within each convo (see
+      /// service::Endpoint::ReorderInbound), so we write it out as it comes
       bool
-      HandleWriteIPPacket(
-          const llarp_buffer_t& buf, huint128_t src, huint128_t dst, uint64_t seqno);
+      HandleWriteIPPacket(net::IPPacket pkt, huint128_t src, huint128_t dst);
 
       /// we got a packet from the user
       void
       HandleGotUserPacket(llarp::net::IPPacket pkt);
 
+      /// send a packet from the user on to where it is going
+      void
+      SendUserPacket(net::IPPacket pkt);
+
+      /// send what m_UserQueue has for us as fast as m_UserQueueBucket lets us, and come back for
+      /// the rest
+      void
+      DrainUserQueue();
+
       /// get the local interface's address
       huint128_t
       GetIfAddr() const override;
@@ -193,7 +209,7 @@ namespace llarp
       bool
       HasAddress(const AlignedBuffer<32>& addr) const
       {
-        return m_AddrToIP.find(addr) != m_AddrToIP.end();
+        return m_IPPool.HasKey(addr);
       }
 
       /// get ip address for key unconditionally
@@ -204,20 +220,8 @@ namespace llarp
       ResetInternalState() override;
 
      protected:
-      struct WritePacket
-      {
-        uint64_t seqno;
-        net::IPPacket pkt;
-
-        bool
-        operator>(const WritePacket& other) const
-        {
-          return seqno > other.seqno;
-        }
-      };
-
-      /// queue for sending packets to user from network
-      util::ascending_priority_queue<WritePacket> m_NetworkToUserPktQueue;
+      /// packets from the network that Pump writes to the interface at once
+      std::vector<net::IPPacket> m_UserPacketBatch;
 
       void
       Pump(llarp_time_t now) override;
@@ -238,10 +242,9 @@ namespace llarp
       void
       FlushWrite();
 
-      /// maps ip to key (host byte order)
-      std::unordered_map<huint128_t, AlignedBuffer<32>> m_IPToAddr;
-      /// maps key to ip (host byte order)
-      std::unordered_map<AlignedBuffer<32>, huint128_t> m_AddrToIP;
+      /// the addresses of our range we gave to keys, which key has each, and when it was last
+      /// active (host byte order)
+      net::IPPool<AlignedBuffer<32>> m_IPPool;
 
       /// maps key to true if key is a service node, maps key to false if key is
       /// a hidden service
@@ -251,6 +254,10 @@ namespace llarp
       std::unordered_map<huint128_t, service::Address> m_ExitIPToExitAddress;
 
      private:
+      /// make our auth policy from conf; none if auth is off
+      void
+      ConfigureAuth(const NetworkConfig& conf);
+
       /// given an ip address that is not mapped locally find the address it shall be forwarded to
       /// optionally provide a custom selection strategy, if none is provided it will choose a
       /// random entry from the available choices
@@ -284,19 +291,22 @@ namespace llarp
       /// dns subsystem for this endpoint
       std::shared_ptr<dns::Server> m_DNS;
 
+      /// queries waiting on a lookup we are doing, all asking the same thing
+      struct PendingDNS
+      {
+        llarp_time_t started;
+        std::vector<std::shared_ptr<dns::QueryJob>> jobs;
+      };
+      /// the lookups we are doing, by the dns::AnswerCache::Key of what they look up, so that
+      /// queries asking what one already is wait on it rather than looking it up again
+      std::unordered_map<std::string, std::shared_ptr<PendingDNS>> m_PendingDNS;
+
       DnsConfig m_DnsConfig;
 
-      /// maps ip address to timestamp last active
-      std::unordered_map<huint128_t, llarp_time_t> m_IPActivity;
       /// our ip address (host byte order)
       huint128_t m_OurIP;
       /// our network interface's ipv6 address
       huint128_t m_OurIPv6;
-
-      /// next ip address to allocate (host byte order)
-      huint128_t m_NextIP;
-      /// highest ip address to allocate (host byte order)
-      huint128_t m_MaxIP;
       /// our ip range we are using
       llarp::IPRange m_OurRange;
       /// list of strict connect addresses for hooks
@@ -304,6 +314,8 @@ namespace llarp
       /// use v6?
       bool m_UseV6;
       std::string m_IfName;
+      size_t m_TunQueues = 1;
+      bool m_TunOffload = false;
 
       std::optional<huint128_t> m_BaseV6Address;
 
@@ -312,6 +324,14 @@ namespace llarp
       std::shared_ptr<vpn::PacketRouter> m_PacketRouter;
 
       std::optional<net::TrafficPolicy> m_TrafficPolicy;
+      /// m_TrafficPolicy made ready to check every packet against
+      net::CompiledTrafficPolicy m_CompiledTrafficPolicy;
+      /// from the user, waiting their turn when we shape what they send to a rate
+      net::FairQueue m_UserQueue;
+      /// the rate we shape to; unlimited when we don't
+      util::TokenBucket m_UserQueueBucket;
+      /// whether we have a call to DrainUserQueue coming
+      bool m_UserQueueDrainPending = false;
       /// ranges we advetise as reachable
       std::set<IPRange> m_OwnedRanges;
       /// how long to wait for path alignment
@@ -0,0 +1,142 @@
+#include "congestion.hpp"
+#include "session.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace llarp
+{
+  namespace iwp
+  {
+    void
+    CongestionControl::OnRTTSample(llarp_time_t rtt, llarp_time_t now)
+    {
+      m_LatestRTT = rtt;
+      if (not m_HaveRTT)
+      {
+        m_HaveRTT = true;
+        m_SRTT = rtt;
+        m_RTTVar = rtt / 2;
+        m_BaseRTT = m_PrevBaseRTT = rtt;
+        m_BaseIntervalStart = now;
+        return;
+      }
+      const auto delta = m_SRTT > rtt ? m_SRTT - rtt : rtt - m_SRTT;
+      m_RTTVar = (m_RTTVar * 3 + delta) / 4;
+      m_SRTT = (m_SRTT * 7 + rtt) / 8;
+
+      if (now - m_BaseIntervalStart >= BaseDelayInterval)
+      {
+        m_PrevBaseRTT = m_BaseRTT;
+        m_BaseRTT = rtt;
+        m_BaseIntervalStart = now;
+      }
+      else
+        m_BaseRTT = std::min(m_BaseRTT, rtt);
+    }
+
+    llarp_time_t
+    CongestionControl::MinRTT() const
+    {
+      return std::min(m_BaseRTT, m_PrevBaseRTT);
+    }
+
+    void
+    CongestionControl::OnAcked(size_t bytes)
+    {
+      const auto queueing = m_HaveRTT ? m_LatestRTT - MinRTT() : 0s;
+      if (m_Window < m_SlowStartThreshold)
+      {
+        if (queueing < TargetDelay / 2)
+        {
+          m_Window = std::min<double>(m_Window + bytes, MaxWindow);
+          return;
+        }
+        // delay is building up, leave slow start for good
+        m_SlowStartThreshold = m_Window;
+      }
+      const double target = TargetDelay.count();
+      const double offTarget = std::clamp((target - queueing.count()) / target, -1.0, 1.0);
+      m_Window += Gain * offTarget * bytes * FragmentSize / m_Window;
+      m_Window = std::clamp<double>(m_Window, MinWindow, MaxWindow);
+    }
+
+    void
+    CongestionControl::OnLoss(llarp_time_t now)
+    {
+      // a burst of losses in the same round trip is one congestion event
+      if (m_LastLossAt > 0s and now - m_LastLossAt < (m_HaveRTT ? m_SRTT : InitialRTO))
+        return;
+      m_LastLossAt = now;
+      m_Window = std::max<double>(m_Window / 2, MinWindow);
+      m_SlowStartThreshold = m_Window;
+    }
+
+    bool
+    CongestionControl::CanSend(size_t inflight, size_t bytes) const
+    {
+      return inflight == 0 or inflight + bytes <= m_Window;
+    }
+
+    double
+    CongestionControl::PacingRate() const
+    {
+      const auto rtt = m_HaveRTT ? std::max(m_SRTT, 1ms) : InitialRTO / 4;
+      return PacingGain * m_Window / rtt.count();
+    }
+
+    bool
+    CongestionControl::Pace(size_t bytes, llarp_time_t now)
+    {
+      if (now > m_LastPaced)
+      {
+        m_PacingBudget = std::min<double>(
+            m_PacingBudget + PacingRate() * (now - m_LastPaced).count(), PacingBurst);
+        m_LastPaced = now;
+      }
+      if (m_PacingBudget <= 0)
+        return false;
+      // we let the budget go negative rather than splitting a message; the overdraft is paid back
+      // before anything else goes out
+      m_PacingBudget -= bytes;
+      return true;
+    }
+
+    llarp_time_t
+    CongestionControl::PacingDelay(llarp_time_t now) const
+    {
+      const auto rate = PacingRate();
+      const double budget =
+          m_PacingBudget + (now > m_LastPaced ? rate * (now - m_LastPaced).count() : 0);
+      if (budget > 0)
+        return 0s;
+      return std::max(1ms, llarp_time_t{static_cast<int64_t>(std::ceil(-budget / rate))});
+    }
+
+    llarp_time_t
+    CongestionControl::RTO() const
+    {
+      if (not m_HaveRTT)
+        return InitialRTO;
+      return std::clamp<llarp_time_t>(m_SRTT + m_RTTVar * 4, MinRTO, MaxRTO);
+    }
+
+    llarp_time_t
+    CongestionControl::MessageTimeout() const
+    {
+      return std::max<llarp_time_t>(DeliveryTimeout, m_SRTT + RTO() * 2);
+    }
+
+    util::StatusObject
+    CongestionControl::ExtractStatus() const
+    {
+      return {
+          {"cwnd", Window()},
+          {"ssthresh", static_cast<uint64_t>(std::min<double>(m_SlowStartThreshold, MaxWindow))},
+          {"srtt", to_json(m_SRTT)},
+          {"rttvar", to_json(m_RTTVar)},
+          {"minRTT", to_json(MinRTT())},
+          {"rto", to_json(RTO())}};
+    }
+  }  // namespace iwp
+}  // namespace llarp
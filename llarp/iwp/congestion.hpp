@@ -0,0 +1,119 @@
+#pragma once
+
+#include <llarp/util/status.hpp>
+#include <llarp/util/time.hpp>
+
+#include <cstddef>
+
+namespace llarp
+{
+  namespace iwp
+  {
+    /// delay based (LEDBAT style) congestion control and packet pacing for one iwp session.
+    ///
+    /// round trip times are measured from acknowledgements of messages that were sent once; the
+    /// difference between the latest round trip and the smallest seen recently is our estimate of
+    /// queueing delay along the path.  the window grows while that stays under TargetDelay and
+    /// shrinks in proportion as it builds past it, and is halved (at most once per round trip) on
+    /// loss.  sends are paced at a little above window / rtt so that a full window doesn't go out
+    /// as a single burst.
+    ///
+    /// all sizes are in bytes of message payload.
+    struct CongestionControl
+    {
+      /// queueing delay we aim for
+      static constexpr auto TargetDelay = 100ms;
+      /// bytes of window growth per window's worth of acked data at zero queueing delay
+      static constexpr double Gain = 1.0;
+      /// how much faster than window / rtt we pace
+      static constexpr double PacingGain = 1.25;
+      /// how much we may send back to back after being idle
+      static constexpr size_t PacingBurst = 16 * 1024;
+      static constexpr size_t MinWindow = 4 * 1024;
+      static constexpr size_t InitialWindow = 32 * 1024;
+      static constexpr size_t MaxWindow = 4 * 1024 * 1024;
+      /// retransmit timeout before we have any round trip samples
+      static constexpr auto InitialRTO = 400ms;
+      static constexpr auto MinRTO = 200ms;
+      static constexpr auto MaxRTO = 2s;
+      /// how long a minimum round trip sample counts as our base delay for; we keep the minimum of
+      /// the current and previous interval so a route change is forgotten within two of these
+      static constexpr auto BaseDelayInterval = 60s;
+
+      /// feed a round trip time sample
+      void
+      OnRTTSample(llarp_time_t rtt, llarp_time_t now);
+
+      /// bytes were acknowledged
+      void
+      OnAcked(size_t bytes);
+
+      /// data was lost (retransmit timeout, nack or delivery timeout)
+      void
+      OnLoss(llarp_time_t now);
+
+      /// returns true if the window has room to put bytes more on the wire while inflight bytes
+      /// are unacknowledged.  an idle session can always send one message.
+      bool
+      CanSend(size_t inflight, size_t bytes) const;
+
+      /// take bytes from the pacing budget; returns false (without taking anything) if we have to
+      /// wait before sending them
+      bool
+      Pace(size_t bytes, llarp_time_t now);
+
+      /// how long until the pacing budget allows sending again
+      llarp_time_t
+      PacingDelay(llarp_time_t now) const;
+
+      /// retransmit timeout: smoothed rtt + 4 * rtt variance, clamped to [MinRTO, MaxRTO]
+      llarp_time_t
+      RTO() const;
+
+      /// how long we keep trying to deliver a message for: DeliveryTimeout on short paths, enough
+      /// for a few retransmits on long ones
+      llarp_time_t
+      MessageTimeout() const;
+
+      llarp_time_t
+      SmoothedRTT() const
+      {
+        return m_SRTT;
+      }
+
+      llarp_time_t
+      MinRTT() const;
+
+      size_t
+      Window() const
+      {
+        return static_cast<size_t>(m_Window);
+      }
+
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      /// pacing rate in bytes per millisecond
+      double
+      PacingRate() const;
+
+      bool m_HaveRTT = false;
+      llarp_time_t m_SRTT = 0s;
+      llarp_time_t m_RTTVar = 0s;
+      llarp_time_t m_LatestRTT = 0s;
+      /// minimum rtt in the current and previous base delay intervals
+      llarp_time_t m_BaseRTT = 0s;
+      llarp_time_t m_PrevBaseRTT = 0s;
+      llarp_time_t m_BaseIntervalStart = 0s;
+
+      /// kept fractional so that growth at large windows doesn't round away to nothing
+      double m_Window = InitialWindow;
+      double m_SlowStartThreshold = MaxWindow;
+      llarp_time_t m_LastLossAt = 0s;
+
+      double m_PacingBudget = PacingBurst;
+      llarp_time_t m_LastPaced = 0s;
+    };
+  }  // namespace iwp
+}  // namespace llarp
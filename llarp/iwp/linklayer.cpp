@@ -1,11 +1,26 @@
 #include "linklayer.hpp"
 #include "session.hpp"
 #include <llarp/config/key_manager.hpp>
+#include <llarp/ev/udp_handle.hpp>
+#include <llarp/ev/udp_receiver.hpp>
+#include <llarp/util/buffer_pool.hpp>
+#include <llarp/util/metrics.hpp>
+#include <algorithm>
+#include <array>
 #include <memory>
 #include <unordered_set>
 
 namespace llarp::iwp
 {
+  namespace
+  {
+    metrics::Counter rxPackets{"lokinet_link_rx_packets_total", "UDP packets the links received"};
+    metrics::Counter rxBytes{
+        "lokinet_link_rx_bytes_total", "Bytes of UDP packets the links received"};
+    metrics::Counter handshakesRefused{
+        "lokinet_link_handshakes_refused_total", "Inbound handshakes we did not admit"};
+  }  // namespace
+
   LinkLayer::LinkLayer(
       std::shared_ptr<KeyManager> keyManager,
       std::shared_ptr<EventLoop> ev,
@@ -50,6 +65,35 @@ namespace llarp::iwp
   void
   LinkLayer::RecvFrom(const SockAddr& from, ILinkSession::Packet_t pkt)
   {
+    if (HandleRecv(from, std::move(pkt)))
+      WakeupPlaintext();
+  }
+
+  void
+  LinkLayer::RecvBatchFrom(std::vector<UDPPacket>& pkts)
+  {
+    bool wakeup = false;
+    for (auto& pkt : pkts)
+      wakeup |= HandleRecv(pkt.from, util::BufferPool::Acquire(pkt.data.data(), pkt.data.size()));
+    if (wakeup)
+      WakeupPlaintext();
+  }
+
+  void
+  LinkLayer::RecvDatagrams(std::vector<UDPDatagram>& pkts)
+  {
+    bool wakeup = false;
+    for (auto& pkt : pkts)
+      wakeup |= HandleRecv(pkt.from, std::move(pkt.data));
+    if (wakeup)
+      WakeupPlaintext();
+  }
+
+  bool
+  LinkLayer::HandleRecv(const SockAddr& from, ILinkSession::Packet_t pkt)
+  {
+    rxPackets.Inc();
+    rxBytes.Inc(pkt.size());
     std::shared_ptr<ILinkSession> session;
     auto itr = m_AuthedAddrs.find(from);
     bool isNewSession = false;
@@ -60,7 +104,12 @@ namespace llarp::iwp
       if (it == m_Pending.end())
       {
         if (not m_Inbound)
-          return;
+          return false;
+        if (not AdmitHandshake(from, pkt))
+        {
+          handshakesRefused.Inc();
+          return false;
+        }
         isNewSession = true;
         it = m_Pending.emplace(from, std::make_shared<Session>(this, from)).first;
       }
@@ -68,8 +117,7 @@ namespace llarp::iwp
     }
     else
     {
-      if (auto s_itr = m_AuthedLinks.find(itr->second); s_itr != m_AuthedLinks.end())
-        session = s_itr->second;
+      session = FindSessionByPubkey(itr->second);
     }
     if (session)
     {
@@ -79,8 +127,83 @@ namespace llarp::iwp
         LogDebug("Brand new session failed; removing from pending sessions list");
         m_Pending.erase(from);
       }
-      WakeupPlaintext();
+      return true;
     }
+    return false;
+  }
+
+  HandshakeCookie
+  LinkLayer::MakeCookie(const SockAddr& from, const SharedSecret& secret) const
+  {
+    std::array<byte_t, sizeof(sockaddr_in6)> addr{};
+    const auto len = std::min(from.sockaddr_len(), addr.size());
+    const auto* sa = reinterpret_cast<const byte_t*>(static_cast<const sockaddr*>(from));
+    std::copy_n(sa, len, addr.data());
+    HandshakeCookie cookie;
+    CryptoManager::instance()->hmac(cookie.data(), llarp_buffer_t{addr.data(), len}, secret);
+    return cookie;
+  }
+
+  bool
+  LinkLayer::AdmitHandshake(const SockAddr& from, ILinkSession::Packet_t& pkt)
+  {
+    const auto now = Now();
+    if (m_CookieSecretAt == 0s or now - m_CookieSecretAt >= CookieSecretLifetime)
+    {
+      m_PrevCookieSecret = m_CookieSecret;
+      m_CookieSecret.Randomize();
+      m_CookieSecretAt = now;
+    }
+    bool cookied = false;
+    if (pkt.size() == IntroPacketSize + HandshakeCookie::SIZE)
+    {
+      const HandshakeCookie cookie{pkt.data() + IntroPacketSize};
+      cookied = cookie == MakeCookie(from, m_CookieSecret)
+          or cookie == MakeCookie(from, m_PrevCookieSecret);
+      // the session never sees it
+      pkt.resize(IntroPacketSize);
+    }
+    if (now - m_HandshakeWindowStart >= 1s)
+    {
+      m_HandshakeWindowStart = now;
+      m_HandshakesInWindow = 0;
+    }
+    if (cookied or m_HandshakesInWindow < CookieHandshakeRate)
+    {
+      ++m_HandshakesInWindow;
+      if (cookied)
+        ++m_HandshakeStats.cookieAdmitted;
+      else
+        ++m_HandshakeStats.admitted;
+      return true;
+    }
+    if (pkt.size() != IntroPacketSize)
+    {
+      ++m_HandshakeStats.dropped;
+      return false;
+    }
+    // under load: answer without keeping anything around; the remote comes back with the cookie
+    // if it really is at this address
+    std::array<byte_t, CookieReplySize> reply;
+    std::copy_n(pkt.data(), HMACSIZE, reply.data());
+    const auto cookie = MakeCookie(from, m_CookieSecret);
+    std::copy_n(cookie.begin(), cookie.size(), reply.data() + HMACSIZE);
+    SendTo_LL(from, llarp_buffer_t{reply});
+    ++m_HandshakeStats.cookiesSent;
+    return false;
+  }
+
+  util::StatusObject
+  LinkLayer::ExtractStatus() const
+  {
+    auto status = ILinkLayer::ExtractStatus();
+    status["handshakes"] = util::StatusObject{
+        {"admitted", m_HandshakeStats.admitted},
+        {"cookieAdmitted", m_HandshakeStats.cookieAdmitted},
+        {"cookiesSent", m_HandshakeStats.cookiesSent},
+        {"dropped", m_HandshakeStats.dropped},
+        {"recentRate", m_HandshakesInWindow}};
+    return status;
   }
 
   std::shared_ptr<ILinkSession>
@@ -103,8 +226,10 @@ namespace llarp::iwp
     // Copy bare pointers out first because HandlePlaintext can end up removing themselves from the
     // structures.
     m_WakingUp.clear();  // Reused to minimize allocations.
-    for (const auto& [router_id, session] : m_AuthedLinks)
-      m_WakingUp.push_back(session.get());
+    m_AuthedLinks.Read([this](const auto& links) {
+      for (const auto& [router_id, session] : links)
+        m_WakingUp.push_back(session.get());
+    });
     for (const auto& [addr, session] : m_Pending)
       m_WakingUp.push_back(session.get());
     for (auto* session : m_WakingUp)
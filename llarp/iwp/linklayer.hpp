@@ -15,6 +15,10 @@ namespace llarp::iwp
 {
   struct Session;
 
+  /// proof that a handshake came from an address that can receive from us, see
+  /// LinkLayer::AdmitHandshake
+  using HandshakeCookie = AlignedBuffer<32>;
+
   struct LinkLayer final : public ILinkLayer
   {
     LinkLayer(
@@ -44,19 +48,66 @@ namespace llarp::iwp
     void
     RecvFrom(const SockAddr& from, ILinkSession::Packet_t pkt) override;
 
+    void
+    RecvBatchFrom(std::vector<UDPPacket>& pkts) override;
+
+    void
+    RecvDatagrams(std::vector<UDPDatagram>& pkts) override;
+
     void
     WakeupPlaintext();
 
     std::string
     PrintableName() const;
 
+    util::StatusObject
+    ExtractStatus() const override;
+
    private:
+    /// hand a packet to the session for `from`, creating a pending inbound session if needed;
+    /// returns true if a session took the packet and so plaintext processing should be woken up.
+    bool
+    HandleRecv(const SockAddr& from, ILinkSession::Packet_t pkt);
+
     void
     HandleWakeupPlaintext();
 
+    /// decides whether a packet from an address we have no session with may start one.  while
+    /// inbound handshakes come in faster than CookieHandshakeRate per second, only intros carrying
+    /// a valid cookie are let through and everything else gets a cookie reply, so a flood of
+    /// intros costs us a keyed hash each rather than a session, a verify and a dh.  strips a
+    /// trailing cookie from pkt.
+    bool
+    AdmitHandshake(const SockAddr& from, ILinkSession::Packet_t& pkt);
+
+    /// the cookie for from under secret
+    HandshakeCookie
+    MakeCookie(const SockAddr& from, const SharedSecret& secret) const;
+
     const std::shared_ptr<EventLoopWakeup> m_Wakeup;
     std::vector<ILinkSession*> m_WakingUp;
     const bool m_Inbound;
+
+    /// cookies are keyed on a secret that rotates every CookieSecretLifetime; we accept cookies
+    /// made with the current or previous one
+    SharedSecret m_CookieSecret;
+    SharedSecret m_PrevCookieSecret;
+    llarp_time_t m_CookieSecretAt = 0s;
+    /// inbound handshakes let through in the current one second window
+    llarp_time_t m_HandshakeWindowStart = 0s;
+    size_t m_HandshakesInWindow = 0;
+
+    struct HandshakeStats
+    {
+      /// handshakes let through without a cookie
+      uint64_t admitted = 0;
+      /// handshakes let through on a valid cookie
+      uint64_t cookieAdmitted = 0;
+      /// cookie replies sent instead of starting a handshake
+      uint64_t cookiesSent = 0;
+      /// packets dropped while under load that were not intros
+      uint64_t dropped = 0;
+    } m_HandshakeStats;
   };
 
   using LinkLayer_ptr = std::shared_ptr<LinkLayer>;
@@ -1,6 +1,8 @@
 #include "message_buffer.hpp"
 #include "session.hpp"
 #include <llarp/crypto/crypto.hpp>
+#include <llarp/crypto/fast_crypto.hpp>
+#include <llarp/util/buffer_pool.hpp>
 
 namespace llarp
 {
@@ -11,24 +13,31 @@ namespace llarp
         ILinkSession::Message_t msg,
         llarp_time_t now,
         ILinkSession::CompletionHandler handler,
-        uint16_t priority)
+        uint16_t priority,
+        uint16_t fragsize)
         : m_Data{std::move(msg)}
         , m_MsgID{msgid}
+        , m_FragmentSize{fragsize}
         , m_Completed{handler}
         , m_LastFlush{now}
         , m_StartedAt{now}
         , m_ResendPriority{priority}
     {
       const llarp_buffer_t buf(m_Data);
-      CryptoManager::instance()->shorthash(m_Digest, buf);
+      fast_crypto::shorthash(m_Digest, buf);
       m_Acks.set(0);
     }
 
+    OutboundMessage::~OutboundMessage()
+    {
+      util::BufferPool::Release(m_Data);
+    }
+
     ILinkSession::Packet_t
     OutboundMessage::XMIT() const
     {
-      size_t extra = std::min(m_Data.size(), FragmentSize);
-      auto xmit = CreatePacket(Command::eXMIT, 10 + 32 + extra, 0, 0);
+      size_t extra = std::min<size_t>(m_Data.size(), m_FragmentSize);
+      auto xmit = CreatePacket(Command::eXMIT, XMITHeaderSize + extra, 0, 0);
       oxenc::write_host_as_big(
           static_cast<uint16_t>(m_Data.size()), xmit.data() + CommandOverhead + PacketOverhead);
       oxenc::write_host_as_big(m_MsgID, xmit.data() + 2 + CommandOverhead + PacketOverhead);
@@ -49,15 +58,54 @@ namespace llarp
     }
 
     bool
-    OutboundMessage::ShouldFlush(llarp_time_t now) const
+    OutboundMessage::ShouldFlush(llarp_time_t now, llarp_time_t rto) const
     {
-      return now - m_LastFlush >= TXFlushInterval;
+      return IsSent() and now - m_LastFlush >= rto and not IsTransmitted();
     }
 
     void
     OutboundMessage::Ack(byte_t bitmask)
     {
       m_Acks = std::bitset<8>(bitmask);
+      m_GotAcks = true;
+    }
+
+    size_t
+    OutboundMessage::UnackedBytes() const
+    {
+      if (not IsSent())
+        return 0;
+      const auto datasz = m_Data.size();
+      if (not m_GotAcks)
+        return datasz;
+      size_t unacked = 0;
+      for (size_t idx = 0; idx < datasz; idx += m_FragmentSize)
+      {
+        if (not m_Acks.test(idx / m_FragmentSize))
+          unacked += std::min<size_t>(m_FragmentSize, datasz - idx);
+      }
+      return unacked;
+    }
+
+    void
+    OutboundMessage::Transmit(std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now)
+    {
+      sendpkt(XMIT());
+      if (m_Data.size() > m_FragmentSize)
+        FlushUnAcked(sendpkt, now);
+      m_SentAt = now;
+      m_LastFlush = now;
+    }
+
+    void
+    OutboundMessage::Retransmit(
+        std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now)
+    {
+      m_Retransmitted = true;
+      ++m_Retransmits;
+      if (not m_GotAcks)
+        sendpkt(XMIT());
+      FlushUnAcked(sendpkt, now);
     }
 
     void
@@ -70,9 +118,9 @@ namespace llarp
       const auto datasz = m_Data.size();
       while (idx < datasz)
       {
-        if (not m_Acks[idx / FragmentSize])
+        if (not m_Acks[idx / m_FragmentSize])
         {
-          const size_t fragsz = idx + FragmentSize < datasz ? FragmentSize : datasz - idx;
+          const size_t fragsz = idx + m_FragmentSize < datasz ? m_FragmentSize : datasz - idx;
           auto frag = CreatePacket(Command::eDATA, fragsz + Overhead, 0, 0);
           oxenc::write_host_as_big(idx, frag.data() + 2 + PacketOverhead);
           oxenc::write_host_as_big(m_MsgID, frag.data() + 4 + PacketOverhead);
@@ -82,7 +130,7 @@ namespace llarp
               frag.data() + PacketOverhead + Overhead + 2);
           sendpkt(std::move(frag));
         }
-        idx += FragmentSize;
+        idx += m_FragmentSize;
       }
       m_LastFlush = now;
     }
@@ -91,19 +139,19 @@ namespace llarp
     OutboundMessage::IsTransmitted() const
     {
       const auto sz = m_Data.size();
-      for (uint16_t idx = 0; idx < sz; idx += FragmentSize)
+      for (size_t idx = 0; idx < sz; idx += m_FragmentSize)
       {
-        if (not m_Acks.test(idx / FragmentSize))
+        if (not m_Acks.test(idx / m_FragmentSize))
           return false;
       }
       return true;
     }
 
     bool
-    OutboundMessage::IsTimedOut(const llarp_time_t now) const
+    OutboundMessage::IsTimedOut(const llarp_time_t now, llarp_time_t timeout) const
     {
       // TODO: make configurable by outbound message deliverer
-      return now > m_StartedAt && now - m_StartedAt > DeliveryTimeout;
+      return now > m_StartedAt && now - m_StartedAt > timeout;
     }
 
     void
@@ -116,22 +164,32 @@ namespace llarp
       m_Completed = nullptr;
     }
 
-    InboundMessage::InboundMessage(uint64_t msgid, uint16_t sz, ShortHash h, llarp_time_t now)
-        : m_Data(size_t{sz}), m_Digset{std::move(h)}, m_MsgID(msgid), m_LastActiveAt{now}
+    InboundMessage::InboundMessage(
+        uint64_t msgid, uint16_t sz, ShortHash h, llarp_time_t now, uint16_t fragsize)
+        : m_Data{util::BufferPool::Acquire(sz)}
+        , m_Digset{std::move(h)}
+        , m_MsgID(msgid)
+        , m_LastActiveAt{now}
+        , m_FragmentSize{fragsize}
     {}
 
+    InboundMessage::~InboundMessage()
+    {
+      util::BufferPool::Release(m_Data);
+    }
+
     void
     InboundMessage::HandleData(uint16_t idx, const llarp_buffer_t& buf, llarp_time_t now)
     {
-      if (idx + buf.sz > m_Data.size())
+      if (idx + buf.sz > m_Data.size() or idx % m_FragmentSize)
       {
         LogWarn("invalid fragment offset ", idx);
         return;
       }
       byte_t* dst = m_Data.data() + idx;
       std::copy_n(buf.base, buf.sz, dst);
-      m_Acks.set(idx / FragmentSize);
-      LogTrace("got fragment ", idx / FragmentSize);
+      m_Acks.set(idx / m_FragmentSize);
+      LogTrace("got fragment ", idx / m_FragmentSize);
       m_LastActiveAt = now;
     }
 
@@ -154,24 +212,24 @@ namespace llarp
     InboundMessage::IsCompleted() const
     {
       const auto sz = m_Data.size();
-      for (size_t idx = 0; idx < sz; idx += FragmentSize)
+      for (size_t idx = 0; idx < sz; idx += m_FragmentSize)
       {
-        if (not m_Acks.test(idx / FragmentSize))
+        if (not m_Acks.test(idx / m_FragmentSize))
           return false;
       }
       return true;
     }
 
     bool
-    InboundMessage::ShouldSendACKS(llarp_time_t now) const
+    InboundMessage::ShouldSendACKS(llarp_time_t now, llarp_time_t interval) const
     {
-      return now > m_LastACKSent + ACKResendInterval;
+      return now > m_LastACKSent + interval;
     }
 
     bool
-    InboundMessage::IsTimedOut(const llarp_time_t now) const
+    InboundMessage::IsTimedOut(const llarp_time_t now, llarp_time_t timeout) const
     {
-      return now > m_LastActiveAt && now - m_LastActiveAt > DeliveryTimeout;
+      return now > m_LastActiveAt && now - m_LastActiveAt > timeout;
     }
 
     void
@@ -181,12 +239,19 @@ namespace llarp
       m_LastACKSent = now;
     }
 
+    void
+    InboundMessage::SendACKS(RangeACK& rack, llarp_time_t now)
+    {
+      rack.AddPartial(m_MsgID, AcksBitmask());
+      m_LastACKSent = now;
+    }
+
     bool
     InboundMessage::Verify() const
     {
       ShortHash gotten;
       const llarp_buffer_t buf(m_Data);
-      CryptoManager::instance()->shorthash(gotten, buf);
+      fast_crypto::shorthash(gotten, buf);
       return gotten == m_Digset;
     }
   }  // namespace iwp
@@ -1,5 +1,7 @@
 #pragma once
+#include <optional>
 #include <vector>
+#include "range_ack.hpp"
 #include <llarp/constants/link_layer.hpp>
 #include <llarp/link/session.hpp>
 #include <llarp/util/aligned.hpp>
@@ -24,14 +26,29 @@ namespace llarp
       eNACK = 4,
       /// multiack
       eMACK = 5,
+      /// path mtu probe, padded out to the size being probed
+      eMTUP = 6,
+      /// path mtu probe ack
+      eMTUA = 7,
+      /// range coded multiack, covering partially received messages too; see RangeACK
+      eRACK = 8,
       /// close session
       eCLOS = 0xff,
     };
 
-    /// max size of data fragments
+    /// default size of data fragments, and the smallest we use; every peer accepts these.  larger
+    /// ones are only sent once a path mtu probe has shown the remote and the path take them.
     static constexpr size_t FragmentSize = 1024;
+    /// the largest fragment size we use or accept; an XMIT carrying one of these fills a 1500 byte
+    /// ipv6 path MTU
+    static constexpr size_t MaxFragmentSize = 1344;
     /// plaintext header overhead size
     static constexpr size_t CommandOverhead = 2;
+    /// XMIT header after the command: size, message id and hash
+    static constexpr size_t XMITHeaderSize = 2 + 8 + 32;
+    /// acks are one bit per fragment and fragments are never smaller than FragmentSize, so this
+    /// many bits covers any message
+    static constexpr size_t MaxFragments = MAX_LINK_MSG_SIZE / FragmentSize;
 
     struct OutboundMessage
     {
@@ -41,15 +58,32 @@ namespace llarp
           ILinkSession::Message_t data,
           llarp_time_t now,
           ILinkSession::CompletionHandler handler,
-          uint16_t priority);
+          uint16_t priority,
+          uint16_t fragsize = FragmentSize);
+      OutboundMessage(OutboundMessage&&) = default;
+      OutboundMessage&
+      operator=(OutboundMessage&&) = default;
+      /// hands m_Data back to the buffer pool
+      ~OutboundMessage();
 
       ILinkSession::Message_t m_Data;
       uint64_t m_MsgID = 0;
-      std::bitset<MAX_LINK_MSG_SIZE / FragmentSize> m_Acks;
+      std::bitset<MaxFragments> m_Acks;
+      /// the fragment size this message is sent with; fixed for its lifetime
+      uint16_t m_FragmentSize = FragmentSize;
       ILinkSession::CompletionHandler m_Completed;
       llarp_time_t m_LastFlush = 0s;
       ShortHash m_Digest;
       llarp_time_t m_StartedAt = 0s;
+      /// when we first put this message on the wire, if we have
+      std::optional<llarp_time_t> m_SentAt;
+      /// set once we have resent any of it; round trip samples from acks of resent messages are
+      /// ambiguous so we don't take them
+      bool m_Retransmitted = false;
+      /// how many times we have resent it
+      uint16_t m_Retransmits = 0;
+      /// set once the remote has acked any of it, so we know they got the XMIT
+      bool m_GotAcks = false;
       uint16_t m_ResendPriority;
 
       bool
@@ -70,8 +104,27 @@ namespace llarp
       void
       FlushUnAcked(std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now);
 
+      /// first transmission: the XMIT and every other fragment
+      void
+      Transmit(std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now);
+
+      /// resend whatever the remote hasn't acked, including the XMIT if they haven't acked anything
+      void
+      Retransmit(std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now);
+
       bool
-      ShouldFlush(llarp_time_t now) const;
+      IsSent() const
+      {
+        return m_SentAt.has_value();
+      }
+
+      /// bytes that are on the wire and not yet acked
+      size_t
+      UnackedBytes() const;
+
+      /// returns true if we sent this more than rto ago and still have unacked fragments
+      bool
+      ShouldFlush(llarp_time_t now, llarp_time_t rto) const;
 
       void
       Completed();
@@ -80,7 +133,7 @@ namespace llarp
       IsTransmitted() const;
 
       bool
-      IsTimedOut(llarp_time_t now) const;
+      IsTimedOut(llarp_time_t now, llarp_time_t timeout) const;
 
       void
       InformTimeout();
@@ -89,14 +142,26 @@ namespace llarp
     struct InboundMessage
     {
       InboundMessage() = default;
-      InboundMessage(uint64_t msgid, uint16_t sz, ShortHash h, llarp_time_t now);
+      InboundMessage(
+          uint64_t msgid,
+          uint16_t sz,
+          ShortHash h,
+          llarp_time_t now,
+          uint16_t fragsize = FragmentSize);
+      InboundMessage(InboundMessage&&) = default;
+      InboundMessage&
+      operator=(InboundMessage&&) = default;
+      /// hands m_Data back to the buffer pool
+      ~InboundMessage();
 
       ILinkSession::Message_t m_Data;
       ShortHash m_Digset;
       uint64_t m_MsgID = 0;
       llarp_time_t m_LastACKSent = 0s;
       llarp_time_t m_LastActiveAt = 0s;
-      std::bitset<MAX_LINK_MSG_SIZE / FragmentSize> m_Acks;
+      std::bitset<MaxFragments> m_Acks;
+      /// the fragment size the remote sends this message with, from the XMIT
+      uint16_t m_FragmentSize = FragmentSize;
 
       void
       HandleData(uint16_t idx, const llarp_buffer_t& buf, llarp_time_t now);
@@ -105,7 +170,7 @@ namespace llarp
       IsCompleted() const;
 
       bool
-      IsTimedOut(llarp_time_t now) const;
+      IsTimedOut(llarp_time_t now, llarp_time_t timeout) const;
 
       bool
       Verify() const;
@@ -114,11 +179,15 @@ namespace llarp
       AcksBitmask() const;
 
       bool
-      ShouldSendACKS(llarp_time_t now) const;
+      ShouldSendACKS(llarp_time_t now, llarp_time_t interval) const;
 
       void
       SendACKS(std::function<void(ILinkSession::Packet_t)> sendpkt, llarp_time_t now);
 
+      /// ack our fragments as an entry in a range ack rather than in a packet of their own
+      void
+      SendACKS(RangeACK& rack, llarp_time_t now);
+
       ILinkSession::Packet_t
       ACKS() const;
     };
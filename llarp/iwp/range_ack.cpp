@@ -0,0 +1,186 @@
+#include "range_ack.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace llarp
+{
+  namespace iwp
+  {
+    namespace
+    {
+      size_t
+      VarintSize(uint64_t val)
+      {
+        size_t n = 1;
+        while (val >= 0x80)
+        {
+          val >>= 7;
+          ++n;
+        }
+        return n;
+      }
+
+      void
+      PutVarint(std::vector<byte_t>& out, uint64_t val)
+      {
+        while (val >= 0x80)
+        {
+          out.push_back(static_cast<byte_t>(val | 0x80));
+          val >>= 7;
+        }
+        out.push_back(static_cast<byte_t>(val));
+      }
+
+      bool
+      GetVarint(const byte_t*& ptr, const byte_t* end, uint64_t& val)
+      {
+        val = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+          if (ptr == end)
+            return false;
+          const byte_t b = *ptr++;
+          val |= uint64_t{b & 0x7fu} << shift;
+          if (not(b & 0x80))
+            return true;
+        }
+        return false;
+      }
+
+      /// room we leave for the two counts; they are 2 bytes each up to 16k entries, which is
+      /// far more than fits in any packet we send
+      constexpr size_t CountsSize = 4;
+    }  // namespace
+
+    void
+    RangeACK::AddComplete(uint64_t id)
+    {
+      if (not ranges.empty() and id <= ranges.back().second + 1 and id >= ranges.back().first)
+        ranges.back().second = std::max(ranges.back().second, id);
+      else
+        ranges.emplace_back(id, id);
+    }
+
+    void
+    RangeACK::AddPartial(uint64_t id, byte_t mask)
+    {
+      partial.emplace_back(id, mask);
+    }
+
+    std::vector<byte_t>
+    RangeACK::Encode(size_t maxSize)
+    {
+      std::sort(partial.begin(), partial.end());
+      // masks only ever gain bits, so for repeats the union is the latest
+      size_t kept = 0;
+      for (size_t idx = 0; idx < partial.size(); ++idx)
+      {
+        if (kept > 0 and partial[kept - 1].first == partial[idx].first)
+          partial[kept - 1].second |= partial[idx].second;
+        else
+          partial[kept++] = partial[idx];
+      }
+      partial.resize(kept);
+
+      size_t budget = maxSize > CountsSize ? maxSize - CountsSize : 0;
+      size_t nranges = 0;
+      uint64_t prev = 0;
+      for (const auto& [first, last] : ranges)
+      {
+        const size_t sz = VarintSize(first - prev) + VarintSize(last - first);
+        if (sz > budget and nranges > 0)
+          break;
+        budget -= std::min(sz, budget);
+        prev = last;
+        ++nranges;
+      }
+      size_t npartial = 0;
+      prev = 0;
+      for (const auto& [id, mask] : partial)
+      {
+        const size_t sz = VarintSize(id - prev) + 1;
+        if (sz > budget and (nranges > 0 or npartial > 0))
+          break;
+        budget -= std::min(sz, budget);
+        prev = id;
+        ++npartial;
+      }
+
+      std::vector<byte_t> out;
+      out.reserve(maxSize);
+      PutVarint(out, nranges);
+      prev = 0;
+      for (size_t idx = 0; idx < nranges; ++idx)
+      {
+        const auto [first, last] = ranges[idx];
+        PutVarint(out, first - prev);
+        PutVarint(out, last - first);
+        prev = last;
+      }
+      PutVarint(out, npartial);
+      prev = 0;
+      for (size_t idx = 0; idx < npartial; ++idx)
+      {
+        const auto [id, mask] = partial[idx];
+        PutVarint(out, id - prev);
+        out.push_back(mask);
+        prev = id;
+      }
+      ranges.erase(ranges.begin(), ranges.begin() + nranges);
+      partial.erase(partial.begin(), partial.begin() + npartial);
+      return out;
+    }
+
+    std::optional<RangeACK>
+    RangeACK::Decode(const byte_t* buf, size_t sz)
+    {
+      const byte_t* ptr = buf;
+      const byte_t* const end = buf + sz;
+      RangeACK ack;
+      uint64_t count = 0;
+      // every entry takes at least two bytes, which bounds the counts by the packet size
+      if (not GetVarint(ptr, end, count) or count > sz / 2)
+        return std::nullopt;
+      uint64_t prev = 0;
+      for (uint64_t idx = 0; idx < count; ++idx)
+      {
+        uint64_t gap, len;
+        if (not GetVarint(ptr, end, gap) or not GetVarint(ptr, end, len))
+          return std::nullopt;
+        const uint64_t first = prev + gap;
+        const uint64_t last = first + len;
+        // ranges must ascend without wrapping around
+        if (first < prev or last < first or (idx > 0 and first <= prev))
+          return std::nullopt;
+        ack.ranges.emplace_back(first, last);
+        prev = last;
+      }
+      if (not GetVarint(ptr, end, count) or count > sz / 2)
+        return std::nullopt;
+      prev = 0;
+      for (uint64_t idx = 0; idx < count; ++idx)
+      {
+        uint64_t gap;
+        if (not GetVarint(ptr, end, gap) or ptr == end)
+          return std::nullopt;
+        const uint64_t id = prev + gap;
+        if (id < prev)
+          return std::nullopt;
+        ack.partial.emplace_back(id, *ptr++);
+        prev = id;
+      }
+      return ack;
+    }
+
+    bool
+    RangeACK::Covers(uint64_t id) const
+    {
+      auto itr = std::upper_bound(
+          ranges.begin(), ranges.end(), id, [](uint64_t val, const auto& range) {
+            return val < range.first;
+          });
+      return itr != ranges.begin() and id <= std::prev(itr)->second;
+    }
+  }  // namespace iwp
+}  // namespace llarp
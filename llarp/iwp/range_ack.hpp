@@ -0,0 +1,62 @@
+#pragma once
+
+#include <llarp/util/types.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace iwp
+  {
+    /// the body of an eRACK: one packet acking everything we have to ack, in place of an eMACK
+    /// of full 64 bit ids plus an eACKS packet per message still coming in.  sent only to peers
+    /// that advertised link_features::RangeACK in their LIM.
+    ///
+    /// message ids are sequential, so fully received ones are sent as runs, each one a varint
+    /// (LEB128) gap from the end of the one before and a varint length; partially received ones
+    /// as a varint id delta and their fragment bitmask:
+    ///
+    ///     varint nranges, nranges * (varint gap, varint length - 1),
+    ///     varint npartial, npartial * (varint gap, byte mask)
+    ///
+    /// the first gap of each list is from 0, i.e. the first id itself.
+    struct RangeACK
+    {
+      /// fully received ids as inclusive [first, last] runs, ascending and disjoint
+      std::vector<std::pair<uint64_t, uint64_t>> ranges;
+      /// fragment bitmasks of messages still coming in, by id
+      std::vector<std::pair<uint64_t, byte_t>> partial;
+
+      bool
+      empty() const
+      {
+        return ranges.empty() and partial.empty();
+      }
+
+      /// add a fully received id; ids must be added in ascending order, repeats are fine
+      void
+      AddComplete(uint64_t id);
+
+      /// add the fragment bitmask of a message still coming in; any order
+      void
+      AddPartial(uint64_t id, byte_t mask);
+
+      /// encode as much as fits in maxSize bytes (at least one entry, if there are any) and
+      /// remove what was encoded, so that calling this until empty() sends everything
+      std::vector<byte_t>
+      Encode(size_t maxSize);
+
+      /// returns nullopt if buf is malformed
+      static std::optional<RangeACK>
+      Decode(const byte_t* buf, size_t sz);
+
+      /// true if id is in one of the ranges
+      bool
+      Covers(uint64_t id) const;
+    };
+  }  // namespace iwp
+}  // namespace llarp
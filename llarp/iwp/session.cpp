@@ -1,9 +1,14 @@
 #include "session.hpp"
 
+#include <llarp/crypto/fast_crypto.hpp>
+#include <llarp/link/recorder.hpp>
 #include <llarp/messages/link_intro.hpp>
 #include <llarp/messages/discard.hpp>
 #include <llarp/util/meta/memfn.hpp>
 #include <llarp/router/abstractrouter.hpp>
+#include <llarp/util/buffer_pool.hpp>
+#include <llarp/util/metrics.hpp>
+#include <llarp/util/trace.hpp>
 
 #include <queue>
 
@@ -11,25 +16,42 @@ namespace llarp
 {
   namespace iwp
   {
+    namespace
+    {
+      metrics::Counter txMessages{"lokinet_link_tx_messages_total", "Link messages queued to send"};
+      metrics::Counter txDropped{
+          "lokinet_link_tx_dropped_total", "Link messages that timed out before they were acked"};
+      metrics::Counter txRetransmits{
+          "lokinet_link_tx_retransmits_total", "Times link messages were sent again"};
+      metrics::Counter rxMessages{"lokinet_link_rx_messages_total", "Link messages received whole"};
+      metrics::Counter rxDropped{
+          "lokinet_link_rx_dropped_total",
+          "Link packets dropped on the way in because too many were waiting to be handled"};
+      metrics::Histogram cryptoLatency{
+          "lokinet_link_crypto_latency_microseconds",
+          "How long link packets waited for and took to encrypt or decrypt"};
+    }  // namespace
+
     ILinkSession::Packet_t
     CreatePacket(Command cmd, size_t plainsize, size_t minpad, size_t variance)
     {
       const size_t pad = minpad > 0 ? minpad + (variance > 0 ? randint() % variance : 0) : 0;
-      ILinkSession::Packet_t pkt(PacketOverhead + plainsize + pad + CommandOverhead);
+      auto pkt = util::BufferPool::Acquire(PacketOverhead + plainsize + pad + CommandOverhead);
       // randomize pad
       if (pad)
       {
-        CryptoManager::instance()->randbytes(
-            pkt.data() + PacketOverhead + CommandOverhead + plainsize, pad);
+        fast_crypto::randbytes(pkt.data() + PacketOverhead + CommandOverhead + plainsize, pad);
       }
       // randomize nounce
-      CryptoManager::instance()->randbytes(pkt.data() + HMACSIZE, TUNNONCESIZE);
+      fast_crypto::randbytes(pkt.data() + HMACSIZE, TUNNONCESIZE);
       pkt[PacketOverhead] = llarp::constants::proto_version;
       pkt[PacketOverhead + 1] = cmd;
       return pkt;
     }
 
     constexpr size_t PlaintextQueueSize = 512;
+    /// packets of a session we hold on the way in before we drop new ones; about 4MiB
+    constexpr size_t MaxRXBacklog = 2048;
 
     Session::Session(LinkLayer* p, const RouterContact& rc, const AddressInfo& ai)
         : m_State{State::Initial}
@@ -72,6 +94,28 @@ namespace llarp
       m_TXRate += sz;
     }
 
+    void
+    Session::Send_LL(const std::vector<Packet_t>& pkts)
+    {
+      if (pkts.empty())
+        return;
+      LogTrace("send ", pkts.size(), " packets to ", m_RemoteAddr);
+      m_Parent->SendBatchTo_LL(m_RemoteAddr, pkts);
+      m_LastTX = time_now_ms();
+      for (const auto& pkt : pkts)
+        m_TXRate += pkt.size();
+    }
+
+    void
+    Session::HandleLIMFeatures(const LinkIntroMessage* msg)
+    {
+      m_RangeACKs = msg->Features() & link_features::RangeACK;
+      const bool aes = (msg->Features() & link_features::AES256GCM)
+          and fast_crypto::aes256gcm_available();
+      if (aes != m_AES256GCM.exchange(aes))
+        LogDebug("sending with ", aes ? "aes256gcm" : "xchacha20", " to ", m_RemoteAddr);
+    }
+
     bool
     Session::GotInboundLIM(const LinkIntroMessage* msg)
     {
@@ -84,6 +128,8 @@ namespace llarp
       m_State = State::Ready;
       GotLIM = util::memFn(&Session::GotRenegLIM, this);
       m_RemoteRC = msg->rc;
+      m_RemoteRCVersion++;
+      HandleLIMFeatures(msg);
       m_Parent->MapAddr(m_RemoteRC.pubkey, this);
       return m_Parent->SessionEstablished(this, true);
     }
@@ -98,6 +144,8 @@ namespace llarp
       }
 
       m_RemoteRC = msg->rc;
+      m_RemoteRCVersion++;
+      HandleLIMFeatures(msg);
       GotLIM = util::memFn(&Session::GotRenegLIM, this);
       assert(shared_from_this().use_count() > 1);
       SendOurLIM([self = shared_from_this()](ILinkSession::DeliveryStatus st) {
@@ -118,6 +166,10 @@ namespace llarp
       msg.rc = m_Parent->GetOurRC();
       msg.N.Randomize();
       msg.P = 60000;
+      uint64_t features = link_features::RangeACK;
+      if (fast_crypto::aes256gcm_available())
+        features |= link_features::AES256GCM;
+      msg.SetFeatures(features);
       if (not msg.Sign(m_Parent->Sign))
       {
         LogError("failed to sign our RC for ", m_RemoteAddr);
@@ -154,19 +206,23 @@ namespace llarp
     Session::EncryptWorker(CryptoQueue_t msgs)
     {
       LogTrace("encrypt worker ", msgs.size(), " messages");
-      for (auto& pkt : msgs)
+      // every packet we create is at least PacketOverhead in size so this cannot fail
+      if (m_AES256GCM)
       {
-        llarp_buffer_t pktbuf{pkt};
-        const TunnelNonce nonce_ptr{pkt.data() + HMACSIZE};
-        pktbuf.base += PacketOverhead;
-        pktbuf.cur = pktbuf.base;
-        pktbuf.sz -= PacketOverhead;
-        CryptoManager::instance()->xchacha20(pktbuf, m_SessionKey, nonce_ptr);
-        pktbuf.base = pkt.data() + HMACSIZE;
-        pktbuf.sz = pkt.size() - HMACSIZE;
-        CryptoManager::instance()->hmac(pkt.data(), pktbuf, m_SessionKey);
-        Send_LL(pkt.data(), pkt.size());
+        // nonces are which side we are and then a 64 bit counter, so that we never repeat one of
+        // ours or of the remote's
+        for (auto& pkt : msgs)
+        {
+          byte_t* const nonce = pkt.data() + HMACSIZE;
+          oxenc::write_host_as_big<uint32_t>(m_Inbound, nonce);
+          oxenc::write_host_as_big<uint64_t>(m_TXNonceCounter++, nonce + sizeof(uint32_t));
+        }
+        fast_crypto::aes256gcm_encrypt_packets(msgs, m_SessionKey);
       }
+      else
+        fast_crypto::encrypt_packets(msgs, m_SessionKey);
+      Send_LL(msgs);
+      util::BufferPool::Release(msgs);
     }
 
     void
@@ -176,6 +232,7 @@ namespace llarp
         return;
       auto close_msg = CreatePacket(Command::eCLOS, 0, 16, 16);
       m_Parent->UnmapAddr(m_RemoteAddr);
+      m_Parent->RetireHistograms(*this);
       m_State = State::Closed;
       if (m_SentClosed.test_and_set())
         return;
@@ -188,32 +245,168 @@ namespace llarp
     Session::SendMessageBuffer(
         ILinkSession::Message_t buf, ILinkSession::CompletionHandler completed, uint16_t priority)
     {
-      if (m_TXMsgs.size() >= MaxSendQueueSize)
+      const auto now = m_Parent->Now();
+      const auto msgid = m_TXID;
+      const auto bufsz = buf.size();
+      OutboundMessage msg{msgid, std::move(buf), now, completed, priority, m_TXFragmentSize};
+      // the window is full if we have too many messages in flight, or if the oldest one is too far
+      // behind the newest
+      auto* const pmsg = m_TXMsgs.Emplace(msgid, std::move(msg)).first;
+      if (not pmsg)
       {
         if (completed)
           completed(ILinkSession::DeliveryStatus::eDeliveryDropped);
         return false;
       }
-      const auto now = m_Parent->Now();
-      const auto msgid = m_TXID++;
-      const auto bufsz = buf.size();
-      auto& msg =
-          m_TXMsgs.emplace(msgid, OutboundMessage{msgid, std::move(buf), now, completed, priority})
-              .first->second;
+      m_TXID++;
+      // it goes on the wire on the next pump, once the congestion window and pacing allow
       TriggerPump();
-      EncryptAndSend(msg.XMIT());
-      if (bufsz > FragmentSize)
-      {
-        msg.FlushUnAcked(util::memFn(&Session::EncryptAndSend, this), now);
-      }
       m_Stats.totalInFlightTX++;
-      LogDebug("send message ", msgid, " to ", m_RemoteAddr);
+      txMessages.Inc();
+      LogDebug("queued message ", msgid, " of ", bufsz, " bytes to ", m_RemoteAddr);
       return true;
     }
 
+    void
+    Session::FlushTX(llarp_time_t now)
+    {
+      using SendQueue_t = std::priority_queue<
+          OutboundMessage*,
+          std::vector<OutboundMessage*>,
+          ComparePtr<OutboundMessage*>>;
+      const auto rto = m_CC.RTO();
+      size_t inflight = 0;
+      SendQueue_t to_resend;
+      SendQueue_t to_send;
+      m_TXMsgs.ForEach([&](uint64_t, OutboundMessage& msg) {
+        if (not msg.IsSent())
+          to_send.push(&msg);
+        else
+        {
+          inflight += msg.UnackedBytes();
+          if (msg.ShouldFlush(now, rto))
+            to_resend.push(&msg);
+        }
+      });
+      if (not to_resend.empty())
+        m_CC.OnLoss(now);
+
+      const auto sendpkt = util::memFn(&Session::EncryptAndSend, this);
+      bool paced = false;
+      // resends replace data the network already dropped, so they are paced but don't need room
+      // in the window
+      for (; not to_resend.empty(); to_resend.pop())
+      {
+        auto* msg = to_resend.top();
+        if (not m_CC.Pace(msg->UnackedBytes(), now))
+        {
+          paced = true;
+          break;
+        }
+        msg->Retransmit(sendpkt, now);
+        txRetransmits.Inc();
+      }
+      for (; not paced and not to_send.empty(); to_send.pop())
+      {
+        auto* msg = to_send.top();
+        const auto bytes = msg->m_Data.size();
+        // window limited: acks will pump us again
+        if (not m_CC.CanSend(inflight, bytes))
+          break;
+        if (not m_CC.Pace(bytes, now))
+        {
+          paced = true;
+          break;
+        }
+        m_Histograms.queueDelay.Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - msg->m_StartedAt).count());
+        msg->Transmit(sendpkt, now);
+        inflight += bytes;
+      }
+
+      if (paced and not m_PacingTimerArmed)
+      {
+        m_PacingTimerArmed = true;
+        m_Parent->Router()->loop()->call_later(m_CC.PacingDelay(now), [self = weak_from_this()] {
+          if (auto ptr = self.lock())
+          {
+            ptr->m_PacingTimerArmed = false;
+            ptr->TriggerPump();
+          }
+        });
+      }
+    }
+
+    void
+    Session::OnMessageAcked(const OutboundMessage& msg, size_t acked, llarp_time_t now)
+    {
+      if (msg.m_SentAt and not msg.m_Retransmitted)
+      {
+        m_CC.OnRTTSample(now - *msg.m_SentAt, now);
+        m_Histograms.ackRTT.Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - *msg.m_SentAt).count());
+      }
+      m_Histograms.retransmits.Record(msg.m_Retransmits);
+      m_CC.OnAcked(acked);
+      // the window just opened up
+      TriggerPump();
+    }
+
+    void
+    Session::ProbeMTU(llarp_time_t now)
+    {
+      if (now < m_NextMTUProbeAt)
+        return;
+      // skip sizes that have had all their attempts, and ones that would not grow our fragments
+      while (m_MTUProbeIndex < MTUProbeSizes.size()
+             and (m_MTUProbeTries >= MTUProbeAttempts
+                  or MTUProbeSizes[m_MTUProbeIndex] - XMITWireOverhead <= m_TXFragmentSize))
+      {
+        ++m_MTUProbeIndex;
+        m_MTUProbeTries = 0;
+      }
+      if (m_MTUProbeIndex == MTUProbeSizes.size())
+      {
+        // nothing (bigger) got through, look again later in case the path changes
+        m_MTUProbeIndex = 0;
+        m_MTUProbeTries = 0;
+        m_NextMTUProbeAt = now + MTUReprobeInterval;
+        return;
+      }
+      const auto sz = MTUProbeSizes[m_MTUProbeIndex];
+      LogTrace("probing path mtu to ", m_RemoteAddr, " with ", sz, " bytes");
+      auto probe = CreatePacket(Command::eMTUP, sz - (PacketOverhead + CommandOverhead), 0, 0);
+      oxenc::write_host_as_big(
+          static_cast<uint16_t>(sz), probe.data() + PacketOverhead + CommandOverhead);
+      EncryptAndSend(std::move(probe));
+      ++m_MTUProbeTries;
+      m_NextMTUProbeAt = now + m_CC.RTO() * 2;
+    }
+
+    void
+    Session::ResetFragmentSize(llarp_time_t now)
+    {
+      LogInfo(
+          "messages with ",
+          m_TXFragmentSize,
+          " byte fragments are not getting through to ",
+          m_RemoteAddr,
+          ", going back to ",
+          FragmentSize);
+      m_TXFragmentSize = FragmentSize;
+      m_MTUProbeIndex = 0;
+      m_MTUProbeTries = 0;
+      m_NextMTUProbeAt = now + MTUReprobeInterval;
+    }
+
     void
     Session::SendMACK()
     {
+      if (m_RangeACKs)
+      {
+        ScheduleRangeACK();
+        return;
+      }
       // send multi acks
       while (not m_SendMACKs.empty())
       {
@@ -236,6 +429,49 @@ namespace llarp
       }
     }
 
+    void
+    Session::ScheduleRangeACK()
+    {
+      const auto pending = m_SendMACKs.size() + m_SendRangeACK.partial.size();
+      if (pending == 0)
+        return;
+      if (pending >= ACKCoalesceCount)
+      {
+        SendRangeACK();
+        return;
+      }
+      if (m_ACKTimerArmed)
+        return;
+      m_ACKTimerArmed = true;
+      m_Parent->Router()->loop()->call_later(ACKCoalesceDelay, [self = weak_from_this()] {
+        if (auto ptr = self.lock())
+        {
+          ptr->m_ACKTimerArmed = false;
+          ptr->SendRangeACK();
+        }
+      });
+    }
+
+    void
+    Session::SendRangeACK()
+    {
+      if (m_State == State::Closed)
+        return;
+      while (not m_SendMACKs.empty())
+      {
+        m_SendRangeACK.AddComplete(m_SendMACKs.top());
+        m_SendMACKs.pop();
+      }
+      while (not m_SendRangeACK.empty())
+      {
+        const auto body = m_SendRangeACK.Encode(MaxRangeACKSize);
+        auto rack = CreatePacket(Command::eRACK, body.size());
+        std::copy(body.begin(), body.end(), rack.data() + PacketOverhead + CommandOverhead);
+        LogTrace("send ", body.size(), " byte range ack to ", m_RemoteAddr);
+        EncryptAndSend(std::move(rack));
+      }
+    }
+
     void
     Session::TriggerPump()
     {
@@ -248,50 +484,69 @@ namespace llarp
       const auto now = m_Parent->Now();
       if (m_State == State::Ready || m_State == State::LinkIntro)
       {
-        if (ShouldPing())
-          SendKeepAlive();
-        for (auto& [id, msg] : m_RXMsgs)
-        {
-          if (msg.ShouldSendACKS(now))
-          {
+        const auto ackInterval = std::max<llarp_time_t>(ACKResendInterval, m_CC.RTO() / 2);
+        m_RXMsgs.ForEach([this, now, ackInterval](uint64_t, InboundMessage& msg) {
+          if (not msg.ShouldSendACKS(now, ackInterval))
+            return;
+          if (m_RangeACKs)
+            msg.SendACKS(m_SendRangeACK, now);
+          else
             msg.SendACKS(util::memFn(&Session::EncryptAndSend, this), now);
-          }
-        }
-        std::priority_queue<
-            OutboundMessage*,
-            std::vector<OutboundMessage*>,
-            ComparePtr<OutboundMessage*>>
-            to_resend;
-        for (auto& [id, msg] : m_TXMsgs)
-        {
-          if (msg.ShouldFlush(now))
-            to_resend.push(&msg);
-        }
-        if (not to_resend.empty())
-        {
-          for (auto& msg = to_resend.top(); not to_resend.empty(); to_resend.pop())
-            msg->FlushUnAcked(util::memFn(&Session::EncryptAndSend, this), now);
-        }
+        });
+        if (m_RangeACKs)
+          ScheduleRangeACK();
+        FlushTX(now);
       }
       if (not m_EncryptNext.empty())
       {
-        m_Parent->QueueWork(
-            [self = shared_from_this(), data = m_EncryptNext] { self->EncryptWorker(data); });
+        m_Parent->Router()->QueueShardedWork(
+            CryptoShard(),
+            [self = shared_from_this(),
+             data = std::move(m_EncryptNext),
+             queued = std::chrono::steady_clock::now()]() mutable {
+              self->EncryptWorker(std::move(data));
+              self->RecordCryptoLatency(queued);
+            });
         m_EncryptNext.clear();
       }
 
-      if (not m_DecryptNext.empty())
+      // with every slot in m_PlaintextRecv spoken for, the packets wait here until a drain makes
+      // room, and HandleSessionData sheds what comes in past that
+      if (not m_DecryptNext.empty() and m_RXBatches.load() < PlaintextQueueSize)
       {
-        m_Parent->QueueWork(
-            [self = shared_from_this(), data = m_DecryptNext] { self->DecryptWorker(data); });
+        ++m_RXBatches;
+        m_Parent->Router()->QueueShardedWork(
+            CryptoShard(),
+            [self = shared_from_this(),
+             data = std::move(m_DecryptNext),
+             queued = std::chrono::steady_clock::now()]() mutable {
+              self->DecryptWorker(std::move(data));
+              self->RecordCryptoLatency(queued);
+            });
         m_DecryptNext.clear();
       }
     }
 
+    void
+    Session::RecordCryptoLatency(std::chrono::steady_clock::time_point queued)
+    {
+      const auto elapsed = std::chrono::steady_clock::now() - queued;
+      const auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+      m_Histograms.cryptoLatency.Record(usecs);
+      cryptoLatency.Record(usecs);
+    }
+
+    void
+    Session::DrainHistograms(SessionHistograms& into)
+    {
+      m_Histograms.DrainInto(into);
+    }
+
     bool
     Session::GotRenegLIM(const LinkIntroMessage* lim)
     {
       LogDebug("renegotiate session on ", m_RemoteAddr);
+      HandleLIMFeatures(lim);
       return m_Parent->SessionRenegotiate(lim->rc, m_RemoteRC);
     }
 
@@ -317,7 +572,11 @@ namespace llarp
     Session::GetSessionStats() const
     {
       // TODO: thread safety
-      return m_Stats;
+      auto stats = m_Stats;
+      stats.totalDroppedRX = m_RXDropped.load(std::memory_order_relaxed);
+      stats.congestionWindow = m_CC.Window();
+      stats.smoothedRTT = m_CC.SmoothedRTT();
+      return stats;
     }
 
     util::StatusObject
@@ -329,6 +588,8 @@ namespace llarp
           {"txRateCurrent", m_Stats.currentRateTX},
           {"rxRateCurrent", m_Stats.currentRateRX},
           {"rxPktsRcvd", m_Stats.totalPacketsRX},
+          {"rxPktsDropped", m_RXDropped.load(std::memory_order_relaxed)},
+          {"rxBacklog", m_RXBacklog.load(std::memory_order_relaxed)},
 
           // leave 'tx' and 'rx' as duplicates of 'xRateCurrent' for compat
           {"tx", m_Stats.currentRateTX},
@@ -340,11 +601,16 @@ namespace llarp
 
           {"state", StateToString(m_State)},
           {"inbound", m_Inbound},
-          {"replayFilter", m_ReplayFilter.size()},
-          {"txMsgQueueSize", m_TXMsgs.size()},
-          {"rxMsgQueueSize", m_RXMsgs.size()},
+          {"replayFilter", m_ReplayFilter.Size()},
+          {"fragmentSize", m_TXFragmentSize},
+          {"rangeACKs", m_RangeACKs},
+          {"cipher", m_AES256GCM ? "aes256gcm" : "xchacha20"},
+          {"txMsgQueueSize", m_TXMsgs.Size()},
+          {"rxMsgQueueSize", m_RXMsgs.Size()},
+          {"congestion", m_CC.ExtractStatus()},
           {"remoteAddr", m_RemoteAddr.ToString()},
-          {"remoteRC", m_RemoteRC.ExtractStatus()},
+          {"remoteRC",
+           m_RemoteRCStatus.Get(m_RemoteRCVersion, [this] { return m_RemoteRC.ExtractStatus(); })},
           {"created", to_json(m_CreatedAt)},
           {"uptime", to_json(now - m_CreatedAt)}};
     }
@@ -387,53 +653,44 @@ namespace llarp
       }
       // remove pending outbound messsages that timed out
       // inform waiters
+      // (the timeout handler can queue new messages, so we take each message out of the window
+      // before informing it)
+      const auto timeout = m_CC.MessageTimeout();
+      for (const auto txid : m_TXMsgs.Select([now, timeout](uint64_t, const OutboundMessage& msg) {
+             return msg.IsTimedOut(now, timeout);
+           }))
       {
-        auto itr = m_TXMsgs.begin();
-        while (itr != m_TXMsgs.end())
+        m_Stats.totalDroppedTX++;
+        m_Stats.totalInFlightTX--;
+        txDropped.Inc();
+        LogTrace("Dropped unacked packet to ", m_RemoteAddr);
+        if (auto msg = m_TXMsgs.Take(txid))
         {
-          if (itr->second.IsTimedOut(now))
-          {
-            m_Stats.totalDroppedTX++;
-            m_Stats.totalInFlightTX--;
-            LogTrace("Dropped unacked packet to ", m_RemoteAddr);
-            itr->second.InformTimeout();
-            itr = m_TXMsgs.erase(itr);
-          }
-          else
-            ++itr;
+          if (msg->IsSent())
+            m_CC.OnLoss(now);
+          // a path that took our probe may not take larger fragments any more; don't keep
+          // sending into the black hole
+          if (m_TXFragmentSize > FragmentSize and msg->m_FragmentSize > FragmentSize
+              and msg->m_Data.size() > FragmentSize)
+            ResetFragmentSize(now);
+          msg->InformTimeout();
         }
       }
+      // remove pending inbound messages that timed out
+      for (const auto rxid : m_RXMsgs.Select([now, timeout](uint64_t, const InboundMessage& msg) {
+             return msg.IsTimedOut(now, timeout);
+           }))
       {
-        // remove pending inbound messages that timed out
-        auto itr = m_RXMsgs.begin();
-        while (itr != m_RXMsgs.end())
-        {
-          if (itr->second.IsTimedOut(now))
-          {
-            m_ReplayFilter.emplace(itr->first, now);
-            itr = m_RXMsgs.erase(itr);
-          }
-          else
-            ++itr;
-        }
-      }
-      {
-        // decay replay window
-        auto itr = m_ReplayFilter.begin();
-        while (itr != m_ReplayFilter.end())
-        {
-          if (itr->second + ReplayWindow <= now)
-          {
-            itr = m_ReplayFilter.erase(itr);
-          }
-          else
-            ++itr;
-        }
+        m_ReplayFilter.Insert(rxid);
+        m_RXMsgs.Erase(rxid);
       }
+      if (m_State == State::Ready)
+        ProbeMTU(now);
     }
 
     using Introduction =
         AlignedBuffer<PubKey::SIZE + PubKey::SIZE + TunnelNonce::SIZE + Signature::SIZE>;
+    static_assert(Introduction::SIZE + PacketOverhead == IntroPacketSize);
 
     void
     Session::GenerateAndSendIntro()
@@ -458,7 +715,16 @@ namespace llarp
             Z.size(),
             req.data() + PacketOverhead + (Introduction::SIZE - Signature::SIZE));
         CryptoManager::instance()->randbytes(req.data() + HMACSIZE, TUNNONCESIZE);
-        EncryptAndSend(std::move(req));
+        CryptoQueue_t pkts;
+        pkts.emplace_back(std::move(req));
+        fast_crypto::encrypt_packets(pkts, m_SessionKey);
+        auto& intro = pkts.front();
+        std::copy_n(intro.data(), m_IntroMAC.size(), m_IntroMAC.data());
+        // the cookie goes after the encrypted intro, where the remote can check it without
+        // decrypting anything
+        if (m_HandshakeCookie)
+          intro.insert(intro.end(), m_HandshakeCookie->begin(), m_HandshakeCookie->end());
+        Send_LL(pkts);
       }
       m_State = State::Introduction;
       if (not CryptoManager::instance()->transport_dh_client(
@@ -583,12 +849,30 @@ namespace llarp
       m_State = State::LinkIntro;
     }
 
+    void
+    Session::HandleCookieReply(Packet_t pkt)
+    {
+      // these are in the clear, so all a forged one can do is make us send our intro again
+      if (not std::equal(m_IntroMAC.begin(), m_IntroMAC.end(), pkt.data()))
+      {
+        LogDebug(m_Parent->PrintableName(), " cookie reply for another intro from ", m_RemoteAddr);
+        return;
+      }
+      LogDebug(m_RemoteAddr, " is busy, sending our intro again with its cookie");
+      m_LastRX = m_Parent->Now();
+      m_HandshakeCookie.emplace(pkt.data() + HMACSIZE);
+      // intros are encrypted to the remote's identity key, not the dh key we moved on to
+      CryptoManager::instance()->shorthash(m_SessionKey, llarp_buffer_t(m_RemoteRC.pubkey));
+      GenerateAndSendIntro();
+    }
+
     bool
     Session::DecryptMessageInPlace(Packet_t& pkt)
     {
       if (pkt.size() <= PacketOverhead)
       {
-        LogError("packet too small from ", m_RemoteAddr);
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "packet too small from ", m_RemoteAddr);
         return false;
       }
       const llarp_buffer_t buf(pkt);
@@ -596,9 +880,10 @@ namespace llarp
       llarp_buffer_t curbuf(buf.base, buf.sz);
       curbuf.base += ShortHash::SIZE;
       curbuf.sz -= ShortHash::SIZE;
-      if (not CryptoManager::instance()->hmac(H.data(), curbuf, m_SessionKey))
+      if (not fast_crypto::hmac(H.data(), curbuf, m_SessionKey))
       {
-        LogError("failed to caclulate keyed hash for ", m_RemoteAddr);
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "failed to caclulate keyed hash for ", m_RemoteAddr);
         return false;
       }
       const ShortHash expected{buf.base};
@@ -622,7 +907,7 @@ namespace llarp
       curbuf.base += 32;
       curbuf.sz -= 32;
       LogTrace("decrypt: ", curbuf.sz, " bytes from ", m_RemoteAddr);
-      return CryptoManager::instance()->xchacha20(curbuf, m_SessionKey, N);
+      return fast_crypto::xchacha20(curbuf, m_SessionKey, N);
     }
 
     void
@@ -636,26 +921,63 @@ namespace llarp
     void
     Session::HandleSessionData(Packet_t pkt)
     {
+      if (m_RXBacklog.load(std::memory_order_relaxed) >= MaxRXBacklog)
+      {
+        ShedRX(1);
+        util::BufferPool::Release(pkt);
+        return;
+      }
+      m_RXBacklog.fetch_add(1, std::memory_order_relaxed);
       m_DecryptNext.emplace_back(std::move(pkt));
       TriggerPump();
     }
 
+    void
+    Session::ShedRX(size_t n)
+    {
+      m_RXDropped.fetch_add(n, std::memory_order_relaxed);
+      rxDropped.Inc(n);
+      static logging::RateLimit limit{1s};
+      LogWarnLimited(limit, "receiving faster than we keep up with, dropping from ", m_RemoteAddr);
+    }
+
     void
     Session::DecryptWorker(CryptoQueue_t msgs)
     {
+      const size_t received = msgs.size();
+      // once the remote moves to aes256gcm (if we advertised it) both kinds can turn up together,
+      // as packets it sent before it switched can arrive after
+      CryptoQueue_t aesmsgs;
+      if (fast_crypto::aes256gcm_available())
+      {
+        const auto aes = std::stable_partition(msgs.begin(), msgs.end(), [](const auto& pkt) {
+          return not is_aes256gcm_packet(pkt);
+        });
+        aesmsgs.assign(std::make_move_iterator(aes), std::make_move_iterator(msgs.end()));
+        msgs.erase(aes, msgs.end());
+      }
+      size_t dropped = fast_crypto::decrypt_packets(msgs, m_SessionKey);
+      if (not aesmsgs.empty())
+      {
+        dropped += fast_crypto::aes256gcm_decrypt_packets(aesmsgs, m_SessionKey);
+        std::move(aesmsgs.begin(), aesmsgs.end(), std::back_inserter(msgs));
+      }
+      LLARP_TRACE(link_decrypted, this, msgs.size(), dropped);
+      if (dropped)
+      {
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(
+            limit, "failed to decrypt ", dropped, " session data packets from ", m_RemoteAddr);
+      }
       auto itr = msgs.begin();
       while (itr != msgs.end())
       {
         auto& pkt = *itr;
-        if (not DecryptMessageInPlace(pkt))
-        {
-          itr = msgs.erase(itr);
-          LogError("failed to decrypt session data from ", m_RemoteAddr);
-          continue;
-        }
         if (pkt[PacketOverhead] != llarp::constants::proto_version)
         {
-          LogError(
+          static logging::RateLimit limit{1s};
+          LogErrorLimited(
+              limit,
               "protocol version mismatch ",
               int(pkt[PacketOverhead]),
               " != ",
@@ -665,7 +987,17 @@ namespace llarp
         }
         ++itr;
       }
-      m_PlaintextRecv.tryPushBack(std::move(msgs));
+      // what failed to decrypt is out of the backlog here, the rest when it has been handled
+      m_RXBacklog.fetch_sub(received - msgs.size(), std::memory_order_relaxed);
+      const size_t n = msgs.size();
+      if (m_PlaintextRecv.tryPushBack(std::move(msgs)) != thread::QueueReturn::Success)
+      {
+        // Pump keeps this from happening, but don't lose track of them if it does
+        m_RXBacklog.fetch_sub(n, std::memory_order_relaxed);
+        --m_RXBatches;
+        ShedRX(n);
+        return;
+      }
       m_PlaintextEmpty.clear();
       m_Parent->WakeupPlaintext();
     }
@@ -675,107 +1007,232 @@ namespace llarp
     {
       if (m_PlaintextEmpty.test_and_set())
         return;
-      while (auto maybe_queue = m_PlaintextRecv.tryPopFront())
+      // a few of the crypto workers' batches at a time, into an array rather than a vector so that
+      // draining never allocates
+      std::array<CryptoQueue_t, 8> batches;
+      while (const auto n = m_PlaintextRecv.tryPopMany(batches.begin(), batches.size()))
       {
-        for (auto& result : *maybe_queue)
+        for (size_t idx = 0; idx < n; ++idx)
         {
-          LogTrace("Command ", int(result[PacketOverhead + 1]), " from ", m_RemoteAddr);
-          switch (result[PacketOverhead + 1])
+          m_RXBacklog.fetch_sub(batches[idx].size(), std::memory_order_relaxed);
+          --m_RXBatches;
+          for (auto& result : batches[idx])
           {
-            case Command::eXMIT:
-              HandleXMIT(std::move(result));
-              break;
-            case Command::eDATA:
-              HandleDATA(std::move(result));
-              break;
-            case Command::eACKS:
-              HandleACKS(std::move(result));
-              break;
-            case Command::ePING:
-              HandlePING(std::move(result));
-              break;
-            case Command::eNACK:
-              HandleNACK(std::move(result));
-              break;
-            case Command::eCLOS:
-              HandleCLOS(std::move(result));
-              break;
-            case Command::eMACK:
-              HandleMACK(std::move(result));
-              break;
-            default:
-              LogError("invalid command ", int(result[PacketOverhead + 1]), " from ", m_RemoteAddr);
+            LogTrace("Command ", int(result[PacketOverhead + 1]), " from ", m_RemoteAddr);
+            switch (result[PacketOverhead + 1])
+            {
+              case Command::eXMIT:
+                HandleXMIT(result);
+                break;
+              case Command::eDATA:
+                HandleDATA(result);
+                break;
+              case Command::eACKS:
+                HandleACKS(result);
+                break;
+              case Command::ePING:
+                HandlePING(result);
+                break;
+              case Command::eNACK:
+                HandleNACK(result);
+                break;
+              case Command::eCLOS:
+                HandleCLOS(result);
+                break;
+              case Command::eMACK:
+                HandleMACK(result);
+                break;
+              case Command::eMTUP:
+                HandleMTUP(result);
+                break;
+              case Command::eMTUA:
+                HandleMTUA(result);
+                break;
+              case Command::eRACK:
+                HandleRACK(result);
+                break;
+              default: {
+                static logging::RateLimit limit{1s};
+                LogErrorLimited(
+                    limit,
+                    "invalid command ",
+                    int(result[PacketOverhead + 1]),
+                    " from ",
+                    m_RemoteAddr);
+              }
+            }
           }
+          util::BufferPool::Release(batches[idx]);
         }
       }
       SendMACK();
+      // packets Pump held back for want of room can go to the workers now
+      if (not m_DecryptNext.empty())
+        TriggerPump();
       m_Parent->WakeupPlaintext();
     }
 
     void
-    Session::HandleMACK(Packet_t data)
+    Session::HandleMACK(Packet_t& data)
     {
       if (data.size() < (3 + PacketOverhead))
       {
-        LogError("impossibly short mack from ", m_RemoteAddr);
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "impossibly short mack from ", m_RemoteAddr);
         return;
       }
       byte_t numAcks = data[CommandOverhead + PacketOverhead];
       if (data.size() < 1 + CommandOverhead + PacketOverhead + (numAcks * sizeof(uint64_t)))
       {
-        LogError("short mack from ", m_RemoteAddr);
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "short mack from ", m_RemoteAddr);
         return;
       }
       LogTrace("got ", int(numAcks), " mack from ", m_RemoteAddr);
+      const auto now = m_Parent->Now();
       byte_t* ptr = data.data() + CommandOverhead + PacketOverhead + 1;
       while (numAcks > 0)
       {
         auto acked = oxenc::load_big_to_host<uint64_t>(ptr);
         LogTrace("mack containing txid=", acked, " from ", m_RemoteAddr);
-        auto itr = m_TXMsgs.find(acked);
-        if (itr != m_TXMsgs.end())
-        {
-          m_Stats.totalAckedTX++;
-          m_Stats.totalInFlightTX--;
-          itr->second.Completed();
-          m_TXMsgs.erase(itr);
-        }
-        else
-        {
-          LogTrace("ignored mack for txid=", acked, " from ", m_RemoteAddr);
-        }
+        HandleMessageACK(acked, now);
         ptr += sizeof(uint64_t);
         numAcks--;
       }
     }
 
     void
-    Session::HandleNACK(Packet_t data)
+    Session::HandleMessageACK(uint64_t txid, llarp_time_t now)
+    {
+      if (auto msg = m_TXMsgs.Take(txid))
+      {
+        m_Stats.totalAckedTX++;
+        m_Stats.totalInFlightTX--;
+        OnMessageAcked(*msg, msg->UnackedBytes(), now);
+        msg->Completed();
+      }
+      else
+      {
+        LogTrace("ignored mack for txid=", txid, " from ", m_RemoteAddr);
+      }
+    }
+
+    void
+    Session::HandleRACK(Packet_t& data)
+    {
+      if (data.size() < PacketOverhead + CommandOverhead)
+      {
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "impossibly short range ack from ", m_RemoteAddr);
+        return;
+      }
+      const auto rack = RangeACK::Decode(
+          data.data() + PacketOverhead + CommandOverhead,
+          data.size() - (PacketOverhead + CommandOverhead));
+      if (not rack)
+      {
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "malformed range ack from ", m_RemoteAddr);
+        return;
+      }
+      const auto now = m_Parent->Now();
+      m_LastRX = now;
+      // walk our tx window rather than the ranges, which a remote could make as wide as it likes
+      const auto acked = m_TXMsgs.Select(
+          [&rack](uint64_t txid, const OutboundMessage&) { return rack->Covers(txid); });
+      LogTrace("range ack for ", acked.size(), " messages from ", m_RemoteAddr);
+      for (const auto txid : acked)
+        HandleMessageACK(txid, now);
+      for (const auto& [txid, mask] : rack->partial)
+        HandleFragmentACK(txid, mask, now);
+    }
+
+    void
+    Session::HandleMTUP(Packet_t& data)
+    {
+      if (data.size() < (CommandOverhead + sizeof(uint16_t) + PacketOverhead))
+      {
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "short mtu probe from ", m_RemoteAddr);
+        return;
+      }
+      m_LastRX = m_Parent->Now();
+      const auto sz =
+          oxenc::load_big_to_host<uint16_t>(data.data() + CommandOverhead + PacketOverhead);
+      // only ack probes that got here whole
+      if (sz != data.size())
+      {
+        LogDebug("mtu probe of ", data.size(), " bytes claiming ", sz, " from ", m_RemoteAddr);
+        return;
+      }
+      auto ack = CreatePacket(Command::eMTUA, sizeof(uint16_t));
+      oxenc::write_host_as_big(sz, ack.data() + PacketOverhead + CommandOverhead);
+      EncryptAndSend(std::move(ack));
+    }
+
+    void
+    Session::HandleMTUA(Packet_t& data)
+    {
+      if (data.size() < (CommandOverhead + sizeof(uint16_t) + PacketOverhead))
+      {
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "short mtu probe ack from ", m_RemoteAddr);
+        return;
+      }
+      const auto now = m_Parent->Now();
+      m_LastRX = now;
+      const auto sz =
+          oxenc::load_big_to_host<uint16_t>(data.data() + CommandOverhead + PacketOverhead);
+      if (sz < MTUProbeSizes.back() or sz > MTUProbeSizes.front())
+      {
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "invalid mtu probe ack for ", sz, " bytes from ", m_RemoteAddr);
+        return;
+      }
+      const auto fragsize = static_cast<uint16_t>(sz - XMITWireOverhead);
+      // a late ack for a smaller probe than one we already adopted
+      if (fragsize <= m_TXFragmentSize)
+        return;
+      LogDebug(
+          "path to ", m_RemoteAddr, " takes ", sz, " bytes, using ", fragsize, " byte fragments");
+      m_TXFragmentSize = fragsize;
+      m_MTUProbeIndex = 0;
+      m_MTUProbeTries = 0;
+      // sizes are probed largest first, so this is as big as it gets until the path changes
+      m_NextMTUProbeAt = now + MTUReprobeInterval;
+    }
+
+    void
+    Session::HandleNACK(Packet_t& data)
     {
       if (data.size() < (CommandOverhead + sizeof(uint64_t) + PacketOverhead))
       {
-        LogError("short nack from ", m_RemoteAddr);
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "short nack from ", m_RemoteAddr);
         return;
       }
       auto txid = oxenc::load_big_to_host<uint64_t>(data.data() + CommandOverhead + PacketOverhead);
       LogTrace("got nack on ", txid, " from ", m_RemoteAddr);
-      auto itr = m_TXMsgs.find(txid);
-      if (itr != m_TXMsgs.end())
+      const auto now = m_Parent->Now();
+      if (auto* msg = m_TXMsgs.Find(txid))
       {
-        EncryptAndSend(itr->second.XMIT());
+        m_CC.OnLoss(now);
+        msg->m_Retransmitted = true;
+        EncryptAndSend(msg->XMIT());
       }
-      m_LastRX = m_Parent->Now();
+      m_LastRX = now;
     }
 
     void
-    Session::HandleXMIT(Packet_t data)
+    Session::HandleXMIT(Packet_t& data)
     {
       static constexpr size_t XMITOverhead =
           (CommandOverhead + PacketOverhead + sizeof(uint16_t) + sizeof(uint64_t)
            + ShortHash::SIZE);
       if (data.size() < XMITOverhead)
       {
-        LogError("short XMIT from ", m_RemoteAddr);
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "short XMIT from ", m_RemoteAddr);
         return;
       }
       auto* pos = data.data() + CommandOverhead + PacketOverhead;
@@ -789,8 +1246,7 @@ namespace llarp
       m_LastRX = m_Parent->Now();
       {
         // check for replay
-        auto itr = m_ReplayFilter.find(rxid);
-        if (itr != m_ReplayFilter.end())
+        if (m_ReplayFilter.Contains(rxid))
         {
           m_SendMACKs.emplace(rxid);
           LogTrace("duplicate rxid=", rxid, " from ", m_RemoteAddr);
@@ -799,54 +1255,63 @@ namespace llarp
       }
       {
         const auto now = m_Parent->Now();
-        auto itr = m_RXMsgs.find(rxid);
-        if (itr == m_RXMsgs.end())
+        // the first fragment rides along with the XMIT, so it tells us the fragment size the
+        // remote is sending this message with
+        const size_t payload = data.size() - XMITOverhead;
+        size_t fragsize = FragmentSize;
+        if (payload > FragmentSize and payload <= MaxFragmentSize and payload <= sz)
+          fragsize = payload;
+        auto [msg, inserted] = m_RXMsgs.Emplace(
+            rxid,
+            InboundMessage{rxid, sz, ShortHash{pos}, now, static_cast<uint16_t>(fragsize)});
+        if (inserted)
         {
-          itr = m_RXMsgs.emplace(rxid, InboundMessage{rxid, sz, ShortHash{pos}, m_Parent->Now()})
-                    .first;
           TriggerPump();
 
-          sz = std::min(sz, uint16_t{FragmentSize});
-          if ((data.size() - XMITOverhead) == sz)
+          if (payload == std::min<size_t>(sz, fragsize))
           {
             {
-              const llarp_buffer_t buf(data.data() + (data.size() - sz), sz);
-              itr->second.HandleData(0, buf, now);
-              if (not itr->second.IsCompleted())
+              const llarp_buffer_t buf(data.data() + XMITOverhead, payload);
+              msg->HandleData(0, buf, now);
+              if (not msg->IsCompleted())
               {
                 return;
               }
 
-              if (not itr->second.Verify())
+              if (not msg->Verify())
               {
-                LogError("bad short xmit hash from ", m_RemoteAddr);
+                static logging::RateLimit limit{1s};
+                LogErrorLimited(limit, "bad short xmit hash from ", m_RemoteAddr);
                 return;
               }
             }
-            HandleRecvMsgCompleted(itr->second);
+            HandleRecvMsgCompleted(*msg);
           }
         }
-        else
+        else if (msg)
           LogTrace("got duplicate xmit on ", rxid, " from ", m_RemoteAddr);
+        else
+          LogDebug("dropping xmit for rxid=", rxid, " outside rx window from ", m_RemoteAddr);
       }
     }
 
     void
-    Session::HandleDATA(Packet_t data)
+    Session::HandleDATA(Packet_t& data)
     {
       if (data.size() < (CommandOverhead + sizeof(uint16_t) + sizeof(uint64_t) + PacketOverhead))
       {
-        LogError("short DATA from ", m_RemoteAddr, " ", data.size());
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "short DATA from ", m_RemoteAddr, " ", data.size());
         return;
       }
       m_LastRX = m_Parent->Now();
       auto sz = oxenc::load_big_to_host<uint16_t>(data.data() + CommandOverhead + PacketOverhead);
       auto rxid = oxenc::load_big_to_host<uint64_t>(
           data.data() + CommandOverhead + sizeof(uint16_t) + PacketOverhead);
-      auto itr = m_RXMsgs.find(rxid);
-      if (itr == m_RXMsgs.end())
+      auto* msg = m_RXMsgs.Find(rxid);
+      if (not msg)
       {
-        if (m_ReplayFilter.find(rxid) == m_ReplayFilter.end())
+        if (not m_ReplayFilter.Contains(rxid))
         {
           LogTrace("no rxid=", rxid, " for ", m_RemoteAddr);
           auto nack = CreatePacket(Command::eNACK, 8);
@@ -864,18 +1329,19 @@ namespace llarp
       {
         const llarp_buffer_t buf(
             data.data() + PacketOverhead + 12, data.size() - (PacketOverhead + 12));
-        itr->second.HandleData(sz, buf, m_Parent->Now());
+        msg->HandleData(sz, buf, m_Parent->Now());
       }
 
-      if (itr->second.IsCompleted())
+      if (msg->IsCompleted())
       {
-        if (itr->second.Verify())
+        if (msg->Verify())
         {
-          HandleRecvMsgCompleted(itr->second);
+          HandleRecvMsgCompleted(*msg);
         }
         else
         {
-          LogError("hash mismatch for message ", itr->first);
+          static logging::RateLimit limit{1s};
+          LogErrorLimited(limit, "hash mismatch for message ", rxid);
         }
       }
     }
@@ -884,55 +1350,78 @@ namespace llarp
     Session::HandleRecvMsgCompleted(const InboundMessage& msg)
     {
       const auto rxid = msg.m_MsgID;
-      if (m_ReplayFilter.emplace(rxid, m_Parent->Now()).second)
+      if (m_ReplayFilter.Insert(rxid))
       {
+        rxMessages.Inc();
+        if (auto* recorder = m_Parent->Recorder())
+          recorder->Record(
+              LinkRecorder::Direction::Inbound, GetPubKey().data(), llarp_buffer_t{msg.m_Data});
         m_Parent->HandleMessage(this, msg.m_Data);
-        EncryptAndSend(msg.ACKS());
+        if (m_RangeACKs)
+          m_SendMACKs.emplace(rxid);
+        else
+          EncryptAndSend(msg.ACKS());
         LogDebug("recv'd message ", rxid, " from ", m_RemoteAddr);
       }
-      m_RXMsgs.erase(rxid);
+      m_RXMsgs.Erase(rxid);
     }
 
     void
-    Session::HandleACKS(Packet_t data)
+    Session::HandleACKS(Packet_t& data)
     {
       if (data.size() < (11 + PacketOverhead))
       {
-        LogError("short ACKS from ", m_RemoteAddr);
+        static logging::RateLimit limit{1s};
+        LogErrorLimited(limit, "short ACKS from ", m_RemoteAddr);
         return;
       }
       const auto now = m_Parent->Now();
       m_LastRX = now;
       auto txid = oxenc::load_big_to_host<uint64_t>(data.data() + 2 + PacketOverhead);
-      auto itr = m_TXMsgs.find(txid);
-      if (itr == m_TXMsgs.end())
+      HandleFragmentACK(txid, data[10 + PacketOverhead], now);
+    }
+
+    void
+    Session::HandleFragmentACK(uint64_t txid, byte_t mask, llarp_time_t now)
+    {
+      auto* msg = m_TXMsgs.Find(txid);
+      if (not msg)
       {
         LogTrace("no txid=", txid, " for ", m_RemoteAddr);
         return;
       }
-      itr->second.Ack(data[10 + PacketOverhead]);
+      const auto unacked = msg->UnackedBytes();
+      msg->Ack(mask);
 
-      if (itr->second.IsTransmitted())
+      if (msg->IsTransmitted())
       {
-        LogDebug("sent message ", itr->first, " to ", m_RemoteAddr);
-        itr->second.Completed();
-        itr = m_TXMsgs.erase(itr);
+        LogDebug("sent message ", txid, " to ", m_RemoteAddr);
+        OnMessageAcked(*msg, unacked, now);
+        // take it out first: the completion handler may queue new messages
+        m_TXMsgs.Take(txid)->Completed();
       }
       else
       {
-        itr->second.FlushUnAcked(util::memFn(&Session::EncryptAndSend, this), now);
+        m_CC.OnAcked(unacked - std::min(unacked, msg->UnackedBytes()));
+        // anything still unacked that went out at least a round trip ago is lost; anything more
+        // recent may just not have arrived yet
+        if (now - msg->m_LastFlush >= m_CC.SmoothedRTT())
+        {
+          msg->Retransmit(util::memFn(&Session::EncryptAndSend, this), now);
+          txRetransmits.Inc();
+        }
       }
     }
 
     void
-    Session::HandleCLOS(Packet_t)
+    Session::HandleCLOS(Packet_t&)
     {
       LogInfo("remote closed by ", m_RemoteAddr);
       Close();
     }
 
     void
-    Session::HandlePING(Packet_t)
+    Session::HandlePING(Packet_t&)
     {
       m_LastRX = m_Parent->Now();
     }
@@ -957,6 +1446,7 @@ namespace llarp
     bool
     Session::Recv_LL(ILinkSession::Packet_t data)
     {
+      LLARP_TRACE(link_recv, this, data.size());
       m_RXRate += data.size();
 
       // TODO: differentiate between good and bad RX packets here
@@ -985,6 +1475,11 @@ namespace llarp
             // we are replying to an intro ack
             HandleCreateSessionRequest(std::move(data));
           }
+          else if (data.size() == CookieReplySize)
+          {
+            // the remote is under load and wants proof we can receive from it
+            HandleCookieReply(std::move(data));
+          }
           else
           {
             // we got an intro ack
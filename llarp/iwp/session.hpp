@@ -1,15 +1,21 @@
 #pragma once
 
 #include <llarp/link/session.hpp>
+#include "congestion.hpp"
 #include "linklayer.hpp"
 #include "message_buffer.hpp"
 #include <llarp/net/ip_address.hpp>
 
+#include <array>
 #include <map>
 #include <unordered_set>
 #include <deque>
 
+#include <llarp/util/mem_account.hpp>
 #include <llarp/util/priority_queue.hpp>
+#include <llarp/util/replay_window.hpp>
+#include <llarp/util/sequence_window.hpp>
+#include <llarp/util/status.hpp>
 #include <llarp/util/thread/queue.hpp>
 
 namespace llarp
@@ -21,20 +27,49 @@ namespace llarp
     /// creates a packet with plaintext size + wire overhead + random pad
     ILinkSession::Packet_t
     CreatePacket(Command cmd, size_t plainsize, size_t min_pad = 16, size_t pad_variance = 16);
-    /// Time how long we try delivery for
+    /// Time how long we try delivery for, at least; long round trip paths get longer (see
+    /// CongestionControl::MessageTimeout)
     static constexpr std::chrono::milliseconds DeliveryTimeout = 500ms;
     /// Time how long we wait to recieve a message
     static constexpr auto ReceivalTimeout = (DeliveryTimeout * 8) / 5;
-    /// How long to keep a replay window for
-    static constexpr auto ReplayWindow = (ReceivalTimeout * 3) / 2;
-    /// How often to acks RX messages
+    /// How often to acks RX messages, at least; we ack every half retransmit timeout if that is
+    /// longer
     static constexpr auto ACKResendInterval = DeliveryTimeout / 2;
-    /// How often to retransmit TX fragments
-    static constexpr auto TXFlushInterval = (DeliveryTimeout / 5) * 4;
     /// How often we send a keepalive
     static constexpr std::chrono::milliseconds PingInterval = 5s;
     /// How long we wait for a session to die with no tx from them
     static constexpr auto SessionAliveTimeout = PingInterval * 5;
+    /// size of an intro on the wire: our identity and transport keys, nonce and signature
+    static constexpr size_t IntroPacketSize =
+        PacketOverhead + PubKey::SIZE + PubKey::SIZE + TunnelNonce::SIZE + Signature::SIZE;
+    /// a cookie reply echoes the keyed hash of the intro it answers, then gives the cookie.  sent
+    /// in the clear; the echo is what keeps anyone who didn't see our intro from forging one.
+    /// an intro retried with a cookie carries it in the clear after the encrypted intro.
+    static constexpr size_t CookieReplySize = HMACSIZE + HandshakeCookie::SIZE;
+    /// inbound handshakes per second above which we want a cookie before starting one
+    static constexpr size_t CookieHandshakeRate = 100;
+    /// how often we change the secret cookies are made with
+    static constexpr auto CookieSecretLifetime = 2min;
+    /// wire size of an XMIT less the fragment it carries
+    static constexpr size_t XMITWireOverhead = PacketOverhead + CommandOverhead + XMITHeaderSize;
+    /// udp payload sizes we probe the path with once a session is up, largest first; each one is
+    /// an XMIT carrying a fragment of size - XMITWireOverhead, so 1452 fills a 1500 byte ipv6 MTU
+    /// and 1232 fits the ipv6 minimum of 1280
+    static constexpr std::array<size_t, 3> MTUProbeSizes{1452, 1392, 1232};
+    static_assert(MTUProbeSizes.front() - XMITWireOverhead == MaxFragmentSize);
+    static_assert(MTUProbeSizes.back() - XMITWireOverhead > FragmentSize);
+    /// how many times we send a probe size before trying the next one down
+    static constexpr int MTUProbeAttempts = 2;
+    /// how long we wait to probe again after no probe got through, or after larger fragments
+    /// stopped getting through
+    static constexpr auto MTUReprobeInterval = 10min;
+    /// largest eRACK body we send
+    static constexpr size_t MaxRangeACKSize = 1024;
+    /// with range acks, how long acks may wait to be coalesced with later ones, and how many we
+    /// let pile up before sending regardless; kept well under any round trip so the delay it adds
+    /// to rtt samples stays in the noise
+    static constexpr auto ACKCoalesceDelay = 5ms;
+    static constexpr size_t ACKCoalesceCount = 64;
 
     struct Session : public ILinkSession, public std::enable_shared_from_this<Session>
     {
@@ -68,6 +103,10 @@ namespace llarp
       void
       Send_LL(const byte_t* buf, size_t sz);
 
+      /// send a batch of encrypted packets to the remote in as few syscalls as we can
+      void
+      Send_LL(const std::vector<Packet_t>& pkts);
+
       void EncryptAndSend(ILinkSession::Packet_t);
 
       void
@@ -108,7 +147,7 @@ namespace llarp
       size_t
       SendQueueBacklog() const override
       {
-        return m_TXMsgs.size();
+        return m_TXMsgs.Size();
       }
 
       ILinkLayer*
@@ -123,12 +162,21 @@ namespace llarp
       bool
       ShouldPing() const override;
 
+      llarp_time_t
+      NextPingAt() const override
+      {
+        return m_LastTX + PingInterval;
+      }
+
       SessionStats
       GetSessionStats() const override;
 
       util::StatusObject
       ExtractStatus() const override;
 
+      void
+      DrainHistograms(SessionHistograms& into) override;
+
       bool
       IsInbound() const override
       {
@@ -166,6 +214,9 @@ namespace llarp
       AddressInfo m_ChosenAI;
       /// remote rc
       RouterContact m_RemoteRC;
+      /// bumped whenever m_RemoteRC is replaced, so its status is only built again then
+      uint64_t m_RemoteRCVersion = 0;
+      util::CachedStatus m_RemoteRCStatus;
       /// session key
       SharedSecret m_SessionKey;
       /// session token
@@ -174,6 +225,11 @@ namespace llarp
       PubKey m_ExpectedIdent;
       PubKey m_RemoteOnionKey;
 
+      /// keyed hash of the last intro we sent, that a cookie reply must echo
+      ShortHash m_IntroMAC;
+      /// cookie the remote wants our intros to carry, once it has sent us one
+      std::optional<HandshakeCookie> m_HandshakeCookie;
+
       llarp_time_t m_LastTX = 0s;
       llarp_time_t m_LastRX = 0s;
 
@@ -185,19 +241,51 @@ namespace llarp
 
       uint64_t m_TXID = 0;
 
+      CongestionControl m_CC;
+      /// recorded from the event loop and crypto workers alike; the histograms are lock free
+      SessionHistograms m_Histograms;
+      /// set while we have a timer waiting to pump paced out sends
+      bool m_PacingTimerArmed = false;
+
+      /// fragment size new outbound messages are sent with; FragmentSize until a probe gets an
+      /// ack for something larger
+      uint16_t m_TXFragmentSize = FragmentSize;
+      /// index into MTUProbeSizes of the size we are probing
+      size_t m_MTUProbeIndex = 0;
+      /// how many times we have sent the current probe size
+      int m_MTUProbeTries = 0;
+      /// when we next send a probe
+      llarp_time_t m_NextMTUProbeAt = 0s;
+
       bool
       ShouldResetRates(llarp_time_t now) const;
 
       void
       ResetRates();
 
-      std::map<uint64_t, InboundMessage> m_RXMsgs;
-      std::map<uint64_t, OutboundMessage> m_TXMsgs;
+      /// in flight messages keyed by message id; ids are sequential so these are ring windows
+      /// rather than trees
+      util::SequenceWindow<InboundMessage> m_RXMsgs{MaxSendQueueSize};
+      util::SequenceWindow<OutboundMessage> m_TXMsgs{MaxSendQueueSize};
 
-      /// maps rxid to time recieved
-      std::unordered_map<uint64_t, llarp_time_t> m_ReplayFilter;
+      /// rxids we have completed or given up on; wide enough to cover every rxid the rx window can
+      /// hold at once
+      util::ReplayWindow<MaxSendQueueSize * 2> m_ReplayFilter;
       /// rx messages to send in next round of multiacks
       util::ascending_priority_queue<uint64_t> m_SendMACKs;
+      /// set once the remote's LIM says it takes eRACK; from then on we ack only with those
+      bool m_RangeACKs = false;
+      /// set once we and the remote have both advertised link_features::AES256GCM; from then on we
+      /// send with it.  what we receive is told apart per packet, so packets already in flight
+      /// when either side switches still get through.  read by the crypto workers.
+      std::atomic<bool> m_AES256GCM{false};
+      /// counter for the gcm nonces of the packets we send.  both sides send under the same key,
+      /// so the nonces start with which side we are (see EncryptWorker)
+      std::atomic<uint64_t> m_TXNonceCounter{0};
+      /// fragment acks waiting for the next eRACK; fully received messages wait in m_SendMACKs
+      RangeACK m_SendRangeACK;
+      /// set while we have a timer waiting to send coalesced acks
+      bool m_ACKTimerArmed = false;
 
       using CryptoQueue_t = std::vector<Packet_t>;
 
@@ -206,20 +294,51 @@ namespace llarp
 
       std::atomic_flag m_PlaintextEmpty;
       llarp::thread::Queue<CryptoQueue_t> m_PlaintextRecv;
+      /// packets received but not yet handled: waiting in m_DecryptNext, with a crypto worker or
+      /// in m_PlaintextRecv.  past MaxRXBacklog we drop what comes in before spending any crypto
+      /// on it, so a logic thread that falls behind pushes back on the remote (which resends,
+      /// and slows down as it sees the loss) rather than on our memory
+      std::atomic<size_t> m_RXBacklog{0};
+      /// batches handed to the crypto workers and not yet drained from m_PlaintextRecv; we hold
+      /// new ones back in m_DecryptNext while there is no room for them to land
+      std::atomic<size_t> m_RXBatches{0};
+      /// packets dropped on the way in, counted from the crypto workers too
+      std::atomic<uint64_t> m_RXDropped{0};
       std::atomic_flag m_SentClosed;
 
+      util::MemCharge<util::MemTag::Link> m_MemCharge{sizeof(Session)};
+
+      /// which crypto worker our batches go to when the router has dedicated ones; keyed by remote
+      /// router so a session always lands on the same thread
+      uint64_t
+      CryptoShard() const
+      {
+        return std::hash<PubKey>{}(m_RemoteRC.pubkey);
+      }
+
       void
       EncryptWorker(CryptoQueue_t msgs);
 
+      /// called by a crypto worker when done with a batch handed to it at queued
+      void
+      RecordCryptoLatency(std::chrono::steady_clock::time_point queued);
+
       void
       DecryptWorker(CryptoQueue_t msgs);
 
+      /// counts n packets dropped on the way in; called from the crypto workers too
+      void
+      ShedRX(size_t n);
+
       void
       HandleGotIntro(Packet_t pkt);
 
       void
       HandleGotIntroAck(Packet_t pkt);
 
+      void
+      HandleCookieReply(Packet_t pkt);
+
       void
       HandleCreateSessionRequest(Packet_t pkt);
 
@@ -232,15 +351,56 @@ namespace llarp
       bool
       DecryptMessageInPlace(Packet_t& pkt);
 
+      /// send pending multiacks; with range acks, coalesce them (see ScheduleRangeACK)
       void
       SendMACK();
 
+      /// send acks now if enough are waiting, otherwise make sure they go out within
+      /// ACKCoalesceDelay
+      void
+      ScheduleRangeACK();
+
+      /// send everything waiting as eRACKs
+      void
+      SendRangeACK();
+
+      /// the remote has every fragment of txid
+      void
+      HandleMessageACK(uint64_t txid, llarp_time_t now);
+
+      /// the remote has the fragments of txid in mask
+      void
+      HandleFragmentACK(uint64_t txid, byte_t mask, llarp_time_t now);
+
+      /// send the next path mtu probe if one is due
+      void
+      ProbeMTU(llarp_time_t now);
+
+      /// go back to FragmentSize, e.g. when a message sent with larger fragments timed out as the
+      /// path MTU may have shrunk
+      void
+      ResetFragmentSize(llarp_time_t now);
+
+      /// send what the congestion window and pacing allow from the tx window: retransmits first,
+      /// then new messages by priority
+      void
+      FlushTX(llarp_time_t now);
+
+      /// take a round trip sample (if unambiguous) and credit the window with the acked bytes for a
+      /// message the remote has fully acked
+      void
+      OnMessageAcked(const OutboundMessage& msg, size_t acked, llarp_time_t now);
+
       void
       HandleRecvMsgCompleted(const InboundMessage& msg);
 
       void
       GenerateAndSendIntro();
 
+      /// take up what the remote's LIM says it supports
+      void
+      HandleLIMFeatures(const LinkIntroMessage* msg);
+
       bool
       GotInboundLIM(const LinkIntroMessage* msg);
 
@@ -254,25 +414,34 @@ namespace llarp
       SendOurLIM(ILinkSession::CompletionHandler h = nullptr);
 
       void
-      HandleXMIT(Packet_t msg);
+      HandleXMIT(Packet_t& msg);
+
+      void
+      HandleDATA(Packet_t& msg);
+
+      void
+      HandleACKS(Packet_t& msg);
+
+      void
+      HandleNACK(Packet_t& msg);
 
       void
-      HandleDATA(Packet_t msg);
+      HandlePING(Packet_t& msg);
 
       void
-      HandleACKS(Packet_t msg);
+      HandleCLOS(Packet_t& msg);
 
       void
-      HandleNACK(Packet_t msg);
+      HandleMACK(Packet_t& msg);
 
       void
-      HandlePING(Packet_t msg);
+      HandleRACK(Packet_t& msg);
 
       void
-      HandleCLOS(Packet_t msg);
+      HandleMTUP(Packet_t& msg);
 
       void
-      HandleMACK(Packet_t msg);
+      HandleMTUA(Packet_t& msg);
     };
   }  // namespace iwp
 }  // namespace llarp
@@ -3,6 +3,7 @@
 #include "i_link_manager.hpp"
 
 #include <llarp/util/compare_ptr.hpp>
+#include <llarp/util/decaying_hashset.hpp>
 #include "server.hpp"
 
 #include <unordered_map>
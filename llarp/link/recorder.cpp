@@ -0,0 +1,148 @@
+#include "recorder.hpp"
+
+#include <llarp/constants/link_layer.hpp>
+#include <llarp/util/logging.hpp>
+
+#include <array>
+#include <stdexcept>
+
+namespace llarp
+{
+  static auto logcat = log::Cat("link-recorder");
+
+  LinkRecorder::LinkRecorder(
+      const fs::path& file, bool payloads, uint64_t maxBytes, DiskFunc_t disk)
+      : m_File{std::make_shared<fs::ofstream>(file, std::ios::binary | std::ios::trunc)}
+      , m_Payloads{payloads}
+      , m_MaxBytes{maxBytes}
+      , m_Disk{std::move(disk)}
+      , m_Last{std::chrono::steady_clock::now()}
+  {
+    if (not *m_File)
+      throw std::runtime_error{fmt::format("cannot write link recording to {}", file)};
+    m_Pending.reserve(FlushSize + MAX_LINK_MSG_SIZE + 32);
+    m_Pending.insert(m_Pending.end(), Magic.begin(), Magic.end());
+    m_Pending.push_back(m_Payloads ? 1 : 0);
+    m_Bytes = m_Pending.size();
+  }
+
+  LinkRecorder::~LinkRecorder()
+  {
+    Flush();
+  }
+
+  void
+  LinkRecorder::PutVarint(uint64_t v)
+  {
+    while (v >= 0x80)
+    {
+      m_Pending.push_back(static_cast<byte_t>(v | 0x80));
+      v >>= 7;
+    }
+    m_Pending.push_back(static_cast<byte_t>(v));
+  }
+
+  void
+  LinkRecorder::Record(Direction dir, const RouterID& remote, const llarp_buffer_t& msg)
+  {
+    if (m_Full)
+      return;
+    // a record's header is at most a few varints
+    if (m_Bytes + (m_Payloads ? msg.sz : 0) + 32 > m_MaxBytes)
+    {
+      m_Full = true;
+      log::warning(logcat, "link recording reached {} bytes, stopped recording", m_Bytes);
+      Flush();
+      return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(now - m_Last);
+    m_Last = now;
+    const auto [itr, inserted] = m_Sessions.try_emplace(remote, m_Sessions.size());
+
+    const auto before = m_Pending.size();
+    PutVarint(delta.count());
+    m_Pending.push_back(static_cast<byte_t>(dir));
+    PutVarint(itr->second);
+    PutVarint(msg.sz);
+    if (m_Payloads)
+      m_Pending.insert(m_Pending.end(), msg.base, msg.base + msg.sz);
+    m_Bytes += m_Pending.size() - before;
+    ++m_Records;
+    if (m_Pending.size() >= FlushSize)
+      Flush();
+  }
+
+  void
+  LinkRecorder::Flush()
+  {
+    if (m_Pending.empty())
+      return;
+    auto write = [file = m_File, data = std::move(m_Pending)] {
+      file->write(reinterpret_cast<const char*>(data.data()), data.size());
+      file->flush();
+      if (not *file)
+        log::warning(logcat, "failed to write link recording");
+    };
+    m_Pending = {};
+    m_Pending.reserve(FlushSize + MAX_LINK_MSG_SIZE + 32);
+    if (m_Disk)
+      m_Disk(std::move(write));
+    else
+      write();
+  }
+
+  LinkRecorder::Reader::Reader(const fs::path& file) : m_File{file, std::ios::binary}
+  {
+    std::array<char, Magic.size() + 1> header;
+    if (not m_File.read(header.data(), header.size())
+        or std::string_view{header.data(), Magic.size()} != Magic or (header.back() & ~1) != 0)
+      throw std::runtime_error{fmt::format("{} is not a link recording", file)};
+    m_Payloads = header.back() & 1;
+  }
+
+  std::optional<LinkRecorder::Entry>
+  LinkRecorder::Reader::Next()
+  {
+    const auto getVarint = [this](bool first = false) -> std::optional<uint64_t> {
+      uint64_t v = 0;
+      for (int shift = 0; shift < 64; shift += 7)
+      {
+        const int c = m_File.get();
+        if (c == std::char_traits<char>::eof())
+        {
+          if (first and shift == 0)
+            return std::nullopt;
+          throw std::runtime_error{"link recording is cut short"};
+        }
+        v |= uint64_t(c & 0x7f) << shift;
+        if (not(c & 0x80))
+          return v;
+      }
+      throw std::runtime_error{"corrupt varint in link recording"};
+    };
+
+    const auto delta = getVarint(true);
+    if (not delta)
+      return std::nullopt;
+    Entry entry;
+    m_At += std::chrono::microseconds{*delta};
+    entry.at = m_At;
+    const int dir = m_File.get();
+    if (dir != 0 and dir != 1)
+      throw std::runtime_error{"corrupt direction in link recording"};
+    entry.dir = static_cast<Direction>(dir);
+    entry.session = *getVarint();
+    const auto size = *getVarint();
+    if (size > MAX_LINK_MSG_SIZE)
+      throw std::runtime_error{"oversized message in link recording"};
+    entry.size = size;
+    if (m_Payloads)
+    {
+      entry.msg.resize(entry.size);
+      if (not m_File.read(reinterpret_cast<char*>(entry.msg.data()), entry.size))
+        throw std::runtime_error{"link recording is cut short"};
+    }
+    return entry;
+  }
+}  // namespace llarp
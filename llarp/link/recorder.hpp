@@ -0,0 +1,138 @@
+#pragma once
+
+#include <llarp/router_id.hpp>
+#include <llarp/util/buffer.hpp>
+#include <llarp/util/fs.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp
+{
+  /// records the link messages a router sends and receives to a file, for replaying real traffic
+  /// through the message handling offline (see test/bench/bench_link_replay.cpp).  remotes are
+  /// numbered in the order we first see them rather than written out, and the messages themselves
+  /// are only kept when asked for.
+  ///
+  /// the file is "lokilnk1", a flags byte (bit 0: records carry their message), then one record a
+  /// message:
+  ///     varint microseconds since the record before (or since recording started)
+  ///     byte   direction: 0 received, 1 sent
+  ///     varint session: which remote, numbered from 0 in the order first seen
+  ///     varint message size
+  ///     the message, if the flags say so
+  /// varints are unsigned LEB128.
+  class LinkRecorder
+  {
+   public:
+    using DiskFunc_t = std::function<void(std::function<void(void)>)>;
+
+    static constexpr std::string_view Magic{"lokilnk1"};
+    /// how much we collect in memory before it goes to disk
+    static constexpr size_t FlushSize = 256 * 1024;
+
+    enum class Direction : uint8_t
+    {
+      Inbound = 0,
+      Outbound = 1,
+    };
+
+    /// opens file, throwing if it can't.  disk, if given, runs the writes, so that the thread
+    /// recording never waits on the file; they have to be run in the order they were queued.
+    /// past maxBytes of recording we stop, keeping what we have.
+    LinkRecorder(const fs::path& file, bool payloads, uint64_t maxBytes, DiskFunc_t disk = nullptr);
+
+    /// writes out what has not been yet
+    ~LinkRecorder();
+
+    LinkRecorder(const LinkRecorder&) = delete;
+    LinkRecorder&
+    operator=(const LinkRecorder&) = delete;
+
+    /// records one whole link message; not thread safe, so call it from one thread only
+    void
+    Record(Direction dir, const RouterID& remote, const llarp_buffer_t& msg);
+
+    /// hands what we have collected so far to be written
+    void
+    Flush();
+
+    /// how many messages we recorded
+    uint64_t
+    Records() const
+    {
+      return m_Records;
+    }
+
+    /// how big the recording is so far
+    uint64_t
+    Bytes() const
+    {
+      return m_Bytes;
+    }
+
+    /// true once we have stopped recording for having hit maxBytes
+    bool
+    Full() const
+    {
+      return m_Full;
+    }
+
+    /// one record, as read back
+    struct Entry
+    {
+      /// since recording started
+      std::chrono::microseconds at;
+      Direction dir;
+      uint32_t session;
+      uint32_t size;
+      /// empty unless the recording has messages
+      std::vector<byte_t> msg;
+    };
+
+    /// reads a recording back
+    class Reader
+    {
+     public:
+      /// opens file, throwing if it can't or it isn't a recording
+      explicit Reader(const fs::path& file);
+
+      /// true if the records carry their messages
+      bool
+      Payloads() const
+      {
+        return m_Payloads;
+      }
+
+      /// the next record, or nullopt at the end; throws on a record that is cut short or corrupt
+      std::optional<Entry>
+      Next();
+
+     private:
+      fs::ifstream m_File;
+      bool m_Payloads;
+      std::chrono::microseconds m_At{0};
+    };
+
+   private:
+    void
+    PutVarint(uint64_t v);
+
+    std::shared_ptr<fs::ofstream> m_File;
+    const bool m_Payloads;
+    const uint64_t m_MaxBytes;
+    DiskFunc_t m_Disk;
+    std::vector<byte_t> m_Pending;
+    std::unordered_map<RouterID, uint32_t> m_Sessions;
+    std::chrono::steady_clock::time_point m_Last;
+    uint64_t m_Records = 0;
+    uint64_t m_Bytes = 0;
+    bool m_Full = false;
+  };
+}  // namespace llarp
@@ -1,10 +1,14 @@
 #include "server.hpp"
+#include "recorder.hpp"
 #include <llarp/ev/ev.hpp>
 #include <llarp/ev/udp_handle.hpp>
+#include <llarp/ev/udp_receiver.hpp>
 #include <llarp/crypto/crypto.hpp>
 #include <llarp/config/key_manager.hpp>
 #include <memory>
+#include <llarp/util/buffer_pool.hpp>
 #include <llarp/util/fs.hpp>
+#include <llarp/util/metrics.hpp>
 #include <utility>
 #include <unordered_set>
 #include <llarp/router/abstractrouter.hpp>
@@ -14,6 +18,14 @@ static constexpr auto LINK_LAYER_TICK_INTERVAL = 100ms;
 
 namespace llarp
 {
+  namespace
+  {
+    metrics::Counter txPackets{"lokinet_link_tx_packets_total", "UDP packets the links sent"};
+    metrics::Counter txBytes{"lokinet_link_tx_bytes_total", "Bytes of UDP packets the links sent"};
+    metrics::Counter txFailed{
+        "lokinet_link_tx_failed_total", "UDP sends the links could not hand to the socket"};
+  }  // namespace
+
   ILinkLayer::ILinkLayer(
       std::shared_ptr<KeyManager> keyManager,
       GetRCFunc getrc,
@@ -40,6 +52,8 @@ namespace llarp
       , m_SecretKey(keyManager->transportKey)
   {}
 
+  ILinkLayer::~ILinkLayer() = default;
+
   llarp_time_t
   ILinkLayer::Now() const
   {
@@ -49,84 +63,55 @@ namespace llarp
   bool
   ILinkLayer::HasSessionTo(const RouterID& id)
   {
-    Lock_t l(m_AuthedLinksMutex);
-    return m_AuthedLinks.find(id) != m_AuthedLinks.end();
+    return m_AuthedLinks.Read([&id](const auto& links) { return links.count(id) > 0; });
   }
 
   std::shared_ptr<ILinkSession>
   ILinkLayer::FindSessionByPubkey(RouterID id)
   {
-    Lock_t l(m_AuthedLinksMutex);
-    auto itr = m_AuthedLinks.find(id);
-    if (itr == m_AuthedLinks.end())
-      return nullptr;
-    return itr->second;
+    return m_AuthedLinks.Read([&id](const auto& links) -> std::shared_ptr<ILinkSession> {
+      auto itr = links.find(id);
+      if (itr == links.end())
+        return nullptr;
+      return itr->second;
+    });
   }
 
   void
   ILinkLayer::ForEachSession(std::function<void(const ILinkSession*)> visit, bool randomize) const
   {
-    std::vector<std::shared_ptr<ILinkSession>> sessions;
-    {
-      Lock_t l(m_AuthedLinksMutex);
-      if (m_AuthedLinks.size() == 0)
+    // the snapshot keeps every session in it alive until we are done, so there is no need to
+    // copy them out first
+    m_AuthedLinks.Read([&](const auto& links) {
+      if (links.empty())
         return;
-      const size_t sz = randint() % m_AuthedLinks.size();
-      auto itr = m_AuthedLinks.begin();
-      auto begin = itr;
-      if (randomize)
-      {
-        std::advance(itr, sz);
-        begin = itr;
-      }
-      while (itr != m_AuthedLinks.end())
-      {
-        sessions.emplace_back(itr->second);
-        ++itr;
-      }
+      auto itr = links.begin();
       if (randomize)
-      {
-        itr = m_AuthedLinks.begin();
-        while (itr != begin)
-        {
-          sessions.emplace_back(itr->second);
-          ++itr;
-        }
-      }
-    }
-    for (const auto& session : sessions)
-      visit(session.get());
+        std::advance(itr, randint() % links.size());
+      const auto begin = itr;
+      for (; itr != links.end(); ++itr)
+        visit(itr->second.get());
+      for (itr = links.begin(); itr != begin; ++itr)
+        visit(itr->second.get());
+    });
   }
 
   bool
   ILinkLayer::VisitSessionByPubkey(const RouterID& pk, std::function<bool(ILinkSession*)> visit)
   {
-    std::shared_ptr<ILinkSession> session;
-    {
-      Lock_t l(m_AuthedLinksMutex);
-      auto itr = m_AuthedLinks.find(pk);
-      if (itr == m_AuthedLinks.end())
-        return false;
-      session = itr->second;
-    }
-    return visit(session.get());
+    return m_AuthedLinks.Read([&](const auto& links) {
+      auto itr = links.find(pk);
+      return itr != links.end() and visit(itr->second.get());
+    });
   }
 
   void
   ILinkLayer::ForEachSession(std::function<void(ILinkSession*)> visit)
   {
-    std::vector<std::shared_ptr<ILinkSession>> sessions;
-    {
-      Lock_t l(m_AuthedLinksMutex);
-      auto itr = m_AuthedLinks.begin();
-      while (itr != m_AuthedLinks.end())
-      {
-        sessions.emplace_back(itr->second);
-        ++itr;
-      }
-    }
-    for (const auto& s : sessions)
-      visit(s.get());
+    m_AuthedLinks.Read([&visit](const auto& links) {
+      for (const auto& [router, session] : links)
+        visit(session.get());
+    });
   }
 
   void
@@ -138,44 +123,109 @@ namespace llarp
     m_Router = router;
     m_udp = m_Router->loop()->make_udp(
         [this]([[maybe_unused]] UDPHandle& udp, const SockAddr& from, llarp_buffer_t buf) {
-          ILinkSession::Packet_t pkt;
-          pkt.resize(buf.sz);
-          std::copy_n(buf.base, buf.sz, pkt.data());
-          RecvFrom(from, std::move(pkt));
+          RecvFrom(from, util::BufferPool::Acquire(buf.base, buf.sz));
         });
+    m_udp->set_batch_recv([this](UDPHandle&, std::vector<UDPPacket>& pkts) { RecvBatchFrom(pkts); });
 
-    if (m_udp->listen(m_ourAddr))
+    const auto conf = router->GetConfig();
+    const int sockets = conf ? conf->links.UDPSockets : 1;
+    bool listening = false;
+    if (sockets > 1)
+    {
+      listening = m_udp->listen_shared(m_ourAddr);
+      if (not listening)
+        LogWarn("cannot share udp socket for ", Name(), " link on ", m_ourAddr, ", using only one");
+    }
+
+    if (listening or m_udp->listen(m_ourAddr))
+    {
+      if (not m_udp->set_dont_fragment())
+        LogDebug("cannot set don't fragment on ", Name(), " link on ", m_ourAddr);
+      if (conf and conf->links.UDPOffload)
+      {
+        if (m_udp->enable_offload())
+          LogInfo(Name(), " link on ", m_ourAddr, " using udp segmentation offload");
+        else
+          LogWarn("udp offload requested but not supported for ", Name(), " link on ", m_ourAddr);
+      }
+      if (not m_ReceiveToken)
+        m_ReceiveToken = std::make_shared<int>();
+      for (int i = 1; listening and i < sockets; ++i)
+      {
+        // packets are handed to the event loop, which owns all the sessions
+        auto thread = std::make_unique<UDPReceiveThread>(
+            [this, loop = m_Router->loop(), token = std::weak_ptr<int>{m_ReceiveToken}](
+                std::vector<UDPDatagram> pkts) {
+              loop->call_soon([this, token, pkts = std::move(pkts)]() mutable {
+                if (not token.expired())
+                  RecvDatagrams(pkts);
+              });
+            });
+        if (not thread->start(m_ourAddr))
+        {
+          LogWarn("failed to start udp receive thread ", i, " for ", Name(), " link");
+          break;
+        }
+        m_ReceiveThreads.push_back(std::move(thread));
+      }
+      if (not m_ReceiveThreads.empty())
+        LogInfo(
+            Name(), " link on ", m_ourAddr, " receiving on ", m_ReceiveThreads.size() + 1, " sockets");
       return;
+    }
 
     throw std::runtime_error{
         fmt::format("failed to listen {} udp socket on {}", Name(), m_ourAddr)};
   }
 
+  void
+  ILinkLayer::RecvBatchFrom(std::vector<UDPPacket>& pkts)
+  {
+    for (auto& pkt : pkts)
+      RecvFrom(pkt.from, util::BufferPool::Acquire(pkt.data.data(), pkt.data.size()));
+  }
+
+  void
+  ILinkLayer::RecvDatagrams(std::vector<UDPDatagram>& pkts)
+  {
+    for (auto& pkt : pkts)
+      RecvFrom(pkt.from, std::move(pkt.data));
+  }
+
   void
   ILinkLayer::Pump()
   {
     std::unordered_set<RouterID> closedSessions;
+    std::unordered_set<const ILinkSession*> timedOut;
     std::vector<std::shared_ptr<ILinkSession>> closedPending;
     auto _now = Now();
-    {
-      Lock_t l(m_AuthedLinksMutex);
-      auto itr = m_AuthedLinks.begin();
-      while (itr != m_AuthedLinks.end())
+    m_AuthedLinks.Read([&](const auto& links) {
+      for (const auto& [router, session] : links)
       {
-        if (not itr->second->TimedOut(_now))
+        if (not session->TimedOut(_now))
         {
-          itr->second->Pump();
-          ++itr;
+          session->Pump();
+          continue;
         }
-        else
+        llarp::LogInfo("session to ", RouterID(session->GetPubKey()), " timed out");
+        session->Close();
+        closedSessions.emplace(router);
+        timedOut.emplace(session.get());
+        UnmapAddr(session->GetRemoteEndpoint());
+      }
+    });
+    if (not timedOut.empty())
+    {
+      m_AuthedLinks.Update([&timedOut](auto& links) {
+        for (auto itr = links.begin(); itr != links.end();)
         {
-          llarp::LogInfo("session to ", RouterID(itr->second->GetPubKey()), " timed out");
-          itr->second->Close();
-          closedSessions.emplace(itr->first);
-          UnmapAddr(itr->second->GetRemoteEndpoint());
-          itr = m_AuthedLinks.erase(itr);
+          if (timedOut.count(itr->second.get()))
+            itr = links.erase(itr);
+          else
+            ++itr;
         }
-      }
+        return true;
+      });
     }
     {
       Lock_t l(m_PendingMutex);
@@ -198,15 +248,10 @@ namespace llarp
         }
       }
     }
+    for (const auto& r : closedSessions)
     {
-      Lock_t l(m_AuthedLinksMutex);
-      for (const auto& r : closedSessions)
-      {
-        if (m_AuthedLinks.count(r) == 0)
-        {
-          SessionClosed(r);
-        }
-      }
+      if (not HasSessionTo(r))
+        SessionClosed(r);
     }
     for (const auto& pending : closedPending)
     {
@@ -225,25 +270,47 @@ namespace llarp
   bool
   ILinkLayer::MapAddr(const RouterID& pk, ILinkSession* s)
   {
-    Lock_t l_authed(m_AuthedLinksMutex);
-    Lock_t l_pending(m_PendingMutex);
-    const auto addr = s->GetRemoteEndpoint();
-    auto itr = m_Pending.find(addr);
-    if (itr != m_Pending.end())
+    // our other attempts to the same router at its other addresses, which lost the race
+    std::vector<std::shared_ptr<ILinkSession>> losers;
     {
-      if (m_AuthedLinks.count(pk))
+      Lock_t l_pending(m_PendingMutex);
+      const auto addr = s->GetRemoteEndpoint();
+      auto itr = m_Pending.find(addr);
+      if (itr == m_Pending.end())
+        return false;
+      const bool added = m_AuthedLinks.Update([&](auto& links) {
+        if (links.count(pk))
+          return false;
+        links.emplace(pk, itr->second);
+        return true;
+      });
+      if (not added)
       {
         LogWarn("too many session for ", pk);
         s->Close();
         return false;
       }
       m_AuthedAddrs.emplace(addr, pk);
-      m_AuthedLinks.emplace(pk, itr->second);
-      itr = m_Pending.erase(itr);
-      m_Router->TriggerPump();
-      return true;
+      m_KeepAliveDue.Schedule(s->NextPingAt(), itr->second);
+      m_Pending.erase(itr);
+      for (itr = m_Pending.begin(); itr != m_Pending.end();)
+      {
+        if (not itr->second->IsInbound() and RouterID{itr->second->GetPubKey()} == pk)
+        {
+          losers.emplace_back(std::move(itr->second));
+          itr = m_Pending.erase(itr);
+        }
+        else
+          ++itr;
+      }
     }
-    return false;
+    for (const auto& loser : losers)
+    {
+      LogDebug("closing slower attempt to ", pk, " at ", loser->GetRemoteEndpoint());
+      loser->Close();
+    }
+    m_Router->TriggerPump();
+    return true;
   }
 
   bool
@@ -261,6 +328,19 @@ namespace llarp
     return false;
   }
 
+  std::vector<AddressInfo>
+  ILinkLayer::PickAddresses(const RouterContact& rc) const
+  {
+    std::vector<AddressInfo> picked;
+    const auto OurDialect = Name();
+    for (const auto& addr : rc.addrs)
+    {
+      if (addr.dialect == OurDialect)
+        picked.push_back(addr);
+    }
+    return picked;
+  }
+
   util::StatusObject
   ILinkLayer::ExtractStatus() const
   {
@@ -274,14 +354,13 @@ namespace llarp
           std::back_inserter(pending),
           [](const auto& item) -> util::StatusObject { return item.second->ExtractStatus(); });
     }
-    {
-      Lock_t l(m_AuthedLinksMutex);
+    m_AuthedLinks.Read([&established](const auto& links) {
       std::transform(
-          m_AuthedLinks.cbegin(),
-          m_AuthedLinks.cend(),
+          links.cbegin(),
+          links.cend(),
           std::back_inserter(established),
           [](const auto& item) -> util::StatusObject { return item.second->ExtractStatus(); });
-    }
+    });
 
     return {
         {"name", Name()},
@@ -290,23 +369,53 @@ namespace llarp
         {"sessions", util::StatusObject{{"pending", pending}, {"established", established}}}};
   }
 
-  bool
-  ILinkLayer::TryEstablishTo(RouterContact rc)
+  util::StatusObject
+  ILinkLayer::ExtractHistograms()
   {
-    {
-      Lock_t l(m_AuthedLinksMutex);
-      if (m_AuthedLinks.count(rc.pubkey))
+    SessionHistograms total;
+    m_ClosedHistograms.DrainInto(total);
+    std::vector<util::StatusObject> sessions;
+    m_AuthedLinks.Read([&](const auto& links) {
+      for (const auto& [router, session] : links)
       {
-        LogWarn("Too many links to ", RouterID{rc.pubkey}, ", not establishing another one");
-        return false;
+        SessionHistograms hists;
+        session->DrainHistograms(hists);
+        auto obj = hists.ExtractStatus();
+        obj["router"] = router.ToString();
+        obj["addr"] = session->GetRemoteEndpoint().ToString();
+        sessions.push_back(std::move(obj));
+        hists.DrainInto(total);
       }
-    }
+    });
+    return {{"name", Name()}, {"total", total.ExtractStatus()}, {"sessions", sessions}};
+  }
+
+  void
+  ILinkLayer::RetireHistograms(ILinkSession& session)
+  {
+    session.DrainHistograms(m_ClosedHistograms);
+  }
+
+  bool
+  ILinkLayer::TryEstablishTo(RouterContact rc)
+  {
     llarp::AddressInfo to;
     if (not PickAddress(rc, to))
     {
       LogWarn("router ", RouterID{rc.pubkey}, " has no acceptable inbound addresses");
       return false;
     }
+    return TryEstablishTo(std::move(rc), to);
+  }
+
+  bool
+  ILinkLayer::TryEstablishTo(RouterContact rc, const AddressInfo& to)
+  {
+    if (HasSessionTo(rc.pubkey))
+    {
+      LogWarn("Too many links to ", RouterID{rc.pubkey}, ", not establishing another one");
+      return false;
+    }
     const SockAddr address{to};
     {
       Lock_t l(m_PendingMutex);
@@ -347,11 +456,30 @@ namespace llarp
   void
   ILinkLayer::Tick(const llarp_time_t now)
   {
-    {
-      Lock_t l(m_AuthedLinksMutex);
-      for (const auto& [routerid, link] : m_AuthedLinks)
+    m_AuthedLinks.Read([now](const auto& links) {
+      for (const auto& [routerid, link] : links)
         link->Tick(now);
-    }
+    });
+
+    m_KeepAliveDue.Advance(now, [this](std::weak_ptr<ILinkSession> weak) {
+      auto session = weak.lock();
+      if (not session)
+        return;
+      const RouterID remote{session->GetPubKey()};
+      const bool live = m_AuthedLinks.Read([&remote, &session](const auto& links) {
+        for (auto [itr, end] = links.equal_range(remote); itr != end; ++itr)
+        {
+          if (itr->second == session)
+            return true;
+        }
+        return false;
+      });
+      if (not live)
+        return;
+      if (session->ShouldPing())
+        session->SendKeepAlive();
+      m_KeepAliveDue.Schedule(session->NextPingAt(), std::move(weak));
+    });
 
     {
       Lock_t l(m_PendingMutex);
@@ -376,11 +504,15 @@ namespace llarp
   ILinkLayer::Stop()
   {
     m_repeater_keepalive.reset();  // make the repeater kill itself
-    {
-      Lock_t l(m_AuthedLinksMutex);
-      for (const auto& [router, link] : m_AuthedLinks)
+    for (auto& thread : m_ReceiveThreads)
+      thread->stop();
+    m_ReceiveThreads.clear();
+    // what they already handed to the event loop is dropped rather than processed
+    m_ReceiveToken.reset();
+    m_AuthedLinks.Read([](const auto& links) {
+      for (const auto& [router, link] : links)
         link->Close();
-    }
+    });
     {
       Lock_t l(m_PendingMutex);
       for (const auto& [addr, link] : m_Pending)
@@ -393,16 +525,20 @@ namespace llarp
   {
     static constexpr auto CloseGraceWindow = 500ms;
     const auto now = Now();
-    {
-      Lock_t l(m_AuthedLinksMutex);
-      RouterID r = remote;
-      llarp::LogInfo("Closing all to ", r);
-      for (auto [itr, end] = m_AuthedLinks.equal_range(r); itr != end;)
+    llarp::LogInfo("Closing all to ", remote);
+    std::vector<std::shared_ptr<ILinkSession>> closed;
+    m_AuthedLinks.Update([&](auto& links) {
+      for (auto [itr, end] = links.equal_range(remote); itr != end;)
       {
-        itr->second->Close();
-        m_RecentlyClosed.emplace(itr->second->GetRemoteEndpoint(), now + CloseGraceWindow);
-        itr = m_AuthedLinks.erase(itr);
+        closed.emplace_back(std::move(itr->second));
+        itr = links.erase(itr);
       }
+      return not closed.empty();
+    });
+    for (const auto& session : closed)
+    {
+      session->Close();
+      m_RecentlyClosed.emplace(session->GetRemoteEndpoint(), now + CloseGraceWindow);
     }
     SessionClosed(remote);
   }
@@ -410,22 +546,88 @@ namespace llarp
   void
   ILinkLayer::KeepAliveSessionTo(const RouterID& remote)
   {
-    Lock_t l(m_AuthedLinksMutex);
-    for (auto [itr, end] = m_AuthedLinks.equal_range(remote); itr != end; ++itr)
-    {
-      if (itr->second->ShouldPing())
+    m_AuthedLinks.Read([&remote](const auto& links) {
+      for (auto [itr, end] = links.equal_range(remote); itr != end; ++itr)
       {
-        LogDebug("keepalive to ", remote);
-        itr->second->SendKeepAlive();
+        if (itr->second->ShouldPing())
+        {
+          LogDebug("keepalive to ", remote);
+          itr->second->SendKeepAlive();
+        }
       }
-    }
+    });
   }
 
   void
   ILinkLayer::SendTo_LL(const SockAddr& to, const llarp_buffer_t& pkt)
   {
+    txPackets.Inc();
+    txBytes.Inc(pkt.sz);
     if (not m_udp->send(to, pkt))
+    {
+      txFailed.Inc();
       LogError("could not send udp packet to ", to);
+    }
+  }
+
+  void
+  ILinkLayer::SendBatchTo_LL(const SockAddr& to, const std::vector<ILinkSession::Packet_t>& pkts)
+  {
+    std::vector<UDPSendItem> items;
+    items.reserve(pkts.size());
+    size_t bytes = 0;
+    for (const auto& pkt : pkts)
+      bytes += pkt.size();
+    txPackets.Inc(pkts.size());
+    txBytes.Inc(bytes);
+    if (not m_udp->offload_enabled())
+    {
+      for (const auto& pkt : pkts)
+        items.push_back(UDPSendItem{to, byte_view_t{pkt.data(), pkt.size()}});
+      SendItems_LL(to, items);
+      return;
+    }
+    // With segmentation offload we coalesce each run of same sized packets (which is what full
+    // sized data fragments look like) into one buffer the kernel splits back up for us.  Moving
+    // the inner vectors as `runs` grows does not move their data, so the views stay valid.
+    std::vector<std::vector<byte_t>> runs;
+    for (size_t i = 0; i < pkts.size();)
+    {
+      const size_t segsz = pkts[i].size();
+      size_t j = i + 1;
+      size_t total = segsz;
+      while (j < pkts.size() and j - i < udp_gso_max_segments
+             and total + pkts[j].size() <= udp_gso_max_bytes and pkts[j].size() <= segsz)
+      {
+        total += pkts[j].size();
+        // a shorter packet can only be the last one in the run
+        if (pkts[j++].size() < segsz)
+          break;
+      }
+      if (j - i == 1)
+        items.push_back(UDPSendItem{to, byte_view_t{pkts[i].data(), pkts[i].size()}});
+      else
+      {
+        auto& run = runs.emplace_back();
+        run.reserve(total);
+        for (size_t k = i; k < j; ++k)
+          run.insert(run.end(), pkts[k].begin(), pkts[k].end());
+        items.push_back(
+            UDPSendItem{to, byte_view_t{run.data(), run.size()}, static_cast<uint16_t>(segsz)});
+      }
+      i = j;
+    }
+    SendItems_LL(to, items);
+  }
+
+  void
+  ILinkLayer::SendItems_LL(const SockAddr& to, const std::vector<UDPSendItem>& items)
+  {
+    if (const auto sent = m_udp->send_batch(items); sent < items.size())
+    {
+      txFailed.Inc(items.size() - sent);
+      LogError("could not send ", items.size() - sent, " of ", items.size(), " udp packets to ", to);
+    }
   }
 
   bool
@@ -435,24 +637,25 @@ namespace llarp
       ILinkSession::CompletionHandler completed,
       uint16_t priority)
   {
-    std::shared_ptr<ILinkSession> s;
-    {
-      Lock_t l(m_AuthedLinksMutex);
+    auto s = m_AuthedLinks.Read([&remote](const auto& links) {
       // pick lowest backlog session
+      std::shared_ptr<ILinkSession> best;
       size_t min = std::numeric_limits<size_t>::max();
-
-      for (auto [itr, end] = m_AuthedLinks.equal_range(remote); itr != end; ++itr)
+      for (auto [itr, end] = links.equal_range(remote); itr != end; ++itr)
       {
         if (const auto backlog = itr->second->SendQueueBacklog(); backlog < min)
         {
-          s = itr->second;
+          best = itr->second;
           min = backlog;
         }
       }
-    }
-    ILinkSession::Message_t pkt(buf.sz);
-    std::copy_n(buf.base, buf.sz, pkt.begin());
-    return s && s->SendMessageBuffer(std::move(pkt), completed, priority);
+      return best;
+    });
+    if (not s)
+      return false;
+    if (m_Recorder)
+      m_Recorder->Record(LinkRecorder::Direction::Outbound, remote, buf);
+    return s->SendMessageBuffer(util::BufferPool::Acquire(buf.base, buf.sz), completed, priority);
   }
 
   bool
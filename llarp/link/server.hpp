@@ -6,15 +6,23 @@
 #include <llarp/net/sock_addr.hpp>
 #include <llarp/router_contact.hpp>
 #include <llarp/util/status.hpp>
+#include <llarp/util/timer_wheel.hpp>
+#include <llarp/util/thread/rcu.hpp>
 #include <llarp/util/thread/threading.hpp>
 #include <llarp/config/key_manager.hpp>
 
 #include <list>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace llarp
 {
+  struct UDPSendItem;
+  struct UDPDatagram;
+  struct UDPReceiveThread;
+  class LinkRecorder;
+
   /// handle a link layer message. this allows for the message to be handled by "upper layers"
   ///
   /// currently called from iwp::Session when messages are sent or received.
@@ -53,8 +61,6 @@ namespace llarp
 
   /// handles close of all sessions with pubkey
   ///
-  /// Note that this handler is called while m_AuthedLinksMutex is held
-  ///
   /// currently called from iwp::ILinkSession when a previously established session times out
   using SessionClosedHandler = std::function<void(llarp::RouterID)>;
 
@@ -85,7 +91,7 @@ namespace llarp
         SessionClosedHandler closed,
         PumpDoneHandler pumpDone,
         WorkerFunc_t doWork);
-    virtual ~ILinkLayer() = default;
+    virtual ~ILinkLayer();
 
     /// get current time via event loop
     llarp_time_t
@@ -95,11 +101,10 @@ namespace llarp
     HasSessionTo(const RouterID& pk);
 
     void
-    ForEachSession(std::function<void(const ILinkSession*)> visit, bool randomize = false) const
-        EXCLUDES(m_AuthedLinksMutex);
+    ForEachSession(std::function<void(const ILinkSession*)> visit, bool randomize = false) const;
 
     void
-    ForEachSession(std::function<void(ILinkSession*)> visit) EXCLUDES(m_AuthedLinksMutex);
+    ForEachSession(std::function<void(ILinkSession*)> visit);
 
     void
     UnmapAddr(const SockAddr& addr);
@@ -107,6 +112,10 @@ namespace llarp
     void
     SendTo_LL(const SockAddr& to, const llarp_buffer_t& pkt);
 
+    /// send several already encrypted packets to the same remote in a single batch
+    void
+    SendBatchTo_LL(const SockAddr& to, const std::vector<ILinkSession::Packet_t>& pkts);
+
     void
     Bind(AbstractRouter* router, SockAddr addr);
 
@@ -123,12 +132,31 @@ namespace llarp
     virtual void
     RecvFrom(const SockAddr& from, ILinkSession::Packet_t pkt) = 0;
 
+    /// handle a batch of packets read from the socket in one go; the default simply hands each to
+    /// RecvFrom
+    virtual void
+    RecvBatchFrom(std::vector<UDPPacket>& pkts);
+
+    /// handle a batch of packets read by one of our extra receive threads, in the event loop;
+    /// the default hands each to RecvFrom
+    virtual void
+    RecvDatagrams(std::vector<UDPDatagram>& pkts);
+
     bool
     PickAddress(const RouterContact& rc, AddressInfo& picked) const;
 
+    /// every address of rc's we could connect to, in the order it lists them
+    std::vector<AddressInfo>
+    PickAddresses(const RouterContact& rc) const;
+
     bool
     TryEstablishTo(RouterContact rc);
 
+    /// start a session to rc at one particular address of theirs; an attempt elsewhere may
+    /// already be going, and whichever gets established first closes the rest
+    bool
+    TryEstablishTo(RouterContact rc, const AddressInfo& to);
+
     bool
     Start();
 
@@ -138,8 +166,17 @@ namespace llarp
     virtual std::string_view
     Name() const = 0;
 
+    virtual util::StatusObject
+    ExtractStatus() const;
+
+    /// per session latency histograms and their total for this link, including what sessions
+    /// that have closed since the last call recorded; resets them all
     util::StatusObject
-    ExtractStatus() const EXCLUDES(m_AuthedLinksMutex);
+    ExtractHistograms();
+
+    /// keep what a closing session recorded for the next ExtractHistograms
+    void
+    RetireHistograms(ILinkSession& session);
 
     void
     CloseSessionTo(const RouterID& remote);
@@ -158,8 +195,7 @@ namespace llarp
     GetOurAddressInfo(AddressInfo& addr) const;
 
     bool
-    VisitSessionByPubkey(const RouterID& pk, std::function<bool(ILinkSession*)> visit)
-        EXCLUDES(m_AuthedLinksMutex);
+    VisitSessionByPubkey(const RouterID& pk, std::function<bool(ILinkSession*)> visit);
 
     virtual uint16_t
     Rank() const = 0;
@@ -242,6 +278,20 @@ namespace llarp
       return m_ourAddr;
     }
 
+    /// records every message sent or received on this link while set; nullptr stops that.  set
+    /// it from the logic thread, which is where messages get sent and handled
+    void
+    SetRecorder(std::shared_ptr<LinkRecorder> recorder)
+    {
+      m_Recorder = std::move(recorder);
+    }
+
+    LinkRecorder*
+    Recorder() const
+    {
+      return m_Recorder.get();
+    }
+
    private:
     const SecretKey& m_RouterEncSecret;
 
@@ -256,22 +306,39 @@ namespace llarp
     bool
     PutSession(const std::shared_ptr<ILinkSession>& s);
 
+    /// hand a batch of udp send items to our socket, logging if any could not be sent
+    void
+    SendItems_LL(const SockAddr& to, const std::vector<UDPSendItem>& items);
+
     AbstractRouter* m_Router;
     SockAddr m_ourAddr;
     std::shared_ptr<llarp::UDPHandle> m_udp;
+    /// extra sockets sharing m_udp's address, each read on its own thread
+    std::vector<std::unique_ptr<UDPReceiveThread>> m_ReceiveThreads;
+    /// the batches those threads hand to the event loop hold on to this weakly, and are dropped
+    /// if it is gone by the time they run: after Stop() or once we are destroyed
+    std::shared_ptr<int> m_ReceiveToken = std::make_shared<int>();
     SecretKey m_SecretKey;
 
     using AuthedLinks = std::unordered_multimap<RouterID, std::shared_ptr<ILinkSession>>;
     using Pending = std::unordered_map<SockAddr, std::shared_ptr<ILinkSession>>;
-    mutable DECLARE_LOCK(Mutex_t, m_AuthedLinksMutex, ACQUIRED_BEFORE(m_PendingMutex));
-    AuthedLinks m_AuthedLinks GUARDED_BY(m_AuthedLinksMutex);
-    mutable DECLARE_LOCK(Mutex_t, m_PendingMutex, ACQUIRED_AFTER(m_AuthedLinksMutex));
+    /// established sessions by remote router.  lookups (on the send path for every link message)
+    /// never lock; adding or removing a session publishes a new copy
+    thread::RCU<AuthedLinks> m_AuthedLinks;
+    mutable DECLARE_LOCK(Mutex_t, m_PendingMutex);
     Pending m_Pending GUARDED_BY(m_PendingMutex);
     std::unordered_map<SockAddr, RouterID> m_AuthedAddrs;
     std::unordered_map<SockAddr, llarp_time_t> m_RecentlyClosed;
+    /// recorded by sessions that have since closed
+    SessionHistograms m_ClosedHistograms;
+    /// established sessions by when they next need a keepalive, so that Tick only looks at the
+    /// ones that have gone quiet; a session that sends anything in the meantime moves its
+    /// deadline on, and is put back for that when it comes up
+    util::TimerWheel<std::weak_ptr<ILinkSession>> m_KeepAliveDue{1s};
 
    private:
     std::shared_ptr<int> m_repeater_keepalive;
+    std::shared_ptr<LinkRecorder> m_Recorder;
   };
 
   using LinkLayer_ptr = std::shared_ptr<ILinkLayer>;
@@ -4,6 +4,7 @@
 #include <llarp/net/net.hpp>
 #include <llarp/ev/ev.hpp>
 #include <llarp/router_contact.hpp>
+#include <llarp/util/histogram.hpp>
 #include <llarp/util/types.hpp>
 
 #include <functional>
@@ -21,10 +22,50 @@ namespace llarp
     uint64_t currentRateTX = 0;
 
     uint64_t totalPacketsRX = 0;
+    /// packets shed on the way in because we had too many still to decrypt or handle
+    uint64_t totalDroppedRX = 0;
 
     uint64_t totalAckedTX = 0;
     uint64_t totalDroppedTX = 0;
     uint64_t totalInFlightTX = 0;
+
+    // congestion control state, for links that have it
+    uint64_t congestionWindow = 0;
+    llarp_time_t smoothedRTT = 0s;
+  };
+
+  /// latency and retransmission distributions for a session, for links that keep them.  reading
+  /// them (DrainInto) resets them.
+  struct SessionHistograms
+  {
+    /// from a message's first transmission to its ack, in microseconds; only messages that were
+    /// sent once, as the ack of a resent one is ambiguous
+    util::Histogram ackRTT;
+    /// how long messages waited to first go out, in microseconds
+    util::Histogram queueDelay;
+    /// how many times each delivered message was resent
+    util::Histogram retransmits;
+    /// from a batch of packets being handed to a crypto worker to it being done, in microseconds
+    util::Histogram cryptoLatency;
+
+    void
+    DrainInto(SessionHistograms& other)
+    {
+      ackRTT.DrainInto(other.ackRTT);
+      queueDelay.DrainInto(other.queueDelay);
+      retransmits.DrainInto(other.retransmits);
+      cryptoLatency.DrainInto(other.cryptoLatency);
+    }
+
+    util::StatusObject
+    ExtractStatus() const
+    {
+      return {
+          {"ackRTT", ackRTT.ExtractStatus()},
+          {"queueDelay", queueDelay.ExtractStatus()},
+          {"retransmits", retransmits.ExtractStatus()},
+          {"cryptoLatency", cryptoLatency.ExtractStatus()}};
+    }
   };
 
   struct ILinkSession
@@ -125,6 +166,10 @@ namespace llarp
     virtual bool
     ShouldPing() const = 0;
 
+    /// when we next have to send an explicit keepalive, if nothing else goes out before then
+    virtual llarp_time_t
+    NextPingAt() const = 0;
+
     /// return the current stats for this session
     virtual SessionStats
     GetSessionStats() const = 0;
@@ -132,6 +177,12 @@ namespace llarp
     virtual util::StatusObject
     ExtractStatus() const = 0;
 
+    /// move this session's histograms into `into`, resetting them; links that don't keep any
+    /// leave it alone
+    virtual void
+    DrainHistograms(SessionHistograms& /*into*/)
+    {}
+
     virtual void
     HandlePlaintext() = 0;
   };
@@ -14,10 +14,18 @@
 
 #include <oxenc/base32z.h>
 
+#include <algorithm>
 #include <mutex>
 #include <memory>
 #include <chrono>
+#include <deque>
 #include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
 
 #ifdef _WIN32
 #define EHOSTDOWN ENETDOWN
@@ -81,9 +89,20 @@ namespace
   struct UDPHandler
   {
     using AddressVariant_t = llarp::vpn::AddressVariant_t;
+
+    /// a datagram waiting for lokinet_udp_recv_many
+    struct QueuedDatagram
+    {
+      AddressVariant_t m_From;
+      lokinet_udp_flowinfo m_FlowInfo;
+      void* m_FlowUserData;
+      std::vector<char> m_Data;
+    };
+
     int m_SocketID;
     llarp::nuint16_t m_LocalPort;
     lokinet_udp_flow_filter m_Filter;
+    /// null for sockets bound with lokinet_udp_bind_polled, which queue datagrams instead
     lokinet_udp_flow_recv_func m_Recv;
     lokinet_udp_flow_timeout_func m_Timeout;
     void* m_User;
@@ -91,6 +110,12 @@ namespace
 
     std::unordered_map<AddressVariant_t, UDPFlow> m_Flows;
 
+    /// for polled sockets: the datagrams the app has yet to receive, the most we hold, and an
+    /// eventfd that is readable while there are any
+    std::deque<QueuedDatagram> m_Queue;
+    size_t m_QueueSize;
+    int m_PollFD = -1;
+
     std::mutex m_Access;
 
     explicit UDPHandler(
@@ -100,7 +125,8 @@ namespace
         lokinet_udp_flow_recv_func recv,
         lokinet_udp_flow_timeout_func timeout,
         void* user,
-        std::weak_ptr<llarp::service::Endpoint> ep)
+        std::weak_ptr<llarp::service::Endpoint> ep,
+        size_t queueSize = 0)
         : m_SocketID{socketid}
         , m_LocalPort{localport}
         , m_Filter{filter}
@@ -108,7 +134,53 @@ namespace
         , m_Timeout{timeout}
         , m_User{user}
         , m_Endpoint{std::move(ep)}
-    {}
+        , m_QueueSize{queueSize}
+    {
+#ifdef __linux__
+      if (m_Recv == nullptr)
+        m_PollFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+    }
+
+    ~UDPHandler()
+    {
+#ifdef __linux__
+      if (m_PollFD >= 0)
+        ::close(m_PollFD);
+#endif
+    }
+
+    /// make the poll fd readable or not, as the queue goes from empty or to empty
+    void
+    SetReadable(bool readable)
+    {
+#ifdef __linux__
+      if (m_PollFD < 0)
+        return;
+      eventfd_t val = 1;
+      if (readable)
+        eventfd_write(m_PollFD, val);
+      else
+        eventfd_read(m_PollFD, &val);
+#else
+      (void)readable;
+#endif
+    }
+
+    /// drop queued datagrams for a flow that is going, as the app may free its user data
+    void
+    DropQueuedFrom(const AddressVariant_t& from)
+    {
+      const bool had = not m_Queue.empty();
+      m_Queue.erase(
+          std::remove_if(
+              m_Queue.begin(),
+              m_Queue.end(),
+              [&from](const auto& queued) { return queued.m_From == from; }),
+          m_Queue.end());
+      if (had and m_Queue.empty())
+        SetReadable(false);
+    }
 
     void
     KillAllFlows()
@@ -119,6 +191,56 @@ namespace
         item.second.TimedOut(m_Timeout);
       }
       m_Flows.clear();
+      if (not m_Queue.empty())
+      {
+        m_Queue.clear();
+        SetReadable(false);
+      }
+    }
+
+    /// hand a datagram on a flow to the app, or queue it for the app on a polled socket
+    void
+    Deliver(const AddressVariant_t& from, UDPFlow& flow, const llarp::net::IPPacket& pkt)
+    {
+      if (m_Recv)
+      {
+        flow.HandlePacket(pkt);
+        return;
+      }
+      auto maybe = pkt.L4Data();
+      if (not maybe)
+        return;
+      flow.MarkActive();
+      if (m_Queue.size() >= m_QueueSize)
+        return;
+      m_Queue.push_back(QueuedDatagram{
+          from,
+          flow.m_FlowInfo,
+          flow.m_FlowUserData,
+          std::vector<char>{maybe->first, maybe->first + maybe->second}});
+      if (m_Queue.size() == 1)
+        SetReadable(true);
+    }
+
+    /// copy up to num queued datagrams out to the app, returning how many
+    size_t
+    Receive(lokinet_udp_datagram* datagrams, size_t num)
+    {
+      std::unique_lock lock{m_Access};
+      size_t n = 0;
+      for (; n < num and not m_Queue.empty(); ++n)
+      {
+        const auto& queued = m_Queue.front();
+        auto& out = datagrams[n];
+        out.remote = queued.m_FlowInfo;
+        out.flow_userdata = queued.m_FlowUserData;
+        out.len = std::min(out.capacity, queued.m_Data.size());
+        std::copy_n(queued.m_Data.data(), out.len, out.data);
+        m_Queue.pop_front();
+      }
+      if (n > 0 and m_Queue.empty())
+        SetReadable(false);
+      return n;
     }
 
     void
@@ -136,7 +258,7 @@ namespace
       flow.m_FlowUserData = flow_userdata;
       flow.m_Recv = m_Recv;
       if (firstPacket)
-        flow.HandlePacket(*firstPacket);
+        Deliver(from, flow, *firstPacket);
     }
 
     void
@@ -147,6 +269,7 @@ namespace
       {
         if (itr->second.IsExpired())
         {
+          DropQueuedFrom(itr->first);
           itr->second.TimedOut(m_Timeout);
           itr = m_Flows.erase(itr);
         }
@@ -160,9 +283,9 @@ namespace
     {
       {
         std::unique_lock lock{m_Access};
-        if (m_Flows.count(from))
+        if (auto itr = m_Flows.find(from); itr != m_Flows.end())
         {
-          m_Flows[from].HandlePacket(pkt);
+          Deliver(from, itr->second, pkt);
           return;
         }
       }
@@ -191,6 +314,17 @@ namespace
       AddFlow(from, flow_addr, flow_userdata, flow_timeoutseconds, pkt);
     }
   };
+
+  /// a stream from lokinet_direct_stream_open or lokinet_direct_stream_listen
+  struct DirectStream
+  {
+    int m_ID;
+    lokinet_stream_callbacks m_Callbacks;
+    /// set once it opens
+    std::weak_ptr<llarp::quic::Stream> m_Stream;
+    /// set if the app closed it before it opened, to close it once it does
+    bool m_Closed = false;
+  };
 }  // namespace
 
 struct lokinet_context
@@ -232,7 +366,8 @@ struct lokinet_context
       lokinet_udp_flow_filter filter,
       lokinet_udp_flow_recv_func recv,
       lokinet_udp_flow_timeout_func timeout,
-      void* user)
+      void* user,
+      size_t queueSize = 0)
   {
     if (udp_sockets.empty())
     {
@@ -247,7 +382,7 @@ struct lokinet_context
     }
     std::weak_ptr<llarp::service::Endpoint> weak{ep};
     auto udp = std::make_shared<UDPHandler>(
-        next_socket_id(), exposePort, filter, recv, timeout, user, weak);
+        next_socket_id(), exposePort, filter, recv, timeout, user, weak, queueSize);
     auto id = udp->m_SocketID;
     std::promise<bool> result;
 
@@ -311,6 +446,102 @@ struct lokinet_context
   std::unordered_map<int, bool> streams;
   std::unordered_map<int, std::shared_ptr<UDPHandler>> udp_sockets;
 
+  /// direct streams, opening or open, by their id.  these have a lock of their own, as they are
+  /// looked up on each write, and go from the event loop when they close
+  std::mutex direct_access;
+  std::unordered_map<int, std::shared_ptr<DirectStream>> direct_streams;
+  int _direct_id = 0;
+
+  [[nodiscard]] std::shared_ptr<DirectStream>
+  find_direct(int id)
+  {
+    std::unique_lock lock{direct_access};
+    if (auto itr = direct_streams.find(id); itr != direct_streams.end())
+      return itr->second;
+    return nullptr;
+  }
+
+  void
+  forget_direct(int id)
+  {
+    std::unique_lock lock{direct_access};
+    direct_streams.erase(id);
+  }
+
+  /// make a direct stream and the quic handlers that hand it to the app's callbacks, and hold onto
+  /// it until it closes or fails to open.  returns its id and the handlers
+  std::pair<int, llarp::quic::TunnelManager::DirectStream>
+  make_direct(const lokinet_stream_callbacks& callbacks)
+  {
+    auto direct = std::make_shared<DirectStream>();
+    direct->m_Callbacks = callbacks;
+    {
+      std::unique_lock lock{direct_access};
+      direct->m_ID = ++_direct_id;
+      // handle overflow
+      if (direct->m_ID < 0)
+        direct->m_ID = _direct_id = 1;
+      direct_streams[direct->m_ID] = direct;
+    }
+
+    llarp::quic::TunnelManager::DirectStream handlers;
+    handlers.on_open = [this, direct](std::shared_ptr<llarp::quic::Stream> stream) {
+      const auto& cb = direct->m_Callbacks;
+      if (direct->m_Closed)
+      {
+        // the app is done with it already
+        if (stream)
+          stream->close();
+        forget_direct(direct->m_ID);
+        return;
+      }
+      if (stream)
+        direct->m_Stream = stream;
+      else
+        forget_direct(direct->m_ID);
+      if (cb.on_open)
+        cb.on_open(direct->m_ID, stream ? 0 : ECONNREFUSED, cb.user);
+    };
+    handlers.on_data = [direct](auto&, llarp::quic::bstring_view data) {
+      const auto& cb = direct->m_Callbacks;
+      if (cb.on_data)
+        cb.on_data(
+            direct->m_ID, reinterpret_cast<const char*>(data.data()), data.size(), cb.user);
+    };
+    handlers.on_writable = [direct](auto&) {
+      const auto& cb = direct->m_Callbacks;
+      if (cb.on_writable)
+        cb.on_writable(direct->m_ID, cb.user);
+    };
+    handlers.on_close = [this, direct](auto&, std::optional<uint64_t> error_code) {
+      const auto& cb = direct->m_Callbacks;
+      forget_direct(direct->m_ID);
+      if (cb.on_close)
+        cb.on_close(direct->m_ID, error_code.value_or(0), cb.user);
+    };
+    return {direct->m_ID, std::move(handlers)};
+  }
+
+  /// run f on the event loop and wait for it to finish; right away if we are on the loop already,
+  /// as when called from a callback
+  template <typename Callable>
+  void
+  on_loop(Callable&& f)
+  {
+    auto loop = impl->router->loop();
+    if (loop->inEventLoop())
+    {
+      f();
+      return;
+    }
+    std::promise<void> done;
+    loop->call_soon([&f, &done] {
+      f();
+      done.set_value();
+    });
+    done.get_future().get();
+  }
+
   void
   inbound_stream(int id)
   {
@@ -847,6 +1078,166 @@ extern "C"
     {}
   }
 
+  void EXPORT
+  lokinet_direct_stream_open(
+      struct lokinet_stream_result* result,
+      const char* remote,
+      const struct lokinet_stream_callbacks* callbacks,
+      struct lokinet_context* ctx)
+  {
+    if (ctx == nullptr)
+    {
+      stream_error(result, EHOSTDOWN);
+      return;
+    }
+    if (remote == nullptr or callbacks == nullptr)
+    {
+      stream_error(result, EINVAL);
+      return;
+    }
+    auto promise = std::make_shared<std::promise<int>>();
+    int id;
+    {
+      auto lock = ctx->acquire();
+      if (not ctx->impl->IsUp())
+      {
+        stream_error(result, EHOSTDOWN);
+        return;
+      }
+      std::string remotehost;
+      int remoteport;
+      try
+      {
+        std::tie(remotehost, remoteport) = split_host_port(remote);
+      }
+      catch (int err)
+      {
+        stream_error(result, err);
+        return;
+      }
+      auto [direct_id, handlers] = ctx->make_direct(*callbacks);
+      id = direct_id;
+      ctx->impl->CallSafe(
+          [ctx, promise, remotehost, remoteport, handlers = std::move(handlers)]() mutable {
+            auto ep = ctx->endpoint();
+            auto* quic = ep ? ep->GetQUICTunnel() : nullptr;
+            if (quic == nullptr)
+            {
+              promise->set_value(ENOTSUP);
+              return;
+            }
+            try
+            {
+              quic->open_direct(remotehost, remoteport, std::move(handlers));
+              promise->set_value(0);
+            }
+            catch (const std::exception& ex)
+            {
+              llarp::LogWarn("could not open direct stream to ", remotehost, ": ", ex.what());
+              promise->set_value(EINVAL);
+            }
+          });
+    }
+    if (auto err = promise->get_future().get())
+    {
+      ctx->forget_direct(id);
+      stream_error(result, err);
+      return;
+    }
+    stream_okay(result, "", 0, id);
+  }
+
+  int EXPORT
+  lokinet_direct_stream_listen(
+      lokinet_stream_filter acceptFilter,
+      void* user,
+      const struct lokinet_stream_callbacks* callbacks,
+      struct lokinet_context* ctx)
+  {
+    if (acceptFilter == nullptr)
+    {
+      acceptFilter = [](auto, auto, auto) { return 0; };
+    }
+    if (not ctx or not callbacks)
+      return -1;
+    std::promise<int> promise;
+    {
+      auto lock = ctx->acquire();
+      if (not ctx->impl->IsUp())
+      {
+        return -1;
+      }
+
+      ctx->impl->CallSafe([ctx, acceptFilter, user, cb = *callbacks, &promise]() {
+        auto ep = ctx->endpoint();
+        auto* quic = ep->GetQUICTunnel();
+        auto id = quic->listen_direct(
+            [ctx, acceptFilter, user, cb](auto remoteAddr, auto port)
+                -> std::optional<llarp::quic::TunnelManager::DirectStream> {
+              std::string remote{remoteAddr};
+              if (auto result = acceptFilter(remote.c_str(), port, user))
+              {
+                if (result == -1)
+                {
+                  throw std::invalid_argument{"rejected"};
+                }
+                return std::nullopt;
+              }
+              return ctx->make_direct(cb).second;
+            });
+        promise.set_value(id);
+      });
+    }
+    auto ftr = promise.get_future();
+    auto id = ftr.get();
+    {
+      auto lock = ctx->acquire();
+      ctx->inbound_stream(id);
+    }
+    return id;
+  }
+
+  int EXPORT
+  lokinet_direct_stream_write(
+      int stream_id, const void* data, size_t len, struct lokinet_context* ctx)
+  {
+    if (ctx == nullptr or (data == nullptr and len > 0))
+      return EINVAL;
+    auto direct = ctx->find_direct(stream_id);
+    if (not direct)
+      return EBADF;
+    int err = 0;
+    ctx->on_loop([&]() {
+      auto stream = direct->m_Stream.lock();
+      if (not stream or stream->closing())
+        err = ENOTCONN;
+      else if (not llarp::quic::TunnelManager::write_direct(
+                   *stream, {reinterpret_cast<const std::byte*>(data), len}))
+        err = EAGAIN;
+    });
+    return err;
+  }
+
+  void EXPORT
+  lokinet_direct_stream_close(int stream_id, struct lokinet_context* ctx)
+  {
+    if (ctx == nullptr)
+      return;
+    auto direct = ctx->find_direct(stream_id);
+    if (not direct)
+      return;
+    ctx->on_loop([&]() {
+      if (auto stream = direct->m_Stream.lock())
+      {
+        stream->close();
+        ctx->forget_direct(stream_id);
+      }
+      else
+        // still opening: it closes once it opens, and forgets itself then
+        direct->m_Closed = true;
+    });
+  }
+
   int EXPORT
   lokinet_srv_lookup(
       char* host,
@@ -913,6 +1304,76 @@ extern "C"
     return EINVAL;
   }
 
+  int EXPORT
+  lokinet_udp_bind_polled(
+      uint16_t exposedPort,
+      lokinet_udp_flow_filter filter,
+      lokinet_udp_flow_timeout_func timeout,
+      void* user,
+      size_t queue_size,
+      struct lokinet_udp_bind_result* result,
+      struct lokinet_context* ctx)
+  {
+    if (filter == nullptr or timeout == nullptr or queue_size == 0 or result == nullptr
+        or ctx == nullptr)
+      return EINVAL;
+
+    auto lock = ctx->acquire();
+    if (auto ep = ctx->endpoint())
+    {
+      if (auto maybe = ctx->make_udp_handler(
+              ep,
+              llarp::net::port_t::from_host(exposedPort),
+              filter,
+              nullptr,
+              timeout,
+              user,
+              queue_size))
+      {
+        result->socket_id = *maybe;
+        return 0;
+      }
+    }
+    return EINVAL;
+  }
+
+  int EXPORT
+  lokinet_udp_recv_many(
+      int socket_id,
+      struct lokinet_udp_datagram* datagrams,
+      size_t num,
+      size_t* received,
+      struct lokinet_context* ctx)
+  {
+    if (datagrams == nullptr or received == nullptr or ctx == nullptr)
+      return EINVAL;
+    *received = 0;
+    std::shared_ptr<UDPHandler> udp;
+    {
+      auto lock = ctx->acquire();
+      if (auto itr = ctx->udp_sockets.find(socket_id); itr != ctx->udp_sockets.end())
+        udp = itr->second;
+      else
+        return EHOSTUNREACH;
+    }
+    // sockets with a recv callback get their datagrams that way
+    if (udp->m_Recv)
+      return EINVAL;
+    *received = udp->Receive(datagrams, num);
+    return 0;
+  }
+
+  int EXPORT
+  lokinet_udp_poll_fd(int socket_id, struct lokinet_context* ctx)
+  {
+    if (ctx == nullptr)
+      return -1;
+    auto lock = ctx->acquire();
+    if (auto itr = ctx->udp_sockets.find(socket_id); itr != ctx->udp_sockets.end())
+      return itr->second->m_PollFD;
+    return -1;
+  }
+
   void EXPORT
   lokinet_udp_close(int socket_id, struct lokinet_context* ctx)
   {
@@ -929,7 +1390,21 @@ extern "C"
       size_t len,
       struct lokinet_context* ctx)
   {
-    if (remote == nullptr or remote->remote_port == 0 or ptr == nullptr or len == 0
+    const lokinet_udp_packet pkt{ptr, len};
+    return lokinet_udp_flow_send_many(remote, &pkt, 1, nullptr, ctx);
+  }
+
+  int EXPORT
+  lokinet_udp_flow_send_many(
+      const struct lokinet_udp_flowinfo* remote,
+      const struct lokinet_udp_packet* pkts,
+      size_t num,
+      size_t* sent,
+      struct lokinet_context* ctx)
+  {
+    if (sent)
+      *sent = 0;
+    if (remote == nullptr or remote->remote_port == 0 or pkts == nullptr or num == 0
         or ctx == nullptr)
       return EINVAL;
     std::shared_ptr<llarp::EndpointBase> ep;
@@ -947,28 +1422,41 @@ extern "C"
     }
     if (auto maybe = llarp::service::ParseAddress(std::string{remote->remote_host}))
     {
-      llarp::net::IPPacket pkt = llarp::net::IPPacket::UDP(
-          llarp::nuint32_t{0},
-          srcport,
-          llarp::nuint32_t{0},
-          dstport,
-          llarp_buffer_t{reinterpret_cast<const uint8_t*>(ptr), len});
-
-      if (pkt.empty())
-        return EINVAL;
-      std::promise<int> ret;
-      ctx->impl->router->loop()->call([addr = *maybe, pkt = std::move(pkt), ep, &ret]() {
+      std::vector<llarp::net::IPPacket> ippkts;
+      ippkts.reserve(num);
+      for (size_t idx = 0; idx < num; ++idx)
+      {
+        if (pkts[idx].data == nullptr or pkts[idx].len == 0)
+          return EINVAL;
+        auto& pkt = ippkts.emplace_back(llarp::net::IPPacket::UDP(
+            llarp::nuint32_t{0},
+            srcport,
+            llarp::nuint32_t{0},
+            dstport,
+            llarp_buffer_t{reinterpret_cast<const uint8_t*>(pkts[idx].data), pkts[idx].len}));
+        if (pkt.empty())
+          return EINVAL;
+      }
+      // one hop onto the lokinet thread for the lot
+      std::promise<size_t> ret;
+      ctx->impl->router->loop()->call([addr = *maybe, ippkts = std::move(ippkts), ep, &ret]() {
+        size_t n = 0;
         if (auto tag = ep->GetBestConvoTagFor(addr))
         {
-          if (ep->SendToOrQueue(*tag, pkt.ConstBuffer(), llarp::service::ProtocolType::TrafficV4))
+          for (const auto& pkt : ippkts)
           {
-            ret.set_value(0);
-            return;
+            if (not ep->SendToOrQueue(
+                    *tag, pkt.ConstBuffer(), llarp::service::ProtocolType::TrafficV4))
+              break;
+            ++n;
           }
         }
-        ret.set_value(ENETUNREACH);
+        ret.set_value(n);
       });
-      return ret.get_future().get();
+      const auto n = ret.get_future().get();
+      if (sent)
+        *sent = n;
+      return n == num ? 0 : ENETUNREACH;
     }
     return EINVAL;
   }
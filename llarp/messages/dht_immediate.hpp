@@ -12,7 +12,7 @@ namespace llarp
     DHTImmediateMessage() = default;
     ~DHTImmediateMessage() override = default;
 
-    std::vector<std::unique_ptr<dht::IMessage>> msgs;
+    std::vector<dht::IMessage::Ptr_t> msgs;
 
     bool
     DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* buf) override;
@@ -8,9 +8,23 @@ namespace llarp
 {
   struct ILinkSession;
 
+  /// optional link layer features a LIM can advertise; see LinkIntroMessage::Features
+  namespace link_features
+  {
+    /// understands eRACK, the range coded multi ack
+    constexpr uint64_t RangeACK = 1 << 0;
+    /// can take transport packets encrypted with aes-256-gcm (Crypto::aes256gcm_encrypt_packets)
+    /// as well as the default xchacha20 with a keyed hash; only advertised with hardware aes
+    constexpr uint64_t AES256GCM = 1 << 1;
+  }  // namespace link_features
+
   struct LinkIntroMessage : public ILinkMessage
   {
     static constexpr size_t MaxSize = MAX_RC_SIZE + 256;
+    /// feature bits ride in the upper half of P.  nobody reads P otherwise, and a new key would
+    /// break older peers, which reject keys they don't know and verify the signature over their
+    /// own re-encoding of the message.
+    static constexpr unsigned FeatureShift = 32;
 
     LinkIntroMessage() : ILinkMessage()
     {}
@@ -20,6 +34,19 @@ namespace llarp
     Signature Z;
     uint64_t P;
 
+    /// link_features bits the sender supports
+    uint64_t
+    Features() const
+    {
+      return P >> FeatureShift;
+    }
+
+    void
+    SetFeatures(uint64_t features)
+    {
+      P = (P & ((uint64_t{1} << FeatureShift) - 1)) | (features << FeatureShift);
+    }
+
     bool
     DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* buf) override;
 
@@ -8,13 +8,18 @@
 #include "relay_status.hpp"
 #include "relay.hpp"
 #include <llarp/router_contact.hpp>
+#include <llarp/util/arena.hpp>
+#include <llarp/util/bencode_span.hpp>
 #include <llarp/util/buffer.hpp>
 #include <llarp/util/logging.hpp>
 
-#include <memory>
+#include <array>
 
 namespace llarp
 {
+  /// one of each message, which we decode into and clear after, so that parsing allocates no
+  /// message.  there is one a thread, shared by every parser on it (a hive runs many routers to a
+  /// thread), as a parser only uses it while it is parsing.
   struct LinkMessageParser::msg_holder_t
   {
     LinkIntroMessage i;
@@ -26,10 +31,47 @@ namespace llarp
     DiscardMessage x;
 
     msg_holder_t() = default;
+
+    static msg_holder_t&
+    ThisThread()
+    {
+      static thread_local msg_holder_t holder;
+      return holder;
+    }
   };
 
+  namespace
+  {
+    using Holder = LinkMessageParser::msg_holder_t;
+    using Slot = ILinkMessage* (*)(Holder&);
+
+    template <auto member>
+    ILinkMessage*
+    Get(Holder& h)
+    {
+      return &(h.*member);
+    }
+
+    /// the message each type byte decodes into, or null for one we do not know
+    constexpr std::array<Slot, 256>
+    MakeDispatch()
+    {
+      std::array<Slot, 256> table{};
+      table['i'] = &Get<&Holder::i>;
+      table['d'] = &Get<&Holder::d>;
+      table['u'] = &Get<&Holder::u>;
+      table['m'] = &Get<&Holder::m>;
+      table['c'] = &Get<&Holder::c>;
+      table['s'] = &Get<&Holder::s>;
+      table['x'] = &Get<&Holder::x>;
+      return table;
+    }
+
+    constexpr auto dispatch = MakeDispatch();
+  }  // namespace
+
   LinkMessageParser::LinkMessageParser(AbstractRouter* _router)
-      : router(_router), from(nullptr), msg(nullptr), holder(std::make_unique<msg_holder_t>())
+      : router(_router), from(nullptr), msg(nullptr)
   {}
 
   LinkMessageParser::~LinkMessageParser() = default;
@@ -64,32 +106,10 @@ namespace llarp
       }
       // create the message to parse based off message type
       llarp::LogDebug("inbound message ", *strbuf.cur);
-      switch (*strbuf.cur)
-      {
-        case 'i':
-          msg = &holder->i;
-          break;
-        case 'd':
-          msg = &holder->d;
-          break;
-        case 'u':
-          msg = &holder->u;
-          break;
-        case 'm':
-          msg = &holder->m;
-          break;
-        case 'c':
-          msg = &holder->c;
-          break;
-        case 's':
-          msg = &holder->s;
-          break;
-        case 'x':
-          msg = &holder->x;
-          break;
-        default:
-          return false;
-      }
+      const auto slot = dispatch[*strbuf.cur];
+      if (slot == nullptr)
+        return false;
+      msg = slot(msg_holder_t::ThisThread());
 
       msg->session = from;
       firstkey = false;
@@ -124,9 +144,76 @@ namespace llarp
     }
 
     from = src;
+    // what the message decodes into, like a DHT message's list, comes out of the arena and goes
+    // with this; Reset() has to have emptied the message by the time it does
+    util::Arena::Scope scope;
+
+    // relay traffic, which is nearly all of it, is read straight off buf: by its fixed offsets
+    // when it is laid out as we write it, as it nearly always is, or else in one pass of the
+    // reader; the rest goes key by key through DecodeKey
+    auto& holder = msg_holder_t::ThisThread();
+    const auto data = buf.view_all();
+    switch (RelayMessageType(data))
+    {
+      case 'u':
+        if (holder.u.DecodeFixed(data))
+          return Handle(holder.u);
+        holder.u.Clear();
+        break;
+      case 'd':
+        if (holder.d.DecodeFixed(data))
+          return Handle(holder.d);
+        holder.d.Clear();
+        break;
+      default:
+        break;
+    }
+
+    bencode::Reader reader{data};
+    char key;
+    byte_view_t type;
+    if (reader.Dict() and reader.NextKey(key) and key == 'a' and reader.Bytes(type)
+        and type.size() == 1)
+    {
+      switch (type[0])
+      {
+        case 'u':
+          return DecodeAndHandle(holder.u, reader);
+        case 'd':
+          return DecodeAndHandle(holder.d, reader);
+        default:
+          break;
+      }
+    }
+
     firstkey = true;
     ManagedBuffer copy(buf);
-    return bencode_read_dict(*this, &copy.underlying);
+    const bool result = bencode_read_dict(*this, &copy.underlying);
+    // MessageDone resets it, but not if decoding stopped part way
+    Reset();
+    return result;
+  }
+
+  template <typename Msg_t>
+  bool
+  LinkMessageParser::DecodeAndHandle(Msg_t& m, bencode::Reader& reader)
+  {
+    msg = &m;
+    m.session = from;
+    const bool result = m.Decode(reader) and m.HandleMessage(router);
+    Reset();
+    return result;
+  }
+
+  template <typename Msg_t>
+  bool
+  LinkMessageParser::Handle(Msg_t& m)
+  {
+    msg = &m;
+    m.session = from;
+    const bool result = m.HandleMessage(router);
+    Reset();
+    return result;
   }
 
   void
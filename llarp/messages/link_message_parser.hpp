@@ -7,6 +7,11 @@
 
 namespace llarp
 {
+  namespace bencode
+  {
+    class Reader;
+  }
+
   struct AbstractRouter;
   struct ILinkMessage;
   struct ILinkSession;
@@ -36,14 +41,24 @@ namespace llarp
     RouterID
     GetCurrentFrom();
 
+    /// decodes the rest of m, whose type was just read, in one pass and handles it
+    template <typename Msg_t>
+    bool
+    DecodeAndHandle(Msg_t& m, bencode::Reader& reader);
+
+    /// handles m, which is already decoded
+    template <typename Msg_t>
+    bool
+    Handle(Msg_t& m);
+
+   public:
+    /// what we decode messages into; see the .cpp
+    struct msg_holder_t;
+
    private:
     bool firstkey;
     AbstractRouter* router;
     ILinkSession* from;
     ILinkMessage* msg;
-
-    struct msg_holder_t;
-
-    std::unique_ptr<msg_holder_t> holder;
   };
 }  // namespace llarp
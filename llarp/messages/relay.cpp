@@ -3,35 +3,190 @@
 #include <llarp/path/path_context.hpp>
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/util/bencode.hpp>
+#include <llarp/util/bencode_span.hpp>
+#include <llarp/util/trace.hpp>
+
+#include <charconv>
+#include <optional>
+#include <string_view>
 
 namespace llarp
 {
+  namespace
+  {
+    /// both directions have the same layout, but for the message type
+    bool
+    EncodeRelay(
+        llarp_buffer_t* buf,
+        char type,
+        const PathID_t& pathid,
+        const byte_view_t& X,
+        const TunnelNonce& Y)
+    {
+      bencode::Writer w{*buf};
+      w.Dict()
+          .Key('a')
+          .Bytes(&type, 1)
+          .Key('p')
+          .Bytes(pathid)
+          .Key('v')
+          .Int(llarp::constants::proto_version)
+          .Key('x')
+          .Bytes(X)
+          .Key('y')
+          .Bytes(Y)
+          .End();
+      return w.Commit(buf);
+    }
+
+    /// the keys after the message type, in one pass, leaving the payload in place
+    bool
+    DecodeRelay(
+        bencode::Reader& r, PathID_t& pathid, uint64_t& version, byte_view_t& X, TunnelNonce& Y)
+    {
+      bool any = false;
+      char key;
+      while (r.NextKey(key))
+      {
+        switch (key)
+        {
+          case 'p':
+            if (not r.Fixed(pathid))
+              return false;
+            break;
+          case 'v':
+            if (not r.Int(version) or version != llarp::constants::proto_version)
+              return false;
+            break;
+          case 'x':
+            if (not r.Bytes(X, MAX_RELAY_PAYLOAD_SIZE))
+            {
+              llarp::LogWarn("failed to decode key x for entry in dict");
+              return false;
+            }
+            break;
+          case 'y':
+            if (not r.Fixed(Y))
+              return false;
+            break;
+          default:
+            return false;
+        }
+        any = true;
+      }
+      return any and not r.Failed();
+    }
+
+    /// where EncodeRelay puts everything, for the messages it wrote:
+    ///   d 1:a 1:<type> 1:p 16:<pathid> 1:v i<version>e 1:x <n>:<payload> 1:y 24:<nonce> e
+    /// all of it is at a fixed offset from the start, but the payload and the nonce after it,
+    /// which are at a fixed offset from the end
+    static_assert(llarp::constants::proto_version < 10, "the version is one digit on the wire");
+    constexpr std::string_view FixedHead = "d1:a1:";
+    constexpr size_t FixedTypeAt = 6;
+    constexpr std::string_view FixedPathKey = "1:p16:";
+    constexpr size_t FixedPathAt = 13;
+    constexpr char FixedVersion[] = {
+        '1', ':', 'v', 'i', '0' + llarp::constants::proto_version, 'e', '1', ':', 'x'};
+    constexpr size_t FixedVersionAt = FixedPathAt + PathID_t::SIZE;
+    constexpr size_t FixedPayloadLenAt = FixedVersionAt + sizeof(FixedVersion);
+    constexpr std::string_view FixedNonceKey = "1:y24:";
+    constexpr size_t FixedTail = FixedNonceKey.size() + TunnelNonce::SIZE + 1;
+
+    bool
+    Matches(byte_view_t data, size_t at, std::string_view expect)
+    {
+      return std::memcmp(data.data() + at, expect.data(), expect.size()) == 0;
+    }
+
+    /// where the payload is in a message in EncodeRelay's layout, or nothing if it is not one
+    std::optional<byte_view_t>
+    FixedPayload(byte_view_t data)
+    {
+      if (data.size() < FixedPayloadLenAt + 2 + FixedTail
+          or not Matches(data, 0, FixedHead)
+          or not Matches(data, FixedTypeAt + 1, FixedPathKey)
+          or not Matches(data, FixedVersionAt, {FixedVersion, sizeof(FixedVersion)})
+          or not Matches(data, data.size() - FixedTail, FixedNonceKey) or data.back() != 'e')
+        return std::nullopt;
+      // the payload length is the one thing laid out by what is in it
+      const auto* begin = reinterpret_cast<const char*>(data.data()) + FixedPayloadLenAt;
+      const auto* end = reinterpret_cast<const char*>(data.data()) + data.size() - FixedTail;
+      size_t len = 0;
+      const auto [colon, ec] = std::from_chars(begin, end, len);
+      if (ec != std::errc{} or colon == begin or colon == end or *colon != ':'
+          or len > MAX_RELAY_PAYLOAD_SIZE or static_cast<size_t>(end - (colon + 1)) != len)
+        return std::nullopt;
+      return byte_view_t{reinterpret_cast<const byte_t*>(colon + 1), len};
+    }
+
+    bool
+    DecodeRelayFixed(byte_view_t data, PathID_t& pathid, byte_view_t& X, TunnelNonce& Y)
+    {
+      const auto payload = FixedPayload(data);
+      if (not payload)
+        return false;
+      std::copy_n(data.data() + FixedPathAt, PathID_t::SIZE, pathid.begin());
+      const auto* nonce = data.data() + data.size() - FixedTail + FixedNonceKey.size();
+      std::copy_n(nonce, TunnelNonce::SIZE, Y.begin());
+      X = *payload;
+      return true;
+    }
+
+    /// like BEncodeMaybeReadDictEntry but leaves the payload where it is in buf
+    bool
+    MaybeReadPayload(byte_view_t& X, bool& read, const llarp_buffer_t& key, llarp_buffer_t* buf)
+    {
+      if (not key.startswith("x"))
+        return true;
+      llarp_buffer_t strbuf;
+      if (not bencode_read_string(buf, &strbuf) or strbuf.sz > MAX_RELAY_PAYLOAD_SIZE)
+      {
+        llarp::LogWarn("failed to decode key x for entry in dict");
+        return false;
+      }
+      X = byte_view_t{strbuf.base, strbuf.sz};
+      read = true;
+      return true;
+    }
+  }  // namespace
+
+  char
+  RelayMessageType(byte_view_t data)
+  {
+    if (data.size() <= FixedTypeAt or not Matches(data, 0, FixedHead))
+      return 0;
+    const char type = data[FixedTypeAt];
+    return type == 'u' or type == 'd' ? type : 0;
+  }
+
   void
   RelayUpstreamMessage::Clear()
   {
     pathid.Zero();
-    X.Clear();
+    X = {};
     Y.Zero();
+    priority = 0;
     version = 0;
   }
 
   bool
   RelayUpstreamMessage::BEncode(llarp_buffer_t* buf) const
   {
-    if (!bencode_start_dict(buf))
-      return false;
-    if (!BEncodeWriteDictMsgType(buf, "a", "u"))
-      return false;
+    return EncodeRelay(buf, 'u', pathid, X, Y);
+  }
 
-    if (!BEncodeWriteDictEntry("p", pathid, buf))
-      return false;
-    if (!BEncodeWriteDictInt("v", llarp::constants::proto_version, buf))
-      return false;
-    if (!BEncodeWriteDictEntry("x", X, buf))
-      return false;
-    if (!BEncodeWriteDictEntry("y", Y, buf))
-      return false;
-    return bencode_end(buf);
+  bool
+  RelayUpstreamMessage::Decode(bencode::Reader& reader)
+  {
+    return DecodeRelay(reader, pathid, version, X, Y);
+  }
+
+  bool
+  RelayUpstreamMessage::DecodeFixed(byte_view_t data)
+  {
+    version = llarp::constants::proto_version;
+    return DecodeRelayFixed(data, pathid, X, Y);
   }
 
   bool
@@ -42,7 +197,7 @@ namespace llarp
       return false;
     if (!BEncodeMaybeVerifyVersion("v", version, llarp::constants::proto_version, read, key, buf))
       return false;
-    if (!BEncodeMaybeReadDictEntry("x", X, read, key, buf))
+    if (!MaybeReadPayload(X, read, key, buf))
       return false;
     if (!BEncodeMaybeReadDictEntry("y", Y, read, key, buf))
       return false;
@@ -52,10 +207,11 @@ namespace llarp
   bool
   RelayUpstreamMessage::HandleMessage(AbstractRouter* r) const
   {
+    LLARP_TRACE(relay_upstream_recv, trace::ID(pathid), trace::ID(Y), X.size());
     auto path = r->pathContext().GetByDownstream(session->GetPubKey(), pathid);
     if (path)
     {
-      return path->HandleUpstream(llarp_buffer_t(X), Y, r);
+      return path->HandleUpstream(llarp_buffer_t(X), Y, r, priority);
     }
     return false;
   }
@@ -64,28 +220,29 @@ namespace llarp
   RelayDownstreamMessage::Clear()
   {
     pathid.Zero();
-    X.Clear();
+    X = {};
     Y.Zero();
+    priority = 0;
     version = 0;
   }
 
   bool
   RelayDownstreamMessage::BEncode(llarp_buffer_t* buf) const
   {
-    if (!bencode_start_dict(buf))
-      return false;
-    if (!BEncodeWriteDictMsgType(buf, "a", "d"))
-      return false;
+    return EncodeRelay(buf, 'd', pathid, X, Y);
+  }
 
-    if (!BEncodeWriteDictEntry("p", pathid, buf))
-      return false;
-    if (!BEncodeWriteDictInt("v", llarp::constants::proto_version, buf))
-      return false;
-    if (!BEncodeWriteDictEntry("x", X, buf))
-      return false;
-    if (!BEncodeWriteDictEntry("y", Y, buf))
-      return false;
-    return bencode_end(buf);
+  bool
+  RelayDownstreamMessage::Decode(bencode::Reader& reader)
+  {
+    return DecodeRelay(reader, pathid, version, X, Y);
+  }
+
+  bool
+  RelayDownstreamMessage::DecodeFixed(byte_view_t data)
+  {
+    version = llarp::constants::proto_version;
+    return DecodeRelayFixed(data, pathid, X, Y);
   }
 
   bool
@@ -96,7 +253,7 @@ namespace llarp
       return false;
     if (!BEncodeMaybeVerifyVersion("v", version, llarp::constants::proto_version, read, key, buf))
       return false;
-    if (!BEncodeMaybeReadDictEntry("x", X, read, key, buf))
+    if (!MaybeReadPayload(X, read, key, buf))
       return false;
     if (!BEncodeMaybeReadDictEntry("y", Y, read, key, buf))
       return false;
@@ -106,10 +263,11 @@ namespace llarp
   bool
   RelayDownstreamMessage::HandleMessage(AbstractRouter* r) const
   {
+    LLARP_TRACE(relay_downstream_recv, trace::ID(pathid), trace::ID(Y), X.size());
     auto path = r->pathContext().GetByUpstream(session->GetPubKey(), pathid);
     if (path)
     {
-      return path->HandleDownstream(llarp_buffer_t(X), Y, r);
+      return path->HandleDownstream(llarp_buffer_t(X), Y, r, priority);
     }
     llarp::LogWarn("no path for downstream message id=", pathid);
     return false;
@@ -1,22 +1,50 @@
 #pragma once
 
-#include <llarp/crypto/encrypted.hpp>
+#include <llarp/constants/link_layer.hpp>
 #include <llarp/crypto/types.hpp>
 #include "link_message.hpp"
 #include <llarp/path/path_types.hpp>
+#include <llarp/util/buffer.hpp>
 
 #include <vector>
 
 namespace llarp
 {
+  namespace bencode
+  {
+    class Reader;
+  }
+
+  /// largest onion payload we accept in a relay message
+  constexpr size_t MAX_RELAY_PAYLOAD_SIZE = MAX_LINK_MSG_SIZE - 128;
+
+  /// 'u' or 'd' if data starts as a relay message does, going by the bytes at fixed offsets
+  /// rather than walking its bencode; 0 for anything else
+  char
+  RelayMessageType(byte_view_t data);
+
   struct RelayUpstreamMessage : public ILinkMessage
   {
-    Encrypted<MAX_LINK_MSG_SIZE - 128> X;
+    /// the onion payload, which we never copy.  once decoded it points into the link buffer the
+    /// message was parsed from and is only valid during HandleMessage; when sending it points at
+    /// the caller's traffic buffer, which only has to outlive SendToOrQueue as that encodes it.
+    byte_view_t X;
     TunnelNonce Y;
+    /// see Priority(); not sent, so 0 in messages we got
+    uint16_t priority = 0;
 
     bool
     DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* buf) override;
 
+    /// decodes the keys after the message type in one pass; what LinkMessageParser uses
+    bool
+    Decode(bencode::Reader& reader);
+
+    /// decodes a whole message RelayMessageType said is 'u' by its fixed offsets, if it is laid
+    /// out just as we write them; false if not, though Decode may still read it
+    bool
+    DecodeFixed(byte_view_t data);
+
     bool
     BEncode(llarp_buffer_t* buf) const override;
 
@@ -34,18 +62,29 @@ namespace llarp
     uint16_t
     Priority() const override
     {
-      return 0;
+      return priority;
     }
   };
 
   struct RelayDownstreamMessage : public ILinkMessage
   {
-    Encrypted<MAX_LINK_MSG_SIZE - 128> X;
+    /// see RelayUpstreamMessage::X
+    byte_view_t X;
     TunnelNonce Y;
+    /// see RelayUpstreamMessage::priority
+    uint16_t priority = 0;
 
     bool
     DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* buf) override;
 
+    /// see RelayUpstreamMessage::Decode
+    bool
+    Decode(bencode::Reader& reader);
+
+    /// see RelayUpstreamMessage::DecodeFixed
+    bool
+    DecodeFixed(byte_view_t data);
+
     bool
     BEncode(llarp_buffer_t* buf) const override;
 
@@ -64,7 +103,7 @@ namespace llarp
     uint16_t
     Priority() const override
     {
-      return 0;
+      return priority;
     }
   };
 }  // namespace llarp
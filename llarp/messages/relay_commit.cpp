@@ -14,6 +14,8 @@
 #include <llarp/util/meta/memfn.hpp>
 #include <llarp/tooling/path_event.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <optional>
 
@@ -176,9 +178,6 @@ namespace llarp
   {
     using Context = llarp::path::PathContext;
     using Hop = llarp::path::TransitHop;
-    using Decrypter = AsyncFrameDecrypter<LRCMFrameDecrypt>;
-    using Decrypter_ptr = std::unique_ptr<Decrypter>;
-    Decrypter_ptr decrypter;
     std::array<EncryptedFrame, 8> frames;
     Context* context;
     // decrypted record
@@ -188,15 +187,18 @@ namespace llarp
 
     const std::optional<IpAddress> fromAddr;
 
-    LRCMFrameDecrypt(Context* ctx, Decrypter_ptr dec, const LR_CommitMessage* commit)
-        : decrypter(std::move(dec))
-        , frames(commit->frames)
+    /// when we got the LRCM, for the hive to see how long hops spend on them
+    const std::chrono::steady_clock::time_point received;
+
+    LRCMFrameDecrypt(Context* ctx, const LR_CommitMessage* commit)
+        : frames(commit->frames)
         , context(ctx)
         , hop(std::make_shared<Hop>())
         , fromAddr(
               commit->session->GetRemoteRC().IsPublicRouter()
                   ? std::optional<IpAddress>{}
                   : commit->session->GetRemoteEndpoint())
+        , received(std::chrono::steady_clock::now())
     {
       hop->info.downstream = commit->session->GetPubKey();
     }
@@ -239,9 +241,11 @@ namespace llarp
           std::abort();
           break;
       }
-      router->QueueWork([router, path, pathid, nextHop, pathKey, status] {
-        LR_StatusMessage::CreateAndSend(router, path, pathid, nextHop, pathKey, status);
-      });
+      router->QueueWork(
+          [router, path, pathid, nextHop, pathKey, status] {
+            LR_StatusMessage::CreateAndSend(router, path, pathid, nextHop, pathKey, status);
+          },
+          thread::WorkClass::PathBuild);
     }
 
     /// this is done from logic thread
@@ -361,25 +365,29 @@ namespace llarp
     // TODO: If decryption has succeeded here but we otherwise don't
     //       want to or can't accept the path build request, send
     //       a status message saying as much.
-    static void
-    HandleDecrypted(llarp_buffer_t* buf, std::shared_ptr<LRCMFrameDecrypt> self)
+    /// the worker half, run in the commit stage; returns the logic thread half if we are going
+    /// ahead with the build.  when reject is set we are too backed up to take the build, and
+    /// refuse it as soon as we have the keys to reply with.
+    static std::function<void()>
+    Process(std::shared_ptr<LRCMFrameDecrypt> self, bool reject)
     {
       auto now = self->context->Router()->Now();
       auto& info = self->hop->info;
-      if (!buf)
+      // our frame is shifted out below, so we decrypt it where it is
+      auto& frame = self->frames[0];
+      if (!frame.DecryptInPlace(self->context->EncryptionSecretKey()))
       {
         llarp::LogError("LRCM decrypt failed from ", info.downstream);
-        self->decrypter = nullptr;
-        return;
+        return nullptr;
       }
+      auto buf = frame.Buffer();
       buf->cur = buf->base + EncryptedFrameOverheadSize;
       llarp::LogDebug("decrypted LRCM from ", info.downstream);
       // successful decrypt
       if (!self->record.BDecode(buf))
       {
         llarp::LogError("malformed frame inside LRCM from ", info.downstream);
-        self->decrypter = nullptr;
-        return;
+        return nullptr;
       }
 
       info.txID = self->record.txid;
@@ -388,8 +396,7 @@ namespace llarp
       if (info.txID.IsZero() || info.rxID.IsZero())
       {
         llarp::LogError("LRCM refusing zero pathid");
-        self->decrypter = nullptr;
-        return;
+        return nullptr;
       }
 
       info.upstream = self->record.nextHop;
@@ -403,11 +410,22 @@ namespace llarp
               self->record.tunnelNonce))
       {
         llarp::LogError("LRCM DH Failed ", info);
-        self->decrypter = nullptr;
-        return;
+        return nullptr;
       }
       // generate hash of hop key for nonce mutation
       crypto->shorthash(self->hop->nonceXOR, llarp_buffer_t(self->hop->pathKey));
+      if (reject)
+      {
+        llarp::LogWarn("path build backlog is full, refusing LRCM ", info);
+        LR_StatusMessage::CreateAndSend(
+            self->context->Router(),
+            self->hop,
+            info.rxID,
+            info.downstream,
+            self->hop->pathKey,
+            LR_StatusRecord::FAIL_CONGESTION);
+        return nullptr;
+      }
       if (self->record.work && self->record.work->IsValid(now))
       {
         llarp::LogDebug(
@@ -428,60 +446,45 @@ namespace llarp
       self->hop->started = now;
 
       self->context->Router()->NotifyRouterEvent<tooling::PathRequestReceivedEvent>(
-          self->context->Router()->pubkey(), self->hop);
-
-      size_t sz = self->frames[0].size();
-      // shift
-      std::array<EncryptedFrame, 8> frames;
-      frames[0] = self->frames[1];
-      frames[1] = self->frames[2];
-      frames[2] = self->frames[3];
-      frames[3] = self->frames[4];
-      frames[4] = self->frames[5];
-      frames[5] = self->frames[6];
-      frames[6] = self->frames[7];
-      // put our response on the end
-      frames[7] = EncryptedFrame(sz - EncryptedFrameOverheadSize);
-      // random junk for now
-      frames[7].Randomize();
-      self->frames = std::move(frames);
+          self->context->Router()->pubkey(),
+          self->hop,
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - self->received));
+
+      // shift the rest down in place, and put our response on the end the size ours was: random
+      // junk for now, which also covers what we decrypted
+      const size_t sz = frame.size();
+      std::move(self->frames.begin() + 1, self->frames.end(), self->frames.begin());
+      auto& last = self->frames.back();
+      last.Resize(sz);
+      last.Randomize();
       if (self->context->HopIsUs(info.upstream))
       {
         // we are the farthest hop
         llarp::LogDebug("We are the farthest hop for ", info);
         // send a LRSM down the path
-        self->context->loop()->call([self] {
-          SendPathConfirm(self);
-          self->decrypter = nullptr;
-        });
+        return [self] { SendPathConfirm(self); };
       }
-      else
-      {
-        // forward upstream
-        // we are still in the worker thread so post job to logic
-        self->context->loop()->call([self] {
-          SendLRCM(self);
-          self->decrypter = nullptr;
-        });
-      }
-      // trigger idempotent pump to ensure that the build messages propagate
-      self->context->Router()->TriggerPump();
+      // forward upstream
+      return [self] { SendLRCM(self); };
     }
   };
 
   bool
   LR_CommitMessage::AsyncDecrypt(llarp::path::PathContext* context) const
   {
-    auto decrypter = std::make_unique<LRCMFrameDecrypt::Decrypter>(
-        context->EncryptionSecretKey(), &LRCMFrameDecrypt::HandleDecrypted);
+    const auto backlog = context->CommitBacklog();
+    if (backlog >= path::commit_backlog_drop)
+    {
+      // we can't even afford to say no, as that takes the same key exchanges as saying yes
+      llarp::LogWarn("path build backlog of ", backlog, " is full, dropping LRCM");
+      return true;
+    }
     // copy frames so we own them
-    auto frameDecrypt = std::make_shared<LRCMFrameDecrypt>(context, std::move(decrypter), this);
-
-    // decrypt frames async
-    frameDecrypt->decrypter->AsyncDecrypt(
-        frameDecrypt->frames[0], frameDecrypt, [r = context->Router()](auto func) {
-          r->QueueWork(std::move(func));
-        });
+    auto frameDecrypt = std::make_shared<LRCMFrameDecrypt>(context, this);
+    context->QueueCommit([frameDecrypt, reject = backlog >= path::commit_backlog_reject] {
+      return LRCMFrameDecrypt::Process(frameDecrypt, reject);
+    });
     return true;
   }
 }  // namespace llarp
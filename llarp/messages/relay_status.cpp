@@ -16,46 +16,6 @@
 
 namespace llarp
 {
-  struct LRSM_AsyncHandler : public std::enable_shared_from_this<LRSM_AsyncHandler>
-  {
-    using HopHandler_ptr = std::shared_ptr<llarp::path::IHopHandler>;
-
-    std::array<EncryptedFrame, 8> frames;
-    uint64_t status = 0;
-    HopHandler_ptr hop;
-    AbstractRouter* router;
-    PathID_t pathid;
-
-    LRSM_AsyncHandler(
-        std::array<EncryptedFrame, 8> _frames,
-        uint64_t _status,
-        HopHandler_ptr _hop,
-        AbstractRouter* _router,
-        PathID_t pathid)
-        : frames{std::move(_frames)}
-        , status{_status}
-        , hop{std::move(_hop)}
-        , router{_router}
-        , pathid{std::move(pathid)}
-    {}
-
-    ~LRSM_AsyncHandler() = default;
-
-    void
-    handle()
-    {
-      router->NotifyRouterEvent<tooling::PathStatusReceivedEvent>(router->pubkey(), pathid, status);
-      hop->HandleLRSM(status, frames, router);
-    }
-
-    void
-    queue_handle()
-    {
-      auto func = [self = shared_from_this()] { self->handle(); };
-      router->QueueWork(func);
-    }
-  };
-
   bool
   LR_StatusMessage::DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* buf)
   {
@@ -137,8 +97,15 @@ namespace llarp
       llarp::LogWarn("unhandled LR_Status message: no associated path found pathid=", pathid);
       return false;
     }
-    auto handler = std::make_shared<LRSM_AsyncHandler>(frames, status, path, router, pathid);
-    handler->queue_handle();
+    // we decode into a message that is reused, so the job gets its own frames
+    router->pathContext().QueueStatus([router,
+                                       hop = std::move(path),
+                                       frames = frames,
+                                       status = status,
+                                       pathid = pathid]() mutable {
+      router->NotifyRouterEvent<tooling::PathStatusReceivedEvent>(router->pubkey(), pathid, status);
+      return hop->HandleLRSM(status, frames, router);
+    });
     return true;
   }
 
@@ -222,6 +189,7 @@ namespace llarp
   {
     router->loop()->call([router, nextHop, msg = std::move(msg), hop = std::move(hop)] {
       SendMessage(router, nextHop, msg, hop);
+      router->TriggerPump();
     });
   }
 
@@ -247,9 +215,6 @@ namespace llarp
     // if it fails we are hitting a failure case we can't cope with so ... drop.
     if (not router->SendToOrQueue(nextHop, *msg, resultCallback))
       resultCallback(SendStatus::Congestion);
-
-    // trigger idempotent pump to make sure stuff gets sent
-    router->TriggerPump();
   }
 
   bool
@@ -0,0 +1,193 @@
+#include "fair_queue.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace llarp::net
+{
+  namespace
+  {
+    /// fnv-1a over sz bytes at buf, on from hash
+    uint64_t
+    Mix(uint64_t hash, const byte_t* buf, size_t sz)
+    {
+      for (size_t i = 0; i < sz; ++i)
+      {
+        hash ^= buf[i];
+        hash *= 0x100000001b3ULL;
+      }
+      return hash;
+    }
+  }  // namespace
+
+  FairQueue::FairQueue(Config conf)
+      : m_Conf{conf}
+      , m_Flows(std::max<uint32_t>(conf.flows, 1))
+      , m_Perturbation{conf.perturbation.value_or(std::random_device{}())}
+  {}
+
+  uint32_t
+  FairQueue::FlowFor(const IPPacket& pkt) const
+  {
+    const byte_t* buf = pkt.data();
+    const size_t sz = pkt.size();
+    uint64_t hash = Mix(0xcbf29ce484222325ULL, reinterpret_cast<const byte_t*>(&m_Perturbation), 8);
+    size_t l4 = 0;
+    byte_t proto = 0;
+    if (pkt.IsV4() and sz >= 20)
+    {
+      // addresses and protocol
+      hash = Mix(hash, buf + 12, 8);
+      proto = buf[9];
+      l4 = (buf[0] & 0x0f) * 4;
+    }
+    else if (pkt.IsV6() and sz >= 40)
+    {
+      hash = Mix(hash, buf + 8, 32);
+      proto = buf[6];
+      l4 = 40;
+    }
+    hash = Mix(hash, &proto, 1);
+    // the ports of tcp and udp, which come first in both
+    if ((proto == 6 or proto == 17) and l4 + 4 <= sz)
+      hash = Mix(hash, buf + l4, 4);
+    return hash % m_Flows.size();
+  }
+
+  void
+  FairQueue::Enqueue(IPPacket pkt, llarp_time_t now)
+  {
+    if (pkt.empty())
+      return;
+    const auto idx = FlowFor(pkt);
+    auto& flow = m_Flows[idx];
+    flow.bytes += pkt.size();
+    flow.pkts.emplace_back(std::move(pkt), now);
+    ++m_Size;
+    if (not flow.listed)
+    {
+      flow.listed = true;
+      flow.deficit = m_Conf.quantum;
+      m_NewFlows.push_back(idx);
+    }
+    if (m_Size > m_Conf.limit)
+      DropFromBiggest();
+  }
+
+  void
+  FairQueue::DropFromBiggest()
+  {
+    auto itr = std::max_element(m_Flows.begin(), m_Flows.end(), [](const auto& a, const auto& b) {
+      return a.bytes < b.bytes;
+    });
+    if (itr->pkts.empty())
+      return;
+    itr->bytes -= itr->pkts.front().first.size();
+    itr->pkts.pop_front();
+    --m_Size;
+    ++m_Dropped;
+  }
+
+  llarp_time_t
+  FairQueue::ControlLaw(llarp_time_t t, uint32_t count) const
+  {
+    const auto next = std::chrono::duration<double, std::milli>{m_Conf.interval} / std::sqrt(count);
+    return t + std::chrono::duration_cast<llarp_time_t>(next);
+  }
+
+  std::optional<IPPacket>
+  FairQueue::TakeHead(Flow& flow, llarp_time_t now, bool& okToDrop)
+  {
+    okToDrop = false;
+    if (flow.pkts.empty())
+    {
+      flow.firstAboveTime = 0s;
+      return std::nullopt;
+    }
+    auto [pkt, queuedAt] = std::move(flow.pkts.front());
+    flow.pkts.pop_front();
+    flow.bytes -= pkt.size();
+    --m_Size;
+    const auto sojourn = now - queuedAt;
+    // a flow with no more than a packet waiting is not what is building the queue
+    if (sojourn < m_Conf.target or flow.bytes <= m_Conf.quantum)
+      flow.firstAboveTime = 0s;
+    else if (flow.firstAboveTime == 0s)
+      flow.firstAboveTime = now + m_Conf.interval;
+    else if (now >= flow.firstAboveTime)
+      okToDrop = true;
+    return std::move(pkt);
+  }
+
+  std::optional<IPPacket>
+  FairQueue::CoDelDequeue(Flow& flow, llarp_time_t now)
+  {
+    bool okToDrop;
+    auto pkt = TakeHead(flow, now, okToDrop);
+    if (flow.dropping)
+    {
+      if (not okToDrop)
+        flow.dropping = false;
+      while (pkt and flow.dropping and now >= flow.dropNext)
+      {
+        ++m_Dropped;
+        ++flow.count;
+        pkt = TakeHead(flow, now, okToDrop);
+        if (not okToDrop)
+          flow.dropping = false;
+        else
+          flow.dropNext = ControlLaw(flow.dropNext, flow.count);
+      }
+    }
+    else if (pkt and okToDrop)
+    {
+      ++m_Dropped;
+      pkt = TakeHead(flow, now, okToDrop);
+      flow.dropping = true;
+      // drop faster straight away if we were dropping not long ago
+      const uint32_t delta = flow.count - flow.lastCount;
+      flow.count = 1;
+      if (delta > 1 and now - flow.dropNext < 16 * m_Conf.interval)
+        flow.count = delta;
+      flow.dropNext = ControlLaw(now, flow.count);
+      flow.lastCount = flow.count;
+    }
+    return pkt;
+  }
+
+  std::optional<IPPacket>
+  FairQueue::Dequeue(llarp_time_t now)
+  {
+    while (true)
+    {
+      auto* list = &m_NewFlows;
+      if (list->empty())
+        list = &m_OldFlows;
+      if (list->empty())
+        return std::nullopt;
+
+      const auto idx = list->front();
+      auto& flow = m_Flows[idx];
+      if (flow.deficit <= 0)
+      {
+        flow.deficit += m_Conf.quantum;
+        list->pop_front();
+        m_OldFlows.push_back(idx);
+        continue;
+      }
+      if (auto pkt = CoDelDequeue(flow, now))
+      {
+        flow.deficit -= pkt->size();
+        return pkt;
+      }
+      list->pop_front();
+      // a new flow that empties goes to the back of the old ones, so a flow can't get ahead by
+      // going quiet now and then; an old one that empties is done for now
+      if (list == &m_NewFlows and not m_OldFlows.empty())
+        m_OldFlows.push_back(idx);
+      else
+        flow.listed = false;
+    }
+  }
+}  // namespace llarp::net
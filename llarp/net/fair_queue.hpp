@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ip_packet.hpp"
+#include <llarp/util/time.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace llarp::net
+{
+  /// fq-codel (rfc 8290) over ip packets: packets are hashed by their 5-tuple into flows, flows
+  /// that have only just started sending go ahead of the ones that have been sending for a while,
+  /// the rest take turns a quantum of bytes at a time, and each flow drops from its head as codel
+  /// (rfc 8289) says once its packets have been sitting for longer than the target for an
+  /// interval.  it only does anything where packets wait in it, so whoever takes packets out has
+  /// to do it no faster than they can go.
+  class FairQueue
+  {
+   public:
+    struct Config
+    {
+      /// how many flows packets are hashed to
+      uint32_t flows = 1024;
+      /// how many packets we hold in all, past which we drop from the biggest flow
+      size_t limit = 10240;
+      /// how many bytes a flow sends every turn
+      uint32_t quantum = 1514;
+      /// how long a packet may sit before codel starts looking to drop
+      llarp_time_t target = 5ms;
+      /// how long packets have to have been sitting past the target before we drop
+      llarp_time_t interval = 100ms;
+      /// mixed into the hash so that which flows share a queue can't be picked from outside;
+      /// random unless set
+      std::optional<uint64_t> perturbation;
+    };
+
+    explicit FairQueue(Config conf);
+
+    FairQueue() : FairQueue{Config{}}
+    {}
+
+    /// queue pkt, which came in at now
+    void
+    Enqueue(IPPacket pkt, llarp_time_t now);
+
+    /// the next packet to send, if any
+    std::optional<IPPacket>
+    Dequeue(llarp_time_t now);
+
+    /// how many packets we hold
+    size_t
+    Size() const
+    {
+      return m_Size;
+    }
+
+    bool
+    Empty() const
+    {
+      return m_Size == 0;
+    }
+
+    /// how many packets we have dropped in all
+    uint64_t
+    Dropped() const
+    {
+      return m_Dropped;
+    }
+
+   private:
+    struct Flow
+    {
+      std::deque<std::pair<IPPacket, llarp_time_t>> pkts;
+      size_t bytes = 0;
+      int64_t deficit = 0;
+      /// on the new or old list
+      bool listed = false;
+      // codel
+      bool dropping = false;
+      llarp_time_t firstAboveTime = 0s;
+      llarp_time_t dropNext = 0s;
+      uint32_t count = 0;
+      uint32_t lastCount = 0;
+    };
+
+    uint32_t
+    FlowFor(const IPPacket& pkt) const;
+
+    /// take the head of flow, noting whether codel says it has been sitting long enough to drop
+    std::optional<IPPacket>
+    TakeHead(Flow& flow, llarp_time_t now, bool& okToDrop);
+
+    /// codel's dequeue for flow
+    std::optional<IPPacket>
+    CoDelDequeue(Flow& flow, llarp_time_t now);
+
+    llarp_time_t
+    ControlLaw(llarp_time_t t, uint32_t count) const;
+
+    /// make room by dropping from the head of the flow with the most bytes
+    void
+    DropFromBiggest();
+
+    Config m_Conf;
+    std::vector<Flow> m_Flows;
+    std::deque<uint32_t> m_NewFlows;
+    std::deque<uint32_t> m_OldFlows;
+    size_t m_Size = 0;
+    uint64_t m_Dropped = 0;
+    uint64_t m_Perturbation;
+  };
+}  // namespace llarp::net
@@ -11,8 +11,16 @@
 #include <oxenc/endian.h>
 
 #include <algorithm>
+#include <array>
+#include <cstring>
 #include <map>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 namespace llarp::net
 {
   constexpr uint32_t ipv6_flowlabel_mask = 0b0000'0000'0000'1111'1111'1111'1111'1111;
@@ -96,15 +104,56 @@ namespace llarp::net
       _buf.resize(0);
       return;
     }
-    _buf.resize(view.size());
-    std::copy_n(view.data(), size(), data());
+    _buf = util::BufferPool::Acquire(view.data(), view.size());
   }
 
   IPPacket::IPPacket(size_t sz)
   {
     if (sz and sz < MinSize)
       throw std::invalid_argument{"buffer size is too small to hold an ip packet"};
-    _buf.resize(sz);
+    if (sz)
+      _buf = util::BufferPool::Acquire(sz);
+  }
+
+  IPPacket::IPPacket(const IPPacket& other)
+      : timestamp{other.timestamp}, _buf{util::BufferPool::Acquire(other.data(), other.size())}
+  {}
+
+  IPPacket::IPPacket(IPPacket&& other) noexcept
+      : timestamp{other.timestamp}, _buf{std::move(other._buf)}
+  {}
+
+  IPPacket&
+  IPPacket::operator=(const IPPacket& other)
+  {
+    if (this == &other)
+      return *this;
+    timestamp = other.timestamp;
+    // keep the buffer we have if it will do
+    if (_buf.capacity() < other.size())
+    {
+      util::BufferPool::Release(_buf);
+      _buf = util::BufferPool::Acquire(other.data(), other.size());
+    }
+    else
+      _buf.assign(other._buf.begin(), other._buf.end());
+    return *this;
+  }
+
+  IPPacket&
+  IPPacket::operator=(IPPacket&& other) noexcept
+  {
+    if (this == &other)
+      return *this;
+    util::BufferPool::Release(_buf);
+    timestamp = other.timestamp;
+    _buf = std::move(other._buf);
+    return *this;
+  }
+
+  IPPacket::~IPPacket()
+  {
+    util::BufferPool::Release(_buf);
   }
 
   SockAddr
@@ -128,7 +177,7 @@ namespace llarp::net
       return SockAddr{ToNet(dstv6()), port};
   }
 
-  IPPacket::IPPacket(std::vector<byte_t>&& stolen) : _buf{stolen}
+  IPPacket::IPPacket(std::vector<byte_t>&& stolen) : _buf{std::move(stolen)}
   {
     if (size() < MinSize)
       _buf.resize(0);
@@ -203,29 +252,78 @@ namespace llarp::net
     return ExpandV4Lan(srcv4());
   }
 
-  uint16_t
-  ipchksum(const byte_t* buf, size_t sz, uint32_t sum)
+  namespace
   {
-    while (sz > 1)
+    /// one's complement sum of the 16 bit words of the sz bytes at buf, not yet folded down to 16
+    /// bits.  the words are summed as they are in memory, whatever order that is, which works
+    /// out as long as the sum goes back the same way: carries wrap around either way.
+    uint64_t
+    WideSum(const byte_t* buf, size_t sz)
     {
-      sum += *(const uint16_t*)buf;
-      sz -= sizeof(uint16_t);
-      buf += sizeof(uint16_t);
-    }
-    if (sz != 0)
-    {
-      uint16_t x = 0;
-
-      *(byte_t*)&x = *(const byte_t*)buf;
-      sum += x;
+      uint64_t sum = 0;
+#if defined(__SSE2__)
+      // 16 bytes at a time, as 32 bit lanes that we empty before they could carry out
+      const __m128i zero = _mm_setzero_si128();
+      while (sz >= 16)
+      {
+        __m128i acc = zero;
+        for (size_t n = 0; n < 16384 and sz >= 16; ++n, buf += 16, sz -= 16)
+        {
+          const __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+          acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(words, zero));
+          acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(words, zero));
+        }
+        alignas(16) std::array<uint32_t, 4> lanes;
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes.data()), acc);
+        for (const auto lane : lanes)
+          sum += lane;
+      }
+#elif defined(__ARM_NEON)
+      while (sz >= 16)
+      {
+        uint32x4_t acc = vdupq_n_u32(0);
+        for (size_t n = 0; n < 16384 and sz >= 16; ++n, buf += 16, sz -= 16)
+          acc = vpadalq_u16(acc, vreinterpretq_u16_u8(vld1q_u8(buf)));
+        const uint64x2_t halves = vpaddlq_u32(acc);
+        sum += vgetq_lane_u64(halves, 0) + vgetq_lane_u64(halves, 1);
+      }
+#endif
+      for (; sz >= sizeof(uint32_t); buf += sizeof(uint32_t), sz -= sizeof(uint32_t))
+      {
+        uint32_t word;
+        std::memcpy(&word, buf, sizeof(word));
+        sum += word;
+      }
+      if (sz >= sizeof(uint16_t))
+      {
+        uint16_t word;
+        std::memcpy(&word, buf, sizeof(word));
+        sum += word;
+        buf += sizeof(uint16_t);
+        sz -= sizeof(uint16_t);
+      }
+      if (sz != 0)
+      {
+        uint16_t x = 0;
+        *(byte_t*)&x = *buf;
+        sum += x;
+      }
+      return sum;
     }
+  }  // namespace
 
-    // only need to do it 2 times to be sure
-    // proof: 0xFFff + 0xFFff = 0x1FFfe -> 0xFFff
-    sum = (sum & 0xFFff) + (sum >> 16);
-    sum += sum >> 16;
+  uint16_t
+  ipchksum(const byte_t* buf, size_t sz, uint32_t sum)
+  {
+    uint64_t wide = WideSum(buf, sz) + sum;
+    // fold the carries back in, down to 32 bits and then to 16, until there are none left
+    wide = (wide & 0xFFffFFff) + (wide >> 32);
+    wide = (wide & 0xFFffFFff) + (wide >> 32);
+    wide = (wide & 0xFFff) + (wide >> 16);
+    wide = (wide & 0xFFff) + (wide >> 16);
+    wide = (wide & 0xFFff) + (wide >> 16);
 
-    return uint16_t((~sum) & 0xFFff);
+    return uint16_t((~wide) & 0xFFff);
   }
 
 #define ADD32CS(x) ((uint32_t)(x & 0xFFff) + (uint32_t)(x >> 16))
@@ -663,6 +761,7 @@ namespace llarp::net
       oxenc::write_host_as_big(uint16_t{0}, ptr);  // checksum
       ptr += 2;
       std::copy_n(udp_data.data(), udp_data.size(), ptr);
+      util::BufferPool::Release(udp_data);
 
       hdr->check = 0;
       hdr->check = net::ipchksum(pkt.data(), 20);
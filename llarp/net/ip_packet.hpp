@@ -4,6 +4,7 @@
 #include <llarp/ev/ev.hpp>
 #include "net.hpp"
 #include <llarp/util/buffer.hpp>
+#include <llarp/util/buffer_pool.hpp>
 #include <llarp/util/time.hpp>
 #include <memory>
 #include <llarp/service/protocol_type.hpp>
@@ -113,6 +114,10 @@ namespace llarp::net
   ParseIPProtocol(std::string data);
 
   /// an Packet
+  ///
+  /// its buffer comes from and goes back to util::BufferPool, so a packet moved from the
+  /// interface or a link message through to where it is written does no heap allocation of its
+  /// own; moving one hands the buffer over, and copying one takes another from the pool.
   struct IPPacket
   {
     static constexpr size_t _max_size = 1500;
@@ -129,7 +134,16 @@ namespace llarp::net
     /// create an ip packet from a vector we then own
     IPPacket(std::vector<byte_t>&&);
 
-    ~IPPacket() = default;
+    IPPacket(const IPPacket& other);
+    IPPacket(IPPacket&& other) noexcept;
+
+    IPPacket&
+    operator=(const IPPacket& other);
+    IPPacket&
+    operator=(IPPacket&& other) noexcept;
+
+    /// gives our buffer back to the pool
+    ~IPPacket();
 
     static constexpr size_t MaxSize = _max_size;
     static constexpr size_t MinSize = 20;
@@ -158,7 +172,7 @@ namespace llarp::net
       if (auto* vec = std::get_if<std::vector<byte_t>>(&udp_body))
         return make_udp(src.getIP(), src.port(), dst.getIP(), dst.port(), std::move(*vec));
       else if (auto* buf = std::get_if<OwnedBuffer>(&udp_body))
-        return make_udp(src, dst, buf->copy());
+        return make_udp(src, dst, util::BufferPool::Acquire(buf->buf.get(), buf->sz));
       else
         return net::IPPacket{size_t{}};
     }
@@ -166,7 +180,8 @@ namespace llarp::net
     [[deprecated("deprecated because of llarp_buffer_t")]] inline bool
     Load(const llarp_buffer_t& buf)
     {
-      _buf = buf.copy();
+      util::BufferPool::Release(_buf);
+      _buf = util::BufferPool::Acquire(buf.base, buf.sz);
       if (size() >= MinSize)
         return true;
       _buf.resize(0);
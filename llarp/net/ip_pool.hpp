@@ -0,0 +1,289 @@
+#pragma once
+
+#include "net_int.hpp"
+#include <llarp/util/time.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp::net
+{
+  /// the addresses of a range we hand out to keys, and which key has which.
+  ///
+  /// addresses are offsets from the bottom of the range, with one slot each for as far up the
+  /// range as we have gone, a bitmap of the ones in use, and the ones in use that aren't pinned
+  /// linked in order of when they were last marked active, so that allocating, finding who to
+  /// take an address back from once the range is full, and marking one active are all O(1). we
+  /// hand out addresses from the bottom up, so a big range costs only as much as we have used of
+  /// it.
+  template <typename Key_t>
+  class IPPool
+  {
+   public:
+    IPPool() = default;
+
+    /// an empty pool of the addresses from lowest up to highest, both included
+    IPPool(huint128_t lowest, huint128_t highest)
+        : m_Lowest{lowest}, m_Capacity{Span(lowest, highest)}
+    {}
+
+    /// the highest address we hand out
+    huint128_t
+    Highest() const
+    {
+      return m_Lowest + ToHost(m_Capacity - 1);
+    }
+
+    /// the address we will hand out next if none is freed up before then
+    huint128_t
+    Next() const
+    {
+      return m_Lowest + ToHost(m_Next);
+    }
+
+    /// how many addresses are in use
+    size_t
+    Size() const
+    {
+      return m_ByKey.size();
+    }
+
+    bool
+    Contains(huint128_t ip) const
+    {
+      return not(ip < m_Lowest) and (ip - m_Lowest).h < uint128_t{m_Capacity};
+    }
+
+    bool
+    InUse(huint128_t ip) const
+    {
+      return Contains(ip) and Used(Offset(ip));
+    }
+
+    /// the key using ip, if any
+    const Key_t*
+    KeyFor(huint128_t ip) const
+    {
+      if (not InUse(ip))
+        return nullptr;
+      return &m_Slots[Offset(ip)].key;
+    }
+
+    /// the address key is using, if any
+    std::optional<huint128_t>
+    IPFor(const Key_t& key) const
+    {
+      const auto itr = m_ByKey.find(key);
+      if (itr == m_ByKey.end())
+        return std::nullopt;
+      return m_Lowest + ToHost(itr->second);
+    }
+
+    bool
+    HasKey(const Key_t& key) const
+    {
+      return m_ByKey.count(key) > 0;
+    }
+
+    /// give key a free address, or nothing once the range is all in use
+    std::optional<huint128_t>
+    Allocate(const Key_t& key, llarp_time_t now)
+    {
+      if (HasKey(key))
+        return std::nullopt;
+      while (not m_Free.empty())
+      {
+        const auto offset = m_Free.back();
+        m_Free.pop_back();
+        // assigned again since it was freed
+        if (Used(offset))
+          continue;
+        Take(offset, key, now);
+        return m_Lowest + ToHost(offset);
+      }
+      while (m_Next < m_Capacity and Used(m_Next))
+        ++m_Next;
+      if (m_Next == m_Capacity)
+        return std::nullopt;
+      Take(m_Next, key, now);
+      return m_Lowest + ToHost(m_Next++);
+    }
+
+    /// give key the address ip in particular; false if ip is not ours or is in use, or key has
+    /// an address already
+    bool
+    Assign(huint128_t ip, const Key_t& key, llarp_time_t now)
+    {
+      if (not Contains(ip) or Used(Offset(ip)) or HasKey(key))
+        return false;
+      Take(Offset(ip), key, now);
+      return true;
+    }
+
+    /// take ip back from whoever has it
+    void
+    Release(huint128_t ip)
+    {
+      if (not InUse(ip))
+        return;
+      const auto offset = Offset(ip);
+      auto& slot = m_Slots[offset];
+      Unlink(offset);
+      m_ByKey.erase(slot.key);
+      slot = Slot{};
+      m_Used[offset / 64] &= ~(uint64_t{1} << (offset % 64));
+      m_Free.push_back(offset);
+    }
+
+    /// note that ip was used just now, making it the last one we take back
+    void
+    MarkActive(huint128_t ip, llarp_time_t now)
+    {
+      if (not InUse(ip))
+        return;
+      const auto offset = Offset(ip);
+      auto& slot = m_Slots[offset];
+      if (slot.pinned)
+        return;
+      slot.lastActive = std::max(slot.lastActive, now);
+      Unlink(offset);
+      Link(offset);
+    }
+
+    /// never take ip back from whoever has it
+    void
+    Pin(huint128_t ip)
+    {
+      if (not InUse(ip))
+        return;
+      const auto offset = Offset(ip);
+      Unlink(offset);
+      m_Slots[offset].pinned = true;
+      m_Slots[offset].lastActive = std::numeric_limits<llarp_time_t>::max();
+    }
+
+    /// the address in use that was marked active longest ago, leaving out pinned ones
+    std::optional<huint128_t>
+    LeastRecentlyActive() const
+    {
+      if (m_Oldest == None)
+        return std::nullopt;
+      return m_Lowest + ToHost(m_Oldest);
+    }
+
+    /// call visit(ip, key, lastActive) for each address in use
+    template <typename Visit_t>
+    void
+    ForEach(Visit_t&& visit) const
+    {
+      for (uint32_t offset = 0; offset < m_Slots.size(); ++offset)
+      {
+        if (Used(offset))
+          visit(m_Lowest + ToHost(offset), m_Slots[offset].key, m_Slots[offset].lastActive);
+      }
+    }
+
+   private:
+    static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+    struct Slot
+    {
+      Key_t key{};
+      llarp_time_t lastActive = 0s;
+      /// neighbours in order of activity, older and newer
+      uint32_t older = None;
+      uint32_t newer = None;
+      bool pinned = false;
+    };
+
+    /// how many addresses from lowest to highest, as far as we count
+    static uint32_t
+    Span(huint128_t lowest, huint128_t highest)
+    {
+      const auto span = (highest - lowest).h + uint128_t{1};
+      constexpr uint128_t most{std::numeric_limits<uint32_t>::max()};
+      return static_cast<uint32_t>(std::min(span, most));
+    }
+
+    static huint128_t
+    ToHost(uint32_t offset)
+    {
+      return huint128_t{uint128_t{offset}};
+    }
+
+    uint32_t
+    Offset(huint128_t ip) const
+    {
+      return static_cast<uint32_t>((ip - m_Lowest).h);
+    }
+
+    bool
+    Used(uint32_t offset) const
+    {
+      return offset < m_Slots.size() and (m_Used[offset / 64] >> (offset % 64)) & 1;
+    }
+
+    void
+    Take(uint32_t offset, const Key_t& key, llarp_time_t now)
+    {
+      if (offset >= m_Slots.size())
+      {
+        m_Slots.resize(offset + 1);
+        m_Used.resize(offset / 64 + 1);
+      }
+      m_Used[offset / 64] |= uint64_t{1} << (offset % 64);
+      m_Slots[offset].key = key;
+      m_Slots[offset].lastActive = now;
+      m_ByKey.emplace(key, offset);
+      Link(offset);
+    }
+
+    /// put offset at the newest end of the activity order
+    void
+    Link(uint32_t offset)
+    {
+      auto& slot = m_Slots[offset];
+      slot.older = m_Newest;
+      slot.newer = None;
+      if (m_Newest != None)
+        m_Slots[m_Newest].newer = offset;
+      else
+        m_Oldest = offset;
+      m_Newest = offset;
+    }
+
+    void
+    Unlink(uint32_t offset)
+    {
+      auto& slot = m_Slots[offset];
+      if (slot.pinned)
+        return;
+      if (slot.older != None)
+        m_Slots[slot.older].newer = slot.newer;
+      else
+        m_Oldest = slot.newer;
+      if (slot.newer != None)
+        m_Slots[slot.newer].older = slot.older;
+      else
+        m_Newest = slot.older;
+      slot.older = slot.newer = None;
+    }
+
+    huint128_t m_Lowest{};
+    uint32_t m_Capacity = 0;
+    /// next offset we have not gone past yet
+    uint32_t m_Next = 0;
+    std::vector<Slot> m_Slots;
+    /// bit per slot, set for the ones in use
+    std::vector<uint64_t> m_Used;
+    /// offsets below m_Next that were released, to hand out again before going further up
+    std::vector<uint32_t> m_Free;
+    std::unordered_map<Key_t, uint32_t> m_ByKey;
+    uint32_t m_Oldest = None;
+    uint32_t m_Newest = None;
+  };
+}  // namespace llarp::net
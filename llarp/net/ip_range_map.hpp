@@ -2,6 +2,9 @@
 
 #include "ip_range.hpp"
 #include <llarp/util/status.hpp>
+
+#include <algorithm>
+#include <cstdint>
 #include <set>
 #include <vector>
 
@@ -12,7 +15,9 @@ namespace llarp
     /// a container that maps an ip range to a value that allows you to lookup
     /// key by range hit
     ///
-    /// in the future we should do some kind of magic shit to ensure near constant time for lookups
+    /// the entries are kept in the order they went in, and indexed by a path compressed binary
+    /// trie over the bits of their prefixes, so that finding the ranges an address is in costs
+    /// as much as the longest prefix on its way down and not a look at every range.
     template <typename Value_t>
     struct IPRangeMap
     {
@@ -82,10 +87,20 @@ namespace llarp
       std::optional<Value_t>
       GetExact(Range_t range) const
       {
-        for (const auto& [r, value] : m_Entries)
+        const auto len = PrefixLength(range);
+        const auto prefix = range.addr.h & Mask(len);
+        uint32_t node = Root;
+        while (m_Nodes[node].len < len)
+        {
+          node = m_Nodes[node].child[Bit(prefix, m_Nodes[node].len)];
+          if (node == Root or m_Nodes[node].len > len
+              or (prefix & Mask(m_Nodes[node].len)) != m_Nodes[node].prefix)
+            return std::nullopt;
+        }
+        for (const auto idx : m_Nodes[node].entries)
         {
-          if (r == range)
-            return value;
+          if (m_Entries[idx].first == range)
+            return m_Entries[idx].second;
         }
         return std::nullopt;
       }
@@ -95,14 +110,25 @@ namespace llarp
       FindAllEntries(const IP_t& addr) const
       {
         std::set<Entry_t> found;
-        for (const auto& entry : m_Entries)
-        {
-          if (entry.first.Contains(addr))
-            found.insert(entry);
-        }
+        ForEachMatch(addr, [&found](const auto& entry) { found.insert(entry); });
         return found;
       }
 
+      /// the entry with the longest prefix of all those whose range contains addr, the one put in
+      /// first of those if there are a few
+      std::optional<Entry_t>
+      FindLongestMatch(const IP_t& addr) const
+      {
+        const Entry_t* best = nullptr;
+        ForEachMatch(addr, [&best](const auto& entry) {
+          if (best == nullptr or PrefixLength(entry.first) > PrefixLength(best->first))
+            best = &entry;
+        });
+        if (best == nullptr)
+          return std::nullopt;
+        return *best;
+      }
+
       struct CompareEntry
       {
         bool
@@ -116,6 +142,7 @@ namespace llarp
       Insert(const Range_t& addr, const Value_t& val)
       {
         m_Entries.emplace_back(addr, val);
+        Index(m_Entries.size() - 1);
       }
 
       template <typename Visit_t>
@@ -130,6 +157,11 @@ namespace llarp
           else
             ++itr;
         }
+        // the indexes of what is left have moved, and ranges go away rarely enough to start over
+        m_Nodes.resize(1);
+        m_Nodes[Root] = Node{};
+        for (uint32_t idx = 0; idx < m_Entries.size(); ++idx)
+          Index(idx);
       }
 
       util::StatusObject
@@ -144,7 +176,111 @@ namespace llarp
       }
 
      private:
+      /// the root has the empty prefix, and as nothing points back at it, it stands for no child
+      static constexpr uint32_t Root = 0;
+
+      struct Node
+      {
+        /// the prefix bits, and nothing below them
+        uint128_t prefix{0};
+        /// how many of the top bits are the prefix
+        uint32_t len = 0;
+        /// the nodes below, by the bit after the prefix
+        uint32_t child[2] = {Root, Root};
+        /// the entries whose range is this prefix
+        std::vector<uint32_t> entries;
+      };
+
+      static constexpr uint128_t
+      Mask(uint32_t len)
+      {
+        return len == 0 ? uint128_t{0} : ~uint128_t{0} << (128 - len);
+      }
+
+      /// bit i of n, counting from the top
+      static constexpr uint32_t
+      Bit(const uint128_t& n, uint32_t i)
+      {
+        return i < 64 ? (n.upper >> (63 - i)) & 1 : (n.lower >> (127 - i)) & 1;
+      }
+
+      static uint32_t
+      PrefixLength(const Range_t& range)
+      {
+        return bits::count_bits_128(range.netmask_bits.h);
+      }
+
+      /// call visit with each entry whose range contains addr, from the shortest prefix down
+      template <typename Visit_t>
+      void
+      ForEachMatch(const IP_t& addr, Visit_t&& visit) const
+      {
+        uint32_t node = Root;
+        while (true)
+        {
+          for (const auto idx : m_Nodes[node].entries)
+          {
+            // a netmask that is not one run of bits from the top is not a prefix we can index
+            if (m_Entries[idx].first.Contains(addr))
+              visit(m_Entries[idx]);
+          }
+          const auto& at = m_Nodes[node];
+          if (at.len == 128)
+            return;
+          node = at.child[Bit(addr.h, at.len)];
+          if (node == Root or (addr.h & Mask(m_Nodes[node].len)) != m_Nodes[node].prefix)
+            return;
+        }
+      }
+
+      /// put the entry at idx into the trie
+      void
+      Index(uint32_t idx)
+      {
+        const auto len = PrefixLength(m_Entries[idx].first);
+        const auto prefix = m_Entries[idx].first.addr.h & Mask(len);
+        uint32_t node = Root;
+        while (m_Nodes[node].len < len)
+        {
+          const auto bit = Bit(prefix, m_Nodes[node].len);
+          const uint32_t next = m_Nodes[node].child[bit];
+          if (next == Root)
+          {
+            const uint32_t leaf = NewNode(prefix, len);
+            m_Nodes[node].child[bit] = leaf;
+            node = leaf;
+            break;
+          }
+          // how far down the next node and this prefix agree
+          uint32_t common = m_Nodes[node].len + 1;
+          const auto upto = std::min(m_Nodes[next].len, len);
+          while (common < upto and Bit(prefix, common) == Bit(m_Nodes[next].prefix, common))
+            ++common;
+          if (common == m_Nodes[next].len)
+          {
+            node = next;
+            continue;
+          }
+          // they part ways above the next node, so a node where they do goes in between
+          const uint32_t split = NewNode(prefix & Mask(common), common);
+          m_Nodes[split].child[Bit(m_Nodes[next].prefix, common)] = next;
+          m_Nodes[node].child[bit] = split;
+          node = split;
+        }
+        m_Nodes[node].entries.push_back(idx);
+      }
+
+      uint32_t
+      NewNode(const uint128_t& prefix, uint32_t len)
+      {
+        m_Nodes.emplace_back();
+        m_Nodes.back().prefix = prefix;
+        m_Nodes.back().len = len;
+        return m_Nodes.size() - 1;
+      }
+
       Container_t m_Entries;
+      std::vector<Node> m_Nodes = std::vector<Node>(1);
     };
   }  // namespace net
 }  // namespace llarp
@@ -0,0 +1,117 @@
+#include "traffic_class.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace llarp::net
+{
+  TrafficClass
+  ParseTrafficClass(std::string_view name)
+  {
+    if (name == "realtime")
+      return TrafficClass::Realtime;
+    if (name == "interactive")
+      return TrafficClass::Interactive;
+    if (name == "bulk")
+      return TrafficClass::Bulk;
+    throw std::invalid_argument{"invalid traffic class: " + std::string{name}};
+  }
+
+  std::string_view
+  ToString(TrafficClass c)
+  {
+    switch (c)
+    {
+      case TrafficClass::Realtime:
+        return "realtime";
+      case TrafficClass::Interactive:
+        return "interactive";
+      case TrafficClass::Bulk:
+        return "bulk";
+    }
+    return "unknown";
+  }
+
+  TrafficClass
+  ClassForDSCP(uint8_t dscp)
+  {
+    switch (dscp)
+    {
+      // le, cs1, af11 to af13
+      case 1:
+      case 8:
+      case 10:
+      case 12:
+      case 14:
+        return TrafficClass::Bulk;
+      // cs4, af41 to af43, cs5, voice admit, ef, cs6, cs7
+      case 32:
+      case 34:
+      case 36:
+      case 38:
+      case 40:
+      case 44:
+      case 46:
+      case 48:
+      case 56:
+        return TrafficClass::Realtime;
+      default:
+        return TrafficClass::Interactive;
+    }
+  }
+
+  void
+  TrafficClassifier::AddRule(std::string_view spec)
+  {
+    const auto pos = spec.rfind(':');
+    if (pos == std::string_view::npos)
+      throw std::invalid_argument{"traffic class rule has no class: " + std::string{spec}};
+    const auto klass = ParseTrafficClass(spec.substr(pos + 1));
+    m_Rules.emplace_back(ProtocolInfo{spec.substr(0, pos)}, klass);
+  }
+
+  TrafficClass
+  TrafficClassifier::Classify(const IPPacket& pkt) const
+  {
+    const byte_t* buf = pkt.data();
+    const size_t sz = pkt.size();
+    uint8_t proto, dscp;
+    size_t l4;
+    if (sz >= 20 and pkt.IsV4())
+    {
+      proto = buf[9];
+      dscp = buf[1] >> 2;
+      l4 = (buf[0] & 0x0f) * 4;
+    }
+    else if (sz >= 40 and pkt.IsV6())
+    {
+      proto = buf[6];
+      dscp = ((buf[0] & 0x0f) << 2) | (buf[1] >> 6);
+      l4 = 40;
+    }
+    else
+      return TrafficClass::Interactive;
+
+    std::optional<nuint16_t> src, dst;
+    if ((proto == static_cast<uint8_t>(IPProtocol::TCP)
+         or proto == static_cast<uint8_t>(IPProtocol::UDP))
+        and l4 + 4 <= sz)
+    {
+      src.emplace();
+      dst.emplace();
+      std::memcpy(&src->n, buf + l4, sizeof(uint16_t));
+      std::memcpy(&dst->n, buf + l4 + 2, sizeof(uint16_t));
+    }
+
+    for (const auto& [info, klass] : m_Rules)
+    {
+      if (static_cast<uint8_t>(info.protocol) != proto)
+        continue;
+      // the port is ours going out and theirs coming back
+      if (not info.port or not src or *info.port == *src or *info.port == *dst)
+        return klass;
+    }
+    return ClassForDSCP(dscp);
+  }
+}  // namespace llarp::net
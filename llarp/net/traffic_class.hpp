@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ip_packet.hpp"
+#include "traffic_policy.hpp"
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace llarp::net
+{
+  /// how urgently traffic wants to get where it is going
+  enum class TrafficClass : uint8_t
+  {
+    /// voice, video and games: little of it, and late is as good as lost
+    Realtime,
+    /// everything not marked otherwise
+    Interactive,
+    /// transfers that only care how long the whole thing takes
+    Bulk,
+  };
+
+  constexpr size_t NumTrafficClasses = 3;
+
+  /// the priority link messages carrying traffic of class c go with; higher goes first
+  constexpr uint16_t
+  LinkPriority(TrafficClass c)
+  {
+    return NumTrafficClasses - 1 - static_cast<uint16_t>(c);
+  }
+
+  /// parse "realtime", "interactive" or "bulk", throwing std::invalid_argument on anything else
+  TrafficClass
+  ParseTrafficClass(std::string_view name);
+
+  std::string_view
+  ToString(TrafficClass c);
+
+  /// the class of traffic marked with dscp: expedited forwarding, voice admit, cs4 to cs7 and
+  /// the af4 classes are realtime; cs1, the af1 classes and lower effort are bulk; the rest is
+  /// interactive
+  TrafficClass
+  ClassForDSCP(uint8_t dscp);
+
+  /// puts packets in a class, by rules for protocols and ports first and by their dscp marking
+  /// when none match
+  class TrafficClassifier
+  {
+   public:
+    /// add a rule of the form "<protocol>[/<port>]:<class>", as in "udp/3478:realtime", which
+    /// matches packets going to or coming from the port; rules added first win.  throws
+    /// std::invalid_argument if spec is bad.
+    void
+    AddRule(std::string_view spec);
+
+    TrafficClass
+    Classify(const IPPacket& pkt) const;
+
+   private:
+    std::vector<std::pair<ProtocolInfo, TrafficClass>> m_Rules;
+  };
+}  // namespace llarp::net
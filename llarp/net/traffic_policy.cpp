@@ -1,6 +1,8 @@
 #include "traffic_policy.hpp"
 #include "llarp/util/str.hpp"
 
+#include <algorithm>
+
 namespace llarp::net
 {
   ProtocolInfo::ProtocolInfo(std::string_view data)
@@ -70,6 +72,54 @@ namespace llarp::net
     return false;
   }
 
+  CompiledTrafficPolicy::CompiledTrafficPolicy(const TrafficPolicy& policy)
+      : m_AllowAll{policy.protocols.empty() and policy.ranges.empty()}
+  {
+    for (const auto& proto : policy.protocols)
+    {
+      const auto num = static_cast<std::underlying_type_t<IPProtocol>>(proto.protocol);
+      if (proto.port)
+      {
+        m_SomePorts.set(num);
+        m_Ports.emplace_back(num, proto.port->n);
+      }
+      else
+        m_AnyPort.set(num);
+    }
+    std::sort(m_Ports.begin(), m_Ports.end());
+    for (const auto& range : policy.ranges)
+      m_Ranges.Insert(range, true);
+  }
+
+  bool
+  CompiledTrafficPolicy::AllowsTraffic(const IPPacket& pkt) const
+  {
+    if (m_AllowAll)
+      return true;
+
+    const auto num = pkt.Header()->protocol;
+    if (m_AnyPort[num])
+      return true;
+    if (m_SomePorts[num])
+    {
+      const auto port = pkt.DstPort();
+      // we can't tell what the port is but the protocol matches and that's good enough
+      if (not port
+          or std::binary_search(m_Ports.begin(), m_Ports.end(), std::make_pair(num, port->n)))
+        return true;
+    }
+    if (m_Ranges.Empty())
+      return false;
+    huint128_t dst;
+    if (pkt.IsV6())
+      dst = pkt.dstv6();
+    else if (pkt.IsV4())
+      dst = pkt.dst4to6();
+    else
+      return false;
+    return m_Ranges.FindLongestMatch(dst).has_value();
+  }
+
   bool
   ProtocolInfo::BDecode(llarp_buffer_t* buf)
   {
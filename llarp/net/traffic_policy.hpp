@@ -1,10 +1,14 @@
 #pragma once
 
 #include "ip_range.hpp"
+#include "ip_range_map.hpp"
 #include "ip_packet.hpp"
 #include "llarp/util/status.hpp"
 
+#include <bitset>
 #include <set>
+#include <utility>
+#include <vector>
 
 namespace llarp::net
 {
@@ -63,4 +67,29 @@ namespace llarp::net
     bool
     AllowsTraffic(const IPPacket& pkt) const;
   };
+
+  /// a traffic policy laid out to be checked against each packet: a bit per protocol allowed on
+  /// any port, a bit per protocol allowed on some, the ports those are allowed on sorted, and the
+  /// ranges in a prefix trie.  allows the same traffic as the policy it is made from.
+  class CompiledTrafficPolicy
+  {
+   public:
+    /// allows all traffic, as an empty policy does
+    CompiledTrafficPolicy() = default;
+
+    explicit CompiledTrafficPolicy(const TrafficPolicy& policy);
+
+    /// returns true if we allow the traffic in this ip packet
+    /// returns false otherwise
+    bool
+    AllowsTraffic(const IPPacket& pkt) const;
+
+   private:
+    bool m_AllowAll = true;
+    std::bitset<256> m_AnyPort;
+    std::bitset<256> m_SomePorts;
+    /// ip protocol and port in network order of each allowed port
+    std::vector<std::pair<uint8_t, uint16_t>> m_Ports;
+    IPRangeMap<bool> m_Ranges;
+  };
 }  // namespace llarp::net
@@ -9,6 +9,7 @@
 #include "util/time.hpp"
 #include "util/mem.hpp"
 #include "util/str.hpp"
+#include "dht/closest.hpp"
 #include "dht/kademlia.hpp"
 
 #include <algorithm>
@@ -22,11 +23,19 @@ namespace llarp
 {
   static auto logcat = log::Cat("nodedb");
 
-  NodeDB::Entry::Entry(RouterContact value) : rc(std::move(value)), insertedAt(llarp::time_now_ms())
+  NodeDB::Summary::Summary(const RouterContact& rc)
+      : pubkey{rc.pubkey}
+      , lastUpdated{rc.last_updated}
+      , insertedAt{llarp::time_now_ms()}
+      , publicRouter{rc.IsPublicRouter()}
+      , exit{rc.IsExit()}
+  {}
+
+  NodeDB::Entry::Entry(RouterContact value) : rc(std::move(value))
   {}
 
   static void
-  EnsureSkiplist(fs::path nodedbDir)
+  EnsureNodeDBDir(fs::path nodedbDir)
   {
     if (not fs::exists(nodedbDir))
     {
@@ -41,18 +50,55 @@ namespace llarp
 
     if (not fs::is_directory(nodedbDir))
       throw std::runtime_error{fmt::format("nodedb {} is not a directory", nodedbDir)};
+  }
 
+  /// everything readable in the old one-file-per-rc format, for migrating to the store
+  static std::vector<RouterContact>
+  LoadSkiplist(const fs::path& root)
+  {
+    std::vector<RouterContact> loaded;
     for (const char& ch : skiplist_subdirs)
     {
-      // this seems to be a problem on all targets
-      // perhaps cpp17::fs is just as screwed-up
-      // attempting to create a folder with no name
-      // what does this mean...?
       if (!ch)
         continue;
+      fs::path sub = root / std::string(&ch, 1);
+      if (not fs::is_directory(sub))
+        continue;
+
+      llarp::util::IterDir(sub, [&](const fs::path& f) -> bool {
+        // skip files that are not suffixed with .signed
+        if (not(fs::is_regular_file(f) and f.extension() == RC_FILE_EXT))
+          return true;
 
-      fs::path sub = nodedbDir / std::string(&ch, 1);
-      fs::create_directory(sub);
+        RouterContact rc{};
+        // the old format goes away wholesale once migrated, so junk in it needs no purging
+        if (rc.Read(f))
+          loaded.push_back(std::move(rc));
+        return true;
+      });
+    }
+    return loaded;
+  }
+
+  /// remove what is left of the old one-file-per-rc format
+  static void
+  RemoveSkiplist(const fs::path& root)
+  {
+    for (const char& ch : skiplist_subdirs)
+    {
+      if (!ch)
+        continue;
+      fs::path sub = root / std::string(&ch, 1);
+      if (not fs::is_directory(sub))
+        continue;
+      llarp::util::IterDir(sub, [](const fs::path& f) -> bool {
+        if (fs::is_regular_file(f) and f.extension() == RC_FILE_EXT)
+          fs::remove(f);
+        return true;
+      });
+      std::error_code ec;
+      // only goes if empty, so that we never take anything we did not put there
+      fs::remove(sub, ec);
     }
   }
 
@@ -63,7 +109,8 @@ namespace llarp
       , disk(std::move(diskCaller))
       , m_NextFlushAt{time_now_ms() + FlushInterval}
   {
-    EnsureSkiplist(m_Root);
+    EnsureNodeDBDir(m_Root);
+    m_Store.emplace(m_Root / NodeDBStore::Filename);
   }
   NodeDB::NodeDB() : m_Root{}, disk{[](auto) {}}, m_NextFlushAt{0s}
   {}
@@ -77,106 +124,189 @@ namespace llarp
     if (now > m_NextFlushAt)
     {
       m_NextFlushAt += FlushInterval;
-      // make copy of all rcs
-      std::vector<RouterContact> copy;
-      for (const auto& item : m_Entries)
-        copy.push_back(item.second.rc);
-      // flush them to disk in one big job
-      // TODO: split this up? idk maybe some day...
-      disk([this, data = std::move(copy)]() {
-        for (const auto& rc : data)
-        {
-          rc.Write(GetPathForPubkey(rc.pubkey));
-        }
-      });
+      if (m_WantCompact.exchange(false))
+      {
+        // the store is mostly dead records, rewrite it with everything we have
+        TakeDirty();
+        m_Removed.clear();
+        disk([this, data = CopyAll()]() {
+          util::Lock lock{m_StoreAccess};
+          m_Store->Compact(data);
+        });
+      }
+      else if (auto data = TakeDirty(); not(data.empty() and m_Removed.empty()))
+      {
+        // append what changed since last time, removals first so that a router removed and put
+        // back ends up put
+        disk([this, data = std::move(data), removed = std::exchange(m_Removed, {})]() {
+          util::Lock lock{m_StoreAccess};
+          m_Store->AppendRemovals(removed);
+          m_Store->Append(data);
+          m_WantCompact = m_Store->ShouldCompact();
+        });
+      }
     }
   }
 
-  fs::path
-  NodeDB::GetPathForPubkey(RouterID pubkey) const
+  void
+  NodeDB::LoadFromDisk(bool verify)
   {
-    std::string hexString = oxenc::to_hex(pubkey.begin(), pubkey.end());
-    std::string skiplistDir;
-
-    const llarp::RouterID r{pubkey};
-    std::string fname = r.ToString();
-
-    skiplistDir += hexString[0];
-    fname += RC_FILE_EXT;
-    return m_Root / skiplistDir / fname;
+    auto loaded = ReadFromDisk();
+    if (not verify)
+    {
+      AddPending(std::move(loaded));
+      return;
+    }
+    // validate signatures all at once and purge entries with invalid signatures, load ones with
+    // valid signatures
+    const auto valid = RouterContact::VerifySignatures(loaded);
+    std::unordered_set<RouterID> purge;
+    for (size_t idx = 0; idx < loaded.size(); ++idx)
+    {
+      if (valid[idx])
+        Insert(std::move(loaded[idx])).dirty = false;
+      else
+        purge.insert(RouterID{loaded[idx].pubkey});
+    }
+    if (not purge.empty())
+    {
+      log::warning(logcat, "removing {} RCs with invalid signatures from disk", purge.size());
+      util::Lock lock{m_StoreAccess};
+      m_Store->AppendRemovals(purge);
+    }
   }
 
-  void
-  NodeDB::LoadFromDisk()
+  std::vector<RouterContact>
+  NodeDB::ReadFromDisk()
   {
     if (m_Root.empty())
-      return;
-    std::set<fs::path> purge;
+      return {};
+    util::Lock lock{m_StoreAccess};
+    std::unordered_set<RouterID> purge;
+    // rcs to load once their signatures check out
+    std::vector<RouterContact> loaded;
+
+    const auto now = time_now_ms();
+    const bool fromStore = m_Store->Load([&](const RouterID& id, llarp_buffer_t buf) {
+      RouterContact rc{};
+      // try loading it, purge it if it is junk
+      if (not rc.BDecode(&buf) or RouterID{rc.pubkey} != id)
+        purge.insert(id);
+      // skip entries that are not from our network
+      else if (not rc.FromOurNetwork())
+        return;
+      // rc expired dont load it and purge it
+      else if (rc.IsExpired(now))
+        purge.insert(id);
+      else
+        loaded.push_back(std::move(rc));
+    });
 
-    for (const char& ch : skiplist_subdirs)
+    const bool migrate = not fromStore;
+    if (migrate)
     {
-      if (!ch)
-        continue;
-      std::string p;
-      p += ch;
-      fs::path sub = m_Root / p;
-
-      llarp::util::IterDir(sub, [&](const fs::path& f) -> bool {
-        // skip files that are not suffixed with .signed
-        if (not(fs::is_regular_file(f) and f.extension() == RC_FILE_EXT))
-          return true;
-
-        RouterContact rc{};
-
-        if (not rc.Read(f))
-        {
-          // try loading it, purge it if it is junk
-          purge.emplace(f);
-          return true;
-        }
-
-        if (not rc.FromOurNetwork())
-        {
-          // skip entries that are not from our network
-          return true;
-        }
-
-        if (rc.IsExpired(time_now_ms()))
-        {
-          // rc expired dont load it and purge it later
-          purge.emplace(f);
-          return true;
-        }
-
-        // validate signature and purge entries with invalid signatures
-        // load ones with valid signatures
-        if (rc.VerifySignature())
-          m_Entries.emplace(rc.pubkey, rc);
-        else
-          purge.emplace(f);
-
-        return true;
-      });
+      for (auto& rc : LoadSkiplist(m_Root))
+      {
+        if (rc.FromOurNetwork() and not rc.IsExpired(now))
+          loaded.push_back(std::move(rc));
+      }
     }
 
     if (not purge.empty())
     {
       log::warning(logcat, "removing {} invalid RCs from disk", purge.size());
+      m_Store->AppendRemovals(purge);
+    }
 
-      for (const auto& fpath : purge)
-        fs::remove(fpath);
+    if (migrate and not loaded.empty())
+    {
+      log::info(
+          logcat,
+          "moving {} RCs from the old nodedb layout into {}",
+          loaded.size(),
+          NodeDBStore::Filename);
+      m_Store->Compact(loaded);
+    }
+    // once the store has them, whatever is left of the old layout is just clutter
+    if (fs::exists(m_Root / NodeDBStore::Filename))
+      RemoveSkiplist(m_Root);
+    return loaded;
+  }
+
+  size_t
+  NodeDB::AddPending(std::vector<RouterContact> rcs)
+  {
+    util::NullLock lock{m_Access};
+    size_t added = 0;
+    m_Sorted.reserve(m_Sorted.size() + rcs.size());
+    for (auto& rc : rcs)
+    {
+      const RouterID pk{rc.pubkey};
+      if (m_Entries.count(pk))
+        continue;
+      auto& entry = m_Entries.emplace(pk, std::move(rc)).first->second;
+      // it came off disk, so there is nothing to write out
+      entry.dirty = false;
+      AddDense(entry).pending = true;
+      m_Sorted.push_back(pk);
+      ++added;
     }
+    // sorted once for the lot, where an Insert each would shift the vector along for every one
+    std::sort(m_Sorted.begin(), m_Sorted.end());
+    return added;
   }
 
   void
-  NodeDB::SaveToDisk() const
+  NodeDB::SaveToDisk()
   {
     if (m_Root.empty())
       return;
 
-    for (const auto& item : m_Entries)
+    util::Lock lock{m_StoreAccess};
+    m_Store->AppendRemovals(std::exchange(m_Removed, {}));
+    m_Store->Append(TakeDirty());
+  }
+
+  std::vector<RouterContact>
+  NodeDB::PendingRCs() const
+  {
+    util::NullLock lock{m_Access};
+    std::vector<RouterContact> pending;
+    for (const auto& hot : m_Dense)
     {
-      item.second.rc.Write(GetPathForPubkey(item.first));
+      if (hot.summary.pending)
+        pending.push_back(hot.entry->rc);
+    }
+    return pending;
+  }
+
+  void
+  NodeDB::VerifiedPending(const std::vector<RouterContact>& rcs, const std::vector<bool>& valid)
+  {
+    util::NullLock lock{m_Access};
+    std::unordered_set<RouterID> removed;
+    for (size_t idx = 0; idx < rcs.size(); ++idx)
+    {
+      const RouterID pk{rcs[idx].pubkey};
+      auto itr = m_Entries.find(pk);
+      // replaced since, by an rc that was checked on its way in
+      if (itr == m_Entries.end())
+        continue;
+      auto& summary = m_Dense[itr->second.denseIndex].summary;
+      if (not summary.pending or not(itr->second.rc == rcs[idx]))
+        continue;
+      if (valid[idx])
+        summary.pending = false;
+      else
+      {
+        Erase(itr);
+        removed.insert(pk);
+      }
+    }
+    if (not removed.empty())
+    {
+      log::warning(logcat, "removing {} RCs with invalid signatures", removed.size());
+      AsyncRemoveManyFromDisk(std::move(removed));
     }
   }
 
@@ -184,7 +314,8 @@ namespace llarp
   NodeDB::Has(RouterID pk) const
   {
     util::NullLock lock{m_Access};
-    return m_Entries.find(pk) != m_Entries.end();
+    const auto itr = m_Entries.find(pk);
+    return itr != m_Entries.end() and not IsPending(itr->second);
   }
 
   std::optional<RouterContact>
@@ -192,7 +323,7 @@ namespace llarp
   {
     util::NullLock lock{m_Access};
     const auto itr = m_Entries.find(pk);
-    if (itr == m_Entries.end())
+    if (itr == m_Entries.end() or IsPending(itr->second))
       return std::nullopt;
     return itr->second.rc;
   }
@@ -201,7 +332,8 @@ namespace llarp
   NodeDB::Remove(RouterID pk)
   {
     util::NullLock lock{m_Access};
-    m_Entries.erase(pk);
+    if (auto itr = m_Entries.find(pk); itr != m_Entries.end())
+      Erase(itr);
     AsyncRemoveManyFromDisk({pk});
   }
 
@@ -210,17 +342,14 @@ namespace llarp
   {
     util::NullLock lock{m_Access};
     std::unordered_set<RouterID> removed;
-    auto itr = m_Entries.begin();
-    while (itr != m_Entries.end())
+    for (const auto& hot : m_Dense)
     {
-      if (itr->second.insertedAt < cutoff and keep.count(itr->second.rc.pubkey) == 0)
-      {
-        removed.insert(itr->second.rc.pubkey);
-        itr = m_Entries.erase(itr);
-      }
-      else
-        ++itr;
+      if (hot.summary.insertedAt < cutoff and keep.count(hot.summary.pubkey) == 0)
+        removed.insert(hot.summary.pubkey);
     }
+    // only now, as erasing moves m_Dense about
+    for (const auto& pk : removed)
+      Erase(m_Entries.find(pk));
     if (not removed.empty())
       AsyncRemoveManyFromDisk(std::move(removed));
   }
@@ -229,8 +358,7 @@ namespace llarp
   NodeDB::Put(RouterContact rc)
   {
     util::NullLock lock{m_Access};
-    m_Entries.erase(rc.pubkey);
-    m_Entries.emplace(rc.pubkey, rc);
+    Insert(std::move(rc));
   }
 
   size_t
@@ -246,31 +374,78 @@ namespace llarp
     util::NullLock lock{m_Access};
     auto itr = m_Entries.find(rc.pubkey);
     if (itr == m_Entries.end() or itr->second.rc.OtherIsNewer(rc))
+      Insert(std::move(rc));
+  }
+
+  NodeDB::Entry&
+  NodeDB::Insert(RouterContact rc)
+  {
+    const RouterID pk{rc.pubkey};
+    // putting back the rc we already have leaves it as clean as it was
+    bool dirty = true;
+    if (auto itr = m_Entries.find(pk); itr != m_Entries.end())
     {
-      // delete if existing
-      if (itr != m_Entries.end())
-        m_Entries.erase(itr);
-      // add new entry
-      m_Entries.emplace(rc.pubkey, rc);
+      dirty = itr->second.dirty or not(itr->second.rc == rc);
+      Erase(itr);
     }
+    m_Sorted.insert(std::lower_bound(m_Sorted.begin(), m_Sorted.end(), pk), pk);
+    auto& entry = m_Entries.emplace(pk, std::move(rc)).first->second;
+    entry.dirty = dirty;
+    AddDense(entry);
+    return entry;
+  }
+
+  NodeDB::Summary&
+  NodeDB::AddDense(Entry& entry)
+  {
+    entry.denseIndex = m_Dense.size();
+    m_Dense.push_back({Summary{entry.rc}, &entry});
+    return m_Dense.back().summary;
+  }
+
+  NodeDB::NodeMap::iterator
+  NodeDB::Erase(NodeMap::iterator itr)
+  {
+    if (m_OnChange)
+      m_OnChange(itr->first);
+    const auto idx = itr->second.denseIndex;
+    m_Dense[idx] = m_Dense.back();
+    m_Dense[idx].entry->denseIndex = idx;
+    m_Dense.pop_back();
+    m_Sorted.erase(std::lower_bound(m_Sorted.begin(), m_Sorted.end(), itr->first));
+    return m_Entries.erase(itr);
   }
 
   void
-  NodeDB::AsyncRemoveManyFromDisk(std::unordered_set<RouterID> remove) const
+  NodeDB::AsyncRemoveManyFromDisk(std::unordered_set<RouterID> remove)
   {
     if (m_Root.empty())
       return;
-    // build file list
-    std::set<fs::path> files;
-    for (auto id : remove)
+    m_Removed.merge(remove);
+  }
+
+  std::vector<RouterContact>
+  NodeDB::TakeDirty()
+  {
+    std::vector<RouterContact> dirty;
+    for (auto& item : m_Entries)
     {
-      files.emplace(GetPathForPubkey(std::move(id)));
+      if (not item.second.dirty)
+        continue;
+      dirty.push_back(item.second.rc);
+      item.second.dirty = false;
     }
-    // remove them from the disk via the diskio thread
-    disk([files]() {
-      for (auto fpath : files)
-        fs::remove(fpath);
-    });
+    return dirty;
+  }
+
+  std::vector<RouterContact>
+  NodeDB::CopyAll() const
+  {
+    std::vector<RouterContact> copy;
+    copy.reserve(m_Entries.size());
+    for (const auto& item : m_Entries)
+      copy.push_back(item.second.rc);
+    return copy;
   }
 
   llarp::RouterContact
@@ -278,46 +453,45 @@ namespace llarp
   {
     util::NullLock lock{m_Access};
     llarp::RouterContact rc;
-    const llarp::dht::XorMetric compare(location);
-    VisitAll([&rc, compare](const auto& otherRC) {
-      if (rc.pubkey.IsZero())
-      {
-        rc = otherRC;
-        return;
-      }
-      if (compare(
-              llarp::dht::Key_t{otherRC.pubkey.as_array()},
-              llarp::dht::Key_t{rc.pubkey.as_array()}))
-        rc = otherRC;
-    });
+    size_t n = 1;
+    dht::VisitClosest(
+        RouterID{location.as_array()},
+        m_Sorted.data(),
+        m_Sorted.data() + m_Sorted.size(),
+        n,
+        [this](const auto& pk) { return IsPending(m_Entries.at(pk)); },
+        [this, &rc](const auto& pk) { rc = m_Entries.at(pk).rc; });
     return rc;
   }
 
   std::vector<RouterContact>
-  NodeDB::FindManyClosestTo(llarp::dht::Key_t location, uint32_t numRouters) const
+  NodeDB::Page(std::optional<RouterID> after, size_t n, bool& more) const
   {
     util::NullLock lock{m_Access};
-    std::vector<const RouterContact*> all;
-
-    const auto& entries = m_Entries;
-
-    all.reserve(entries.size());
-    for (auto& entry : entries)
-    {
-      all.push_back(&entry.second.rc);
-    }
-
-    auto it_mid = numRouters < all.size() ? all.begin() + numRouters : all.end();
-    std::partial_sort(
-        all.begin(), it_mid, all.end(), [compare = dht::XorMetric{location}](auto* a, auto* b) {
-          return compare(*a, *b);
-        });
+    auto itr = after ? std::upper_bound(m_Sorted.begin(), m_Sorted.end(), *after)
+                     : m_Sorted.begin();
+    std::vector<RouterContact> page;
+    page.reserve(std::min<size_t>(n, m_Sorted.end() - itr));
+    for (; itr != m_Sorted.end() and page.size() < n; ++itr)
+      page.push_back(m_Entries.at(*itr).rc);
+    more = itr != m_Sorted.end();
+    return page;
+  }
 
+  std::vector<RouterContact>
+  NodeDB::FindManyClosestTo(llarp::dht::Key_t location, uint32_t numRouters) const
+  {
+    util::NullLock lock{m_Access};
     std::vector<RouterContact> closest;
-    closest.reserve(numRouters);
-    for (auto it = all.begin(); it != it_mid; ++it)
-      closest.push_back(**it);
-
+    size_t n = std::min<size_t>(numRouters, m_Sorted.size());
+    closest.reserve(n);
+    dht::VisitClosest(
+        RouterID{location.as_array()},
+        m_Sorted.data(),
+        m_Sorted.data() + m_Sorted.size(),
+        n,
+        [this](const auto& pk) { return IsPending(m_Entries.at(pk)); },
+        [this, &closest](const auto& pk) { closest.push_back(m_Entries.at(pk).rc); });
     return closest;
   }
 }  // namespace llarp
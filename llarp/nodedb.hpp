@@ -2,8 +2,10 @@
 
 #include "router_contact.hpp"
 #include "router_id.hpp"
+#include "nodedb_store.hpp"
 #include "util/common.hpp"
 #include "util/fs.hpp"
+#include "util/mem_account.hpp"
 #include "util/thread/threading.hpp"
 #include "util/thread/annotations.hpp"
 #include "dht/key.hpp"
@@ -13,6 +15,8 @@
 #include <optional>
 #include <unordered_set>
 #include <unordered_map>
+#include <random>
+#include <vector>
 #include <utility>
 #include <atomic>
 #include <algorithm>
@@ -21,16 +25,60 @@ namespace llarp
 {
   class NodeDB
   {
+   public:
+    /// the little of an rc that picking and expiring routers looks at, kept packed together for
+    /// all of them apart from the rcs themselves, so going through every router to find a few
+    /// touches one small array rather than every rc's scattered heap
+    struct Summary
+    {
+      RouterID pubkey;
+      llarp_time_t lastUpdated = 0s;
+      llarp_time_t insertedAt = 0s;
+      bool publicRouter = false;
+      bool exit = false;
+      /// if the rc was loaded from disk without checking its signature, and is waiting on
+      /// VerifiedPending
+      bool pending = false;
+
+      explicit Summary(const RouterContact& rc);
+    };
+
+   private:
     struct Entry
     {
       const RouterContact rc;
-      llarp_time_t insertedAt;
+      /// where we are in m_Dense
+      size_t denseIndex = 0;
+      /// if rc has not been written out since it was inserted or changed
+      bool dirty = true;
       explicit Entry(RouterContact rc);
     };
-    using NodeMap = std::unordered_map<RouterID, Entry>;
+    using NodeMap = std::unordered_map<
+        RouterID,
+        Entry,
+        std::hash<RouterID>,
+        std::equal_to<RouterID>,
+        util::TaggedAllocator<std::pair<const RouterID, Entry>, util::MemTag::NodeDB>>;
 
     NodeMap m_Entries;
 
+    struct Hot
+    {
+      Summary summary;
+      Entry* entry;
+    };
+
+    /// the summary of every entry of m_Entries packed together in no order, so that we can pick
+    /// one at random in O(1); kept packed by moving the last one into the hole on removal.  map
+    /// nodes don't move so pointing into them is fine.
+    std::vector<Hot> m_Dense;
+
+    /// the keys of m_Entries, sorted, for dht::VisitClosest
+    std::vector<RouterID> m_Sorted;
+
+    /// how many random picks GetRandom tries before falling back to looking at everything
+    static constexpr size_t RandomSampleTries = 32;
+
     const fs::path m_Root;
 
     const std::function<void(std::function<void()>)> disk;
@@ -39,13 +87,84 @@ namespace llarp
 
     mutable util::NullMutex m_Access;
 
-    /// asynchronously remove the files for a set of rcs on disk given their public ident key
+    /// where we keep the rcs on disk, unless we are in memory only.  used from the disk thread,
+    /// and at load and save.
+    util::Mutex m_StoreAccess;
+    std::optional<NodeDBStore> m_Store GUARDED_BY(m_StoreAccess);
+
+    /// routers removed since the last flush, whose removals go out with it
+    std::unordered_set<RouterID> m_Removed;
+    /// set by the disk thread when the store has grown to mostly dead records, so that the next
+    /// flush rewrites it with everything we have rather than appending what changed
+    std::atomic<bool> m_WantCompact{false};
+
+    /// called with the routers whose rc we replace or drop
+    std::function<void(const RouterID&)> m_OnChange;
+
+    /// remove a set of rcs from disk given their public ident key, batched up with the next
+    /// flush
     void
-    AsyncRemoveManyFromDisk(std::unordered_set<RouterID> idents) const;
+    AsyncRemoveManyFromDisk(std::unordered_set<RouterID> idents);
+
+    /// copies of the dirty rcs, marking them clean
+    std::vector<RouterContact>
+    TakeDirty();
+
+    /// copies of all our rcs
+    std::vector<RouterContact>
+    CopyAll() const;
+
+    /// add an entry, replacing any for the same router
+    Entry&
+    Insert(RouterContact rc);
+
+    /// puts an entry just added to m_Entries in m_Dense
+    Summary&
+    AddDense(Entry& entry);
 
-    /// get filename of an RC file given its public ident key
-    fs::path
-    GetPathForPubkey(RouterID pk) const;
+    /// a random one of m_Dense that is not pending and passes, uniformly; nullptr if none do
+    template <typename Pred>
+    const Hot*
+    PickRandom(Pred pass) const
+    {
+      if (m_Dense.empty())
+        return nullptr;
+
+      llarp::CSRNG rng{};
+      // rejection sampling, O(1) expected when most rcs pass
+      std::uniform_int_distribution<size_t> pick{0, m_Dense.size() - 1};
+      for (size_t tries = 0; tries < RandomSampleTries; ++tries)
+      {
+        const auto& hot = m_Dense[pick(rng)];
+        if (not hot.summary.pending and pass(hot))
+          return &hot;
+      }
+
+      // few pass, if any, so look at each one once in random order
+      std::vector<const Hot*> entries;
+      entries.reserve(m_Dense.size());
+      for (const auto& hot : m_Dense)
+        entries.push_back(&hot);
+      std::shuffle(entries.begin(), entries.end(), rng);
+      for (const auto* hot : entries)
+      {
+        if (not hot->summary.pending and pass(*hot))
+          return hot;
+      }
+      return nullptr;
+    }
+
+    /// remove an entry, returning the one after it like unordered_map::erase
+    NodeMap::iterator
+    Erase(NodeMap::iterator itr);
+
+    /// if entry's rc is still waiting on VerifiedPending.  until it is checked it is not one we
+    /// have accepted, so nothing that answers peers or picks hops gets to see it.
+    bool
+    IsPending(const Entry& entry) const
+    {
+      return m_Dense[entry.denseIndex].summary.pending;
+    }
 
    public:
     explicit NodeDB(fs::path rootdir, std::function<void(std::function<void()>)> diskCaller);
@@ -53,13 +172,38 @@ namespace llarp
     /// in memory nodedb
     NodeDB();
 
-    /// load all entries from disk syncrhonously
+    /// load all entries from disk syncrhonously.  with verify false their signatures are left
+    /// for the caller to check, off the startup path: the rcs come in pending, and the lookups
+    /// that answer peers or pick hops pass over them, until the results are handed to
+    /// VerifiedPending.  only the upkeep of the db itself (Page, VisitInsertedBefore, NumLoaded
+    /// and the removals) sees them before then.
+    void
+    LoadFromDisk(bool verify = true);
+
+    /// the reading half of LoadFromDisk: our rcs off disk, junk and expired ones purged from it,
+    /// without touching what we have in memory, so that it can run on the disk thread while the
+    /// router starts up.  hand what it returns to AddPending, back on the loop.
+    std::vector<RouterContact>
+    ReadFromDisk();
+
+    /// put in rcs from ReadFromDisk, pending until VerifiedPending, all in one go rather than an
+    /// Insert each.  routers we have had an rc put in for since are left with that one, as those
+    /// were checked on their way in.  returns how many were added.
+    size_t
+    AddPending(std::vector<RouterContact> rcs);
+
+    /// the rcs LoadFromDisk left pending
+    std::vector<RouterContact>
+    PendingRCs() const;
+
+    /// apply the signature checks of rcs, from PendingRCs: valid ones stop being pending and
+    /// invalid ones are removed.  any since replaced by a Put are left alone.
     void
-    LoadFromDisk();
+    VerifiedPending(const std::vector<RouterContact>& rcs, const std::vector<bool>& valid);
 
-    /// explicit save all RCs to disk synchronously
+    /// write out anything not yet on disk, synchronously
     void
-    SaveToDisk() const;
+    SaveToDisk();
 
     /// the number of RCs that are loaded from disk
     size_t
@@ -69,7 +213,16 @@ namespace llarp
     void
     Tick(llarp_time_t now);
 
-    /// find the absolute closets router to a dht location
+    /// has hook called with each router whose rc we replace or drop, for keeping what was made
+    /// from the rc we had in step; replaces any hook set before
+    void
+    SetChangeHook(std::function<void(const RouterID&)> hook)
+    {
+      m_OnChange = std::move(hook);
+    }
+
+    /// find the absolute closets router to a dht location.  this and FindManyClosestTo take
+    /// O(log size + routers found).
     RouterContact
     FindClosestTo(dht::Key_t location) const;
 
@@ -77,6 +230,12 @@ namespace llarp
     std::vector<RouterContact>
     FindManyClosestTo(dht::Key_t location, uint32_t numRouters) const;
 
+    /// copies of up to n of our rcs in order of their keys, from the first key past after (or
+    /// the start), for walking all of them a page at a time.  O(log size + n).  more is set to
+    /// whether there are rcs past the page.
+    std::vector<RouterContact>
+    Page(std::optional<RouterID> after, size_t n, bool& more) const;
+
     /// return true if we have an rc by its ident pubkey
     bool
     Has(RouterID pk) const;
@@ -85,24 +244,28 @@ namespace llarp
     std::optional<RouterContact>
     Get(RouterID pk) const;
 
+    /// get a random rc, uniformly among those visit returns true for.  visit may be called on
+    /// the same rc more than once.  callers that want some routers picked more than others can
+    /// have visit accept them with a probability to match.
     template <typename Filter>
     std::optional<RouterContact>
     GetRandom(Filter visit) const
     {
       util::NullLock lock{m_Access};
+      if (const auto* hot = PickRandom([&visit](const Hot& h) { return visit(h.entry->rc); }))
+        return hot->entry->rc;
+      return std::nullopt;
+    }
 
-      std::vector<const decltype(m_Entries)::value_type*> entries;
-      for (const auto& entry : m_Entries)
-        entries.push_back(&entry);
-
-      std::shuffle(entries.begin(), entries.end(), llarp::CSRNG{});
-
-      for (const auto entry : entries)
-      {
-        if (visit(entry->second.rc))
-          return entry->second.rc;
-      }
-
+    /// GetRandom for callers that only need the summary to choose: visit sees only that, so the
+    /// rcs we pass over are never touched, and we copy out just the one picked
+    template <typename Filter>
+    std::optional<RouterContact>
+    GetRandomBySummary(Filter visit) const
+    {
+      util::NullLock lock{m_Access};
+      if (const auto* hot = PickRandom([&visit](const Hot& h) { return visit(h.summary); }))
+        return hot->entry->rc;
       return std::nullopt;
     }
 
@@ -112,9 +275,10 @@ namespace llarp
     VisitAll(Visit visit) const
     {
       util::NullLock lock{m_Access};
-      for (const auto& item : m_Entries)
+      for (const auto& hot : m_Dense)
       {
-        visit(item.second.rc);
+        if (not hot.summary.pending)
+          visit(hot.entry->rc);
       }
     }
 
@@ -124,10 +288,23 @@ namespace llarp
     VisitInsertedBefore(Visit visit, llarp_time_t insertedBefore)
     {
       util::NullLock lock{m_Access};
-      for (const auto& item : m_Entries)
+      for (const auto& hot : m_Dense)
       {
-        if (item.second.insertedAt < insertedBefore)
-          visit(item.second.rc);
+        if (hot.summary.insertedAt < insertedBefore)
+          visit(hot.entry->rc);
+      }
+    }
+
+    /// visit all entries with rcs updated after a timestamp
+    template <typename Visit>
+    void
+    VisitUpdatedSince(Visit visit, llarp_time_t since) const
+    {
+      util::NullLock lock{m_Access};
+      for (const auto& hot : m_Dense)
+      {
+        if (not hot.summary.pending and hot.summary.lastUpdated > since)
+          visit(hot.entry->rc);
       }
     }
 
@@ -148,7 +325,7 @@ namespace llarp
         if (visit(itr->second.rc))
         {
           removed.insert(itr->second.rc.pubkey);
-          itr = m_Entries.erase(itr);
+          itr = Erase(itr);
         }
         else
           ++itr;
@@ -157,6 +334,34 @@ namespace llarp
         AsyncRemoveManyFromDisk(std::move(removed));
     }
 
+    /// RemoveIf a chunk at a time: looks at no more than max entries, in key order after cursor,
+    /// and moves cursor on past them.  returns true once it has been through to the end, leaving
+    /// cursor empty for the next pass.
+    template <typename Filter>
+    bool
+    RemoveIfChunk(Filter visit, std::optional<RouterID>& cursor, size_t max)
+    {
+      util::NullLock lock{m_Access};
+      auto itr = cursor ? std::upper_bound(m_Sorted.begin(), m_Sorted.end(), *cursor)
+                        : m_Sorted.begin();
+      std::unordered_set<RouterID> removed;
+      for (; itr != m_Sorted.end() and max > 0; ++itr, --max)
+      {
+        if (visit(m_Entries.at(*itr).rc))
+          removed.insert(*itr);
+        cursor = *itr;
+      }
+      const bool done = itr == m_Sorted.end();
+      if (done)
+        cursor.reset();
+      // only now, as erasing moves m_Sorted about under itr
+      for (const auto& pk : removed)
+        Erase(m_Entries.find(pk));
+      if (not removed.empty())
+        AsyncRemoveManyFromDisk(std::move(removed));
+      return done;
+    }
+
     /// remove rcs that are not in keep and have been inserted before cutoff
     void
     RemoveStaleRCs(std::unordered_set<RouterID> keep, llarp_time_t cutoff);
@@ -0,0 +1,271 @@
+#include "nodedb_store.hpp"
+
+#include "util/file.hpp"
+#include "util/logging.hpp"
+
+#include <oxenc/endian.h>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string_view>
+
+namespace llarp
+{
+  static auto logcat = log::Cat("nodedb");
+
+  static constexpr std::string_view Magic{"LKNODEDB"};
+  static constexpr uint32_t FormatVersion = 1;
+  static constexpr size_t HeaderSize = Magic.size() + sizeof(uint32_t);
+
+  static constexpr byte_t KindPut = 'p';
+  static constexpr byte_t KindRemove = 'r';
+  /// kind, body length, router id
+  static constexpr size_t RecordHeaderSize = 1 + sizeof(uint32_t) + RouterID::SIZE;
+
+  static bool
+  WriteHeader(fs::ofstream& out)
+  {
+    std::array<char, HeaderSize> header;
+    std::copy(Magic.begin(), Magic.end(), header.begin());
+    oxenc::write_host_as_little(FormatVersion, header.data() + Magic.size());
+    return bool(out.write(header.data(), header.size()));
+  }
+
+  static bool
+  WriteRecord(fs::ofstream& out, byte_t kind, const RouterID& id, const byte_t* body, uint32_t len)
+  {
+    std::array<char, RecordHeaderSize> header;
+    header[0] = kind;
+    oxenc::write_host_as_little(len, header.data() + 1);
+    std::copy(id.begin(), id.end(), header.begin() + 5);
+    out.write(header.data(), header.size());
+    out.write(reinterpret_cast<const char*>(body), len);
+    return bool(out);
+  }
+
+  /// bencode rc into buf, giving the encoded size, or nothing if it doesn't encode
+  static std::optional<uint32_t>
+  Encode(const RouterContact& rc, std::array<byte_t, MAX_RC_SIZE>& tmp)
+  {
+    llarp_buffer_t buf{tmp};
+    if (not rc.BEncode(&buf))
+      return std::nullopt;
+    return buf.cur - buf.base;
+  }
+
+  NodeDBStore::NodeDBStore(fs::path file) : m_File{std::move(file)}
+  {}
+
+  void
+  NodeDBStore::Track(const RouterID& id, size_t size)
+  {
+    auto& live = m_Live[id];
+    m_LiveSize -= live;
+    live = size;
+    m_LiveSize += live;
+  }
+
+  bool
+  NodeDBStore::Load(std::function<void(const RouterID&, llarp_buffer_t)> visit)
+  {
+    if (not fs::exists(m_File))
+      return false;
+    std::optional<util::MappedFile> map;
+    try
+    {
+      map.emplace(m_File);
+    }
+    catch (const std::exception& e)
+    {
+      log::error(logcat, "cannot map {}: {}", m_File, e.what());
+      return false;
+    }
+    const byte_t* const data = map->data();
+    const size_t size = map->size();
+    if (size < HeaderSize or not std::equal(Magic.begin(), Magic.end(), data)
+        or oxenc::load_little_to_host<uint32_t>(data + Magic.size()) != FormatVersion)
+    {
+      log::warning(logcat, "{} is not a nodedb file we know, ignoring it", m_File);
+      return false;
+    }
+
+    // find each router's last record first, so that we only ever decode the rcs we keep
+    struct Body
+    {
+      size_t offset;
+      uint32_t len;
+    };
+    std::unordered_map<RouterID, Body> live;
+    size_t pos = HeaderSize;
+    while (size - pos >= RecordHeaderSize)
+    {
+      const byte_t kind = data[pos];
+      const auto len = oxenc::load_little_to_host<uint32_t>(data + pos + 1);
+      if (len > size - pos - RecordHeaderSize or (kind != KindPut and kind != KindRemove))
+        break;
+      const RouterID id{data + pos + 5};
+      if (kind == KindPut)
+        live[id] = Body{pos + RecordHeaderSize, len};
+      else
+        live.erase(id);
+      pos += RecordHeaderSize + len;
+    }
+
+    m_FileSize = pos;
+    m_Live.clear();
+    m_LiveSize = 0;
+    for (const auto& [id, body] : live)
+    {
+      Track(id, RecordHeaderSize + body.len);
+      // the mapping is read only, but decoding only ever reads
+      visit(id, llarp_buffer_t{const_cast<byte_t*>(data + body.offset), body.len});
+    }
+
+    map.reset();
+    if (pos < size)
+    {
+      log::warning(
+          logcat, "dropping {} bytes of partial record from the end of {}", size - pos, m_File);
+      std::error_code ec;
+      fs::resize_file(m_File, pos, ec);
+      if (ec)
+        log::error(logcat, "failed to truncate {}: {}", m_File, ec.message());
+    }
+    return true;
+  }
+
+  void
+  NodeDBStore::Append(const std::vector<RouterContact>& rcs)
+  {
+    if (rcs.empty())
+      return;
+    // with nothing written yet, anything there is not ours (Load would have said), so start over
+    const auto mode = m_FileSize == 0 ? std::ios::trunc : std::ios::app;
+    fs::ofstream out{m_File, std::ios::binary | std::ios::out | mode};
+    if (m_FileSize == 0)
+    {
+      if (not WriteHeader(out))
+      {
+        log::error(logcat, "failed to write to {}", m_File);
+        Untear(out);
+        return;
+      }
+      m_FileSize = HeaderSize;
+    }
+    std::array<byte_t, MAX_RC_SIZE> tmp;
+    for (const auto& rc : rcs)
+    {
+      const auto len = Encode(rc, tmp);
+      if (not len)
+        continue;
+      const RouterID id{rc.pubkey};
+      if (not WriteRecord(out, KindPut, id, tmp.data(), *len))
+      {
+        log::error(logcat, "failed to write to {}", m_File);
+        Untear(out);
+        return;
+      }
+      m_FileSize += RecordHeaderSize + *len;
+      Track(id, RecordHeaderSize + *len);
+    }
+  }
+
+  void
+  NodeDBStore::AppendRemovals(const std::unordered_set<RouterID>& removed)
+  {
+    fs::ofstream out;
+    for (const auto& id : removed)
+    {
+      const auto itr = m_Live.find(id);
+      if (itr == m_Live.end())
+        continue;
+      if (not out.is_open())
+        out.open(m_File, std::ios::binary | std::ios::out | std::ios::app);
+      if (not WriteRecord(out, KindRemove, id, nullptr, 0))
+      {
+        log::error(logcat, "failed to write to {}", m_File);
+        Untear(out);
+        return;
+      }
+      m_FileSize += RecordHeaderSize;
+      m_LiveSize -= itr->second;
+      m_Live.erase(itr);
+    }
+  }
+
+  void
+  NodeDBStore::Untear(fs::ofstream& out)
+  {
+    out.close();
+    if (m_FileSize == 0)
+      return;
+    std::error_code ec;
+    // records we counted may still have been in the stream's buffer when it failed, gone with it
+    if (const auto size = fs::file_size(m_File, ec); not ec and size >= m_FileSize)
+    {
+      fs::resize_file(m_File, m_FileSize, ec);
+      if (not ec)
+        return;
+    }
+    log::error(logcat, "cannot cut {} back to {} bytes: {}", m_File, m_FileSize, ec.message());
+    // start the file over with the next append, and have the whole of it written by Compact
+    m_FileSize = 0;
+    m_Torn = true;
+  }
+
+  bool
+  NodeDBStore::ShouldCompact() const
+  {
+    return m_Torn or (m_FileSize >= CompactMinSize and m_FileSize > m_LiveSize * CompactRatio);
+  }
+
+  void
+  NodeDBStore::Compact(const std::vector<RouterContact>& rcs)
+  {
+    auto tmpfile = m_File;
+    tmpfile += ".new";
+    std::unordered_map<RouterID, size_t> live;
+    size_t filesize = HeaderSize;
+    {
+      fs::ofstream out{tmpfile, std::ios::binary | std::ios::out | std::ios::trunc};
+      bool ok = WriteHeader(out);
+      std::array<byte_t, MAX_RC_SIZE> tmp;
+      for (auto itr = rcs.begin(); ok and itr != rcs.end(); ++itr)
+      {
+        const auto len = Encode(*itr, tmp);
+        if (not len)
+          continue;
+        const RouterID id{itr->pubkey};
+        ok = WriteRecord(out, KindPut, id, tmp.data(), *len);
+        live[id] = RecordHeaderSize + *len;
+        filesize += RecordHeaderSize + *len;
+      }
+      if (ok)
+        ok = bool(out.flush());
+      if (not ok)
+      {
+        log::error(logcat, "failed to write {}", tmpfile);
+        out.close();
+        std::error_code ec;
+        fs::remove(tmpfile, ec);
+        return;
+      }
+    }
+    std::error_code ec;
+    fs::rename(tmpfile, m_File, ec);
+    if (ec)
+    {
+      log::error(logcat, "failed to replace {}: {}", m_File, ec.message());
+      fs::remove(tmpfile, ec);
+      return;
+    }
+    log::debug(logcat, "rewrote {}: {} bytes down to {}", m_File, m_FileSize, filesize);
+    m_Live = std::move(live);
+    m_FileSize = filesize;
+    m_Torn = false;
+    m_LiveSize = 0;
+    for (const auto& item : m_Live)
+      m_LiveSize += item.second;
+  }
+}  // namespace llarp
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "router_contact.hpp"
+#include "router_id.hpp"
+#include "util/buffer.hpp"
+#include "util/fs.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace llarp
+{
+  /// the nodedb on disk: a single file that we append RCs and removals to as they change, and
+  /// replay on startup, the last record for a router winning.  once superseded and removed
+  /// records make up most of it, it gets rewritten with just the live RCs.
+  ///
+  /// the file is a magic and format version, then records of a kind byte, a little endian u32
+  /// body length and the router id, followed by the body: the bencoded RC for a put, nothing for
+  /// a removal.  a record cut short at the end (we went down halfway through an append) is
+  /// dropped when we load.
+  ///
+  /// not thread safe; NodeDB does everything after Load on its disk thread.
+  class NodeDBStore
+  {
+   public:
+    static constexpr auto Filename = "nodedb.dat";
+
+    /// the file gets rewritten once it is at least this big and more than this many times the
+    /// size of the live records in it
+    static constexpr size_t CompactMinSize = 1024 * 1024;
+    static constexpr size_t CompactRatio = 2;
+
+    explicit NodeDBStore(fs::path file);
+
+    /// map the file and give visit the bencoded form of each live RC straight out of the mapping,
+    /// which is only valid during the call.  records that were superseded or removed later on
+    /// are skipped over by their headers without being looked at.  returns false if there is no
+    /// file or it is not one of ours.
+    bool
+    Load(std::function<void(const RouterID&, llarp_buffer_t)> visit);
+
+    /// append a put for each rc
+    void
+    Append(const std::vector<RouterContact>& rcs);
+
+    /// append a removal for each router we have an rc for
+    void
+    AppendRemovals(const std::unordered_set<RouterID>& removed);
+
+    /// whether the file is big and mostly dead records, so that Compact is worth doing
+    bool
+    ShouldCompact() const;
+
+    /// replace the file with one holding only rcs.  written to a temporary and renamed over, so
+    /// a crash part way through leaves us with the old one.
+    void
+    Compact(const std::vector<RouterContact>& rcs);
+
+    /// size of the file as we have written it
+    size_t
+    FileSize() const
+    {
+      return m_FileSize;
+    }
+
+    /// how much of FileSize is the latest put for a router that has not been removed since
+    size_t
+    LiveSize() const
+    {
+      return m_LiveSize;
+    }
+
+   private:
+    const fs::path m_File;
+    size_t m_FileSize = 0;
+    size_t m_LiveSize = 0;
+    /// record size of each router's live put
+    std::unordered_map<RouterID, size_t> m_Live;
+
+    /// set when a write failed part way and we could not cut the file back, so that it gets
+    /// rewritten whole
+    bool m_Torn = false;
+
+    /// account for a put of size bytes for id
+    void
+    Track(const RouterID& id, size_t size);
+
+    /// after a write to out failed, cut the file back to the m_FileSize we know we wrote, so
+    /// that appends after don't land behind a torn record and get lost with it on the next Load
+    void
+    Untear(fs::ofstream& out);
+  };
+}  // namespace llarp
@@ -1,5 +1,6 @@
 #include "ihophandler.hpp"
 #include <llarp/router/abstractrouter.hpp>
+#include <llarp/util/buffer_pool.hpp>
 
 namespace llarp
 {
@@ -7,28 +8,42 @@ namespace llarp
   {
     // handle data in upstream direction
     bool
-    IHopHandler::HandleUpstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter* r)
+    IHopHandler::HandleUpstream(
+        const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter* r, uint16_t priority)
     {
-      auto& pkt = m_UpstreamQueue.emplace_back();
-      pkt.first.resize(X.sz);
-      std::copy_n(X.base, X.sz, pkt.first.begin());
-      pkt.second = Y;
+      m_UpstreamQueue.emplace_back(util::BufferPool::Acquire(X.base, X.sz), Y, priority);
       r->TriggerPump();
       return true;
     }
 
     // handle data in downstream direction
     bool
-    IHopHandler::HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter* r)
+    IHopHandler::HandleDownstream(
+        const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter* r, uint16_t priority)
     {
-      auto& pkt = m_DownstreamQueue.emplace_back();
-      pkt.first.resize(X.sz);
-      std::copy_n(X.base, X.sz, pkt.first.begin());
-      pkt.second = Y;
+      m_DownstreamQueue.emplace_back(util::BufferPool::Acquire(X.base, X.sz), Y, priority);
       r->TriggerPump();
       return true;
     }
 
+    IHopHandler::TrafficQueue_t
+    IHopHandler::TakeQueue(TrafficQueue_t& queue)
+    {
+      TrafficQueue_t batch;
+      // batches tend to be alike in size, so start the next one where this one ended up
+      batch.reserve(queue.size());
+      std::swap(batch, queue);
+      return batch;
+    }
+
+    void
+    IHopHandler::ReleaseTraffic(TrafficQueue_t& msgs)
+    {
+      for (auto& msg : msgs)
+        util::BufferPool::Release(std::get<0>(msg));
+      msgs.clear();
+    }
+
     void
     IHopHandler::DecayFilters(llarp_time_t now)
     {
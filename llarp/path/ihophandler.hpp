@@ -3,8 +3,10 @@
 #include <llarp/crypto/types.hpp>
 #include <llarp/util/types.hpp>
 #include <llarp/crypto/encrypted_frame.hpp>
-#include <llarp/util/decaying_hashset.hpp>
+#include <llarp/util/rotating_bloom_filter.hpp>
 #include <llarp/messages/relay.hpp>
+#include <functional>
+#include <tuple>
 #include <vector>
 
 #include <memory>
@@ -24,8 +26,16 @@ namespace llarp
   {
     struct IHopHandler
     {
-      using TrafficEvent_t = std::pair<std::vector<byte_t>, TunnelNonce>;
-      using TrafficQueue_t = std::list<TrafficEvent_t>;
+      /// onion traffic queued for (or coming back from) the crypto workers.  the payload is a
+      /// util::BufferPool buffer which is decrypted in place and, once sent on or handled, given
+      /// back to the pool, so relaying a message costs one copy out of the link buffer and no
+      /// allocations.  last is the priority the link message it goes out in is queued with.
+      using TrafficEvent_t = std::tuple<std::vector<byte_t>, TunnelNonce, uint16_t>;
+      using TrafficQueue_t = std::vector<TrafficEvent_t>;
+
+      /// nonces seen recently in one direction; a util::DecayingHashSet<TunnelNonce> works here
+      /// too, exactly but with an allocation per message
+      using ReplayFilter_t = util::RotatingBloomFilter<TunnelNonce>;
 
       virtual ~IHopHandler() = default;
 
@@ -47,16 +57,20 @@ namespace llarp
 
       // handle data in upstream direction
       virtual bool
-      HandleUpstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter*);
+      HandleUpstream(
+          const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter*, uint16_t priority);
       // handle data in downstream direction
       virtual bool
-      HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter*);
+      HandleDownstream(
+          const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter*, uint16_t priority);
 
       /// return timestamp last remote activity happened at
       virtual llarp_time_t
       LastRemoteActivityAt() const = 0;
 
-      virtual bool
+      /// the worker half of handling a path build status (LRSM): does its crypto, taking frames
+      /// over, and returns what is left to do on the logic thread, if there is anything
+      virtual std::function<void()>
       HandleLRSM(uint64_t status, std::array<EncryptedFrame, 8>& frames, AbstractRouter* r) = 0;
 
       uint64_t
@@ -75,8 +89,8 @@ namespace llarp
       uint64_t m_SequenceNum = 0;
       TrafficQueue_t m_UpstreamQueue;
       TrafficQueue_t m_DownstreamQueue;
-      util::DecayingHashSet<TunnelNonce> m_UpstreamReplayFilter;
-      util::DecayingHashSet<TunnelNonce> m_DownstreamReplayFilter;
+      ReplayFilter_t m_UpstreamReplayFilter;
+      ReplayFilter_t m_DownstreamReplayFilter;
 
       virtual void
       UpstreamWork(TrafficQueue_t queue, AbstractRouter* r) = 0;
@@ -84,10 +98,20 @@ namespace llarp
       virtual void
       DownstreamWork(TrafficQueue_t queue, AbstractRouter* r) = 0;
 
+      /// handle a batch back from the workers, holding the payloads and the nonces to send on
+      /// with; runs in the logic thread
       virtual void
-      HandleAllUpstream(std::vector<RelayUpstreamMessage> msgs, AbstractRouter* r) = 0;
+      HandleAllUpstream(TrafficQueue_t msgs, AbstractRouter* r) = 0;
       virtual void
-      HandleAllDownstream(std::vector<RelayDownstreamMessage> msgs, AbstractRouter* r) = 0;
+      HandleAllDownstream(TrafficQueue_t msgs, AbstractRouter* r) = 0;
+
+      /// hand off everything queued in one direction, leaving the queue ready for the next batch
+      static TrafficQueue_t
+      TakeQueue(TrafficQueue_t& queue);
+
+      /// give the payload buffers in a handled batch back to the pool
+      static void
+      ReleaseTraffic(TrafficQueue_t& msgs);
     };
 
     using HopHandler_ptr = std::shared_ptr<IHopHandler>;
@@ -1,5 +1,6 @@
 #include "path.hpp"
 
+#include <llarp/crypto/fast_crypto.hpp>
 #include <llarp/exit/exit_messages.hpp>
 #include <llarp/link/i_link_manager.hpp>
 #include <llarp/messages/discard.hpp>
@@ -10,6 +11,8 @@
 #include <llarp/nodedb.hpp>
 #include <llarp/profiling.hpp>
 #include <llarp/router/abstractrouter.hpp>
+#include <llarp/router/i_outbound_message_handler.hpp>
+#include <llarp/routing/bundle_message.hpp>
 #include <llarp/routing/dht_message.hpp>
 #include <llarp/routing/path_latency_message.hpp>
 #include <llarp/routing/transfer_traffic_message.hpp>
@@ -18,7 +21,7 @@
 
 #include <oxenc/endian.h>
 
-#include <deque>
+#include <cmath>
 #include <queue>
 
 namespace llarp
@@ -67,19 +70,21 @@ namespace llarp
     }
 
     bool
-    Path::HandleUpstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter* r)
+    Path::HandleUpstream(
+        const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter* r, uint16_t priority)
     {
       if (not m_UpstreamReplayFilter.Insert(Y))
         return false;
-      return IHopHandler::HandleUpstream(X, Y, r);
+      return IHopHandler::HandleUpstream(X, Y, r, priority);
     }
 
     bool
-    Path::HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter* r)
+    Path::HandleDownstream(
+        const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter* r, uint16_t priority)
     {
       if (not m_DownstreamReplayFilter.Insert(Y))
         return false;
-      return IHopHandler::HandleDownstream(X, Y, r);
+      return IHopHandler::HandleDownstream(X, Y, r, priority);
     }
 
     RouterID
@@ -146,7 +151,7 @@ namespace llarp
       return hops_str;
     }
 
-    bool
+    std::function<void()>
     Path::HandleLRSM(uint64_t status, std::array<EncryptedFrame, 8>& frames, AbstractRouter* r)
     {
       uint64_t currentStatus = status;
@@ -199,10 +204,11 @@ namespace llarp
       if ((currentStatus & LR_StatusRecord::SUCCESS) == LR_StatusRecord::SUCCESS)
       {
         llarp::LogDebug("LR_Status message processed, path build successful");
-        r->loop()->call([r, self = shared_from_this()] { self->HandlePathConfirmMessage(r); });
+        return [r, self = shared_from_this()] { self->HandlePathConfirmMessage(r); };
       }
       else
       {
+        bool deregistered = false;
         if (failedAt)
         {
           r->NotifyRouterEvent<tooling::PathBuildRejectedEvent>(Endpoint(), RXID(), *failedAt);
@@ -239,13 +245,7 @@ namespace llarp
           llarp::LogDebug(
               "Path build failed due to one or more nodes considered an "
               "invalid destination");
-          if (failedAt)
-          {
-            r->loop()->call([nodedb = r->nodedb(), router = *failedAt]() {
-              LogInfo("router ", router, " is deregistered so we remove it");
-              nodedb->Remove(router);
-            });
-          }
+          deregistered = failedAt.has_value();
         }
         else if (currentStatus & LR_StatusRecord::FAIL_CANNOT_CONNECT)
         {
@@ -272,17 +272,19 @@ namespace llarp
         RouterID edge{};
         if (failedAt)
           edge = *failedAt;
-        r->loop()->call([r, self = shared_from_this(), edge]() {
+        return [r, self = shared_from_this(), edge, deregistered]() {
+          if (deregistered)
+          {
+            LogInfo("router ", edge, " is deregistered so we remove it");
+            r->nodedb()->Remove(edge);
+          }
           self->EnterState(ePathFailed, r->Now());
           if (auto parent = self->m_PathSet.lock())
           {
             parent->HandlePathBuildFailedAt(self, edge);
           }
-        });
+        };
       }
-
-      // TODO: meaningful return value?
-      return true;
     }  // namespace path
 
     void
@@ -314,9 +316,11 @@ namespace llarp
       {
         LogInfo("path ", Name(), " died");
         _status = st;
-        if (auto parent = m_PathSet.lock())
+        auto self = shared_from_this();
+        // nothing uses a pooled path yet, so the pool just drops it on its next tick
+        if (auto parent = m_PathSet.lock(); parent and not parent->IsPooled(self))
         {
-          parent->HandlePathDied(shared_from_this());
+          parent->HandlePathDied(self);
         }
       }
       else if (st == ePathEstablished && _status == ePathTimeout)
@@ -357,19 +361,24 @@ namespace llarp
           {"expiresSoon", ExpiresSoon(now)},
           {"expiresAt", to_json(ExpireTime())},
           {"ready", IsReady()},
+          {"loss", m_LossEstimate},
+          {"jitter", to_json(LatencyJitter())},
+          {"queueDelay", to_json(m_QueueDelay)},
           {"txRateCurrent", m_LastTXRate},
           {"rxRateCurrent", m_LastRXRate},
           {"replayTX", m_UpstreamReplayFilter.Size()},
           {"replayRX", m_DownstreamReplayFilter.Size()},
           {"hasExit", SupportsAnyRoles(ePathRoleExit)}};
 
-      std::vector<util::StatusObject> hopsObj;
-      std::transform(
-          hops.begin(),
-          hops.end(),
-          std::back_inserter(hopsObj),
-          [](const auto& hop) -> util::StatusObject { return hop.ExtractStatus(); });
-      obj["hops"] = hopsObj;
+      obj["hops"] = m_HopsStatus.Get(0, [this] {
+        std::vector<util::StatusObject> hopsObj;
+        std::transform(
+            hops.begin(),
+            hops.end(),
+            std::back_inserter(hopsObj),
+            [](const auto& hop) -> util::StatusObject { return hop.ExtractStatus(); });
+        return util::StatusObject(hopsObj);
+      });
 
       switch (_status)
       {
@@ -422,10 +431,23 @@ namespace llarp
       m_LastLatencyTestID = latency.T;
       m_LastLatencyTestTime = now;
       LogDebug(Name(), " send latency test id=", latency.T);
-      if (not SendRoutingMessage(latency, r))
-        return false;
-      FlushUpstream(r);
-      return true;
+      // no flushing it on its own: the pump this triggers sends it along with whatever else we
+      // have queued up on this path by then
+      return SendRoutingMessage(latency, r);
+    }
+
+    void
+    Path::MarkDelivery(bool lost)
+    {
+      m_LossEstimate = m_LossEstimate * 7 / 8 + (lost ? 1.0 / 8 : 0);
+    }
+
+    double
+    Path::Score() const
+    {
+      // a path losing everything is still worth something to try over none at all
+      const double latency = m_SmoothedLatency + m_QueueDelay.count();
+      return (latency + 4 * m_LatencyJitter) / std::max(1 - m_LossEstimate, 0.05);
     }
 
     void
@@ -439,6 +461,7 @@ namespace llarp
 
       m_RXRate = 0;
       m_TXRate = 0;
+      m_QueueDelay = r->outboundMessageHandler().QueueDelay(TXID());
 
       if (_status == ePathBuilding)
       {
@@ -460,13 +483,19 @@ namespace llarp
       if (_status == ePathEstablished)
       {
         auto dlt = now - m_LastLatencyTestTime;
-        if (dlt > path::latency_interval && m_LastLatencyTestID == 0)
+        // traffic coming back tells us the path is alive as well as a test would
+        const bool quiet = now - m_LastRecvMessage >= latencyProbeInterval / 2;
+        if (dlt > latencyProbeInterval && m_LastLatencyTestID == 0
+            && (quiet || dlt > latencyProbeInterval * path::busy_latency_factor))
         {
           SendLatencyMessage(r);
           // latency test FEC
           r->loop()->call_later(2s, [self = shared_from_this(), r]() {
             if (self->m_LastLatencyTestID)
+            {
+              self->MarkDelivery(true);
               self->SendLatencyMessage(r);
+            }
           });
           return;
         }
@@ -486,43 +515,48 @@ namespace llarp
     }
 
     void
-    Path::HandleAllUpstream(std::vector<RelayUpstreamMessage> msgs, AbstractRouter* r)
+    Path::HandleAllUpstream(TrafficQueue_t msgs, AbstractRouter* r)
     {
-      for (const auto& msg : msgs)
+      RelayUpstreamMessage msg;
+      msg.pathid = TXID();
+      for (const auto& [payload, nonce, priority] : msgs)
       {
+        msg.X = byte_view_t{payload.data(), payload.size()};
+        msg.Y = nonce;
+        msg.priority = priority;
         if (r->SendToOrQueue(Upstream(), msg))
         {
-          m_TXRate += msg.X.size();
+          m_TXRate += payload.size();
         }
         else
         {
           LogDebug("failed to send upstream to ", Upstream());
         }
       }
+      ReleaseTraffic(msgs);
       r->TriggerPump();
     }
 
     void
     Path::UpstreamWork(TrafficQueue_t msgs, AbstractRouter* r)
     {
-      std::vector<RelayUpstreamMessage> sendmsgs(msgs.size());
-      size_t idx = 0;
-      for (auto& ev : msgs)
+      std::array<SharedSecret, path::max_len> keys;
+      std::array<TunnelNonce, path::max_len> nonces;
+      for (size_t idx = 0; idx < hops.size(); ++idx)
+        keys[idx] = hops[idx].shared;
+      for (auto& [payload, nonce, priority] : msgs)
       {
-        const llarp_buffer_t buf(ev.first);
-        TunnelNonce n = ev.second;
-        for (const auto& hop : hops)
+        // we send with the nonce we were given; each hop's layer uses it stepped along
+        TunnelNonce n = nonce;
+        for (size_t idx = 0; idx < hops.size(); ++idx)
         {
-          CryptoManager::instance()->xchacha20(buf, hop.shared, n);
-          n ^= hop.nonceXOR;
+          nonces[idx] = n;
+          n ^= hops[idx].nonceXOR;
         }
-        auto& msg = sendmsgs[idx];
-        msg.X = buf;
-        msg.Y = ev.second;
-        msg.pathid = TXID();
-        ++idx;
+        fast_crypto::xchacha20_layers(
+            llarp_buffer_t{payload}, keys.data(), nonces.data(), hops.size());
       }
-      r->loop()->call([self = shared_from_this(), data = std::move(sendmsgs), r]() mutable {
+      r->loop()->call([self = shared_from_this(), data = std::move(msgs), r]() mutable {
         self->HandleAllUpstream(std::move(data), r);
       });
     }
@@ -532,9 +566,11 @@ namespace llarp
     {
       if (not m_UpstreamQueue.empty())
       {
-        r->QueueWork([self = shared_from_this(),
-                      data = std::exchange(m_UpstreamQueue, {}),
-                      r]() mutable { self->UpstreamWork(std::move(data), r); });
+        r->QueuePathWork(
+            std::hash<PathID_t>{}(RXID()),
+            [self = shared_from_this(), data = TakeQueue(m_UpstreamQueue), r]() mutable {
+              self->UpstreamWork(std::move(data), r);
+            });
       }
     }
 
@@ -543,9 +579,11 @@ namespace llarp
     {
       if (not m_DownstreamQueue.empty())
       {
-        r->QueueWork([self = shared_from_this(),
-                      data = std::exchange(m_DownstreamQueue, {}),
-                      r]() mutable { self->DownstreamWork(std::move(data), r); });
+        r->QueuePathWork(
+            std::hash<PathID_t>{}(RXID()),
+            [self = shared_from_this(), data = TakeQueue(m_DownstreamQueue), r]() mutable {
+              self->DownstreamWork(std::move(data), r);
+            });
       }
     }
 
@@ -579,31 +617,31 @@ namespace llarp
     void
     Path::DownstreamWork(TrafficQueue_t msgs, AbstractRouter* r)
     {
-      std::vector<RelayDownstreamMessage> sendMsgs(msgs.size());
-      size_t idx = 0;
-      for (auto& ev : msgs)
+      std::array<SharedSecret, path::max_len> keys;
+      std::array<TunnelNonce, path::max_len> nonces;
+      for (size_t idx = 0; idx < hops.size(); ++idx)
+        keys[idx] = hops[idx].shared;
+      for (auto& [payload, nonce, priority] : msgs)
       {
-        const llarp_buffer_t buf(ev.first);
-        sendMsgs[idx].Y = ev.second;
-        for (const auto& hop : hops)
+        for (size_t idx = 0; idx < hops.size(); ++idx)
         {
-          sendMsgs[idx].Y ^= hop.nonceXOR;
-          CryptoManager::instance()->xchacha20(buf, hop.shared, sendMsgs[idx].Y);
+          nonce ^= hops[idx].nonceXOR;
+          nonces[idx] = nonce;
         }
-        sendMsgs[idx].X = buf;
-        ++idx;
+        fast_crypto::xchacha20_layers(
+            llarp_buffer_t{payload}, keys.data(), nonces.data(), hops.size());
       }
-      r->loop()->call([self = shared_from_this(), msgs = std::move(sendMsgs), r]() mutable {
-        self->HandleAllDownstream(std::move(msgs), r);
+      r->loop()->call([self = shared_from_this(), data = std::move(msgs), r]() mutable {
+        self->HandleAllDownstream(std::move(data), r);
       });
     }
 
     void
-    Path::HandleAllDownstream(std::vector<RelayDownstreamMessage> msgs, AbstractRouter* r)
+    Path::HandleAllDownstream(TrafficQueue_t msgs, AbstractRouter* r)
     {
-      for (const auto& msg : msgs)
+      for (auto& [payload, nonce, priority] : msgs)
       {
-        const llarp_buffer_t buf{msg.X};
+        const llarp_buffer_t buf{payload};
         m_RXRate += buf.sz;
         if (HandleRoutingMessage(buf, r))
         {
@@ -611,6 +649,7 @@ namespace llarp
           m_LastRecvMessage = r->Now();
         }
       }
+      ReleaseTraffic(msgs);
     }
 
     bool
@@ -665,12 +704,12 @@ namespace llarp
       if (buf.sz < pad_size)
       {
         // randomize padding
-        CryptoManager::instance()->randbytes(buf.cur, pad_size - buf.sz);
+        fast_crypto::randbytes(buf.cur, pad_size - buf.sz);
         buf.sz = pad_size;
       }
       buf.cur = buf.base;
       LogDebug("send routing message ", msg.S, " with ", buf.sz, " bytes to endpoint ", Endpoint());
-      return HandleUpstream(buf, N, r);
+      return HandleUpstream(buf, N, r, msg.priority);
     }
 
     bool
@@ -685,6 +724,7 @@ namespace llarp
     Path::HandleDataDiscardMessage(const routing::DataDiscardMessage& msg, AbstractRouter* r)
     {
       MarkActive(r->Now());
+      MarkDelivery(true);
       if (m_DropHandler)
         return m_DropHandler(shared_from_this(), msg.P, msg.S);
       return true;
@@ -705,6 +745,8 @@ namespace llarp
         // persist session with upstream router until the path is done
         r->PersistSessionUntil(Upstream(), intro.expiresAt);
         MarkActive(now);
+        // let the last hop bundle what it passes on to us
+        SendRoutingMessage(routing::BundleMessage{}, r);
         return SendLatencyMessage(r);
       }
       LogWarn("got unwarranted path confirm message on tx=", RXID(), " rx=", RXID());
@@ -717,6 +759,19 @@ namespace llarp
       return HandlePathConfirmMessage(r);
     }
 
+    bool
+    Path::HandleBundleMessage(const routing::BundleMessage& msg, AbstractRouter* r)
+    {
+      // the bundle refused any bundles in it when it was decoded, so this only goes one deep
+      bool handled = not msg.messages.empty();
+      for (const auto& inner : msg.messages)
+      {
+        llarp_buffer_t buf{const_cast<byte_t*>(inner.data()), inner.size()};
+        handled = r->ParseRoutingMessageBuffer(buf, this, RXID()) and handled;
+      }
+      return handled;
+    }
+
     bool
     Path::HandleHiddenServiceFrame(const service::ProtocolFrame& frame)
     {
@@ -728,20 +783,6 @@ namespace llarp
       return false;
     }
 
-    template <typename Samples_t>
-    static llarp_time_t
-    computeLatency(const Samples_t& samps)
-    {
-      llarp_time_t mean = 0s;
-      if (samps.empty())
-        return mean;
-      for (const auto& samp : samps)
-        mean += samp;
-      return mean / samps.size();
-    }
-
-    constexpr auto MaxLatencySamples = 8;
-
     bool
     Path::HandlePathLatencyMessage(const routing::PathLatencyMessage&, AbstractRouter* r)
     {
@@ -749,13 +790,25 @@ namespace llarp
       MarkActive(now);
       if (m_LastLatencyTestID)
       {
-        m_LatencySamples.emplace_back(now - m_LastLatencyTestTime);
+        const auto sample = now - m_LastLatencyTestTime;
+        r->routerProfiling().MarkPathLatency(this, sample);
 
-        while (m_LatencySamples.size() > MaxLatencySamples)
-          m_LatencySamples.pop_front();
-
-        intro.latency = computeLatency(m_LatencySamples);
+        // the usual srtt/rttvar smoothing, seeded off the first sample
+        const double ms = sample.count();
+        if (m_SmoothedLatency == 0)
+        {
+          m_SmoothedLatency = ms;
+          m_LatencyJitter = ms / 2;
+        }
+        else
+        {
+          m_LatencyJitter = m_LatencyJitter * 3 / 4 + std::abs(ms - m_SmoothedLatency) / 4;
+          m_SmoothedLatency = m_SmoothedLatency * 7 / 8 + ms / 8;
+        }
+        intro.latency = std::max(
+            std::chrono::milliseconds{static_cast<int64_t>(std::lround(m_SmoothedLatency))}, 1ms);
         m_LastLatencyTestID = 0;
+        MarkDelivery(false);
         EnterState(ePathEstablished, now);
         if (m_BuiltHook)
           m_BuiltHook(shared_from_this());
@@ -892,9 +945,9 @@ namespace llarp
       // handle traffic if we have a handler
       if (!m_ExitTrafficHandler)
         return false;
-      bool sent = msg.X.size() > 0;
+      bool sent = msg.receivedX.size() > 0;
       auto self = shared_from_this();
-      for (const auto& pkt : msg.X)
+      for (const auto& pkt : msg.receivedX)
       {
         if (pkt.size() <= 8)
           continue;
@@ -14,6 +14,8 @@
 #include <llarp/service/intro.hpp>
 #include <llarp/util/aligned.hpp>
 #include <llarp/util/compare_ptr.hpp>
+#include <llarp/util/mem_account.hpp>
+#include <llarp/util/status.hpp>
 #include <llarp/util/thread/threading.hpp>
 #include <llarp/util/time.hpp>
 
@@ -93,6 +95,10 @@ namespace llarp
 
       llarp_time_t buildStarted = 0s;
 
+      /// how often to test latency once established; more often than path::latency_interval
+      /// tracks changes sooner, less often would get idle paths taken for dead
+      llarp_time_t latencyProbeInterval = path::latency_interval;
+
       Path(
           const std::vector<RouterContact>& routers,
           std::weak_ptr<PathSet> parent,
@@ -201,13 +207,56 @@ namespace llarp
         return _status;
       }
 
+      /// smoothed fraction of latency tests and sends that got lost on this path, 0 to 1
+      double
+      LossEstimate() const
+      {
+        return m_LossEstimate;
+      }
+
+      /// smoothed mean deviation of latency tests from intro.latency, as in tcp's rttvar
+      llarp_time_t
+      LatencyJitter() const
+      {
+        return std::chrono::milliseconds{static_cast<int64_t>(m_LatencyJitter)};
+      }
+
+      /// smoothed time what we send on the path waits in our queue for its first hop, as of our
+      /// last tick
+      llarp_time_t
+      QueueDelay() const
+      {
+        return m_QueueDelay;
+      }
+
+      /// how good a path this is to send on, lower being better: latency and time spent in our
+      /// queue, plus a margin for jitter, scaled up by loss.  only meaningful once the path
+      /// IsReady.
+      double
+      Score() const;
+
+      /// bytes sent and received on the path between its last two ticks
+      uint64_t
+      LastTickBytes() const
+      {
+        return m_LastTXRate + m_LastRXRate;
+      }
+
       // handle data in upstream direction
       bool
-      HandleUpstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter*) override;
+      HandleUpstream(
+          const llarp_buffer_t& X,
+          const TunnelNonce& Y,
+          AbstractRouter*,
+          uint16_t priority) override;
       // handle data in downstream direction
 
       bool
-      HandleDownstream(const llarp_buffer_t& X, const TunnelNonce& Y, AbstractRouter*) override;
+      HandleDownstream(
+          const llarp_buffer_t& X,
+          const TunnelNonce& Y,
+          AbstractRouter*,
+          uint16_t priority) override;
 
       const std::string&
       ShortName() const;
@@ -221,7 +270,7 @@ namespace llarp
         return m_LastRecvMessage;
       }
 
-      bool
+      std::function<void()>
       HandleLRSM(
           uint64_t status, std::array<EncryptedFrame, 8>& frames, AbstractRouter* r) override;
 
@@ -339,6 +388,10 @@ namespace llarp
       bool
       HandleDHTMessage(const dht::IMessage& msg, AbstractRouter* r) override;
 
+      /// frames our last hop passed on into this path together, which we handle one by one
+      bool
+      HandleBundleMessage(const routing::BundleMessage& msg, AbstractRouter* r) override;
+
       bool
       HandleRoutingMessage(const llarp_buffer_t& buf, AbstractRouter* r);
 
@@ -394,10 +447,10 @@ namespace llarp
       DownstreamWork(TrafficQueue_t queue, AbstractRouter* r) override;
 
       void
-      HandleAllUpstream(std::vector<RelayUpstreamMessage> msgs, AbstractRouter* r) override;
+      HandleAllUpstream(TrafficQueue_t msgs, AbstractRouter* r) override;
 
       void
-      HandleAllDownstream(std::vector<RelayDownstreamMessage> msgs, AbstractRouter* r) override;
+      HandleAllDownstream(TrafficQueue_t msgs, AbstractRouter* r) override;
 
      private:
       bool
@@ -407,6 +460,10 @@ namespace llarp
       bool
       InformExitResult(llarp_time_t b);
 
+      /// fold whether something we sent made it into m_LossEstimate
+      void
+      MarkDelivery(bool lost);
+
       BuildResultHookFunc m_BuiltHook;
       DataHandlerFunc m_DataHandler;
       DropHandlerFunc m_DropHandler;
@@ -427,8 +484,16 @@ namespace llarp
       uint64_t m_RXRate = 0;
       uint64_t m_LastTXRate = 0;
       uint64_t m_TXRate = 0;
-      std::deque<llarp_time_t> m_LatencySamples;
+      /// ewma of latency test round trips and of their deviation, in ms; intro.latency is the
+      /// former rounded
+      double m_SmoothedLatency = 0;
+      double m_LatencyJitter = 0;
+      double m_LossEstimate = 0;
+      llarp_time_t m_QueueDelay = 0s;
       const std::string m_shortName;
+      /// the hops never change once the path is made, so their status is only built once
+      util::CachedStatus m_HopsStatus;
+      util::MemCharge<util::MemTag::Path> m_MemCharge{sizeof(Path)};
     };
   }  // namespace path
 }  // namespace llarp
@@ -110,20 +110,6 @@ namespace llarp
       return nullptr;
     }
 
-    template <typename Lock_t, typename Map_t, typename Key_t, typename CheckValue_t>
-    bool
-    MapHas(Map_t& map, const Key_t& k, CheckValue_t check)
-    {
-      Lock_t lock(map.first);
-      auto range = map.second.equal_range(k);
-      for (auto i = range.first; i != range.second; ++i)
-      {
-        if (check(i->second))
-          return true;
-      }
-      return false;
-    }
-
     template <typename Lock_t, typename Map_t, typename Key_t, typename Value_t>
     void
     MapPut(Map_t& map, const Key_t& k, const Value_t& v)
@@ -167,49 +153,27 @@ namespace llarp
     bool
     PathContext::HasTransitHop(const TransitHopInfo& info)
     {
-      return MapHas<SyncTransitMap_t::Lock_t>(
-          m_TransitPaths, info.txID, [info](const std::shared_ptr<TransitHop>& hop) -> bool {
-            return info == hop->info;
-          });
+      return m_TransitPaths
+          .FindIf(info.txID, [&info](const TransitHop_ptr& hop) { return info == hop->info; })
+          .has_value();
     }
 
     std::optional<std::weak_ptr<TransitHop>>
     PathContext::TransitHopByInfo(const TransitHopInfo& info)
     {
-      // this is ugly as sin
-      auto own = MapGet<
-          SyncTransitMap_t::Lock_t,
-          decltype(m_TransitPaths),
-          PathID_t,
-          std::function<bool(const std::shared_ptr<TransitHop>&)>,
-          std::function<TransitHop*(const std::shared_ptr<TransitHop>&)>,
-          TransitHop*>(
-          m_TransitPaths,
-          info.txID,
-          [info](const auto& hop) -> bool { return hop->info == info; },
-          [](const auto& hop) -> TransitHop* { return hop.get(); });
-      if (own)
-        return own->weak_from_this();
+      if (auto found = m_TransitPaths.FindIf(
+              info.txID, [&info](const TransitHop_ptr& hop) { return hop->info == info; }))
+        return *found;
       return std::nullopt;
     }
 
     std::optional<std::weak_ptr<TransitHop>>
     PathContext::TransitHopByUpstream(const RouterID& upstream, const PathID_t& id)
     {
-      // this is ugly as sin as well
-      auto own = MapGet<
-          SyncTransitMap_t::Lock_t,
-          decltype(m_TransitPaths),
-          PathID_t,
-          std::function<bool(const std::shared_ptr<TransitHop>&)>,
-          std::function<TransitHop*(const std::shared_ptr<TransitHop>&)>,
-          TransitHop*>(
-          m_TransitPaths,
-          id,
-          [upstream](const auto& hop) -> bool { return hop->info.upstream == upstream; },
-          [](const auto& hop) -> TransitHop* { return hop.get(); });
-      if (own)
-        return own->weak_from_this();
+      if (auto found = m_TransitPaths.FindIf(id, [&upstream](const TransitHop_ptr& hop) {
+            return hop->info.upstream == upstream;
+          }))
+        return *found;
       return std::nullopt;
     }
 
@@ -227,35 +191,26 @@ namespace llarp
       if (own)
         return own;
 
-      return MapGet<SyncTransitMap_t::Lock_t>(
-          m_TransitPaths,
-          id,
-          [remote](const std::shared_ptr<TransitHop>& hop) -> bool {
-            return hop->info.upstream == remote;
-          },
-          [](const std::shared_ptr<TransitHop>& h) -> HopHandler_ptr { return h; });
+      if (auto found = m_TransitPaths.FindIf(
+              id, [&remote](const TransitHop_ptr& hop) { return hop->info.upstream == remote; }))
+        return *found;
+      return nullptr;
     }
 
     bool
     PathContext::TransitHopPreviousIsRouter(const PathID_t& path, const RouterID& otherRouter)
     {
-      SyncTransitMap_t::Lock_t lock(m_TransitPaths.first);
-      auto itr = m_TransitPaths.second.find(path);
-      if (itr == m_TransitPaths.second.end())
-        return false;
-      return itr->second->info.downstream == otherRouter;
+      auto hop = m_TransitPaths.FindIf(path, [](const TransitHop_ptr&) { return true; });
+      return hop and (*hop)->info.downstream == otherRouter;
     }
 
     HopHandler_ptr
     PathContext::GetByDownstream(const RouterID& remote, const PathID_t& id)
     {
-      return MapGet<SyncTransitMap_t::Lock_t>(
-          m_TransitPaths,
-          id,
-          [remote](const std::shared_ptr<TransitHop>& hop) -> bool {
-            return hop->info.downstream == remote;
-          },
-          [](const std::shared_ptr<TransitHop>& h) -> HopHandler_ptr { return h; });
+      if (auto found = m_TransitPaths.FindIf(
+              id, [&remote](const TransitHop_ptr& hop) { return hop->info.downstream == remote; }))
+        return *found;
+      return nullptr;
     }
 
     PathSet_ptr
@@ -288,39 +243,99 @@ namespace llarp
     PathContext::GetPathForTransfer(const PathID_t& id)
     {
       const RouterID us(OurRouterID());
-      auto& map = m_TransitPaths;
-      {
-        SyncTransitMap_t::Lock_t lock(map.first);
-        auto range = map.second.equal_range(id);
-        for (auto i = range.first; i != range.second; ++i)
-        {
-          if (i->second->info.upstream == us)
-            return i->second;
-        }
-      }
+      if (auto found = m_TransitPaths.FindIf(
+              id, [&us](const TransitHop_ptr& hop) { return hop->info.upstream == us; }))
+        return *found;
       return nullptr;
     }
 
     void
     PathContext::PumpUpstream()
     {
-      m_TransitPaths.ForEach([&](auto& ptr) { ptr->FlushUpstream(m_Router); });
+      m_TransitPaths.ForEach([&](const auto&, const auto& ptr) { ptr->FlushUpstream(m_Router); });
       m_OurPaths.ForEach([&](auto& ptr) { ptr->FlushUpstream(m_Router); });
     }
 
     void
     PathContext::PumpDownstream()
     {
-      m_TransitPaths.ForEach([&](auto& ptr) { ptr->FlushDownstream(m_Router); });
+      m_TransitPaths.ForEach(
+          [&](const auto&, const auto& ptr) { ptr->FlushDownstream(m_Router); });
       m_OurPaths.ForEach([&](auto& ptr) { ptr->FlushDownstream(m_Router); });
     }
 
+    void
+    PathContext::QueueCommit(CommitJob_t job)
+    {
+      ++m_CommitBacklog;
+      m_PendingCommits.push_back(std::move(job));
+      m_Router->TriggerPump();
+    }
+
+    size_t
+    PathContext::CommitBacklog() const
+    {
+      return m_CommitBacklog;
+    }
+
+    void
+    PathContext::QueueStatus(StatusJob_t job)
+    {
+      m_PendingStatuses.push_back(std::move(job));
+      m_Router->TriggerPump();
+    }
+
+    void
+    PathContext::PumpCommits()
+    {
+      QueueBatches(m_PendingCommits, path::commit_batch_size, [this](size_t done) {
+        m_CommitBacklog -= done;
+      });
+    }
+
+    void
+    PathContext::PumpStatuses()
+    {
+      QueueBatches(m_PendingStatuses, path::status_batch_size, nullptr);
+    }
+
+    void
+    PathContext::QueueBatches(
+        std::vector<CommitJob_t>& jobs, size_t batch_size, std::function<void(size_t)> done)
+    {
+      // one job and one trip back to the logic thread per batch rather than per request, and on
+      // relays these go to threads of their own so they never wait behind traffic
+      for (size_t begin = 0; begin < jobs.size(); begin += batch_size)
+      {
+        const auto end = std::min(begin + batch_size, jobs.size());
+        std::vector<CommitJob_t> batch{
+            std::make_move_iterator(jobs.begin() + begin),
+            std::make_move_iterator(jobs.begin() + end)};
+        m_Router->QueuePathBuildWork([this, done, batch = std::move(batch)] {
+          std::vector<std::function<void()>> results;
+          results.reserve(batch.size());
+          for (const auto& job : batch)
+          {
+            if (auto then = job())
+              results.push_back(std::move(then));
+          }
+          m_Router->loop()->call([this, done, n = batch.size(), results = std::move(results)] {
+            if (done)
+              done(n);
+            for (const auto& then : results)
+              then();
+            // so the messages we just made go out
+            m_Router->TriggerPump();
+          });
+        });
+      }
+      jobs.clear();
+    }
+
     uint64_t
     PathContext::CurrentTransitPaths()
     {
-      SyncTransitMap_t::Lock_t lock(m_TransitPaths.first);
-      const auto& map = m_TransitPaths.second;
-      return map.size() / 2;
+      return m_TransitPaths.Size() / 2;
     }
 
     uint64_t
@@ -340,8 +355,15 @@ namespace llarp
     void
     PathContext::PutTransitHop(std::shared_ptr<TransitHop> hop)
     {
-      MapPut<SyncTransitMap_t::Lock_t>(m_TransitPaths, hop->info.txID, hop);
-      MapPut<SyncTransitMap_t::Lock_t>(m_TransitPaths, hop->info.rxID, hop);
+      m_TransitPaths.Insert(hop->info.txID, hop);
+      m_TransitPaths.Insert(hop->info.rxID, hop);
+      ScheduleTransitHopExpiry(hop, hop->ExpireTime());
+    }
+
+    void
+    PathContext::ScheduleTransitHopExpiry(const TransitHop_ptr& hop, llarp_time_t when)
+    {
+      m_TransitExpiry.Schedule(when, hop);
     }
 
     void
@@ -350,24 +372,24 @@ namespace llarp
       // decay limits
       m_PathLimits.Decay(now);
 
-      {
-        SyncTransitMap_t::Lock_t lock(m_TransitPaths.first);
-        auto& map = m_TransitPaths.second;
-        auto itr = map.begin();
-        while (itr != map.end())
+      // we have far too many transit hops to look at them all every tick, so only the due ones
+      // get looked at.  transit hops never use their replay filters so there is nothing to decay.
+      m_TransitExpiry.Advance(now, [&](std::weak_ptr<TransitHop> weak) {
+        auto hop = weak.lock();
+        if (not hop)
+          return;
+        if (not hop->Expired(now))
         {
-          if (itr->second->Expired(now))
-          {
-            m_Router->outboundMessageHandler().RemovePath(itr->first);
-            itr = map.erase(itr);
-          }
-          else
-          {
-            itr->second->DecayFilters(now);
-            ++itr;
-          }
+          m_TransitExpiry.Schedule(hop->ExpireTime(), hop);
+          return;
         }
-      }
+        const auto isHop = [&hop](const TransitHop_ptr& other) { return other == hop; };
+        for (const auto& id : {hop->info.txID, hop->info.rxID})
+        {
+          if (m_TransitPaths.EraseIf(id, isHop))
+            m_Router->outboundMessageHandler().RemovePath(id);
+        }
+      });
       {
         util::Lock lock(m_OurPaths.first);
         auto& map = m_OurPaths.second;
@@ -399,16 +421,9 @@ namespace llarp
       if (h)
         return h;
       const RouterID us(OurRouterID());
-      auto& map = m_TransitPaths;
-      {
-        SyncTransitMap_t::Lock_t lock(map.first);
-        auto range = map.second.equal_range(id);
-        for (auto i = range.first; i != range.second; ++i)
-        {
-          if (i->second->info.upstream == us)
-            return i->second;
-        }
-      }
+      if (auto found = m_TransitPaths.FindIf(
+              id, [&us](const TransitHop_ptr& hop) { return hop->info.upstream == us; }))
+        return *found;
       return nullptr;
     }
 
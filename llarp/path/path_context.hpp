@@ -10,10 +10,14 @@
 #include <llarp/router/i_outbound_message_handler.hpp>
 #include <llarp/util/compare_ptr.hpp>
 #include <llarp/util/decaying_hashset.hpp>
+#include <llarp/util/thread/sharded_map.hpp>
+#include <llarp/util/timer_wheel.hpp>
 #include <llarp/util/types.hpp>
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace llarp
 {
@@ -41,6 +45,14 @@ namespace llarp
       void
       PumpUpstream();
 
+      /// hand queued path build requests to the path build worker, in batches
+      void
+      PumpCommits();
+
+      /// hand queued path build statuses to the path build worker, in batches
+      void
+      PumpStatuses();
+
       void
       PumpDownstream();
 
@@ -65,6 +77,11 @@ namespace llarp
       void
       PutTransitHop(std::shared_ptr<TransitHop> hop);
 
+      /// have ExpirePaths check on hop at when, or on its next run if that has passed; hops are
+      /// only ever looked at when due, so anything that makes one expire early must call this
+      void
+      ScheduleTransitHopExpiry(const TransitHop_ptr& hop, llarp_time_t when);
+
       HopHandler_ptr
       GetByUpstream(const RouterID& id, const PathID_t& path);
 
@@ -115,27 +132,29 @@ namespace llarp
       void
       RemovePathSet(PathSet_ptr set);
 
-      using TransitHopsMap_t = std::unordered_multimap<PathID_t, TransitHop_ptr>;
+      /// the worker half of handling a path build request (LRCM); returns the logic thread half
+      /// to run once its batch is done, if there is one
+      using CommitJob_t = std::function<std::function<void()>()>;
 
-      struct SyncTransitMap_t
-      {
-        using Mutex_t = util::NullMutex;
-        using Lock_t = util::NullLock;
+      /// queue a path build request for the commit stage; it runs at the next pump
+      void
+      QueueCommit(CommitJob_t job);
 
-        Mutex_t first;  // protects second
-        TransitHopsMap_t second GUARDED_BY(first);
+      /// path build requests queued or being worked on
+      size_t
+      CommitBacklog() const;
 
-        /// Invokes a callback for each transit path; visit must be invokable with a `const
-        /// TransitHop_ptr&` argument.
-        template <typename TransitHopVisitor>
-        void
-        ForEach(TransitHopVisitor&& visit) EXCLUDES(first)
-        {
-          Lock_t lock(first);
-          for (const auto& item : second)
-            visit(item.second);
-        }
-      };
+      /// the worker half of handling a path build status (LRSM), which is IHopHandler::HandleLRSM
+      /// for the hop it came for; as with commits, returns the logic thread half
+      using StatusJob_t = CommitJob_t;
+
+      /// queue a path build status for its hop; it runs at the next pump.  every hop of a path
+      /// that fails reports it at once, so these come in bursts when relays churn
+      void
+      QueueStatus(StatusJob_t job);
+
+      /// transit hops by both their path ids; looked up without locking from any thread
+      using TransitHopsMap_t = thread::ShardedMultiMap<PathID_t, TransitHop_ptr>;
 
       // maps path id -> pathset owner of path
       using OwnedPathsMap_t = std::unordered_map<PathID_t, Path_ptr>;
@@ -179,10 +198,22 @@ namespace llarp
 
      private:
       AbstractRouter* m_Router;
-      SyncTransitMap_t m_TransitPaths;
+      TransitHopsMap_t m_TransitPaths;
+      /// when to look at each transit hop again; 1s granularity is plenty for lifetimes in
+      /// minutes
+      util::TimerWheel<std::weak_ptr<TransitHop>> m_TransitExpiry{1s};
       SyncOwnedPathsMap_t m_OurPaths;
       bool m_AllowTransit;
       util::DecayingHashSet<IpAddress> m_PathLimits;
+      std::vector<CommitJob_t> m_PendingCommits;
+      size_t m_CommitBacklog = 0;
+      std::vector<StatusJob_t> m_PendingStatuses;
+
+      /// runs jobs on the path build worker batch_size at a time, then the halves they return on
+      /// the logic thread, and tells done how many jobs the batch had once they have run
+      void
+      QueueBatches(
+          std::vector<CommitJob_t>& jobs, size_t batch_size, std::function<void(size_t)> done);
     };
   }  // namespace path
 }  // namespace llarp
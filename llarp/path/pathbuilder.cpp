@@ -5,13 +5,17 @@
 #include <llarp/messages/relay_commit.hpp>
 #include <llarp/nodedb.hpp>
 #include <llarp/util/logging.hpp>
+#include <llarp/util/metrics.hpp>
 #include <llarp/profiling.hpp>
 #include <llarp/router/abstractrouter.hpp>
+#include <llarp/router/i_outbound_session_maker.hpp>
 #include <llarp/router/i_rc_lookup_handler.hpp>
 #include <llarp/util/buffer.hpp>
 #include <llarp/tooling/path_event.hpp>
 #include <llarp/link/link_manager.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 
 namespace llarp
@@ -19,6 +23,12 @@ namespace llarp
   namespace
   {
     auto log_path = log::Cat("path");
+
+    metrics::Counter buildsSucceeded{
+        "lokinet_path_builds_succeeded_total", "Paths of ours that got built"};
+    metrics::Histogram buildLatency{
+        "lokinet_path_build_latency_milliseconds",
+        "How long the paths of ours that got built took to build"};
   }
 
   struct AsyncPathKeyExchangeContext : std::enable_shared_from_this<AsyncPathKeyExchangeContext>
@@ -32,14 +42,18 @@ namespace llarp
     using Handler = std::function<void(std::shared_ptr<AsyncPathKeyExchangeContext>)>;
 
     Handler result;
-    size_t idx = 0;
+    /// hops whose keys are still being made; the one that takes it to zero hands off the result
+    std::atomic<size_t> pending{0};
+    std::atomic<bool> failed{false};
     AbstractRouter* router = nullptr;
     WorkerFunc_t work;
     EventLoop_ptr loop;
     LR_CommitMessage LRCM;
 
-    void
-    GenerateNextKey()
+    /// makes one hop's keys and its commit record; the hops only touch their own frame and the
+    /// rcs of the next hop, so they all run at once
+    bool
+    GenerateKey(size_t idx)
     {
       // current hop
       auto& hop = path->hops[idx];
@@ -54,13 +68,12 @@ namespace llarp
       if (!crypto->dh_client(hop.shared, hop.rc.enckey, hop.commkey, hop.nonce))
       {
         LogError(pathset->Name(), " Failed to generate shared key for path build");
-        return;
+        return false;
       }
       // generate nonceXOR valueself->hop->pathKey
       crypto->shorthash(hop.nonceXOR, llarp_buffer_t(hop.shared));
-      ++idx;
 
-      bool isFarthestHop = idx == path->hops.size();
+      const bool isFarthestHop = idx + 1 == path->hops.size();
 
       LR_CommitRecord record;
       if (isFarthestHop)
@@ -69,8 +82,8 @@ namespace llarp
       }
       else
       {
-        hop.upstream = path->hops[idx].rc.pubkey;
-        record.nextRC = std::make_unique<RouterContact>(path->hops[idx].rc);
+        hop.upstream = path->hops[idx + 1].rc.pubkey;
+        record.nextRC = std::make_unique<RouterContact>(path->hops[idx + 1].rc);
       }
       // build record
       record.lifetime = path::default_lifetime;
@@ -89,7 +102,7 @@ namespace llarp
         // failed to encode?
         LogError(pathset->Name(), " Failed to generate Commit Record");
         DumpBuffer(buf);
-        return;
+        return false;
       }
       // use ephemeral keypair for frame
       SecretKey framekey;
@@ -97,23 +110,24 @@ namespace llarp
       if (!frame.EncryptInPlace(framekey, hop.rc.enckey))
       {
         LogError(pathset->Name(), " Failed to encrypt LRCR");
-        return;
+        return false;
       }
+      return true;
+    }
 
-      if (isFarthestHop)
-      {
-        // farthest hop
-        // TODO: encrypt junk frames because our public keys are not eligator
-        loop->call([self = shared_from_this()] {
-          self->result(self);
-          self->result = nullptr;
-        });
-      }
-      else
-      {
-        // next hop
-        work([self = shared_from_this()] { self->GenerateNextKey(); });
-      }
+    void
+    GenerateKeyJob(size_t idx)
+    {
+      if (not GenerateKey(idx))
+        failed = true;
+      // the last hop done sees every other hop's writes through the acq_rel decrement
+      if (pending.fetch_sub(1, std::memory_order_acq_rel) != 1 or failed)
+        return;
+      // TODO: encrypt junk frames because our public keys are not eligator
+      loop->call([self = shared_from_this()] {
+        self->result(self);
+        self->result = nullptr;
+      });
     }
 
     /// Generate all keys asynchronously and call handler when done
@@ -125,11 +139,15 @@ namespace llarp
       result = func;
       work = worker;
 
-      for (size_t i = 0; i < path::max_len; ++i)
+      const size_t numHops = path->hops.size();
+      // the frames we fill in get overwritten, only the junk ones need randomising
+      for (size_t i = numHops; i < path::max_len; ++i)
       {
         LRCM.frames[i].Randomize();
       }
-      work([self = shared_from_this()] { self->GenerateNextKey(); });
+      pending = numHops;
+      for (size_t i = 0; i < numHops; ++i)
+        work([self = shared_from_this(), i] { self->GenerateKeyJob(i); });
     }
   };
 
@@ -185,7 +203,12 @@ namespace llarp
     }
 
     Builder::Builder(AbstractRouter* p_router, size_t pathNum, size_t hops)
-        : path::PathSet{pathNum}, _run{true}, m_router{p_router}, numHops{hops}
+        : path::PathSet{pathNum}
+        , _run{true}
+        , m_router{p_router}
+        , numHops{hops}
+        , minDesiredPaths{pathNum}
+        , maxDesiredPaths{pathNum}
     {
       CryptoManager::instance()->encryption_keygen(enckey);
     }
@@ -208,6 +231,8 @@ namespace llarp
       if (ShouldBuildMore(now))
         BuildOne();
       TickPaths(m_router);
+      TickPathPool(now);
+      AdaptDesiredPaths(now);
       if (m_BuildStats.attempts > 50)
       {
         if (m_BuildStats.SuccessRatio() <= BuildStats::MinGoodRatio && now - m_LastWarn > 5s)
@@ -223,8 +248,11 @@ namespace llarp
     {
       util::StatusObject obj{
           {"buildStats", m_BuildStats.ExtractStatus()},
+          {"buildLatency", m_BuildLatency.ExtractStatus()},
           {"numHops", uint64_t{numHops}},
-          {"numPaths", uint64_t{numDesiredPaths}}};
+          {"numPaths", uint64_t{numDesiredPaths}},
+          {"pathPoolSize", uint64_t{pathPoolSize}},
+          {"pooledPaths", uint64_t{m_PathPool.size()}}};
       std::transform(
           m_Paths.begin(),
           m_Paths.end(),
@@ -236,10 +264,12 @@ namespace llarp
     std::optional<RouterContact>
     Builder::SelectFirstHop(const std::set<RouterID>& exclude) const
     {
-      std::optional<RouterContact> found = std::nullopt;
+      // we have real rtts for these from our links, so no guessing
+      const size_t wanted = PickAtRandom() ? 1 : LATENCY_CANDIDATES;
+      std::vector<std::pair<RouterContact, llarp_time_t>> candidates;
       m_router->ForEachPeer(
           [&](const ILinkSession* s, bool isOutbound) {
-            if (s && s->IsEstablished() && isOutbound && not found.has_value())
+            if (s && s->IsEstablished() && isOutbound && candidates.size() < wanted)
             {
               const RouterContact rc = s->GetRemoteRC();
 #ifndef TESTNET
@@ -255,20 +285,72 @@ namespace llarp
               if (m_router->routerProfiling().IsBadForPath(rc.pubkey))
                 return;
 
-              found = rc;
+              // a session too new to have measured its rtt goes by what we remember of the router,
+              // which after a restart is from the performance record of the last run
+              const auto rtt = s->GetSessionStats().smoothedRTT;
+              candidates.emplace_back(
+                  rc,
+                  rtt > 0s
+                      ? rtt
+                      : m_router->routerProfiling().GetRTT(rc.pubkey).value_or(UNKNOWN_HOP_RTT));
             }
           },
           true);
-      return found;
+      if (candidates.empty())
+        return std::nullopt;
+      return std::min_element(
+                 candidates.begin(),
+                 candidates.end(),
+                 [](const auto& a, const auto& b) { return a.second < b.second; })
+          ->first;
+    }
+
+    bool
+    Builder::PickAtRandom() const
+    {
+      const auto& pathConfig = m_router->GetConfig()->paths;
+      if (not pathConfig.m_LatencyAware)
+        return true;
+      CSRNG rng{};
+      return std::uniform_int_distribution<int>{0, 99}(rng) < pathConfig.m_LatencyRandomness;
+    }
+
+    std::optional<RouterContact>
+    Builder::SelectHop(std::function<bool(const RouterContact&)> filter) const
+    {
+      if (PickAtRandom())
+        return m_router->nodedb()->GetRandom(filter);
+      std::vector<std::pair<RouterContact, llarp_time_t>> candidates;
+      auto& profiling = m_router->routerProfiling();
+      // GetRandom visits in random order, so this gathers the first few random matches
+      m_router->nodedb()->GetRandom([&](const auto& rc) -> bool {
+        if (not filter(rc))
+          return false;
+        for (const auto& [seen, rtt] : candidates)
+        {
+          if (seen.pubkey == rc.pubkey)
+            return false;
+        }
+        candidates.emplace_back(rc, profiling.GetRTT(rc.pubkey).value_or(UNKNOWN_HOP_RTT));
+        return candidates.size() >= LATENCY_CANDIDATES;
+      });
+      if (candidates.empty())
+        return std::nullopt;
+      return std::min_element(
+                 candidates.begin(),
+                 candidates.end(),
+                 [](const auto& a, const auto& b) { return a.second < b.second; })
+          ->first;
     }
 
     std::optional<std::vector<RouterContact>>
     Builder::GetHopsForBuild()
     {
       auto filter = [r = m_router](const auto& rc) -> bool {
-        return not r->routerProfiling().IsBadForPath(rc.pubkey, 1);
+        return not r->routerProfiling().IsBadForPath(rc.pubkey, 1)
+            and not r->outboundSessionMaker().IsRecentlyFailed(rc.pubkey);
       };
-      if (const auto maybe = m_router->nodedb()->GetRandom(filter))
+      if (const auto maybe = SelectHop(filter))
       {
         return GetHopsAlignedToForBuild(maybe->pubkey);
       }
@@ -285,6 +367,9 @@ namespace llarp
       {
         item.second->EnterState(ePathIgnore, now);
       }
+      for (auto& path : m_PathPool)
+        path->EnterState(ePathIgnore, now);
+      m_PathPool.clear();
       return true;
     }
 
@@ -384,6 +469,8 @@ namespace llarp
 
             if (r->routerProfiling().IsBadForPath(rc.pubkey, 1))
               return false;
+            if (r->outboundSessionMaker().IsRecentlyFailed(rc.pubkey))
+              return false;
             for (const auto& hop : hopsSet)
             {
               if (hop.pubkey == rc.pubkey)
@@ -398,7 +485,7 @@ namespace llarp
             return rc.pubkey != endpointRC.pubkey;
           };
 
-          if (const auto maybe = m_router->nodedb()->GetRandom(filter))
+          if (const auto maybe = SelectHop(filter))
             hops.emplace_back(*maybe);
           else
             return std::nullopt;
@@ -410,6 +497,12 @@ namespace llarp
     bool
     Builder::BuildOneAlignedTo(const RouterID remote)
     {
+      if (auto path = TakePooledPath(remote))
+      {
+        LogInfo(Name(), " using pooled path ", path->ShortName(), " to ", remote);
+        AdoptPath(std::move(path));
+        return true;
+      }
       if (const auto maybe = GetHopsAlignedToForBuild(remote); maybe.has_value())
       {
         LogInfo(Name(), " building path to ", remote);
@@ -427,6 +520,12 @@ namespace llarp
 
     void
     Builder::Build(std::vector<RouterContact> hops, PathRole roles)
+    {
+      StartBuild(std::move(hops), roles, false);
+    }
+
+    void
+    Builder::StartBuild(std::vector<RouterContact> hops, PathRole roles, bool pooled)
     {
       if (IsStopped())
         return;
@@ -445,24 +544,160 @@ namespace llarp
       std::string path_shortName = "[path " + m_router->ShortName() + "-";
       path_shortName = path_shortName + std::to_string(m_router->NextPathBuildNumber()) + "]";
       auto path = std::make_shared<path::Path>(hops, GetWeak(), roles, std::move(path_shortName));
+      path->latencyProbeInterval = m_router->GetConfig()->paths.m_LatencyProbeInterval;
       LogInfo(Name(), " build ", path->ShortName(), ": ", path->HopsString());
 
-      path->SetBuildResultHook([self](Path_ptr p) { self->HandlePathBuilt(p); });
+      if (pooled)
+        m_PathPool.push_back(path);
+
+      // self keeps this alive
+      path->SetBuildResultHook([self, this](Path_ptr p) {
+        PathBuildSucceeded(p);
+        if (not IsPooled(p))
+          self->HandlePathBuilt(p);
+      });
       ctx->AsyncGenerateKeys(
           path,
           m_router->loop(),
-          [r = m_router](auto func) { r->QueueWork(std::move(func)); },
+          [r = m_router](auto func) {
+            r->QueueWork(std::move(func), thread::WorkClass::PathBuild);
+          },
           &PathBuilderKeysGenerated);
     }
 
     void
-    Builder::HandlePathBuilt(Path_ptr p)
+    Builder::PathBuildSucceeded(Path_ptr p)
     {
       buildIntervalLimit = PATH_BUILD_RATE;
       m_router->routerProfiling().MarkPathSuccess(p.get());
 
       LogInfo(p->Name(), " built latency=", ToString(p->intro.latency));
       m_BuildStats.success++;
+
+      const auto buildTime = m_router->Now() - p->buildStarted;
+      m_BuildLatency.Record(buildTime.count());
+      buildsSucceeded.Inc();
+      buildLatency.Record(buildTime.count());
+      m_router->NotifyRouterEvent<tooling::PathBuildCompletedEvent>(
+          m_router->pubkey(), p->RXID(), p->hops.size(), buildTime);
+    }
+
+    void
+    Builder::HandlePathBuilt(Path_ptr)
+    {}
+
+    void
+    Builder::TickPathPool(llarp_time_t now)
+    {
+      // a path handed out should have at least min_intro_lifetime left in it, and a dead one
+      // never comes back as far as the pool is concerned
+      auto itr = m_PathPool.begin();
+      while (itr != m_PathPool.end())
+      {
+        auto& path = *itr;
+        const auto st = path->Status();
+        if (st == ePathFailed or st == ePathTimeout or st == ePathExpired or path->Expired(now)
+            or (st == ePathEstablished and path->ExpiresSoon(now, min_intro_lifetime)))
+        {
+          LogDebug(Name(), " dropping pooled path ", path->ShortName());
+          path->EnterState(ePathIgnore, now);
+          itr = m_PathPool.erase(itr);
+          continue;
+        }
+        path->Tick(now, m_router);
+        ++itr;
+      }
+      // the paths we need come first
+      if (m_PathPool.size() >= pathPoolSize or IsStopped() or BuildCooldownHit(now)
+          or PathSet::ShouldBuildMore(now))
+        return;
+      if (const auto maybe = GetHopsForBuild())
+        StartBuild(*maybe, ePathRoleAny, true);
+    }
+
+    void
+    Builder::AdaptDesiredPaths(llarp_time_t now)
+    {
+      const auto ceiling = std::max(minDesiredPaths, maxDesiredPaths);
+      numDesiredPaths = std::clamp(numDesiredPaths, minDesiredPaths, ceiling);
+      if (ceiling == minDesiredPaths)
+        return;
+      // the paths have just ticked, so what they carried is over the tick that just ended
+      ForEachPath([this](const Path_ptr& path) {
+        if (not path->IsReady())
+          return;
+        m_LoadBytes += path->LastTickBytes();
+        ++m_LoadPathTicks;
+      });
+      ++m_LoadTicks;
+      if (m_LoadSince == 0s)
+        m_LoadSince = now;
+      if (now < m_LoadSince + load_interval)
+        return;
+      if (m_LoadPathTicks > 0)
+      {
+        const double seconds = std::chrono::duration<double>(now - m_LoadSince).count();
+        const double paths = static_cast<double>(m_LoadPathTicks) / m_LoadTicks;
+        const double perPath = m_LoadBytes / seconds / paths;
+        if (perPath > busy_path_rate and numDesiredPaths < ceiling)
+        {
+          ++numDesiredPaths;
+          LogDebug(Name(), " paths are busy, now keeping ", numDesiredPaths);
+        }
+        else if (perPath < idle_path_rate and numDesiredPaths > minDesiredPaths)
+        {
+          // the ones we don't want any more go when they expire, rather than being torn down
+          --numDesiredPaths;
+          LogDebug(Name(), " paths are idle, now keeping ", numDesiredPaths);
+        }
+      }
+      m_LoadSince = now;
+      m_LoadBytes = 0;
+      m_LoadPathTicks = 0;
+      m_LoadTicks = 0;
+    }
+
+    bool
+    Builder::HasPooledPath(const RouterID& endpoint) const
+    {
+      return std::any_of(m_PathPool.begin(), m_PathPool.end(), [&endpoint](const auto& path) {
+        return path->IsReady() and path->Endpoint() == endpoint;
+      });
+    }
+
+    Path_ptr
+    Builder::TakePooledPath(const RouterID& endpoint)
+    {
+      auto itr = std::find_if(m_PathPool.begin(), m_PathPool.end(), [&endpoint](const auto& path) {
+        return path->IsReady() and path->Endpoint() == endpoint;
+      });
+      if (itr == m_PathPool.end())
+        return nullptr;
+      auto path = std::move(*itr);
+      m_PathPool.erase(itr);
+      return path;
+    }
+
+    void
+    Builder::AdoptPath(Path_ptr p)
+    {
+      p->m_PathSet = GetWeak();
+      AddPath(p);
+      HandlePathBuilt(p);
+    }
+
+    void
+    Builder::AddPath(Path_ptr p)
+    {
+      // pooled paths stay out of m_Paths, so nothing picks them for traffic until taken
+      if (not IsPooled(p))
+        PathSet::AddPath(std::move(p));
+    }
+
+    bool
+    Builder::IsPooled(const Path_ptr& p) const
+    {
+      return std::find(m_PathPool.begin(), m_PathPool.end(), p) != m_PathPool.end();
     }
 
     void
@@ -3,8 +3,11 @@
 #include "pathset.hpp"
 #include <llarp/util/status.hpp>
 #include <llarp/util/decaying_hashset.hpp>
+#include <llarp/util/histogram.hpp>
 
 #include <atomic>
+#include <functional>
+#include <optional>
 #include <set>
 
 namespace llarp
@@ -14,6 +17,11 @@ namespace llarp
     // milliseconds waiting between builds on a path per router
     static constexpr auto MIN_PATH_BUILD_INTERVAL = 500ms;
     static constexpr auto PATH_BUILD_RATE = 100ms;
+    /// how many random candidates latency aware selection picks the fastest of; more means
+    /// faster paths but more predictable ones
+    static constexpr size_t LATENCY_CANDIDATES = 4;
+    /// what latency aware selection takes a router we have no rtt estimate for to have
+    static constexpr auto UNKNOWN_HOP_RTT = 250ms;
 
     /// limiter for path builds
     /// prevents overload and such
@@ -52,16 +60,63 @@ namespace llarp
       bool
       BuildCooldownHit(RouterID edge) const;
 
+      /// pick a random router that passes filter.  in latency aware mode, unless a coin toss
+      /// with the configured randomness says otherwise, it's the one with the lowest rtt
+      /// estimate out of a few random candidates.
+      std::optional<RouterContact>
+      SelectHop(std::function<bool(const RouterContact&)> filter) const;
+
+      /// should this pick ignore latency, in latency aware mode or not
+      bool
+      PickAtRandom() const;
+
      private:
       void
       DoPathBuildBackoff();
 
+      void
+      StartBuild(std::vector<RouterContact> hops, PathRole roles, bool pooled);
+
+      /// a path we built, pooled or not, is established
+      void
+      PathBuildSucceeded(Path_ptr p);
+
+      /// keep the pool's paths alive, drop the ones that are no use any more and build one more
+      /// if we are short
+      void
+      TickPathPool(llarp_time_t now);
+
+      /// moves numDesiredPaths by one towards maxDesiredPaths or minDesiredPaths each
+      /// load_interval that our established paths were busy or idle over
+      void
+      AdaptDesiredPaths(llarp_time_t now);
+
+      /// what our established paths carried since m_LoadSince, and how many there were summed
+      /// over the ticks since
+      llarp_time_t m_LoadSince = 0s;
+      uint64_t m_LoadBytes = 0;
+      uint64_t m_LoadPathTicks = 0;
+      uint64_t m_LoadTicks = 0;
+
+      /// established paths built ahead of time that nothing has asked for yet; they are not in
+      /// m_Paths until someone takes one
+      std::vector<Path_ptr> m_PathPool;
+
+      /// how long our successful builds took, in ms, for telling if path build changes helped
+      util::Histogram m_BuildLatency;
+
      public:
       AbstractRouter* const m_router;
       SecretKey enckey;
       size_t numHops;
       llarp_time_t lastBuild = 0s;
       llarp_time_t buildIntervalLimit = MIN_PATH_BUILD_INTERVAL;
+      /// how many spare paths to keep built ahead of time, on top of numDesiredPaths
+      size_t pathPoolSize = 0;
+      /// fewest and most paths numDesiredPaths moves between with how busy our paths are; it
+      /// stays put while they are the same
+      size_t minDesiredPaths;
+      size_t maxDesiredPaths;
 
       /// construct
       Builder(AbstractRouter* p_router, size_t numDesiredPaths, size_t numHops);
@@ -135,6 +190,25 @@ namespace llarp
       void
       ManualRebuild(size_t N, PathRole roles = ePathRoleAny);
 
+      /// return true if we have a pooled path ready that ends at endpoint
+      bool
+      HasPooledPath(const RouterID& endpoint) const;
+
+      /// take a ready pooled path ending at endpoint out of the pool, for some path set to
+      /// AdoptPath; nullptr if we have none
+      Path_ptr
+      TakePooledPath(const RouterID& endpoint);
+
+      /// make an established path taken from a pool one of ours
+      void
+      AdoptPath(Path_ptr p);
+
+      void
+      AddPath(Path_ptr p) override;
+
+      bool
+      IsPooled(const Path_ptr& p) const override;
+
       virtual const SecretKey&
       GetTunnelEncryptionSecretKey() const;
 
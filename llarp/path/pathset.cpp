@@ -4,13 +4,25 @@
 #include "path.hpp"
 #include <llarp/routing/dht_message.hpp>
 #include <llarp/router/abstractrouter.hpp>
+#include <llarp/util/metrics.hpp>
 
+#include <algorithm>
 #include <random>
 
 namespace llarp
 {
   namespace path
   {
+    namespace
+    {
+      metrics::Counter buildsStarted{
+          "lokinet_path_builds_total", "Paths of ours we set out to build"};
+      metrics::Counter buildsTimedOut{
+          "lokinet_path_builds_timed_out_total", "Path builds of ours that timed out"};
+      metrics::Counter buildsFailed{
+          "lokinet_path_builds_failed_total", "Path builds of ours that a hop refused"};
+    }  // namespace
+
     PathSet::PathSet(size_t num) : numDesiredPaths(num)
     {}
 
@@ -120,9 +132,7 @@ namespace llarp
     {
       Lock_t l{m_PathsMutex};
       Path_ptr path = nullptr;
-      AlignedBuffer<32> dist;
-      AlignedBuffer<32> to = id;
-      dist.Fill(0xff);
+      const AlignedBuffer<32> to = id;
       for (const auto& item : m_Paths)
       {
         if (!item.second->IsReady())
@@ -131,12 +141,11 @@ namespace llarp
           continue;
         if (excluding.count(item.second->Endpoint()))
           continue;
-        AlignedBuffer<32> localDist = item.second->Endpoint() ^ to;
-        if (localDist < dist)
-        {
-          dist = localDist;
+        const auto& endpoint = item.second->Endpoint();
+        // of paths to the same router, the best scoring one
+        if (not path or to.XorCloser(endpoint, path->Endpoint())
+            or (endpoint == path->Endpoint() and item.second->Score() < path->Score()))
           path = item.second;
-        }
       }
       return path;
     }
@@ -185,8 +194,7 @@ namespace llarp
           {
             if (chosen == nullptr)
               chosen = itr->second;
-            else if (
-                chosen->intro.latency != 0s and chosen->intro.latency > itr->second->intro.latency)
+            else if (chosen->Score() > itr->second->Score())
               chosen = itr->second;
           }
         }
@@ -329,11 +337,35 @@ namespace llarp
       return intros;
     }
 
+    std::vector<service::Introduction>
+    PathSet::GetIntroductionsByScore(
+        std::function<bool(const service::Introduction&)> filter) const
+    {
+      std::vector<std::pair<double, service::Introduction>> scored;
+      {
+        Lock_t l{m_PathsMutex};
+        for (const auto& item : m_Paths)
+        {
+          if (item.second->IsReady() and filter(item.second->intro))
+            scored.emplace_back(item.second->Score(), item.second->intro);
+        }
+      }
+      std::sort(scored.begin(), scored.end(), [](const auto& left, const auto& right) {
+        return left.first < right.first;
+      });
+      std::vector<service::Introduction> intros;
+      intros.reserve(scored.size());
+      for (auto& item : scored)
+        intros.emplace_back(std::move(item.second));
+      return intros;
+    }
+
     void
     PathSet::HandlePathBuildTimeout(Path_ptr p)
     {
       LogWarn(Name(), " path build ", p->ShortName(), " timed out");
       m_BuildStats.timeouts++;
+      buildsTimedOut.Inc();
     }
 
     void
@@ -341,6 +373,7 @@ namespace llarp
     {
       LogWarn(Name(), " path build ", p->ShortName(), " failed at ", hop);
       m_BuildStats.fails++;
+      buildsFailed.Inc();
     }
 
     void
@@ -354,6 +387,7 @@ namespace llarp
     {
       LogInfo(Name(), " path build ", p->ShortName(), " started");
       m_BuildStats.attempts++;
+      buildsStarted.Inc();
     }
 
     util::StatusObject
@@ -436,14 +470,10 @@ namespace llarp
         ++itr;
       }
       Path_ptr chosen = nullptr;
-      llarp_time_t minLatency = 30s;
       for (const auto& path : established)
       {
-        if (path->intro.latency < minLatency and path->intro.latency != 0s)
-        {
-          minLatency = path->intro.latency;
+        if (chosen == nullptr or path->Score() < chosen->Score())
           chosen = path;
-        }
       }
       return chosen;
     }
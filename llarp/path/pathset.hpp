@@ -149,9 +149,17 @@ namespace llarp
       bool
       GetNewestIntro(service::Introduction& intro) const;
 
-      void
+      virtual void
       AddPath(Path_ptr path);
 
+      /// return true if path is being kept warm for later use rather than being one of our
+      /// paths in use
+      virtual bool
+      IsPooled(const Path_ptr&) const
+      {
+        return false;
+      }
+
       Path_ptr
       GetByUpstream(RouterID remote, PathID_t rxid) const;
 
@@ -267,6 +275,10 @@ namespace llarp
       GetCurrentIntroductionsWithFilter(
           std::function<bool(const service::Introduction&)> filter) const;
 
+      /// the intros of our ready paths that pass filter, from the best scoring path down
+      std::vector<service::Introduction>
+      GetIntroductionsByScore(std::function<bool(const service::Introduction&)> filter) const;
+
       virtual bool
       PublishIntroSet(const service::EncryptedIntroSet&, AbstractRouter*)
       {
@@ -1,5 +1,6 @@
 #include "path.hpp"
 
+#include <llarp/crypto/fast_crypto.hpp>
 #include <llarp/dht/context.hpp>
 #include <llarp/exit/context.hpp>
 #include <llarp/exit/exit_messages.hpp>
@@ -10,10 +11,13 @@
 #include "path_context.hpp"
 #include "transit_hop.hpp"
 #include <llarp/router/abstractrouter.hpp>
+#include <llarp/routing/bundle_message.hpp>
 #include <llarp/routing/path_latency_message.hpp>
 #include <llarp/routing/path_transfer_message.hpp>
 #include <llarp/routing/handler.hpp>
 #include <llarp/util/buffer.hpp>
+#include <llarp/util/metrics.hpp>
+#include <llarp/util/trace.hpp>
 
 #include <oxenc/endian.h>
 
@@ -21,6 +25,22 @@ namespace llarp
 {
   namespace path
   {
+    namespace
+    {
+      metrics::Gauge transitHops{"lokinet_path_transit_hops", "Paths we are a hop on"};
+      metrics::Counter relayedUpstream{
+          "lokinet_path_relayed_upstream_total", "Messages we relayed upstream on transit hops"};
+      metrics::Counter relayedUpstreamBytes{
+          "lokinet_path_relayed_upstream_bytes_total",
+          "Bytes of the messages we relayed upstream on transit hops"};
+      metrics::Counter relayedDownstream{
+          "lokinet_path_relayed_downstream_total",
+          "Messages we relayed downstream on transit hops"};
+      metrics::Counter relayedDownstreamBytes{
+          "lokinet_path_relayed_downstream_bytes_total",
+          "Bytes of the messages we relayed downstream on transit hops"};
+    }  // namespace
+
     std::string
     TransitHopInfo::ToString() const
     {
@@ -32,15 +52,14 @@ namespace llarp
           downstream);
     }
 
-    TransitHop::TransitHop()
-        : IHopHandler{}
-        , m_UpstreamGather{transit_hop_queue_size}
-        , m_DownstreamGather{transit_hop_queue_size}
+    TransitHop::TransitHop() : IHopHandler{}
+    {
+      transitHops.Add(1);
+    }
+
+    TransitHop::~TransitHop()
     {
-      m_UpstreamGather.enable();
-      m_DownstreamGather.enable();
-      m_UpstreamWorkCounter = 0;
-      m_DownstreamWorkCounter = 0;
+      transitHops.Add(-1);
     }
 
     bool
@@ -55,11 +74,11 @@ namespace llarp
       return started + lifetime;
     }
 
-    bool
+    std::function<void()>
     TransitHop::HandleLRSM(
         uint64_t status, std::array<EncryptedFrame, 8>& frames, AbstractRouter* r)
     {
-      auto msg = std::make_shared<LR_StatusMessage>(frames);
+      auto msg = std::make_shared<LR_StatusMessage>(std::move(frames));
       msg->status = status;
       msg->pathid = info.rxID;
 
@@ -68,8 +87,10 @@ namespace llarp
       const uint64_t ourStatus = LR_StatusRecord::SUCCESS;
 
       msg->AddFrame(pathKey, ourStatus);
-      LR_StatusMessage::QueueSendMessage(r, info.downstream, msg, shared_from_this());
-      return true;
+      // sent with the rest of its batch, which pumps once it is done
+      return [r, downstream = info.downstream, msg = std::move(msg), self = shared_from_this()] {
+        LR_StatusMessage::SendMessage(r, downstream, msg, self);
+      };
     }
 
     TransitHopInfo::TransitHopInfo(const RouterID& down, const LR_CommitRecord& record)
@@ -86,7 +107,8 @@ namespace llarp
       llarp_buffer_t buf(tmp);
       if (!msg.BEncode(&buf))
       {
-        llarp::LogError("failed to encode routing message");
+        static logging::RateLimit limit{1s};
+        llarp::LogErrorLimited(limit, "failed to encode routing message");
         return false;
       }
       TunnelNonce N;
@@ -98,86 +120,55 @@ namespace llarp
       {
         dlt = pad_size - dlt;
         // randomize padding
-        CryptoManager::instance()->randbytes(buf.cur, dlt);
+        fast_crypto::randbytes(buf.cur, dlt);
         buf.sz += dlt;
       }
       buf.cur = buf.base;
-      return HandleDownstream(buf, N, r);
+      return HandleDownstream(buf, N, r, msg.priority);
     }
 
     void
     TransitHop::DownstreamWork(TrafficQueue_t msgs, AbstractRouter* r)
     {
-      auto flushIt = [self = shared_from_this(), r]() {
-        std::vector<RelayDownstreamMessage> msgs;
-        while (auto maybe = self->m_DownstreamGather.tryPopFront())
-        {
-          msgs.push_back(*maybe);
-        }
-        self->HandleAllDownstream(std::move(msgs), r);
-      };
-      for (auto& ev : msgs)
+      for (auto& [payload, nonce, priority] : msgs)
       {
-        RelayDownstreamMessage msg;
-        const llarp_buffer_t buf(ev.first);
-        msg.pathid = info.rxID;
-        msg.Y = ev.second ^ nonceXOR;
-        CryptoManager::instance()->xchacha20(buf, pathKey, ev.second);
-        msg.X = buf;
-        llarp::LogDebug(
-            "relay ",
-            msg.X.size(),
-            " bytes downstream from ",
-            info.upstream,
-            " to ",
-            info.downstream);
-        if (m_DownstreamGather.full())
-        {
-          r->loop()->call(flushIt);
-        }
-        if (m_DownstreamGather.enabled())
-          m_DownstreamGather.pushBack(msg);
+        fast_crypto::xchacha20(llarp_buffer_t{payload}, pathKey, nonce);
+        nonce ^= nonceXOR;
       }
-      r->loop()->call(flushIt);
+      r->loop()->call([self = shared_from_this(), data = std::move(msgs), r]() mutable {
+        self->HandleAllDownstream(std::move(data), r);
+      });
     }
 
     void
     TransitHop::UpstreamWork(TrafficQueue_t msgs, AbstractRouter* r)
     {
-      for (auto& ev : msgs)
+      for (auto& [payload, nonce, priority] : msgs)
       {
-        const llarp_buffer_t buf(ev.first);
-        RelayUpstreamMessage msg;
-        CryptoManager::instance()->xchacha20(buf, pathKey, ev.second);
-        msg.pathid = info.txID;
-        msg.Y = ev.second ^ nonceXOR;
-        msg.X = buf;
-        if (m_UpstreamGather.tryPushBack(msg) != thread::QueueReturn::Success)
-          break;
+        fast_crypto::xchacha20(llarp_buffer_t{payload}, pathKey, nonce);
+        nonce ^= nonceXOR;
       }
-
-      // Flush it:
-      r->loop()->call([self = shared_from_this(), r] {
-        std::vector<RelayUpstreamMessage> msgs;
-        while (auto maybe = self->m_UpstreamGather.tryPopFront())
-        {
-          msgs.push_back(*maybe);
-        }
-        self->HandleAllUpstream(std::move(msgs), r);
+      r->loop()->call([self = shared_from_this(), data = std::move(msgs), r]() mutable {
+        self->HandleAllUpstream(std::move(data), r);
       });
     }
 
     void
-    TransitHop::HandleAllUpstream(std::vector<RelayUpstreamMessage> msgs, AbstractRouter* r)
+    TransitHop::HandleAllUpstream(TrafficQueue_t msgs, AbstractRouter* r)
     {
+      if (m_Stopped)
+      {
+        ReleaseTraffic(msgs);
+        return;
+      }
       if (IsEndpoint(r->pubkey()))
       {
-        for (const auto& msg : msgs)
+        for (auto& [payload, nonce, priority] : msgs)
         {
-          const llarp_buffer_t buf(msg.X);
-          if (!r->ParseRoutingMessageBuffer(buf, this, info.rxID))
+          if (!r->ParseRoutingMessageBuffer(llarp_buffer_t{payload}, this, info.rxID))
           {
-            LogWarn("invalid upstream data on endpoint ", info);
+            static logging::RateLimit limit{1s};
+            LogWarnLimited(limit, "invalid upstream data on endpoint ", info);
           }
           m_LastActivity = r->Now();
         }
@@ -190,35 +181,69 @@ namespace llarp
       }
       else
       {
-        for (const auto& msg : msgs)
+        RelayUpstreamMessage msg;
+        msg.pathid = info.txID;
+        for (const auto& [payload, nonce, priority] : msgs)
         {
           llarp::LogDebug(
               "relay ",
-              msg.X.size(),
+              payload.size(),
               " bytes upstream from ",
               info.downstream,
               " to ",
               info.upstream);
+          // the message only borrows the payload; it is encoded before SendToOrQueue returns
+          msg.X = byte_view_t{payload.data(), payload.size()};
+          msg.Y = nonce;
+          msg.priority = priority;
           r->SendToOrQueue(info.upstream, msg);
+          LLARP_TRACE(
+              transit_upstream,
+              trace::ID(info.rxID),
+              trace::ID(info.txID),
+              trace::ID(nonce),
+              payload.size());
+          relayedUpstreamBytes.Inc(payload.size());
         }
+        relayedUpstream.Inc(msgs.size());
       }
+      ReleaseTraffic(msgs);
       r->TriggerPump();
     }
 
     void
-    TransitHop::HandleAllDownstream(std::vector<RelayDownstreamMessage> msgs, AbstractRouter* r)
+    TransitHop::HandleAllDownstream(TrafficQueue_t msgs, AbstractRouter* r)
     {
-      for (const auto& msg : msgs)
+      if (m_Stopped)
+      {
+        ReleaseTraffic(msgs);
+        return;
+      }
+      RelayDownstreamMessage msg;
+      msg.pathid = info.rxID;
+      for (const auto& [payload, nonce, priority] : msgs)
       {
         llarp::LogDebug(
             "relay ",
-            msg.X.size(),
+            payload.size(),
             " bytes downstream from ",
             info.upstream,
             " to ",
             info.downstream);
+        msg.X = byte_view_t{payload.data(), payload.size()};
+        msg.Y = nonce;
+        msg.priority = priority;
         r->SendToOrQueue(info.downstream, msg);
+        LLARP_TRACE(
+            transit_downstream,
+            trace::ID(info.txID),
+            trace::ID(info.rxID),
+            trace::ID(nonce),
+            payload.size());
+        relayedDownstreamBytes.Inc(payload.size());
       }
+      relayedDownstream.Inc(msgs.size());
+      ReleaseTraffic(msgs);
       r->TriggerPump();
     }
 
@@ -227,20 +252,25 @@ namespace llarp
     {
       if (not m_UpstreamQueue.empty())
       {
-        r->QueueWork([self = shared_from_this(),
-                      data = std::exchange(m_UpstreamQueue, {}),
-                      r]() mutable { self->UpstreamWork(std::move(data), r); });
+        r->QueuePathWork(
+            std::hash<PathID_t>{}(info.rxID),
+            [self = shared_from_this(), data = TakeQueue(m_UpstreamQueue), r]() mutable {
+              self->UpstreamWork(std::move(data), r);
+            });
       }
     }
 
     void
     TransitHop::FlushDownstream(AbstractRouter* r)
     {
+      SendBundle(r);
       if (not m_DownstreamQueue.empty())
       {
-        r->QueueWork([self = shared_from_this(),
-                      data = std::exchange(m_DownstreamQueue, {}),
-                      r]() mutable { self->DownstreamWork(std::move(data), r); });
+        r->QueuePathWork(
+            std::hash<PathID_t>{}(info.rxID),
+            [self = shared_from_this(), data = TakeQueue(m_DownstreamQueue), r]() mutable {
+              self->DownstreamWork(std::move(data), r);
+            });
       }
     }
 
@@ -252,6 +282,20 @@ namespace llarp
       return r->dht()->impl->RelayRequestForPath(info.rxID, msg);
     }
 
+    bool
+    TransitHop::HandleBundleMessage(const routing::BundleMessage& msg, AbstractRouter*)
+    {
+      // we send bundles down paths, we never pass them on up one
+      if (not msg.messages.empty())
+      {
+        static logging::RateLimit limit{1s};
+        llarp::LogWarnLimited(limit, "unwarranted bundle message on ", info);
+        return false;
+      }
+      m_TakesBundles = true;
+      return true;
+    }
+
     bool
     TransitHop::HandlePathLatencyMessage(
         const llarp::routing::PathLatencyMessage& msg, AbstractRouter* r)
@@ -267,7 +311,8 @@ namespace llarp
         [[maybe_unused]] const llarp::routing::PathConfirmMessage& msg,
         [[maybe_unused]] AbstractRouter* r)
     {
-      llarp::LogWarn("unwarranted path confirm message on ", info);
+      static logging::RateLimit limit{1s};
+      llarp::LogWarnLimited(limit, "unwarranted path confirm message on ", info);
       return false;
     }
 
@@ -276,7 +321,8 @@ namespace llarp
         [[maybe_unused]] const llarp::routing::DataDiscardMessage& msg,
         [[maybe_unused]] AbstractRouter* r)
     {
-      llarp::LogWarn("unwarranted path data discard message on ", info);
+      static logging::RateLimit limit{1s};
+      llarp::LogWarnLimited(limit, "unwarranted path data discard message on ", info);
       return false;
     }
 
@@ -393,7 +439,7 @@ namespace llarp
       if (endpoint)
       {
         bool sent = true;
-        for (const auto& pkt : msg.X)
+        for (const auto& pkt : msg.receivedX)
         {
           // check short packet buffer
           if (pkt.size() <= 8)
@@ -406,7 +452,8 @@ namespace llarp
         return sent;
       }
 
-      llarp::LogError("No exit endpoint on ", info);
+      static logging::RateLimit limit{1s};
+      llarp::LogErrorLimited(limit, "No exit endpoint on ", info);
       // discarded
       llarp::routing::DataDiscardMessage discard(info.rxID, msg.S);
       return SendRoutingMessage(discard, r);
@@ -422,8 +469,8 @@ namespace llarp
       {
         return SendRoutingMessage(discarded, r);
       }
-      // send routing message
-      if (path->SendRoutingMessage(msg.T, r))
+      // send the frame on as it came, it is only decoded at the far end
+      if (path->SendTransfer(msg.encodedT, r))
       {
         m_FlushOthers.emplace(path);
         return true;
@@ -431,6 +478,53 @@ namespace llarp
       return SendRoutingMessage(discarded, r);
     }
 
+    bool
+    TransitHop::SendTransfer(byte_view_t frame, AbstractRouter* r)
+    {
+      using routing::BundleMessage;
+      constexpr auto room = BundleMessage::MaxSize - BundleMessage::Overhead;
+      if (not m_TakesBundles or frame.size() + BundleMessage::EntryOverhead > room)
+        return SendRoutingMessage(routing::EncodedMessage{frame}, r);
+      const auto bundled =
+          m_Bundle.size() + (m_BundleSizes.size() + 1) * BundleMessage::EntryOverhead;
+      if (bundled + frame.size() > room)
+        SendBundle(r);
+      m_Bundle.insert(m_Bundle.end(), frame.begin(), frame.end());
+      m_BundleSizes.push_back(frame.size());
+      return true;
+    }
+
+    void
+    TransitHop::SendBundle(AbstractRouter* r)
+    {
+      if (m_BundleSizes.empty())
+        return;
+      bool sent;
+      if (m_BundleSizes.size() == 1)
+        sent = SendRoutingMessage(
+            routing::EncodedMessage{byte_view_t{m_Bundle.data(), m_Bundle.size()}}, r);
+      else
+      {
+        routing::BundleMessage bundle;
+        bundle.messages.reserve(m_BundleSizes.size());
+        const byte_t* pos = m_Bundle.data();
+        for (const auto sz : m_BundleSizes)
+        {
+          bundle.messages.emplace_back(pos, sz);
+          pos += sz;
+        }
+        sent = SendRoutingMessage(bundle, r);
+      }
+      if (not sent)
+      {
+        static logging::RateLimit limit{1s};
+        llarp::LogWarnLimited(
+            limit, "failed to send ", m_BundleSizes.size(), " bundled frames down ", info);
+      }
+      m_Bundle.clear();
+      m_BundleSizes.clear();
+    }
+
     std::string
     TransitHop::ToString() const
     {
@@ -441,8 +535,7 @@ namespace llarp
     void
     TransitHop::Stop()
     {
-      m_UpstreamGather.disable();
-      m_DownstreamGather.disable();
+      m_Stopped = true;
     }
 
     void
@@ -454,7 +547,10 @@ namespace llarp
     void
     TransitHop::QueueDestroySelf(AbstractRouter* r)
     {
-      r->loop()->call([self = shared_from_this()] { self->SetSelfDestruct(); });
+      r->loop()->call([self = shared_from_this(), r] {
+        self->SetSelfDestruct();
+        r->pathContext().ScheduleTransitHopExpiry(self, 0s);
+      });
     }
   }  // namespace path
 }  // namespace llarp
@@ -6,7 +6,9 @@
 #include <llarp/routing/handler.hpp>
 #include <llarp/router_id.hpp>
 #include <llarp/util/compare_ptr.hpp>
-#include <llarp/util/thread/queue.hpp>
+#include <llarp/util/mem_account.hpp>
+
+#include <set>
 
 namespace llarp
 {
@@ -58,6 +60,8 @@ namespace llarp
     {
       TransitHop();
 
+      ~TransitHop() override;
+
       TransitHopInfo info;
       SharedSecret pathKey;
       ShortHash nonceXOR;
@@ -99,7 +103,7 @@ namespace llarp
         return m_LastActivity;
       }
 
-      bool
+      std::function<void()>
       HandleLRSM(
           uint64_t status, std::array<EncryptedFrame, 8>& frames, AbstractRouter* r) override;
 
@@ -173,6 +177,10 @@ namespace llarp
       bool
       HandleDHTMessage(const dht::IMessage& msg, AbstractRouter* r) override;
 
+      /// the empty bundle our path's owner sends to say we may bundle what we pass on to it
+      bool
+      HandleBundleMessage(const routing::BundleMessage& msg, AbstractRouter* r) override;
+
       void
       FlushUpstream(AbstractRouter* r) override;
 
@@ -190,20 +198,33 @@ namespace llarp
       DownstreamWork(TrafficQueue_t queue, AbstractRouter* r) override;
 
       void
-      HandleAllUpstream(std::vector<RelayUpstreamMessage> msgs, AbstractRouter* r) override;
+      HandleAllUpstream(TrafficQueue_t msgs, AbstractRouter* r) override;
 
       void
-      HandleAllDownstream(std::vector<RelayDownstreamMessage> msgs, AbstractRouter* r) override;
+      HandleAllDownstream(TrafficQueue_t msgs, AbstractRouter* r) override;
 
      private:
       void
       SetSelfDestruct();
 
+      /// sends a frame passed on to us for this path down it, bundled with the others passed on
+      /// before its next flush if the path's owner takes bundles, or else on its own
+      bool
+      SendTransfer(byte_view_t frame, AbstractRouter* r);
+
+      /// sends the frames SendTransfer has held back, as one message
+      void
+      SendBundle(AbstractRouter* r);
+
+      bool m_TakesBundles = false;
+      /// the frames held back, back to back, and how long each is
+      std::vector<byte_t> m_Bundle;
+      std::vector<size_t> m_BundleSizes;
+
       std::set<std::shared_ptr<TransitHop>, ComparePtr<std::shared_ptr<TransitHop>>> m_FlushOthers;
-      thread::Queue<RelayUpstreamMessage> m_UpstreamGather;
-      thread::Queue<RelayDownstreamMessage> m_DownstreamGather;
-      std::atomic<uint32_t> m_UpstreamWorkCounter;
-      std::atomic<uint32_t> m_DownstreamWorkCounter;
+      /// set by Stop, after which batches still in flight are dropped
+      bool m_Stopped = false;
+      util::MemCharge<util::MemTag::Path> m_MemCharge{sizeof(TransitHop)};
     };
   }  // namespace path
 
@@ -16,12 +16,12 @@ namespace llarp
   void
   PeerDb::loadDatabase(std::optional<fs::path> file)
   {
-    std::lock_guard guard(m_statsLock);
+    std::lock_guard guard(m_storageLock);
 
     if (m_storage)
       throw std::runtime_error("Reloading database not supported");  // TODO
 
-    m_peerStats.clear();
+    m_peerStats.EraseIf([](const auto&, const auto&) { return true; });
 
     // sqlite_orm treats empty-string as an indicator to load a memory-backed database, which we'll
     // use if file is an empty-optional
@@ -38,16 +38,24 @@ namespace llarp
 
     m_storage = std::make_unique<PeerDbStorage>(initStorage(fileString));
     m_storage->sync_schema(true);  // true for "preserve" as in "don't nuke" (how cute!)
+    if (file.has_value())
+    {
+      // keep the one connection rather than opening the file for every statement, and journal
+      // to a WAL so that a flush is a sequential append, synced only at checkpoints
+      m_storage->open_forever();
+      m_storage->pragma.journal_mode(sqlite_orm::journal_mode::WAL);
+      m_storage->pragma.synchronous(1);  // NORMAL
+    }
 
     auto allStats = m_storage->get_all<PeerStats>();
     LogInfo("Loading ", allStats.size(), " PeerStats from table peerstats...");
     for (PeerStats& stats : allStats)
     {
       // we cleared m_peerStats, and the database should enforce that routerId is unique...
-      assert(m_peerStats.find(stats.routerId) == m_peerStats.end());
+      assert(not m_peerStats.FindIf(stats.routerId, [](const auto&) { return true; }));
 
       stats.stale = false;
-      m_peerStats[stats.routerId] = stats;
+      m_peerStats.Insert(stats.routerId, stats);
     }
   }
 
@@ -63,33 +71,43 @@ namespace llarp
       return;
     }
 
+    std::lock_guard storageGuard(m_storageLock);
+
     if (not m_storage)
       throw std::runtime_error("Cannot flush database before it has been loaded");
 
-    std::vector<PeerStats> staleStats;
+    std::vector<RouterID> staleIds;
+    m_peerStats.ForEach([&staleIds](const auto& id, const auto& stats) {
+      if (stats.stale)
+        staleIds.push_back(id);
+    });
 
+    // copy and clear the flag in the one update, so that a change racing us is either in this
+    // copy or marks the entry stale again for the next flush
+    std::vector<PeerStats> staleStats;
+    staleStats.reserve(staleIds.size());
+    for (const auto& id : staleIds)
     {
-      std::lock_guard guard(m_statsLock);
-
-      // copy all stale entries
-      for (auto& entry : m_peerStats)
-      {
-        if (entry.second.stale)
-        {
-          staleStats.push_back(entry.second);
-          entry.second.stale = false;
-        }
-      }
+      m_peerStats.Update(id, [&staleStats](auto& stats) {
+        if (not stats.stale)
+          return;
+        staleStats.push_back(stats);
+        stats.stale = false;
+      });
     }
 
     LogDebug("Updating ", staleStats.size(), " stats");
 
+    if (not staleStats.empty())
     {
       auto guard = m_storage->transaction_guard();
 
+      // compiled once, then rebound to each row
+      auto statement = m_storage->prepare(sqlite_orm::replace(staleStats.front()));
       for (const auto& stats : staleStats)
       {
-        m_storage->replace(stats);
+        sqlite_orm::get<0>(statement) = stats;
+        m_storage->execute(statement);
       }
 
       guard.commit();
@@ -110,50 +128,40 @@ namespace llarp
       throw std::invalid_argument{
           fmt::format("routerId {} doesn't match {}", routerId, delta.routerId)};
 
-    std::lock_guard guard(m_statsLock);
-    auto itr = m_peerStats.find(routerId);
-    if (itr == m_peerStats.end())
-      itr = m_peerStats.insert({routerId, delta}).first;
-    else
-      itr->second += delta;
-
-    itr->second.stale = true;
+    m_peerStats.Update(routerId, [&delta](auto& stats) {
+      // a default constructed entry is one we had nothing for
+      if (stats.routerId.IsZero())
+        stats = delta;
+      else
+        stats += delta;
+      stats.stale = true;
+    });
   }
 
   void
   PeerDb::modifyPeerStats(const RouterID& routerId, std::function<void(PeerStats&)> callback)
   {
-    std::lock_guard guard(m_statsLock);
-
-    PeerStats& stats = m_peerStats[routerId];
-    stats.routerId = routerId;
-    stats.stale = true;
-    callback(stats);
+    m_peerStats.Update(routerId, [&](auto& stats) {
+      stats.routerId = routerId;
+      stats.stale = true;
+      callback(stats);
+    });
   }
 
   std::optional<PeerStats>
   PeerDb::getCurrentPeerStats(const RouterID& routerId) const
   {
-    std::lock_guard guard(m_statsLock);
-    auto itr = m_peerStats.find(routerId);
-    if (itr == m_peerStats.end())
-      return std::nullopt;
-    else
-      return itr->second;
+    return m_peerStats.FindIf(routerId, [](const auto&) { return true; });
   }
 
   std::vector<PeerStats>
   PeerDb::listAllPeerStats() const
   {
-    std::lock_guard guard(m_statsLock);
-
     std::vector<PeerStats> statsList;
-    statsList.reserve(m_peerStats.size());
+    statsList.reserve(m_peerStats.Size());
 
-    for (const auto& [routerId, stats] : m_peerStats)
-    {
-      statsList.push_back(stats);
-    }
+    m_peerStats.ForEach(
+        [&statsList](const auto&, const auto& stats) { statsList.push_back(stats); });
 
     return statsList;
   }
@@ -161,16 +169,13 @@ namespace llarp
   std::vector<PeerStats>
   PeerDb::listPeerStats(const std::vector<RouterID>& ids) const
   {
-    std::lock_guard guard(m_statsLock);
-
     std::vector<PeerStats> statsList;
     statsList.reserve(ids.size());
 
     for (const auto& id : ids)
     {
-      const auto itr = m_peerStats.find(id);
-      if (itr != m_peerStats.end())
-        statsList.push_back(itr->second);
+      if (auto stats = getCurrentPeerStats(id))
+        statsList.push_back(std::move(*stats));
     }
 
     return statsList;
@@ -226,16 +231,20 @@ namespace llarp
   void
   PeerDb::handleGossipedRC(const RouterContact& rc, llarp_time_t now)
   {
-    std::lock_guard guard(m_statsLock);
+    const RouterID id(rc.pubkey);
 
-    RouterID id(rc.pubkey);
-    auto& stats = m_peerStats[id];
-    stats.routerId = id;
+    // nothing to do for an rc we have seen, so don't take the shard lock for one
+    const auto current = getCurrentPeerStats(id);
+    if (current and current->lastRCUpdated >= rc.last_updated)
+      return;
 
-    const bool isNewRC = (stats.lastRCUpdated < rc.last_updated);
+    m_peerStats.Update(id, [&](auto& stats) {
+      stats.routerId = id;
+
+      const bool isNewRC = (stats.lastRCUpdated < rc.last_updated);
+      if (not isNewRC)
+        return;
 
-    if (isNewRC)
-    {
       stats.numDistinctRCsReceived++;
 
       if (stats.numDistinctRCsReceived > 1)
@@ -255,7 +264,7 @@ namespace llarp
 
       stats.lastRCUpdated = rc.last_updated;
       stats.stale = true;
-    }
+    });
   }
 
   void
@@ -276,20 +285,20 @@ namespace llarp
   util::StatusObject
   PeerDb::ExtractStatus() const
   {
-    std::lock_guard guard(m_statsLock);
-
-    bool loaded = (m_storage.get() != nullptr);
+    bool loaded;
     util::StatusObject dbFile = nullptr;
-    if (loaded)
-      dbFile = m_storage->filename();
-
-    std::vector<util::StatusObject> statsObjs;
-    statsObjs.reserve(m_peerStats.size());
-    for (const auto& pair : m_peerStats)
     {
-      statsObjs.push_back(pair.second.toJson());
+      std::lock_guard guard(m_storageLock);
+      loaded = (m_storage.get() != nullptr);
+      if (loaded)
+        dbFile = m_storage->filename();
     }
 
+    std::vector<util::StatusObject> statsObjs;
+    statsObjs.reserve(m_peerStats.Size());
+    m_peerStats.ForEach(
+        [&statsObjs](const auto&, const auto& stats) { statsObjs.push_back(stats.toJson()); });
+
     util::StatusObject obj{
         {"dbLoaded", loaded},
         {"dbFile", dbFile},
@@ -9,6 +9,7 @@
 #include <llarp/router_id.hpp>
 #include <llarp/util/time.hpp>
 #include <llarp/util/status.hpp>
+#include <llarp/util/thread/sharded_map.hpp>
 #include "types.hpp"
 #ifdef LOKINET_PEERSTATS_BACKEND
 #include "orm.hpp"
@@ -20,6 +21,11 @@ namespace llarp
   /// This uses a sqlite3 database behind the scenes as persistance, but this database is
   /// periodically flushed to, meaning that it will become stale as PeerDb accumulates stats without
   /// a flush.
+  ///
+  /// the stats themselves live in a thread::ShardedMultiMap, so that reads (rpc, status) take no
+  /// lock and marking a peer only locks its shard; nothing the link layer does waits on the
+  /// database.  a flush writes everything changed since the last one in one transaction, through
+  /// one prepared statement, to a WAL journalled file.
   struct PeerDb
   {
     /// Constructor
@@ -67,8 +73,8 @@ namespace llarp
     /// is an alternative means of incrementing peer stats that is suitable for one-off
     /// modifications.
     ///
-    /// Note that this holds m_statsLock during the callback invocation, so the callback should
-    /// return as quickly as possible.
+    /// Note that this holds the lock of the peer's shard during the callback invocation, so the
+    /// callback should return as quickly as possible.
     ///
     /// @param routerId is the id of the router whose stats should be modified.
     /// @param callback is a function which will be called immediately with mutex held
@@ -129,9 +135,10 @@ namespace llarp
 
 #ifdef LOKINET_PEERSTATS_BACKEND
    private:
-    std::unordered_map<RouterID, PeerStats> m_peerStats;
-    mutable std::mutex m_statsLock;
+    thread::ShardedMultiMap<RouterID, PeerStats> m_peerStats;
 
+    /// guards m_storage, which only load and flush use
+    mutable std::mutex m_storageLock;
     std::unique_ptr<PeerDbStorage> m_storage;
 
     std::atomic<llarp_time_t> m_lastFlush;
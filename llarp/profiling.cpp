@@ -5,6 +5,8 @@
 #include "util/file.hpp"
 #include "util/logging.hpp"
 
+#include <vector>
+
 using oxenc::bt_dict_consumer;
 using oxenc::bt_dict_producer;
 
@@ -59,12 +61,17 @@ namespace llarp
     lastDecay = llarp::time_now_ms();
   }
 
+  bool
+  RouterProfile::ShouldDecay(llarp_time_t now) const
+  {
+    static constexpr auto updateInterval = 30s;
+    return lastDecay < now && now - lastDecay > updateInterval;
+  }
+
   void
   RouterProfile::Tick()
   {
-    static constexpr auto updateInterval = 30s;
-    const auto now = llarp::time_now_ms();
-    if (lastDecay < now && now - lastDecay > updateInterval)
+    if (ShouldDecay(llarp::time_now_ms()))
       Decay();
   }
 
@@ -102,6 +109,12 @@ namespace llarp
   Profiling::Profiling() : m_DisableProfiling(false)
   {}
 
+  std::optional<RouterProfile>
+  Profiling::Find(const RouterID& r) const
+  {
+    return m_Profiles.FindIf(r, [](const auto&) { return true; });
+  }
+
   void
   Profiling::Disable()
   {
@@ -119,11 +132,8 @@ namespace llarp
   {
     if (m_DisableProfiling.load())
       return false;
-    util::Lock lock{m_ProfilesMutex};
-    auto itr = m_Profiles.find(r);
-    if (itr == m_Profiles.end())
-      return false;
-    return not itr->second.IsGoodForConnect(chances);
+    const auto profile = Find(r);
+    return profile and not profile->IsGoodForConnect(chances);
   }
 
   bool
@@ -131,11 +141,8 @@ namespace llarp
   {
     if (m_DisableProfiling.load())
       return false;
-    util::Lock lock{m_ProfilesMutex};
-    auto itr = m_Profiles.find(r);
-    if (itr == m_Profiles.end())
-      return false;
-    return not itr->second.IsGoodForPath(chances);
+    const auto profile = Find(r);
+    return profile and not profile->IsGoodForPath(chances);
   }
 
   bool
@@ -143,59 +150,132 @@ namespace llarp
   {
     if (m_DisableProfiling.load())
       return false;
-    util::Lock lock{m_ProfilesMutex};
-    auto itr = m_Profiles.find(r);
-    if (itr == m_Profiles.end())
-      return false;
-    return not itr->second.IsGood(chances);
+    const auto profile = Find(r);
+    return profile and not profile->IsGood(chances);
   }
 
   void
   Profiling::Tick()
   {
-    util::Lock lock(m_ProfilesMutex);
-    for (auto& [rid, profile] : m_Profiles)
-      profile.Tick();
+    // only the ones due, since every update is a new entry
+    const auto now = llarp::time_now_ms();
+    std::vector<RouterID> routers;
+    m_Profiles.ForEach([&routers, now](const auto& rid, const auto& profile) {
+      if (profile.ShouldDecay(now))
+        routers.push_back(rid);
+    });
+    for (const auto& rid : routers)
+      m_Profiles.Update(rid, [](auto& profile) { profile.Tick(); });
   }
 
   void
   Profiling::MarkConnectTimeout(const RouterID& r)
   {
-    util::Lock lock{m_ProfilesMutex};
-    auto& profile = m_Profiles[r];
-    profile.connectTimeoutCount += 1;
-    profile.lastUpdated = llarp::time_now_ms();
+    m_Profiles.Update(r, [](auto& profile) {
+      profile.connectTimeoutCount += 1;
+      profile.lastUpdated = llarp::time_now_ms();
+    });
+    ++m_Changes;
   }
 
   void
   Profiling::MarkConnectSuccess(const RouterID& r)
   {
-    util::Lock lock{m_ProfilesMutex};
-    auto& profile = m_Profiles[r];
-    profile.connectGoodCount += 1;
-    profile.lastUpdated = llarp::time_now_ms();
+    m_Profiles.Update(r, [](auto& profile) {
+      profile.connectGoodCount += 1;
+      profile.lastUpdated = llarp::time_now_ms();
+    });
+    ++m_Changes;
   }
 
   void
   Profiling::ClearProfile(const RouterID& r)
   {
-    util::Lock lock{m_ProfilesMutex};
-    m_Profiles.erase(r);
+    m_Profiles.EraseIf(r, [](const auto&) { return true; });
+    ++m_Changes;
   }
 
   void
   Profiling::MarkHopFail(const RouterID& r)
   {
-    util::Lock lock{m_ProfilesMutex};
-    auto& profile = m_Profiles[r];
-    profile.pathFailCount += 1;
-    profile.lastUpdated = llarp::time_now_ms();
+    m_Profiles.Update(r, [](auto& profile) {
+      profile.pathFailCount += 1;
+      profile.lastUpdated = llarp::time_now_ms();
+    });
+    ++m_Changes;
+  }
+
+  namespace
+  {
+    /// smooth as tcp does its srtt, 1/8 of each new sample
+    void
+    AddRTTSample(RouterProfile& profile, llarp_time_t rtt)
+    {
+      if (profile.rtt == 0s or profile.rttSaved)
+        profile.rtt = rtt;
+      else
+        profile.rtt = profile.rtt - profile.rtt / 8 + rtt / 8;
+      profile.rttSaved = false;
+      profile.perfUpdated = llarp::time_now_ms();
+    }
+  }  // namespace
+
+  // rtts are only in the performance record, so they don't count as changes to the profiles
+
+  void
+  Profiling::MarkRTT(const RouterID& r, llarp_time_t rtt)
+  {
+    if (rtt <= 0s)
+      return;
+    m_Profiles.Update(r, [rtt](auto& profile) { AddRTTSample(profile, rtt); });
+    ++m_PerfChanges;
+  }
+
+  void
+  Profiling::MarkPathLatency(path::Path* p, llarp_time_t latency)
+  {
+    if (latency <= 0s or p->hops.empty())
+      return;
+    const auto share = latency / p->hops.size();
+    for (const auto& hop : p->hops)
+      m_Profiles.Update(hop.rc.pubkey, [share](auto& profile) { AddRTTSample(profile, share); });
+    ++m_PerfChanges;
+  }
+
+  std::optional<llarp_time_t>
+  Profiling::GetRTT(const RouterID& r) const
+  {
+    const auto profile = Find(r);
+    if (not profile or profile->rtt == 0s)
+      return std::nullopt;
+    return profile->rtt;
+  }
+
+  void
+  Profiling::MarkBandwidth(const RouterID& r, uint64_t bytesPerSec)
+  {
+    if (bytesPerSec == 0)
+      return;
+    m_Profiles.Update(r, [bytesPerSec](auto& profile) {
+      // the peaks are what the link can do, so hold on to them and let them go slowly
+      profile.bandwidth = std::max(bytesPerSec, profile.bandwidth - profile.bandwidth / 64);
+      profile.perfUpdated = llarp::time_now_ms();
+    });
+    ++m_PerfChanges;
+  }
+
+  std::optional<uint64_t>
+  Profiling::GetBandwidth(const RouterID& r) const
+  {
+    const auto profile = Find(r);
+    if (not profile or profile->bandwidth == 0)
+      return std::nullopt;
+    return profile->bandwidth;
   }
 
   void
   Profiling::MarkPathFail(path::Path* p)
   {
-    util::Lock lock{m_ProfilesMutex};
     bool first = true;
     for (const auto& hop : p->hops)
     {
@@ -204,61 +284,74 @@ namespace llarp
         first = false;
       else
       {
-        auto& profile = m_Profiles[hop.rc.pubkey];
-        profile.pathFailCount += 1;
-        profile.lastUpdated = llarp::time_now_ms();
+        m_Profiles.Update(hop.rc.pubkey, [](auto& profile) {
+          profile.pathFailCount += 1;
+          profile.lastUpdated = llarp::time_now_ms();
+        });
       }
     }
+    ++m_Changes;
   }
 
   void
   Profiling::MarkPathTimeout(path::Path* p)
   {
-    util::Lock lock{m_ProfilesMutex};
     for (const auto& hop : p->hops)
     {
-      auto& profile = m_Profiles[hop.rc.pubkey];
-      profile.pathTimeoutCount += 1;
-      profile.lastUpdated = llarp::time_now_ms();
+      m_Profiles.Update(hop.rc.pubkey, [](auto& profile) {
+        profile.pathTimeoutCount += 1;
+        profile.lastUpdated = llarp::time_now_ms();
+      });
     }
+    ++m_Changes;
   }
 
   void
   Profiling::MarkPathSuccess(path::Path* p)
   {
-    util::Lock lock{m_ProfilesMutex};
     const auto sz = p->hops.size();
     for (const auto& hop : p->hops)
     {
-      auto& profile = m_Profiles[hop.rc.pubkey];
-      // redeem previous fails by halfing the fail count and setting timeout to zero
-      profile.pathFailCount /= 2;
-      profile.pathTimeoutCount = 0;
-      // mark success at hop
-      profile.pathSuccessCount += sz;
-      profile.lastUpdated = llarp::time_now_ms();
+      m_Profiles.Update(hop.rc.pubkey, [sz](auto& profile) {
+        // redeem previous fails by halfing the fail count and setting timeout to zero
+        profile.pathFailCount /= 2;
+        profile.pathTimeoutCount = 0;
+        // mark success at hop
+        profile.pathSuccessCount += sz;
+        profile.lastUpdated = llarp::time_now_ms();
+      });
     }
+    ++m_Changes;
+  }
+
+  std::map<RouterID, RouterProfile>
+  Profiling::Snapshot() const
+  {
+    std::map<RouterID, RouterProfile> all;
+    m_Profiles.ForEach([&all](const auto& rid, const auto& profile) { all.emplace(rid, profile); });
+    return all;
   }
 
   bool
   Profiling::Save(const fs::path fpath)
   {
+    const uint64_t changes = m_Changes;
+    // copied out without locking anything, so that saving never holds up hop selection
+    const auto profiles = Snapshot();
     std::string buf;
+    buf.resize((profiles.size() * (RouterProfile::MaxSize + 32 + 8)) + 8);
+    bt_dict_producer d{buf.data(), buf.size()};
+    try
     {
-      util::Lock lock{m_ProfilesMutex};
-      buf.resize((m_Profiles.size() * (RouterProfile::MaxSize + 32 + 8)) + 8);
-      bt_dict_producer d{buf.data(), buf.size()};
-      try
-      {
-        BEncode(d);
-      }
-      catch (const std::exception& e)
-      {
-        log::warning(logcat, "Failed to encode profiling data: {}", e.what());
-        return false;
-      }
-      buf.resize(d.end() - buf.data());
+      for (const auto& [r_id, profile] : profiles)
+        profile.BEncode(d.append_dict(r_id.ToView()));
     }
+    catch (const std::exception& e)
+    {
+      log::warning(logcat, "Failed to encode profiling data: {}", e.what());
+      return false;
+    }
+    buf.resize(d.end() - buf.data());
 
     try
     {
@@ -270,52 +363,152 @@ namespace llarp
       return false;
     }
 
+    m_SavedChanges = changes;
     m_LastSave = llarp::time_now_ms();
     return true;
   }
 
-  void
-  Profiling::BEncode(bt_dict_producer& dict) const
+  bool
+  Profiling::Load(const fs::path fname)
+  {
+    std::vector<std::pair<RouterID, RouterProfile>> loaded;
+    try
+    {
+      std::string data = util::slurp_file(fname);
+      bt_dict_consumer dict{data};
+      while (dict)
+      {
+        auto [rid, subdict] = dict.next_dict_consumer();
+        if (rid.size() != RouterID::SIZE)
+          throw std::invalid_argument{"invalid RouterID"};
+        loaded.emplace_back(reinterpret_cast<const byte_t*>(rid.data()), subdict);
+      }
+    }
+    catch (const std::exception& e)
+    {
+      log::warning(logcat, "failed to load router profiles from {}: {}", fname, e.what());
+      return false;
+    }
+    m_Profiles.EraseIf([](const auto&, const auto&) { return true; });
+    for (const auto& [rid, profile] : loaded)
+      m_Profiles.Insert(rid, profile);
+    m_SavedChanges = m_Changes.load();
+    m_LastSave = llarp::time_now_ms();
+    return true;
+  }
+
+  bool
+  Profiling::ShouldSave(llarp_time_t now) const
   {
-    for (const auto& [r_id, profile] : m_Profiles)
-      profile.BEncode(dict.append_dict(r_id.ToView()));
+    auto dlt = now - m_LastSave.load();
+    return dlt > 1min and m_Changes != m_SavedChanges;
   }
 
-  void
-  Profiling::BDecode(bt_dict_consumer dict)
+  bool
+  Profiling::SavePerformance(const fs::path fpath)
   {
-    m_Profiles.clear();
-    while (dict)
+    const uint64_t changes = m_PerfChanges;
+    // each record is a list of the rtt in microseconds, the bandwidth and when they were last
+    // updated, which keeps it to a few bytes more than the router id
+    std::string buf;
+    size_t count = 0;
+    const auto profiles = Snapshot();
+    buf.resize(profiles.size() * (RouterID::SIZE + 64) + 8);
+    bt_dict_producer d{buf.data(), buf.size()};
+    try
+    {
+      for (const auto& [r_id, profile] : profiles)
+      {
+        if (profile.perfUpdated == 0s)
+          continue;
+        auto l = d.append_list(r_id.ToView());
+        l.append(std::chrono::duration_cast<std::chrono::microseconds>(profile.rtt).count());
+        l.append(profile.bandwidth);
+        l.append(profile.perfUpdated.count());
+        ++count;
+      }
+    }
+    catch (const std::exception& e)
+    {
+      log::warning(logcat, "Failed to encode performance record: {}", e.what());
+      return false;
+    }
+    buf.resize(d.end() - buf.data());
+
+    try
     {
-      auto [rid, subdict] = dict.next_dict_consumer();
-      if (rid.size() != RouterID::SIZE)
-        throw std::invalid_argument{"invalid RouterID"};
-      m_Profiles.emplace(reinterpret_cast<const byte_t*>(rid.data()), subdict);
+      util::dump_file(fpath, buf);
     }
+    catch (const std::exception& e)
+    {
+      log::warning(logcat, "Failed to save performance record to {}: {}", fpath, e.what());
+      return false;
+    }
+    log::debug(logcat, "saved performance record of {} routers to {}", count, fpath);
+    m_SavedPerfChanges = changes;
+    m_LastPerfSave = llarp::time_now_ms();
+    return true;
   }
 
   bool
-  Profiling::Load(const fs::path fname)
+  Profiling::LoadPerformance(const fs::path fname)
   {
+    struct Record
+    {
+      RouterID rid;
+      llarp_time_t rtt;
+      uint64_t bandwidth;
+      llarp_time_t updated;
+    };
+    std::vector<Record> loaded;
+    const auto now = llarp::time_now_ms();
     try
     {
       std::string data = util::slurp_file(fname);
-      util::Lock lock{m_ProfilesMutex};
-      BDecode(bt_dict_consumer{data});
+      bt_dict_consumer dict{data};
+      while (dict)
+      {
+        auto [rid, l] = dict.next_list_consumer();
+        if (rid.size() != RouterID::SIZE)
+          throw std::invalid_argument{"invalid RouterID"};
+        Record rec;
+        rec.rid = RouterID{reinterpret_cast<const byte_t*>(rid.data())};
+        rec.rtt = std::chrono::duration_cast<llarp_time_t>(
+            std::chrono::microseconds{l.consume_integer<int64_t>()});
+        rec.bandwidth = l.consume_integer<uint64_t>();
+        rec.updated = llarp_time_t{l.consume_integer<int64_t>()};
+        if (now - rec.updated < PerformanceMaxAge)
+          loaded.push_back(rec);
+      }
     }
     catch (const std::exception& e)
     {
-      log::warning(logcat, "failed to load router profiles from {}: {}", fname, e.what());
+      log::warning(logcat, "failed to load performance record from {}: {}", fname, e.what());
       return false;
     }
-    m_LastSave = llarp::time_now_ms();
+    for (const auto& rec : loaded)
+    {
+      m_Profiles.Update(rec.rid, [&rec](auto& profile) {
+        // anything we have measured already this run is better than what we remember
+        if (profile.rtt == 0s and rec.rtt > 0s)
+        {
+          profile.rtt = rec.rtt;
+          profile.rttSaved = true;
+        }
+        profile.bandwidth = std::max(profile.bandwidth, rec.bandwidth);
+        profile.perfUpdated = std::max(profile.perfUpdated, rec.updated);
+      });
+    }
+    log::debug(logcat, "loaded performance record of {} routers from {}", loaded.size(), fname);
+    m_SavedPerfChanges = m_PerfChanges.load();
+    m_LastPerfSave = now;
     return true;
   }
 
   bool
-  Profiling::ShouldSave(llarp_time_t now) const
+  Profiling::ShouldSavePerformance(llarp_time_t now) const
   {
-    auto dlt = now - m_LastSave;
-    return dlt > 1min;
+    return now - m_LastPerfSave.load() >= PerformanceSaveInterval
+        and m_PerfChanges != m_SavedPerfChanges;
   }
 }  // namespace llarp
@@ -3,10 +3,11 @@
 #include "path/path.hpp"
 #include "router_id.hpp"
 #include "util/bencode.hpp"
-#include "util/thread/threading.hpp"
+#include "util/thread/sharded_map.hpp"
 
-#include "util/thread/annotations.hpp"
+#include <atomic>
 #include <map>
+#include <optional>
 
 namespace oxenc
 {
@@ -27,6 +28,17 @@ namespace llarp
     llarp_time_t lastUpdated = 0s;
     llarp_time_t lastDecay = 0s;
     uint64_t version = llarp::constants::proto_version;
+    /// smoothed round trip estimate to this router, 0 if we have none.  it is about network
+    /// conditions now, so it is not saved with the rest, only in the performance record
+    /// (Profiling::SavePerformance).
+    llarp_time_t rtt = 0s;
+    /// the most bytes a second we have seen go over our link to this router, decaying slowly
+    uint64_t bandwidth = 0;
+    /// when rtt or bandwidth last got a sample
+    llarp_time_t perfUpdated = 0s;
+    /// rtt came from the performance record of a previous run rather than from this one, so the
+    /// first sample we take replaces it rather than being smoothed into it
+    bool rttSaved = false;
 
     RouterProfile() = default;
     RouterProfile(oxenc::bt_dict_consumer dict);
@@ -55,11 +67,17 @@ namespace llarp
     void
     Decay();
 
+    /// if it is time for Tick to decay stats
+    bool
+    ShouldDecay(llarp_time_t now) const;
+
     // rotate stats if timeout reached
     void
     Tick();
   };
 
+  /// the profiles live in a thread::ShardedMultiMap, one entry per router, so that hop selection
+  /// reads them without taking a lock and marking a result only locks the shards of its hops.
   struct Profiling
   {
     Profiling();
@@ -68,50 +86,90 @@ namespace llarp
 
     /// generic variant
     bool
-    IsBad(const RouterID& r, uint64_t chances = profiling_chances) EXCLUDES(m_ProfilesMutex);
+    IsBad(const RouterID& r, uint64_t chances = profiling_chances);
 
     /// check if this router should have paths built over it
     bool
-    IsBadForPath(const RouterID& r, uint64_t chances = profiling_chances) EXCLUDES(m_ProfilesMutex);
+    IsBadForPath(const RouterID& r, uint64_t chances = profiling_chances);
 
     /// check if this router should be connected directly to
     bool
-    IsBadForConnect(const RouterID& r, uint64_t chances = profiling_chances)
-        EXCLUDES(m_ProfilesMutex);
+    IsBadForConnect(const RouterID& r, uint64_t chances = profiling_chances);
+
+    void
+    MarkConnectTimeout(const RouterID& r);
+
+    void
+    MarkConnectSuccess(const RouterID& r);
 
     void
-    MarkConnectTimeout(const RouterID& r) EXCLUDES(m_ProfilesMutex);
+    MarkPathTimeout(path::Path* p);
 
     void
-    MarkConnectSuccess(const RouterID& r) EXCLUDES(m_ProfilesMutex);
+    MarkPathFail(path::Path* p);
 
     void
-    MarkPathTimeout(path::Path* p) EXCLUDES(m_ProfilesMutex);
+    MarkPathSuccess(path::Path* p);
 
     void
-    MarkPathFail(path::Path* p) EXCLUDES(m_ProfilesMutex);
+    MarkHopFail(const RouterID& r);
 
+    /// fold a round trip sample into the router's rtt estimate
     void
-    MarkPathSuccess(path::Path* p) EXCLUDES(m_ProfilesMutex);
+    MarkRTT(const RouterID& r, llarp_time_t rtt);
 
+    /// fold a latency test result for a whole path into the estimates of its hops, each of
+    /// which is charged an equal share of it
     void
-    MarkHopFail(const RouterID& r) EXCLUDES(m_ProfilesMutex);
+    MarkPathLatency(path::Path* p, llarp_time_t latency);
+
+    /// our rtt estimate for a router, if we have one
+    std::optional<llarp_time_t>
+    GetRTT(const RouterID& r) const;
+
+    /// fold a sample of the bytes a second going over our link to a router into its bandwidth
+    /// estimate
+    void
+    MarkBandwidth(const RouterID& r, uint64_t bytesPerSec);
+
+    /// our bandwidth estimate for a router, if we have one
+    std::optional<uint64_t>
+    GetBandwidth(const RouterID& r) const;
 
     void
-    ClearProfile(const RouterID& r) EXCLUDES(m_ProfilesMutex);
+    ClearProfile(const RouterID& r);
 
     void
-    Tick() EXCLUDES(m_ProfilesMutex);
+    Tick();
 
     bool
-    Load(const fs::path fname) EXCLUDES(m_ProfilesMutex);
+    Load(const fs::path fname);
 
     bool
-    Save(const fs::path fname) EXCLUDES(m_ProfilesMutex);
+    Save(const fs::path fname);
 
+    /// if it has been a while since we last saved, and something worth saving has changed since
     bool
     ShouldSave(llarp_time_t now) const;
 
+    /// the performance record: the rtt and bandwidth estimates we have, which change with every
+    /// sample and so are kept apart from the profiles, to be written out now and then and read
+    /// back after a restart so that hop selection has them from the first build.  records older
+    /// than PerformanceMaxAge are not loaded.
+    bool
+    SavePerformance(const fs::path fname);
+
+    bool
+    LoadPerformance(const fs::path fname);
+
+    /// if it has been PerformanceSaveInterval since we last saved the performance record, and
+    /// there have been samples since
+    bool
+    ShouldSavePerformance(llarp_time_t now) const;
+
+    static constexpr auto PerformanceSaveInterval = 5min;
+    static constexpr auto PerformanceMaxAge = 24h;
+
     void
     Disable();
 
@@ -119,15 +177,25 @@ namespace llarp
     Enable();
 
    private:
-    void
-    BEncode(oxenc::bt_dict_producer& dict) const;
-
-    void
-    BDecode(oxenc::bt_dict_consumer dict);
-
-    mutable util::Mutex m_ProfilesMutex;  // protects m_Profiles
-    std::map<RouterID, RouterProfile> m_Profiles GUARDED_BY(m_ProfilesMutex);
-    llarp_time_t m_LastSave = 0s;
+    /// a copy of r's profile, if we have one
+    std::optional<RouterProfile>
+    Find(const RouterID& r) const;
+
+    /// a sorted copy of every profile
+    std::map<RouterID, RouterProfile>
+    Snapshot() const;
+
+    thread::ShardedMultiMap<RouterID, RouterProfile> m_Profiles;
+    /// bumped by everything that changes what Save writes, so that we can skip saves that would
+    /// write the same thing again
+    std::atomic<uint64_t> m_Changes{0};
+    std::atomic<uint64_t> m_SavedChanges{0};
+    /// set from the disk thread, read from the logic thread
+    std::atomic<llarp_time_t> m_LastSave{0s};
+    /// likewise for the performance record
+    std::atomic<uint64_t> m_PerfChanges{0};
+    std::atomic<uint64_t> m_SavedPerfChanges{0};
+    std::atomic<llarp_time_t> m_LastPerfSave{0s};
     std::atomic<bool> m_DisableProfiling;
   };
 
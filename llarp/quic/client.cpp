@@ -12,10 +12,14 @@
 
 namespace llarp::quic
 {
-  Client::Client(EndpointBase& ep, const SockAddr& remote, uint16_t pseudo_port) : Endpoint{ep}
+  Client::Client(
+      EndpointBase& ep, const SockAddr& remote, uint16_t pseudo_port, ConnectionSettings settings)
+      : Endpoint{ep}
   {
     default_stream_buffer_size =
         0;  // We steal uvw's provided buffers so don't need an outgoing data buffer
+    // Before the connection below is made, which is the only one we make
+    connection_settings = std::move(settings);
 
     // *Our* port; we stuff this in the llarp quic header so it knows how to target quic packets
     // back to *this* client.
@@ -14,7 +14,11 @@ namespace llarp::quic
     // `remote.getPort()` on the remote's lokinet address.  `pseudo_port` is *our* unique local
     // identifier which we include in outgoing packets (so that the remote server knows where to
     // send the back to *this* client).
-    Client(EndpointBase& ep, const SockAddr& remote, uint16_t pseudo_port);
+    Client(
+        EndpointBase& ep,
+        const SockAddr& remote,
+        uint16_t pseudo_port,
+        ConnectionSettings settings = {});
 
     // Returns a reference to the client's connection to the server. Returns a nullptr if there is
     // no connection.
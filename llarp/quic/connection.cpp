@@ -4,7 +4,9 @@
 #include <limits>
 #include <llarp/util/logging.hpp>
 #include <llarp/util/logging/buffer.hpp>
+#include <llarp/util/metrics.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <charconv>
 #include <cstring>
@@ -25,6 +27,11 @@ extern "C"
 
 namespace llarp::quic
 {
+  namespace
+  {
+    metrics::Counter streamsOpened{"lokinet_quic_streams_total", "QUIC streams opened, either way"};
+  }  // namespace
+
   ConnectionID::ConnectionID(const uint8_t* cid, size_t length)
   {
     assert(length <= max_size());
@@ -235,6 +242,15 @@ namespace llarp::quic
       return static_cast<Connection*>(user_data)->stream_ack({stream_id}, datalen);
     }
 
+    int
+    recv_datagram(
+        ngtcp2_conn* conn, uint32_t flags, const uint8_t* data, size_t datalen, void* user_data)
+    {
+      LogTrace("######################", __func__);
+      return static_cast<Connection*>(user_data)->datagram_receive(
+          {reinterpret_cast<const std::byte*>(data), datalen});
+    }
+
     int
     stream_open(ngtcp2_conn* conn, int64_t stream_id, void* user_data)
     {
@@ -329,6 +345,18 @@ namespace llarp::quic
 #pragma GCC diagnostic pop
   }  // namespace
 
+  std::optional<ngtcp2_cc_algo>
+  parse_cc_algo(std::string_view name)
+  {
+    if (name == "reno")
+      return NGTCP2_CC_ALGO_RENO;
+    if (name == "cubic")
+      return NGTCP2_CC_ALGO_CUBIC;
+    if (name == "bbr")
+      return NGTCP2_CC_ALGO_BBR;
+    return std::nullopt;
+  }
+
 #ifndef NDEBUG
   extern "C" inline void
   ngtcp_trace_logger([[maybe_unused]] void* user_data, const char* fmt, ...)
@@ -345,13 +373,12 @@ namespace llarp::quic
   io_result
   Connection::send()
   {
-    assert(send_buffer_size <= send_buffer.size());
+    assert(send_batch.size() <= send_buffers.size());
     io_result rv{};
-    bstring_view send_data{send_buffer.data(), send_buffer_size};
-
-    if (!send_data.empty())
+    if (!send_batch.empty())
     {
-      rv = endpoint.send_packet(path.remote, send_data, send_pkt_info.ecn);
+      rv = endpoint.send_packets(path.remote, send_batch);
+      send_batch.clear();
     }
     return rv;
   }
@@ -359,25 +386,12 @@ namespace llarp::quic
   std::tuple<ngtcp2_settings, ngtcp2_transport_params, ngtcp2_callbacks>
   Connection::init()
   {
+    send_batch.reserve(max_send_batch);
+
     auto loop = endpoint.get_loop();
     io_trigger = loop->resource<uvw::AsyncHandle>();
     io_trigger->on<uvw::AsyncEvent>([this](auto&, auto&) { on_io_ready(); });
 
-    retransmit_timer = loop->resource<uvw::TimerHandle>();
-    retransmit_timer->on<uvw::TimerEvent>([this](auto&, auto&) {
-      LogTrace("Retransmit timer fired!");
-      if (auto rv = ngtcp2_conn_handle_expiry(*this, get_timestamp()); rv != 0)
-      {
-        LogWarn("expiry handler invocation returned an error: ", ngtcp2_strerror(rv));
-        endpoint.close_connection(*this, ngtcp2_err_infer_quic_transport_error_code(rv), false);
-      }
-      else
-      {
-        flush_streams();
-      }
-    });
-    retransmit_timer->start(0ms, 0ms);
-
     auto result = std::tuple<ngtcp2_settings, ngtcp2_transport_params, ngtcp2_callbacks>{};
     auto& [settings, tparams, cb] = result;
     cb.recv_crypto_data = recv_crypto_data;
@@ -389,6 +403,7 @@ namespace llarp::quic
     cb.stream_open = stream_open;
     cb.stream_close = stream_close_cb;
     cb.extend_max_local_streams_bidi = extend_max_local_streams_bidi;
+    cb.recv_datagram = recv_datagram;
     cb.rand = rand;
     cb.get_new_connection_id = get_new_connection_id;
     cb.remove_connection_id = remove_connection_id;
@@ -402,22 +417,27 @@ namespace llarp::quic
     settings.initial_ts = get_timestamp();
     // FIXME: IPv6
     settings.max_udp_payload_size = Endpoint::max_pkt_size_v4;
-    settings.cc_algo = NGTCP2_CC_ALGO_CUBIC;
+    const auto& conf = endpoint.connection_settings;
+    settings.cc_algo = conf.cc_algo;
     // settings.initial_rtt = ???; # NGTCP2's default is 333ms
+    // How far ngtcp2 may auto-tune the windows below as it measures the path:
+    settings.max_window = std::max(conf.max_connection_window, conf.connection_window);
+    settings.max_stream_window = std::max(conf.max_stream_window, conf.stream_window);
 
     ngtcp2_transport_params_default(&tparams);
 
     // Connection level flow control window:
-    tparams.initial_max_data = CONNECTION_BUFFER;
+    tparams.initial_max_data = conf.connection_window;
     // Max send buffer for a streams (local is for streams we initiate, remote is for replying on
     // streams they initiate to us):
-    tparams.initial_max_stream_data_bidi_local = STREAM_BUFFER;
-    tparams.initial_max_stream_data_bidi_remote = STREAM_BUFFER;
+    tparams.initial_max_stream_data_bidi_local = conf.stream_window;
+    tparams.initial_max_stream_data_bidi_remote = conf.stream_window;
     // Max *cumulative* streams we support on a connection:
-    tparams.initial_max_streams_bidi = STREAM_LIMIT;
+    tparams.initial_max_streams_bidi = conf.stream_limit;
     tparams.initial_max_streams_uni = 0;
     tparams.max_idle_timeout = std::chrono::nanoseconds(IDLE_TIMEOUT).count();
     tparams.active_connection_id_limit = 8;
+    tparams.max_datagram_frame_size = conf.max_datagram_frame_size;
 
     LogDebug("Done basic connection initialization");
 
@@ -525,11 +545,6 @@ namespace llarp::quic
   {
     if (io_trigger)
       io_trigger->close();
-    if (retransmit_timer)
-    {
-      retransmit_timer->stop();
-      retransmit_timer->close();
-    }
   }
 
   void
@@ -546,6 +561,21 @@ namespace llarp::quic
     LogTrace("done ", __func__);
   }
 
+  void
+  Connection::on_expiry()
+  {
+    LogTrace("Retransmit timer fired!");
+    if (auto rv = ngtcp2_conn_handle_expiry(*this, get_timestamp()); rv != 0)
+    {
+      LogWarn("expiry handler invocation returned an error: ", ngtcp2_strerror(rv));
+      endpoint.close_connection(*this, ngtcp2_err_infer_quic_transport_error_code(rv), false);
+    }
+    else
+    {
+      flush_streams();
+    }
+  }
+
   void
   Connection::flush_streams()
   {
@@ -561,6 +591,8 @@ namespace llarp::quic
           if (!ts)
             ts = get_timestamp();
 
+          // each packet gets the next slot; one that ngtcp2 wants to write more into stays put
+          auto& send_buffer = send_buffers[send_batch.size()];
           LogTrace(
               "send_buffer size=", send_buffer.size(), ", datalen=", datalen, ", flags=", flags);
           nwrite = ngtcp2_conn_writev_stream(
@@ -578,10 +610,8 @@ namespace llarp::quic
           return result;
         };
 
-    auto send_packet = [&](auto nwrite) -> bool {
-      send_buffer_size = nwrite;
-      LogTrace("Sending ", send_buffer_size, "B packet");
-
+    auto send_queued = [&]() -> bool {
+      LogTrace("Sending batch of ", send_batch.size(), " packets");
       auto sent = send();
       if (sent.blocked())
       {
@@ -589,21 +619,79 @@ namespace llarp::quic
         return false;
       }
 
-      send_buffer_size = 0;
       if (!sent)
       {
-        LogWarn("I/O error while trying to send packet: ", sent.str());
+        LogWarn("I/O error while trying to send packets: ", sent.str());
         // FIXME: disconnect?
         return false;
       }
-      LogTrace("packet away!");
+      LogTrace("packets away!");
       return true;
     };
 
+    // Queues the packet just written into the batch, sending the batch if that filled it
+    auto send_packet = [&](auto nwrite) -> bool {
+      auto& send_buffer = send_buffers[send_batch.size()];
+      send_batch.push_back(
+          {bstring_view{send_buffer.data(), static_cast<size_t>(nwrite)}, send_pkt_info.ecn});
+      LogTrace("Queued ", nwrite, "B packet");
+      return send_batch.size() < max_send_batch || send_queued();
+    };
+
+    // Datagrams go first: whatever sends them is most sensitive to delay, and any stream data
+    // packed in after them is just as happy to wait for the next packet.
+    while (!pending_datagrams.empty())
+    {
+      if (!ts)
+        ts = get_timestamp();
+      auto& dgram = pending_datagrams.front();
+      ngtcp2_vec datav{u8data(dgram), dgram.size()};
+      auto& send_buffer = send_buffers[send_batch.size()];
+      int accepted = 0;
+      auto nwrite = ngtcp2_conn_writev_datagram(
+          conn.get(),
+          &path.path,
+          &send_pkt_info,
+          u8data(send_buffer),
+          send_buffer.size(),
+          &accepted,
+          NGTCP2_WRITE_DATAGRAM_FLAG_MORE,
+          0,
+          &datav,
+          1,
+          *ts);
+      if (accepted)
+        pending_datagrams.pop_front();
+      if (nwrite == NGTCP2_ERR_WRITE_MORE)
+        continue;
+      if (nwrite > 0)
+      {
+        if (!send_packet(nwrite))
+          return;
+        continue;
+      }
+      if (nwrite == 0)
+      {
+        LogTrace("Congested; holding ", pending_datagrams.size(), " datagrams for later");
+        break;
+      }
+      // The remote doesn't take datagrams, or not this big: it's never going to go
+      LogDebug("Dropping ", dgram.size(), "B datagram: ", ngtcp2_strerror(nwrite));
+      pending_datagrams.pop_front();
+    }
+
     std::list<Stream*> strs;
     for (auto& [stream_id, stream_ptr] : streams)
       if (stream_ptr)
         strs.push_back(stream_ptr.get());
+    // Most urgent first, then non-incremental before incremental; the sort is stable so that each
+    // group stays in stream order.
+    strs.sort([](const Stream* a, const Stream* b) {
+      const auto& pa = a->priority();
+      const auto& pb = b->priority();
+      return pa.urgency < pb.urgency
+          || (pa.urgency == pb.urgency && !pa.incremental && pb.incremental);
+    });
 
     // Maximum number of stream data packets to send out at once; if we reach this then we'll
     // schedule another event loop call of ourselves (so that we don't starve the loop).
@@ -611,7 +699,10 @@ namespace llarp::quic
     int stream_packets = 0;
     while (!strs.empty() && stream_packets < max_stream_packets)
     {
-      for (auto it = strs.begin(); it != strs.end();)
+      // Each round only goes to the most urgent streams that still have something to send; a
+      // non-incremental stream takes the whole round, and keeps on taking them until it is done.
+      const auto urgency = strs.front()->priority().urgency;
+      for (auto it = strs.begin(); it != strs.end() && (*it)->priority().urgency == urgency;)
       {
         auto& stream = **it;
         auto bufs = stream.pending();
@@ -663,6 +754,8 @@ namespace llarp::quic
           if (!send_packet(nwrite))
             return;
           ++stream_packets;
+          if (!stream.priority().incremental)
+            break;
           ++it;
           continue;
         }
@@ -733,6 +826,9 @@ namespace llarp::quic
         return;
     }
 
+    if (!send_queued())
+      return;
+
     schedule_retransmit();
   }
 
@@ -741,20 +837,8 @@ namespace llarp::quic
   {
     auto exp = ngtcp2_conn_get_expiry(*this);
     if (exp == std::numeric_limits<decltype(exp)>::max())
-    {
       LogTrace("no retransmit currently needed");
-      retransmit_timer->stop();
-      return;
-    }
-
-    auto expiry = std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(exp)};
-    auto expires_in = std::max(
-        0ms,
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            expiry - get_time().time_since_epoch()));
-    LogDebug("Next retransmit in ", expires_in.count(), "ms");
-    retransmit_timer->stop();
-    retransmit_timer->start(expires_in, 0ms);
+    endpoint.schedule_expiry(*this, exp);
   }
 
   int
@@ -783,6 +867,7 @@ namespace llarp::quic
 
     [[maybe_unused]] auto [it, ins] = streams.emplace(id, std::move(stream));
     assert(ins);
+    streamsOpened.Inc();
     LogDebug("Created new incoming stream ", id);
     return 0;
   }
@@ -796,6 +881,7 @@ namespace llarp::quic
     else
     {
       bool good = false;
+      str->deferring = 0;
       try
       {
         str->data_callback(*str, data);
@@ -832,8 +918,10 @@ namespace llarp::quic
     }
     else
     {
-      ngtcp2_conn_extend_max_stream_offset(*this, id.id, data.size());
-      ngtcp2_conn_extend_max_offset(*this, data.size());
+      // Whatever the data callback deferred gets credited later, when it calls `consumed()`
+      const auto credit = data.size() - std::min(data.size(), std::exchange(str->deferring, 0));
+      ngtcp2_conn_extend_max_stream_offset(*this, id.id, credit);
+      ngtcp2_conn_extend_max_offset(*this, credit);
     }
     return 0;
   }
@@ -858,6 +946,11 @@ namespace llarp::quic
       stream.close_callback(stream, code);
     }
 
+    // Data still deferred on the stream will never be consumed now, but it still counts against the
+    // connection's flow control window.
+    if (stream.deferred)
+      ngtcp2_conn_extend_max_offset(*this, std::exchange(stream.deferred, 0));
+
     LogDebug("Erasing stream ", id, " from ", (void*)it->second.get());
     streams.erase(it);
 
@@ -912,6 +1005,40 @@ namespace llarp::quic
     return ngtcp2_conn_get_handshake_completed(*this) != 0;
   }
 
+  bool
+  Connection::send_datagram(bstring_view data)
+  {
+    if (data.size() > NGTCP2_MAX_UDP_PAYLOAD_SIZE)
+      return false;
+    if (pending_datagrams.size() >= max_pending_datagrams)
+    {
+      LogDebug("Too many datagrams waiting to send; dropping the oldest");
+      pending_datagrams.pop_front();
+    }
+    pending_datagrams.emplace_back(data.begin(), data.end());
+    io_ready();
+    return true;
+  }
+
+  int
+  Connection::datagram_receive(bstring_view data)
+  {
+    if (!on_datagram)
+    {
+      LogDebug("Dropping ", data.size(), "B datagram: connection has no datagram callback");
+      return 0;
+    }
+    try
+    {
+      on_datagram(*this, data);
+    }
+    catch (const std::exception& e)
+    {
+      LogWarn("Datagram callback raised exception (", e.what(), "); dropping datagram");
+    }
+    return 0;
+  }
+
   int
   Connection::get_streams_available()
   {
@@ -932,6 +1059,7 @@ namespace llarp::quic
 
     auto& str = streams[stream->stream_id];
     str = std::move(stream);
+    streamsOpened.Inc();
 
     return str;
   }
@@ -6,8 +6,11 @@
 
 #include <chrono>
 #include <cstddef>
+#include <deque>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <string_view>
 #include <unordered_set>
 #include <map>
@@ -30,14 +33,50 @@ namespace llarp::quic
   constexpr std::basic_string_view<uint8_t> handshake_magic{
       handshake_magic_bytes.data(), handshake_magic_bytes.size()};
 
-  // Flow control window sizes for a buffer and individual streams:
+  // Default flow control window sizes for a buffer and individual streams, and how far ngtcp2 may
+  // grow them:
   constexpr uint64_t CONNECTION_BUFFER = 1024 * 1024;
+  constexpr uint64_t MAX_CONNECTION_BUFFER = 15 * 1024 * 1024;
   constexpr uint64_t STREAM_BUFFER = 64 * 1024;
-  // Max number of simultaneous streams we support over one connection
+  constexpr uint64_t MAX_STREAM_BUFFER = 6 * 1024 * 1024;
+  // Default max number of simultaneous streams we support over one connection
   constexpr uint64_t STREAM_LIMIT = 32;
+  // Default largest DATAGRAM frame we accept; a datagram can't span packets, so there is no use in
+  // accepting larger.
+  constexpr uint64_t MAX_DATAGRAM_FRAME_SIZE = NGTCP2_MAX_UDP_PAYLOAD_SIZE;
+
+  // Congestion and flow control for the connections of an endpoint.  The flow control windows we
+  // give the peer start at `connection_window` and `stream_window`; whenever the peer uses up a
+  // window in less than a couple of round trips ngtcp2 doubles it, up to the max, so that they
+  // settle at about the path's bandwidth-delay product.  A max no bigger than the start turns
+  // that off.
+  struct ConnectionSettings
+  {
+    ngtcp2_cc_algo cc_algo = NGTCP2_CC_ALGO_CUBIC;
+    uint64_t connection_window = CONNECTION_BUFFER;
+    uint64_t max_connection_window = MAX_CONNECTION_BUFFER;
+    uint64_t stream_window = STREAM_BUFFER;
+    uint64_t max_stream_window = MAX_STREAM_BUFFER;
+    uint64_t stream_limit = STREAM_LIMIT;
+    // Largest DATAGRAM frame (RFC 9221) we let the peer send us; 0 tells the peer we don't take
+    // datagrams at all.
+    uint64_t max_datagram_frame_size = MAX_DATAGRAM_FRAME_SIZE;
+  };
+
+  // Looks up a congestion controller by name: "reno", "cubic" or "bbr".  Returns nullopt for
+  // anything else.
+  std::optional<ngtcp2_cc_algo>
+  parse_cc_algo(std::string_view name);
 
   using bstring_view = std::basic_string_view<std::byte>;
 
+  // A packet on its way out in a batch: the packet data and the ecn value ngtcp2 gave it
+  struct OutgoingPacket
+  {
+    bstring_view data;
+    uint8_t ecn;
+  };
+
   class Endpoint;
   class Server;
   class Client;
@@ -127,15 +166,24 @@ namespace llarp::quic
       }
     };
 
-    // Packet data storage for a packet we are currently sending
-    std::array<std::byte, NGTCP2_MAX_UDP_PAYLOAD_SIZE> send_buffer{};
-    size_t send_buffer_size = 0;
+    // Most packets we write before handing them to the endpoint together
+    static constexpr size_t max_send_batch = 16;
+
+    // Packet data storage for the packets we are currently sending, one slot per packet of the
+    // batch; kept from flush to flush so that writing a batch costs no allocations
+    std::array<std::array<std::byte, NGTCP2_MAX_UDP_PAYLOAD_SIZE>, max_send_batch> send_buffers{};
+    // The packets written into `send_buffers` and not yet sent
+    std::vector<OutgoingPacket> send_batch;
     ngtcp2_pkt_info send_pkt_info{};
 
-    // Attempts to send the packet in `send_buffer`.  If sending blocks then we set up a write poll
-    // on the socket to wait for it to become available, and return an io_result with `.blocked()`
-    // set to true.  On other I/O errors we return the errno, and on successful sending we return a
-    // "true" (i.e. no error code) io_result.
+    // Datagrams queued by `send_datagram()` that haven't made it into a packet yet
+    std::deque<std::vector<std::byte>> pending_datagrams;
+
+    // Attempts to send the packets in `send_batch`, all in one call to the endpoint, and empties
+    // it.  If sending blocks then we set up a write poll on the socket to wait for it to become
+    // available, and return an io_result with `.blocked()` set to true.  On other I/O errors we
+    // return the errno, and on successful sending we return a "true" (i.e. no error code)
+    // io_result.
     io_result
     send();
 
@@ -150,7 +198,6 @@ namespace llarp::quic
     // Schedules a retransmit in the event loop (according to when ngtcp2 tells us we should)
     void
     schedule_retransmit();
-    std::shared_ptr<uvw::TimerHandle> retransmit_timer;
 
     // The port the client wants to connect to on the server
     uint16_t tunnel_port = 0;
@@ -242,6 +289,17 @@ namespace llarp::quic
     void
     on_io_ready();
 
+    // Called by the endpoint once the time ngtcp2 gave us from `ngtcp2_conn_get_expiry` has come:
+    // lets ngtcp2 deal with whatever timed out (retransmits, delayed acks, pacing) then flushes.
+    void
+    on_expiry();
+
+    // The expiry the endpoint currently has scheduled for us (max() if none), and a counter bumped
+    // each time that changes so that the endpoint can recognize its outdated entries.  Only the
+    // endpoint should touch these.
+    uint64_t expiry_at = std::numeric_limits<uint64_t>::max();
+    uint64_t expiry_gen = 0;
+
     int
     setup_server_crypto_initial();
 
@@ -263,6 +321,10 @@ namespace llarp::quic
     void
     stream_closed(StreamID id, uint64_t app_error_code);
 
+    // Called when a datagram is received
+    int
+    datagram_receive(bstring_view data);
+
     // Called when stream data has been acknowledged and can be freed
     int
     stream_ack(StreamID id, size_t size);
@@ -311,6 +373,22 @@ namespace llarp::quic
     const std::shared_ptr<Stream>&
     get_stream(StreamID s) const;
 
+    // Callback invoked with each datagram (RFC 9221) the remote sends us over this connection.
+    // Datagrams share the connection's congestion control with its streams, but are never
+    // retransmitted: each arrives at most once, in no particular order.
+    std::function<void(Connection&, bstring_view)> on_datagram;
+
+    // Most datagrams we hold on to while the connection is congested
+    static constexpr size_t max_pending_datagrams = 64;
+
+    // Queues a datagram to go out ahead of any pending stream data.  If `max_pending_datagrams` are
+    // already waiting then the oldest is dropped to make room: whatever uses datagrams over
+    // streams would rather have new data than late data.  Returns false, without queuing anything,
+    // if the datagram is too big to ever fit in a packet.  A datagram the remote won't accept
+    // (because it doesn't take datagrams, or not ones that big) is dropped when we try to send it.
+    bool
+    send_datagram(bstring_view data);
+
     // Internal methods that need to be publicly callable because we call them from C functions:
     int
     init_client();
@@ -4,6 +4,7 @@
 #include "uvw/async.h"
 #include <llarp/crypto/crypto.hpp>
 #include <llarp/util/logging/buffer.hpp>
+#include <llarp/util/metrics.hpp>
 #include <llarp/service/endpoint.hpp>
 #include <llarp/ev/libuv.hpp>
 
@@ -22,6 +23,16 @@ extern "C"
 
 namespace llarp::quic
 {
+  namespace
+  {
+    metrics::Counter rxPackets{"lokinet_quic_rx_packets_total", "QUIC packets we received"};
+    metrics::Counter rxBytes{"lokinet_quic_rx_bytes_total", "Bytes of QUIC packets we received"};
+    metrics::Counter txPackets{"lokinet_quic_tx_packets_total", "QUIC packets we sent"};
+    metrics::Counter txBytes{"lokinet_quic_tx_bytes_total", "Bytes of QUIC packets we sent"};
+    metrics::Counter txFailed{
+        "lokinet_quic_tx_failed_total", "QUIC packets we had nowhere to send to"};
+  }  // namespace
+
   Endpoint::Endpoint(EndpointBase& ep) : service_endpoint{ep}
   {
     randombytes_buf(static_secret.data(), static_secret.size());
@@ -31,6 +42,9 @@ namespace llarp::quic
     expiry_timer->on<uvw::TimerEvent>([this](const auto&, auto&) { check_timeouts(); });
     expiry_timer->start(250ms, 250ms);
 
+    conn_timer = get_loop()->resource<uvw::TimerHandle>();
+    conn_timer->on<uvw::TimerEvent>([this](const auto&, auto&) { process_expiries(); });
+
     LogDebug("Created QUIC endpoint");
   }
 
@@ -38,6 +52,8 @@ namespace llarp::quic
   {
     if (expiry_timer)
       expiry_timer->close();
+    if (conn_timer)
+      conn_timer->close();
   }
 
   std::shared_ptr<uvw::Loop>
@@ -56,6 +72,8 @@ namespace llarp::quic
     SockAddr local = src.isIPv6() ? SockAddr{in6addr_any} : SockAddr{nuint32_t{INADDR_ANY}};
 
     Packet pkt{Path{local, src}, data, ngtcp2_pkt_info{.ecn = ecn}};
+    rxPackets.Inc();
+    rxBytes.Inc(data.size());
 
     LogTrace("[", pkt.path, ",ecn=", pkt.info.ecn, "]: received ", data.size(), " bytes");
 
@@ -188,15 +206,55 @@ namespace llarp::quic
     if (service_endpoint.SendToOrQueue(
             to, llarp_buffer_t{outgoing.data(), outgoing.size()}, service::ProtocolType::QUIC))
     {
+      txPackets.Inc();
+      txBytes.Inc(outgoing.size());
       LogTrace("[", to, "]: sent ", buffer_printer{outgoing});
     }
     else
     {
+      txFailed.Inc();
       LogDebug("Failed to send to quic endpoint ", to, "; was sending ", outgoing.size(), "B");
     }
     return {};
   }
 
+  io_result
+  Endpoint::send_packets(const Address& to, const std::vector<OutgoingPacket>& packets)
+  {
+    assert(service_endpoint.Loop()->inEventLoop());
+
+    if (batch_bufs_.size() < packets.size())
+      batch_bufs_.resize(packets.size());
+    batch_payloads_.clear();
+    for (size_t i = 0; i < packets.size(); ++i)
+    {
+      const auto& pkt = packets[i];
+      auto& outgoing = batch_bufs_[i];
+      size_t header_size = write_packet_header(to.port(), pkt.ecn);
+      outgoing.resize(header_size + pkt.data.size());
+      std::memcpy(outgoing.data(), buf_.data(), header_size);
+      std::memcpy(outgoing.data() + header_size, pkt.data.data(), pkt.data.size());
+      batch_payloads_.emplace_back(outgoing.data(), outgoing.size());
+    }
+
+    if (service_endpoint.SendBatchToOrQueue(to, batch_payloads_, service::ProtocolType::QUIC))
+    {
+      size_t bytes = 0;
+      for (const auto& payload : batch_payloads_)
+        bytes += payload.sz;
+      txPackets.Inc(batch_payloads_.size());
+      txBytes.Inc(bytes);
+      LogTrace("[", to, "]: sent batch of ", packets.size(), " packets");
+    }
+    else
+    {
+      txFailed.Inc(packets.size());
+      LogDebug(
+          "Failed to send to quic endpoint ", to, "; was sending ", packets.size(), " packets");
+    }
+    return {};
+  }
+
   void
   Endpoint::send_version_negotiation(const version_info& vi, const Address& source)
   {
@@ -326,6 +384,85 @@ namespace llarp::quic
     }
   }
 
+  void
+  Endpoint::schedule_expiry(Connection& conn, uint64_t at)
+  {
+    if (at == conn.expiry_at)
+      return;
+    conn.expiry_at = at;
+    ++conn.expiry_gen;
+    if (at == std::numeric_limits<uint64_t>::max())
+      return;  // Its old entry, if any, is now outdated and will be skipped
+
+    // Outdated entries usually get dropped as they reach the front, but a busy connection moves its
+    // expiry far more often than that, so start over from the current ones if they pile up.
+    if (conn_expiries.size() >= 64 + 4 * conns.size())
+    {
+      decltype(conn_expiries) current;
+      for (auto& [cid, c] : conns)
+        if (auto* conn_ptr = std::get_if<primary_conn_ptr>(&c))
+          if (auto& ptr = *conn_ptr; ptr->expiry_at != std::numeric_limits<uint64_t>::max())
+            current.push({ptr->expiry_at, ptr->base_cid, ptr->expiry_gen});
+      conn_expiries = std::move(current);
+    }
+    else
+      conn_expiries.push({at, conn.base_cid, conn.expiry_gen});
+
+    if (at < conn_timer_at)
+      arm_conn_timer();
+  }
+
+  void
+  Endpoint::process_expiries()
+  {
+    conn_timer_at = std::numeric_limits<uint64_t>::max();
+    const auto now = get_timestamp();
+    // Collect first and handle after: handling reschedules, and ngtcp2 may well want to be called
+    // again right away (e.g. to send the next paced packet); that waits for the next timer.
+    std::vector<std::shared_ptr<Connection>> due;
+    while (!conn_expiries.empty() && conn_expiries.top().at <= now)
+    {
+      auto [conn, alias] = get_conn(conn_expiries.top().cid);
+      if (conn && !alias && conn->expiry_gen == conn_expiries.top().gen)
+      {
+        conn->expiry_at = std::numeric_limits<uint64_t>::max();
+        due.push_back(std::move(conn));
+      }
+      conn_expiries.pop();
+    }
+    for (auto& conn : due)
+      conn->on_expiry();
+    arm_conn_timer();
+  }
+
+  void
+  Endpoint::arm_conn_timer()
+  {
+    while (!conn_expiries.empty())
+    {
+      auto& next = conn_expiries.top();
+      if (auto [conn, alias] = get_conn(next.cid); conn && !alias && conn->expiry_gen == next.gen)
+        break;
+      conn_expiries.pop();
+    }
+    if (conn_expiries.empty())
+    {
+      conn_timer->stop();
+      conn_timer_at = std::numeric_limits<uint64_t>::max();
+      return;
+    }
+    const auto at = conn_expiries.top().at;
+    if (at == conn_timer_at)
+      return;
+    // libuv timers only go to the millisecond, so round up: waking before the expiry would just
+    // cost another wakeup to find nothing due yet.
+    const auto now = get_timestamp();
+    const auto delay = at > now ? (at - now + 999'999) / 1'000'000 : 0;
+    LogTrace("Next connection expiry in ", delay, "ms");
+    conn_timer->start(std::chrono::milliseconds{delay}, 0ms);
+    conn_timer_at = at;
+  }
+
   std::pair<std::shared_ptr<Connection>, bool>
   Endpoint::get_conn(const ConnectionID& cid)
   {
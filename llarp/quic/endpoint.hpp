@@ -9,6 +9,8 @@
 #include <llarp/net/ip_packet.hpp>
 
 #include <chrono>
+#include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <queue>
@@ -60,6 +62,39 @@ namespace llarp::quic
 
     std::shared_ptr<uvw::TimerHandle> expiry_timer;
 
+    // The ngtcp2 expiries (retransmits, delayed acks, pacing, idle timeout) of all our connections,
+    // earliest first, so that one timer serves them all and a quiet connection costs no wakeups of
+    // its own.  Entries aren't removed when a connection's expiry moves: each records the
+    // connection's `expiry_gen` when it was pushed, and ones that no longer match are skipped.
+    struct conn_expiry
+    {
+      uint64_t at;
+      ConnectionID cid;
+      uint64_t gen;
+
+      bool
+      operator>(const conn_expiry& other) const
+      {
+        return at > other.at;
+      }
+    };
+    std::priority_queue<conn_expiry, std::vector<conn_expiry>, std::greater<>> conn_expiries;
+    std::shared_ptr<uvw::TimerHandle> conn_timer;
+    // The expiry `conn_timer` is currently set for, max() if it is stopped
+    uint64_t conn_timer_at = std::numeric_limits<uint64_t>::max();
+
+    // Replaces the expiry scheduled for `conn` with the ngtcp2 timestamp `at` (max() for none)
+    void
+    schedule_expiry(Connection& conn, uint64_t at);
+
+    // Fired by `conn_timer`: handles each connection whose expiry has come, then rearms
+    void
+    process_expiries();
+
+    // Sets `conn_timer` for the earliest expiry still current, or stops it if there isn't one
+    void
+    arm_conn_timer();
+
     std::vector<std::byte> buf;
     // Max theoretical size of a UDP packet is 2^16-1 minus IP/UDP header overhead
     static constexpr size_t max_buf_size = 64 * 1024;
@@ -168,6 +203,11 @@ namespace llarp::quic
     io_result
     send_packet(const Address& to, bstring_view data, uint8_t ecn);
 
+    // Sends a batch of packets to `to` with one call into the service endpoint, so that it can
+    // pack them into fewer frames.  Returns as send_packet does.
+    io_result
+    send_packets(const Address& to, const std::vector<OutgoingPacket>& packets);
+
     // Wrapper around the above that takes a regular std::string_view (i.e. of chars) and recasts
     // it to an string_view of std::bytes.
     io_result
@@ -246,9 +286,17 @@ namespace llarp::quic
     // Default stream buffer size for streams opened through this endpoint.
     size_t default_stream_buffer_size = 64 * 1024;
 
+    // Congestion and flow control for connections made from here on.
+    ConnectionSettings connection_settings;
+
     // Packet buffer we use when constructing custom packets to fire over lokinet
     std::array<std::byte, net::IPPacket::MaxSize> buf_;
 
+    // Per packet buffers for headed packets of a batch, and the views of them we hand on; kept
+    // between batches so that they stop needing to allocate
+    std::vector<std::vector<std::byte>> batch_bufs_;
+    std::vector<llarp_buffer_t> batch_payloads_;
+
     // Non-copyable, non-movable
     Endpoint(const Endpoint&) = delete;
     Endpoint(Endpoint&&) = delete;
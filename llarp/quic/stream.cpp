@@ -3,6 +3,7 @@
 #include "endpoint.hpp"
 #include <llarp/util/logging.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -313,6 +314,35 @@ namespace llarp::quic
     unacked_size += bytes;
   }
 
+  void
+  Stream::set_priority(StreamPriority p)
+  {
+    p.urgency = std::min(p.urgency, StreamPriority::max_urgency);
+    prio = p;
+    io_ready();
+  }
+
+  void
+  Stream::defer_consumed(size_t bytes)
+  {
+    deferring += bytes;
+    deferred += bytes;
+  }
+
+  void
+  Stream::consumed(size_t bytes)
+  {
+    // Once shut down the remote can't send anything more, and stream_closed has already given back
+    // the connection-level credit for whatever was still deferred.
+    if (is_shutdown)
+      return;
+    bytes = std::min(bytes, deferred);
+    deferred -= bytes;
+    ngtcp2_conn_extend_max_stream_offset(conn, stream_id.id, bytes);
+    ngtcp2_conn_extend_max_offset(conn, bytes);
+    conn.io_ready();
+  }
+
   void
   Stream::close(std::optional<uint64_t> error_code)
   {
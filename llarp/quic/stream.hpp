@@ -13,6 +13,7 @@
 #include <uvw/async.h>
 
 #include <llarp/util/formattable.hpp>
+#include <llarp/util/mem_account.hpp>
 
 namespace llarp::quic
 {
@@ -103,6 +104,20 @@ namespace std
 
 namespace llarp::quic
 {
+  // Send priority of a stream, in the manner of RFC 9218: when several streams of a connection have
+  // data to send, those of the lowest `urgency` (0-7) go first.  Among streams of the same urgency,
+  // non-incremental ones are sent one at a time in stream order, ahead of incremental ones which
+  // take turns a packet at a time.  (Unlike RFC 9218 we default to incremental, which is how all
+  // streams were sent before priorities existed).  Priorities only order what *we* send; the
+  // remote schedules its side of the stream by its own.
+  struct StreamPriority
+  {
+    static constexpr uint8_t max_urgency = 7;
+
+    uint8_t urgency = 3;
+    bool incremental = true;
+  };
+
   // Class for an established stream (a single connection has multiple streams): we have a
   // fixed-sized ring buffer for holding outgoing data, and a callback to invoke on received data.
   // To construct a Stream call `conn.open_stream()`.
@@ -201,6 +216,18 @@ namespace llarp::quic
       return is_closing;
     }
 
+    // Sets the send priority of this stream; urgencies above `StreamPriority::max_urgency` are
+    // treated as the max.
+    void
+    set_priority(StreamPriority p);
+
+    // Returns the send priority of this stream
+    const StreamPriority&
+    priority() const
+    {
+      return prio;
+    }
+
     // Callback invoked when data is received
     using data_callback_t = std::function<void(Stream&, bstring_view)>;
 
@@ -217,6 +244,18 @@ namespace llarp::quic
     // size of the data, just that this will always be called in sequential order.
     data_callback_t data_callback;
 
+    // May be called from within the data callback to signal that `bytes` of the data it was given
+    // have not yet been consumed (e.g. because they are queued for a slow write).  The flow control
+    // window is not reopened for these bytes until `consumed()` is called for them, so that a slow
+    // consumer holds back the remote sender rather than having data pile up here.
+    void
+    defer_consumed(size_t bytes);
+
+    // Reopens the flow control window for `bytes` of data previously held back with
+    // `defer_consumed()`.
+    void
+    consumed(size_t bytes);
+
     // Callback to invoke when the connection has closed.  If the close was an abrupt stream close
     // initiated by the remote then `error_code` will be set to whatever code the remote side
     // provided; for graceful closing or locally initiated closing the error code will be null.
@@ -333,7 +372,7 @@ namespace llarp::quic
     // ring buffer of outgoing stream data that has not yet been acknowledged.  This cannot be
     // resized once used as ngtcp2 will have pointers into the data.  If this is empty then we are
     // in user-provided buffer mode.
-    std::vector<std::byte> buffer{65536};
+    std::vector<std::byte, util::TaggedAllocator<std::byte, util::MemTag::QUIC>> buffer{65536};
 
     // user-provided buffers; only used when `buffer` is empty (via a `set_buffer_size(0)` or a 0
     // size given in the constructor).
@@ -353,6 +392,13 @@ namespace llarp::quic
     // description is ignoring the circularity of the buffer).
     size_t size{0};
 
+    // Bytes of received data deferred by the data callback currently being invoked, and the total
+    // deferred bytes not yet released by a `consumed()` call.
+    size_t deferring{0};
+    size_t deferred{0};
+
+    StreamPriority prio;
+
     bool is_new{true};
     bool is_closing{false};
     bool sent_fin{false};
@@ -6,8 +6,11 @@
 #include <limits>
 #include <llarp/util/logging.hpp>
 #include <llarp/util/logging/buffer.hpp>
+#include <llarp/util/buffer_pool.hpp>
 #include <llarp/util/str.hpp>
 #include <llarp/ev/libuv.hpp>
+#include <algorithm>
+#include <deque>
 #include <memory>
 #include <stdexcept>
 #include <type_traits>
@@ -51,9 +54,14 @@ namespace llarp::quic
       }
     }
 
+    // Received data that the TCP connection couldn't take right away, in the order it was handed to
+    // uv to write.  Each buffer goes back to the pool, and its size is credited back to the quic
+    // stream's flow control window, once uv tells us it has been written.
+    using write_backlog = std::deque<std::vector<byte_t>>;
+
     // Received data from the quic tunnel and sends it to the TCP connection
     void
-    on_incoming_data(Stream& stream, bstring_view bdata)
+    on_incoming_data(Stream& stream, bstring_view bdata, write_backlog& backlog)
     {
       auto tcp = stream.data<uvw::TCPHandle>();
       if (!tcp)
@@ -74,9 +82,13 @@ namespace llarp::quic
       {
         data.remove_prefix(written);
 
-        auto wdata = std::make_unique<char[]>(data.size());
-        std::copy(data.begin(), data.end(), wdata.get());
-        tcp->write(std::move(wdata), data.size());
+        // The packet buffer is only ours until we return, so the rest has to be copied; it goes
+        // into a pooled buffer, and until it has been written we hold back that much flow control
+        // credit so that a slow TCP client slows the sender rather than piling up data here.
+        auto& wdata = backlog.emplace_back(util::BufferPool::Acquire(
+            reinterpret_cast<const byte_t*>(data.data()), data.size()));
+        stream.defer_consumed(wdata.size());
+        tcp->write(reinterpret_cast<char*>(wdata.data()), wdata.size());
       }
     }
 
@@ -133,8 +145,21 @@ namespace llarp::quic
         }
         // tcp.closeReset();
       });
+      auto backlog = std::make_shared<write_backlog>();
+      tcp.on<uvw::WriteEvent>([backlog](auto&, uvw::TCPHandle& c) {
+        // Writes complete in order, so this is the one at the front of the backlog
+        if (backlog->empty())
+          return;
+        auto& wdata = backlog->front();
+        if (auto stream = c.data<Stream>())
+          stream->consumed(wdata.size());
+        util::BufferPool::Release(wdata);
+        backlog->pop_front();
+      });
       tcp.on<uvw::DataEvent>(on_outgoing_data);
-      stream.data_callback = on_incoming_data;
+      stream.data_callback = [backlog](Stream& s, bstring_view data) {
+        on_incoming_data(s, data, *backlog);
+      };
       stream.close_callback = close_tcp_pair;
     }
     // This initial data handler is responsible for pulling off the initial stream data that comes
@@ -202,6 +227,56 @@ namespace llarp::quic
         client.close();
     }
 
+    using DirectStream = TunnelManager::DirectStream;
+
+    // Hands a stream over to the callbacks of a direct stream, which it holds on to for as long as
+    // it is open.
+    void
+    install_direct(Stream& stream, std::shared_ptr<DirectStream> direct)
+    {
+      stream.data(std::move(direct));
+      stream.data_callback = [](Stream& s, bstring_view data) {
+        if (auto direct = s.data<DirectStream>(); direct and direct->on_data)
+          direct->on_data(s, data);
+      };
+      stream.close_callback = [](Stream& s, std::optional<uint64_t> error_code) {
+        auto direct = s.data<DirectStream>();
+        s.data(nullptr);
+        if (direct and direct->on_close)
+          direct->on_close(s, error_code);
+      };
+    }
+
+    // The direct stream version of initial_client_data_handler: once the remote's CONNECT_INIT
+    // arrives the stream is open, and goes over to the app's callbacks.
+    void
+    initial_direct_data_handler(
+        Stream& stream, bstring_view bdata, const std::shared_ptr<DirectStream>& direct)
+    {
+      if (bdata.empty())
+        return;
+      if (bdata[0] != tunnel::CONNECT_INIT)
+      {
+        LogWarn(
+            "Remote connection returned invalid initial byte (0x",
+            oxenc::to_hex(bdata.begin(), bdata.begin() + 1),
+            "); dropping direct stream");
+        stream.close(tunnel::ERROR_BAD_INIT);
+        if (auto on_open = std::exchange(direct->on_open, nullptr))
+          on_open(nullptr);
+        return;
+      }
+      install_direct(stream, direct);
+      if (auto on_open = std::exchange(direct->on_open, nullptr))
+        on_open(stream.shared_from_this());
+      if (bdata.size() > 1)
+      {
+        bdata.remove_prefix(1);
+        stream.data_callback(stream, bdata);
+      }
+      stream.io_ready();
+    }
+
   }  // namespace
 
   TunnelManager::TunnelManager(EndpointBase& se) : service_endpoint_{se}
@@ -213,6 +288,15 @@ namespace llarp::quic
       {
         // Clear any accepted connections that have been closed:
         auto& [port, ct] = *ctit;
+        ct.direct.erase(
+            std::remove_if(
+                ct.direct.begin(),
+                ct.direct.end(),
+                [](const auto& weak) {
+                  auto stream = weak.lock();
+                  return not stream or stream->closing();
+                }),
+            ct.direct.end());
         for (auto it = ct.conns.begin(); it != ct.conns.end();)
         {
           // TCP connections keep a shared_ptr to their quic::Stream while open and clear it when
@@ -228,8 +312,11 @@ namespace llarp::quic
         }
 
         // If there are not accepted connections left *and* we stopped listening for new ones then
-        // destroy the whole thing.
-        if (ct.conns.empty() and (not ct.tcp or not ct.tcp->active()))
+        // destroy the whole thing, unless other tunnels are still using the quic client we made.
+        const bool client_in_use =
+            ct.client and ct.client_pport == port and ct.client.use_count() > 1;
+        if (ct.conns.empty() and ct.direct.empty() and ct.pending_direct.empty()
+            and (not ct.tcp or not ct.tcp->active()) and not client_in_use)
         {
           LogDebug("All sockets closed on quic:", port, ", destroying tunnel data");
           ctit = client_tunnels_.erase(ctit);
@@ -247,6 +334,7 @@ namespace llarp::quic
     // auto loop = get_loop();
 
     server_ = std::make_unique<Server>(service_endpoint_);
+    server_->connection_settings = connection_settings;
     server_->stream_open_callback = [this](Stream& stream, uint16_t port) -> bool {
       stream.close_callback = close_tcp_pair;
 
@@ -259,6 +347,30 @@ namespace llarp::quic
       }
 
       auto lokinet_addr = var::visit([](auto&& remote) { return remote.ToString(); }, *remote);
+      if (auto handlers = allow_direct(lokinet_addr, port))
+      {
+        LogInfo("quic stream from ", lokinet_addr, " to ", port, " handed over directly");
+        auto direct = std::make_shared<DirectStream>(std::move(*handlers));
+        // The connection only takes on the stream once we return, so the app gets it (and
+        // CONNECT_INIT goes back) on the next tick; the client sends nothing before then.
+        stream.data_callback = [](Stream&, bstring_view) {};
+        service_endpoint_.Loop()->call_soon([streamw = stream.weak_from_this(), direct] {
+          auto stream = streamw.lock();
+          auto on_open = std::exchange(direct->on_open, nullptr);
+          if (not stream or stream->closing())
+          {
+            if (on_open)
+              on_open(nullptr);
+            return;
+          }
+          install_direct(*stream, direct);
+          stream->append_buffer(new std::byte[1]{tunnel::CONNECT_INIT}, 1);
+          if (on_open)
+            on_open(stream);
+          stream->io_ready();
+        });
+        return true;
+      }
       auto tunnel_to = allow_connection(lokinet_addr, port);
       if (not tunnel_to)
         return false;
@@ -331,10 +443,52 @@ namespace llarp::quic
     });
   }
 
+  int
+  TunnelManager::listen_direct(DirectListenHandler handler)
+  {
+    if (!handler)
+      throw std::logic_error{"Cannot call listen_direct() with a null handler"};
+    assert(service_endpoint_.Loop()->inEventLoop());
+    if (not server_)
+      make_server();
+
+    int id = next_handler_id_++;
+    incoming_direct_handlers_.emplace_hint(
+        incoming_direct_handlers_.end(), id, std::move(handler));
+    return id;
+  }
+
   void
   TunnelManager::forget(int id)
   {
     incoming_handlers_.erase(id);
+    incoming_direct_handlers_.erase(id);
+  }
+
+  std::optional<TunnelManager::DirectStream>
+  TunnelManager::allow_direct(std::string_view lokinet_addr, uint16_t port)
+  {
+    for (auto& [id, handler] : incoming_direct_handlers_)
+    {
+      try
+      {
+        if (auto handlers = handler(lokinet_addr, port))
+          return handlers;
+      }
+      catch (const std::exception& e)
+      {
+        LogWarn(
+            "Incoming direct quic stream from ",
+            lokinet_addr,
+            " to ",
+            port,
+            " denied via exception (",
+            e.what(),
+            ")");
+        return std::nullopt;
+      }
+    }
+    return std::nullopt;
   }
 
   std::optional<SockAddr>
@@ -419,7 +573,8 @@ namespace llarp::quic
     if (!step_success)
     {
       LogWarn("QUIC tunnel to ", addr, " failed during ", step_name, "; aborting tunnel");
-      it->second.tcp->close();
+      if (it->second.tcp)
+        it->second.tcp->close();
       if (it->second.open_cb)
         it->second.open_cb(false);
       client_tunnels_.erase(it);
@@ -429,7 +584,11 @@ namespace llarp::quic
 
   std::pair<SockAddr, uint16_t>
   TunnelManager::open(
-      std::string_view remote_address, uint16_t port, OpenCallback on_open, SockAddr bind_addr)
+      std::string_view remote_address,
+      uint16_t port,
+      OpenCallback on_open,
+      SockAddr bind_addr,
+      StreamPriority priority)
   {
     std::string remote_addr = lowercase_ascii_string(std::string{remote_address});
 
@@ -486,13 +645,15 @@ namespace llarp::quic
     auto bound = tcp_tunnel->sock();
     saddr = SockAddr{bound.ip, huint16_t{static_cast<uint16_t>(bound.port)}};
 
-    // Find the first unused psuedo-port value starting from next_pseudo_port_.
-    if (auto p = find_unused_key(client_tunnels_, next_pseudo_port_))
-      pport = *p;
-    else
-      throw std::runtime_error{
-          "Unable to open an outgoing quic connection: too many existing connections"};
-    (next_pseudo_port_ = pport)++;
+    try
+    {
+      pport = next_pseudo_port();
+    }
+    catch (...)
+    {
+      tcp_tunnel->close();
+      throw;
+    }
 
     LogInfo("Bound TCP tunnel ", saddr, " for quic client :", pport);
 
@@ -501,12 +662,92 @@ namespace llarp::quic
     assert(client_tunnels_.count(pport) == 0);
     auto& ct = client_tunnels_[pport];
     ct.open_cb = std::move(on_open);
+    ct.priority = priority;
     ct.tcp = std::move(tcp_tunnel);
     // We use this pport shared_ptr value on the listening tcp socket both to hand to pport into the
     // accept handler, and to let the accept handler know that `this` is still safe to use.
     ct.tcp->data(std::make_shared<uint16_t>(pport));
 
-    auto after_path = [this, port, pport = pport, remote_addr](auto maybe_convo) {
+    start_connecting(pport, std::move(remote_addr), port);
+    return result;
+  }
+
+  uint16_t
+  TunnelManager::open_direct(
+      std::string_view remote_address,
+      uint16_t port,
+      DirectStream handlers,
+      StreamPriority priority)
+  {
+    std::string remote_addr = lowercase_ascii_string(std::string{remote_address});
+    if (not service::ParseAddress(remote_addr) and not service::NameIsValid(remote_addr))
+      throw std::invalid_argument{"Invalid remote lokinet name/address"};
+
+    const auto pport = next_pseudo_port();
+    LogInfo("Opening direct stream to ", remote_addr, ":", port, " on quic client :", pport);
+
+    auto& ct = client_tunnels_[pport];
+    ct.priority = priority;
+    ct.pending_direct.push(std::move(handlers));
+
+    start_connecting(pport, std::move(remote_addr), port);
+    return pport;
+  }
+
+  bool
+  TunnelManager::write_direct(Stream& stream, bstring_view data)
+  {
+    auto direct = stream.data<DirectStream>();
+    if (not direct or stream.closing())
+      return false;
+    if (stream.used() >= tunnel::PAUSE_SIZE)
+    {
+      if (not std::exchange(direct->blocked, true))
+      {
+        stream.when_available([](Stream& s) {
+          if (s.used() >= tunnel::PAUSE_SIZE)
+            return false;
+          if (auto direct = s.data<DirectStream>())
+          {
+            direct->blocked = false;
+            if (direct->on_writable)
+              direct->on_writable(s);
+          }
+          return true;
+        });
+      }
+      return false;
+    }
+    if (data.empty())
+      return true;
+    // Tunnel streams hold their data in buffers they own, so this is the one copy of it we make
+    auto* buf = new std::byte[data.size()];
+    std::copy(data.begin(), data.end(), buf);
+    stream.append_buffer(buf, data.size());
+    stream.io_ready();
+    return true;
+  }
+
+  uint16_t
+  TunnelManager::next_pseudo_port()
+  {
+    // Find the first unused psuedo-port value starting from next_pseudo_port_.
+    uint16_t pport;
+    if (auto p = find_unused_key(client_tunnels_, next_pseudo_port_))
+      pport = *p;
+    else
+      throw std::runtime_error{
+          "Unable to open an outgoing quic connection: too many existing connections"};
+    (next_pseudo_port_ = pport)++;
+    return pport;
+  }
+
+  void
+  TunnelManager::start_connecting(uint16_t pport, std::string remote_addr, uint16_t port)
+  {
+    auto maybe_remote = service::ParseAddress(remote_addr);
+
+    auto after_path = [this, port, pport, remote_addr](auto maybe_convo) {
       if (not continue_connecting(pport, (bool)maybe_convo, "path build", remote_addr))
         return;
       SockAddr dest{maybe_convo->ToV6()};
@@ -520,17 +761,15 @@ namespace llarp::quic
       // then we have to build a path to that address.
       service_endpoint_.LookupNameAsync(
           remote_addr,
-          [this,
-           after_path = std::move(after_path),
-           pport = pport,
-           remote_addr = std::move(remote_addr)](auto maybe_remote) {
+          [this, after_path = std::move(after_path), pport, remote_addr = std::move(remote_addr)](
+              auto maybe_remote) {
             if (not continue_connecting(
                     pport, (bool)maybe_remote, "endpoint ONS lookup", remote_addr))
               return;
             service_endpoint_.MarkAddressOutbound(*maybe_remote);
             service_endpoint_.EnsurePathTo(*maybe_remote, after_path, open_timeout);
           });
-      return result;
+      return;
     }
 
     auto& remote = *maybe_remote;
@@ -543,8 +782,6 @@ namespace llarp::quic
       service_endpoint_.MarkAddressOutbound(remote);
       service_endpoint_.EnsurePathTo(remote, after_path, open_timeout);
     }
-
-    return result;
   }
 
   void
@@ -579,6 +816,14 @@ namespace llarp::quic
       }
       pending_incoming.pop();
     }
+
+    // A direct stream that never got to open learns of it here, whatever the reason
+    while (not pending_direct.empty())
+    {
+      if (auto on_open = std::exchange(pending_direct.front().on_open, nullptr))
+        on_open(nullptr);
+      pending_direct.pop();
+    }
   }
 
   void
@@ -587,13 +832,37 @@ namespace llarp::quic
     assert(remote.getPort() > 0);
     auto& [pport, tunnel] = row;
     assert(not tunnel.client);
-    tunnel.client = std::make_unique<Client>(service_endpoint_, remote, pport);
+    tunnel.remote = remote;
+
+    // If we already have a connection to the same remote address and port that isn't going away
+    // and still has (or, while handshaking, may soon have) streams to spare then we open our
+    // streams over that rather than paying for another handshake and congestion controller.
+    for (auto& [id, other] : client_tunnels_)
+    {
+      if (not other.client or other.remote != remote)
+        continue;
+      auto conn = other.client->get_connection();
+      if (not conn or conn->closing or conn->draining)
+        continue;
+      if (conn->get_handshake_completed() and conn->get_streams_available() <= 0)
+        continue;
+      LogDebug("QUIC tunnel :", pport, " sharing connection of tunnel :", other.client_pport);
+      tunnel.client = other.client;
+      tunnel.client_pport = other.client_pport;
+      flush_pending_incoming(tunnel);
+      return;
+    }
+
+    tunnel.client = std::make_shared<Client>(service_endpoint_, remote, pport, connection_settings);
+    tunnel.client_pport = pport;
     auto conn = tunnel.client->get_connection();
 
-    conn->on_stream_available = [this, id = row.first](Connection&) {
+    conn->on_stream_available = [this, id = pport, client = tunnel.client.get()](Connection&) {
       LogDebug("QUIC connection :", id, " established; streams now available");
-      if (auto it = client_tunnels_.find(id); it != client_tunnels_.end())
-        flush_pending_incoming(it->second);
+      // Every tunnel sharing the connection may have connections waiting for a stream
+      for (auto& [pport, ct] : client_tunnels_)
+        if (ct.client.get() == client)
+          flush_pending_incoming(ct);
     };
   }
 
@@ -622,6 +891,7 @@ namespace llarp::quic
             [tcp_client](auto&&... args) {
               initial_client_close_handler(*tcp_client, std::forward<decltype(args)>(args)...);
             });
+        str->set_priority(ct.priority);
         available--;
       }
       catch (const std::exception& e)
@@ -633,6 +903,36 @@ namespace llarp::quic
       LogTrace("Set up new stream");
       conn.io_ready();
     }
+
+    while (available > 0 and not ct.pending_direct.empty())
+    {
+      auto direct = std::make_shared<DirectStream>(std::move(ct.pending_direct.front()));
+      ct.pending_direct.pop();
+      try
+      {
+        auto str = conn.open_stream(
+            [direct](Stream& s, bstring_view data) {
+              initial_direct_data_handler(s, data, direct);
+            },
+            [direct](Stream&, std::optional<uint64_t> error_code) {
+              LogDebug(
+                  "Direct stream closed before it opened",
+                  error_code ? " with error " + std::to_string(*error_code) : "");
+              if (auto on_open = std::exchange(direct->on_open, nullptr))
+                on_open(nullptr);
+            });
+        str->set_priority(ct.priority);
+        ct.direct.push_back(str);
+        available--;
+      }
+      catch (const std::exception& e)
+      {
+        LogWarn("Opening direct quic stream failed: ", e.what());
+        if (auto on_open = std::exchange(direct->on_open, nullptr))
+          on_open(nullptr);
+      }
+      conn.io_ready();
+    }
   }
 
   void
@@ -49,6 +49,10 @@ namespace llarp::quic
     // includes the resolution time.
     std::chrono::milliseconds open_timeout = 4s;
 
+    // Congestion and flow control for the quic connections of tunnels opened, and of the server
+    // made by the first `listen()`, after this is set.
+    ConnectionSettings connection_settings;
+
     TunnelManager(EndpointBase& endpoint);
 
     /// Adds an incoming listener callback.  When a new incoming quic connection is initiated to us
@@ -73,6 +77,36 @@ namespace llarp::quic
     int
     listen(SockAddr port);
 
+    /// Callbacks for a tunnelled stream that is read and written in process (e.g. by an app
+    /// embedding lokinet) rather than through a localhost TCP socket, so its data skips the
+    /// loopback hop both ways.  All are invoked on the event loop thread.
+    struct DirectStream
+    {
+      // Invoked once, with the stream once it is connected end to end, or with nullptr if the
+      // tunnel or stream failed before it got that far.
+      std::function<void(std::shared_ptr<Stream>)> on_open;
+      // Invoked with data from the remote; the data is only valid for the duration of the call.
+      Stream::data_callback_t on_data;
+      // Invoked once there is room again after `write_direct()` refused data.
+      std::function<void(Stream&)> on_writable;
+      // Invoked when an opened stream closes, as for Stream::close_callback.
+      Stream::close_callback_t on_close;
+      // Set while `write_direct()` is waiting for room to call on_writable
+      bool blocked = false;
+    };
+
+    using DirectListenHandler = std::function<std::optional<DirectStream>(
+        std::string_view lokinet_addr,  // The remote's full lokinet address
+        uint16_t port                   // The requested port the tunnel wants to reach
+        )>;
+
+    /// Adds an incoming listener callback like `listen()`, except that streams it accepts (by
+    /// returning callbacks rather than nullopt) are handed to those callbacks rather than
+    /// connected to a TCP address.  These handlers are tried before the `listen()` ones; the ID
+    /// returned is removed with `forget()`.
+    int
+    listen_direct(DirectListenHandler handler);
+
     /// Removes an incoming connection handler; takes the ID returned by `listen()`.
     void
     forget(int id);
@@ -91,6 +125,8 @@ namespace llarp::quic
     /// out.
     /// \param bind_addr is the bind address and port that we should use for the localhost TCP
     /// connection.  Use port 0 to let the OS choose a random high port.  Defaults to `127.0.0.1:0`.
+    /// \param priority is the send priority of the streams of this tunnel, relative to those of
+    /// other tunnels sharing the same QUIC connection.
     ///
     /// This call immediately opens the local TCP socket, and initiates the lokinet connection and
     /// QUIC tunnel to the remote.  If the connection fails, the TCP socket will be closed.  Note,
@@ -98,6 +134,8 @@ namespace llarp::quic
     /// established.
     ///
     /// Each connection to the local TCP socket establishes a new stream over the QUIC connection.
+    /// Tunnels opened to the same remote and port share one QUIC connection (and so its handshake
+    /// and congestion control) as long as it has streams to spare.
     ///
     /// \return a pair:
     /// - SockAddr containing the just-opened localhost socket that tunnels to the remote.  This is
@@ -115,7 +153,28 @@ namespace llarp::quic
         std::string_view remote_addr,
         uint16_t port,
         OpenCallback on_open = {},
-        SockAddr bind_addr = {127, 0, 0, 1});
+        SockAddr bind_addr = {127, 0, 0, 1},
+        StreamPriority priority = {});
+
+    /// Opens a single stream to some remote lokinet address and port, like a connection to the
+    /// socket of a tunnel made with `open()`, but with no local TCP socket: the stream's data goes
+    /// to and from `handlers`.  The stream shares a QUIC connection with other tunnels to the same
+    /// remote and port, as with `open()`.  (Should only be called from the event loop thread.)
+    ///
+    /// Returns the pseudo-port of the tunnel, which is cleaned up once the stream has closed.
+    /// Throws std::invalid_argument if remote_addr is neither an address nor an ONS name.
+    uint16_t
+    open_direct(
+        std::string_view remote_addr,
+        uint16_t port,
+        DirectStream handlers,
+        StreamPriority priority = {});
+
+    /// Queues data on a stream from `open_direct()` or `listen_direct()`.  Returns false, without
+    /// queuing any of it, while the stream has `tunnel::PAUSE_SIZE` or more bytes in flight or is
+    /// closing; on_writable is then invoked once it has room again.
+    static bool
+    write_direct(Stream& stream, bstring_view data);
 
     /// Start closing an outgoing tunnel; takes the ID returned by `open()`.  Note that an existing
     /// established tunneled connections will not be forcibly closed; this simply stops accepting
@@ -135,7 +194,7 @@ namespace llarp::quic
     inline bool
     hasListeners() const
     {
-      return not incoming_handlers_.empty();
+      return not(incoming_handlers_.empty() and incoming_direct_handlers_.empty());
     }
 
    private:
@@ -143,10 +202,19 @@ namespace llarp::quic
 
     struct ClientTunnel
     {
-      // quic endpoint
-      std::unique_ptr<Client> client;
+      // quic endpoint; this is shared by any later tunnels to the same remote address and port that
+      // pool its connection rather than making their own.
+      std::shared_ptr<Client> client;
+      // Pseudo-port of the tunnel that made `client` (our own pseudo-port if we made it): incoming
+      // packets for the client are routed to that tunnel, so it is kept around until no other
+      // tunnel is using its client.
+      uint16_t client_pport = 0;
+      // The remote lokinet address and port the client connects to
+      SockAddr remote;
       // Callback to invoke on quic connection established (true argument) or failed (false arg)
       OpenCallback open_cb;
+      // Send priority of the streams we open for accepted TCP connections
+      StreamPriority priority;
       // TCP listening socket
       std::shared_ptr<uvw::TCPHandle> tcp;
       // Accepted TCP connections
@@ -154,6 +222,10 @@ namespace llarp::quic
       // Queue of incoming connections that are waiting for a stream to become available (either
       // because we are still handshaking, or we reached the stream limit).
       std::queue<std::weak_ptr<uvw::TCPHandle>> pending_incoming;
+      // Likewise for a tunnel from `open_direct()`, which has no TCP socket: the stream it is
+      // waiting to open, and then the stream itself.
+      std::queue<DirectStream> pending_direct;
+      std::vector<std::weak_ptr<Stream>> direct;
 
       ~ClientTunnel();
     };
@@ -165,10 +237,21 @@ namespace llarp::quic
     uint16_t next_pseudo_port_ = 0;
     // bool pport_wrapped_ = false;
 
+    // Finds the next free pseudo-port for a client tunnel; throws if there are none.
+    uint16_t
+    next_pseudo_port();
+
+    // Starts getting a path (after an ONS lookup, if remote_addr is a name) to the remote of a
+    // client tunnel just added, to then make its quic client to.
+    void
+    start_connecting(uint16_t pseudo_port, std::string remote_addr, uint16_t port);
+
     bool
     continue_connecting(
         uint16_t pseudo_port, bool step_success, std::string_view step_name, std::string_view addr);
 
+    // Sets up the quic client for a tunnel: this reuses the connection of an existing tunnel to the
+    // same remote when that connection can take more streams, and otherwise makes a new one.
     void
     make_client(const SockAddr& remote, std::pair<const uint16_t, ClientTunnel>& row);
 
@@ -191,8 +274,13 @@ namespace llarp::quic
     std::optional<SockAddr>
     allow_connection(std::string_view lokinet_addr, uint16_t port);
 
+    // Likewise for the `listen_direct()` handlers, returning the callbacks to hand the stream to.
+    std::optional<DirectStream>
+    allow_direct(std::string_view lokinet_addr, uint16_t port);
+
     // Incoming stream handlers
     std::map<int, ListenHandler> incoming_handlers_;
+    std::map<int, DirectListenHandler> incoming_direct_handlers_;
     int next_handler_id_ = 1;
 
     std::shared_ptr<uvw::Loop>
@@ -5,6 +5,8 @@
 #include <memory>
 #include <llarp/util/types.hpp>
 #include <llarp/util/status.hpp>
+#include <llarp/util/thread/crypto_pool.hpp>
+#include <llarp/util/thread/work_scheduler.hpp>
 #include "i_outbound_message_handler.hpp"
 #include <vector>
 #include <llarp/ev/ev.hpp>
@@ -154,8 +156,52 @@ namespace llarp
     virtual const EventLoop_ptr&
     loop() const = 0;
 
-    /// call function in crypto worker
-    virtual void QueueWork(std::function<void(void)>) = 0;
+    /// call function in crypto worker; jobs of a more urgent class go ahead of queued ones of a
+    /// less urgent one
+    virtual void
+    QueueWork(
+        std::function<void(void)> func,
+        thread::WorkClass cls = thread::WorkClass::Background) = 0;
+
+    /// call function in the crypto worker that shard maps to; work queued with the same shard
+    /// runs in order on the same thread.  falls back to QueueWork if there are no dedicated
+    /// workers.
+    virtual void
+    QueueShardedWork(uint64_t /*shard*/, thread::InlineTask func)
+    {
+      QueueWork(
+          [func = std::make_shared<thread::InlineTask>(std::move(func))] { (*func)(); },
+          thread::WorkClass::DataPlane);
+    }
+
+    /// call function in the path traffic worker that shard maps to; like QueueShardedWork but for
+    /// onion crypto of path traffic, so a path's batches run in order on one thread and relayed
+    /// traffic spreads over its own cores rather than the link crypto ones.  falls back to
+    /// QueueWork if there are no dedicated workers.
+    virtual void
+    QueuePathWork(uint64_t /*shard*/, thread::InlineTask func)
+    {
+      QueueWork(
+          [func = std::make_shared<thread::InlineTask>(std::move(func))] { (*func)(); },
+          thread::WorkClass::DataPlane);
+    }
+
+    /// call function in the path build workers, which have threads of their own on relays so that
+    /// path builds don't queue up behind traffic crypto.  falls back to QueueWork.
+    virtual void
+    QueuePathBuildWork(std::function<void(void)> func)
+    {
+      QueueWork(std::move(func), thread::WorkClass::PathBuild);
+    }
+
+    /// call function in the key exchange worker, which has a thread of its own so that convos
+    /// being started don't queue up behind established convos' traffic, nor it behind them.
+    /// falls back to QueueWork.
+    virtual void
+    QueueKeyExchangeWork(std::function<void(void)> func)
+    {
+      QueueWork(std::move(func), thread::WorkClass::PathBuild);
+    }
 
     /// call function in disk io thread
     virtual void QueueDiskIO(std::function<void(void)>) = 0;
@@ -317,9 +363,25 @@ namespace llarp
         const std::vector<RouterID>& greylist,
         const std::vector<RouterID>& unfundedlist) = 0;
 
+    /// apply changes to router's service node whitelist: routers newly in (or moved to) each
+    /// list, and routers no longer registered at all
+    virtual void
+    UpdateRouterWhitelist(
+        const std::vector<RouterID>& whitelist,
+        const std::vector<RouterID>& greylist,
+        const std::vector<RouterID>& unfundedlist,
+        const std::vector<RouterID>& removed) = 0;
+
     virtual std::unordered_set<RouterID>
     GetRouterWhitelist() const = 0;
 
+    /// apply what changed in [network] and [dns] of a reloaded config to the running router,
+    /// without tearing down its links, paths or sessions; must be called on the loop.  returns
+    /// the settings that changed but can only take effect on a restart, which are left as they
+    /// were.  other sections are not reloaded at all.
+    virtual std::vector<std::string>
+    Reconfigure(std::shared_ptr<Config> conf) = 0;
+
     /// visit each connected link session
     virtual void
     ForEachPeer(std::function<void(const ILinkSession*, bool)> visit, bool randomize) const = 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <llarp/util/status.hpp>
+#include <llarp/util/time.hpp>
 
 #include <cstdint>
 #include <functional>
@@ -40,6 +41,11 @@ namespace llarp
     virtual void
     RemovePath(const PathID_t& pathid) = 0;
 
+    /// smoothed time the messages for pathid waited in its queue before going out, 0s if it
+    /// has not had any of late
+    virtual llarp_time_t
+    QueueDelay(const PathID_t& pathid) const = 0;
+
     virtual util::StatusObject
     ExtractStatus() const = 0;
   };
@@ -67,6 +67,11 @@ namespace llarp
 
     virtual bool
     ShouldConnectTo(const RouterID& router) const = 0;
+
+    /// whether our last attempt to connect to router failed not long ago, in which case
+    /// another is not worth making yet
+    virtual bool
+    IsRecentlyFailed(const RouterID& router) const = 0;
   };
 
 }  // namespace llarp
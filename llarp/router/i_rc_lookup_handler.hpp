@@ -38,6 +38,15 @@ namespace llarp
         const std::vector<RouterID>& greylist,
         const std::vector<RouterID>& greenlist) = 0;
 
+    /// apply changes to the service node lists rather than replacing them: routers newly in (or
+    /// moved to) each list, and routers gone from all of them
+    virtual void
+    UpdateRouterWhitelist(
+        const std::vector<RouterID>& whitelist,
+        const std::vector<RouterID>& greylist,
+        const std::vector<RouterID>& greenlist,
+        const std::vector<RouterID>& removed) = 0;
+
     virtual void
     GetRC(const RouterID& router, RCRequestCallback callback, bool forceLookup = false) = 0;
 
@@ -59,6 +68,11 @@ namespace llarp
     virtual bool
     CheckRC(const RouterContact& rc) const = 0;
 
+    /// CheckRC for many rcs at once, with their signatures verified as one batch; returns whether
+    /// each one passed, in the order given
+    virtual std::vector<bool>
+    CheckRCs(const std::vector<RouterContact>& rcs) const = 0;
+
     virtual bool
     GetRandomWhitelistRouter(RouterID& router) const = 0;
 
@@ -71,6 +85,10 @@ namespace llarp
     virtual void
     ExploreNetwork() = 0;
 
+    /// how long to wait before the next ExploreNetwork, going by what the last one found
+    virtual llarp_time_t
+    ExploreInterval() const = 0;
+
     virtual size_t
     NumberOfStrictConnectRouters() const = 0;
 
@@ -2,12 +2,18 @@
 
 #include <llarp/messages/link_message.hpp>
 #include "router.hpp"
+#include <llarp/config/config.hpp>
 #include <llarp/constants/link_layer.hpp>
+#include <llarp/util/buffer_pool.hpp>
+#include <llarp/util/mem_account.hpp>
 #include <llarp/util/meta/memfn.hpp>
+#include <llarp/util/metrics.hpp>
 #include <llarp/util/status.hpp>
+#include <llarp/util/trace.hpp>
 
 #include <algorithm>
 #include <cstdlib>
+#include <limits>
 
 namespace llarp
 {
@@ -15,8 +21,29 @@ namespace llarp
 
   using namespace std::chrono_literals;
 
+  /// bytes a path earns per visit of the round robin; at least the biggest message, so that
+  /// any path with something queued can always send on its turn
+  static constexpr int64_t RoundRobinQuantum = MAX_LINK_MSG_SIZE;
+
+  /// how soon to look again when all that's left is waiting on a bandwidth cap
+  static constexpr auto ThrottleWakeup = 10ms;
+
+  namespace
+  {
+    metrics::Histogram pathQueueWait{
+        "lokinet_path_queue_wait_milliseconds",
+        "Time a message on a path, ours or one we relay, waited in its queue before going out"};
+  }  // namespace
+
+  /// rate is in bytes/s; a quarter second's worth of burst, and a few messages at the least
+  static util::TokenBucket
+  MakeBucket(uint64_t rate)
+  {
+    return {rate, std::max<uint64_t>(rate / 4, 4 * MAX_LINK_MSG_SIZE)};
+  }
+
   OutboundMessageHandler::OutboundMessageHandler(size_t maxQueueSize)
-      : outboundQueue(maxQueueSize), recentlyRemovedPaths(5s), removedSomePaths(false)
+      : m_MaxIncoming(maxQueueSize), recentlyRemovedPaths(5s), removedSomePaths(false)
   {}
 
   bool
@@ -35,6 +62,8 @@ namespace llarp
     ent.inform = std::move(callback);
     ent.pathid = msg.pathid;
     ent.priority = msg.Priority();
+    ent.sequence = m_NextSequence++;
+    ent.queuedAt = _router->Now();
 
     std::array<byte_t, MAX_LINK_MSG_SIZE> linkmsg_buffer;
     llarp_buffer_t buf{linkmsg_buffer};
@@ -44,38 +73,11 @@ namespace llarp
       return false;
     }
 
-    ent.message.resize(buf.sz);
-
-    std::copy_n(buf.base, buf.sz, ent.message.data());
-
-    // if we have a session to the destination, queue the message and return
-    if (_router->linkManager().HasSessionTo(remote))
-    {
-      QueueOutboundMessage(std::move(ent));
-      return true;
-    }
-
-    // if we don't have a session to the destination, queue the message onto
-    // a special pending session queue for that destination, and then create
-    // that pending session if there is not already a session establish attempt
-    // in progress.
-    bool shouldCreateSession = false;
-    {
-      util::Lock l{_mutex};
-
-      // create queue for <remote> if it doesn't exist, and get iterator
-      auto [queue_itr, is_new] = pendingSessionMessageQueues.emplace(remote, MessageQueue());
-      queue_itr->second.push(std::move(ent));
-
-      shouldCreateSession = is_new;
-    }
-
-    if (shouldCreateSession)
-    {
-      QueueSessionCreation(remote);
-    }
+    // a pooled buffer of the size class that fits, rather than a fresh one per message
+    ent.message = util::BufferPool::Acquire(buf.base, buf.sz);
+    util::MemAccount::Allocated(util::MemTag::Link, ent.message.capacity());
 
-    return true;
+    return QueueOutboundMessage(std::move(ent));
   }
 
   void
@@ -83,11 +85,11 @@ namespace llarp
   {
     m_Killer.TryAccess([this]() {
       recentlyRemovedPaths.Decay();
-      ProcessOutboundQueue();
+      const bool unsorted = ProcessOutboundQueue();
       // TODO: this probably shouldn't be pumping, as it defeats the purpose
       // of having a limit on sends per tick, but chaning it is potentially bad
       // and requires testing so it should be changed later.
-      if (/*bool more = */ SendRoundRobin())
+      if (/*bool more = */ SendRoundRobin() or unsorted)
         _router->TriggerPump();
     });
   }
@@ -106,23 +108,44 @@ namespace llarp
       auto itr = outboundMessageQueues.find(pathid);
       if (itr != outboundMessageQueues.end())
       {
+        // out of the round robin too, or should the path come back it would be in there twice
+        if (itr->second.active)
+        {
+          for (size_t n = roundRobinOrder.size(); n > 0; --n)
+          {
+            if (roundRobinOrder.front() != pathid)
+              roundRobinOrder.push(std::move(roundRobinOrder.front()));
+            roundRobinOrder.pop();
+          }
+        }
+        for (auto& messages = itr->second.messages; not messages.empty(); messages.pop())
+          Release(messages.top());
         outboundMessageQueues.erase(itr);
       }
       removedSomePaths = true;
     });
   }
 
+  llarp_time_t
+  OutboundMessageHandler::QueueDelay(const PathID_t& pathid) const
+  {
+    if (auto itr = outboundMessageQueues.find(pathid); itr != outboundMessageQueues.end())
+      return std::chrono::milliseconds{static_cast<int64_t>(itr->second.queueDelay)};
+    return 0s;
+  }
+
   util::StatusObject
   OutboundMessageHandler::ExtractStatus() const
   {
     util::StatusObject status{
         "queueStats",
         {{"queued", m_queueStats.queued},
-         {"dropped", m_queueStats.dropped},
+         {"dropped", m_queueStats.dropped + m_IncomingDropped.load()},
          {"sent", m_queueStats.sent},
          {"queueWatermark", m_queueStats.queueWatermark},
          {"perTickMax", m_queueStats.perTickMax},
-         {"numTicks", m_queueStats.numTicks}}};
+         {"numTicks", m_queueStats.numTicks},
+         {"throttled", m_queueStats.throttled}}};
 
     return status;
   }
@@ -131,7 +154,16 @@ namespace llarp
   OutboundMessageHandler::Init(AbstractRouter* router)
   {
     _router = router;
-    outboundMessageQueues.emplace(zeroID, MessageQueue());
+    outboundMessageQueues.try_emplace(zeroID);
+
+    if (const auto conf = router->GetConfig())
+    {
+      // configured in kB/s
+      m_PathRate = uint64_t{1000} * conf->router.m_PathBandwidth;
+      m_PeerRate = uint64_t{1000} * conf->router.m_PeerBandwidth;
+      if (conf->router.m_RelayBandwidth)
+        m_RelayBucket = MakeBucket(uint64_t{1000} * conf->router.m_RelayBandwidth);
+    }
   }
 
   static inline SendStatus
@@ -190,13 +222,21 @@ namespace llarp
     return true;
   }
 
+  void
+  OutboundMessageHandler::Release(const MessageQueueEntry& entry)
+  {
+    util::MemAccount::Freed(util::MemTag::Link, entry.message.capacity());
+    util::BufferPool::Release(entry.message);
+  }
+
   bool
   OutboundMessageHandler::Send(const MessageQueueEntry& ent)
   {
     const llarp_buffer_t buf{ent.message};
+    LLARP_TRACE(outbound_send, trace::ID(ent.router), buf.sz, ent.priority);
     m_queueStats.sent++;
     SendStatusHandler callback = ent.inform;
-    return _router->linkManager().SendTo(
+    const bool sent = _router->linkManager().SendTo(
         ent.router,
         buf,
         [this, callback](ILinkSession::DeliveryStatus status) {
@@ -208,6 +248,9 @@ namespace llarp
           }
         },
         ent.priority);
+    // the link layer copies what it sends, so the buffer is done with
+    Release(ent);
+    return sent;
   }
 
   bool
@@ -223,56 +266,84 @@ namespace llarp
   bool
   OutboundMessageHandler::QueueOutboundMessage(MessageQueueEntry entry)
   {
-    // copy callback in case we need to call it, so we can std::move(entry)
-    auto callback = entry.inform;
-    if (outboundQueue.tryPushBack(std::move(entry)) != llarp::thread::QueueReturn::Success)
+    if (m_IncomingSize.fetch_add(1, std::memory_order_relaxed) >= m_MaxIncoming)
     {
-      m_queueStats.dropped++;
-      DoCallback(callback, SendStatus::Congestion);
-    }
-    else
-    {
-      m_queueStats.queued++;
-      uint32_t queueSize = outboundQueue.size();
-      m_queueStats.queueWatermark = std::max(queueSize, m_queueStats.queueWatermark);
+      m_IncomingSize.fetch_sub(1, std::memory_order_relaxed);
+      m_IncomingDropped.fetch_add(1, std::memory_order_relaxed);
+      Release(entry);
+      DoCallback(std::move(entry.inform), SendStatus::Congestion);
+      return true;
     }
-
+    outboundQueue.Push(std::move(entry));
     return true;
   }
 
-  void
+  bool
   OutboundMessageHandler::ProcessOutboundQueue()
   {
-    while (not outboundQueue.empty())
-    {
-      MessageQueueEntry entry = outboundQueue.popFront();
+    // as deep as the queue gets, which is just before we drain it
+    const auto depth = static_cast<uint32_t>(m_IncomingSize.load(std::memory_order_relaxed));
+    m_queueStats.queueWatermark = std::max(depth, m_queueStats.queueWatermark);
+    uint32_t count = 0;
+    const bool more = outboundQueue.Drain(
+        [this, &count](MessageQueueEntry entry) {
+          ++count;
+          if (_router->linkManager().HasSessionTo(entry.router))
+            QueuePathMessage(std::move(entry));
+          else
+            QueuePendingMessage(std::move(entry));
+        },
+        std::numeric_limits<size_t>::max());
+    m_IncomingSize.fetch_sub(count, std::memory_order_relaxed);
+    m_queueStats.queued += count;
+    return more;
+  }
 
-      // messages may still be queued for processing when a pathid is removed,
-      // so check here if the pathid was recently removed.
-      if (recentlyRemovedPaths.Contains(entry.pathid))
-      {
-        continue;
-      }
+  void
+  OutboundMessageHandler::QueuePathMessage(MessageQueueEntry entry)
+  {
+    // messages may still be queued for processing when a pathid is removed,
+    // so check here if the pathid was recently removed.
+    if (recentlyRemovedPaths.Contains(entry.pathid))
+    {
+      Release(entry);
+      return;
+    }
 
-      auto [queue_itr, is_new] = outboundMessageQueues.emplace(entry.pathid, MessageQueue());
+    auto [queue_itr, is_new] = outboundMessageQueues.try_emplace(entry.pathid);
+    auto& queue = queue_itr->second;
 
-      if (is_new && !entry.pathid.IsZero())
-      {
-        roundRobinOrder.push(entry.pathid);
-      }
+    if (is_new and m_PathRate and not entry.pathid.IsZero())
+      queue.bucket = MakeBucket(m_PathRate);
 
-      MessageQueue& path_queue = queue_itr->second;
+    if (queue.messages.size() >= MAX_PATH_QUEUE_SIZE and not entry.pathid.IsZero())
+    {
+      Release(entry);
+      DoCallback(std::move(entry.inform), SendStatus::Congestion);
+      m_queueStats.dropped++;
+      return;
+    }
 
-      if (path_queue.size() < MAX_PATH_QUEUE_SIZE || entry.pathid.IsZero())
-      {
-        path_queue.push(std::move(entry));
-      }
-      else
-      {
-        DoCallback(entry.inform, SendStatus::Congestion);
-        m_queueStats.dropped++;
-      }
+    if (not queue.active and not entry.pathid.IsZero())
+    {
+      queue.active = true;
+      roundRobinOrder.push(entry.pathid);
     }
+    queue.messages.push(std::move(entry));
+  }
+
+  void
+  OutboundMessageHandler::QueuePendingMessage(MessageQueueEntry entry)
+  {
+    // queue the message onto a special pending session queue for that destination, and then
+    // create that pending session if there is not already a session establish attempt in
+    // progress.
+    const auto remote = entry.router;
+    auto [queue_itr, is_new] = pendingSessionMessageQueues.try_emplace(remote);
+    queue_itr->second.push(std::move(entry));
+
+    if (is_new)
+      QueueSessionCreation(remote);
   }
 
   bool
@@ -281,7 +352,7 @@ namespace llarp
     m_queueStats.numTicks++;
 
     // send routing messages first priority
-    auto& routing_mq = outboundMessageQueues[zeroID];
+    auto& routing_mq = outboundMessageQueues[zeroID].messages;
     while (not routing_mq.empty())
     {
       const MessageQueueEntry& entry = routing_mq.top();
@@ -289,88 +360,136 @@ namespace llarp
       routing_mq.pop();
     }
 
-    size_t num_queues = roundRobinOrder.size();
-
-    // if any paths have been removed since last tick, remove any stale
-    // entries from the round-robin ordering
+    // if any paths have been removed since last tick, forget peers we haven't sent to in long
+    // enough to be back at a full burst
     if (removedSomePaths)
     {
-      for (size_t i = 0; i < num_queues; i++)
+      const auto now = _router->Now();
+      for (auto itr = m_PeerBuckets.begin(); itr != m_PeerBuckets.end();)
       {
-        PathID_t pathid = std::move(roundRobinOrder.front());
-        roundRobinOrder.pop();
-
-        if (outboundMessageQueues.find(pathid) != outboundMessageQueues.end())
-        {
-          roundRobinOrder.push(std::move(pathid));
-        }
+        if (itr->second.Full(now))
+          itr = m_PeerBuckets.erase(itr);
+        else
+          ++itr;
       }
     }
     removedSomePaths = false;
 
-    num_queues = roundRobinOrder.size();
-    if (num_queues == 0)
-    {
-      return false;
-    }
-
-    // send messages for each pathid in roundRobinOrder, stopping when
-    // either every path's queue is empty or a set maximum amount of
-    // messages have been sent.
-    size_t consecutive_empty = 0;
-    for (size_t sent_count = 0; sent_count < MAX_OUTBOUND_MESSAGES_PER_TICK;)
+    // visit each pathid in roundRobinOrder, stopping when either it runs out of paths with
+    // something queued, a whole round goes by without sending anything (every queue left is
+    // throttled) or a set maximum amount of messages have been sent.
+    const auto now = _router->Now();
+    size_t sent_count = 0;
+    size_t idle_visits = 0;
+    bool throttled = false;
+    while (not roundRobinOrder.empty() and sent_count < MAX_OUTBOUND_MESSAGES_PER_TICK
+           and idle_visits < roundRobinOrder.size())
     {
       PathID_t pathid = std::move(roundRobinOrder.front());
       roundRobinOrder.pop();
 
-      auto& message_queue = outboundMessageQueues[pathid];
-      if (message_queue.size() > 0)
-      {
-        const MessageQueueEntry& entry = message_queue.top();
+      // removed since it was queued
+      auto itr = outboundMessageQueues.find(pathid);
+      if (itr == outboundMessageQueues.end())
+        continue;
+      auto& queue = itr->second;
 
+      bool sent_any = false;
+      queue.deficit += RoundRobinQuantum;
+      while (not queue.messages.empty() and sent_count < MAX_OUTBOUND_MESSAGES_PER_TICK)
+      {
+        const MessageQueueEntry& entry = queue.messages.top();
+        const auto size = static_cast<int64_t>(entry.message.size());
+        if (size > queue.deficit)
+          break;
+        if (not Admit(queue, entry, now))
+        {
+          // a path waiting on a cap doesn't bank its turns to spend all at once later
+          queue.deficit = std::min(queue.deficit, RoundRobinQuantum);
+          m_queueStats.throttled++;
+          throttled = true;
+          break;
+        }
+        queue.deficit -= size;
+        const auto waited = now > entry.queuedAt ? now - entry.queuedAt : 0s;
+        pathQueueWait.Record(waited.count());
+        queue.queueDelay = queue.queueDelay * 7 / 8 + waited.count() / 8.0;
         Send(entry);
-        message_queue.pop();
-
-        consecutive_empty = 0;
-        consecutive_empty++;
+        queue.messages.pop();
+        ++sent_count;
+        sent_any = true;
       }
-      else
+
+      if (queue.messages.empty())
       {
-        consecutive_empty++;
+        // out of the round robin until something is queued on it again
+        queue.deficit = 0;
+        queue.active = false;
+        continue;
       }
-
       roundRobinOrder.push(std::move(pathid));
 
-      // if num_queues empty queues in a row, all queues empty.
-      if (consecutive_empty == num_queues)
-      {
-        break;
-      }
+      // if every path left visited in a row sent nothing, they are all throttled.
+      idle_visits = sent_any ? 0 : idle_visits + 1;
     }
 
-    m_queueStats.perTickMax = std::max((uint32_t)consecutive_empty, m_queueStats.perTickMax);
+    m_queueStats.perTickMax = std::max((uint32_t)sent_count, m_queueStats.perTickMax);
+
+    if (throttled)
+      ScheduleThrottleWakeup();
 
-    return consecutive_empty != num_queues;
+    return not roundRobinOrder.empty() and idle_visits < roundRobinOrder.size();
   }
 
-  void
-  OutboundMessageHandler::FinalizeSessionRequest(const RouterID& router, SendStatus status)
+  bool
+  OutboundMessageHandler::Admit(PathQueue& queue, const MessageQueueEntry& entry, llarp_time_t now)
   {
-    MessageQueue movedMessages;
+    util::TokenBucket* peer = nullptr;
+    if (m_PeerRate)
     {
-      util::Lock l(_mutex);
-      auto itr = pendingSessionMessageQueues.find(router);
+      auto itr = m_PeerBuckets.find(entry.router);
+      if (itr == m_PeerBuckets.end())
+        itr = m_PeerBuckets.emplace(entry.router, MakeBucket(m_PeerRate)).first;
+      peer = &itr->second;
+    }
 
-      if (itr == pendingSessionMessageQueues.end())
-      {
-        return;
-      }
+    if (not queue.bucket.Ready(now) or not m_RelayBucket.Ready(now)
+        or (peer and not peer->Ready(now)))
+      return false;
+
+    const auto size = entry.message.size();
+    queue.bucket.Consume(size);
+    m_RelayBucket.Consume(size);
+    if (peer)
+      peer->Consume(size);
+    return true;
+  }
 
-      movedMessages.swap(itr->second);
+  void
+  OutboundMessageHandler::ScheduleThrottleWakeup()
+  {
+    if (m_WakeupPending)
+      return;
+    m_WakeupPending = true;
+    _router->loop()->call_later(ThrottleWakeup, [this]() {
+      m_WakeupPending = false;
+      _router->TriggerPump();
+    });
+  }
 
-      pendingSessionMessageQueues.erase(itr);
+  void
+  OutboundMessageHandler::FinalizeSessionRequest(const RouterID& router, SendStatus status)
+  {
+    auto itr = pendingSessionMessageQueues.find(router);
+    if (itr == pendingSessionMessageQueues.end())
+    {
+      return;
     }
 
+    MessageQueue movedMessages;
+    movedMessages.swap(itr->second);
+    pendingSessionMessageQueues.erase(itr);
+
     while (!movedMessages.empty())
     {
       const MessageQueueEntry& entry = movedMessages.top();
@@ -381,6 +500,7 @@ namespace llarp
       }
       else
       {
+        Release(entry);
         DoCallback(entry.inform, status);
       }
       movedMessages.pop();
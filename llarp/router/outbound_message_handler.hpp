@@ -3,12 +3,14 @@
 #include "i_outbound_message_handler.hpp"
 
 #include <llarp/ev/ev.hpp>
-#include <llarp/util/thread/queue.hpp>
+#include <llarp/util/thread/mpsc_queue.hpp>
 #include <llarp/util/decaying_hashset.hpp>
 #include <llarp/path/path_types.hpp>
 #include <llarp/util/priority_queue.hpp>
+#include <llarp/util/token_bucket.hpp>
 #include <llarp/router_id.hpp>
 
+#include <atomic>
 #include <list>
 #include <unordered_map>
 #include <utility>
@@ -27,17 +29,15 @@ namespace llarp
 
     OutboundMessageHandler(size_t maxQueueSize = MAX_OUTBOUND_QUEUE_SIZE);
 
-    /* Called to queue a message to be sent to a router.
+    /* Called to queue a message to be sent to a router, from any thread.
      *
-     * If there is no session with the destination router, the message is added to a
-     * pending session queue for that router.  If there is no pending session to that
-     * router, one is created.
-     *
-     * If there is a session to the destination router, the message is placed on the shared
-     * outbound message queue to be processed on Pump().
+     * The message is encoded into a pooled buffer and placed on the shared, lock-free
+     * incoming queue, to be processed on Pump().
      *
      * When this class' Pump() is called, that queue is emptied and the messages there
-     * are placed in their paths' respective individual queues.
+     * are placed in their paths' respective individual queues, or, if there is no session
+     * with the destination router, in a pending session queue for that router.  If there
+     * is no pending session to that router, one is created.
      *
      * Returns false if encoding the message into a buffer fails, true otherwise.
      * A return value of true merely means we successfully processed the queue request,
@@ -45,7 +45,7 @@ namespace llarp
      */
     bool
     QueueMessage(const RouterID& remote, const ILinkMessage& msg, SendStatusHandler callback)
-        override EXCLUDES(_mutex);
+        override;
 
     /* Called when pumping output queues, typically scheduled via a call to Router::TriggerPump().
      *
@@ -67,6 +67,9 @@ namespace llarp
     void
     RemovePath(const PathID_t& pathid) override;
 
+    llarp_time_t
+    QueueDelay(const PathID_t& pathid) const override;
+
     util::StatusObject
     ExtractStatus() const override;
 
@@ -80,15 +83,25 @@ namespace llarp
     struct MessageQueueEntry
     {
       uint16_t priority;
-      std::vector<byte_t> message;
+      /// the order messages were queued in, which those of the same priority go in
+      uint64_t sequence;
+      /// from the buffer pool; mutable so that it can go back to the pool as the entry leaves
+      /// its priority queue
+      mutable std::vector<byte_t> message;
       SendStatusHandler inform;
       PathID_t pathid;
       RouterID router;
+      /// when QueueMessage was called for it
+      llarp_time_t queuedAt;
 
+      /// whether this goes out after other: lower priorities after higher ones, and then in the
+      /// order they were queued
       bool
       operator>(const MessageQueueEntry& other) const
       {
-        return priority > other.priority;
+        if (priority != other.priority)
+          return priority < other.priority;
+        return sequence > other.sequence;
       }
     };
 
@@ -101,10 +114,26 @@ namespace llarp
 
       uint32_t perTickMax = 0;
       uint32_t numTicks = 0;
+      /// times a path with something to send had to wait on a bandwidth cap
+      uint64_t throttled = 0;
     };
 
     using MessageQueue = util::ascending_priority_queue<MessageQueueEntry>;
 
+    /// a path's queued messages and its share of the bandwidth
+    struct PathQueue
+    {
+      MessageQueue messages;
+      /// bytes this path may still send this round of the round robin
+      int64_t deficit = 0;
+      /// this path's own cap, if any
+      util::TokenBucket bucket;
+      /// whether the path is in roundRobinOrder, which paths with nothing queued are not
+      bool active = false;
+      /// ewma of how long its messages waited before going out, in ms
+      double queueDelay = 0;
+    };
+
     /* If a session is not yet created with the destination router for a message,
      * a special queue is created for that router and an attempt is made to
      * establish a session.  When this establish attempt concludes, either
@@ -139,7 +168,7 @@ namespace llarp
     bool
     SendIfSession(const MessageQueueEntry& ent);
 
-    /* queues a message to the shared outbound message queue.
+    /* queues a message to the shared outbound message queue, from any thread.
      *
      * If the queue is full, the message is dropped and the message's status
      * callback is invoked with a congestion status.
@@ -151,25 +180,45 @@ namespace llarp
     QueueOutboundMessage(MessageQueueEntry entry);
 
     /* Processes messages on the shared message queue into their paths' respective
-     * individual queues.
+     * individual queues, or the pending session queues of routers we have no session with.
+     * Returns true if a push still going on when we got to it was left for next time.
      */
-    void
+    bool
     ProcessOutboundQueue();
 
+    /* Queues a message for a router we have a session with onto its path's queue */
+    void
+    QueuePathMessage(MessageQueueEntry entry);
+
+    /* Queues a message for a router we have no session with yet, starting one if need be */
+    void
+    QueuePendingMessage(MessageQueueEntry entry);
+
     /*
      * Sends routing messages that have been queued, indicated by pathid 0 when queued.
      *
-     * Sends messages from path queues until all are empty or a set cap has been reached.
-     * This will send one message from each queue in a round-robin fashion such that they
-     * all have roughly equal access to bandwidth.  A notion of priority may be introduced
-     * at a later time, but for now only routing messages get priority.
+     * Sends messages from path queues until all are empty, held back by a bandwidth cap, or a
+     * set cap on messages per tick has been reached.  Paths are visited round-robin and each
+     * visit earns a path a quantum of bytes to spend (deficit round robin), so that paths get
+     * equal shares of bandwidth however big their messages are.  Routing messages are never
+     * held back.
      *
      * Returns true if there is more to send (i.e. we hit the limit before emptying all path
-     * queues), false if all queues were drained.
+     * queues), false if all queues were drained or are waiting on a bandwidth cap.
      */
     bool
     SendRoundRobin();
 
+    /* Returns true and takes the message's size from the path, peer and relay bandwidth caps
+     * that apply to it if none of them are exhausted; returns false otherwise.
+     */
+    bool
+    Admit(PathQueue& queue, const MessageQueueEntry& entry, llarp_time_t now);
+
+    /* Pumps again once throttled paths may have bandwidth again, as nothing else would */
+    void
+    ScheduleThrottleWakeup();
+
     /* Invoked when an outbound session establish attempt has concluded.
      *
      * If the outbound session was successfully created, sends any messages queued
@@ -179,22 +228,41 @@ namespace llarp
      * queued messages and drops them.
      */
     void
-    FinalizeSessionRequest(const RouterID& router, SendStatus status) EXCLUDES(_mutex);
-
-    llarp::thread::Queue<MessageQueueEntry> outboundQueue;
+    FinalizeSessionRequest(const RouterID& router, SendStatus status);
+
+    /* Gives the entry's buffer back to the pool as the entry is dropped or sent */
+    static void
+    Release(const MessageQueueEntry& entry);
+
+    /// messages queued from any thread, for Pump() to sort out on the logic thread; everything
+    /// below is only touched there
+    llarp::thread::MPSCQueue<MessageQueueEntry> outboundQueue;
+    /// how many messages are in outboundQueue, to drop new ones past maxQueueSize
+    std::atomic<size_t> m_IncomingSize{0};
+    std::atomic<uint64_t> m_IncomingDropped{0};
+    const size_t m_MaxIncoming;
     llarp::util::DecayingHashSet<PathID_t> recentlyRemovedPaths;
     bool removedSomePaths;
 
-    mutable util::Mutex _mutex;  // protects pendingSessionMessageQueues
+    std::unordered_map<RouterID, MessageQueue> pendingSessionMessageQueues;
 
-    std::unordered_map<RouterID, MessageQueue> pendingSessionMessageQueues GUARDED_BY(_mutex);
-
-    std::unordered_map<PathID_t, MessageQueue> outboundMessageQueues;
+    std::unordered_map<PathID_t, PathQueue> outboundMessageQueues;
 
+    /// paths with messages queued, in the order the deficit round robin visits them; paths
+    /// join when something is queued on them and leave when they run empty, so a round costs
+    /// the number of busy paths rather than of all paths
     std::queue<PathID_t> roundRobinOrder;
 
     AbstractRouter* _router;
 
+    /// bandwidth caps in bytes/s from the config, 0 for none
+    uint64_t m_PathRate = 0;
+    uint64_t m_PeerRate = 0;
+    util::TokenBucket m_RelayBucket;
+    std::unordered_map<RouterID, util::TokenBucket> m_PeerBuckets;
+    bool m_WakeupPending = false;
+    std::atomic<uint64_t> m_NextSequence{0};
+
     util::ContentionKiller m_Killer;
 
     // paths cannot have pathid "0", so it can be used as the "pathid"
@@ -12,6 +12,7 @@
 #include <llarp/util/status.hpp>
 #include <llarp/crypto/crypto.hpp>
 #include <utility>
+#include <vector>
 
 #include <llarp/rpc/lokid_rpc_client.hpp>
 
@@ -23,14 +24,31 @@ namespace llarp
 
     const RouterContact rc;
     LinkLayer_ptr link;
+    /// the addresses of theirs we can try, started one after another in this order
+    const std::vector<AddressInfo> addrs;
 
     size_t attemptCount = 0;
+    /// attempts started and not yet timed out
+    size_t inFlight = 0;
 
     PendingSession(RouterContact _rc, LinkLayer_ptr _link)
-        : rc(std::move(_rc)), link(std::move(_link))
+        : rc(std::move(_rc)), link(std::move(_link)), addrs(link->PickAddresses(rc))
     {}
+
+    bool
+    MoreToTry() const
+    {
+      return attemptCount < addrs.size();
+    }
   };
 
+  /// how long after starting an attempt at one of a relay's addresses we start one at the next,
+  /// unless one has been established by then
+  static constexpr auto ConnectStagger = 250ms;
+
+  /// how long a relay we couldn't connect to is skipped for
+  static constexpr auto FailedPeerCacheTime = 30s;
+
   bool
   OutboundSessionMaker::OnSessionEstablished(ILinkSession* session)
   {
@@ -61,12 +79,35 @@ namespace llarp
   {
     const auto router = RouterID(session->GetPubKey());
     LogWarn("Session establish attempt to ", router, " timed out.", session->GetRemoteEndpoint());
+    std::shared_ptr<PendingSession> job;
+    {
+      util::Lock l(_mutex);
+      if (auto itr = pendingSessions.find(router); itr != pendingSessions.end() and itr->second)
+      {
+        if (itr->second->inFlight)
+          --itr->second->inFlight;
+        // the other attempts still have a chance
+        if (itr->second->inFlight)
+          return;
+        if (itr->second->MoreToTry())
+          job = itr->second;
+      }
+    }
+    // with none left going, don't wait out the stagger for the next address
+    if (job)
+    {
+      TryNextAddress(router, job);
+      return;
+    }
     FinalizeRequest(router, SessionResult::Timeout);
   }
 
   void
   OutboundSessionMaker::CreateSessionTo(const RouterID& router, RouterCallback on_result)
   {
+    if (FailedRecently(router, on_result))
+      return;
+
     if (on_result)
     {
       util::Lock l(_mutex);
@@ -103,6 +144,9 @@ namespace llarp
   {
     const RouterID router{rc.pubkey};
 
+    if (FailedRecently(router, on_result))
+      return;
+
     if (on_result)
     {
       util::Lock l(_mutex);
@@ -128,6 +172,28 @@ namespace llarp
     GotRouterContact(router, rc);
   }
 
+  bool
+  OutboundSessionMaker::FailedRecently(const RouterID& router, const RouterCallback& on_result)
+  {
+    {
+      util::Lock l(_mutex);
+      m_RecentlyFailed.Decay();
+      if (not m_RecentlyFailed.Contains(router))
+        return false;
+    }
+    LogDebug("not connecting to ", router, ", which we failed to connect to recently");
+    if (on_result)
+      _loop->call([on_result, router] { on_result(router, SessionResult::EstablishFail); });
+    return true;
+  }
+
+  bool
+  OutboundSessionMaker::IsRecentlyFailed(const RouterID& router) const
+  {
+    util::Lock l(_mutex);
+    return m_RecentlyFailed.Contains(router);
+  }
+
   bool
   OutboundSessionMaker::HavePendingSessionTo(const RouterID& router) const
   {
@@ -142,10 +208,12 @@ namespace llarp
     std::set<RouterID> exclude;
     do
     {
-      auto filter = [exclude](const auto& rc) -> bool { return exclude.count(rc.pubkey) == 0; };
+      auto filter = [this, &exclude](const NodeDB::Summary& summary) -> bool {
+        return exclude.count(summary.pubkey) == 0 and not IsRecentlyFailed(summary.pubkey);
+      };
 
       RouterContact other;
-      if (const auto maybe = _nodedb->GetRandom(filter))
+      if (const auto maybe = _nodedb->GetRandomBySummary(filter))
       {
         other = *maybe;
       }
@@ -168,12 +236,12 @@ namespace llarp
         "connecting to ", numDesired - remainingDesired, " out of ", numDesired, " random routers");
   }
 
-  // TODO: this
   util::StatusObject
   OutboundSessionMaker::ExtractStatus() const
   {
-    util::StatusObject status{};
-    return status;
+    util::Lock l(_mutex);
+    return util::StatusObject{
+        {"pending", pendingSessions.size()}, {"recentlyFailed", m_RecentlyFailed.Size()}};
   }
 
   void
@@ -192,26 +260,70 @@ namespace llarp
     _nodedb = router->nodedb();
     _profiler = profiler;
     work = std::move(dowork);
+    util::Lock l(_mutex);
+    m_RecentlyFailed.DecayInterval(FailedPeerCacheTime);
   }
 
   void
   OutboundSessionMaker::DoEstablish(const RouterID& router)
   {
-    std::unique_lock l{_mutex};
-
-    auto itr = pendingSessions.find(router);
-
-    if (itr == pendingSessions.end())
+    std::shared_ptr<PendingSession> job;
     {
-      return;
+      util::Lock l(_mutex);
+      auto itr = pendingSessions.find(router);
+      if (itr == pendingSessions.end() or not itr->second)
+      {
+        return;
+      }
+      job = itr->second;
     }
+    TryNextAddress(router, job);
+  }
 
-    const auto& job = itr->second;
-    if (not job->link->TryEstablishTo(job->rc))
+  void
+  OutboundSessionMaker::TryNextAddress(
+      const RouterID& router, const std::shared_ptr<PendingSession>& job)
+  {
+    // a relay publishing several addresses gets an attempt at each in turn, ConnectStagger
+    // apart, without waiting for the last to time out; the first to complete a handshake wins
+    // and closes the others.
+    while (true)
     {
-      l.unlock();
-      FinalizeRequest(router, SessionResult::EstablishFail);
+      std::optional<AddressInfo> addr;
+      {
+        util::Lock l(_mutex);
+        auto itr = pendingSessions.find(router);
+        // done with, or a newer request that has its own timers going
+        if (itr == pendingSessions.end() or itr->second != job)
+          return;
+        if (job->MoreToTry())
+          addr = job->addrs[job->attemptCount++];
+        else if (job->inFlight)
+          return;
+      }
+      if (not addr)
+        break;
+
+      if (job->link->TryEstablishTo(job->rc, *addr))
+      {
+        bool more;
+        {
+          util::Lock l(_mutex);
+          ++job->inFlight;
+          more = job->MoreToTry();
+        }
+        if (more)
+        {
+          _loop->call_later(ConnectStagger, [this, router, weak = std::weak_ptr{job}] {
+            if (auto alive = weak.lock())
+              TryNextAddress(router, alive);
+          });
+        }
+        return;
+      }
+      // that one failed to start at all, so on to the next right away
     }
+    FinalizeRequest(router, SessionResult::EstablishFail);
   }
 
   void
@@ -357,12 +469,17 @@ namespace llarp
       if (type == SessionResult::Establish)
       {
         _profiler->MarkConnectSuccess(router);
+        m_RecentlyFailed.Remove(router);
       }
       else
       {
         // TODO: add non timeout related fail case
         _profiler->MarkConnectTimeout(router);
       }
+      // shared with path builds, so that they skip relays we can't reach rather than waiting
+      // on a connect timeout for each
+      if (type == SessionResult::Timeout or type == SessionResult::EstablishFail)
+        m_RecentlyFailed.Insert(router);
 
       auto itr = pendingCallbacks.find(router);
 
@@ -3,6 +3,7 @@
 #include "i_outbound_session_maker.hpp"
 
 #include "i_rc_lookup_handler.hpp"
+#include <llarp/util/decaying_hashset.hpp>
 #include <llarp/util/thread/threading.hpp>
 
 #include <llarp/profiling.hpp>
@@ -52,6 +53,9 @@ namespace llarp
     bool
     ShouldConnectTo(const RouterID& router) const override EXCLUDES(_mutex);
 
+    bool
+    IsRecentlyFailed(const RouterID& router) const override EXCLUDES(_mutex);
+
     void
     Init(
         AbstractRouter* router,
@@ -76,6 +80,15 @@ namespace llarp
     void
     DoEstablish(const RouterID& router) EXCLUDES(_mutex);
 
+    /// starts an attempt at job's next address, and sets a timer for the one after
+    void
+    TryNextAddress(const RouterID& router, const std::shared_ptr<PendingSession>& job)
+        EXCLUDES(_mutex);
+
+    /// if we failed to connect to router recently, tells on_result so (if set) and returns true
+    bool
+    FailedRecently(const RouterID& router, const RouterCallback& on_result) EXCLUDES(_mutex);
+
     void
     GotRouterContact(const RouterID& router, const RouterContact& rc) EXCLUDES(_mutex);
 
@@ -105,6 +118,9 @@ namespace llarp
 
     std::unordered_map<RouterID, CallbacksQueue> pendingCallbacks GUARDED_BY(_mutex);
 
+    /// routers we timed out or failed connecting to, not tried again until they decay
+    util::DecayingHashSet<RouterID> m_RecentlyFailed GUARDED_BY(_mutex);
+
     AbstractRouter* _router = nullptr;
     ILinkManager* _linkManager = nullptr;
     I_RCLookupHandler* _rcLookup = nullptr;
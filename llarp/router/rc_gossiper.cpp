@@ -17,11 +17,13 @@ namespace llarp
   {}
 
   void
-  RCGossiper::Init(ILinkManager* l, const RouterID& ourID, AbstractRouter* router)
+  RCGossiper::Init(
+      ILinkManager* l, const RouterID& ourID, AbstractRouter* router, Time_t batchInterval)
   {
     m_OurRouterID = ourID;
     m_LinkManager = l;
     m_router = router;
+    m_BatchInterval = batchInterval;
   }
 
   bool
@@ -40,12 +42,33 @@ namespace llarp
   RCGossiper::Decay(Time_t now)
   {
     m_Filter.Decay(now);
+    // a peer that had an rc from us longer ago than the filter holds it may well have dropped it
+    if (now - m_LastSentDecay < 1min)
+      return;
+    m_LastSentDecay = now;
+    for (auto peer = m_Sent.begin(); peer != m_Sent.end();)
+    {
+      auto& sent = peer->second;
+      for (auto itr = sent.begin(); itr != sent.end();)
+      {
+        if (itr->second.at + RCGossipFilterDecayInterval <= now)
+          itr = sent.erase(itr);
+        else
+          ++itr;
+      }
+      if (sent.empty())
+        peer = m_Sent.erase(peer);
+      else
+        ++peer;
+    }
   }
 
   void
   RCGossiper::Forget(const RouterID& pk)
   {
     m_Filter.Remove(pk);
+    for (auto& [peer, sent] : m_Sent)
+      sent.erase(pk);
     if (m_OurRouterID == pk)
       m_LastGossipedOurRC = 0s;
   }
@@ -94,10 +117,59 @@ namespace llarp
       m_LastGossipedOurRC = now;
     }
 
-    // send a GRCM as gossip method
-    DHTImmediateMessage gossip;
-    gossip.msgs.emplace_back(new dht::GotRouterMessage(dht::Key_t{}, 0, {rc}, false));
+    if (m_BatchInterval == 0s)
+    {
+      Send({rc});
+      return true;
+    }
+    if (m_Batch.empty())
+      m_BatchStarted = now;
+    m_Batch.insert_or_assign(pubkey, rc);
+    return true;
+  }
+
+  void
+  RCGossiper::SendBatch(Time_t now)
+  {
+    if (m_Batch.empty() or now - m_BatchStarted < m_BatchInterval)
+      return;
+    std::vector<RouterContact> rcs;
+    rcs.reserve(m_Batch.size());
+    for (auto& item : m_Batch)
+      rcs.emplace_back(std::move(item.second));
+    m_Batch.clear();
+    Send(rcs);
+  }
+
+  /// bencode rcs as gossip messages, as many rcs to a message as fit
+  static std::vector<ILinkSession::Message_t>
+  EncodeGossip(const std::vector<const RouterContact*>& rcs)
+  {
+    std::vector<RouterContact> all;
+    all.reserve(rcs.size());
+    for (const auto* rc : rcs)
+      all.push_back(*rc);
+
+    std::vector<ILinkSession::Message_t> msgs;
+    for (auto& batch : dht::SplitForLink(std::move(all)))
+    {
+      // send a GRCM as gossip method
+      DHTImmediateMessage gossip;
+      gossip.msgs.emplace_back(new dht::GotRouterMessage(dht::Key_t{}, 0, batch, false));
+      ILinkSession::Message_t msg{};
+      msg.resize(MAX_LINK_MSG_SIZE / 2);
+      llarp_buffer_t buf(msg);
+      if (not gossip.BEncode(&buf))
+        continue;
+      msg.resize(buf.cur - buf.base);
+      msgs.push_back(std::move(msg));
+    }
+    return msgs;
+  }
 
+  void
+  RCGossiper::Send(const std::vector<RouterContact>& rcs)
+  {
     std::vector<RouterID> gossipTo;
 
     // select peers to gossip to
@@ -114,33 +186,51 @@ namespace llarp
         },
         true);
 
-    std::unordered_set<RouterID> keys;
-    // grab the keys we want to use
-    std::sample(
-        gossipTo.begin(), gossipTo.end(), std::inserter(keys, keys.end()), MaxGossipPeers, CSRNG{});
+    const auto now = time_now_ms();
+    // each rc to its own sample of them, as it would go out on its own, less the peers we have
+    // already sent it to
+    std::unordered_map<RouterID, std::vector<const RouterContact*>> toPeer;
+    for (const auto& rc : rcs)
+    {
+      std::vector<RouterID> keys;
+      // grab the keys we want to use
+      std::sample(
+          gossipTo.begin(), gossipTo.end(), std::back_inserter(keys), MaxGossipPeers, CSRNG{});
+      for (const auto& key : keys)
+      {
+        if (auto peer = m_Sent.find(key); peer != m_Sent.end())
+        {
+          if (auto itr = peer->second.find(rc.pubkey);
+              itr != peer->second.end() and itr->second.version >= rc.last_updated)
+            continue;
+        }
+        toPeer[key].push_back(&rc);
+      }
+    }
 
+    const auto priority = DHTImmediateMessage{}.Priority();
     m_LinkManager->ForEachPeer([&](ILinkSession* peerSession) {
       if (not(peerSession && peerSession->IsEstablished()))
         return;
 
-      // exclude from gossip as we have not selected to use it
-      if (keys.count(peerSession->GetPubKey()) == 0)
+      // exclude from gossip as we have not selected to use it, or it had all of it over another
+      // session already
+      const auto itr = toPeer.find(peerSession->GetPubKey());
+      if (itr == toPeer.end())
         return;
 
-      // encode message
-      ILinkSession::Message_t msg{};
-      msg.resize(MAX_LINK_MSG_SIZE / 2);
-      llarp_buffer_t buf(msg);
-      if (not gossip.BEncode(&buf))
-        return;
-      msg.resize(buf.cur - buf.base);
-
-      m_router->NotifyRouterEvent<tooling::RCGossipSentEvent>(m_router->pubkey(), rc);
+      auto& sent = m_Sent[itr->first];
+      for (const auto* rc : itr->second)
+      {
+        m_router->NotifyRouterEvent<tooling::RCGossipSentEvent>(m_router->pubkey(), *rc);
+        sent.insert_or_assign(rc->pubkey, Sent{rc->last_updated, now});
+      }
 
       // send message
-      peerSession->SendMessageBuffer(std::move(msg), nullptr, gossip.Priority());
+      for (auto& msg : EncodeGossip(itr->second))
+        peerSession->SendMessageBuffer(std::move(msg), nullptr, priority);
+      toPeer.erase(itr);
     });
-    return true;
   }
 
 }  // namespace llarp
@@ -6,6 +6,9 @@
 #include <llarp/link/i_link_manager.hpp>
 #include "abstractrouter.hpp"
 
+#include <unordered_map>
+#include <vector>
+
 namespace llarp
 {
   struct RCGossiper : public I_RCGossiper
@@ -26,8 +29,14 @@ namespace llarp
     bool
     IsOurRC(const RouterContact& rc) const override;
 
+    /// batchInterval is how long to gather RCs to gossip before sending them on together, 0 to
+    /// send each one as it comes
+    void
+    Init(ILinkManager*, const RouterID&, AbstractRouter*, Time_t batchInterval = 0s);
+
+    /// send on the RCs gathered for gossip once the batch has been open for the batch interval
     void
-    Init(ILinkManager*, const RouterID&, AbstractRouter*);
+    SendBatch(Time_t now);
 
     void
     Forget(const RouterID& router) override;
@@ -39,11 +48,30 @@ namespace llarp
     LastGossipAt() const override;
 
    private:
+    /// gossip rcs to our peers, each rc to its own sample of them, with every rc for a peer that
+    /// has not already had it from us sent in as few messages as fit
+    void
+    Send(const std::vector<RouterContact>& rcs);
+
     RouterID m_OurRouterID;
     Time_t m_LastGossipedOurRC = 0s;
     ILinkManager* m_LinkManager = nullptr;
     util::DecayingHashSet<RouterID> m_Filter;
 
+    Time_t m_BatchInterval = 0s;
+    Time_t m_BatchStarted = 0s;
+    std::unordered_map<RouterID, RouterContact> m_Batch;
+
+    struct Sent
+    {
+      /// the RC's last_updated
+      llarp_time_t version;
+      Time_t at;
+    };
+    /// what we have gossiped to each peer lately, by the router the RC is for
+    std::unordered_map<RouterID, std::unordered_map<RouterID, Sent>> m_Sent;
+    Time_t m_LastSentDecay = 0s;
+
     AbstractRouter* m_router;
   };
 }  // namespace llarp
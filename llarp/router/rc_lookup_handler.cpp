@@ -10,9 +10,12 @@
 #include <llarp/util/thread/threading.hpp>
 #include <llarp/nodedb.hpp>
 #include <llarp/dht/context.hpp>
+#include <llarp/dht/messages/findrcs.hpp>
 #include "abstractrouter.hpp"
 
+#include <algorithm>
 #include <iterator>
+#include <limits>
 #include <functional>
 #include <random>
 
@@ -56,6 +59,40 @@ namespace llarp
     LogInfo("lokinet service node list now has ", whitelistRouters.size(), " active routers");
   }
 
+  void
+  RCLookupHandler::UpdateRouterWhitelist(
+      const std::vector<RouterID>& whitelist,
+      const std::vector<RouterID>& greylist,
+      const std::vector<RouterID>& greenlist,
+      const std::vector<RouterID>& removed)
+  {
+    util::Lock l(_mutex);
+
+    // a router moved from one list to another is in the one it moved to, so take it out of all of
+    // them first
+    for (const auto* routers : {&whitelist, &greylist, &greenlist, &removed})
+    {
+      for (const auto& router : *routers)
+      {
+        whitelistRouters.erase(router);
+        greylistRouters.erase(router);
+        greenlistRouters.erase(router);
+      }
+    }
+    whitelistRouters.insert(whitelist.begin(), whitelist.end());
+    greylistRouters.insert(greylist.begin(), greylist.end());
+    greenlistRouters.insert(greenlist.begin(), greenlist.end());
+
+    LogInfo(
+        "lokinet service node list now has ",
+        whitelistRouters.size(),
+        " active routers (",
+        whitelist.size() + greylist.size() + greenlist.size(),
+        " changed, ",
+        removed.size(),
+        " removed)");
+  }
+
   bool
   RCLookupHandler::HaveReceivedWhitelist() const
   {
@@ -206,6 +243,33 @@ namespace llarp
       return false;
     }
 
+    AcceptRC(rc);
+    return true;
+  }
+
+  std::vector<bool>
+  RCLookupHandler::CheckRCs(const std::vector<RouterContact>& rcs) const
+  {
+    auto valid = RouterContact::VerifyAll(rcs, _dht->impl->Now());
+    for (size_t idx = 0; idx < rcs.size(); ++idx)
+    {
+      const auto& rc = rcs[idx];
+      if (not SessionIsAllowed(rc.pubkey))
+      {
+        _dht->impl->DelRCNodeAsync(dht::Key_t{rc.pubkey});
+        valid[idx] = false;
+      }
+      else if (not valid[idx])
+        LogWarn("RC for ", RouterID(rc.pubkey), " is invalid");
+      else
+        AcceptRC(rc);
+    }
+    return valid;
+  }
+
+  void
+  RCLookupHandler::AcceptRC(const RouterContact& rc) const
+  {
     // update nodedb if required
     if (rc.IsPublicRouter())
     {
@@ -213,8 +277,6 @@ namespace llarp
       _loop->call([rc, n = _nodedb] { n->PutIfNewer(rc); });
       _dht->impl->PutRCNodeAsync(rc);
     }
-
-    return true;
   }
 
   size_t
@@ -262,41 +324,151 @@ namespace llarp
   }
 
   void
-  RCLookupHandler::PeriodicUpdate(llarp_time_t now)
+  RCLookupHandler::RequestRCs(
+      const RouterID& peer, std::vector<RouterID> routers, llarp_time_t since)
   {
-    // try looking up stale routers
-    std::unordered_set<RouterID> routersToLookUp;
+    _dht->impl->DHTSendTo(peer, new dht::FindRCsMessage(randint(), std::move(routers), since));
+  }
 
-    _nodedb->VisitInsertedBefore(
-        [&](const RouterContact& rc) {
-          if (HavePendingLookup(rc.pubkey))
-            return;
-          routersToLookUp.insert(rc.pubkey);
+  std::vector<RouterID>
+  RCLookupHandler::RandomConnectedRouters(size_t n) const
+  {
+    std::vector<RouterID> peers;
+    _linkManager->ForEachPeer(
+        [&peers](const ILinkSession* session, bool) {
+          if (session and session->IsEstablished() and session->GetRemoteRC().IsPublicRouter())
+            peers.emplace_back(session->GetPubKey());
         },
-        now - RouterContact::UpdateInterval);
+        false);
+    std::vector<RouterID> picked;
+    std::sample(peers.begin(), peers.end(), std::back_inserter(picked), n, CSRNG{});
+    return picked;
+  }
+
+  void
+  RCLookupHandler::PeriodicUpdate(llarp_time_t now)
+  {
+    /// how often we ask a peer for everything updated since we last asked
+    static constexpr auto RCRefreshInterval = 5min;
+    /// how far back before the last refresh we ask from, for rcs that took a while to reach the
+    /// peer and for clock differences
+    static constexpr auto RCRefreshOverlap = 5min;
+    /// how long we give the rcs a refresh brings in before we go after the routers left stale
+    static constexpr auto StaleGrace = 30s;
+    /// how long before we ask again for a router still stale
+    static constexpr auto StaleRetryInterval = 5min;
+    /// how many peers the stale routers are shared out among each time
+    static constexpr size_t StalePeers = 4;
+
+    // whatever changed since last time in one request, rather than a lookup for each router we
+    // have not had an rc from in a while
+    if (now - _lastRCRefresh >= RCRefreshInterval)
+    {
+      if (const auto peers = RandomConnectedRouters(1); not peers.empty())
+      {
+        const auto since = _lastRCRefresh == 0s ? now - RouterContact::UpdateInterval
+                                                : _lastRCRefresh - RCRefreshOverlap;
+        RequestRCs(peers.front(), {}, since);
+        _lastRCRefresh = now;
+        for (auto itr = _staleRequested.begin(); itr != _staleRequested.end();)
+        {
+          if (now - itr->second >= StaleRetryInterval)
+            itr = _staleRequested.erase(itr);
+          else
+            ++itr;
+        }
+      }
+    }
 
-    for (const auto& router : routersToLookUp)
+    if (now - _lastRCRefresh >= StaleGrace)
     {
-      GetRC(router, nullptr, true);
+      // try looking up stale routers
+      std::vector<std::pair<llarp_time_t, RouterID>> stale;
+      _nodedb->VisitInsertedBefore(
+          [&](const RouterContact& rc) {
+            if (HavePendingLookup(rc.pubkey))
+              return;
+            if (auto itr = _staleRequested.find(rc.pubkey);
+                itr != _staleRequested.end() and now - itr->second < StaleRetryInterval)
+              return;
+            stale.emplace_back(rc.last_updated, rc.pubkey);
+          },
+          now - RouterContact::UpdateInterval);
+
+      if (not isServiceNode)
+      {
+        // clients look routers up anonymously, one at a time
+        for (const auto& [updated, router] : stale)
+        {
+          _staleRequested[router] = now;
+          GetRC(router, nullptr, true);
+        }
+      }
+      else if (not stale.empty())
+      {
+        // by when we last had them updated, so that each request can ask for only what is newer
+        // than the oldest rc in it, shared out among a few peers to go at once
+        std::sort(stale.begin(), stale.end());
+        const auto peers = RandomConnectedRouters(StalePeers);
+        auto itr = stale.begin();
+        for (const auto& peer : peers)
+        {
+          if (itr == stale.end())
+            break;
+          const auto end = itr + std::min<size_t>(dht::FindRCsMessage::MaxRCs, stale.end() - itr);
+          std::vector<RouterID> routers;
+          for (auto rc = itr; rc != end; ++rc)
+          {
+            _staleRequested[rc->second] = now;
+            routers.push_back(rc->second);
+          }
+          RequestRCs(peer, std::move(routers), itr->first);
+          itr = end;
+        }
+      }
     }
 
     _nodedb->RemoveStaleRCs(_bootstrapRouterIDList, now - RouterContact::StaleInsertionAge);
   }
 
+  void
+  RCLookupHandler::AdaptExploreInterval(bool behind)
+  {
+    const auto min = isServiceNode ? MinRelayExploreInterval : MinClientExploreInterval;
+    const auto max = isServiceNode ? MaxRelayExploreInterval : MaxClientExploreInterval;
+    _exploreInterval = behind ? min : std::clamp<llarp_time_t>(_exploreInterval * 2, min, max);
+  }
+
   void
   RCLookupHandler::ExploreNetwork()
   {
     const size_t known = _nodedb->NumLoaded();
+    // routers coming and going, or lookups for them not getting answers, both mean there is a
+    // part of the network we don't know about yet
+    const bool failed = _failedLookups.exchange(0) > 0;
+    const bool churning = known != _lastExploreKnown;
+    _lastExploreKnown = known;
+    const bool bootstrapping = known <= _bootstrapRCList.size();
     if (_bootstrapRCList.empty() && known == 0)
     {
       LogError("we have no bootstrap nodes specified");
     }
-    else if (known <= _bootstrapRCList.size())
+    else if (bootstrapping)
     {
+      /// how long we give the bootstrap routers to answer a bulk request before we ask again
+      static constexpr auto BootstrapFetchInterval = 10s;
+      // every bootstrap router at once, and besides exploring each also asks it for the newest
+      // rcs it has, which come back in a reply or two rather than a lookup per router
+      const auto now = _dht->impl->Now();
+      const bool fetch = now - _lastBootstrapFetch >= BootstrapFetchInterval;
+      if (fetch)
+        _lastBootstrapFetch = now;
       for (const auto& rc : _bootstrapRCList)
       {
         LogInfo("Doing explore via bootstrap node: ", RouterID(rc.pubkey));
         _dht->impl->ExploreNetworkVia(dht::Key_t{rc.pubkey});
+        if (fetch)
+          RequestRCs(rc.pubkey, {}, 0s);
       }
     }
 
@@ -310,22 +482,43 @@ namespace llarp
 
       const auto now = std::chrono::steady_clock::now();
 
+      size_t missing = 0;
       {
         // if we are using a whitelist look up a few routers we don't have
         util::Lock l(_mutex);
         for (const auto& r : whitelistRouters)
         {
-          if (now > _routerLookupTimes[r] + RerequestInterval and not _nodedb->Has(r))
-          {
+          if (_nodedb->Has(r))
+            continue;
+          ++missing;
+          if (now > _routerLookupTimes[r] + RerequestInterval)
             lookupRouters.emplace_back(r);
-          }
         }
       }
-
-      if (lookupRouters.size() > LookupPerTick)
+      // the service node list says who there is, so we are in sync once we have every one of
+      // them; churn among the rest doesn't matter
+      AdaptExploreInterval(bootstrapping or failed or missing > 0);
+
+      // a relay can ask a peer for a whole lot at once, where lookups are a router at a time
+      const auto peers = isServiceNode ? RandomConnectedRouters(1) : std::vector<RouterID>{};
+      const size_t perTick = peers.empty() ? LookupPerTick : dht::FindRCsMessage::MaxRCs;
+      if (lookupRouters.size() > perTick)
       {
         std::shuffle(lookupRouters.begin(), lookupRouters.end(), CSRNG{});
-        lookupRouters.resize(LookupPerTick);
+        lookupRouters.resize(perTick);
+      }
+
+      if (not peers.empty())
+      {
+        if (lookupRouters.empty())
+          return;
+        {
+          util::Lock l(_mutex);
+          for (const auto& r : lookupRouters)
+            _routerLookupTimes[r] = now;
+        }
+        RequestRCs(peers.front(), std::move(lookupRouters), 0s);
+        return;
       }
 
       for (const auto& r : lookupRouters)
@@ -334,19 +527,29 @@ namespace llarp
     }
     // service nodes gossip, not explore
     if (_dht->impl->GetRouter()->IsServiceNode())
+    {
+      AdaptExploreInterval(bootstrapping or failed);
       return;
+    }
 
-    // explore via every connected peer
-    _linkManager->ForEachPeer([&](ILinkSession* s) {
-      if (!s->IsEstablished())
-        return;
-      const RouterContact rc = s->GetRemoteRC();
-      if (rc.IsPublicRouter() && (_bootstrapRCList.find(rc) == _bootstrapRCList.end()))
-      {
-        LogDebug("Doing explore via public node: ", RouterID(rc.pubkey));
-        _dht->impl->ExploreNetworkVia(dht::Key_t{rc.pubkey});
-      }
-    });
+    // while we are behind explore via every connected peer, and once we are not, via just the
+    // one
+    const bool behind = bootstrapping or failed or churning;
+    AdaptExploreInterval(behind);
+    size_t fanout = behind ? std::numeric_limits<size_t>::max() : 1;
+    _linkManager->ForEachPeer(
+        [&](const ILinkSession* s, bool) {
+          if (fanout == 0 or not s->IsEstablished())
+            return;
+          const RouterContact rc = s->GetRemoteRC();
+          if (rc.IsPublicRouter() && (_bootstrapRCList.find(rc) == _bootstrapRCList.end()))
+          {
+            LogDebug("Doing explore via public node: ", RouterID(rc.pubkey));
+            _dht->impl->ExploreNetworkVia(dht::Key_t{rc.pubkey});
+            --fanout;
+          }
+        },
+        true);
   }
 
   void
@@ -427,6 +630,8 @@ namespace llarp
   RCLookupHandler::FinalizeRequest(
       const RouterID& router, const RouterContact* const rc, RCRequestResult result)
   {
+    if (result != RCRequestResult::Success)
+      ++_failedLookups;
     CallbacksQueue movedCallbacks;
     {
       util::Lock l(_mutex);
@@ -7,7 +7,9 @@
 
 #include <unordered_map>
 #include <set>
+#include <vector>
 #include <unordered_set>
+#include <atomic>
 #include <list>
 
 struct llarp_dht_context;
@@ -48,6 +50,13 @@ namespace llarp
 
         ) override EXCLUDES(_mutex);
 
+    void
+    UpdateRouterWhitelist(
+        const std::vector<RouterID>& whitelist,
+        const std::vector<RouterID>& greylist,
+        const std::vector<RouterID>& greenlist,
+        const std::vector<RouterID>& removed) override EXCLUDES(_mutex);
+
     bool
     HaveReceivedWhitelist() const override;
 
@@ -77,6 +86,9 @@ namespace llarp
     bool
     CheckRC(const RouterContact& rc) const override;
 
+    std::vector<bool>
+    CheckRCs(const std::vector<RouterContact>& rcs) const override;
+
     bool
     GetRandomWhitelistRouter(RouterID& router) const override EXCLUDES(_mutex);
 
@@ -89,6 +101,19 @@ namespace llarp
     void
     ExploreNetwork() override;
 
+    llarp_time_t
+    ExploreInterval() const override
+    {
+      return _exploreInterval;
+    }
+
+    /// the quickest we explore, while the nodedb is behind, and the slowest, once it has been in
+    /// sync for a while
+    static constexpr auto MinRelayExploreInterval = 5s;
+    static constexpr auto MinClientExploreInterval = 2s;
+    static constexpr auto MaxRelayExploreInterval = 10min;
+    static constexpr auto MaxClientExploreInterval = 5min;
+
     size_t
     NumberOfStrictConnectRouters() const override;
 
@@ -113,6 +138,10 @@ namespace llarp
     }
 
    private:
+    /// store an rc that CheckRC found valid
+    void
+    AcceptRC(const RouterContact& rc) const;
+
     void
     HandleDHTLookupResult(RouterID remote, const std::vector<RouterContact>& results);
 
@@ -126,6 +155,20 @@ namespace llarp
     FinalizeRequest(const RouterID& router, const RouterContact* const rc, RCRequestResult result)
         EXCLUDES(_mutex);
 
+    /// ask peer in one message for the rcs of routers it has that were updated after since, or
+    /// with no routers given for every such rc it has.  they come back as dht rcs do, and get
+    /// stored the same way.
+    void
+    RequestRCs(const RouterID& peer, std::vector<RouterID> routers, llarp_time_t since);
+
+    /// up to n of the public routers we have a session with, at random
+    std::vector<RouterID>
+    RandomConnectedRouters(size_t n) const;
+
+    /// explore again soon if we are behind, or else wait twice as long as last time
+    void
+    AdaptExploreInterval(bool behind);
+
     mutable util::Mutex _mutex;  // protects pendingCallbacks, whitelistRouters
 
     llarp_dht_context* _dht = nullptr;
@@ -156,6 +199,20 @@ namespace llarp
 
     using TimePoint = std::chrono::steady_clock::time_point;
     std::unordered_map<RouterID, TimePoint> _routerLookupTimes;
+
+    /// when PeriodicUpdate last asked a peer for everything updated since the time before
+    llarp_time_t _lastRCRefresh = 0s;
+    /// when PeriodicUpdate last asked for each stale router, so that it goes a while before it
+    /// asks again
+    std::unordered_map<RouterID, llarp_time_t> _staleRequested;
+    /// when ExploreNetwork last asked the bootstrap routers for their rcs in bulk
+    llarp_time_t _lastBootstrapFetch = 0s;
+    llarp_time_t _exploreInterval = MinClientExploreInterval;
+    /// how many rcs we had as of the last ExploreNetwork, to tell whether the network is churning
+    size_t _lastExploreKnown = 0;
+    /// lookups that failed since the last ExploreNetwork; bumped from whichever thread finishes
+    /// them
+    std::atomic<size_t> _failedLookups{0};
   };
 
 }  // namespace llarp
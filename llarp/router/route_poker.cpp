@@ -78,25 +78,76 @@ namespace llarp
   void
   RoutePoker::DeleteAllRoutes()
   {
-    // DelRoute will check enabled, so no need here
-    for (const auto& item : m_PokedRoutes)
-      DelRoute(item.first);
+    vpn::RouteBatch batch{m_Router->GetVPNPlatform()->RouteManager()};
+    // DisableRoute will check enabled, so no need here
+    for (const auto& [ip, gateway] : m_PokedRoutes)
+      DisableRoute(ip, gateway);
+    m_PokedRoutes.clear();
   }
 
   void
   RoutePoker::DisableAllRoutes()
   {
+    vpn::RouteBatch batch{m_Router->GetVPNPlatform()->RouteManager()};
     for (const auto& [ip, gateway] : m_PokedRoutes)
     {
       DisableRoute(ip, gateway);
     }
   }
 
+  /// a host and the gateway we route it via, as one key
+  static uint64_t
+  HostRouteKey(net::ipv4addr_t ip, net::ipv4addr_t gateway)
+  {
+    return (uint64_t{ip.n} << 32) | gateway.n;
+  }
+
   void
   RoutePoker::RefreshAllRoutes()
   {
-    for (const auto& item : m_PokedRoutes)
-      AddRoute(item.first);
+    if (not m_up or not m_CurrentGateway or not IsEnabled())
+      return;
+    const auto gateway = *m_CurrentGateway;
+    auto& route = m_Router->GetVPNPlatform()->RouteManager();
+
+    // what is in the routing table now, where we can find out, so that we only change what is
+    // not as we want it rather than taking every route down and putting it up again
+    std::optional<std::unordered_set<uint64_t>> current;
+    if (auto routes = route.GetHostRoutes())
+    {
+      current.emplace();
+      for (const auto& [ip, via] : *routes)
+      {
+        const auto* ip4 = std::get_if<net::ipv4addr_t>(&ip);
+        const auto* via4 = std::get_if<net::ipv4addr_t>(&via);
+        if (ip4 and via4 and m_PokedRoutes.count(*ip4))
+          current->insert(HostRouteKey(*ip4, *via4));
+      }
+    }
+
+    size_t changed = 0;
+    vpn::RouteBatch batch{route};
+    for (auto& [ip, via] : m_PokedRoutes)
+    {
+      if (not current)
+      {
+        DisableRoute(ip, via);
+        EnableRoute(ip, gateway);
+        ++changed;
+      }
+      else
+      {
+        const bool stale = via != gateway and current->count(HostRouteKey(ip, via));
+        const bool missing = not current->count(HostRouteKey(ip, gateway));
+        if (stale)
+          DisableRoute(ip, via);
+        if (missing)
+          EnableRoute(ip, gateway);
+        changed += stale or missing;
+      }
+      via = gateway;
+    }
+    log::info(logcat, "{} of {} routes moved to {}", changed, m_PokedRoutes.size(), gateway);
   }
 
   RoutePoker::~RoutePoker()
@@ -105,6 +156,7 @@ namespace llarp
       return;
 
     auto& route = m_Router->GetVPNPlatform()->RouteManager();
+    vpn::RouteBatch batch{route};
     for (const auto& [ip, gateway] : m_PokedRoutes)
     {
       if (gateway.n and ip.n)
@@ -147,15 +199,19 @@ namespace llarp
 
     auto& route = platform->RouteManager();
 
-    // get current gateways, assume sorted by lowest metric first
-    auto gateways = route.GetGatewaysNotOnInterface(*vpn);
-    std::optional<net::ipv4addr_t> next_gw;
-    for (auto& gateway : gateways)
+    // get current gateways, assume sorted by lowest metric first; only when the routing table
+    // may have changed, where the platform can tell us
+    std::optional<net::ipv4addr_t> next_gw = m_CurrentGateway;
+    if (route.GatewaysMayHaveChanged())
     {
-      if (auto* gw_ptr = std::get_if<net::ipv4addr_t>(&gateway))
+      next_gw.reset();
+      for (auto& gateway : route.GetGatewaysNotOnInterface(*vpn))
       {
-        next_gw = *gw_ptr;
-        break;
+        if (auto* gw_ptr = std::get_if<net::ipv4addr_t>(&gateway))
+        {
+          next_gw = *gw_ptr;
+          break;
+        }
       }
     }
 
@@ -215,6 +271,7 @@ namespace llarp
         log::info(logcat, "RoutePoker coming up; poking routes");
 
         vpn::IRouteManager& route = m_Router->GetVPNPlatform()->RouteManager();
+        vpn::RouteBatch batch{route};
 
         // black hole all routes if enabled
         if (m_Router->GetConfig()->network.m_BlackholeRoutes)
@@ -238,6 +295,10 @@ namespace llarp
   void
   RoutePoker::Down()
   {
+    std::optional<vpn::RouteBatch> batch;
+    if (auto* platform = m_Router->GetVPNPlatform())
+      batch.emplace(platform->RouteManager());
+
     // unpoke routes for first hops
     m_Router->ForEachPeer(
         [this](auto session, auto) { DelRoute(session->GetRemoteEndpoint().getIPv4()); }, false);
@@ -15,18 +15,26 @@
 #include <llarp/net/net.hpp>
 #include <stdexcept>
 #include <llarp/util/buffer.hpp>
+#include <llarp/util/buffer_pool.hpp>
+#include <llarp/util/file.hpp>
 #include <llarp/util/logging.hpp>
+#include <llarp/util/logging/async_sink.hpp>
+#include <llarp/util/mem_account.hpp>
 #include <llarp/util/meta/memfn.hpp>
 #include <llarp/util/str.hpp>
+#include <llarp/util/thread/threading.hpp>
 #include <llarp/ev/ev.hpp>
 #include <llarp/tooling/peer_stats_event.hpp>
 
 #include <llarp/tooling/router_event.hpp>
 #include <llarp/util/status.hpp>
 
+#include <array>
+#include <chrono>
 #include <fstream>
 #include <cstdlib>
 #include <iterator>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #if defined(ANDROID) || defined(IOS)
@@ -40,6 +48,7 @@
 #include <llarp/constants/platform.hpp>
 
 #include <oxenmq/oxenmq.h>
+#include <spdlog/sinks/basic_file_sink.h>
 
 static constexpr std::chrono::milliseconds ROUTER_TICK_INTERVAL = 250ms;
 
@@ -56,6 +65,7 @@ namespace llarp
       , _exitContext{this}
       , _dht{llarp_dht_context_new(this)}
       , m_DiskThread{m_lmq->add_tagged_thread("disk")}
+      , m_KeyExchangeThread{m_lmq->add_tagged_thread("key-exchange")}
       , inbound_link_msg_parser{this}
       , _hiddenServiceContext{this}
       , m_RoutePoker{std::make_shared<RoutePoker>()}
@@ -85,6 +95,8 @@ namespace llarp
     llarp::LogTrace("Router::PumpLL() start");
     if (_stopping.load())
       return;
+    paths.PumpCommits();
+    paths.PumpStatuses();
     paths.PumpDownstream();
     paths.PumpUpstream();
     _hiddenServiceContext.Pump();
@@ -106,7 +118,12 @@ namespace llarp
         {"services", _hiddenServiceContext.ExtractStatus()},
         {"exit", _exitContext.ExtractStatus()},
         {"links", _linkManager.ExtractStatus()},
-        {"outboundMessages", _outboundMessageHandler.ExtractStatus()}};
+        {"outboundMessages", _outboundMessageHandler.ExtractStatus()},
+        {"bufferPool", util::BufferPool::ExtractStatus()},
+        {"memory", util::MemAccount::ExtractStatus()},
+        {"crypto", CryptoManager::instance()->ExtractStatus()},
+        {"workQueues", m_WorkScheduler ? m_WorkScheduler->ExtractStatus() : util::StatusObject{}},
+        {"cryptoPool", m_CryptoPool ? m_CryptoPool->ExtractStatus() : util::StatusObject{}}};
   }
 
   util::StatusObject
@@ -285,7 +302,7 @@ namespace llarp
       return _rcLookupHandler.GetRandomWhitelistRouter(router);
     }
 
-    if (const auto maybe = nodedb()->GetRandom([](const auto&) -> bool { return true; }))
+    if (const auto maybe = nodedb()->GetRandomBySummary([](const auto&) { return true; }))
     {
       router = maybe->pubkey;
       return true;
@@ -412,7 +429,15 @@ namespace llarp
     if (log::get_level_default() != log::Level::off)
       log::reset_level(conf.logging.m_logLevel);
     log::clear_sinks();
-    log::add_sink(log_type, log_type == log::Type::System ? "lokinet" : conf.logging.m_logFile);
+    // a file can fall behind on a busy disk; have it written out from its own thread so that
+    // whoever logs never waits on it
+    if (log_type == log::Type::File)
+      log::add_sink(
+          std::make_shared<logging::AsyncSink>(
+              std::make_shared<spdlog::sinks::basic_file_sink_mt>(conf.logging.m_logFile)),
+          log::DEFAULT_PATTERN_MONO);
+    else
+      log::add_sink(log_type, log_type == log::Type::System ? "lokinet" : conf.logging.m_logFile);
 
     // re-add rpc log sink if rpc enabled, else free it
     if (m_Config->api.m_enableRPCServer and llarp::logRingBuffer)
@@ -435,13 +460,53 @@ namespace llarp
 
     if (conf.router.m_workerThreads > 0)
       m_lmq->set_general_threads(conf.router.m_workerThreads);
+    m_WorkScheduler = std::make_unique<thread::WorkScheduler>(
+        [this](auto func) { m_lmq->job(std::move(func)); },
+        conf.router.m_workerThreads > 0 ? conf.router.m_workerThreads
+                                        : std::thread::hardware_concurrency());
+
+    // threads start on the cores of the thread that starts them: the crypto pool and oxenmq's
+    // threads, and the workers oxenmq starts later, get the worker cores; we are the loop thread
+    // and take the logic cores after
+    const auto startCores = util::GetThreadCores();
+    if (not conf.router.m_workerCores.empty())
+      util::PinThreadToCores(conf.router.m_workerCores);
+
+    // tagged threads have to exist before we start
+    if (conf.router.m_cryptoThreads > 0)
+    {
+      if (conf.router.m_linkCryptoThreads > 0 or conf.router.m_pathCryptoThreads > 0)
+        log::warning(logcat, "crypto-threads is set, ignoring link- and path-crypto-threads");
+      m_CryptoPool = std::make_unique<thread::CryptoPool>(
+          conf.router.m_cryptoThreads, conf.router.m_cryptoCores);
+    }
+    else
+    {
+      for (int i = 0; i < conf.router.m_linkCryptoThreads; ++i)
+        m_LinkCryptoThreads.push_back(m_lmq->add_tagged_thread(fmt::format("link-crypto-{}", i)));
+      for (int i = 0; i < conf.router.m_pathCryptoThreads; ++i)
+        m_PathThreads.push_back(m_lmq->add_tagged_thread(fmt::format("path-crypto-{}", i)));
+    }
+    if (conf.router.m_isRelay)
+    {
+      for (int i = 0; i < conf.router.m_pathBuildThreads; ++i)
+        m_PathBuildThreads.push_back(m_lmq->add_tagged_thread(fmt::format("path-build-{}", i)));
+    }
 
     log::debug(logcat, "Starting OMQ server");
-    m_lmq->start();
+    StartOxenMQ();
+
+    if (not conf.router.m_logicCores.empty())
+      util::PinThreadToCores(conf.router.m_logicCores);
+    else if (not conf.router.m_workerCores.empty())
+      util::PinThreadToCores(startCores);
+    if (auto cores = conf.router.m_diskCores; not cores.empty())
+      QueueDiskIO([cores = std::move(cores)] { util::PinThreadToCores(cores); });
 
     _nodedb = std::move(nodedb);
 
     m_isServiceNode = conf.router.m_isRelay;
+    m_TickBudget = std::chrono::microseconds{conf.router.m_tickBudget};
     log::debug(
         logcat, m_isServiceNode ? "Running as a relay (service node)" : "Running as a client");
 
@@ -517,6 +582,8 @@ namespace llarp
     log::info(logcat, "closing");
     if (_onDown)
       _onDown();
+    // its handle has to be closed while the loop is still here to close it
+    m_MetricsServer.reset();
     log::debug(logcat, "stopping mainloop");
     _loop->stop();
     _running.store(false);
@@ -652,6 +719,8 @@ namespace llarp
     _rc.SetNick(conf.router.m_nickname);
     _outboundSessionMaker.maxConnectedRouters = conf.router.m_maxConnectedRouters;
     _outboundSessionMaker.minConnectedRouters = conf.router.m_minConnectedRouters;
+    for (const auto& [tag, kB] : conf.router.m_MemoryLimits)
+      util::MemAccount::SetSoftLimit(tag, kB * 1000);
 
     encryption_keyfile = m_keyManager->m_encKeyPath;
     our_rc_file = m_keyManager->m_rcPath;
@@ -777,13 +846,13 @@ namespace llarp
         &_rcLookupHandler,
         &_routerProfiling,
         _loop,
-        util::memFn(&AbstractRouter::QueueWork, this));
+        [this](auto func) { QueueWork(std::move(func), thread::WorkClass::Background); });
     _linkManager.Init(&_outboundSessionMaker);
     _rcLookupHandler.Init(
         _dht,
         _nodedb,
         _loop,
-        util::memFn(&AbstractRouter::QueueWork, this),
+        [this](auto func) { QueueWork(std::move(func), thread::WorkClass::Background); },
         &_linkManager,
         &_hiddenServiceContext,
         strictConnectPubkeys,
@@ -798,6 +867,10 @@ namespace llarp
 
     // profiling
     _profilesFile = conf.router.m_dataDir / "profiles.dat";
+    _performanceFile = conf.router.m_dataDir / "performance.dat";
+    _goodPeersFile = conf.router.m_dataDir / "peers.dat";
+    if (not m_isServiceNode)
+      LoadGoodPeers();
 
     // Network config
     if (conf.network.m_enableProfiling.value_or(false))
@@ -818,6 +891,9 @@ namespace llarp
       routerProfiling().Disable();
       LogInfo("router profiling disabled");
     }
+    // rtts and bandwidths from before a restart, for hop selection to go by until we have our own
+    if (conf.network.m_saveProfiles and fs::exists(_performanceFile))
+      routerProfiling().LoadPerformance(_performanceFile);
 
     // API config
     if (not IsServiceNode())
@@ -926,6 +1002,9 @@ namespace llarp
   {
     if (_stopping)
       return;
+    // the last tick ran out of budget and is still catching up; let it finish first
+    if (m_TickRunning)
+      return;
     // LogDebug("tick router");
     const auto now = Now();
     if (const auto delta = now - _lastTick; _lastTick != 0s and delta > TimeskipDetectedDuration)
@@ -934,25 +1013,89 @@ namespace llarp
       LogWarn("Timeskip of ", ToString(delta), " detected. Resetting network state");
       Thaw();
     }
+    m_TickRunning = true;
+    m_TickNow = now;
+    m_TickStage = 0;
+    ContinueTick();
+  }
 
+  void
+  Router::ContinueTick()
+  {
+    // each stage returns true once it is done, or false if it stopped part way to be called again
+    static constexpr std::array<bool (Router::*)(llarp_time_t), 6> stages{
+        &Router::TickHousekeeping,
+        &Router::TickNodeDBPolicy,
+        &Router::TickPeers,
+        &Router::TickServices,
+        &Router::TickSaves,
+        &Router::TickPaths};
+
+    if (_stopping)
+    {
+      m_TickRunning = false;
+      return;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    while (m_TickStage < stages.size())
+    {
+      if ((this->*stages[m_TickStage])(m_TickNow))
+        ++m_TickStage;
+      if (m_TickStage < stages.size() and m_TickBudget > 0us
+          and std::chrono::steady_clock::now() - started >= m_TickBudget)
+      {
+        // the rest next time round the loop, after the io that has come in meanwhile; a timer
+        // rather than call_soon, which could run it in the same pass
+        _loop->call_later(0ms, [this, self = weak_from_this()] {
+          if (self.lock())
+            ContinueTick();
+        });
+        return;
+      }
+    }
+    m_TickRunning = false;
+    // update tick timestamp
+    _lastTick = llarp::time_now_ms();
+  }
+
+  bool
+  Router::TickHousekeeping(llarp_time_t now)
+  {
     llarp::sys::service_manager->report_periodic_stats();
 
     m_PathBuildLimiter.Decay(now);
 
     routerProfiling().Tick();
 
+    util::MemAccount::Tick(now);
+
+    // latency aware hop selection learns first hop rtts from our links, and relays size their
+    // dht lookup timeouts by them; having many more links, they take them less often
+    static constexpr auto RelayRTTSampleInterval = 5s;
+    if (m_Config->paths.m_LatencyAware
+        or (IsServiceNode() and now - m_LastRTTSample >= RelayRTTSampleInterval))
+    {
+      m_LastRTTSample = now;
+      _linkManager.ForEachPeer([this](ILinkSession* session) {
+        const auto stats = session->GetSessionStats();
+        routerProfiling().MarkRTT(session->GetPubKey(), stats.smoothedRTT);
+        routerProfiling().MarkBandwidth(
+            session->GetPubKey(), stats.currentRateRX + stats.currentRateTX);
+      });
+    }
+
     if (ShouldReportStats(now))
     {
       ReportStats();
     }
 
     _rcGossiper.Decay(now);
+    _rcGossiper.SendBatch(now);
 
     _rcLookupHandler.PeriodicUpdate(now);
 
     const bool gotWhitelist = _rcLookupHandler.HaveReceivedWhitelist();
     const bool isSvcNode = IsServiceNode();
-    const bool decom = LooksDecommissioned();
     bool shouldGossip = isSvcNode and whitelistRouters and gotWhitelist
         and _rcLookupHandler.SessionIsAllowed(pubkey());
 
@@ -976,54 +1119,73 @@ namespace llarp
       // the white or grey list, we want to gossip our RC
       GossipRCIfNeeded(_rc);
     }
+    return true;
+  }
+
+  bool
+  Router::TickNodeDBPolicy(llarp_time_t now)
+  {
+    const bool gotWhitelist = _rcLookupHandler.HaveReceivedWhitelist();
+    const bool isSvcNode = IsServiceNode();
     // remove RCs for nodes that are no longer allowed by network policy
-    nodedb()->RemoveIf([&](const RouterContact& rc) -> bool {
-      // don't purge bootstrap nodes from nodedb
-      if (IsBootstrapNode(rc.pubkey))
-      {
-        log::trace(logcat, "Not removing {}: is bootstrap node", rc.pubkey);
-        return false;
-      }
-      // if for some reason we stored an RC that isn't a valid router
-      // purge this entry
-      if (not rc.IsPublicRouter())
-      {
-        log::debug(logcat, "Removing {}: not a valid router", rc.pubkey);
-        return true;
-      }
-      /// clear out a fully expired RC
-      if (rc.IsExpired(now))
-      {
-        log::debug(logcat, "Removing {}: RC is expired", rc.pubkey);
-        return true;
-      }
-      // clients have no notion of a whilelist
-      // we short circuit logic here so we dont remove
-      // routers that are not whitelisted for first hops
-      if (not isSvcNode)
-      {
-        log::trace(logcat, "Not removing {}: we are a client and it looks fine", rc.pubkey);
-        return false;
-      }
+    return nodedb()->RemoveIfChunk(
+        [&](const RouterContact& rc) -> bool {
+          // don't purge bootstrap nodes from nodedb
+          if (IsBootstrapNode(rc.pubkey))
+          {
+            log::trace(logcat, "Not removing {}: is bootstrap node", rc.pubkey);
+            return false;
+          }
+          // if for some reason we stored an RC that isn't a valid router
+          // purge this entry
+          if (not rc.IsPublicRouter())
+          {
+            log::debug(logcat, "Removing {}: not a valid router", rc.pubkey);
+            return true;
+          }
+          /// clear out a fully expired RC
+          if (rc.IsExpired(now))
+          {
+            log::debug(logcat, "Removing {}: RC is expired", rc.pubkey);
+            return true;
+          }
+          // clients have no notion of a whilelist
+          // we short circuit logic here so we dont remove
+          // routers that are not whitelisted for first hops
+          if (not isSvcNode)
+          {
+            log::trace(logcat, "Not removing {}: we are a client and it looks fine", rc.pubkey);
+            return false;
+          }
 
-      // if we have a whitelist enabled and we don't
-      // have the whitelist yet don't remove the entry
-      if (whitelistRouters and not gotWhitelist)
-      {
-        log::debug(logcat, "Skipping check on {}: don't have whitelist yet", rc.pubkey);
-        return false;
-      }
-      // if we have no whitelist enabled or we have
-      // the whitelist enabled and we got the whitelist
-      // check against the whitelist and remove if it's not
-      // in the whitelist OR if there is no whitelist don't remove
-      if (gotWhitelist and not _rcLookupHandler.SessionIsAllowed(rc.pubkey))
-      {
-        log::debug(logcat, "Removing {}: not a valid router", rc.pubkey);
-        return true;
-      }
-      return false;
-    });
+          // if we have a whitelist enabled and we don't
+          // have the whitelist yet don't remove the entry
+          if (whitelistRouters and not gotWhitelist)
+          {
+            log::debug(logcat, "Skipping check on {}: don't have whitelist yet", rc.pubkey);
+            return false;
+          }
+          // if we have no whitelist enabled or we have
+          // the whitelist enabled and we got the whitelist
+          // check against the whitelist and remove if it's not
+          // in the whitelist OR if there is no whitelist don't remove
+          if (gotWhitelist and not _rcLookupHandler.SessionIsAllowed(rc.pubkey))
+          {
+            log::debug(logcat, "Removing {}: not a valid router", rc.pubkey);
+            return true;
+          }
+          return false;
+        },
+        m_NodeDBCursor,
+        NodeDBPolicyChunk);
+  }
+
+  bool
+  Router::TickPeers(llarp_time_t now)
+  {
+    const bool gotWhitelist = _rcLookupHandler.HaveReceivedWhitelist();
+    const bool isSvcNode = IsServiceNode();
+    const bool decom = LooksDecommissioned();
 
     // find all deregistered relays
     std::unordered_set<PubKey> closePeers;
@@ -1052,12 +1214,12 @@ namespace llarp
       connected += _linkManager.NumberOfPendingConnections();
     }
 
-    const int interval = isSvcNode ? 5 : 2;
     const auto timepoint_now = Clock_t::now();
-    if (timepoint_now >= m_NextExploreAt and not decom)
+    // going to the bootstrap routers for more while we have yet to read what we had is a waste
+    if (timepoint_now >= m_NextExploreAt and not decom and not m_LoadingNodeDB)
     {
       _rcLookupHandler.ExploreNetwork();
-      m_NextExploreAt = timepoint_now + std::chrono::seconds(interval);
+      m_NextExploreAt = timepoint_now + _rcLookupHandler.ExploreInterval();
     }
     size_t connectToNum = _outboundSessionMaker.minConnectedRouters;
     const auto strictConnect = _rcLookupHandler.NumberOfStrictConnectRouters();
@@ -1099,15 +1261,37 @@ namespace llarp
       LogDebug("connecting to ", dlt, " random routers to keep alive");
       _outboundSessionMaker.ConnectToRandomRouters(dlt);
     }
+    return true;
+  }
 
+  bool
+  Router::TickServices(llarp_time_t now)
+  {
     _hiddenServiceContext.Tick(now);
     _exitContext.Tick(now);
+    return true;
+  }
 
+  bool
+  Router::TickSaves(llarp_time_t now)
+  {
     // save profiles
     if (routerProfiling().ShouldSave(now) and m_Config->network.m_saveProfiles)
     {
       QueueDiskIO([&]() { routerProfiling().Save(_profilesFile); });
     }
+    if (routerProfiling().ShouldSavePerformance(now) and m_Config->network.m_saveProfiles)
+    {
+      QueueDiskIO([&]() { routerProfiling().SavePerformance(_performanceFile); });
+    }
+
+    static constexpr auto GoodPeersSaveInterval = 5min;
+    if (not IsServiceNode() and NumberOfConnectedRouters() > 0
+        and now - m_LastGoodPeersSave >= GoodPeersSaveInterval)
+    {
+      m_LastGoodPeersSave = now;
+      SaveGoodPeers();
+    }
 
     _nodedb->Tick(now);
 
@@ -1133,7 +1317,12 @@ namespace llarp
         });
       }
     }
+    return true;
+  }
 
+  bool
+  Router::TickPaths(llarp_time_t now)
+  {
     // get connected peers
     std::set<dht::Key_t> peersWeHave;
     _linkManager.ForEachPeer([&peersWeHave](ILinkSession* s) {
@@ -1146,8 +1335,7 @@ namespace llarp
         [&peersWeHave](const dht::Key_t& k) -> bool { return peersWeHave.count(k) == 0; });
     // expire paths
     paths.ExpirePaths(now);
-    // update tick timestamp
-    _lastTick = llarp::time_now_ms();
+    return true;
   }
 
   bool
@@ -1217,10 +1405,7 @@ namespace llarp
   void
   Router::HandleDHTLookupForExplore(RouterID /*remote*/, const std::vector<RouterContact>& results)
   {
-    for (const auto& rc : results)
-    {
-      _rcLookupHandler.CheckRC(rc);
-    }
+    _rcLookupHandler.CheckRCs(results);
   }
 
   // TODO: refactor callers and remove this function
@@ -1252,12 +1437,69 @@ namespace llarp
     _rcLookupHandler.SetRouterWhitelist(whitelist, greylist, unfundedlist);
   }
 
+  void
+  Router::UpdateRouterWhitelist(
+      const std::vector<RouterID>& whitelist,
+      const std::vector<RouterID>& greylist,
+      const std::vector<RouterID>& unfundedlist,
+      const std::vector<RouterID>& removed)
+  {
+    _rcLookupHandler.UpdateRouterWhitelist(whitelist, greylist, unfundedlist, removed);
+  }
+
+  std::vector<std::string>
+  Router::Reconfigure(std::shared_ptr<Config> conf)
+  {
+    std::vector<std::string> restart;
+    const auto& was = *m_Config;
+    // what the interface, its resolver and our identity were made with stays as it is
+    const auto keep = [&restart](auto& now, const auto& before, std::string setting) {
+      if (not(now == before))
+      {
+        restart.push_back(std::move(setting));
+        now = before;
+      }
+    };
+    keep(conf->network.m_ifname, was.network.m_ifname, "[network]:ifname");
+    keep(conf->network.m_ifaddr, was.network.m_ifaddr, "[network]:ifaddr");
+    keep(conf->network.m_keyfile, was.network.m_keyfile, "[network]:keyfile");
+    keep(conf->network.m_endpointType, was.network.m_endpointType, "[network]:type");
+    keep(conf->network.m_TunQueues, was.network.m_TunQueues, "[network]:tun-queues");
+    keep(conf->dns.m_bind, was.dns.m_bind, "[dns]:bind");
+    keep(conf->dns.m_hostfiles, was.dns.m_hostfiles, "[dns]:add-hosts");
+
+    if (IsServiceNode())
+    {
+      if (auto exit = _exitContext.GetExitEndpoint("default"))
+        exit->Reconfigure(conf->network, conf->dns);
+    }
+    else if (auto ep = hiddenServiceContext().GetDefault())
+      ep->Reconfigure(was.network, conf->network, conf->dns);
+
+    // assigned into rather than swapped out, as there are references to these about
+    m_Config->network = conf->network;
+    m_Config->dns = conf->dns;
+
+    for (const auto& setting : restart)
+      log::warning(logcat, "{} changed, but will only take effect on restart", setting);
+    log::info(logcat, "reloaded [network] and [dns] config");
+    return restart;
+  }
+
   bool
   Router::StartRpcServer()
   {
     if (m_Config->api.m_enableRPCServer)
       m_RPCServer = std::make_unique<rpc::RPCServer>(m_lmq, *this);
 
+    if (const auto& bind = m_Config->api.m_metricsBindAddress)
+    {
+      if (auto uvw = _loop->MaybeGetUVWLoop())
+        m_MetricsServer = std::make_unique<rpc::MetricsServer>(uvw, *bind);
+      else
+        log::warning(logcat, "not serving metrics on {}: the event loop cannot serve tcp", *bind);
+    }
+
     return true;
   }
 
@@ -1267,6 +1509,15 @@ namespace llarp
     if (_running || _stopping)
       return false;
 
+    // read the nodedb on the disk thread while we start our links and endpoints below, rather
+    // than before them; the loop puts the rcs in once it runs
+    LogInfo("Loading nodedb from disk...");
+    m_LoadingNodeDB = true;
+    QueueDiskIO([this] {
+      auto rcs = _nodedb->ReadFromDisk();
+      _loop->call([this, rcs = std::move(rcs)]() mutable { AddLoadedRCs(std::move(rcs)); });
+    });
+
     // set public signing key
     _rc.pubkey = seckey_topublic(identity());
     // set router version if service node
@@ -1317,20 +1568,35 @@ namespace llarp
     // set public encryption key
     _rc.enckey = seckey_topublic(encryption());
 
-    LogInfo("Signing rc...");
-    if (!_rc.Sign(identity()))
+    // a relay that comes back up as it went down goes on with the rc it saved while that is
+    // fresh, rather than sign and write out the same again before it can start; the ticker
+    // signs a new one when it is due
+    const auto now = Now();
+    if (const auto& saved = m_keyManager->savedRC; IsServiceNode() and saved
+        and saved->SignsSameAs(_rc) and not saved->ExpiresSoon(now)
+        and now - saved->last_updated < rcRegenInterval)
     {
-      LogError("failed to sign rc");
-      return false;
+      LogInfo("our rc is unchanged since we saved it, not signing it again");
+      _rc = *saved;
+      _nodedb->Put(_rc);
     }
-
-    if (IsServiceNode())
+    else
     {
-      if (!SaveRC())
+      LogInfo("Signing rc...");
+      if (!_rc.Sign(identity()))
       {
-        LogError("failed to save RC");
+        LogError("failed to sign rc");
         return false;
       }
+
+      if (IsServiceNode())
+      {
+        if (!SaveRC())
+        {
+          LogError("failed to save RC");
+          return false;
+        }
+      }
     }
     _outboundSessionMaker.SetOurRouter(pubkey());
     if (!_linkManager.StartLinks())
@@ -1350,7 +1616,7 @@ namespace llarp
       const RouterID us = pubkey();
       LogInfo("initalized service node: ", us);
       // init gossiper here
-      _rcGossiper.Init(&_linkManager, us, this);
+      _rcGossiper.Init(&_linkManager, us, this, m_Config->router.m_GossipBatchInterval);
       // relays do not use profiling
       routerProfiling().Disable();
     }
@@ -1376,11 +1642,6 @@ namespace llarp
       return false;
     }
 
-    {
-      LogInfo("Loading nodedb from disk...");
-      _nodedb->LoadFromDisk();
-    }
-
     llarp_dht_context_start(dht(), pubkey());
 
     for (const auto& rc : bootstrapRCList)
@@ -1390,8 +1651,6 @@ namespace llarp
       LogInfo("added bootstrap node ", RouterID{rc.pubkey});
     }
 
-    LogInfo("have ", _nodedb->NumLoaded(), " routers");
-
     _loop->call_every(ROUTER_TICK_INTERVAL, weak_from_this(), [this] { Tick(); });
     m_RoutePoker->Start(this);
     _running.store(true);
@@ -1408,12 +1667,49 @@ namespace llarp
         // yet when we expect to have one.
         if (not ShouldTestOtherRouters())
           return;
-        auto tests = m_routerTesting.get_failing();
-        if (auto maybe = m_routerTesting.next_random(this))
-        {
-          tests.emplace_back(*maybe, 0);
-        }
-        for (const auto& [router, fails] : tests)
+        auto report = [this](const RouterID& router, int previous_fails, SessionResult result) {
+          auto rpc = RpcClient();
+
+          if (result != SessionResult::Establish)
+          {
+            // failed connection mark it as so
+            m_routerTesting.add_failing_node(router, previous_fails);
+            LogInfo(
+                "FAILED SN connection test to ",
+                router,
+                " (",
+                previous_fails + 1,
+                " consecutive failures) result=",
+                result);
+          }
+          else
+          {
+            m_routerTesting.remove_node_from_failing(router);
+            if (previous_fails > 0)
+            {
+              LogInfo(
+                  "Successful SN connection test to ",
+                  router,
+                  " after ",
+                  previous_fails,
+                  " failures");
+            }
+            else
+            {
+              LogDebug("Successful SN connection test to ", router);
+            }
+          }
+          if (rpc)
+          {
+            // inform as needed
+            rpc->InformConnection(router, result == SessionResult::Establish);
+          }
+        };
+        // an outbound session we already have is as good a test as a new one, and costs nothing
+        const auto have_session = [this](const RouterID& router) {
+          return linkManager().HasOutboundSessionTo(router);
+        };
+        for (const auto& [router, fails, proven] : m_routerTesting.next_tests(this, have_session))
         {
           if (not SessionToRouterAllowed(router))
           {
@@ -1423,47 +1719,18 @@ namespace llarp
             m_routerTesting.remove_node_from_failing(router);
             continue;
           }
+          if (proven)
+          {
+            LogDebug("Existing session to ", router, " passes SN testing");
+            report(router, fails, SessionResult::Establish);
+            continue;
+          }
           LogDebug("Establishing session to ", router, " for SN testing");
           // try to make a session to this random router
           // this will do a dht lookup if needed
           _outboundSessionMaker.CreateSessionTo(
-              router, [previous_fails = fails, this](const auto& router, const auto result) {
-                auto rpc = RpcClient();
-
-                if (result != SessionResult::Establish)
-                {
-                  // failed connection mark it as so
-                  m_routerTesting.add_failing_node(router, previous_fails);
-                  LogInfo(
-                      "FAILED SN connection test to ",
-                      router,
-                      " (",
-                      previous_fails + 1,
-                      " consecutive failures) result=",
-                      result);
-                }
-                else
-                {
-                  m_routerTesting.remove_node_from_failing(router);
-                  if (previous_fails > 0)
-                  {
-                    LogInfo(
-                        "Successful SN connection test to ",
-                        router,
-                        " after ",
-                        previous_fails,
-                        " failures");
-                  }
-                  else
-                  {
-                    LogDebug("Successful SN connection test to ", router);
-                  }
-                }
-                if (rpc)
-                {
-                  // inform as needed
-                  rpc->InformConnection(router, result == SessionResult::Establish);
-                }
+              router, [report, previous_fails = fails](const auto& router, const auto result) {
+                report(router, previous_fails, result);
               });
         }
       });
@@ -1494,6 +1761,7 @@ namespace llarp
     Close();
     log::debug(logcat, "stopping oxenmq");
     m_lmq.reset();
+    m_CryptoPool.reset();
   }
 
   void
@@ -1598,6 +1866,109 @@ namespace llarp
     _outboundSessionMaker.ConnectToRandomRouters(want);
   }
 
+  void
+  Router::SaveGoodPeers()
+  {
+    std::string ids;
+    _linkManager.ForEachPeer([&ids](const ILinkSession* session, bool) {
+      if (session and session->IsEstablished() and session->GetRemoteRC().IsPublicRouter())
+      {
+        const auto& pk = session->GetPubKey();
+        ids.append(reinterpret_cast<const char*>(pk.data()), pk.size());
+      }
+    });
+    // if we have lost every session, what we saved last time is still the better bet
+    if (ids.empty())
+      return;
+    QueueDiskIO([fpath = _goodPeersFile, ids = std::move(ids)] {
+      try
+      {
+        util::dump_file(fpath, ids);
+      }
+      catch (const std::exception& e)
+      {
+        log::warning(logcat, "failed to save peers to {}: {}", fpath, e.what());
+      }
+    });
+  }
+
+  void
+  Router::LoadGoodPeers()
+  {
+    if (not fs::exists(_goodPeersFile))
+      return;
+    std::string ids;
+    try
+    {
+      ids = util::slurp_file(_goodPeersFile);
+    }
+    catch (const std::exception& e)
+    {
+      log::warning(logcat, "failed to load peers from {}: {}", _goodPeersFile, e.what());
+      return;
+    }
+    m_SavedGoodPeers.clear();
+    for (size_t pos = 0; pos + RouterID::SIZE <= ids.size(); pos += RouterID::SIZE)
+      m_SavedGoodPeers.emplace_back(reinterpret_cast<const byte_t*>(ids.data() + pos));
+    log::debug(logcat, "loaded {} peers from {}", m_SavedGoodPeers.size(), _goodPeersFile);
+  }
+
+  void
+  Router::AddLoadedRCs(std::vector<RouterContact> rcs)
+  {
+    m_LoadingNodeDB = false;
+    const auto added = _nodedb->AddPending(std::move(rcs));
+    LogInfo("loaded ", added, " routers from disk, have ", _nodedb->NumLoaded(), " routers");
+
+    // rcs checked a chunk at a time across the workers rather than all of them in one job, so
+    // that paths can be built over the first chunks while the rest are still being checked
+    static constexpr size_t VerifyChunk = 256;
+    auto pending = _nodedb->PendingRCs();
+    if (pending.empty())
+    {
+      ConnectToSavedPeers();
+      return;
+    }
+    auto left = std::make_shared<size_t>((pending.size() + VerifyChunk - 1) / VerifyChunk);
+    for (auto itr = pending.begin(); itr != pending.end();)
+    {
+      const auto end = itr + std::min<size_t>(VerifyChunk, pending.end() - itr);
+      QueueWork([this,
+                 left,
+                 chunk = std::vector<RouterContact>{
+                     std::make_move_iterator(itr), std::make_move_iterator(end)}]() mutable {
+        auto valid = RouterContact::VerifySignatures(chunk);
+        _loop->call([this, left, chunk = std::move(chunk), valid = std::move(valid)] {
+          _nodedb->VerifiedPending(chunk, valid);
+          // the peers we had last time are connected to once all the rcs are in, as before
+          if (--*left == 0)
+            ConnectToSavedPeers();
+        });
+      });
+      itr = end;
+    }
+  }
+
+  void
+  Router::ConnectToSavedPeers()
+  {
+    const auto now = Now();
+    size_t connecting = 0;
+    for (const auto& id : m_SavedGoodPeers)
+    {
+      if (not _rcLookupHandler.SessionIsAllowed(id) or _linkManager.HasSessionTo(id))
+        continue;
+      const auto rc = _nodedb->Get(id);
+      if (not rc or rc->IsExpired(now))
+        continue;
+      _outboundSessionMaker.CreateSessionTo(*rc, nullptr);
+      ++connecting;
+    }
+    if (connecting)
+      log::info(logcat, "connecting to {} peers from our last run", connecting);
+    m_SavedGoodPeers.clear();
+  }
+
   bool
   Router::InitServiceNode()
   {
@@ -1629,9 +2000,18 @@ namespace llarp
   }
 
   void
-  Router::QueueWork(std::function<void(void)> func)
+  Router::StartOxenMQ()
+  {
+    m_lmq->start();
+  }
+
+  void
+  Router::QueueWork(std::function<void(void)> func, thread::WorkClass cls)
   {
-    m_lmq->job(std::move(func));
+    if (m_WorkScheduler)
+      m_WorkScheduler->Queue(cls, std::move(func));
+    else
+      m_lmq->job(std::move(func));
   }
 
   void
@@ -1640,6 +2020,50 @@ namespace llarp
     m_lmq->job(std::move(func), m_DiskThread);
   }
 
+  void
+  Router::QueueShardedWork(uint64_t shard, thread::InlineTask func)
+  {
+    if (m_CryptoPool)
+      m_CryptoPool->Queue(shard, std::move(func));
+    else if (m_LinkCryptoThreads.empty())
+      AbstractRouter::QueueShardedWork(shard, std::move(func));
+    else
+      m_lmq->job(
+          [func = std::make_shared<thread::InlineTask>(std::move(func))] { (*func)(); },
+          m_LinkCryptoThreads[shard % m_LinkCryptoThreads.size()]);
+  }
+
+  void
+  Router::QueuePathWork(uint64_t shard, thread::InlineTask func)
+  {
+    if (m_CryptoPool)
+      m_CryptoPool->Queue(shard, std::move(func));
+    else if (m_PathThreads.empty())
+      AbstractRouter::QueuePathWork(shard, std::move(func));
+    else
+      m_lmq->job(
+          [func = std::make_shared<thread::InlineTask>(std::move(func))] { (*func)(); },
+          m_PathThreads[shard % m_PathThreads.size()]);
+  }
+
+  void
+  Router::QueuePathBuildWork(std::function<void(void)> func)
+  {
+    // batches are independent of each other, so they just go round the threads
+    if (not m_PathBuildThreads.empty())
+      m_lmq->job(
+          std::move(func),
+          m_PathBuildThreads[m_NextPathBuildThread++ % m_PathBuildThreads.size()]);
+    else
+      QueueWork(std::move(func), thread::WorkClass::PathBuild);
+  }
+
+  void
+  Router::QueueKeyExchangeWork(std::function<void(void)> func)
+  {
+    m_lmq->job(std::move(func), m_KeyExchangeThread);
+  }
+
   bool
   Router::HasClientExit() const
   {
@@ -1714,7 +2138,7 @@ namespace llarp
           util::memFn(&Router::ConnectionTimedOut, this),
           util::memFn(&AbstractRouter::SessionClosed, this),
           util::memFn(&AbstractRouter::TriggerPump, this),
-          util::memFn(&AbstractRouter::QueueWork, this));
+          [this](auto func) { QueueWork(std::move(func), thread::WorkClass::DataPlane); });
 
       server->Bind(this, bind_addr);
       _linkManager.AddLink(std::move(server), true);
@@ -1747,7 +2171,7 @@ namespace llarp
           util::memFn(&Router::ConnectionTimedOut, this),
           util::memFn(&AbstractRouter::SessionClosed, this),
           util::memFn(&AbstractRouter::TriggerPump, this),
-          util::memFn(&AbstractRouter::QueueWork, this));
+          [this](auto func) { QueueWork(std::move(func), thread::WorkClass::DataPlane); });
 
       const auto& net = Net();
 
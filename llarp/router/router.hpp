@@ -26,6 +26,7 @@
 #include <llarp/routing/handler.hpp>
 #include <llarp/routing/message_parser.hpp>
 #include <llarp/rpc/lokid_rpc_client.hpp>
+#include <llarp/rpc/metrics_server.hpp>
 #include <llarp/rpc/rpc_server.hpp>
 #include <llarp/service/context.hpp>
 #include <stdexcept>
@@ -148,6 +149,16 @@ namespace llarp
         const std::vector<RouterID>& greylist,
         const std::vector<RouterID>& unfunded) override;
 
+    void
+    UpdateRouterWhitelist(
+        const std::vector<RouterID>& whitelist,
+        const std::vector<RouterID>& greylist,
+        const std::vector<RouterID>& unfunded,
+        const std::vector<RouterID>& removed) override;
+
+    std::vector<std::string>
+    Reconfigure(std::shared_ptr<Config> conf) override;
+
     std::unordered_set<RouterID>
     GetRouterWhitelist() const override
     {
@@ -197,11 +208,25 @@ namespace llarp
     }
 
     void
-    QueueWork(std::function<void(void)> func) override;
+    QueueWork(
+        std::function<void(void)> func,
+        thread::WorkClass cls = thread::WorkClass::Background) override;
 
     void
     QueueDiskIO(std::function<void(void)> func) override;
 
+    void
+    QueueShardedWork(uint64_t shard, thread::InlineTask func) override;
+
+    void
+    QueuePathWork(uint64_t shard, thread::InlineTask func) override;
+
+    void
+    QueuePathBuildWork(std::function<void(void)> func) override;
+
+    void
+    QueueKeyExchangeWork(std::function<void(void)> func) override;
+
     /// return true if we look like we are a decommissioned service node
     bool
     LooksDecommissioned() const;
@@ -233,6 +258,20 @@ namespace llarp
     std::shared_ptr<NodeDB> _nodedb;
     llarp_time_t _startedAt;
     const oxenmq::TaggedThreadID m_DiskThread;
+    /// hidden service key exchanges, which can be many at once and slow on a busy service
+    const oxenmq::TaggedThreadID m_KeyExchangeThread;
+    /// dedicated link crypto threads, if configured
+    std::vector<oxenmq::TaggedThreadID> m_LinkCryptoThreads;
+    /// dedicated path traffic crypto threads, if configured
+    std::vector<oxenmq::TaggedThreadID> m_PathThreads;
+    /// dedicated path build (LRCM) threads, on relays, and the next of them to get a batch; only
+    /// used from the logic thread
+    std::vector<oxenmq::TaggedThreadID> m_PathBuildThreads;
+    size_t m_NextPathBuildThread = 0;
+    /// link and path traffic crypto pool, if configured; takes over from the two above
+    std::unique_ptr<thread::CryptoPool> m_CryptoPool;
+    /// queues general worker jobs by class ahead of the worker pool, once we know its size
+    std::unique_ptr<thread::WorkScheduler> m_WorkScheduler;
 
     llarp_time_t
     Uptime() const override;
@@ -299,6 +338,7 @@ namespace llarp
     PumpLL();
 
     std::unique_ptr<rpc::RPCServer> m_RPCServer;
+    std::unique_ptr<rpc::MetricsServer> m_MetricsServer;
 
     const llarp_time_t _randomStartDelay;
 
@@ -307,6 +347,10 @@ namespace llarp
     oxenmq::address lokidRPCAddr;
     Profiling _routerProfiling;
     fs::path _profilesFile;
+    fs::path _performanceFile;
+    fs::path _goodPeersFile;
+    std::vector<RouterID> m_SavedGoodPeers;
+    llarp_time_t m_LastGoodPeersSave = 0s;
     OutboundMessageHandler _outboundMessageHandler;
     OutboundSessionMaker _outboundSessionMaker;
     LinkManager _linkManager;
@@ -514,6 +558,28 @@ namespace llarp
     void
     ConnectToRandomRouters(int N) override;
 
+    /// a client writes the relays it has sessions with to _goodPeersFile now and then, so that
+    /// on its next start it can go straight back to them and build paths before the network
+    /// has been refreshed
+    void
+    SaveGoodPeers();
+
+    /// read the relays the last SaveGoodPeers wrote into m_SavedGoodPeers
+    void
+    LoadGoodPeers();
+
+    /// connect to each of m_SavedGoodPeers we have a current rc for, once the nodedb is loaded
+    void
+    ConnectToSavedPeers();
+
+    /// put in the rcs the disk thread read at startup, and check their signatures a chunk per
+    /// worker job, each chunk put to use as soon as it checks out
+    void
+    AddLoadedRCs(std::vector<RouterContact> rcs);
+
+    /// set from Run until the nodedb's rcs have been read off disk
+    bool m_LoadingNodeDB = false;
+
     /// count the number of unique service nodes connected via pubkey
     size_t
     NumberOfConnectedRouters() const override;
@@ -566,6 +632,40 @@ namespace llarp
     static constexpr auto DECOMM_WARNING_STARTUP_DELAY = 15s;
 
     llarp_time_t m_LastStatsReport = 0s;
+    llarp_time_t m_LastRTTSample = 0s;
+
+    /// where the tick in progress is, when it is spread over several loop iterations
+    bool m_TickRunning = false;
+    size_t m_TickStage = 0;
+    llarp_time_t m_TickNow = 0s;
+    std::optional<RouterID> m_NodeDBCursor;
+    /// longest we run tick stages for before letting the loop see to io; 0 for no limit
+    std::chrono::microseconds m_TickBudget{0};
+    /// nodedb entries the policy check looks at between looks at the clock
+    static constexpr size_t NodeDBPolicyChunk = 256;
+
+    /// runs tick stages from m_TickStage until done or out of budget
+    void
+    ContinueTick();
+
+    bool
+    TickHousekeeping(llarp_time_t now);
+
+    /// may stop part way through the nodedb
+    bool
+    TickNodeDBPolicy(llarp_time_t now);
+
+    bool
+    TickPeers(llarp_time_t now);
+
+    bool
+    TickServices(llarp_time_t now);
+
+    bool
+    TickSaves(llarp_time_t now);
+
+    bool
+    TickPaths(llarp_time_t now);
     llarp_time_t m_NextDecommissionWarn = time_now_ms() + DECOMM_WARNING_STARTUP_DELAY;
     std::shared_ptr<llarp::KeyManager> m_keyManager;
     std::shared_ptr<PeerDb> m_peerDb;
@@ -596,6 +696,11 @@ namespace llarp
     virtual void
     HandleRouterEvent(tooling::RouterEventPtr event) const override;
 
+    /// starts the oxenmq workers and tagged threads our queued work runs on; the simulator runs
+    /// its routers' work on its own loop instead, and so never starts them
+    virtual void
+    StartOxenMQ();
+
     virtual bool
     disableGossipingRC_TestingOnly()
     {
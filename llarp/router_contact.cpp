@@ -89,6 +89,37 @@ namespace llarp
 
   bool
   RouterContact::BEncode(llarp_buffer_t* buf) const
+  {
+    if (auto wire = CachedEncoding())
+      return buf->write(wire->begin(), wire->end());
+    return BEncodeFresh(buf);
+  }
+
+  std::optional<std::string_view>
+  RouterContact::CachedEncoding() const
+  {
+    if (m_Wire and m_Wire->signature == signature and m_Wire->version == version)
+      return m_Wire->bytes;
+    return std::nullopt;
+  }
+
+  void
+  RouterContact::CacheEncoding(std::string bytes)
+  {
+    m_Wire.reset();
+    if (bytes.empty())
+    {
+      std::array<byte_t, MAX_RC_SIZE> tmp;
+      llarp_buffer_t buf{tmp};
+      if (not BEncodeFresh(&buf))
+        return;
+      bytes.assign(reinterpret_cast<const char*>(tmp.data()), buf.cur - buf.base);
+    }
+    m_Wire = std::make_shared<const WireCache>(WireCache{signature, version, std::move(bytes)});
+  }
+
+  bool
+  RouterContact::BEncodeFresh(llarp_buffer_t* buf) const
   {
     if (version == 0)
       return BEncodeSignedSection(buf);
@@ -231,6 +262,7 @@ namespace llarp
     last_updated = 0s;
     srvRecords.clear();
     version = llarp::constants::proto_version;
+    m_Wire.reset();
   }
 
   util::StatusObject
@@ -266,7 +298,12 @@ namespace llarp
 
     if (*buf->cur == 'd')  // old format
     {
-      return DecodeVersion_0(buf);
+      if (not DecodeVersion_0(buf))
+        return false;
+      // what we were sent need not be what we would write (unknown keys, which we drop), and
+      // version 0 rcs are signed over what we would write, so keep that
+      CacheEncoding();
+      return true;
     }
     else if (*buf->cur != 'l')  // if not dict, should be new format and start with list
     {
@@ -285,8 +322,12 @@ namespace llarp
         bool decode_result = DecodeVersion_1(btlist);
 
         // advance the llarp_buffer_t since lokimq serialization is unaware of it.
-        buf->cur += btlist.current_buffer().data() - buf_view.data() + 1;
+        const size_t consumed = btlist.current_buffer().data() - buf_view.data() + 1;
+        buf->cur += consumed;
 
+        // the signature and signed dict verbatim, which is just what we would write
+        if (decode_result)
+          CacheEncoding(std::string{buf_view.substr(0, consumed)});
         return decode_result;
       }
       else
@@ -467,14 +508,33 @@ namespace llarp
 
     if (version == 0 or version == 1)
     {
-      return CryptoManager::instance()->sign(signature, secretkey, buf);
+      if (not CryptoManager::instance()->sign(signature, secretkey, buf))
+        return false;
+      CacheEncoding();
+      return true;
     }
 
     return false;
   }
 
   bool
-  RouterContact::Verify(llarp_time_t now, bool allowExpired) const
+  RouterContact::SignsSameAs(const RouterContact& other) const
+  {
+    const auto encode = [](RouterContact rc) -> std::optional<std::string> {
+      std::array<byte_t, MAX_RC_SIZE> tmp;
+      llarp_buffer_t buf(tmp);
+      rc.signature.Zero();
+      rc.last_updated = 0s;
+      if (not rc.BEncodeSignedSection(&buf))
+        return std::nullopt;
+      return std::string{reinterpret_cast<const char*>(buf.base), buf.cur - buf.base};
+    };
+    const auto ours = encode(*this);
+    return ours and ours == encode(other);
+  }
+
+  bool
+  RouterContact::VerifyFields(llarp_time_t now, bool allowExpired) const
   {
     if (netID != NetID::DefaultValue())
     {
@@ -496,6 +556,14 @@ namespace llarp
         return false;
       }
     }
+    return true;
+  }
+
+  bool
+  RouterContact::Verify(llarp_time_t now, bool allowExpired) const
+  {
+    if (not VerifyFields(now, allowExpired))
+      return false;
     if (!VerifySignature())
     {
       log::error(logcat, "invalid signature: {}", *this);
@@ -504,33 +572,93 @@ namespace llarp
     return true;
   }
 
-  bool
-  RouterContact::VerifySignature() const
+  std::optional<llarp_buffer_t>
+  RouterContact::SignedSection(std::vector<byte_t>& tmp) const
   {
     if (version == 0)
     {
       RouterContact copy;
       copy = *this;
       copy.signature.Zero();
-      std::array<byte_t, MAX_RC_SIZE> tmp;
+      tmp.resize(MAX_RC_SIZE);
       llarp_buffer_t buf(tmp);
-      if (!copy.BEncode(&buf))
+      // what our fields say now, rather than what we kept from when we were signed
+      if (!copy.BEncodeFresh(&buf))
       {
         log::error(logcat, "bencode failed");
-        return false;
+        return std::nullopt;
       }
       buf.sz = buf.cur - buf.base;
       buf.cur = buf.base;
-      return CryptoManager::instance()->verify(pubkey, buf, signature);
+      return buf;
     }
     /* else */
     if (version == 1)
+      return llarp_buffer_t{signed_bt_dict};
+
+    return std::nullopt;
+  }
+
+  bool
+  RouterContact::VerifySignature() const
+  {
+    std::vector<byte_t> tmp;
+    const auto buf = SignedSection(tmp);
+    if (not buf)
+      return false;
+    return CryptoManager::instance()->verify(pubkey, *buf, signature);
+  }
+
+  std::vector<bool>
+  RouterContact::VerifySignatures(const std::vector<RouterContact>& rcs)
+  {
+    return VerifySignatures(rcs, std::vector<bool>(rcs.size(), true));
+  }
+
+  std::vector<bool>
+  RouterContact::VerifySignatures(const std::vector<RouterContact>& rcs, std::vector<bool> valid)
+  {
+    std::vector<SignatureCheck> checks;
+    checks.reserve(rcs.size());
+    // which rc each check is for
+    std::vector<size_t> index;
+    index.reserve(rcs.size());
+    // holds the version 0 encodings the checks point into
+    std::vector<std::vector<byte_t>> tmps(rcs.size());
+
+    for (size_t idx = 0; idx < rcs.size(); ++idx)
     {
-      llarp_buffer_t buf{signed_bt_dict};
-      return CryptoManager::instance()->verify(pubkey, buf, signature);
+      if (not valid[idx])
+        continue;
+      const auto& rc = rcs[idx];
+      if (auto buf = rc.SignedSection(tmps[idx]))
+      {
+        checks.push_back({rc.pubkey, *buf, rc.signature});
+        index.push_back(idx);
+      }
+      else
+        valid[idx] = false;
     }
+    CryptoManager::instance()->verify_batch(checks);
+    for (size_t idx = 0; idx < checks.size(); ++idx)
+      valid[index[idx]] = checks[idx].valid;
+    return valid;
+  }
 
-    return false;
+  std::vector<bool>
+  RouterContact::VerifyAll(
+      const std::vector<RouterContact>& rcs, llarp_time_t now, bool allowExpired)
+  {
+    std::vector<bool> fields(rcs.size());
+    for (size_t idx = 0; idx < rcs.size(); ++idx)
+      fields[idx] = rcs[idx].VerifyFields(now, allowExpired);
+    auto valid = VerifySignatures(rcs, fields);
+    for (size_t idx = 0; idx < rcs.size(); ++idx)
+    {
+      if (fields[idx] and not valid[idx])
+        log::error(logcat, "invalid signature: {}", rcs[idx]);
+    }
+    return valid;
   }
 
   static constexpr std::array obsolete_bootstraps = {
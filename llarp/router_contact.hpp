@@ -12,7 +12,10 @@
 #include "llarp/dns/srv_data.hpp"
 
 #include <functional>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 #define MAX_RC_SIZE (1024)
@@ -108,9 +111,14 @@ namespace llarp
     std::string
     ToString() const;
 
+    /// writes our wire encoding, straight from the copy we keep of it when we have one
     bool
     BEncode(llarp_buffer_t* buf) const;
 
+    /// the wire encoding we keep from when we were last signed or decoded, if it is still ours
+    std::optional<std::string_view>
+    CachedEncoding() const;
+
     bool
     BEncodeSignedSection(llarp_buffer_t* buf) const;
 
@@ -201,6 +209,20 @@ namespace llarp
     bool
     VerifySignature() const;
 
+    /// whether other signs for all the same as we do, other than when it was signed
+    bool
+    SignsSameAs(const RouterContact& other) const;
+
+    /// VerifySignature for many rcs at once, with the signatures checked as one batch.  returns
+    /// whether each one is valid, in the order given.
+    static std::vector<bool>
+    VerifySignatures(const std::vector<RouterContact>& rcs);
+
+    /// Verify for many rcs at once, with the signatures checked as one batch.  returns whether
+    /// each one is valid, in the order given.
+    static std::vector<bool>
+    VerifyAll(const std::vector<RouterContact>& rcs, llarp_time_t now, bool allowExpired = true);
+
     /// return true if the netid in this rc is for the network id we are using
     bool
     FromOurNetwork() const;
@@ -209,6 +231,40 @@ namespace llarp
     IsObsoleteBootstrap() const;
 
    private:
+    /// our wire encoding as it was signed or decoded, shared between copies rather than copied,
+    /// and the signature and version it is for.  signing again replaces it and changing either
+    /// of those stops it being used; changing other fields without signing again does not, as
+    /// what was signed has not changed.
+    struct WireCache
+    {
+      Signature signature;
+      uint64_t version;
+      std::string bytes;
+    };
+    std::shared_ptr<const WireCache> m_Wire;
+
+    /// encodes us afresh, without the cache
+    bool
+    BEncodeFresh(llarp_buffer_t* buf) const;
+
+    /// keeps bytes as our encoding, or encodes us afresh to keep if they are empty
+    void
+    CacheEncoding(std::string bytes = {});
+
+    /// everything Verify checks except the signature
+    bool
+    VerifyFields(llarp_time_t now, bool allowExpired) const;
+
+    /// the signed part of this rc, for checking its signature against, or nullopt if we can't
+    /// tell.  version 0 rcs sign their own encoding with the signature zeroed, which gets written
+    /// to tmp.
+    std::optional<llarp_buffer_t>
+    SignedSection(std::vector<byte_t>& tmp) const;
+
+    /// VerifySignatures, checking only the rcs valid is already true for
+    static std::vector<bool>
+    VerifySignatures(const std::vector<RouterContact>& rcs, std::vector<bool> valid);
+
     bool
     DecodeVersion_0(llarp_buffer_t* buf);
 
@@ -0,0 +1,78 @@
+#include "bundle_message.hpp"
+
+#include "handler.hpp"
+#include <llarp/util/bencode_span.hpp>
+
+#include <algorithm>
+#include <string_view>
+
+namespace llarp
+{
+  namespace routing
+  {
+    namespace
+    {
+      /// how every bundle starts, and so how one in a bundle would
+      constexpr std::string_view BundleHead = "d1:A1:B";
+
+      bool
+      IsBundle(byte_view_t msg)
+      {
+        return msg.size() >= BundleHead.size()
+            and std::equal(BundleHead.begin(), BundleHead.end(), msg.begin());
+      }
+    }  // namespace
+
+    bool
+    BundleMessage::BEncode(llarp_buffer_t* buf) const
+    {
+      bencode::Writer w{*buf};
+      w.Dict().Key('A').Bytes("B", 1).Key('M').List();
+      for (const auto& msg : messages)
+        w.Bytes(msg.data(), msg.size());
+      w.End().Key('S').Int(S).Key('V').Int(llarp::constants::proto_version).End();
+      return w.Commit(buf);
+    }
+
+    bool
+    BundleMessage::Decode(bencode::Reader& r)
+    {
+      char key;
+      while (r.NextKey(key))
+      {
+        bool ok = true;
+        switch (key)
+        {
+          case 'M':
+            ok = r.List();
+            while (ok and r.More())
+            {
+              byte_view_t msg;
+              ok = r.Bytes(msg) and not IsBundle(msg);
+              if (ok)
+                messages.push_back(msg);
+            }
+            break;
+          case 'S':
+            ok = r.Int(S);
+            break;
+          case 'V':
+            ok = r.Int(version);
+            break;
+          default:
+            ok = false;
+        }
+        if (not ok)
+          return false;
+      }
+      return not r.Failed();
+    }
+
+    bool
+    BundleMessage::HandleMessage(IMessageHandler* h, AbstractRouter* r) const
+    {
+      return h->HandleBundleMessage(*this, r);
+    }
+
+  }  // namespace routing
+}  // namespace llarp
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "message.hpp"
+#include <llarp/constants/link_layer.hpp>
+
+#include <vector>
+
+namespace llarp
+{
+  namespace routing
+  {
+    /// several routing messages for one path sent as one, so that they share an onion layer at
+    /// each hop and a link message between hops.  the last hop of a path bundles the frames it
+    /// passes on into it from other paths (see TransitHop::HandlePathTransferMessage), once the
+    /// path's owner has said it can take bundles by sending an empty one up the path.
+    struct BundleMessage final : public IMessage
+    {
+      /// the most a whole bundle encodes to; as much as a routing message can be
+      static constexpr size_t MaxSize = MAX_LINK_MSG_SIZE - 128;
+      /// what a bundle adds past the messages in it, at most
+      static constexpr size_t Overhead = 32;
+      /// and what each message adds, at most
+      static constexpr size_t EntryOverhead = 6;
+
+      /// the messages, still encoded.  once decoded they point into the buffer the bundle was
+      /// parsed from and are only valid during HandleMessage; when sending they point at the
+      /// caller's, which only have to outlive encoding it
+      std::vector<byte_view_t> messages;
+
+      bool
+      BEncode(llarp_buffer_t* buf) const override;
+
+      /// bundles only come through InboundMessageParser's one pass decode, as handling them
+      /// parses the messages in them with the same parser
+      bool
+      DecodeKey(const llarp_buffer_t&, llarp_buffer_t*) override
+      {
+        return false;
+      }
+
+      /// decodes the keys after the message type in one pass; a bundle in a bundle is refused
+      bool
+      Decode(bencode::Reader& reader);
+
+      bool
+      HandleMessage(IMessageHandler* h, AbstractRouter* r) const override;
+
+      void
+      Clear() override
+      {
+        messages.clear();
+        version = 0;
+      }
+    };
+  }  // namespace routing
+}  // namespace llarp
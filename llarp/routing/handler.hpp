@@ -29,6 +29,7 @@ namespace llarp
     struct PathTransferMessage;
     struct PathConfirmMessage;
     struct PathLatencyMessage;
+    struct BundleMessage;
 
     // handles messages on the routing level
     struct IMessageHandler
@@ -70,6 +71,9 @@ namespace llarp
       HandlePathLatencyMessage(const PathLatencyMessage& msg, AbstractRouter* r) = 0;
       virtual bool
       HandleDHTMessage(const dht::IMessage& msg, AbstractRouter* r) = 0;
+
+      virtual bool
+      HandleBundleMessage(const BundleMessage& msg, AbstractRouter* r) = 0;
     };
 
     using MessageHandler_ptr = std::shared_ptr<IMessageHandler>;
@@ -8,6 +8,10 @@
 namespace llarp
 {
   struct AbstractRouter;
+  namespace bencode
+  {
+    class Reader;
+  }
   namespace routing
   {
     struct IMessageHandler;
@@ -17,6 +21,9 @@ namespace llarp
       PathID_t from;
       uint64_t S{0};
       uint64_t version = llarp::constants::proto_version;
+      /// the priority of the link messages this goes out to the first hop in (see
+      /// ILinkMessage::Priority); never sent
+      uint16_t priority = 0;
 
       IMessage() = default;
 
@@ -41,5 +48,39 @@ namespace llarp
       }
     };
 
+    /// a routing message sent on exactly as someone else encoded it, for passing along messages
+    /// without decoding them; only borrows the encoding, which must outlive sending it
+    struct EncodedMessage final : public IMessage
+    {
+      byte_view_t encoded;
+
+      explicit EncodedMessage(byte_view_t enc) : encoded{enc}
+      {}
+
+      bool
+      BEncode(llarp_buffer_t* buf) const override
+      {
+        return buf->write(encoded.begin(), encoded.end());
+      }
+
+      bool
+      DecodeKey(const llarp_buffer_t&, llarp_buffer_t*) override
+      {
+        return false;
+      }
+
+      bool
+      HandleMessage(IMessageHandler*, AbstractRouter*) const override
+      {
+        return false;
+      }
+
+      void
+      Clear() override
+      {
+        encoded = {};
+      }
+    };
+
   }  // namespace routing
 }  // namespace llarp
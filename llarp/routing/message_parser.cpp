@@ -3,11 +3,14 @@
 #include <llarp/exit/exit_messages.hpp>
 #include <llarp/messages/discard.hpp>
 #include <llarp/path/path_types.hpp>
+#include "bundle_message.hpp"
 #include "dht_message.hpp"
 #include "path_confirm_message.hpp"
 #include "path_latency_message.hpp"
 #include "path_transfer_message.hpp"
 #include "transfer_traffic_message.hpp"
+#include <llarp/util/arena.hpp>
+#include <llarp/util/bencode_span.hpp>
 #include <llarp/util/mem.hpp>
 
 namespace llarp
@@ -28,6 +31,7 @@ namespace llarp
       ObtainExitMessage O;
       UpdateExitMessage U;
       CloseExitMessage C;
+      BundleMessage B;
     };
 
     InboundMessageParser::InboundMessageParser() : m_Holder(std::make_unique<MessageHolder>())
@@ -106,10 +110,63 @@ namespace llarp
       return msg->DecodeKey(*key, buffer);
     }
 
+    template <typename Msg_t>
+    bool
+    InboundMessageParser::DecodeAndHandle(
+        Msg_t& m,
+        bencode::Reader& reader,
+        IMessageHandler* h,
+        const PathID_t& from,
+        AbstractRouter* r)
+    {
+      // as if no version were given, until we get to it
+      m.version = 0;
+      bool result = m.Decode(reader);
+      if (result)
+      {
+        m.from = from;
+        result = m.HandleMessage(h, r);
+        if (not result)
+          llarp::LogWarn("Failed to handle inbound routing message ", ourKey);
+      }
+      else
+        llarp::LogError("read dict failed in routing layer");
+      m.Clear();
+      return result;
+    }
+
     bool
     InboundMessageParser::ParseMessageBuffer(
         const llarp_buffer_t& buf, IMessageHandler* h, const PathID_t& from, AbstractRouter* r)
     {
+      // what a DHT message decodes into comes out of the arena and goes with this, after msg is
+      // cleared below
+      util::Arena::Scope scope;
+
+      // traffic, which is nearly all of it, is read in one pass straight off buf; the rest goes
+      // key by key through DecodeKey
+      bencode::Reader reader{buf.view_all()};
+      char key;
+      byte_view_t type;
+      if (reader.Dict() and reader.NextKey(key) and key == 'A' and reader.Bytes(type)
+          and type.size() == 1)
+      {
+        ourKey = type[0];
+        switch (ourKey)
+        {
+          case 'T':
+            return DecodeAndHandle(m_Holder->T, reader, h, from, r);
+          case 'I':
+            return DecodeAndHandle(m_Holder->I, reader, h, from, r);
+          case 'H':
+            return DecodeAndHandle(m_Holder->H, reader, h, from, r);
+          case 'B':
+            return DecodeAndHandle(m_Holder->B, reader, h, from, r);
+          default:
+            break;
+        }
+      }
+
       bool result = false;
       msg = nullptr;
       firstKey = true;
@@ -10,6 +10,11 @@ namespace llarp
   struct AbstractRouter;
   struct PathID_t;
 
+  namespace bencode
+  {
+    class Reader;
+  }
+
   namespace routing
   {
     struct IMessage;
@@ -31,6 +36,16 @@ namespace llarp
       operator()(llarp_buffer_t* buffer, llarp_buffer_t* key);
 
      private:
+      /// decodes the rest of m, whose type was just read, in one pass and handles it
+      template <typename Msg_t>
+      bool
+      DecodeAndHandle(
+          Msg_t& m,
+          bencode::Reader& reader,
+          IMessageHandler* handler,
+          const PathID_t& from,
+          AbstractRouter* r);
+
       uint64_t version = 0;
       bool firstKey{false};
       char ourKey{'\0'};
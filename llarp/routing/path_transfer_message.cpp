@@ -1,6 +1,7 @@
 #include "path_transfer_message.hpp"
 
 #include "handler.hpp"
+#include <llarp/util/bencode_span.hpp>
 #include <llarp/util/buffer.hpp>
 
 namespace llarp
@@ -15,8 +16,28 @@ namespace llarp
         return false;
       if (!BEncodeMaybeReadDictInt("S", S, read, key, val))
         return false;
-      if (!BEncodeMaybeReadDictEntry("T", T, read, key, val))
-        return false;
+      if (key.startswith("T"))
+      {
+        // all we need of the frame is who it is for; the rest is for the far end to decode
+        const byte_t* start = val->cur;
+        bool hasRecipient = false;
+        const bool decoded = bencode_read_dict(
+            [this, &hasRecipient](llarp_buffer_t* buf, llarp_buffer_t* k) {
+              if (k == nullptr)
+                return true;
+              if (k->startswith("F"))
+              {
+                hasRecipient = true;
+                return T.F.BDecode(buf);
+              }
+              return bencode_discard(buf);
+            },
+            val);
+        if (not decoded or not hasRecipient)
+          return false;
+        encodedT = byte_view_t{start, static_cast<size_t>(val->cur - start)};
+        read = true;
+      }
       if (!BEncodeMaybeReadDictInt("V", version, read, key, val))
         return false;
       if (!BEncodeMaybeReadDictEntry("Y", Y, read, key, val))
@@ -25,27 +46,71 @@ namespace llarp
     }
 
     bool
-    PathTransferMessage::BEncode(llarp_buffer_t* buf) const
+    PathTransferMessage::Decode(bencode::Reader& r)
     {
-      if (!bencode_start_dict(buf))
-        return false;
-      if (!BEncodeWriteDictMsgType(buf, "A", "T"))
-        return false;
-      if (!BEncodeWriteDictEntry("P", P, buf))
-        return false;
-
-      if (!BEncodeWriteDictInt("S", S, buf))
-        return false;
-
-      if (!BEncodeWriteDictEntry("T", T, buf))
-        return false;
-
-      if (!BEncodeWriteDictInt("V", llarp::constants::proto_version, buf))
-        return false;
-      if (!BEncodeWriteDictEntry("Y", Y, buf))
-        return false;
+      bool any = false;
+      char key;
+      while (r.NextKey(key))
+      {
+        bool ok;
+        switch (key)
+        {
+          case 'P':
+            ok = r.Fixed(P);
+            break;
+          case 'S':
+            ok = r.Int(S);
+            break;
+          case 'T': {
+            // as with DecodeKey, just who the frame is for
+            const byte_t* start = r.Pos();
+            bool hasRecipient = false;
+            ok = r.Dict();
+            char tkey;
+            while (ok and r.NextKey(tkey))
+            {
+              if (tkey == 'F')
+                ok = hasRecipient = r.Fixed(T.F);
+              else
+                ok = r.Skip();
+            }
+            ok = ok and hasRecipient and not r.Failed();
+            if (ok)
+              encodedT = byte_view_t{start, static_cast<size_t>(r.Pos() - start)};
+            break;
+          }
+          case 'V':
+            ok = r.Int(version);
+            break;
+          case 'Y':
+            ok = r.Fixed(Y);
+            break;
+          default:
+            ok = false;
+        }
+        if (not ok)
+          return false;
+        any = true;
+      }
+      return any and not r.Failed();
+    }
 
-      return bencode_end(buf);
+    bool
+    PathTransferMessage::BEncode(llarp_buffer_t* buf) const
+    {
+      bencode::Writer w{*buf};
+      w.Dict().Key('A').Bytes("T", 1).Key('P').Bytes(P).Key('S').Int(S).Key('T');
+      if (encodedT.empty())
+      {
+        // the frame has its own encoder, which goes through buf
+        if (not w.Commit(buf) or not T.BEncode(buf))
+          return false;
+        w = bencode::Writer{*buf};
+      }
+      else
+        w.Raw(encodedT.data(), encodedT.size());
+      w.Key('V').Int(llarp::constants::proto_version).Key('Y').Bytes(Y).End();
+      return w.Commit(buf);
     }
 
     bool
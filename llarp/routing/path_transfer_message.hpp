@@ -12,8 +12,12 @@ namespace llarp
     struct PathTransferMessage final : public IMessage
     {
       PathID_t P;
+      /// the frame to send; of a frame we received, decoding only fills in F
       service::ProtocolFrame T;
       TunnelNonce Y;
+      /// the frame as received, still encoded and pointing into the buffer the message was parsed
+      /// from, for passing on without decoding it; only valid during HandleMessage
+      byte_view_t encodedT;
 
       PathTransferMessage() = default;
       PathTransferMessage(const service::ProtocolFrame& f, const PathID_t& p) : P(p), T(f)
@@ -25,6 +29,10 @@ namespace llarp
       bool
       DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* val) override;
 
+      /// decodes the keys after the message type in one pass; what InboundMessageParser uses
+      bool
+      Decode(bencode::Reader& reader);
+
       bool
       BEncode(llarp_buffer_t* buf) const override;
 
@@ -36,6 +44,7 @@ namespace llarp
       {
         P.Zero();
         T.Clear();
+        encodedT = {};
         Y.Zero();
         version = 0;
       }
@@ -2,6 +2,7 @@
 
 #include "handler.hpp"
 #include <llarp/util/bencode.hpp>
+#include <llarp/util/bencode_span.hpp>
 
 #include <oxenc/endian.h>
 
@@ -14,11 +15,12 @@ namespace llarp
     {
       if (buf.sz > MaxExitMTU)
         return false;
-      X.emplace_back(buf.sz + 8);
-      byte_t* ptr = X.back().data();
+      const auto at = X.size();
+      X.resize(at + ExitOverhead + buf.sz);
+      byte_t* ptr = X.data() + at;
       oxenc::write_host_as_big(counter, ptr);
-      ptr += 8;
-      memcpy(ptr, buf.base, buf.sz);
+      memcpy(ptr + ExitOverhead, buf.base, buf.sz);
+      sizes.push_back(ExitOverhead + buf.sz);
       // 8 bytes encoding overhead and 8 bytes counter
       _size += buf.sz + 16;
       return true;
@@ -27,19 +29,66 @@ namespace llarp
     bool
     TransferTrafficMessage::BEncode(llarp_buffer_t* buf) const
     {
-      if (!bencode_start_dict(buf))
-        return false;
-      if (!BEncodeWriteDictMsgType(buf, "A", "I"))
-        return false;
-      if (!BEncodeWriteDictInt("P", protocol, buf))
-        return false;
-      if (!BEncodeWriteDictInt("S", S, buf))
-        return false;
-      if (!BEncodeWriteDictInt("V", version, buf))
-        return false;
-      if (!BEncodeWriteDictList("X", X, buf))
-        return false;
-      return bencode_end(buf);
+      bencode::Writer w{*buf};
+      w.Dict()
+          .Key('A')
+          .Bytes("I", 1)
+          .Key('P')
+          .Int(static_cast<uint64_t>(protocol))
+          .Key('S')
+          .Int(S)
+          .Key('V')
+          .Int(version)
+          .Key('X')
+          .List();
+      const byte_t* pkt = X.data();
+      for (const auto sz : sizes)
+      {
+        w.Bytes(pkt, sz);
+        pkt += sz;
+      }
+      w.End().End();
+      return w.Commit(buf);
+    }
+
+    bool
+    TransferTrafficMessage::Decode(bencode::Reader& r)
+    {
+      // the parser reuses this message, so once warmed up this allocates nothing
+      receivedX.clear();
+      char key;
+      while (r.NextKey(key))
+      {
+        bool ok;
+        switch (key)
+        {
+          case 'P':
+            ok = r.IntAs(protocol);
+            break;
+          case 'S':
+            ok = r.Int(S);
+            break;
+          case 'V':
+            ok = r.Int(version);
+            break;
+          case 'X':
+            ok = r.List();
+            while (ok and r.More())
+            {
+              byte_view_t pkt;
+              ok = r.Bytes(pkt, MaxExitMTU + ExitOverhead);
+              if (ok)
+                receivedX.push_back(pkt);
+            }
+            ok = ok and not r.Failed();
+            break;
+          default:
+            ok = r.Skip();
+        }
+        if (not ok)
+          return false;
+      }
+      return not r.Failed();
     }
 
     bool
@@ -52,8 +101,22 @@ namespace llarp
         return false;
       if (!BEncodeMaybeReadDictInt("V", version, read, key, buf))
         return false;
-      if (!BEncodeMaybeReadDictList("X", X, read, key, buf))
-        return false;
+      if (key.startswith("X"))
+      {
+        // the parser reuses this message, so once warmed up this allocates nothing
+        receivedX.clear();
+        return bencode_read_list(
+            [this](llarp_buffer_t* buffer, bool has) {
+              if (not has)
+                return true;
+              llarp_buffer_t strbuf;
+              if (not bencode_read_string(buffer, &strbuf) or strbuf.sz > MaxExitMTU + ExitOverhead)
+                return false;
+              receivedX.emplace_back(strbuf.base, strbuf.sz);
+              return true;
+            },
+            buf);
+      }
       return read or bencode_discard(buf);
     }
 
@@ -13,9 +13,22 @@ namespace llarp
     constexpr size_t ExitPadSize = 512 - 48;
     constexpr size_t MaxExitMTU = 1500;
     constexpr size_t ExitOverhead = sizeof(uint64_t);
+    /// the most packet bytes an exit puts in one message to a client, a few full sized packets
+    /// and still well inside a link message
+    constexpr size_t ExitPackSize = 4 * MaxExitMTU;
+    /// the most packet bytes a client puts in one message to its exit: what a path's upstream
+    /// routing message has room for, less the keys around the packets
+    constexpr size_t ExitUpstreamPackSize = 2 * MaxExitMTU;
     struct TransferTrafficMessage final : public IMessage
     {
-      std::vector<llarp::Encrypted<MaxExitMTU + ExitOverhead>> X;
+      /// packets to send back to back, each prefixed with its counter; Clear keeps the memory, so
+      /// a message reused for the next lot of packets packs them without allocating
+      std::vector<byte_t> X;
+      /// how many bytes of X each packet takes up, counter included
+      std::vector<uint16_t> sizes;
+      /// packets received, likewise prefixed: decoding leaves them where they are in the buffer
+      /// the message was parsed from, so these are only valid during HandleMessage
+      std::vector<byte_view_t> receivedX;
       service::ProtocolType protocol;
       size_t _size = 0;
 
@@ -23,6 +36,8 @@ namespace llarp
       Clear() override
       {
         X.clear();
+        sizes.clear();
+        receivedX.clear();
         _size = 0;
         version = 0;
         protocol = service::ProtocolType::TrafficV4;
@@ -34,6 +49,20 @@ namespace llarp
         return _size;
       }
 
+      /// how many packets have been put in
+      size_t
+      Packets() const
+      {
+        return sizes.size();
+      }
+
+      /// the memory kept for packets, used or not
+      size_t
+      Capacity() const
+      {
+        return X.capacity();
+      }
+
       /// append buffer to X
       bool
       PutBuffer(const llarp_buffer_t& buf, uint64_t counter);
@@ -44,6 +73,10 @@ namespace llarp
       bool
       DecodeKey(const llarp_buffer_t& k, llarp_buffer_t* val) override;
 
+      /// decodes the keys after the message type in one pass; what InboundMessageParser uses
+      bool
+      Decode(bencode::Reader& reader);
+
       bool
       HandleMessage(IMessageHandler* h, AbstractRouter* r) const override;
     };
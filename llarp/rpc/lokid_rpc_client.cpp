@@ -217,8 +217,8 @@ namespace llarp
     void
     LokidRpcClient::HandleNewServiceNodeList(const nlohmann::json& j)
     {
-      std::unordered_map<RouterID, PubKey> keymap;
-      std::vector<RouterID> activeNodeList, decommNodeList, unfundedNodeList;
+      std::unordered_map<RouterID, ServiceNodeState> nodes;
+      size_t numActive = 0;
       if (not j.is_array())
         throw std::runtime_error{
             "Invalid service node list: expected array of service node states"};
@@ -246,35 +246,85 @@ namespace llarp
             or not pk.FromHex(svc_itr->get<std::string_view>()))
           continue;
 
-        keymap[rid] = pk;
-        (active       ? activeNodeList
-             : funded ? decommNodeList
-                      : unfundedNodeList)
-            .push_back(std::move(rid));
+        if (active)
+          numActive++;
+        nodes[rid] = ServiceNodeState{
+            pk,
+            active       ? NodeList::Active
+                : funded ? NodeList::Decommissioned
+                         : NodeList::Unfunded};
       }
 
-      if (activeNodeList.empty())
+      if (numActive == 0)
       {
         LogWarn("got empty service node list, ignoring.");
         return;
       }
 
-      // inform router about the new list
-      if (auto router = m_Router.lock())
+      auto router = m_Router.lock();
+      if (not router)
+      {
+        LogWarn("Cannot update whitelist: router object has gone away");
+        return;
+      }
+
+      // the first list replaces whatever the router has; after that we hand it only the nodes
+      // that were added, removed or moved between lists, which with each new block is a handful
+      // rather than the whole network
+      const bool full = m_ServiceNodes.empty();
+      std::vector<RouterID> activeNodeList, decommNodeList, unfundedNodeList, removedNodeList;
+      std::unordered_map<RouterID, PubKey> keymap;
+      for (const auto& [rid, state] : nodes)
+      {
+        const auto itr = m_ServiceNodes.find(rid);
+        if (itr != m_ServiceNodes.end() and itr->second == state)
+          continue;
+        if (full or itr == m_ServiceNodes.end() or itr->second.pubkey != state.pubkey)
+          keymap[rid] = state.pubkey;
+        if (full or itr == m_ServiceNodes.end() or itr->second.list != state.list)
+        {
+          (state.list == NodeList::Active               ? activeNodeList
+               : state.list == NodeList::Decommissioned ? decommNodeList
+                                                        : unfundedNodeList)
+              .push_back(rid);
+        }
+      }
+      for (const auto& [rid, state] : m_ServiceNodes)
       {
-        auto& loop = router->loop();
-        loop->call([this,
-                    active = std::move(activeNodeList),
-                    decomm = std::move(decommNodeList),
-                    unfunded = std::move(unfundedNodeList),
-                    keymap = std::move(keymap),
-                    router = std::move(router)]() mutable {
+        if (nodes.count(rid) == 0)
+          removedNodeList.push_back(rid);
+      }
+      m_ServiceNodes = std::move(nodes);
+
+      if (not full and keymap.empty() and removedNodeList.empty() and activeNodeList.empty()
+          and decommNodeList.empty() and unfundedNodeList.empty())
+      {
+        LogDebug("service node list has no changes for us");
+        return;
+      }
+
+      // inform router about the new list
+      auto& loop = router->loop();
+      loop->call([this,
+                  full,
+                  active = std::move(activeNodeList),
+                  decomm = std::move(decommNodeList),
+                  unfunded = std::move(unfundedNodeList),
+                  removed = std::move(removedNodeList),
+                  keymap = std::move(keymap),
+                  router = std::move(router)]() mutable {
+        if (full)
+        {
           m_KeyMap = std::move(keymap);
           router->SetRouterWhitelist(active, decomm, unfunded);
-        });
-      }
-      else
-        LogWarn("Cannot update whitelist: router object has gone away");
+          return;
+        }
+        for (const auto& rid : removed)
+          m_KeyMap.erase(rid);
+        for (auto& [rid, pk] : keymap)
+          m_KeyMap[rid] = pk;
+        router->UpdateRouterWhitelist(active, decomm, unfunded, removed);
+      });
     }
 
     void
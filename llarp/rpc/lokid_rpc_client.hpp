@@ -8,6 +8,8 @@
 #include <llarp/dht/key.hpp>
 #include <llarp/service/name.hpp>
 
+#include <unordered_map>
+
 namespace llarp
 {
   struct AbstractRouter;
@@ -93,6 +95,30 @@ namespace llarp
       std::atomic<bool> m_UpdatingList;
       std::string m_LastUpdateHash;
 
+      /// which of the router's lists a service node goes on
+      enum class NodeList
+      {
+        Active,
+        Decommissioned,
+        Unfunded
+      };
+
+      struct ServiceNodeState
+      {
+        PubKey pubkey;
+        NodeList list;
+
+        bool
+        operator==(const ServiceNodeState& other) const
+        {
+          return pubkey == other.pubkey and list == other.list;
+        }
+      };
+
+      /// the last service node list we got, that the next one is compared with so only what
+      /// changed is handed to the router; guarded by m_UpdatingList, like m_LastUpdateHash
+      std::unordered_map<RouterID, ServiceNodeState> m_ServiceNodes;
+
       std::unordered_map<RouterID, PubKey> m_KeyMap;
 
       uint64_t m_BlockHeight;
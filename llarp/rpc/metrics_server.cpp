@@ -0,0 +1,129 @@
+#include "metrics_server.hpp"
+
+#include <llarp/util/logging.hpp>
+#include <llarp/util/metrics.hpp>
+#include <llarp/util/time.hpp>
+
+#include <uvw/loop.h>
+#include <uvw/tcp.h>
+#include <uvw/timer.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace llarp::rpc
+{
+  static auto logcat = log::Cat("metrics");
+
+  namespace
+  {
+    /// the most we read of a request before giving up on it; a scrape is a few hundred bytes
+    constexpr size_t MaxRequestSize = 8192;
+    /// how long a connection has to send its request and take our answer before we close it,
+    /// so that ones left open (or trickling a byte at a time) don't pile up
+    constexpr auto ConnectionTimeout = 5s;
+
+    std::string
+    Response(std::string_view status, std::string_view type, const std::string& body)
+    {
+      return fmt::format(
+          "HTTP/1.1 {}\r\nContent-Type: {}\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+          status,
+          type,
+          body.size(),
+          body);
+    }
+
+    /// the answer to the request line of a request, e.g. "GET /metrics HTTP/1.1"
+    std::string
+    Answer(std::string_view line)
+    {
+      const auto method = line.substr(0, line.find(' '));
+      auto target = line.substr(std::min(line.size(), method.size() + 1));
+      target = target.substr(0, target.find(' '));
+      target = target.substr(0, target.find('?'));
+      if (target != "/metrics")
+        return Response("404 Not Found", "text/plain", "not found; try /metrics\n");
+      if (method != "GET")
+        return Response("405 Method Not Allowed", "text/plain", "GET only\n");
+      return Response("200 OK", "text/plain; version=0.0.4", metrics::Prometheus());
+    }
+
+    void
+    Send(uvw::TCPHandle& client, const std::string& response)
+    {
+      auto data = std::make_unique<char[]>(response.size());
+      std::memcpy(data.get(), response.data(), response.size());
+      client.once<uvw::WriteEvent>([](auto&, uvw::TCPHandle& c) { c.close(); });
+      client.write(std::move(data), response.size());
+    }
+
+    void
+    Accept(uvw::TCPHandle& server)
+    {
+      auto client = server.loop().resource<uvw::TCPHandle>();
+      server.accept(*client);
+      auto timeout = server.loop().resource<uvw::TimerHandle>();
+      timeout->on<uvw::TimerEvent>(
+          [weak = std::weak_ptr<uvw::TCPHandle>{client}](const auto&, uvw::TimerHandle& t) {
+            t.close();
+            if (auto c = weak.lock(); c and not c->closing())
+              c->close();
+          });
+      client->once<uvw::CloseEvent>([timeout](auto&, auto&) {
+        if (not timeout->closing())
+          timeout->close();
+      });
+      timeout->start(ConnectionTimeout, 0ms);
+      auto request = std::make_shared<std::string>();
+      client->on<uvw::DataEvent>([request](const uvw::DataEvent& ev, uvw::TCPHandle& c) {
+        request->append(ev.data.get(), ev.length);
+        const auto end = request->find("\r\n");
+        if (end == std::string::npos)
+        {
+          if (request->size() > MaxRequestSize)
+            c.close();
+          return;
+        }
+        // we answer on the request line; the headers don't change what we say
+        c.stop();
+        Send(c, Answer(std::string_view{*request}.substr(0, end)));
+      });
+      client->on<uvw::EndEvent>([](auto&, uvw::TCPHandle& c) { c.close(); });
+      client->on<uvw::ErrorEvent>([](const uvw::ErrorEvent& e, uvw::TCPHandle& c) {
+        log::debug(logcat, "metrics connection error: {}", e.what());
+        c.close();
+      });
+      client->read();
+    }
+  }  // namespace
+
+  MetricsServer::MetricsServer(const std::shared_ptr<uvw::Loop>& loop, const SockAddr& addr)
+      : m_TCP{loop->resource<uvw::TCPHandle>()}
+  {
+    const char* failed = nullptr;
+    auto err_handler =
+        m_TCP->once<uvw::ErrorEvent>([&failed](auto& evt, auto&) { failed = evt.what(); });
+    m_TCP->bind(*addr.operator const sockaddr*());
+    m_TCP->on<uvw::ListenEvent>(
+        [](const uvw::ListenEvent&, uvw::TCPHandle& server) { Accept(server); });
+    m_TCP->listen();
+    m_TCP->erase(err_handler);
+    if (failed)
+    {
+      m_TCP->close();
+      throw std::runtime_error{
+          fmt::format("failed to listen for metrics scrapes on {}: {}", addr, failed)};
+    }
+    const auto bound = m_TCP->sock();
+    m_Bound = SockAddr{bound.ip, huint16_t{static_cast<uint16_t>(bound.port)}};
+    log::info(logcat, "serving metrics on http://{}/metrics", m_Bound);
+  }
+
+  MetricsServer::~MetricsServer()
+  {
+    m_TCP->close();
+  }
+}  // namespace llarp::rpc
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <llarp/net/sock_addr.hpp>
+
+#include <memory>
+
+namespace uvw
+{
+  class Loop;
+  class TCPHandle;
+}  // namespace uvw
+
+namespace llarp::rpc
+{
+  /// a bare http listener that answers GET /metrics with metrics::Prometheus(), for prometheus
+  /// (or anything else that speaks its text format) to scrape.  it reads one request per
+  /// connection, answers it and hangs up; anything else gets a 404.  it runs in the event loop,
+  /// and what it reports is only read from counters, so scraping costs the data plane nothing.
+  class MetricsServer
+  {
+   public:
+    /// throws if we cannot listen on addr
+    MetricsServer(const std::shared_ptr<uvw::Loop>& loop, const SockAddr& addr);
+
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer&
+    operator=(const MetricsServer&) = delete;
+
+    /// where we ended up listening
+    const SockAddr&
+    BoundOn() const
+    {
+      return m_Bound;
+    }
+
+   private:
+    std::shared_ptr<uvw::TCPHandle> m_TCP;
+    SockAddr m_Bound;
+  };
+}  // namespace llarp::rpc
@@ -81,6 +81,75 @@ namespace llarp::rpc
     static constexpr auto name = "get_status"sv;
   };
 
+  //  RPC: link_stats
+  //    Returns latency and retransmission histograms for every established link session, and
+  //    their total per link.  Reading them resets them.
+  //
+  //  Inputs: none
+  //
+  //  Returns: "inbound" and "outbound" lists of links, each with
+  //    "name"
+  //    "total" : histograms over all sessions, including ones closed since the last call
+  //    "sessions" : list of histograms per session, with "router" and "addr"
+  //    where each set of histograms is
+  //      "ackRTT", "queueDelay", "cryptoLatency" : microseconds
+  //      "retransmits" : per delivered message
+  //    each one given as "count", "mean", "p50", "p90", "p99", "p999" and "max"
+  //
+  struct LinkStats : NoArgs
+  {
+    static constexpr auto name = "link_stats"sv;
+  };
+
+  //  RPC: memory_stats
+  //    Returns the memory each part of lokinet holds, as counted by util::MemAccount
+  //
+  //  Inputs: none
+  //
+  //  Returns: "tags", by part ("nodedb", "path", "link", "service", "dns", "quic"), each with
+  //    "live", "peak" : bytes
+  //    "allocs", "frees" : counts since startup
+  //    "allocsPerSec", "bytesPerSec" : rates over the last second or so
+  //    "softLimit" : bytes, 0 for none
+  //  and "jemalloc" with the process's "allocated", "active", "resident", "mapped" and
+  //  "retained" bytes, when built with jemalloc
+  //
+  struct MemoryStats : NoArgs
+  {
+    static constexpr auto name = "memory_stats"sv;
+  };
+
+  //  RPC: loop_stats
+  //    Returns how healthy the event loop is
+  //
+  //  Inputs: none
+  //
+  //  Returns:
+  //    "iteration" : microseconds busy per loop iteration, leaving out waiting for io
+  //    "callDelay" : microseconds from a call being queued to it being run
+  //    "call", "timer" : microseconds spent in a queued call, or in a repeating timer
+  //    each one given as "count", "mean", "p50", "p90", "p99" and "max"
+  //    "stalls" : iterations that took longer than "stallThreshold" (microseconds)
+  //
+  struct LoopStats : NoArgs
+  {
+    static constexpr auto name = "loop_stats"sv;
+  };
+
+  //  RPC: metrics
+  //    Returns the counters, gauges and histograms kept by metrics::Metric, as served to
+  //    prometheus on [api]:metrics-bind.  Cheap to call, unlike status.
+  //
+  //  Inputs: none
+  //
+  //  Returns: each metric by name ("lokinet_link_rx_packets_total", etc); counters and gauges
+  //    as a number, histograms with "count", "mean", "p50", "p90", "p99" and "max"
+  //
+  struct Metrics : NoArgs
+  {
+    static constexpr auto name = "metrics"sv;
+  };
+
   //  RPC: quic_connect
   //    Initializes QUIC connection tunnel
   //    Passes request parameters in nlohmann::json format
@@ -91,6 +160,9 @@ namespace llarp::rpc
   //    "host" : remote host ID (string)
   //    "port" : port to bind to (int)
   //    "close" : close connection to port or host ID
+  //    "urgency" : send priority of the tunnel's streams, 0 (most urgent) to 7; default 3 (int)
+  //    "incremental" : false to send each stream's data in turn rather than interleaved with
+  //      other streams of the same urgency; default true (bool)
   //
   //  Returns:
   //    "id" : connection ID
@@ -105,8 +177,10 @@ namespace llarp::rpc
       std::string bindAddr;
       int closeID;
       std::string endpoint;
+      std::optional<bool> incremental;
       uint16_t port;
       std::string remoteHost;
+      std::optional<int> urgency;
     } request;
   };
 
@@ -292,12 +366,112 @@ namespace llarp::rpc
     } request;
   };
 
+  //  RPC: reload_config
+  //    Loads the config file, and the overrides written with "config", over again and applies
+  //    what changed in [network] and [dns] to the running router, the same as a SIGHUP, without
+  //    restarting it: links, paths and sessions stay up
+  //
+  //  Inputs: none
+  //
+  //  Returns:
+  //    "restart" : settings that changed but only take effect on a restart
+  //
+  struct ReloadConfig : NoArgs
+  {
+    static constexpr auto name = "reload_config"sv;
+  };
+
+  //  RPC: profile
+  //    Profiles the running router for a while and writes what it found to the data dir, for
+  //    diagnosing a live relay without attaching a profiler to it or restarting it
+  //
+  //  Inputs:
+  //    "kind" : "cpu" samples every thread's stack, and writes them as collapsed stacks (one
+  //      "outer;inner N" a line) for flamegraph.pl, speedscope or pprof; "heap" has jemalloc sample
+  //      allocations, and writes a heap profile for jeprof.  heap profiles need lokinet built with
+  //      jemalloc and started with MALLOC_CONF=prof:true,prof_active:false.
+  //    "seconds" : how long to profile for, 1 to 300 (default 30)
+  //    "rate" : for "cpu", samples a second of cpu time, up to 1000 (default 99); for "heap", the
+  //      mean bytes between sampled allocations as a power of 2 (default 19, i.e. 512kiB)
+  //
+  //  Returns:
+  //    "file" : where the profile is written once the time is up
+  //    "seconds" : when that will be, from now
+  //
+  struct Profile : RPCRequest
+  {
+    static constexpr auto name = "profile"sv;
+
+    struct request_parameters
+    {
+      std::string kind;
+      uint64_t seconds = 30;
+      std::optional<uint64_t> rate;
+    } request;
+  };
+
+  //  RPC: record_links
+  //    Records the link messages the router sends and receives for a while to a file in the data
+  //    dir, for replaying real traffic through lokinet-bench-link-replay.  remotes are written as
+  //    numbers, not keys.
+  //
+  //  Inputs:
+  //    "seconds" : how long to record for, 1 to 3600 (default 60)
+  //    "payloads" : keep the messages themselves, which replaying needs, rather than only their
+  //      sizes and timing (default false)
+  //    "maxMB" : stop recording past this many megabytes (default 1024)
+  //
+  //  Returns:
+  //    "file" : where the recording goes
+  //    "seconds" : when it will be done, from now
+  //
+  struct RecordLinks : RPCRequest
+  {
+    static constexpr auto name = "record_links"sv;
+
+    struct request_parameters
+    {
+      uint64_t maxMB = 1024;
+      bool payloads = false;
+      uint64_t seconds = 60;
+    } request;
+  };
+
+  //  RPC: list_routers
+  //    Returns the rcs in our nodedb a page at a time, in the order of their keys, so that all of
+  //    a big nodedb can be pulled without one huge response.  each page is a snapshot taken when
+  //    it is asked for, so rcs that come and go in between may be missed or seen on a later page.
+  //
+  //  Inputs:
+  //    "after" : the "next" of the page before; leave out for the first page
+  //    "limit" : most rcs to return, 1 to 1000 (default 200)
+  //
+  //  Returns:
+  //    "routers" : list of rcs
+  //    "next" : what to pass as "after" for the next page; left out on the last page
+  //    "total" : how many rcs the nodedb holds
+  //
+  struct ListRouters : RPCRequest
+  {
+    static constexpr auto name = "list_routers"sv;
+
+    struct request_parameters
+    {
+      std::string after;
+      uint64_t limit = 200;
+    } request;
+  };
+
   // List of all RPC request structs to allow compile-time enumeration of all supported types
   using rpc_request_types = tools::type_list<
       Halt,
       Version,
       Status,
       GetStatus,
+      LinkStats,
+      MemoryStats,
+      LoopStats,
+      Metrics,
       QuicConnect,
       QuicListener,
       LookupSnode,
@@ -306,6 +480,10 @@ namespace llarp::rpc
       SwapExits,
       UnmapExit,
       DNSQuery,
-      Config>;
+      Config,
+      ReloadConfig,
+      Profile,
+      RecordLinks,
+      ListRouters>;
 
 }  // namespace llarp::rpc
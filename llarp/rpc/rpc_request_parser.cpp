@@ -22,10 +22,14 @@ namespace llarp::rpc
         quicconnect.request.closeID,
         "endpoint",
         quicconnect.request.endpoint,
+        "incremental",
+        quicconnect.request.incremental,
         "port",
         quicconnect.request.port,
         "remoteHost",
-        quicconnect.request.remoteHost);
+        quicconnect.request.remoteHost,
+        "urgency",
+        quicconnect.request.urgency);
   }
 
   void
@@ -107,4 +111,36 @@ namespace llarp::rpc
         config.request.ini);
   }
 
+  void
+  parse_request(Profile& profile, rpc_input input)
+  {
+    get_values(
+        input,
+        "kind",
+        profile.request.kind,
+        "rate",
+        profile.request.rate,
+        "seconds",
+        profile.request.seconds);
+  }
+
+  void
+  parse_request(RecordLinks& recordlinks, rpc_input input)
+  {
+    get_values(
+        input,
+        "maxMB",
+        recordlinks.request.maxMB,
+        "payloads",
+        recordlinks.request.payloads,
+        "seconds",
+        recordlinks.request.seconds);
+  }
+
+  void
+  parse_request(ListRouters& listrouters, rpc_input input)
+  {
+    get_values(input, "after", listrouters.request.after, "limit", listrouters.request.limit);
+  }
+
 }  // namespace llarp::rpc
\ No newline at end of file
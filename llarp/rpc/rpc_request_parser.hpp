@@ -31,5 +31,11 @@ namespace llarp::rpc
   parse_request(DNSQuery& dnsquery, rpc_input input);
   void
   parse_request(Config& config, rpc_input input);
+  void
+  parse_request(Profile& profile, rpc_input input);
+  void
+  parse_request(RecordLinks& recordlinks, rpc_input input);
+  void
+  parse_request(ListRouters& listrouters, rpc_input input);
 
 }  // namespace llarp::rpc
\ No newline at end of file
@@ -2,7 +2,9 @@
 #include "llarp/rpc/rpc_request_definitions.hpp"
 #include "rpc_request.hpp"
 #include "llarp/service/address.hpp"
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <exception>
 #include <llarp/router/route_poker.hpp>
 #include <llarp/config/config.hpp>
@@ -11,7 +13,11 @@
 #include <llarp/constants/version.hpp>
 #include <nlohmann/json.hpp>
 #include <llarp/exit/context.hpp>
+#include <llarp/link/i_link_manager.hpp>
+#include <llarp/link/recorder.hpp>
+#include <llarp/link/server.hpp>
 #include <llarp/net/ip_range.hpp>
+#include <llarp/nodedb.hpp>
 #include <llarp/quic/tunnel.hpp>
 #include <llarp/service/context.hpp>
 #include <llarp/service/outbound_context.hpp>
@@ -19,6 +25,9 @@
 #include <llarp/service/name.hpp>
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/dns/dns.hpp>
+#include <llarp/util/mem_account.hpp>
+#include <llarp/util/metrics.hpp>
+#include <llarp/util/profiler.hpp>
 #include <vector>
 #include <oxenmq/fmt.h>
 
@@ -110,6 +119,14 @@ namespace llarp::rpc
     }
 
     AddCategories();
+
+    if (const auto interval = r.GetConfig()->api.m_statusPushInterval; interval > 0s)
+    {
+      m_StatusTimer = std::make_shared<int>(0);
+      r.loop()->call([this, interval] {
+        m_Router.loop()->call_every(interval, m_StatusTimer, [this] { PushStatus(); });
+      });
+    }
   }
 
   template <typename... RPC>
@@ -130,7 +147,9 @@ namespace llarp::rpc
   RPCServer::AddCategories()
   {
     m_LMQ->add_category("llarp", oxenmq::AuthLevel::none)
-        .add_request_command("logs", [this](oxenmq::Message& msg) { HandleLogsSubRequest(msg); });
+        .add_request_command("logs", [this](oxenmq::Message& msg) { HandleLogsSubRequest(msg); })
+        .add_request_command(
+            "status_subscribe", [this](oxenmq::Message& msg) { HandleStatusSubRequest(msg); });
 
     for (auto& req : rpc_request_map)
     {
@@ -167,8 +186,20 @@ namespace llarp::rpc
   void
   RPCServer::invoke(Status& status)
   {
-    (m_Router.IsRunning()) ? SetJSONResponse(m_Router.ExtractStatus(), status.response)
-                           : SetJSONError("Router is not yet ready", status.response);
+    if (not m_Router.IsRunning())
+    {
+      SetJSONError("Router is not yet ready", status.response);
+      return;
+    }
+    // the status has to be taken here on the loop, but serialising all of a busy relay's status
+    // takes longer than taking it and needs nothing but the tree, so do that on a worker
+    json response;
+    SetJSONResponse(m_Router.ExtractStatus(), response);
+    m_Router.QueueWork(
+        [bt = status.is_bt(), response = std::move(response), reply = status.move()]() mutable {
+          reply.reply(
+              bt ? oxenc::bt_serialize(json_to_bt(std::move(response))) : response.dump());
+        });
   }
 
   void
@@ -177,6 +208,41 @@ namespace llarp::rpc
     SetJSONResponse(m_Router.ExtractSummaryStatus(), getstatus.response);
   }
 
+  void
+  RPCServer::invoke(LinkStats& linkstats)
+  {
+    if (not m_Router.IsRunning())
+    {
+      SetJSONError("Router is not yet ready", linkstats.response);
+      return;
+    }
+    std::vector<util::StatusObject> inbound, outbound;
+    m_Router.linkManager().ForEachInboundLink(
+        [&inbound](LinkLayer_ptr link) { inbound.push_back(link->ExtractHistograms()); });
+    m_Router.linkManager().ForEachOutboundLink(
+        [&outbound](LinkLayer_ptr link) { outbound.push_back(link->ExtractHistograms()); });
+    SetJSONResponse(
+        util::StatusObject{{"inbound", inbound}, {"outbound", outbound}}, linkstats.response);
+  }
+
+  void
+  RPCServer::invoke(MemoryStats& memorystats)
+  {
+    SetJSONResponse(util::MemAccount::ExtractStatus(), memorystats.response);
+  }
+
+  void
+  RPCServer::invoke(LoopStats& loopstats)
+  {
+    SetJSONResponse(m_Router.loop()->ExtractStatus(), loopstats.response);
+  }
+
+  void
+  RPCServer::invoke(Metrics& metrics)
+  {
+    SetJSONResponse(metrics::ExtractStatus(), metrics.response);
+  }
+
   void
   RPCServer::invoke(QuicConnect& quicconnect)
   {
@@ -221,10 +287,27 @@ namespace llarp::rpc
 
     SockAddr laddr{quicconnect.request.bindAddr};
 
+    quic::StreamPriority priority;
+    if (auto urgency = quicconnect.request.urgency)
+    {
+      if (*urgency < 0 or *urgency > quic::StreamPriority::max_urgency)
+      {
+        SetJSONError("Invalid urgency: must be between 0 and 7", quicconnect.response);
+        return;
+      }
+      priority.urgency = *urgency;
+    }
+    if (auto incremental = quicconnect.request.incremental)
+      priority.incremental = *incremental;
+
     try
     {
       auto [addr, id] = quic->open(
-          quicconnect.request.remoteHost, quicconnect.request.port, [](auto&&) {}, laddr);
+          quicconnect.request.remoteHost,
+          quicconnect.request.port,
+          [](auto&&) {},
+          laddr,
+          priority);
 
       util::StatusObject status;
       status["addr"] = addr.ToString();
@@ -583,6 +666,156 @@ namespace llarp::rpc
     SetJSONResponse("OK", config.response);
   }
 
+  void
+  RPCServer::invoke(ReloadConfig& reloadconfig)
+  {
+    if (not m_Router.IsRunning())
+    {
+      SetJSONError("Router is not yet ready", reloadconfig.response);
+      return;
+    }
+    // throws if the file no longer parses, which comes back as the error
+    auto conf = m_Router.GetConfig()->Reload(m_Router.IsServiceNode());
+    if (not conf)
+    {
+      SetJSONError("Config was not loaded from a file", reloadconfig.response);
+      return;
+    }
+    SetJSONResponse(
+        util::StatusObject{{"restart", m_Router.Reconfigure(std::move(conf))}},
+        reloadconfig.response);
+  }
+
+  void
+  RPCServer::invoke(Profile& profile)
+  {
+    const auto& req = profile.request;
+    const bool cpu = req.kind == "cpu";
+    if (not cpu and req.kind != "heap")
+      throw rpc_error{"kind must be \"cpu\" or \"heap\""};
+    const std::chrono::seconds duration{req.seconds};
+    if (duration < 1s or duration > util::profiler::MaxDuration)
+      throw rpc_error{fmt::format(
+          "seconds must be 1 to {}",
+          std::chrono::duration_cast<std::chrono::seconds>(util::profiler::MaxDuration).count())};
+    const auto file = m_Router.GetConfig()->router.m_dataDir
+        / fmt::format("profile-{}-{}.{}",
+                      req.kind,
+                      time_now_ms().count() / 1000,
+                      cpu ? "folded" : "heap");
+    const uint64_t defaultRate =
+        cpu ? util::profiler::DefaultCPURate : util::profiler::DefaultHeapSampleBits;
+    const auto rate = static_cast<unsigned>(
+        std::min<uint64_t>(req.rate.value_or(defaultRate), std::numeric_limits<unsigned>::max()));
+    // these throw if a profile of the kind is running already, or it can't be done here
+    if (cpu)
+      util::profiler::StartCPU(rate, duration);
+    else
+      util::profiler::StartHeap(rate);
+
+    m_Router.loop()->call_later(duration, [router = &m_Router, cpu, file] {
+      // writing out a cpu profile symbolises every frame, which is too slow for the loop
+      router->QueueDiskIO([cpu, file] {
+        try
+        {
+          if (cpu)
+            util::profiler::StopCPU(file);
+          else
+            util::profiler::StopHeap(file);
+        }
+        catch (const std::exception& ex)
+        {
+          log::warning(logcat, "failed to write {} profile: {}", cpu ? "cpu" : "heap", ex.what());
+        }
+      });
+    });
+    SetJSONResponse(
+        util::StatusObject{{"file", file.u8string()}, {"seconds", duration.count()}},
+        profile.response);
+  }
+
+  void
+  RPCServer::invoke(RecordLinks& recordlinks)
+  {
+    static constexpr std::chrono::seconds MaxRecording = 1h;
+    const auto& req = recordlinks.request;
+    if (not m_Router.IsRunning())
+      throw rpc_error{"Router is not yet ready"};
+    const std::chrono::seconds duration{req.seconds};
+    if (duration < 1s or duration > MaxRecording)
+      throw rpc_error{fmt::format("seconds must be 1 to {}", MaxRecording.count())};
+    if (not m_LinkRecorder.expired())
+      throw rpc_error{"links are being recorded already"};
+    const auto file = m_Router.GetConfig()->router.m_dataDir
+        / fmt::format("links-{}.rec", time_now_ms().count() / 1000);
+    std::shared_ptr<LinkRecorder> recorder;
+    try
+    {
+      recorder = std::make_shared<LinkRecorder>(
+          file, req.payloads, req.maxMB * 1'000'000, [router = &m_Router](auto write) {
+            router->QueueDiskIO(std::move(write));
+          });
+    }
+    catch (const std::exception& ex)
+    {
+      throw rpc_error{ex.what()};
+    }
+    m_LinkRecorder = recorder;
+    const auto setRecorder = [router = &m_Router](const std::shared_ptr<LinkRecorder>& r) {
+      router->linkManager().ForEachInboundLink([&r](LinkLayer_ptr link) { link->SetRecorder(r); });
+      router->linkManager().ForEachOutboundLink([&r](LinkLayer_ptr link) { link->SetRecorder(r); });
+    };
+    setRecorder(recorder);
+    // the links hold the only references; once they let go, what is left gets written out
+    m_Router.loop()->call_later(duration, [setRecorder, file, weak = m_LinkRecorder] {
+      if (auto r = weak.lock())
+        log::info(logcat, "recorded {} link messages to {}", r->Records(), file);
+      setRecorder(nullptr);
+    });
+    SetJSONResponse(
+        util::StatusObject{{"file", file.u8string()}, {"seconds", duration.count()}},
+        recordlinks.response);
+  }
+
+  void
+  RPCServer::invoke(ListRouters& listrouters)
+  {
+    static constexpr uint64_t MaxLimit = 1000;
+    const auto& req = listrouters.request;
+    if (not m_Router.IsRunning())
+      throw rpc_error{"Router is not yet ready"};
+    if (req.limit < 1 or req.limit > MaxLimit)
+      throw rpc_error{fmt::format("limit must be 1 to {}", MaxLimit)};
+    std::optional<RouterID> after;
+    if (not req.after.empty())
+    {
+      after.emplace();
+      if (not after->FromString(req.after))
+        throw rpc_error{"invalid after: " + req.after};
+    }
+    // the page is copied out of the nodedb here on the loop; the rest needs only the copies, so
+    // happens on a worker, as for status
+    bool more = false;
+    auto page = m_Router.nodedb()->Page(after, req.limit, more);
+    const auto total = m_Router.nodedb()->NumLoaded();
+    m_Router.QueueWork([bt = listrouters.is_bt(),
+                        page = std::move(page),
+                        more,
+                        total,
+                        reply = listrouters.move()]() mutable {
+      std::vector<util::StatusObject> routers;
+      routers.reserve(page.size());
+      for (const auto& rc : page)
+        routers.push_back(rc.ExtractStatus());
+      util::StatusObject result{{"routers", std::move(routers)}, {"total", total}};
+      if (more)
+        result["next"] = RouterID{page.back().pubkey}.ToString();
+      json response;
+      SetJSONResponse(std::move(result), response);
+      reply.reply(bt ? oxenc::bt_serialize(json_to_bt(std::move(response))) : response.dump());
+    });
+  }
+
   void
   RPCServer::HandleLogsSubRequest(oxenmq::Message& m)
   {
@@ -617,4 +850,136 @@ namespace llarp::rpc
     }
   }
 
+  /// how long a status subscription lasts without being renewed
+  static constexpr auto StatusSubscriptionLifetime = 30min;
+
+  void
+  RPCServer::HandleStatusSubRequest(oxenmq::Message& m)
+  {
+    if (m.data.size() != 1)
+    {
+      m.send_reply("Invalid subscription request: no status receipt endpoint given");
+      return;
+    }
+    if (not m_StatusTimer)
+    {
+      m.send_reply("Status subscriptions are turned off");
+      return;
+    }
+
+    // the subscriptions, and the snapshots they are sent from, are only touched on the router's
+    // loop, where the status is taken from
+    m_Router.loop()->call([this,
+                           conn = m.conn,
+                           remote = std::string{m.remote},
+                           endpoint = std::string{m.data[0]},
+                           reply = m.send_later()]() mutable {
+      if (endpoint == "unsubscribe")
+      {
+        log::info(logcat, "New status unsubscribe request from conn {}@{}", conn, remote);
+        m_StatusSubs.erase(conn);
+        reply.reply("OK");
+        return;
+      }
+
+      if (not m_Router.IsRunning())
+      {
+        reply.reply("Router is not yet ready");
+        return;
+      }
+
+      const auto expires = m_Router.Now() + StatusSubscriptionLifetime;
+      if (auto itr = m_StatusSubs.find(conn); itr != m_StatusSubs.end())
+      {
+        log::debug(logcat, "Renewed status subscription request from conn {}@{}", conn, remote);
+        itr->second = StatusSubscriber{std::move(endpoint), expires};
+        reply.reply("ALREADY");
+        return;
+      }
+
+      log::info(logcat, "New status subscription request from conn {}@{}", conn, remote);
+      // with no one else subscribed the snapshot is as old as the last one anyone was sent, so
+      // take a fresh one; otherwise the cached one is at most an interval old and the next delta
+      // goes on from it
+      if (m_StatusSubs.empty() or m_StatusSnapshotDump.empty())
+        RefreshStatus();
+      reply.reply("OK");
+      m_LMQ->send(conn, endpoint, "full", std::to_string(m_StatusSeq), m_StatusSnapshotDump);
+      m_StatusSubs.emplace(conn, StatusSubscriber{std::move(endpoint), expires});
+    });
+  }
+
+  void
+  RPCServer::RefreshStatus()
+  {
+    m_StatusSnapshot = m_Router.ExtractStatus();
+    m_StatusSnapshotDump = m_StatusSnapshot.dump();
+    m_StatusSeq++;
+  }
+
+  void
+  RPCServer::PushStatus()
+  {
+    const auto now = m_Router.Now();
+    for (auto itr = m_StatusSubs.begin(); itr != m_StatusSubs.end();)
+    {
+      if (itr->second.expires <= now)
+      {
+        log::debug(logcat, "Status subscription from conn {} expired", itr->first);
+        itr = m_StatusSubs.erase(itr);
+      }
+      else
+        ++itr;
+    }
+    // no one to push to: don't keep snapshots no one will see, the next subscriber takes a fresh
+    // one anyway
+    if (m_StatusSubs.empty())
+    {
+      m_StatusSnapshot = nullptr;
+      m_StatusSnapshotDump.clear();
+      return;
+    }
+    // the last tick's delta is still being worked out
+    if (m_StatusPushing or not m_Router.IsRunning())
+      return;
+
+    // the status has to be taken here on the loop, but diffing and serialising it need nothing
+    // but the trees, so a worker does that and hands back what to send
+    m_StatusPushing = true;
+    m_Router.QueueWork([this,
+                        alive = std::weak_ptr<int>{m_StatusTimer},
+                        base = m_StatusSeq,
+                        prev = std::move(m_StatusSnapshot),
+                        status = m_Router.ExtractStatus()]() mutable {
+      std::optional<std::string> delta, dump;
+      if (auto patch = nlohmann::json::diff(prev, status); not patch.empty())
+      {
+        delta = patch.dump();
+        dump = status.dump();
+      }
+      m_Router.loop()->call([this,
+                             alive = std::move(alive),
+                             base,
+                             status = std::move(status),
+                             delta = std::move(delta),
+                             dump = std::move(dump)]() mutable {
+        if (not alive.lock())
+          return;
+        m_StatusPushing = false;
+        // a new subscriber took a fresh snapshot meanwhile, which the next delta goes on from
+        if (base != m_StatusSeq)
+          return;
+        m_StatusSnapshot = std::move(status);
+        if (not delta)
+          return;
+        m_StatusSnapshotDump = std::move(*dump);
+        m_StatusSeq++;
+        // serialised once however many are subscribed; each send only copies the bytes
+        const auto seq = std::to_string(m_StatusSeq);
+        for (const auto& [conn, sub] : m_StatusSubs)
+          m_LMQ->send(conn, sub.endpoint, "delta", seq, *delta);
+      });
+    });
+  }
+
 }  // namespace llarp::rpc
@@ -2,9 +2,10 @@
 
 #include "rpc_request_definitions.hpp"
 #include "json_bt.hpp"
-#include <nlohmann/json_fwd.hpp>
+#include <nlohmann/json.hpp>
 #include <stdexcept>
 #include <string_view>
+#include <unordered_map>
 #include <llarp/config/config.hpp>
 #include <oxenmq/oxenmq.h>
 #include <oxenmq/message.h>
@@ -21,6 +22,11 @@ namespace
   static auto logcat = llarp::log::Cat("lokinet.rpc");
 }  // namespace
 
+namespace llarp
+{
+  class LinkRecorder;
+}
+
 namespace llarp::rpc
 {
   using LMQ_ptr = std::shared_ptr<oxenmq::OxenMQ>;
@@ -87,6 +93,9 @@ namespace llarp::rpc
     void
     HandleLogsSubRequest(oxenmq::Message& m);
 
+    void
+    HandleStatusSubRequest(oxenmq::Message& m);
+
     void
     AddCategories();
 
@@ -99,6 +108,14 @@ namespace llarp::rpc
     void
     invoke(GetStatus& getstatus);
     void
+    invoke(LinkStats& linkstats);
+    void
+    invoke(MemoryStats& memorystats);
+    void
+    invoke(LoopStats& loopstats);
+    void
+    invoke(Metrics& metrics);
+    void
     invoke(QuicConnect& quicconnect);
     void
     invoke(QuicListener& quiclistener);
@@ -116,10 +133,45 @@ namespace llarp::rpc
     invoke(DNSQuery& dnsquery);
     void
     invoke(Config& config);
+    void
+    invoke(ReloadConfig& reloadconfig);
+    void
+    invoke(Profile& profile);
+    void
+    invoke(RecordLinks& recordlinks);
+    void
+    invoke(ListRouters& listrouters);
 
     LMQ_ptr m_LMQ;
     AbstractRouter& m_Router;
     oxen::log::PubsubLogger log_subs;
+
+   private:
+    /// a client pushed status deltas; they expire unless the client renews them
+    struct StatusSubscriber
+    {
+      std::string endpoint;
+      llarp_time_t expires;
+    };
+
+    /// takes a fresh status snapshot, serialised once for whoever subscribes before the next one.
+    /// must be called on the router's loop, as everything touching the status subscriptions is.
+    void
+    RefreshStatus();
+
+    void
+    PushStatus();
+
+    std::unordered_map<oxenmq::ConnectionID, StatusSubscriber> m_StatusSubs;
+    nlohmann::json m_StatusSnapshot;
+    std::string m_StatusSnapshotDump;
+    uint64_t m_StatusSeq = 0;
+    /// set while a worker works out a delta to push
+    bool m_StatusPushing = false;
+    /// ties the push timer's lifetime to ours
+    std::shared_ptr<int> m_StatusTimer;
+    /// the links hold it while record_links records; set and read on the router's loop
+    std::weak_ptr<LinkRecorder> m_LinkRecorder;
   };
 
   template <typename RPC>
@@ -103,7 +103,9 @@ namespace std
     size_t
     operator()(const llarp::service::Address& addr) const
     {
-      return std::accumulate(addr.begin(), addr.end(), 0, std::bit_xor{});
+      // addresses are public keys, so any of their bytes are as good as random; folding them all
+      // into one byte left every map keyed by address with at most 256 buckets
+      return std::hash<llarp::AlignedBuffer<32>>{}(addr);
     }
   };
 }  // namespace std
@@ -9,6 +9,16 @@ namespace llarp
 {
   namespace service
   {
+    std::optional<PQEncapsulation>
+    PQEncapsulation::Make(const PQPubKey& pubkey)
+    {
+      PQEncapsulation enc;
+      enc.pubkey = pubkey;
+      if (not CryptoManager::instance()->pqe_encrypt(enc.cipher, enc.key, pubkey))
+        return std::nullopt;
+      return enc;
+    }
+
     AsyncKeyExchange::AsyncKeyExchange(
         EventLoop_ptr l,
         ServiceInfo r,
@@ -48,7 +58,14 @@ namespace llarp
       // derive ntru session key component
       SharedSecret K;
       auto crypto = CryptoManager::instance();
-      crypto->pqe_encrypt(frame->C, K, self->introPubKey);
+      if (self->encapsulation and self->encapsulation->pubkey == self->introPubKey)
+      {
+        frame->C = self->encapsulation->cipher;
+        K = self->encapsulation->key;
+        self->encapsulation.reset();
+      }
+      else
+        crypto->pqe_encrypt(frame->C, K, self->introPubKey);
       // randomize Nonce
       frame->N.Randomize();
       // compure post handshake session key
@@ -4,10 +4,25 @@
 #include "identity.hpp"
 #include "protocol.hpp"
 
+#include <optional>
+
 namespace llarp
 {
   namespace service
   {
+    /// an ntru encapsulation to a remote's introset key, made ahead of time so that the key
+    /// exchange that uses it doesn't have to wait for it.  each one may only be used once.
+    struct PQEncapsulation
+    {
+      PQPubKey pubkey;
+      PQCipherBlock cipher;
+      SharedSecret key;
+
+      /// make one for pubkey, or nullopt if that fails; slow, so call it from a worker
+      static std::optional<PQEncapsulation>
+      Make(const PQPubKey& pubkey);
+    };
+
     struct AsyncKeyExchange : public std::enable_shared_from_this<AsyncKeyExchange>
     {
       EventLoop_ptr loop;
@@ -21,6 +36,8 @@ namespace llarp
       std::function<void(std::shared_ptr<ProtocolFrame>)> hook;
       IDataHandler* handler;
       ConvoTag tag;
+      /// used instead of encapsulating in Encrypt if set and made for introPubKey
+      std::optional<PQEncapsulation> encapsulation;
 
       AsyncKeyExchange(
           EventLoop_ptr l,
@@ -1,4 +1,5 @@
 #include "auth.hpp"
+#include "auth_cache.hpp"
 #include <unordered_map>
 
 #include <llarp/router/abstractrouter.hpp>
@@ -185,4 +186,77 @@ namespace llarp::service
     return std::make_shared<FileAuthPolicy>(r, std::move(files), filetype);
   }
 
+  class CachedAuthPolicy : public IAuthPolicy,
+                           public std::enable_shared_from_this<CachedAuthPolicy>
+  {
+    AbstractRouter* const m_Router;
+    const std::shared_ptr<IAuthPolicy> m_Policy;
+    mutable util::Mutex m_Access;
+    AuthCache m_Cache;
+
+    /// who sent the message, and the token in it if it is an auth message; anything else carries
+    /// traffic, which is not what the policy goes by
+    static AuthCache::Key_t
+    MakeKey(const ProtocolMessage& msg)
+    {
+      const auto from = msg.sender.Addr();
+      std::vector<byte_t> data{from.begin(), from.end()};
+      data.push_back(static_cast<byte_t>(msg.proto));
+      if (msg.proto == ProtocolType::Auth)
+        data.insert(data.end(), msg.payload.begin(), msg.payload.end());
+      AuthCache::Key_t key;
+      CryptoManager::instance()->shorthash(key, llarp_buffer_t{data});
+      return key;
+    }
+
+   public:
+    CachedAuthPolicy(
+        AbstractRouter* r, std::shared_ptr<IAuthPolicy> policy, llarp_time_t positiveTTL)
+        : m_Router{r}, m_Policy{std::move(policy)}, m_Cache{positiveTTL}
+    {}
+
+    void
+    AuthenticateAsync(
+        std::shared_ptr<ProtocolMessage> msg, std::function<void(AuthResult)> hook) override
+    {
+      const auto key = MakeKey(*msg);
+      std::optional<AuthResult> cached;
+      {
+        util::Lock _lock{m_Access};
+        cached = m_Cache.Get(key, m_Router->Now());
+      }
+      if (cached)
+      {
+        m_Router->loop()->call([hook = std::move(hook), result = std::move(*cached)] {
+          hook(result);
+        });
+        return;
+      }
+      m_Policy->AuthenticateAsync(
+          std::move(msg),
+          [self = shared_from_this(), key, hook = std::move(hook)](AuthResult result) {
+            {
+              util::Lock _lock{self->m_Access};
+              self->m_Cache.Put(key, result, self->m_Router->Now());
+            }
+            hook(result);
+          });
+    }
+
+    bool
+    AsyncAuthPending(ConvoTag tag) const override
+    {
+      return m_Policy->AsyncAuthPending(tag);
+    }
+  };
+
+  std::shared_ptr<IAuthPolicy>
+  MakeCachedAuthPolicy(
+      AbstractRouter* r, std::shared_ptr<IAuthPolicy> policy, llarp_time_t positiveTTL)
+  {
+    if (positiveTTL == 0s)
+      return policy;
+    return std::make_shared<CachedAuthPolicy>(r, std::move(policy), positiveTTL);
+  }
+
 }  // namespace llarp::service
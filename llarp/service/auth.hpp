@@ -97,4 +97,11 @@ namespace llarp::service
   std::shared_ptr<IAuthPolicy>
   MakeFileAuthPolicy(AbstractRouter*, std::set<fs::path> files, AuthFileType fileType);
 
+  /// make an IAuthPolicy that remembers what policy said about each sender and token for a while
+  /// (see AuthCache), so clients coming back don't go through it again.  accepted ones are kept
+  /// for positiveTTL; if that is zero this is just policy.
+  std::shared_ptr<IAuthPolicy>
+  MakeCachedAuthPolicy(
+      AbstractRouter*, std::shared_ptr<IAuthPolicy> policy, llarp_time_t positiveTTL);
+
 }  // namespace llarp::service
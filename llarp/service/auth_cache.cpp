@@ -0,0 +1,76 @@
+#include "auth_cache.hpp"
+
+#include <algorithm>
+
+namespace llarp::service
+{
+  std::optional<AuthResult>
+  AuthCache::Get(const Key_t& key, llarp_time_t now)
+  {
+    const auto itr = m_Entries.find(key);
+    if (itr == m_Entries.end() or now >= itr->second.expiresAt)
+    {
+      ++m_Misses;
+      return std::nullopt;
+    }
+    const auto& result = itr->second.result;
+    ++(result.code == AuthResultCode::eAuthAccepted ? m_Hits : m_NegativeHits);
+    return result;
+  }
+
+  void
+  AuthCache::Put(const Key_t& key, AuthResult result, llarp_time_t now)
+  {
+    llarp_time_t ttl;
+    switch (result.code)
+    {
+      case AuthResultCode::eAuthAccepted:
+        ttl = m_PositiveTTL;
+        break;
+      case AuthResultCode::eAuthRejected:
+      case AuthResultCode::eAuthPaymentRequired:
+        ttl = NegativeTTL;
+        break;
+      default:
+        // the backend could not say this time; that is no reason not to ask it next time
+        m_Entries.erase(key);
+        return;
+    }
+    if (m_Entries.size() >= MaxEntries and not m_Entries.count(key))
+    {
+      Decay(now);
+      if (m_Entries.size() >= MaxEntries)
+      {
+        m_Entries.erase(std::min_element(
+            m_Entries.begin(), m_Entries.end(), [](const auto& lhs, const auto& rhs) {
+              return lhs.second.expiresAt < rhs.second.expiresAt;
+            }));
+        ++m_Evictions;
+      }
+    }
+    m_Entries[key] = Entry{std::move(result), now + ttl};
+  }
+
+  void
+  AuthCache::Decay(llarp_time_t now)
+  {
+    for (auto itr = m_Entries.begin(); itr != m_Entries.end();)
+    {
+      if (now >= itr->second.expiresAt)
+        itr = m_Entries.erase(itr);
+      else
+        ++itr;
+    }
+  }
+
+  util::StatusObject
+  AuthCache::ExtractStatus() const
+  {
+    return util::StatusObject{
+        {"entries", m_Entries.size()},
+        {"hits", m_Hits},
+        {"negativeHits", m_NegativeHits},
+        {"misses", m_Misses},
+        {"evictions", m_Evictions}};
+  }
+}  // namespace llarp::service
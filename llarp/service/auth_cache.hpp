@@ -0,0 +1,72 @@
+#pragma once
+
+#include "auth.hpp"
+#include <llarp/crypto/types.hpp>
+#include <llarp/util/status.hpp>
+#include <llarp/util/time.hpp>
+
+#include <optional>
+#include <unordered_map>
+
+namespace llarp::service
+{
+  /// what an auth policy said about the senders and tokens it saw lately, so that a client
+  /// coming back with a new convotag is let in (or turned away) without asking the policy again.
+  ///
+  /// entries are keyed by a hash of who sent the auth message and of the token in it.  answers
+  /// that say something about the token, accepted or turned away, are kept; attempts that failed
+  /// or were rate limited say nothing about it and are asked again next time.
+  ///
+  /// this means a token the policy stops accepting keeps working for whoever used it last for
+  /// up to the positive ttl, which is [network]:auth-cache-ttl.
+  class AuthCache
+  {
+   public:
+    using Key_t = ShortHash;
+
+    /// how long we keep an accepted sender and token unless told otherwise, and one that was not
+    static constexpr auto DefaultPositiveTTL = 10min;
+    static constexpr auto NegativeTTL = 30s;
+    /// the most entries we keep; past this the ones expiring soonest go first
+    static constexpr size_t MaxEntries = 4096;
+
+    explicit AuthCache(llarp_time_t positiveTTL = DefaultPositiveTTL) : m_PositiveTTL{positiveTTL}
+    {}
+
+    /// the answer we have for key, or nullopt if we need to ask
+    std::optional<AuthResult>
+    Get(const Key_t& key, llarp_time_t now);
+
+    /// remember the answer we got for key, if it is one worth keeping
+    void
+    Put(const Key_t& key, AuthResult result, llarp_time_t now);
+
+    /// forget entries past their ttl
+    void
+    Decay(llarp_time_t now);
+
+    size_t
+    Size() const
+    {
+      return m_Entries.size();
+    }
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    struct Entry
+    {
+      AuthResult result;
+      llarp_time_t expiresAt = 0s;
+    };
+
+    const llarp_time_t m_PositiveTTL;
+    std::unordered_map<Key_t, Entry> m_Entries;
+
+    uint64_t m_Hits = 0;
+    uint64_t m_NegativeHits = 0;
+    uint64_t m_Misses = 0;
+    uint64_t m_Evictions = 0;
+  };
+}  // namespace llarp::service
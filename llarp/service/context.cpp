@@ -5,6 +5,8 @@
 #include <llarp/nodedb.hpp>
 #include <llarp/router/abstractrouter.hpp>
 #include "endpoint.hpp"
+
+#include <algorithm>
 #include <stdexcept>
 
 namespace llarp
@@ -53,6 +55,8 @@ namespace llarp
         m_Stopped.emplace_back(std::move(itr->second));
         itr = m_Endpoints.erase(itr);
       }
+      m_TickOrder.clear();
+      m_NextTick = 0;
       return true;
     }
 
@@ -99,6 +103,8 @@ namespace llarp
         return false;
       std::shared_ptr<Endpoint> ep = std::move(itr->second);
       m_Endpoints.erase(itr);
+      m_TickOrder.erase(
+          std::remove(m_TickOrder.begin(), m_TickOrder.end(), ep), m_TickOrder.end());
       ep->Stop();
       m_Stopped.emplace_back(std::move(ep));
       return true;
@@ -118,11 +124,16 @@ namespace llarp
             ++itr;
         }
       }
-      // tick active endpoints
-      for (const auto& item : m_Endpoints)
+      // tick active endpoints, taking turns once there are many; they look at the clock
+      // themselves, so one that sits out a tick or two just catches up on its next
+      const size_t n = std::min(m_TickOrder.size(), EndpointsPerTick);
+      for (size_t i = 0; i < n; ++i)
       {
-        item.second->Tick(now);
+        if (m_NextTick >= m_TickOrder.size())
+          m_NextTick = 0;
+        m_TickOrder[m_NextTick++]->Tick(now);
       }
+      m_NameCache.Decay(now);
     }
 
     bool
@@ -177,10 +188,17 @@ namespace llarp
       ep->LoadKeyFile();
       if (ep->Start())
       {
-        m_Endpoints.emplace(std::move(name), std::move(ep));
+        Emplace(std::move(name), std::move(ep));
       }
     }
 
+    void
+    Context::Emplace(std::string name, std::shared_ptr<Endpoint> ep)
+    {
+      if (m_Endpoints.emplace(std::move(name), ep).second)
+        m_TickOrder.push_back(std::move(ep));
+    }
+
     void
     Context::AddEndpoint(const Config& conf, bool autostart)
     {
@@ -215,7 +233,7 @@ namespace llarp
           throw std::runtime_error("failed to start hidden service endpoint");
       }
 
-      m_Endpoints.emplace(endpointName, service);
+      Emplace(endpointName, std::move(service));
     }
   }  // namespace service
 }  // namespace llarp
@@ -4,8 +4,10 @@
 #include <llarp/net/net.hpp>
 #include <llarp/config/config.hpp>
 #include "endpoint.hpp"
+#include "lns_cache.hpp"
 
 #include <unordered_map>
+#include <vector>
 
 namespace llarp
 {
@@ -65,9 +67,27 @@ namespace llarp
       bool
       StartAll();
 
+      /// the lns names our endpoints have resolved
+      LNSCache&
+      NameCache()
+      {
+        return m_NameCache;
+      }
+
+      /// most endpoints we tick per router tick; with more than this hosted, they take turns,
+      /// so that the router tick doesn't grow with how many we host
+      static constexpr size_t EndpointsPerTick = 64;
+
      private:
+      void
+      Emplace(std::string name, std::shared_ptr<Endpoint> ep);
+
       AbstractRouter* const m_Router;
+      LNSCache m_NameCache;
       std::unordered_map<std::string, std::shared_ptr<Endpoint>> m_Endpoints;
+      /// m_Endpoints in the order we take turns ticking them, and where the next turn starts
+      std::vector<std::shared_ptr<Endpoint>> m_TickOrder;
+      size_t m_NextTick = 0;
       std::list<std::shared_ptr<Endpoint>> m_Stopped;
     };
   }  // namespace service
@@ -0,0 +1,152 @@
+#include "convo_map.hpp"
+
+#include <algorithm>
+
+namespace llarp::service
+{
+  size_t
+  ConvoMap::Find(const ConvoTag& tag) const
+  {
+    if (m_Slots.empty())
+      return 0;
+    const size_t hash = Hash(tag);
+    const uint8_t control = ControlFor(hash);
+    const size_t mask = m_Slots.size() - 1;
+    // we never fill the table, so this always gets to an empty slot
+    for (size_t idx = hash & mask;; idx = (idx + 1) & mask)
+    {
+      if (m_Control[idx] == Empty)
+        return m_Slots.size();
+      if (m_Control[idx] == control and m_Slots[idx].first == tag)
+        return idx;
+    }
+  }
+
+  size_t
+  ConvoMap::NextFull(size_t idx) const
+  {
+    while (idx < m_Control.size() and not(m_Control[idx] & Full))
+      ++idx;
+    return std::min(idx, m_Slots.size());
+  }
+
+  std::pair<ConvoMap::iterator, bool>
+  ConvoMap::emplace(const ConvoTag& tag, Session session)
+  {
+    if (const auto idx = Find(tag); idx != m_Slots.size())
+      return {iterator{this, idx}, false};
+
+    // keep at most 3/4 of the slots walked over; when rebuilding, go to at most half full
+    if ((m_Used + 1) * 4 > m_Slots.size() * 3)
+    {
+      size_t slots = MinSlots;
+      while (slots < (m_Size + 1) * 2)
+        slots *= 2;
+      Rehash(slots);
+    }
+
+    const size_t hash = Hash(tag);
+    const size_t mask = m_Slots.size() - 1;
+    size_t idx = hash & mask;
+    while (m_Control[idx] & Full)
+      idx = (idx + 1) & mask;
+    if (m_Control[idx] == Empty)
+      ++m_Used;
+    m_Control[idx] = ControlFor(hash);
+    m_Slots[idx] = value_type{tag, std::move(session)};
+    ++m_Size;
+    return {iterator{this, idx}, true};
+  }
+
+  ConvoMap::iterator
+  ConvoMap::erase(const_iterator itr)
+  {
+    const size_t idx = itr.m_Idx;
+    auto& slot = m_Slots[idx];
+    Unindex(slot.first, slot.second.Addr());
+    slot = value_type{};
+    --m_Size;
+    // nothing can probe past an empty slot, so if the next one is, this one needn't be a
+    // tombstone either
+    if (m_Control[(idx + 1) & (m_Slots.size() - 1)] == Empty)
+    {
+      m_Control[idx] = Empty;
+      --m_Used;
+    }
+    else
+      m_Control[idx] = Erased;
+    return {this, NextFull(idx + 1)};
+  }
+
+  size_t
+  ConvoMap::erase(const ConvoTag& tag)
+  {
+    const auto itr = find(tag);
+    if (itr == end())
+      return 0;
+    erase(itr);
+    return 1;
+  }
+
+  void
+  ConvoMap::clear()
+  {
+    m_Control.clear();
+    m_Slots.clear();
+    m_Size = 0;
+    m_Used = 0;
+    m_ByRemote.clear();
+  }
+
+  void
+  ConvoMap::Rehash(size_t slots)
+  {
+    auto control = std::exchange(m_Control, std::vector<uint8_t>(slots, Empty));
+    auto old = std::exchange(m_Slots, std::vector<value_type>(slots));
+    const size_t mask = slots - 1;
+    for (size_t i = 0; i < old.size(); ++i)
+    {
+      if (not(control[i] & Full))
+        continue;
+      size_t idx = Hash(old[i].first) & mask;
+      while (m_Control[idx] != Empty)
+        idx = (idx + 1) & mask;
+      m_Control[idx] = control[i];
+      m_Slots[idx] = std::move(old[i]);
+    }
+    m_Used = m_Size;
+  }
+
+  void
+  ConvoMap::SetRemote(iterator itr, const ServiceInfo& remote)
+  {
+    auto& [tag, session] = *itr;
+    Unindex(tag, session.Addr());
+    session.remote = remote;
+    m_ByRemote[session.Addr()].push_back(tag);
+  }
+
+  const std::vector<ConvoTag>&
+  ConvoMap::TagsFor(const Address& addr) const
+  {
+    static const std::vector<ConvoTag> none;
+    const auto itr = m_ByRemote.find(addr);
+    return itr == m_ByRemote.end() ? none : itr->second;
+  }
+
+  void
+  ConvoMap::Unindex(const ConvoTag& tag, const Address& addr)
+  {
+    const auto itr = m_ByRemote.find(addr);
+    if (itr == m_ByRemote.end())
+      return;
+    auto& tags = itr->second;
+    if (const auto found = std::find(tags.begin(), tags.end(), tag); found != tags.end())
+    {
+      *found = tags.back();
+      tags.pop_back();
+    }
+    if (tags.empty())
+      m_ByRemote.erase(itr);
+  }
+}  // namespace llarp::service
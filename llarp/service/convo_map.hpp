@@ -0,0 +1,230 @@
+#pragma once
+
+#include "address.hpp"
+#include "convotag.hpp"
+#include "info.hpp"
+#include "session.hpp"
+
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace llarp::service
+{
+  /// an endpoint's sessions by convo tag, which it looks up for every data message in and out.
+  ///
+  /// open addressed, probing linearly over a power of two array of slots with a control byte
+  /// each: empty, erased, or in use along with 7 bits of the tag's hash, so that a lookup mostly
+  /// compares bytes next to each other and only looks at a tag whose hash bits match.  erasing
+  /// leaves a tombstone (unless it ends a probe run), which keeps iterators good over
+  /// erase(itr), and tombstones go when the table is next rebuilt.  inserting can rebuild it, so
+  /// unlike std::unordered_map, an insert invalidates iterators and references.
+  ///
+  /// alongside the table we keep the tags we have with each remote address, as set through
+  /// SetRemote, so that finding the convos for an address doesn't look at every convo we have.
+  class ConvoMap
+  {
+   public:
+    using key_type = ConvoTag;
+    using mapped_type = Session;
+    using value_type = std::pair<ConvoTag, Session>;
+
+    template <bool Const>
+    class Iterator
+    {
+     public:
+      using iterator_category = std::forward_iterator_tag;
+      using value_type = ConvoMap::value_type;
+      using difference_type = std::ptrdiff_t;
+      using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+      using reference = std::conditional_t<Const, const value_type&, value_type&>;
+      using Map_t = std::conditional_t<Const, const ConvoMap, ConvoMap>;
+
+      Iterator() = default;
+
+      Iterator(Map_t* map, size_t idx) : m_Map{map}, m_Idx{idx}
+      {}
+
+      /// const from non const
+      template <bool C = Const, typename = std::enable_if_t<C>>
+      Iterator(const Iterator<false>& other) : m_Map{other.m_Map}, m_Idx{other.m_Idx}
+      {}
+
+      reference
+      operator*() const
+      {
+        return m_Map->m_Slots[m_Idx];
+      }
+
+      pointer
+      operator->() const
+      {
+        return &m_Map->m_Slots[m_Idx];
+      }
+
+      Iterator&
+      operator++()
+      {
+        m_Idx = m_Map->NextFull(m_Idx + 1);
+        return *this;
+      }
+
+      Iterator
+      operator++(int)
+      {
+        auto copy = *this;
+        ++*this;
+        return copy;
+      }
+
+      bool
+      operator==(const Iterator& other) const
+      {
+        return m_Idx == other.m_Idx;
+      }
+
+      bool
+      operator!=(const Iterator& other) const
+      {
+        return m_Idx != other.m_Idx;
+      }
+
+     private:
+      friend class ConvoMap;
+      friend class Iterator<not Const>;
+
+      Map_t* m_Map = nullptr;
+      size_t m_Idx = 0;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    iterator
+    begin()
+    {
+      return {this, NextFull(0)};
+    }
+
+    iterator
+    end()
+    {
+      return {this, m_Slots.size()};
+    }
+
+    const_iterator
+    begin() const
+    {
+      return {this, NextFull(0)};
+    }
+
+    const_iterator
+    end() const
+    {
+      return {this, m_Slots.size()};
+    }
+
+    size_t
+    size() const
+    {
+      return m_Size;
+    }
+
+    bool
+    empty() const
+    {
+      return m_Size == 0;
+    }
+
+    iterator
+    find(const ConvoTag& tag)
+    {
+      return {this, Find(tag)};
+    }
+
+    const_iterator
+    find(const ConvoTag& tag) const
+    {
+      return {this, Find(tag)};
+    }
+
+    size_t
+    count(const ConvoTag& tag) const
+    {
+      return Find(tag) == m_Slots.size() ? 0 : 1;
+    }
+
+    /// put session under tag if there is nothing there already, like std::unordered_map
+    std::pair<iterator, bool>
+    emplace(const ConvoTag& tag, Session session);
+
+    Session&
+    operator[](const ConvoTag& tag)
+    {
+      return emplace(tag, Session{}).first->second;
+    }
+
+    /// returns an iterator to whatever comes after itr
+    iterator
+    erase(const_iterator itr);
+
+    size_t
+    erase(const ConvoTag& tag);
+
+    void
+    clear();
+
+    /// set the remote of the session at itr, and index its tag under the remote's address
+    void
+    SetRemote(iterator itr, const ServiceInfo& remote);
+
+    /// the tags whose sessions have been given a remote of addr with SetRemote, in no order
+    const std::vector<ConvoTag>&
+    TagsFor(const Address& addr) const;
+
+   private:
+    static constexpr uint8_t Empty = 0;
+    static constexpr uint8_t Erased = 1;
+    /// set for a slot in use, whose low 7 bits are the top 7 of its tag's hash
+    static constexpr uint8_t Full = 0x80;
+    static constexpr size_t MinSlots = 16;
+
+    static size_t
+    Hash(const ConvoTag& tag)
+    {
+      return std::hash<ConvoTag>{}(tag);
+    }
+
+    static uint8_t
+    ControlFor(size_t hash)
+    {
+      return Full | static_cast<uint8_t>(hash >> (sizeof(size_t) * 8 - 7));
+    }
+
+    /// slot holding tag, or m_Slots.size() if there is none
+    size_t
+    Find(const ConvoTag& tag) const;
+
+    /// first slot in use from idx on, or m_Slots.size()
+    size_t
+    NextFull(size_t idx) const;
+
+    /// rebuild into a table of slots slots, without tombstones
+    void
+    Rehash(size_t slots);
+
+    void
+    Unindex(const ConvoTag& tag, const Address& addr);
+
+    std::vector<uint8_t> m_Control;
+    std::vector<value_type> m_Slots;
+    /// slots in use
+    size_t m_Size = 0;
+    /// slots in use or erased, which is what probing has to walk over
+    size_t m_Used = 0;
+
+    std::unordered_map<Address, std::vector<ConvoTag>> m_ByRemote;
+  };
+}  // namespace llarp::service
@@ -30,6 +30,8 @@ namespace std
     size_t
     operator()(const llarp::service::ConvoTag& tag) const
     {
+      // remote peers pick the tags we key their sessions by, so hash all of it rather than
+      // trusting any part of it to be random
       std::hash<std::string_view> h{};
       return h(std::string_view{reinterpret_cast<const char*>(tag.data()), tag.size()});
     }
@@ -3,6 +3,7 @@
 #include "endpoint_util.hpp"
 #include "hidden_service_address_lookup.hpp"
 #include "auth.hpp"
+#include "context.hpp"
 #include "llarp/util/logging.hpp"
 #include "outbound_context.hpp"
 #include "protocol.hpp"
@@ -36,6 +37,7 @@
 #include <llarp/quic/tunnel.hpp>
 #include <llarp/util/priority_queue.hpp>
 
+#include <algorithm>
 #include <optional>
 #include <type_traits>
 #include <utility>
@@ -48,6 +50,24 @@ namespace llarp
   {
     static auto logcat = log::Cat("endpoint");
 
+    namespace
+    {
+      /// most of what a tick took out that we let go of in one go of the loop
+      constexpr size_t ReclaimBatch = 16;
+
+      /// lets go of reclaim on the loop, ReclaimBatch at a time; the sessions in it belong to the
+      /// logic thread, so they are torn down there
+      void
+      ReclaimSoon(const EventLoop_ptr& loop, EndpointUtil::Reclaim_t reclaim)
+      {
+        loop->call_soon([loop, reclaim = std::move(reclaim)]() mutable {
+          reclaim.resize(reclaim.size() - std::min(reclaim.size(), ReclaimBatch));
+          if (not reclaim.empty())
+            ReclaimSoon(loop, std::move(reclaim));
+        });
+      }
+    }  // namespace
+
     Endpoint::Endpoint(AbstractRouter* r, Context* parent)
         : path::Builder{r, 3, path::default_len}
         , context{parent}
@@ -69,7 +89,28 @@ namespace llarp
     Endpoint::Configure(const NetworkConfig& conf, [[maybe_unused]] const DnsConfig& dnsConf)
     {
       if (conf.m_Paths.has_value())
-        numDesiredPaths = *conf.m_Paths;
+        numDesiredPaths = minDesiredPaths = *conf.m_Paths;
+      maxDesiredPaths = conf.m_MaxPaths;
+
+      m_Multipath = conf.m_Multipath;
+      m_CoalesceFrames = conf.m_CoalesceFrames;
+
+      if (m_quic)
+      {
+        auto& quic = m_quic->connection_settings;
+        if (auto algo = quic::parse_cc_algo(conf.m_QuicCongestionControl))
+          quic.cc_algo = *algo;
+        quic.connection_window = conf.m_QuicConnectionWindow;
+        quic.max_connection_window = conf.m_QuicMaxConnectionWindow;
+        quic.stream_window = conf.m_QuicStreamWindow;
+        quic.max_stream_window = conf.m_QuicMaxStreamWindow;
+        quic.stream_limit = conf.m_QuicStreamLimit;
+      }
+
+      pathPoolSize = conf.m_PathPoolSize;
+
+      m_LookupAlpha = conf.m_LookupAlpha;
+      m_MaxPendingLookups = conf.m_MaxPendingLookups;
 
       if (conf.m_Hops.has_value())
         numHops = *conf.m_Hops;
@@ -93,26 +134,83 @@ namespace llarp
       return m_state->Configure(conf);
     }
 
+    void
+    Endpoint::Reconfigure(
+        const NetworkConfig& was, const NetworkConfig& conf, [[maybe_unused]] const DnsConfig&)
+    {
+      if (conf.m_Paths.has_value())
+        numDesiredPaths = minDesiredPaths = *conf.m_Paths;
+      maxDesiredPaths = conf.m_MaxPaths;
+      if (conf.m_Hops.has_value())
+        numHops = *conf.m_Hops;
+      pathPoolSize = conf.m_PathPoolSize;
+
+      m_Multipath = conf.m_Multipath;
+      m_CoalesceFrames = conf.m_CoalesceFrames;
+      m_LookupAlpha = conf.m_LookupAlpha;
+      m_MaxPendingLookups = conf.m_MaxPendingLookups;
+      m_state->m_SnodeBlacklist = conf.m_snodeBlacklist;
+
+      // drop the mappings that are gone or go to another exit now, and add the new ones; a
+      // mapping left as it was keeps the sessions to its exit
+      const auto mapped = [](const auto& map, const IPRange& range, const service::Address& addr) {
+        bool found = false;
+        map.ForEachEntry([&](const IPRange& r, const service::Address& a) {
+          found = found or (r == range and a == addr);
+        });
+        return found;
+      };
+      was.m_ExitMap.ForEachEntry([&](const IPRange& range, const service::Address& addr) {
+        if (not mapped(conf.m_ExitMap, range, addr))
+          UnmapExitRange(range);
+      });
+      conf.m_ExitMap.ForEachEntry([&](const IPRange& range, const service::Address& addr) {
+        // against what is left rather than what was, as unmapping a range unmaps what is in it
+        if (not mapped(m_ExitMap, range, addr))
+          MapExitRange(range, addr);
+      });
+      for (const auto& [exit, auth] : conf.m_ExitAuths)
+        SetAuthInfoForEndpoint(exit, auth);
+    }
+
     bool
     Endpoint::HasPendingPathToService(const Address& addr) const
     {
       return m_state->m_PendingServiceLookups.find(addr) != m_state->m_PendingServiceLookups.end();
     }
 
+    namespace
+    {
+      /// true if b says something different from a to whoever looks us up, as opposed to the
+      /// same intros in another order or with fresher latencies.  exit policy comes from our
+      /// config, so doesn't change under us.
+      bool
+      IntrosetMateriallyDiffers(const IntroSet& a, const IntroSet& b)
+      {
+        return a.intros.size() != b.intros.size()
+            or not std::is_permutation(a.intros.begin(), a.intros.end(), b.intros.begin())
+            or a.supportedProtocols != b.supportedProtocols or a.SRVs != b.SRVs
+            or a.ownedRanges != b.ownedRanges or a.topic != b.topic;
+      }
+    }  // namespace
+
+    void
+    Endpoint::ScheduleIntrosetRegen()
+    {
+      if (m_IntrosetRegenDueAt == 0s)
+        m_IntrosetRegenDueAt = Now() + IntrosetRegenDebounce;
+    }
+
     void
     Endpoint::RegenAndPublishIntroSet()
     {
       const auto now = llarp::time_now_ms();
       m_LastIntrosetRegenAttempt = now;
-      std::set<Introduction, CompareIntroTimestamp> intros;
-      if (const auto maybe =
-              GetCurrentIntroductionsWithFilter([now](const service::Introduction& intro) -> bool {
-                return not intro.ExpiresSoon(now, path::intro_stale_threshold);
-              }))
-      {
-        intros.insert(maybe->begin(), maybe->end());
-      }
-      else
+      // publish the intros of our best paths, so that others reach us over the fastest ones
+      auto intros = GetIntroductionsByScore([now](const service::Introduction& intro) -> bool {
+        return not intro.ExpiresSoon(now, path::intro_stale_threshold);
+      });
+      if (intros.empty())
       {
         LogWarn(
             "could not publish descriptors for endpoint ",
@@ -150,6 +248,8 @@ namespace llarp
         if (quic->hasListeners())
           introSet().supportedProtocols.push_back(ProtocolType::QUIC);
       }
+      // we can always unpack batches, whether or not we send them
+      introSet().supportedProtocols.push_back(ProtocolType::Batch);
 
       introSet().intros.clear();
       for (auto& intro : intros)
@@ -164,13 +264,29 @@ namespace llarp
           ManualRebuild(1);
         return;
       }
-      auto maybe = m_Identity.EncryptAndSignIntroSet(introSet(), now);
-      if (not maybe)
+      // what we encrypted last is good to send again as is, as long as it says the same and has a
+      // while to go; if it was also stored fine, there is nothing to publish at all
+      const bool current = m_EncryptedIntroSet
+          and now + IntrosetRepublishMargin < m_EncryptedIntroSet->signedAt + path::default_lifetime
+          and not IntrosetMateriallyDiffers(m_EncryptedFrom, introSet());
+      if (current and m_state->m_LastPublish >= m_EncryptedIntroSet->signedAt)
       {
-        LogWarn("failed to generate introset for endpoint ", Name());
+        LogDebug(Name(), " introset unchanged, not republishing");
+        m_LastIntrosetUnchanged = now;
         return;
       }
-      if (PublishIntroSet(*maybe, Router()))
+      if (not current)
+      {
+        auto maybe = m_Identity.EncryptAndSignIntroSet(introSet(), now);
+        if (not maybe)
+        {
+          LogWarn("failed to generate introset for endpoint ", Name());
+          return;
+        }
+        m_EncryptedFrom = introSet();
+        m_EncryptedIntroSet = std::move(maybe);
+      }
+      if (PublishIntroSet(*m_EncryptedIntroSet, Router()))
       {
         LogInfo("(re)publishing introset for endpoint ", Name());
       }
@@ -390,6 +506,7 @@ namespace llarp
         authCodes[service.ToString()] = info.token;
       }
       obj["authCodes"] = authCodes;
+      obj["lnsCache"] = m_router->hiddenServiceContext().NameCache().ExtractStatus();
 
       return m_state->ExtractStatus(obj);
     }
@@ -400,28 +517,58 @@ namespace llarp
       const auto now = llarp::time_now_ms();
       path::Builder::Tick(now);
       // publish descriptors
-      if (ShouldPublishDescriptors(now))
+      if (m_IntrosetRegenDueAt > 0s and now >= m_IntrosetRegenDueAt)
+      {
+        m_IntrosetRegenDueAt = 0s;
+        RegenAndPublishIntroSet();
+      }
+      else if (ShouldPublishDescriptors(now))
       {
         RegenAndPublishIntroSet();
       }
       // decay introset lookup filter
       m_IntrosetLookupFilter.Decay(now);
-      // expire name cache
-      m_state->nameCache.Decay(now);
+      // look up the names we are asked for a lot before they expire
+      if (ReadyToDoLookup(GetUniqueEndpointsForLookup().size()))
+      {
+        for (auto& name : Router()->hiddenServiceContext().NameCache().TakePrefetches(now))
+          LookupNameFromNetwork(std::move(name), true, nullptr);
+      }
+      m_state->introsetLocations.Decay(now);
+      m_state->resolvedIntroSets.Decay(now);
+      m_state->lnsTracker.Decay(now);
+      for (auto itr = m_state->m_ChosenConvos.begin(); itr != m_state->m_ChosenConvos.end();)
+      {
+        if (itr->second.until <= now)
+          itr = m_state->m_ChosenConvos.erase(itr);
+        else
+          ++itr;
+      }
+      EndpointUtil::Reclaim_t reclaim;
       // expire snode sessions
-      EndpointUtil::ExpireSNodeSessions(now, m_state->m_SNodeSessions);
+      EndpointUtil::ExpireSNodeSessions(now, m_state->m_SNodeSessions, reclaim);
       // expire pending tx
-      EndpointUtil::ExpirePendingTx(now, m_state->m_PendingLookups);
+      EndpointUtil::ExpirePendingTx(now, m_state->m_LookupExpiry, m_state->m_PendingLookups);
+      // and make use of the lookup slots that freed up
+      StartQueuedIntrosetLookups(now);
       // expire pending router lookups
-      EndpointUtil::ExpirePendingRouterLookups(now, m_state->m_PendingRouters);
+      EndpointUtil::ExpirePendingRouterLookups(
+          now, m_state->m_RouterLookupExpiry, m_state->m_PendingRouters);
 
       // deregister dead sessions
-      EndpointUtil::DeregisterDeadSessions(now, m_state->m_DeadSessions);
+      EndpointUtil::DeregisterDeadSessions(now, m_state->m_DeadSessions, reclaim);
+      // what is left of them goes over the next few goes of the loop, so that a lot going at
+      // once (after a network blip, say) doesn't stall it
+      if (not reclaim.empty())
+        ReclaimSoon(Loop(), std::move(reclaim));
+      m_SharedPaths.Decay(now);
       // tick remote sessions
       EndpointUtil::TickRemoteSessions(
           now, m_state->m_RemoteSessions, m_state->m_DeadSessions, Sessions());
-      // expire convotags
-      EndpointUtil::ExpireConvoSessions(now, Sessions());
+      // expire convotags, and drop what we hold to reorder for those that are gone
+      const auto gone = EndpointUtil::ExpireConvoSessions(now, m_state->m_ConvoExpiry, Sessions());
+      for (const auto& tag : gone)
+        m_InboundReorder.erase(tag);
 
       if (NumInStatus(path::ePathEstablished) > 1)
       {
@@ -480,6 +627,7 @@ namespace llarp
     void
     Endpoint::PutLookup(IServiceLookup* lookup, uint64_t txid)
     {
+      m_state->m_LookupExpiry.Schedule(lookup->ExpiresAt(), txid);
       m_state->m_PendingLookups.emplace(txid, std::unique_ptr<IServiceLookup>(lookup));
     }
 
@@ -500,8 +648,8 @@ namespace llarp
       auto itr = lookups.find(msg->txid);
       if (itr == lookups.end())
       {
-        LogWarn(
-            "invalid lookup response for hidden service endpoint ", Name(), " txid=", msg->txid);
+        // including one we stopped waiting on once another relay answered
+        LogDebug("no pending lookup on ", Name(), " for response txid=", msg->txid);
         return true;
       }
       std::unique_ptr<IServiceLookup> lookup = std::move(itr->second);
@@ -513,9 +661,9 @@ namespace llarp
     bool
     Endpoint::HasInboundConvo(const Address& addr) const
     {
-      for (const auto& item : Sessions())
+      for (const auto& tag : Sessions().TagsFor(addr))
       {
-        if (item.second.remote.Addr() == addr and item.second.inbound)
+        if (auto itr = Sessions().find(tag); itr != Sessions().end() and itr->second.inbound)
           return true;
       }
       return false;
@@ -524,9 +672,9 @@ namespace llarp
     bool
     Endpoint::HasOutboundConvo(const Address& addr) const
     {
-      for (const auto& item : Sessions())
+      for (const auto& tag : Sessions().TagsFor(addr))
       {
-        if (item.second.remote.Addr() == addr && not item.second.inbound)
+        if (auto itr = Sessions().find(tag); itr != Sessions().end() and not itr->second.inbound)
           return true;
       }
       return false;
@@ -553,28 +701,30 @@ namespace llarp
               tag);
           return;
         }
-        itr = Sessions().emplace(tag, Session{}).first;
+        itr = EmplaceSession(tag);
         itr->second.inbound = inbound;
-        itr->second.remote = info;
+        Sessions().SetRemote(itr, info);
       }
     }
 
+    ConvoMap::iterator
+    Endpoint::EmplaceSession(const ConvoTag& tag)
+    {
+      auto [itr, inserted] = Sessions().emplace(tag, Session{});
+      // looked at on the next wheel tick, when it will have been set up
+      if (inserted)
+        m_state->m_ConvoExpiry.Schedule(Now(), tag);
+      return itr;
+    }
+
     size_t
     Endpoint::RemoveAllConvoTagsFor(service::Address remote)
     {
       size_t removed = 0;
-      auto& sessions = Sessions();
-      auto itr = sessions.begin();
-      while (itr != sessions.end())
-      {
-        if (itr->second.remote.Addr() == remote)
-        {
-          itr = sessions.erase(itr);
-          removed++;
-        }
-        else
-          ++itr;
-      }
+      // a copy, as erasing changes it
+      const auto tags = Sessions().TagsFor(remote);
+      for (const auto& tag : tags)
+        removed += Sessions().erase(tag);
       return removed;
     }
 
@@ -592,8 +742,7 @@ namespace llarp
     void
     Endpoint::PutIntroFor(const ConvoTag& tag, const Introduction& intro)
     {
-      auto& s = Sessions()[tag];
-      s.intro = intro;
+      EmplaceSession(tag)->second.intro = intro;
     }
 
     bool
@@ -614,6 +763,9 @@ namespace llarp
       {
         return;
       }
+      // they moved to another path, so our best way back to them may be another too
+      if (itr->second.replyIntro != intro)
+        ++m_PathGeneration;
       itr->second.replyIntro = intro;
     }
 
@@ -649,7 +801,7 @@ namespace llarp
       auto itr = Sessions().find(tag);
       if (itr == Sessions().end())
       {
-        itr = Sessions().emplace(tag, Session{}).first;
+        itr = EmplaceSession(tag);
       }
       itr->second.sharedKey = k;
     }
@@ -657,15 +809,15 @@ namespace llarp
     void
     Endpoint::ConvoTagTX(const ConvoTag& tag)
     {
-      if (Sessions().count(tag))
-        Sessions()[tag].TX();
+      if (auto itr = Sessions().find(tag); itr != Sessions().end())
+        itr->second.TX();
     }
 
     void
     Endpoint::ConvoTagRX(const ConvoTag& tag)
     {
-      if (Sessions().count(tag))
-        Sessions()[tag].RX();
+      if (auto itr = Sessions().find(tag); itr != Sessions().end())
+        itr->second.RX();
     }
 
     bool
@@ -849,7 +1001,8 @@ namespace llarp
       if (not m_PublishIntroSet)
         return false;
 
-      const auto lastEventAt = std::max(m_state->m_LastPublishAttempt, m_state->m_LastPublish);
+      const auto lastEventAt = std::max(
+          {m_state->m_LastPublishAttempt, m_state->m_LastPublish, m_LastIntrosetUnchanged});
       const auto next_pub = lastEventAt
           + (m_state->m_IntroSet.HasStaleIntros(now, path::intro_stale_threshold)
                  ? IntrosetPublishRetryCooldown
@@ -878,11 +1031,9 @@ namespace llarp
     {
       std::unordered_set<RouterID> exclude;
       ForEachPath([&exclude](auto path) { exclude.insert(path->Endpoint()); });
-      const auto maybe =
-          m_router->nodedb()->GetRandom([exclude, r = m_router](const auto& rc) -> bool {
-            return exclude.count(rc.pubkey) == 0
-                and not r->routerProfiling().IsBadForPath(rc.pubkey);
-          });
+      const auto maybe = SelectHop([exclude, r = m_router](const auto& rc) -> bool {
+        return exclude.count(rc.pubkey) == 0 and not r->routerProfiling().IsBadForPath(rc.pubkey);
+      });
       if (not maybe.has_value())
         return std::nullopt;
       return GetHopsForBuildWithEndpoint(maybe->pubkey);
@@ -902,6 +1053,20 @@ namespace llarp
 
     constexpr auto MaxOutboundContextPerRemote = 1;
 
+    dht::Key_t
+    Endpoint::IntrosetLocation(const Address& addr)
+    {
+      // the keys of services we keep talking to stay put, so they are derived once and not again
+      // each time the cache interval comes around
+      const auto now = Now();
+      auto& cache = m_state->introsetLocations;
+      if (auto maybe = cache.GetAndRefresh(addr, now))
+        return *maybe;
+      const auto location = addr.ToKey();
+      cache.Put(addr, location, now);
+      return location;
+    }
+
     void
     Endpoint::PutNewOutboundContext(const service::IntroSet& introset, llarp_time_t left)
     {
@@ -928,12 +1093,17 @@ namespace llarp
     {
       auto& pendingRouters = m_state->m_PendingRouters;
       auto itr = pendingRouters.find(id);
-      if (itr != pendingRouters.end())
+      if (itr == pendingRouters.end())
+        return;
+      if (valid)
       {
-        if (valid)
-          itr->second.InformResult(msg->foundRCs);
-        else
-          itr->second.InformResult({});
+        itr->second.InformResult(msg->foundRCs);
+        pendingRouters.erase(itr);
+      }
+      // a bad answer from one path doesn't mean the others won't have a good one
+      else if (itr->second.txids.erase(msg->txid) and itr->second.txids.empty())
+      {
+        itr->second.InformResult({});
         pendingRouters.erase(itr);
       }
     }
@@ -960,9 +1130,10 @@ namespace llarp
         auto itr = routers.begin();
         while (itr != routers.end())
         {
-          if (itr->second.txid == msg->txid)
+          auto& job = itr->second;
+          if (job.txids.erase(msg->txid) and job.txids.empty())
           {
-            itr->second.InformResult({});
+            job.InformResult({});
             itr = routers.erase(itr);
           }
           else
@@ -1057,13 +1228,28 @@ namespace llarp
         handler(ParseAddress(name));
         return;
       }
-      auto& cache = m_state->nameCache;
-      const auto maybe = cache.Get(name);
-      if (maybe.has_value())
+      auto& cache = Router()->hiddenServiceContext().NameCache();
+      const auto now = Now();
+      if (const auto hit = cache.Get(name, now))
       {
-        handler(maybe);
+        // past its ttl, so answer with what we had and find out if it still holds
+        if (hit->stale and cache.StartRefresh(name, now))
+          LookupNameFromNetwork(name, true, nullptr);
+        handler(hit->value);
         return;
       }
+      LookupNameFromNetwork(std::move(name), false, std::move(handler));
+    }
+
+    void
+    Endpoint::LookupNameFromNetwork(
+        std::string name,
+        bool refresh,
+        std::function<void(std::optional<std::variant<Address, RouterID>>)> handler)
+    {
+      // asked for again before the answer came
+      if (m_state->lnsTracker.Join(name, handler))
+        return;
       LogInfo(Name(), " looking up LNS name: ", name);
       auto paths = GetUniqueEndpointsForLookup();
       // not enough paths
@@ -1075,44 +1261,53 @@ namespace llarp
             paths.size(),
             " need ",
             MIN_ENDPOINTS_FOR_LNS_LOOKUP);
-        handler(std::nullopt);
+        if (handler)
+          handler(std::nullopt);
         return;
       }
 
-      auto maybeInvalidateCache = [handler, &cache, name](auto result) {
-        if (result)
-        {
-          var::visit(
-              [&result, &cache, name](auto&& value) {
-                if (value.IsZero())
-                {
-                  cache.Remove(name);
-                  result = std::nullopt;
-                }
-              },
-              *result);
-        }
-        if (result)
-        {
-          cache.Put(name, *result);
-        }
-        handler(result);
+      auto& cache = Router()->hiddenServiceContext().NameCache();
+      auto maybeInvalidateCache = [handler, &cache, name, refresh, this](auto result) {
+        // a refresh that comes up empty may just have timed out, so we keep serving what we had
+        // until it goes stale rather than forget a name that resolved
+        if (result or not refresh)
+          cache.Put(name, result, Now());
+        if (handler)
+          handler(result);
       };
 
       constexpr size_t max_lns_lookup_endpoints = 7;
-      // pick up to max_unique_lns_endpoints random paths to do lookups from
-      std::vector<path::Path_ptr> chosenpaths;
-      chosenpaths.insert(chosenpaths.begin(), paths.begin(), paths.end());
+      // pick up to max_unique_lns_endpoints paths to do lookups from, those whose endpoints
+      // answered us fastest before (or, if we haven't asked them, with the fastest paths) first,
+      // so that the quorum is in soonest; in random order among equals
+      auto& tracker = m_state->lnsTracker;
+      std::vector<std::pair<llarp_time_t, path::Path_ptr>> chosenpaths;
+      for (const auto& path : paths)
+        chosenpaths.emplace_back(
+            tracker.PathLatency(path->Endpoint()).value_or(path->intro.latency), path);
       std::shuffle(chosenpaths.begin(), chosenpaths.end(), CSRNG{});
+      std::stable_sort(
+          chosenpaths.begin(), chosenpaths.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+          });
       chosenpaths.resize(std::min(paths.size(), max_lns_lookup_endpoints));
 
       auto resultHandler =
-          m_state->lnsTracker.MakeResultHandler(name, chosenpaths.size(), maybeInvalidateCache);
+          tracker.MakeResultHandler(name, chosenpaths.size(), maybeInvalidateCache);
 
-      for (const auto& path : chosenpaths)
+      for (const auto& [latency, path] : chosenpaths)
       {
         LogInfo(Name(), " lookup ", name, " from ", path->Endpoint());
-        auto job = new LookupNameJob{this, GenTXID(), name, resultHandler};
+        // timeouts count too, and put the endpoint at the back for next time
+        auto job = new LookupNameJob{
+            this,
+            GenTXID(),
+            name,
+            [this, resultHandler, endpoint = path->Endpoint(), sentAt = Now()](auto result) {
+              const auto now = Now();
+              m_state->lnsTracker.ObservePath(endpoint, now - sentAt, now);
+              resultHandler(std::move(result));
+            }};
         job->SendRequestViaPath(path, m_router);
       }
     }
@@ -1150,37 +1345,44 @@ namespace llarp
       using llarp::dht::FindRouterMessage;
 
       auto& routers = m_state->m_PendingRouters;
-      if (routers.find(router) == routers.end())
+      if (routers.find(router) != routers.end())
+        return false;
+
+      RouterLookupJob job{this, [handler, router, nodedb = m_router->nodedb()](auto results) {
+                            if (results.empty())
+                            {
+                              LogInfo("could not find ", router, ", remove it from nodedb");
+                              nodedb->Remove(router);
+                            }
+                            if (handler)
+                              handler(results);
+                          }};
+
+      // alpha paths ending closest to it at once, each its own lookup; the first good answer
+      // wins, and we give up only once all of them have come up empty
+      const auto paths =
+          GetManyPathsWithUniqueEndpoints(this, m_LookupAlpha, dht::Key_t{router.as_array()});
+      for (const auto& path : paths)
       {
-        auto path = GetEstablishedPathClosestTo(router);
         routing::DHTMessage msg;
-        auto txid = GenTXID();
+        const auto txid = GenTXID();
         msg.M.emplace_back(std::make_unique<FindRouterMessage>(txid, router));
-        if (path)
-          msg.S = path->NextSeqNo();
-        if (path && path->SendRoutingMessage(msg, Router()))
-        {
-          RouterLookupJob job{this, [handler, router, nodedb = m_router->nodedb()](auto results) {
-                                if (results.empty())
-                                {
-                                  LogInfo("could not find ", router, ", remove it from nodedb");
-                                  nodedb->Remove(router);
-                                }
-                                if (handler)
-                                  handler(results);
-                              }};
-
-          assert(msg.M.size() == 1);
-          auto dhtMsg = dynamic_cast<FindRouterMessage*>(msg.M[0].get());
-          assert(dhtMsg != nullptr);
-
-          m_router->NotifyRouterEvent<tooling::FindRouterSentEvent>(m_router->pubkey(), *dhtMsg);
-
-          routers.emplace(router, std::move(job));
-          return true;
-        }
+        msg.S = path->NextSeqNo();
+        if (not path->SendRoutingMessage(msg, Router()))
+          continue;
+
+        assert(msg.M.size() == 1);
+        auto dhtMsg = dynamic_cast<FindRouterMessage*>(msg.M[0].get());
+        assert(dhtMsg != nullptr);
+
+        m_router->NotifyRouterEvent<tooling::FindRouterSentEvent>(m_router->pubkey(), *dhtMsg);
+        job.txids.insert(txid);
       }
-      return false;
+      if (job.txids.empty())
+        return false;
+      m_state->m_RouterLookupExpiry.Schedule(job.ExpiresAt(), router);
+      routers.emplace(router, std::move(job));
+      return true;
     }
 
     void
@@ -1190,6 +1392,7 @@ namespace llarp
       p->SetDropHandler(util::memFn(&Endpoint::HandleDataDrop, this));
       p->SetDeadChecker(util::memFn(&Endpoint::CheckPathIsDead, this));
       path::Builder::HandlePathBuilt(p);
+      ++m_PathGeneration;
     }
 
     bool
@@ -1215,6 +1418,43 @@ namespace llarp
       }
     }
 
+    void
+    Endpoint::QueueInboundFrame(InboundFrame frame)
+    {
+      m_InboundFrames.emplace_back(std::move(frame));
+      Router()->TriggerPump();
+    }
+
+    void
+    Endpoint::FlushInboundFrames()
+    {
+      if (m_InboundFrames.empty())
+        return;
+      // one hand off to a worker for everything since the last pump, which is what costs on busy
+      // flows, rather than one per frame
+      Router()->QueueWork(
+          [this, frames = std::exchange(m_InboundFrames, {})]() mutable {
+            for (auto& in : frames)
+            {
+              auto msg = std::make_shared<ProtocolMessage>();
+              msg->handler = this;
+              if (not in.frame.VerifyAndDecryptInPlace(in.sender, in.sessionKey, *msg))
+              {
+                Loop()->call_soon([this, tag = in.frame.T, from = in.frame.F, path = in.path]() {
+                  ResetConvoTag(tag, path, from);
+                });
+                continue;
+              }
+              if (in.hook)
+                Loop()->call([msg, hook = std::move(in.hook)]() { hook(msg); });
+              m_RecvQueue.tryPushBack(
+                  RecvDataEvent{std::move(in.path), in.frame.F, std::move(msg)});
+            }
+            Router()->TriggerPump();
+          },
+          thread::WorkClass::DataPlane);
+    }
+
     void
     Endpoint::QueueRecvData(RecvDataEvent ev)
     {
@@ -1416,7 +1656,7 @@ namespace llarp
         RemoveConvoTag(frame.T);
         return true;
       }
-      if (not frame.AsyncDecryptAndVerify(Router()->loop(), p, m_Identity, this))
+      if (not frame.AsyncDecryptAndVerify(p, this))
       {
         ResetConvoTag(frame.T, p, frame.F);
       }
@@ -1429,7 +1669,8 @@ namespace llarp
       m_router->routerProfiling().MarkPathTimeout(p.get());
       ManualRebuild(1);
       path::Builder::HandlePathDied(p);
-      RegenAndPublishIntroSet();
+      ScheduleIntrosetRegen();
+      ++m_PathGeneration;
     }
 
     bool
@@ -1449,7 +1690,6 @@ namespace llarp
       // tell all our existing remote sessions about this introset update
 
       const auto now = Router()->Now();
-      auto& lookups = m_state->m_PendingServiceLookups;
       if (introset)
       {
         auto& sessions = m_state->m_RemoteSessions;
@@ -1462,14 +1702,7 @@ namespace llarp
           if (itr->second->ReadyToSend() and not introset->IsExpired(now))
           {
             // inform all lookups
-            auto lookup_range = lookups.equal_range(addr);
-            auto i = lookup_range.first;
-            while (i != lookup_range.second)
-            {
-              i->second(addr, itr->second.get());
-              ++i;
-            }
-            lookups.erase(addr);
+            InformPathToService(addr, itr->second.get());
           }
           ++itr;
         }
@@ -1486,6 +1719,7 @@ namespace llarp
             " order=",
             relayOrder);
         fails[endpoint] = fails[endpoint] + 1;
+        ContinueIntrosetLookup(addr, endpoint);
 
         const auto pendingForAddr = std::count_if(
             m_state->m_PendingLookups.begin(),
@@ -1495,16 +1729,30 @@ namespace llarp
         // inform all if we have no more pending lookups for this address
         if (pendingForAddr == 0)
         {
-          auto range = lookups.equal_range(addr);
-          auto itr = range.first;
-          while (itr != range.second)
-          {
-            itr->second(addr, nullptr);
-            itr = lookups.erase(itr);
-          }
+          m_state->m_IntrosetLookups.erase(addr);
+          InformPathToService(addr, nullptr);
         }
         return false;
       }
+      // the first good answer is all we need, so stop waiting on the other relays
+      if (m_state->m_IntrosetLookups.erase(addr))
+      {
+        auto& pending = m_state->m_PendingLookups;
+        for (auto itr = pending.begin(); itr != pending.end();)
+        {
+          if (itr->second->IsFor(addr))
+            itr = pending.erase(itr);
+          else
+            ++itr;
+        }
+      }
+      auto& resolved = m_state->resolvedIntroSets;
+      if (auto cached = resolved.Get(addr); not cached or *cached < *introset)
+      {
+        resolved.Remove(addr);
+        resolved.Put(addr, *introset, now);
+      }
+
       // check for established outbound context
 
       if (m_state->m_RemoteSessions.count(addr) > 0)
@@ -1531,14 +1779,15 @@ namespace llarp
     Endpoint::InformPathToService(const Address remote, OutboundContext* ctx)
     {
       auto& serviceLookups = m_state->m_PendingServiceLookups;
-      auto range = serviceLookups.equal_range(remote);
-      auto itr = range.first;
-      while (itr != range.second)
-      {
-        itr->second(remote, ctx);
-        ++itr;
-      }
-      serviceLookups.erase(remote);
+      const auto range = serviceLookups.equal_range(remote);
+      std::vector<PathEnsureHook> hooks;
+      for (auto itr = range.first; itr != range.second; ++itr)
+        hooks.push_back(std::move(itr->second));
+      serviceLookups.erase(range.first, range.second);
+      // taken out first, as a hook may ensure a path to remote again and needs its own hook to
+      // stay in for that
+      for (const auto& hook : hooks)
+        hook(remote, ctx);
     }
 
     bool
@@ -1552,13 +1801,8 @@ namespace llarp
         return false;
       }
 
-      /// how many routers to use for lookups
-      static constexpr size_t NumParallelLookups = 2;
-      /// how many requests per router
-      static constexpr size_t RequestsPerLookup = 2;
-
       // add response hook to list for address.
-      m_state->m_PendingServiceLookups.emplace(remote, hook);
+      m_state->m_PendingServiceLookups.emplace(remote, std::move(hook));
 
       auto& sessions = m_state->m_RemoteSessions;
       {
@@ -1573,55 +1817,151 @@ namespace llarp
           }
           ++itr;
         }
+        // sessions still aligning paths will tell the hook once one of them is ready; we don't
+        // start over alongside them
+        if (range.first != range.second)
+        {
+          for (itr = range.first; itr != range.second; ++itr)
+          {
+            itr->second->AddReadyHook(
+                [remote, this](auto session) { InformPathToService(remote, session); },
+                timeout);
+          }
+          return true;
+        }
       }
+      // one we resolved a moment ago can go straight to a new session
+      if (sessions.count(remote) == 0)
+      {
+        if (auto cached = m_state->resolvedIntroSets.Get(remote);
+            cached and not cached->IsExpired(Now()))
+        {
+          LogDebug(Name(), " using recently resolved introset for ", remote);
+          PutNewOutboundContext(*cached, timeout);
+          return true;
+        }
+      }
+
+      // the lookup already under way, or waiting to be, will tell the hook
+      if (m_state->m_IntrosetLookups.count(remote))
+        return true;
+      auto& queued = m_state->m_QueuedIntrosetLookups;
+      if (std::any_of(queued.begin(), queued.end(), [&remote](const auto& item) {
+            return item.first == remote;
+          }))
+        return true;
+
       /// check replay filter
       if (not m_IntrosetLookupFilter.Insert(remote))
         return true;
 
-      const auto paths = GetManyPathsWithUniqueEndpoints(this, NumParallelLookups);
+      if (m_state->m_IntrosetLookups.size() >= m_MaxPendingLookups)
+      {
+        LogDebug(Name(), " has too many lookups under way, queueing the one for ", remote);
+        queued.emplace_back(remote, Now() + timeout);
+        return true;
+      }
+      return StartIntrosetLookup(remote, timeout);
+    }
 
-      using namespace std::placeholders;
-      const dht::Key_t location = remote.ToKey();
-      uint64_t order = 0;
+    bool
+    Endpoint::StartIntrosetLookup(const Address& remote, llarp_time_t timeout)
+    {
+      const auto paths = GetManyPathsWithUniqueEndpoints(this, m_LookupAlpha);
+      if (paths.empty())
+        return false;
 
-      // flag to only add callback to list of callbacks for
-      // address once.
-      bool hookAdded = false;
+      // the first alpha of the relays storing it all at once, through different paths where we
+      // have them; ContinueIntrosetLookup asks the rest as these come up empty
+      auto& lookup = m_state->m_IntrosetLookups[remote];
+      lookup.timeout = timeout;
+      bool sent = false;
+      auto path = paths.begin();
+      for (size_t n = 0; n < m_LookupAlpha; ++n)
+      {
+        if (SendIntrosetLookup(remote, *path, lookup.nextRelayOrder++, timeout))
+          sent = true;
+        if (++path == paths.end())
+          path = paths.begin();
+      }
+      if (not sent)
+        m_state->m_IntrosetLookups.erase(remote);
+      return sent;
+    }
 
-      for (const auto& path : paths)
+    void
+    Endpoint::StartQueuedIntrosetLookups(llarp_time_t now)
+    {
+      auto& queued = m_state->m_QueuedIntrosetLookups;
+      while (not queued.empty() and m_state->m_IntrosetLookups.size() < m_MaxPendingLookups)
       {
-        for (size_t count = 0; count < RequestsPerLookup; ++count)
-        {
-          HiddenServiceAddressLookup* job = new HiddenServiceAddressLookup(
-              this,
-              [this](auto addr, auto result, auto from, auto left, auto order) {
-                return OnLookup(addr, result, from, left, order);
-              },
-              location,
-              PubKey{remote.as_array()},
-              path->Endpoint(),
-              order,
-              GenTXID(),
-              timeout + (2 * path->intro.latency) + IntrosetLookupGraceInterval);
-          LogInfo(
-              "doing lookup for ",
-              remote,
-              " via ",
-              path->Endpoint(),
-              " at ",
-              location,
-              " order=",
-              order);
-          order++;
-          if (job->SendRequestViaPath(path, Router()))
-          {
-            hookAdded = true;
-          }
-          else
-            LogError(Name(), " send via path failed for lookup");
-        }
+        const auto [remote, deadline] = queued.front();
+        queued.pop_front();
+        // nobody waiting on it any more
+        if (m_state->m_PendingServiceLookups.count(remote) == 0)
+          continue;
+        if (deadline <= now or not StartIntrosetLookup(remote, deadline - now))
+          InformPathToService(remote, nullptr);
       }
-      return hookAdded;
+    }
+
+    bool
+    Endpoint::SendIntrosetLookup(
+        const Address& remote, path::Path_ptr path, uint64_t relayOrder, llarp_time_t timeout)
+    {
+      const dht::Key_t location = IntrosetLocation(remote);
+      // give up on the relay after a few of the path's round trips, and the request's hop on to
+      // the storing relay, rather than the whole timeout: the next relay gets asked if it does
+      const auto latency = path->intro.latency;
+      auto lookupTimeout = timeout + (2 * latency) + IntrosetLookupGraceInterval;
+      if (latency > 0s)
+        lookupTimeout = std::min(lookupTimeout, (4 * latency) + IntrosetLookupRelayInterval);
+      HiddenServiceAddressLookup* job = new HiddenServiceAddressLookup(
+          this,
+          [this](auto addr, auto result, auto from, auto left, auto order) {
+            return OnLookup(addr, result, from, left, order);
+          },
+          location,
+          PubKey{remote.as_array()},
+          path->Endpoint(),
+          relayOrder,
+          GenTXID(),
+          lookupTimeout);
+      LogInfo(
+          "doing lookup for ",
+          remote,
+          " via ",
+          path->Endpoint(),
+          " at ",
+          location,
+          " order=",
+          relayOrder);
+      if (job->SendRequestViaPath(path, Router()))
+        return true;
+      LogError(Name(), " send via path failed for lookup");
+      return false;
+    }
+
+    bool
+    Endpoint::ContinueIntrosetLookup(const Address& addr, const RouterID& endpoint)
+    {
+      auto itr = m_state->m_IntrosetLookups.find(addr);
+      if (itr == m_state->m_IntrosetLookups.end())
+        return false;
+      auto& lookup = itr->second;
+      const RouterID location{IntrosetLocation(addr).as_array()};
+      while (lookup.nextRelayOrder < dht::IntroSetStorageRedundancy)
+      {
+        // through some other path than the one that just came up empty, if we have one
+        auto path = GetEstablishedPathClosestTo(location, {endpoint});
+        if (not path)
+          path = GetEstablishedPathClosestTo(location);
+        if (not path)
+          return false;
+        if (SendIntrosetLookup(addr, path, lookup.nextRelayOrder++, lookup.timeout))
+          return true;
+      }
+      return false;
     }
 
     void
@@ -1632,7 +1972,7 @@ namespace llarp
       for (const auto& srv : SRVRecords())
         introset.SRVs.emplace_back(srv.toTuple());
 
-      RegenAndPublishIntroSet();
+      ScheduleIntrosetRegen();
     }
 
     bool
@@ -1727,6 +2067,29 @@ namespace llarp
       return false;
     }
 
+    bool
+    Endpoint::SendBatchToOrQueue(
+        ConvoTag tag, const std::vector<llarp_buffer_t>& payloads, ProtocolType t)
+    {
+      const auto maybe = GetEndpointWithConvoTag(tag);
+      const auto* addr = maybe ? std::get_if<Address>(&*maybe) : nullptr;
+      // inbound convos and ourselves send frame by frame, as SendToOrQueue would
+      if (addr and *addr != m_Identity.pub.Addr() and not HasInboundConvo(*addr))
+      {
+        auto range = m_state->m_RemoteSessions.equal_range(*addr);
+        for (auto itr = range.first; itr != range.second; ++itr)
+        {
+          if (itr->second->ReadyToSend())
+          {
+            LogDebug(Name(), " send batch of ", payloads.size(), " on T=", tag);
+            itr->second->AsyncEncryptAndSendTo(payloads, t);
+            return true;
+          }
+        }
+      }
+      return EndpointBase::SendBatchToOrQueue(tag, payloads, t);
+    }
+
     bool
     Endpoint::SendToOrQueue(const RouterID& addr, const llarp_buffer_t& buf, ProtocolType t)
     {
@@ -1745,41 +2108,120 @@ namespace llarp
       return true;
     }
 
+    /// how long multipath holds inbound traffic back waiting for a gap to fill; a bit more than
+    /// the spread in rtt between our paths, less than anything an application would notice
+    static constexpr auto MultipathReorderHold = 50ms;
+
+    void
+    Endpoint::DeliverInbound(const ProtocolMessage& msg)
+    {
+      LogDebug(
+          Name(),
+          " handle inbound packet on ",
+          msg.tag,
+          " ",
+          msg.payload.size(),
+          " bytes seqno=",
+          msg.seqno);
+      if (HandleInboundPacket(msg.tag, msg.payload, msg.proto, msg.seqno))
+      {
+        ConvoTagRX(msg.tag);
+      }
+      else
+      {
+        LogWarn("Failed to handle inbound message");
+      }
+    }
+
+    void
+    Endpoint::ReorderInbound(ProtocolMessagePtr msg, llarp_time_t now)
+    {
+      auto& reorder = m_InboundReorder[msg->tag];
+      if (not reorder.started)
+      {
+        reorder.started = true;
+        reorder.next = msg->seqno;
+      }
+      // anything we already gave up waiting for goes straight through; late beats lost
+      if (msg->seqno < reorder.next)
+      {
+        DeliverInbound(*msg);
+        return;
+      }
+      // and so does what is next with nothing waiting behind it
+      if (msg->seqno == reorder.next and reorder.held.Empty())
+      {
+        DeliverInbound(*msg);
+        ++reorder.next;
+        return;
+      }
+      const auto seqno = msg->seqno;
+      // too far past the gap to hold on to: stop waiting for it
+      while (not reorder.held.Emplace(seqno, std::move(msg), now).first)
+      {
+        reorder.next = *reorder.held.First();
+        DeliverHeldInbound(reorder);
+      }
+      DeliverHeldInbound(reorder);
+    }
+
+    void
+    Endpoint::DeliverHeldInbound(InboundReorder& reorder)
+    {
+      while (auto held = reorder.held.Take(reorder.next))
+      {
+        DeliverInbound(*held->first);
+        ++reorder.next;
+      }
+    }
+
+    void
+    Endpoint::ReleaseHeldInbound(llarp_time_t now)
+    {
+      for (auto& [tag, reorder] : m_InboundReorder)
+      {
+        // skip a gap once the frame after it has waited long enough, then deliver the run
+        // behind it
+        while (const auto first = reorder.held.First())
+        {
+          if (now - reorder.held.Find(*first)->second < MultipathReorderHold)
+            break;
+          reorder.next = *first;
+          DeliverHeldInbound(reorder);
+        }
+      }
+    }
+
     void
     Endpoint::Pump(llarp_time_t now)
     {
+      FlushInboundFrames();
       FlushRecvData();
       // send downstream packets to user for snode
       for (const auto& [router, session] : m_state->m_SNodeSessions)
         session->FlushDownstream();
 
-      // handle inbound traffic sorted
-      util::ascending_priority_queue<ProtocolMessage> queue;
-      while (not m_InboundTrafficQueue.empty())
+      if (m_Multipath)
       {
-        // succ it out
-        queue.emplace(std::move(*m_InboundTrafficQueue.popFront()));
+        // frames of one convo come in over several paths, so put them back in order across pumps
+        while (not m_InboundTrafficQueue.empty())
+          ReorderInbound(m_InboundTrafficQueue.popFront(), now);
+        ReleaseHeldInbound(now);
       }
-      while (not queue.empty())
+      else
       {
-        const auto& msg = queue.top();
-        LogDebug(
-            Name(),
-            " handle inbound packet on ",
-            msg.tag,
-            " ",
-            msg.payload.size(),
-            " bytes seqno=",
-            msg.seqno);
-        if (HandleInboundPacket(msg.tag, msg.payload, msg.proto, msg.seqno))
+        // handle inbound traffic sorted
+        util::ascending_priority_queue<ProtocolMessage> queue;
+        while (not m_InboundTrafficQueue.empty())
         {
-          ConvoTagRX(msg.tag);
+          // succ it out
+          queue.emplace(std::move(*m_InboundTrafficQueue.popFront()));
         }
-        else
+        while (not queue.empty())
         {
-          LogWarn("Failed to handle inbound message");
+          DeliverInbound(queue.top());
+          queue.pop();
         }
-        queue.pop();
       }
 
       auto router = Router();
@@ -1806,64 +2248,97 @@ namespace llarp
     }
 
     std::optional<ConvoTag>
-    Endpoint::GetBestConvoTagFor(std::variant<Address, RouterID> remote) const
+    Endpoint::ChooseBestConvoTagFor(const Address& remote) const
     {
       // get convotag with lowest estimated RTT
-      if (auto ptr = std::get_if<Address>(&remote))
-      {
-        llarp_time_t rtt = 30s;
-        std::optional<ConvoTag> ret = std::nullopt;
-        for (const auto& [tag, session] : Sessions())
+      llarp_time_t rtt = 30s;
+      std::optional<ConvoTag> ret = std::nullopt;
+      for (const auto& tag : Sessions().TagsFor(remote))
+      {
+        if (tag.IsZero())
+          continue;
+        const auto found = Sessions().find(tag);
+        if (found == Sessions().end())
+          continue;
+        const auto& session = found->second;
+        if (remote == m_Identity.pub.Addr())
         {
-          if (tag.IsZero())
+          return tag;
+        }
+        if (session.inbound)
+        {
+          auto path = GetPathByRouter(session.replyIntro.router);
+          // if we have no path to the remote router that's fine still use it just in case this
+          // is the ONLY one we have
+          if (path == nullptr)
+          {
+            ret = tag;
             continue;
-          if (session.remote.Addr() == *ptr)
+          }
+
+          if (path and path->IsReady())
           {
-            if (*ptr == m_Identity.pub.Addr())
+            const auto rttEstimate = (session.replyIntro.latency + path->intro.latency) * 2;
+            if (rttEstimate < rtt)
             {
-              return tag;
+              ret = tag;
+              rtt = rttEstimate;
             }
-            if (session.inbound)
+          }
+        }
+        else
+        {
+          auto range = m_state->m_RemoteSessions.equal_range(remote);
+          auto itr = range.first;
+          while (itr != range.second)
+          {
+            if (itr->second->ReadyToSend() and itr->second->estimatedRTT > 0s)
             {
-              auto path = GetPathByRouter(session.replyIntro.router);
-              // if we have no path to the remote router that's fine still use it just in case this
-              // is the ONLY one we have
-              if (path == nullptr)
+              if (itr->second->estimatedRTT < rtt)
               {
                 ret = tag;
-                continue;
-              }
-
-              if (path and path->IsReady())
-              {
-                const auto rttEstimate = (session.replyIntro.latency + path->intro.latency) * 2;
-                if (rttEstimate < rtt)
-                {
-                  ret = tag;
-                  rtt = rttEstimate;
-                }
-              }
-            }
-            else
-            {
-              auto range = m_state->m_RemoteSessions.equal_range(*ptr);
-              auto itr = range.first;
-              while (itr != range.second)
-              {
-                if (itr->second->ReadyToSend() and itr->second->estimatedRTT > 0s)
-                {
-                  if (itr->second->estimatedRTT < rtt)
-                  {
-                    ret = tag;
-                    rtt = itr->second->estimatedRTT;
-                  }
-                }
-                itr++;
+                rtt = itr->second->estimatedRTT;
               }
             }
+            itr++;
           }
         }
-        return ret;
+      }
+      return ret;
+    }
+
+    path::Path_ptr
+    Endpoint::GetSendPathFor(Session& session)
+    {
+      if (session.sendPathGeneration == m_PathGeneration)
+      {
+        if (auto path = session.sendPath.lock(); path and path->IsReady())
+          return path;
+      }
+      auto path = GetPathByRouter(session.replyIntro.router);
+      session.sendPath = path;
+      session.sendPathGeneration = m_PathGeneration;
+      return path;
+    }
+
+    std::optional<ConvoTag>
+    Endpoint::GetBestConvoTagFor(std::variant<Address, RouterID> remote) const
+    {
+      if (auto ptr = std::get_if<Address>(&remote))
+      {
+        // chosen for every packet we send, so we go with what we chose last time while our paths
+        // and their intros stay as they were, and not for long even then
+        const auto now = Now();
+        auto& chosen = m_state->m_ChosenConvos;
+        if (auto itr = chosen.find(*ptr); itr != chosen.end() and now < itr->second.until
+            and itr->second.generation == m_PathGeneration and Sessions().count(itr->second.tag))
+          return itr->second.tag;
+        const auto best = ChooseBestConvoTagFor(*ptr);
+        if (best)
+          chosen[*ptr] = {*best, m_PathGeneration, now + ChosenConvoLifetime};
+        else
+          chosen.erase(*ptr);
+        return best;
       }
       if (auto* ptr = std::get_if<RouterID>(&remote))
       {
@@ -1894,8 +2369,8 @@ namespace llarp
             tag.Randomize();
           PutSenderFor(tag, m_Identity.pub, true);
           ConvoTagTX(tag);
-          Sessions()[tag].forever = true;
-          Loop()->call_soon([tag, hook]() { hook(tag); });
+          EmplaceSession(tag)->second.forever = true;
+          Loop()->call_soon([tag, hook = std::move(hook)]() { hook(tag); });
           return true;
         }
         if (not WantsOutboundSession(*ptr))
@@ -1907,7 +2382,7 @@ namespace llarp
 
         return EnsurePathToService(
             *ptr,
-            [hook](auto, auto* ctx) {
+            [hook = std::move(hook)](auto, auto* ctx) {
               if (ctx)
               {
                 hook(ctx->currentConvoTag);
@@ -1921,7 +2396,7 @@ namespace llarp
       }
       if (auto ptr = std::get_if<RouterID>(&addr))
       {
-        return EnsurePathToSNode(*ptr, [hook](auto, auto session, auto tag) {
+        return EnsurePathToSNode(*ptr, [hook = std::move(hook)](auto, auto session, auto tag) {
           if (session)
           {
             hook(tag);
@@ -1951,26 +2426,20 @@ namespace llarp
         auto transfer = std::make_shared<routing::PathTransferMessage>();
         ProtocolFrame& f = transfer->T;
         f.R = 0;
-        std::shared_ptr<path::Path> p;
         if (const auto maybe = GetBestConvoTagFor(remote))
         {
-          // the remote guy's intro
-          Introduction replyIntro;
-          SharedSecret K;
           const auto tag = *maybe;
-
-          if (not GetCachedSessionKeyFor(tag, K))
+          auto itr = Sessions().find(tag);
+          if (itr == Sessions().end())
           {
-            LogError(Name(), " no cached key for inbound session from ", remote, " T=", tag);
+            LogError(Name(), " no session for inbound convo from ", remote, " T=", tag);
             return false;
           }
-          if (not GetReplyIntroFor(tag, replyIntro))
-          {
-            LogError(Name(), "no reply intro for inbound session from ", remote, " T=", tag);
-            return false;
-          }
-          // get path for intro
-          auto p = GetPathByRouter(replyIntro.router);
+          auto& session = itr->second;
+          // the remote guy's intro
+          const auto& replyIntro = session.replyIntro;
+          const SharedSecret K = session.sharedKey;
+          auto p = GetSendPathFor(session);
 
           if (not p)
           {
@@ -1994,27 +2463,21 @@ namespace llarp
           m->proto = t;
           m->introReply = p->intro;
           m->sender = m_Identity.pub;
-          if (auto maybe = GetSeqNoForConvo(f.T))
-          {
-            m->seqno = *maybe;
-          }
-          else
-          {
-            LogWarn(Name(), " could not set sequence number, no session T=", f.T);
-            return false;
-          }
+          m->seqno = session.seqno++;
           f.S = m->seqno;
           f.F = p->intro.pathID;
           transfer->P = replyIntro.pathID;
-          Router()->QueueWork([transfer, p, m, K, this]() {
-            if (not transfer->T.EncryptAndSign(*m, K, m_Identity))
-            {
-              LogError("failed to encrypt and sign for sessionn T=", transfer->T.T);
-              return;
-            }
-            m_SendQueue.tryPushBack(SendEvent_t{transfer, p});
-            Router()->TriggerPump();
-          });
+          Router()->QueueWork(
+              [transfer, p, m, K, this]() {
+                if (not transfer->T.EncryptAndSign(*m, K, m_Identity))
+                {
+                  LogError("failed to encrypt and sign for sessionn T=", transfer->T.T);
+                  return;
+                }
+                m_SendQueue.tryPushBack(SendEvent_t{transfer, p});
+                Router()->TriggerPump();
+              },
+              thread::WorkClass::DataPlane);
           return true;
         }
         else
@@ -2051,14 +2514,14 @@ namespace llarp
       }
       LogTrace("Making an outbound session and queuing the data");
       // add pending traffic
-      auto& traffic = m_state->m_PendingTraffic;
-      traffic[remote].emplace_back(data, t);
+      if (not m_state->m_PendingTraffic.Push(remote, data, t))
+        LogWarn(Name(), " dropping ", data.sz, " byte packet to ", remote, ": too big to queue");
       EnsurePathToService(
           remote,
           [this](Address addr, OutboundContext* ctx) {
             if (ctx)
             {
-              for (auto& pending : m_state->m_PendingTraffic[addr])
+              for (auto& pending : m_state->m_PendingTraffic.Take(addr))
               {
                 ctx->AsyncEncryptAndSendTo(pending.Buffer(), pending.protocol);
               }
@@ -2066,8 +2529,8 @@ namespace llarp
             else
             {
               LogWarn("no path made to ", addr);
+              m_state->m_PendingTraffic.Drop(addr);
             }
-            m_state->m_PendingTraffic.erase(addr);
           },
           PathAlignmentTimeout());
       return true;
@@ -7,6 +7,7 @@
 #include <llarp/path/path.hpp>
 #include <llarp/path/pathbuilder.hpp>
 #include <llarp/util/compare_ptr.hpp>
+#include <llarp/util/sequence_window.hpp>
 
 // --- begin kitchen sink headers ----
 #include <llarp/service/address.hpp>
@@ -17,12 +18,14 @@
 #include <llarp/service/sendcontext.hpp>
 #include <llarp/service/protocol_type.hpp>
 #include <llarp/service/session.hpp>
+#include <llarp/service/shared_paths.hpp>
 #include <llarp/service/lookup.hpp>
 #include <llarp/service/endpoint_types.hpp>
 #include <llarp/endpoint_base.hpp>
 #include <llarp/service/auth.hpp>
 // ----- end kitchen sink headers -----
 
+#include <map>
 #include <optional>
 #include <unordered_map>
 #include <variant>
@@ -56,12 +59,24 @@ namespace llarp
     /// how agressively should we retry publishing introset on failure
     inline constexpr auto IntrosetPublishRetryCooldown = 1s;
 
+    /// how long we wait after a path dies or our records change before we regenerate our introset,
+    /// so that a burst of them makes one publish
+    inline constexpr auto IntrosetRegenDebounce = 2s;
+
+    /// how long before the introset we published expires that we sign a new one even if nothing
+    /// in it changed
+    inline constexpr auto IntrosetRepublishMargin = path::default_lifetime / 2;
+
     /// how aggressively should we retry looking up introsets
     inline constexpr auto IntrosetLookupCooldown = 250ms;
 
     /// number of unique snodes we want to talk to do to ons lookups
     inline constexpr size_t MIN_ENDPOINTS_FOR_LNS_LOOKUP = 2;
 
+    /// how long the convo we chose to send to a remote on stands with nothing else changed, as
+    /// the round trips we chose it by move
+    inline constexpr auto ChosenConvoLifetime = 1s;
+
     struct Endpoint : public path::Builder,
                       public ILookupHolder,
                       public IDataHandler,
@@ -96,6 +111,12 @@ namespace llarp
       virtual bool
       Configure(const NetworkConfig& conf, const DnsConfig& dnsConf);
 
+      /// apply what changed from the config we were configured with, was, to a reloaded one,
+      /// keeping the paths and sessions we have: how many paths we build and how long, lookups,
+      /// and the exit map and its auths.  paths already built keep the hops they were built with.
+      virtual void
+      Reconfigure(const NetworkConfig& was, const NetworkConfig& conf, const DnsConfig& dnsConf);
+
       void
       Tick(llarp_time_t now) override;
 
@@ -149,6 +170,14 @@ namespace llarp
       AbstractRouter*
       Router();
 
+      /// the aligned paths our outbound contexts built, for our others to the same routers to
+      /// share
+      SharedPaths<OutboundContext>&
+      OutboundPaths()
+      {
+        return m_SharedPaths;
+      }
+
       virtual bool
       LoadKeyFile();
 
@@ -258,6 +287,14 @@ namespace llarp
           std::function<void(std::optional<std::variant<Address, RouterID>>)> resultHandler)
           override;
 
+      /// look name up from the network and cache what we get.  refresh is for a name we have
+      /// cached, whose entry we keep if the lookup comes up empty.  handler may be null.
+      void
+      LookupNameFromNetwork(
+          std::string name,
+          bool refresh,
+          std::function<void(std::optional<std::variant<Address, RouterID>>)> handler);
+
       void
       LookupServiceAsync(
           std::string name,
@@ -306,8 +343,6 @@ namespace llarp
       bool
       CheckPathIsDead(path::Path_ptr p, llarp_time_t latency);
 
-      using PendingBufferQueue = std::deque<PendingBuffer>;
-
       size_t
       RemoveAllConvoTagsFor(service::Address remote);
 
@@ -426,6 +461,11 @@ namespace llarp
       void
       PutNewOutboundContext(const IntroSet& introset, llarp_time_t timeLeftToAlign);
 
+      /// where in the dht the introset for addr lives (Address::ToKey), remembered for a while
+      /// so that repeated lookups of and sessions to the same address don't redo the derivation
+      dht::Key_t
+      IntrosetLocation(const Address& addr);
+
       std::optional<uint64_t>
       GetSeqNoForConvo(const ConvoTag& tag);
 
@@ -471,6 +511,12 @@ namespace llarp
       bool
       SendToOrQueue(ConvoTag tag, const llarp_buffer_t& payload, ProtocolType t) override;
 
+      // Sends on the outbound session for the ConvoTag, if it is one of ours, so that the
+      // payloads can share frames; otherwise sends each as SendToOrQueue would.
+      bool
+      SendBatchToOrQueue(
+          ConvoTag tag, const std::vector<llarp_buffer_t>& payloads, ProtocolType t) override;
+
       // Send a to (or queues for sending) to either an address or router id
       bool
       SendToOrQueue(
@@ -504,6 +550,10 @@ namespace llarp
       void
       RegenAndPublishIntroSet();
 
+      /// regenerate our introset soon, along with anything else that asks in the meantime
+      void
+      ScheduleIntrosetRegen();
+
       IServiceLookup*
       GenerateLookupByTag(const Tag& tag);
 
@@ -522,6 +572,24 @@ namespace llarp
           llarp_time_t timeLeft,
           uint64_t relayOrder);
 
+      /// look up remote's introset through the first m_LookupAlpha relays storing it at once
+      bool
+      StartIntrosetLookup(const Address& remote, llarp_time_t timeout);
+
+      /// start the queued lookups there is room for, as lookups under way finish
+      void
+      StartQueuedIntrosetLookups(llarp_time_t now);
+
+      /// ask the relay at relayOrder among those storing remote's introset, through path
+      bool
+      SendIntrosetLookup(
+          const Address& remote, path::Path_ptr path, uint64_t relayOrder, llarp_time_t timeout);
+
+      /// ask the next relay storing addr's introset, if there is one left to ask, after the one
+      /// we asked through endpoint came up empty
+      bool
+      ContinueIntrosetLookup(const Address& addr, const RouterID& endpoint);
+
       bool
       DoNetworkIsolation(bool failed);
 
@@ -543,6 +611,43 @@ namespace llarp
       bool
       ReadyForNetwork() const;
 
+      /// return true if we stripe each session's traffic over all our paths to the remote's intro
+      /// router, and put inbound traffic back in order to make up for it
+      bool
+      MultipathEnabled() const
+      {
+        return m_Multipath;
+      }
+
+      /// return true if we pack small packets sent close together on a session into one frame
+      bool
+      CoalesceFramesEnabled() const
+      {
+        return m_CoalesceFrames;
+      }
+
+      /// a frame on an established convo waiting to be verified and decrypted, along with the
+      /// rest that come in before the next pump
+      struct InboundFrame
+      {
+        path::Path_ptr path;
+        ProtocolFrame frame;
+        SharedSecret sessionKey;
+        ServiceInfo sender;
+        /// called on the logic thread with what it decrypts to, if set
+        std::function<void(std::shared_ptr<ProtocolMessage>)> hook;
+      };
+
+      void
+      QueueInboundFrame(InboundFrame frame);
+
+      /// where intro frames from remotes starting convos with us wait on their key exchange
+      KeyExchangeStage&
+      KeyExchanges()
+      {
+        return m_KeyExchanges;
+      }
+
      protected:
       bool
       ReadyToDoLookup(size_t num_paths) const;
@@ -568,7 +673,69 @@ namespace llarp
       SendMessageQueue_t m_SendQueue;
 
      private:
+      SharedPaths<OutboundContext> m_SharedPaths;
       llarp_time_t m_LastIntrosetRegenAttempt = 0s;
+      /// when a regen we put off with ScheduleIntrosetRegen is due, or 0s if there is none
+      llarp_time_t m_IntrosetRegenDueAt = 0s;
+      /// bumped when one of our paths is built or dies, or a remote moves to another intro, so
+      /// that what we chose to send on before gets chosen again
+      uint64_t m_PathGeneration = 1;
+
+      /// GetBestConvoTagFor without the cache
+      std::optional<ConvoTag>
+      ChooseBestConvoTagFor(const Address& remote) const;
+
+      /// the path to send an inbound session's traffic back on, to its reply intro's router, as
+      /// chosen last time if nothing changed since
+      path::Path_ptr
+      GetSendPathFor(Session& session);
+      /// when we last found our introset unchanged and had nothing to publish
+      llarp_time_t m_LastIntrosetUnchanged = 0s;
+      /// the introset we last encrypted, and what we encrypted it into, which we publish again
+      /// while it is current rather than sign a new one
+      IntroSet m_EncryptedFrom;
+      std::optional<EncryptedIntroSet> m_EncryptedIntroSet;
+      bool m_Multipath = false;
+      bool m_CoalesceFrames = false;
+      KeyExchangeStage m_KeyExchanges{this};
+      /// frames of established convos since the last pump, gone through in one batch
+      std::vector<InboundFrame> m_InboundFrames;
+
+      void
+      FlushInboundFrames();
+
+      /// inbound traffic of one convo waiting for a gap in its sequence numbers to be filled
+      struct InboundReorder
+      {
+        /// how far past a gap we hold traffic before we stop waiting for it
+        static constexpr size_t MaxHeld = 256;
+
+        uint64_t next = 0;
+        bool started = false;
+        /// in a ring by seqno, with when it arrived
+        util::SequenceWindow<std::pair<ProtocolMessagePtr, llarp_time_t>> held{MaxHeld};
+      };
+      std::unordered_map<ConvoTag, InboundReorder> m_InboundReorder;
+
+      /// the session under tag, creating it and scheduling its expiry if there isn't one
+      ConvoMap::iterator
+      EmplaceSession(const ConvoTag& tag);
+
+      /// hand inbound traffic to HandleInboundPacket
+      void
+      DeliverInbound(const ProtocolMessage& msg);
+
+      /// hold msg in its convo's reorder buffer, delivering whatever that puts in order
+      void
+      ReorderInbound(ProtocolMessagePtr msg, llarp_time_t now);
+
+      /// deliver what reorder holds from its next seqno on, up to the next gap
+      void
+      DeliverHeldInbound(InboundReorder& reorder);
+
+      /// give up waiting on gaps that have been open too long
+      void
+      ReleaseHeldInbound(llarp_time_t now);
 
      protected:
       void
@@ -580,7 +747,6 @@ namespace llarp
       const IntroSet& introSet() const;
       IntroSet&       introSet();
 
-      using ConvoMap = std::unordered_map<ConvoTag, Session>;
       const ConvoMap& Sessions() const;
       ConvoMap&       Sessions();
       // clang-format on
@@ -588,6 +754,10 @@ namespace llarp
 
       /// for rate limiting introset lookups
       util::DecayingHashSet<Address> m_IntrosetLookupFilter;
+      /// how many relays we ask at once in a lookup, [network]:lookup-alpha
+      size_t m_LookupAlpha = 3;
+      /// how many introset lookups we have under way at once, [network]:max-pending-lookups
+      size_t m_MaxPendingLookups = 32;
     };
 
     using Endpoint_ptr = std::shared_ptr<Endpoint>;
@@ -66,6 +66,7 @@ namespace llarp
       }
 
       obj["converstations"] = sessionObj;
+      obj["pendingTraffic"] = m_PendingTraffic.ExtractStatus();
       return obj;
     }
   }  // namespace service
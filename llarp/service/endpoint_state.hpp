@@ -6,9 +6,11 @@
 #include "router_lookup_job.hpp"
 #include "session.hpp"
 #include "endpoint_types.hpp"
+#include "intro_set.hpp"
 #include <llarp/util/compare_ptr.hpp>
 #include <llarp/util/decaying_hashtable.hpp>
 #include <llarp/util/status.hpp>
+#include <llarp/util/timer_wheel.hpp>
 #include "lns_tracker.hpp"
 
 #include <memory>
@@ -22,6 +24,15 @@ namespace llarp
 {
   namespace service
   {
+    /// an introset lookup under way, asking the relays storing the introset in relay order
+    struct IntrosetLookupProgress
+    {
+      /// the relay order to ask next once one we asked comes up empty
+      uint64_t nextRelayOrder = 0;
+      /// the timeout the lookup was started with
+      llarp_time_t timeout = 0s;
+    };
+
     struct EndpointState
     {
       std::set<RouterID> m_SnodeBlacklist;
@@ -54,19 +65,43 @@ namespace llarp
       IntroSet m_IntroSet;
       /// pending remote service lookups by id
       PendingLookups m_PendingLookups;
+      /// by the address they are for
+      std::unordered_map<Address, IntrosetLookupProgress> m_IntrosetLookups;
+      /// addresses waiting on a free lookup slot, with when their sessions give up on them
+      std::deque<std::pair<Address, llarp_time_t>> m_QueuedIntrosetLookups;
       /// on initialize functions
       std::list<std::function<bool(void)>> m_OnInit;
 
       /// conversations
       ConvoMap m_Sessions;
 
+      /// when to look again at each pending lookup, pending router lookup and convo, so that
+      /// expiring them costs nothing for the ones not yet due
+      util::TimerWheel<uint64_t> m_LookupExpiry{1s};
+      util::TimerWheel<RouterID> m_RouterLookupExpiry{1s};
+      util::TimerWheel<ConvoTag> m_ConvoExpiry{1s};
+
       OutboundSessions_t m_OutboundSessions;
 
-      util::DecayingHashTable<std::string, std::variant<Address, RouterID>, std::hash<std::string>>
-          nameCache;
+      /// Endpoint::IntrosetLocation's blinded keys by address
+      util::DecayingHashTable<Address, dht::Key_t> introsetLocations;
+
+      /// introsets we looked up lately, so that going back to a service soon after needs no
+      /// lookup
+      util::DecayingHashTable<Address, IntroSet> resolvedIntroSets{5min};
 
       LNSLookupTracker lnsTracker;
 
+      /// the convo GetBestConvoTagFor last chose for each remote address: with the endpoint's
+      /// path generation then, and when to choose again regardless
+      struct ChosenConvo
+      {
+        ConvoTag tag;
+        uint64_t generation;
+        llarp_time_t until;
+      };
+      std::unordered_map<Address, ChosenConvo> m_ChosenConvos;
+
       bool
       Configure(const NetworkConfig& conf);
 
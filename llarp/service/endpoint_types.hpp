@@ -1,5 +1,6 @@
 #pragma once
 
+#include "convo_map.hpp"
 #include "pendingbuffer.hpp"
 #include "router_lookup_job.hpp"
 #include "session.hpp"
@@ -29,9 +30,6 @@ namespace llarp
     using SendEvent_t = std::pair<Msg_ptr, path::Path_ptr>;
     using SendMessageQueue_t = thread::Queue<SendEvent_t>;
 
-    using PendingBufferQueue = std::deque<PendingBuffer>;
-    using PendingTraffic = std::unordered_map<Address, PendingBufferQueue>;
-
     using ProtocolMessagePtr = std::shared_ptr<ProtocolMessage>;
     using RecvPacketQueue_t = thread::Queue<ProtocolMessagePtr>;
 
@@ -43,14 +41,10 @@ namespace llarp
 
     using SNodeSessions = std::unordered_map<RouterID, std::shared_ptr<exit::BaseSession>>;
 
-    using ConvoMap = std::unordered_map<ConvoTag, Session>;
-
     /// set of outbound addresses to maintain to
     using OutboundSessions_t = std::unordered_set<Address>;
 
     using PathEnsureHook = std::function<void(Address, OutboundContext*)>;
 
-    using LNSNameCache = std::unordered_map<std::string, std::pair<Address, llarp_time_t>>;
-
   }  // namespace service
 }  // namespace llarp
@@ -10,13 +10,14 @@ namespace llarp
   namespace service
   {
     void
-    EndpointUtil::ExpireSNodeSessions(llarp_time_t now, SNodeSessions& sessions)
+    EndpointUtil::ExpireSNodeSessions(llarp_time_t now, SNodeSessions& sessions, Reclaim_t& reclaim)
     {
       auto itr = sessions.begin();
       while (itr != sessions.end())
       {
         if (itr->second->ShouldRemove() && itr->second->IsStopped())
         {
+          reclaim.push_back(std::move(itr->second));
           itr = sessions.erase(itr);
           continue;
         }
@@ -35,19 +36,23 @@ namespace llarp
     }
 
     void
-    EndpointUtil::ExpirePendingTx(llarp_time_t now, PendingLookups& lookups)
+    EndpointUtil::ExpirePendingTx(
+        llarp_time_t now, util::TimerWheel<uint64_t>& due, PendingLookups& lookups)
     {
       std::vector<std::unique_ptr<IServiceLookup>> timedout;
-      for (auto itr = lookups.begin(); itr != lookups.end();)
-      {
-        if (!itr->second->IsTimedOut(now))
+      due.Advance(now, [&](uint64_t txid) {
+        // answered already
+        auto itr = lookups.find(txid);
+        if (itr == lookups.end())
+          return;
+        if (not itr->second->IsTimedOut(now))
         {
-          ++itr;
-          continue;
+          due.Schedule(itr->second->ExpiresAt(), txid);
+          return;
         }
         timedout.emplace_back(std::move(itr->second));
-        itr = lookups.erase(itr);
-      }
+        lookups.erase(itr);
+      });
 
       for (const auto& lookup : timedout)
       {
@@ -57,29 +62,34 @@ namespace llarp
     }
 
     void
-    EndpointUtil::ExpirePendingRouterLookups(llarp_time_t now, PendingRouters& routers)
+    EndpointUtil::ExpirePendingRouterLookups(
+        llarp_time_t now, util::TimerWheel<RouterID>& due, PendingRouters& routers)
     {
-      for (auto itr = routers.begin(); itr != routers.end();)
-      {
-        if (!itr->second.IsExpired(now))
+      due.Advance(now, [&](const RouterID& router) {
+        auto itr = routers.find(router);
+        if (itr == routers.end())
+          return;
+        // a later lookup for the same router
+        if (not itr->second.IsExpired(now))
         {
-          ++itr;
-          continue;
+          due.Schedule(itr->second.ExpiresAt(), router);
+          return;
         }
         LogWarn("lookup for ", itr->first, " timed out");
         itr->second.InformResult({});
-        itr = routers.erase(itr);
-      }
+        routers.erase(itr);
+      });
     }
 
     void
-    EndpointUtil::DeregisterDeadSessions(llarp_time_t now, Sessions& sessions)
+    EndpointUtil::DeregisterDeadSessions(llarp_time_t now, Sessions& sessions, Reclaim_t& reclaim)
     {
       auto itr = sessions.begin();
       while (itr != sessions.end())
       {
         if (itr->second->IsDone(now))
         {
+          reclaim.push_back(std::move(itr->second));
           itr = sessions.erase(itr);
         }
         else
@@ -120,20 +130,30 @@ namespace llarp
       }
     }
 
-    void
-    EndpointUtil::ExpireConvoSessions(llarp_time_t now, ConvoMap& sessions)
+    std::vector<ConvoTag>
+    EndpointUtil::ExpireConvoSessions(
+        llarp_time_t now, util::TimerWheel<ConvoTag>& due, ConvoMap& sessions)
     {
-      auto itr = sessions.begin();
-      while (itr != sessions.end())
-      {
-        if (itr->second.IsExpired(now))
+      std::vector<ConvoTag> gone;
+      due.Advance(now, [&](const ConvoTag& tag) {
+        auto itr = sessions.find(tag);
+        if (itr == sessions.end())
         {
-          LogInfo("Expire session T=", itr->first, " to ", itr->second.Addr());
-          itr = sessions.erase(itr);
+          gone.push_back(tag);
+          return;
         }
-        else
-          ++itr;
-      }
+        const auto& session = itr->second;
+        if (not session.IsExpired(now))
+        {
+          // used since it was scheduled; forever ones just get looked at once a lifetime
+          due.Schedule(session.forever ? now + SessionLifetime : session.ExpiresAt(), tag);
+          return;
+        }
+        LogInfo("Expire session T=", tag, " to ", session.Addr());
+        sessions.erase(itr);
+        gone.push_back(tag);
+      });
+      return gone;
     }
 
     void
@@ -173,17 +193,12 @@ namespace llarp
         const ConvoMap& sessions, const Address& info, std::set<ConvoTag>& tags)
     {
       bool inserted = false;
-      auto itr = sessions.begin();
-      while (itr != sessions.end())
+      for (const auto& tag : sessions.TagsFor(info))
       {
-        if (itr->second.remote.Addr() == info)
+        if (tags.emplace(tag).second)
         {
-          if (tags.emplace(itr->first).second)
-          {
-            inserted = true;
-          }
+          inserted = true;
         }
-        ++itr;
       }
       return inserted;
     }
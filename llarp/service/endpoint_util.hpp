@@ -1,6 +1,7 @@
 #pragma once
 
 #include "endpoint_types.hpp"
+#include <llarp/util/timer_wheel.hpp>
 
 namespace llarp
 {
@@ -8,24 +9,32 @@ namespace llarp
   {
     struct EndpointUtil
     {
+      /// the sessions a tick takes out of our tables, to let go of a few at a time over later
+      /// goes of the loop, so that tearing down many of them at once doesn't hold it up
+      using Reclaim_t = std::vector<std::shared_ptr<void>>;
+
       static void
-      ExpireSNodeSessions(llarp_time_t now, SNodeSessions& sessions);
+      ExpireSNodeSessions(llarp_time_t now, SNodeSessions& sessions, Reclaim_t& reclaim);
 
+      /// time out the lookups that have come due on the wheel by now
       static void
-      ExpirePendingTx(llarp_time_t now, PendingLookups& lookups);
+      ExpirePendingTx(llarp_time_t now, util::TimerWheel<uint64_t>& due, PendingLookups& lookups);
 
       static void
-      ExpirePendingRouterLookups(llarp_time_t now, PendingRouters& routers);
+      ExpirePendingRouterLookups(
+          llarp_time_t now, util::TimerWheel<RouterID>& due, PendingRouters& routers);
 
       static void
-      DeregisterDeadSessions(llarp_time_t now, Sessions& sessions);
+      DeregisterDeadSessions(llarp_time_t now, Sessions& sessions, Reclaim_t& reclaim);
 
       static void
       TickRemoteSessions(
           llarp_time_t now, Sessions& remoteSessions, Sessions& deadSessions, ConvoMap& sessions);
 
-      static void
-      ExpireConvoSessions(llarp_time_t now, ConvoMap& sessions);
+      /// expire the convos that have come due on the wheel by now, returning the tags of those
+      /// that came due and are gone, whether expired here or erased some other way since
+      static std::vector<ConvoTag>
+      ExpireConvoSessions(llarp_time_t now, util::TimerWheel<ConvoTag>& due, ConvoMap& sessions);
 
       static void
       StopRemoteSessions(Sessions& remoteSessions);
@@ -10,6 +10,9 @@ namespace llarp
   {
     /// interval for which we will add to lookup timeout interval
     constexpr auto IntrosetLookupGraceInterval = 20s;
+    /// what we allow for the end of the path to hear back from the relay storing the introset,
+    /// on top of the path's own round trips
+    constexpr auto IntrosetLookupRelayInterval = 5s;
 
     struct Endpoint;
     struct HiddenServiceAddressLookup : public IServiceLookup
@@ -40,6 +40,7 @@ namespace llarp
       enckey.Zero();
       pq.Zero();
       derivedSignKey.Zero();
+      derivedSignPubKey.Zero();
       vanity.Zero();
     }
 
@@ -51,7 +52,8 @@ namespace llarp
       crypto->encryption_keygen(enckey);
       pub.Update(seckey_topublic(signkey), seckey_topublic(enckey));
       crypto->pqe_keygen(pq);
-      if (not crypto->derive_subkey_private(derivedSignKey, signkey, 1))
+      if (not crypto->derive_subkey_private(derivedSignKey, signkey, 1)
+          or not derivedSignKey.toPublic(derivedSignPubKey))
       {
         throw std::runtime_error("failed to derive subkey");
       }
@@ -146,7 +148,8 @@ namespace llarp
         van = vanity;
       // update pubkeys
       pub.Update(seckey_topublic(signkey), seckey_topublic(enckey), van);
-      if (not crypto->derive_subkey_private(derivedSignKey, signkey, 1))
+      if (not crypto->derive_subkey_private(derivedSignKey, signkey, 1)
+          or not derivedSignKey.toPublic(derivedSignPubKey))
       {
         throw std::runtime_error("failed to derive subkey");
       }
@@ -180,7 +183,7 @@ namespace llarp
       CryptoManager::instance()->xchacha20(buf, k, encrypted.nounce);
       encrypted.introsetPayload = buf.copy();
 
-      if (not encrypted.Sign(derivedSignKey))
+      if (not encrypted.Sign(derivedSignKey, derivedSignPubKey))
         return std::nullopt;
       return encrypted;
     }
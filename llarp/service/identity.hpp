@@ -21,6 +21,8 @@ namespace llarp
       SecretKey enckey;
       SecretKey signkey;
       PrivateKey derivedSignKey;
+      /// derivedSignKey's public key, which every introset we sign carries
+      PubKey derivedSignPubKey;
       PQKeyPair pq;
       uint64_t version = llarp::constants::proto_version;
       VanityNonce vanity;
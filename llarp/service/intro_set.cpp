@@ -103,9 +103,17 @@ namespace llarp::service
   bool
   EncryptedIntroSet::Sign(const PrivateKey& k)
   {
-    signedAt = llarp::time_now_ms();
-    if (not k.toPublic(derivedSigningKey))
+    PubKey pubkey;
+    if (not k.toPublic(pubkey))
       return false;
+    return Sign(k, pubkey);
+  }
+
+  bool
+  EncryptedIntroSet::Sign(const PrivateKey& k, const PubKey& pubkey)
+  {
+    signedAt = llarp::time_now_ms();
+    derivedSigningKey = pubkey;
     sig.Zero();
     std::array<byte_t, MAX_INTROSET_SIZE + 128> tmp;
     llarp_buffer_t buf(tmp);
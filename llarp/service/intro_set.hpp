@@ -146,6 +146,10 @@ namespace llarp
       bool
       Sign(const PrivateKey& k);
 
+      /// sign with k, whose public key the caller already has
+      bool
+      Sign(const PrivateKey& k, const PubKey& pubkey);
+
       bool
       IsExpired(llarp_time_t now) const;
 
@@ -0,0 +1,94 @@
+#include "lns_cache.hpp"
+
+namespace llarp::service
+{
+  std::optional<LNSCache::Hit>
+  LNSCache::Get(const std::string& name, llarp_time_t now)
+  {
+    const auto itr = m_Names.find(name);
+    if (itr == m_Names.end())
+    {
+      ++m_Misses;
+      return std::nullopt;
+    }
+    auto& entry = itr->second;
+    if (now < entry.expiresAt)
+    {
+      ++entry.hits;
+      ++(entry.value ? m_Hits : m_NegativeHits);
+      return Hit{entry.value, false};
+    }
+    // only names that resolved are worth serving stale; a missing one may have been registered
+    if (entry.value and now < entry.expiresAt + StaleGrace)
+    {
+      ++m_StaleHits;
+      return Hit{entry.value, true};
+    }
+    ++m_Misses;
+    return std::nullopt;
+  }
+
+  void
+  LNSCache::Put(const std::string& name, std::optional<Addr_t> value, llarp_time_t now)
+  {
+    auto& entry = m_Names[name];
+    entry.expiresAt = now + (value ? llarp_time_t{PositiveTTL} : llarp_time_t{NegativeTTL});
+    entry.value = std::move(value);
+    entry.refreshStartedAt = 0s;
+    entry.hits = 0;
+  }
+
+  bool
+  LNSCache::StartRefresh(const std::string& name, llarp_time_t now)
+  {
+    const auto itr = m_Names.find(name);
+    if (itr == m_Names.end())
+      return false;
+    auto& entry = itr->second;
+    if (entry.refreshStartedAt > 0s and now - entry.refreshStartedAt < RefreshRetry)
+      return false;
+    entry.refreshStartedAt = now;
+    return true;
+  }
+
+  std::vector<std::string>
+  LNSCache::TakePrefetches(llarp_time_t now)
+  {
+    std::vector<std::string> names;
+    for (const auto& [name, entry] : m_Names)
+    {
+      if (not entry.value or entry.hits < PrefetchHits or now >= entry.expiresAt
+          or entry.expiresAt - now > PrefetchWindow)
+        continue;
+      if (StartRefresh(name, now))
+        names.push_back(name);
+    }
+    m_Prefetches += names.size();
+    return names;
+  }
+
+  void
+  LNSCache::Decay(llarp_time_t now)
+  {
+    for (auto itr = m_Names.begin(); itr != m_Names.end();)
+    {
+      const auto& entry = itr->second;
+      if (now >= entry.expiresAt + (entry.value ? llarp_time_t{StaleGrace} : 0s))
+        itr = m_Names.erase(itr);
+      else
+        ++itr;
+    }
+  }
+
+  util::StatusObject
+  LNSCache::ExtractStatus() const
+  {
+    return util::StatusObject{
+        {"names", m_Names.size()},
+        {"hits", m_Hits},
+        {"negativeHits", m_NegativeHits},
+        {"staleHits", m_StaleHits},
+        {"misses", m_Misses},
+        {"prefetches", m_Prefetches}};
+  }
+}  // namespace llarp::service
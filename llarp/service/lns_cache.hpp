@@ -0,0 +1,90 @@
+#pragma once
+
+#include "address.hpp"
+#include <llarp/router_id.hpp>
+#include <llarp/util/status.hpp>
+#include <llarp/util/time.hpp>
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <oxenc/variant.h>
+
+namespace llarp::service
+{
+  /// lns names we have resolved, shared by all of a router's endpoints.
+  ///
+  /// names that turned out not to exist are kept for a short while too, so that asking for them
+  /// again doesn't go to the network every time.  a name past its ttl is still served for a grace
+  /// period while it is looked up again, and names asked for often are looked up again shortly
+  /// before they expire, so that hot names never wait on the network.
+  class LNSCache
+  {
+   public:
+    using Addr_t = std::variant<Address, RouterID>;
+
+    /// how long we keep a name that resolved, and one that did not
+    static constexpr auto PositiveTTL = 1h;
+    static constexpr auto NegativeTTL = 1min;
+    /// how long past its ttl we serve a name while looking it up again
+    static constexpr auto StaleGrace = 10min;
+    /// how close to expiring a name we look up again if it is asked for at least PrefetchHits
+    /// times
+    static constexpr auto PrefetchWindow = 5min;
+    static constexpr uint64_t PrefetchHits = 3;
+    /// how long we wait on a lookup to refresh a name before trying again
+    static constexpr auto RefreshRetry = 30s;
+
+    struct Hit
+    {
+      /// what the name resolves to, or nullopt if it does not exist
+      std::optional<Addr_t> value;
+      /// true if it is past its ttl and the caller should refresh it
+      bool stale;
+    };
+
+    /// what we have for name, or nullopt if we need to look it up
+    std::optional<Hit>
+    Get(const std::string& name, llarp_time_t now);
+
+    /// cache the result of looking up name; nullopt for a name that does not exist
+    void
+    Put(const std::string& name, std::optional<Addr_t> value, llarp_time_t now);
+
+    /// note that we are looking name up again.  returns false if we already are, or have nothing
+    /// for it.
+    bool
+    StartRefresh(const std::string& name, llarp_time_t now);
+
+    /// names that are asked for a lot and expire soon, marked as being refreshed
+    std::vector<std::string>
+    TakePrefetches(llarp_time_t now);
+
+    /// forget names past their ttl and grace
+    void
+    Decay(llarp_time_t now);
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    struct Entry
+    {
+      std::optional<Addr_t> value;
+      llarp_time_t expiresAt = 0s;
+      llarp_time_t refreshStartedAt = 0s;
+      /// times it was asked for since we last looked it up
+      uint64_t hits = 0;
+    };
+
+    std::unordered_map<std::string, Entry> m_Names;
+
+    uint64_t m_Hits = 0;
+    uint64_t m_NegativeHits = 0;
+    uint64_t m_StaleHits = 0;
+    uint64_t m_Misses = 0;
+    uint64_t m_Prefetches = 0;
+  };
+}  // namespace llarp::service
@@ -2,47 +2,94 @@
 
 namespace llarp::service
 {
-  std::function<void(std::optional<LNSLookupTracker::Addr_t>)>
+  LNSLookupTracker::Handler_t
   LNSLookupTracker::MakeResultHandler(
-      std::string name,
-      std::size_t numPeers,
-      std::function<void(std::optional<Addr_t>)> resultHandler)
+      std::string name, std::size_t numPeers, Handler_t resultHandler)
   {
-    m_PendingLookups.emplace(name, LookupInfo{numPeers, resultHandler});
-    return [name, this](std::optional<Addr_t> found) {
+    const auto id = m_NextID++;
+    m_PendingLookups.insert_or_assign(name, LookupInfo{numPeers, std::move(resultHandler), id});
+    return [name, id, this](std::optional<Addr_t> found) {
       auto itr = m_PendingLookups.find(name);
-      if (itr == m_PendingLookups.end())
+      if (itr == m_PendingLookups.end() or itr->second.m_ID != id)
         return;
-      itr->second.HandleOneResult(found);
-      if (itr->second.IsDone())
-        m_PendingLookups.erase(itr);
+      // take it out first, as a handler may well look the name up again
+      auto info = std::move(itr->second);
+      m_PendingLookups.erase(itr);
+      if (not info.HandleOneResult(found))
+        m_PendingLookups.emplace(name, std::move(info));
     };
   }
 
   bool
-  LNSLookupTracker::LookupInfo::IsDone() const
+  LNSLookupTracker::Join(const std::string& name, Handler_t resultHandler)
   {
-    return m_ResultsGotten == m_ResultsNeeded;
+    auto itr = m_PendingLookups.find(name);
+    if (itr == m_PendingLookups.end())
+      return false;
+    if (resultHandler)
+      itr->second.m_Handlers.push_back(std::move(resultHandler));
+    return true;
   }
 
   void
-  LNSLookupTracker::LookupInfo::HandleOneResult(std::optional<Addr_t> result)
+  LNSLookupTracker::ObservePath(const RouterID& endpoint, llarp_time_t rtt, llarp_time_t now)
   {
-    if (result)
+    auto [itr, inserted] = m_PathLatency.try_emplace(endpoint, EndpointLatency{rtt, now});
+    if (not inserted)
     {
-      m_CurrentValues.insert(*result);
+      // the same smoothing as tcp's srtt
+      itr->second.latency = (itr->second.latency * 7 + rtt) / 8;
+      itr->second.lastSeen = now;
     }
-    m_ResultsGotten++;
-    if (IsDone())
+  }
+
+  std::optional<llarp_time_t>
+  LNSLookupTracker::PathLatency(const RouterID& endpoint) const
+  {
+    if (auto itr = m_PathLatency.find(endpoint); itr != m_PathLatency.end())
+      return itr->second.latency;
+    return std::nullopt;
+  }
+
+  void
+  LNSLookupTracker::Decay(llarp_time_t now)
+  {
+    for (auto itr = m_PathLatency.begin(); itr != m_PathLatency.end();)
     {
-      if (m_CurrentValues.size() == 1)
-      {
-        m_HandleResult(*m_CurrentValues.begin());
-      }
+      if (itr->second.lastSeen + PathLatencyExpiry <= now)
+        itr = m_PathLatency.erase(itr);
       else
-      {
-        m_HandleResult(std::nullopt);
-      }
+        ++itr;
     }
   }
+
+  std::size_t
+  LNSLookupTracker::LookupInfo::Quorum() const
+  {
+    return m_ResultsNeeded / 2 + 1;
+  }
+
+  bool
+  LNSLookupTracker::LookupInfo::HandleOneResult(std::optional<Addr_t> result)
+  {
+    if (result)
+      m_Votes[*result]++;
+    m_ResultsGotten++;
+
+    const bool agreed = m_Votes.size() == 1 and m_Votes.begin()->second >= Quorum();
+    // peers that disagree settle it too: whatever the rest say, we won't take an answer
+    if (not agreed and m_Votes.size() < 2 and m_ResultsGotten < m_ResultsNeeded)
+      return false;
+
+    std::optional<Addr_t> settled;
+    if (m_Votes.size() == 1)
+      settled = m_Votes.begin()->first;
+
+    // a zero value is a peer telling us the name isn't registered
+    if (settled and var::visit([](const auto& value) { return value.IsZero(); }, *settled))
+      settled = std::nullopt;
+    for (const auto& handler : m_Handlers)
+      handler(settled);
+    return true;
+  }
 }  // namespace llarp::service
@@ -3,11 +3,12 @@
 #include <functional>
 #include <optional>
 #include <unordered_map>
-#include <unordered_set>
 #include <string>
+#include <vector>
 
 #include "address.hpp"
 #include <llarp/router_id.hpp>
+#include <llarp/util/time.hpp>
 #include <oxenc/variant.h>
 
 namespace llarp::service
@@ -17,37 +18,71 @@ namespace llarp::service
   {
    public:
     using Addr_t = std::variant<Address, RouterID>;
+    using Handler_t = std::function<void(std::optional<Addr_t>)>;
+
+    /// how long we remember how fast a path endpoint answered after we last heard from it
+    static constexpr auto PathLatencyExpiry = 30min;
 
    private:
     struct LookupInfo
     {
-      std::unordered_set<Addr_t> m_CurrentValues;
-      std::function<void(std::optional<Addr_t>)> m_HandleResult;
+      /// how many peers gave each answer
+      std::unordered_map<Addr_t, std::size_t> m_Votes;
+      std::vector<Handler_t> m_Handlers;
       std::size_t m_ResultsGotten = 0;
       std::size_t m_ResultsNeeded;
+      /// told apart from a later lookup of the same name, for the answers that come late
+      uint64_t m_ID;
 
-      LookupInfo(std::size_t wantResults, std::function<void(std::optional<Addr_t>)> resultHandler)
-          : m_HandleResult{std::move(resultHandler)}, m_ResultsNeeded{wantResults}
+      LookupInfo(std::size_t wantResults, Handler_t resultHandler, uint64_t id)
+          : m_Handlers{std::move(resultHandler)}, m_ResultsNeeded{wantResults}, m_ID{id}
       {}
 
-      bool
-      IsDone() const;
+      /// how many peers have to agree for us to take their answer before the rest are in
+      std::size_t
+      Quorum() const;
 
-      void
+      /// handles one peer's answer; true once that settled the lookup, and the handlers have
+      /// been called
+      bool
       HandleOneResult(std::optional<Addr_t> result);
     };
 
+    struct EndpointLatency
+    {
+      llarp_time_t latency;
+      llarp_time_t lastSeen;
+    };
+
     std::unordered_map<std::string, LookupInfo> m_PendingLookups;
+    std::unordered_map<RouterID, EndpointLatency> m_PathLatency;
+    uint64_t m_NextID = 0;
 
    public:
     /// make a function that will handle consensus of an lns request
     /// name is the name we are requesting
     /// numPeers is the number of peers we asked
     /// resultHandler is a function that we are wrapping that will handle the final result
-    std::function<void(std::optional<Addr_t>)>
-    MakeResultHandler(
-        std::string name,
-        std::size_t numPeers,
-        std::function<void(std::optional<Addr_t>)> resultHandler);
+    /// the lookup settles as soon as a majority of the peers agree, or any two disagree; the
+    /// answers that come in after that are dropped
+    Handler_t
+    MakeResultHandler(std::string name, std::size_t numPeers, Handler_t resultHandler);
+
+    /// if a lookup of the name is underway, has the handler called with its result too and
+    /// returns true; returns false if there is none, and the caller has to start one
+    bool
+    Join(const std::string& name, Handler_t resultHandler);
+
+    /// folds in how long a path endpoint took to answer a lookup (or time out)
+    void
+    ObservePath(const RouterID& endpoint, llarp_time_t rtt, llarp_time_t now);
+
+    /// smoothed time a path endpoint took to answer our lookups, if we have asked it
+    std::optional<llarp_time_t>
+    PathLatency(const RouterID& endpoint) const;
+
+    /// forgets the latency of endpoints we have not heard from in a while
+    void
+    Decay(llarp_time_t now);
   };
 }  // namespace llarp::service
@@ -54,6 +54,13 @@ namespace llarp
         return TimeLeft(now) == 0ms;
       }
 
+      /// when this request times out
+      llarp_time_t
+      ExpiresAt() const
+      {
+        return m_created + m_timeout;
+      }
+
       /// return how long this request has left to be fufilled
       llarp_time_t
       TimeLeft(llarp_time_t now) const
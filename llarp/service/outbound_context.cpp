@@ -4,6 +4,7 @@
 #include "endpoint.hpp"
 #include "endpoint_util.hpp"
 #include "protocol_type.hpp"
+#include "shared_paths.hpp"
 
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/nodedb.hpp>
@@ -12,6 +13,7 @@
 
 #include <random>
 #include <algorithm>
+#include <utility>
 
 namespace llarp
 {
@@ -21,6 +23,12 @@ namespace llarp
     OutboundContext::Stop()
     {
       markedBad = true;
+      // the paths others still use are theirs to tear down
+      for (const auto& path : m_Endpoint->OutboundPaths().Release(this))
+      {
+        Lock_t l{m_PathsMutex};
+        m_Paths.erase(std::make_pair(path->Upstream(), path->RXID()));
+      }
       return path::Builder::Stop();
     }
 
@@ -57,7 +65,7 @@ namespace llarp
     OutboundContext::OutboundContext(const IntroSet& introset, Endpoint* parent)
         : path::Builder{parent->Router(), OutboundContextNumPaths, parent->numHops}
         , SendContext{introset.addressKeys, {}, this, parent}
-        , location{introset.addressKeys.Addr().ToKey()}
+        , location{parent->IntrosetLocation(introset.addressKeys.Addr())}
         , addr{introset.addressKeys.Addr()}
         , currentIntroSet{introset}
 
@@ -73,6 +81,15 @@ namespace llarp
         it += std::uniform_int_distribution<size_t>{0, introset.intros.size() - 1}(rng);
       }
       m_NextIntro = *it;
+      // but if our endpoint has a path ready to one of the intros we can start talking right away
+      for (const auto& intro : introset.intros)
+      {
+        if (parent->HasPooledPath(intro.router) and not intro.ExpiresSoon(Now()))
+        {
+          m_NextIntro = intro;
+          break;
+        }
+      }
       currentConvoTag.Randomize();
       lastShift = Now();
       // add send and connect timeouts to the parent endpoints path alignment timeout
@@ -214,10 +231,12 @@ namespace llarp
         LogInfo(Name(), " marked bad, ignoring new path");
         p->EnterState(path::ePathIgnore, Now());
       }
-      else if (p->Endpoint() == m_NextIntro.router)
+      else
       {
+        m_Endpoint->OutboundPaths().Offer(p, shared_from_this());
         // we now have a path to the next intro, swap intros
-        SwapIntros();
+        if (p->Endpoint() == m_NextIntro.router)
+          SwapIntros();
       }
     }
 
@@ -252,6 +271,9 @@ namespace llarp
           m_DataHandler,
           currentConvoTag,
           t);
+      // use the encapsulation we made ahead of time if we have one, and start on the next
+      ex->encapsulation = std::exchange(m_Encapsulation, std::nullopt);
+      PrepareEncapsulation();
 
       ex->hook = [self = shared_from_this(), path](auto frame) {
         if (not self->Send(std::move(frame), path))
@@ -268,7 +290,8 @@ namespace llarp
       // ensure we have a sender put for this convo tag
       m_DataHandler->PutSenderFor(currentConvoTag, currentIntroSet.addressKeys, false);
       // encrypt frame async
-      m_Endpoint->Router()->QueueWork([ex, frame] { return AsyncKeyExchange::Encrypt(ex, frame); });
+      m_Endpoint->Router()->QueueKeyExchangeWork(
+          [ex, frame] { return AsyncKeyExchange::Encrypt(ex, frame); });
 
       LogInfo(Name(), " send intro frame T=", currentConvoTag);
     }
@@ -407,9 +430,7 @@ namespace llarp
           LogWarn(Name(), " ready but no path to ", remoteIntro.router, " ???");
           return true;
         }
-        for (const auto& hook : m_ReadyHooks)
-          hook(this);
-        m_ReadyHooks.clear();
+        RunReadyHooks(this);
       }
 
       const auto timeout = std::max(lastGoodSend, m_LastInboundTraffic);
@@ -451,14 +472,26 @@ namespace llarp
       }
       if (m_ReadyHooks.empty())
       {
-        m_router->loop()->call_later(timeout, [this]() {
-          LogWarn(Name(), " did not obtain session in time");
-          for (const auto& hook : m_ReadyHooks)
-            hook(nullptr);
-          m_ReadyHooks.clear();
-        });
-      }
-      m_ReadyHooks.push_back(hook);
+        // we may be gone by the time it runs
+        m_router->loop()->call_later(
+            timeout, [weak = GetWeak(), this, batch = m_ReadyHooksBatch]() {
+              const auto self = weak.lock();
+              if (not self or batch != m_ReadyHooksBatch)
+                return;
+              LogWarn(Name(), " did not obtain session in time");
+              RunReadyHooks(nullptr);
+            });
+      }
+      m_ReadyHooks.push_back(std::move(hook));
+    }
+
+    void
+    OutboundContext::RunReadyHooks(OutboundContext* ready)
+    {
+      ++m_ReadyHooksBatch;
+      // a hook may add another, which starts the next batch rather than joining this one
+      for (const auto& hook : std::exchange(m_ReadyHooks, {}))
+        hook(ready);
     }
 
     std::optional<std::vector<RouterContact>>
@@ -473,6 +506,55 @@ namespace llarp
       return GetHopsAlignedToForBuild(m_NextIntro.router, m_Endpoint->SnodeBlacklist());
     }
 
+    bool
+    OutboundContext::TakePathFromEndpointPool(const RouterID& remote)
+    {
+      auto path = m_Endpoint->TakePooledPath(remote);
+      if (not path)
+        return false;
+      LogInfo(Name(), " using pooled path ", path->ShortName(), " to ", remote);
+      AdoptPath(std::move(path));
+      return true;
+    }
+
+    bool
+    OutboundContext::TakeSharedPath(const RouterID& remote)
+    {
+      if (markedBad)
+        return false;
+      auto path =
+          m_Endpoint->OutboundPaths().Acquire(remote, numHops, shared_from_this(), Now());
+      if (not path)
+        return false;
+      LogInfo(Name(), " sharing path ", path->ShortName(), " to ", remote);
+      // it stays its builder's, and already has the handlers that get its traffic to us
+      PathSet::AddPath(path);
+      if (remote == m_NextIntro.router)
+        SwapIntros();
+      return true;
+    }
+
+    void
+    OutboundContext::TakeOverSharedPath(const path::Path_ptr& path)
+    {
+      path->m_PathSet = GetWeak();
+    }
+
+    void
+    OutboundContext::BuildOne(path::PathRole roles)
+    {
+      const auto& remote = m_NextIntro.router;
+      if (remote.IsZero() or not(TakePathFromEndpointPool(remote) or TakeSharedPath(remote)))
+        path::Builder::BuildOne(roles);
+    }
+
+    bool
+    OutboundContext::BuildOneAlignedTo(const RouterID remote)
+    {
+      return TakePathFromEndpointPool(remote) or TakeSharedPath(remote)
+          or path::Builder::BuildOneAlignedTo(remote);
+    }
+
     bool
     OutboundContext::ShouldBuildMore(llarp_time_t now) const
     {
@@ -513,6 +595,13 @@ namespace llarp
       return sentIntro;
     }
 
+    bool
+    OutboundContext::RemoteTakesBatches() const
+    {
+      const auto& protos = currentIntroSet.supportedProtocols;
+      return std::find(protos.begin(), protos.end(), ProtocolType::Batch) != protos.end();
+    }
+
     bool
     OutboundContext::IntroGenerated() const
     {
@@ -622,6 +711,31 @@ namespace llarp
       path::Builder::Tick(now);
       if (ShouldKeepAlive(now))
         KeepAlive();
+      PrepareEncapsulation();
+    }
+
+    void
+    OutboundContext::PrepareEncapsulation()
+    {
+      // one made for a key the remote has since replaced is no good to us
+      if (m_Encapsulation and m_Encapsulation->pubkey != currentIntroSet.sntrupKey)
+        m_Encapsulation.reset();
+      if (m_Encapsulation or m_EncapsulationPending or markedBad)
+        return;
+      m_EncapsulationPending = true;
+      m_Endpoint->Router()->QueueKeyExchangeWork([weak = weak_from_this(),
+                                                  loop = m_Endpoint->Loop(),
+                                                  pubkey = currentIntroSet.sntrupKey]() {
+        auto enc = PQEncapsulation::Make(pubkey);
+        loop->call([weak, enc = std::move(enc)]() {
+          auto self = weak.lock();
+          if (not self)
+            return;
+          self->m_EncapsulationPending = false;
+          if (enc and enc->pubkey == self->currentIntroSet.sntrupKey)
+            self->m_Encapsulation = enc;
+        });
+      });
     }
 
     bool
@@ -687,8 +801,7 @@ namespace llarp
           handler(result);
         };
       }
-      const auto& ident = m_Endpoint->GetIdentity();
-      if (not frame.AsyncDecryptAndVerify(m_Endpoint->Loop(), p, ident, m_Endpoint, hook))
+      if (not frame.AsyncDecryptAndVerify(p, m_Endpoint, hook))
       {
         // send reset convo tag message
         LogError("failed to decrypt and verify frame");
@@ -697,7 +810,7 @@ namespace llarp
         f.T = frame.T;
         f.F = p->intro.pathID;
 
-        f.Sign(ident);
+        f.Sign(m_Endpoint->GetIdentity());
         {
           LogWarn("invalidating convotag T=", frame.T);
           m_Endpoint->RemoveConvoTag(frame.T);
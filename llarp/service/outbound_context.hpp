@@ -1,6 +1,7 @@
 #pragma once
 
 #include <llarp/path/pathbuilder.hpp>
+#include "async_key_exchange.hpp"
 #include "sendcontext.hpp"
 #include <llarp/util/status.hpp>
 
@@ -56,6 +57,10 @@ namespace llarp
       bool
       HandleDataDrop(path::Path_ptr p, const PathID_t& dst, uint64_t s);
 
+      /// path, shared with us by the context that built it, reports to us from now on
+      void
+      TakeOverSharedPath(const path::Path_ptr& path);
+
       void
       HandlePathDied(path::Path_ptr p) override;
 
@@ -85,6 +90,10 @@ namespace llarp
       void
       AddReadyHook(std::function<void(OutboundContext*)> readyHook, llarp_time_t timeout);
 
+      /// calls and forgets the ready hooks we have, with ready (nullptr if we timed out)
+      void
+      RunReadyHooks(OutboundContext* ready);
+
       /// for exits
       void
       SendPacketToRemote(const llarp_buffer_t&, ProtocolType t) override;
@@ -123,6 +132,13 @@ namespace llarp
       std::optional<std::vector<RouterContact>>
       GetHopsForBuild() override;
 
+      /// uses a path from our endpoint's pool when it has one to the intro we want
+      void
+      BuildOne(path::PathRole roles = path::ePathRoleAny) override;
+
+      bool
+      BuildOneAlignedTo(const RouterID remote) override;
+
       bool
       HandleHiddenServiceFrame(path::Path_ptr p, const ProtocolFrame& frame);
 
@@ -157,10 +173,25 @@ namespace llarp
       void
       SwapIntros();
 
+      /// adopt a ready path to remote from our endpoint's pool, if it has one
+      bool
+      TakePathFromEndpointPool(const RouterID& remote);
+
+      /// use a path to remote another outbound context of our endpoint built, if it shares one
+      bool
+      TakeSharedPath(const RouterID& remote);
+
+      /// start making an encapsulation to the remote's introset key on a worker, if we don't
+      /// have one ready or on the way, so that the next intro we send doesn't wait for one
+      void
+      PrepareEncapsulation();
+
       bool
       IntroGenerated() const override;
       bool
       IntroSent() const override;
+      bool
+      RemoteTakesBatches() const override;
 
       const dht::Key_t location;
       const Address addr;
@@ -175,8 +206,13 @@ namespace llarp
       bool generatedIntro = false;
       bool sentIntro = false;
       std::vector<std::function<void(OutboundContext*)>> m_ReadyHooks;
+      /// bumped each time the ready hooks are run, so that the timeout of hooks already told
+      /// doesn't fail the ones added since
+      uint64_t m_ReadyHooksBatch = 0;
       llarp_time_t m_LastIntrosetUpdateAt = 0s;
       llarp_time_t m_LastKeepAliveAt = 0s;
+      std::optional<PQEncapsulation> m_Encapsulation;
+      bool m_EncapsulationPending = false;
     };
   }  // namespace service
 
@@ -0,0 +1,105 @@
+#include "pendingbuffer.hpp"
+
+#include <llarp/util/buffer_pool.hpp>
+
+#include <algorithm>
+
+namespace llarp::service
+{
+  PendingBuffer::PendingBuffer(const llarp_buffer_t& buf, ProtocolType t, uint64_t order)
+      : payload{util::BufferPool::Acquire(buf.base, buf.sz)}, protocol{t}, order{order}
+  {}
+
+  PendingBuffer::~PendingBuffer()
+  {
+    util::BufferPool::Release(payload);
+  }
+
+  PendingTraffic::PendingTraffic(size_t maxBytes, size_t maxBytesPerAddress)
+      : m_MaxBytes{maxBytes}, m_MaxBytesPerAddress{std::min(maxBytesPerAddress, maxBytes)}
+  {}
+
+  bool
+  PendingTraffic::Push(const Address& addr, const llarp_buffer_t& buf, ProtocolType t)
+  {
+    if (buf.sz > m_MaxBytesPerAddress)
+    {
+      ++m_DroppedOverBudget;
+      return false;
+    }
+    auto itr = m_Queues.find(addr);
+    // make room within the address first, then overall
+    while (itr != m_Queues.end() and itr->second.bytes + buf.sz > m_MaxBytesPerAddress)
+    {
+      DropOldest(itr);
+      itr = m_Queues.find(addr);
+    }
+    while (m_Bytes + buf.sz > m_MaxBytes)
+    {
+      // few addresses wait on sessions at once, so looking over them all for the oldest is cheap
+      DropOldest(std::min_element(
+          m_Queues.begin(), m_Queues.end(), [](const auto& a, const auto& b) {
+            return a.second.bufs.front().order < b.second.bufs.front().order;
+          }));
+    }
+    auto& queue = m_Queues[addr];
+    queue.bufs.emplace_back(buf, t, m_NextOrder++);
+    queue.bytes += buf.sz;
+    m_Bytes += buf.sz;
+    ++m_Queued;
+    return true;
+  }
+
+  void
+  PendingTraffic::DropOldest(std::unordered_map<Address, Queue>::iterator itr)
+  {
+    auto& queue = itr->second;
+    const auto sz = queue.bufs.front().payload.size();
+    queue.bufs.pop_front();
+    queue.bytes -= sz;
+    m_Bytes -= sz;
+    ++m_DroppedOverBudget;
+    if (queue.bufs.empty())
+      m_Queues.erase(itr);
+  }
+
+  PendingBufferQueue
+  PendingTraffic::Remove(const Address& addr)
+  {
+    auto itr = m_Queues.find(addr);
+    if (itr == m_Queues.end())
+      return {};
+    auto bufs = std::move(itr->second.bufs);
+    m_Bytes -= itr->second.bytes;
+    m_Queues.erase(itr);
+    return bufs;
+  }
+
+  PendingBufferQueue
+  PendingTraffic::Take(const Address& addr)
+  {
+    auto bufs = Remove(addr);
+    m_Sent += bufs.size();
+    return bufs;
+  }
+
+  void
+  PendingTraffic::Drop(const Address& addr)
+  {
+    m_DroppedNoSession += Remove(addr).size();
+  }
+
+  util::StatusObject
+  PendingTraffic::ExtractStatus() const
+  {
+    return util::StatusObject{
+        {"addresses", m_Queues.size()},
+        {"bytes", m_Bytes},
+        {"maxBytes", m_MaxBytes},
+        {"maxBytesPerAddress", m_MaxBytesPerAddress},
+        {"queued", m_Queued},
+        {"sent", m_Sent},
+        {"droppedOverBudget", m_DroppedOverBudget},
+        {"droppedNoSession", m_DroppedNoSession}};
+  }
+}  // namespace llarp::service
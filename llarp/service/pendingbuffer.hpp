@@ -1,15 +1,24 @@
 #pragma once
 
+#include "address.hpp"
 #include "protocol.hpp"
 #include <llarp/util/buffer.hpp>
+#include <llarp/util/status.hpp>
+
+#include <deque>
+#include <unordered_map>
 #include <vector>
 
 namespace llarp::service
 {
+  /// a packet held for a remote we have no session to yet, in a buffer from util::BufferPool
+  /// that goes back to the pool when it is done with
   struct PendingBuffer
   {
     std::vector<byte_t> payload;
     ProtocolType protocol;
+    /// when it was queued relative to everything else pending, for dropping the oldest
+    uint64_t order = 0;
 
     inline llarp_buffer_t
     Buffer()
@@ -17,8 +26,75 @@ namespace llarp::service
       return llarp_buffer_t{payload};
     }
 
-    PendingBuffer(const llarp_buffer_t& buf, ProtocolType t) : payload{buf.copy()}, protocol{t}
-    {}
+    PendingBuffer(const llarp_buffer_t& buf, ProtocolType t, uint64_t order = 0);
+
+    PendingBuffer(PendingBuffer&&) = default;
+    PendingBuffer&
+    operator=(PendingBuffer&&) = default;
+
+    ~PendingBuffer();
   };
 
+  using PendingBufferQueue = std::deque<PendingBuffer>;
+
+  /// traffic waiting on sessions to remotes to be made, by remote address.  what it holds is
+  /// bounded both overall and per address; once full, the oldest traffic is dropped to make room,
+  /// as it is what the remote is least likely to still care about by the time we get there.
+  class PendingTraffic
+  {
+   public:
+    static constexpr size_t DefaultMaxBytes = 4 * 1024 * 1024;
+    static constexpr size_t DefaultMaxBytesPerAddress = 256 * 1024;
+
+    explicit PendingTraffic(
+        size_t maxBytes = DefaultMaxBytes, size_t maxBytesPerAddress = DefaultMaxBytesPerAddress);
+
+    /// queue a copy of buf for addr, dropping older traffic if we are over budget.  returns false
+    /// if it is bigger than we hold for one address and was dropped itself.
+    bool
+    Push(const Address& addr, const llarp_buffer_t& buf, ProtocolType t);
+
+    /// take everything queued for addr, oldest first
+    PendingBufferQueue
+    Take(const Address& addr);
+
+    /// drop everything queued for addr, as we won't be getting a session to it
+    void
+    Drop(const Address& addr);
+
+    size_t
+    Bytes() const
+    {
+      return m_Bytes;
+    }
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    struct Queue
+    {
+      PendingBufferQueue bufs;
+      size_t bytes = 0;
+    };
+
+    /// take the queue for addr out without counting it as sent or dropped
+    PendingBufferQueue
+    Remove(const Address& addr);
+
+    /// drop the oldest buffer queued for the address at itr, erasing its queue once empty
+    void
+    DropOldest(std::unordered_map<Address, Queue>::iterator itr);
+
+    const size_t m_MaxBytes;
+    const size_t m_MaxBytesPerAddress;
+    std::unordered_map<Address, Queue> m_Queues;
+    size_t m_Bytes = 0;
+    uint64_t m_NextOrder = 0;
+
+    uint64_t m_Queued = 0;
+    uint64_t m_Sent = 0;
+    uint64_t m_DroppedOverBudget = 0;
+    uint64_t m_DroppedNoSession = 0;
+  };
 }  // namespace llarp::service
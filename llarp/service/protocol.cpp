@@ -1,13 +1,19 @@
 #include "protocol.hpp"
+#include <llarp/crypto/fast_crypto.hpp>
 #include <llarp/path/path.hpp>
 #include <llarp/routing/handler.hpp>
+#include <llarp/util/bencode_span.hpp>
 #include <llarp/util/buffer.hpp>
+#include <llarp/util/buffer_pool.hpp>
 #include <llarp/util/mem.hpp>
 #include <llarp/util/meta/memfn.hpp>
 #include "endpoint.hpp"
 #include <llarp/router/abstractrouter.hpp>
+#include <algorithm>
 #include <utility>
 
+#include <oxenc/endian.h>
+
 namespace llarp
 {
   namespace service
@@ -20,21 +26,90 @@ namespace llarp
     ProtocolMessage::ProtocolMessage(const ConvoTag& t) : tag(t)
     {}
 
-    ProtocolMessage::~ProtocolMessage() = default;
+    ProtocolMessage::~ProtocolMessage()
+    {
+      util::BufferPool::Release(payload);
+    }
 
     void
     ProtocolMessage::PutBuffer(const llarp_buffer_t& buf)
     {
-      payload.resize(buf.sz);
-      memcpy(payload.data(), buf.base, buf.sz);
+      util::BufferPool::Release(payload);
+      payload = util::BufferPool::Acquire(buf.base, buf.sz);
     }
 
     void
     ProtocolMessage::ProcessAsync(
         path::Path_ptr path, PathID_t from, std::shared_ptr<ProtocolMessage> self)
     {
-      if (!self->handler->HandleDataMessage(path, from, self))
-        LogWarn("failed to handle data message from ", path->Name());
+      if (self->proto != ProtocolType::Batch)
+      {
+        if (!self->handler->HandleDataMessage(path, from, self))
+          LogWarn("failed to handle data message from ", path->Name());
+        return;
+      }
+      const auto msgs = UnpackBatch(*self);
+      if (not msgs)
+      {
+        LogWarn("dropping malformed batch from ", path->Name(), " on T=", self->tag);
+        return;
+      }
+      for (const auto& msg : *msgs)
+      {
+        if (!self->handler->HandleDataMessage(path, from, msg))
+          LogWarn("failed to handle batched data message from ", path->Name());
+      }
+    }
+
+    void
+    AppendBatchEntry(
+        std::vector<byte_t>& batch, ProtocolType t, uint64_t seqno, const llarp_buffer_t& payload)
+    {
+      const auto offset = batch.size();
+      batch.resize(offset + BatchEntryOverhead + payload.sz);
+      byte_t* ptr = batch.data() + offset;
+      *ptr++ = static_cast<byte_t>(t);
+      oxenc::write_host_as_little(seqno, ptr);
+      ptr += sizeof(uint64_t);
+      oxenc::write_host_as_little(static_cast<uint16_t>(payload.sz), ptr);
+      ptr += sizeof(uint16_t);
+      std::copy_n(payload.base, payload.sz, ptr);
+    }
+
+    std::optional<std::vector<std::shared_ptr<ProtocolMessage>>>
+    UnpackBatch(const ProtocolMessage& batch)
+    {
+      std::vector<std::shared_ptr<ProtocolMessage>> msgs;
+      const byte_t* ptr = batch.payload.data();
+      const byte_t* const end = ptr + batch.payload.size();
+      while (ptr != end)
+      {
+        if (end - ptr < static_cast<std::ptrdiff_t>(BatchEntryOverhead))
+          return std::nullopt;
+        const auto t = static_cast<ProtocolType>(*ptr++);
+        // batches don't nest
+        if (t == ProtocolType::Batch)
+          return std::nullopt;
+        const auto seqno = oxenc::load_little_to_host<uint64_t>(ptr);
+        ptr += sizeof(uint64_t);
+        const auto sz = oxenc::load_little_to_host<uint16_t>(ptr);
+        ptr += sizeof(uint16_t);
+        if (end - ptr < sz)
+          return std::nullopt;
+
+        auto msg = std::make_shared<ProtocolMessage>(batch.tag);
+        msg->proto = t;
+        msg->seqno = seqno;
+        msg->payload.assign(ptr, ptr + sz);
+        msg->introReply = batch.introReply;
+        msg->sender = batch.sender;
+        msg->handler = batch.handler;
+        msg->version = batch.version;
+        msg->queued = batch.queued;
+        msgs.emplace_back(std::move(msg));
+        ptr += sz;
+      }
+      return msgs;
     }
 
     bool
@@ -125,43 +200,71 @@ namespace llarp
     bool
     ProtocolFrame::BEncode(llarp_buffer_t* buf) const
     {
-      if (!bencode_start_dict(buf))
-        return false;
-
-      if (!BEncodeWriteDictMsgType(buf, "A", "H"))
-        return false;
-      if (!C.IsZero())
-      {
-        if (!BEncodeWriteDictEntry("C", C, buf))
-          return false;
-      }
+      // what we sign and verify, so this has to stay byte for byte what it was
+      bencode::Writer w{*buf};
+      w.Dict().Key('A').Bytes("H", 1);
+      if (not C.IsZero())
+        w.Key('C').Bytes(C);
       if (D.size() > 0)
-      {
-        if (!BEncodeWriteDictEntry("D", D, buf))
-          return false;
-      }
-      if (!BEncodeWriteDictEntry("F", F, buf))
-        return false;
-      if (!N.IsZero())
-      {
-        if (!BEncodeWriteDictEntry("N", N, buf))
-          return false;
-      }
+        w.Key('D').Bytes(D);
+      w.Key('F').Bytes(F);
+      if (not N.IsZero())
+        w.Key('N').Bytes(N);
       if (R)
+        w.Key('R').Int(R);
+      if (not T.IsZero())
+        w.Key('T').Bytes(T);
+      w.Key('V').Int(version).Key('Z').Bytes(Z).End();
+      return w.Commit(buf);
+    }
+
+    bool
+    ProtocolFrame::Decode(bencode::Reader& r)
+    {
+      bool any = false;
+      char key;
+      while (r.NextKey(key))
       {
-        if (!BEncodeWriteDictInt("R", R, buf))
-          return false;
-      }
-      if (!T.IsZero())
-      {
-        if (!BEncodeWriteDictEntry("T", T, buf))
+        bool ok;
+        switch (key)
+        {
+          case 'C':
+            ok = r.Fixed(C);
+            break;
+          case 'D': {
+            byte_view_t payload;
+            ok = r.Bytes(payload) and D.CopyFrom(payload);
+            break;
+          }
+          case 'F':
+            ok = r.Fixed(F);
+            break;
+          case 'N':
+            ok = r.Fixed(N);
+            break;
+          case 'R':
+            ok = r.Int(R);
+            break;
+          case 'S':
+            ok = r.Int(S);
+            break;
+          case 'T':
+            ok = r.Fixed(T);
+            break;
+          case 'V':
+            ok = r.Int(version) and version == llarp::constants::proto_version;
+            break;
+          case 'Z':
+            ok = r.Fixed(Z);
+            break;
+          default:
+            ok = false;
+        }
+        if (not ok)
           return false;
+        any = true;
       }
-      if (!BEncodeWriteDictInt("V", version, buf))
-        return false;
-      if (!BEncodeWriteDictEntry("Z", Z, buf))
-        return false;
-      return bencode_end(buf);
+      return any and not r.Failed();
     }
 
     bool
@@ -203,7 +306,7 @@ namespace llarp
     {
       Encrypted_t tmp = D;
       auto buf = tmp.Buffer();
-      CryptoManager::instance()->xchacha20(*buf, sharedkey, N);
+      fast_crypto::xchacha20(*buf, sharedkey, N);
       return bencode_decode_dict(msg, buf);
     }
 
@@ -242,7 +345,7 @@ namespace llarp
       buf.sz = buf.cur - buf.base;
       buf.cur = buf.base;
       // encrypt
-      CryptoManager::instance()->xchacha20(buf, sessionKey, N);
+      fast_crypto::xchacha20(buf, sessionKey, N);
       // put encrypted buffer
       D = buf;
       // zero out signature
@@ -267,74 +370,48 @@ namespace llarp
       return true;
     }
 
-    struct AsyncFrameDecrypt
+    namespace
     {
-      path::Path_ptr path;
-      EventLoop_ptr loop;
-      std::shared_ptr<ProtocolMessage> msg;
-      const Identity& m_LocalIdentity;
-      Endpoint* handler;
-      const ProtocolFrame frame;
-      const Introduction fromIntro;
-
-      AsyncFrameDecrypt(
-          EventLoop_ptr l,
-          const Identity& localIdent,
-          Endpoint* h,
-          std::shared_ptr<ProtocolMessage> m,
-          const ProtocolFrame& f,
-          const Introduction& recvIntro)
-          : loop(std::move(l))
-          , msg(std::move(m))
-          , m_LocalIdentity(localIdent)
-          , handler(h)
-          , frame(f)
-          , fromIntro(recvIntro)
-      {}
-
-      static void
-      Work(std::shared_ptr<AsyncFrameDecrypt> self)
+      /// key exchange an intro frame from a remote starting a convo with us, and hand on what it
+      /// carries if it checks out; runs on the key exchange worker
+      void
+      HandleIntroFrame(Endpoint* handler, path::Path_ptr path, const ProtocolFrame& introFrame)
       {
         auto crypto = CryptoManager::instance();
+        const auto& localIdent = handler->GetIdentity();
         SharedSecret K;
         SharedSecret sharedKey;
         // copy
-        ProtocolFrame frame(self->frame);
-        if (!crypto->pqe_decrypt(self->frame.C, K, pq_keypair_to_secret(self->m_LocalIdentity.pq)))
+        ProtocolFrame frame(introFrame);
+        if (!crypto->pqe_decrypt(introFrame.C, K, pq_keypair_to_secret(localIdent.pq)))
         {
-          LogError("pqke failed C=", self->frame.C);
-          self->msg.reset();
+          LogError("pqke failed C=", introFrame.C);
           return;
         }
+        auto msg = std::make_shared<ProtocolMessage>();
         // decrypt
         auto buf = frame.D.Buffer();
-        crypto->xchacha20(*buf, K, self->frame.N);
-        if (!bencode_decode_dict(*self->msg, buf))
+        crypto->xchacha20(*buf, K, introFrame.N);
+        if (!bencode_decode_dict(*msg, buf))
         {
           LogError("failed to decode inner protocol message");
           DumpBuffer(*buf);
-          self->msg.reset();
           return;
         }
         // verify signature of outer message after we parsed the inner message
-        if (!self->frame.Verify(self->msg->sender))
+        if (!introFrame.Verify(msg->sender))
         {
           LogError(
-              "intro frame has invalid signature Z=",
-              self->frame.Z,
-              " from ",
-              self->msg->sender.Addr());
-          Dump<MAX_PROTOCOL_MESSAGE_SIZE>(self->frame);
-          Dump<MAX_PROTOCOL_MESSAGE_SIZE>(*self->msg);
-          self->msg.reset();
+              "intro frame has invalid signature Z=", introFrame.Z, " from ", msg->sender.Addr());
+          Dump<MAX_PROTOCOL_MESSAGE_SIZE>(introFrame);
+          Dump<MAX_PROTOCOL_MESSAGE_SIZE>(*msg);
           return;
         }
 
-        if (self->handler->HasConvoTag(self->msg->tag))
+        if (handler->HasConvoTag(msg->tag))
         {
-          LogError("dropping duplicate convo tag T=", self->msg->tag);
+          LogError("dropping duplicate convo tag T=", msg->tag);
           // TODO: send convotag reset
-          self->msg.reset();
           return;
         }
 
@@ -342,12 +419,10 @@ namespace llarp
         SharedSecret sharedSecret;
         path_dh_func dh_server = util::memFn(&Crypto::dh_server, CryptoManager::instance());
 
-        if (!self->m_LocalIdentity.KeyExchange(
-                dh_server, sharedSecret, self->msg->sender, self->frame.N))
+        if (!localIdent.KeyExchange(dh_server, sharedSecret, msg->sender, introFrame.N))
         {
           LogError("x25519 key exchange failed");
-          Dump<MAX_PROTOCOL_MESSAGE_SIZE>(self->frame);
-          self->msg.reset();
+          Dump<MAX_PROTOCOL_MESSAGE_SIZE>(introFrame);
           return;
         }
         std::array<byte_t, 64> tmp;
@@ -357,14 +432,10 @@ namespace llarp
         std::copy(sharedSecret.begin(), sharedSecret.end(), tmp.begin() + 32);
         crypto->shorthash(sharedKey, llarp_buffer_t(tmp));
 
-        std::shared_ptr<ProtocolMessage> msg = std::move(self->msg);
-        path::Path_ptr path = std::move(self->path);
-        const PathID_t from = self->frame.F;
-        msg->handler = self->handler;
-        self->handler->AsyncProcessAuthMessage(
-            msg,
-            [path, msg, from, handler = self->handler, fromIntro = self->fromIntro, sharedKey](
-                AuthResult result) {
+        const PathID_t from = introFrame.F;
+        msg->handler = handler;
+        handler->AsyncProcessAuthMessage(
+            msg, [path = std::move(path), msg, from, handler, sharedKey](AuthResult result) {
               if (result.code == AuthResultCode::eAuthAccepted)
               {
                 if (handler->WantsOutboundSession(msg->sender.Addr()))
@@ -388,7 +459,39 @@ namespace llarp
               handler->Pump(time_now_ms());
             });
       }
-    };
+    }  // namespace
+
+    KeyExchangeStage::KeyExchangeStage(Endpoint* ep) : m_Endpoint{ep}, m_Queue{QueueSize}
+    {
+      m_Queue.enable();
+    }
+
+    bool
+    KeyExchangeStage::Queue(path::Path_ptr path, const ProtocolFrame& frame)
+    {
+      if (m_Queue.tryPushBack(Job{std::move(path), frame}) != thread::QueueReturn::Success)
+        return false;
+      if (not m_Scheduled.exchange(true))
+        m_Endpoint->Router()->QueueKeyExchangeWork([this] { Drain(); });
+      return true;
+    }
+
+    void
+    KeyExchangeStage::Drain()
+    {
+      for (size_t n = 0; n < BatchSize; ++n)
+      {
+        auto job = m_Queue.tryPopFront();
+        if (not job)
+          break;
+        HandleIntroFrame(m_Endpoint, std::move(job->path), job->frame);
+      }
+      m_Scheduled = false;
+      // what is left goes in another batch rather than this one going on, so that whatever else
+      // is waiting on the worker gets a turn in between
+      if (not m_Queue.empty() and not m_Scheduled.exchange(true))
+        m_Endpoint->Router()->QueueKeyExchangeWork([this] { Drain(); });
+    }
 
     ProtocolFrame&
     ProtocolFrame::operator=(const ProtocolFrame& other)
@@ -405,90 +508,73 @@ namespace llarp
       return *this;
     }
 
-    struct AsyncDecrypt
-    {
-      ServiceInfo si;
-      SharedSecret shared;
-      ProtocolFrame frame;
-    };
-
     bool
     ProtocolFrame::AsyncDecryptAndVerify(
-        EventLoop_ptr loop,
         path::Path_ptr recvPath,
-        const Identity& localIdent,
         Endpoint* handler,
         std::function<void(std::shared_ptr<ProtocolMessage>)> hook) const
     {
-      auto msg = std::make_shared<ProtocolMessage>();
-      msg->handler = handler;
       if (T.IsZero())
       {
         // we need to dh
-        auto dh = std::make_shared<AsyncFrameDecrypt>(
-            loop, localIdent, handler, msg, *this, recvPath->intro);
-        dh->path = recvPath;
-        handler->Router()->QueueWork([dh = std::move(dh)] { return AsyncFrameDecrypt::Work(dh); });
+        if (not handler->KeyExchanges().Queue(recvPath, *this))
+          LogWarn(handler->Name(), " too many convos being started, dropping intro frame");
         return true;
       }
+      Endpoint::InboundFrame in{std::move(recvPath), *this, {}, {}, std::move(hook)};
 
-      auto v = std::make_shared<AsyncDecrypt>();
-
-      if (!handler->GetCachedSessionKeyFor(T, v->shared))
+      if (!handler->GetCachedSessionKeyFor(T, in.sessionKey))
       {
         LogError("No cached session for T=", T);
         return false;
       }
-      if (v->shared.IsZero())
+      if (in.sessionKey.IsZero())
       {
         LogError("bad cached session key for T=", T);
         return false;
       }
 
-      if (!handler->GetSenderFor(T, v->si))
+      if (!handler->GetSenderFor(T, in.sender))
       {
         LogError("No sender for T=", T);
         return false;
       }
-      if (v->si.Addr().IsZero())
+      if (in.sender.Addr().IsZero())
       {
         LogError("Bad sender for T=", T);
         return false;
       }
+      handler->QueueInboundFrame(std::move(in));
+      return true;
+    }
 
-      v->frame = *this;
-      auto callback = [loop, hook](std::shared_ptr<ProtocolMessage> msg) {
-        if (hook)
-        {
-          loop->call([msg, hook]() { hook(msg); });
-        }
-      };
-      handler->Router()->QueueWork(
-          [v, msg = std::move(msg), recvPath = std::move(recvPath), callback, handler]() {
-            auto resetTag = [handler, tag = v->frame.T, from = v->frame.F, path = recvPath]() {
-              handler->ResetConvoTag(tag, path, from);
-            };
-
-            if (not v->frame.Verify(v->si))
-            {
-              LogError("Signature failure from ", v->si.Addr());
-              handler->Loop()->call_soon(resetTag);
-              return;
-            }
-            if (not v->frame.DecryptPayloadInto(v->shared, *msg))
-            {
-              LogError("failed to decrypt message from ", v->si.Addr());
-              handler->Loop()->call_soon(resetTag);
-              return;
-            }
-            callback(msg);
-            RecvDataEvent ev;
-            ev.fromPath = std::move(recvPath);
-            ev.pathid = v->frame.F;
-            auto* handler = msg->handler;
-            ev.msg = std::move(msg);
-            handler->QueueRecvData(std::move(ev));
-          });
+    bool
+    ProtocolFrame::VerifyAndDecryptInPlace(
+        const ServiceInfo& from, const SharedSecret& sessionKey, ProtocolMessage& into)
+    {
+      // the signature is over the frame as sent with it zeroed, so check it before we decrypt
+      const Signature sig = Z;
+      Z.Zero();
+      std::array<byte_t, MAX_PROTOCOL_MESSAGE_SIZE> tmp;
+      llarp_buffer_t buf{tmp};
+      const bool encoded = BEncode(&buf);
+      Z = sig;
+      if (not encoded)
+        return false;
+      buf.sz = buf.cur - buf.base;
+      buf.cur = buf.base;
+      if (not from.Verify(buf, Z))
+      {
+        LogError("Signature failure from ", from.Addr());
+        return false;
+      }
+      auto payload = D.Buffer();
+      fast_crypto::xchacha20(*payload, sessionKey, N);
+      if (not bencode_decode_dict(into, payload))
+      {
+        LogError("failed to decrypt message from ", from.Addr());
+        return false;
+      }
       return true;
     }
 
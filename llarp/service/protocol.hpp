@@ -12,7 +12,10 @@
 #include <llarp/util/bencode.hpp>
 #include <llarp/util/time.hpp>
 #include <llarp/path/pathset.hpp>
+#include <llarp/util/thread/queue.hpp>
 
+#include <atomic>
+#include <optional>
 #include <vector>
 
 struct llarp_threadpool;
@@ -70,6 +73,20 @@ namespace llarp
       }
     };
 
+    /// bytes a batch entry takes besides its payload: protocol, sequence number and length
+    constexpr std::size_t BatchEntryOverhead = 1 + 8 + 2;
+
+    /// append a message to the payload of a ProtocolType::Batch message.  each entry keeps its own
+    /// protocol and sequence number so the receiver handles it as if it came in its own frame.
+    void
+    AppendBatchEntry(
+        std::vector<byte_t>& batch, ProtocolType t, uint64_t seqno, const llarp_buffer_t& payload);
+
+    /// split a ProtocolType::Batch message into the messages it carries, which come from the same
+    /// sender on the same convo; nullopt if it is malformed
+    std::optional<std::vector<std::shared_ptr<ProtocolMessage>>>
+    UnpackBatch(const ProtocolMessage& batch);
+
     /// outer message
     struct ProtocolFrame final : public routing::IMessage
     {
@@ -124,18 +141,27 @@ namespace llarp
 
       bool
       AsyncDecryptAndVerify(
-          EventLoop_ptr loop,
           path::Path_ptr fromPath,
-          const Identity& localIdent,
           Endpoint* handler,
           std::function<void(std::shared_ptr<ProtocolMessage>)> hook = nullptr) const;
 
       bool
       DecryptPayloadInto(const SharedSecret& sharedkey, ProtocolMessage& into) const;
 
+      /// check that from sent this frame, then decrypt it over itself into into, for a frame of
+      /// ours to do with as we please
+      bool
+      VerifyAndDecryptInPlace(
+          const ServiceInfo& from, const SharedSecret& sessionKey, ProtocolMessage& into);
+
       bool
       DecodeKey(const llarp_buffer_t& key, llarp_buffer_t* val) override;
 
+      /// decodes the keys after the message type in one pass; what InboundMessageParser uses.
+      /// unlike the other hot messages this copies D, which outlives the parse
+      bool
+      Decode(bencode::Reader& reader);
+
       bool
       BEncode(llarp_buffer_t* buf) const override;
 
@@ -164,5 +190,36 @@ namespace llarp
       bool
       HandleMessage(routing::IMessageHandler* h, AbstractRouter* r) const override;
     };
+
+    /// intro frames sent to an endpoint by remotes starting convos with it, waiting on their key
+    /// exchange.  they are worked through a batch at a time on the router's key exchange worker,
+    /// out of the way of decrypting established convos' traffic, and when more come in than it
+    /// keeps up with, the newest are dropped for their senders to try again.
+    class KeyExchangeStage
+    {
+     public:
+      static constexpr size_t QueueSize = 256;
+      static constexpr size_t BatchSize = 16;
+
+      explicit KeyExchangeStage(Endpoint* ep);
+
+      /// queue frame from path for its key exchange; false if we are too far behind to take it
+      bool
+      Queue(path::Path_ptr path, const ProtocolFrame& frame);
+
+     private:
+      struct Job
+      {
+        path::Path_ptr path;
+        ProtocolFrame frame;
+      };
+
+      void
+      Drain();
+
+      Endpoint* const m_Endpoint;
+      thread::Queue<Job> m_Queue;
+      std::atomic<bool> m_Scheduled{false};
+    };
   }  // namespace service
 }  // namespace llarp
@@ -17,7 +17,8 @@ namespace llarp::service
     Exit = 3UL,
     Auth = 4UL,
     QUIC = 5UL,
-
+    /// several small messages of the same convo packed into one, see AppendBatchEntry
+    Batch = 6UL,
   };
 
   constexpr std::string_view
@@ -30,6 +31,7 @@ namespace llarp::service
         : t == ProtocolType::Exit      ? "Exit"sv
         : t == ProtocolType::Auth      ? "Auth"sv
         : t == ProtocolType::QUIC      ? "QUIC"sv
+        : t == ProtocolType::Batch     ? "Batch"sv
                                        : "(unknown-protocol-type)"sv;
   }
 
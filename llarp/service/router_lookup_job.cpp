@@ -8,7 +8,7 @@ namespace llarp
   namespace service
   {
     RouterLookupJob::RouterLookupJob(Endpoint* p, RouterLookupHandler h)
-        : handler(std::move(h)), txid(p->GenTXID()), started(p->Now())
+        : handler(std::move(h)), started(p->Now())
     {}
 
   }  // namespace service
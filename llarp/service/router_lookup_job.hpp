@@ -2,6 +2,8 @@
 
 #include <llarp/router_contact.hpp>
 
+#include <unordered_set>
+
 namespace llarp
 {
   namespace service
@@ -10,10 +12,13 @@ namespace llarp
 
     struct RouterLookupJob
     {
+      static constexpr auto Timeout = 30s;
+
       RouterLookupJob(Endpoint* p, RouterLookupHandler h);
 
       RouterLookupHandler handler;
-      uint64_t txid;
+      /// one for each path we asked through that has not come up empty yet
+      std::unordered_set<uint64_t> txids;
       llarp_time_t started;
 
       bool
@@ -21,7 +26,13 @@ namespace llarp
       {
         if (now < started)
           return false;
-        return now - started > 30s;
+        return now - started > Timeout;
+      }
+
+      llarp_time_t
+      ExpiresAt() const
+      {
+        return started + Timeout;
       }
 
       void
@@ -3,6 +3,8 @@
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp/routing/path_transfer_message.hpp>
 #include "endpoint.hpp"
+#include <algorithm>
+#include <random>
 #include <utility>
 #include <unordered_set>
 #include <llarp/crypto/crypto.hpp>
@@ -12,6 +14,10 @@ namespace llarp
   namespace service
   {
     static constexpr size_t SendContextQueueSize = 512;
+    /// packets bigger than this are sent on their own even when coalescing
+    static constexpr size_t CoalesceMaxPacket = 512;
+    /// most we put in one batch, leaving room in the frame for the rest of the message
+    static constexpr size_t CoalesceMaxBatch = 1400;
 
     SendContext::SendContext(
         ServiceInfo ident, const Introduction& intro, path::PathSet* send, Endpoint* ep)
@@ -41,6 +47,7 @@ namespace llarp
     void
     SendContext::FlushUpstream()
     {
+      FlushCoalesced();
       auto r = m_Endpoint->Router();
       std::unordered_set<path::Path_ptr, path::Path::Ptr_Hash> flushpaths;
       auto rttRMS = 0ms;
@@ -68,9 +75,128 @@ namespace llarp
           static_cast<int64_t>(std::sqrt(rttRMS.count() / flushpaths.size()))};
     }
 
+    path::Path_ptr
+    SendContext::PickPath() const
+    {
+      if (not m_Endpoint->MultipathEnabled())
+        return m_PathSet->GetPathByRouter(remoteIntro.router);
+
+      // every path we stripe over ends at the intro's router, so the remote sees one intro;
+      // faster paths get more frames, and lossy ones a trickle so that they can recover
+      std::vector<std::pair<path::Path_ptr, double>> paths;
+      double total = 0;
+      m_PathSet->ForEachPath([&](const path::Path_ptr& path) {
+        if (not path->IsReady() or path->Endpoint() != remoteIntro.router)
+          return;
+        const auto latency = std::max(path->intro.latency, 1ms);
+        const auto weight = std::max(1 - path->LossEstimate(), 0.05) / latency.count();
+        paths.emplace_back(path, weight);
+        total += weight;
+      });
+      if (paths.empty())
+        return nullptr;
+      CSRNG rng{};
+      auto pick = std::uniform_real_distribution<double>{0, total}(rng);
+      for (const auto& [path, weight] : paths)
+      {
+        if (pick < weight)
+          return path;
+        pick -= weight;
+      }
+      return paths.back().first;
+    }
+
     /// send on an established convo tag
     void
     SendContext::EncryptAndSendTo(const llarp_buffer_t& payload, ProtocolType t)
+    {
+      // the sequence number is taken now either way, so that batching doesn't reorder anything
+      const auto seqno = m_Endpoint->GetSeqNoForConvo(currentConvoTag);
+      if (not seqno)
+      {
+        LogWarn(
+            m_PathSet->Name(), " could not get sequence number for session T=", currentConvoTag);
+        return;
+      }
+      const bool coalesce = m_Endpoint->CoalesceFramesEnabled() and t != ProtocolType::Auth
+          and payload.sz <= CoalesceMaxPacket and RemoteTakesBatches();
+      if (not coalesce)
+      {
+        FlushCoalesced();
+        SendFrame(t, *seqno, payload);
+        return;
+      }
+      Coalesce(t, *seqno, payload);
+      // what we hold goes out when the endpoint next pumps, which flushes us upstream
+      m_Endpoint->Router()->TriggerPump();
+    }
+
+    void
+    SendContext::AsyncEncryptAndSendTo(const std::vector<llarp_buffer_t>& payloads, ProtocolType t)
+    {
+      if (not IntroSent() or not RemoteTakesBatches() or t == ProtocolType::Auth)
+      {
+        for (const auto& payload : payloads)
+          AsyncEncryptAndSendTo(payload, t);
+        return;
+      }
+      for (const auto& payload : payloads)
+      {
+        const auto seqno = m_Endpoint->GetSeqNoForConvo(currentConvoTag);
+        if (not seqno)
+        {
+          LogWarn(
+              m_PathSet->Name(), " could not get sequence number for session T=", currentConvoTag);
+          break;
+        }
+        // anything that fits in a batch may share one here, big or small, since all of them are
+        // ready now and none has to wait for the rest
+        if (BatchEntryOverhead + payload.sz > CoalesceMaxBatch)
+        {
+          FlushCoalesced();
+          SendFrame(t, *seqno, payload);
+        }
+        else
+          Coalesce(t, *seqno, payload);
+      }
+      if (m_Endpoint->CoalesceFramesEnabled())
+        m_Endpoint->Router()->TriggerPump();
+      else
+        FlushCoalesced();
+    }
+
+    void
+    SendContext::Coalesce(ProtocolType t, uint64_t seqno, const llarp_buffer_t& payload)
+    {
+      if (m_CoalescedBytes + BatchEntryOverhead + payload.sz > CoalesceMaxBatch)
+        FlushCoalesced();
+      m_Coalesced.emplace_back(
+          t, seqno, std::vector<byte_t>{payload.base, payload.base + payload.sz});
+      m_CoalescedBytes += BatchEntryOverhead + payload.sz;
+    }
+
+    void
+    SendContext::FlushCoalesced()
+    {
+      if (m_Coalesced.empty())
+        return;
+      auto coalesced = std::exchange(m_Coalesced, {});
+      m_CoalescedBytes = 0;
+      if (coalesced.size() == 1)
+      {
+        auto& [t, seqno, data] = coalesced.front();
+        SendFrame(t, seqno, llarp_buffer_t{data});
+        return;
+      }
+      std::vector<byte_t> batch;
+      for (auto& [t, seqno, data] : coalesced)
+        AppendBatchEntry(batch, t, seqno, llarp_buffer_t{data});
+      // the batch itself goes out under the first entry's sequence number, which nothing else uses
+      SendFrame(ProtocolType::Batch, std::get<1>(coalesced.front()), llarp_buffer_t{batch});
+    }
+
+    void
+    SendContext::SendFrame(ProtocolType t, uint64_t seqno, const llarp_buffer_t& payload)
     {
       SharedSecret shared;
       auto f = std::make_shared<ProtocolFrame>();
@@ -79,7 +205,7 @@ namespace llarp
       f->T = currentConvoTag;
       f->S = ++sequenceNo;
 
-      auto path = m_PathSet->GetPathByRouter(remoteIntro.router);
+      auto path = PickPath();
       if (!path)
       {
         ShiftIntroRouter(remoteIntro.router);
@@ -98,28 +224,22 @@ namespace llarp
       m_DataHandler->PutIntroFor(f->T, remoteIntro);
       m_DataHandler->PutReplyIntroFor(f->T, path->intro);
       m->proto = t;
-      if (auto maybe = m_Endpoint->GetSeqNoForConvo(f->T))
-      {
-        m->seqno = *maybe;
-      }
-      else
-      {
-        LogWarn(m_PathSet->Name(), " could not get sequence number for session T=", f->T);
-        return;
-      }
+      m->seqno = seqno;
       m->introReply = path->intro;
       f->F = m->introReply.pathID;
       m->sender = m_Endpoint->GetIdentity().pub;
       m->tag = f->T;
       m->PutBuffer(payload);
-      m_Endpoint->Router()->QueueWork([f, m, shared, path, this] {
-        if (not f->EncryptAndSign(*m, shared, m_Endpoint->GetIdentity()))
-        {
-          LogError(m_PathSet->Name(), " failed to sign message");
-          return;
-        }
-        Send(f, path);
-      });
+      m_Endpoint->Router()->QueueWork(
+          [f, m, shared, path, this] {
+            if (not f->EncryptAndSign(*m, shared, m_Endpoint->GetIdentity()))
+            {
+              LogError(m_PathSet->Name(), " failed to sign message");
+              return;
+            }
+            Send(f, path);
+          },
+          thread::WorkClass::DataPlane);
     }
 
     void
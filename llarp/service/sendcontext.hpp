@@ -9,6 +9,8 @@
 #include <llarp/util/thread/queue.hpp>
 
 #include <deque>
+#include <tuple>
+#include <vector>
 
 namespace llarp
 {
@@ -25,6 +27,11 @@ namespace llarp
       void
       AsyncEncryptAndSendTo(const llarp_buffer_t& payload, ProtocolType t);
 
+      /// send several payloads of one protocol that are ready at once, packing the ones that fit
+      /// together into batch frames if the remote takes them
+      void
+      AsyncEncryptAndSendTo(const std::vector<llarp_buffer_t>& payloads, ProtocolType t);
+
       /// queue send a fully encrypted hidden service frame
       /// via a path
       bool
@@ -84,8 +91,33 @@ namespace llarp
       void
       EncryptAndSendTo(const llarp_buffer_t& payload, ProtocolType t);
 
+      /// the path to send the next frame down: the best one to the remote intro's router, or in
+      /// multipath mode any ready one to it, picked at random weighted by rtt and loss
+      path::Path_ptr
+      PickPath() const;
+
       virtual void
       AsyncGenIntro(const llarp_buffer_t& payload, ProtocolType t) = 0;
+
+      /// true if the remote end says it can unpack ProtocolType::Batch messages
+      virtual bool
+      RemoteTakesBatches() const = 0;
+
+      /// encrypt and send one frame carrying payload, as sequence number seqno of the convo
+      void
+      SendFrame(ProtocolType t, uint64_t seqno, const llarp_buffer_t& payload);
+
+      /// hold payload to go out with the others we hold, sending those first if it doesn't fit
+      void
+      Coalesce(ProtocolType t, uint64_t seqno, const llarp_buffer_t& payload);
+
+      /// send what we have coalesced, as one batch frame if there is more than one
+      void
+      FlushCoalesced();
+
+      /// small messages waiting to go out together, with their convo sequence numbers
+      std::vector<std::tuple<ProtocolType, uint64_t, std::vector<byte_t>>> m_Coalesced;
+      size_t m_CoalescedBytes = 0;
     };
   }  // namespace service
 }  // namespace llarp
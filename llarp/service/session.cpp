@@ -36,6 +36,15 @@ namespace llarp
       return now >= lastUsed && (now - lastUsed > lifetime);
     }
 
+    llarp_time_t
+    Session::ExpiresAt(llarp_time_t lifetime) const
+    {
+      const auto lastUsed = std::max(lastSend, lastRecv);
+      if (lastUsed == 0s)
+        return intro.expiresAt;
+      return lastUsed + lifetime;
+    }
+
     void
     Session::TX()
     {
@@ -36,6 +36,11 @@ namespace llarp
       Duration_t lastSend{};
       Duration_t lastRecv{};
 
+      /// for an inbound session, the path of ours we last sent on to replyIntro.router, good
+      /// while the endpoint's path generation stays sendPathGeneration
+      std::weak_ptr<path::Path> sendPath;
+      uint64_t sendPathGeneration = 0;
+
       util::StatusObject
       ExtractStatus() const;
 
@@ -50,6 +55,11 @@ namespace llarp
       bool
       IsExpired(llarp_time_t now, llarp_time_t lifetime = SessionLifetime) const;
 
+      /// when IsExpired comes true if nothing uses the session before then; not meaningful for
+      /// forever sessions
+      llarp_time_t
+      ExpiresAt(llarp_time_t lifetime = SessionLifetime) const;
+
       Address
       Addr() const;
     };
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <llarp/path/path.hpp>
+#include <llarp/router_id.hpp>
+#include <llarp/service/convotag.hpp>
+#include <llarp/util/logging.hpp>
+#include <llarp/util/time.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace llarp::service
+{
+  /// established paths that one endpoint's outbound contexts built aligned to a remote's intro
+  /// routers, shared by the endpoint's other outbound contexts, so that those talking to the
+  /// same popular service (one session after another, or to several of its addresses) don't
+  /// each build and keep up paths of their own to the same routers.  an endpoint keeps its own;
+  /// sharing a path across endpoints would let every hop on it tie them together.
+  ///
+  /// a path is counted as used by the context that built it and every context that took it from
+  /// here since.  the first of them still around owns it, in that the path reports its build and
+  /// death to it; the rest just send over it.  once a second user takes a path, traffic coming
+  /// back on it goes to the user whose convo tag it carries, and drops go to all users, each of
+  /// which checks if it was theirs.
+  ///
+  /// User is OutboundContext, or a stand in for it in the tests: it has a currentConvoTag, takes
+  /// frames and drops as HandleHiddenServiceFrame and HandleDataDrop do, and with
+  /// TakeOverSharedPath makes a path we hand it report to it.
+  template <typename User>
+  class SharedPaths
+  {
+   public:
+    /// most contexts that share one path, so that a few paths don't carry all the traffic we
+    /// have with a service
+    static constexpr size_t MaxUsers = 8;
+
+    /// shares p, an established path owner built, with owner as its only user for now.  does
+    /// nothing if p is shared already.
+    void
+    Offer(path::Path_ptr p, const std::shared_ptr<User>& owner)
+    {
+      auto& shared = m_Paths[p->Endpoint()];
+      if (std::any_of(shared.begin(), shared.end(), [&p](const auto& s) { return s.path == p; }))
+        return;
+      auto users = std::make_shared<Users_t>();
+      users->emplace_back(owner);
+      shared.push_back(Shared{std::move(p), std::move(users)});
+    }
+
+    /// a shared path ending at endpoint of numHops hops with at least min_intro_lifetime left
+    /// in it, that user does not use yet, with user counted as one of its users; the one with
+    /// the fewest users.  nullptr if we have none.
+    path::Path_ptr
+    Acquire(
+        const RouterID& endpoint,
+        size_t numHops,
+        const std::shared_ptr<User>& user,
+        llarp_time_t now)
+    {
+      auto itr = m_Paths.find(endpoint);
+      if (itr == m_Paths.end())
+        return nullptr;
+      Shared* best = nullptr;
+      size_t bestUsers = MaxUsers;
+      for (auto& shared : itr->second)
+      {
+        const auto& path = shared.path;
+        if (not path->IsReady() or path->hops.size() != numHops
+            or path->ExpiresSoon(now, path::min_intro_lifetime))
+          continue;
+        const auto& users = *shared.users;
+        if (std::any_of(users.begin(), users.end(), [&user](const auto& weak) {
+              return weak.lock() == user;
+            }))
+          continue;
+        if (const auto n = LiveUsers(users); n < bestUsers)
+        {
+          best = &shared;
+          bestUsers = n;
+        }
+      }
+      if (not best)
+        return nullptr;
+      best->users->emplace_back(user);
+      // until now the path's handlers were all its owner's
+      if (not best->handlersShared)
+        ShareHandlers(*best);
+      return best->path;
+    }
+
+    /// user no longer uses any of our paths.  for each path it was the owner of, the next user
+    /// takes it over; the ones no one else uses we stop sharing.  returns the paths that still
+    /// have other users, which user must not tear down.
+    std::vector<path::Path_ptr>
+    Release(const User* user)
+    {
+      std::vector<path::Path_ptr> stillUsed;
+      for (auto map_itr = m_Paths.begin(); map_itr != m_Paths.end();)
+      {
+        auto& shared = map_itr->second;
+        for (auto itr = shared.begin(); itr != shared.end();)
+        {
+          auto& users = *itr->users;
+          users.erase(
+              std::remove_if(
+                  users.begin(), users.end(), [](const auto& weak) { return weak.expired(); }),
+              users.end());
+          const auto found = std::find_if(users.begin(), users.end(), [user](const auto& weak) {
+            return weak.lock().get() == user;
+          });
+          if (found == users.end())
+          {
+            ++itr;
+            continue;
+          }
+          const bool wasOwner = found == users.begin();
+          users.erase(found);
+          if (users.empty())
+          {
+            itr = shared.erase(itr);
+            continue;
+          }
+          stillUsed.push_back(itr->path);
+          if (wasOwner)
+          {
+            auto next = users.front().lock();
+            next->TakeOverSharedPath(itr->path);
+            log::debug(
+                log::Cat("service"),
+                "{} takes over shared path {}",
+                next->Name(),
+                itr->path->ShortName());
+          }
+          ++itr;
+        }
+        if (shared.empty())
+          map_itr = m_Paths.erase(map_itr);
+        else
+          ++map_itr;
+      }
+      return stillUsed;
+    }
+
+    /// stops sharing the paths that are no use any more, or no one uses
+    void
+    Decay(llarp_time_t now)
+    {
+      for (auto itr = m_Paths.begin(); itr != m_Paths.end();)
+      {
+        auto& shared = itr->second;
+        shared.erase(
+            std::remove_if(
+                shared.begin(),
+                shared.end(),
+                [now](const auto& s) {
+                  return not s.path->IsReady() or s.path->Expired(now)
+                      or LiveUsers(*s.users) == 0;
+                }),
+            shared.end());
+        if (shared.empty())
+          itr = m_Paths.erase(itr);
+        else
+          ++itr;
+      }
+    }
+
+    /// the user a frame coming back on path for the convo tag goes to, which is nullptr if the
+    /// path is not shared or has no users left
+    std::shared_ptr<User>
+    FrameUser(const path::Path_ptr& path, const ConvoTag& tag) const
+    {
+      if (auto itr = m_Paths.find(path->Endpoint()); itr != m_Paths.end())
+      {
+        for (const auto& shared : itr->second)
+        {
+          if (shared.path == path)
+            return UserFor(*shared.users, tag);
+        }
+      }
+      return nullptr;
+    }
+
+    /// how many paths we share
+    size_t
+    Size() const
+    {
+      size_t n = 0;
+      for (const auto& [endpoint, shared] : m_Paths)
+        n += shared.size();
+      return n;
+    }
+
+   private:
+    using Users_t = std::vector<std::weak_ptr<User>>;
+
+    struct Shared
+    {
+      path::Path_ptr path;
+      /// the path's handlers hold these too once shared, so it outlives our entry for as long as
+      /// the path
+      std::shared_ptr<Users_t> users;
+      /// whether the path's handlers are ours rather than its owner's
+      bool handlersShared = false;
+    };
+
+    static size_t
+    LiveUsers(const Users_t& users)
+    {
+      return std::count_if(
+          users.begin(), users.end(), [](const auto& user) { return not user.expired(); });
+    }
+
+    /// the user whose convo tag is tag, or else the owner, as it would have the frame were the
+    /// path not shared
+    static std::shared_ptr<User>
+    UserFor(const Users_t& users, const ConvoTag& tag)
+    {
+      std::shared_ptr<User> first;
+      for (const auto& weak : users)
+      {
+        auto user = weak.lock();
+        if (not user)
+          continue;
+        if (user->currentConvoTag == tag)
+          return user;
+        if (not first)
+          first = std::move(user);
+      }
+      return first;
+    }
+
+    /// points the path's frames and drops at whichever of its users they are for
+    static void
+    ShareHandlers(Shared& shared)
+    {
+      shared.handlersShared = true;
+      shared.path->SetDataHandler([users = shared.users](auto path, const ProtocolFrame& frame) {
+        const auto user = UserFor(*users, frame.T);
+        return user and user->HandleHiddenServiceFrame(path, frame);
+      });
+      shared.path->SetDropHandler([users = shared.users](auto path, auto id, auto seqno) {
+        bool handled = false;
+        for (const auto& weak : *users)
+        {
+          if (auto user = weak.lock())
+            handled = user->HandleDataDrop(path, id, seqno) or handled;
+        }
+        return handled;
+      });
+    }
+
+    /// by the router the paths end at
+    std::unordered_map<RouterID, std::vector<Shared>> m_Paths;
+  };
+}  // namespace llarp::service
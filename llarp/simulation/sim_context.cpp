@@ -1,32 +1,187 @@
 #include "sim_context.hpp"
-#include <llarp.hpp>
+#include "sim_router.hpp"
 
-namespace llarp
+#include <llarp/config/config.hpp>
+#include <llarp/nodedb.hpp>
+#include <llarp/router/abstractrouter.hpp>
+#include <llarp/util/logging.hpp>
+
+#include <algorithm>
+#include <csignal>
+
+namespace llarp::simulate
 {
-  namespace simulate
+  static auto logcat = log::Cat("sim");
+
+  /// the port relays take inbound links on
+  static constexpr uint16_t RelayPort = 1090;
+
+  NodeContext::NodeContext(std::shared_ptr<NodeLoop> loop, bool isRelay)
+      : isRelay{isRelay}, m_Loop{std::move(loop)}
+  {
+    this->loop = m_Loop;
+  }
+
+  std::shared_ptr<AbstractRouter>
+  NodeContext::makeRouter(const EventLoop_ptr& loop)
+  {
+    return std::make_shared<SimRouter>(loop, makeVPNPlatform());
+  }
+
+  std::shared_ptr<NodeDB>
+  NodeContext::makeNodeDB()
+  {
+    return std::make_shared<NodeDB>();
+  }
+
+  Simulation::Simulation(fs::path root, uint64_t seed)
+      : m_Root{std::move(root)}, m_CryptoManager{&m_Crypto}, m_Net{m_Sched, seed}
+  {}
+
+  Simulation::~Simulation()
+  {
+    Stop();
+    m_Relays.clear();
+    m_Clients.clear();
+    // each router's context set the crypto in turn as it was set up, so they have to go in the
+    // other order for it to be put back right
+    while (not m_Started.empty())
+      m_Started.pop_back();
+  }
+
+  Node_ptr
+  Simulation::AddNode(bool isRelay, ConfigTweak tweak)
+  {
+    auto& nodes = isRelay ? m_Relays : m_Clients;
+    const auto ip = m_Net.AddNode();
+    const auto dir = m_Root / (isRelay ? "relays" : "clients") / std::to_string(nodes.size());
+    fs::create_directories(dir);
+
+    auto conf = std::make_shared<Config>(dir);
+    if (not conf->Load(std::nullopt, isRelay))
+      throw std::runtime_error{"failed to load a simulated router's config"};
+    conf->router.m_dataDir = dir;
+    conf->router.m_netId = "simnet";
+    conf->router.m_nickname = fmt::format("sim{}", ip);
+    conf->router.m_blockBogons = false;
+    conf->network.m_enableProfiling = false;
+    conf->network.m_endpointType = "null";
+    conf->api.m_enableRPCServer = false;
+    conf->api.m_metricsBindAddress.reset();
+    conf->lokid.whitelistRouters = false;
+    conf->links.OutboundLinks = {SockAddr{ip}};
+    conf->links.InboundListenAddrs.clear();
+    if (isRelay)
+      conf->links.InboundListenAddrs.emplace_back(ip, huint16_t{RelayPort});
+    if (tweak)
+      tweak(*conf);
+
+    auto node =
+        std::make_shared<NodeContext>(std::make_shared<NodeLoop>(m_Sched, m_Net, ip), isRelay);
+    node->Configure(std::move(conf));
+    nodes.push_back(node);
+    return node;
+  }
+
+  Node_ptr
+  Simulation::AddRelay(ConfigTweak tweak)
+  {
+    return AddNode(true, std::move(tweak));
+  }
+
+  Node_ptr
+  Simulation::AddClient(ConfigTweak tweak)
+  {
+    return AddNode(false, std::move(tweak));
+  }
+
+  void
+  Simulation::StartNode(const Node_ptr& node_ptr)
   {
-    Simulation::Simulation() : m_CryptoManager(new sodium::CryptoLibSodium())
-    {}
+    auto& node = *node_ptr;
+    m_Started.push_back(node_ptr);
+    auto conf = node.GetConfig();
+    const bool seed = node.isRelay and m_SeedRCs.size() < m_SeedCount;
+    conf->bootstrap.seednode = seed and m_SeedRCs.empty();
+    conf->bootstrap.routers.insert(m_SeedRCs.begin(), m_SeedRCs.end());
 
-    void
-    Simulation::NodeUp(llarp::Context*)
-    {}
+    node.Setup(RuntimeOptions{false, false, node.isRelay});
+    if (not node.router->Run())
+      throw std::runtime_error{fmt::format("simulated router {} failed to start", node.IP())};
+    node.started = true;
+    if (seed)
+      m_SeedRCs.push_back(node.router->rc());
+  }
 
-    Node_ptr
-    Simulation::AddNode(const std::string& name)
+  void
+  Simulation::Start()
+  {
+    size_t started = 0;
+    for (const auto* nodes : {&m_Relays, &m_Clients})
     {
-      auto itr = m_Nodes.find(name);
-      if (itr == m_Nodes.end())
+      for (const auto& node : *nodes)
       {
-        itr = m_Nodes.emplace(name, std::make_shared<llarp::Context>(shared_from_this())).first;
+        if (node->started)
+          continue;
+        StartNode(node);
+        ++started;
       }
-      return itr->second;
     }
+    log::info(logcat, "started {} simulated routers", started);
+  }
 
-    void
-    Simulation::DelNode(const std::string& name)
+  void
+  Simulation::Stop()
+  {
+    size_t up = 0;
+    for (const auto* nodes : {&m_Relays, &m_Clients})
+    {
+      for (const auto& node : *nodes)
+      {
+        if (node->IsUp())
+        {
+          node->HandleSignal(SIGINT);
+          ++up;
+        }
+      }
+    }
+    // stopping takes a little while for the links to close, but not this long
+    const auto giveUp = m_Sched.Now() + 1min;
+    while (up and m_Sched.Now() < giveUp)
     {
-      m_Nodes.erase(name);
+      m_Sched.RunFor(1s);
+      up = 0;
+      for (const auto* nodes : {&m_Relays, &m_Clients})
+        up += std::count_if(
+            nodes->begin(), nodes->end(), [](const auto& node) { return node->IsUp(); });
     }
-  }  // namespace simulate
-}  // namespace llarp
+    if (up)
+      log::warning(logcat, "{} simulated routers did not stop", up);
+  }
+
+  util::StatusObject
+  Simulation::ExtractStatus() const
+  {
+    const auto count = [](const std::vector<Node_ptr>& nodes) {
+      size_t up = 0;
+      size_t connected = 0;
+      for (const auto& node : nodes)
+      {
+        if (not node->IsUp())
+          continue;
+        ++up;
+        connected += node->router->NumberOfConnectedRouters();
+      }
+      return util::StatusObject{
+          {"added", nodes.size()}, {"up", up}, {"connections", connected}};
+    };
+    return util::StatusObject{
+        {"now", ToMS(m_Sched.Now())},
+        {"eventsRun", m_Sched.Ran()},
+        {"eventsPending", m_Sched.Pending()},
+        {"relays", count(m_Relays)},
+        {"clients", count(m_Clients)},
+        {"network", m_Net.ExtractStatus()}};
+  }
+
+}  // namespace llarp::simulate
@@ -1,32 +1,155 @@
 #pragma once
+
+#include "sim_loop.hpp"
+#include "sim_network.hpp"
+
+#include <llarp.hpp>
 #include <llarp/crypto/crypto_libsodium.hpp>
-#include <llarp/ev/ev.hpp>
+#include <llarp/router_contact.hpp>
+#include <llarp/util/fs.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 namespace llarp
 {
-  // forward declair
-  struct Context;
-  using Node_ptr = std::shared_ptr<llarp::Context>;
+  struct Config;
 
   namespace simulate
   {
-    struct Simulation : public std::enable_shared_from_this<Simulation>
+    /// one simulated router: its router is a SimRouter on a NodeLoop, and its nodedb is kept in
+    /// memory
+    struct NodeContext : public llarp::Context
     {
-      Simulation();
+      NodeContext(std::shared_ptr<NodeLoop> loop, bool isRelay);
+
+      std::shared_ptr<AbstractRouter>
+      makeRouter(const EventLoop_ptr& loop) override;
 
-      llarp::CryptoManager m_CryptoManager;
-      EventLoop_ptr m_NetLoop;
+      std::shared_ptr<NodeDB>
+      makeNodeDB() override;
 
-      std::unordered_map<std::string, Node_ptr> m_Nodes;
+      /// the router's address on the simulated network
+      huint32_t
+      IP() const
+      {
+        return m_Loop->IP();
+      }
+
+      std::shared_ptr<Config>
+      GetConfig() const
+      {
+        return config;
+      }
+
+      const bool isRelay;
+      bool started = false;
+
+     private:
+      std::shared_ptr<NodeLoop> m_Loop;
+    };
 
+    using Node_ptr = std::shared_ptr<NodeContext>;
+
+    /// a whole network of routers run in this process, on one thread, in virtual time.  they
+    /// share a Scheduler in place of an event loop each and talk over an in-memory Network in
+    /// place of udp, and their work is done inline rather than on oxenmq workers, so running
+    /// thousands of them costs what they do and nothing more, and a run with the same seed goes
+    /// the same way every time.  routers run with null endpoints and without rpc or oxend.
+    ///
+    ///     Simulation sim{"/tmp/lokinet-sim"};
+    ///     for (int i = 0; i < 2000; ++i)
+    ///       sim.AddRelay();
+    ///     sim.AddClient();
+    ///     sim.Start();
+    ///     sim.RunFor(10min);
+    class Simulation
+    {
+     public:
+      /// edits a router's config after we have set it up to run in the simulation
+      using ConfigTweak = std::function<void(Config&)>;
+
+      /// routers' keys go in a directory each under `root`; `seed` is what the network's loss
+      /// and jitter are drawn from
+      explicit Simulation(fs::path root, uint64_t seed = 0);
+      ~Simulation();
+
+      Scheduler&
+      Sched()
+      {
+        return m_Sched;
+      }
+
+      Network&
+      Net()
+      {
+        return m_Net;
+      }
+
+      /// how many of the first relays started everyone else bootstraps from
       void
-      NodeUp(llarp::Context* node);
+      SetSeedCount(size_t seeds)
+      {
+        m_SeedCount = std::max<size_t>(seeds, 1);
+      }
 
       Node_ptr
-      AddNode(const std::string& name);
+      AddRelay(ConfigTweak tweak = nullptr);
+
+      Node_ptr
+      AddClient(ConfigTweak tweak = nullptr);
+
+      /// starts every router added since last time: seeds first, then the rest bootstrapping off
+      /// them
+      void
+      Start();
+
+      void
+      RunFor(llarp_time_t duration)
+      {
+        m_Sched.RunFor(duration);
+      }
+
+      /// stops every router and runs until they have finished stopping
+      void
+      Stop();
+
+      const std::vector<Node_ptr>&
+      Relays() const
+      {
+        return m_Relays;
+      }
+
+      const std::vector<Node_ptr>&
+      Clients() const
+      {
+        return m_Clients;
+      }
+
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      Node_ptr
+      AddNode(bool isRelay, ConfigTweak tweak);
 
       void
-      DelNode(const std::string& name);
+      StartNode(const Node_ptr& node);
+
+      const fs::path m_Root;
+      // before the routers, and gone after them: they all read its clock and its crypto
+      Scheduler m_Sched;
+      sodium::CryptoLibSodium m_Crypto;
+      CryptoManager m_CryptoManager;
+      Network m_Net;
+
+      size_t m_SeedCount = 1;
+      std::vector<RouterContact> m_SeedRCs;
+      std::vector<Node_ptr> m_Relays;
+      std::vector<Node_ptr> m_Clients;
+      /// in the order they were set up
+      std::vector<Node_ptr> m_Started;
     };
 
     using Sim_ptr = std::shared_ptr<Simulation>;
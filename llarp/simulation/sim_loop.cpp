@@ -0,0 +1,280 @@
+#include "sim_loop.hpp"
+#include "sim_network.hpp"
+
+#include <llarp/util/logging.hpp>
+
+#include <algorithm>
+#include <atomic>
+
+namespace llarp::simulate
+{
+  static auto logcat = log::Cat("sim");
+
+  Scheduler::Scheduler() : m_Now{time_now_ms()}, m_Thread{std::this_thread::get_id()}
+  {
+    set_virtual_time(&m_Now);
+  }
+
+  Scheduler::~Scheduler()
+  {
+    set_virtual_time(nullptr);
+  }
+
+  void
+  Scheduler::Push(llarp_time_t when, std::function<void()> f)
+  {
+    m_Events.push_back(Event{std::max(when, m_Now), m_Seq++, std::move(f)});
+    std::push_heap(m_Events.begin(), m_Events.end());
+  }
+
+  void
+  Scheduler::At(llarp_time_t when, std::function<void()> f)
+  {
+    if (InScheduler())
+      return Push(when, std::move(f));
+    std::lock_guard lock{m_IncomingMutex};
+    m_Incoming.emplace_back(when, std::move(f));
+  }
+
+  void
+  Scheduler::TakeIncoming()
+  {
+    decltype(m_Incoming) incoming;
+    {
+      std::lock_guard lock{m_IncomingMutex};
+      if (m_Incoming.empty())
+        return;
+      incoming.swap(m_Incoming);
+    }
+    for (auto& [when, f] : incoming)
+      Push(when, std::move(f));
+  }
+
+  bool
+  Scheduler::Step()
+  {
+    TakeIncoming();
+    if (m_Events.empty())
+      return false;
+    std::pop_heap(m_Events.begin(), m_Events.end());
+    auto ev = std::move(m_Events.back());
+    m_Events.pop_back();
+    m_Now = ev.when;
+    ++m_Ran;
+    ev.f();
+    return true;
+  }
+
+  void
+  Scheduler::RunUntil(llarp_time_t until)
+  {
+    while (true)
+    {
+      TakeIncoming();
+      if (m_Events.empty() or m_Events.front().when >= until)
+        break;
+      Step();
+    }
+    m_Now = std::max(m_Now, until);
+  }
+
+  namespace
+  {
+    class SimWakeup final : public EventLoopWakeup
+    {
+      struct Waker
+      {
+        std::function<void()> callback;
+        std::atomic<bool> triggered{false};
+      };
+
+      /// queues the wakeup on the node's loop
+      std::function<void(std::function<void()>)> m_Queue;
+      std::shared_ptr<Waker> m_Waker;
+
+     public:
+      SimWakeup(std::function<void(std::function<void()>)> queue, std::function<void()> callback)
+          : m_Queue{std::move(queue)}, m_Waker{std::make_shared<Waker>()}
+      {
+        m_Waker->callback = std::move(callback);
+      }
+
+      void
+      Trigger() override
+      {
+        if (m_Waker->triggered.exchange(true))
+          return;
+        m_Queue([waker = std::weak_ptr<Waker>{m_Waker}] {
+          if (auto w = waker.lock())
+          {
+            w->triggered = false;
+            w->callback();
+          }
+        });
+      }
+    };
+
+    class SimRepeater final : public EventLoopRepeater
+    {
+      Scheduler& m_Sched;
+      std::weak_ptr<NodeLoop::State> m_State;
+      std::shared_ptr<NodeLoop::Timer> m_Timer;
+
+      static void
+      Schedule(
+          Scheduler& sched,
+          std::weak_ptr<NodeLoop::State> state,
+          std::weak_ptr<NodeLoop::Timer> timer,
+          llarp_time_t every)
+      {
+        sched.After(
+            every, [&sched, state = std::move(state), timer = std::move(timer), every]() mutable {
+              auto s = state.lock();
+              auto t = timer.lock();
+              if (not s or not s->running or not t or t->cancelled)
+                return;
+              t->task();
+              if (not t->cancelled)
+                Schedule(sched, std::move(state), std::move(timer), every);
+            });
+      }
+
+     public:
+      SimRepeater(Scheduler& sched, std::weak_ptr<NodeLoop::State> state)
+          : m_Sched{sched}, m_State{std::move(state)}, m_Timer{std::make_shared<NodeLoop::Timer>()}
+      {}
+
+      ~SimRepeater() override
+      {
+        m_Timer->cancelled = true;
+      }
+
+      void
+      start(llarp_time_t every, std::function<void()> task, const char*) override
+      {
+        m_Timer->task = std::move(task);
+        if (auto s = m_State.lock())
+          s->timers.push_back(m_Timer);
+        Schedule(m_Sched, m_State, m_Timer, std::max(every, 1ms));
+      }
+    };
+  }  // namespace
+
+  NodeLoop::NodeLoop(Scheduler& sched, Network& net, huint32_t ip)
+      : m_Sched{sched}, m_Net{net}, m_IP{ip}, m_State{std::make_shared<State>()}
+  {}
+
+  NodeLoop::~NodeLoop()
+  {
+    stop();
+  }
+
+  std::function<void()>
+  NodeLoop::Guard(std::function<void()> f) const
+  {
+    return [state = std::weak_ptr<State>{m_State}, f = std::move(f)] {
+      if (auto s = state.lock(); s and s->running)
+        f();
+    };
+  }
+
+  void
+  NodeLoop::run()
+  {
+    while (running() and m_Sched.Step())
+      ;
+  }
+
+  void
+  NodeLoop::call_soon(std::function<void(void)> f)
+  {
+    m_Sched.At(m_Sched.Now(), Guard(std::move(f)));
+    wakeup();
+  }
+
+  void
+  NodeLoop::call_later(llarp_time_t delay_ms, std::function<void(void)> callback)
+  {
+    m_Sched.At(m_Sched.Now() + delay_ms, Guard(std::move(callback)));
+  }
+
+  bool
+  NodeLoop::add_network_interface(
+      std::shared_ptr<vpn::NetworkInterface>, std::function<void(net::IPPacket)>)
+  {
+    log::error(logcat, "simulated routers have no network interfaces; use a null endpoint");
+    return false;
+  }
+
+  bool
+  NodeLoop::add_ticker(std::function<void(void)> ticker)
+  {
+    m_State->tickers.push_back(std::move(ticker));
+    return true;
+  }
+
+  void
+  NodeLoop::wakeup()
+  {
+    if (m_State->ticking or not m_State->running)
+      return;
+    m_State->ticking = true;
+    m_Sched.At(m_Sched.Now(), Guard([s = m_State.get()] {
+      s->ticking = false;
+      // by index: a ticker may add another, or stop us and take them all away
+      for (size_t i = 0; i < s->tickers.size(); ++i)
+        s->tickers[i]();
+    }));
+  }
+
+  void
+  NodeLoop::stop()
+  {
+    if (not m_State->running)
+      return;
+    m_State->running = false;
+    // we may be inside one of these now, so they are only dropped once it has returned
+    std::vector<std::shared_ptr<Timer>> timers;
+    for (const auto& weak : m_State->timers)
+    {
+      if (auto t = weak.lock())
+      {
+        t->cancelled = true;
+        timers.push_back(std::move(t));
+      }
+    }
+    m_State->timers.clear();
+    m_Sched.At(
+        m_Sched.Now(),
+        [timers = std::move(timers), tickers = std::move(m_State->tickers)]() mutable {
+          for (auto& t : timers)
+            t->task = nullptr;
+        });
+    m_State->tickers.clear();
+  }
+
+  std::shared_ptr<UDPHandle>
+  NodeLoop::make_udp(UDPReceiveFunc on_recv)
+  {
+    return m_Net.MakeUDP(m_IP, m_State, std::move(on_recv));
+  }
+
+  std::shared_ptr<EventLoopWakeup>
+  NodeLoop::make_waker(std::function<void()> callback)
+  {
+    return std::make_shared<SimWakeup>(
+        [this, state = std::weak_ptr<State>{m_State}](std::function<void()> f) {
+          // the waker may outlive us, but then it has nothing left to wake
+          if (auto s = state.lock(); s and s->running)
+            m_Sched.At(m_Sched.Now(), Guard(std::move(f)));
+        },
+        std::move(callback));
+  }
+
+  std::shared_ptr<EventLoopRepeater>
+  NodeLoop::make_repeater()
+  {
+    return std::make_shared<SimRepeater>(m_Sched, m_State);
+  }
+
+}  // namespace llarp::simulate
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <llarp/ev/ev.hpp>
+#include <llarp/net/net_int.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace llarp::simulate
+{
+  class Network;
+
+  /// the one virtual clock and queue of timed events that every router in a simulation runs on.
+  /// time only moves when the next event is due, so a simulated hour of a quiet network takes as
+  /// long as the work done in it; work itself takes no virtual time at all.  while it exists it is
+  /// what time_now_ms() reads, so there can only be one at a time.
+  class Scheduler
+  {
+   public:
+    /// starts the clock at the real time now, so that rc timestamps and the like look sane
+    Scheduler();
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler&
+    operator=(const Scheduler&) = delete;
+
+    llarp_time_t
+    Now() const
+    {
+      return m_Now;
+    }
+
+    /// runs `f` at virtual time `when` (or now, if that has passed); events due at the same time
+    /// run in the order they were added.  can be called from any thread.
+    void
+    At(llarp_time_t when, std::function<void()> f);
+
+    void
+    After(llarp_time_t delay, std::function<void()> f)
+    {
+      At(m_Now + delay, std::move(f));
+    }
+
+    /// runs the next event, moving the clock up to it; returns false if there was none
+    bool
+    Step();
+
+    /// runs every event due before `until` and leaves the clock at `until`
+    void
+    RunUntil(llarp_time_t until);
+
+    void
+    RunFor(llarp_time_t duration)
+    {
+      RunUntil(m_Now + duration);
+    }
+
+    /// how many events are waiting
+    size_t
+    Pending() const
+    {
+      return m_Events.size();
+    }
+
+    /// how many events have run
+    uint64_t
+    Ran() const
+    {
+      return m_Ran;
+    }
+
+    /// true if called from the thread that runs the events
+    bool
+    InScheduler() const
+    {
+      return std::this_thread::get_id() == m_Thread;
+    }
+
+   private:
+    struct Event
+    {
+      llarp_time_t when;
+      uint64_t seq;
+      std::function<void()> f;
+
+      /// backwards, so that the heap's top is the soonest
+      bool
+      operator<(const Event& other) const
+      {
+        return std::tie(when, seq) > std::tie(other.when, other.seq);
+      }
+    };
+
+    void
+    Push(llarp_time_t when, std::function<void()> f);
+
+    /// moves in what other threads have added
+    void
+    TakeIncoming();
+
+    Duration_t m_Now;
+    uint64_t m_Seq = 0;
+    uint64_t m_Ran = 0;
+    std::vector<Event> m_Events;
+    std::thread::id m_Thread;
+
+    std::mutex m_IncomingMutex;
+    std::vector<std::pair<llarp_time_t, std::function<void()>>> m_Incoming;
+  };
+
+  /// one router's event loop in a simulation: its calls, timers and wakeups go on the shared
+  /// Scheduler and its udp sockets on the in-memory Network, at the node's address there.  once
+  /// stopped, none of what it has queued runs any more, so a stopping router cannot stop the
+  /// rest of the simulation with it.
+  class NodeLoop final : public EventLoop, public std::enable_shared_from_this<NodeLoop>
+  {
+   public:
+    NodeLoop(Scheduler& sched, Network& net, huint32_t ip);
+    ~NodeLoop() override;
+
+    /// the node's address on the simulated network
+    huint32_t
+    IP() const
+    {
+      return m_IP;
+    }
+
+    /// runs the whole simulation until this node stops
+    void
+    run() override;
+
+    bool
+    running() const override
+    {
+      return m_State->running;
+    }
+
+    llarp_time_t
+    time_now() const override
+    {
+      return m_Sched.Now();
+    }
+
+    void
+    call_soon(std::function<void(void)> f) override;
+
+    void
+    call_later(llarp_time_t delay_ms, std::function<void(void)> callback) override;
+
+    /// we have no tun devices to read from; the simulation runs null endpoints
+    bool
+    add_network_interface(
+        std::shared_ptr<vpn::NetworkInterface> netif,
+        std::function<void(net::IPPacket)> packetHandler) override;
+
+    bool
+    add_ticker(std::function<void(void)> ticker) override;
+
+    void
+    stop() override;
+
+    std::shared_ptr<UDPHandle>
+    make_udp(UDPReceiveFunc on_recv) override;
+
+    std::shared_ptr<EventLoopWakeup>
+    make_waker(std::function<void()> callback) override;
+
+    std::shared_ptr<EventLoopRepeater>
+    make_repeater() override;
+
+    bool
+    inEventLoop() const override
+    {
+      return m_Sched.InScheduler();
+    }
+
+    /// runs the tickers once, as a real loop does after each lot of io it sees to
+    void
+    wakeup() override;
+
+    /// a repeater's task and whether it has been cancelled
+    struct Timer
+    {
+      std::function<void()> task;
+      bool cancelled = false;
+    };
+
+    /// what a node's queued events look at; they hold it weakly, so drop it once the loop goes
+    struct State
+    {
+      bool running = true;
+      bool ticking = false;
+      std::vector<std::function<void()>> tickers;
+      /// call_every's task owns its repeater, which owns the timer, which owns the task: only the
+      /// owner going away breaks that, so we break it ourselves when the node stops
+      std::vector<std::weak_ptr<Timer>> timers;
+    };
+
+    /// wraps what this node queues so it doesn't run once the node has stopped
+    std::function<void()>
+    Guard(std::function<void()> f) const;
+
+   private:
+    Scheduler& m_Sched;
+    Network& m_Net;
+    const huint32_t m_IP;
+    std::shared_ptr<State> m_State;
+  };
+
+}  // namespace llarp::simulate
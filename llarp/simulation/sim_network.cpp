@@ -0,0 +1,187 @@
+#include "sim_network.hpp"
+
+#include <llarp/util/logging.hpp>
+
+namespace llarp::simulate
+{
+  static auto logcat = log::Cat("sim");
+
+  /// a node's udp socket on the simulated network
+  class SimUDP final : public UDPHandle
+  {
+    Network& m_Net;
+    const huint32_t m_IP;
+    std::weak_ptr<NodeLoop::State> m_Node;
+    std::optional<SockAddr> m_Addr;
+
+    bool
+    NodeRunning() const
+    {
+      auto node = m_Node.lock();
+      return node and node->running;
+    }
+
+   public:
+    SimUDP(Network& net, huint32_t ip, std::weak_ptr<NodeLoop::State> node, ReceiveFunc on_recv)
+        : UDPHandle{std::move(on_recv)}, m_Net{net}, m_IP{ip}, m_Node{std::move(node)}
+    {}
+
+    ~SimUDP() override
+    {
+      close();
+    }
+
+    bool
+    listen(const SockAddr& addr) override
+    {
+      if (m_Addr or not addr.isIPv4())
+        return false;
+      // the wildcard and loopback addresses are as good as the node's own
+      const auto ip = addr.asIPv4();
+      if (ip != huint32_t{0} and (ip.h >> 24) != 127 and ip != m_IP)
+      {
+        log::warning(logcat, "cannot bind {}: the node's address is {}", addr, m_IP);
+        return false;
+      }
+      SockAddr bind{m_IP, huint16_t{addr.getPort()}};
+      if (not m_Net.Bind(bind, this))
+        return false;
+      m_Addr = bind;
+      return true;
+    }
+
+    bool
+    send(const SockAddr& dest, const llarp_buffer_t& buf) override
+    {
+      if (not NodeRunning())
+        return false;
+      if (not m_Addr and not listen(SockAddr{m_IP}))
+        return false;
+      m_Net.Send(*m_Addr, dest, byte_view_t{buf.base, buf.sz});
+      return true;
+    }
+
+    void
+    close() override
+    {
+      if (m_Addr)
+        m_Net.Unbind(*m_Addr);
+      m_Addr.reset();
+    }
+
+    std::optional<SockAddr>
+    LocalAddr() const override
+    {
+      return m_Addr;
+    }
+
+    void
+    Receive(const SockAddr& from, byte_view_t data)
+    {
+      if (not NodeRunning())
+        return;
+      std::vector<UDPPacket> pkts{UDPPacket{from, data}};
+      deliver_batch(pkts);
+    }
+  };
+
+  Network::Network(Scheduler& sched, uint64_t seed) : m_Sched{sched}, m_Rand{seed}
+  {}
+
+  huint32_t
+  Network::AddNode()
+  {
+    // 1.0.0.1, 1.1.0.1, ...: one /16 each, which is good for 65000 nodes before we wrap
+    return huint32_t{(uint32_t{1} << 24) + (m_Nodes++ << 16) + 1};
+  }
+
+  const LinkModel&
+  Network::Model(huint32_t ip) const
+  {
+    auto itr = m_Models.find(ip);
+    return itr == m_Models.end() ? m_DefaultModel : itr->second;
+  }
+
+  std::shared_ptr<UDPHandle>
+  Network::MakeUDP(
+      huint32_t ip, std::weak_ptr<NodeLoop::State> node, UDPHandle::ReceiveFunc on_recv)
+  {
+    return std::make_shared<SimUDP>(*this, ip, std::move(node), std::move(on_recv));
+  }
+
+  bool
+  Network::Bind(SockAddr& addr, SimUDP* handle)
+  {
+    if (addr.getPort() == 0)
+    {
+      auto& next = m_NextPort.try_emplace(addr.asIPv4(), 49152).first->second;
+      for (size_t tries = 0; tries < 16384; ++tries)
+      {
+        addr.setPort(next);
+        next = next == 65535 ? 49152 : next + 1;
+        if (m_Bound.emplace(addr, handle).second)
+          return true;
+      }
+      return false;
+    }
+    return m_Bound.emplace(addr, handle).second;
+  }
+
+  void
+  Network::Unbind(const SockAddr& addr)
+  {
+    m_Bound.erase(addr);
+  }
+
+  void
+  Network::Send(const SockAddr& from, const SockAddr& to, byte_view_t data)
+  {
+    ++m_Sent;
+    m_Bytes += data.size();
+    const auto& src = Model(from.asIPv4());
+    const auto& dst = Model(to.asIPv4());
+    std::uniform_real_distribution<double> chance{0.0, 1.0};
+    if (chance(m_Rand) < src.loss or chance(m_Rand) < dst.loss)
+    {
+      ++m_Lost;
+      return;
+    }
+    auto delay = src.latency + dst.latency;
+    for (const auto jitter : {src.jitter, dst.jitter})
+    {
+      if (jitter > 0ms)
+        delay += llarp_time_t{
+            std::uniform_int_distribution<llarp_time_t::rep>{0, jitter.count()}(m_Rand)};
+    }
+    m_Sched.After(delay, [this, from, to, data = std::basic_string<byte_t>{data}] {
+      Deliver(from, to, data);
+    });
+  }
+
+  void
+  Network::Deliver(const SockAddr& from, const SockAddr& to, const std::basic_string<byte_t>& data)
+  {
+    auto itr = m_Bound.find(to);
+    if (itr == m_Bound.end())
+    {
+      ++m_Unroutable;
+      return;
+    }
+    ++m_Delivered;
+    itr->second->Receive(from, byte_view_t{data});
+  }
+
+  util::StatusObject
+  Network::ExtractStatus() const
+  {
+    return util::StatusObject{
+        {"nodes", m_Nodes},
+        {"sockets", m_Bound.size()},
+        {"sent", m_Sent},
+        {"sentBytes", m_Bytes},
+        {"delivered", m_Delivered},
+        {"lost", m_Lost},
+        {"unroutable", m_Unroutable}};
+  }
+
+}  // namespace llarp::simulate
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "sim_loop.hpp"
+
+#include <llarp/ev/udp_handle.hpp>
+
+#include <random>
+#include <unordered_map>
+
+namespace llarp::simulate
+{
+  /// how packets fare on a node's link to the rest of the network: how long they take one way,
+  /// up to how much longer at random, and the chance one is lost.  a packet crosses the sender's
+  /// link and then the receiver's, so a pair's latencies add up and either can lose it.
+  struct LinkModel
+  {
+    llarp_time_t latency = 10ms;
+    llarp_time_t jitter = 0ms;
+    double loss = 0.0;
+  };
+
+  class SimUDP;
+
+  /// the in-memory packet switched network a simulation's routers talk over in place of udp.
+  /// each node has one address and binds its sockets there; a datagram sent to an address no one
+  /// is bound on goes nowhere, as it would.
+  class Network
+  {
+   public:
+    /// `seed` makes the loss and jitter the same from one run to the next
+    Network(Scheduler& sched, uint64_t seed);
+
+    /// a new node's address.  each gets a /16 of its own, so path selection never turns down a
+    /// pair of hops for sharing a netblock
+    huint32_t
+    AddNode();
+
+    /// the model for nodes that don't have one of their own
+    void
+    SetDefaultModel(LinkModel model)
+    {
+      m_DefaultModel = model;
+    }
+
+    void
+    SetNodeModel(huint32_t ip, LinkModel model)
+    {
+      m_Models[ip] = model;
+    }
+
+    const LinkModel&
+    Model(huint32_t ip) const;
+
+    std::shared_ptr<UDPHandle>
+    MakeUDP(
+        huint32_t ip, std::weak_ptr<NodeLoop::State> node, UDPHandle::ReceiveFunc on_recv);
+
+    /// what the sockets call on us
+
+    /// binds `addr`, or the next free port on its ip if its port is 0; returns false if taken
+    bool
+    Bind(SockAddr& addr, SimUDP* handle);
+
+    void
+    Unbind(const SockAddr& addr);
+
+    void
+    Send(const SockAddr& from, const SockAddr& to, byte_view_t data);
+
+    util::StatusObject
+    ExtractStatus() const;
+
+   private:
+    void
+    Deliver(const SockAddr& from, const SockAddr& to, const std::basic_string<byte_t>& data);
+
+    Scheduler& m_Sched;
+    std::mt19937_64 m_Rand;
+    uint32_t m_Nodes = 0;
+    LinkModel m_DefaultModel;
+    std::unordered_map<huint32_t, LinkModel> m_Models;
+    std::unordered_map<SockAddr, SimUDP*> m_Bound;
+    std::unordered_map<huint32_t, uint16_t> m_NextPort;
+
+    uint64_t m_Sent = 0;
+    uint64_t m_Delivered = 0;
+    uint64_t m_Lost = 0;
+    uint64_t m_Unroutable = 0;
+    uint64_t m_Bytes = 0;
+  };
+
+}  // namespace llarp::simulate
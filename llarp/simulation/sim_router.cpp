@@ -0,0 +1,47 @@
+#include "sim_router.hpp"
+
+namespace llarp::simulate
+{
+  void
+  SimRouter::QueueWork(std::function<void(void)> func, thread::WorkClass)
+  {
+    loop()->call_soon(std::move(func));
+  }
+
+  void
+  SimRouter::QueueDiskIO(std::function<void(void)> func)
+  {
+    loop()->call_soon(std::move(func));
+  }
+
+  void
+  SimRouter::QueueShardedWork(uint64_t, thread::InlineTask func)
+  {
+    loop()->call_soon(
+        [func = std::make_shared<thread::InlineTask>(std::move(func))] { (*func)(); });
+  }
+
+  void
+  SimRouter::QueuePathWork(uint64_t, thread::InlineTask func)
+  {
+    loop()->call_soon(
+        [func = std::make_shared<thread::InlineTask>(std::move(func))] { (*func)(); });
+  }
+
+  void
+  SimRouter::QueuePathBuildWork(std::function<void(void)> func)
+  {
+    loop()->call_soon(std::move(func));
+  }
+
+  void
+  SimRouter::QueueKeyExchangeWork(std::function<void(void)> func)
+  {
+    loop()->call_soon(std::move(func));
+  }
+
+  void
+  SimRouter::StartOxenMQ()
+  {}
+
+}  // namespace llarp::simulate
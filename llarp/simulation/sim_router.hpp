@@ -0,0 +1,37 @@
+#pragma once
+
+#include <llarp/router/router.hpp>
+
+namespace llarp::simulate
+{
+  /// a Router that does all its work on its (simulated) event loop: there are no oxenmq workers
+  /// or tagged threads, so what would be queued to them is queued on the loop instead, and takes
+  /// no virtual time.  that is what lets thousands of them share a thread deterministically.
+  struct SimRouter final : public Router
+  {
+    using Router::Router;
+
+    void
+    QueueWork(std::function<void(void)> func, thread::WorkClass cls) override;
+
+    void
+    QueueDiskIO(std::function<void(void)> func) override;
+
+    void
+    QueueShardedWork(uint64_t shard, thread::InlineTask func) override;
+
+    void
+    QueuePathWork(uint64_t shard, thread::InlineTask func) override;
+
+    void
+    QueuePathBuildWork(std::function<void(void)> func) override;
+
+    void
+    QueueKeyExchangeWork(std::function<void(void)> func) override;
+
+   protected:
+    void
+    StartOxenMQ() override;
+  };
+
+}  // namespace llarp::simulate
@@ -48,15 +48,20 @@ namespace tooling
     llarp::PathID_t txid;
     llarp::PathID_t rxid;
     bool isEndpoint = false;
+    /// from the LRCM arriving to its record being decrypted and accepted, queueing included
+    std::chrono::microseconds processingTime;
 
     PathRequestReceivedEvent(
-        const llarp::RouterID& routerID, std::shared_ptr<const llarp::path::TransitHop> hop)
+        const llarp::RouterID& routerID,
+        std::shared_ptr<const llarp::path::TransitHop> hop,
+        std::chrono::microseconds processingTime_ = 0us)
         : RouterEvent("PathRequestReceivedEvent", routerID, true)
         , prevHop(hop->info.downstream)
         , nextHop(hop->info.upstream)
         , txid(hop->info.txID)
         , rxid(hop->info.rxID)
         , isEndpoint(routerID == nextHop ? true : false)
+        , processingTime(processingTime_)
     {}
 
     std::string
@@ -104,6 +109,36 @@ namespace tooling
     }
   };
 
+  struct PathBuildCompletedEvent : public RouterEvent
+  {
+    llarp::PathID_t rxid;
+    size_t numHops;
+    /// from sending the LRCM to the LRSM saying every hop took it
+    llarp_time_t buildTime;
+
+    PathBuildCompletedEvent(
+        const llarp::RouterID& routerID,
+        const llarp::PathID_t rxid_,
+        size_t numHops_,
+        llarp_time_t buildTime_)
+        : RouterEvent("PathBuildCompletedEvent", routerID, false)
+        , rxid(rxid_)
+        , numHops(numHops_)
+        , buildTime(buildTime_)
+    {}
+
+    std::string
+    ToString() const
+    {
+      std::string result = RouterEvent::ToString();
+      result += "---- path rxid: " + rxid.ShortHex();
+      result += ", hops: " + std::to_string(numHops);
+      result += ", took: " + std::to_string(buildTime.count()) + "ms";
+
+      return result;
+    }
+  };
+
   struct PathBuildRejectedEvent : public RouterEvent
   {
     llarp::PathID_t rxid;
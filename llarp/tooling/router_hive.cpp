@@ -144,6 +144,19 @@ namespace tooling
     return events;
   }
 
+  std::vector<RouterEventPtr>
+  RouterHive::GetEvents(size_t max)
+  {
+    std::lock_guard<std::mutex> guard{eventQueueMutex};
+
+    const size_t n = max ? std::min(max, eventQueue.size()) : eventQueue.size();
+    std::vector<RouterEventPtr> events{
+        std::make_move_iterator(eventQueue.begin()),
+        std::make_move_iterator(eventQueue.begin() + n)};
+    eventQueue.erase(eventQueue.begin(), eventQueue.begin() + n);
+    return events;
+  }
+
   void
   RouterHive::VisitRouter(Context_ptr ctx, std::function<void(Context_ptr)> visit)
   {
@@ -65,6 +65,10 @@ namespace tooling
     std::deque<RouterEventPtr>
     GetAllEvents();
 
+    /// takes up to `max` of the oldest events, or all of them if 0, under one lock
+    std::vector<RouterEventPtr>
+    GetEvents(size_t max = 0);
+
     // functions to safely visit each relay and/or client's HiveContext
     void
     ForEachRelay(std::function<void(Context_ptr)> visit);
@@ -4,10 +4,12 @@
 #include <llarp/util/logging.hpp>
 #include <llarp/util/formattable.hpp>
 
+#include <oxenc/endian.h>
 #include <oxenc/hex.h>
 
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <memory>
@@ -81,55 +83,95 @@ namespace llarp
     bool
     operator==(const AlignedBuffer& other) const
     {
-      return m_data == other.m_data;
+      // a memcmp of a fixed size compiles to a few word (or vector) compares
+      return std::memcmp(data(), other.data(), sz) == 0;
     }
 
     bool
     operator!=(const AlignedBuffer& other) const
     {
-      return m_data != other.m_data;
+      return not(*this == other);
     }
 
     bool
     operator<(const AlignedBuffer& other) const
     {
-      return m_data < other.m_data;
+      return Compare(other) < 0;
     }
 
     bool
     operator>(const AlignedBuffer& other) const
     {
-      return m_data > other.m_data;
+      return Compare(other) > 0;
     }
 
     bool
     operator<=(const AlignedBuffer& other) const
     {
-      return m_data <= other.m_data;
+      return Compare(other) <= 0;
     }
 
     bool
     operator>=(const AlignedBuffer& other) const
     {
-      return m_data >= other.m_data;
+      return Compare(other) >= 0;
+    }
+
+    /// orders as the bytes do, a word at a time; negative, zero or positive like memcmp
+    int
+    Compare(const AlignedBuffer& other) const
+    {
+      for (size_t i = 0; i < Words; ++i)
+      {
+        const auto a = Word(i), b = other.Word(i);
+        if (a != b)
+          return a < b ? -1 : 1;
+      }
+      return std::memcmp(data() + Words * 8, other.data() + Words * 8, sz % 8);
+    }
+
+    /// true if a is closer to us than b is by xor distance, i.e. (a ^ *this) < (b ^ *this),
+    /// without making either distance
+    bool
+    XorCloser(const AlignedBuffer& a, const AlignedBuffer& b) const
+    {
+      for (size_t i = 0; i < Words; ++i)
+      {
+        const auto us = Word(i), da = a.Word(i) ^ us, db = b.Word(i) ^ us;
+        if (da != db)
+          return da < db;
+      }
+      for (size_t i = Words * 8; i < sz; ++i)
+      {
+        const byte_t da = a[i] ^ m_data[i], db = b[i] ^ m_data[i];
+        if (da != db)
+          return da < db;
+      }
+      return false;
     }
 
     AlignedBuffer
     operator^(const AlignedBuffer& other) const
     {
-      AlignedBuffer<sz> ret;
-      std::transform(begin(), end(), other.begin(), ret.begin(), std::bit_xor<>());
+      AlignedBuffer<sz> ret{*this};
+      ret ^= other;
       return ret;
     }
 
     AlignedBuffer&
     operator^=(const AlignedBuffer& other)
     {
-      // Mutate in place instead.
-      for (size_t i = 0; i < sz; ++i)
+      // a word at a time, which the compiler turns into vector xors where it can
+      for (size_t i = 0; i < Words * 8; i += 8)
       {
-        m_data[i] ^= other.m_data[i];
+        uint64_t a, b;
+        std::memcpy(&a, data() + i, 8);
+        std::memcpy(&b, other.data() + i, 8);
+        a ^= b;
+        std::memcpy(data() + i, &a, 8);
       }
+      for (size_t i = Words * 8; i < sz; ++i)
+        m_data[i] ^= other.m_data[i];
       return *this;
     }
 
@@ -288,6 +330,15 @@ namespace llarp
     }
 
    private:
+    static constexpr size_t Words = sz / 8;
+
+    /// the ith 8 bytes as a big endian number, so that words order as their bytes do
+    uint64_t
+    Word(size_t i) const
+    {
+      return oxenc::load_big_to_host<uint64_t>(data() + i * 8);
+    }
+
     Data m_data;
   };
 
@@ -335,6 +386,8 @@ namespace std
     std::size_t
     operator()(const llarp::AlignedBuffer<sz>& buf) const noexcept
     {
+      // what we keep in hash maps (keys, path ids, nonces) is random already, so its first
+      // word is as good a hash as any
       std::size_t h = 0;
       std::memcpy(&h, buf.data(), sizeof(std::size_t));
       return h;
@@ -0,0 +1,70 @@
+#include "arena.hpp"
+
+#include <algorithm>
+
+namespace llarp
+{
+  namespace util
+  {
+    Arena::Scope::Scope(Arena& arena)
+        : m_Arena{arena}, m_Block{arena.m_Current}, m_Offset{arena.m_Offset}
+    {
+      ++m_Arena.m_Depth;
+    }
+
+    Arena::Scope::~Scope()
+    {
+      --m_Arena.m_Depth;
+      m_Arena.Rewind(m_Block, m_Offset);
+    }
+
+    Arena&
+    Arena::ForThread()
+    {
+      static thread_local Arena arena;
+      return arena;
+    }
+
+    void*
+    Arena::Allocate(size_t sz, size_t align)
+    {
+      for (; m_Current < m_Blocks.size(); ++m_Current, m_Offset = 0)
+      {
+        auto& block = m_Blocks[m_Current];
+        void* ptr = block.data.get() + m_Offset;
+        size_t space = block.size - m_Offset;
+        if (std::align(align, sz, ptr, space))
+        {
+          m_Offset = block.size - space + sz;
+          return ptr;
+        }
+      }
+      // out of blocks, or of ones big enough; std::byte[] is aligned to max_align_t, so only an
+      // over aligned type needs more than sz
+      m_Blocks.emplace_back(std::max(BlockSize, sz + align));
+      void* ptr = m_Blocks.back().data.get();
+      size_t space = m_Blocks.back().size;
+      std::align(align, sz, ptr, space);
+      m_Offset = m_Blocks.back().size - space + sz;
+      return ptr;
+    }
+
+    void
+    Arena::Rewind(size_t block, size_t offset)
+    {
+      m_Current = block;
+      m_Offset = offset;
+      if (m_Depth > 0 or m_Blocks.size() <= KeepBlocks)
+        return;
+      // nothing is live any more, so we can drop the blocks a burst or a big allocation left
+      m_Blocks.erase(
+          std::remove_if(
+              m_Blocks.begin(),
+              m_Blocks.end(),
+              [](const auto& b) { return b.size > BlockSize; }),
+          m_Blocks.end());
+      if (m_Blocks.size() > KeepBlocks)
+        m_Blocks.erase(m_Blocks.begin() + KeepBlocks, m_Blocks.end());
+    }
+  }  // namespace util
+}  // namespace llarp
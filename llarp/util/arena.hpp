@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// a monotonic arena for objects that only live for one pass through a parser or one batch
+    /// of the event loop, like decoded DHT messages: allocating is a pointer bump in a block we
+    /// already have, and freeing is rewinding to where a Scope started, so steady state traffic
+    /// makes no calls into the heap for them.
+    ///
+    /// the arena never runs destructors; whatever is made in it has to be destroyed by its owner
+    /// (see dht::MessageDeleter) before the Scope it was made in ends.  each thread has its own,
+    /// from ForThread, and none of it is thread safe.
+    class Arena
+    {
+     public:
+      /// size of the blocks we carve allocations out of; anything bigger gets a block of its own
+      static constexpr size_t BlockSize = 64 * 1024;
+      /// blocks kept once the outermost scope ends, so a burst doesn't pin memory forever
+      static constexpr size_t KeepBlocks = 4;
+
+      /// marks a point in the arena and rewinds to it when it goes; scopes nest, and only what
+      /// was allocated since this one started is given back
+      class Scope
+      {
+       public:
+        explicit Scope(Arena& arena = Arena::ForThread());
+
+        Scope(const Scope&) = delete;
+        Scope&
+        operator=(const Scope&) = delete;
+
+        ~Scope();
+
+       private:
+        Arena& m_Arena;
+        const size_t m_Block;
+        const size_t m_Offset;
+      };
+
+      Arena() = default;
+      Arena(const Arena&) = delete;
+      Arena&
+      operator=(const Arena&) = delete;
+
+      /// this thread's arena
+      static Arena&
+      ForThread();
+
+      /// sz bytes aligned to align, good until the innermost scope ends
+      void*
+      Allocate(size_t sz, size_t align = alignof(std::max_align_t));
+
+      /// constructs a T in the arena; destroying it is up to the caller
+      template <typename T, typename... Args>
+      T*
+      Make(Args&&... args)
+      {
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+      }
+
+      /// whether there is a scope open, i.e. whether anything allocated now will be given back
+      bool
+      InScope() const
+      {
+        return m_Depth > 0;
+      }
+
+      /// blocks we hold, used or not
+      size_t
+      Blocks() const
+      {
+        return m_Blocks.size();
+      }
+
+     private:
+      struct Block
+      {
+        explicit Block(size_t sz) : data{new std::byte[sz]}, size{sz}
+        {}
+
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+      };
+
+      void
+      Rewind(size_t block, size_t offset);
+
+      std::vector<Block> m_Blocks;
+      /// the block we are allocating from and how far into it we are
+      size_t m_Current = 0;
+      size_t m_Offset = 0;
+      size_t m_Depth = 0;
+    };
+
+    /// std allocator over an Arena, for short lived containers like the sets bucket queries fill
+    /// in; deallocating is a no-op and the memory comes back when the arena's scope ends
+    template <typename T>
+    struct ArenaAllocator
+    {
+      using value_type = T;
+
+      explicit ArenaAllocator(Arena& arena = Arena::ForThread()) : m_Arena{&arena}
+      {}
+
+      template <typename U>
+      ArenaAllocator(const ArenaAllocator<U>& other) : m_Arena{other.m_Arena}
+      {}
+
+      T*
+      allocate(size_t n)
+      {
+        return static_cast<T*>(m_Arena->Allocate(n * sizeof(T), alignof(T)));
+      }
+
+      void
+      deallocate(T*, size_t)
+      {}
+
+      template <typename U>
+      bool
+      operator==(const ArenaAllocator<U>& other) const
+      {
+        return m_Arena == other.m_Arena;
+      }
+
+      template <typename U>
+      bool
+      operator!=(const ArenaAllocator<U>& other) const
+      {
+        return m_Arena != other.m_Arena;
+      }
+
+      Arena* m_Arena;
+    };
+  }  // namespace util
+}  // namespace llarp
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "buffer.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+/// a bencode codec over plain byte ranges for the hot wire messages (relay up/down, path
+/// transfer, transfer traffic and protocol frames), in place of the llarp_buffer_t helpers in
+/// bencode.hpp: writing appends to the caller's buffer with no printf, and reading walks a
+/// message once, handing out views into the input rather than copies.
+///
+/// every key on the wire is a single character, so a decoder reads keys as a char and switches
+/// on it rather than comparing strings key by key; a longer key comes out as 0.
+///
+/// the rest of the messages still go through DecodeKey.  moving one over is a matter of giving it
+/// a Decode(bencode::Reader&), reading the keys after the message type, and adding it to the fast
+/// path switch in its parser (LinkMessageParser::ProcessFrom or
+/// routing::InboundMessageParser::ParseMessageBuffer); its BEncode can use a Writer on its own.
+namespace llarp::bencode
+{
+  /// appends bencode to a fixed caller buffer.  running out of room makes it stop writing and
+  /// Ok() false, so a whole message can be written out before checking once.
+  class Writer
+  {
+   public:
+    Writer(byte_t* begin, byte_t* end) : m_Pos{begin}, m_End{end}
+    {}
+
+    /// writes at buf's cursor; Commit moves the cursor past what was written
+    explicit Writer(llarp_buffer_t& buf) : Writer{buf.cur, buf.base + buf.sz}
+    {}
+
+    Writer&
+    Dict()
+    {
+      return Put('d');
+    }
+
+    Writer&
+    List()
+    {
+      return Put('l');
+    }
+
+    Writer&
+    End()
+    {
+      return Put('e');
+    }
+
+    /// a single character dict key
+    Writer&
+    Key(char k)
+    {
+      return Put('1').Put(':').Put(k);
+    }
+
+    Writer&
+    Int(uint64_t i)
+    {
+      Put('i');
+      Number(i);
+      return Put('e');
+    }
+
+    Writer&
+    Bytes(const void* data, size_t sz)
+    {
+      Number(sz);
+      Put(':');
+      return Raw(data, sz);
+    }
+
+    /// anything with data() and size(), i.e. views, AlignedBuffers and Encrypted
+    template <typename T>
+    Writer&
+    Bytes(const T& val)
+    {
+      return Bytes(val.data(), val.size());
+    }
+
+    /// what is already bencoded, as is
+    Writer&
+    Raw(const void* data, size_t sz)
+    {
+      if (not Room(sz))
+        return *this;
+      if (sz)
+        std::memcpy(m_Pos, data, sz);
+      m_Pos += sz;
+      return *this;
+    }
+
+    bool
+    Ok() const
+    {
+      return m_Ok;
+    }
+
+    /// moves buf's cursor past what we wrote, if it all fit
+    bool
+    Commit(llarp_buffer_t* buf) const
+    {
+      if (m_Ok)
+        buf->cur = m_Pos;
+      return m_Ok;
+    }
+
+   private:
+    bool
+    Room(size_t sz)
+    {
+      m_Ok = m_Ok and static_cast<size_t>(m_End - m_Pos) >= sz;
+      return m_Ok;
+    }
+
+    Writer&
+    Put(char c)
+    {
+      if (Room(1))
+        *m_Pos++ = static_cast<byte_t>(c);
+      return *this;
+    }
+
+    void
+    Number(uint64_t i)
+    {
+      char digits[20];
+      const auto [end, ec] = std::to_chars(std::begin(digits), std::end(digits), i);
+      (void)ec;
+      Raw(digits, end - digits);
+    }
+
+    byte_t* m_Pos;
+    byte_t* m_End;
+    bool m_Ok = true;
+  };
+
+  /// reads bencode in a single pass over a view of it.  the views it hands out point into that
+  /// input and are only good for as long as it is.  all reads return false on malformed or
+  /// truncated input; NextKey and More also return false at the end of the dict or list, which
+  /// Failed() tells apart.
+  class Reader
+  {
+   public:
+    explicit Reader(byte_view_t data) : m_Pos{data.data()}, m_End{data.data() + data.size()}
+    {}
+
+    bool
+    Dict()
+    {
+      return Take('d');
+    }
+
+    bool
+    List()
+    {
+      return Take('l');
+    }
+
+    /// reads the next key of the dict we are in into key, or 0 for one that is not a single
+    /// character; false, having read the 'e', at the end of the dict
+    bool
+    NextKey(char& key)
+    {
+      if (not More())
+        return false;
+      byte_view_t str;
+      if (not Bytes(str))
+        return false;
+      key = str.size() == 1 ? static_cast<char>(str[0]) : 0;
+      return true;
+    }
+
+    /// whether the dict or list we are in has more in it; false, having read the 'e', at its end
+    bool
+    More()
+    {
+      if (m_Pos == m_End)
+        return Fail();
+      if (*m_Pos != 'e')
+        return true;
+      ++m_Pos;
+      return false;
+    }
+
+    bool
+    Int(uint64_t& val)
+    {
+      if (not Take('i'))
+        return false;
+      return Number(val) and Take('e');
+    }
+
+    template <typename Int_t>
+    bool
+    IntAs(Int_t& val)
+    {
+      uint64_t read;
+      if (not Int(read))
+        return false;
+      val = static_cast<Int_t>(read);
+      return true;
+    }
+
+    /// borrows a string of at most max bytes
+    bool
+    Bytes(byte_view_t& val, size_t max = std::numeric_limits<size_t>::max())
+    {
+      uint64_t sz;
+      if (not Number(sz) or not Take(':') or sz > max or sz > static_cast<size_t>(m_End - m_Pos))
+        return Fail();
+      val = byte_view_t{m_Pos, static_cast<size_t>(sz)};
+      m_Pos += sz;
+      return true;
+    }
+
+    /// reads a string of exactly val.size() bytes into a fixed size buffer, like AlignedBuffer
+    template <typename T>
+    bool
+    Fixed(T& val)
+    {
+      byte_view_t str;
+      if (not Bytes(str) or str.size() != val.size())
+        return Fail();
+      std::memcpy(val.data(), str.data(), str.size());
+      return true;
+    }
+
+    /// steps over a value of any type
+    bool
+    Skip(int depth = 0)
+    {
+      if (m_Pos == m_End or depth > MaxDepth)
+        return Fail();
+      switch (*m_Pos)
+      {
+        case 'i': {
+          uint64_t ignored;
+          return Int(ignored);
+        }
+        case 'l':
+        case 'd':
+          ++m_Pos;
+          while (More())
+          {
+            if (not Skip(depth + 1))
+              return false;
+          }
+          return not m_Failed;
+        default: {
+          byte_view_t ignored;
+          return Bytes(ignored);
+        }
+      }
+    }
+
+    /// where we are up to, for taking a view of an encoded value we step over
+    const byte_t*
+    Pos() const
+    {
+      return m_Pos;
+    }
+
+    bool
+    Failed() const
+    {
+      return m_Failed;
+    }
+
+   private:
+    static constexpr int MaxDepth = 32;
+
+    bool
+    Fail()
+    {
+      m_Failed = true;
+      return false;
+    }
+
+    bool
+    Take(char c)
+    {
+      if (m_Pos == m_End or *m_Pos != static_cast<byte_t>(c))
+        return Fail();
+      ++m_Pos;
+      return true;
+    }
+
+    bool
+    Number(uint64_t& val)
+    {
+      const auto* begin = reinterpret_cast<const char*>(m_Pos);
+      const auto [end, ec] =
+          std::from_chars(begin, reinterpret_cast<const char*>(m_End), val, 10);
+      if (ec != std::errc{} or end == begin)
+        return Fail();
+      m_Pos += end - begin;
+      return true;
+    }
+
+    const byte_t* m_Pos;
+    const byte_t* const m_End;
+    bool m_Failed = false;
+  };
+}  // namespace llarp::bencode
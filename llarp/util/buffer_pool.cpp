@@ -0,0 +1,218 @@
+#include "buffer_pool.hpp"
+
+#include <llarp/constants/link_layer.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace llarp
+{
+  namespace util
+  {
+    namespace
+    {
+      /// capacities we pool: control packets, full size link packets, and whole link messages
+      constexpr std::array<size_t, 3> SizeClasses{256, 2048, MAX_LINK_MSG_SIZE + 512};
+      constexpr size_t NumClasses = SizeClasses.size();
+
+      /// how many buffers of each class a thread keeps before spilling into the depot
+      constexpr size_t MaxLocal = 512;
+      /// how many buffers move between a thread and the depot at a time
+      constexpr size_t DepotBatch = MaxLocal / 2;
+      /// about how many bytes of buffers of each class the depot holds before we start freeing
+      /// them, so that it is the big classes that hold fewer buffers
+      constexpr size_t MaxDepotBytes = 4 * 1024 * 1024;
+      /// and at most how many buffers, however small
+      constexpr size_t MaxDepotBuffers = 8192;
+
+      /// how many buffers of class idx the depot holds before we start freeing them
+      constexpr size_t
+      MaxDepot(size_t idx)
+      {
+        return std::clamp(MaxDepotBytes / SizeClasses[idx], DepotBatch, MaxDepotBuffers);
+      }
+
+      /// size class index of the smallest class that can hold sz bytes, or NumClasses if none
+      constexpr size_t
+      ClassFor(size_t sz)
+      {
+        for (size_t idx = 0; idx < NumClasses; ++idx)
+        {
+          if (sz <= SizeClasses[idx])
+            return idx;
+        }
+        return NumClasses;
+      }
+
+      /// size class index a buffer of capacity cap can serve, or NumClasses if none; we don't keep
+      /// buffers that grew far past the largest class around
+      constexpr size_t
+      ClassOf(size_t cap)
+      {
+        if (cap > SizeClasses.back() * 2)
+          return NumClasses;
+        for (size_t idx = NumClasses; idx > 0; --idx)
+        {
+          if (cap >= SizeClasses[idx - 1])
+            return idx - 1;
+        }
+        return NumClasses;
+      }
+
+      using FreeList_t = std::vector<std::vector<byte_t>>;
+
+      struct Stats
+      {
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        std::atomic<uint64_t> freed{0};
+        std::array<std::atomic<int64_t>, NumClasses> pooled{};
+      };
+
+      Stats stats;
+
+      struct Depot
+      {
+        std::mutex mutex;
+        FreeList_t bufs;
+      };
+
+      std::array<Depot, NumClasses> depots;
+
+      /// move up to n buffers from the back of from onto to
+      void
+      MoveBuffers(FreeList_t& from, FreeList_t& to, size_t n)
+      {
+        n = std::min(n, from.size());
+        for (auto itr = from.end() - n; itr != from.end(); ++itr)
+          to.emplace_back(std::move(*itr));
+        from.resize(from.size() - n);
+      }
+
+      struct LocalCache
+      {
+        std::array<FreeList_t, NumClasses> bufs;
+
+        ~LocalCache()
+        {
+          for (size_t idx = 0; idx < NumClasses; ++idx)
+            stats.pooled[idx] -= bufs[idx].size();
+        }
+
+        /// pop a buffer of class idx, refilling from the depot if we are out
+        std::optional<std::vector<byte_t>>
+        Take(size_t idx)
+        {
+          auto& local = bufs[idx];
+          if (local.empty())
+          {
+            auto& depot = depots[idx];
+            std::lock_guard lock{depot.mutex};
+            MoveBuffers(depot.bufs, local, DepotBatch);
+          }
+          if (local.empty())
+            return std::nullopt;
+          std::optional<std::vector<byte_t>> buf{std::move(local.back())};
+          local.pop_back();
+          return buf;
+        }
+
+        /// push a buffer of class idx, spilling to the depot if we have too many.  returns false
+        /// if there was no room anywhere.
+        bool
+        Put(size_t idx, std::vector<byte_t>& buf)
+        {
+          auto& local = bufs[idx];
+          if (local.size() >= MaxLocal)
+          {
+            auto& depot = depots[idx];
+            std::lock_guard lock{depot.mutex};
+            if (depot.bufs.size() >= MaxDepot(idx))
+              return false;
+            MoveBuffers(local, depot.bufs, DepotBatch);
+          }
+          local.emplace_back(std::move(buf));
+          return true;
+        }
+      };
+
+      thread_local LocalCache localCache;
+
+      std::vector<byte_t>
+      AcquireUninit(size_t sz)
+      {
+        const auto idx = ClassFor(sz);
+        if (idx < NumClasses)
+        {
+          if (auto buf = localCache.Take(idx))
+          {
+            stats.hits.fetch_add(1, std::memory_order_relaxed);
+            stats.pooled[idx].fetch_sub(1, std::memory_order_relaxed);
+            buf->clear();
+            return std::move(*buf);
+          }
+        }
+        stats.misses.fetch_add(1, std::memory_order_relaxed);
+        std::vector<byte_t> buf;
+        buf.reserve(idx < NumClasses ? SizeClasses[idx] : sz);
+        return buf;
+      }
+    }  // namespace
+
+    std::vector<byte_t>
+    BufferPool::Acquire(size_t sz)
+    {
+      auto buf = AcquireUninit(sz);
+      buf.resize(sz);
+      return buf;
+    }
+
+    std::vector<byte_t>
+    BufferPool::Acquire(const byte_t* ptr, size_t sz)
+    {
+      auto buf = AcquireUninit(sz);
+      buf.insert(buf.end(), ptr, ptr + sz);
+      return buf;
+    }
+
+    void
+    BufferPool::Release(std::vector<byte_t>& buf)
+    {
+      const auto idx = ClassOf(buf.capacity());
+      if (idx < NumClasses and localCache.Put(idx, buf))
+      {
+        stats.pooled[idx].fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      if (buf.capacity())
+        stats.freed.fetch_add(1, std::memory_order_relaxed);
+      std::vector<byte_t>{}.swap(buf);
+    }
+
+    void
+    BufferPool::Release(std::vector<std::vector<byte_t>>& bufs)
+    {
+      for (auto& buf : bufs)
+        Release(buf);
+      bufs.clear();
+    }
+
+    util::StatusObject
+    BufferPool::ExtractStatus()
+    {
+      util::StatusObject pooled{};
+      for (size_t idx = 0; idx < NumClasses; ++idx)
+        pooled[std::to_string(SizeClasses[idx])] =
+            std::max<int64_t>(0, stats.pooled[idx].load(std::memory_order_relaxed));
+      return util::StatusObject{
+          {"hits", stats.hits.load(std::memory_order_relaxed)},
+          {"misses", stats.misses.load(std::memory_order_relaxed)},
+          {"freed", stats.freed.load(std::memory_order_relaxed)},
+          {"pooled", pooled}};
+    }
+  }  // namespace util
+}  // namespace llarp
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "status.hpp"
+#include "types.hpp"
+
+#include <vector>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// a process wide, size classed pool of byte vectors used for link layer packets and messages
+    /// so that steady state traffic does no heap allocation per packet.
+    ///
+    /// each thread keeps its own free lists; buffers released on a different thread than the one
+    /// that acquired them (e.g. packets made in the logic thread and sent from a crypto worker)
+    /// overflow in batches into a shared depot that starved threads refill from, so the only lock
+    /// taken is once per batch rather than once per buffer.
+    struct BufferPool
+    {
+      /// get a zero filled buffer of size sz, reusing a pooled one if we have one big enough.
+      /// buffers larger than the largest size class are allocated normally.
+      static std::vector<byte_t>
+      Acquire(size_t sz);
+
+      /// get a buffer holding a copy of [ptr, ptr + sz)
+      static std::vector<byte_t>
+      Acquire(const byte_t* ptr, size_t sz);
+
+      /// give a buffer back to the pool; buf is left empty.  buffers that fit no size class or
+      /// that would overfill the pool are freed.
+      static void
+      Release(std::vector<byte_t>& buf);
+
+      /// release every buffer in bufs and clear it
+      static void
+      Release(std::vector<std::vector<byte_t>>& bufs);
+
+      /// occupancy and hit/miss counters
+      static util::StatusObject
+      ExtractStatus();
+    };
+  }  // namespace util
+}  // namespace llarp
@@ -1,10 +1,21 @@
 #pragma once
 
 #include "time.hpp"
-#include <unordered_map>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace llarp::util
 {
+  /// a hash table whose entries expire a cache interval after they were put in (or last
+  /// refreshed).  entries live in one vector, linked in the order they expire, and an open
+  /// addressed index of (hash, entry) pairs finds them by key; so a lookup is a probe of a flat
+  /// array and one key compare, and Decay only looks at the entries it erases.
+  /// Key_t and Value_t must be default constructible: erased entries are reset and kept for reuse.
   template <typename Key_t, typename Value_t, typename Hash_t = std::hash<Key_t>>
   struct DecayingHashTable
   {
@@ -14,14 +25,15 @@ namespace llarp::util
     void
     Decay(llarp_time_t now)
     {
-      EraseIf([&](const auto& item) { return item.second.second + m_CacheInterval <= now; });
+      while (m_Oldest != npos and m_Entries[m_Oldest].time + m_CacheInterval <= now)
+        Erase(m_Oldest);
     }
 
     /// return if we have this value by key
     bool
     Has(const Key_t& k) const
     {
-      return m_Values.find(k) != m_Values.end();
+      return Find(k) != npos;
     }
 
     /// return true if inserted
@@ -31,45 +43,200 @@ namespace llarp::util
     {
       if (now == 0s)
         now = llarp::time_now_ms();
-      return m_Values.try_emplace(std::move(key), std::make_pair(std::move(value), now)).second;
+      const auto hash = Hash(key);
+      if (Find(key, hash) != npos)
+        return false;
+      if ((m_Size + 1) * 4 > m_Index.size() * 3)
+        Grow();
+
+      uint32_t idx;
+      if (m_Free != npos)
+      {
+        idx = m_Free;
+        m_Free = m_Entries[idx].next;
+      }
+      else
+      {
+        idx = m_Entries.size();
+        m_Entries.emplace_back();
+      }
+      auto& entry = m_Entries[idx];
+      entry.key = std::move(key);
+      entry.value = std::move(value);
+      entry.time = now;
+      Link(idx);
+
+      auto slot = hash & Mask();
+      while (m_Index[slot].entry != npos)
+        slot = (slot + 1) & Mask();
+      m_Index[slot] = {idx, hash};
+      ++m_Size;
+      return true;
     }
 
     /// get value by key
     std::optional<Value_t>
     Get(Key_t k) const
     {
-      const auto itr = m_Values.find(k);
-      if (itr == m_Values.end())
+      const auto idx = Find(k);
+      if (idx == npos)
         return std::nullopt;
-      return itr->second.first;
+      return m_Entries[idx].value;
+    }
+
+    /// get value by key, and keep it for another cache interval from now
+    std::optional<Value_t>
+    GetAndRefresh(const Key_t& k, llarp_time_t now)
+    {
+      const auto idx = Find(k);
+      if (idx == npos)
+        return std::nullopt;
+      Unlink(idx);
+      m_Entries[idx].time = now;
+      Link(idx);
+      return m_Entries[idx].value;
     }
 
     /// explicit remove an item from the cache by key
     void
     Remove(const Key_t& key)
     {
-      m_Values.erase(key);
+      if (const auto idx = Find(key); idx != npos)
+        Erase(idx);
+    }
+
+    size_t
+    Size() const
+    {
+      return m_Size;
     }
 
    private:
-    template <typename Predicate_t>
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    struct Entry
+    {
+      Key_t key;
+      Value_t value;
+      llarp_time_t time = 0s;
+      /// neighbours in expiry order; `next` links the free list for erased entries
+      uint32_t prev = npos;
+      uint32_t next = npos;
+    };
+
+    struct Slot
+    {
+      uint32_t entry = npos;
+      uint32_t hash = 0;
+    };
+
+    static uint32_t
+    Hash(const Key_t& k)
+    {
+      // spread out hashes that only differ in their high bits, as the index goes by the low ones
+      return (uint64_t{Hash_t{}(k)} * 0x9E3779B97F4A7C15ULL) >> 32;
+    }
+
+    size_t
+    Mask() const
+    {
+      return m_Index.size() - 1;
+    }
+
+    uint32_t
+    Find(const Key_t& k) const
+    {
+      return Find(k, Hash(k));
+    }
+
+    uint32_t
+    Find(const Key_t& k, uint32_t hash) const
+    {
+      if (m_Index.empty())
+        return npos;
+      for (auto slot = hash & Mask(); m_Index[slot].entry != npos; slot = (slot + 1) & Mask())
+      {
+        const auto& s = m_Index[slot];
+        if (s.hash == hash and m_Entries[s.entry].key == k)
+          return s.entry;
+      }
+      return npos;
+    }
+
     void
-    EraseIf(Predicate_t pred)
+    Grow()
     {
-      for (auto i = m_Values.begin(), last = m_Values.end(); i != last;)
+      std::vector<Slot> index(std::max<size_t>(16, m_Index.size() * 2));
+      const size_t mask = index.size() - 1;
+      for (const auto& s : m_Index)
       {
-        if (pred(*i))
-        {
-          i = m_Values.erase(i);
-        }
-        else
+        if (s.entry == npos)
+          continue;
+        auto slot = s.hash & mask;
+        while (index[slot].entry != npos)
+          slot = (slot + 1) & mask;
+        index[slot] = s;
+      }
+      m_Index = std::move(index);
+    }
+
+    /// links an entry in by its time; callers go forward in time, so this is nearly always at
+    /// the end
+    void
+    Link(uint32_t idx)
+    {
+      auto& entry = m_Entries[idx];
+      uint32_t after = m_Newest;
+      while (after != npos and m_Entries[after].time > entry.time)
+        after = m_Entries[after].prev;
+      entry.prev = after;
+      entry.next = after == npos ? m_Oldest : m_Entries[after].next;
+      (entry.next == npos ? m_Newest : m_Entries[entry.next].prev) = idx;
+      (after == npos ? m_Oldest : m_Entries[after].next) = idx;
+    }
+
+    void
+    Unlink(uint32_t idx)
+    {
+      auto& entry = m_Entries[idx];
+      (entry.prev == npos ? m_Oldest : m_Entries[entry.prev].next) = entry.next;
+      (entry.next == npos ? m_Newest : m_Entries[entry.next].prev) = entry.prev;
+      entry.prev = entry.next = npos;
+    }
+
+    void
+    Erase(uint32_t idx)
+    {
+      auto& entry = m_Entries[idx];
+      auto slot = Hash(entry.key) & Mask();
+      while (m_Index[slot].entry != idx)
+        slot = (slot + 1) & Mask();
+      // shift back whatever after it would then be cut off from where its probe starts
+      for (auto next = (slot + 1) & Mask(); m_Index[next].entry != npos; next = (next + 1) & Mask())
+      {
+        const auto home = m_Index[next].hash & Mask();
+        if (((next - home) & Mask()) >= ((next - slot) & Mask()))
         {
-          ++i;
+          m_Index[slot] = m_Index[next];
+          slot = next;
         }
       }
+      m_Index[slot] = Slot{};
+
+      Unlink(idx);
+      entry.key = Key_t{};
+      entry.value = Value_t{};
+      entry.next = m_Free;
+      m_Free = idx;
+      --m_Size;
     }
 
     llarp_time_t m_CacheInterval;
-    std::unordered_map<Key_t, std::pair<Value_t, llarp_time_t>, Hash_t> m_Values;
+    std::vector<Entry> m_Entries;
+    std::vector<Slot> m_Index;
+    size_t m_Size = 0;
+    uint32_t m_Oldest = npos;
+    uint32_t m_Newest = npos;
+    uint32_t m_Free = npos;
   };
 }  // namespace llarp::util
@@ -13,7 +13,9 @@
 
 #ifdef WIN32
 #include <io.h>
+#include <windows.h>
 #else
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -69,6 +71,82 @@ namespace llarp::util
     return std::make_error_code(static_cast<std::errc>(e));
   }
 
+#ifdef _WIN32
+  MappedFile::MappedFile(const fs::path& filename)
+  {
+    HANDLE file = CreateFileW(
+        filename.wstring().c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+      throw std::system_error{
+          static_cast<int>(GetLastError()), std::system_category(), "cannot open file"};
+    LARGE_INTEGER sz;
+    if (not GetFileSizeEx(file, &sz))
+    {
+      const auto err = GetLastError();
+      CloseHandle(file);
+      throw std::system_error{static_cast<int>(err), std::system_category(), "cannot stat file"};
+    }
+    m_Size = sz.QuadPart;
+    if (m_Size > 0)
+    {
+      m_Mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (m_Mapping)
+        m_Data = static_cast<const uint8_t*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    // the mapping keeps the file open
+    const auto err = GetLastError();
+    CloseHandle(file);
+    if (m_Size > 0 and not m_Data)
+    {
+      if (m_Mapping)
+        CloseHandle(m_Mapping);
+      throw std::system_error{static_cast<int>(err), std::system_category(), "cannot map file"};
+    }
+  }
+
+  MappedFile::~MappedFile()
+  {
+    if (m_Data)
+      UnmapViewOfFile(m_Data);
+    if (m_Mapping)
+      CloseHandle(m_Mapping);
+  }
+#else
+  MappedFile::MappedFile(const fs::path& filename)
+  {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+      throw std::system_error{errno_error(), "cannot open file"};
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+      const auto err = errno_error();
+      ::close(fd);
+      throw std::system_error{err, "cannot stat file"};
+    }
+    m_Size = st.st_size;
+    void* ptr = m_Size > 0 ? ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    const auto err = ptr == MAP_FAILED ? errno_error() : std::error_code{};
+    // the mapping keeps the file open
+    ::close(fd);
+    if (ptr == MAP_FAILED)
+      throw std::system_error{err, "cannot map file"};
+    m_Data = static_cast<const uint8_t*>(ptr);
+  }
+
+  MappedFile::~MappedFile()
+  {
+    if (m_Data)
+      ::munmap(const_cast<uint8_t*>(m_Data), m_Size);
+  }
+#endif
+
   error_code_t
   EnsurePrivateFile(fs::path pathname)
   {
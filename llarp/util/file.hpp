@@ -1,6 +1,8 @@
 #pragma once
 #include "fs.hpp"
 
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <set>
 #include <string>
@@ -45,6 +47,39 @@ namespace llarp::util
         filename, std::string_view{reinterpret_cast<const char*>(buffer), buffer_size});
   }
 
+  /// a whole file mapped read only into memory for as long as this lives.  throws
+  /// std::system_error if the file can't be opened or mapped; an empty file maps to nothing.
+  class MappedFile
+  {
+   public:
+    explicit MappedFile(const fs::path& filename);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile&
+    operator=(const MappedFile&) = delete;
+
+    const uint8_t*
+    data() const
+    {
+      return m_Data;
+    }
+
+    size_t
+    size() const
+    {
+      return m_Size;
+    }
+
+   private:
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size = 0;
+#ifdef _WIN32
+    void* m_Mapping = nullptr;
+#endif
+  };
+
   struct FileHash
   {
     size_t
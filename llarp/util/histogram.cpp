@@ -0,0 +1,132 @@
+#include "histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace llarp
+{
+  namespace util
+  {
+    namespace
+    {
+      constexpr uint64_t Linear = uint64_t{2} << Histogram::SubBucketBits;
+      constexpr uint64_t SubBuckets = uint64_t{1} << Histogram::SubBucketBits;
+
+      unsigned
+      TopBit(uint64_t value)
+      {
+        unsigned bit = 0;
+        while (value >>= 1)
+          ++bit;
+        return bit;
+      }
+
+      void
+      RaiseMax(std::atomic<uint64_t>& max, uint64_t value)
+      {
+        auto current = max.load(std::memory_order_relaxed);
+        while (value > current
+               and not max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {}
+      }
+    }  // namespace
+
+    size_t
+    Histogram::BucketFor(uint64_t value)
+    {
+      if (value < Linear)
+        return value;
+      const unsigned exp = std::min(TopBit(value), MaxBits - 1);
+      const uint64_t sub = exp == TopBit(value)
+          ? (value >> (exp - SubBucketBits)) & (SubBuckets - 1)
+          : SubBuckets - 1;
+      return Linear + (exp - SubBucketBits - 1) * SubBuckets + sub;
+    }
+
+    uint64_t
+    Histogram::BucketTop(size_t bucket)
+    {
+      if (bucket < Linear)
+        return bucket;
+      const unsigned exp = (bucket - Linear) / SubBuckets + SubBucketBits + 1;
+      const uint64_t sub = (bucket - Linear) % SubBuckets;
+      const uint64_t width = uint64_t{1} << (exp - SubBucketBits);
+      return ((SubBuckets + sub) << (exp - SubBucketBits)) + width - 1;
+    }
+
+    void
+    Histogram::Record(uint64_t value)
+    {
+      m_Counts[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+      m_Sum.fetch_add(value, std::memory_order_relaxed);
+      RaiseMax(m_Max, value);
+    }
+
+    void
+    Histogram::DrainInto(Histogram& other)
+    {
+      for (size_t idx = 0; idx < Buckets; ++idx)
+      {
+        if (const auto n = m_Counts[idx].exchange(0, std::memory_order_relaxed))
+          other.m_Counts[idx].fetch_add(n, std::memory_order_relaxed);
+      }
+      other.m_Sum.fetch_add(m_Sum.exchange(0, std::memory_order_relaxed));
+      RaiseMax(other.m_Max, m_Max.exchange(0, std::memory_order_relaxed));
+    }
+
+    void
+    Histogram::DrainInto(std::array<uint64_t, Buckets>& counts, uint64_t& sum, uint64_t& max)
+    {
+      for (size_t idx = 0; idx < Buckets; ++idx)
+        counts[idx] += m_Counts[idx].exchange(0, std::memory_order_relaxed);
+      sum += m_Sum.exchange(0, std::memory_order_relaxed);
+      max = std::max(max, m_Max.exchange(0, std::memory_order_relaxed));
+    }
+
+    uint64_t
+    Histogram::Count() const
+    {
+      uint64_t total = 0;
+      for (const auto& count : m_Counts)
+        total += count.load(std::memory_order_relaxed);
+      return total;
+    }
+
+    double
+    Histogram::Mean() const
+    {
+      const auto count = Count();
+      return count ? static_cast<double>(m_Sum.load(std::memory_order_relaxed)) / count : 0;
+    }
+
+    uint64_t
+    Histogram::Percentile(double q) const
+    {
+      const auto count = Count();
+      if (count == 0)
+        return 0;
+      const auto rank = std::max<uint64_t>(1, std::ceil(std::clamp(q, 0.0, 1.0) * count));
+      uint64_t seen = 0;
+      for (size_t idx = 0; idx < Buckets; ++idx)
+      {
+        seen += m_Counts[idx].load(std::memory_order_relaxed);
+        if (seen >= rank)
+          return std::min(BucketTop(idx), Max());
+      }
+      return Max();
+    }
+
+    StatusObject
+    Histogram::ExtractStatus() const
+    {
+      return {
+          {"count", Count()},
+          {"mean", Mean()},
+          {"p50", Percentile(0.5)},
+          {"p90", Percentile(0.9)},
+          {"p99", Percentile(0.99)},
+          {"p999", Percentile(0.999)},
+          {"max", Max()}};
+    }
+  }  // namespace util
+}  // namespace llarp
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "status.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// a log-linear (HDR style) histogram of non-negative integer samples, e.g. latencies in
+    /// microseconds.  samples below 16 get a bucket each; above that every power of two is split
+    /// into 8 buckets, so anything we report is within 12.5% of a value actually recorded.
+    /// samples of 2^32 and up are counted in the top bucket (but max and the sum are exact).
+    ///
+    /// recording is a few relaxed atomic adds, safe from any thread and never blocking, so the
+    /// hot path can afford it; readers drain it with DrainInto, which also resets it.
+    class Histogram
+    {
+     public:
+      static constexpr unsigned SubBucketBits = 3;
+      static constexpr unsigned MaxBits = 32;
+      static constexpr size_t Buckets =
+          (size_t{2} << SubBucketBits) + ((MaxBits - SubBucketBits - 1) << SubBucketBits);
+
+      Histogram() = default;
+      Histogram(const Histogram&) = delete;
+      Histogram&
+      operator=(const Histogram&) = delete;
+
+      void
+      Record(uint64_t value);
+
+      /// add everything recorded here to other and clear this one.  samples recorded meanwhile
+      /// end up on one side or the other, never both and never lost.
+      void
+      DrainInto(Histogram& other);
+
+      /// the same, into plain totals for whoever keeps them for longer than 2^32 samples a bucket
+      void
+      DrainInto(std::array<uint64_t, Buckets>& counts, uint64_t& sum, uint64_t& max);
+
+      uint64_t
+      Count() const;
+
+      uint64_t
+      Max() const
+      {
+        return m_Max.load(std::memory_order_relaxed);
+      }
+
+      double
+      Mean() const;
+
+      /// the value at or below which a fraction q (0 to 1) of samples fall, as the top of the
+      /// bucket it is in; 0 if empty
+      uint64_t
+      Percentile(double q) const;
+
+      /// count, mean, max and the usual percentiles
+      StatusObject
+      ExtractStatus() const;
+
+      /// which bucket a value is counted in, and the largest value that bucket holds
+      static size_t
+      BucketFor(uint64_t value);
+
+      static uint64_t
+      BucketTop(size_t bucket);
+
+     private:
+      std::array<std::atomic<uint32_t>, Buckets> m_Counts{};
+      std::atomic<uint64_t> m_Sum{0};
+      std::atomic<uint64_t> m_Max{0};
+    };
+  }  // namespace util
+}  // namespace llarp
@@ -9,6 +9,7 @@
 #include <oxen/log.hpp>
 #include <oxen/log/ring_buffer_sink.hpp>
 #include "oxen/log/internal.hpp"
+#include "logging/rate_limit.hpp"
 
 namespace llarp
 {
@@ -129,4 +130,54 @@ namespace llarp
   template <typename... T>
   LogError(T&&...) -> LogError<T...>;
 
+  namespace log_detail
+  {
+    /// logs like Logger would if limit lets it through, and then how many limit held back before
+    /// it; otherwise the arguments aren't formatted at all
+    template <template <typename...> typename Logger, typename... T>
+    void
+    log_limited(
+        logging::RateLimit& limit, const log::slns::source_location& location, T&&... args)
+    {
+      const auto suppressed = limit.Allow();
+      if (not suppressed)
+        return;
+      Logger<T...>{
+          legacy_logger, concat_args_fmt<sizeof...(T)>(), std::forward<T>(args)..., location};
+      if (*suppressed > 0)
+        Logger<uint64_t>{
+            legacy_logger, "({} more like the above held back)", uint64_t{*suppressed}, location};
+    }
+  }  // namespace log_detail
+
+  /// LogWarn and LogError for hot paths: at most one message through each RateLimit an interval
+  template <typename... T>
+  struct LogWarnLimited
+  {
+    LogWarnLimited(
+        logging::RateLimit& limit,
+        T&&... args,
+        const log::slns::source_location& location = log::slns::source_location::current())
+    {
+      log_detail::log_limited<log::warning>(limit, location, std::forward<T>(args)...);
+    }
+  };
+  template <typename... T>
+  struct LogErrorLimited
+  {
+    LogErrorLimited(
+        logging::RateLimit& limit,
+        T&&... args,
+        const log::slns::source_location& location = log::slns::source_location::current())
+    {
+      log_detail::log_limited<log::error>(limit, location, std::forward<T>(args)...);
+    }
+  };
+
+  template <typename... T>
+  LogWarnLimited(logging::RateLimit&, T&&...) -> LogWarnLimited<T...>;
+
+  template <typename... T>
+  LogErrorLimited(logging::RateLimit&, T&&...) -> LogErrorLimited<T...>;
+
 }  // namespace llarp
@@ -0,0 +1,130 @@
+#include "async_sink.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace llarp::logging
+{
+  namespace
+  {
+    /// how long the writing thread sleeps when there is nothing to write; producers never wake it,
+    /// so that logging costs them no syscall
+    constexpr auto IdleWait = std::chrono::milliseconds{10};
+  }  // namespace
+
+  AsyncSink::AsyncSink(std::shared_ptr<spdlog::sinks::sink> target, size_t slots)
+      : m_Target{std::move(target)}, m_Slots(slots), m_Mask{slots - 1}
+  {
+    if (slots == 0 or (slots & (slots - 1)) != 0)
+      throw std::invalid_argument{"async log sink slots must be a power of 2"};
+    for (size_t i = 0; i < slots; ++i)
+      m_Slots[i].seq.store(i, std::memory_order_relaxed);
+    m_Thread = std::thread{[this] { Run(); }};
+  }
+
+  AsyncSink::~AsyncSink()
+  {
+    m_Running = false;
+    m_Thread.join();
+  }
+
+  void
+  AsyncSink::log(const spdlog::details::log_msg& msg)
+  {
+    // claim the slot at the head, as long as the writer is done with it
+    auto pos = m_Head.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+      slot = &m_Slots[pos & m_Mask];
+      const auto seq = slot->seq.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+      if (diff == 0)
+      {
+        if (m_Head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      }
+      else if (diff < 0)
+      {
+        m_Dropped.fetch_add(1, std::memory_order_relaxed);
+        m_TotalDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      else
+        pos = m_Head.load(std::memory_order_relaxed);
+    }
+    slot->level = msg.level;
+    slot->time = msg.time;
+    slot->thread_id = msg.thread_id;
+    slot->source = msg.source;
+    slot->nameSize = std::min(msg.logger_name.size(), MaxLoggerName);
+    std::memcpy(slot->name.data(), msg.logger_name.data(), slot->nameSize);
+    slot->size = std::min(msg.payload.size(), MaxMessage);
+    std::memcpy(slot->payload.data(), msg.payload.data(), slot->size);
+    slot->seq.store(pos + 1, std::memory_order_release);
+  }
+
+  size_t
+  AsyncSink::Drain()
+  {
+    size_t wrote = 0;
+    for (;;)
+    {
+      auto& slot = m_Slots[m_Tail & m_Mask];
+      if (slot.seq.load(std::memory_order_acquire) != m_Tail + 1)
+        break;
+      spdlog::details::log_msg msg{
+          slot.time,
+          slot.source,
+          spdlog::string_view_t{slot.name.data(), slot.nameSize},
+          slot.level,
+          spdlog::string_view_t{slot.payload.data(), slot.size}};
+      msg.thread_id = slot.thread_id;
+      if (m_Target->should_log(msg.level))
+        m_Target->log(msg);
+      slot.seq.store(m_Tail + m_Slots.size(), std::memory_order_release);
+      ++m_Tail;
+      ++wrote;
+    }
+    if (const auto dropped = m_Dropped.exchange(0, std::memory_order_relaxed))
+    {
+      const auto text = fmt::format("{} log messages dropped as the log was behind", dropped);
+      m_Target->log(spdlog::details::log_msg{spdlog::string_view_t{}, spdlog::level::warn, text});
+    }
+    return wrote;
+  }
+
+  void
+  AsyncSink::Run()
+  {
+    while (m_Running)
+    {
+      if (Drain() > 0)
+        continue;
+      if (m_FlushWanted.exchange(false))
+        m_Target->flush();
+      std::this_thread::sleep_for(IdleWait);
+    }
+    Drain();
+    m_Target->flush();
+  }
+
+  void
+  AsyncSink::flush()
+  {
+    m_FlushWanted = true;
+  }
+
+  void
+  AsyncSink::set_pattern(const std::string& pattern)
+  {
+    m_Target->set_pattern(pattern);
+  }
+
+  void
+  AsyncSink::set_formatter(std::unique_ptr<spdlog::formatter> formatter)
+  {
+    m_Target->set_formatter(std::move(formatter));
+  }
+}  // namespace llarp::logging
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <spdlog/sinks/sink.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace llarp::logging
+{
+  /// puts log messages in a fixed ring of slots and leaves writing them out to another sink, on a
+  /// thread of its own, so that a slow target (a file on a busy disk, say) never holds up whoever
+  /// logged.  putting a message in is lock free: it copies the message into a slot and applies no
+  /// formatting; the pattern is applied on the way out.  when the ring is full messages are
+  /// dropped and counted rather than waited on, and the count is logged once there is room.
+  class AsyncSink : public spdlog::sinks::sink
+  {
+   public:
+    /// the most bytes of a message we keep; the rest is cut off
+    static constexpr size_t MaxMessage = 1024;
+    static constexpr size_t MaxLoggerName = 32;
+
+    /// slots must be a power of 2
+    explicit AsyncSink(std::shared_ptr<spdlog::sinks::sink> target, size_t slots = 1024);
+
+    ~AsyncSink() override;
+
+    void
+    log(const spdlog::details::log_msg& msg) override;
+
+    /// asks the writing thread to flush the target once it has written what it has
+    void
+    flush() override;
+
+    void
+    set_pattern(const std::string& pattern) override;
+
+    void
+    set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+    /// messages dropped as the ring was full, so far
+    uint64_t
+    Dropped() const
+    {
+      return m_TotalDropped.load(std::memory_order_relaxed);
+    }
+
+   private:
+    struct Slot
+    {
+      /// which turn of the ring the slot is on, and whether it is filled for that turn
+      std::atomic<size_t> seq;
+      spdlog::level::level_enum level;
+      spdlog::log_clock::time_point time;
+      size_t thread_id;
+      spdlog::source_loc source;
+      uint8_t nameSize;
+      std::array<char, MaxLoggerName> name;
+      uint16_t size;
+      std::array<char, MaxMessage> payload;
+    };
+
+    /// writes out what is in the ring, and returns how many it wrote
+    size_t
+    Drain();
+
+    void
+    Run();
+
+    const std::shared_ptr<spdlog::sinks::sink> m_Target;
+    std::vector<Slot> m_Slots;
+    const size_t m_Mask;
+    alignas(64) std::atomic<size_t> m_Head{0};
+    alignas(64) size_t m_Tail = 0;
+    std::atomic<uint64_t> m_Dropped{0};
+    std::atomic<uint64_t> m_TotalDropped{0};
+    std::atomic<bool> m_FlushWanted{false};
+    std::atomic<bool> m_Running{true};
+    std::thread m_Thread;
+  };
+}  // namespace llarp::logging
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace llarp::logging
+{
+  /// lets through at most one log message a given interval from the call site it belongs to, and
+  /// counts the ones it holds back.  meant to be a function local static next to a log statement
+  /// on a path that runs per packet, so that a flood of the same error costs an atomic load
+  /// a packet rather than formatting and writing each one:
+  ///
+  ///   static logging::RateLimit limit{1s};
+  ///   LogWarnLimited(limit, "dropped packet from ", from);
+  ///
+  /// lock free, so any thread can log through the same one.
+  class RateLimit
+  {
+   public:
+    using Clock_t = std::chrono::steady_clock;
+
+    explicit constexpr RateLimit(std::chrono::milliseconds interval) : m_Interval{interval}
+    {}
+
+    /// nullopt if the message should be held back, or else how many were held back since the
+    /// last one let through
+    std::optional<uint64_t>
+    Allow(Clock_t::time_point now = Clock_t::now())
+    {
+      const int64_t at =
+          std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+      auto next = m_NextAt.load(std::memory_order_relaxed);
+      // when threads race for the same slot only one wins it; the rest count as held back
+      if (at < next
+          or not m_NextAt.compare_exchange_strong(
+              next, at + m_Interval.count(), std::memory_order_relaxed))
+      {
+        m_Suppressed.fetch_add(1, std::memory_order_relaxed);
+        return std::nullopt;
+      }
+      return m_Suppressed.exchange(0, std::memory_order_relaxed);
+    }
+
+   private:
+    const std::chrono::milliseconds m_Interval;
+    std::atomic<int64_t> m_NextAt{0};
+    std::atomic<uint64_t> m_Suppressed{0};
+  };
+}  // namespace llarp::logging
@@ -0,0 +1,227 @@
+#include "mem_account.hpp"
+
+#include <llarp/util/logging.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#ifdef LOKINET_JEMALLOC
+#include <jemalloc/jemalloc.h>
+#endif
+
+namespace llarp
+{
+  namespace util
+  {
+    static auto logcat = log::Cat("memory");
+
+    namespace
+    {
+      constexpr std::array<std::string_view, NumMemTags> TagNames{
+          "nodedb", "path", "link", "service", "dns", "quic"};
+
+      struct Counters
+      {
+        /// signed so that a free counted before its allocation on another thread can't wrap
+        std::atomic<int64_t> live{0};
+        std::atomic<int64_t> peak{0};
+        std::atomic<uint64_t> allocs{0};
+        std::atomic<uint64_t> frees{0};
+        std::atomic<uint64_t> allocated{0};
+        std::atomic<size_t> limit{0};
+
+        /// from the last Tick, on the logic thread
+        llarp_time_t lastSample = 0s;
+        uint64_t lastAllocs = 0;
+        uint64_t lastAllocated = 0;
+        double allocsPerSec = 0;
+        double bytesPerSec = 0;
+      };
+
+      std::array<Counters, NumMemTags> counters;
+
+      struct Shedders
+      {
+        std::mutex mutex;
+        std::array<std::vector<std::weak_ptr<MemAccount::Shedder>>, NumMemTags> byTag;
+      };
+
+      Shedders&
+      shedders()
+      {
+        static Shedders s;
+        return s;
+      }
+
+      Counters&
+      For(MemTag tag)
+      {
+        return counters[static_cast<size_t>(tag)];
+      }
+
+      size_t
+      Over(const Counters& c)
+      {
+        const auto limit = static_cast<int64_t>(c.limit.load(std::memory_order_relaxed));
+        const auto live = c.live.load(std::memory_order_relaxed);
+        return limit and live > limit ? static_cast<size_t>(live - limit) : 0;
+      }
+    }  // namespace
+
+    std::string_view
+    ToString(MemTag tag)
+    {
+      return TagNames[static_cast<size_t>(tag)];
+    }
+
+    std::optional<MemTag>
+    MemTagFromString(std::string_view name)
+    {
+      for (size_t idx = 0; idx < NumMemTags; ++idx)
+      {
+        if (TagNames[idx] == name)
+          return static_cast<MemTag>(idx);
+      }
+      return std::nullopt;
+    }
+
+    void
+    MemAccount::Allocated(MemTag tag, size_t bytes)
+    {
+      auto& c = For(tag);
+      const auto sz = static_cast<int64_t>(bytes);
+      c.allocs.fetch_add(1, std::memory_order_relaxed);
+      c.allocated.fetch_add(bytes, std::memory_order_relaxed);
+      const auto live = c.live.fetch_add(sz, std::memory_order_relaxed) + sz;
+      auto peak = c.peak.load(std::memory_order_relaxed);
+      while (live > peak)
+      {
+        if (c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+          break;
+      }
+    }
+
+    void
+    MemAccount::Freed(MemTag tag, size_t bytes)
+    {
+      auto& c = For(tag);
+      c.frees.fetch_add(1, std::memory_order_relaxed);
+      c.live.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+    }
+
+    size_t
+    MemAccount::Live(MemTag tag)
+    {
+      return std::max<int64_t>(0, For(tag).live.load(std::memory_order_relaxed));
+    }
+
+    void
+    MemAccount::SetSoftLimit(MemTag tag, size_t bytes)
+    {
+      For(tag).limit = bytes;
+    }
+
+    MemAccount::ShedderHandle
+    MemAccount::AddShedder(MemTag tag, Shedder shed)
+    {
+      auto handle = std::make_shared<Shedder>(std::move(shed));
+      auto& s = shedders();
+      std::lock_guard lock{s.mutex};
+      s.byTag[static_cast<size_t>(tag)].push_back(handle);
+      return handle;
+    }
+
+    void
+    MemAccount::Tick(llarp_time_t now)
+    {
+      for (auto& c : counters)
+      {
+        if (now - c.lastSample < 1s)
+          continue;
+        const auto allocs = c.allocs.load(std::memory_order_relaxed);
+        const auto allocated = c.allocated.load(std::memory_order_relaxed);
+        if (c.lastSample > 0s)
+        {
+          const auto secs = std::chrono::duration<double>(now - c.lastSample).count();
+          c.allocsPerSec = (allocs - c.lastAllocs) / secs;
+          c.bytesPerSec = (allocated - c.lastAllocated) / secs;
+        }
+        c.lastSample = now;
+        c.lastAllocs = allocs;
+        c.lastAllocated = allocated;
+      }
+
+      for (size_t idx = 0; idx < NumMemTags; ++idx)
+      {
+        if (Over(counters[idx]) == 0)
+          continue;
+        // take them out from under the lock, as shedding may well free things that let go of
+        // their own shedders
+        std::vector<std::shared_ptr<Shedder>> shed;
+        {
+          auto& s = shedders();
+          std::lock_guard lock{s.mutex};
+          auto& weak = s.byTag[idx];
+          weak.erase(
+              std::remove_if(weak.begin(), weak.end(), [](const auto& w) { return w.expired(); }),
+              weak.end());
+          for (const auto& w : weak)
+          {
+            if (auto ptr = w.lock())
+              shed.push_back(std::move(ptr));
+          }
+        }
+        log::debug(
+            logcat,
+            "{} is {} bytes over its limit, shedding",
+            TagNames[idx],
+            Over(counters[idx]));
+        for (const auto& ptr : shed)
+        {
+          const auto over = Over(counters[idx]);
+          if (over == 0)
+            break;
+          (*ptr)(over);
+        }
+      }
+    }
+
+    util::StatusObject
+    MemAccount::ExtractStatus()
+    {
+      util::StatusObject tags;
+      for (size_t idx = 0; idx < NumMemTags; ++idx)
+      {
+        const auto& c = counters[idx];
+        tags[std::string{TagNames[idx]}] = util::StatusObject{
+            {"live", std::max<int64_t>(0, c.live.load())},
+            {"peak", c.peak.load()},
+            {"allocs", c.allocs.load()},
+            {"frees", c.frees.load()},
+            {"allocsPerSec", c.allocsPerSec},
+            {"bytesPerSec", c.bytesPerSec},
+            {"softLimit", c.limit.load()}};
+      }
+      util::StatusObject status{{"tags", std::move(tags)}};
+#ifdef LOKINET_JEMALLOC
+      // jemalloc's stats are only brought up to date when the epoch is bumped
+      uint64_t epoch = 1;
+      size_t sz = sizeof(epoch);
+      mallctl("epoch", &epoch, &sz, &epoch, sz);
+      util::StatusObject je;
+      for (const auto* stat : {"allocated", "active", "resident", "mapped", "retained"})
+      {
+        size_t val = 0;
+        sz = sizeof(val);
+        if (mallctl(fmt::format("stats.{}", stat).c_str(), &val, &sz, nullptr, 0) == 0)
+          je[stat] = val;
+      }
+      status["jemalloc"] = std::move(je);
+#endif
+      return status;
+    }
+  }  // namespace util
+}  // namespace llarp
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "status.hpp"
+#include "time.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// the parts of lokinet whose memory we count apart
+    enum class MemTag : uint8_t
+    {
+      NodeDB,
+      Path,
+      Link,
+      Service,
+      DNS,
+      QUIC,
+    };
+
+    constexpr size_t NumMemTags = 6;
+
+    std::string_view
+    ToString(MemTag tag);
+
+    /// the tag named name, as ToString gives it
+    std::optional<MemTag>
+    MemTagFromString(std::string_view name);
+
+    /// process wide counts of the bytes each subsystem holds, so heap growth can be put down to
+    /// the nodedb, transit hops, pending link messages, introsets, dns answers or quic streams
+    /// rather than guessed at.  subsystems report as they take and give back memory, either
+    /// through TaggedAllocator on their containers or by calling Allocated/Freed with what they
+    /// reckon an object costs, as the caches already do for their budgets.
+    ///
+    /// each tag may have a soft limit; Tick calls the tag's shedders while it is over, for them to
+    /// drop what they can (least used cache entries and such).  counting is a relaxed atomic add
+    /// and can be done from any thread; the rest is for the logic thread.
+    struct MemAccount
+    {
+      /// called with how many bytes over its soft limit the tag is
+      using Shedder = std::function<void(size_t over)>;
+
+      /// keeps a Shedder registered for as long as it is held
+      using ShedderHandle = std::shared_ptr<Shedder>;
+
+      static void
+      Allocated(MemTag tag, size_t bytes);
+
+      static void
+      Freed(MemTag tag, size_t bytes);
+
+      /// bytes tag holds now
+      static size_t
+      Live(MemTag tag);
+
+      /// limit tag to bytes, or 0 for no limit
+      static void
+      SetSoftLimit(MemTag tag, size_t bytes);
+
+      /// have shed called when tag is over its soft limit, until the handle goes
+      [[nodiscard]] static ShedderHandle
+      AddShedder(MemTag tag, Shedder shed);
+
+      /// works out allocation rates and calls on shedders for the tags over their limits; the
+      /// router does this from its tick
+      static void
+      Tick(llarp_time_t now);
+
+      /// per tag live and peak bytes, allocation counts and rates, and limits; and from jemalloc,
+      /// when we have it, what the whole process has
+      static util::StatusObject
+      ExtractStatus();
+    };
+
+    /// counts bytes against Tag for as long as it lives, for an object to hold as a member
+    /// charging what it reckons it costs, e.g. m_Charge{sizeof(TransitHop)}
+    template <MemTag Tag>
+    class MemCharge
+    {
+     public:
+      explicit MemCharge(size_t bytes) : m_Bytes{bytes}
+      {
+        MemAccount::Allocated(Tag, m_Bytes);
+      }
+
+      MemCharge(const MemCharge& other) : MemCharge{other.m_Bytes}
+      {}
+
+      MemCharge&
+      operator=(const MemCharge& other)
+      {
+        Resize(other.m_Bytes);
+        return *this;
+      }
+
+      ~MemCharge()
+      {
+        MemAccount::Freed(Tag, m_Bytes);
+      }
+
+      /// charge bytes from now on instead
+      void
+      Resize(size_t bytes)
+      {
+        if (bytes > m_Bytes)
+          MemAccount::Allocated(Tag, bytes - m_Bytes);
+        else if (bytes < m_Bytes)
+          MemAccount::Freed(Tag, m_Bytes - bytes);
+        m_Bytes = bytes;
+      }
+
+     private:
+      size_t m_Bytes;
+    };
+
+    /// std allocator that counts what it hands out against Tag
+    template <typename T, MemTag Tag>
+    struct TaggedAllocator
+    {
+      using value_type = T;
+
+      template <typename U>
+      struct rebind
+      {
+        using other = TaggedAllocator<U, Tag>;
+      };
+
+      TaggedAllocator() = default;
+
+      template <typename U>
+      TaggedAllocator(const TaggedAllocator<U, Tag>&)
+      {}
+
+      T*
+      allocate(size_t n)
+      {
+        auto* ptr = std::allocator<T>{}.allocate(n);
+        MemAccount::Allocated(Tag, n * sizeof(T));
+        return ptr;
+      }
+
+      void
+      deallocate(T* ptr, size_t n)
+      {
+        MemAccount::Freed(Tag, n * sizeof(T));
+        std::allocator<T>{}.deallocate(ptr, n);
+      }
+
+      template <typename U>
+      bool
+      operator==(const TaggedAllocator<U, Tag>&) const
+      {
+        return true;
+      }
+
+      template <typename U>
+      bool
+      operator!=(const TaggedAllocator<U, Tag>&) const
+      {
+        return false;
+      }
+    };
+  }  // namespace util
+}  // namespace llarp
@@ -0,0 +1,186 @@
+#include "metrics.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <vector>
+
+namespace llarp
+{
+  namespace metrics
+  {
+    namespace
+    {
+      struct Registry
+      {
+        std::mutex mutex;
+        std::vector<const Metric*> metrics;
+      };
+
+      Registry&
+      registry()
+      {
+        static Registry r;
+        return r;
+      }
+
+      /// the live metrics, by name, for as long as the lock is held
+      template <typename Func>
+      void
+      ForEach(Func&& f)
+      {
+        auto& r = registry();
+        std::lock_guard lock{r.mutex};
+        std::sort(r.metrics.begin(), r.metrics.end(), [](const auto* a, const auto* b) {
+          return a->Name() < b->Name();
+        });
+        for (const auto* metric : r.metrics)
+          f(*metric);
+      }
+
+      /// the top of the bucket a fraction q of count samples fall in or below
+      uint64_t
+      Percentile(
+          const std::array<uint64_t, util::Histogram::Buckets>& counts,
+          uint64_t count,
+          uint64_t max,
+          double q)
+      {
+        if (count == 0)
+          return 0;
+        const auto rank = std::max<uint64_t>(1, std::ceil(q * count));
+        uint64_t seen = 0;
+        for (size_t idx = 0; idx < counts.size(); ++idx)
+        {
+          seen += counts[idx];
+          if (seen >= rank)
+            return std::min(util::Histogram::BucketTop(idx), max);
+        }
+        return max;
+      }
+    }  // namespace
+
+    Metric::Metric(std::string_view name, std::string_view help) : m_Name{name}, m_Help{help}
+    {
+      auto& r = registry();
+      std::lock_guard lock{r.mutex};
+      r.metrics.push_back(this);
+    }
+
+    Metric::~Metric()
+    {
+      auto& r = registry();
+      std::lock_guard lock{r.mutex};
+      r.metrics.erase(std::remove(r.metrics.begin(), r.metrics.end(), this), r.metrics.end());
+    }
+
+    size_t
+    Counter::ThreadShard()
+    {
+      static std::atomic<size_t> next{0};
+      static thread_local const size_t shard =
+          next.fetch_add(1, std::memory_order_relaxed) % Shards;
+      return shard;
+    }
+
+    uint64_t
+    Counter::Value() const
+    {
+      uint64_t total = 0;
+      for (const auto& shard : m_Shards)
+        total += shard.value.load(std::memory_order_relaxed);
+      return total;
+    }
+
+    void
+    Counter::Render(std::string& out) const
+    {
+      fmt::format_to(std::back_inserter(out), "{} {}\n", Name(), Value());
+    }
+
+    util::StatusObject
+    Counter::ExtractStatus() const
+    {
+      return Value();
+    }
+
+    void
+    Gauge::Render(std::string& out) const
+    {
+      fmt::format_to(std::back_inserter(out), "{} {}\n", Name(), Value());
+    }
+
+    util::StatusObject
+    Gauge::ExtractStatus() const
+    {
+      return Value();
+    }
+
+    Histogram::Totals
+    Histogram::Collect() const
+    {
+      std::lock_guard lock{m_TotalsMutex};
+      m_Histogram.DrainInto(m_Totals.counts, m_Totals.sum, m_Totals.max);
+      return m_Totals;
+    }
+
+    void
+    Histogram::Render(std::string& out) const
+    {
+      const auto totals = Collect();
+      auto it = std::back_inserter(out);
+      uint64_t seen = 0;
+      // the top bucket also holds everything past it, so that is left to +Inf
+      for (size_t idx = 0; idx + 1 < totals.counts.size(); ++idx)
+      {
+        seen += totals.counts[idx];
+        const auto top = util::Histogram::BucketTop(idx);
+        if ((top & (top + 1)) == 0)
+          fmt::format_to(it, "{}_bucket{{le=\"{}\"}} {}\n", Name(), top, seen);
+      }
+      seen += totals.counts.back();
+      fmt::format_to(it, "{}_bucket{{le=\"+Inf\"}} {}\n", Name(), seen);
+      fmt::format_to(it, "{}_sum {}\n", Name(), totals.sum);
+      fmt::format_to(it, "{}_count {}\n", Name(), seen);
+    }
+
+    util::StatusObject
+    Histogram::ExtractStatus() const
+    {
+      const auto totals = Collect();
+      uint64_t count = 0;
+      for (const auto n : totals.counts)
+        count += n;
+      return util::StatusObject{
+          {"count", count},
+          {"mean", count ? static_cast<double>(totals.sum) / count : 0.0},
+          {"p50", Percentile(totals.counts, count, totals.max, 0.5)},
+          {"p90", Percentile(totals.counts, count, totals.max, 0.9)},
+          {"p99", Percentile(totals.counts, count, totals.max, 0.99)},
+          {"max", totals.max}};
+    }
+
+    std::string
+    Prometheus()
+    {
+      std::string out;
+      ForEach([&out](const Metric& metric) {
+        auto it = std::back_inserter(out);
+        fmt::format_to(it, "# HELP {} {}\n", metric.Name(), metric.Help());
+        fmt::format_to(it, "# TYPE {} {}\n", metric.Name(), metric.Type());
+        metric.Render(out);
+      });
+      return out;
+    }
+
+    util::StatusObject
+    ExtractStatus()
+    {
+      util::StatusObject status;
+      ForEach([&status](const Metric& metric) { status[metric.Name()] = metric.ExtractStatus(); });
+      return status;
+    }
+  }  // namespace metrics
+}  // namespace llarp
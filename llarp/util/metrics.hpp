@@ -0,0 +1,199 @@
+#pragma once
+
+#include "histogram.hpp"
+#include "status.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace llarp
+{
+  namespace metrics
+  {
+    /// a named value we export for scraping.  metrics are meant to be defined once, at namespace
+    /// scope next to the code that updates them, e.g.
+    ///
+    ///     static metrics::Counter rxPackets{"lokinet_link_rx_packets_total", "Packets received"};
+    ///
+    /// and register themselves for as long as they live.  names follow prometheus conventions:
+    /// lokinet_<subsystem>_<what>[_<unit>], with counters ending in _total.
+    class Metric
+    {
+     public:
+      Metric(std::string_view name, std::string_view help);
+      virtual ~Metric();
+
+      Metric(const Metric&) = delete;
+      Metric&
+      operator=(const Metric&) = delete;
+
+      const std::string&
+      Name() const
+      {
+        return m_Name;
+      }
+
+      const std::string&
+      Help() const
+      {
+        return m_Help;
+      }
+
+      /// prometheus' name for what sort of metric this is
+      virtual std::string_view
+      Type() const = 0;
+
+      /// append the sample lines for this metric, in prometheus' text format
+      virtual void
+      Render(std::string& out) const = 0;
+
+      virtual util::StatusObject
+      ExtractStatus() const = 0;
+
+     private:
+      const std::string m_Name;
+      const std::string m_Help;
+    };
+
+    /// a count that only goes up.  each thread adds to a shard of its own, on a cache line of its
+    /// own, so that counting from the data plane is a relaxed add nothing else is writing to;
+    /// reading sums the shards.
+    class Counter final : public Metric
+    {
+     public:
+      using Metric::Metric;
+
+      void
+      Inc(uint64_t n = 1)
+      {
+        m_Shards[ThreadShard()].value.fetch_add(n, std::memory_order_relaxed);
+      }
+
+      uint64_t
+      Value() const;
+
+      std::string_view
+      Type() const override
+      {
+        return "counter";
+      }
+
+      void
+      Render(std::string& out) const override;
+
+      util::StatusObject
+      ExtractStatus() const override;
+
+      static constexpr size_t Shards = 16;
+
+     private:
+      /// the shard the calling thread counts in
+      static size_t
+      ThreadShard();
+
+      struct alignas(64) Shard
+      {
+        std::atomic<uint64_t> value{0};
+      };
+
+      std::array<Shard, Shards> m_Shards;
+    };
+
+    /// a value that goes up and down, e.g. how many paths we have
+    class Gauge final : public Metric
+    {
+     public:
+      using Metric::Metric;
+
+      void
+      Set(int64_t value)
+      {
+        m_Value.store(value, std::memory_order_relaxed);
+      }
+
+      void
+      Add(int64_t n)
+      {
+        m_Value.fetch_add(n, std::memory_order_relaxed);
+      }
+
+      int64_t
+      Value() const
+      {
+        return m_Value.load(std::memory_order_relaxed);
+      }
+
+      std::string_view
+      Type() const override
+      {
+        return "gauge";
+      }
+
+      void
+      Render(std::string& out) const override;
+
+      util::StatusObject
+      ExtractStatus() const override;
+
+     private:
+      std::atomic<int64_t> m_Value{0};
+    };
+
+    /// a distribution of samples, such as latencies in microseconds.  samples are recorded into a
+    /// util::Histogram, which reading drains into 64 bit totals so that they never wrap.
+    /// prometheus is given a bucket per power of two, which is all a scrape needs; the finer
+    /// buckets are still there for the percentiles in ExtractStatus.
+    class Histogram final : public Metric
+    {
+     public:
+      using Metric::Metric;
+
+      void
+      Record(uint64_t value)
+      {
+        m_Histogram.Record(value);
+      }
+
+      std::string_view
+      Type() const override
+      {
+        return "histogram";
+      }
+
+      void
+      Render(std::string& out) const override;
+
+      util::StatusObject
+      ExtractStatus() const override;
+
+     private:
+      struct Totals
+      {
+        std::array<uint64_t, util::Histogram::Buckets> counts{};
+        uint64_t sum = 0;
+        uint64_t max = 0;
+      };
+
+      /// what has been recorded, ever
+      Totals
+      Collect() const;
+
+      mutable util::Histogram m_Histogram;
+      mutable std::mutex m_TotalsMutex;
+      mutable Totals m_Totals;
+    };
+
+    /// every metric that is alive, in prometheus' text exposition format
+    std::string
+    Prometheus();
+
+    /// every metric that is alive, by name
+    util::StatusObject
+    ExtractStatus();
+  }  // namespace metrics
+}  // namespace llarp
@@ -0,0 +1,269 @@
+#include "profiler.hpp"
+
+#include "formattable.hpp"
+#include <llarp/util/logging.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if not defined(_WIN32) and __has_include(<execinfo.h>)
+#define LOKINET_CPU_PROFILER
+#include <csignal>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/time.h>
+#endif
+
+#ifdef LOKINET_JEMALLOC
+#include <jemalloc/jemalloc.h>
+#endif
+
+namespace llarp::util::profiler
+{
+  static auto logcat = log::Cat("profiler");
+
+  namespace
+  {
+    /// held while starting or stopping a profile, so that those don't race each other; the
+    /// running flags, which they set and check under it, are what keep to one profile of a kind
+    std::mutex cpuMutex, heapMutex;
+    bool cpuRunning = false, heapRunning = false;
+
+#ifdef LOKINET_CPU_PROFILER
+    constexpr int MaxDepth = 48;
+    /// the handler and the trampoline that called it
+    constexpr int SkipFrames = 2;
+    /// 48 frames a sample makes this about 25MiB at most
+    constexpr size_t MaxSamples = 1 << 16;
+
+    struct Sample
+    {
+      int depth;
+      void* frames[MaxDepth];
+    };
+
+    /// all the signal handler touches: sized before `sampling` is set and not freed until it
+    /// was cleared and every handler that saw it set has returned
+    std::unique_ptr<Sample[]> samples;
+    size_t capacity = 0;
+    std::atomic<size_t> nextSample{0};
+    std::atomic<int> inHandler{0};
+    std::atomic<bool> sampling{false};
+    struct sigaction oldAction;
+
+    void
+    OnProfileSignal(int, siginfo_t*, void*)
+    {
+      const int savedErrno = errno;
+      // count ourselves in before looking at `sampling`, and StopCPU clears it before it counts
+      // us; both sequentially consistent, so either it waits for us or we see it cleared
+      inHandler.fetch_add(1, std::memory_order_seq_cst);
+      if (sampling.load(std::memory_order_seq_cst))
+      {
+        if (const auto idx = nextSample.fetch_add(1, std::memory_order_relaxed); idx < capacity)
+        {
+          auto& sample = samples[idx];
+          sample.depth = ::backtrace(sample.frames, MaxDepth);
+        }
+      }
+      inHandler.fetch_sub(1, std::memory_order_release);
+      errno = savedErrno;
+    }
+
+    std::string
+    Symbolise(void* addr)
+    {
+      Dl_info info{};
+      if (::dladdr(addr, &info) == 0)
+        return fmt::format("{}", addr);
+      if (info.dli_sname)
+      {
+        int status = 0;
+        std::unique_ptr<char, decltype(&std::free)> demangled{
+            abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status), &std::free};
+        return status == 0 and demangled ? demangled.get() : info.dli_sname;
+      }
+      // no symbol (a static function, say): the module and offset are enough for addr2line
+      const std::string_view module{info.dli_fname ? info.dli_fname : "?"};
+      return fmt::format(
+          "{}+{:#x}",
+          module.substr(module.rfind('/') + 1),
+          reinterpret_cast<uintptr_t>(addr) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+    }
+#endif
+  }  // namespace
+
+  void
+  StartCPU(unsigned rate, std::chrono::seconds duration)
+  {
+#ifdef LOKINET_CPU_PROFILER
+    if (rate == 0 or rate > MaxCPURate)
+      throw std::invalid_argument{fmt::format("cpu sample rate must be 1 to {}", MaxCPURate)};
+    // a stop still writing out the last profile holds the lock too; don't wait on it
+    std::unique_lock lock{cpuMutex, std::try_to_lock};
+    if (not lock or cpuRunning)
+      throw std::runtime_error{"a cpu profile is already running"};
+    // the timer counts cpu time across all threads, so a busy process can take one sample a
+    // thread each tick
+    const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    capacity = std::min<size_t>(MaxSamples, rate * duration.count() * threads);
+    samples.reset(new Sample[capacity]);
+    nextSample = 0;
+
+    // the first backtrace loads libgcc, which is not something to do in a signal handler
+    void* warmup[1];
+    ::backtrace(warmup, 1);
+
+    struct sigaction action
+    {};
+    action.sa_sigaction = &OnProfileSignal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (::sigaction(SIGPROF, &action, &oldAction) != 0)
+      throw std::runtime_error{fmt::format("cannot handle SIGPROF: {}", strerror(errno))};
+    sampling = true;
+    const long usec = 1'000'000 / rate;
+    itimerval timer{{usec / 1'000'000, usec % 1'000'000}, {usec / 1'000'000, usec % 1'000'000}};
+    if (::setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    {
+      sampling = false;
+      ::sigaction(SIGPROF, &oldAction, nullptr);
+      throw std::runtime_error{fmt::format("cannot start profiling timer: {}", strerror(errno))};
+    }
+    cpuRunning = true;
+    log::info(logcat, "cpu profiling at {} samples a second for {}s", rate, duration.count());
+#else
+    (void)rate;
+    (void)duration;
+    throw std::runtime_error{"cpu profiling is not supported on this platform"};
+#endif
+  }
+
+  size_t
+  StopCPU(const fs::path& out)
+  {
+#ifdef LOKINET_CPU_PROFILER
+    std::lock_guard lock{cpuMutex};
+    if (not cpuRunning)
+      throw std::runtime_error{"no cpu profile is running"};
+    itimerval off{};
+    ::setitimer(ITIMER_PROF, &off, nullptr);
+    sampling.store(false, std::memory_order_seq_cst);
+    // the handler stays installed, doing nothing, as a signal already on its way can still land
+    // and SIGPROF's default is to kill us; wait out any handler that saw `sampling` still set
+    while (inHandler.load(std::memory_order_seq_cst) > 0)
+      std::this_thread::yield();
+    // from here on the handler is inert, as any that runs now sees `sampling` cleared, so the
+    // samples are ours to read and free
+    cpuRunning = false;
+
+    const size_t taken = nextSample.load();
+    const size_t kept = std::min(taken, capacity);
+    std::map<std::string, size_t> stacks;
+    std::unordered_map<void*, std::string> symbols;
+    std::string stack;
+    for (size_t i = 0; i < kept; ++i)
+    {
+      const auto& sample = samples[i];
+      stack.clear();
+      // backtrace gives the innermost frame first, collapsed stacks want the outermost
+      for (int f = sample.depth - 1; f >= SkipFrames; --f)
+      {
+        auto [itr, inserted] = symbols.try_emplace(sample.frames[f]);
+        if (inserted)
+        {
+          itr->second = Symbolise(sample.frames[f]);
+          // these separate frames and counts in the format
+          std::replace(itr->second.begin(), itr->second.end(), ';', ':');
+          std::replace(itr->second.begin(), itr->second.end(), ' ', '_');
+        }
+        if (not stack.empty())
+          stack += ';';
+        stack += itr->second;
+      }
+      if (not stack.empty())
+        ++stacks[stack];
+    }
+    samples.reset();
+    capacity = 0;
+
+    fs::ofstream f{out, std::ios::trunc};
+    for (const auto& [s, n] : stacks)
+      f << s << ' ' << n << '\n';
+    if (not f)
+      throw std::runtime_error{fmt::format("cannot write cpu profile to {}", out)};
+    if (taken > kept)
+      log::warning(logcat, "cpu profile ran out of room, {} samples lost", taken - kept);
+    log::info(logcat, "wrote {} cpu samples to {}", kept, out);
+    return kept;
+#else
+    (void)out;
+    throw std::runtime_error{"cpu profiling is not supported on this platform"};
+#endif
+  }
+
+  void
+  StartHeap(unsigned sampleBits)
+  {
+#ifdef LOKINET_JEMALLOC
+    if (sampleBits > MaxHeapSampleBits)
+      throw std::invalid_argument{
+          fmt::format("heap sample rate must be at most 2^{} bytes", MaxHeapSampleBits)};
+    std::unique_lock lock{heapMutex, std::try_to_lock};
+    if (not lock or heapRunning)
+      throw std::runtime_error{"a heap profile is already running"};
+    bool enabled = false;
+    size_t sz = sizeof(enabled);
+    if (mallctl("opt.prof", &enabled, &sz, nullptr, 0) != 0 or not enabled)
+      throw std::runtime_error{
+          "jemalloc heap profiling is off; start lokinet with "
+          "MALLOC_CONF=prof:true,prof_active:false to use it"};
+    // start from nothing, so what we dump is what was allocated while we watched
+    size_t bits = sampleBits;
+    if (mallctl("prof.reset", nullptr, nullptr, &bits, sizeof(bits)) != 0)
+      throw std::runtime_error{"cannot reset jemalloc heap profile"};
+    bool active = true;
+    if (mallctl("prof.active", nullptr, nullptr, &active, sizeof(active)) != 0)
+      throw std::runtime_error{"cannot start jemalloc heap profiling"};
+    heapRunning = true;
+    log::info(logcat, "heap profiling, sampling every 2^{} bytes", sampleBits);
+#else
+    (void)sampleBits;
+    throw std::runtime_error{"heap profiling needs lokinet built with jemalloc"};
+#endif
+  }
+
+  void
+  StopHeap(const fs::path& out)
+  {
+#ifdef LOKINET_JEMALLOC
+    std::lock_guard lock{heapMutex};
+    if (not heapRunning)
+      throw std::runtime_error{"no heap profile is running"};
+    heapRunning = false;
+    const auto filename = out.string();
+    const char* name = filename.c_str();
+    const int err = mallctl("prof.dump", nullptr, nullptr, &name, sizeof(name));
+    bool active = false;
+    mallctl("prof.active", nullptr, nullptr, &active, sizeof(active));
+    if (err != 0)
+      throw std::runtime_error{fmt::format("cannot write heap profile to {}", out)};
+    log::info(logcat, "wrote heap profile to {}", out);
+#else
+    (void)out;
+    throw std::runtime_error{"heap profiling needs lokinet built with jemalloc"};
+#endif
+  }
+}  // namespace llarp::util::profiler
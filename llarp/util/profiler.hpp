@@ -0,0 +1,45 @@
+#pragma once
+
+#include "fs.hpp"
+#include "time.hpp"
+
+#include <chrono>
+#include <cstddef>
+
+namespace llarp::util::profiler
+{
+  /// the longest a profile may run for, so one asked for and forgotten stops by itself
+  inline constexpr auto MaxDuration = 5min;
+
+  /// cpu samples a second of cpu time the process uses across all its threads; just off 100 so
+  /// that we don't sample in step with something else that runs 100 times a second
+  inline constexpr unsigned DefaultCPURate = 99;
+  inline constexpr unsigned MaxCPURate = 1000;
+
+  /// jemalloc samples one allocation every 2^n bytes allocated, on average
+  inline constexpr unsigned DefaultHeapSampleBits = 19;
+  inline constexpr unsigned MaxHeapSampleBits = 40;
+
+  /// starts sampling the stacks of every thread about `rate` times a cpu second, into memory
+  /// sized up front for `duration` of them.  throws if a profile is already running or this
+  /// platform can't.
+  void
+  StartCPU(unsigned rate, std::chrono::seconds duration);
+
+  /// stops sampling and writes out what we got as collapsed stacks, "outer;inner;innermost N" a
+  /// line, as flamegraph.pl, speedscope and pprof's importers read them.  returns how many
+  /// samples were written.  slow, as it symbolises every frame: do it off the loop.
+  size_t
+  StopCPU(const fs::path& out);
+
+  /// starts jemalloc's heap profiling, sampling an allocation every 2^sampleBits bytes.  throws if
+  /// we were not built with jemalloc, or jemalloc wasn't started with MALLOC_CONF=prof:true (as
+  /// with prof_active:false, that costs nothing but a counter until it is made active here).
+  void
+  StartHeap(unsigned sampleBits);
+
+  /// writes what is live on the sampled heap to out, for jeprof (or pprof, after jeprof --raw),
+  /// and stops sampling
+  void
+  StopHeap(const fs::path& out);
+}  // namespace llarp::util::profiler
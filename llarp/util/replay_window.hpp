@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// anti-replay filter for (mostly) increasing sequence numbers, as in IPsec and WireGuard: a
+    /// fixed ring of bits anchored at the highest sequence number seen.  insert and lookup are
+    /// O(1), there is no allocation and nothing to decay; sliding forward just clears the words
+    /// that fall off the bottom.
+    ///
+    /// anything more than Window below the highest sequence number seen counts as seen, so the
+    /// window must be wider than the span of sequence numbers that can legitimately be in flight.
+    template <size_t Bits>
+    struct ReplayWindow
+    {
+      static_assert(Bits >= 128 and (Bits & (Bits - 1)) == 0, "Bits must be a power of two");
+
+      /// how far below the highest sequence number we still track individual numbers; one word
+      /// short of Bits so that the word being slid into never aliases one still in the window
+      static constexpr uint64_t Window = Bits - 64;
+
+      /// record seqno; returns false if it was already seen or is too old to tell
+      bool
+      Insert(uint64_t seqno)
+      {
+        if (not m_Any or seqno > m_Highest)
+        {
+          if (m_Any)
+          {
+            // clear the words we slide over, at most the whole ring
+            const uint64_t from = m_Highest / 64;
+            const uint64_t to = seqno / 64;
+            for (uint64_t idx = from + 1; idx <= to and idx - from <= Words; ++idx)
+              m_Words[idx % Words] = 0;
+          }
+          m_Highest = seqno;
+          m_Any = true;
+        }
+        else if (m_Highest - seqno >= Window)
+          return false;
+        auto& word = m_Words[(seqno / 64) % Words];
+        const uint64_t bit = uint64_t{1} << (seqno % 64);
+        if (word & bit)
+          return false;
+        word |= bit;
+        return true;
+      }
+
+      /// returns true if seqno was seen or is too old to tell
+      bool
+      Contains(uint64_t seqno) const
+      {
+        if (not m_Any or seqno > m_Highest)
+          return false;
+        if (m_Highest - seqno >= Window)
+          return true;
+        return m_Words[(seqno / 64) % Words] & (uint64_t{1} << (seqno % 64));
+      }
+
+      /// number of sequence numbers recorded in the ring, for stats; O(Bits / 64)
+      size_t
+      Size() const
+      {
+        size_t n = 0;
+        for (const auto word : m_Words)
+          n += std::bitset<64>{word}.count();
+        return n;
+      }
+
+     private:
+      static constexpr size_t Words = Bits / 64;
+
+      std::array<uint64_t, Words> m_Words{};
+      uint64_t m_Highest = 0;
+      bool m_Any = false;
+    };
+  }  // namespace util
+}  // namespace llarp
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "time.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// a set of recently seen values in fixed memory, for replay filters that see a value per
+    /// message: two bloom filter generations, the older of which is dropped and reused every
+    /// decay interval, so a value is remembered for between one and two intervals.  inserts
+    /// never allocate (bar the first, done lazily so that unused filters cost nothing) and
+    /// decay is one memset instead of a walk over every entry.
+    ///
+    /// it may say it has seen a value it has not.  to bound how often, a generation that gets
+    /// Capacity values before its interval is up is rotated early, which keeps the false
+    /// positive rate around 0.2% at the cost of a shorter memory when busy.
+    ///
+    /// drop in for DecayingHashSet where a wrongly rejected value is acceptable, except that
+    /// values cannot be removed.
+    template <typename Val_t, typename Hash_t = std::hash<Val_t>, size_t Bits = size_t{1} << 15>
+    struct RotatingBloomFilter
+    {
+      static_assert((Bits & (Bits - 1)) == 0, "Bits must be a power of 2");
+
+      using Time_t = std::chrono::milliseconds;
+
+      /// hashes per value; with 20 bits per value that's ~0.1% false positives per generation
+      static constexpr size_t Hashes = 4;
+      static constexpr size_t Capacity = Bits / 20;
+
+      RotatingBloomFilter(Time_t cacheInterval = 1s) : m_CacheInterval(cacheInterval)
+      {}
+
+      /// roughly how many values we remember
+      size_t
+      Size() const
+      {
+        return m_Generations[0].count + m_Generations[1].count;
+      }
+
+      bool
+      Empty() const
+      {
+        return Size() == 0;
+      }
+
+      /// return true if we have probably seen v
+      bool
+      Contains(const Val_t& v) const
+      {
+        const auto hash = Hash_t{}(v);
+        return m_Generations[0].Has(hash) or m_Generations[1].Has(hash);
+      }
+
+      /// return true if inserted
+      /// return false if we have probably seen v already
+      bool
+      Insert(const Val_t& v, Time_t now = 0s)
+      {
+        const auto hash = Hash_t{}(v);
+        if (m_Generations[0].Has(hash) or m_Generations[1].Has(hash))
+          return false;
+        if (m_Generations[m_Current].count >= Capacity)
+          Rotate(now == 0s ? llarp::time_now_ms() : now);
+        m_Generations[m_Current].Add(hash);
+        return true;
+      }
+
+      /// forget the older generation if an interval has gone by since the last rotation
+      void
+      Decay(Time_t now = 0s)
+      {
+        if (now == 0s)
+          now = llarp::time_now_ms();
+        if (m_RotatedAt + m_CacheInterval <= now)
+          Rotate(now);
+      }
+
+      Time_t
+      DecayInterval() const
+      {
+        return m_CacheInterval;
+      }
+
+      void
+      DecayInterval(Time_t interval)
+      {
+        m_CacheInterval = interval;
+      }
+
+     private:
+      struct Generation
+      {
+        static constexpr size_t Words = Bits / 64;
+
+        std::unique_ptr<uint64_t[]> bits;
+        size_t count = 0;
+
+        /// the Hashes bit positions of a hash, by double hashing off it and a remix of it
+        template <typename Visit_t>
+        static bool
+        ForEachBit(uint64_t hash, Visit_t&& visit)
+        {
+          uint64_t step = hash * 0x9e3779b97f4a7c15;
+          step ^= step >> 32;
+          step |= 1;
+          for (size_t idx = 0; idx < Hashes; ++idx, hash += step)
+          {
+            if (not visit(hash & (Bits - 1)))
+              return false;
+          }
+          return true;
+        }
+
+        bool
+        Has(uint64_t hash) const
+        {
+          if (count == 0)
+            return false;
+          return ForEachBit(
+              hash, [this](size_t bit) { return (bits[bit / 64] >> (bit % 64)) & 1; });
+        }
+
+        void
+        Add(uint64_t hash)
+        {
+          if (not bits)
+            bits = std::make_unique<uint64_t[]>(Words);
+          ForEachBit(hash, [this](size_t bit) {
+            bits[bit / 64] |= uint64_t{1} << (bit % 64);
+            return true;
+          });
+          ++count;
+        }
+
+        void
+        Clear()
+        {
+          if (count == 0)
+            return;
+          std::fill_n(bits.get(), Words, 0);
+          count = 0;
+        }
+      };
+
+      void
+      Rotate(Time_t now)
+      {
+        m_Current ^= 1;
+        m_Generations[m_Current].Clear();
+        m_RotatedAt = now;
+      }
+
+      Time_t m_CacheInterval;
+      Time_t m_RotatedAt = 0s;
+      std::array<Generation, 2> m_Generations;
+      size_t m_Current = 0;
+    };
+  }  // namespace util
+}  // namespace llarp
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// a container of values keyed by a (mostly) monotonically increasing sequence number, such as
+    /// link layer message ids.  values live in a power of two sized ring indexed directly by
+    /// sequence number, so insert, lookup and removal are O(1) and need no per element allocation.
+    ///
+    /// the only constraint is that all live sequence numbers must fit in a span no larger than the
+    /// maximum capacity; the ring grows (by doubling) up to that as needed.
+    template <typename Val_t>
+    struct SequenceWindow
+    {
+      explicit SequenceWindow(size_t maxCapacity, size_t initialCapacity = 16)
+          : m_MaxCapacity{RoundUp(maxCapacity)}
+      {
+        m_Slots.resize(std::min(RoundUp(initialCapacity), m_MaxCapacity));
+      }
+
+      size_t
+      Size() const
+      {
+        return m_Size;
+      }
+
+      bool
+      Empty() const
+      {
+        return m_Size == 0;
+      }
+
+      /// the lowest sequence number we hold a value at, if we hold any
+      std::optional<uint64_t>
+      First() const
+      {
+        if (m_Size == 0)
+          return std::nullopt;
+        return m_Begin;
+      }
+
+      /// current ring capacity
+      size_t
+      Capacity() const
+      {
+        return m_Slots.size();
+      }
+
+      Val_t*
+      Find(uint64_t seqno)
+      {
+        if (not Contains(seqno))
+          return nullptr;
+        return &*Slot(seqno);
+      }
+
+      const Val_t*
+      Find(uint64_t seqno) const
+      {
+        if (not Contains(seqno))
+          return nullptr;
+        return &*Slot(seqno);
+      }
+
+      bool
+      Contains(uint64_t seqno) const
+      {
+        return m_Size and seqno >= m_Begin and seqno < m_End and Slot(seqno).has_value();
+      }
+
+      /// construct a value at seqno.  returns a pointer to the value and true if inserted, a
+      /// pointer to the existing value and false if seqno is already present, or nullptr and false
+      /// if seqno cannot fit in the window without exceeding the maximum capacity.
+      ///
+      /// note that inserting may grow the ring, which invalidates pointers to other values.
+      template <typename... Args>
+      std::pair<Val_t*, bool>
+      Emplace(uint64_t seqno, Args&&... args)
+      {
+        if (auto* existing = Find(seqno))
+          return {existing, false};
+        const uint64_t begin = m_Size ? std::min(m_Begin, seqno) : seqno;
+        const uint64_t end = m_Size ? std::max(m_End, seqno + 1) : seqno + 1;
+        if (end - begin > m_MaxCapacity)
+          return {nullptr, false};
+        if (end - begin > m_Slots.size())
+          Grow(end - begin);
+        m_Begin = begin;
+        m_End = end;
+        auto& slot = Slot(seqno);
+        slot.emplace(std::forward<Args>(args)...);
+        m_Size++;
+        return {&*slot, true};
+      }
+
+      /// remove the value at seqno and return it, if present
+      std::optional<Val_t>
+      Take(uint64_t seqno)
+      {
+        if (not Contains(seqno))
+          return std::nullopt;
+        std::optional<Val_t> val;
+        val.swap(Slot(seqno));
+        Retire(seqno);
+        return val;
+      }
+
+      /// remove the value at seqno; returns true if it was present
+      bool
+      Erase(uint64_t seqno)
+      {
+        if (not Contains(seqno))
+          return false;
+        Slot(seqno).reset();
+        Retire(seqno);
+        return true;
+      }
+
+      /// call visit(seqno, value) for every value in sequence order.  visit must not insert into
+      /// or remove from the window.
+      template <typename Visit_t>
+      void
+      ForEach(Visit_t&& visit)
+      {
+        for (uint64_t seqno = m_Begin; m_Size and seqno < m_End; ++seqno)
+        {
+          if (auto& slot = Slot(seqno))
+            visit(seqno, *slot);
+        }
+      }
+
+      template <typename Visit_t>
+      void
+      ForEach(Visit_t&& visit) const
+      {
+        for (uint64_t seqno = m_Begin; m_Size and seqno < m_End; ++seqno)
+        {
+          if (const auto& slot = Slot(seqno))
+            visit(seqno, *slot);
+        }
+      }
+
+      /// collect the sequence numbers of every value for which pred(seqno, value) is true, in
+      /// sequence order.  useful for removing values whose removal invokes callbacks that might
+      /// modify the window.
+      template <typename Pred_t>
+      std::vector<uint64_t>
+      Select(Pred_t&& pred) const
+      {
+        std::vector<uint64_t> selected;
+        ForEach([&selected, &pred](uint64_t seqno, const Val_t& val) {
+          if (pred(seqno, val))
+            selected.push_back(seqno);
+        });
+        return selected;
+      }
+
+     private:
+      static size_t
+      RoundUp(size_t n)
+      {
+        size_t cap = 1;
+        while (cap < n)
+          cap <<= 1;
+        return cap;
+      }
+
+      std::optional<Val_t>&
+      Slot(uint64_t seqno)
+      {
+        return m_Slots[seqno & (m_Slots.size() - 1)];
+      }
+
+      const std::optional<Val_t>&
+      Slot(uint64_t seqno) const
+      {
+        return m_Slots[seqno & (m_Slots.size() - 1)];
+      }
+
+      void
+      Grow(size_t span)
+      {
+        std::vector<std::optional<Val_t>> slots(std::min(RoundUp(span), m_MaxCapacity));
+        for (uint64_t seqno = m_Begin; m_Size and seqno < m_End; ++seqno)
+        {
+          if (auto& slot = Slot(seqno))
+            slots[seqno & (slots.size() - 1)] = std::move(slot);
+        }
+        m_Slots = std::move(slots);
+      }
+
+      /// bookkeeping after the slot for seqno has been emptied
+      void
+      Retire(uint64_t seqno)
+      {
+        if (--m_Size == 0)
+        {
+          m_Begin = m_End = 0;
+          return;
+        }
+        if (seqno == m_Begin)
+        {
+          while (not Slot(m_Begin))
+            ++m_Begin;
+        }
+        else if (seqno + 1 == m_End)
+        {
+          while (not Slot(m_End - 1))
+            --m_End;
+        }
+      }
+
+      std::vector<std::optional<Val_t>> m_Slots;
+      const size_t m_MaxCapacity;
+      uint64_t m_Begin = 0;
+      uint64_t m_End = 0;
+      size_t m_Size = 0;
+    };
+  }  // namespace util
+}  // namespace llarp
@@ -2,10 +2,37 @@
 
 #include <nlohmann/json.hpp>
 
+#include <cstdint>
+
 namespace llarp
 {
   namespace util
   {
     using StatusObject = nlohmann::json;
+
+    /// a fragment of a status tree that is only built again when what it is built from has
+    /// changed, for the parts of a component's status that hardly ever do.  the owner keeps a
+    /// version it bumps whenever it changes any of them, and Get builds the fragment afresh only
+    /// when it was last built at another version.
+    class CachedStatus
+    {
+      mutable StatusObject m_Fragment;
+      mutable uint64_t m_Version = 0;
+      mutable bool m_Built = false;
+
+     public:
+      template <typename Build>
+      const StatusObject&
+      Get(uint64_t version, Build&& build) const
+      {
+        if (not m_Built or m_Version != version)
+        {
+          m_Fragment = build();
+          m_Version = version;
+          m_Built = true;
+        }
+        return m_Fragment;
+      }
+    };
   }  // namespace util
 }  // namespace llarp
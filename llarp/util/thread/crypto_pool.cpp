@@ -0,0 +1,175 @@
+#include "crypto_pool.hpp"
+#include "threading.hpp"
+
+#include <llarp/util/logging.hpp>
+
+#include <algorithm>
+#include <exception>
+
+namespace llarp
+{
+  namespace thread
+  {
+    static auto logcat = log::Cat("crypto-pool");
+
+    namespace
+    {
+      /// lanes per worker; enough that shards spread out evenly and a busy one can be stolen
+      /// without taking many others with it
+      constexpr size_t LanesPerWorker = 64;
+    }  // namespace
+
+    CryptoPool::CryptoPool(size_t threads, std::vector<unsigned> cores, std::string name)
+        : m_Lanes{new Lane[std::max<size_t>(threads, 1) * LanesPerWorker]}
+        , m_NumLanes{std::max<size_t>(threads, 1) * LanesPerWorker}
+    {
+      threads = std::max<size_t>(threads, 1);
+      for (size_t idx = 0; idx < m_NumLanes; ++idx)
+        m_Lanes[idx].home = idx % threads;
+      for (size_t idx = 0; idx < threads; ++idx)
+        m_Workers.push_back(std::make_unique<Worker>());
+      // every worker has to exist before any of them starts looking at the others
+      for (size_t idx = 0; idx < threads; ++idx)
+      {
+        std::optional<unsigned> core;
+        if (not cores.empty())
+          core = cores[idx % cores.size()];
+        m_Workers[idx]->thread =
+            std::thread{&CryptoPool::Run, this, idx, core, fmt::format("{}-{}", name, idx)};
+      }
+    }
+
+    CryptoPool::~CryptoPool()
+    {
+      {
+        std::lock_guard lock{m_SleepMutex};
+        m_Stop = true;
+      }
+      m_Wake.notify_all();
+      for (auto& worker : m_Workers)
+        worker->thread.join();
+    }
+
+    void
+    CryptoPool::Queue(uint64_t shard, InlineTask task)
+    {
+      auto& lane = m_Lanes[shard % m_NumLanes];
+      {
+        std::lock_guard lock{lane.mutex};
+        lane.tasks.push_back(std::move(task));
+        if (std::exchange(lane.scheduled, true))
+          return;
+      }
+      Schedule(lane);
+    }
+
+    void
+    CryptoPool::Schedule(Lane& lane)
+    {
+      auto& worker = *m_Workers[lane.home];
+      {
+        std::lock_guard lock{worker.mutex};
+        worker.ready.push_back(&lane);
+      }
+      ++m_Ready;
+      // whoever goes to sleep bumps m_Sleeping before looking at m_Ready one last time, so either
+      // they see our lane or we see them
+      if (m_Sleeping > 0)
+      {
+        std::lock_guard lock{m_SleepMutex};
+        m_Wake.notify_one();
+      }
+    }
+
+    CryptoPool::Lane*
+    CryptoPool::Next(size_t idx)
+    {
+      for (size_t n = 0; n < m_Workers.size(); ++n)
+      {
+        auto& worker = *m_Workers[(idx + n) % m_Workers.size()];
+        std::lock_guard lock{worker.mutex};
+        if (worker.ready.empty())
+          continue;
+        // our own from the front, for order between shards; others' from the back, which are
+        // the ones their owner would get to last
+        Lane* lane;
+        if (n == 0)
+        {
+          lane = worker.ready.front();
+          worker.ready.pop_front();
+        }
+        else
+        {
+          lane = worker.ready.back();
+          worker.ready.pop_back();
+          m_Workers[idx]->stolen.fetch_add(1, std::memory_order_relaxed);
+        }
+        --m_Ready;
+        return lane;
+      }
+      return nullptr;
+    }
+
+    void
+    CryptoPool::Run(size_t idx, std::optional<unsigned> core, std::string name)
+    {
+      util::SetThreadName(name);
+      if (core)
+        util::PinThreadToCore(*core);
+
+      auto& self = *m_Workers[idx];
+      // swapped with a lane's tasks each time round, so the two vectors' capacity is reused
+      // rather than reallocated
+      std::vector<InlineTask> batch;
+      while (not m_Stop)
+      {
+        Lane* lane = Next(idx);
+        if (not lane)
+        {
+          std::unique_lock lock{m_SleepMutex};
+          ++m_Sleeping;
+          m_Wake.wait(lock, [this] { return m_Stop or m_Ready > 0; });
+          --m_Sleeping;
+          continue;
+        }
+
+        {
+          std::lock_guard lock{lane->mutex};
+          std::swap(batch, lane->tasks);
+        }
+        for (auto& task : batch)
+        {
+          try
+          {
+            task();
+          }
+          catch (const std::exception& ex)
+          {
+            log::warning(logcat, "crypto job threw: {}", ex.what());
+          }
+        }
+        self.ran.fetch_add(batch.size(), std::memory_order_relaxed);
+        batch.clear();
+
+        bool more;
+        {
+          std::lock_guard lock{lane->mutex};
+          more = not lane->tasks.empty();
+          lane->scheduled = more;
+        }
+        if (more)
+          Schedule(*lane);
+      }
+    }
+
+    util::StatusObject
+    CryptoPool::ExtractStatus() const
+    {
+      std::vector<util::StatusObject> workers;
+      for (const auto& worker : m_Workers)
+        workers.push_back(
+            util::StatusObject{{"ran", worker->ran.load()}, {"stolen", worker->stolen.load()}});
+      return util::StatusObject{{"threads", m_Workers.size()}, {"workers", workers}};
+    }
+  }  // namespace thread
+}  // namespace llarp
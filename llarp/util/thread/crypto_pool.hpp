@@ -0,0 +1,188 @@
+#pragma once
+
+#include <llarp/util/status.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// a move only void() callable kept inline, so that queuing one never allocates; anything
+    /// capturing more than Capacity bytes fails to compile rather than going to the heap
+    class InlineTask
+    {
+     public:
+      static constexpr size_t Capacity = 64;
+
+      InlineTask() = default;
+
+      template <
+          typename F,
+          typename = std::enable_if_t<not std::is_same_v<std::decay_t<F>, InlineTask>>>
+      InlineTask(F&& f)
+      {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= Capacity, "task captures too much to be kept inline");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t));
+        static_assert(std::is_nothrow_move_constructible_v<Fn>);
+        new (m_Storage) Fn(std::forward<F>(f));
+        m_Ops = &OpsFor<Fn>;
+      }
+
+      InlineTask(InlineTask&& other) noexcept
+      {
+        *this = std::move(other);
+      }
+
+      InlineTask&
+      operator=(InlineTask&& other) noexcept
+      {
+        if (this == &other)
+          return *this;
+        Reset();
+        if (other.m_Ops)
+        {
+          other.m_Ops->move(other.m_Storage, m_Storage);
+          m_Ops = std::exchange(other.m_Ops, nullptr);
+        }
+        return *this;
+      }
+
+      ~InlineTask()
+      {
+        Reset();
+      }
+
+      explicit operator bool() const
+      {
+        return m_Ops != nullptr;
+      }
+
+      void
+      operator()()
+      {
+        m_Ops->invoke(m_Storage);
+      }
+
+      void
+      Reset()
+      {
+        if (m_Ops)
+          std::exchange(m_Ops, nullptr)->destroy(m_Storage);
+      }
+
+     private:
+      struct Ops
+      {
+        void (*invoke)(void*);
+        /// move constructs into to and destroys from
+        void (*move)(void* from, void* to);
+        void (*destroy)(void*);
+      };
+
+      template <typename Fn>
+      static constexpr Ops OpsFor{
+          [](void* f) { (*static_cast<Fn*>(f))(); },
+          [](void* from, void* to) {
+            new (to) Fn(std::move(*static_cast<Fn*>(from)));
+            static_cast<Fn*>(from)->~Fn();
+          },
+          [](void* f) { static_cast<Fn*>(f)->~Fn(); }};
+
+      alignas(std::max_align_t) std::byte m_Storage[Capacity];
+      const Ops* m_Ops = nullptr;
+    };
+
+    /// a pool of threads for short, hot jobs like packet crypto, kept apart from the general
+    /// worker pool.  jobs are queued by shard into lanes; a lane runs its jobs one at a time in
+    /// the order they were queued, so a session's or path's batches never overtake each other.
+    /// each thread has a deque of lanes with work, fed with the lanes that hash to it, and a
+    /// thread with nothing of its own steals whole lanes from the others, which keeps every core
+    /// busy when the load is lopsided without giving up per shard order.
+    ///
+    /// queuing takes a lane's lock and, if the lane was idle, its home thread's; neither is held
+    /// while jobs run.  once warmed up neither queuing nor running allocates.
+    class CryptoPool
+    {
+     public:
+      /// starts threads workers named name-0, name-1...; if cores is not empty, worker i is
+      /// pinned to cores[i % cores.size()]
+      CryptoPool(size_t threads, std::vector<unsigned> cores = {}, std::string name = "crypto");
+
+      CryptoPool(const CryptoPool&) = delete;
+      CryptoPool&
+      operator=(const CryptoPool&) = delete;
+
+      /// stops and joins the workers; jobs not yet started are dropped
+      ~CryptoPool();
+
+      /// runs task on a worker, after any queued before it with the same shard; any thread
+      void
+      Queue(uint64_t shard, InlineTask task);
+
+      size_t
+      Size() const
+      {
+        return m_Workers.size();
+      }
+
+      /// per worker jobs run and lanes stolen
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      struct Lane
+      {
+        std::mutex mutex;
+        std::vector<InlineTask> tasks;
+        /// in some worker's deque or being run, so not to be queued again
+        bool scheduled = false;
+        size_t home = 0;
+      };
+
+      struct Worker
+      {
+        std::mutex mutex;
+        std::deque<Lane*> ready;
+        std::thread thread;
+        std::atomic<uint64_t> ran{0};
+        std::atomic<uint64_t> stolen{0};
+      };
+
+      void
+      Run(size_t idx, std::optional<unsigned> core, std::string name);
+
+      /// our own next lane, or else one stolen from another worker
+      Lane*
+      Next(size_t idx);
+
+      void
+      Schedule(Lane& lane);
+
+      const std::unique_ptr<Lane[]> m_Lanes;
+      const size_t m_NumLanes;
+      std::vector<std::unique_ptr<Worker>> m_Workers;
+
+      /// lanes sitting in deques, for idle workers to know when to look
+      std::atomic<size_t> m_Ready{0};
+      std::atomic<size_t> m_Sleeping{0};
+      std::atomic<bool> m_Stop{false};
+      std::mutex m_SleepMutex;
+      std::condition_variable m_Wake;
+    };
+  }  // namespace thread
+}  // namespace llarp
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// an unbounded lock-free queue for many threads pushing and one popping, as a linked list
+    /// of nodes (after Vyukov's node based mpsc queue): a push is one allocation, an exchange and
+    /// a store, and never waits on the consumer or other pushers.
+    ///
+    /// it also tracks whether the consumer needs waking, so that a burst of pushes costs one
+    /// wakeup rather than one each: only the first push after the consumer starts a drain is told
+    /// to wake it.
+    template <typename T>
+    class MPSCQueue
+    {
+      struct Node
+      {
+        std::atomic<Node*> next{nullptr};
+        T value;
+
+        Node() = default;
+
+        explicit Node(T&& val) : value{std::move(val)}
+        {}
+      };
+
+      /// last pushed node; pushers only
+      alignas(64) std::atomic<Node*> m_Head;
+      /// a spent node in front of the next one to pop; the consumer only
+      alignas(64) Node* m_Tail;
+      std::atomic<bool> m_Signalled{false};
+
+     public:
+      MPSCQueue() : m_Head{new Node{}}, m_Tail{m_Head.load(std::memory_order_relaxed)}
+      {}
+
+      MPSCQueue(const MPSCQueue&) = delete;
+      MPSCQueue&
+      operator=(const MPSCQueue&) = delete;
+
+      ~MPSCQueue()
+      {
+        while (m_Tail)
+          delete std::exchange(m_Tail, m_Tail->next.load(std::memory_order_relaxed));
+      }
+
+      /// queues val from any thread; returns true if the consumer needs waking for it, which is
+      /// the case for the first push since the consumer last started draining
+      bool
+      Push(T val)
+      {
+        auto* node = new Node{std::move(val)};
+        auto* prev = m_Head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+        return not m_Signalled.exchange(true, std::memory_order_acq_rel);
+      }
+
+      /// pops up to max values, oldest first, handing each to func; consumer thread only.  returns
+      /// true if it left any behind, in which case the caller has to drain again (no more wakeups
+      /// come for them): either there were more than max, or a push was half done when we got to
+      /// it.
+      template <typename Func>
+      bool
+      Drain(Func&& func, size_t max)
+      {
+        // anything pushed from here on asks for another wakeup
+        m_Signalled.exchange(false, std::memory_order_acq_rel);
+        for (size_t n = 0; n < max; ++n)
+        {
+          auto* next = m_Tail->next.load(std::memory_order_acquire);
+          if (not next)
+            return m_Head.load(std::memory_order_acquire) != m_Tail;
+          T val = std::move(next->value);
+          delete std::exchange(m_Tail, next);
+          func(std::move(val));
+        }
+        return not Empty();
+      }
+
+      /// true if nothing is queued; consumer thread only
+      bool
+      Empty() const
+      {
+        return m_Head.load(std::memory_order_acquire) == m_Tail;
+      }
+    };
+  }  // namespace thread
+}  // namespace llarp
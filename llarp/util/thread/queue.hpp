@@ -5,7 +5,9 @@
 
 #include <optional>
 #include <atomic>
+#include <iterator>
 #include <tuple>
+#include <type_traits>
 
 namespace llarp
 {
@@ -40,6 +42,12 @@ namespace llarp
       friend QueuePopGuard<Type>;
       friend QueuePushGuard<Type>;
 
+      // Move `count` reserved elements, starting at `generation` and `index`,
+      // out to `out` and give their cells back.
+      template <typename OutputIt>
+      OutputIt
+      popReserved(OutputIt out, uint32_t generation, uint32_t index, uint32_t count);
+
      public:
       explicit Queue(size_t capacity);
 
@@ -66,6 +74,14 @@ namespace llarp
       QueueReturn
       tryPushBack(Type&& value);
 
+      // Try to push the elements of [begin, end) back to the queue, moving them
+      // in, with a single reservation for as many as there is room for. Return
+      // the number pushed, which is 0 if the queue is full or disabled; the
+      // rest are left where they are.
+      template <typename ForwardIt>
+      size_t
+      tryPushMany(ForwardIt begin, ForwardIt end);
+
       // Remove an element from the queue. Block until an element is available
       Type
       popFront();
@@ -78,6 +94,18 @@ namespace llarp
       std::optional<Type>
       tryPopFront();
 
+      // Remove up to `max` elements from the front of the queue, in order, into
+      // `out`. Block until at least one is available. Return the number
+      // removed.
+      template <typename OutputIt>
+      size_t
+      popMany(OutputIt out, size_t max);
+
+      // As `popMany`, but return 0 rather than block if the queue is empty.
+      template <typename OutputIt>
+      size_t
+      tryPopMany(OutputIt out, size_t max);
+
       // Remove all elements from the queue. Note this is not atomic, and if
       // other threads `pushBack` onto the queue during this call, the `size` of
       // the queue is not guaranteed to be 0.
@@ -288,6 +316,138 @@ namespace llarp
       return std::optional<Type>(std::move(m_data[index]));
     }
 
+    template <typename Type>
+    template <typename ForwardIt>
+    size_t
+    Queue<Type>::tryPushMany(ForwardIt begin, ForwardIt end)
+    {
+      // There's no rolling back part of a batch, so moves mustn't throw
+      static_assert(std::is_nothrow_move_constructible_v<Type>);
+
+      const auto wanted = static_cast<size_t>(std::distance(begin, end));
+      if (wanted == 0)
+      {
+        return 0;
+      }
+
+      uint32_t generation = 0;
+      uint32_t index = 0;
+      auto count = static_cast<uint32_t>(std::min(wanted, capacity()));
+
+      // Sync point A, as for tryPushBack
+
+      if (m_manager.reservePushIndexes(generation, index, count) != QueueReturn::Success)
+      {
+        return 0;
+      }
+
+      for (uint32_t i = 0; i < count; ++i, ++begin)
+      {
+        ::new (&m_data[index]) Type(std::move(*begin));
+        m_manager.commitPushIndex(generation, index);
+        m_manager.nextIndex(generation, index);
+      }
+
+      for (uint32_t wakeups = std::min(count, m_waitingPoppers.load()); wakeups > 0; --wakeups)
+      {
+        m_popSemaphore.notify();
+      }
+
+      return count;
+    }
+
+    template <typename Type>
+    template <typename OutputIt>
+    OutputIt
+    Queue<Type>::popReserved(OutputIt out, uint32_t generation, uint32_t index, uint32_t count)
+    {
+      uint32_t i = 0;
+      try
+      {
+        for (; i < count; ++i)
+        {
+          *out = std::move(m_data[index]);
+          ++out;
+          m_data[index].~Type();
+          m_manager.commitPopIndex(generation, index);
+          m_manager.nextIndex(generation, index);
+        }
+      }
+      catch (...)
+      {
+        // Like QueuePopGuard, drop what we couldn't hand out rather than leave
+        // the cells reserved
+        for (; i < count; ++i)
+        {
+          m_data[index].~Type();
+          m_manager.commitPopIndex(generation, index);
+          m_manager.nextIndex(generation, index);
+        }
+        throw;
+      }
+
+      for (uint32_t wakeups = std::min(count, m_waitingPushers.load()); wakeups > 0; --wakeups)
+      {
+        m_pushSemaphore.notify();
+      }
+
+      return out;
+    }
+
+    template <typename Type>
+    template <typename OutputIt>
+    size_t
+    Queue<Type>::popMany(OutputIt out, size_t max)
+    {
+      if (max == 0)
+      {
+        return 0;
+      }
+
+      uint32_t generation = 0;
+      uint32_t index = 0;
+      auto count = static_cast<uint32_t>(std::min(max, capacity()));
+      while (m_manager.reservePopIndexes(generation, index, count) != QueueReturn::Success)
+      {
+        m_waitingPoppers.fetch_add(1, std::memory_order_relaxed);
+
+        if (empty())
+        {
+          m_popSemaphore.wait();
+        }
+
+        m_waitingPoppers.fetch_sub(1, std::memory_order_relaxed);
+      }
+
+      popReserved(out, generation, index, count);
+      return count;
+    }
+
+    template <typename Type>
+    template <typename OutputIt>
+    size_t
+    Queue<Type>::tryPopMany(OutputIt out, size_t max)
+    {
+      if (max == 0)
+      {
+        return 0;
+      }
+
+      uint32_t generation = 0;
+      uint32_t index = 0;
+      auto count = static_cast<uint32_t>(std::min(max, capacity()));
+
+      // Sync Point C, as for tryPopFront
+
+      if (m_manager.reservePopIndexes(generation, index, count) != QueueReturn::Success)
+      {
+        return 0;
+      }
+
+      popReserved(out, generation, index, count);
+      return count;
+    }
+
     template <typename Type>
     QueueReturn
     Queue<Type>::pushBack(const Type& value)
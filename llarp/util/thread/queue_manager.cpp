@@ -174,9 +174,58 @@ namespace llarp
       delete[] m_states;
     }
 
+    uint32_t
+    QueueManager::reserveFollowing(
+        uint32_t combinedIndex, uint32_t maxCount, ElementState from, ElementState to)
+    {
+      uint32_t count = 1;
+      for (; count < maxCount; ++count)
+      {
+        combinedIndex = nextCombinedIndex(combinedIndex);
+
+        const auto currGen = static_cast<uint32_t>(combinedIndex / m_capacity);
+        const auto currIdx = static_cast<uint32_t>(combinedIndex % m_capacity);
+
+        uint32_t compare = encodeElement(currGen, from);
+        if (!m_states[currIdx].compare_exchange_strong(compare, encodeElement(currGen, to)))
+        {
+          break;
+        }
+      }
+      return count;
+    }
+
+    void
+    QueueManager::advanceIndex(AtomicIndex& index, uint32_t combinedIndex, uint32_t count)
+    {
+      const uint32_t target = (combinedIndex + count) % (m_maxCombinedIndex + 1);
+
+      // Threads which found our cells reserved will have moved the index on
+      // one cell at a time; whatever they left we jump over. If they've gone
+      // past our cells (or the queue was disabled), there's nothing to do.
+      uint32_t loaded = combinedIndex;
+      while (!index.compare_exchange_strong(loaded, target))
+      {
+        if (isDisabledFlagSet(loaded)
+            || circularDifference(target, loaded, m_maxCombinedIndex + 1) <= 0)
+        {
+          return;
+        }
+      }
+    }
+
     QueueReturn
     QueueManager::reservePushIndex(uint32_t& generation, uint32_t& index)
     {
+      uint32_t count = 1;
+      return reservePushIndexes(generation, index, count);
+    }
+
+    QueueReturn
+    QueueManager::reservePushIndexes(uint32_t& generation, uint32_t& index, uint32_t& count)
+    {
+      assert(count > 0);
+
       uint32_t loadedPushIndex = pushIndex().load(std::memory_order_relaxed);
 
       uint32_t savedPushIndex = -1;
@@ -263,9 +312,10 @@ namespace llarp
         loadedPushIndex = combinedIndex;
       }
 
-      // We got the cell, increment the push index
-      const uint32_t next = nextCombinedIndex(combinedIndex);
-      pushIndex().compare_exchange_strong(combinedIndex, next);
+      // We got the cell, take as many after it as we can and then increment
+      // the push index past them all
+      count = reserveFollowing(combinedIndex, count, ElementState::Empty, ElementState::Writing);
+      advanceIndex(pushIndex(), combinedIndex, count);
 
       return QueueReturn::Success;
     }
@@ -284,6 +334,15 @@ namespace llarp
     QueueReturn
     QueueManager::reservePopIndex(uint32_t& generation, uint32_t& index)
     {
+      uint32_t count = 1;
+      return reservePopIndexes(generation, index, count);
+    }
+
+    QueueReturn
+    QueueManager::reservePopIndexes(uint32_t& generation, uint32_t& index, uint32_t& count)
+    {
+      assert(count > 0);
+
       uint32_t loadedPopIndex = popIndex().load();
       uint32_t savedPopIndex = -1;
 
@@ -356,7 +415,8 @@ namespace llarp
         popIndex().compare_exchange_strong(loadedPopIndex, nextCombinedIndex(loadedPopIndex));
       }
 
-      popIndex().compare_exchange_strong(loadedPopIndex, nextCombinedIndex(loadedPopIndex));
+      count = reserveFollowing(loadedPopIndex, count, ElementState::Full, ElementState::Reading);
+      advanceIndex(popIndex(), loadedPopIndex, count);
 
       return QueueReturn::Success;
     }
@@ -372,6 +432,16 @@ namespace llarp
       m_states[index] = encodeElement(nextGeneration(generation), ElementState::Empty);
     }
 
+    void
+    QueueManager::nextIndex(uint32_t& generation, uint32_t& index) const
+    {
+      if (++index == m_capacity)
+      {
+        index = 0;
+        generation = nextGeneration(generation);
+      }
+    }
+
     void
     QueueManager::disable()
     {
@@ -107,6 +107,19 @@ namespace llarp
       uint32_t
       nextGeneration(uint32_t generation) const;
 
+      // Having reserved the cell at `combinedIndex`, move the cells after it
+      // from `from` to `to` state, up to `maxCount` cells in total, stopping at
+      // the first one another thread has (or that isn't in `from` state).
+      // Return the number of cells now held, including the first.
+      uint32_t
+      reserveFollowing(
+          uint32_t combinedIndex, uint32_t maxCount, ElementState from, ElementState to);
+
+      // Move `index` on from `combinedIndex` past `count` cells we hold, in one
+      // step. Other threads may have moved it part of the way already.
+      void
+      advanceIndex(AtomicIndex& index, uint32_t combinedIndex, uint32_t count);
+
      public:
       // Return the difference between the startingValue and the subtractValue
       // around a particular modulo.
@@ -137,6 +150,13 @@ namespace llarp
       QueueReturn
       reservePushIndex(uint32_t& generation, uint32_t& index);
 
+      // As `reservePushIndex`, but reserve up to `count` consecutive indexes,
+      // the first of which is loaded into `generation` and `index` (see
+      // `nextIndex`). On success, `count` holds the number reserved, which is
+      // at least one. The push index is moved past all of them at once.
+      QueueReturn
+      reservePushIndexes(uint32_t& generation, uint32_t& index, uint32_t& count);
+
       // Mark the `index` in the given `generation` as in-use. This unblocks
       // any other threads which were waiting on the index state.
       void
@@ -153,11 +173,21 @@ namespace llarp
       QueueReturn
       reservePopIndex(uint32_t& generation, uint32_t& index);
 
+      // As `reservePopIndex`, but reserve up to `count` consecutive indexes, as
+      // for `reservePushIndexes`.
+      QueueReturn
+      reservePopIndexes(uint32_t& generation, uint32_t& index, uint32_t& count);
+
       // Mark the `index` in the given `generation` as available. This unblocks
       // any other threads which were waiting on the index state.
       void
       commitPopIndex(uint32_t generation, uint32_t index);
 
+      // Move `generation` and `index` on to the cell after them, which is where
+      // the next of a batch of reserved indexes is.
+      void
+      nextIndex(uint32_t& generation, uint32_t& index) const;
+
       // Disable the queue
       void
       disable();
@@ -0,0 +1,158 @@
+#include "rcu.hpp"
+
+#include <array>
+#include <vector>
+
+namespace llarp
+{
+  namespace thread
+  {
+    namespace epoch
+    {
+      namespace
+      {
+        /// one per reader thread; on its own cache line so that pinning doesn't bounce lines
+        /// between cores
+        struct alignas(64) Slot
+        {
+          /// the epoch this thread is pinned in, 0 when not pinned
+          std::atomic<uint64_t> epoch{0};
+          std::atomic<bool> claimed{false};
+        };
+
+        struct Retired
+        {
+          uint64_t epoch;
+          std::function<void()> deleter;
+        };
+
+        // epochs start at 1 so that 0 can mean "not pinned"
+        std::atomic<uint64_t> g_Epoch{1};
+        std::array<Slot, MaxThreads> g_Slots;
+        /// pinned readers that didn't get a slot
+        std::atomic<size_t> g_Overflow{0};
+
+        std::mutex g_RetiredMutex;
+        std::vector<Retired> g_Retired;
+
+        struct ThreadState
+        {
+          Slot* slot = nullptr;
+          size_t depth = 0;
+
+          ThreadState()
+          {
+            for (auto& s : g_Slots)
+            {
+              bool expected = false;
+              if (s.claimed.compare_exchange_strong(expected, true))
+              {
+                slot = &s;
+                break;
+              }
+            }
+          }
+
+          ~ThreadState()
+          {
+            if (slot)
+              slot->claimed.store(false, std::memory_order_release);
+          }
+        };
+
+        ThreadState&
+        Local()
+        {
+          thread_local ThreadState state;
+          return state;
+        }
+
+        /// move the epoch on if every pinned reader has seen the current one
+        bool
+        TryAdvance()
+        {
+          if (g_Overflow.load() > 0)
+            return false;
+          auto current = g_Epoch.load();
+          for (const auto& slot : g_Slots)
+          {
+            const auto pinned = slot.epoch.load();
+            if (pinned != 0 and pinned != current)
+              return false;
+          }
+          return g_Epoch.compare_exchange_strong(current, current + 1);
+        }
+      }  // namespace
+
+      Guard::Guard()
+      {
+        auto& state = Local();
+        if (state.depth++ > 0)
+          return;
+        // the store has to be visible before we load anything we are protecting; both are
+        // sequentially consistent, as are the loads in TryAdvance
+        if (state.slot)
+          state.slot->epoch.store(g_Epoch.load());
+        else
+          g_Overflow.fetch_add(1);
+      }
+
+      Guard::~Guard()
+      {
+        auto& state = Local();
+        if (--state.depth > 0)
+          return;
+        if (state.slot)
+          state.slot->epoch.store(0, std::memory_order_release);
+        else
+          g_Overflow.fetch_sub(1, std::memory_order_release);
+      }
+
+      void
+      Retire(std::function<void()> deleter)
+      {
+        {
+          std::lock_guard lock{g_RetiredMutex};
+          g_Retired.push_back(Retired{g_Epoch.load(), std::move(deleter)});
+        }
+        Collect();
+      }
+
+      void
+      Collect()
+      {
+        std::vector<std::function<void()>> ready;
+        {
+          std::lock_guard lock{g_RetiredMutex};
+          if (g_Retired.empty())
+            return;
+          // twice, so that with no readers about something retired just now is freed right away
+          if (TryAdvance())
+            TryAdvance();
+          const auto current = g_Epoch.load();
+          auto itr = g_Retired.begin();
+          while (itr != g_Retired.end())
+          {
+            if (itr->epoch + 2 <= current)
+            {
+              ready.push_back(std::move(itr->deleter));
+              itr = g_Retired.erase(itr);
+            }
+            else
+              ++itr;
+          }
+        }
+        // outside the lock, as a deleter may well retire something itself
+        for (auto& deleter : ready)
+          deleter();
+      }
+
+      size_t
+      Pending()
+      {
+        std::lock_guard lock{g_RetiredMutex};
+        return g_Retired.size();
+      }
+    }  // namespace epoch
+  }  // namespace thread
+}  // namespace llarp
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// epoch based reclamation, for data structures that readers traverse without locks.
+    ///
+    /// a reader pins the current epoch for as long as it holds pointers into the structure;
+    /// a writer that unlinks something retires it rather than freeing it, and it is freed once
+    /// the global epoch has moved on twice, which can only happen after every reader that was
+    /// pinned when it was unlinked has unpinned.  pinning is a couple of atomic stores to a
+    /// per-thread slot and never blocks; writers never wait for readers either, reclamation just
+    /// happens later.
+    ///
+    /// there is one process-wide domain.  the first MaxThreads threads to pin get a slot of their
+    /// own; any after that share an overflow counter, which is correct but holds reclamation back
+    /// while any of them is pinned.
+    namespace epoch
+    {
+      constexpr size_t MaxThreads = 256;
+
+      /// pins the current epoch until destroyed; nests
+      class Guard
+      {
+       public:
+        Guard();
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard&
+        operator=(const Guard&) = delete;
+      };
+
+      /// run deleter once no reader can still be looking at what was unlinked before this call
+      void
+      Retire(std::function<void()> deleter);
+
+      /// try to advance the epoch and run whatever deleters that frees up; Retire calls this, so
+      /// it only needs calling directly to flush (e.g. in tests or at shutdown)
+      void
+      Collect();
+
+      /// number of retired deleters not yet run, for tests and stats
+      size_t
+      Pending();
+    }  // namespace epoch
+
+    /// a read-copy-update cell: readers see an immutable snapshot of T without taking any lock;
+    /// writers copy the current value, change the copy and publish it, and the old one is freed
+    /// through the epoch domain once no reader is left on it.  writers are serialized among
+    /// themselves.
+    ///
+    /// meant for small, read-mostly values: every update copies the whole thing.
+    template <typename T>
+    class RCU
+    {
+     public:
+      RCU() : m_Current{new T{}}
+      {}
+
+      /// there must be no readers or writers left
+      ~RCU()
+      {
+        delete m_Current.load(std::memory_order_relaxed);
+      }
+
+      RCU(const RCU&) = delete;
+      RCU&
+      operator=(const RCU&) = delete;
+
+      /// call f with the current value and return what it returns.  f may keep references into
+      /// the value only until it returns; it may call Update (on this cell too), it just won't see
+      /// the result.
+      template <typename F>
+      decltype(auto)
+      Read(F&& f) const
+      {
+        epoch::Guard guard;
+        // sequentially consistent, so this can't be hoisted above the pin
+        return std::invoke(std::forward<F>(f), std::as_const(*m_Current.load()));
+      }
+
+      /// call f with a copy of the current value; if it returns true the copy is published,
+      /// otherwise it is thrown away.  returns what f returned.  f must not call Update on this
+      /// cell.
+      template <typename F>
+      bool
+      Update(F&& f)
+      {
+        static_assert(std::is_invocable_r_v<bool, F, T&>, "update must take T& and return bool");
+        std::lock_guard lock{m_WriteMutex};
+        const T* current = m_Current.load(std::memory_order_relaxed);
+        auto next = std::make_unique<T>(*current);
+        if (not std::invoke(std::forward<F>(f), *next))
+          return false;
+        // sequentially consistent, so that Retire stamps current with an epoch read after it
+        // was unlinked
+        m_Current.store(next.release());
+        epoch::Retire([current] { delete current; });
+        return true;
+      }
+
+     private:
+      std::atomic<const T*> m_Current;
+      std::mutex m_WriteMutex;
+    };
+  }  // namespace thread
+}  // namespace llarp
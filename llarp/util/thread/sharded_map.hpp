@@ -0,0 +1,326 @@
+#pragma once
+
+#include "rcu.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// a concurrent hash multimap split into independently locked shards, for big tables that
+    /// are read far more than they are written.
+    ///
+    /// lookups and iteration take no lock: each shard is a table of singly linked chains that
+    /// writers only ever change by atomically swinging one pointer, and unlinked nodes (and
+    /// outgrown tables) are freed through the epoch domain once no reader can be on them.
+    /// writers take their shard's mutex, so writes to different shards never contend.
+    ///
+    /// lookups hand back copies of values, so Value_t should be cheap to copy (e.g. a
+    /// shared_ptr).  a reader racing a writer sees the entry either before or after the change.
+    template <
+        typename Key_t,
+        typename Value_t,
+        typename Hash_t = std::hash<Key_t>,
+        size_t NumShards = 64>
+    class ShardedMultiMap
+    {
+      struct Node
+      {
+        Node(const Key_t& k, const Value_t& v, Node* n) : key{k}, value{v}, next{n}
+        {}
+
+        const Key_t key;
+        const Value_t value;
+        std::atomic<Node*> next;
+      };
+
+      /// a power of two sized bucket array; never resized in place, a shard that outgrows it
+      /// gets a new one
+      struct Table
+      {
+        explicit Table(size_t sz) : mask{sz - 1}, buckets{new std::atomic<Node*>[sz]}
+        {
+          for (size_t idx = 0; idx < sz; ++idx)
+            buckets[idx].store(nullptr, std::memory_order_relaxed);
+        }
+
+        /// frees the chains too; only once nothing can reach them
+        ~Table()
+        {
+          for (size_t idx = 0; idx <= mask; ++idx)
+          {
+            for (Node* n = buckets[idx].load(std::memory_order_relaxed); n;)
+              delete std::exchange(n, n->next.load(std::memory_order_relaxed));
+          }
+        }
+
+        std::atomic<Node*>&
+        Bucket(size_t hash) const
+        {
+          return buckets[(hash / NumShards) & mask];
+        }
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<Node*>[]> buckets;
+      };
+
+      /// padded so that writers on neighbouring shards don't share a cache line
+      struct alignas(64) Shard
+      {
+        std::mutex mutex;
+        std::atomic<Table*> table{new Table{InitialBuckets}};
+        /// entries in table, guarded by mutex
+        size_t count = 0;
+      };
+
+     public:
+      static constexpr size_t InitialBuckets = 8;
+
+      ShardedMultiMap() = default;
+
+      /// there must be no readers or writers left
+      ~ShardedMultiMap()
+      {
+        for (auto& shard : m_Shards)
+          delete shard.table.load(std::memory_order_relaxed);
+      }
+
+      ShardedMultiMap(const ShardedMultiMap&) = delete;
+      ShardedMultiMap&
+      operator=(const ShardedMultiMap&) = delete;
+
+      /// add an entry; existing entries with the same key are kept
+      void
+      Insert(const Key_t& key, const Value_t& value)
+      {
+        const size_t hash = Hash_t{}(key);
+        auto& shard = ShardFor(hash);
+        std::lock_guard lock{shard.mutex};
+        Table* table = shard.table.load(std::memory_order_relaxed);
+        if (shard.count > table->mask)
+          table = Grow(shard, table);
+        auto& bucket = table->Bucket(hash);
+        bucket.store(new Node{key, value, bucket.load(std::memory_order_relaxed)});
+        ++shard.count;
+        m_Size.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      /// get a copy of the first value under key for which pred returns true; pred may be called
+      /// concurrently with writers but only ever sees live or just removed entries
+      template <typename Pred_t>
+      std::optional<Value_t>
+      FindIf(const Key_t& key, Pred_t&& pred) const
+      {
+        const size_t hash = Hash_t{}(key);
+        epoch::Guard guard;
+        const Table* table = ShardFor(hash).table.load();
+        for (const Node* n = table->Bucket(hash).load(); n; n = n->next.load())
+        {
+          if (n->key == key and pred(n->value))
+            return n->value;
+        }
+        return std::nullopt;
+      }
+
+      /// call visit with every key and value.  entries added or removed while this runs may or
+      /// may not be visited; nothing is visited twice.
+      template <typename Visit_t>
+      void
+      ForEach(Visit_t&& visit) const
+      {
+        epoch::Guard guard;
+        for (const auto& shard : m_Shards)
+        {
+          const Table* table = shard.table.load();
+          for (size_t idx = 0; idx <= table->mask; ++idx)
+          {
+            for (const Node* n = table->buckets[idx].load(); n; n = n->next.load())
+              visit(n->key, n->value);
+          }
+        }
+      }
+
+      /// remove every entry for which pred(key, value) returns true, one shard at a time; pred
+      /// runs with that shard's write lock held so it must not write to this map.  returns how
+      /// many were removed.
+      template <typename Pred_t>
+      size_t
+      EraseIf(Pred_t&& pred)
+      {
+        size_t removed = 0;
+        for (auto& shard : m_Shards)
+        {
+          std::vector<Node*> unlinked;
+          {
+            std::lock_guard lock{shard.mutex};
+            Table* table = shard.table.load(std::memory_order_relaxed);
+            for (size_t idx = 0; idx <= table->mask; ++idx)
+            {
+              std::atomic<Node*>* link = &table->buckets[idx];
+              while (Node* n = link->load(std::memory_order_relaxed))
+              {
+                if (pred(n->key, n->value))
+                {
+                  // readers on n carry on down the chain as it is now, so n->next stays put
+                  link->store(n->next.load(std::memory_order_relaxed));
+                  unlinked.push_back(n);
+                }
+                else
+                  link = &n->next;
+              }
+            }
+            shard.count -= unlinked.size();
+          }
+          if (unlinked.empty())
+            continue;
+          removed += unlinked.size();
+          epoch::Retire([nodes = std::move(unlinked)] {
+            for (Node* n : nodes)
+              delete n;
+          });
+        }
+        m_Size.fetch_sub(removed, std::memory_order_relaxed);
+        return removed;
+      }
+
+      /// remove the entries under key for which pred(value) returns true, touching only the one
+      /// chain they can be on; same rules for pred as the other EraseIf.  returns how many were
+      /// removed.
+      template <typename Pred_t>
+      size_t
+      EraseIf(const Key_t& key, Pred_t&& pred)
+      {
+        const size_t hash = Hash_t{}(key);
+        auto& shard = ShardFor(hash);
+        std::vector<Node*> unlinked;
+        {
+          std::lock_guard lock{shard.mutex};
+          std::atomic<Node*>* link = &shard.table.load(std::memory_order_relaxed)->Bucket(hash);
+          while (Node* n = link->load(std::memory_order_relaxed))
+          {
+            if (n->key == key and pred(n->value))
+            {
+              link->store(n->next.load(std::memory_order_relaxed));
+              unlinked.push_back(n);
+            }
+            else
+              link = &n->next;
+          }
+          shard.count -= unlinked.size();
+        }
+        const size_t removed = unlinked.size();
+        if (removed)
+        {
+          m_Size.fetch_sub(removed, std::memory_order_relaxed);
+          epoch::Retire([nodes = std::move(unlinked)] {
+            for (Node* n : nodes)
+              delete n;
+          });
+        }
+        return removed;
+      }
+
+      /// replace the first entry under key with a copy of it that update has changed, or add one
+      /// that update makes of a default constructed value if there is none.  readers see the
+      /// entry either as it was or as it is now, never both.  same rules for update as for pred
+      /// in EraseIf.
+      template <typename Update_t>
+      void
+      Update(const Key_t& key, Update_t&& update)
+      {
+        const size_t hash = Hash_t{}(key);
+        auto& shard = ShardFor(hash);
+        Node* old = nullptr;
+        {
+          std::lock_guard lock{shard.mutex};
+          Table* table = shard.table.load(std::memory_order_relaxed);
+          std::atomic<Node*>* link = &table->Bucket(hash);
+          while (Node* n = link->load(std::memory_order_relaxed))
+          {
+            if (n->key == key)
+            {
+              old = n;
+              break;
+            }
+            link = &n->next;
+          }
+          if (old)
+          {
+            Value_t value{old->value};
+            update(value);
+            // readers on old carry on down the chain from it, as with EraseIf
+            link->store(new Node{key, value, old->next.load(std::memory_order_relaxed)});
+          }
+          else
+          {
+            if (shard.count > table->mask)
+              table = Grow(shard, table);
+            auto& bucket = table->Bucket(hash);
+            Value_t value{};
+            update(value);
+            bucket.store(new Node{key, value, bucket.load(std::memory_order_relaxed)});
+            ++shard.count;
+            m_Size.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+        if (old)
+          epoch::Retire([old] { delete old; });
+      }
+
+      /// number of entries
+      size_t
+      Size() const
+      {
+        return m_Size.load(std::memory_order_relaxed);
+      }
+
+     private:
+      Shard&
+      ShardFor(size_t hash)
+      {
+        return m_Shards[hash % NumShards];
+      }
+
+      const Shard&
+      ShardFor(size_t hash) const
+      {
+        return m_Shards[hash % NumShards];
+      }
+
+      /// replace shard's table with one twice the size holding copies of every node.  readers
+      /// still on the old one see it unchanged, since from here on writers only touch the new
+      /// one, and it goes once they are done.
+      Table*
+      Grow(Shard& shard, Table* old)
+      {
+        auto* table = new Table{(old->mask + 1) * 2};
+        for (size_t idx = 0; idx <= old->mask; ++idx)
+        {
+          for (Node* n = old->buckets[idx].load(std::memory_order_relaxed); n;
+               n = n->next.load(std::memory_order_relaxed))
+          {
+            auto& bucket = table->Bucket(Hash_t{}(n->key));
+            bucket.store(
+                new Node{n->key, n->value, bucket.load(std::memory_order_relaxed)},
+                std::memory_order_relaxed);
+          }
+        }
+        shard.table.store(table);
+        epoch::Retire([old] { delete old; });
+        return table;
+      }
+
+      std::array<Shard, NumShards> m_Shards;
+      std::atomic<size_t> m_Size{0};
+    };
+  }  // namespace thread
+}  // namespace llarp
@@ -10,6 +10,11 @@
 #endif
 #endif
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #ifdef _MSC_VER
 #include <windows.h>
 extern "C" void
@@ -51,5 +56,63 @@ namespace llarp
       (void)name;
 #endif
     }
+
+    bool
+    PinThreadToCore(unsigned core)
+    {
+      return PinThreadToCores({core});
+    }
+
+    bool
+    PinThreadToCores(const std::vector<unsigned>& cores)
+    {
+      if (cores.empty())
+        return false;
+#if defined(__linux__)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (const auto core : cores)
+      {
+        if (core >= CPU_SETSIZE)
+        {
+          LogError("Cannot pin thread to cpu ", core, ", the most there can be is ", CPU_SETSIZE);
+          return false;
+        }
+        CPU_SET(core, &set);
+      }
+      if (const int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+      {
+        LogError(
+            "Failed to pin thread to ",
+            cores.size(),
+            " cpus errno = ",
+            rc,
+            " errstr = ",
+            ::strerror(rc));
+        return false;
+      }
+      return true;
+#else
+      LogWarn("Pinning threads to cpus not supported on this platform");
+      return false;
+#endif
+    }
+
+    std::vector<unsigned>
+    GetThreadCores()
+    {
+      std::vector<unsigned> cores;
+#if defined(__linux__)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+      {
+        for (unsigned core = 0; core < CPU_SETSIZE; ++core)
+          if (CPU_ISSET(core, &set))
+            cores.push_back(core);
+      }
+#endif
+      return cores;
+    }
   }  // namespace util
 }  // namespace llarp
@@ -5,6 +5,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <optional>
+#include <vector>
 
 #include "annotations.hpp"
 
@@ -148,6 +149,21 @@ namespace llarp
     void
     SetThreadName(const std::string& name);
 
+    /// pins the calling thread to one cpu core; returns false if that failed or isn't supported
+    /// on this platform
+    bool
+    PinThreadToCore(unsigned core);
+
+    /// pins the calling thread to a set of cpu cores, to be moved between as the scheduler sees
+    /// fit; threads it starts after this start on the same set.  false if that failed, isn't
+    /// supported here, or `cores` is empty
+    bool
+    PinThreadToCores(const std::vector<unsigned>& cores);
+
+    /// the cpu cores the calling thread may run on; empty if we can't tell on this platform
+    std::vector<unsigned>
+    GetThreadCores();
+
     inline pid_t
     GetPid()
     {
@@ -0,0 +1,152 @@
+#include "work_scheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace llarp
+{
+  namespace thread
+  {
+    namespace
+    {
+      constexpr std::array<const char*, NumWorkClasses> ClassNames{
+          "dataPlane", "pathBuild", "background"};
+    }
+
+    WorkScheduler::WorkScheduler(
+        Dispatch dispatch, size_t slots, std::array<ClassConfig, NumWorkClasses> classes)
+        : m_Dispatch{std::move(dispatch)}, m_Slots{std::max<size_t>(slots, 1)}
+    {
+      for (size_t idx = 0; idx < NumWorkClasses; ++idx)
+      {
+        auto& cls = m_Classes[idx];
+        cls.conf = classes[idx];
+        cls.conf.weight = std::max(cls.conf.weight, 1u);
+        cls.maxRunning = std::max<size_t>(std::floor(m_Slots * cls.conf.maxShare), 1);
+      }
+    }
+
+    void
+    WorkScheduler::Queue(WorkClass which, Job job)
+    {
+      std::vector<std::pair<size_t, Queued_t>> picked;
+      {
+        std::lock_guard lock{m_Mutex};
+        auto& cls = m_Classes[static_cast<size_t>(which)];
+        if (cls.conf.limit and cls.jobs.size() >= cls.conf.limit)
+        {
+          cls.jobs.pop_front();
+          ++cls.dropped;
+        }
+        cls.jobs.push_back({std::move(job), Clock::now()});
+        Pick(picked);
+      }
+      Start(std::move(picked));
+    }
+
+    void
+    WorkScheduler::Pick(std::vector<std::pair<size_t, Queued_t>>& picked)
+    {
+      while (m_Running < m_Slots)
+      {
+        // every class that could start a job now earns its weight, the one furthest ahead goes
+        // and pays back what they all earned; over time each gets slots in proportion to weight
+        // without any one going twice in a row more than it has to
+        int64_t total = 0;
+        Class* best = nullptr;
+        size_t bestIdx = 0;
+        for (size_t idx = 0; idx < NumWorkClasses; ++idx)
+        {
+          auto& cls = m_Classes[idx];
+          if (cls.jobs.empty() or cls.running >= cls.maxRunning)
+            continue;
+          cls.current += cls.conf.weight;
+          total += cls.conf.weight;
+          if (not best or cls.current > best->current)
+          {
+            best = &cls;
+            bestIdx = idx;
+          }
+        }
+        if (not best)
+          return;
+        best->current -= total;
+        ++best->running;
+        ++m_Running;
+        picked.emplace_back(bestIdx, std::move(best->jobs.front()));
+        best->jobs.pop_front();
+      }
+    }
+
+    void
+    WorkScheduler::Start(std::vector<std::pair<size_t, Queued_t>> picked)
+    {
+      const auto now = Clock::now();
+      for (auto& [idx, queued] : picked)
+      {
+        m_Classes[idx].wait.Record(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - queued.queuedAt).count());
+        m_Dispatch([this, idx = idx, job = std::move(queued.job)]() {
+          // a job that throws still gives its slot back
+          struct Release
+          {
+            WorkScheduler& self;
+            size_t idx;
+            ~Release()
+            {
+              self.Done(idx);
+            }
+          } release{*this, idx};
+          job();
+        });
+      }
+    }
+
+    void
+    WorkScheduler::Done(size_t idx)
+    {
+      std::vector<std::pair<size_t, Queued_t>> picked;
+      {
+        std::lock_guard lock{m_Mutex};
+        auto& cls = m_Classes[idx];
+        --cls.running;
+        ++cls.ran;
+        --m_Running;
+        Pick(picked);
+      }
+      Start(std::move(picked));
+    }
+
+    size_t
+    WorkScheduler::Queued(WorkClass cls) const
+    {
+      std::lock_guard lock{m_Mutex};
+      return m_Classes[static_cast<size_t>(cls)].jobs.size();
+    }
+
+    size_t
+    WorkScheduler::Running(WorkClass cls) const
+    {
+      std::lock_guard lock{m_Mutex};
+      return m_Classes[static_cast<size_t>(cls)].running;
+    }
+
+    util::StatusObject
+    WorkScheduler::ExtractStatus() const
+    {
+      util::StatusObject obj{{"slots", m_Slots}};
+      std::lock_guard lock{m_Mutex};
+      for (size_t idx = 0; idx < NumWorkClasses; ++idx)
+      {
+        const auto& cls = m_Classes[idx];
+        obj[ClassNames[idx]] = util::StatusObject{
+            {"queued", cls.jobs.size()},
+            {"running", cls.running},
+            {"ran", cls.ran},
+            {"dropped", cls.dropped},
+            {"waitMicros", cls.wait.ExtractStatus()}};
+      }
+      return obj;
+    }
+  }  // namespace thread
+}  // namespace llarp
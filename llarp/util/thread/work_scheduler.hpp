@@ -0,0 +1,131 @@
+#pragma once
+
+#include <llarp/util/histogram.hpp>
+#include <llarp/util/status.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace llarp
+{
+  namespace thread
+  {
+    /// what a job handed to the worker pool is for, most urgent first
+    enum class WorkClass : uint8_t
+    {
+      /// crypto of traffic in flight: link packets, path onion layers, convo frames
+      DataPlane,
+      /// setting up: building paths, ours and others' through us, and convo key exchanges
+      PathBuild,
+      /// anything that can wait: router contact checks, bookkeeping
+      Background,
+    };
+
+    inline constexpr size_t NumWorkClasses = 3;
+
+    /// puts jobs for a pool of worker threads in a queue per work class and hands them on to the
+    /// pool no more than slots at a time, so that a backlog of one class waits in its own queue
+    /// rather than in front of everyone else in the pool's.  free slots go to the queued classes
+    /// in proportion to their weights (smooth weighted round robin), and each class can be capped
+    /// to a share of the slots so that slow jobs of one class can't take every thread.
+    ///
+    /// a class with a queue limit drops its oldest job when a new one would go past it; only data
+    /// plane crypto has one by default, where a dropped job is a lost packet, not a stuck state.
+    ///
+    /// safe to queue from any thread.
+    class WorkScheduler
+    {
+     public:
+      using Job = std::function<void(void)>;
+      using Dispatch = std::function<void(Job)>;
+
+      struct ClassConfig
+      {
+        /// share of the free slots this class gets when others are queued too
+        unsigned weight;
+        /// most jobs of this class queued (not counting running ones); 0 for no limit
+        size_t limit;
+        /// most of the slots jobs of this class may run in at once, as a fraction of all of them;
+        /// always at least one
+        double maxShare;
+      };
+
+      static constexpr std::array<ClassConfig, NumWorkClasses> DefaultClasses{{
+          {8, 8192, 1.0},
+          {4, 0, 0.5},
+          {1, 0, 0.25},
+      }};
+
+      /// dispatch hands a job to the pool; slots is how many jobs we let the pool have at once,
+      /// e.g. its number of threads
+      WorkScheduler(
+          Dispatch dispatch,
+          size_t slots,
+          std::array<ClassConfig, NumWorkClasses> classes = DefaultClasses);
+
+      WorkScheduler(const WorkScheduler&) = delete;
+      WorkScheduler&
+      operator=(const WorkScheduler&) = delete;
+
+      void
+      Queue(WorkClass cls, Job job);
+
+      /// number of jobs of cls waiting for a slot
+      size_t
+      Queued(WorkClass cls) const;
+
+      /// number of jobs of cls handed to the pool and not yet done
+      size_t
+      Running(WorkClass cls) const;
+
+      /// per class queue depth, running and dropped jobs, and how long jobs waited for a slot
+      util::StatusObject
+      ExtractStatus() const;
+
+     private:
+      using Clock = std::chrono::steady_clock;
+
+      struct Queued_t
+      {
+        Job job;
+        Clock::time_point queuedAt;
+      };
+
+      struct Class
+      {
+        ClassConfig conf;
+        size_t maxRunning;
+        int64_t current = 0;
+        std::deque<Queued_t> jobs;
+        size_t running = 0;
+        uint64_t ran = 0;
+        uint64_t dropped = 0;
+        /// microseconds from queuing to starting
+        util::Histogram wait;
+      };
+
+      /// picks what to run next, while we hold the lock; the jobs are handed to the pool after
+      /// we let go of it
+      void
+      Pick(std::vector<std::pair<size_t, Queued_t>>& picked);
+
+      void
+      Start(std::vector<std::pair<size_t, Queued_t>> picked);
+
+      void
+      Done(size_t cls);
+
+      const Dispatch m_Dispatch;
+      const size_t m_Slots;
+      mutable std::mutex m_Mutex;
+      std::array<Class, NumWorkClasses> m_Classes;
+      size_t m_Running = 0;
+    };
+  }  // namespace thread
+}  // namespace llarp
@@ -19,6 +19,8 @@ namespace llarp
     const static auto started_at_system = Clock_t::now();
 
     const static auto started_at_steady = std::chrono::steady_clock::now();
+
+    const Duration_t* virtual_now = nullptr;
   }  // namespace
 
   uint64_t
@@ -35,9 +37,17 @@ namespace llarp
         std::chrono::steady_clock::now() - started_at_steady);
   }
 
+  void
+  set_virtual_time(const Duration_t* now)
+  {
+    virtual_now = now;
+  }
+
   Duration_t
   time_now_ms()
   {
+    if (virtual_now)
+      return *virtual_now;
     auto t = uptime();
 #ifdef TESTNET_SPEED
     t /= uint64_t{TESTNET_SPEED};
@@ -18,6 +18,12 @@ namespace llarp
   Duration_t
   uptime();
 
+  /// makes time_now_ms() read `now` instead of the clock, for routers run by the simulator on its
+  /// virtual time; nullptr goes back to the clock.  whoever sets it owns `now` and must reset this
+  /// before `now` goes away.  not thread safe: set it before anything that reads the time starts.
+  void
+  set_virtual_time(const Duration_t* now);
+
   /// convert to milliseconds
   uint64_t
   ToMS(Duration_t duration);
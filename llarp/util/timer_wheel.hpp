@@ -0,0 +1,144 @@
+#pragma once
+
+#include "time.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// a hierarchical timer wheel: remembers values with deadlines and hands back the ones that
+    /// are due, for expiring big collections of things without looking at all of them every
+    /// tick.  scheduling is O(1); advancing costs one step per elapsed tick plus O(1) per value
+    /// each time it moves down a level, which it does at most Levels times.
+    ///
+    /// deadlines are rounded up to the resolution, so values come out up to one resolution late
+    /// but never early.  not thread safe; values are copied, so use something cheap like a
+    /// weak_ptr.  nothing is ever cancelled: whoever gets a value back checks whether it still
+    /// means anything, and schedules it again if its deadline moved.
+    template <typename Value_t>
+    class TimerWheel
+    {
+     public:
+      static constexpr unsigned SlotBits = 8;
+      static constexpr size_t Slots = size_t{1} << SlotBits;
+      static constexpr unsigned Levels = 4;
+
+      explicit TimerWheel(llarp_time_t resolution) : m_Resolution{resolution}
+      {}
+
+      /// hand value back from Advance once now reaches when
+      void
+      Schedule(llarp_time_t when, Value_t value)
+      {
+        if (not m_Started)
+          Start(llarp::time_now_ms());
+        // anything already due goes out on the next tick
+        Place({std::max(TickFor(when), m_Current + 1), std::move(value)});
+        ++m_Size;
+      }
+
+      /// move time on to now, calling visit(value) with everything that is due by then.  visit
+      /// may schedule more.
+      template <typename Visit_t>
+      void
+      Advance(llarp_time_t now, Visit_t&& visit)
+      {
+        if (not m_Started)
+        {
+          Start(now);
+          return;
+        }
+        const uint64_t target = now / m_Resolution;
+        while (m_Current < target)
+        {
+          ++m_Current;
+          // a level below us wrapped around, so its next stretch of ticks comes down from us
+          for (unsigned level = 1; level < Levels; ++level)
+          {
+            if ((m_Current & ((uint64_t{1} << (SlotBits * level)) - 1)) != 0)
+              break;
+            Cascade(level, (m_Current >> (SlotBits * level)) & (Slots - 1));
+          }
+          auto due = std::move(m_Wheels[0][m_Current & (Slots - 1)]);
+          m_Wheels[0][m_Current & (Slots - 1)].clear();
+          for (auto& entry : due)
+          {
+            // only ones that waited out past the top level's span can be early
+            if (entry.first > m_Current)
+            {
+              Place(std::move(entry));
+              continue;
+            }
+            --m_Size;
+            visit(std::move(entry.second));
+          }
+        }
+      }
+
+      /// how many values are scheduled
+      size_t
+      Size() const
+      {
+        return m_Size;
+      }
+
+     private:
+      using Entry = std::pair<uint64_t, Value_t>;
+
+      uint64_t
+      TickFor(llarp_time_t when) const
+      {
+        return (when + m_Resolution - llarp_time_t{1}) / m_Resolution;
+      }
+
+      void
+      Start(llarp_time_t now)
+      {
+        m_Current = now / m_Resolution;
+        m_Started = true;
+      }
+
+      /// put an entry on the lowest level whose span covers the distance to its tick; further
+      /// out than the top level spans it waits in the farthest top slot and gets placed again
+      /// when that comes around
+      void
+      Place(Entry entry)
+      {
+        const uint64_t diff = entry.first ^ m_Current;
+        for (unsigned level = 0; level < Levels; ++level)
+        {
+          if (diff < (uint64_t{1} << (SlotBits * (level + 1))))
+          {
+            m_Wheels[level][(entry.first >> (SlotBits * level)) & (Slots - 1)].push_back(
+                std::move(entry));
+            return;
+          }
+        }
+        constexpr unsigned top = Levels - 1;
+        m_Wheels[top][((m_Current >> (SlotBits * top)) - 1) & (Slots - 1)].push_back(
+            std::move(entry));
+      }
+
+      void
+      Cascade(unsigned level, size_t slot)
+      {
+        auto entries = std::move(m_Wheels[level][slot]);
+        m_Wheels[level][slot].clear();
+        for (auto& entry : entries)
+          Place(std::move(entry));
+      }
+
+      const llarp_time_t m_Resolution;
+      uint64_t m_Current = 0;
+      bool m_Started = false;
+      size_t m_Size = 0;
+      std::array<std::array<std::vector<Entry>, Slots>, Levels> m_Wheels;
+    };
+  }  // namespace util
+}  // namespace llarp
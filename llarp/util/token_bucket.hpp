@@ -0,0 +1,79 @@
+#pragma once
+
+#include "time.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace llarp
+{
+  namespace util
+  {
+    /// a token bucket rate limiter: on average lets through rate units (bytes, say) a second, and
+    /// bursts of up to burst after being idle.  a send may take the bucket into debt, so a
+    /// message bigger than the burst still goes eventually; the bucket just stays shut until the
+    /// debt is paid off.  a rate of 0 means no limit.
+    class TokenBucket
+    {
+     public:
+      TokenBucket() = default;
+
+      TokenBucket(uint64_t rate, uint64_t burst)
+          : m_Rate{rate}, m_Burst{static_cast<int64_t>(burst)}, m_Tokens{m_Burst}
+      {}
+
+      bool
+      Unlimited() const
+      {
+        return m_Rate == 0;
+      }
+
+      /// top up for the time since we last did and return true if we may send now
+      bool
+      Ready(llarp_time_t now)
+      {
+        if (Unlimited())
+          return true;
+        Refill(now);
+        return m_Tokens > 0;
+      }
+
+      /// take n tokens for something sent; call after Ready said yes
+      void
+      Consume(uint64_t n)
+      {
+        if (not Unlimited())
+          m_Tokens -= static_cast<int64_t>(n);
+      }
+
+      /// return true if we have been idle long enough to be back at a full burst
+      bool
+      Full(llarp_time_t now)
+      {
+        if (Unlimited())
+          return true;
+        Refill(now);
+        return m_Tokens >= m_Burst;
+      }
+
+     private:
+      void
+      Refill(llarp_time_t now)
+      {
+        if (now <= m_LastRefill)
+          return;
+        const auto added = static_cast<int64_t>(m_Rate * (now - m_LastRefill).count() / 1000);
+        // leave the clock alone until there is a whole token to add, so slow rates still fill
+        if (added == 0)
+          return;
+        m_Tokens = std::min(m_Tokens + added, m_Burst);
+        m_LastRefill = now;
+      }
+
+      uint64_t m_Rate = 0;
+      int64_t m_Burst = 0;
+      int64_t m_Tokens = 0;
+      llarp_time_t m_LastRefill = 0s;
+    };
+  }  // namespace util
+}  // namespace llarp
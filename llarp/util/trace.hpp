@@ -0,0 +1,56 @@
+#pragma once
+
+/// static tracepoints (USDT probes, as read by bpftrace, perf and systemtap) on the packet hot
+/// paths, so a packet can be followed through the link layer, path relaying and the exit with
+/// the time spent in each stage.  they are only compiled in when built with -DWITH_USDT=ON;
+/// otherwise LLARP_TRACE expands to nothing, arguments and all.  when compiled in, a probe no one
+/// is attached to is a nop instruction, so arguments are kept to what is at hand already.
+///
+/// the probes, all under the "lokinet" provider:
+///
+///     link_recv(session, bytes)                       a udp packet for a session
+///     link_decrypted(session, packets, dropped)       a batch of them decrypted
+///     relay_upstream_recv(path, id, bytes)            a relayed message from downstream
+///     relay_downstream_recv(path, id, bytes)          a relayed message from upstream
+///     transit_upstream(rxpath, txpath, id, bytes)     one decrypted and sent on upstream
+///     transit_downstream(txpath, rxpath, id, bytes)   one encrypted and sent on downstream
+///     outbound_send(router, bytes, priority)          a message handed to a link session
+///     tun_user_packet(bytes)                          a packet read from the tun interface
+///     exit_flush(inbound, outbound)                   an exit writing out what it gathered
+///
+/// session is the session's address; path, router and id are the first 8 bytes of the path id,
+/// router id and nonce, in host order.  a relayed message's nonce is what identifies it at a hop;
+/// the nonce it goes on with is another, so the transit probes give the one it went on with.
+/// e.g.  bpftrace -e 'usdt:/usr/bin/lokinet:lokinet:transit_upstream { @[arg0] = count(); }'
+
+#ifdef LOKINET_USDT
+
+#include <sys/sdt.h>
+
+#include <cstdint>
+#include <cstring>
+
+#define LLARP_TRACE(probe, ...) STAP_PROBEV(lokinet, probe, __VA_ARGS__)
+
+namespace llarp::trace
+{
+  /// the first 8 bytes of an id, key or nonce, as a number to hand a probe
+  template <typename Bytes>
+  inline uint64_t
+  ID(const Bytes& bytes)
+  {
+    static_assert(sizeof(bytes) >= sizeof(uint64_t));
+    uint64_t id;
+    std::memcpy(&id, bytes.data(), sizeof(id));
+    return id;
+  }
+}  // namespace llarp::trace
+
+#else
+
+#define LLARP_TRACE(probe, ...) \
+  do                            \
+  {                             \
+  } while (0)
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "platform.hpp"
 #include "common.hpp"
+#include "packet_ring.hpp"
 #include <llarp.hpp>
 
 namespace llarp::vpn
@@ -53,6 +54,78 @@ namespace llarp::vpn
     }
   };
 
+  /// the batched mode: packets come and go through rings shared with the java side rather than
+  /// the VpnService's fd, so the java side moves them in bulk with no jni call or syscall a packet
+  class AndroidRingInterface : public NetworkInterface
+  {
+    const std::shared_ptr<AndroidRings> m_Rings;
+
+   public:
+    AndroidRingInterface(InterfaceInfo info, std::shared_ptr<AndroidRings> rings)
+        : NetworkInterface{std::move(info)}, m_Rings{std::move(rings)}
+    {}
+
+    int
+    PollFD() const override
+    {
+      return m_Rings->in.PollFD();
+    }
+
+    net::IPPacket
+    ReadNextPacket() override
+    {
+      std::vector<net::IPPacket> one;
+      if (ReadPackets(one, 1) == 0)
+        return net::IPPacket{};
+      return std::move(one.front());
+    }
+
+    size_t
+    ReadPackets(std::vector<net::IPPacket>& into, size_t max) override
+    {
+      auto& ring = m_Rings->in;
+      ring.ClearWakeup();
+      size_t n = 0;
+      uint32_t avail = ring.Available();
+      while (avail > 0 and n < max)
+      {
+        const uint32_t take = std::min<size_t>(avail, max - n);
+        for (uint32_t idx = 0; idx < take; ++idx)
+        {
+          if (auto pkt = ring.Peek(idx); not pkt.empty())
+          {
+            into.emplace_back(std::move(pkt));
+            ++n;
+          }
+        }
+        // what came in while we were taking these out, so that we only hand back fewer than max
+        // when the ring is empty
+        avail = ring.Release(take);
+      }
+      return n;
+    }
+
+    bool
+    WritePacket(net::IPPacket pkt) override
+    {
+      return m_Rings->out.Put(pkt);
+    }
+
+    size_t
+    WritePackets(std::vector<net::IPPacket>& pkts) override
+    {
+      auto& ring = m_Rings->out;
+      uint32_t staged = 0;
+      for (const auto& pkt : pkts)
+      {
+        if (ring.Stage(staged, pkt))
+          ++staged;
+      }
+      ring.Publish(staged);
+      return staged;
+    }
+  };
+
   class AndroidRouteManager : public IRouteManager
   {
     void AddRoute(net::ipaddr_t, net::ipaddr_t) override{};
@@ -81,15 +154,18 @@ namespace llarp::vpn
   class AndroidPlatform : public Platform
   {
     const int fd;
+    const std::shared_ptr<AndroidRings> rings;
     AndroidRouteManager _routeManager{};
 
    public:
-    AndroidPlatform(llarp::Context* ctx) : fd{ctx->androidFD}
+    AndroidPlatform(llarp::Context* ctx) : fd{ctx->androidFD}, rings{ctx->androidRings}
     {}
 
     std::shared_ptr<NetworkInterface>
     ObtainInterface(InterfaceInfo info, AbstractRouter*) override
     {
+      if (rings)
+        return std::make_shared<AndroidRingInterface>(std::move(info), rings);
       return std::make_shared<AndroidInterface>(std::move(info), fd);
     }
     IRouteManager&
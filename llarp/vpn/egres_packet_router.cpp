@@ -1,102 +1,72 @@
 #include "egres_packet_router.hpp"
 
+#include <algorithm>
+
 namespace llarp::vpn
 {
-  struct EgresUDPPacketHandler : public EgresLayer4Handler
-  {
-    EgresPacketHandlerFunc m_BaseHandler;
-    std::unordered_map<nuint16_t, EgresPacketHandlerFunc> m_LocalPorts;
-
-    explicit EgresUDPPacketHandler(EgresPacketHandlerFunc baseHandler)
-        : m_BaseHandler{std::move(baseHandler)}
-    {}
-
-    void
-    AddSubHandler(nuint16_t localport, EgresPacketHandlerFunc handler) override
-    {
-      m_LocalPorts.emplace(std::move(localport), std::move(handler));
-    }
-
-    void
-    RemoveSubHandler(nuint16_t localport) override
-    {
-      m_LocalPorts.erase(localport);
-    }
-
-    void
-    HandleIPPacketFrom(AddressVariant_t from, net::IPPacket pkt) override
-    {
-      if (auto dstPort = pkt.DstPort())
-      {
-        if (auto itr = m_LocalPorts.find(*dstPort); itr != m_LocalPorts.end())
-        {
-          itr->second(std::move(from), std::move(pkt));
-          return;
-        }
-      }
-      m_BaseHandler(std::move(from), std::move(pkt));
-    }
-  };
-
-  struct EgresGenericLayer4Handler : public EgresLayer4Handler
+  namespace
   {
-    EgresPacketHandlerFunc m_BaseHandler;
-
-    explicit EgresGenericLayer4Handler(EgresPacketHandlerFunc baseHandler)
-        : m_BaseHandler{std::move(baseHandler)}
-    {}
-
-    void
-    HandleIPPacketFrom(AddressVariant_t from, net::IPPacket pkt) override
-    {
-      m_BaseHandler(std::move(from), std::move(pkt));
-    }
-  };
+    constexpr byte_t udp_proto = 0x11;
+  }
 
   EgresPacketRouter::EgresPacketRouter(EgresPacketHandlerFunc baseHandler)
       : m_BaseHandler{std::move(baseHandler)}
   {}
 
+  std::vector<std::pair<nuint16_t, EgresPacketHandlerFunc>>::iterator
+  EgresPacketRouter::FindUDPHandler(nuint16_t port)
+  {
+    return std::lower_bound(
+        m_UDPHandler.begin(), m_UDPHandler.end(), port, [](const auto& item, nuint16_t p) {
+          return item.first.n < p.n;
+        });
+  }
+
   void
   EgresPacketRouter::HandleIPPacketFrom(AddressVariant_t from, net::IPPacket pkt)
   {
     const auto proto = pkt.Header()->protocol;
-    if (const auto itr = m_IPProtoHandler.find(proto); itr != m_IPProtoHandler.end())
+    if (proto == udp_proto and not m_UDPHandler.empty())
     {
-      itr->second->HandleIPPacketFrom(std::move(from), std::move(pkt));
+      if (const auto dstPort = pkt.DstPort())
+      {
+        if (auto itr = FindUDPHandler(*dstPort);
+            itr != m_UDPHandler.end() and itr->first == *dstPort)
+        {
+          itr->second(std::move(from), std::move(pkt));
+          return;
+        }
+      }
     }
+    if (const auto& handler = m_IPProtoHandler[proto])
+      handler(std::move(from), std::move(pkt));
     else
       m_BaseHandler(std::move(from), std::move(pkt));
   }
 
-  namespace
-  {
-    constexpr byte_t udp_proto = 0x11;
-  }
-
   void
   EgresPacketRouter::AddUDPHandler(huint16_t localport, EgresPacketHandlerFunc func)
   {
-    if (m_IPProtoHandler.find(udp_proto) == m_IPProtoHandler.end())
-    {
-      m_IPProtoHandler.emplace(udp_proto, std::make_unique<EgresUDPPacketHandler>(m_BaseHandler));
-    }
-    m_IPProtoHandler[udp_proto]->AddSubHandler(ToNet(localport), std::move(func));
+    const auto port = ToNet(localport);
+    const auto itr = FindUDPHandler(port);
+    // like the map this used to be, the first handler added for a port stays
+    if (itr != m_UDPHandler.end() and itr->first == port)
+      return;
+    m_UDPHandler.emplace(itr, port, std::move(func));
   }
 
   void
   EgresPacketRouter::AddIProtoHandler(uint8_t proto, EgresPacketHandlerFunc func)
   {
-    m_IPProtoHandler[proto] = std::make_unique<EgresGenericLayer4Handler>(std::move(func));
+    m_IPProtoHandler[proto] = std::move(func);
   }
 
   void
   EgresPacketRouter::RemoveUDPHandler(huint16_t localport)
   {
-    if (auto itr = m_IPProtoHandler.find(udp_proto); itr != m_IPProtoHandler.end())
-    {
-      itr->second->RemoveSubHandler(ToNet(localport));
-    }
+    const auto port = ToNet(localport);
+    if (auto itr = FindUDPHandler(port); itr != m_UDPHandler.end() and itr->first == port)
+      m_UDPHandler.erase(itr);
   }
 
 }  // namespace llarp::vpn
@@ -2,29 +2,28 @@
 #include <llarp/net/net_int.hpp>
 #include <llarp/net/ip_packet.hpp>
 #include <llarp/endpoint_base.hpp>
+#include <array>
 #include <functional>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace llarp::vpn
 {
   using AddressVariant_t = llarp::EndpointBase::AddressVariant_t;
   using EgresPacketHandlerFunc = std::function<void(AddressVariant_t, net::IPPacket)>;
 
-  struct EgresLayer4Handler
-  {
-    virtual ~EgresLayer4Handler() = default;
-
-    virtual void
-    HandleIPPacketFrom(AddressVariant_t from, net::IPPacket pkt) = 0;
-
-    virtual void AddSubHandler(nuint16_t, EgresPacketHandlerFunc){};
-    virtual void RemoveSubHandler(nuint16_t){};
-  };
-
+  /// as PacketRouter, for packets that come with who they are from
   class EgresPacketRouter
   {
     EgresPacketHandlerFunc m_BaseHandler;
-    std::unordered_map<uint8_t, std::unique_ptr<EgresLayer4Handler>> m_IPProtoHandler;
+    /// by ip protocol, empty where there is none
+    std::array<EgresPacketHandlerFunc, 256> m_IPProtoHandler;
+    /// by udp destination port, sorted by port; there are only ever a few
+    std::vector<std::pair<nuint16_t, EgresPacketHandlerFunc>> m_UDPHandler;
+
+    /// where the handler for udp port is or would go
+    std::vector<std::pair<nuint16_t, EgresPacketHandlerFunc>>::iterator
+    FindUDPHandler(nuint16_t port);
 
    public:
     /// baseHandler will be called if no other handlers matches a packet
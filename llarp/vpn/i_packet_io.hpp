@@ -3,6 +3,8 @@
 #include <llarp/net/ip_packet.hpp>
 #include <llarp/util/types.hpp>
 
+#include <vector>
+
 namespace llarp::vpn
 {
   class I_Packet_IO
@@ -27,6 +29,36 @@ namespace llarp::vpn
     virtual bool
     WritePacket(net::IPPacket pkt) = 0;
 
+    /// read up to max packets onto the end of into, returning how many; fewer than max means
+    /// there are none ready for now
+    virtual size_t
+    ReadPackets(std::vector<net::IPPacket>& into, size_t max)
+    {
+      size_t n = 0;
+      while (n < max)
+      {
+        auto pkt = ReadNextPacket();
+        if (pkt.empty())
+          break;
+        into.emplace_back(std::move(pkt));
+        ++n;
+      }
+      return n;
+    }
+
+    /// write all of pkts, moving out of them, and return how many we did not drop
+    virtual size_t
+    WritePackets(std::vector<net::IPPacket>& pkts)
+    {
+      size_t n = 0;
+      for (auto& pkt : pkts)
+      {
+        if (WritePacket(std::move(pkt)))
+          ++n;
+      }
+      return n;
+    }
+
     /// get pollable fd for reading
     virtual int
     PollFD() const = 0;
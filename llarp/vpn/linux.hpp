@@ -6,15 +6,25 @@
 #include <sys/types.h>
 #include <fcntl.h>
 #include "common.hpp"
+#include "offload.hpp"
 #include <net/if.h>
 #include <linux/if_tun.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
 
 #include <cstring>
 #include <arpa/inet.h>
 #include <linux/rtnetlink.h>
 #include <llarp/net/net.hpp>
+#include <llarp/util/buffer_pool.hpp>
 #include <llarp/util/str.hpp>
+#include <llarp/util/thread/queue.hpp>
+#include <algorithm>
+#include <array>
 #include <exception>
+#include <thread>
+#include <utility>
 
 #include <oxenc/endian.h>
 
@@ -34,25 +44,150 @@ namespace llarp::vpn
 
   class LinuxInterface : public NetworkInterface
   {
-    const int m_fd;
+    /// one per queue of the interface
+    std::vector<int> m_fds;
+
+    /// with more than one queue, each is read on a thread of its own into m_Incoming, which
+    /// bumps m_ReadyFD for the event loop to poll
+    static constexpr size_t IncomingQueueSize = 1024;
+    static constexpr size_t ReadBatch = 64;
+    thread::Queue<net::IPPacket> m_Incoming{IncomingQueueSize};
+    int m_ReadyFD = -1;
+    int m_StopFD = -1;
+    std::vector<std::thread> m_Readers;
+    /// with offloads on, everything read or written starts with a VNetHeader
+    bool m_Offload = false;
+    /// what ReadNextPacket reads into, so that a packet gets a buffer of only its own size; with
+    /// offloads on, big enough for a whole super packet
+    std::vector<byte_t> m_ReadBuf;
+    /// the packets of the last read that ReadNextPacket has not handed out yet
+    std::vector<net::IPPacket> m_Segments;
+    size_t m_NextSegment = 0;
+    /// what WritePackets puts each write together in with offloads on
+    std::vector<byte_t> m_WriteBuf;
+
+    /// open one more queue of the interface named in ifr, which gets the name the kernel gave it
+    void
+    OpenQueue(ifreq& ifr, bool multi)
+    {
+      const int fd = ::open("/dev/net/tun", O_RDWR | (multi ? O_NONBLOCK : 0));
+      if (fd == -1)
+        throw std::runtime_error("cannot open /dev/net/tun " + std::string{strerror(errno)});
+      ifr.ifr_flags = IFF_TUN | IFF_NO_PI | (multi ? IFF_MULTI_QUEUE : 0)
+          | (m_Offload ? IFF_VNET_HDR : 0);
+      if (::ioctl(fd, TUNSETIFF, &ifr) == -1)
+      {
+        const std::string err{strerror(errno)};
+        ::close(fd);
+        throw std::runtime_error("cannot set interface name: " + err);
+      }
+      // the header is the size of a VNetHeader unless set otherwise.  without the offloads the
+      // kernel still puts one on everything, it just never leaves us anything to do
+      if (m_Offload
+          and ::ioctl(fd, TUNSETOFFLOAD, TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6) == -1
+          and m_fds.empty())
+        LogWarn("cannot turn on offloads for ", ifr.ifr_name, ": ", strerror(errno));
+      m_fds.push_back(fd);
+    }
 
-   public:
-    LinuxInterface(InterfaceInfo info)
-        : NetworkInterface{std::move(info)}, m_fd{::open("/dev/net/tun", O_RDWR)}
+    /// the packets in the sz bytes of buf read off a queue, onto the end of into
+    void
+    Unpack(const byte_t* buf, size_t sz, std::vector<net::IPPacket>& into) const
+    {
+      if (not m_Offload)
+      {
+        into.emplace_back(util::BufferPool::Acquire(buf, sz));
+        return;
+      }
+      if (sz < sizeof(VNetHeader))
+        return;
+      VNetHeader hdr;
+      std::memcpy(&hdr, buf, sizeof(hdr));
+      SegmentOffloaded(hdr, buf + sizeof(hdr), sz - sizeof(hdr), into);
+    }
 
+    void
+    ReadQueue(int fd)
     {
-      if (m_fd == -1)
-        throw std::runtime_error("cannot open /dev/net/tun " + std::string{strerror(errno)});
+      std::array<pollfd, 2> fds{pollfd{fd, POLLIN, 0}, pollfd{m_StopFD, POLLIN, 0}};
+      std::vector<byte_t> buf(m_ReadBuf.size());
+      std::vector<net::IPPacket> got;
+      while (true)
+      {
+        if (::poll(fds.data(), fds.size(), -1) == -1)
+        {
+          if (errno == EINTR)
+            continue;
+          LogError("cannot poll interface queue: ", strerror(errno));
+          return;
+        }
+        if (fds[1].revents)
+          return;
+        bool queued = false;
+        for (size_t n = 0; n < ReadBatch; ++n)
+        {
+          const auto sz = ::read(fd, buf.data(), buf.size());
+          if (sz <= 0)
+            break;
+          got.clear();
+          Unpack(buf.data(), sz, got);
+          for (auto& pkt : got)
+          {
+            if (pkt.empty())
+              continue;
+            // with the event loop this far behind we drop, as the kernel does when a queue is
+            // full
+            if (m_Incoming.tryPushBack(std::move(pkt)) == thread::QueueReturn::Success)
+              queued = true;
+          }
+        }
+        if (queued)
+        {
+          const uint64_t one = 1;
+          [[maybe_unused]] const auto wrote = ::write(m_ReadyFD, &one, sizeof(one));
+        }
+      }
+    }
+
+    /// the queue a packet's flow goes out on, so that a flow's packets stay in order
+    int
+    QueueFor(const net::IPPacket& pkt) const
+    {
+      if (m_fds.size() == 1)
+        return m_fds[0];
+      size_t hash = std::hash<uint8_t>{}(pkt.protocol());
+      if (pkt.IsV4())
+      {
+        hash ^= std::hash<uint32_t>{}(pkt.srcv4().h) * 31;
+        hash ^= std::hash<uint32_t>{}(pkt.dstv4().h) * 131;
+        hash ^= std::hash<uint16_t>{}(pkt.SrcPort().value_or(nuint16_t{0}).n) * 1031;
+        hash ^= std::hash<uint16_t>{}(pkt.DstPort().value_or(nuint16_t{0}).n) * 10037;
+      }
+      else
+      {
+        hash ^= std::hash<huint128_t>{}(pkt.srcv6()) * 31;
+        hash ^= std::hash<huint128_t>{}(pkt.dstv6()) * 131;
+      }
+      return m_fds[hash % m_fds.size()];
+    }
+
+   public:
+    LinuxInterface(InterfaceInfo info) : NetworkInterface{std::move(info)}
+    {
+      m_Info.queues = std::max<size_t>(m_Info.queues, 1);
+      const bool multi = m_Info.queues > 1;
+      m_Offload = m_Info.offload;
+      m_ReadBuf.resize(m_Offload ? MaxOffloadedSize : net::IPPacket::MaxSize);
 
       ifreq ifr{};
       in6_ifreq ifr6{};
-      ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
       std::copy_n(
           m_Info.ifname.c_str(),
           std::min(m_Info.ifname.size(), sizeof(ifr.ifr_name)),
           ifr.ifr_name);
-      if (::ioctl(m_fd, TUNSETIFF, &ifr) == -1)
-        throw std::runtime_error("cannot set interface name: " + std::string{strerror(errno)});
+      // the first queue sets up the interface, the others attach to it by the name it got
+      while (m_fds.size() < m_Info.queues)
+        OpenQueue(ifr, multi);
       IOCTL control{AF_INET};
 
       control.ioctl(SIOCGIFFLAGS, &ifr);
@@ -90,51 +225,144 @@ namespace llarp::vpn
       }
       ifr.ifr_flags = static_cast<short>(flags | IFF_UP | IFF_NO_PI);
       control.ioctl(SIOCSIFFLAGS, &ifr);
+
+      if (multi)
+      {
+        m_ReadyFD = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_StopFD = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_ReadyFD == -1 or m_StopFD == -1)
+          throw std::runtime_error("cannot make eventfd: " + std::string{strerror(errno)});
+        m_Incoming.enable();
+        for (const int fd : m_fds)
+          m_Readers.emplace_back([this, fd] { ReadQueue(fd); });
+        LogInfo(m_Info.ifname, " reading ", m_fds.size(), " queues");
+      }
+      if (m_Offload)
+        LogInfo(m_Info.ifname, " using tcp segmentation and checksum offloads");
     }
 
     virtual ~LinuxInterface()
     {
-      ::close(m_fd);
+      if (not m_Readers.empty())
+      {
+        const uint64_t one = 1;
+        [[maybe_unused]] const auto wrote = ::write(m_StopFD, &one, sizeof(one));
+        for (auto& reader : m_Readers)
+          reader.join();
+      }
+      for (const int fd : {m_ReadyFD, m_StopFD})
+      {
+        if (fd != -1)
+          ::close(fd);
+      }
+      for (const int fd : m_fds)
+        ::close(fd);
+    }
+
+    size_t
+    Queues() const override
+    {
+      return m_fds.size();
+    }
+
+    bool
+    Offloaded() const override
+    {
+      return m_Offload;
     }
 
     int
     PollFD() const override
     {
-      return m_fd;
+      return m_Readers.empty() ? m_fds[0] : m_ReadyFD;
     }
 
     net::IPPacket
     ReadNextPacket() override
     {
-      std::vector<byte_t> pkt;
-      pkt.resize(net::IPPacket::MaxSize);
-      const auto sz = read(m_fd, pkt.data(), pkt.capacity());
-      if (sz < 0)
+      if (not m_Readers.empty())
+      {
+        if (auto pkt = m_Incoming.tryPopFront())
+          return std::move(*pkt);
+        // drained; reset what woke us, then look once more for anything queued before that
+        uint64_t count;
+        [[maybe_unused]] const auto got = ::read(m_ReadyFD, &count, sizeof(count));
+        if (auto pkt = m_Incoming.tryPopFront())
+          return std::move(*pkt);
+        return net::IPPacket{};
+      }
+      // one read can be a super packet of many
+      while (m_NextSegment == m_Segments.size())
       {
-        if (errno == EAGAIN or errno == EWOULDBLOCK)
+        m_Segments.clear();
+        m_NextSegment = 0;
+        const auto sz = read(m_fds[0], m_ReadBuf.data(), m_ReadBuf.size());
+        if (sz < 0)
         {
-          errno = 0;
-          return net::IPPacket{};
+          if (errno == EAGAIN or errno == EWOULDBLOCK)
+          {
+            errno = 0;
+            return net::IPPacket{};
+          }
+          throw std::error_code{errno, std::system_category()};
         }
-        throw std::error_code{errno, std::system_category()};
+        Unpack(m_ReadBuf.data(), sz, m_Segments);
       }
-      pkt.resize(sz);
-      return pkt;
+      return std::move(m_Segments[m_NextSegment++]);
     }
 
     bool
     WritePacket(net::IPPacket pkt) override
     {
-      const auto sz = write(m_fd, pkt.data(), pkt.size());
+      if (m_PacketWriter and m_PacketWriter(pkt))
+        return true;
+      if (m_Offload)
+      {
+        VNetHeader hdr{};
+        std::array<iovec, 2> iov{iovec{&hdr, sizeof(hdr)}, iovec{pkt.data(), pkt.size()}};
+        const auto sz = ::writev(QueueFor(pkt), iov.data(), iov.size());
+        return sz == static_cast<ssize_t>(sizeof(hdr) + pkt.size());
+      }
+      const auto sz = write(QueueFor(pkt), pkt.data(), pkt.size());
       if (sz <= 0)
         return false;
       return sz == static_cast<ssize_t>(pkt.size());
     }
+
+    size_t
+    WritePackets(std::vector<net::IPPacket>& pkts) override
+    {
+      if (not m_Offload)
+        return NetworkInterface::WritePackets(pkts);
+      // runs of segments of one flow go to the kernel as one
+      size_t n = 0;
+      for (size_t idx = 0; idx < pkts.size();)
+      {
+        const size_t covered = CoalesceSegments(pkts, idx, m_WriteBuf);
+        const auto sz = ::write(QueueFor(pkts[idx]), m_WriteBuf.data(), m_WriteBuf.size());
+        if (sz == static_cast<ssize_t>(m_WriteBuf.size()))
+          n += covered;
+        idx += covered;
+      }
+      return n;
+    }
   };
 
   class LinuxRouteManager : public IRouteManager
   {
     const int fd;
+    /// joined to the route, link and address groups, so we hear of any change to the routing
+    /// table rather than reading it all over again to find out; -1 if we could not join them
+    int m_Monitor = -1;
+    /// whether we have looked the gateways up yet, or have missed changes since
+    bool m_Stale = true;
+
+    /// requests held back while batching, back to back in the one buffer to send them all in one
+    /// go; the kernel handles each in turn as if it had been sent on its own
+    static constexpr size_t MaxBatchBytes = 32 * 1024;
+    std::vector<byte_t> m_Batch;
+    int m_BatchDepth = 0;
+    uint32_t m_Seq = 0;
 
     enum class GatewayMode
     {
@@ -217,7 +445,143 @@ namespace llarp::vpn
         uint128_t addr{};
         nl_request.AddData(RTA_DST, &addr, sizeof(addr));
       }
-      send(fd, &nl_request, sizeof(nl_request), 0);
+      Send(nl_request.n);
+    }
+
+    /// sends a request now, or holds it back for the batch
+    void
+    Send(nlmsghdr& msg)
+    {
+      msg.nlmsg_seq = ++m_Seq;
+      if (m_BatchDepth == 0)
+      {
+        send(fd, &msg, msg.nlmsg_len, 0);
+        return;
+      }
+      if (m_Batch.size() + NLMSG_ALIGN(msg.nlmsg_len) > MaxBatchBytes)
+        FlushBatch();
+      const auto* ptr = reinterpret_cast<const byte_t*>(&msg);
+      m_Batch.insert(m_Batch.end(), ptr, ptr + msg.nlmsg_len);
+      m_Batch.resize(NLMSG_ALIGN(m_Batch.size()));
+    }
+
+    void
+    FlushBatch()
+    {
+      if (m_Batch.empty())
+        return;
+      send(fd, m_Batch.data(), m_Batch.size(), 0);
+      m_Batch.clear();
+    }
+
+    /// a route in the main table, as a netlink dump tells us of it
+    struct KernelRoute
+    {
+      uint8_t dst_len = 0;
+      uint8_t protocol = 0;
+      net::ipaddr_t dst{};
+      std::optional<net::ipaddr_t> gateway;
+      int oif = 0;
+      uint32_t priority = 0;
+    };
+
+    static net::ipaddr_t
+    AddrFromAttr(int af, const rtattr* attr)
+    {
+      const size_t len = RTA_PAYLOAD(attr);
+      if (af == AF_INET and len >= sizeof(uint32_t))
+      {
+        net::ipv4addr_t ip{};
+        std::memcpy(&ip.n, RTA_DATA(attr), sizeof(uint32_t));
+        return ip;
+      }
+      net::ipv6addr_t ip{};
+      if (len >= sizeof(in6_addr))
+        std::memcpy(&ip.n, RTA_DATA(attr), sizeof(in6_addr));
+      return ip;
+    }
+
+    /// every route of family af in the main table, read with a netlink dump on a socket of its
+    /// own, so that what the kernel says to our requests cannot get mixed in
+    std::vector<KernelRoute>
+    DumpRoutes(int af) const
+    {
+      std::vector<KernelRoute> routes;
+      const int sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_ROUTE);
+      if (sock == -1)
+        return routes;
+
+      struct
+      {
+        nlmsghdr n;
+        rtmsg r;
+      } req{};
+      req.n.nlmsg_len = NLMSG_LENGTH(sizeof(rtmsg));
+      req.n.nlmsg_type = RTM_GETROUTE;
+      req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+      req.n.nlmsg_seq = 1;
+      req.r.rtm_family = af;
+      if (send(sock, &req, req.n.nlmsg_len, 0) == -1)
+      {
+        close(sock);
+        return routes;
+      }
+
+      alignas(nlmsghdr) std::array<char, 16 * 1024> buf;
+      bool done = false;
+      while (not done)
+      {
+        const auto got = recv(sock, buf.data(), buf.size(), 0);
+        if (got <= 0)
+          break;
+        int len = got;
+        for (auto* hdr = reinterpret_cast<nlmsghdr*>(buf.data()); NLMSG_OK(hdr, len);
+             hdr = NLMSG_NEXT(hdr, len))
+        {
+          if (hdr->nlmsg_type == NLMSG_DONE or hdr->nlmsg_type == NLMSG_ERROR)
+          {
+            done = true;
+            break;
+          }
+          if (hdr->nlmsg_type != RTM_NEWROUTE)
+            continue;
+          const auto* rt = reinterpret_cast<const rtmsg*>(NLMSG_DATA(hdr));
+          uint32_t table = rt->rtm_table;
+          KernelRoute route{};
+          route.dst_len = rt->rtm_dst_len;
+          route.protocol = rt->rtm_protocol;
+          if (af == AF_INET)
+            route.dst = net::ipv4addr_t{};
+          else
+            route.dst = net::ipv6addr_t{};
+          int attrlen = RTM_PAYLOAD(hdr);
+          for (auto* attr = RTM_RTA(rt); RTA_OK(attr, attrlen); attr = RTA_NEXT(attr, attrlen))
+          {
+            switch (attr->rta_type)
+            {
+              case RTA_TABLE:
+                std::memcpy(&table, RTA_DATA(attr), sizeof(table));
+                break;
+              case RTA_DST:
+                route.dst = AddrFromAttr(af, attr);
+                break;
+              case RTA_GATEWAY:
+                route.gateway = AddrFromAttr(af, attr);
+                break;
+              case RTA_OIF:
+                std::memcpy(&route.oif, RTA_DATA(attr), sizeof(route.oif));
+                break;
+              case RTA_PRIORITY:
+                std::memcpy(&route.priority, RTA_DATA(attr), sizeof(route.priority));
+                break;
+            }
+          }
+          if (table == RT_TABLE_MAIN and rt->rtm_type == RTN_UNICAST)
+            routes.push_back(std::move(route));
+        }
+      }
+      close(sock);
+      return routes;
     }
 
     void
@@ -282,7 +646,7 @@ namespace llarp::vpn
         }
       }
       /* Send message to the netlink */
-      send(fd, &nl_request, sizeof(nl_request), 0);
+      Send(nl_request.n);
     }
 
     void
@@ -355,13 +719,40 @@ namespace llarp::vpn
     {
       if (fd == -1)
         throw std::runtime_error{"failed to make netlink socket"};
+
+      m_Monitor = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+      sockaddr_nl addr{};
+      addr.nl_family = AF_NETLINK;
+      addr.nl_groups = RTMGRP_IPV4_ROUTE | RTMGRP_IPV4_IFADDR | RTMGRP_LINK;
+      if (m_Monitor != -1
+          and bind(m_Monitor, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == -1)
+      {
+        LogWarn("cannot watch for routing changes, will look for them instead: ", strerror(errno));
+        close(m_Monitor);
+        m_Monitor = -1;
+      }
     }
 
     ~LinuxRouteManager()
     {
+      if (m_Monitor != -1)
+        close(m_Monitor);
       close(fd);
     }
 
+    void
+    BeginBatch() override
+    {
+      ++m_BatchDepth;
+    }
+
+    void
+    EndBatch() override
+    {
+      if (m_BatchDepth > 0 and --m_BatchDepth == 0)
+        FlushBatch();
+    }
+
     void
     AddRoute(net::ipaddr_t ip, net::ipaddr_t gateway) override
     {
@@ -398,27 +789,58 @@ namespace llarp::vpn
       RouteViaInterface(RTM_DELROUTE, 0, vpn, range);
     }
 
+    /// the ipv4 default routes' gateways, lowest metric first
     std::vector<net::ipaddr_t>
     GetGatewaysNotOnInterface(NetworkInterface& vpn) override
     {
-      const auto& ifname = vpn.Info().ifname;
+      const int ifindex = vpn.Info().index;
+      auto routes = DumpRoutes(AF_INET);
+      std::stable_sort(routes.begin(), routes.end(), [](const auto& a, const auto& b) {
+        return a.priority < b.priority;
+      });
       std::vector<net::ipaddr_t> gateways{};
-      std::ifstream inf{"/proc/net/route"};
-      for (std::string line; std::getline(inf, line);)
+      for (const auto& route : routes)
       {
-        const auto parts = split(line, "\t");
-        if (parts[1].find_first_not_of('0') == std::string::npos and parts[0] != ifname)
+        if (route.dst_len == 0 and route.gateway and route.oif != ifindex)
+          gateways.push_back(*route.gateway);
+      }
+      return gateways;
+    }
+
+    bool
+    GatewaysMayHaveChanged() override
+    {
+      if (m_Monitor == -1)
+        return true;
+      alignas(nlmsghdr) std::array<char, 8 * 1024> buf;
+      while (true)
+      {
+        const auto got = recv(m_Monitor, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (got > 0)
+          m_Stale = true;
+        else if (got == -1 and errno == ENOBUFS)
+          // we fell behind and the kernel dropped some, so we cannot know what changed
+          m_Stale = true;
+        else
+          break;
+      }
+      return std::exchange(m_Stale, false);
+    }
+
+    std::optional<std::vector<std::pair<net::ipaddr_t, net::ipaddr_t>>>
+    GetHostRoutes() override
+    {
+      std::vector<std::pair<net::ipaddr_t, net::ipaddr_t>> hosts;
+      for (const int af : {AF_INET, AF_INET6})
+      {
+        const uint8_t bits = af == AF_INET ? 32 : 128;
+        for (const auto& route : DumpRoutes(af))
         {
-          const auto& ip = parts[2];
-          if ((ip.size() == sizeof(uint32_t) * 2) and oxenc::is_hex(ip))
-          {
-            huint32_t x{};
-            oxenc::from_hex(ip.begin(), ip.end(), reinterpret_cast<char*>(&x.h));
-            gateways.emplace_back(net::ipv4addr_t::from_host(x.h));
-          }
+          if (route.dst_len == bits and route.gateway and route.protocol == RTPROT_BOOT)
+            hosts.emplace_back(route.dst, *route.gateway);
         }
       }
-      return gateways;
+      return hosts;
     }
 
     void
@@ -0,0 +1,272 @@
+#include "offload.hpp"
+
+#include <llarp/util/buffer_pool.hpp>
+
+#include <oxenc/endian.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace llarp::vpn
+{
+  namespace
+  {
+    constexpr uint8_t TCP = 6;
+    constexpr size_t IPv6HeaderSize = 40;
+    constexpr size_t TCPMinHeaderSize = 20;
+    constexpr size_t MaxIPSize = 65535;
+
+    constexpr byte_t FIN = 0x01;
+    constexpr byte_t PSH = 0x08;
+    constexpr byte_t ACK = 0x10;
+    constexpr byte_t CWR = 0x80;
+
+    bool
+    IsV6(const byte_t* pkt)
+    {
+      return (pkt[0] >> 4) == 6;
+    }
+
+    /// where the tcp header starts in the sz bytes of pkt, or 0 if they are not a whole tcp
+    /// packet we can take apart
+    size_t
+    TCPOffset(const byte_t* pkt, size_t sz)
+    {
+      if (sz == 0)
+        return 0;
+      if ((pkt[0] >> 4) == 4)
+      {
+        const size_t ihl = (pkt[0] & 0x0f) * 4;
+        if (ihl < 20 or sz < ihl + TCPMinHeaderSize or pkt[9] != TCP)
+          return 0;
+        // fragments, or more to come
+        if (oxenc::load_big_to_host<uint16_t>(pkt + 6) & 0x3fff)
+          return 0;
+        return ihl;
+      }
+      if (IsV6(pkt))
+      {
+        // extension headers we leave alone
+        if (sz < IPv6HeaderSize + TCPMinHeaderSize or pkt[6] != TCP)
+          return 0;
+        return IPv6HeaderSize;
+      }
+      return 0;
+    }
+
+    size_t
+    TCPHeaderSize(const byte_t* tcp)
+    {
+      return (tcp[12] >> 4) * 4;
+    }
+
+    uint16_t
+    Load16(const byte_t* at)
+    {
+      uint16_t val;
+      std::memcpy(&val, at, sizeof(val));
+      return val;
+    }
+
+    void
+    Store16(byte_t* at, uint16_t val)
+    {
+      std::memcpy(at, &val, sizeof(val));
+    }
+
+    /// sum of the tcp pseudo header of pkt, for a tcp header and payload of len bytes, to start
+    /// ipchksum off with
+    uint32_t
+    PseudoHeaderSum(const byte_t* pkt, size_t len)
+    {
+      const bool v6 = IsV6(pkt);
+      const byte_t* addrs = pkt + (v6 ? 8 : 12);
+      uint32_t sum = 0;
+      for (size_t i = 0; i < (v6 ? 32 : 8); i += 2)
+        sum += Load16(addrs + i);
+      sum += oxenc::host_to_big<uint16_t>(TCP);
+      sum += oxenc::host_to_big<uint16_t>(static_cast<uint16_t>(len));
+      return sum;
+    }
+
+    /// set the ip length fields of the sz bytes of pkt, bumping an ipv4 id by idDelta
+    void
+    SetIPLength(byte_t* pkt, size_t sz, uint16_t idDelta)
+    {
+      if (IsV6(pkt))
+      {
+        oxenc::write_host_as_big<uint16_t>(sz - IPv6HeaderSize, pkt + 4);
+        return;
+      }
+      const size_t ihl = (pkt[0] & 0x0f) * 4;
+      const uint16_t id = oxenc::load_big_to_host<uint16_t>(pkt + 4) + idDelta;
+      oxenc::write_host_as_big<uint16_t>(sz, pkt + 2);
+      oxenc::write_host_as_big(id, pkt + 4);
+      Store16(pkt + 10, 0);
+      Store16(pkt + 10, net::ipchksum(pkt, ihl));
+    }
+
+    void
+    FinishTCPChecksum(byte_t* pkt, size_t l4, size_t sz)
+    {
+      Store16(pkt + l4 + 16, 0);
+      Store16(pkt + l4 + 16, net::ipchksum(pkt + l4, sz - l4, PseudoHeaderSum(pkt, sz - l4)));
+    }
+
+    bool
+    SameBytes(const byte_t* a, const byte_t* b, size_t from, size_t to)
+    {
+      return std::equal(a + from, a + to, b + from);
+    }
+
+    /// whether the headers of two tcp packets with headers of hdrsz, the tcp one at l4, are the
+    /// same but for what changes from one segment of a flow to the next
+    bool
+    SameFlow(const byte_t* a, const byte_t* b, size_t l4, size_t hdrsz)
+    {
+      if (IsV6(a))
+      {
+        // all but the payload length
+        if (not(SameBytes(a, b, 0, 4) and SameBytes(a, b, 6, IPv6HeaderSize)))
+          return false;
+      }
+      // all but the length, id and checksum
+      else if (not(SameBytes(a, b, 0, 2) and SameBytes(a, b, 6, 10) and SameBytes(a, b, 12, l4)))
+        return false;
+      const byte_t* ta = a + l4;
+      const byte_t* tb = b + l4;
+      // all but the sequence number, flags and checksum
+      return SameBytes(ta, tb, 0, 4) and SameBytes(ta, tb, 8, 13) and SameBytes(ta, tb, 14, 16)
+          and SameBytes(ta, tb, 18, hdrsz - l4);
+    }
+  }  // namespace
+
+  void
+  SegmentOffloaded(
+      const VNetHeader& hdr, const byte_t* data, size_t sz, std::vector<net::IPPacket>& into)
+  {
+    const uint8_t gso = hdr.gso_type & ~VNetHeader::GSOECN;
+    if (gso == VNetHeader::GSONone)
+    {
+      auto buf = util::BufferPool::Acquire(data, sz);
+      if (hdr.flags & VNetHeader::NeedsChecksum)
+      {
+        // what is there already is the sum of the pseudo header
+        const size_t field = size_t{hdr.csum_start} + hdr.csum_offset;
+        if (field + sizeof(uint16_t) > sz)
+          return;
+        uint16_t csum = net::ipchksum(buf.data() + hdr.csum_start, sz - hdr.csum_start);
+        // to udp 0 is no checksum at all, and to tcp it is the same as 0xffff
+        if (csum == 0)
+          csum = 0xffff;
+        Store16(buf.data() + field, csum);
+      }
+      into.emplace_back(std::move(buf));
+      return;
+    }
+    if (gso != VNetHeader::GSOTCPv4 and gso != VNetHeader::GSOTCPv6)
+      return;
+
+    const size_t l4 = TCPOffset(data, sz);
+    if (l4 == 0 or IsV6(data) != (gso == VNetHeader::GSOTCPv6))
+      return;
+    const size_t hdrsz = l4 + TCPHeaderSize(data + l4);
+    const size_t mss = hdr.gso_size;
+    if (hdrsz < l4 + TCPMinHeaderSize or hdrsz > sz or mss == 0)
+      return;
+
+    const uint32_t seq = oxenc::load_big_to_host<uint32_t>(data + l4 + 4);
+    const size_t payload = sz - hdrsz;
+    const size_t segments = std::max<size_t>(1, (payload + mss - 1) / mss);
+    for (size_t i = 0; i < segments; ++i)
+    {
+      const size_t offset = i * mss;
+      const size_t len = std::min(mss, payload - offset);
+      auto buf = util::BufferPool::Acquire(hdrsz + len);
+      std::copy_n(data, hdrsz, buf.begin());
+      std::copy_n(data + hdrsz + offset, len, buf.begin() + hdrsz);
+
+      byte_t* tcp = buf.data() + l4;
+      oxenc::write_host_as_big<uint32_t>(seq + offset, tcp + 4);
+      // the end of the stream and the push go with the last segment, a window reduction with
+      // the first
+      if (i + 1 < segments)
+        tcp[13] &= ~(FIN | PSH);
+      if (i > 0)
+        tcp[13] &= ~CWR;
+      SetIPLength(buf.data(), buf.size(), i);
+      FinishTCPChecksum(buf.data(), l4, buf.size());
+      into.emplace_back(std::move(buf));
+    }
+  }
+
+  size_t
+  CoalesceSegments(const std::vector<net::IPPacket>& pkts, size_t start, std::vector<byte_t>& into)
+  {
+    into.clear();
+    VNetHeader hdr{};
+    const auto& first = pkts[start];
+    const byte_t* head = first.data();
+    const size_t sz = first.size();
+
+    size_t end = start + 1;
+    size_t total = sz;
+    const size_t l4 = TCPOffset(head, sz);
+    const size_t hdrsz = l4 ? l4 + TCPHeaderSize(head + l4) : 0;
+    // segments after the first are the same size as it, except for the last
+    if (l4 and hdrsz >= l4 + TCPMinHeaderSize and hdrsz < sz and head[l4 + 13] == ACK)
+    {
+      const size_t mss = sz - hdrsz;
+      uint32_t next = oxenc::load_big_to_host<uint32_t>(head + l4 + 4) + mss;
+      while (end < pkts.size())
+      {
+        const byte_t* pkt = pkts[end].data();
+        const size_t pktsz = pkts[end].size();
+        if (pktsz <= hdrsz or pktsz - hdrsz > mss or total + pktsz - hdrsz > MaxIPSize
+            or TCPOffset(pkt, pktsz) != l4 or not SameFlow(head, pkt, l4, hdrsz)
+            or oxenc::load_big_to_host<uint32_t>(pkt + l4 + 4) != next)
+          break;
+        const byte_t flags = pkt[l4 + 13];
+        if (flags != ACK and flags != (ACK | PSH))
+          break;
+        total += pktsz - hdrsz;
+        next += pktsz - hdrsz;
+        ++end;
+        if (flags != ACK or pktsz - hdrsz < mss)
+          break;
+      }
+      if (end > start + 1)
+      {
+        hdr.flags = VNetHeader::NeedsChecksum;
+        hdr.gso_type = IsV6(head) ? VNetHeader::GSOTCPv6 : VNetHeader::GSOTCPv4;
+        hdr.hdr_len = hdrsz;
+        hdr.gso_size = mss;
+        hdr.csum_start = l4;
+        hdr.csum_offset = 16;
+      }
+    }
+
+    into.resize(sizeof(hdr));
+    std::memcpy(into.data(), &hdr, sizeof(hdr));
+    if (end == start + 1)
+    {
+      into.insert(into.end(), head, head + sz);
+      return 1;
+    }
+
+    into.reserve(sizeof(hdr) + total);
+    into.insert(into.end(), head, head + sz);
+    for (size_t i = start + 1; i < end; ++i)
+      into.insert(into.end(), pkts[i].data() + hdrsz, pkts[i].data() + pkts[i].size());
+
+    byte_t* super = into.data() + sizeof(hdr);
+    // the flags of the last segment, which may push
+    super[l4 + 13] = pkts[end - 1].data()[l4 + 13];
+    SetIPLength(super, total, 0);
+    // the kernel finishes the checksum of each segment it makes from the pseudo header's sum
+    Store16(
+        super + l4 + 16,
+        static_cast<uint16_t>(~net::ipchksum(nullptr, 0, PseudoHeaderSum(super, total - l4))));
+    return end - start;
+  }
+}  // namespace llarp::vpn
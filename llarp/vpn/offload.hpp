@@ -0,0 +1,54 @@
+#pragma once
+
+#include <llarp/net/ip_packet.hpp>
+#include <llarp/util/types.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace llarp::vpn
+{
+  /// the virtio net header that comes before every packet on a tun opened with IFF_VNET_HDR, in
+  /// host order, as in linux/virtio_net.h
+  struct VNetHeader
+  {
+    /// the transport checksum is only partly done, see csum_start
+    static constexpr uint8_t NeedsChecksum = 1;
+
+    static constexpr uint8_t GSONone = 0;
+    static constexpr uint8_t GSOTCPv4 = 1;
+    static constexpr uint8_t GSOTCPv6 = 4;
+    /// or'd into the gso type when the segments are to carry ECN's congestion window reduced
+    static constexpr uint8_t GSOECN = 0x80;
+
+    uint8_t flags = 0;
+    uint8_t gso_type = GSONone;
+    /// ip and transport headers together
+    uint16_t hdr_len = 0;
+    /// transport payload in each segment
+    uint16_t gso_size = 0;
+    /// with NeedsChecksum, checksum from here to the end, which is put csum_offset past here
+    uint16_t csum_start = 0;
+    uint16_t csum_offset = 0;
+  };
+
+  static_assert(sizeof(VNetHeader) == 10);
+
+  /// the most we read off the interface at once with offloads on, a whole gso super packet
+  constexpr size_t MaxOffloadedSize = sizeof(VNetHeader) + 65535;
+
+  /// turn the sz bytes the kernel handed us under hdr into the packets they stand for, putting
+  /// them on the end of into: a tcp super packet is cut into segments of hdr.gso_size, each with
+  /// headers made up as the kernel would have sent it, and a packet whose checksum was left to us
+  /// gets it finished.  what we cannot make sense of is dropped.
+  void
+  SegmentOffloaded(
+      const VNetHeader& hdr, const byte_t* data, size_t sz, std::vector<net::IPPacket>& into);
+
+  /// put into the bytes to write to the interface for the packets of pkts from start on: a
+  /// header and, where the packets from start on are full sized tcp segments of one flow one after
+  /// the other, one super packet for the kernel to take as if its gro had made them one; otherwise
+  /// a header and only the packet at start.  returns how many packets that covers.
+  size_t
+  CoalesceSegments(const std::vector<net::IPPacket>& pkts, size_t start, std::vector<byte_t>& into);
+}  // namespace llarp::vpn
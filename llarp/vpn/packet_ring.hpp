@@ -0,0 +1,192 @@
+#pragma once
+
+#include <llarp/net/ip_packet.hpp>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace llarp::vpn
+{
+  /// a ring of fixed size packet slots that one side puts packets into and the other takes them
+  /// out of, in memory the java side sees as a DirectByteBuffer.  each slot is a native endian
+  /// uint32 length followed by up to MaxPacket bytes of packet, and slot N of the ring is at byte
+  /// (N % Slots()) * SlotSize.
+  ///
+  /// the indices stay on our side: java keeps count of its own end, and publishes what it has put
+  /// in or hands back what it has taken out with one jni call a batch.  an eventfd is readable
+  /// while there may be packets to take out, and is only written when the ring was empty before,
+  /// so a burst of packets costs the one wakeup.
+  class PacketRing
+  {
+   public:
+    static constexpr size_t LengthSize = sizeof(uint32_t);
+    static constexpr size_t MaxPacket = net::IPPacket::MaxSize;
+    /// rounded up to keep the lengths aligned
+    static constexpr size_t SlotSize = (LengthSize + MaxPacket + 15) & ~size_t{15};
+
+    /// slots must be a power of 2 so the free running indices wrap cleanly
+    explicit PacketRing(uint32_t slots)
+        : m_Slots{ValidSlots(slots)}
+        , m_Data{new byte_t[slots * SlotSize]}
+        , m_Wakeup{::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)}
+    {
+      if (m_Wakeup == -1)
+        throw std::runtime_error{
+            "cannot make packet ring eventfd: " + std::string{strerror(errno)}};
+    }
+
+    ~PacketRing()
+    {
+      ::close(m_Wakeup);
+    }
+
+    PacketRing(const PacketRing&) = delete;
+    PacketRing&
+    operator=(const PacketRing&) = delete;
+
+    uint32_t
+    Slots() const
+    {
+      return m_Slots;
+    }
+
+    /// the memory to hand to java
+    byte_t*
+    Data()
+    {
+      return m_Data.get();
+    }
+
+    size_t
+    Bytes() const
+    {
+      return m_Slots * SlotSize;
+    }
+
+    /// readable while there may be packets to take out
+    int
+    PollFD() const
+    {
+      return m_Wakeup;
+    }
+
+    /// packets put in and not yet taken out
+    uint32_t
+    Available() const
+    {
+      return m_Head.load() - m_Tail.load();
+    }
+
+    uint32_t
+    Free() const
+    {
+      return m_Slots - Available();
+    }
+
+    /// producer: marks the next n slots as put in, waking the consumer if it had emptied the ring
+    void
+    Publish(uint32_t n)
+    {
+      if (n == 0)
+        return;
+      const auto head = m_Head.fetch_add(n);
+      // the consumer stores its tail before it looks at our head again, so either it sees what we
+      // just put in or we see it caught up with us here
+      if (m_Tail.load() == head)
+        ::eventfd_write(m_Wakeup, 1);
+    }
+
+    /// consumer: hands the next n slots back and returns how many are still to take out
+    uint32_t
+    Release(uint32_t n)
+    {
+      m_Tail.fetch_add(n);
+      return Available();
+    }
+
+    /// consumer: call before looking for packets, so that a wakeup after it is not lost
+    void
+    ClearWakeup()
+    {
+      eventfd_t val;
+      ::eventfd_read(m_Wakeup, &val);
+    }
+
+    /// producer: copies a packet into the next free slot and publishes it; false if the ring is
+    /// full or the packet does not fit a slot
+    bool
+    Put(const net::IPPacket& pkt)
+    {
+      if (not Stage(Available(), pkt))
+        return false;
+      Publish(1);
+      return true;
+    }
+
+    /// producer: copies a packet into the slot `offset` past the head without publishing it, for
+    /// putting in a batch at once
+    bool
+    Stage(uint32_t offset, const net::IPPacket& pkt)
+    {
+      if (offset >= Free() or pkt.size() > MaxPacket)
+        return false;
+      auto* slot = SlotAt(m_Head.load() + offset);
+      const uint32_t len = pkt.size();
+      std::memcpy(slot, &len, LengthSize);
+      std::memcpy(slot + LengthSize, pkt.data(), len);
+      return true;
+    }
+
+    /// consumer: the packet `offset` past the tail, which must be less than Available(); empty if
+    /// the other side put in a bad length
+    net::IPPacket
+    Peek(uint32_t offset) const
+    {
+      const auto* slot = SlotAt(m_Tail.load() + offset);
+      uint32_t len;
+      std::memcpy(&len, slot, LengthSize);
+      if (len > MaxPacket)
+        return net::IPPacket{};
+      return net::IPPacket{byte_view_t{slot + LengthSize, len}};
+    }
+
+   private:
+    static uint32_t
+    ValidSlots(uint32_t slots)
+    {
+      if (slots == 0 or (slots & (slots - 1)) != 0)
+        throw std::invalid_argument{"packet ring slots must be a power of 2"};
+      return slots;
+    }
+
+    byte_t*
+    SlotAt(uint32_t idx) const
+    {
+      return m_Data.get() + (idx & (m_Slots - 1)) * SlotSize;
+    }
+
+    const uint32_t m_Slots;
+    const std::unique_ptr<byte_t[]> m_Data;
+    const int m_Wakeup;
+    /// on their own cache lines, as each is written from a different thread
+    alignas(64) std::atomic<uint32_t> m_Head{0};
+    alignas(64) std::atomic<uint32_t> m_Tail{0};
+  };
+
+  /// the two rings an android vpn in batched mode moves packets through: packets from the
+  /// VpnService to us, and packets from us to it
+  struct AndroidRings
+  {
+    explicit AndroidRings(uint32_t slots) : in{slots}, out{slots}
+    {}
+
+    PacketRing in;
+    PacketRing out;
+  };
+
+}  // namespace llarp::vpn
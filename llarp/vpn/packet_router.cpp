@@ -1,64 +1,45 @@
 #include "packet_router.hpp"
 
+#include <algorithm>
+
 namespace llarp::vpn
 {
-  struct UDPPacketHandler : public Layer4Handler
+  namespace
   {
-    PacketHandlerFunc_t m_BaseHandler;
-    std::unordered_map<nuint16_t, PacketHandlerFunc_t> m_LocalPorts;
-
-    explicit UDPPacketHandler(PacketHandlerFunc_t baseHandler)
-        : m_BaseHandler{std::move(baseHandler)}
-    {}
-
-    void
-    AddSubHandler(nuint16_t localport, PacketHandlerFunc_t handler) override
-    {
-      m_LocalPorts.emplace(localport, std::move(handler));
-    }
-
-    void
-    HandleIPPacket(llarp::net::IPPacket pkt) override
-    {
-      auto dstport = pkt.DstPort();
-      if (not dstport)
-      {
-        m_BaseHandler(std::move(pkt));
-        return;
-      }
-
-      if (auto itr = m_LocalPorts.find(*dstport); itr != m_LocalPorts.end())
-        itr->second(std::move(pkt));
-      else
-        m_BaseHandler(std::move(pkt));
-    }
-  };
-
-  struct GenericLayer4Handler : public Layer4Handler
-  {
-    PacketHandlerFunc_t m_BaseHandler;
-
-    explicit GenericLayer4Handler(PacketHandlerFunc_t baseHandler)
-        : m_BaseHandler{std::move(baseHandler)}
-    {}
-
-    void
-    HandleIPPacket(llarp::net::IPPacket pkt) override
-    {
-      m_BaseHandler(std::move(pkt));
-    }
-  };
+    constexpr byte_t udp_proto = 0x11;
+  }
 
   PacketRouter::PacketRouter(PacketHandlerFunc_t baseHandler)
       : m_BaseHandler{std::move(baseHandler)}
   {}
 
+  std::vector<std::pair<nuint16_t, PacketHandlerFunc_t>>::iterator
+  PacketRouter::FindUDPHandler(nuint16_t port)
+  {
+    return std::lower_bound(
+        m_UDPHandler.begin(), m_UDPHandler.end(), port, [](const auto& item, nuint16_t p) {
+          return item.first.n < p.n;
+        });
+  }
+
   void
   PacketRouter::HandleIPPacket(llarp::net::IPPacket pkt)
   {
     const auto proto = pkt.Header()->protocol;
-    if (const auto itr = m_IPProtoHandler.find(proto); itr != m_IPProtoHandler.end())
-      itr->second->HandleIPPacket(std::move(pkt));
+    if (proto == udp_proto and not m_UDPHandler.empty())
+    {
+      if (const auto dstport = pkt.DstPort())
+      {
+        if (auto itr = FindUDPHandler(*dstport);
+            itr != m_UDPHandler.end() and itr->first == *dstport)
+        {
+          itr->second(std::move(pkt));
+          return;
+        }
+      }
+    }
+    if (const auto& handler = m_IPProtoHandler[proto])
+      handler(std::move(pkt));
     else
       m_BaseHandler(std::move(pkt));
   }
@@ -66,19 +47,26 @@ namespace llarp::vpn
   void
   PacketRouter::AddUDPHandler(huint16_t localport, PacketHandlerFunc_t func)
   {
-    constexpr byte_t udp_proto = 0x11;
+    const auto port = ToNet(localport);
+    const auto itr = FindUDPHandler(port);
+    // like the map this used to be, the first handler added for a port stays
+    if (itr != m_UDPHandler.end() and itr->first == port)
+      return;
+    m_UDPHandler.emplace(itr, port, std::move(func));
+  }
 
-    if (m_IPProtoHandler.find(udp_proto) == m_IPProtoHandler.end())
-    {
-      m_IPProtoHandler.emplace(udp_proto, std::make_unique<UDPPacketHandler>(m_BaseHandler));
-    }
-    m_IPProtoHandler[udp_proto]->AddSubHandler(ToNet(localport), func);
+  void
+  PacketRouter::RemoveUDPHandler(huint16_t localport)
+  {
+    const auto port = ToNet(localport);
+    if (auto itr = FindUDPHandler(port); itr != m_UDPHandler.end() and itr->first == port)
+      m_UDPHandler.erase(itr);
   }
 
   void
   PacketRouter::AddIProtoHandler(uint8_t proto, PacketHandlerFunc_t func)
   {
-    m_IPProtoHandler[proto] = std::make_unique<GenericLayer4Handler>(std::move(func));
+    m_IPProtoHandler[proto] = std::move(func);
   }
 
 }  // namespace llarp::vpn
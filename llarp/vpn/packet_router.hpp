@@ -1,19 +1,30 @@
 #pragma once
 #include <llarp/net/net_int.hpp>
 #include <llarp/net/ip_packet.hpp>
+#include <array>
 #include <functional>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace llarp::vpn
 {
   using PacketHandlerFunc_t = std::function<void(llarp::net::IPPacket)>;
 
-  struct Layer4Handler;
-
+  /// hands each packet to the handler for its udp port or ip protocol, looked up in flat tables
+  /// rather than maps: udp packets go to the handler for their destination port, if any, then
+  /// packets go to the handler for their ip protocol, if any, and whatever is left to the base
+  /// handler.
   class PacketRouter
   {
     PacketHandlerFunc_t m_BaseHandler;
-    std::unordered_map<uint8_t, std::unique_ptr<Layer4Handler>> m_IPProtoHandler;
+    /// by ip protocol, empty where there is none
+    std::array<PacketHandlerFunc_t, 256> m_IPProtoHandler;
+    /// by udp destination port, sorted by port; there are only ever a few
+    std::vector<std::pair<nuint16_t, PacketHandlerFunc_t>> m_UDPHandler;
+
+    /// where the handler for udp port is or would go
+    std::vector<std::pair<nuint16_t, PacketHandlerFunc_t>>::iterator
+    FindUDPHandler(nuint16_t port);
 
    public:
     /// baseHandler will be called if no other handlers matches a packet
@@ -35,15 +46,4 @@ namespace llarp::vpn
     void
     RemoveUDPHandler(huint16_t localport);
   };
-
-  struct Layer4Handler
-  {
-    virtual ~Layer4Handler() = default;
-
-    virtual void
-    HandleIPPacket(llarp::net::IPPacket pkt) = 0;
-
-    virtual void AddSubHandler(nuint16_t, PacketHandlerFunc_t){};
-  };
-
 }  // namespace llarp::vpn
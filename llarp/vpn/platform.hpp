@@ -6,6 +6,7 @@
 
 #include "i_packet_io.hpp"
 
+#include <optional>
 #include <set>
 
 namespace llarp
@@ -35,6 +36,11 @@ namespace llarp::vpn
     unsigned int index;
     huint32_t dnsaddr;
     std::vector<InterfaceAddress> addrs;
+    /// packet queues to open the interface with, where the platform can have more than one
+    size_t queues = 1;
+    /// have the kernel hand us and take from us tcp packets bigger than the mtu, and leave
+    /// checksums to whoever needs them, where the platform can (linux virtio net headers)
+    bool offload = false;
 
     /// get address number N
     inline net::ipaddr_t
@@ -65,9 +71,38 @@ namespace llarp::vpn
       return m_Info;
     }
 
+    /// how many queues the interface moves packets through.  with more than one they are read off
+    /// the event loop and handed to it through PollFD and ReadNextPacket, so an event loop that
+    /// would do the interface's io on PollFD itself must not.
+    virtual size_t
+    Queues() const
+    {
+      return 1;
+    }
+
+    /// whether what is read and written on PollFD carries offload headers, which an event loop
+    /// doing the interface's io itself would not know what to do with
+    virtual bool
+    Offloaded() const
+    {
+      return false;
+    }
+
     /// idempotently wake up the upper layers as needed (platform dependant)
     virtual void
     MaybeWakeUpperLayers() const {};
+
+    /// set by event loops that do this interface's io themselves (see uring::Loop): platforms that
+    /// support it hand written packets to writer first, and only write them directly if it
+    /// returns false
+    void
+    SetPacketWriter(std::function<bool(const net::IPPacket&)> writer)
+    {
+      m_PacketWriter = std::move(writer);
+    }
+
+   protected:
+    std::function<bool(const net::IPPacket&)> m_PacketWriter;
   };
 
   class IRouteManager
@@ -108,11 +143,54 @@ namespace llarp::vpn
     virtual std::vector<net::ipaddr_t>
     GetGatewaysNotOnInterface(NetworkInterface& vpn) = 0;
 
+    /// whether the routing table may have changed since we last asked, so that the gateways are
+    /// worth looking up again: platforms that are told of changes say so only when they were
+    virtual bool
+    GatewaysMayHaveChanged()
+    {
+      return true;
+    }
+
+    /// the routes to single hosts via a gateway that are in the routing table now, as AddRoute
+    /// puts them there, for working out what needs changing; nullopt where we cannot find out
+    virtual std::optional<std::vector<std::pair<net::ipaddr_t, net::ipaddr_t>>>
+    GetHostRoutes()
+    {
+      return std::nullopt;
+    }
+
     virtual void
     AddBlackhole(){};
 
     virtual void
     DelBlackhole(){};
+
+    /// changes between the two may be held back and made all at once at the end, where the
+    /// platform can; they nest, with the outermost EndBatch making them.  see RouteBatch.
+    virtual void
+    BeginBatch(){};
+
+    virtual void
+    EndBatch(){};
+  };
+
+  /// batches an IRouteManager's changes while it lives
+  class RouteBatch
+  {
+    IRouteManager& m_Route;
+
+   public:
+    explicit RouteBatch(IRouteManager& route) : m_Route{route}
+    {
+      m_Route.BeginBatch();
+    }
+
+    RouteBatch(const RouteBatch&) = delete;
+
+    ~RouteBatch()
+    {
+      m_Route.EndBatch();
+    }
   };
 
   /// a vpn platform
@@ -3,9 +3,11 @@
 #include "windivert.hpp"
 #include "dll.hpp"
 #include "handle.hpp"
+#include <llarp/util/buffer_pool.hpp>
 #include <llarp/util/thread/queue.hpp>
 #include <llarp/util/logging.hpp>
 #include <llarp/util/logging/buffer.hpp>
+#include <array>
 #include <thread>
 extern "C"
 {
@@ -113,7 +115,7 @@ namespace llarp::win32
       decltype(::WinDivertShutdown)* shutdown = nullptr;
       decltype(::WinDivertHelperCalcChecksums)* calc_checksum = nullptr;
       decltype(::WinDivertSend)* send = nullptr;
-      decltype(::WinDivertRecv)* recv = nullptr;
+      decltype(::WinDivertRecvEx)* recv_ex = nullptr;
       decltype(::WinDivertHelperFormatIPv4Address)* format_ip4 = nullptr;
       decltype(::WinDivertHelperFormatIPv6Address)* format_ip6 = nullptr;
 
@@ -132,7 +134,7 @@ namespace llarp::win32
           "WinDivertShutdown",                shutdown,
           "WinDivertHelperCalcChecksums",     calc_checksum,
           "WinDivertSend",                    send,
-          "WinDivertRecv",                    recv,
+          "WinDivertRecvEx",                  recv_ex,
           "WinDivertHelperFormatIPv4Address", format_ip4,
           "WinDivertHelperFormatIPv6Address", format_ip6);
         // clang-format on
@@ -151,10 +153,15 @@ namespace llarp::win32
 
       HANDLE m_Handle;
       std::thread m_Runner;
+      /// where windivert puts a batch of packets, read thread only
+      std::vector<byte_t> m_RecvBuf = std::vector<byte_t>(recv_batch * max_packet_size);
       std::atomic<bool> m_Shutdown{false};
       thread::Queue<Packet> m_RecvQueue;
       // dns packet queue size
       static constexpr size_t recv_queue_size = 64;
+      /// the most packets we take from windivert in one go
+      static constexpr size_t recv_batch = 16;
+      static constexpr size_t max_packet_size = 1500;  // net::IPPacket::MaxSize
 
      public:
       IO(const std::string& filter_spec, std::function<void(void)> wake)
@@ -173,34 +180,67 @@ namespace llarp::win32
         wd::close(m_Handle);
       }
 
-      std::optional<Packet>
-      recv_packet() const
+      /// how long the ip packet at the front of the sz bytes at buf is, or 0 if it is not one
+      static size_t
+      ip_packet_size(const byte_t* buf, size_t sz)
       {
-        WINDIVERT_ADDRESS addr{};
-        std::vector<byte_t> pkt;
-        pkt.resize(1500);  // net::IPPacket::MaxSize
+        if (sz < 20)
+          return 0;
+        size_t len = 0;
+        if ((buf[0] >> 4) == 4)
+          len = (size_t{buf[2]} << 8) | buf[3];
+        else if ((buf[0] >> 4) == 6 and sz >= 40)
+          len = 40 + ((size_t{buf[4]} << 8) | buf[5]);
+        return len <= sz ? len : 0;
+      }
+
+      /// block until windivert has packets for us and put as many as it has, up to recv_batch,
+      /// onto the end of into, each in a pooled buffer; returns false once we are shut down
+      bool
+      recv_packets(std::vector<Packet>& into)
+      {
+        std::array<WINDIVERT_ADDRESS, recv_batch> addrs{};
+        UINT addrs_sz = sizeof(addrs);
         UINT sz{};
-        if (not wd::recv(m_Handle, pkt.data(), pkt.size(), &sz, &addr))
+        if (not wd::recv_ex(
+                m_Handle,
+                m_RecvBuf.data(),
+                m_RecvBuf.size(),
+                &sz,
+                0,
+                addrs.data(),
+                &addrs_sz,
+                nullptr))
         {
           auto err = GetLastError();
           if (err == ERROR_NO_DATA)
             // The handle is shut down and the packet queue is empty
-            return std::nullopt;
+            return false;
           if (err == ERROR_BROKEN_PIPE)
           {
             SetLastError(0);
-            return std::nullopt;
+            return false;
           }
 
           log::critical(logcat, "error receiving packet: {}", err);
           throw win32::error{
               err, fmt::format("failed to receive packet from windivert (code={})", err)};
         }
-        pkt.resize(sz);
 
-        log::trace(logcat, "got packet of size {}B", sz);
-        log::trace(logcat, "{}", windivert_addr_to_string(addr));
-        return Packet{std::move(pkt), std::move(addr)};
+        // the packets come one after the other in the buffer, with an address each
+        const byte_t* ptr = m_RecvBuf.data();
+        const byte_t* const end = ptr + sz;
+        for (size_t i = 0; i < addrs_sz / sizeof(WINDIVERT_ADDRESS); ++i)
+        {
+          const auto len = ip_packet_size(ptr, end - ptr);
+          if (len == 0)
+            break;
+          log::trace(logcat, "got packet of size {}B", len);
+          log::trace(logcat, "{}", windivert_addr_to_string(addrs[i]));
+          into.push_back(Packet{util::BufferPool::Acquire(ptr, len), addrs[i]});
+          ptr += len;
+        }
+        return true;
       }
 
       void
@@ -257,18 +297,16 @@ namespace llarp::win32
 
         auto read_loop = [this]() {
           log::debug(logcat, "windivert read loop start");
-          while (true)
+          std::vector<Packet> batch;
+          // in the read loop, read packets until they stop coming in
+          // each batch is sent off with one wake up, leaving the loop on read fail
+          while (recv_packets(batch))
           {
-            // in the read loop, read packets until they stop coming in
-            // each packet is sent off
-            if (auto maybe_pkt = recv_packet())
-            {
-              m_RecvQueue.pushBack(std::move(*maybe_pkt));
-              // wake up event loop
-              m_Wake();
-            }
-            else  // leave loop on read fail
-              break;
+            for (auto& pkt : batch)
+              m_RecvQueue.pushBack(std::move(pkt));
+            batch.clear();
+            // wake up event loop
+            m_Wake();
           }
           log::debug(logcat, "windivert read loop end");
         };
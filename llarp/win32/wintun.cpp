@@ -10,7 +10,9 @@ extern "C"
 #include "guid.hpp"
 #include <unordered_set>
 #include <map>
+#include <optional>
 #include <llarp/router/abstractrouter.hpp>
+#include <llarp/util/buffer_pool.hpp>
 #include <llarp/util/str.hpp>
 #include <llarp/util/thread/queue.hpp>
 #include <llarp/util/logging.hpp>
@@ -67,26 +69,6 @@ namespace llarp::win32
 
     using Adapter_ptr = std::shared_ptr<_WINTUN_ADAPTER>;
 
-    struct PacketWrapper
-    {
-      BYTE* data;
-      DWORD size;
-      WINTUN_SESSION_HANDLE session;
-      /// copy our data into an ip packet struct
-      net::IPPacket
-      copy() const
-      {
-        net::IPPacket pkt{size};
-        std::copy_n(data, size, pkt.data());
-        return pkt;
-      }
-
-      ~PacketWrapper()
-      {
-        release_read(session, data);
-      }
-    };
-
     /// autovivify a wintun adapter handle
     [[nodiscard]] auto
     make_adapter(std::string adapter_name, std::string tunnel_name)
@@ -231,21 +213,26 @@ namespace llarp::win32
         WaitForSingleObject(_handle, dur.count());
       }
 
-      /// read a unique pointer holding a packet read from wintun, returns the packet if we read
-      /// one and a bool, set to true if our adapter is now closed
-      [[nodiscard]] std::pair<std::unique_ptr<PacketWrapper>, bool>
+      /// read a packet off the wintun ring into a pooled buffer, handing the ring its slot back
+      /// there and then; returns the packet if there was one and a bool, set to true if our
+      /// adapter is now closed
+      [[nodiscard]] std::pair<std::optional<net::IPPacket>, bool>
       ReadPacket() const
       {
         if (ended)
-          return {nullptr, true};
+          return {std::nullopt, true};
         DWORD sz;
         if (auto* ptr = read_packet(_impl, &sz))
-          return {std::unique_ptr<PacketWrapper>{new PacketWrapper{ptr, sz, _impl}}, false};
+        {
+          net::IPPacket pkt{util::BufferPool::Acquire(ptr, sz)};
+          release_read(_impl, ptr);
+          return {std::move(pkt), false};
+        }
         const auto err = GetLastError();
         if (err == ERROR_NO_MORE_ITEMS or err == ERROR_HANDLE_EOF)
         {
           SetLastError(0);
-          return {nullptr, err == ERROR_HANDLE_EOF};
+          return {std::nullopt, err == ERROR_HANDLE_EOF};
         }
         throw error{err, "failed to read packet"};
       }
@@ -253,7 +240,7 @@ namespace llarp::win32
       /// write an ip packet to the interface, return 2 bools, first is did we write the packet,
       /// second if we are terminating
       std::pair<bool, bool>
-      WritePacket(net::IPPacket pkt) const
+      WritePacket(const net::IPPacket& pkt) const
       {
         if (auto* buf = alloc_write(_impl, pkt.size()))
         {
@@ -276,12 +263,19 @@ namespace llarp::win32
       AbstractRouter* const _router;
       std::shared_ptr<WintunAdapter> _adapter;
       std::shared_ptr<WintunSession> _session;
-      thread::Queue<net::IPPacket> _recv_queue;
-      thread::Queue<net::IPPacket> _send_queue;
+      /// packets go between the io threads and the event loop a batch at a time, so that a lock
+      /// and a wake up go with each batch and not each packet
+      thread::Queue<std::vector<net::IPPacket>> _recv_queue;
+      thread::Queue<std::vector<net::IPPacket>> _send_queue;
       std::thread _recv_thread;
       std::thread _send_thread;
+      /// the batch ReadPackets is taking packets from, and how far it has got
+      std::vector<net::IPPacket> _reading;
+      size_t _reading_at = 0;
 
-      static inline constexpr size_t packet_queue_length = 1024;
+      /// the most packets we read off the ring before handing them over
+      static inline constexpr size_t read_batch = 64;
+      static inline constexpr size_t batch_queue_length = 64;
 
      public:
       WintunInterface(vpn::InterfaceInfo info, AbstractRouter* router)
@@ -289,8 +283,8 @@ namespace llarp::win32
           , _router{router}
           , _adapter{std::make_shared<WintunAdapter>(m_Info.ifname)}
           , _session{std::make_shared<WintunSession>()}
-          , _recv_queue{packet_queue_length}
-          , _send_queue{packet_queue_length}
+          , _recv_queue{batch_queue_length}
+          , _send_queue{batch_queue_length}
       {}
 
       void
@@ -306,18 +300,32 @@ namespace llarp::win32
         _recv_thread = std::thread{[session = _session, this]() {
           do
           {
-            // read all our packets this iteration
+            // read all our packets this iteration, handing them over a batch at a time
             bool more{true};
             do
             {
-              auto [pkt, done] = session->ReadPacket();
-              // bail if we are closing
-              if (done)
-                return;
-              if (pkt)
-                _recv_queue.pushBack(pkt->copy());
-              else
-                more = false;
+              std::vector<net::IPPacket> batch;
+              batch.reserve(read_batch);
+              while (batch.size() < read_batch)
+              {
+                auto [pkt, done] = session->ReadPacket();
+                // bail if we are closing
+                if (done)
+                  return;
+                if (not pkt)
+                {
+                  more = false;
+                  break;
+                }
+                // too short to be ip at all
+                if (not pkt->empty())
+                  batch.emplace_back(std::move(*pkt));
+              }
+              if (not batch.empty())
+              {
+                _recv_queue.pushBack(std::move(batch));
+                _router->loop()->wakeup();
+              }
             } while (more);
             // wait for more packets
             session->WaitFor(5s);
@@ -329,9 +337,12 @@ namespace llarp::win32
           {
             if (auto maybe = _send_queue.popFrontWithTimeout(100ms))
             {
-              auto [written, done] = session->WritePacket(std::move(*maybe));
-              if (done)
-                return;
+              for (const auto& pkt : *maybe)
+              {
+                auto [written, done] = session->WritePacket(pkt);
+                if (done)
+                  return;
+              }
             }
           } while (_send_queue.enabled());
         }};
@@ -356,16 +367,52 @@ namespace llarp::win32
       net::IPPacket
       ReadNextPacket() override
       {
-        net::IPPacket pkt{};
-        if (auto maybe_pkt = _recv_queue.tryPopFront())
-          pkt = std::move(*maybe_pkt);
-        return pkt;
+        std::vector<net::IPPacket> one;
+        if (ReadPackets(one, 1) == 0)
+          return net::IPPacket{};
+        return std::move(one.front());
+      }
+
+      size_t
+      ReadPackets(std::vector<net::IPPacket>& into, size_t max) override
+      {
+        size_t n = 0;
+        while (n < max)
+        {
+          if (_reading_at == _reading.size())
+          {
+            auto maybe = _recv_queue.tryPopFront();
+            if (not maybe)
+              break;
+            _reading = std::move(*maybe);
+            _reading_at = 0;
+            continue;
+          }
+          into.emplace_back(std::move(_reading[_reading_at++]));
+          ++n;
+        }
+        return n;
       }
 
       bool
       WritePacket(net::IPPacket pkt) override
       {
-        return _send_queue.tryPushBack(std::move(pkt)) == thread::QueueReturn::Success;
+        std::vector<net::IPPacket> one;
+        one.emplace_back(std::move(pkt));
+        return _send_queue.tryPushBack(std::move(one)) == thread::QueueReturn::Success;
+      }
+
+      size_t
+      WritePackets(std::vector<net::IPPacket>& pkts) override
+      {
+        const size_t n = pkts.size();
+        if (n == 0)
+          return 0;
+        std::vector<net::IPPacket> batch{
+            std::make_move_iterator(pkts.begin()), std::make_move_iterator(pkts.end())};
+        if (_send_queue.tryPushBack(std::move(batch)) != thread::QueueReturn::Success)
+          return 0;
+        return n;
       }
 
       int
@@ -14,6 +14,9 @@ namespace llarp
   void
   Logger_Init(py::module& mod);
 
+  void
+  Buffers_Init(py::module& mod);
+
   void
   Context_Init(py::module& mod);
 
@@ -65,6 +68,12 @@ namespace llarp
     Address_Init(py::module& mod);
   }
 
+  namespace simulate
+  {
+    void
+    Simulation_Init(py::module& mod);
+  }
+
 }  // namespace llarp
 
 namespace tooling
@@ -0,0 +1,13 @@
+#include "buffers.hpp"
+
+namespace llarp
+{
+  void
+  Buffers_Init(py::module& mod)
+  {
+    // byte_t is uint8_t, so this does for arrays of those too
+    PyArray_Init<byte_t>(mod, "Bytes");
+    PyArray_Init<uint64_t>(mod, "U64Array");
+    PyArray_Init<double>(mod, "F64Array");
+  }
+}  // namespace llarp
@@ -0,0 +1,48 @@
+#pragma once
+#include <common.hpp>
+#include <llarp/util/buffer.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace llarp
+{
+  /// an array that python reads in place through the buffer protocol, e.g. with memoryview(a),
+  /// a struct's unpack_from(a) or numpy.asarray(a), rather than as a list built an element at a
+  /// time.  read only: python gets a view of what we made, not a copy it can change.
+  template <typename T>
+  struct PyArray
+  {
+    std::vector<T> values;
+
+    PyArray() = default;
+
+    explicit PyArray(std::vector<T> v) : values{std::move(v)}
+    {}
+  };
+
+  template <typename T>
+  using PyArray_ptr = std::shared_ptr<PyArray<T>>;
+
+  /// packet contents, handed up to python without copying them again
+  using PyBytes = PyArray<byte_t>;
+  using PyBytes_ptr = PyArray_ptr<byte_t>;
+
+  template <typename T>
+  void
+  PyArray_Init(py::module& mod, const char* name)
+  {
+    py::class_<PyArray<T>, PyArray_ptr<T>>(mod, name, py::buffer_protocol())
+        .def_buffer([](PyArray<T>& self) {
+          return py::buffer_info(
+              self.values.data(),
+              sizeof(T),
+              py::format_descriptor<T>::format(),
+              1,
+              {self.values.size()},
+              {sizeof(T)},
+              true);
+        })
+        .def("__len__", [](const PyArray<T>& self) { return self.values.size(); });
+  }
+}  // namespace llarp
@@ -32,6 +32,14 @@ namespace llarp
               std::copy_n(pkt.c_str(), pkt.size(), buf.data());
               return ep and ep->SendToOrQueue(to, std::move(buf), service::ProtocolType::Control);
             })
+        .def(
+            "BuildPath",
+            [](Context_ptr self) {
+              self->CallSafe([self] {
+                if (auto ep = self->router->hiddenServiceContext().GetDefault())
+                  ep->BuildOne();
+              });
+            })
         .def(
             "AddEndpoint",
             [](Context_ptr self, handlers::PythonEndpoint_ptr ep) {
@@ -6,9 +6,32 @@ namespace llarp
     void
     PyHandler_Init(py::module& mod)
     {
+      py::enum_<service::ProtocolType>(mod, "ProtocolType")
+          .value("Control", service::ProtocolType::Control)
+          .value("TrafficV4", service::ProtocolType::TrafficV4)
+          .value("TrafficV6", service::ProtocolType::TrafficV6)
+          .value("Exit", service::ProtocolType::Exit)
+          .value("Auth", service::ProtocolType::Auth)
+          .value("QUIC", service::ProtocolType::QUIC)
+          .value("Batch", service::ProtocolType::Batch);
+
       py::class_<PythonEndpoint, PythonEndpoint_ptr>(mod, "Endpoint")
           .def(py::init<std::string, Context_ptr>())
           .def("SendTo", &PythonEndpoint::SendPacket)
+          .def(
+              "SendBytes",
+              // anything with the buffer protocol: bytes, bytearray, memoryview, or a packet we
+              // handed up, copied once straight into what we send
+              [](PythonEndpoint& self, service::Address remote, py::buffer pkt) {
+                const auto info = pkt.request();
+                if (info.ndim != 1 or info.strides[0] != info.itemsize)
+                  throw std::invalid_argument{"a packet has to be one contiguous buffer"};
+                const auto* data = static_cast<const byte_t*>(info.ptr);
+                self.SendPacket(
+                    remote,
+                    std::vector<byte_t>{data, data + info.size * info.itemsize},
+                    service::ProtocolType::Control);
+              })
           .def("OurAddress", &PythonEndpoint::GetOurAddress)
           .def_readwrite("GotPacket", &PythonEndpoint::handlePacket);
     }
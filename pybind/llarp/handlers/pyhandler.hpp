@@ -1,5 +1,6 @@
 #pragma once
 #include <common.hpp>
+#include <llarp/buffers.hpp>
 #include <llarp.hpp>
 #include <llarp/service/context.hpp>
 #include <llarp/service/endpoint.hpp>
@@ -40,10 +41,11 @@ namespace llarp
           }
           else
             return false;
-          std::vector<byte_t> pkt;
-          pkt.resize(pktbuf.sz);
-          std::copy_n(pktbuf.base, pktbuf.sz, pkt.data());
-          handlePacket(addr, std::move(pkt), proto);
+          // the one copy, out of a buffer that is only ours until we return; python reads this
+          handlePacket(
+              addr,
+              std::make_shared<PyBytes>(std::vector<byte_t>{pktbuf.base, pktbuf.base + pktbuf.sz}),
+              proto);
         }
         return true;
       }
@@ -85,7 +87,7 @@ namespace llarp
       }
 
       using PacketHandler_t =
-          std::function<void(service::Address, std::vector<byte_t>, service::ProtocolType)>;
+          std::function<void(service::Address, PyBytes_ptr, service::ProtocolType)>;
 
       PacketHandler_t handlePacket;
 
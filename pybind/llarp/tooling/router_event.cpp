@@ -29,7 +29,10 @@ namespace tooling
         .def_readonly("nextHop", &PathRequestReceivedEvent::nextHop)
         .def_readonly("txid", &PathRequestReceivedEvent::txid)
         .def_readonly("rxid", &PathRequestReceivedEvent::rxid)
-        .def_readonly("isEndpoint", &PathRequestReceivedEvent::isEndpoint);
+        .def_readonly("isEndpoint", &PathRequestReceivedEvent::isEndpoint)
+        .def_property_readonly("processingTime", [](const PathRequestReceivedEvent* const ev) {
+          return ev->processingTime.count();
+        });
 
     py::class_<PathStatusReceivedEvent, RouterEvent>(mod, "PathStatusReceivedEvent")
         .def_readonly("rxid", &PathStatusReceivedEvent::rxid)
@@ -38,6 +41,13 @@ namespace tooling
           return ev->status == llarp::LR_StatusRecord::SUCCESS;
         });
 
+    py::class_<PathBuildCompletedEvent, RouterEvent>(mod, "PathBuildCompletedEvent")
+        .def_readonly("rxid", &PathBuildCompletedEvent::rxid)
+        .def_readonly("numHops", &PathBuildCompletedEvent::numHops)
+        .def_property_readonly("buildTime", [](const PathBuildCompletedEvent* const ev) {
+          return ev->buildTime.count();
+        });
+
     py::class_<PubIntroSentEvent, RouterEvent>(mod, "DhtPubIntroSentEvent")
         .def_readonly("introsetPubkey", &PubIntroSentEvent::introsetPubkey)
         .def_readonly("relay", &PubIntroSentEvent::relay)
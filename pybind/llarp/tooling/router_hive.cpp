@@ -1,4 +1,5 @@
 #include <common.hpp>
+#include <llarp/buffers.hpp>
 #include <pybind11/stl.h>
 #include <pybind11/iostream.h>
 
@@ -6,8 +7,41 @@
 #include <llarp/router/abstractrouter.hpp>
 #include <llarp.hpp>
 
+#include <typeindex>
+
 namespace tooling
 {
+  /// a lot of events taken off the hive's queue at once.  python objects are made only for the
+  /// events python looks at; counting them, or picking out those of one class, makes none.
+  struct EventBatch
+  {
+    std::vector<RouterEventPtr> events;
+
+    /// what python calls each event's class, e.g. "PathBuildCompletedEvent", looked up once a
+    /// class rather than by making an object for each event
+    template <typename Visit>
+    void
+    ForEachClass(Visit&& visit) const
+    {
+      std::unordered_map<std::type_index, std::string> names;
+      for (size_t i = 0; i < events.size(); ++i)
+      {
+        const auto& ev = *events[i];
+        auto [itr, inserted] = names.try_emplace(typeid(ev));
+        if (inserted)
+        {
+          if (auto* info = py::detail::get_type_info(typeid(ev)))
+            itr->second = py::handle{reinterpret_cast<PyObject*>(info->type)}
+                              .attr("__name__")
+                              .cast<std::string>();
+          else
+            itr->second = ev.eventType;
+        }
+        visit(i, itr->second);
+      }
+    }
+  };
+
   void
   RouterHive_Init(py::module& mod)
   {
@@ -15,6 +49,43 @@ namespace tooling
     using Context_ptr = RouterHive::Context_ptr;
     using ContextVisitor = std::function<void(Context_ptr)>;
 
+    py::class_<EventBatch, std::shared_ptr<EventBatch>>(mod, "EventBatch")
+        .def("__len__", [](const EventBatch& self) { return self.events.size(); })
+        .def(
+            "__getitem__",
+            [](const EventBatch& self, size_t idx) -> const RouterEvent* {
+              if (idx >= self.events.size())
+                throw py::index_error{};
+              return self.events[idx].get();
+            },
+            py::return_value_policy::reference_internal)
+        .def(
+            "Counts",
+            [](const EventBatch& self) {
+              std::unordered_map<std::string, size_t> counts;
+              self.ForEachClass([&counts](size_t, const std::string& name) { ++counts[name]; });
+              return counts;
+            })
+        .def(
+            "OfType",
+            [](py::object self, const std::string& type) {
+              const auto& batch = self.cast<const EventBatch&>();
+              py::list found;
+              batch.ForEachClass([&](size_t idx, const std::string& name) {
+                if (name == type)
+                  found.append(py::cast(
+                      batch.events[idx].get(), py::return_value_policy::reference_internal, self));
+              });
+              return found;
+            })
+        .def_property_readonly("triggered", [](const EventBatch& self) {
+          auto triggered = std::make_shared<llarp::PyBytes>();
+          triggered->values.reserve(self.events.size());
+          for (const auto& ev : self.events)
+            triggered->values.push_back(ev->triggered);
+          return triggered;
+        });
+
     py::class_<RouterHive, RouterHive_ptr>(mod, "RouterHive")
         .def(py::init<>())
         .def("AddRelay", &RouterHive::AddRelay)
@@ -48,7 +119,19 @@ namespace tooling
             })
         .def("GetNextEvent", &RouterHive::GetNextEvent)
         .def("GetAllEvents", &RouterHive::GetAllEvents)
-        .def("RelayConnectedRelays", &RouterHive::RelayConnectedRelays)
+        .def(
+            "GetEventBatch",
+            [](RouterHive& hive, size_t max) {
+              return std::make_shared<EventBatch>(EventBatch{hive.GetEvents(max)});
+            },
+            py::arg("max") = 0)
+        .def(
+            "RelayConnectedRelays",
+            [](RouterHive& hive) {
+              const auto counts = hive.RelayConnectedRelays();
+              return std::make_shared<llarp::PyArray<uint64_t>>(
+                  std::vector<uint64_t>{counts.begin(), counts.end()});
+            })
         .def("GetRelayRCs", &RouterHive::GetRelayRCs)
         .def("GetRelay", &RouterHive::GetRelay);
   }
@@ -0,0 +1,57 @@
+#include <common.hpp>
+#include <pybind11/stl.h>
+
+#include <llarp/simulation/sim_context.hpp>
+#include <llarp/config/config.hpp>
+#include <llarp/router/abstractrouter.hpp>
+
+namespace llarp::simulate
+{
+  void
+  Simulation_Init(py::module& mod)
+  {
+    using ConfigTweak = std::function<void(Config&)>;
+
+    // times are in milliseconds, as ints
+    py::class_<LinkModel>(mod, "LinkModel")
+        .def(py::init<>())
+        .def_property(
+            "latency",
+            [](const LinkModel& m) { return m.latency.count(); },
+            [](LinkModel& m, int64_t ms) { m.latency = llarp_time_t{ms}; })
+        .def_property(
+            "jitter",
+            [](const LinkModel& m) { return m.jitter.count(); },
+            [](LinkModel& m, int64_t ms) { m.jitter = llarp_time_t{ms}; })
+        .def_readwrite("loss", &LinkModel::loss);
+
+    py::class_<NodeContext, Context, Node_ptr>(mod, "SimNode")
+        .def_property_readonly("ip", [](const NodeContext& node) { return node.IP().ToString(); })
+        .def_readonly("isRelay", &NodeContext::isRelay)
+        .def_readonly("started", &NodeContext::started);
+
+    py::class_<Simulation, Sim_ptr>(mod, "Simulation")
+        .def(py::init<std::string, uint64_t>(), py::arg("root"), py::arg("seed") = 0)
+        .def("SetSeedCount", &Simulation::SetSeedCount)
+        .def(
+            "SetDefaultLink",
+            [](Simulation& self, LinkModel model) { self.Net().SetDefaultModel(model); })
+        .def(
+            "SetNodeLink",
+            [](Simulation& self, const Node_ptr& node, LinkModel model) {
+              self.Net().SetNodeModel(node->IP(), model);
+            })
+        .def("AddRelay", &Simulation::AddRelay, py::arg("tweak") = ConfigTweak{})
+        .def("AddClient", &Simulation::AddClient, py::arg("tweak") = ConfigTweak{})
+        .def("Start", &Simulation::Start)
+        .def(
+            "RunFor",
+            [](Simulation& self, int64_t ms) { self.RunFor(llarp_time_t{ms}); },
+            py::arg("ms"))
+        .def("Stop", &Simulation::Stop)
+        .def("Now", [](Simulation& self) { return self.Sched().Now().count(); })
+        .def("Relays", &Simulation::Relays)
+        .def("Clients", &Simulation::Clients)
+        .def("Status", [](const Simulation& self) { return self.ExtractStatus().dump(); });
+  }
+}  // namespace llarp::simulate
@@ -1,8 +1,11 @@
 #include "common.hpp"
 #include <llarp/util/logging.hpp>
+#include <llarp/util/mem_account.hpp>
+#include <llarp/util/metrics.hpp>
 
 PYBIND11_MODULE(pyllarp, m)
 {
+  llarp::Buffers_Init(m);
   tooling::RouterHive_Init(m);
   tooling::RouterEvent_Init(m);
   llarp::AbstractRouter_Init(m);
@@ -14,6 +17,7 @@ PYBIND11_MODULE(pyllarp, m)
   llarp::CryptoTypes_Init(m);
   llarp::Context_Init(m);
   tooling::HiveContext_Init(m);
+  llarp::simulate::Simulation_Init(m);
   llarp::Config_Init(m);
   llarp::dht::DHTTypes_Init(m);
   llarp::PathTypes_Init(m);
@@ -21,5 +25,8 @@ PYBIND11_MODULE(pyllarp, m)
   llarp::handlers::PyHandler_Init(m);
   llarp::service::Address_Init(m);
   m.def("EnableDebug", []() { llarp::log::reset_level(llarp::log::Level::debug); });
+  // every router in a hive shares the process, so these are the hive's totals, as json
+  m.def("Metrics", []() { return llarp::metrics::ExtractStatus().dump(); });
+  m.def("MemoryStats", []() { return llarp::util::MemAccount::ExtractStatus().dump(); });
   llarp::Logger_Init(m);
 }
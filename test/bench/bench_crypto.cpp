@@ -0,0 +1,315 @@
+// lokinet-bench-crypto: throughput and latency of the llarp::Crypto primitives, across payload
+// sizes and thread counts, for comparing hardware and catching regressions.
+//
+//     lokinet-bench-crypto --threads 1,4 --sizes 64,1500 --json bench.json
+
+#include <llarp/constants/path.hpp>
+#include <llarp/crypto/crypto.hpp>
+#include <llarp/crypto/crypto_libsodium.hpp>
+#include <llarp/util/histogram.hpp>
+
+#include <CLI/App.hpp>
+#include <CLI/Formatter.hpp>
+#include <CLI/Config.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using namespace llarp;
+  using Clock = std::chrono::steady_clock;
+
+  /// keys, nonces and buffers for one thread's runs, set up before the clock starts so that all
+  /// we time is the operation itself
+  struct Fixture
+  {
+    Crypto& crypto;
+    std::vector<byte_t> payload;
+    std::vector<byte_t> out;
+    SharedSecret key;
+    TunnelNonce nonce;
+    std::array<SharedSecret, path::max_len> layerKeys;
+    std::array<TunnelNonce, path::max_len> layerNonces;
+    SecretKey identity;
+    Signature sig;
+    SecretKey ours;
+    SecretKey theirs;
+    PQKeyPair pq;
+    PQCipherBlock pqCipher;
+    ShortHash hash;
+    SharedSecret shared;
+    PubKey derived;
+    PrivateKey derivedPrivate;
+
+    Fixture(Crypto& c, size_t size) : crypto{c}, payload(size), out(size)
+    {
+      crypto.randbytes(payload.data(), payload.size());
+      key.Randomize();
+      nonce.Randomize();
+      for (size_t idx = 0; idx < layerKeys.size(); ++idx)
+      {
+        layerKeys[idx].Randomize();
+        layerNonces[idx].Randomize();
+      }
+      crypto.identity_keygen(identity);
+      crypto.sign(sig, identity, Payload());
+      crypto.encryption_keygen(ours);
+      crypto.encryption_keygen(theirs);
+      crypto.pqe_keygen(pq);
+      crypto.pqe_encrypt(pqCipher, shared, PQPubKey{pq_keypair_to_public(pq)});
+    }
+
+    llarp_buffer_t
+    Payload()
+    {
+      return llarp_buffer_t{payload};
+    }
+  };
+
+  struct Benchmark
+  {
+    std::string name;
+    /// if it works over a payload, and so gets run at every payload size
+    bool sized;
+    std::function<void(Fixture&)> run;
+  };
+
+  const std::vector<Benchmark> benchmarks{
+      {"xchacha20",
+       true,
+       [](Fixture& f) { f.crypto.xchacha20(f.Payload(), f.key, f.nonce); }},
+      {"xchacha20_alt",
+       true,
+       [](Fixture& f) {
+         f.crypto.xchacha20_alt(llarp_buffer_t{f.out}, f.Payload(), f.key, f.nonce.data());
+       }},
+      {"xchacha20_layers",
+       true,
+       [](Fixture& f) {
+         f.crypto.xchacha20_layers(
+             f.Payload(), f.layerKeys.data(), f.layerNonces.data(), f.layerKeys.size());
+       }},
+      {"hmac", true, [](Fixture& f) { f.crypto.hmac(f.hash.data(), f.Payload(), f.key); }},
+      {"shorthash", true, [](Fixture& f) { f.crypto.shorthash(f.hash, f.Payload()); }},
+      {"sign", true, [](Fixture& f) { f.crypto.sign(f.sig, f.identity, f.Payload()); }},
+      {"verify",
+       true,
+       [](Fixture& f) { f.crypto.verify(f.identity.toPublic(), f.Payload(), f.sig); }},
+      {"dh_client",
+       false,
+       [](Fixture& f) { f.crypto.dh_client(f.shared, f.theirs.toPublic(), f.ours, f.nonce); }},
+      {"dh_server",
+       false,
+       [](Fixture& f) { f.crypto.dh_server(f.shared, f.theirs.toPublic(), f.ours, f.nonce); }},
+      // the same keys every time, so this is the cached case
+      {"transport_dh_client",
+       false,
+       [](Fixture& f) {
+         f.crypto.transport_dh_client(f.shared, f.theirs.toPublic(), f.ours, f.nonce);
+       }},
+      {"transport_dh_server",
+       false,
+       [](Fixture& f) {
+         f.crypto.transport_dh_server(f.shared, f.theirs.toPublic(), f.ours, f.nonce);
+       }},
+      {"pqe_keygen", false, [](Fixture& f) { f.crypto.pqe_keygen(f.pq); }},
+      {"pqe_encrypt",
+       false,
+       [](Fixture& f) {
+         f.crypto.pqe_encrypt(f.pqCipher, f.shared, PQPubKey{pq_keypair_to_public(f.pq)});
+       }},
+      {"pqe_decrypt",
+       false,
+       [](Fixture& f) {
+         f.crypto.pqe_decrypt(f.pqCipher, f.shared, pq_keypair_to_secret(f.pq));
+       }},
+      {"derive_subkey",
+       false,
+       [](Fixture& f) { f.crypto.derive_subkey(f.derived, f.identity.toPublic(), 1); }},
+      {"derive_subkey_private",
+       false,
+       [](Fixture& f) { f.crypto.derive_subkey_private(f.derivedPrivate, f.identity, 1); }},
+  };
+
+  /// run bench on nthreads threads at once for about duration, each with its own fixture
+  nlohmann::json
+  Run(Crypto& crypto,
+      const Benchmark& bench,
+      size_t size,
+      size_t nthreads,
+      std::chrono::duration<double> duration)
+  {
+    // one each, merged after, so that the threads time the crypto rather than each other's
+    // recording
+    std::unique_ptr<util::Histogram[]> latencies{new util::Histogram[nthreads]};
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<uint64_t> ops(nthreads);
+    std::vector<Clock::duration> elapsed(nthreads);
+
+    std::vector<std::thread> threads;
+    for (size_t idx = 0; idx < nthreads; ++idx)
+    {
+      threads.emplace_back([&, idx] {
+        Fixture f{crypto, size};
+        ++ready;
+        while (not go)
+          std::this_thread::yield();
+
+        const auto start = Clock::now();
+        const auto deadline = start + std::chrono::duration_cast<Clock::duration>(duration);
+        auto now = start;
+        uint64_t n = 0;
+        auto& latency = latencies[idx];
+        do
+        {
+          bench.run(f);
+          const auto done = Clock::now();
+          latency.Record(
+              std::chrono::duration_cast<std::chrono::nanoseconds>(done - now).count());
+          now = done;
+          ++n;
+        } while (now < deadline);
+        ops[idx] = n;
+        elapsed[idx] = now - start;
+      });
+    }
+    while (ready < nthreads)
+      std::this_thread::yield();
+    go = true;
+    for (auto& t : threads)
+      t.join();
+    util::Histogram latency;
+    for (size_t idx = 0; idx < nthreads; ++idx)
+      latencies[idx].DrainInto(latency);
+
+    uint64_t total = 0;
+    double opsPerSec = 0;
+    for (size_t idx = 0; idx < nthreads; ++idx)
+    {
+      total += ops[idx];
+      opsPerSec += ops[idx] / std::chrono::duration<double>(elapsed[idx]).count();
+    }
+    nlohmann::json result{
+        {"name", bench.name},
+        {"threads", nthreads},
+        {"ops", total},
+        {"opsPerSec", opsPerSec},
+        {"latencyNs", latency.ExtractStatus()}};
+    if (bench.sized)
+    {
+      result["size"] = size;
+      result["bytesPerSec"] = opsPerSec * size;
+    }
+    return result;
+  }
+
+  void
+  Print(const nlohmann::json& r)
+  {
+    const auto& lat = r["latencyNs"];
+    std::string size = r.contains("size") ? std::to_string(r["size"].get<size_t>()) : "-";
+    std::string rate = r.contains("bytesPerSec")
+        ? fmt::format("{:10.1f} MB/s", r["bytesPerSec"].get<double>() / 1e6)
+        : std::string(15, ' ');
+    fmt::print(
+        "{:<24}{:>7}{:>4}t {:12.0f} op/s {} p50 {:>8}ns p99 {:>8}ns\n",
+        r["name"].get<std::string>(),
+        size,
+        r["threads"].get<size_t>(),
+        r["opsPerSec"].get<double>(),
+        rate,
+        lat["p50"].get<uint64_t>(),
+        lat["p99"].get<uint64_t>());
+  }
+}  // namespace
+
+int
+main(int argc, char* argv[])
+{
+  CLI::App cli{"benchmark lokinet's crypto primitives", "lokinet-bench-crypto"};
+
+  std::vector<size_t> sizes{64, 256, 1024, 1500, 4096, 16384};
+  std::vector<size_t> threadCounts{1, std::max(1u, std::thread::hardware_concurrency())};
+  double seconds = 1.0;
+  std::string filter;
+  std::string jsonPath;
+  bool list = false;
+
+  cli.add_option("--sizes", sizes, "Payload sizes in bytes for the primitives that take one")
+      ->delimiter(',')
+      ->capture_default_str();
+  cli.add_option("--threads", threadCounts, "Thread counts to run each benchmark with")
+      ->delimiter(',')
+      ->capture_default_str();
+  cli.add_option("--duration", seconds, "Seconds to run each benchmark for")
+      ->capture_default_str();
+  cli.add_option("--filter", filter, "Only run benchmarks whose name contains this");
+  cli.add_option("--json", jsonPath, "Write the results as json to this file, - for stdout");
+  cli.add_flag("--list", list, "List the benchmarks and exit");
+
+  try
+  {
+    cli.parse(argc, argv);
+  }
+  catch (const CLI::ParseError& e)
+  {
+    return cli.exit(e);
+  }
+
+  if (list)
+  {
+    for (const auto& bench : benchmarks)
+      fmt::print("{}\n", bench.name);
+    return 0;
+  }
+
+  sodium::CryptoLibSodium crypto;
+  CryptoManager manager{&crypto};
+
+  const bool quiet = jsonPath == "-";
+  auto results = nlohmann::json::array();
+  for (const auto& bench : benchmarks)
+  {
+    if (not filter.empty() and bench.name.find(filter) == std::string::npos)
+      continue;
+    const auto benchSizes = bench.sized ? sizes : std::vector<size_t>{0};
+    for (const auto size : benchSizes)
+    {
+      for (const auto nthreads : threadCounts)
+      {
+        auto result = Run(
+            crypto,
+            bench,
+            size,
+            std::max<size_t>(1, nthreads),
+            std::chrono::duration<double>{seconds});
+        if (not quiet)
+          Print(result);
+        results.push_back(std::move(result));
+      }
+    }
+  }
+
+  nlohmann::json out{
+      {"hardwareConcurrency", std::thread::hardware_concurrency()},
+      {"crypto", crypto.ExtractStatus()},
+      {"results", std::move(results)}};
+  if (jsonPath == "-")
+    std::cout << out.dump(2) << std::endl;
+  else if (not jsonPath.empty())
+    std::ofstream{jsonPath} << out.dump(2) << std::endl;
+  return 0;
+}
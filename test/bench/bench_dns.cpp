@@ -0,0 +1,507 @@
+// lokinet-bench-dns: latency and cpu cost of answering dns through llarp::dns::Server, for a mix
+// of .loki, .snode, reverse and upstream queries sent at a steady rate.  the resolvers behind the
+// server are stand-ins that answer after fixed delays, so runs are repeatable and what we measure
+// is the dns path itself.
+//
+//     lokinet-bench-dns --qps 1000,10000,50000 --mix loki=40,snode=10,ptr=10,upstream=40
+
+#include <llarp/dns/cache.hpp>
+#include <llarp/dns/dns.hpp>
+#include <llarp/dns/server.hpp>
+#include <llarp/dns/wire.hpp>
+#include <llarp/net/ip.hpp>
+#include <llarp/util/histogram.hpp>
+
+#include <CLI/App.hpp>
+#include <CLI/Formatter.hpp>
+#include <CLI/Config.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+#include <oxenc/endian.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+  using namespace llarp;
+  using namespace std::literals;
+  using Clock = std::chrono::steady_clock;
+
+  enum Kind : size_t
+  {
+    Loki,
+    SNode,
+    PTR,
+    Upstream,
+    NumKinds
+  };
+
+  const std::array<std::string, NumKinds> kindNames{"loki", "snode", "ptr", "upstream"};
+
+  struct Settings
+  {
+    std::array<double, NumKinds> mix{40, 10, 10, 40};
+    size_t names = 1000;
+    std::chrono::duration<double> duration{5};
+    llarp_time_t lookupDelay = 0ms;
+    llarp_time_t upstreamDelay = 20ms;
+    size_t cacheKB = 1024;
+    uint32_t seed = 1;
+  };
+
+  /// what went out and what came back, by query id
+  struct Stats
+  {
+    struct Sent
+    {
+      Clock::time_point at;
+      Kind kind;
+      bool waiting = false;
+    };
+
+    std::array<Sent, 1 << 16> sent{};
+    std::array<util::Histogram, NumKinds> kinds;
+    util::Histogram all;
+    uint64_t numSent = 0;
+    uint64_t numAnswered = 0;
+    /// ids that came around again before their answer did
+    uint64_t numLost = 0;
+    /// answers that said no such name or failed
+    uint64_t numErrors = 0;
+
+    uint64_t
+    Waiting() const
+    {
+      return numSent - numAnswered - numLost;
+    }
+  };
+
+  /// where the server sends its answers; timestamps each one against when its query went out
+  class Sink : public dns::PacketSource_Base
+  {
+    Stats& m_Stats;
+
+   public:
+    explicit Sink(Stats& stats) : m_Stats{stats}
+    {}
+
+    bool
+    WouldLoop(const SockAddr&, const SockAddr&) const override
+    {
+      return false;
+    }
+
+    void
+    SendTo(const SockAddr&, const SockAddr&, OwnedBuffer buf) const override
+    {
+      const auto now = Clock::now();
+      if (buf.sz < dns::MessageHeader::Size)
+        return;
+      auto& sent = m_Stats.sent[oxenc::load_big_to_host<uint16_t>(buf.buf.get())];
+      if (not sent.waiting)
+        return;
+      sent.waiting = false;
+      const auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - sent.at).count();
+      m_Stats.kinds[sent.kind].Record(us);
+      m_Stats.all.Record(us);
+      ++m_Stats.numAnswered;
+      if (buf.buf[3] & 0x0f)
+        ++m_Stats.numErrors;
+    }
+
+    void
+    Stop() override
+    {}
+
+    std::optional<SockAddr>
+    BoundOn() const override
+    {
+      return std::nullopt;
+    }
+  };
+
+  /// send reply to the job after delay, or right away if there is none
+  void
+  ReplyLater(
+      const EventLoop_ptr& loop,
+      llarp_time_t delay,
+      std::shared_ptr<dns::QueryJob> job,
+      dns::Message reply)
+  {
+    if (delay == 0s)
+    {
+      job->SendReply(reply.ToBuffer());
+      return;
+    }
+    loop->call_later(delay, [job = std::move(job), reply = std::move(reply)]() {
+      job->SendReply(reply.ToBuffer());
+    });
+  }
+
+  /// stands in for the endpoint: .loki after a lookup delay, .snode and reverse lookups at once,
+  /// as a router that knows them would
+  class MockEndpoint : public dns::Resolver_Base
+  {
+    EventLoop_ptr m_Loop;
+    const Settings& m_Settings;
+
+   protected:
+    int
+    Rank() const override
+    {
+      return 0;
+    }
+
+   public:
+    MockEndpoint(EventLoop_ptr loop, const Settings& settings)
+        : m_Loop{std::move(loop)}, m_Settings{settings}
+    {}
+
+    std::string_view
+    ResolverName() const override
+    {
+      return "mock-endpoint";
+    }
+
+    bool
+    MaybeHookDNS(
+        std::shared_ptr<dns::PacketSource_Base> source,
+        const dns::Message& query,
+        const SockAddr& to,
+        const SockAddr& from) override
+    {
+      if (query.questions.size() != 1)
+        return false;
+      const auto& q = query.questions[0];
+      const bool loki = q.HasTLD(".loki");
+      if (not loki and not q.HasTLD(".snode") and not q.HasTLD(".arpa"))
+        return false;
+
+      auto job = std::make_shared<dns::QueryJob>(source, query, to, from);
+      dns::Message reply{query};
+      if (q.qtype == dns::qTypePTR)
+        reply.AddAReply(std::string(52, 'y') + ".loki.", 1);
+      else
+        reply.AddINReply(net::ExpandV4(huint32_t{0x0a00'0001}), false, 1);
+      ReplyLater(m_Loop, loki ? m_Settings.lookupDelay : 0s, std::move(job), std::move(reply));
+      return true;
+    }
+  };
+
+  /// stands in for libunbound: everything else, after a round trip's delay, through the same
+  /// answer cache the real one has
+  class MockUpstream : public dns::Resolver_Base
+  {
+    EventLoop_ptr m_Loop;
+    const Settings& m_Settings;
+    std::shared_ptr<dns::AnswerCache> m_Cache;
+
+   protected:
+    int
+    Rank() const override
+    {
+      return 10;
+    }
+
+   public:
+    MockUpstream(EventLoop_ptr loop, const Settings& settings)
+        : m_Loop{std::move(loop)}, m_Settings{settings}
+    {
+      dns::AnswerCache::Config conf;
+      conf.maxBytes = settings.cacheKB * 1024;
+      m_Cache = std::make_shared<dns::AnswerCache>(conf);
+    }
+
+    std::string_view
+    ResolverName() const override
+    {
+      return "mock-upstream";
+    }
+
+    bool
+    MaybeHookDNS(
+        std::shared_ptr<dns::PacketSource_Base> source,
+        const dns::Message& query,
+        const SockAddr& to,
+        const SockAddr& from) override
+    {
+      if (auto cached = m_Cache->Get(query, m_Loop->time_now()))
+      {
+        source->SendTo(from, to, std::move(*cached));
+        return true;
+      }
+      dns::Message reply{query};
+      reply.AddINReply(net::ExpandV4(huint32_t{0x5db8'd822}), false, 300);
+      auto job = std::make_shared<dns::QueryJob>(source, query, to, from);
+      auto answer = [loop = m_Loop, cache = m_Cache, job, reply = std::move(reply)]() {
+        auto buf = reply.ToBuffer();
+        cache->Put(job->Underlying(), buf.buf.get(), buf.sz, loop->time_now());
+        job->SendReply(std::move(buf));
+      };
+      if (m_Settings.upstreamDelay == 0s)
+        answer();
+      else
+        m_Loop->call_later(m_Settings.upstreamDelay, std::move(answer));
+      return true;
+    }
+  };
+
+  /// a 52 character base32z string, the length of a .loki or .snode address
+  std::string
+  Address(std::mt19937& rng)
+  {
+    static constexpr std::string_view alphabet = "ybndrfg8ejkmcpqxot1uwisza345h769";
+    std::string addr(52, 'y');
+    for (auto& ch : addr)
+      ch = alphabet[rng() % alphabet.size()];
+    return addr;
+  }
+
+  /// the wire form of a query for each of the names of a kind we ask about, to copy and stamp
+  /// with an id as we send them, so that making queries isn't what we time
+  std::vector<std::vector<byte_t>>
+  MakeQueries(Kind kind, size_t count, std::mt19937& rng)
+  {
+    std::vector<std::vector<byte_t>> queries;
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+      std::string name;
+      auto qtype = dns::qTypeA;
+      switch (kind)
+      {
+        case Loki:
+          name = Address(rng) + ".loki";
+          break;
+        case SNode:
+          name = Address(rng) + ".snode";
+          break;
+        case PTR:
+          name = fmt::format("{}.{}.{}.10.in-addr.arpa", idx & 0xff, (idx >> 8) & 0xff, idx >> 16);
+          qtype = dns::qTypePTR;
+          break;
+        default:
+          name = fmt::format("host{}.example.com", idx);
+      }
+      std::array<byte_t, 512> buf;
+      dns::MessageWriter writer{buf.data(), buf.size()};
+      writer.Header(0, dns::flags_RD);
+      writer.Question(name, qtype, dns::qClassIN);
+      queries.emplace_back(buf.begin(), buf.begin() + writer.Size());
+    }
+    return queries;
+  }
+
+  /// send qps queries a second for about duration, then wait for what is still out
+  nlohmann::json
+  Run(const Settings& settings, double qps)
+  {
+    auto loop = EventLoop::create();
+    auto server = std::make_shared<dns::Server>(loop, DnsConfig{}, 0);
+    auto endpoint = std::make_shared<MockEndpoint>(loop, settings);
+    auto upstream = std::make_shared<MockUpstream>(loop, settings);
+    server->AddResolver(std::weak_ptr<dns::Resolver_Base>{endpoint});
+    server->AddResolver(std::weak_ptr<dns::Resolver_Base>{upstream});
+
+    auto stats = std::make_unique<Stats>();
+    auto sink = std::make_shared<Sink>(*stats);
+    const SockAddr resolver{"127.0.0.1:53"};
+    const SockAddr asker{"127.0.0.1:41414"};
+
+    std::mt19937 rng{settings.seed};
+    std::array<std::vector<std::vector<byte_t>>, NumKinds> queries;
+    for (size_t kind = 0; kind < NumKinds; ++kind)
+      queries[kind] = MakeQueries(Kind(kind), settings.names, rng);
+    std::discrete_distribution<size_t> pickKind{settings.mix.begin(), settings.mix.end()};
+    std::uniform_int_distribution<size_t> pickName{0, settings.names - 1};
+
+    const auto sending = std::chrono::duration_cast<Clock::duration>(settings.duration);
+    const auto grace = std::max(settings.lookupDelay, settings.upstreamDelay) + 1s;
+    Clock::time_point start, stopped;
+    std::clock_t cpuStart = 0;
+    uint16_t nextID = 0;
+
+    auto keepalive = std::make_shared<int>(0);
+    const auto send = [&](Clock::time_point now) {
+      const Kind kind = Kind(pickKind(rng));
+      const auto& wire = queries[kind][pickName(rng)];
+      OwnedBuffer buf{wire.data(), wire.size()};
+      const uint16_t id = nextID++;
+      oxenc::write_host_as_big(id, buf.buf.get());
+      auto& sent = stats->sent[id];
+      if (sent.waiting)
+        ++stats->numLost;
+      sent = Stats::Sent{now, kind, true};
+      ++stats->numSent;
+      server->MaybeHandlePacket(sink, resolver, asker, std::move(buf));
+    };
+    const auto tick = [&]() {
+      const auto now = Clock::now();
+      if (now < start + sending)
+      {
+        const auto due = static_cast<uint64_t>(
+            std::chrono::duration<double>(now - start).count() * qps);
+        while (stats->numSent < due)
+          send(Clock::now());
+        stopped = now;
+      }
+      else if (stats->Waiting() == 0 or now > stopped + grace)
+      {
+        keepalive.reset();
+        loop->stop();
+      }
+    };
+    loop->call_soon([&]() {
+      start = stopped = Clock::now();
+      cpuStart = std::clock();
+      loop->call_every(1ms, keepalive, tick);
+    });
+    loop->run();
+
+    const double cpuSeconds = double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    const double elapsed = std::chrono::duration<double>(stopped - start).count();
+    nlohmann::json byKind;
+    for (size_t kind = 0; kind < NumKinds; ++kind)
+      byKind[kindNames[kind]] = stats->kinds[kind].ExtractStatus();
+    return nlohmann::json{
+        {"targetQps", qps},
+        {"sent", stats->numSent},
+        {"answered", stats->numAnswered},
+        {"unanswered", stats->Waiting() + stats->numLost},
+        {"errors", stats->numErrors},
+        {"sentQps", elapsed > 0 ? stats->numSent / elapsed : 0},
+        {"cpuUsPerQuery", stats->numSent ? cpuSeconds * 1e6 / stats->numSent : 0},
+        {"latencyUs", stats->all.ExtractStatus()},
+        {"latencyUsByKind", std::move(byKind)}};
+  }
+
+  void
+  Print(const nlohmann::json& r)
+  {
+    const auto& lat = r["latencyUs"];
+    fmt::print(
+        "{:>8.0f} q/s target {:10.0f} q/s sent {:>9}/{:<9} answered p50 {:>7}us p99 {:>7}us "
+        "cpu {:6.2f}us/q\n",
+        r["targetQps"].get<double>(),
+        r["sentQps"].get<double>(),
+        r["answered"].get<uint64_t>(),
+        r["sent"].get<uint64_t>(),
+        lat["p50"].get<uint64_t>(),
+        lat["p99"].get<uint64_t>(),
+        r["cpuUsPerQuery"].get<double>());
+    for (const auto& name : kindNames)
+    {
+      const auto& kind = r["latencyUsByKind"][name];
+      if (kind["count"].get<uint64_t>() == 0)
+        continue;
+      fmt::print(
+          "    {:<10}{:>9} p50 {:>7}us p99 {:>7}us\n",
+          name,
+          kind["count"].get<uint64_t>(),
+          kind["p50"].get<uint64_t>(),
+          kind["p99"].get<uint64_t>());
+    }
+  }
+}  // namespace
+
+int
+main(int argc, char* argv[])
+{
+  CLI::App cli{"benchmark lokinet's dns server", "lokinet-bench-dns"};
+
+  Settings settings;
+  std::vector<double> rates{1000, 10000};
+  std::vector<std::string> mix;
+  double seconds = settings.duration.count();
+  double lookupMs = 0;
+  double upstreamMs = 20;
+  std::string jsonPath;
+
+  cli.add_option("--qps", rates, "Queries a second to send, one run each")
+      ->delimiter(',')
+      ->capture_default_str();
+  cli.add_option("--mix", mix, "Relative share of each kind, e.g. loki=40,snode=10,ptr=10")
+      ->delimiter(',');
+  cli.add_option("--names", settings.names, "Distinct names to ask about of each kind")
+      ->capture_default_str();
+  cli.add_option("--duration", seconds, "Seconds to send queries for in each run")
+      ->capture_default_str();
+  cli.add_option("--lookup-delay", lookupMs, "Milliseconds a .loki lookup takes")
+      ->capture_default_str();
+  cli.add_option("--upstream-delay", upstreamMs, "Milliseconds an upstream query takes")
+      ->capture_default_str();
+  cli.add_option("--cache-size", settings.cacheKB, "Upstream answer cache in kB, 0 for none")
+      ->capture_default_str();
+  cli.add_option("--seed", settings.seed, "Seed for picking names and kinds")
+      ->capture_default_str();
+  cli.add_option("--json", jsonPath, "Write the results as json to this file, - for stdout");
+
+  try
+  {
+    cli.parse(argc, argv);
+  }
+  catch (const CLI::ParseError& e)
+  {
+    return cli.exit(e);
+  }
+
+  if (not mix.empty())
+  {
+    settings.mix = {};
+    for (const auto& part : mix)
+    {
+      const auto eq = part.find('=');
+      const auto name = part.substr(0, eq);
+      const auto itr = std::find(kindNames.begin(), kindNames.end(), name);
+      if (eq == std::string::npos or itr == kindNames.end())
+      {
+        fmt::print(stderr, "bad --mix entry '{}', want one of loki, snode, ptr, upstream\n", part);
+        return 1;
+      }
+      settings.mix[itr - kindNames.begin()] = std::stod(part.substr(eq + 1));
+    }
+  }
+  if (settings.names == 0)
+  {
+    fmt::print(stderr, "--names has to be at least 1\n");
+    return 1;
+  }
+  settings.duration = std::chrono::duration<double>{seconds};
+  settings.lookupDelay = std::chrono::duration_cast<llarp_time_t>(
+      std::chrono::duration<double, std::milli>{lookupMs});
+  settings.upstreamDelay = std::chrono::duration_cast<llarp_time_t>(
+      std::chrono::duration<double, std::milli>{upstreamMs});
+
+  const bool quiet = jsonPath == "-";
+  auto results = nlohmann::json::array();
+  for (const auto qps : rates)
+  {
+    auto result = Run(settings, qps);
+    if (not quiet)
+      Print(result);
+    results.push_back(std::move(result));
+  }
+
+  nlohmann::json mixJson;
+  for (size_t kind = 0; kind < NumKinds; ++kind)
+    mixJson[kindNames[kind]] = settings.mix[kind];
+  nlohmann::json out{
+      {"mix", std::move(mixJson)},
+      {"names", settings.names},
+      {"lookupDelayMs", lookupMs},
+      {"upstreamDelayMs", upstreamMs},
+      {"cacheKB", settings.cacheKB},
+      {"results", std::move(results)}};
+  if (jsonPath == "-")
+    std::cout << out.dump(2) << std::endl;
+  else if (not jsonPath.empty())
+    std::ofstream{jsonPath} << out.dump(2) << std::endl;
+  return 0;
+}
@@ -0,0 +1,553 @@
+// lokinet-bench-iwp: how fast one iwp link session moves messages, with no paths or routers
+// around it.  two iwp::LinkLayers handshake over an in-memory wire, then one keeps as many
+// messages in flight to the other as it is let, of each size asked for, spread over the
+// priorities asked for.  reports messages and bytes a second, retransmits, delivery latency by
+// priority and how the cpu went between crypto and everything else.
+//
+// the wire hands packets over on the next loop iteration, dropping --loss percent of them to make
+// the links retransmit, and crypto jobs run in the event loop thread, so one core does it all and
+// the split between crypto and bookkeeping is exact.
+//
+//     lokinet-bench-iwp --sizes 64,1024,8192 --priorities 0,1,2 --loss 1 --json iwp.json
+
+#include <llarp/config/key_manager.hpp>
+#include <llarp/crypto/crypto.hpp>
+#include <llarp/crypto/crypto_libsodium.hpp>
+#include <llarp/ev/libuv.hpp>
+#include <llarp/iwp/iwp.hpp>
+#include <llarp/iwp/linklayer.hpp>
+#include <llarp/router/router.hpp>
+#include <llarp/router_contact.hpp>
+#include <llarp/util/histogram.hpp>
+#include <llarp/util/metrics.hpp>
+
+#include <CLI/App.hpp>
+#include <CLI/Formatter.hpp>
+#include <CLI/Config.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  using namespace llarp;
+  using namespace std::literals;
+  using Clock = std::chrono::steady_clock;
+
+  struct Settings
+  {
+    std::vector<uint16_t> priorities{0};
+    std::chrono::duration<double> duration{5};
+    size_t window = 1024;
+    double loss = 0;
+    uint32_t seed = 1;
+  };
+
+  class Wire;
+
+  /// one end of the wire, bound at an address the other end sends to
+  class WireUDP final : public UDPHandle, public std::enable_shared_from_this<WireUDP>
+  {
+    Wire& m_Wire;
+    std::optional<SockAddr> m_Addr;
+    std::vector<std::pair<SockAddr, std::vector<byte_t>>> m_Inbox;
+
+    void
+    Flush()
+    {
+      auto inbox = std::move(m_Inbox);
+      m_Inbox.clear();
+      std::vector<UDPPacket> pkts;
+      pkts.reserve(inbox.size());
+      for (const auto& [from, data] : inbox)
+        pkts.push_back(UDPPacket{from, byte_view_t{data.data(), data.size()}});
+      deliver_batch(pkts);
+    }
+
+   public:
+    WireUDP(Wire& wire, ReceiveFunc recv) : UDPHandle{std::move(recv)}, m_Wire{wire}
+    {}
+
+    bool
+    listen(const SockAddr& addr) override;
+
+    bool
+    send(const SockAddr& to, const llarp_buffer_t& buf) override;
+
+    void
+    close() override;
+
+    std::optional<SockAddr>
+    LocalAddr() const override
+    {
+      return m_Addr;
+    }
+
+    /// queue a packet from `from`, to be read on the next loop iteration
+    void
+    Deliver(EventLoop& loop, const SockAddr& from, const llarp_buffer_t& buf)
+    {
+      if (m_Inbox.empty())
+      {
+        loop.call_soon([self = weak_from_this()] {
+          if (auto ptr = self.lock())
+            ptr->Flush();
+        });
+      }
+      m_Inbox.emplace_back(from, std::vector<byte_t>{buf.base, buf.base + buf.sz});
+    }
+  };
+
+  /// an event loop whose udp handles only talk to each other, in memory
+  class Wire final : public uv::Loop
+  {
+    std::unordered_map<SockAddr, std::weak_ptr<WireUDP>> m_Bound;
+    std::mt19937 m_RNG;
+    std::bernoulli_distribution m_Drop;
+
+   public:
+    Wire(const Settings& settings)
+        : uv::Loop{1024}, m_RNG{settings.seed}, m_Drop{settings.loss / 100}
+    {}
+
+    std::shared_ptr<UDPHandle>
+    make_udp(UDPReceiveFunc recv) override
+    {
+      return std::make_shared<WireUDP>(*this, std::move(recv));
+    }
+
+    bool
+    Bind(const SockAddr& addr, std::weak_ptr<WireUDP> handle)
+    {
+      return m_Bound.emplace(addr, std::move(handle)).second;
+    }
+
+    void
+    Unbind(const SockAddr& addr)
+    {
+      m_Bound.erase(addr);
+    }
+
+    void
+    Send(const SockAddr& from, const SockAddr& to, const llarp_buffer_t& buf)
+    {
+      if (m_Drop(m_RNG))
+        return;
+      if (auto itr = m_Bound.find(to); itr != m_Bound.end())
+        if (auto handle = itr->second.lock())
+          handle->Deliver(*this, from, buf);
+    }
+  };
+
+  bool
+  WireUDP::listen(const SockAddr& addr)
+  {
+    if (not m_Wire.Bind(addr, weak_from_this()))
+      return false;
+    m_Addr = addr;
+    return true;
+  }
+
+  bool
+  WireUDP::send(const SockAddr& to, const llarp_buffer_t& buf)
+  {
+    if (not m_Addr)
+      return false;
+    m_Wire.Send(*m_Addr, to, buf);
+    return true;
+  }
+
+  void
+  WireUDP::close()
+  {
+    if (m_Addr)
+      m_Wire.Unbind(*m_Addr);
+    m_Addr.reset();
+  }
+
+  /// what the links need of a router: a loop, a pump and somewhere to run crypto.  the crypto
+  /// jobs go to the back of the loop's queue, as they would go to a worker, and are timed.
+  class BenchRouter final : public Router
+  {
+    const std::shared_ptr<EventLoopWakeup> m_PumpLinks;
+
+   public:
+    std::vector<ILinkLayer*> links;
+    Clock::duration crypto{0};
+
+    explicit BenchRouter(EventLoop_ptr loop)
+        : Router{loop, nullptr}, m_PumpLinks{loop->make_waker([this] {
+          for (auto* link : links)
+            link->Pump();
+        })}
+    {}
+
+    void
+    TriggerPump() override
+    {
+      m_PumpLinks->Trigger();
+    }
+
+    void
+    QueueShardedWork(uint64_t, thread::InlineTask func) override
+    {
+      loop()->call_soon([this, func = std::make_shared<thread::InlineTask>(std::move(func))] {
+        const auto started = Clock::now();
+        (*func)();
+        crypto += Clock::now() - started;
+      });
+    }
+
+    void
+    QueueWork(std::function<void(void)> func, thread::WorkClass) override
+    {
+      loop()->call_soon(std::move(func));
+    }
+  };
+
+  /// the keys and rc of one end
+  struct Peer
+  {
+    std::shared_ptr<KeyManager> keys = std::make_shared<KeyManager>();
+    RouterContact rc;
+    SockAddr addr;
+    LinkLayer_ptr link;
+
+    explicit Peer(SockAddr a) : addr{std::move(a)}
+    {
+      CryptoManager::instance()->identity_keygen(keys->identityKey);
+      CryptoManager::instance()->encryption_keygen(keys->encryptionKey);
+      CryptoManager::instance()->encryption_keygen(keys->transportKey);
+    }
+
+    /// sign our rc once the link is bound and can tell us its address info
+    void
+    MakeRC()
+    {
+      AddressInfo ai;
+      link->GetOurAddressInfo(ai);
+      rc.addrs = {ai};
+      rc.enckey = seckey_topublic(keys->encryptionKey);
+      rc.SetNick(fmt::format("bench{}", addr.getPort()));
+      rc.Sign(keys->identityKey);
+    }
+  };
+
+  struct Stats
+  {
+    struct Priority
+    {
+      uint64_t delivered = 0;
+      uint64_t dropped = 0;
+      util::Histogram latency;
+    };
+
+    std::map<uint16_t, Priority> priorities;
+    uint64_t sent = 0;
+    uint64_t refused = 0;
+    uint64_t received = 0;
+    uint64_t receivedBytes = 0;
+    size_t inFlight = 0;
+  };
+
+  uint64_t
+  Counter(const nlohmann::json& metrics, const char* name)
+  {
+    return metrics.is_object() ? metrics.value(name, uint64_t{0}) : 0;
+  }
+
+  /// keep the window full of size byte messages for about duration, then wait for the rest
+  nlohmann::json
+  Run(const Settings& settings, size_t size)
+  {
+    auto loop = std::make_shared<Wire>(settings);
+    auto router = std::make_shared<BenchRouter>(loop);
+    Peer sender{SockAddr{"10.0.0.1:1090"}};
+    Peer receiver{SockAddr{"10.0.0.2:1090"}};
+    Stats stats;
+    bool established = false;
+
+    const auto makeLink = [&](Peer& peer, bool inbound) {
+      const auto newLink = inbound ? iwp::NewInboundLink : iwp::NewOutboundLink;
+      peer.link = newLink(
+          peer.keys,
+          loop,
+          [&peer]() -> const RouterContact& { return peer.rc; },
+          [&stats](ILinkSession*, const llarp_buffer_t& buf) {
+            ++stats.received;
+            stats.receivedBytes += buf.sz;
+            return true;
+          },
+          [&peer](Signature& sig, const llarp_buffer_t& buf) {
+            return CryptoManager::instance()->sign(sig, peer.keys->identityKey, buf);
+          },
+          nullptr,
+          [&established](ILinkSession*, bool inbound) {
+            // the sender's end is up once the receiver has its intro
+            if (not inbound)
+              established = true;
+            return true;
+          },
+          [](RouterContact, RouterContact) { return true; },
+          [](ILinkSession*) {},
+          [](RouterID) {},
+          [] {},
+          [loop](auto func) { loop->call_soon(std::move(func)); });
+      peer.link->Bind(router.get(), peer.addr);
+      router->links.push_back(peer.link.get());
+      peer.MakeRC();
+    };
+    makeLink(receiver, true);
+    makeLink(sender, false);
+
+    std::vector<byte_t> payload(size);
+    CryptoManager::instance()->randbytes(payload.data(), payload.size());
+    const llarp_buffer_t msg{payload};
+    const RouterID to{receiver.rc.pubkey};
+    size_t nextPriority = 0;
+
+    const auto sending = std::chrono::duration_cast<Clock::duration>(settings.duration);
+    Clock::time_point start, stopped;
+    Clock::duration cryptoStart{0};
+    std::clock_t cpuStart = 0;
+    nlohmann::json metricsStart;
+    bool measuring = false;
+    bool done = false;
+
+    const auto fill = [&] {
+      while (stats.inFlight < settings.window)
+      {
+        const auto priority = settings.priorities[nextPriority++ % settings.priorities.size()];
+        auto completed = std::make_shared<bool>(false);
+        ++stats.inFlight;
+        const bool queued = sender.link->SendTo(
+            to,
+            msg,
+            [&stats, priority, completed, at = Clock::now()](ILinkSession::DeliveryStatus st) {
+              *completed = true;
+              --stats.inFlight;
+              auto& p = stats.priorities[priority];
+              if (st == ILinkSession::DeliveryStatus::eDeliverySuccess)
+              {
+                ++p.delivered;
+                p.latency.Record(
+                    std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - at)
+                        .count());
+              }
+              else
+                ++p.dropped;
+            },
+            priority);
+        if (not queued)
+        {
+          // a full window hands the message back as dropped; we count those apart
+          if (*completed)
+            --stats.priorities[priority].dropped;
+          else
+            --stats.inFlight;
+          ++stats.refused;
+          return;
+        }
+        ++stats.sent;
+      }
+    };
+
+    auto keepalive = std::make_shared<int>(0);
+    const auto tick = [&] {
+      const auto now = Clock::now();
+      if (not measuring)
+      {
+        if (not established)
+        {
+          if (now > start + 5s)
+          {
+            fmt::print(stderr, "the links did not handshake\n");
+            done = true;
+          }
+          else
+            return;
+        }
+        else
+        {
+          measuring = true;
+          start = stopped = now;
+          cpuStart = std::clock();
+          cryptoStart = router->crypto;
+          metricsStart = metrics::ExtractStatus();
+        }
+      }
+      if (not done and now < start + sending)
+      {
+        fill();
+        stopped = now;
+        return;
+      }
+      if (done or stats.inFlight == 0 or now > stopped + 5s)
+      {
+        keepalive.reset();
+        sender.link->Stop();
+        receiver.link->Stop();
+        loop->stop();
+      }
+    };
+    loop->call_soon([&] {
+      start = Clock::now();
+      sender.link->Start();
+      receiver.link->Start();
+      AddressInfo ai;
+      receiver.link->GetOurAddressInfo(ai);
+      sender.link->TryEstablishTo(receiver.rc, ai);
+      loop->call_every(1ms, keepalive, tick);
+    });
+    loop->run();
+
+    const double cpuSeconds = double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    const double cryptoSeconds =
+        std::chrono::duration<double>(router->crypto - cryptoStart).count();
+    const double elapsed = std::chrono::duration<double>(stopped - start).count();
+    const auto metricsEnd = metrics::ExtractStatus();
+    const auto delta = [&](const char* name) {
+      return Counter(metricsEnd, name) - Counter(metricsStart, name);
+    };
+    uint64_t delivered = 0;
+    nlohmann::json byPriority;
+    for (auto& [priority, p] : stats.priorities)
+    {
+      delivered += p.delivered;
+      byPriority[std::to_string(priority)] = nlohmann::json{
+          {"delivered", p.delivered},
+          {"dropped", p.dropped},
+          {"latencyUs", p.latency.ExtractStatus()}};
+    }
+    const auto retransmits = delta("lokinet_link_tx_retransmits_total");
+    return nlohmann::json{
+        {"size", size},
+        {"established", measuring},
+        {"sent", stats.sent},
+        {"delivered", delivered},
+        {"refused", stats.refused},
+        {"received", stats.received},
+        {"msgsPerSec", elapsed > 0 ? delivered / elapsed : 0},
+        {"bytesPerSec", elapsed > 0 ? stats.receivedBytes / elapsed : 0},
+        {"packets", delta("lokinet_link_tx_packets_total")},
+        {"retransmits", retransmits},
+        {"retransmitRate", stats.sent ? double(retransmits) / stats.sent : 0},
+        {"cpuSeconds", cpuSeconds},
+        {"cryptoSeconds", cryptoSeconds},
+        {"bookkeepingSeconds", std::max(0.0, cpuSeconds - cryptoSeconds)},
+        {"cpuUsPerMsg", delivered ? cpuSeconds * 1e6 / delivered : 0},
+        {"byPriority", std::move(byPriority)}};
+  }
+
+  void
+  Print(const nlohmann::json& r)
+  {
+    const auto cpu = r["cpuSeconds"].get<double>();
+    const auto crypto = r["cryptoSeconds"].get<double>();
+    fmt::print(
+        "{:>6} bytes {:>10.0f} msg/s {:>8.1f} MB/s  retransmits {:>6.2f}%  cpu {:6.2f}us/msg "
+        "({:.0f}% crypto)\n",
+        r["size"].get<size_t>(),
+        r["msgsPerSec"].get<double>(),
+        r["bytesPerSec"].get<double>() / 1e6,
+        100 * r["retransmitRate"].get<double>(),
+        r["cpuUsPerMsg"].get<double>(),
+        cpu > 0 ? 100 * crypto / cpu : 0);
+    for (const auto& [priority, p] : r["byPriority"].items())
+    {
+      fmt::print(
+          "    priority {:<4}{:>10} delivered p50 {:>7}us p99 {:>7}us\n",
+          priority,
+          p["delivered"].get<uint64_t>(),
+          p["latencyUs"]["p50"].get<uint64_t>(),
+          p["latencyUs"]["p99"].get<uint64_t>());
+    }
+  }
+}  // namespace
+
+int
+main(int argc, char* argv[])
+{
+  CLI::App cli{"benchmark one iwp link session", "lokinet-bench-iwp"};
+
+  Settings settings;
+  std::vector<size_t> sizes{64, 1024, MAX_LINK_MSG_SIZE};
+  double seconds = settings.duration.count();
+  std::string jsonPath;
+
+  cli.add_option("--sizes", sizes, "Message sizes in bytes, one run each")
+      ->delimiter(',')
+      ->capture_default_str();
+  cli.add_option("--priorities", settings.priorities, "Priorities to spread messages over")
+      ->delimiter(',')
+      ->capture_default_str();
+  cli.add_option("--window", settings.window, "Messages to keep in flight")
+      ->capture_default_str();
+  cli.add_option("--loss", settings.loss, "Percent of packets the wire drops")
+      ->capture_default_str();
+  cli.add_option("--duration", seconds, "Seconds to send for in each run")->capture_default_str();
+  cli.add_option("--seed", settings.seed, "Seed for which packets get dropped")
+      ->capture_default_str();
+  cli.add_option("--json", jsonPath, "Write the results as json to this file, - for stdout");
+
+  try
+  {
+    cli.parse(argc, argv);
+  }
+  catch (const CLI::ParseError& e)
+  {
+    return cli.exit(e);
+  }
+
+  for (const auto size : sizes)
+  {
+    if (size == 0 or size > MAX_LINK_MSG_SIZE)
+    {
+      fmt::print(stderr, "message sizes have to be from 1 to {}\n", MAX_LINK_MSG_SIZE);
+      return 1;
+    }
+  }
+  if (settings.priorities.empty() or settings.window == 0)
+  {
+    fmt::print(stderr, "need at least one priority and a window of at least 1\n");
+    return 1;
+  }
+  settings.duration = std::chrono::duration<double>{seconds};
+
+  sodium::CryptoLibSodium crypto;
+  CryptoManager manager{&crypto};
+  // the wire's addresses are private ones
+  RouterContact::BlockBogons = false;
+
+  const bool quiet = jsonPath == "-";
+  auto results = nlohmann::json::array();
+  for (const auto size : sizes)
+  {
+    auto result = Run(settings, size);
+    if (not quiet)
+      Print(result);
+    results.push_back(std::move(result));
+  }
+
+  nlohmann::json out{
+      {"priorities", settings.priorities},
+      {"window", settings.window},
+      {"loss", settings.loss},
+      {"results", std::move(results)}};
+  if (jsonPath == "-")
+    std::cout << out.dump(2) << std::endl;
+  else if (not jsonPath.empty())
+    std::ofstream{jsonPath} << out.dump(2) << std::endl;
+  return 0;
+}
@@ -0,0 +1,481 @@
+// lokinet-bench-link-replay: feeds a recording of real link traffic (made with the record_links
+// rpc) back through message handling, to see what it costs to handle a real workload rather than
+// a synthetic flood.  the messages a router received are parsed and handled by a router with no
+// paths and no links, at the pace they came in, or faster, or as fast as they go; what it sends
+// in reply is counted rather than sent.  reports the time handling took, by message type.
+//
+// messages end where a bare router would take them: relayed traffic finds no transit hop, path
+// builds are turned away (as we hold none of the keys they were made for) and dht requests are
+// answered out of an empty dht.  so this measures decoding and dispatch, and what comes before
+// the first lookup that misses, which is where a flood of small messages spends its time.
+//
+// a recording made without payloads can't be replayed; for one of those we only describe it.
+//
+//     lokinet-bench-link-replay links-1700000000.rec --speed 10 --json replay.json
+
+#include <llarp/crypto/crypto.hpp>
+#include <llarp/crypto/crypto_libsodium.hpp>
+#include <llarp/dht/context.hpp>
+#include <llarp/ev/ev.hpp>
+#include <llarp/link/recorder.hpp>
+#include <llarp/link/session.hpp>
+#include <llarp/messages/link_message_parser.hpp>
+#include <llarp/router/router.hpp>
+#include <llarp/router_contact.hpp>
+#include <llarp/util/histogram.hpp>
+
+#include <CLI/App.hpp>
+#include <CLI/Formatter.hpp>
+#include <CLI/Config.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  using namespace llarp;
+  using namespace std::literals;
+  using Clock = std::chrono::steady_clock;
+
+  /// handles what it is given on the loop, as nothing here needs another thread, and swallows
+  /// what it would send
+  class ReplayRouter final : public Router
+  {
+   public:
+    uint64_t replies = 0;
+
+    explicit ReplayRouter(EventLoop_ptr loop) : Router{loop, nullptr}
+    {}
+
+    bool
+    SendToOrQueue(const RouterID&, const ILinkMessage&, SendStatusHandler handler) override
+    {
+      ++replies;
+      if (handler)
+        loop()->call_soon([handler] { handler(SendStatus::Success); });
+      return true;
+    }
+
+    void
+    QueueWork(std::function<void(void)> func, thread::WorkClass) override
+    {
+      loop()->call_soon(std::move(func));
+    }
+
+    void
+    QueueDiskIO(std::function<void(void)> func) override
+    {
+      loop()->call_soon(std::move(func));
+    }
+
+    void
+    QueueShardedWork(uint64_t, thread::InlineTask func) override
+    {
+      loop()->call_soon(
+          [func = std::make_shared<thread::InlineTask>(std::move(func))] { (*func)(); });
+    }
+
+    void
+    QueuePathWork(uint64_t shard, thread::InlineTask func) override
+    {
+      QueueShardedWork(shard, std::move(func));
+    }
+  };
+
+  /// stands in for the session a recorded message came in on
+  class ReplaySession final : public ILinkSession
+  {
+    RouterContact m_RC;
+    SockAddr m_Addr{"127.0.0.1:1090"};
+
+   public:
+    explicit ReplaySession(const PubKey& remote)
+    {
+      m_RC.pubkey = remote;
+      GotLIM = [](const LinkIntroMessage*) { return true; };
+    }
+
+    void
+    Pump() override
+    {}
+
+    void
+    Tick(llarp_time_t) override
+    {}
+
+    bool
+    SendMessageBuffer(Message_t, CompletionHandler handler, uint16_t) override
+    {
+      if (handler)
+        handler(DeliveryStatus::eDeliverySuccess);
+      return true;
+    }
+
+    void
+    Start() override
+    {}
+
+    void
+    Close() override
+    {}
+
+    bool
+    SendKeepAlive() override
+    {
+      return true;
+    }
+
+    bool
+    IsEstablished() const override
+    {
+      return true;
+    }
+
+    bool
+    TimedOut(llarp_time_t) const override
+    {
+      return false;
+    }
+
+    PubKey
+    GetPubKey() const override
+    {
+      return m_RC.pubkey;
+    }
+
+    bool
+    IsInbound() const override
+    {
+      return true;
+    }
+
+    const SockAddr&
+    GetRemoteEndpoint() const override
+    {
+      return m_Addr;
+    }
+
+    RouterContact
+    GetRemoteRC() const override
+    {
+      return m_RC;
+    }
+
+    size_t
+    SendQueueBacklog() const override
+    {
+      return 0;
+    }
+
+    ILinkLayer*
+    GetLinkLayer() const override
+    {
+      return nullptr;
+    }
+
+    bool
+    RenegotiateSession() override
+    {
+      return true;
+    }
+
+    bool
+    ShouldPing() const override
+    {
+      return false;
+    }
+
+    llarp_time_t
+    NextPingAt() const override
+    {
+      return 0s;
+    }
+
+    SessionStats
+    GetSessionStats() const override
+    {
+      return {};
+    }
+
+    util::StatusObject
+    ExtractStatus() const override
+    {
+      return {};
+    }
+
+    void
+    HandlePlaintext() override
+    {}
+  };
+
+  /// the type of a bencoded link message, which always starts "d1:a1:"
+  char
+  MessageType(const std::vector<byte_t>& msg)
+  {
+    constexpr std::string_view prefix{"d1:a1:"};
+    if (msg.size() <= prefix.size()
+        or std::string_view{reinterpret_cast<const char*>(msg.data()), prefix.size()} != prefix)
+      return '?';
+    return msg[prefix.size()];
+  }
+
+  struct TypeStats
+  {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint64_t rejected = 0;
+    util::Histogram handleNs;
+  };
+
+  struct Summary
+  {
+    uint64_t received = 0;
+    uint64_t receivedBytes = 0;
+    uint64_t sent = 0;
+    uint64_t sentBytes = 0;
+    uint32_t sessions = 0;
+    std::chrono::microseconds span{0};
+  };
+
+  nlohmann::json
+  Describe(const Summary& s)
+  {
+    const double secs = std::chrono::duration<double>(s.span).count();
+    return nlohmann::json{
+        {"received", s.received},
+        {"receivedBytes", s.receivedBytes},
+        {"sent", s.sent},
+        {"sentBytes", s.sentBytes},
+        {"sessions", s.sessions},
+        {"seconds", secs},
+        {"receivedPerSec", secs > 0 ? s.received / secs : 0},
+        {"sentPerSec", secs > 0 ? s.sent / secs : 0}};
+  }
+
+  /// reads the whole recording without handling anything
+  nlohmann::json
+  Survey(LinkRecorder::Reader& reader)
+  {
+    Summary s;
+    while (auto entry = reader.Next())
+    {
+      s.span = entry->at;
+      s.sessions = std::max(s.sessions, entry->session + 1);
+      if (entry->dir == LinkRecorder::Direction::Inbound)
+      {
+        ++s.received;
+        s.receivedBytes += entry->size;
+      }
+      else
+      {
+        ++s.sent;
+        s.sentBytes += entry->size;
+      }
+    }
+    return nlohmann::json{{"recording", Describe(s)}};
+  }
+
+  /// replays the received messages, speed times as fast as they came, or as fast as they go if
+  /// speed is 0
+  nlohmann::json
+  Replay(LinkRecorder::Reader& reader, double speed)
+  {
+    auto loop = EventLoop::create();
+    auto router = std::make_shared<ReplayRouter>(loop);
+    SecretKey ourKey;
+    CryptoManager::instance()->identity_keygen(ourKey);
+    router->dht()->impl->Init(dht::Key_t{seckey_topublic(ourKey)}, router.get());
+    LinkMessageParser parser{router.get()};
+
+    std::unordered_map<uint32_t, std::unique_ptr<ReplaySession>> sessions;
+    std::map<char, TypeStats> types;
+    Summary summary;
+    Clock::duration handling{0};
+    std::optional<LinkRecorder::Entry> next = reader.Next();
+    Clock::time_point start;
+    std::clock_t cpuStart = 0;
+
+    const auto handle = [&](const LinkRecorder::Entry& entry) {
+      summary.span = entry.at;
+      if (entry.dir == LinkRecorder::Direction::Outbound)
+      {
+        ++summary.sent;
+        summary.sentBytes += entry.size;
+        return;
+      }
+      ++summary.received;
+      summary.receivedBytes += entry.size;
+      auto& session = sessions[entry.session];
+      if (not session)
+      {
+        PubKey remote;
+        remote.Randomize();
+        session = std::make_unique<ReplaySession>(remote);
+        summary.sessions = sessions.size();
+      }
+      auto& stats = types[MessageType(entry.msg)];
+      const auto started = Clock::now();
+      const bool ok = parser.ProcessFrom(session.get(), llarp_buffer_t{entry.msg});
+      const auto took = Clock::now() - started;
+      handling += took;
+      ++stats.count;
+      stats.bytes += entry.size;
+      if (not ok)
+        ++stats.rejected;
+      stats.handleNs.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(took).count());
+    };
+
+    // hands over everything that is due, then comes back when the next one is; between goes
+    // whatever the handling queued on the loop
+    std::function<void(void)> step = [&] {
+      const auto now = Clock::now();
+      for (size_t batch = 0; next and batch < 1000; ++batch)
+      {
+        if (speed > 0)
+        {
+          const auto due = start
+              + std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<double, std::micro>{next->at.count() / speed});
+          if (due > now)
+          {
+            const auto wait = std::chrono::ceil<std::chrono::milliseconds>(due - now);
+            loop->call_later(wait, step);
+            return;
+          }
+        }
+        handle(*next);
+        next = reader.Next();
+      }
+      if (next)
+        loop->call_soon(step);
+      else
+        loop->call_soon([&loop] { loop->stop(); });
+    };
+    loop->call_soon([&] {
+      start = Clock::now();
+      cpuStart = std::clock();
+      step();
+    });
+    loop->run();
+
+    const double cpuSeconds = double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    const double handlingSeconds = std::chrono::duration<double>(handling).count();
+    nlohmann::json byType;
+    for (auto& [type, stats] : types)
+    {
+      byType[std::string(1, type)] = nlohmann::json{
+          {"count", stats.count},
+          {"bytes", stats.bytes},
+          {"rejected", stats.rejected},
+          {"handleNs", stats.handleNs.ExtractStatus()}};
+    }
+    return nlohmann::json{
+        {"recording", Describe(summary)},
+        {"speed", speed},
+        {"wallSeconds", std::chrono::duration<double>(Clock::now() - start).count()},
+        {"cpuSeconds", cpuSeconds},
+        {"handlingSeconds", handlingSeconds},
+        {"handlingUsPerMsg", summary.received ? handlingSeconds * 1e6 / summary.received : 0},
+        {"cpuUsPerMsg", summary.received ? cpuSeconds * 1e6 / summary.received : 0},
+        {"replies", router->replies},
+        {"byType", std::move(byType)}};
+  }
+
+  void
+  Print(const nlohmann::json& r)
+  {
+    const auto& rec = r["recording"];
+    fmt::print(
+        "{} sessions, {} received ({} bytes) and {} sent ({} bytes) over {:.1f}s\n",
+        rec["sessions"].get<uint32_t>(),
+        rec["received"].get<uint64_t>(),
+        rec["receivedBytes"].get<uint64_t>(),
+        rec["sent"].get<uint64_t>(),
+        rec["sentBytes"].get<uint64_t>(),
+        rec["seconds"].get<double>());
+    if (not r.contains("byType"))
+      return;
+    fmt::print(
+        "replayed in {:.2f}s: {:.2f}us a message handling, {:.2f}us cpu all told, {} replies\n",
+        r["wallSeconds"].get<double>(),
+        r["handlingUsPerMsg"].get<double>(),
+        r["cpuUsPerMsg"].get<double>(),
+        r["replies"].get<uint64_t>());
+    for (const auto& [type, t] : r["byType"].items())
+    {
+      fmt::print(
+          "    {} {:>10} msgs {:>8} rejected  p50 {:>8}ns p99 {:>8}ns\n",
+          type,
+          t["count"].get<uint64_t>(),
+          t["rejected"].get<uint64_t>(),
+          t["handleNs"]["p50"].get<uint64_t>(),
+          t["handleNs"]["p99"].get<uint64_t>());
+    }
+  }
+}  // namespace
+
+int
+main(int argc, char* argv[])
+{
+  CLI::App cli{"replay a link recording through message handling", "lokinet-bench-link-replay"};
+
+  std::string file;
+  double speed = 1;
+  std::string jsonPath;
+
+  cli.add_option("recording", file, "A recording made with the record_links rpc")->required();
+  cli.add_option("--speed", speed, "How many times as fast as it was recorded; 0 for flat out")
+      ->capture_default_str();
+  cli.add_option("--json", jsonPath, "Write the results as json to this file, - for stdout");
+
+  try
+  {
+    cli.parse(argc, argv);
+  }
+  catch (const CLI::ParseError& e)
+  {
+    return cli.exit(e);
+  }
+  if (speed < 0)
+  {
+    fmt::print(stderr, "speed can't be negative\n");
+    return 1;
+  }
+
+  sodium::CryptoLibSodium crypto;
+  CryptoManager manager{&crypto};
+
+  nlohmann::json result;
+  try
+  {
+    LinkRecorder::Reader reader{file};
+    if (not reader.Payloads())
+      fmt::print(stderr, "{} was recorded without payloads, so there is nothing to replay\n", file);
+    result = reader.Payloads() ? Replay(reader, speed) : Survey(reader);
+  }
+  catch (const std::exception& ex)
+  {
+    fmt::print(stderr, "{}\n", ex.what());
+    return 1;
+  }
+
+  if (jsonPath == "-")
+    std::cout << result.dump(2) << std::endl;
+  else
+  {
+    Print(result);
+    if (not jsonPath.empty())
+      std::ofstream{jsonPath} << result.dump(2) << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,412 @@
+// lokinet-bench-nodedb: what the NodeDB and the dht's router bucket cost at the size of today's
+// network and at the sizes it may grow to: loading, saving, inserting and expiring rcs as bulk
+// operations, and the lookups path builds and the dht make as per call latencies.
+//
+//     lokinet-bench-nodedb --sizes 2000,20000,200000 --rounds 3 --json bench.json
+
+#include <llarp/crypto/crypto.hpp>
+#include <llarp/crypto/crypto_libsodium.hpp>
+#include <llarp/dht/bucket.hpp>
+#include <llarp/dht/node.hpp>
+#include <llarp/nodedb.hpp>
+#include <llarp/router_contact.hpp>
+#include <llarp/util/fs.hpp>
+#include <llarp/util/histogram.hpp>
+
+#include <CLI/App.hpp>
+#include <CLI/Formatter.hpp>
+#include <CLI/Config.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+  using namespace llarp;
+  using Clock = std::chrono::steady_clock;
+
+  /// how many lookup targets we go round, so a run doesn't keep asking about the same spot
+  constexpr size_t NumTargets = 1024;
+
+  /// signed rcs, each with an address and keys of its own, as a relay would publish.  made once
+  /// for the largest size; smaller sizes use a prefix
+  std::vector<RouterContact>
+  MakeRCs(size_t n)
+  {
+    auto* crypto = CryptoManager::instance();
+    std::vector<RouterContact> rcs(n);
+    for (auto& rc : rcs)
+    {
+      SecretKey identity;
+      SecretKey encryption;
+      crypto->identity_keygen(identity);
+      crypto->encryption_keygen(encryption);
+      AddressInfo ai{};
+      ai.rank = 1;
+      ai.dialect = "iwp";
+      ai.pubkey.Randomize();
+      ai.fromSockAddr(SockAddr{fmt::format(
+          "{}.{}.{}.{}:1090",
+          1 + randint() % 223,
+          randint() % 256,
+          randint() % 256,
+          1 + randint() % 254)});
+      rc.addrs = {ai};
+      rc.enckey = seckey_topublic(encryption);
+      rc.SetNick(fmt::format("bench{}", randint() % 100000));
+      rc.Sign(identity);
+    }
+    return rcs;
+  }
+
+  /// a nodedb and bucket holding size rcs, and what the lookups ask about, set up before the
+  /// clock starts
+  struct Fixture
+  {
+    NodeDB nodedb;
+    dht::Bucket<dht::RCNode> bucket;
+    std::vector<dht::Key_t> targets;
+    size_t next = 0;
+    /// the hops of a path being built, that the next hop is not to be one of
+    std::set<RouterID> hops;
+    std::set<dht::Key_t> exclude;
+
+    Fixture(const std::vector<RouterContact>& rcs, size_t size)
+        : bucket{dht::Key_t{}, llarp::randint}, targets(NumTargets)
+    {
+      for (size_t idx = 0; idx < size; ++idx)
+      {
+        nodedb.Put(rcs[idx]);
+        bucket.PutNode(dht::RCNode{rcs[idx]});
+      }
+      for (auto& target : targets)
+        target.Randomize();
+      for (size_t idx = 0; idx < 4; ++idx)
+      {
+        const auto& pk = rcs[randint() % size].pubkey;
+        hops.emplace(pk);
+        exclude.emplace(pk);
+      }
+    }
+
+    const dht::Key_t&
+    Target()
+    {
+      return targets[next++ % targets.size()];
+    }
+  };
+
+  struct Query
+  {
+    std::string name;
+    std::function<void(Fixture&)> run;
+  };
+
+  const std::vector<Query> queries{
+      {"get_random",
+       [](Fixture& f) { f.nodedb.GetRandom([](const auto&) { return true; }); }},
+      {"get_random_path_hop",
+       [](Fixture& f) {
+         // what a path build asks for a hop: a public router not already on the path
+         f.nodedb.GetRandom([&f](const auto& rc) {
+           return rc.IsPublicRouter() and f.hops.count(RouterID{rc.pubkey}) == 0;
+         });
+       }},
+      {"get_random_1_in_256",
+       [](Fixture& f) {
+         // a filter few pass, that rejection sampling gives up on
+         f.nodedb.GetRandom([](const auto& rc) { return rc.pubkey[0] == 0; });
+       }},
+      {"find_closest_to", [](Fixture& f) { f.nodedb.FindClosestTo(f.Target()); }},
+      {"find_many_closest_to", [](Fixture& f) { f.nodedb.FindManyClosestTo(f.Target(), 4); }},
+      {"bucket_find_closest",
+       [](Fixture& f) {
+         dht::Key_t result;
+         f.bucket.FindClosest(f.Target(), result);
+       }},
+      {"bucket_find_close_excluding",
+       [](Fixture& f) {
+         dht::Key_t result;
+         f.bucket.FindCloseExcluding(f.Target(), result, f.exclude);
+       }},
+      {"bucket_get_many_near_excluding",
+       [](Fixture& f) {
+         std::set<dht::Key_t> result;
+         f.bucket.GetManyNearExcluding(f.Target(), result, 4, f.exclude);
+       }},
+      {"bucket_random_excluding",
+       [](Fixture& f) {
+         dht::Key_t result;
+         f.bucket.GetRandomNodeExcluding(result, f.exclude);
+       }},
+  };
+
+  /// the bulk operations, each given the rcs and returning how long its operation took
+  struct Bulk
+  {
+    std::string name;
+    std::function<Clock::duration(const std::vector<RouterContact>&, size_t)> run;
+  };
+
+  /// a directory of its own for a nodedb, gone once we are done with it
+  struct TempDir
+  {
+    fs::path path;
+
+    TempDir()
+        : path{fs::temp_directory_path() / fmt::format("lokinet-bench-nodedb-{}", randint())}
+    {}
+
+    ~TempDir()
+    {
+      std::error_code ec;
+      fs::remove_all(path, ec);
+    }
+  };
+
+  /// run what a nodedb hands to the disk thread right away, so it is part of what we time
+  void
+  Inline(std::function<void()> f)
+  {
+    f();
+  }
+
+  template <typename F>
+  Clock::duration
+  Time(F&& f)
+  {
+    const auto start = Clock::now();
+    f();
+    return Clock::now() - start;
+  }
+
+  /// a store of size rcs in dir
+  void
+  Populate(const fs::path& dir, const std::vector<RouterContact>& rcs, size_t size)
+  {
+    NodeDB nodedb{dir, Inline};
+    for (size_t idx = 0; idx < size; ++idx)
+      nodedb.Put(rcs[idx]);
+    nodedb.SaveToDisk();
+  }
+
+  const std::vector<Bulk> bulks{
+      {"put",
+       [](const auto& rcs, size_t size) {
+         NodeDB nodedb;
+         return Time([&] {
+           for (size_t idx = 0; idx < size; ++idx)
+             nodedb.Put(rcs[idx]);
+         });
+       }},
+      {"save_to_disk",
+       [](const auto& rcs, size_t size) {
+         TempDir dir;
+         NodeDB nodedb{dir.path, Inline};
+         for (size_t idx = 0; idx < size; ++idx)
+           nodedb.Put(rcs[idx]);
+         return Time([&] { nodedb.SaveToDisk(); });
+       }},
+      {"load_from_disk",
+       [](const auto& rcs, size_t size) {
+         TempDir dir;
+         Populate(dir.path, rcs, size);
+         NodeDB nodedb{dir.path, Inline};
+         return Time([&] { nodedb.LoadFromDisk(); });
+       }},
+      {"load_from_disk_unverified",
+       [](const auto& rcs, size_t size) {
+         TempDir dir;
+         Populate(dir.path, rcs, size);
+         NodeDB nodedb{dir.path, Inline};
+         return Time([&] { nodedb.LoadFromDisk(false); });
+       }},
+      {"remove_stale_rcs",
+       [](const auto& rcs, size_t size) {
+         // as when we get a fresh list of routers: keep the tenth of them on it, drop the rest
+         NodeDB nodedb;
+         std::unordered_set<RouterID> keep;
+         for (size_t idx = 0; idx < size; ++idx)
+         {
+           nodedb.Put(rcs[idx]);
+           if (idx % 10 == 0)
+             keep.emplace(rcs[idx].pubkey);
+         }
+         const auto cutoff = time_now_ms() + 1s;
+         return Time([&] { nodedb.RemoveStaleRCs(std::move(keep), cutoff); });
+       }},
+      {"bucket_put",
+       [](const auto& rcs, size_t size) {
+         dht::Bucket<dht::RCNode> bucket{dht::Key_t{}, llarp::randint};
+         return Time([&] {
+           for (size_t idx = 0; idx < size; ++idx)
+             bucket.PutNode(dht::RCNode{rcs[idx]});
+         });
+       }},
+  };
+
+  nlohmann::json
+  RunBulk(const Bulk& bulk, const std::vector<RouterContact>& rcs, size_t size, size_t rounds)
+  {
+    std::vector<double> seconds;
+    for (size_t round = 0; round < rounds; ++round)
+      seconds.push_back(std::chrono::duration<double>(bulk.run(rcs, size)).count());
+    const double best = *std::min_element(seconds.begin(), seconds.end());
+    return {
+        {"name", bulk.name},
+        {"size", size},
+        {"seconds", seconds},
+        {"bestSeconds", best},
+        {"nsPerRC", 1e9 * best / size}};
+  }
+
+  nlohmann::json
+  RunQuery(const Query& query, Fixture& f, size_t size, std::chrono::duration<double> duration)
+  {
+    util::Histogram latency;
+    const auto start = Clock::now();
+    const auto deadline = start + std::chrono::duration_cast<Clock::duration>(duration);
+    auto now = start;
+    uint64_t n = 0;
+    do
+    {
+      query.run(f);
+      const auto done = Clock::now();
+      latency.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(done - now).count());
+      now = done;
+      ++n;
+    } while (now < deadline);
+    return {
+        {"name", query.name},
+        {"size", size},
+        {"ops", n},
+        {"opsPerSec", n / std::chrono::duration<double>(now - start).count()},
+        {"latencyNs", latency.ExtractStatus()}};
+  }
+
+  void
+  Print(const nlohmann::json& r)
+  {
+    if (r.contains("latencyNs"))
+    {
+      const auto& lat = r["latencyNs"];
+      fmt::print(
+          "{:<32}{:>8} {:12.0f} op/s p50 {:>8}ns p99 {:>8}ns\n",
+          r["name"].get<std::string>(),
+          r["size"].get<size_t>(),
+          r["opsPerSec"].get<double>(),
+          lat["p50"].get<uint64_t>(),
+          lat["p99"].get<uint64_t>());
+    }
+    else
+    {
+      fmt::print(
+          "{:<32}{:>8} {:12.3f} s    {:>10.0f}ns/rc\n",
+          r["name"].get<std::string>(),
+          r["size"].get<size_t>(),
+          r["bestSeconds"].get<double>(),
+          r["nsPerRC"].get<double>());
+    }
+  }
+}  // namespace
+
+int
+main(int argc, char* argv[])
+{
+  CLI::App cli{"benchmark the nodedb and the dht's router bucket", "lokinet-bench-nodedb"};
+
+  std::vector<size_t> sizes{2000, 20000, 200000};
+  double seconds = 1.0;
+  size_t rounds = 1;
+  std::string filter;
+  std::string jsonPath;
+  bool list = false;
+
+  cli.add_option("--sizes", sizes, "Numbers of rcs to run each benchmark with")
+      ->delimiter(',')
+      ->capture_default_str();
+  cli.add_option("--duration", seconds, "Seconds to run each lookup benchmark for")
+      ->capture_default_str();
+  cli.add_option("--rounds", rounds, "Times to run each bulk benchmark, keeping the best")
+      ->capture_default_str();
+  cli.add_option("--filter", filter, "Only run benchmarks whose name contains this");
+  cli.add_option("--json", jsonPath, "Write the results as json to this file, - for stdout");
+  cli.add_flag("--list", list, "List the benchmarks and exit");
+
+  try
+  {
+    cli.parse(argc, argv);
+  }
+  catch (const CLI::ParseError& e)
+  {
+    return cli.exit(e);
+  }
+
+  if (list)
+  {
+    for (const auto& bulk : bulks)
+      fmt::print("{}\n", bulk.name);
+    for (const auto& query : queries)
+      fmt::print("{}\n", query.name);
+    return 0;
+  }
+
+  sizes.erase(std::remove(sizes.begin(), sizes.end(), 0), sizes.end());
+  if (sizes.empty())
+    return 0;
+  rounds = std::max<size_t>(1, rounds);
+
+  sodium::CryptoLibSodium crypto;
+  CryptoManager manager{&crypto};
+
+  const bool quiet = jsonPath == "-";
+  const auto wanted = [&filter](const std::string& name) {
+    return filter.empty() or name.find(filter) != std::string::npos;
+  };
+
+  const auto largest = *std::max_element(sizes.begin(), sizes.end());
+  if (not quiet)
+    fmt::print("making {} signed rcs\n", largest);
+  const auto rcs = MakeRCs(largest);
+
+  auto results = nlohmann::json::array();
+  for (const auto size : sizes)
+  {
+    for (const auto& bulk : bulks)
+    {
+      if (not wanted(bulk.name))
+        continue;
+      auto result = RunBulk(bulk, rcs, size, rounds);
+      if (not quiet)
+        Print(result);
+      results.push_back(std::move(result));
+    }
+
+    Fixture fixture{rcs, size};
+    for (const auto& query : queries)
+    {
+      if (not wanted(query.name))
+        continue;
+      auto result = RunQuery(query, fixture, size, std::chrono::duration<double>{seconds});
+      if (not quiet)
+        Print(result);
+      results.push_back(std::move(result));
+    }
+  }
+
+  nlohmann::json out{{"results", std::move(results)}};
+  if (jsonPath == "-")
+    std::cout << out.dump(2) << std::endl;
+  else if (not jsonPath.empty())
+    std::ofstream{jsonPath} << out.dump(2) << std::endl;
+  return 0;
+}
@@ -0,0 +1,195 @@
+// lokinet-bench-queue: throughput of llarp::thread::Queue with producers and consumers contending
+// on it, moving one element per call (tryPushBack/tryPopFront) against moving batches of them
+// (tryPushMany/tryPopMany).  a batch of 1 is the per element calls.
+//
+//     lokinet-bench-queue --threads 1,4 --batches 1,16,64 --json bench.json
+
+#include <llarp/util/thread/queue.hpp>
+
+#include <CLI/App.hpp>
+#include <CLI/Formatter.hpp>
+#include <CLI/Config.hpp>
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  using namespace llarp;
+  using Clock = std::chrono::steady_clock;
+
+  /// runs threads producers and as many consumers against one queue for duration, each moving
+  /// batch elements per call, and counts what got through
+  nlohmann::json
+  Run(size_t threads, size_t batch, size_t capacity, std::chrono::duration<double> duration)
+  {
+    thread::Queue<uint64_t> queue{capacity};
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<uint64_t> pushed(threads);
+    std::vector<uint64_t> popped(threads);
+    // calls that found the queue full or empty
+    std::vector<uint64_t> misses(threads * 2);
+
+    std::vector<std::thread> workers;
+    for (size_t idx = 0; idx < threads; ++idx)
+    {
+      workers.emplace_back([&, idx] {
+        std::vector<uint64_t> in(batch, idx);
+        uint64_t n = 0, missed = 0;
+        ++ready;
+        while (not go)
+          std::this_thread::yield();
+        while (not stop)
+        {
+          size_t got;
+          if (batch == 1)
+            got = queue.tryPushBack(idx) == thread::QueueReturn::Success;
+          else
+            got = queue.tryPushMany(in.begin(), in.end());
+          n += got;
+          if (got == 0)
+          {
+            ++missed;
+            std::this_thread::yield();
+          }
+        }
+        pushed[idx] = n;
+        misses[idx] = missed;
+      });
+      workers.emplace_back([&, idx] {
+        std::vector<uint64_t> out;
+        out.reserve(batch);
+        uint64_t n = 0, missed = 0;
+        ++ready;
+        while (not go)
+          std::this_thread::yield();
+        while (not stop)
+        {
+          size_t got;
+          if (batch == 1)
+            got = queue.tryPopFront().has_value();
+          else
+          {
+            out.clear();
+            got = queue.tryPopMany(std::back_inserter(out), batch);
+          }
+          n += got;
+          if (got == 0)
+          {
+            ++missed;
+            std::this_thread::yield();
+          }
+        }
+        popped[idx] = n;
+        misses[threads + idx] = missed;
+      });
+    }
+    while (ready < workers.size())
+      std::this_thread::yield();
+    const auto start = Clock::now();
+    go = true;
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    for (auto& t : workers)
+      t.join();
+
+    uint64_t totalPushed = 0, totalPopped = 0, totalMisses = 0;
+    for (size_t idx = 0; idx < threads; ++idx)
+    {
+      totalPushed += pushed[idx];
+      totalPopped += popped[idx];
+    }
+    for (const auto missed : misses)
+      totalMisses += missed;
+    return nlohmann::json{
+        {"threads", threads},
+        {"batch", batch},
+        {"capacity", capacity},
+        {"pushed", totalPushed},
+        {"popped", totalPopped},
+        {"misses", totalMisses},
+        {"itemsPerSec", totalPopped / elapsed}};
+  }
+
+  void
+  Print(const nlohmann::json& r)
+  {
+    fmt::print(
+        "{:>3}p/{:<3}c batch {:>5} {:14.0f} items/s {:>12} full/empty\n",
+        r["threads"].get<size_t>(),
+        r["threads"].get<size_t>(),
+        r["batch"].get<size_t>(),
+        r["itemsPerSec"].get<double>(),
+        r["misses"].get<uint64_t>());
+  }
+}  // namespace
+
+int
+main(int argc, char* argv[])
+{
+  CLI::App cli{"benchmark llarp::thread::Queue, per element and batched", "lokinet-bench-queue"};
+
+  std::vector<size_t> threadCounts{1, std::max(1u, std::thread::hardware_concurrency() / 2)};
+  std::vector<size_t> batches{1, 8, 32, 128};
+  size_t capacity = 1024;
+  double seconds = 1.0;
+  std::string jsonPath;
+
+  cli.add_option("--threads", threadCounts, "Producer (and consumer) counts to run with")
+      ->delimiter(',')
+      ->capture_default_str();
+  cli.add_option("--batches", batches, "Elements moved per call; 1 is the per element calls")
+      ->delimiter(',')
+      ->capture_default_str();
+  cli.add_option("--capacity", capacity, "Size of the queue")->capture_default_str();
+  cli.add_option("--duration", seconds, "Seconds to run each combination for")
+      ->capture_default_str();
+  cli.add_option("--json", jsonPath, "Write the results as json to this file, - for stdout");
+
+  try
+  {
+    cli.parse(argc, argv);
+  }
+  catch (const CLI::ParseError& e)
+  {
+    return cli.exit(e);
+  }
+
+  capacity = std::max<size_t>(1, capacity);
+  const bool quiet = jsonPath == "-";
+  auto results = nlohmann::json::array();
+  for (const auto nthreads : threadCounts)
+  {
+    for (const auto batch : batches)
+    {
+      auto result = Run(
+          std::max<size_t>(1, nthreads),
+          std::clamp<size_t>(batch, 1, capacity),
+          capacity,
+          std::chrono::duration<double>{seconds});
+      if (not quiet)
+        Print(result);
+      results.push_back(std::move(result));
+    }
+  }
+
+  nlohmann::json out{
+      {"hardwareConcurrency", std::thread::hardware_concurrency()}, {"results", std::move(results)}};
+  if (jsonPath == "-")
+    std::cout << out.dump(2) << std::endl;
+  else if (not jsonPath.empty())
+    std::ofstream{jsonPath} << out.dump(2) << std::endl;
+  return 0;
+}
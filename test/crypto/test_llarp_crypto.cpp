@@ -1,5 +1,10 @@
+#include <llarp/constants/path.hpp>
 #include <llarp/crypto/crypto_libsodium.hpp>
+#include <llarp/crypto/fast_crypto.hpp>
 
+#include <sodium/crypto_stream_xchacha20.h>
+
+#include <algorithm>
 #include <iostream>
 
 #include <catch2/catch.hpp>
@@ -48,6 +53,195 @@ TEST_CASE("PQ crypto")
   REQUIRE(otherShared == shared);
 }
 
+TEST_CASE("Batched packet crypto")
+{
+  llarp::sodium::CryptoLibSodium crypto;
+  SharedSecret key;
+  key.Randomize();
+
+  std::vector<std::vector<byte_t>> pkts;
+  for (size_t sz : {64, 65, 128, 1500})
+  {
+    auto& pkt = pkts.emplace_back(sz);
+    crypto.randbytes(pkt.data(), pkt.size());
+  }
+  const auto plaintext = pkts;
+
+  REQUIRE(crypto.encrypt_packets(pkts, key));
+
+  SECTION("matches the per packet primitives")
+  {
+    for (size_t i = 0; i < pkts.size(); ++i)
+    {
+      auto expected = plaintext[i];
+      llarp_buffer_t body{
+          expected.data() + HMACSIZE + TUNNONCESIZE, expected.size() - HMACSIZE - TUNNONCESIZE};
+      REQUIRE(crypto.xchacha20(body, key, TunnelNonce{expected.data() + HMACSIZE}));
+      llarp_buffer_t hashed{expected.data() + HMACSIZE, expected.size() - HMACSIZE};
+      REQUIRE(crypto.hmac(expected.data(), hashed, key));
+      REQUIRE(pkts[i] == expected);
+    }
+  }
+
+  SECTION("round trips")
+  {
+    REQUIRE(crypto.decrypt_packets(pkts, key) == 0);
+    REQUIRE(pkts == plaintext);
+  }
+
+  SECTION("drops tampered and short packets")
+  {
+    pkts[1].back() ^= 1;
+    pkts.emplace_back(HMACSIZE + TUNNONCESIZE);
+    REQUIRE(crypto.decrypt_packets(pkts, key) == 2);
+    REQUIRE(pkts.size() == 3);
+    REQUIRE(pkts[0] == plaintext[0]);
+    REQUIRE(pkts[1] == plaintext[2]);
+    REQUIRE(pkts[2] == plaintext[3]);
+  }
+}
+
+TEST_CASE("xchacha20 matches libsodium")
+{
+  llarp::sodium::CryptoLibSodium crypto;
+  SharedSecret key;
+  key.Randomize();
+  TunnelNonce nonce;
+  nonce.Randomize();
+
+  for (size_t sz : {1, 64, 100, 1024, 1500, 4113})
+  {
+    std::vector<byte_t> data(sz);
+    crypto.randbytes(data.data(), data.size());
+    auto expected = data;
+    crypto_stream_xchacha20_xor(
+        expected.data(), expected.data(), expected.size(), nonce.data(), key.data());
+    REQUIRE(crypto.xchacha20(llarp_buffer_t{data}, key, nonce));
+    REQUIRE(data == expected);
+  }
+}
+
+TEST_CASE("Fused onion layers")
+{
+  llarp::sodium::CryptoLibSodium crypto;
+  std::array<SharedSecret, path::max_len> keys;
+  std::array<TunnelNonce, path::max_len> nonces;
+  for (size_t idx = 0; idx < keys.size(); ++idx)
+  {
+    keys[idx].Randomize();
+    nonces[idx].Randomize();
+  }
+
+  // sizes around the chacha block and the chunk size to catch counter mistakes
+  for (size_t sz : {0, 1, 63, 64, 65, 4095, 4096, 4097, 9000})
+  {
+    for (size_t layers : {1, 4, 8})
+    {
+      std::vector<byte_t> data(sz);
+      crypto.randbytes(data.data(), data.size());
+      auto expected = data;
+      for (size_t idx = 0; idx < layers; ++idx)
+        REQUIRE(crypto.xchacha20(llarp_buffer_t{expected}, keys[idx], nonces[idx]));
+      REQUIRE(crypto.xchacha20_layers(llarp_buffer_t{data}, keys.data(), nonces.data(), layers));
+      REQUIRE(data == expected);
+    }
+  }
+
+  std::vector<byte_t> data(64);
+  REQUIRE_FALSE(crypto.xchacha20_layers(
+      llarp_buffer_t{data}, keys.data(), nonces.data(), path::max_len + 1));
+}
+
+TEST_CASE("Data plane crypto agrees with llarp::Crypto")
+{
+  llarp::sodium::CryptoLibSodium crypto;
+  CryptoManager manager{&crypto};
+  SharedSecret key;
+  key.Randomize();
+  TunnelNonce nonce;
+  nonce.Randomize();
+
+  std::vector<byte_t> data(1500);
+  crypto.randbytes(data.data(), data.size());
+  auto expected = data;
+  REQUIRE(crypto.xchacha20(llarp_buffer_t{expected}, key, nonce));
+  REQUIRE(fast_crypto::xchacha20(llarp_buffer_t{data}, key, nonce));
+  REQUIRE(data == expected);
+
+  ShortHash h1, h2;
+  REQUIRE(crypto.shorthash(h1, llarp_buffer_t{data}));
+  REQUIRE(fast_crypto::shorthash(h2, llarp_buffer_t{data}));
+  REQUIRE(h1 == h2);
+
+  REQUIRE(crypto.hmac(h1.data(), llarp_buffer_t{data}, key));
+  REQUIRE(fast_crypto::hmac(h2.data(), llarp_buffer_t{data}, key));
+  REQUIRE(h1 == h2);
+
+  std::vector<std::vector<byte_t>> pkts{data, data};
+  auto expectedPkts = pkts;
+  REQUIRE(crypto.encrypt_packets(expectedPkts, key));
+  // same nonces in, same packets out
+  REQUIRE(fast_crypto::encrypt_packets(pkts, key));
+  REQUIRE(pkts == expectedPkts);
+  REQUIRE(fast_crypto::decrypt_packets(pkts, key) == 0);
+  // all but the keyed hash at the front, which encrypting wrote over
+  const auto& decrypted = pkts.front();
+  REQUIRE(std::equal(decrypted.begin() + HMACSIZE, decrypted.end(), data.begin() + HMACSIZE));
+}
+
+TEST_CASE("Batched aes256gcm packet crypto")
+{
+  llarp::sodium::CryptoLibSodium crypto;
+  if (not crypto.aes256gcm_available())
+    return;
+  SharedSecret key;
+  key.Randomize();
+
+  std::vector<std::vector<byte_t>> pkts;
+  for (size_t sz : {size_t{HMACSIZE + TUNNONCESIZE}, size_t{100}, size_t{1500}})
+  {
+    auto& pkt = pkts.emplace_back(sz);
+    crypto.randbytes(pkt.data(), pkt.size());
+    // distinct gcm nonces
+    pkt[HMACSIZE] = pkts.size();
+  }
+  const auto plain = pkts;
+  REQUIRE(crypto.aes256gcm_encrypt_packets(pkts, key));
+  for (size_t idx = 0; idx < pkts.size(); ++idx)
+  {
+    REQUIRE(pkts[idx].size() == plain[idx].size());
+    REQUIRE(is_aes256gcm_packet(pkts[idx]));
+  }
+  REQUIRE(pkts[2] != plain[2]);
+
+  SECTION("round trip")
+  {
+    REQUIRE(crypto.aes256gcm_decrypt_packets(pkts, key) == 0);
+    for (size_t idx = 0; idx < pkts.size(); ++idx)
+    {
+      REQUIRE(std::equal(
+          pkts[idx].begin() + HMACSIZE, pkts[idx].end(), plain[idx].begin() + HMACSIZE));
+    }
+  }
+
+  SECTION("tampering with the body or the nonce drops the packet")
+  {
+    pkts[1].back() ^= 1;
+    pkts[2][HMACSIZE + TUNNONCESIZE - 1] ^= 1;
+    REQUIRE(crypto.aes256gcm_decrypt_packets(pkts, key) == 2);
+    REQUIRE(pkts.size() == 1);
+  }
+
+  SECTION("the two packet kinds are told apart")
+  {
+    std::vector<std::vector<byte_t>> other{plain[2]};
+    REQUIRE(crypto.encrypt_packets(other, key));
+    REQUIRE_FALSE(is_aes256gcm_packet(other[0]));
+    REQUIRE(crypto.aes256gcm_decrypt_packets(other, key) == 1);
+    REQUIRE(crypto.decrypt_packets(pkts, key) == 3);
+  }
+}
+
 #ifdef HAVE_CRYPT
 
 TEST_CASE("passwd hash valid")
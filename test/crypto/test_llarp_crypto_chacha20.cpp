@@ -0,0 +1,88 @@
+#include <llarp/crypto/chacha20.hpp>
+
+#include <array>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+using namespace llarp;
+
+static std::vector<byte_t>
+keystream(chacha20::detail::Impl_t impl, size_t len, const byte_t* key, const byte_t* nonce,
+          uint64_t ic)
+{
+  std::array<uint32_t, 16> state;
+  chacha20::detail::InitState(state.data(), key, nonce, ic);
+  std::vector<byte_t> out(len);
+  impl(out.data(), out.data(), len, state.data());
+  return out;
+}
+
+TEST_CASE("chacha20 known answers", "[crypto][chacha20]")
+{
+  SECTION("all zero key and nonce")
+  {
+    const std::array<byte_t, chacha20::KeySize> key{};
+    const std::array<byte_t, chacha20::NonceSize> nonce{};
+    const std::vector<byte_t> expected{0x76, 0xb8, 0xe0, 0xad, 0xa0, 0xf1, 0x3d, 0x90,
+                                       0x40, 0x5d, 0x6a, 0xe5, 0x53, 0x86, 0xbd, 0x28};
+    auto ks = keystream(&chacha20::detail::xor_scalar, 16, key.data(), nonce.data(), 0);
+    REQUIRE(ks == expected);
+  }
+
+  SECTION("rfc 7539 block function")
+  {
+    // the rfc's variant has a 32 bit counter and 96 bit nonce; its first nonce word is our high
+    // counter word, so its counter 1 and nonce 000000090000004a00000000 are our counter
+    // 0x0900000000000001 and nonce 0000004a00000000
+    std::array<byte_t, chacha20::KeySize> key;
+    for (size_t i = 0; i < key.size(); ++i)
+      key[i] = i;
+    const std::array<byte_t, chacha20::NonceSize> nonce{0, 0, 0, 0x4a, 0, 0, 0, 0};
+    const std::vector<byte_t> expected{0x10, 0xf1, 0xe7, 0xe4, 0xd1, 0x3b, 0x59, 0x15,
+                                       0x50, 0x0f, 0xdd, 0x1f, 0xa3, 0x20, 0x71, 0xc4};
+    auto ks = keystream(
+        &chacha20::detail::xor_scalar, 16, key.data(), nonce.data(), 0x0900'0000'0000'0001);
+    REQUIRE(ks == expected);
+  }
+}
+
+TEST_CASE("chacha20 vector implementations match scalar", "[crypto][chacha20]")
+{
+  std::array<byte_t, chacha20::KeySize> key;
+  for (size_t i = 0; i < key.size(); ++i)
+    key[i] = 0xa5 ^ (i * 7);
+  const std::array<byte_t, chacha20::NonceSize> nonce{1, 2, 3, 4, 5, 6, 7, 8};
+
+  // the last counter makes lanes of the same batch straddle a carry into the high word
+  const uint64_t counters[] = {0, 1, 12345, 0xffff'fffful - 3};
+  // around each of the vector widths, and a few whole multiples of them
+  const size_t lens[] = {0, 1, 63, 64, 65, 255, 256, 257, 511, 512, 513, 1023, 1024, 1025, 3000};
+
+  for (const auto& [name, impl] : chacha20::detail::Implementations())
+  {
+    INFO(name);
+    for (const auto ic : counters)
+    {
+      for (const auto len : lens)
+      {
+        INFO("ic=" << ic << " len=" << len);
+        REQUIRE(
+            keystream(impl, len, key.data(), nonce.data(), ic)
+            == keystream(&chacha20::detail::xor_scalar, len, key.data(), nonce.data(), ic));
+      }
+    }
+  }
+
+  SECTION("xor_ic works in place and out of place")
+  {
+    std::vector<byte_t> plain(1500);
+    for (size_t i = 0; i < plain.size(); ++i)
+      plain[i] = i;
+    std::vector<byte_t> cipher(plain.size());
+    chacha20::xor_ic(cipher.data(), plain.data(), plain.size(), nonce.data(), 7, key.data());
+    REQUIRE(cipher != plain);
+    chacha20::xor_ic(cipher.data(), cipher.data(), cipher.size(), nonce.data(), 7, key.data());
+    REQUIRE(cipher == plain);
+  }
+}
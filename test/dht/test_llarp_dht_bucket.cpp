@@ -0,0 +1,133 @@
+#include <llarp/dht/bucket.hpp>
+
+#include <algorithm>
+#include <random>
+#include <catch2/catch.hpp>
+
+using llarp::dht::Bucket;
+using llarp::dht::Key_t;
+
+namespace
+{
+  struct TestNode
+  {
+    Key_t ID;
+    int version = 0;
+
+    llarp::util::StatusObject
+    ExtractStatus() const
+    {
+      return {{"version", version}};
+    }
+
+    bool
+    operator<(const TestNode& other) const
+    {
+      return version < other.version;
+    }
+  };
+
+  Key_t
+  RandomKey(std::mt19937_64& rng)
+  {
+    Key_t k;
+    for (auto& b : k)
+      b = rng();
+    return k;
+  }
+
+  /// what the closest n to target are, the slow way
+  std::vector<Key_t>
+  Closest(std::vector<Key_t> keys, const Key_t& target, size_t n)
+  {
+    std::sort(keys.begin(), keys.end(), [&target](const auto& a, const auto& b) {
+      return (a ^ target) < (b ^ target);
+    });
+    keys.resize(std::min(n, keys.size()));
+    return keys;
+  }
+}  // namespace
+
+TEST_CASE("dht Bucket finds the nearest nodes by xor", "[dht]")
+{
+  std::mt19937_64 rng{42};
+  Bucket<TestNode> bucket{Key_t{}, [&rng] { return rng(); }};
+
+  std::vector<Key_t> keys;
+  for (int i = 0; i < 1000; ++i)
+  {
+    keys.push_back(RandomKey(rng));
+    bucket.PutNode(TestNode{keys.back()});
+  }
+  // some sharing long prefixes, so that the walk goes deep
+  for (int i = 0; i < 40; ++i)
+  {
+    Key_t k = keys[i];
+    k[31] ^= (i + 1);
+    keys.push_back(k);
+    bucket.PutNode(TestNode{k});
+  }
+  REQUIRE(bucket.size() == keys.size());
+
+  for (int round = 0; round < 50; ++round)
+  {
+    // both near known keys and anywhere at all
+    Key_t target = round % 2 ? RandomKey(rng) : keys[round];
+    target[30] ^= round;
+
+    Key_t closest;
+    REQUIRE(bucket.FindClosest(target, closest));
+    REQUIRE(closest == Closest(keys, target, 1)[0]);
+
+    const auto expected = Closest(keys, target, 8);
+    std::set<Key_t> exclude{expected[0], expected[3]};
+    std::set<Key_t> result;
+    REQUIRE(bucket.GetManyNearExcluding(target, result, 6, exclude));
+    REQUIRE(result == std::set<Key_t>{expected[1], expected[2], expected[4], expected[5],
+                                      expected[6], expected[7]});
+
+    REQUIRE(bucket.FindCloseExcluding(target, closest, exclude));
+    REQUIRE(closest == expected[1]);
+  }
+
+  SECTION("asking for more than there are fails")
+  {
+    std::set<Key_t> result;
+    REQUIRE_FALSE(bucket.GetManyNearExcluding(Key_t{}, result, keys.size() + 1, {}));
+    REQUIRE(result.size() == keys.size());
+  }
+
+  SECTION("removal keeps lookups consistent")
+  {
+    bucket.RemoveIf([](const auto& k) { return k[0] < 128; });
+    keys.erase(
+        std::remove_if(keys.begin(), keys.end(), [](const auto& k) { return k[0] < 128; }),
+        keys.end());
+    bucket.DelNode(keys.back());
+    REQUIRE_FALSE(bucket.HasNode(keys.back()));
+    keys.pop_back();
+    REQUIRE(bucket.size() == keys.size());
+
+    Key_t closest;
+    REQUIRE(bucket.FindClosest(Key_t{}, closest));
+    REQUIRE(closest == Closest(keys, Key_t{}, 1)[0]);
+
+    Key_t random;
+    REQUIRE(bucket.GetRandomNodeExcluding(random, {}));
+    REQUIRE(std::find(keys.begin(), keys.end(), random) != keys.end());
+    std::set<Key_t> all{keys.begin(), keys.end()};
+    all.erase(keys[5]);
+    REQUIRE(bucket.GetRandomNodeExcluding(random, all));
+    REQUIRE(random == keys[5]);
+    all.insert(keys[5]);
+    REQUIRE_FALSE(bucket.GetRandomNodeExcluding(random, all));
+  }
+
+  SECTION("newer nodes replace older ones")
+  {
+    bucket.PutNode(TestNode{keys[0], 2});
+    bucket.PutNode(TestNode{keys[0], 1});
+    REQUIRE(bucket.GetNode(keys[0])->version == 2);
+    REQUIRE(bucket.size() == keys.size());
+  }
+}
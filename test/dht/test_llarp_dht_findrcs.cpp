@@ -0,0 +1,58 @@
+#include <llarp/dht/messages/findrcs.hpp>
+#include <llarp/util/bencode.hpp>
+
+#include <array>
+#include <catch2/catch.hpp>
+
+using llarp::dht::FindRCsMessage;
+
+TEST_CASE("FindRCsMessage round trip", "[dht]")
+{
+  llarp::RouterID a, b;
+  a.Randomize();
+  b.Randomize();
+
+  SECTION("for given routers")
+  {
+    const FindRCsMessage msg{42, {a, b}, 1234ms};
+    std::array<byte_t, 1024> tmp;
+    llarp_buffer_t buf{tmp};
+    REQUIRE(bencode_start_list(&buf));
+    REQUIRE(msg.BEncode(&buf));
+    REQUIRE(bencode_end(&buf));
+    buf.sz = buf.cur - buf.base;
+    buf.cur = buf.base;
+
+    std::vector<llarp::dht::IMessage::Ptr_t> decoded;
+    REQUIRE(llarp::dht::DecodeMesssageList(llarp::dht::Key_t{}, &buf, decoded));
+    REQUIRE(decoded.size() == 1);
+    const auto* got = dynamic_cast<const FindRCsMessage*>(decoded[0].get());
+    REQUIRE(got);
+    REQUIRE(got->txid == 42);
+    REQUIRE(got->since == 1234ms);
+    REQUIRE(got->routers == std::vector<llarp::RouterID>{a, b});
+  }
+
+  SECTION("for everything, but not relayed")
+  {
+    const FindRCsMessage msg{7, {}, 0s};
+    std::array<byte_t, 1024> tmp;
+    llarp_buffer_t buf{tmp};
+    REQUIRE(bencode_start_list(&buf));
+    REQUIRE(msg.BEncode(&buf));
+    REQUIRE(bencode_end(&buf));
+    buf.sz = buf.cur - buf.base;
+
+    buf.cur = buf.base;
+    std::vector<llarp::dht::IMessage::Ptr_t> decoded;
+    REQUIRE(llarp::dht::DecodeMesssageList(llarp::dht::Key_t{}, &buf, decoded));
+    REQUIRE(decoded.size() == 1);
+    const auto* got = dynamic_cast<const FindRCsMessage*>(decoded[0].get());
+    REQUIRE(got);
+    REQUIRE(got->routers.empty());
+
+    buf.cur = buf.base;
+    decoded.clear();
+    REQUIRE_FALSE(llarp::dht::DecodeMesssageList(llarp::dht::Key_t{}, &buf, decoded, true));
+  }
+}
@@ -0,0 +1,175 @@
+#include <llarp/dht/introset_store.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::dht::IntroSetStore;
+using llarp::dht::Key_t;
+using llarp::service::EncryptedIntroSet;
+
+namespace
+{
+  EncryptedIntroSet
+  MakeIntroSet(uint8_t id, llarp_time_t signedAt, size_t payload = 100)
+  {
+    EncryptedIntroSet introset;
+    introset.derivedSigningKey[0] = id;
+    introset.signedAt = signedAt;
+    introset.introsetPayload.resize(payload);
+    return introset;
+  }
+
+  Key_t
+  Location(uint8_t id)
+  {
+    return Key_t{MakeIntroSet(id, 0s).derivedSigningKey.as_array()};
+  }
+
+  /// the peer or path an introset came from
+  Key_t
+  Source(uint8_t id)
+  {
+    Key_t source;
+    source[0] = id;
+    return source;
+  }
+}  // namespace
+
+TEST_CASE("IntroSetStore keeps the newest introset for a location", "[dht]")
+{
+  IntroSetStore store{0};
+  const llarp_time_t now = 1h;
+  store.Put(MakeIntroSet(1, now), Source(0));
+  store.Put(MakeIntroSet(1, now - 1s), Source(0));
+  REQUIRE(store.Get(Location(1), now)->signedAt == now);
+  store.Put(MakeIntroSet(1, now + 1s), Source(0));
+  REQUIRE(store.Get(Location(1), now)->signedAt == now + 1s);
+  REQUIRE(store.size() == 1);
+
+  REQUIRE_FALSE(store.Get(Location(2), now));
+  const auto status = store.ExtractStatus();
+  REQUIRE(status["hits"] == 2);
+  REQUIRE(status["misses"] == 1);
+}
+
+TEST_CASE("IntroSetStore knows the introsets it holds to the byte", "[dht]")
+{
+  IntroSetStore store{0};
+  const llarp_time_t now = 1h;
+  const auto introset = MakeIntroSet(1, now);
+  REQUIRE_FALSE(store.Holds(introset));
+  store.Put(introset, Source(0));
+  REQUIRE(store.Holds(introset));
+
+  auto changed = introset;
+  changed.introsetPayload[0] ^= 1;
+  REQUIRE_FALSE(store.Holds(changed));
+  changed = introset;
+  changed.topic = llarp::service::Tag{"changed"};
+  REQUIRE_FALSE(store.Holds(changed));
+  REQUIRE_FALSE(store.Holds(MakeIntroSet(1, now + 1s)));
+  REQUIRE_FALSE(store.Holds(MakeIntroSet(2, now)));
+}
+
+TEST_CASE("IntroSetStore holds expired introsets until they decay", "[dht]")
+{
+  IntroSetStore store{0};
+  const llarp_time_t now = 1h;
+  const auto introset = MakeIntroSet(1, now);
+  store.Put(introset, Source(0));
+
+  // a replay of it once expired still matches, so the publish handler checks expiry itself
+  const auto later = now + llarp::path::default_lifetime + 1s;
+  REQUIRE(introset.IsExpired(later));
+  REQUIRE(store.Holds(introset));
+  REQUIRE_FALSE(store.Get(Location(1), later));
+  store.Expire(later);
+  REQUIRE_FALSE(store.Holds(introset));
+}
+
+TEST_CASE("IntroSetStore expires and evicts", "[dht]")
+{
+  const llarp_time_t now = 1h;
+  IntroSetStore measure{0};
+  measure.Put(MakeIntroSet(0, now), Source(0));
+  // room for three
+  IntroSetStore store{3 * measure.Bytes()};
+  for (uint8_t id = 1; id <= 3; ++id)
+    store.Put(MakeIntroSet(id, now + std::chrono::seconds{id}), Source(id));
+  REQUIRE(store.size() == 3);
+
+  // using the first makes the second the one to go
+  REQUIRE(store.Get(Location(1), now));
+  store.Put(MakeIntroSet(4, now), Source(4));
+  REQUIRE(store.size() == 3);
+  REQUIRE_FALSE(store.Get(Location(2), now));
+  REQUIRE(store.Get(Location(1), now));
+  REQUIRE(store.ExtractStatus()["evictions"] == 1);
+
+  // expiry goes by when they were signed, not by use
+  store.Expire(now + llarp::path::default_lifetime + 500ms);
+  REQUIRE(store.size() == 2);
+  REQUIRE_FALSE(store.Get(Location(4), now));
+  store.Expire(now + llarp::path::default_lifetime + 1h);
+  REQUIRE(store.size() == 0);
+  REQUIRE(store.Bytes() == 0);
+
+  // too big to ever fit
+  store.Put(MakeIntroSet(5, now, 1'000'000), Source(5));
+  REQUIRE(store.size() == 0);
+}
+
+TEST_CASE("IntroSetStore does not let one source push out the rest", "[dht]")
+{
+  const llarp_time_t now = 1h;
+  IntroSetStore measure{0};
+  measure.Put(MakeIntroSet(0, now), Source(0));
+  // room for 32, so a source's share is two
+  IntroSetStore store{32 * measure.Bytes()};
+  store.Put(MakeIntroSet(1, now), Source(1));
+
+  // one source may fill what is free
+  for (uint8_t id = 2; id <= 32; ++id)
+    store.Put(MakeIntroSet(id, now), Source(2));
+  REQUIRE(store.size() == 32);
+
+  // but not evict for more once over its share
+  store.Put(MakeIntroSet(33, now), Source(2));
+  REQUIRE(store.size() == 32);
+  REQUIRE_FALSE(store.Get(Location(33), now));
+  REQUIRE(store.Get(Location(1), now));
+  REQUIRE(store.ExtractStatus()["refused"] == 1);
+
+  // while another source still gets in, pushing out the least recently used
+  store.Put(MakeIntroSet(34, now), Source(3));
+  REQUIRE(store.size() == 32);
+  REQUIRE(store.Get(Location(34), now));
+  REQUIRE_FALSE(store.Get(Location(2), now));
+  REQUIRE(store.Get(Location(1), now));
+  REQUIRE(store.ExtractStatus()["evictions"] == 1);
+}
+
+TEST_CASE("IntroSetStore sheds for the service memory limit", "[dht]")
+{
+  using llarp::util::MemAccount;
+  using llarp::util::MemTag;
+
+  const llarp_time_t now = 1h;
+  const auto before = MemAccount::Live(MemTag::Service);
+  {
+    IntroSetStore store{0};
+    for (uint8_t id = 1; id <= 4; ++id)
+      store.Put(MakeIntroSet(id, now), Source(id));
+    REQUIRE(MemAccount::Live(MemTag::Service) == before + store.Bytes());
+    const auto each = store.Bytes() / 4;
+
+    // over by a bit more than one takes the two least recently used
+    REQUIRE(store.Get(Location(1), now));
+    MemAccount::SetSoftLimit(MemTag::Service, before + 2 * each - 1);
+    MemAccount::Tick(now);
+    MemAccount::SetSoftLimit(MemTag::Service, 0);
+    REQUIRE(store.size() == 1);
+    REQUIRE(store.Get(Location(1), now));
+    REQUIRE(MemAccount::Live(MemTag::Service) == before + each);
+  }
+  REQUIRE(MemAccount::Live(MemTag::Service) == before);
+}
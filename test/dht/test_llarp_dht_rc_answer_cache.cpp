@@ -0,0 +1,76 @@
+#include <llarp/dht/rc_answer_cache.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::RouterContact;
+using llarp::RouterID;
+using llarp::dht::RCAnswerCache;
+
+namespace
+{
+  RouterContact
+  MakeRC(uint8_t id, llarp_time_t updated)
+  {
+    RouterContact rc;
+    rc.pubkey[0] = id;
+    rc.last_updated = updated;
+    return rc;
+  }
+
+  RouterID
+  ID(uint8_t id)
+  {
+    return RouterID{MakeRC(id, 0s).pubkey};
+  }
+}  // namespace
+
+TEST_CASE("RCAnswerCache answers with the rc as a GotRouterMessage list", "[dht]")
+{
+  RCAnswerCache cache;
+  const llarp_time_t now = 1h;
+  const auto rc = MakeRC(1, now);
+  const auto answer = cache.Put(rc, now);
+  REQUIRE(answer);
+
+  std::array<byte_t, MAX_RC_SIZE> tmp;
+  llarp_buffer_t buf{tmp};
+  REQUIRE(rc.BEncode(&buf));
+  const std::string encoded{reinterpret_cast<const char*>(tmp.data()), buf.cur - buf.base};
+  REQUIRE(*answer == "l" + encoded + "e");
+
+  REQUIRE(cache.Get(ID(1), now + 1s) == answer);
+  REQUIRE_FALSE(cache.Get(ID(2), now));
+}
+
+TEST_CASE("RCAnswerCache forgets answers", "[dht]")
+{
+  RCAnswerCache cache;
+  const llarp_time_t now = 1h;
+
+  SECTION("when the rc changes")
+  {
+    cache.Put(MakeRC(1, now), now);
+    cache.Invalidate(ID(1));
+    REQUIRE_FALSE(cache.Get(ID(1), now));
+  }
+
+  SECTION("after their ttl")
+  {
+    cache.Put(MakeRC(1, now), now);
+    REQUIRE(cache.Get(ID(1), now + RCAnswerCache::TTL - 1s));
+    REQUIRE_FALSE(cache.Get(ID(1), now + RCAnswerCache::TTL));
+    cache.Decay(now + RCAnswerCache::TTL);
+    REQUIRE(cache.Size() == 0);
+  }
+
+  SECTION("before the rc expires soon")
+  {
+    // 70s from expiring, which is 10s from too close to give out
+    cache.Put(MakeRC(1, now - RouterContact::Lifetime + 70s), now);
+    REQUIRE(cache.Get(ID(1), now + 9s));
+    REQUIRE_FALSE(cache.Get(ID(1), now + 10s));
+    // already too close, so answered with but not kept
+    REQUIRE(cache.Put(MakeRC(2, now - RouterContact::Lifetime), now));
+    REQUIRE_FALSE(cache.Get(ID(2), now));
+  }
+}
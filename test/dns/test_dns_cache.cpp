@@ -0,0 +1,249 @@
+#include <llarp/dns/cache.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <oxenc/endian.h>
+
+using namespace std::literals;
+using llarp::byte_t;
+using llarp::dns::AnswerCache;
+
+namespace
+{
+  constexpr uint16_t A = 1;
+  constexpr uint16_t AAAA = 28;
+  constexpr uint8_t NOERROR = 0, SERVFAIL = 2, NXDOMAIN = 3;
+
+  llarp::dns::Message
+  Query(std::string name, uint16_t type = A, uint16_t id = 0x1234)
+  {
+    llarp::dns::Message msg{llarp::dns::Question{std::move(name), type}};
+    msg.hdr_id = id;
+    return msg;
+  }
+
+  /// builds an upstream reply by hand, the way it would come in over the wire
+  struct Reply
+  {
+    std::vector<byte_t> wire;
+    uint16_t an = 0, ns = 0, ar = 0;
+
+    explicit Reply(std::string_view name, uint8_t rcode = NOERROR, bool truncated = false)
+    {
+      wire = {0xab, 0xcd, byte_t(0x81 | (truncated ? 0x02 : 0)), byte_t(0x80 | rcode)};
+      wire.resize(llarp::dns::MessageHeader::Size);
+      oxenc::write_host_as_big<uint16_t>(1, wire.data() + 4);
+      while (not name.empty())
+      {
+        auto label = name.substr(0, name.find('.'));
+        wire.push_back(label.size());
+        wire.insert(wire.end(), label.begin(), label.end());
+        name.remove_prefix(std::min(name.size(), label.size() + 1));
+      }
+      wire.push_back(0);
+      Put<uint16_t>(A);
+      Put<uint16_t>(1);
+    }
+
+    template <typename T>
+    void
+    Put(T val)
+    {
+      wire.resize(wire.size() + sizeof(T));
+      oxenc::write_host_as_big(val, wire.data() + wire.size() - sizeof(T));
+    }
+
+    /// the record header, naming the question
+    void
+    Record(uint16_t type, uint32_t ttl, uint16_t rdlen)
+    {
+      Put<uint16_t>(0xc00c);
+      Put(type);
+      Put<uint16_t>(1);
+      Put(ttl);
+      Put(rdlen);
+    }
+
+    Reply&&
+    Answer(uint32_t ttl)
+    {
+      Record(A, ttl, 4);
+      Put<uint32_t>(0x0a000001);
+      ++an;
+      return std::move(*this);
+    }
+
+    Reply&&
+    SOA(uint32_t ttl, uint32_t minimum)
+    {
+      Record(6, ttl, 24);
+      Put<uint16_t>(0xc00c);
+      Put<uint16_t>(0xc00c);
+      for (uint32_t val : {1u, 7200u, 900u, 1209600u})
+        Put(val);
+      Put(minimum);
+      ++ns;
+      return std::move(*this);
+    }
+
+    Reply&&
+    EDNS()
+    {
+      wire.push_back(0);
+      Put<uint16_t>(41);
+      Put<uint16_t>(1232);
+      Put<uint32_t>(0x8000);
+      Put<uint16_t>(0);
+      ++ar;
+      return std::move(*this);
+    }
+
+    std::vector<byte_t>
+    Done()
+    {
+      oxenc::write_host_as_big(an, wire.data() + 6);
+      oxenc::write_host_as_big(ns, wire.data() + 8);
+      oxenc::write_host_as_big(ar, wire.data() + 10);
+      return std::move(wire);
+    }
+  };
+
+  void
+  Put(AnswerCache& cache,
+      const llarp::dns::Message& query,
+      const std::vector<byte_t>& reply,
+      llarp_time_t now)
+  {
+    cache.Put(query, reply.data(), reply.size(), now);
+  }
+
+  uint32_t
+  TTLAt(const llarp::OwnedBuffer& buf, size_t pos)
+  {
+    return oxenc::load_big_to_host<uint32_t>(buf.buf.get() + pos);
+  }
+}  // namespace
+
+TEST_CASE("cached answers get the asker's id and spelling and ttls counted down", "[dns][cache]")
+{
+  AnswerCache cache;
+  const auto reply = Reply{"example.com."}.Answer(300).Answer(60).EDNS().Done();
+  Put(cache, Query("example.com."), reply, 1000s);
+  REQUIRE(cache.Size() == 1);
+
+  auto got = cache.Get(Query("EXAMPLE.com.", A, 0x4242), 1010s);
+  REQUIRE(got);
+  REQUIRE(got->sz == reply.size());
+  REQUIRE(oxenc::load_big_to_host<uint16_t>(got->buf.get()) == 0x4242);
+  // the first ttl is right after the question and the name pointer, type and class
+  const size_t first = llarp::dns::MessageHeader::Size + 13 + 4 + 6;
+  const size_t second = first + 16;
+  // no record outlives the answer it is in
+  REQUIRE(TTLAt(*got, first) == 50);
+  REQUIRE(TTLAt(*got, second) == 50);
+  // the edns flags are left alone
+  REQUIRE(TTLAt(*got, reply.size() - 6) == 0x8000);
+  // the question is spelled as asked, and the rest is as upstream sent it
+  REQUIRE(std::equal(reply.begin() + 2, reply.begin() + 12, got->buf.get() + 2));
+  REQUIRE(std::string_view{reinterpret_cast<const char*>(got->buf.get()) + 13, 7} == "EXAMPLE");
+  REQUIRE(std::equal(reply.begin() + 20, reply.begin() + first, got->buf.get() + 20));
+
+  REQUIRE(TTLAt(*cache.Get(Query("example.com."), 1059s), first) == 1);
+  REQUIRE_FALSE(cache.Get(Query("example.com.", AAAA), 1010s));
+  REQUIRE_FALSE(cache.Get(Query("example.com."), 1060s));
+}
+
+TEST_CASE("denials are cached for as long as their soa says", "[dns][cache]")
+{
+  AnswerCache::Config conf;
+  conf.maxStale = 0s;
+  AnswerCache cache{conf};
+
+  const auto denial = Reply{"nope.example.", NXDOMAIN}.SOA(3600, 120).Done();
+  Put(cache, Query("nope.example."), denial, 0s);
+  REQUIRE(cache.Get(Query("nope.example."), 119s));
+  REQUIRE_FALSE(cache.Get(Query("nope.example."), 120s));
+  REQUIRE(cache.Size() == 0);
+
+  // no answer is a denial too, and the soa's own ttl counts if lower
+  Put(cache, Query("empty.example."), Reply{"empty.example."}.SOA(30, 120).Done(), 0s);
+  REQUIRE(cache.Get(Query("empty.example."), 29s));
+  REQUIRE_FALSE(cache.Get(Query("empty.example."), 30s));
+
+  // but only as long as we allow
+  const auto long_denial = Reply{"long.example.", NXDOMAIN}.SOA(1 << 20, 1 << 20).Done();
+  Put(cache, Query("long.example."), long_denial, 0s);
+  REQUIRE(cache.Get(Query("long.example."), conf.maxNegativeTTL - 1s));
+  REQUIRE_FALSE(cache.Get(Query("long.example."), conf.maxNegativeTTL));
+
+  // and without an soa we can't say how long
+  Put(cache, Query("bare.example."), Reply{"bare.example.", NXDOMAIN}.Done(), 0s);
+  REQUIRE_FALSE(cache.Get(Query("bare.example."), 0s));
+}
+
+TEST_CASE("expired answers are served stale for a while", "[dns][cache]")
+{
+  AnswerCache::Config conf;
+  conf.maxStale = 1h;
+  AnswerCache cache{conf};
+  Put(cache, Query("stale.example."), Reply{"stale.example."}.Answer(60).Done(), 0s);
+
+  REQUIRE_FALSE(cache.Get(Query("stale.example."), 2min));
+  auto stale = cache.GetStale(Query("stale.example.", A, 7), 2min);
+  REQUIRE(stale);
+  REQUIRE(oxenc::load_big_to_host<uint16_t>(stale->buf.get()) == 7);
+  REQUIRE(TTLAt(*stale, stale->sz - 10) == AnswerCache::StaleTTL);
+
+  REQUIRE_FALSE(cache.GetStale(Query("stale.example."), 61min));
+  REQUIRE(cache.Size() == 0);
+}
+
+TEST_CASE("the cache drops the least recently used past its memory cap", "[dns][cache]")
+{
+  const auto reply = [](std::string name) { return Reply{name}.Answer(300).Done(); };
+  size_t each;
+  {
+    AnswerCache measure;
+    Put(measure, Query("a.example."), reply("a.example."), 0s);
+    each = measure.Bytes();
+  }
+  AnswerCache::Config conf;
+  conf.maxBytes = 2 * each;
+  AnswerCache cache{conf};
+
+  Put(cache, Query("a.example."), reply("a.example."), 0s);
+  Put(cache, Query("b.example."), reply("b.example."), 0s);
+  REQUIRE(cache.Get(Query("a.example."), 1s));
+  Put(cache, Query("c.example."), reply("c.example."), 2s);
+
+  REQUIRE(cache.Size() == 2);
+  REQUIRE(cache.Bytes() <= conf.maxBytes);
+  REQUIRE(cache.Get(Query("a.example."), 3s));
+  REQUIRE_FALSE(cache.Get(Query("b.example."), 3s));
+  REQUIRE(cache.Get(Query("c.example."), 3s));
+
+  // putting the same question again replaces its answer
+  Put(cache, Query("c.example."), reply("c.example."), 3s);
+  REQUIRE(cache.Size() == 2);
+  REQUIRE(cache.Bytes() == 2 * each);
+}
+
+TEST_CASE("the cache only keeps whole, good answers", "[dns][cache]")
+{
+  AnswerCache cache;
+  const auto query = Query("bad.example.");
+
+  Put(cache, query, Reply{"bad.example.", SERVFAIL}.SOA(300, 300).Done(), 0s);
+  Put(cache, query, Reply{"bad.example.", NOERROR, true}.Answer(300).Done(), 0s);
+  Put(cache, query, Reply{"bad.example."}.Answer(0).Done(), 0s);
+  auto cut = Reply{"bad.example."}.Answer(300).Done();
+  cut.pop_back();
+  Put(cache, query, cut, 0s);
+  REQUIRE(cache.Size() == 0);
+
+  AnswerCache::Config conf;
+  conf.maxBytes = 0;
+  AnswerCache off{conf};
+  Put(off, query, Reply{"bad.example."}.Answer(300).Done(), 0s);
+  REQUIRE(off.Size() == 0);
+}
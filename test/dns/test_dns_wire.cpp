@@ -0,0 +1,133 @@
+#include <llarp/dns/wire.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <oxenc/endian.h>
+
+using llarp::byte_t;
+using llarp::dns::MessageView;
+using llarp::dns::MessageWriter;
+using llarp::dns::NameView;
+
+namespace
+{
+  /// a query as it comes in, for A of www.Example.com.
+  const std::vector<byte_t> query{
+      0x12, 0x34, 0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  //
+      3,    'w',  'w',  'w',  7,    'E',  'x',  'a',  'm',  'p',  'l',  'e',   //
+      3,    'c',  'o',  'm',  0,    0x00, 0x01, 0x00, 0x01};
+}  // namespace
+
+TEST_CASE("queries are read in place", "[dns][wire]")
+{
+  auto msg = MessageView::Parse(query.data(), query.size());
+  REQUIRE(msg);
+  REQUIRE(msg->hdr_id == 0x1234);
+  REQUIRE(msg->hdr_fields == 0x0100);
+  REQUIRE(msg->qd_count == 1);
+  const auto& q = msg->questions[0];
+  REQUIRE(q.qtype == 1);
+  REQUIRE(q.qclass == 1);
+  REQUIRE(q.qname.Equals("www.example.com."));
+  REQUIRE(q.qname.Equals("WWW.EXAMPLE.COM"));
+  REQUIRE_FALSE(q.qname.Equals("ww.example.com"));
+  REQUIRE_FALSE(q.qname.Equals("www.example.co"));
+  REQUIRE_FALSE(q.qname.Equals("example.com"));
+  REQUIRE(q.qname.HasTLD(".com"));
+  REQUIRE_FALSE(q.qname.HasTLD(".loki"));
+  REQUIRE(q.qname.ToString() == "www.Example.com.");
+
+  // cut short anywhere it is no message at all
+  for (size_t sz = 0; sz < query.size(); ++sz)
+    REQUIRE_FALSE(MessageView::Parse(query.data(), sz));
+}
+
+TEST_CASE("names follow pointers back but never forward", "[dns][wire]")
+{
+  // example.com. at 0, then www pointing back at it, then a pointer to itself, then one ahead
+  std::vector<byte_t> buf{7, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 3, 'c', 'o', 'm', 0};
+  buf.insert(buf.end(), {3, 'w', 'w', 'w', 0xc0, 0x00});
+  buf.insert(buf.end(), {0xc0, 19});
+  buf.insert(buf.end(), {0xc0, 23, 1, 'x', 0});
+
+  size_t pos = 13;
+  auto name = NameView::Read(buf.data(), buf.size(), pos);
+  REQUIRE(name);
+  REQUIRE(pos == 19);
+  REQUIRE(name->Equals("www.example.com"));
+
+  REQUIRE_FALSE(NameView::Read(buf.data(), buf.size(), pos));
+  pos = 21;
+  REQUIRE_FALSE(NameView::Read(buf.data(), buf.size(), pos));
+
+  // nor run past the end, nor past 255 bytes
+  std::vector<byte_t> overlong;
+  for (int i = 0; i < 5; ++i)
+  {
+    overlong.push_back(63);
+    overlong.insert(overlong.end(), 63, 'a');
+  }
+  overlong.push_back(0);
+  pos = 0;
+  REQUIRE_FALSE(NameView::Read(overlong.data(), overlong.size(), pos));
+  pos = 0;
+  REQUIRE_FALSE(NameView::Read(buf.data(), 5, pos));
+}
+
+TEST_CASE("replies are written with names pointing back", "[dns][wire]")
+{
+  const auto msg = MessageView::Parse(query.data(), query.size());
+  REQUIRE(msg);
+  std::array<byte_t, 512> out;
+  MessageWriter writer{out.data(), out.size()};
+  writer.Header(msg->hdr_id, 0x8180);
+  writer.Question(msg->questions[0]);
+  const std::array<byte_t, 4> addr{10, 0, 0, 1};
+  writer.Answer("www.example.com.", 1, 1, 300, addr.data(), addr.size());
+  writer.Answer("mail.example.com", 1, 1, 300, addr.data(), addr.size());
+  REQUIRE(writer.Ok());
+
+  // the question as it came, then an answer that is all pointer and one that points at the end
+  // of the question's name
+  const size_t answers = query.size();
+  REQUIRE(writer.Size() == answers + (2 + 14) + (5 + 2 + 14));
+  REQUIRE(std::equal(query.begin() + 12, query.end(), out.begin() + 12));
+  REQUIRE(oxenc::load_big_to_host<uint16_t>(out.data() + 4) == 1);
+  REQUIRE(oxenc::load_big_to_host<uint16_t>(out.data() + 6) == 2);
+  REQUIRE(oxenc::load_big_to_host<uint16_t>(out.data() + answers) == 0xc00c);
+  REQUIRE(out[answers + 16] == 4);
+  REQUIRE(oxenc::load_big_to_host<uint16_t>(out.data() + answers + 21) == 0xc010);
+
+  size_t pos = answers + 16;
+  auto name = NameView::Read(out.data(), writer.Size(), pos);
+  REQUIRE(name);
+  REQUIRE(name->ToString() == "mail.Example.com.");
+
+  // what doesn't fit isn't written
+  MessageWriter small{out.data(), 20};
+  small.Header(1, 0);
+  small.Question("www.example.com", 1, 1);
+  REQUIRE_FALSE(small.Ok());
+  REQUIRE(small.Size() == 12);
+  MessageWriter bad{out.data(), out.size()};
+  bad.Header(1, 0);
+  bad.Question("www..example.com", 1, 1);
+  REQUIRE_FALSE(bad.Ok());
+}
+
+TEST_CASE("replies are made over for queries asking the same", "[dns][wire]")
+{
+  llarp::dns::Message other{llarp::dns::Question{"wWw.exAMPLE.Com.", 1}};
+  other.hdr_id = 0x4321;
+  auto reply = query;
+  llarp::dns::ReplyAs(other, reply.data(), reply.size());
+  REQUIRE(oxenc::load_big_to_host<uint16_t>(reply.data()) == 0x4321);
+  size_t pos = 12;
+  REQUIRE(NameView::Read(reply.data(), reply.size(), pos)->ToString() == "wWw.exAMPLE.Com.");
+
+  // a different name is left as it was
+  other.questions[0].qname = "www.example.org.";
+  reply = query;
+  llarp::dns::ReplyAs(other, reply.data(), reply.size());
+  REQUIRE(std::equal(query.begin() + 2, query.end(), reply.begin() + 2));
+}
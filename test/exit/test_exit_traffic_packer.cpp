@@ -0,0 +1,89 @@
+#include <llarp/exit/traffic_packer.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::exit::TrafficPacker;
+using llarp::routing::TransferTrafficMessage;
+
+namespace
+{
+  bool
+  Put(TrafficPacker& packer, size_t sz, llarp_time_t now, uint64_t counter = 0)
+  {
+    std::vector<byte_t> pkt(sz, 0x42);
+    return packer.Put(
+        llarp_buffer_t{pkt},
+        counter,
+        llarp::service::ProtocolType::TrafficV4,
+        llarp::net::TrafficClass::Bulk,
+        now);
+  }
+}  // namespace
+
+TEST_CASE("TrafficPacker", "[exit]")
+{
+  TrafficPacker packer{llarp::routing::ExitUpstreamPackSize};
+  std::vector<size_t> sent;
+  const TrafficPacker::Send_t send = [&sent](TransferTrafficMessage& msg) {
+    REQUIRE(msg.version == llarp::constants::proto_version);
+    sent.push_back(msg.Packets());
+  };
+  const auto now = 10s;
+
+  SECTION("Packets of a size go in one message")
+  {
+    for (uint64_t i = 0; i < 10; ++i)
+      REQUIRE(Put(packer, 100, now, i));
+    REQUIRE(packer.Flush(now, send, true) == 1);
+    REQUIRE(sent == std::vector<size_t>{10});
+    REQUIRE_FALSE(packer.Holding());
+  }
+
+  SECTION("Full messages go while the last one waits for more")
+  {
+    // seven fill a message, so the eighth opens the next
+    for (uint64_t i = 0; i < 8; ++i)
+      REQUIRE(Put(packer, 400, now, i));
+    REQUIRE(packer.Flush(now, send) == 1);
+    REQUIRE(packer.Holding());
+    // nothing more came for it
+    REQUIRE(packer.Flush(now, send) == 1);
+    REQUIRE(sent == std::vector<size_t>{7, 1});
+    REQUIRE_FALSE(packer.Holding());
+  }
+
+  SECTION("A message waits no longer than the bound")
+  {
+    REQUIRE(Put(packer, 100, now));
+    REQUIRE(packer.Flush(now, send) == 0);
+    REQUIRE(Put(packer, 100, now + 1ms));
+    REQUIRE(packer.Flush(now + 1ms, send) == 0);
+    REQUIRE(Put(packer, 100, now + llarp::exit::MaxPackDelay));
+    REQUIRE(packer.Flush(now + llarp::exit::MaxPackDelay, send) == 1);
+    REQUIRE(sent == std::vector<size_t>{3});
+  }
+
+  SECTION("Sent messages are reused, memory and all")
+  {
+    REQUIRE(Put(packer, 1000, now));
+    packer.Flush(now, send, true);
+    const auto buffered = packer.BufferBytes();
+    REQUIRE(buffered >= 1000);
+    REQUIRE(packer.QueuedBytes() == 0);
+    REQUIRE(Put(packer, 1000, now));
+    REQUIRE(packer.BufferBytes() == buffered);
+    REQUIRE(packer.QueuedBytes() > 1000);
+  }
+
+  SECTION("A session holds only so much")
+  {
+    size_t put = 0;
+    while (Put(packer, llarp::routing::MaxExitMTU, now))
+      ++put;
+    REQUIRE(put > 0);
+    REQUIRE(packer.QueuedBytes() <= TrafficPacker::MaxQueuedBytes);
+    packer.Clear();
+    REQUIRE_FALSE(packer.Holding());
+    REQUIRE(Put(packer, llarp::routing::MaxExitMTU, now));
+  }
+}
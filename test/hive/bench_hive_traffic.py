@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+hive throughput benchmark: runs a hive of relays, clients and services, has every client send
+a steady stream of packets to a service that echoes them back, and reports what the hive got
+through and what it cost, as json for tracking across releases:
+
+  throughput            packets and bytes echoed back a second, across all clients
+  rtt, per hop latency  round trip times, and those split evenly over the link hops a round
+                        trip takes (two paths of --hops relays, plus the hop between them, there
+                        and back)
+  cpu per relayed byte  process cpu time over the bytes the relays moved on transit hops
+  memory per transit    path memory lokinet accounts for, and the whole process' resident set,
+                        over the transit hops the relays held at the end
+
+every router shares the one process (and python's gil), so the numbers are for comparing one
+build against another on the same machine, not for what a network of real routers would do.
+exit traffic needs a tun device and root, which a hive does not have, so exits are left out.
+
+    ./bench_hive_traffic.py --relays 30 --clients 10 --services 2 --rate 50 --duration 60 \\
+        --output hive-bench.json
+"""
+import hive
+import pyllarp
+import json
+import struct
+import threading
+from os import sysconf
+from time import sleep, time, monotonic_ns, process_time
+from argparse import ArgumentParser as ap
+
+
+# what we put at the front of each packet: the sequence number and when it was sent
+header = struct.Struct("!QQ")
+
+
+def percentile(values, q):
+  if not values:
+    return 0
+  values = sorted(values)
+  return values[min(len(values) - 1, int(q * len(values)))]
+
+
+def summary(values):
+  return {
+    "n": len(values),
+    "p50": percentile(values, 0.5),
+    "p90": percentile(values, 0.9),
+    "p99": percentile(values, 0.99),
+    "max": max(values) if values else 0,
+  }
+
+
+def resident_bytes():
+  try:
+    with open("/proc/self/statm") as f:
+      return int(f.read().split()[1]) * sysconf("SC_PAGE_SIZE")
+  except OSError:
+    return 0
+
+
+def relayed_bytes(metrics):
+  return (metrics.get("lokinet_path_relayed_upstream_bytes_total", 0)
+          + metrics.get("lokinet_path_relayed_downstream_bytes_total", 0))
+
+
+class Traffic(object):
+  """the endpoints we send from and echo on, and what came back"""
+
+  def __init__(self):
+    self.lock = threading.Lock()
+    self.sent = 0
+    self.received = 0
+    self.received_bytes = 0
+    self.rtts = []
+    self.measuring = False
+    self.services = []
+    self.clients = []
+
+  def AddService(self, ctx, index):
+    ep = pyllarp.Endpoint("bench-service-{}".format(index), ctx)
+
+    # packets come up as pyllarp.Bytes, which we read and send back in place
+    def echo(addr, pkt, proto):
+      ep.SendBytes(addr, pkt)
+
+    ep.GotPacket = echo
+    ctx.CallSafe(lambda: ctx.AddEndpoint(ep))
+    self.services.append(ep)
+
+  def AddClient(self, ctx, index):
+    ep = pyllarp.Endpoint("bench-client-{}".format(index), ctx)
+
+    def got(addr, pkt, proto):
+      now = monotonic_ns()
+      _, sent_at = header.unpack_from(pkt)
+      with self.lock:
+        if self.measuring:
+          self.received += 1
+          self.received_bytes += len(pkt)
+          self.rtts.append((now - sent_at) / 1e6)
+
+    ep.GotPacket = got
+    ctx.CallSafe(lambda: ctx.AddEndpoint(ep))
+    self.clients.append(ep)
+
+  def SendRound(self, size):
+    targets = [pyllarp.ServiceAddress(ep.OurAddress()) for ep in self.services]
+    for idx, ep in enumerate(self.clients):
+      pkt = header.pack(self.sent, monotonic_ns())
+      pkt += bytes(max(0, size - len(pkt)))
+      ep.SendBytes(targets[idx % len(targets)], pkt)
+      with self.lock:
+        self.sent += 1
+
+
+def main(args):
+  h = hive.RouterHive(args.relays, args.clients + args.services, shutup=not args.verbose)
+  h.Start()
+
+  traffic = Traffic()
+  contexts = []
+  h.hive.ForEachClient(lambda ctx: contexts.append(ctx))
+  for idx, ctx in enumerate(contexts):
+    if idx < args.services:
+      traffic.AddService(ctx, idx)
+    else:
+      traffic.AddClient(ctx, idx)
+
+  print("letting the hive settle for {}s".format(args.warmup))
+  end_warmup = time() + args.warmup
+  while time() < end_warmup:
+    # endpoints are added on their router's thread, so give them a moment before we send; and
+    # warm up the convos too, so we measure sending on them rather than setting them up
+    sleep(1)
+    traffic.SendRound(args.size)
+    h.DrainEvents()
+
+  with traffic.lock:
+    traffic.sent = 0
+    traffic.measuring = True
+  metrics_start = json.loads(pyllarp.Metrics())
+  cpu_start = process_time()
+  start = time()
+  next_round = start
+  while time() < start + args.duration:
+    if time() >= next_round:
+      traffic.SendRound(args.size)
+      next_round += 1.0 / args.rate
+    h.DrainEvents()
+    sleep(min(0.01, max(0, next_round - time())))
+  elapsed = time() - start
+  cpu = process_time() - cpu_start
+  # give what is in flight a moment to come back before we stop counting
+  sleep(2)
+  with traffic.lock:
+    traffic.measuring = False
+
+  metrics_end = json.loads(pyllarp.Metrics())
+  memory = json.loads(pyllarp.MemoryStats())
+  resident = resident_bytes()
+  h.Stop()
+
+  relayed = relayed_bytes(metrics_end) - relayed_bytes(metrics_start)
+  transit_hops = metrics_end.get("lokinet_path_transit_hops", 0)
+  path_memory = memory["tags"]["path"]["live"]
+  # there and back: our path, the hop to the service's intro, and the service's path
+  link_hops = 2 * (2 * args.hops + 1)
+  result = {
+    "hive": {
+      "relays": args.relays,
+      "clients": args.clients,
+      "services": args.services,
+      "hops": args.hops,
+      "rate": args.rate,
+      "size": args.size,
+      "duration": elapsed,
+    },
+    "sent": traffic.sent,
+    "received": traffic.received,
+    "loss": 1 - traffic.received / traffic.sent if traffic.sent else 0,
+    "throughput": {
+      "packetsPerSec": traffic.received / elapsed,
+      "bytesPerSec": traffic.received_bytes / elapsed,
+    },
+    "rttMs": summary(traffic.rtts),
+    "perHopLatencyMs": summary([rtt / link_hops for rtt in traffic.rtts]),
+    "relayedBytes": relayed,
+    "cpuNsPerRelayedByte": 1e9 * cpu / relayed if relayed else 0,
+    "transitHops": transit_hops,
+    "pathMemoryPerTransitHop": path_memory / transit_hops if transit_hops else 0,
+    "residentPerTransitHop": resident / transit_hops if transit_hops else 0,
+    "pathBuilds": {
+      "started": metrics_end.get("lokinet_path_builds_total", 0),
+      "succeeded": metrics_end.get("lokinet_path_builds_succeeded_total", 0),
+      "latencyMs": metrics_end.get("lokinet_path_build_latency_milliseconds", {}),
+    },
+  }
+
+  out = json.dumps(result, indent=2, sort_keys=True)
+  print(out)
+  if args.output:
+    with open(args.output, "w") as f:
+      f.write(out + "\n")
+
+
+if __name__ == '__main__':
+  parser = ap()
+  parser.add_argument('--relays', dest="relays", type=int, default=20)
+  parser.add_argument('--clients', dest="clients", type=int, default=10)
+  parser.add_argument('--services', dest="services", type=int, default=2)
+  parser.add_argument('--hops', dest="hops", type=int, default=4,
+                      help="hops in each path, for the per hop split (endpoints use 4)")
+  parser.add_argument('--rate', dest="rate", type=float, default=20,
+                      help="packets a second each client sends")
+  parser.add_argument('--size', dest="size", type=int, default=512,
+                      help="bytes in each packet")
+  parser.add_argument('--duration', dest="duration", type=float, default=30)
+  parser.add_argument('--warmup', dest="warmup", type=float, default=20,
+                      help="seconds to let paths build and convos start before measuring")
+  parser.add_argument('--output', dest="output", default=None,
+                      help="also write the json results here")
+  parser.add_argument('--verbose', action='store_true', dest='verbose')
+  args = parser.parse_args()
+  if args.services < 1 or args.clients < 1:
+    parser.error("need at least one client and one service")
+  main(args)
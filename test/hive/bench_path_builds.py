@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""
+path build benchmark: runs a hive, has every client build paths at a set rate and reports how
+long builds took, how long each hop spent on the LRCM, and how much cpu each build cost.
+
+run it before and after a change to path building and compare, e.g.
+
+    ./bench_path_builds.py --relays 30 --clients 10 --rate 2 --duration 30
+"""
+import hive
+from time import sleep, time, process_time
+from argparse import ArgumentParser as ap
+
+
+def percentile(values, q):
+  if not values:
+    return 0
+  values = sorted(values)
+  return values[min(len(values) - 1, int(q * len(values)))]
+
+
+def summarize(name, values, unit):
+  print("{}: n={} p50={}{u} p90={}{u} p99={}{u} max={}{u}".format(
+    name, len(values),
+    percentile(values, 0.5), percentile(values, 0.9), percentile(values, 0.99),
+    max(values) if values else 0, u=unit))
+
+
+def main(n_relays, n_clients, rate, duration, warmup, verbose):
+  h = hive.RouterHive(n_relays, n_clients, shutup=not verbose)
+  h.Start()
+
+  print("letting the hive settle for {}s".format(warmup))
+  sleep(warmup)
+  h.DrainEvents()
+
+  attempts = 0
+  rejected = 0
+  build_times = []
+  hop_times = []
+
+  start = time()
+  cpu_start = process_time()
+  next_build = start
+  while time() < start + duration:
+    now = time()
+    if now >= next_build:
+      h.hive.ForEachClient(lambda ctx: ctx.BuildPath())
+      next_build += 1.0 / rate
+
+    # only the events we read a field of become python objects; the rest are just counted
+    batch = h.CollectEventBatch()
+    counts = batch.Counts()
+    attempts += counts.get("PathAttemptEvent", 0)
+    rejected += counts.get("PathBuildRejectedEvent", 0)
+    build_times.extend(ev.buildTime for ev in batch.OfType("PathBuildCompletedEvent"))
+    hop_times.extend(ev.processingTime for ev in batch.OfType("PathRequestReceivedEvent"))
+    sleep(min(0.01, max(0, next_build - time())))
+
+  cpu = process_time() - cpu_start
+  h.Stop()
+
+  print("{} relays, {} clients, {} builds/s per client for {}s".format(
+    n_relays, n_clients, rate, duration))
+  print("attempts={} built={} rejected={}".format(attempts, len(build_times), rejected))
+  summarize("build time", build_times, "ms")
+  summarize("LRCM time per hop", hop_times, "us")
+  if build_times:
+    print("cpu per build: {:.2f}ms".format(1000 * cpu / len(build_times)))
+
+
+if __name__ == '__main__':
+  parser = ap()
+  parser.add_argument('--relays', dest="relays", type=int, default=20)
+  parser.add_argument('--clients', dest="clients", type=int, default=10)
+  parser.add_argument('--rate', dest="rate", type=float, default=1.0,
+                      help="path builds a second asked of each client")
+  parser.add_argument('--duration', dest="duration", type=float, default=30)
+  parser.add_argument('--warmup', dest="warmup", type=float, default=10,
+                      help="seconds to let clients bootstrap before measuring")
+  parser.add_argument('--verbose', action='store_true', dest='verbose')
+  args = parser.parse_args()
+  main(args.relays, args.clients, args.rate, args.duration, args.warmup, args.verbose)
@@ -153,7 +153,17 @@ class RouterHive(object):
     self.events.append(self.hive.GetNextEvent())
 
   def CollectAllEvents(self):
-    self.events.extend(self.hive.GetAllEvents())
+    self.events.extend(self.hive.GetEventBatch())
+
+  def CollectEventBatch(self, max_events=0):
+    """the events so far as a pyllarp.EventBatch, which keeps them in c++ until looked at: count
+    them with Counts(), or pick out one class of them with OfType(name)"""
+    return self.hive.GetEventBatch(max_events)
+
+  def DrainEvents(self):
+    """throws away the events so far without making python objects of them"""
+    self.hive.GetEventBatch()
+    self.events.clear()
 
   def PopEvent(self):
     self.CollectAllEvents()
@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""
+runs a network of simulated routers in virtual time and prints how it is doing as it goes: every
+router runs in this process on one thread, over an in-memory network, so thousands of them fit
+where a hive manages a few dozen, and a run goes the same way each time for the same --seed.
+
+    ./sim_network.py --relays 2000 --clients 200 --latency 20 --jitter 10 --loss 0.01 \\
+        --duration 600 --every 30
+"""
+import pyllarp
+import json
+from shutil import rmtree
+from time import time
+from argparse import ArgumentParser as ap
+
+
+def main(args):
+  rmtree(args.dir, ignore_errors=True)
+  pyllarp.LogContext().shutup = not args.verbose
+
+  sim = pyllarp.Simulation(args.dir, args.seed)
+  sim.SetSeedCount(args.seeds)
+  link = pyllarp.LinkModel()
+  link.latency = args.latency
+  link.jitter = args.jitter
+  link.loss = args.loss
+  sim.SetDefaultLink(link)
+
+  for _ in range(args.relays):
+    sim.AddRelay()
+  for _ in range(args.clients):
+    sim.AddClient()
+
+  started = time()
+  sim.Start()
+  print("started {} relays and {} clients in {:.1f}s".format(
+    args.relays, args.clients, time() - started))
+
+  elapsed = 0
+  while elapsed < args.duration:
+    step = min(args.every, args.duration - elapsed)
+    wall = time()
+    sim.RunFor(int(step * 1000))
+    elapsed += step
+    status = json.loads(sim.Status())
+    status["wallSeconds"] = time() - wall
+    print("after {}s: {}".format(elapsed, json.dumps(status, sort_keys=True)))
+
+  sim.Stop()
+
+
+if __name__ == '__main__':
+  parser = ap()
+  parser.add_argument('--relays', dest="relays", type=int, default=500)
+  parser.add_argument('--clients', dest="clients", type=int, default=50)
+  parser.add_argument('--seeds', dest="seeds", type=int, default=1,
+                      help="relays everyone else bootstraps from")
+  parser.add_argument('--latency', dest="latency", type=int, default=20,
+                      help="one way ms each node's link adds")
+  parser.add_argument('--jitter', dest="jitter", type=int, default=0,
+                      help="up to how many ms more each link adds at random")
+  parser.add_argument('--loss', dest="loss", type=float, default=0.0,
+                      help="chance each link loses a packet")
+  parser.add_argument('--duration', dest="duration", type=float, default=300,
+                      help="virtual seconds to run for")
+  parser.add_argument('--every', dest="every", type=float, default=30,
+                      help="virtual seconds between status reports")
+  parser.add_argument('--seed', dest="seed", type=int, default=0)
+  parser.add_argument('--dir', dest="dir", default="/tmp/lokinet_sim")
+  parser.add_argument('--verbose', action='store_true', dest='verbose')
+  main(parser.parse_args())
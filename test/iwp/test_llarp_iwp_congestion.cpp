@@ -0,0 +1,91 @@
+#include <llarp/iwp/congestion.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::iwp::CongestionControl;
+using namespace std::literals;
+
+TEST_CASE("iwp congestion control rtt estimate", "[iwp][congestion]")
+{
+  CongestionControl cc;
+  REQUIRE(cc.RTO() == CongestionControl::InitialRTO);
+
+  llarp_time_t now = 1000s;
+  cc.OnRTTSample(300ms, now);
+  REQUIRE(cc.SmoothedRTT() == 300ms);
+  REQUIRE(cc.MinRTT() == 300ms);
+  // srtt + 4 * (rtt / 2)
+  REQUIRE(cc.RTO() == 900ms);
+
+  for (int i = 0; i < 50; ++i)
+    cc.OnRTTSample(300ms, now += 10ms);
+  REQUIRE(cc.SmoothedRTT() == 300ms);
+  REQUIRE(cc.RTO() < 400ms);
+  REQUIRE(cc.RTO() >= CongestionControl::MinRTO);
+  // long paths get longer to deliver
+  REQUIRE(cc.MessageTimeout() > 500ms);
+}
+
+TEST_CASE("iwp congestion control window", "[iwp][congestion]")
+{
+  CongestionControl cc;
+  llarp_time_t now = 1000s;
+  cc.OnRTTSample(50ms, now);
+
+  SECTION("grows while delay is low")
+  {
+    const auto start = cc.Window();
+    cc.OnAcked(8192);
+    REQUIRE(cc.Window() == start + 8192);
+  }
+
+  SECTION("shrinks as queueing delay builds past target")
+  {
+    // leave slow start
+    cc.OnLoss(now);
+    const auto start = cc.Window();
+    for (int i = 0; i < 20; ++i)
+    {
+      cc.OnRTTSample(50ms + CongestionControl::TargetDelay * 2, now += 10ms);
+      cc.OnAcked(8192);
+    }
+    REQUIRE(cc.Window() < start);
+    REQUIRE(cc.Window() >= CongestionControl::MinWindow);
+  }
+
+  SECTION("halves once per round trip on loss")
+  {
+    const auto start = cc.Window();
+    cc.OnLoss(now);
+    REQUIRE(cc.Window() == start / 2);
+    cc.OnLoss(now + 1ms);
+    REQUIRE(cc.Window() == start / 2);
+    cc.OnLoss(now + 1s);
+    REQUIRE(cc.Window() == start / 4);
+  }
+
+  SECTION("window limits what we put in flight")
+  {
+    REQUIRE(cc.CanSend(0, CongestionControl::MaxWindow * 2));
+    REQUIRE(cc.CanSend(1024, cc.Window() - 1024));
+    REQUIRE_FALSE(cc.CanSend(1024, cc.Window()));
+  }
+}
+
+TEST_CASE("iwp congestion control pacing", "[iwp][congestion]")
+{
+  CongestionControl cc;
+  llarp_time_t now = 1000s;
+  cc.OnRTTSample(100ms, now);
+
+  // an idle session gets a burst, then has to wait
+  size_t sent = 0;
+  while (cc.Pace(1024, now))
+    sent += 1024;
+  REQUIRE(sent >= CongestionControl::PacingBurst);
+  REQUIRE(sent <= CongestionControl::PacingBurst + 1024);
+  const auto delay = cc.PacingDelay(now);
+  REQUIRE(delay > 0ms);
+  REQUIRE_FALSE(cc.Pace(1024, now + delay - 1ms));
+  REQUIRE(cc.Pace(1024, now + delay));
+}
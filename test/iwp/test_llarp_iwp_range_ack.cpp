@@ -0,0 +1,85 @@
+#include <llarp/iwp/range_ack.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::iwp::RangeACK;
+
+TEST_CASE("iwp range ack round trip", "[iwp][rack]")
+{
+  RangeACK rack;
+  for (uint64_t id : {100, 101, 102, 102, 103, 110, 200, 201})
+    rack.AddComplete(id);
+  REQUIRE(rack.ranges.size() == 3);
+  rack.AddPartial(150, 0x05);
+  rack.AddPartial(120, 0x01);
+  rack.AddPartial(150, 0x02);
+
+  const auto body = rack.Encode(1024);
+  REQUIRE(rack.empty());
+  // 3 ranges and 2 partials in a handful of bytes, where an eMACK alone would take 8 per id
+  REQUIRE(body.size() < 20);
+
+  const auto decoded = RangeACK::Decode(body.data(), body.size());
+  REQUIRE(decoded);
+  REQUIRE(
+      decoded->ranges
+      == std::vector<std::pair<uint64_t, uint64_t>>{{100, 103}, {110, 110}, {200, 201}});
+  REQUIRE(
+      decoded->partial == std::vector<std::pair<uint64_t, byte_t>>{{120, 0x01}, {150, 0x07}});
+  REQUIRE(decoded->Covers(100));
+  REQUIRE(decoded->Covers(103));
+  REQUIRE(decoded->Covers(110));
+  REQUIRE_FALSE(decoded->Covers(104));
+  REQUIRE_FALSE(decoded->Covers(99));
+  REQUIRE_FALSE(decoded->Covers(202));
+}
+
+TEST_CASE("iwp range ack splits across packets", "[iwp][rack]")
+{
+  RangeACK rack;
+  // every other id, so nothing coalesces
+  for (uint64_t id = 0; id < 2000; id += 2)
+    rack.AddComplete(id);
+
+  RangeACK reassembled;
+  size_t packets = 0;
+  while (not rack.empty())
+  {
+    const auto body = rack.Encode(128);
+    REQUIRE(body.size() <= 128);
+    const auto decoded = RangeACK::Decode(body.data(), body.size());
+    REQUIRE(decoded);
+    for (const auto& [first, last] : decoded->ranges)
+      for (auto id = first; id <= last; ++id)
+        reassembled.AddComplete(id);
+    ++packets;
+  }
+  REQUIRE(packets > 1);
+  REQUIRE(reassembled.ranges.size() == 1000);
+  REQUIRE(reassembled.ranges.back() == std::pair<uint64_t, uint64_t>{1998, 1998});
+}
+
+TEST_CASE("iwp range ack rejects malformed input", "[iwp][rack]")
+{
+  // truncated varint
+  const std::vector<byte_t> truncated{0x01, 0x80};
+  REQUIRE_FALSE(RangeACK::Decode(truncated.data(), truncated.size()));
+
+  // a count larger than the packet could hold
+  const std::vector<byte_t> overcount{0x7f, 0x00, 0x00};
+  REQUIRE_FALSE(RangeACK::Decode(overcount.data(), overcount.size()));
+
+  // a range that wraps past the top of the id space
+  RangeACK wide;
+  wide.AddComplete(~uint64_t{0} - 1);
+  auto body = wide.Encode(64);
+  // bump the length so first + len overflows
+  body[body.size() - 2] = 0x05;
+  REQUIRE_FALSE(RangeACK::Decode(body.data(), body.size()));
+
+  // empty is fine
+  const std::vector<byte_t> empty{0x00, 0x00};
+  const auto decoded = RangeACK::Decode(empty.data(), empty.size());
+  REQUIRE(decoded);
+  REQUIRE(decoded->empty());
+}
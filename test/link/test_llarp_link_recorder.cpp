@@ -0,0 +1,110 @@
+#include <llarp/link/recorder.hpp>
+
+#include <catch2/catch.hpp>
+#include "test_util.hpp"
+
+using llarp::LinkRecorder;
+
+namespace
+{
+  llarp::RouterID
+  Remote(byte_t id)
+  {
+    llarp::RouterID r;
+    r.Fill(id);
+    return r;
+  }
+}  // namespace
+
+TEST_CASE("LinkRecorder", "[link]")
+{
+  const fs::path file = llarp::test::randFilename();
+  llarp::test::FileGuard guard{file};
+  std::vector<byte_t> big(4000, 'x'), small{'d', '1', ':', 'a', '1', ':', 'u', 'e'};
+
+  SECTION("Records read back as they were written")
+  {
+    {
+      LinkRecorder recorder{file, true, 1'000'000};
+      recorder.Record(LinkRecorder::Direction::Inbound, Remote(1), llarp_buffer_t{small});
+      recorder.Record(LinkRecorder::Direction::Outbound, Remote(2), llarp_buffer_t{big});
+      recorder.Record(LinkRecorder::Direction::Inbound, Remote(1), llarp_buffer_t{big});
+      REQUIRE(recorder.Records() == 3);
+    }
+    LinkRecorder::Reader reader{file};
+    REQUIRE(reader.Payloads());
+    auto a = reader.Next(), b = reader.Next(), c = reader.Next();
+    REQUIRE(a);
+    REQUIRE(b);
+    REQUIRE(c);
+    REQUIRE_FALSE(reader.Next());
+    REQUIRE(a->dir == LinkRecorder::Direction::Inbound);
+    REQUIRE(a->session == 0);
+    REQUIRE(a->msg == small);
+    REQUIRE(b->dir == LinkRecorder::Direction::Outbound);
+    REQUIRE(b->session == 1);
+    REQUIRE(b->size == big.size());
+    REQUIRE(b->msg == big);
+    // the same remote gets the same number
+    REQUIRE(c->session == 0);
+    REQUIRE(a->at <= b->at);
+    REQUIRE(b->at <= c->at);
+  }
+
+  SECTION("Without payloads only the sizes are kept")
+  {
+    {
+      LinkRecorder recorder{file, false, 1'000'000};
+      recorder.Record(LinkRecorder::Direction::Outbound, Remote(3), llarp_buffer_t{big});
+    }
+    REQUIRE(fs::file_size(file) < 32);
+    LinkRecorder::Reader reader{file};
+    REQUIRE_FALSE(reader.Payloads());
+    auto a = reader.Next();
+    REQUIRE(a);
+    REQUIRE(a->size == big.size());
+    REQUIRE(a->msg.empty());
+    REQUIRE_FALSE(reader.Next());
+  }
+
+  SECTION("Recording stops at its limit")
+  {
+    {
+      LinkRecorder recorder{file, true, 10'000};
+      for (int i = 0; i < 5; ++i)
+        recorder.Record(LinkRecorder::Direction::Inbound, Remote(1), llarp_buffer_t{big});
+      REQUIRE(recorder.Full());
+      REQUIRE(recorder.Records() == 2);
+    }
+    REQUIRE(fs::file_size(file) <= 10'000);
+    LinkRecorder::Reader reader{file};
+    size_t n = 0;
+    while (reader.Next())
+      ++n;
+    REQUIRE(n == 2);
+  }
+
+  SECTION("Writes go through the disk function, in order")
+  {
+    std::vector<std::function<void(void)>> queued;
+    {
+      LinkRecorder recorder{file, true, 1'000'000, [&queued](auto f) {
+                              queued.push_back(std::move(f));
+                            }};
+      recorder.Record(LinkRecorder::Direction::Inbound, Remote(1), llarp_buffer_t{small});
+    }
+    REQUIRE(queued.size() == 1);
+    for (auto& f : queued)
+      f();
+    LinkRecorder::Reader reader{file};
+    auto a = reader.Next();
+    REQUIRE(a);
+    REQUIRE(a->msg == small);
+  }
+
+  SECTION("Other files are turned away")
+  {
+    fs::ofstream{file} << "not a recording";
+    REQUIRE_THROWS(LinkRecorder::Reader{file});
+  }
+}
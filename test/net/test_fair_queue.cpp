@@ -0,0 +1,129 @@
+#include <llarp/net/fair_queue.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <oxenc/endian.h>
+
+using llarp::byte_t;
+using llarp::net::FairQueue;
+using llarp::net::IPPacket;
+using namespace std::literals;
+
+/// an ipv4 udp packet of sz bytes from 10.0.0.1 on port to 10.0.0.2:53, with n in its last byte
+static IPPacket
+UDPv4(uint16_t port, size_t sz = 1000, byte_t n = 0)
+{
+  std::vector<byte_t> pkt(sz);
+  pkt[0] = 0x45;
+  oxenc::write_host_as_big<uint16_t>(sz, pkt.data() + 2);
+  pkt[8] = 64;
+  pkt[9] = 17;
+  const byte_t addrs[] = {10, 0, 0, 1, 10, 0, 0, 2};
+  std::copy_n(addrs, sizeof(addrs), pkt.data() + 12);
+  oxenc::write_host_as_big(port, pkt.data() + 20);
+  oxenc::write_host_as_big<uint16_t>(53, pkt.data() + 22);
+  pkt.back() = n;
+  return IPPacket{std::move(pkt)};
+}
+
+/// fixed so which flows share a queue is too
+static FairQueue::Config
+TestConfig()
+{
+  FairQueue::Config conf{};
+  conf.perturbation = 42;
+  return conf;
+}
+
+static uint16_t
+SourcePort(const IPPacket& pkt)
+{
+  return oxenc::load_big_to_host<uint16_t>(pkt.data() + 20);
+}
+
+TEST_CASE("a flow that has only just started goes ahead of a bulk one", "[fq]")
+{
+  FairQueue queue{TestConfig()};
+  for (byte_t i = 0; i < 20; ++i)
+    queue.Enqueue(UDPv4(1000, 1000, i), 0s);
+  // the bulk flow uses up its first turn and goes on to the old list
+  REQUIRE(SourcePort(*queue.Dequeue(0s)) == 1000);
+  REQUIRE(SourcePort(*queue.Dequeue(0s)) == 1000);
+
+  queue.Enqueue(UDPv4(2000, 100), 0s);
+  REQUIRE(SourcePort(*queue.Dequeue(0s)) == 2000);
+  // and the bulk flow carries on in order
+  for (byte_t i = 2; i < 20; ++i)
+  {
+    auto pkt = queue.Dequeue(0s);
+    REQUIRE(pkt);
+    REQUIRE(pkt->data()[pkt->size() - 1] == i);
+  }
+  REQUIRE_FALSE(queue.Dequeue(0s));
+  REQUIRE(queue.Empty());
+}
+
+TEST_CASE("bulk flows take turns a quantum at a time", "[fq]")
+{
+  FairQueue queue{TestConfig()};
+  for (int i = 0; i < 10; ++i)
+  {
+    queue.Enqueue(UDPv4(1000), 0s);
+    queue.Enqueue(UDPv4(2000), 0s);
+  }
+  REQUIRE(queue.Size() == 20);
+
+  // each gets two 1000 byte packets out of a 1514 byte quantum and then the other has a turn
+  std::vector<uint16_t> order;
+  while (auto pkt = queue.Dequeue(0s))
+    order.push_back(SourcePort(*pkt));
+  REQUIRE(order.size() == 20);
+  size_t first = std::count(order.begin(), order.begin() + 10, order[0]);
+  REQUIRE(first >= 4);
+  REQUIRE(first <= 6);
+}
+
+TEST_CASE("codel drops from a flow that keeps a standing queue", "[fq]")
+{
+  auto conf = TestConfig();
+  conf.target = 5ms;
+  conf.interval = 100ms;
+  FairQueue queue{conf};
+
+  // a packet in and a packet out every millisecond, 50 packets behind
+  llarp::llarp_time_t now = 0s;
+  for (int i = 0; i < 50; ++i)
+    queue.Enqueue(UDPv4(1000), now);
+  for (int i = 0; i < 500; ++i)
+  {
+    now += 1ms;
+    queue.Enqueue(UDPv4(1000), now);
+    queue.Dequeue(now);
+  }
+  REQUIRE(queue.Dropped() > 0);
+  REQUIRE(queue.Size() < 50);
+
+  // a flow that keeps up loses nothing
+  FairQueue light{conf};
+  for (int i = 0; i < 500; ++i)
+  {
+    now += 1ms;
+    light.Enqueue(UDPv4(2000), now);
+    REQUIRE(light.Dequeue(now));
+  }
+  REQUIRE(light.Dropped() == 0);
+}
+
+TEST_CASE("past the limit the biggest flow loses packets", "[fq]")
+{
+  auto conf = TestConfig();
+  conf.limit = 10;
+  FairQueue queue{conf};
+  queue.Enqueue(UDPv4(2000, 100), 0s);
+  for (int i = 0; i < 20; ++i)
+    queue.Enqueue(UDPv4(1000), 0s);
+  REQUIRE(queue.Size() == 10);
+  REQUIRE(queue.Dropped() == 11);
+  // the small flow is still there
+  REQUIRE(SourcePort(*queue.Dequeue(0s)) == 2000);
+}
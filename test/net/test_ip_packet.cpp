@@ -0,0 +1,92 @@
+#include <llarp/net/ip_packet.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <random>
+
+using llarp::byte_t;
+
+/// the checksum of buf one 16 bit word at a time, the way rfc 1071 lays it out
+static uint16_t
+ReferenceChecksum(const byte_t* buf, size_t sz, uint32_t initial = 0)
+{
+  uint64_t sum = initial;
+  for (size_t i = 0; i + 1 < sz; i += 2)
+  {
+    uint16_t word;
+    std::memcpy(&word, buf + i, sizeof(word));
+    sum += word;
+  }
+  if (sz % 2)
+  {
+    uint16_t word = 0;
+    std::memcpy(&word, buf + sz - 1, 1);
+    sum += word;
+  }
+  while (sum >> 16)
+    sum = (sum & 0xFFff) + (sum >> 16);
+  return ~sum & 0xFFff;
+}
+
+TEST_CASE("ipchksum agrees with the word at a time checksum", "[ip][checksum]")
+{
+  std::mt19937 rng{1234};
+  std::vector<byte_t> buf(70000);
+  for (auto& b : buf)
+    b = rng();
+
+  // every alignment and every tail length, and sizes past where the vector sums flush
+  for (size_t offset = 0; offset < 16; ++offset)
+  {
+    for (size_t sz : {0, 1, 2, 3, 15, 16, 17, 20, 33, 64, 1499, 1500, 65535})
+    {
+      INFO("offset " << offset << " size " << sz);
+      REQUIRE(
+          llarp::net::ipchksum(buf.data() + offset, sz, 0xabcdef)
+          == ReferenceChecksum(buf.data() + offset, sz, 0xabcdef));
+    }
+  }
+
+  std::fill(buf.begin(), buf.end(), 0xff);
+  REQUIRE(
+      llarp::net::ipchksum(buf.data(), buf.size())
+      == ReferenceChecksum(buf.data(), buf.size()));
+}
+
+TEST_CASE("rewriting ipv4 addresses keeps the checksums good", "[ip][checksum]")
+{
+  // a tcp packet from 10.0.0.1 to 10.0.0.2 with a payload, checksums and all
+  std::vector<byte_t> data(40 + 1000);
+  for (size_t i = 40; i < data.size(); ++i)
+    data[i] = i * 7;
+  const byte_t header[] = {
+      // ipv4
+      0x45, 0, 0x04, 0x10, 0, 0, 0x40, 0, 64, 6, 0, 0, 10, 0, 0, 1, 10, 0, 0, 2,
+      // tcp, port 80 to 8080
+      0, 80, 0x1f, 0x90, 0, 0, 0, 1, 0, 0, 0, 0, 0x50, 0x10, 0x02, 0x00, 0, 0, 0, 0};
+  std::copy_n(header, sizeof(header), data.begin());
+
+  const auto tcpChecksum = [](const std::vector<byte_t>& pkt) {
+    std::vector<byte_t> pseudo(pkt.begin() + 12, pkt.begin() + 20);
+    pseudo.insert(pseudo.end(), {0, 6, byte_t((pkt.size() - 20) >> 8), byte_t(pkt.size() - 20)});
+    pseudo.insert(pseudo.end(), pkt.begin() + 20, pkt.end());
+    return llarp::net::ipchksum(pseudo.data(), pseudo.size());
+  };
+  auto check = llarp::net::ipchksum(data.data(), 20);
+  std::memcpy(data.data() + 10, &check, sizeof(check));
+  check = tcpChecksum(data);
+  std::memcpy(data.data() + 36, &check, sizeof(check));
+
+  llarp::net::IPPacket pkt{std::move(data)};
+  pkt.UpdateIPv4Address(
+      llarp::net::ToNet(llarp::huint32_t{0xac100005}),
+      llarp::net::ToNet(llarp::huint32_t{0xac10fffe}));
+
+  const std::vector<byte_t> rewritten(pkt.data(), pkt.data() + pkt.size());
+  REQUIRE(pkt.srcv4() == llarp::huint32_t{0xac100005});
+  REQUIRE(pkt.dstv4() == llarp::huint32_t{0xac10fffe});
+  // checksums over data with good checksums in it come out as 0
+  REQUIRE(llarp::net::ipchksum(rewritten.data(), 20) == 0);
+  REQUIRE(tcpChecksum(rewritten) == 0);
+}
@@ -0,0 +1,60 @@
+#include <llarp/net/ip_pool.hpp>
+#include <llarp/crypto/types.hpp>
+#include <test_util.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::huint128_t;
+using llarp::PubKey;
+using namespace std::literals;
+
+static huint128_t
+IP(uint64_t n)
+{
+  return huint128_t{llarp::uint128_t{n}};
+}
+
+static PubKey
+Key(llarp::byte_t n)
+{
+  return llarp::test::makeBuf<PubKey>(n);
+}
+
+TEST_CASE("IPPool hands out from the bottom and takes back the least recently active", "[ippool]")
+{
+  llarp::net::IPPool<PubKey> pool{IP(100), IP(103)};
+  REQUIRE(pool.Highest() == IP(103));
+
+  REQUIRE(pool.Assign(IP(100), Key(0), 0s));
+  pool.Pin(IP(100));
+  REQUIRE(pool.Allocate(Key(1), 1s) == IP(101));
+  REQUIRE(pool.Allocate(Key(2), 2s) == IP(102));
+  REQUIRE(pool.Allocate(Key(3), 3s) == IP(103));
+  REQUIRE_FALSE(pool.Allocate(Key(4), 4s).has_value());
+  REQUIRE_FALSE(pool.Assign(IP(104), Key(4), 4s));
+
+  REQUIRE(pool.IPFor(Key(2)) == IP(102));
+  REQUIRE(*pool.KeyFor(IP(103)) == Key(3));
+  REQUIRE(pool.KeyFor(IP(99)) == nullptr);
+
+  // pinned ones never come back, and being active puts one at the back of the line
+  REQUIRE(pool.LeastRecentlyActive() == IP(101));
+  pool.MarkActive(IP(101), 5s);
+  REQUIRE(pool.LeastRecentlyActive() == IP(102));
+
+  pool.Release(IP(102));
+  REQUIRE_FALSE(pool.HasKey(Key(2)));
+  REQUIRE_FALSE(pool.InUse(IP(102)));
+  REQUIRE(pool.Allocate(Key(4), 6s) == IP(102));
+  REQUIRE(pool.LeastRecentlyActive() == IP(103));
+
+  size_t seen = 0;
+  pool.ForEach([&](huint128_t ip, const PubKey& key, llarp_time_t active) {
+    REQUIRE(pool.IPFor(key) == ip);
+    if (ip == IP(100))
+      REQUIRE(active == std::numeric_limits<llarp_time_t>::max());
+    ++seen;
+  });
+  REQUIRE(seen == pool.Size());
+  REQUIRE(seen == 4);
+}
@@ -0,0 +1,69 @@
+#include <llarp/net/ip_range_map.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <random>
+
+using llarp::IPRange;
+
+static llarp::huint128_t
+IPv4(llarp::byte_t a, llarp::byte_t b, llarp::byte_t c, llarp::byte_t d)
+{
+  return llarp::net::ExpandV4(llarp::ipaddr_ipv4_bits(a, b, c, d));
+}
+
+TEST_CASE("IPRangeMap finds the ranges an address is in", "[ip][range]")
+{
+  llarp::net::IPRangeMap<std::string> map;
+  map.Insert(IPRange::FromIPv4(0, 0, 0, 0, 0), "default");
+  map.Insert(IPRange::FromIPv4(10, 0, 0, 0, 8), "ten");
+  map.Insert(IPRange::FromIPv4(10, 1, 0, 0, 16), "ten one");
+  map.Insert(IPRange::FromIPv4(10, 1, 2, 3, 32), "host");
+  map.Insert(IPRange::FromIPv4(10, 128, 0, 0, 9), "high ten");
+
+  REQUIRE(map.FindAllEntries(IPv4(10, 1, 2, 3)).size() == 4);
+  REQUIRE(map.FindAllEntries(IPv4(10, 1, 2, 4)).size() == 3);
+  REQUIRE(map.FindAllEntries(IPv4(10, 200, 0, 1)).size() == 3);
+  REQUIRE(map.FindAllEntries(IPv4(192, 168, 0, 1)).size() == 1);
+
+  REQUIRE(map.FindLongestMatch(IPv4(10, 1, 2, 3))->second == "host");
+  REQUIRE(map.FindLongestMatch(IPv4(10, 1, 9, 9))->second == "ten one");
+  REQUIRE(map.FindLongestMatch(IPv4(10, 127, 0, 1))->second == "ten");
+  REQUIRE(map.FindLongestMatch(IPv4(10, 128, 0, 1))->second == "high ten");
+  REQUIRE(map.FindLongestMatch(IPv4(1, 1, 1, 1))->second == "default");
+
+  REQUIRE(map.GetExact(IPRange::FromIPv4(10, 1, 0, 0, 16)) == "ten one");
+  REQUIRE_FALSE(map.GetExact(IPRange::FromIPv4(10, 1, 0, 0, 15)));
+
+  map.RemoveIf([](const auto& entry) { return entry.second == "default"; });
+  REQUIRE_FALSE(map.FindLongestMatch(IPv4(1, 1, 1, 1)));
+  REQUIRE(map.FindLongestMatch(IPv4(10, 1, 2, 3))->second == "host");
+}
+
+TEST_CASE("IPRangeMap agrees with looking at every range", "[ip][range]")
+{
+  std::mt19937 rng{42};
+  llarp::net::IPRangeMap<int> map;
+  std::vector<std::pair<IPRange, int>> ranges;
+  for (int i = 0; i < 500; ++i)
+  {
+    const auto ip = llarp::net::ExpandV4(llarp::huint32_t{static_cast<uint32_t>(rng())});
+    const IPRange range{ip, llarp::netmask_ipv6_bits(96 + rng() % 33)};
+    map.Insert(range, i);
+    ranges.emplace_back(range, i);
+  }
+  for (int i = 0; i < 2000; ++i)
+  {
+    // half of them in one of the ranges at least
+    auto ip = llarp::net::ExpandV4(llarp::huint32_t{static_cast<uint32_t>(rng())});
+    if (i % 2)
+      ip = ranges[rng() % ranges.size()].first.addr;
+    std::set<std::pair<IPRange, int>> expected;
+    for (const auto& entry : ranges)
+    {
+      if (entry.first.Contains(ip))
+        expected.insert(entry);
+    }
+    REQUIRE(map.FindAllEntries(ip) == expected);
+  }
+}
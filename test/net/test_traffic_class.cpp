@@ -0,0 +1,85 @@
+#include <llarp/net/traffic_class.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <oxenc/endian.h>
+
+using llarp::byte_t;
+using llarp::net::IPPacket;
+using llarp::net::TrafficClass;
+
+/// an ipv4 packet of ip protocol proto marked with dscp, from port src to port dst
+static IPPacket
+Packet(byte_t proto, byte_t dscp, uint16_t src = 0, uint16_t dst = 0)
+{
+  std::vector<byte_t> pkt(40);
+  pkt[0] = 0x45;
+  pkt[1] = dscp << 2;
+  oxenc::write_host_as_big<uint16_t>(pkt.size(), pkt.data() + 2);
+  pkt[8] = 64;
+  pkt[9] = proto;
+  oxenc::write_host_as_big(src, pkt.data() + 20);
+  oxenc::write_host_as_big(dst, pkt.data() + 22);
+  return IPPacket{std::move(pkt)};
+}
+
+TEST_CASE("traffic is classed by its dscp when no rule says otherwise", "[traffic][class]")
+{
+  const byte_t udp = 17;
+  llarp::net::TrafficClassifier classifier;
+  // ef
+  REQUIRE(classifier.Classify(Packet(udp, 46)) == TrafficClass::Realtime);
+  // af41
+  REQUIRE(classifier.Classify(Packet(udp, 34)) == TrafficClass::Realtime);
+  REQUIRE(classifier.Classify(Packet(udp, 0)) == TrafficClass::Interactive);
+  // af21
+  REQUIRE(classifier.Classify(Packet(udp, 18)) == TrafficClass::Interactive);
+  // cs1 and le
+  REQUIRE(classifier.Classify(Packet(udp, 8)) == TrafficClass::Bulk);
+  REQUIRE(classifier.Classify(Packet(udp, 1)) == TrafficClass::Bulk);
+
+  // and in ipv6, where the dscp straddles the first two bytes
+  std::vector<byte_t> v6(48);
+  v6[0] = 0x6b;
+  v6[1] = 0x80;
+  v6[6] = udp;
+  REQUIRE(classifier.Classify(IPPacket{std::move(v6)}) == TrafficClass::Realtime);
+
+  // too short to say
+  REQUIRE(
+      classifier.Classify(IPPacket{std::vector<byte_t>(10, 0x45)}) == TrafficClass::Interactive);
+
+  // the more urgent go ahead of the rest
+  REQUIRE(
+      llarp::net::LinkPriority(TrafficClass::Realtime)
+      > llarp::net::LinkPriority(TrafficClass::Interactive));
+  REQUIRE(
+      llarp::net::LinkPriority(TrafficClass::Interactive)
+      > llarp::net::LinkPriority(TrafficClass::Bulk));
+}
+
+TEST_CASE("traffic class rules match ports either way and go before dscp", "[traffic][class]")
+{
+  const byte_t tcp = 6, udp = 17, icmp = 1;
+  llarp::net::TrafficClassifier classifier;
+  classifier.AddRule("udp/3478:realtime");
+  classifier.AddRule("tcp/873:bulk");
+  classifier.AddRule("udp:bulk");
+  classifier.AddRule("icmp:realtime");
+
+  // to the port and back from it
+  REQUIRE(classifier.Classify(Packet(udp, 0, 50000, 3478)) == TrafficClass::Realtime);
+  REQUIRE(classifier.Classify(Packet(udp, 0, 3478, 50000)) == TrafficClass::Realtime);
+  // the first that matches wins, marked or not
+  REQUIRE(classifier.Classify(Packet(udp, 46, 50000, 53)) == TrafficClass::Bulk);
+  REQUIRE(classifier.Classify(Packet(tcp, 46, 873, 50000)) == TrafficClass::Bulk);
+  REQUIRE(classifier.Classify(Packet(icmp, 8)) == TrafficClass::Realtime);
+  // and no rule leaves it to the dscp
+  REQUIRE(classifier.Classify(Packet(tcp, 0, 50000, 443)) == TrafficClass::Interactive);
+  REQUIRE(classifier.Classify(Packet(tcp, 46, 50000, 443)) == TrafficClass::Realtime);
+
+  REQUIRE_THROWS_AS(classifier.AddRule("udp/3478"), std::invalid_argument);
+  REQUIRE_THROWS_AS(classifier.AddRule("udp/3478:urgent"), std::invalid_argument);
+  REQUIRE(llarp::net::ParseTrafficClass("interactive") == TrafficClass::Interactive);
+  REQUIRE(llarp::net::ToString(TrafficClass::Bulk) == "bulk");
+}
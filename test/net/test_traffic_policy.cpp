@@ -0,0 +1,64 @@
+#include <llarp/net/traffic_policy.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <oxenc/endian.h>
+
+using llarp::byte_t;
+using llarp::net::IPPacket;
+
+/// an ipv4 packet of ip protocol proto to a.b.c.d and port
+static IPPacket
+Packet(byte_t proto, byte_t a, byte_t b, byte_t c, byte_t d, uint16_t port = 0)
+{
+  std::vector<byte_t> pkt(40);
+  pkt[0] = 0x45;
+  oxenc::write_host_as_big<uint16_t>(pkt.size(), pkt.data() + 2);
+  pkt[8] = 64;
+  pkt[9] = proto;
+  const byte_t dst[] = {a, b, c, d};
+  std::copy_n(dst, sizeof(dst), pkt.data() + 16);
+  oxenc::write_host_as_big(port, pkt.data() + 22);
+  return IPPacket{std::move(pkt)};
+}
+
+TEST_CASE("compiled traffic policies allow what the policy does", "[traffic][policy]")
+{
+  const byte_t tcp = 6, udp = 17, icmp = 1, gre = 47;
+  const std::vector<IPPacket> pkts = [&] {
+    std::vector<IPPacket> pkts;
+    pkts.push_back(Packet(tcp, 1, 1, 1, 1, 80));
+    pkts.push_back(Packet(tcp, 1, 1, 1, 1, 443));
+    pkts.push_back(Packet(udp, 1, 1, 1, 1, 53));
+    pkts.push_back(Packet(udp, 10, 0, 0, 1, 80));
+    pkts.push_back(Packet(icmp, 8, 8, 8, 8));
+    pkts.push_back(Packet(icmp, 10, 2, 3, 4));
+    pkts.push_back(Packet(gre, 1, 1, 1, 1));
+    return pkts;
+  }();
+
+  const auto check = [&pkts](const llarp::net::TrafficPolicy& policy, std::vector<bool> allowed) {
+    const llarp::net::CompiledTrafficPolicy compiled{policy};
+    for (size_t i = 0; i < pkts.size(); ++i)
+    {
+      INFO("packet " << i);
+      REQUIRE(policy.AllowsTraffic(pkts[i]) == allowed[i]);
+      REQUIRE(compiled.AllowsTraffic(pkts[i]) == allowed[i]);
+    }
+  };
+
+  llarp::net::TrafficPolicy policy;
+  check(policy, {true, true, true, true, true, true, true});
+
+  policy.protocols.emplace("tcp/80");
+  check(policy, {true, false, false, false, false, false, false});
+
+  policy.protocols.emplace("udp");
+  policy.protocols.emplace("gre/1234");
+  check(policy, {true, false, true, true, false, false, true});
+
+  policy.ranges.insert(llarp::IPRange::FromIPv4(10, 0, 0, 0, 8));
+  check(policy, {true, false, true, true, false, true, true});
+
+  REQUIRE(llarp::net::CompiledTrafficPolicy{}.AllowsTraffic(pkts[0]));
+}
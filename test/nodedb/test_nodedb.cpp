@@ -4,6 +4,9 @@
 #include <llarp/router_contact.hpp>
 #include <llarp/nodedb.hpp>
 
+#include <optional>
+#include <set>
+
 using llarp_nodedb = llarp::NodeDB;
 
 TEST_CASE("FindClosestTo returns correct number of elements", "[nodedb][dht]")
@@ -65,3 +68,260 @@ TEST_CASE("FindClosestTo returns properly ordered set", "[nodedb][dht]")
   REQUIRE(c.pubkey == results[0].pubkey);
   REQUIRE(b.pubkey == results[1].pubkey);
 }
+
+TEST_CASE("GetRandom picks only matching entries, from all of them", "[nodedb]")
+{
+  llarp_nodedb nodeDB;
+
+  for (uint8_t i = 0; i < 100; ++i)
+  {
+    llarp::RouterContact rc;
+    rc.pubkey[0] = i;
+    nodeDB.Put(rc);
+  }
+  // replacing one doesn't add one
+  llarp::RouterContact again;
+  again.pubkey[0] = 7;
+  nodeDB.Put(again);
+  REQUIRE(nodeDB.NumLoaded() == 100);
+
+  // removal moves entries around in the sampling index, which must stay consistent
+  nodeDB.RemoveIf([](const auto& rc) { return rc.pubkey[0] % 2 == 0; });
+  nodeDB.Remove(llarp::RouterID{again.pubkey});
+  REQUIRE(nodeDB.NumLoaded() == 49);
+
+  std::set<uint8_t> seen;
+  for (int i = 0; i < 1000; ++i)
+  {
+    // rare enough that most picks fall through to the full scan
+    const auto maybe = nodeDB.GetRandom([](const auto& rc) { return rc.pubkey[0] < 10; });
+    REQUIRE(maybe);
+    seen.insert(maybe->pubkey[0]);
+  }
+  REQUIRE(seen == std::set<uint8_t>{1, 3, 5, 9});
+
+  REQUIRE_FALSE(nodeDB.GetRandom([](const auto&) { return false; }));
+
+  // the summaries are moved about along with the entries they point to
+  seen.clear();
+  for (int i = 0; i < 1000; ++i)
+  {
+    const auto maybe = nodeDB.GetRandomBySummary(
+        [](const llarp::NodeDB::Summary& summary) { return summary.pubkey[0] < 10; });
+    REQUIRE(maybe);
+    REQUIRE(maybe->pubkey[0] < 10);
+    seen.insert(maybe->pubkey[0]);
+  }
+  REQUIRE(seen == std::set<uint8_t>{1, 3, 5, 9});
+
+  nodeDB.RemoveIf([](const auto&) { return true; });
+  REQUIRE(nodeDB.NumLoaded() == 0);
+  REQUIRE_FALSE(nodeDB.GetRandom([](const auto&) { return true; }));
+  REQUIRE_FALSE(nodeDB.GetRandomBySummary([](const auto&) { return true; }));
+}
+
+TEST_CASE("VisitUpdatedSince goes by the summaries", "[nodedb]")
+{
+  llarp_nodedb nodeDB;
+
+  for (uint8_t i = 0; i < 10; ++i)
+  {
+    llarp::RouterContact rc;
+    rc.pubkey[0] = i;
+    rc.last_updated = std::chrono::milliseconds{i * 1000};
+    nodeDB.Put(rc);
+  }
+  // replacing one updates its summary
+  llarp::RouterContact newer;
+  newer.pubkey[0] = 2;
+  newer.last_updated = 20s;
+  nodeDB.Put(newer);
+
+  std::set<uint8_t> seen;
+  nodeDB.VisitUpdatedSince([&seen](const auto& rc) { seen.insert(rc.pubkey[0]); }, 6s);
+  REQUIRE(seen == std::set<uint8_t>{2, 7, 8, 9});
+}
+
+TEST_CASE("RemoveIfChunk gets through everything a chunk at a time", "[nodedb]")
+{
+  llarp_nodedb nodeDB;
+  for (uint8_t i = 0; i < 100; ++i)
+  {
+    llarp::RouterContact rc;
+    rc.pubkey[0] = i;
+    nodeDB.Put(rc);
+  }
+
+  std::optional<llarp::RouterID> cursor;
+  std::set<uint8_t> visited;
+  int chunks = 0;
+  bool done = false;
+  while (not done)
+  {
+    ++chunks;
+    // removing as we go doesn't lose our place
+    done = nodeDB.RemoveIfChunk(
+        [&visited](const auto& rc) {
+          REQUIRE(visited.insert(rc.pubkey[0]).second);
+          return rc.pubkey[0] % 3 == 0;
+        },
+        cursor,
+        16);
+  }
+  REQUIRE(chunks == 7);
+  REQUIRE(visited.size() == 100);
+  REQUIRE_FALSE(cursor);
+  REQUIRE(nodeDB.NumLoaded() == 66);
+}
+
+TEST_CASE("NodeDBStore replays the latest record for each router", "[nodedb]")
+{
+  const auto file = fs::temp_directory_path() / "lokinet-test-nodedb-store.dat";
+  fs::remove(file);
+
+  std::vector<llarp::RouterContact> rcs(4);
+  for (uint8_t i = 0; i < rcs.size(); ++i)
+    rcs[i].pubkey[0] = i + 1;
+
+  auto load = [&file](llarp::NodeDBStore& store) {
+    std::set<uint8_t> ids;
+    const bool ok = store.Load([&ids](const llarp::RouterID& id, llarp_buffer_t buf) {
+      llarp::RouterContact rc;
+      REQUIRE(rc.BDecode(&buf));
+      REQUIRE(llarp::RouterID{rc.pubkey} == id);
+      ids.insert(id[0]);
+    });
+    return ok ? std::optional{ids} : std::nullopt;
+  };
+
+  {
+    llarp::NodeDBStore store{file};
+    REQUIRE_FALSE(load(store));
+    store.Append(rcs);
+    // putting one again supersedes it rather than adding to the live set
+    store.Append({rcs[1]});
+    store.AppendRemovals({llarp::RouterID{rcs[2].pubkey}});
+    REQUIRE(store.LiveSize() < store.FileSize());
+  }
+
+  llarp::NodeDBStore store{file};
+  REQUIRE(load(store) == std::set<uint8_t>{1, 2, 4});
+  const auto size = store.FileSize();
+  REQUIRE(size == fs::file_size(file));
+
+  SECTION("drops a record cut short at the end")
+  {
+    store.Append({rcs[2]});
+    fs::resize_file(file, fs::file_size(file) - 1);
+    llarp::NodeDBStore reloaded{file};
+    REQUIRE(load(reloaded) == std::set<uint8_t>{1, 2, 4});
+    REQUIRE(fs::file_size(file) == size);
+  }
+
+  SECTION("compacts down to just the live records")
+  {
+    store.Compact({rcs[0], rcs[3]});
+    REQUIRE(store.FileSize() < size);
+    REQUIRE(load(store) == std::set<uint8_t>{1, 4});
+    REQUIRE(store.LiveSize() + 12 == store.FileSize());
+  }
+
+  SECTION("ignores files that are not ours")
+  {
+    fs::ofstream{file, std::ios::trunc} << "not a nodedb";
+    llarp::NodeDBStore other{file};
+    REQUIRE_FALSE(load(other));
+  }
+
+  fs::remove(file);
+}
+
+TEST_CASE("NodeDB only writes out what changed", "[nodedb]")
+{
+  const auto root = fs::temp_directory_path() / "lokinet-test-nodedb";
+  fs::remove_all(root);
+  const auto file = root / llarp::NodeDBStore::Filename;
+  llarp_nodedb nodeDB{root, [](auto job) { job(); }};
+
+  for (uint8_t i = 0; i < 10; ++i)
+  {
+    llarp::RouterContact rc;
+    rc.pubkey[0] = i;
+    nodeDB.Put(rc);
+  }
+  nodeDB.SaveToDisk();
+  const auto size = fs::file_size(file);
+
+  // the same rc again is not a change
+  llarp::RouterContact same;
+  same.pubkey[0] = 3;
+  nodeDB.Put(same);
+  nodeDB.SaveToDisk();
+  REQUIRE(fs::file_size(file) == size);
+
+  // a newer one is
+  llarp::RouterContact newer = same;
+  newer.last_updated = std::chrono::milliseconds{1000};
+  nodeDB.PutIfNewer(newer);
+  nodeDB.SaveToDisk();
+  const auto updated = fs::file_size(file);
+  REQUIRE(updated > size);
+
+  // removals are a record each, whatever the size of the rc
+  nodeDB.RemoveIf([](const auto& rc) { return rc.pubkey[0] < 2; });
+  nodeDB.SaveToDisk();
+  REQUIRE(fs::file_size(file) == updated + 2 * (1 + 4 + llarp::RouterID::SIZE));
+
+  fs::remove_all(root);
+}
+
+TEST_CASE("AddPending leaves rcs put in since, and hides the rest until verified", "[nodedb]")
+{
+  llarp_nodedb nodeDB;
+
+  llarp::RouterContact put;
+  put.pubkey[0] = 5;
+  put.last_updated = std::chrono::milliseconds{1000};
+  nodeDB.Put(put);
+
+  std::vector<llarp::RouterContact> loaded;
+  for (uint8_t i = 10; i > 0; --i)
+  {
+    llarp::RouterContact rc;
+    rc.pubkey[0] = i;
+    rc.last_updated = 2s;
+    loaded.push_back(rc);
+  }
+  REQUIRE(nodeDB.AddPending(loaded) == 9);
+  REQUIRE(nodeDB.NumLoaded() == 10);
+  REQUIRE(nodeDB.Get(llarp::RouterID{put.pubkey})->last_updated == put.last_updated);
+
+  // only the one put in is handed out until the rest check out
+  for (int i = 0; i < 100; ++i)
+    REQUIRE(nodeDB.GetRandom([](const auto&) { return true; })->pubkey[0] == 5);
+  REQUIRE_FALSE(nodeDB.Get(llarp::RouterID{loaded.front().pubkey}));
+  REQUIRE_FALSE(nodeDB.Has(llarp::RouterID{loaded.front().pubkey}));
+  REQUIRE(nodeDB.FindClosestTo(llarp::dht::Key_t{}).pubkey[0] == 5);
+  REQUIRE(nodeDB.FindManyClosestTo(llarp::dht::Key_t{}, 3).size() == 1);
+  size_t updated = 0;
+  nodeDB.VisitUpdatedSince([&updated](const auto&) { ++updated; }, 0s);
+  REQUIRE(updated == 1);
+
+  auto pending = nodeDB.PendingRCs();
+  REQUIRE(pending.size() == 9);
+  std::vector<bool> valid;
+  for (const auto& rc : pending)
+    valid.push_back(rc.pubkey[0] != 1);
+  nodeDB.VerifiedPending(pending, valid);
+  REQUIRE(nodeDB.NumLoaded() == 9);
+  REQUIRE(nodeDB.PendingRCs().empty());
+  REQUIRE_FALSE(nodeDB.Has(llarp::RouterID{loaded.back().pubkey}));
+  REQUIRE(nodeDB.Has(llarp::RouterID{loaded.front().pubkey}));
+
+  // the sorted index takes them all in at once, and has to come out in order
+  const auto closest = nodeDB.FindManyClosestTo(llarp::dht::Key_t{}, 3);
+  REQUIRE(closest.size() == 3);
+  REQUIRE(closest[0].pubkey[0] == 2);
+  REQUIRE(closest[1].pubkey[0] == 3);
+  REQUIRE(closest[2].pubkey[0] == 4);
+}
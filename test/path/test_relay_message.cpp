@@ -0,0 +1,86 @@
+#include <llarp/messages/relay.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <array>
+
+using llarp::RelayDownstreamMessage;
+using llarp::RelayUpstreamMessage;
+
+namespace
+{
+  template <typename Msg_t>
+  std::string
+  Encode(const Msg_t& msg)
+  {
+    std::array<byte_t, 1024> tmp;
+    llarp_buffer_t buf{tmp};
+    REQUIRE(msg.BEncode(&buf));
+    return std::string{
+        reinterpret_cast<const char*>(tmp.data()), static_cast<size_t>(buf.cur - buf.base)};
+  }
+
+  llarp::byte_view_t
+  View(const std::string& s)
+  {
+    return {reinterpret_cast<const byte_t*>(s.data()), s.size()};
+  }
+}  // namespace
+
+TEST_CASE("Relay messages decode by their fixed offsets", "[relay]")
+{
+  std::array<byte_t, 100> payload;
+  payload.fill(0x42);
+
+  RelayUpstreamMessage up;
+  up.pathid.Fill(0x11);
+  up.Y.Fill(0x22);
+  up.X = llarp::byte_view_t{payload.data(), payload.size()};
+  const auto wire = Encode(up);
+
+  SECTION("upstream")
+  {
+    REQUIRE(llarp::RelayMessageType(View(wire)) == 'u');
+    RelayUpstreamMessage got;
+    REQUIRE(got.DecodeFixed(View(wire)));
+    REQUIRE(got.pathid == up.pathid);
+    REQUIRE(got.Y == up.Y);
+    REQUIRE(got.X.size() == payload.size());
+    // the payload is left in place in what we decoded
+    REQUIRE(got.X.data() == View(wire).data() + wire.find(std::string(100, 0x42)));
+  }
+
+  SECTION("downstream")
+  {
+    RelayDownstreamMessage down;
+    down.pathid = up.pathid;
+    down.Y = up.Y;
+    down.X = up.X;
+    const auto dwire = Encode(down);
+    REQUIRE(llarp::RelayMessageType(View(dwire)) == 'd');
+    RelayDownstreamMessage got;
+    REQUIRE(got.DecodeFixed(View(dwire)));
+    REQUIRE(got.pathid == down.pathid);
+    REQUIRE(got.X.size() == payload.size());
+  }
+
+  SECTION("an empty payload")
+  {
+    up.X = {};
+    const auto empty = Encode(up);
+    RelayUpstreamMessage got;
+    REQUIRE(got.DecodeFixed(View(empty)));
+    REQUIRE(got.X.empty());
+  }
+
+  SECTION("anything laid out otherwise is left to the full decode")
+  {
+    auto bad = wire;
+    // a payload length that runs past the nonce
+    bad.replace(bad.find("100:"), 4, "101:");
+    REQUIRE_FALSE(RelayUpstreamMessage{}.DecodeFixed(View(bad)));
+    REQUIRE_FALSE(RelayUpstreamMessage{}.DecodeFixed(View(wire.substr(0, wire.size() - 1))));
+    REQUIRE(llarp::RelayMessageType(View("d1:a1:ie")) == 0);
+    REQUIRE(llarp::RelayMessageType(View("d1")) == 0);
+  }
+}
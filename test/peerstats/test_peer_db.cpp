@@ -92,6 +92,46 @@ TEST_CASE("Test PeerDb file-backed database reloads properly", "[PeerDb]")
   fs::remove(filename);
 }
 
+TEST_CASE("Test PeerDb flushes every stale peer in one go", "[PeerDb]")
+{
+  const std::string filename = "/tmp/peerdb_test_tmp3.db.sqlite";
+  const llarp::RouterID id1 = llarp::test::makeBuf<llarp::RouterID>(0x03);
+  const llarp::RouterID id2 = llarp::test::makeBuf<llarp::RouterID>(0x04);
+
+  {
+    llarp::PeerDb db;
+    db.loadDatabase(filename);
+
+    db.modifyPeerStats(id1, [](llarp::PeerStats& stats) { stats.numConnectionAttempts = 7; });
+    db.modifyPeerStats(id2, [](llarp::PeerStats& stats) { stats.numPathBuilds = 9; });
+
+    db.flushDatabase();
+
+    // flushed entries are no longer stale, but keep their stats
+    auto stats = db.getCurrentPeerStats(id1);
+    CHECK(stats.has_value());
+    CHECK_FALSE(stats->stale);
+    CHECK(stats->numConnectionAttempts == 7);
+  }
+
+  {
+    llarp::PeerDb db;
+    db.loadDatabase(filename);
+
+    CHECK(db.listAllPeerStats().size() == 2);
+    auto stats1 = db.getCurrentPeerStats(id1);
+    auto stats2 = db.getCurrentPeerStats(id2);
+    CHECK(stats1.has_value());
+    CHECK(stats2.has_value());
+    CHECK(stats1->numConnectionAttempts == 7);
+    CHECK(stats2->numPathBuilds == 9);
+  }
+
+  fs::remove(filename);
+  fs::remove(filename + "-wal");
+  fs::remove(filename + "-shm");
+}
+
 TEST_CASE("Test PeerDb modifyPeerStats", "[PeerDb]")
 {
   const llarp::RouterID id = llarp::test::makeBuf<llarp::RouterID>(0xF2);
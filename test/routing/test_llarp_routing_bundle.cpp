@@ -0,0 +1,72 @@
+#include <llarp/routing/bundle_message.hpp>
+#include <llarp/util/bencode_span.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <array>
+
+using llarp::routing::BundleMessage;
+
+namespace
+{
+  std::string
+  Encode(const BundleMessage& msg)
+  {
+    std::array<byte_t, BundleMessage::MaxSize> tmp;
+    llarp_buffer_t buf{tmp};
+    REQUIRE(msg.BEncode(&buf));
+    return std::string{
+        reinterpret_cast<const char*>(tmp.data()), static_cast<size_t>(buf.cur - buf.base)};
+  }
+
+  llarp::byte_view_t
+  View(const std::string& s)
+  {
+    return {reinterpret_cast<const byte_t*>(s.data()), s.size()};
+  }
+
+  /// decodes as InboundMessageParser does, having read the message type
+  bool
+  Decode(const std::string& wire, BundleMessage& msg)
+  {
+    llarp::bencode::Reader reader{View(wire)};
+    char key;
+    llarp::byte_view_t type;
+    return reader.Dict() and reader.NextKey(key) and key == 'A' and reader.Bytes(type)
+        and type == View("B") and msg.Decode(reader);
+  }
+}  // namespace
+
+TEST_CASE("Bundles carry their messages as they were", "[routing][bundle]")
+{
+  const std::string one = "d1:A1:H1:Fi1ee";
+  const std::string two(1000, 'x');
+
+  BundleMessage bundle;
+  bundle.messages = {View(one), View(two)};
+  const auto wire = Encode(bundle);
+  REQUIRE(wire.size() <= one.size() + two.size() + 2 * BundleMessage::EntryOverhead
+              + BundleMessage::Overhead);
+
+  BundleMessage got;
+  REQUIRE(Decode(wire, got));
+  REQUIRE(got.messages.size() == 2);
+  CHECK(got.messages[0] == View(one));
+  CHECK(got.messages[1] == View(two));
+}
+
+TEST_CASE("An empty bundle says the sender takes them", "[routing][bundle]")
+{
+  BundleMessage got;
+  REQUIRE(Decode(Encode(BundleMessage{}), got));
+  CHECK(got.messages.empty());
+}
+
+TEST_CASE("Bundles in bundles are refused", "[routing][bundle]")
+{
+  const auto inner = Encode(BundleMessage{});
+  BundleMessage outer;
+  outer.messages = {View(inner)};
+  BundleMessage got;
+  REQUIRE_FALSE(Decode(Encode(outer), got));
+}
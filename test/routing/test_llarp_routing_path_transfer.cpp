@@ -0,0 +1,61 @@
+#include <llarp/routing/path_transfer_message.hpp>
+#include <llarp/util/bencode_span.hpp>
+
+#include <algorithm>
+
+#include <catch2/catch.hpp>
+
+using PathTransferMessage = llarp::routing::PathTransferMessage;
+
+TEST_CASE("PathTransferMessage passes its frame on undecoded", "[PathTransferMessage]")
+{
+  PathTransferMessage msg;
+  msg.P.Fill(1);
+  msg.Y.Fill(2);
+  msg.T.F.Fill(3);
+  msg.T.N.Fill(4);
+  std::array<byte_t, 512> payload;
+  payload.fill(0x42);
+  msg.T.D = llarp_buffer_t{payload};
+
+  std::array<byte_t, llarp::MAX_LINK_MSG_SIZE> tmp = {{0}};
+  llarp_buffer_t buf(tmp);
+  REQUIRE(msg.BEncode(&buf));
+  buf.sz = buf.cur - buf.base;
+  buf.cur = buf.base;
+
+  PathTransferMessage decoded;
+  REQUIRE(llarp::bencode_decode_dict(decoded, &buf));
+  REQUIRE(decoded.P == msg.P);
+  REQUIRE(decoded.Y == msg.Y);
+  // of the frame we only decode who it is for
+  REQUIRE(decoded.T.F == msg.T.F);
+  REQUIRE(decoded.T.D.size() == 0);
+  REQUIRE(decoded.encodedT.data() > tmp.data());
+  REQUIRE(decoded.encodedT.data() + decoded.encodedT.size() <= tmp.data() + buf.sz);
+
+  // encoding it again gives back exactly what we were sent
+  std::array<byte_t, llarp::MAX_LINK_MSG_SIZE> again = {{0}};
+  llarp_buffer_t againBuf(again);
+  REQUIRE(decoded.BEncode(&againBuf));
+  REQUIRE(size_t(againBuf.cur - againBuf.base) == buf.sz);
+  REQUIRE(std::equal(again.begin(), again.begin() + buf.sz, tmp.begin()));
+
+  // and the one pass decoder the parser uses reads the same
+  llarp::bencode::Reader reader{llarp::byte_view_t{tmp.data(), buf.sz}};
+  char key;
+  llarp::byte_view_t type;
+  REQUIRE(reader.Dict());
+  REQUIRE(reader.NextKey(key));
+  REQUIRE(key == 'A');
+  REQUIRE(reader.Bytes(type));
+  PathTransferMessage fast;
+  REQUIRE(fast.Decode(reader));
+  REQUIRE(fast.P == msg.P);
+  REQUIRE(fast.Y == msg.Y);
+  REQUIRE(fast.T.F == msg.T.F);
+  REQUIRE(fast.encodedT == decoded.encodedT);
+
+  decoded.Clear();
+  REQUIRE(decoded.encodedT.empty());
+}
@@ -1,5 +1,7 @@
 #include <llarp/routing/transfer_traffic_message.hpp>
 
+#include <oxenc/endian.h>
+
 #include <catch2/catch.hpp>
 
 using TransferTrafficMessage = llarp::routing::TransferTrafficMessage;
@@ -21,4 +23,31 @@ TEST_CASE("TransferTrafficMessage", "[TransferTrafficMessage]")
     llarp_buffer_t buf(tmp);
     REQUIRE(msg.PutBuffer(buf, 1));
   }
+
+  SECTION("Decoded packets point into the parsed buffer")
+  {
+    std::array<byte_t, 100> pkt;
+    pkt.fill(0x42);
+    REQUIRE(msg.PutBuffer(llarp_buffer_t{pkt}, 7));
+
+    std::array<byte_t, 1024> tmp = {{0}};
+    llarp_buffer_t buf(tmp);
+    REQUIRE(msg.BEncode(&buf));
+    buf.sz = buf.cur - buf.base;
+    buf.cur = buf.base;
+
+    TransferTrafficMessage decoded;
+    REQUIRE(llarp::bencode_decode_dict(decoded, &buf));
+    REQUIRE(decoded.X.empty());
+    REQUIRE(decoded.receivedX.size() == 1);
+    const auto& view = decoded.receivedX[0];
+    REQUIRE(view.size() == pkt.size() + 8);
+    REQUIRE(view.data() > tmp.data());
+    REQUIRE(view.data() + view.size() <= tmp.data() + buf.sz);
+    REQUIRE(oxenc::load_big_to_host<uint64_t>(view.data()) == 7);
+    REQUIRE(view[8] == 0x42);
+
+    decoded.Clear();
+    REQUIRE(decoded.receivedX.empty());
+  }
 }
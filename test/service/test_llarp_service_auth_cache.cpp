@@ -0,0 +1,87 @@
+#include <llarp/service/auth_cache.hpp>
+#include <test_util.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <cstring>
+
+using llarp::service::AuthCache;
+using llarp::service::AuthResult;
+using llarp::service::AuthResultCode;
+using namespace std::literals;
+
+TEST_CASE("AuthCache keeps accepted senders longer than rejected ones", "[service][auth]")
+{
+  AuthCache cache;
+  const auto good = llarp::test::makeBuf<AuthCache::Key_t>(0x01);
+  const auto bad = llarp::test::makeBuf<AuthCache::Key_t>(0x02);
+  const llarp_time_t now = 1000s;
+
+  REQUIRE_FALSE(cache.Get(good, now));
+  cache.Put(good, AuthResult{AuthResultCode::eAuthAccepted, "OK"}, now);
+  cache.Put(bad, AuthResult{AuthResultCode::eAuthRejected, "no"}, now);
+
+  auto hit = cache.Get(good, now + 1s);
+  REQUIRE(hit);
+  REQUIRE(hit->code == AuthResultCode::eAuthAccepted);
+  REQUIRE(hit->reason == "OK");
+  hit = cache.Get(bad, now + 1s);
+  REQUIRE(hit);
+  REQUIRE(hit->code == AuthResultCode::eAuthRejected);
+
+  REQUIRE_FALSE(cache.Get(bad, now + AuthCache::NegativeTTL));
+  REQUIRE(cache.Get(good, now + AuthCache::NegativeTTL));
+  REQUIRE_FALSE(cache.Get(good, now + AuthCache::DefaultPositiveTTL));
+
+  cache.Decay(now + AuthCache::DefaultPositiveTTL);
+  REQUIRE(cache.Size() == 0);
+  const auto status = cache.ExtractStatus();
+  REQUIRE(status["hits"].get<uint64_t>() == 2);
+  REQUIRE(status["negativeHits"].get<uint64_t>() == 1);
+}
+
+TEST_CASE("AuthCache keeps accepted senders for as long as it is told", "[service][auth]")
+{
+  AuthCache cache{1min};
+  const auto key = llarp::test::makeBuf<AuthCache::Key_t>(0x01);
+  const llarp_time_t now = 1000s;
+
+  cache.Put(key, AuthResult{AuthResultCode::eAuthAccepted, "OK"}, now);
+  REQUIRE(cache.Get(key, now + 1min - 1s));
+  REQUIRE_FALSE(cache.Get(key, now + 1min));
+}
+
+TEST_CASE("AuthCache asks again after an attempt that failed", "[service][auth]")
+{
+  AuthCache cache;
+  const auto key = llarp::test::makeBuf<AuthCache::Key_t>(0x01);
+  const llarp_time_t now = 1000s;
+
+  cache.Put(key, AuthResult{AuthResultCode::eAuthFailed, "no backend"}, now);
+  REQUIRE_FALSE(cache.Get(key, now));
+  cache.Put(key, AuthResult{AuthResultCode::eAuthRateLimit, "slow down"}, now);
+  REQUIRE_FALSE(cache.Get(key, now));
+  REQUIRE(cache.Size() == 0);
+}
+
+TEST_CASE("AuthCache holds only so many entries", "[service][auth]")
+{
+  AuthCache cache;
+  const llarp_time_t now = 1000s;
+  AuthCache::Key_t key;
+  for (size_t i = 0; i < AuthCache::MaxEntries; ++i)
+  {
+    std::memcpy(key.data(), &i, sizeof(i));
+    cache.Put(key, AuthResult{AuthResultCode::eAuthAccepted, "OK"}, now + 1ms * i);
+  }
+  REQUIRE(cache.Size() == AuthCache::MaxEntries);
+
+  // the one that would expire soonest makes way
+  const auto last = llarp::test::makeBuf<AuthCache::Key_t>(0x42);
+  cache.Put(last, AuthResult{AuthResultCode::eAuthAccepted, "OK"}, now + 5s);
+  REQUIRE(cache.Size() == AuthCache::MaxEntries);
+  REQUIRE(cache.Get(last, now + 5s));
+  key.Zero();
+  REQUIRE_FALSE(cache.Get(key, now + 5s));
+  REQUIRE(cache.ExtractStatus()["evictions"].get<uint64_t>() == 1);
+}
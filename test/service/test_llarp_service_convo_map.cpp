@@ -0,0 +1,112 @@
+#include <llarp/service/convo_map.hpp>
+#include <llarp/crypto/types.hpp>
+#include <test_util.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <set>
+
+using llarp::service::ConvoMap;
+using llarp::service::ConvoTag;
+
+static ConvoTag
+MakeTag(uint32_t n)
+{
+  ConvoTag tag;
+  std::copy_n(reinterpret_cast<const llarp::byte_t*>(&n), sizeof(n), tag.begin());
+  return tag;
+}
+
+static llarp::service::ServiceInfo
+MakeRemote(llarp::byte_t n)
+{
+  const auto sign = llarp::test::makeBuf<llarp::PubKey>(n);
+  const auto enc = llarp::test::makeBuf<llarp::PubKey>(n + 1);
+  llarp::service::ServiceInfo info;
+  info.Update(sign.data(), enc.data());
+  return info;
+}
+
+TEST_CASE("ConvoMap finds what it holds through growth and erasure", "[convomap]")
+{
+  ConvoMap map;
+  constexpr uint32_t N = 1000;
+  for (uint32_t i = 0; i < N; ++i)
+  {
+    auto [itr, inserted] = map.emplace(MakeTag(i), llarp::service::Session{});
+    REQUIRE(inserted);
+    itr->second.seqno = i;
+  }
+  REQUIRE(map.size() == N);
+  REQUIRE_FALSE(map.emplace(MakeTag(7), llarp::service::Session{}).second);
+
+  for (uint32_t i = 0; i < N; ++i)
+  {
+    const auto itr = map.find(MakeTag(i));
+    REQUIRE(itr != map.end());
+    REQUIRE(itr->second.seqno == i);
+  }
+  REQUIRE(map.find(MakeTag(N)) == map.end());
+
+  // erase the odd ones while iterating, as the expiry code does
+  size_t visited = 0;
+  for (auto itr = map.begin(); itr != map.end();)
+  {
+    ++visited;
+    if (itr->second.seqno % 2)
+      itr = map.erase(itr);
+    else
+      ++itr;
+  }
+  REQUIRE(visited == N);
+  REQUIRE(map.size() == N / 2);
+
+  std::set<uint64_t> seen;
+  for (const auto& [tag, session] : map)
+    REQUIRE(seen.insert(session.seqno).second);
+  REQUIRE(seen.size() == N / 2);
+
+  for (uint32_t i = 0; i < N; ++i)
+    REQUIRE(map.count(MakeTag(i)) == (i % 2 ? 0 : 1));
+
+  // erased slots get reused
+  for (uint32_t i = 1; i < N; i += 2)
+    map[MakeTag(i)].seqno = i;
+  REQUIRE(map.size() == N);
+  for (uint32_t i = 0; i < N; ++i)
+    REQUIRE(map.find(MakeTag(i))->second.seqno == i);
+}
+
+TEST_CASE("ConvoMap indexes tags by remote address", "[convomap]")
+{
+  ConvoMap map;
+  const auto alice = MakeRemote(0x01);
+  const auto bob = MakeRemote(0x10);
+
+  for (uint32_t i = 0; i < 3; ++i)
+    map.SetRemote(map.emplace(MakeTag(i), {}).first, alice);
+  map.SetRemote(map.emplace(MakeTag(3), {}).first, bob);
+  map.emplace(MakeTag(4), {});
+
+  REQUIRE(map.TagsFor(alice.Addr()).size() == 3);
+  REQUIRE(map.TagsFor(bob.Addr()).size() == 1);
+  REQUIRE(map.TagsFor(bob.Addr()).front() == MakeTag(3));
+
+  REQUIRE(map.erase(MakeTag(1)) == 1);
+  std::set<ConvoTag> tags{map.TagsFor(alice.Addr()).begin(), map.TagsFor(alice.Addr()).end()};
+  REQUIRE(tags == std::set<ConvoTag>{MakeTag(0), MakeTag(2)});
+
+  // moving a convo to another remote moves it in the index
+  map.SetRemote(map.find(MakeTag(0)), bob);
+  REQUIRE(map.TagsFor(alice.Addr()).size() == 1);
+  REQUIRE(map.TagsFor(bob.Addr()).size() == 2);
+
+  map.erase(MakeTag(3));
+  map.erase(MakeTag(0));
+  REQUIRE(map.TagsFor(bob.Addr()).empty());
+
+  map.clear();
+  REQUIRE(map.empty());
+  REQUIRE(map.TagsFor(alice.Addr()).empty());
+  REQUIRE(map.find(MakeTag(2)) == map.end());
+}
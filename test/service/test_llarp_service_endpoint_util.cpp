@@ -0,0 +1,52 @@
+#include <llarp/service/endpoint_util.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::service::ConvoMap;
+using llarp::service::ConvoTag;
+using llarp::service::EndpointUtil;
+using namespace std::literals;
+
+TEST_CASE("Convos expire off the wheel once idle for a lifetime", "[endpoint]")
+{
+  const auto now = llarp::time_now_ms();
+  ConvoMap sessions;
+  llarp::util::TimerWheel<ConvoTag> due{1s};
+
+  ConvoTag used, idle, forever, erased;
+  used.Randomize();
+  idle.Randomize();
+  forever.Randomize();
+  erased.Randomize();
+  for (const auto& tag : {used, idle, forever, erased})
+  {
+    sessions[tag];
+    due.Schedule(now, tag);
+  }
+  sessions[used].lastSend = now;
+  sessions[idle].intro.expiresAt = now + 10s;
+  sessions[forever].forever = true;
+  sessions.erase(erased);
+
+  // the ones still good are put back for when they would expire, the erased one is reported
+  auto gone = EndpointUtil::ExpireConvoSessions(now + 2s, due, sessions);
+  REQUIRE(gone == std::vector<ConvoTag>{erased});
+  REQUIRE(sessions.size() == 3);
+  REQUIRE(due.Size() == 3);
+
+  gone = EndpointUtil::ExpireConvoSessions(now + 12s, due, sessions);
+  REQUIRE(gone == std::vector<ConvoTag>{idle});
+  REQUIRE(sessions.count(idle) == 0);
+
+  // using it pushes its expiry back
+  sessions[used].lastRecv = now + 1min;
+  gone = EndpointUtil::ExpireConvoSessions(
+      now + llarp::service::SessionLifetime + 2s, due, sessions);
+  REQUIRE(gone.empty());
+  gone = EndpointUtil::ExpireConvoSessions(
+      now + llarp::service::SessionLifetime + 1min + 2s, due, sessions);
+  REQUIRE(gone == std::vector<ConvoTag>{used});
+  REQUIRE(sessions.size() == 1);
+  REQUIRE(sessions.count(forever) == 1);
+  REQUIRE(due.Size() == 1);
+}
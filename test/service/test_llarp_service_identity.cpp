@@ -3,6 +3,7 @@
 #include <sodium/crypto_scalarmult_ed25519.h>
 #include <llarp/path/path.hpp>
 #include <llarp/service/address.hpp>
+#include <llarp/service/async_key_exchange.hpp>
 #include <llarp/service/identity.hpp>
 #include <llarp/service/intro_set.hpp>
 #include <llarp/util/time.hpp>
@@ -230,4 +231,31 @@ TEST_CASE("Test sign and encrypt introset", "[crypto]")
   auto crypto = CryptoManager::instance();
   CHECK(crypto->derive_subkey(blind_key, root_key, 1));
   CHECK(blind_key == maybe->derivedSigningKey);
+  CHECK(blind_key == ident.derivedSignPubKey);
+  CHECK(dht::Key_t{blind_key.as_array()} == addr.ToKey());
+}
+
+TEST_CASE("Test pre-made PQ encapsulation", "[crypto]")
+{
+  CryptoManager manager(new sodium::CryptoLibSodium());
+
+  service::Identity ident;
+  ident.RegenerateKeys();
+  const PQPubKey pubkey{pq_keypair_to_public(ident.pq)};
+
+  const auto enc = service::PQEncapsulation::Make(pubkey);
+  REQUIRE(enc.has_value());
+  CHECK(enc->pubkey == pubkey);
+
+  // the remote gets the same session key out of it
+  SharedSecret shared;
+  REQUIRE(CryptoManager::instance()->pqe_decrypt(
+      enc->cipher, shared, pq_keypair_to_secret(ident.pq)));
+  CHECK(shared == enc->key);
+
+  // and every one is different
+  const auto other = service::PQEncapsulation::Make(pubkey);
+  REQUIRE(other.has_value());
+  CHECK(other->cipher != enc->cipher);
+  CHECK(other->key != enc->key);
 }
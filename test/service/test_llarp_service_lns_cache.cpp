@@ -0,0 +1,71 @@
+#include <llarp/service/lns_cache.hpp>
+#include <test_util.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::service::LNSCache;
+using namespace std::literals;
+
+TEST_CASE("LNSCache serves names, then stale ones, then forgets them", "[service][lns]")
+{
+  LNSCache cache;
+  const auto addr = llarp::test::makeBuf<llarp::service::Address>(0x42);
+  const llarp_time_t now = 1000s;
+
+  REQUIRE_FALSE(cache.Get("foo.loki", now));
+  cache.Put("foo.loki", LNSCache::Addr_t{addr}, now);
+
+  auto hit = cache.Get("foo.loki", now + 1s);
+  REQUIRE(hit);
+  REQUIRE_FALSE(hit->stale);
+  REQUIRE(std::get<llarp::service::Address>(*hit->value) == addr);
+
+  const auto expired = now + LNSCache::PositiveTTL;
+  hit = cache.Get("foo.loki", expired);
+  REQUIRE(hit);
+  REQUIRE(hit->stale);
+  REQUIRE(cache.StartRefresh("foo.loki", expired));
+  REQUIRE_FALSE(cache.StartRefresh("foo.loki", expired + 1s));
+  REQUIRE(cache.StartRefresh("foo.loki", expired + LNSCache::RefreshRetry));
+
+  cache.Decay(expired + LNSCache::StaleGrace);
+  REQUIRE_FALSE(cache.Get("foo.loki", expired + LNSCache::StaleGrace));
+}
+
+TEST_CASE("LNSCache keeps names that don't exist for a little while", "[service][lns]")
+{
+  LNSCache cache;
+  const llarp_time_t now = 1000s;
+  cache.Put("nope.loki", std::nullopt, now);
+
+  const auto hit = cache.Get("nope.loki", now + 1s);
+  REQUIRE(hit);
+  REQUIRE_FALSE(hit->value);
+
+  // and once gone, they are looked up again rather than served stale
+  REQUIRE_FALSE(cache.Get("nope.loki", now + LNSCache::NegativeTTL));
+  REQUIRE(cache.ExtractStatus()["negativeHits"].get<uint64_t>() == 1);
+}
+
+TEST_CASE("LNSCache prefetches hot names about to expire", "[service][lns]")
+{
+  LNSCache cache;
+  const auto addr = llarp::test::makeBuf<llarp::service::Address>(0x01);
+  const llarp_time_t now = 1000s;
+  cache.Put("hot.loki", LNSCache::Addr_t{addr}, now);
+  cache.Put("cold.loki", LNSCache::Addr_t{addr}, now);
+  for (uint64_t i = 0; i < LNSCache::PrefetchHits; ++i)
+    cache.Get("hot.loki", now + 1s);
+  cache.Get("cold.loki", now + 1s);
+
+  REQUIRE(cache.TakePrefetches(now + 1s).empty());
+
+  const auto soon = now + LNSCache::PositiveTTL - LNSCache::PrefetchWindow;
+  REQUIRE(cache.TakePrefetches(soon) == std::vector<std::string>{"hot.loki"});
+  // it is being refreshed now, so not again until that has had time to finish
+  REQUIRE(cache.TakePrefetches(soon + 1s).empty());
+
+  // a fresh lookup starts its count over
+  cache.Put("hot.loki", LNSCache::Addr_t{addr}, soon);
+  REQUIRE(cache.TakePrefetches(soon + LNSCache::PositiveTTL - LNSCache::PrefetchWindow).empty());
+}
@@ -0,0 +1,79 @@
+#include <llarp/service/lns_tracker.hpp>
+#include <test_util.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::service::LNSLookupTracker;
+using namespace std::literals;
+
+TEST_CASE("LNSLookupTracker settles on a majority or a disagreement", "[service][lns]")
+{
+  LNSLookupTracker tracker;
+  const LNSLookupTracker::Addr_t addr{llarp::test::makeBuf<llarp::service::Address>(0x42)};
+  const LNSLookupTracker::Addr_t other{llarp::test::makeBuf<llarp::service::Address>(0x43)};
+  std::vector<std::optional<LNSLookupTracker::Addr_t>> results;
+  const auto handler = [&results](auto result) { results.push_back(result); };
+
+  SECTION("A majority agreeing is enough")
+  {
+    auto found = tracker.MakeResultHandler("foo.loki", 5, handler);
+    found(addr);
+    found(std::nullopt);
+    found(addr);
+    REQUIRE(results.empty());
+    found(addr);
+    REQUIRE(results == std::vector{std::optional{addr}});
+    // late answers go nowhere, even with a new lookup of the name underway
+    auto again = tracker.MakeResultHandler("foo.loki", 2, handler);
+    found(other);
+    found(other);
+    REQUIRE(results.size() == 1);
+    again(addr);
+    again(addr);
+    REQUIRE(results.size() == 2);
+  }
+
+  SECTION("Peers that disagree fail it at once")
+  {
+    auto found = tracker.MakeResultHandler("foo.loki", 7, handler);
+    found(addr);
+    found(other);
+    REQUIRE(results == std::vector<std::optional<LNSLookupTracker::Addr_t>>{std::nullopt});
+  }
+
+  SECTION("One answer is taken once the rest have nothing")
+  {
+    auto found = tracker.MakeResultHandler("foo.loki", 3, handler);
+    found(std::nullopt);
+    found(addr);
+    found(std::nullopt);
+    REQUIRE(results == std::vector{std::optional{addr}});
+  }
+
+  SECTION("Asking again joins the lookup underway")
+  {
+    REQUIRE_FALSE(tracker.Join("foo.loki", handler));
+    auto found = tracker.MakeResultHandler("foo.loki", 2, handler);
+    REQUIRE(tracker.Join("foo.loki", handler));
+    found(addr);
+    found(addr);
+    REQUIRE(results == std::vector{std::optional{addr}, std::optional{addr}});
+    REQUIRE_FALSE(tracker.Join("foo.loki", handler));
+  }
+}
+
+TEST_CASE("LNSLookupTracker keeps how fast endpoints answer", "[service][lns]")
+{
+  LNSLookupTracker tracker;
+  const auto endpoint = llarp::test::makeBuf<llarp::RouterID>(0x01);
+  const llarp_time_t now = 1000s;
+  REQUIRE_FALSE(tracker.PathLatency(endpoint));
+  tracker.ObservePath(endpoint, 800ms, now);
+  REQUIRE(tracker.PathLatency(endpoint) == 800ms);
+  tracker.ObservePath(endpoint, 0ms, now);
+  REQUIRE(tracker.PathLatency(endpoint) == 700ms);
+  tracker.Decay(now + LNSLookupTracker::PathLatencyExpiry - 1s);
+  REQUIRE(tracker.PathLatency(endpoint));
+  tracker.Decay(now + LNSLookupTracker::PathLatencyExpiry);
+  REQUIRE_FALSE(tracker.PathLatency(endpoint));
+}
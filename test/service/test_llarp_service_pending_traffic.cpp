@@ -0,0 +1,66 @@
+#include <llarp/service/pendingbuffer.hpp>
+#include <test_util.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::service::Address;
+using llarp::service::PendingTraffic;
+using llarp::service::ProtocolType;
+
+static Address
+MakeAddress(llarp::byte_t n)
+{
+  return llarp::test::makeBuf<Address>(n);
+}
+
+static std::vector<llarp::byte_t>
+MakePacket(size_t sz, llarp::byte_t fill)
+{
+  return std::vector<llarp::byte_t>(sz, fill);
+}
+
+TEST_CASE("PendingTraffic drops the oldest of an address over its cap", "[service][pending]")
+{
+  PendingTraffic pending{1000, 300};
+  const auto addr = MakeAddress(1);
+  for (llarp::byte_t i = 0; i < 5; ++i)
+  {
+    auto pkt = MakePacket(100, i);
+    REQUIRE(pending.Push(addr, llarp_buffer_t{pkt}, ProtocolType::TrafficV4));
+  }
+  REQUIRE(pending.Bytes() == 300);
+
+  auto big = MakePacket(301, 0xff);
+  REQUIRE_FALSE(pending.Push(addr, llarp_buffer_t{big}, ProtocolType::TrafficV4));
+
+  const auto bufs = pending.Take(addr);
+  REQUIRE(bufs.size() == 3);
+  REQUIRE(bufs[0].payload == MakePacket(100, 2));
+  REQUIRE(bufs[2].payload == MakePacket(100, 4));
+  REQUIRE(pending.Bytes() == 0);
+  REQUIRE(pending.Take(addr).empty());
+
+  const auto status = pending.ExtractStatus();
+  REQUIRE(status["queued"].get<uint64_t>() == 5);
+  REQUIRE(status["sent"].get<uint64_t>() == 3);
+  REQUIRE(status["droppedOverBudget"].get<uint64_t>() == 3);
+}
+
+TEST_CASE("PendingTraffic drops the oldest overall over its budget", "[service][pending]")
+{
+  PendingTraffic pending{300, 200};
+  const auto a = MakeAddress(1);
+  const auto b = MakeAddress(2);
+  auto pkt = MakePacket(100, 0);
+  REQUIRE(pending.Push(a, llarp_buffer_t{pkt}, ProtocolType::TrafficV4));
+  REQUIRE(pending.Push(b, llarp_buffer_t{pkt}, ProtocolType::TrafficV4));
+  REQUIRE(pending.Push(a, llarp_buffer_t{pkt}, ProtocolType::TrafficV4));
+  // a's first packet is the oldest
+  REQUIRE(pending.Push(b, llarp_buffer_t{pkt}, ProtocolType::TrafficV4));
+  REQUIRE(pending.Bytes() == 300);
+  REQUIRE(pending.Take(b).size() == 2);
+
+  pending.Drop(a);
+  REQUIRE(pending.Bytes() == 0);
+  REQUIRE(pending.ExtractStatus()["droppedNoSession"].get<uint64_t>() == 1);
+}
@@ -0,0 +1,62 @@
+#include <llarp/service/protocol.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::service::AppendBatchEntry;
+using llarp::service::ProtocolMessage;
+using llarp::service::ProtocolType;
+using llarp::service::UnpackBatch;
+
+TEST_CASE("Batched messages unpack as they went in", "[service][batch]")
+{
+  std::vector<llarp::byte_t> one(40, 0x01);
+  std::vector<llarp::byte_t> two(512, 0x02);
+  std::vector<llarp::byte_t> empty;
+
+  ProtocolMessage batch;
+  batch.proto = ProtocolType::Batch;
+  batch.tag.Randomize();
+  AppendBatchEntry(batch.payload, ProtocolType::TrafficV4, 7, llarp_buffer_t{one});
+  AppendBatchEntry(batch.payload, ProtocolType::QUIC, 8, llarp_buffer_t{two});
+  AppendBatchEntry(batch.payload, ProtocolType::Control, 9, llarp_buffer_t{empty});
+  REQUIRE(batch.payload.size() == 3 * llarp::service::BatchEntryOverhead + 40 + 512);
+
+  const auto msgs = UnpackBatch(batch);
+  REQUIRE(msgs);
+  REQUIRE(msgs->size() == 3);
+  CHECK(msgs->at(0)->proto == ProtocolType::TrafficV4);
+  CHECK(msgs->at(0)->seqno == 7);
+  CHECK(msgs->at(0)->payload == one);
+  CHECK(msgs->at(1)->proto == ProtocolType::QUIC);
+  CHECK(msgs->at(1)->seqno == 8);
+  CHECK(msgs->at(1)->payload == two);
+  CHECK(msgs->at(2)->proto == ProtocolType::Control);
+  CHECK(msgs->at(2)->payload.empty());
+  for (const auto& msg : *msgs)
+    CHECK(msg->tag == batch.tag);
+}
+
+TEST_CASE("Malformed batches are rejected", "[service][batch]")
+{
+  std::vector<llarp::byte_t> data(16, 0x03);
+  ProtocolMessage batch;
+  batch.proto = ProtocolType::Batch;
+
+  SECTION("truncated payload")
+  {
+    AppendBatchEntry(batch.payload, ProtocolType::TrafficV4, 1, llarp_buffer_t{data});
+    batch.payload.pop_back();
+    REQUIRE_FALSE(UnpackBatch(batch));
+  }
+  SECTION("truncated header")
+  {
+    AppendBatchEntry(batch.payload, ProtocolType::TrafficV4, 1, llarp_buffer_t{data});
+    batch.payload.push_back(0x01);
+    REQUIRE_FALSE(UnpackBatch(batch));
+  }
+  SECTION("nested batch")
+  {
+    AppendBatchEntry(batch.payload, ProtocolType::Batch, 1, llarp_buffer_t{data});
+    REQUIRE_FALSE(UnpackBatch(batch));
+  }
+}
@@ -0,0 +1,129 @@
+#include <llarp/service/protocol.hpp>
+#include <llarp/service/shared_paths.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::path::Path;
+using llarp::path::Path_ptr;
+using llarp::service::ConvoTag;
+using namespace std::literals;
+
+namespace
+{
+  /// stands in for an OutboundContext
+  struct User
+  {
+    ConvoTag currentConvoTag;
+    std::vector<Path_ptr> tookOver;
+
+    explicit User(uint8_t tag)
+    {
+      currentConvoTag.Fill(tag);
+    }
+
+    bool
+    HandleHiddenServiceFrame(Path_ptr, const llarp::service::ProtocolFrame&)
+    {
+      return true;
+    }
+
+    bool
+    HandleDataDrop(Path_ptr, const llarp::PathID_t&, uint64_t)
+    {
+      return true;
+    }
+
+    void
+    TakeOverSharedPath(const Path_ptr& path)
+    {
+      tookOver.push_back(path);
+    }
+
+    std::string
+    Name() const
+    {
+      return "user";
+    }
+  };
+
+  using SharedPaths = llarp::service::SharedPaths<User>;
+
+  constexpr llarp_time_t now = 1h;
+
+  Path_ptr
+  MakeEstablished(char endpoint)
+  {
+    std::vector<llarp::RouterContact> hops(4);
+    for (auto& hop : hops)
+      hop.pubkey.Fill('a');
+    hops.back().pubkey.Fill(endpoint);
+    auto path = std::make_shared<Path>(hops, std::weak_ptr<llarp::path::PathSet>{}, 0, "test");
+    path->EnterState(llarp::path::ePathBuilding, now);
+    path->EnterState(llarp::path::ePathEstablished, now);
+    return path;
+  }
+
+  ConvoTag
+  Tag(uint8_t tag)
+  {
+    ConvoTag t;
+    t.Fill(tag);
+    return t;
+  }
+}  // namespace
+
+TEST_CASE("SharedPaths sends frames to the user whose convo they are for", "[service]")
+{
+  SharedPaths shared;
+  auto owner = std::make_shared<User>(1);
+  auto other = std::make_shared<User>(2);
+  const auto path = MakeEstablished('z');
+  shared.Offer(path, owner);
+
+  REQUIRE(shared.Acquire(path->Endpoint(), 4, other, now) == path);
+  // no taking it twice, nor taking one of a different length
+  REQUIRE_FALSE(shared.Acquire(path->Endpoint(), 4, other, now));
+  REQUIRE_FALSE(shared.Acquire(path->Endpoint(), 3, std::make_shared<User>(3), now));
+
+  REQUIRE(shared.FrameUser(path, Tag(1)) == owner);
+  REQUIRE(shared.FrameUser(path, Tag(2)) == other);
+  // a convo neither has goes to the owner
+  REQUIRE(shared.FrameUser(path, Tag(9)) == owner);
+}
+
+TEST_CASE("SharedPaths hands a path over when its owner goes", "[service]")
+{
+  SharedPaths shared;
+  auto owner = std::make_shared<User>(1);
+  auto other = std::make_shared<User>(2);
+  const auto path = MakeEstablished('z');
+  shared.Offer(path, owner);
+
+  SECTION("to the next user")
+  {
+    REQUIRE(shared.Acquire(path->Endpoint(), 4, other, now) == path);
+    const auto stillUsed = shared.Release(owner.get());
+    REQUIRE(stillUsed == std::vector<Path_ptr>{path});
+    REQUIRE(other->tookOver == std::vector<Path_ptr>{path});
+    REQUIRE(shared.FrameUser(path, Tag(1)) == other);
+
+    // the last one going takes it out altogether
+    REQUIRE(shared.Release(other.get()).empty());
+    REQUIRE(shared.Size() == 0);
+  }
+
+  SECTION("not when another user goes")
+  {
+    REQUIRE(shared.Acquire(path->Endpoint(), 4, other, now) == path);
+    // the owner still uses it
+    REQUIRE(shared.Release(other.get()) == std::vector<Path_ptr>{path});
+    REQUIRE(owner->tookOver.empty());
+    REQUIRE(shared.FrameUser(path, Tag(2)) == owner);
+  }
+
+  SECTION("to no one when no one else used it")
+  {
+    REQUIRE(shared.Release(owner.get()).empty());
+    REQUIRE(shared.Size() == 0);
+  }
+}
@@ -0,0 +1,93 @@
+#include "llarp_test.hpp"
+
+#include <llarp/bootstrap.hpp>
+#include <llarp/crypto/crypto.hpp>
+#include <llarp/util/time.hpp>
+
+#include <catch2/catch.hpp>
+
+using namespace llarp;
+
+namespace
+{
+  class BootstrapStreamTest : public test::LlarpTest<>
+  {
+   protected:
+    std::string
+    MakeRC()
+    {
+      RouterContact rc;
+      SecretKey sign, encr;
+      CryptoManager::instance()->identity_keygen(sign);
+      CryptoManager::instance()->encryption_keygen(encr);
+      rc.enckey = encr.toPublic();
+      rc.pubkey = sign.toPublic();
+      REQUIRE(rc.Sign(sign));
+      std::array<byte_t, MAX_RC_SIZE> tmp;
+      llarp_buffer_t buf{tmp};
+      REQUIRE(rc.BEncode(&buf));
+      return std::string{reinterpret_cast<const char*>(tmp.data()), buf.cur - buf.base};
+    }
+  };
+}  // namespace
+
+TEST_CASE_METHOD(BootstrapStreamTest, "BootstrapStream decodes as bytes come", "[bootstrap]")
+{
+  const auto first = MakeRC();
+  const auto second = MakeRC();
+  BootstrapStream stream;
+
+  SECTION("A list a byte at a time")
+  {
+    const auto file = "l" + first + second + "e";
+    for (size_t i = 0; i < file.size(); ++i)
+    {
+      REQUIRE_FALSE(stream.Complete());
+      REQUIRE(stream.Feed(std::string_view{file}.substr(i, 1)));
+      // each rc is there as soon as its last byte is
+      if (i == first.size())
+        REQUIRE(stream.RCs().size() == 1);
+    }
+    REQUIRE(stream.Complete());
+    REQUIRE(stream.RCs().size() == 2);
+  }
+
+  SECTION("One rc on its own")
+  {
+    REQUIRE(stream.Feed(std::string_view{first}.substr(0, 10)));
+    REQUIRE(stream.Feed(std::string_view{first}.substr(10)));
+    REQUIRE(stream.Complete());
+    REQUIRE(stream.RCs().size() == 1);
+  }
+
+  SECTION("Badly signed rcs are left out")
+  {
+    auto bad = second;
+    // in the signature, which goes last before the dict's end
+    bad[bad.size() - 2] ^= 1;
+    REQUIRE(stream.Feed("l" + first + bad + "e"));
+    REQUIRE(stream.Complete());
+    REQUIRE(stream.RCs().size() == 1);
+    REQUIRE(stream.Rejected() == 1);
+  }
+
+  SECTION("What isn't a bootstrap file fails at once")
+  {
+    REQUIRE_FALSE(stream.Feed("<html>"));
+    REQUIRE(stream.Failed());
+    REQUIRE_FALSE(stream.Feed("l" + first + "e"));
+  }
+
+  SECTION("Nothing goes after the end")
+  {
+    REQUIRE_FALSE(stream.Feed("l" + first + "e" + "l"));
+    REQUIRE(stream.Failed());
+  }
+
+  SECTION("Something else in the list fails it")
+  {
+    REQUIRE(stream.Feed("l" + first));
+    REQUIRE_FALSE(stream.Feed("i42ee"));
+    REQUIRE(stream.Failed());
+  }
+}
@@ -53,3 +53,34 @@ TEST_CASE_METHOD(FrameTest, "Frame crypto")
   REQUIRE(otherRecord.BDecode(buf));
   REQUIRE(otherRecord == record);
 }
+
+TEST_CASE("Frames copy and move what is in them", "[crypto]")
+{
+  EncryptedFrame f{100};
+  f.Fill(7);
+
+  EncryptedFrame copied{f};
+  REQUIRE(copied == f);
+  REQUIRE(copied.Buffer()->base == copied.data());
+
+  EncryptedFrame moved{std::move(copied)};
+  REQUIRE(moved == f);
+
+  std::array<EncryptedFrame, 3> frames{EncryptedFrame{10}, EncryptedFrame{20}, f};
+  std::move(frames.begin() + 1, frames.end(), frames.begin());
+  REQUIRE(frames[0].size() == 20 + EncryptedFrameOverheadSize);
+  REQUIRE(frames[1] == f);
+  REQUIRE(frames[1].Buffer()->sz == f.size());
+}
+
+TEST_CASE("Growing a frame zeroes what it grows by", "[crypto]")
+{
+  EncryptedFrame f{100};
+  f.Fill(7);
+  const auto sz = f.size();
+  f.Resize(sz - 50);
+  f.Resize(sz);
+  REQUIRE(f.data()[sz - 51] == 7);
+  REQUIRE(f.data()[sz - 50] == 0);
+  REQUIRE(f.data()[sz - 1] == 0);
+}
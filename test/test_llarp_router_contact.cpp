@@ -32,6 +32,30 @@ TEST_CASE("RouterContact Sign and Verify", "[RC][RouterContact][signature][sign]
   REQUIRE(rc.Verify(time_now_ms()));
 }
 
+TEST_CASE("RouterContact knows when it signs the same again", "[RC][RouterContact][sign]")
+{
+  RouterContact rc;
+
+  SecretKey sign;
+  cmanager.instance()->identity_keygen(sign);
+
+  SecretKey encr;
+  cmanager.instance()->encryption_keygen(encr);
+
+  rc.enckey = encr.toPublic();
+  rc.pubkey = sign.toPublic();
+  REQUIRE(rc.Sign(sign));
+
+  RouterContact fresh = rc;
+  fresh.last_updated += 1min;
+  fresh.signature.Zero();
+  REQUIRE(rc.SignsSameAs(fresh));
+
+  cmanager.instance()->encryption_keygen(encr);
+  fresh.enckey = encr.toPublic();
+  REQUIRE_FALSE(rc.SignsSameAs(fresh));
+}
+
 TEST_CASE("RouterContact Decode Version 1", "[RC][RouterContact][V1]")
 {
   RouterContact rc;
@@ -123,4 +147,93 @@ TEST_CASE("RouterContact Decode Mixed Versions", "[RC][RouterContact]")
     REQUIRE(rc_vec[i] == rc_vec_out[i]);
 }
 
+TEST_CASE("RouterContact keeps its wire encoding", "[RC][RouterContact]")
+{
+  auto encode = [](const RouterContact& rc) {
+    std::array<byte_t, MAX_RC_SIZE> tmp;
+    llarp_buffer_t buf{tmp};
+    REQUIRE(rc.BEncode(&buf));
+    return std::string{reinterpret_cast<const char*>(tmp.data()), size_t(buf.cur - buf.base)};
+  };
+
+  for (uint64_t version : {0, 1})
+  {
+    INFO(version);
+    RouterContact rc;
+    rc.version = version;
+    SecretKey sign, encr;
+    cmanager.instance()->identity_keygen(sign);
+    cmanager.instance()->encryption_keygen(encr);
+    rc.enckey = encr.toPublic();
+    REQUIRE_FALSE(rc.CachedEncoding());
+    REQUIRE(rc.Sign(sign));
+
+    const auto wire = encode(rc);
+    REQUIRE(rc.CachedEncoding() == std::string_view{wire});
+
+    // what we decode keeps what it was decoded from, and copies share it
+    RouterContact decoded;
+    llarp_buffer_t buf{wire};
+    REQUIRE(decoded.BDecode(&buf));
+    REQUIRE(decoded.CachedEncoding() == std::string_view{wire});
+    const RouterContact copy = decoded;
+    REQUIRE(copy.CachedEncoding()->data() == decoded.CachedEncoding()->data());
+    REQUIRE(copy.Verify(time_now_ms()));
+
+    // signing again gives a new encoding, which the copies from before do not see
+    rc.SetNick("renamed");
+    REQUIRE(rc.Sign(sign));
+    const auto resigned = encode(rc);
+    REQUIRE(resigned != wire);
+    REQUIRE(rc.CachedEncoding() == std::string_view{resigned});
+    REQUIRE(encode(copy) == wire);
+
+    // changing the signature stops it being used, and verifying looks at the fields themselves
+    decoded.last_updated += 1s;
+    decoded.signature.Randomize();
+    REQUIRE_FALSE(decoded.CachedEncoding());
+    REQUIRE(encode(decoded) != wire);
+    REQUIRE_FALSE(decoded.VerifySignature());
+  }
+}
+
+TEST_CASE("RouterContact batch Verify", "[RC][RouterContact][signature][verify]")
+{
+  // enough of them that the signatures get split across threads
+  std::vector<RouterContact> rcs(300);
+  for (size_t i = 0; i < rcs.size(); i++)
+  {
+    auto& rc = rcs[i];
+    rc.version = i % 2;
+    SecretKey sign, encr;
+    cmanager.instance()->identity_keygen(sign);
+    cmanager.instance()->encryption_keygen(encr);
+    rc.enckey = encr.toPublic();
+    rc.pubkey = sign.toPublic();
+    REQUIRE(rc.Sign(sign));
+  }
+  // break a few of them
+  rcs[7].signature.Randomize();
+  rcs[150].pubkey = rcs[151].pubkey;
+  rcs[299].version = 2;
+  rcs[43].last_updated = 0s;
+
+  const auto sigs = RouterContact::VerifySignatures(rcs);
+  const auto all = RouterContact::VerifyAll(rcs, time_now_ms(), false);
+  REQUIRE(sigs.size() == rcs.size());
+  REQUIRE(all.size() == rcs.size());
+  for (size_t i = 0; i < rcs.size(); i++)
+  {
+    INFO(i);
+    REQUIRE(sigs[i] == rcs[i].VerifySignature());
+    REQUIRE(all[i] == rcs[i].Verify(time_now_ms(), false));
+  }
+  REQUIRE_FALSE(sigs[7]);
+  REQUIRE_FALSE(sigs[150]);
+  REQUIRE(sigs[151]);
+  REQUIRE_FALSE(sigs[299]);
+  REQUIRE(sigs[43]);
+  REQUIRE_FALSE(all[43]);
+}
+
 } // namespace llarp
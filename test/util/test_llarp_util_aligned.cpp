@@ -108,6 +108,25 @@ TEMPLATE_LIST_TEST_CASE("AlignedBuffer", "[AlignedBuffer]", TestSizes)
     CHECK(c > b);
   }
 
+  SECTION("OrdersAsTheBytesDo")
+  {
+    // buffers that only differ late, and in the tail past the last whole word
+    for (size_t pos : {size_t{0}, TestType::value / 2, TestType::value - 1})
+    {
+      Buffer c, d, us;
+      c.Randomize();
+      d = c;
+      d[pos] ^= 0x80;
+      us.Randomize();
+      CHECK((c < d) == (c.as_array() < d.as_array()));
+      CHECK((c > d) == (c.as_array() > d.as_array()));
+      CHECK(c != d);
+      CHECK(us.XorCloser(c, d) == ((c ^ us).as_array() < (d ^ us).as_array()));
+      CHECK(us.XorCloser(d, c) == ((d ^ us).as_array() < (c ^ us).as_array()));
+      CHECK_FALSE(us.XorCloser(c, c));
+    }
+  }
+
   SECTION("Xor")
   {
     Buffer c;
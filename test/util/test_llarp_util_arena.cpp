@@ -0,0 +1,62 @@
+#include <llarp/util/arena.hpp>
+
+#include <cstdint>
+#include <set>
+#include <catch2/catch.hpp>
+
+using llarp::util::Arena;
+using llarp::util::ArenaAllocator;
+
+TEST_CASE("Arena gives back what a scope allocated when it ends", "[util][arena]")
+{
+  Arena arena;
+  REQUIRE_FALSE(arena.InScope());
+  void* first;
+  {
+    Arena::Scope scope{arena};
+    REQUIRE(arena.InScope());
+    first = arena.Allocate(24);
+    auto* second = arena.Make<uint64_t>(42);
+    REQUIRE(*second == 42);
+    REQUIRE(reinterpret_cast<uintptr_t>(second) % alignof(uint64_t) == 0);
+    REQUIRE(static_cast<void*>(second) != first);
+    {
+      Arena::Scope inner{arena};
+      auto* nested = arena.Allocate(8);
+      // the inner scope only rewinds to where it started
+      Arena::Scope again{arena};
+      REQUIRE(arena.Allocate(8) != nested);
+    }
+    REQUIRE(arena.InScope());
+  }
+  REQUIRE_FALSE(arena.InScope());
+  Arena::Scope scope{arena};
+  REQUIRE(arena.Allocate(24) == first);
+}
+
+TEST_CASE("Arena grows for bursts and trims once it is idle", "[util][arena]")
+{
+  Arena arena;
+  {
+    Arena::Scope scope{arena};
+    for (size_t idx = 0; idx < Arena::KeepBlocks * 4; ++idx)
+      arena.Allocate(Arena::BlockSize / 2 + 1);
+    auto* big = static_cast<char*>(arena.Allocate(Arena::BlockSize * 3, 64));
+    REQUIRE(reinterpret_cast<uintptr_t>(big) % 64 == 0);
+    big[Arena::BlockSize * 3 - 1] = 1;
+    REQUIRE(arena.Blocks() > Arena::KeepBlocks);
+  }
+  REQUIRE(arena.Blocks() == Arena::KeepBlocks);
+}
+
+TEST_CASE("ArenaAllocator backs std containers", "[util][arena]")
+{
+  Arena arena;
+  Arena::Scope scope{arena};
+  std::set<int, std::less<int>, ArenaAllocator<int>> set{ArenaAllocator<int>{arena}};
+  for (int idx = 100; idx > 0; --idx)
+    set.insert(idx);
+  REQUIRE(set.size() == 100);
+  REQUIRE(*set.begin() == 1);
+  REQUIRE(arena.Blocks() == 1);
+}
@@ -1,6 +1,9 @@
 #include <llarp/util/bencode.h>
 #include <llarp/util/bencode.hpp>
+#include <llarp/util/bencode_span.hpp>
 
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -375,3 +378,78 @@ TEST_CASE("Read dict to empty buffer", "[bencode]")
   REQUIRE_FALSE(
       llarp::bencode_read_dict([](llarp_buffer_t*, llarp_buffer_t*) { return true; }, &buf));
 }
+
+TEST_CASE("bencode::Writer writes what the buffer helpers do", "[bencode]")
+{
+  const std::string payload(300, 'x');
+  std::array<byte_t, 512> tmp;
+  llarp_buffer_t old{tmp};
+  REQUIRE(bencode_start_dict(&old));
+  REQUIRE(llarp::BEncodeWriteDictMsgType(&old, "a", "u"));
+  REQUIRE(llarp::BEncodeWriteDictInt("v", uint64_t{18446744073709551615ULL}, &old));
+  REQUIRE(llarp::BEncodeWriteDictString("x", payload, &old));
+  REQUIRE(bencode_end(&old));
+
+  std::array<byte_t, 512> out;
+  llarp_buffer_t buf{out};
+  llarp::bencode::Writer w{buf};
+  w.Dict()
+      .Key('a')
+      .Bytes("u", 1)
+      .Key('v')
+      .Int(18446744073709551615ULL)
+      .Key('x')
+      .Bytes(payload)
+      .End();
+  REQUIRE(w.Commit(&buf));
+  REQUIRE(buf.cur - buf.base == old.cur - old.base);
+  REQUIRE(std::equal(buf.base, buf.cur, old.base));
+
+  // out of room, it writes nothing past the end and leaves the buffer be
+  llarp_buffer_t small{out.data(), 100};
+  llarp::bencode::Writer w2{small};
+  w2.Dict().Key('x').Bytes(payload).End();
+  REQUIRE_FALSE(w2.Ok());
+  REQUIRE_FALSE(w2.Commit(&small));
+  REQUIRE(small.cur == small.base);
+}
+
+TEST_CASE("bencode::Reader walks a dict once, borrowing from it", "[bencode]")
+{
+  const std::string input = "d1:ai42e1:bl2:hie2:zzd1:qi1ee1:c3:abce";
+  llarp::bencode::Reader r{
+      llarp::byte_view_t{reinterpret_cast<const byte_t*>(input.data()), input.size()}};
+  REQUIRE(r.Dict());
+  char key;
+  uint64_t a;
+  REQUIRE(r.NextKey(key));
+  REQUIRE(key == 'a');
+  REQUIRE(r.Int(a));
+  REQUIRE(a == 42);
+  REQUIRE(r.NextKey(key));
+  REQUIRE(key == 'b');
+  REQUIRE(r.Skip());
+  // not a single character, so no key of ours
+  REQUIRE(r.NextKey(key));
+  REQUIRE(key == 0);
+  REQUIRE(r.Skip());
+  REQUIRE(r.NextKey(key));
+  REQUIRE(key == 'c');
+  llarp::byte_view_t c;
+  REQUIRE_FALSE(llarp::bencode::Reader{r}.Bytes(c, 2));
+  REQUIRE(r.Bytes(c));
+  REQUIRE(c.size() == 3);
+  REQUIRE(reinterpret_cast<const char*>(c.data()) == input.data() + input.size() - 4);
+  REQUIRE_FALSE(r.NextKey(key));
+  REQUIRE_FALSE(r.Failed());
+
+  for (std::string bad : {"d1:a", "d1:ai4", "d1:a9:abce", "d1:ai-1ee", "di1e"})
+  {
+    llarp::bencode::Reader b{
+        llarp::byte_view_t{reinterpret_cast<const byte_t*>(bad.data()), bad.size()}};
+    bool ok = b.Dict();
+    while (ok and b.NextKey(key))
+      ok = b.Skip();
+    REQUIRE(b.Failed());
+  }
+}
@@ -0,0 +1,68 @@
+#include <llarp/util/buffer_pool.hpp>
+#include <llarp/net/ip_packet.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::util::BufferPool;
+
+TEST_CASE("BufferPool reuses released buffers", "[util][buffer_pool]")
+{
+  auto buf = BufferPool::Acquire(1000);
+  REQUIRE(buf.size() == 1000);
+  buf[0] = 0xff;
+  const auto* ptr = buf.data();
+  BufferPool::Release(buf);
+  REQUIRE(buf.empty());
+
+  const auto hits = BufferPool::ExtractStatus()["hits"].get<uint64_t>();
+  auto again = BufferPool::Acquire(500);
+  REQUIRE(again.data() == ptr);
+  REQUIRE(again.size() == 500);
+  REQUIRE(again[0] == 0);
+  REQUIRE(BufferPool::ExtractStatus()["hits"].get<uint64_t>() == hits + 1);
+  BufferPool::Release(again);
+}
+
+TEST_CASE("BufferPool copies data in", "[util][buffer_pool]")
+{
+  const std::vector<byte_t> src{1, 2, 3, 4, 5};
+  auto buf = BufferPool::Acquire(src.data(), src.size());
+  REQUIRE(buf == src);
+  BufferPool::Release(buf);
+}
+
+TEST_CASE("BufferPool does not keep oversized buffers", "[util][buffer_pool]")
+{
+  const auto status = BufferPool::ExtractStatus();
+  const auto misses = status["misses"].get<uint64_t>();
+  const auto freed = status["freed"].get<uint64_t>();
+  auto buf = BufferPool::Acquire(1024 * 1024);
+  REQUIRE(buf.size() == 1024 * 1024);
+  BufferPool::Release(buf);
+  const auto after = BufferPool::ExtractStatus();
+  REQUIRE(after["misses"].get<uint64_t>() == misses + 1);
+  REQUIRE(after["freed"].get<uint64_t>() == freed + 1);
+}
+
+TEST_CASE("IPPacket buffers come from the pool and go back to it", "[util][buffer_pool]")
+{
+  const byte_t* ptr;
+  {
+    llarp::net::IPPacket pkt{size_t{100}};
+    ptr = pkt.data();
+    pkt.data()[0] = 0x45;
+
+    // moving hands the buffer over, copying takes another
+    auto moved = std::move(pkt);
+    REQUIRE(moved.data() == ptr);
+    REQUIRE(pkt.empty());
+    llarp::net::IPPacket copy{moved};
+    REQUIRE(copy.size() == 100);
+    REQUIRE(copy.data() != ptr);
+    REQUIRE(copy.data()[0] == 0x45);
+  }
+  // the last one given back is the first one out again
+  llarp::net::IPPacket pkt{size_t{100}};
+  REQUIRE(pkt.data() == ptr);
+  REQUIRE(pkt.data()[0] == 0);
+}
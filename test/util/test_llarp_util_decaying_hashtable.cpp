@@ -0,0 +1,72 @@
+#include <llarp/util/decaying_hashtable.hpp>
+#include <llarp/router_id.hpp>
+#include <catch2/catch.hpp>
+
+#include <map>
+#include <random>
+
+TEST_CASE("DecayingHashTable keeps what is refreshed", "[decaying-hashtable]")
+{
+  static constexpr auto timeout = 5s;
+  static constexpr auto now = 1s;
+  llarp::util::DecayingHashTable<llarp::RouterID, int> table{timeout};
+  const llarp::RouterID used{}, unused{(~used).as_array()};
+  REQUIRE(table.Put(used, 1, now));
+  REQUIRE(table.Put(unused, 2, now));
+  REQUIRE_FALSE(table.Put(used, 3, now));
+
+  REQUIRE(table.GetAndRefresh(used, now + 4s) == 1);
+  table.Decay(now + timeout);
+  REQUIRE(table.Get(used) == 1);
+  REQUIRE_FALSE(table.Has(unused));
+  table.Decay(now + 4s + timeout);
+  REQUIRE_FALSE(table.Has(used));
+  REQUIRE_FALSE(table.GetAndRefresh(used, now + 4s + timeout));
+}
+
+TEST_CASE("DecayingHashTable agrees with a map", "[decaying-hashtable]")
+{
+  static constexpr auto timeout = 10s;
+  // few keys with a bad hash, so that probes run into each other and erases have to shift them
+  struct BadHash
+  {
+    size_t
+    operator()(int k) const
+    {
+      return k % 7;
+    }
+  };
+  llarp::util::DecayingHashTable<int, int, BadHash> table{timeout};
+  std::map<int, std::pair<int, llarp_time_t>> model;
+  std::mt19937 rng{1234};
+  llarp_time_t now = 1s;
+  for (int i = 0; i < 20000; ++i)
+  {
+    const int key = rng() % 200;
+    switch (rng() % 4)
+    {
+      case 0:
+        REQUIRE(table.Put(key, i, now) == model.try_emplace(key, i, now).second);
+        break;
+      case 1:
+        table.Remove(key);
+        model.erase(key);
+        break;
+      case 2:
+        if (auto itr = model.find(key); itr != model.end())
+          itr->second.second = now;
+        REQUIRE(
+            table.GetAndRefresh(key, now)
+            == (model.count(key) ? std::optional{model[key].first} : std::nullopt));
+        break;
+      default:
+        now += std::chrono::milliseconds{rng() % 500};
+        table.Decay(now);
+        for (auto itr = model.begin(); itr != model.end();)
+          itr = itr->second.second + timeout <= now ? model.erase(itr) : std::next(itr);
+    }
+    REQUIRE(table.Size() == model.size());
+  }
+  for (const auto& [key, value] : model)
+    REQUIRE(table.Get(key) == value.first);
+}
@@ -0,0 +1,75 @@
+#include <llarp/util/histogram.hpp>
+
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+
+using llarp::util::Histogram;
+
+TEST_CASE("Histogram buckets", "[histogram]")
+{
+  // small values are exact
+  for (uint64_t v = 0; v < 16; ++v)
+  {
+    REQUIRE(Histogram::BucketFor(v) == v);
+    REQUIRE(Histogram::BucketTop(v) == v);
+  }
+  // above that every value lands in a bucket that holds it, within 12.5%
+  for (uint64_t v = 16; v < (uint64_t{1} << 32); v = v * 3 / 2 + 1)
+  {
+    const auto bucket = Histogram::BucketFor(v);
+    REQUIRE(bucket < Histogram::Buckets);
+    REQUIRE(Histogram::BucketTop(bucket) >= v);
+    REQUIRE(Histogram::BucketTop(bucket) - v <= v / 8);
+    REQUIRE((bucket == 0 or Histogram::BucketTop(bucket - 1) < v));
+  }
+  // oversized values go in the top bucket
+  REQUIRE(Histogram::BucketFor(~uint64_t{0}) == Histogram::Buckets - 1);
+}
+
+TEST_CASE("Histogram percentiles and draining", "[histogram]")
+{
+  Histogram hist;
+  REQUIRE(hist.Percentile(0.5) == 0);
+  for (uint64_t v = 1; v <= 1000; ++v)
+    hist.Record(v);
+  REQUIRE(hist.Count() == 1000);
+  REQUIRE(hist.Max() == 1000);
+  REQUIRE(hist.Mean() == Approx(500.5));
+  REQUIRE(hist.Percentile(0.5) >= 500);
+  REQUIRE(hist.Percentile(0.5) <= 500 * 9 / 8);
+  REQUIRE(hist.Percentile(0.99) >= 990);
+  REQUIRE(hist.Percentile(1.0) == 1000);
+
+  Histogram total;
+  hist.DrainInto(total);
+  REQUIRE(hist.Count() == 0);
+  REQUIRE(hist.Max() == 0);
+  REQUIRE(total.Count() == 1000);
+  REQUIRE(total.Max() == 1000);
+
+  const auto status = total.ExtractStatus();
+  REQUIRE(status.at("count") == 1000);
+  REQUIRE(status.at("max") == 1000);
+}
+
+TEST_CASE("Histogram concurrent recording", "[histogram]")
+{
+  Histogram hist, total;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&hist] {
+      for (uint64_t v = 0; v < 10000; ++v)
+        hist.Record(v);
+    });
+  }
+  // draining while others record loses nothing
+  for (int i = 0; i < 100; ++i)
+    hist.DrainInto(total);
+  for (auto& t : threads)
+    t.join();
+  hist.DrainInto(total);
+  REQUIRE(total.Count() == 40000);
+  REQUIRE(total.Max() == 9999);
+}
@@ -0,0 +1,20 @@
+#include <llarp/util/logging/rate_limit.hpp>
+#include <catch2/catch.hpp>
+
+using llarp::logging::RateLimit;
+using namespace std::literals;
+
+TEST_CASE("RateLimit lets one message through an interval", "[logging]")
+{
+  RateLimit limit{1s};
+  const RateLimit::Clock_t::time_point start{100s};
+
+  REQUIRE(limit.Allow(start) == 0);
+  REQUIRE_FALSE(limit.Allow(start));
+  REQUIRE_FALSE(limit.Allow(start + 999ms));
+
+  // and says how many it held back since the last one
+  REQUIRE(limit.Allow(start + 1s) == 2);
+  REQUIRE_FALSE(limit.Allow(start + 1s));
+  REQUIRE(limit.Allow(start + 1h) == 1);
+}
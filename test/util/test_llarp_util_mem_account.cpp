@@ -0,0 +1,58 @@
+#include <llarp/util/mem_account.hpp>
+
+#include <vector>
+#include <catch2/catch.hpp>
+
+using namespace std::literals;
+using llarp::util::MemAccount;
+using llarp::util::MemTag;
+
+TEST_CASE("MemAccount counts what tagged allocators hold", "[util][mem_account]")
+{
+  REQUIRE(llarp::util::ToString(MemTag::QUIC) == "quic");
+  REQUIRE(llarp::util::MemTagFromString("dns") == MemTag::DNS);
+  REQUIRE_FALSE(llarp::util::MemTagFromString("heap"));
+
+  const auto before = MemAccount::Live(MemTag::Path);
+  {
+    std::vector<uint64_t, llarp::util::TaggedAllocator<uint64_t, MemTag::Path>> vec;
+    vec.reserve(100);
+    REQUIRE(MemAccount::Live(MemTag::Path) == before + 100 * sizeof(uint64_t));
+  }
+  REQUIRE(MemAccount::Live(MemTag::Path) == before);
+
+  MemAccount::Allocated(MemTag::Path, 10);
+  REQUIRE(MemAccount::Live(MemTag::Path) == before + 10);
+  MemAccount::Freed(MemTag::Path, 10);
+  REQUIRE(MemAccount::Live(MemTag::Path) == before);
+}
+
+TEST_CASE("MemAccount sheds over soft limits", "[util][mem_account]")
+{
+  std::vector<size_t> asked;
+  auto handle = MemAccount::AddShedder(MemTag::DNS, [&asked](size_t over) {
+    asked.push_back(over);
+    MemAccount::Freed(MemTag::DNS, over);
+  });
+  const auto base = MemAccount::Live(MemTag::DNS);
+  MemAccount::SetSoftLimit(MemTag::DNS, base + 1000);
+
+  MemAccount::Allocated(MemTag::DNS, 500);
+  MemAccount::Tick(1s);
+  REQUIRE(asked.empty());
+
+  MemAccount::Allocated(MemTag::DNS, 700);
+  MemAccount::Tick(2s);
+  REQUIRE(asked == std::vector<size_t>{200});
+  REQUIRE(MemAccount::Live(MemTag::DNS) == base + 1000);
+
+  // and once the handle goes, so does the shedder
+  handle.reset();
+  MemAccount::Allocated(MemTag::DNS, 100);
+  MemAccount::Tick(3s);
+  REQUIRE(asked.size() == 1);
+
+  MemAccount::SetSoftLimit(MemTag::DNS, 0);
+  MemAccount::Freed(MemTag::DNS, 1100);
+  REQUIRE(MemAccount::Live(MemTag::DNS) == base);
+}
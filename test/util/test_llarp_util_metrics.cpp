@@ -0,0 +1,68 @@
+#include <llarp/util/metrics.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+
+using namespace llarp;
+
+TEST_CASE("metrics::Counter sums what every thread adds", "[util][metrics]")
+{
+  metrics::Counter counter{"lokinet_test_counter_total", "a test counter"};
+  std::vector<std::thread> threads;
+  for (size_t idx = 0; idx < metrics::Counter::Shards + 4; ++idx)
+  {
+    threads.emplace_back([&counter] {
+      for (int n = 0; n < 1000; ++n)
+        counter.Inc();
+      counter.Inc(10);
+    });
+  }
+  for (auto& t : threads)
+    t.join();
+  REQUIRE(counter.Value() == (metrics::Counter::Shards + 4) * 1010);
+  const auto status = metrics::ExtractStatus();
+  REQUIRE(status["lokinet_test_counter_total"].get<uint64_t>() == counter.Value());
+}
+
+TEST_CASE("metrics render in prometheus' text format", "[util][metrics]")
+{
+  metrics::Gauge gauge{"lokinet_test_gauge", "a test gauge"};
+  metrics::Histogram histogram{"lokinet_test_latency_microseconds", "a test histogram"};
+  gauge.Set(5);
+  gauge.Add(-7);
+  for (uint64_t value : {0, 3, 100, 100, 5000})
+    histogram.Record(value);
+
+  const auto text = metrics::Prometheus();
+  REQUIRE(text.find("# HELP lokinet_test_gauge a test gauge\n# TYPE lokinet_test_gauge gauge\n"
+                    "lokinet_test_gauge -2\n")
+          != std::string::npos);
+  REQUIRE(text.find("# TYPE lokinet_test_latency_microseconds histogram\n") != std::string::npos);
+  REQUIRE(text.find("lokinet_test_latency_microseconds_bucket{le=\"0\"} 1\n") != std::string::npos);
+  REQUIRE(text.find("lokinet_test_latency_microseconds_bucket{le=\"3\"} 2\n") != std::string::npos);
+  REQUIRE(
+      text.find("lokinet_test_latency_microseconds_bucket{le=\"127\"} 4\n") != std::string::npos);
+  REQUIRE(
+      text.find("lokinet_test_latency_microseconds_bucket{le=\"+Inf\"} 5\n") != std::string::npos);
+  REQUIRE(text.find("lokinet_test_latency_microseconds_sum 5203\n") != std::string::npos);
+  REQUIRE(text.find("lokinet_test_latency_microseconds_count 5\n") != std::string::npos);
+  // the gauge sorts before the histogram
+  REQUIRE(text.find("lokinet_test_gauge") < text.find("lokinet_test_latency"));
+
+  // reading doesn't lose what was read before
+  histogram.Record(1);
+  const auto status = histogram.ExtractStatus();
+  REQUIRE(status["count"].get<uint64_t>() == 6);
+  REQUIRE(status["max"].get<uint64_t>() == 5000);
+}
+
+TEST_CASE("metrics go from the registry when they do", "[util][metrics]")
+{
+  {
+    metrics::Counter counter{"lokinet_test_scoped_total", "gone soon"};
+    REQUIRE(metrics::Prometheus().find("lokinet_test_scoped_total") != std::string::npos);
+  }
+  REQUIRE(metrics::Prometheus().find("lokinet_test_scoped_total") == std::string::npos);
+}
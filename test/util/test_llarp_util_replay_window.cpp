@@ -0,0 +1,56 @@
+#include <llarp/util/replay_window.hpp>
+#include <catch2/catch.hpp>
+
+using ReplayWindow_t = llarp::util::ReplayWindow<256>;
+
+TEST_CASE("ReplayWindow rejects duplicates", "[replay-window]")
+{
+  ReplayWindow_t window;
+  REQUIRE_FALSE(window.Contains(0));
+  REQUIRE(window.Insert(0));
+  REQUIRE(window.Contains(0));
+  REQUIRE_FALSE(window.Insert(0));
+
+  // out of order within the window is fine, once
+  REQUIRE(window.Insert(10));
+  REQUIRE(window.Insert(5));
+  REQUIRE_FALSE(window.Insert(5));
+  REQUIRE_FALSE(window.Contains(4));
+  REQUIRE_FALSE(window.Contains(11));
+  REQUIRE(window.Size() == 3);
+}
+
+TEST_CASE("ReplayWindow slides", "[replay-window]")
+{
+  ReplayWindow_t window;
+  REQUIRE(window.Insert(100));
+  REQUIRE(window.Insert(100 + ReplayWindow_t::Window - 1));
+  // 100 is now at the very bottom of the window
+  REQUIRE(window.Contains(100));
+  REQUIRE_FALSE(window.Contains(101));
+  REQUIRE(window.Insert(101));
+
+  REQUIRE(window.Insert(100 + ReplayWindow_t::Window));
+  // too old to tell counts as seen
+  REQUIRE(window.Contains(100));
+  REQUIRE_FALSE(window.Insert(100));
+  REQUIRE(window.Contains(101));
+}
+
+TEST_CASE("ReplayWindow forgets words it slides over", "[replay-window]")
+{
+  ReplayWindow_t window;
+  for (uint64_t seqno = 0; seqno < 64; ++seqno)
+    REQUIRE(window.Insert(seqno));
+  // a jump well past the whole ring must not leave old bits aliasing new sequence numbers
+  const uint64_t jump = 10 * 256;
+  REQUIRE(window.Insert(jump + 63));
+  REQUIRE(window.Size() == 1);
+  for (uint64_t seqno = jump; seqno < jump + 63; ++seqno)
+    REQUIRE_FALSE(window.Contains(seqno));
+
+  // sliding by one word at a time clears just that word
+  REQUIRE(window.Insert(jump + 64 + 5));
+  REQUIRE_FALSE(window.Contains(jump + 64));
+  REQUIRE(window.Contains(jump + 63));
+}
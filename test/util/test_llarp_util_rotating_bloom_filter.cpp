@@ -0,0 +1,52 @@
+#include <llarp/util/rotating_bloom_filter.hpp>
+
+#include <catch2/catch.hpp>
+
+using Filter_t = llarp::util::RotatingBloomFilter<uint64_t>;
+
+TEST_CASE("RotatingBloomFilter remembers for one to two intervals", "[bloom]")
+{
+  static constexpr auto timeout = 5s;
+  static constexpr auto now = 1s;
+  Filter_t filter{timeout};
+  REQUIRE(filter.Empty());
+  REQUIRE(not filter.Contains(42));
+  REQUIRE(filter.Insert(42, now));
+  REQUIRE(filter.Contains(42));
+  REQUIRE_FALSE(filter.Insert(42, now));
+
+  // first rotation keeps it, second drops it
+  filter.Decay(now + timeout);
+  REQUIRE(filter.Contains(42));
+  filter.Decay(now + timeout + 1s);
+  REQUIRE(filter.Contains(42));
+  filter.Decay(now + timeout * 2);
+  REQUIRE(not filter.Contains(42));
+  REQUIRE(filter.Empty());
+}
+
+TEST_CASE("RotatingBloomFilter false positives stay bounded", "[bloom]")
+{
+  Filter_t filter{1h};
+  // many more than fit in one generation, forcing early rotations
+  uint64_t rejected = 0;
+  for (uint64_t v = 0; v < Filter_t::Capacity * 10; ++v)
+  {
+    if (not filter.Insert(v * 0x100000001b3))
+      ++rejected;
+  }
+  REQUIRE(rejected < Filter_t::Capacity * 10 / 100);
+  REQUIRE(filter.Size() <= Filter_t::Capacity * 2);
+
+  // the most recent values are all still there
+  for (uint64_t v = Filter_t::Capacity * 9; v < Filter_t::Capacity * 10; ++v)
+    REQUIRE(filter.Contains(v * 0x100000001b3));
+
+  uint64_t fp = 0;
+  for (uint64_t v = 0; v < 100000; ++v)
+  {
+    if (filter.Contains((v << 40) | 0xabcdef))
+      ++fp;
+  }
+  REQUIRE(fp < 1000);
+}
@@ -0,0 +1,69 @@
+#include <llarp/util/sequence_window.hpp>
+#include <catch2/catch.hpp>
+
+#include <string>
+
+using llarp::util::SequenceWindow;
+
+TEST_CASE("SequenceWindow insert find erase", "[sequence-window]")
+{
+  SequenceWindow<std::string> window{1024, 4};
+  REQUIRE(window.Empty());
+  REQUIRE_FALSE(window.First().has_value());
+  for (uint64_t id = 100; id < 110; ++id)
+  {
+    auto [ptr, inserted] = window.Emplace(id, std::to_string(id));
+    REQUIRE(inserted);
+    REQUIRE(*ptr == std::to_string(id));
+  }
+  REQUIRE(window.Size() == 10);
+  REQUIRE(window.Capacity() == 16);
+  REQUIRE(window.Find(99) == nullptr);
+  REQUIRE(window.Find(110) == nullptr);
+  REQUIRE(*window.Find(105) == "105");
+
+  auto [existing, inserted] = window.Emplace(105, "nope");
+  REQUIRE_FALSE(inserted);
+  REQUIRE(*existing == "105");
+
+  REQUIRE(window.Erase(105));
+  REQUIRE_FALSE(window.Erase(105));
+  REQUIRE_FALSE(window.Contains(105));
+  auto taken = window.Take(100);
+  REQUIRE(taken);
+  REQUIRE(*taken == "100");
+  REQUIRE(window.Size() == 8);
+  REQUIRE(window.First() == 101);
+
+  std::vector<uint64_t> seen;
+  window.ForEach([&seen](uint64_t id, const std::string& val) {
+    REQUIRE(val == std::to_string(id));
+    seen.push_back(id);
+  });
+  REQUIRE(seen == std::vector<uint64_t>{101, 102, 103, 104, 106, 107, 108, 109});
+  REQUIRE(window.Select([](uint64_t id, const auto&) { return id % 2; })
+          == std::vector<uint64_t>{101, 103, 107, 109});
+}
+
+TEST_CASE("SequenceWindow bounds", "[sequence-window]")
+{
+  SequenceWindow<int> window{8};
+  REQUIRE(window.Emplace(1000, 1).second);
+  // out of order, including below the current lowest id, is fine within the span
+  REQUIRE(window.Emplace(995, 2).second);
+  REQUIRE(window.Emplace(1002, 3).second);
+  // but not once the span would exceed the maximum capacity
+  REQUIRE(window.Emplace(1003, 4).first == nullptr);
+  REQUIRE(window.Emplace(994, 4).first == nullptr);
+  // retiring the lowest id slides the window forward
+  REQUIRE(window.Erase(995));
+  REQUIRE(window.Emplace(1007, 5).second);
+  REQUIRE(window.Size() == 3);
+  // emptying resets it entirely
+  window.Erase(1000);
+  window.Erase(1002);
+  window.Erase(1007);
+  REQUIRE(window.Empty());
+  REQUIRE(window.Emplace(5, 6).second);
+  REQUIRE(*window.Find(5) == 6);
+}
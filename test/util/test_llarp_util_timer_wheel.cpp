@@ -0,0 +1,59 @@
+#include <llarp/util/timer_wheel.hpp>
+
+#include <map>
+#include <vector>
+#include <catch2/catch.hpp>
+
+using llarp::util::TimerWheel;
+
+TEST_CASE("TimerWheel hands values back once due", "[timer-wheel]")
+{
+  TimerWheel<int> wheel{100ms};
+  const llarp_time_t start = 1000s;
+  wheel.Advance(start, [](int) { FAIL("nothing scheduled"); });
+
+  // spread over every level, including past the top level's span
+  const std::vector<llarp_time_t> deadlines{
+      start, start + 50ms, start + 1s, start + 30s, start + 20min, start + 2h, start + 24h * 60};
+  for (size_t idx = 0; idx < deadlines.size(); ++idx)
+    wheel.Schedule(deadlines[idx], idx);
+  REQUIRE(wheel.Size() == deadlines.size());
+
+  std::map<int, llarp_time_t> fired;
+  llarp_time_t now = start;
+  while (wheel.Size())
+  {
+    now += 100ms + (now.count() % 7 == 0 ? 10min : 0s);
+    wheel.Advance(now, [&](int idx) { fired.emplace(idx, now); });
+  }
+  REQUIRE(fired.size() == deadlines.size());
+  for (const auto& [idx, at] : fired)
+    REQUIRE(at >= deadlines[idx]);
+}
+
+TEST_CASE("TimerWheel is never early and at most a tick late", "[timer-wheel]")
+{
+  TimerWheel<llarp_time_t> wheel{10ms};
+  llarp_time_t now = 5s;
+  wheel.Advance(now, [](auto) {});
+  for (llarp_time_t dlt = 1ms; dlt < 10min; dlt = dlt * 3 / 2 + 1ms)
+    wheel.Schedule(now + dlt, now + dlt);
+
+  size_t count = 0;
+  const auto total = wheel.Size();
+  while (wheel.Size())
+  {
+    now += 1ms;
+    wheel.Advance(now, [&](llarp_time_t when) {
+      REQUIRE(when <= now);
+      REQUIRE(now - when <= 10ms);
+      // rescheduling from inside visit works
+      if (count++ % 2 == 0)
+        wheel.Schedule(now + 1h, now + 1h);
+    });
+    if (count >= total)
+      break;
+  }
+  REQUIRE(count == total);
+  REQUIRE(wheel.Size() == (total + 1) / 2);
+}
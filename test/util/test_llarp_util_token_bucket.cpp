@@ -0,0 +1,86 @@
+#include <llarp/util/token_bucket.hpp>
+
+#include <catch2/catch.hpp>
+
+using llarp::util::TokenBucket;
+using namespace std::literals;
+
+TEST_CASE("TokenBucket unlimited", "[token_bucket]")
+{
+  TokenBucket bucket;
+  REQUIRE(bucket.Unlimited());
+  for (int i = 0; i < 1000; ++i)
+  {
+    REQUIRE(bucket.Ready(1s));
+    bucket.Consume(1'000'000);
+  }
+  REQUIRE(bucket.Full(1s));
+}
+
+TEST_CASE("TokenBucket bursts then holds to its rate", "[token_bucket]")
+{
+  // 1000 a second, bursts of 500
+  TokenBucket bucket{1000, 500};
+  const llarp_time_t start = 10s;
+  REQUIRE(bucket.Full(start));
+
+  // the burst goes at once, and the send that overdraws it still goes
+  uint64_t sent = 0;
+  while (bucket.Ready(start))
+  {
+    bucket.Consume(100);
+    sent += 100;
+  }
+  REQUIRE(sent == 500);
+
+  SECTION("debt is paid off before anything else goes")
+  {
+    bucket.Consume(400);
+    REQUIRE_FALSE(bucket.Ready(start + 300ms));
+    REQUIRE(bucket.Ready(start + 401ms));
+  }
+
+  SECTION("over a long run we get the rate, not more")
+  {
+    for (llarp_time_t now = start; now < start + 10s; now += 1ms)
+    {
+      while (bucket.Ready(now))
+      {
+        bucket.Consume(100);
+        sent += 100;
+      }
+    }
+    // 500 burst plus 1000/s for 10s, give or take the last send
+    REQUIRE(sent >= 10'000);
+    REQUIRE(sent <= 10'600);
+  }
+
+  SECTION("idle time refills up to the burst and no further")
+  {
+    REQUIRE_FALSE(bucket.Full(start + 100ms));
+    REQUIRE(bucket.Full(start + 1h));
+    sent = 0;
+    while (bucket.Ready(start + 1h))
+    {
+      bucket.Consume(100);
+      sent += 100;
+    }
+    REQUIRE(sent == 500);
+  }
+}
+
+TEST_CASE("TokenBucket slow rates still fill", "[token_bucket]")
+{
+  // less than a token per millisecond
+  TokenBucket bucket{10, 10};
+  llarp_time_t now = 1s;
+  REQUIRE(bucket.Ready(now));
+  bucket.Consume(10);
+  REQUIRE_FALSE(bucket.Ready(now));
+  for (int i = 0; i < 150; ++i)
+  {
+    now += 1ms;
+    bucket.Ready(now);
+  }
+  REQUIRE(bucket.Ready(now));
+}
@@ -0,0 +1,81 @@
+#include <llarp/util/thread/crypto_pool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+
+using namespace std::literals;
+using llarp::thread::CryptoPool;
+using llarp::thread::InlineTask;
+
+TEST_CASE("InlineTask moves what it holds and frees it once", "[crypto_pool]")
+{
+  auto counted = std::make_shared<int>(0);
+  InlineTask task{[counted] { ++*counted; }};
+  REQUIRE(task);
+  REQUIRE(counted.use_count() == 2);
+
+  InlineTask moved{std::move(task)};
+  REQUIRE_FALSE(task);
+  REQUIRE(counted.use_count() == 2);
+  moved();
+  REQUIRE(*counted == 1);
+
+  task = std::move(moved);
+  task();
+  REQUIRE(*counted == 2);
+  task.Reset();
+  REQUIRE(counted.use_count() == 1);
+}
+
+TEST_CASE("CryptoPool keeps each shard in order", "[crypto_pool]")
+{
+  constexpr uint64_t Shards = 32;
+  constexpr int Each = 2000;
+  std::vector<std::vector<int>> seen(Shards);
+  std::atomic<int> done{0};
+  {
+    CryptoPool pool{4};
+    REQUIRE(pool.Size() == 4);
+    for (int i = 0; i < Each; ++i)
+      for (uint64_t shard = 0; shard < Shards; ++shard)
+        pool.Queue(shard, [&seen, &done, shard, i] {
+          seen[shard].push_back(i);
+          ++done;
+        });
+    for (int waited = 0; done < int{Shards} * Each and waited < 1000; ++waited)
+      std::this_thread::sleep_for(10ms);
+  }
+  REQUIRE(done == int{Shards} * Each);
+  for (const auto& got : seen)
+  {
+    REQUIRE(got.size() == Each);
+    REQUIRE(std::is_sorted(got.begin(), got.end()));
+  }
+}
+
+TEST_CASE("CryptoPool spreads a busy worker's shards to idle ones", "[crypto_pool]")
+{
+  CryptoPool pool{2};
+  std::mutex mutex;
+  std::vector<std::thread::id> ran;
+  std::atomic<int> done{0};
+  // shards 0 and 2 both start out on the first worker, which is held up by the first
+  for (uint64_t shard : {0, 2})
+    pool.Queue(shard, [&, shard] {
+      if (shard == 0)
+        std::this_thread::sleep_for(200ms);
+      std::lock_guard lock{mutex};
+      ran.push_back(std::this_thread::get_id());
+      ++done;
+    });
+  for (int waited = 0; done < 2 and waited < 100; ++waited)
+    std::this_thread::sleep_for(10ms);
+  REQUIRE(done == 2);
+  REQUIRE(ran[0] != ran[1]);
+}
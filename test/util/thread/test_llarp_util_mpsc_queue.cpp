@@ -0,0 +1,77 @@
+#include <llarp/util/thread/mpsc_queue.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+
+using llarp::thread::MPSCQueue;
+
+TEST_CASE("MPSCQueue drains in order and asks for one wakeup per drain", "[mpsc_queue]")
+{
+  MPSCQueue<int> queue;
+  REQUIRE(queue.Empty());
+  REQUIRE(queue.Push(1));
+  REQUIRE_FALSE(queue.Push(2));
+  REQUIRE_FALSE(queue.Push(3));
+
+  std::vector<int> got;
+  const auto take = [&got](int val) { got.push_back(val); };
+  // more than the batch is left for next time, and says so
+  REQUIRE(queue.Drain(take, 2));
+  REQUIRE(got == std::vector<int>{1, 2});
+  // having started a drain, the next push wakes us again
+  REQUIRE(queue.Push(4));
+  REQUIRE_FALSE(queue.Drain(take, 10));
+  REQUIRE(got == std::vector<int>{1, 2, 3, 4});
+  REQUIRE(queue.Empty());
+
+  // and what is left when it goes is freed with it
+  MPSCQueue<std::shared_ptr<int>> owning;
+  auto ptr = std::make_shared<int>(5);
+  owning.Push(ptr);
+  owning.Push(ptr);
+  REQUIRE(ptr.use_count() == 3);
+  owning.Drain([](auto) {}, 1);
+  REQUIRE(ptr.use_count() == 2);
+  {
+    MPSCQueue<std::shared_ptr<int>> dropped;
+    dropped.Push(ptr);
+  }
+  REQUIRE(ptr.use_count() == 2);
+}
+
+TEST_CASE("MPSCQueue takes pushes from many threads", "[mpsc_queue]")
+{
+  constexpr int Producers = 4, Each = 20000;
+  MPSCQueue<std::pair<int, int>> queue;
+  std::atomic<int> wakeups{0};
+  std::vector<std::thread> producers;
+  for (int p = 0; p < Producers; ++p)
+    producers.emplace_back([&, p] {
+      for (int i = 0; i < Each; ++i)
+        if (queue.Push({p, i}))
+          ++wakeups;
+    });
+
+  // each producer's values come out in the order it pushed them, and none go missing
+  std::vector<int> next(Producers, 0);
+  int got = 0;
+  bool ordered = true;
+  while (got < Producers * Each)
+  {
+    queue.Drain(
+        [&](auto val) {
+          ordered = ordered and val.second == next[val.first];
+          next[val.first] = val.second + 1;
+          ++got;
+        },
+        256);
+  }
+  for (auto& t : producers)
+    t.join();
+  REQUIRE(ordered);
+  REQUIRE(queue.Empty());
+  REQUIRE(wakeups <= got);
+}
@@ -2,10 +2,13 @@
 #include <llarp/util/thread/threading.hpp>
 #include <llarp/util/thread/barrier.hpp>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <thread>
+#include <vector>
 
 #include <catch2/catch.hpp>
 
@@ -569,3 +572,134 @@ TEST_CASE("Move it")
   // Moved twice here to construct the optional.
   REQUIRE(6u == counter);
 }
+
+TEST_CASE("Batch push and pop")
+{
+  static constexpr size_t queueSize = 8;
+
+  Queue<int> queue{queueSize};
+
+  std::vector<int> out;
+
+  REQUIRE(0u == queue.tryPopMany(std::back_inserter(out), 4));
+
+  // Go round enough times to wrap the buffer and the generation count
+  int next = 0;
+  for (size_t round = 0; round < 50; ++round)
+  {
+    std::vector<int> in;
+    for (size_t i = 0; i < 5; ++i)
+    {
+      in.push_back(next++);
+    }
+
+    REQUIRE(5u == queue.tryPushMany(in.begin(), in.end()));
+    REQUIRE(5u == queue.size());
+
+    // Only as many as there's room for go in
+    std::vector<int> more{next, next + 1, next + 2, next + 3};
+    REQUIRE(3u == queue.tryPushMany(more.begin(), more.end()));
+    REQUIRE(queue.full());
+    REQUIRE(0u == queue.tryPushMany(more.begin() + 3, more.end()));
+    next += 3;
+
+    out.clear();
+    REQUIRE(2u == queue.popMany(std::back_inserter(out), 2));
+    REQUIRE(6u == queue.tryPopMany(std::back_inserter(out), 100));
+    REQUIRE(queue.empty());
+
+    REQUIRE(8u == out.size());
+    for (size_t i = 0; i < out.size(); ++i)
+    {
+      REQUIRE(out[i] == next - 8 + static_cast<int>(i));
+    }
+  }
+
+  // Single element operations still line up with batches
+  REQUIRE(QueueReturn::Success == queue.tryPushBack(1));
+  std::vector<int> in{2, 3};
+  REQUIRE(2u == queue.tryPushMany(in.begin(), in.end()));
+  REQUIRE(1 == queue.popFront());
+  out.clear();
+  REQUIRE(2u == queue.tryPopMany(std::back_inserter(out), 2));
+  REQUIRE(out == std::vector<int>{2, 3});
+
+  queue.disable();
+  REQUIRE(0u == queue.tryPushMany(in.begin(), in.end()));
+}
+
+TEST_CASE("Batch many producer many consumer")
+{
+  static constexpr int iterations = 20 * 1000;
+  static constexpr size_t numThreads = 4;
+  static constexpr size_t batch = 16;
+
+  // producer in the high bits, sequence number in the low
+  Queue<uint64_t> queue{64};
+
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::vector<std::vector<uint64_t>> seen(numThreads);
+
+  for (size_t p = 0; p < numThreads; ++p)
+  {
+    threads.emplace_back([&queue, p] {
+      std::vector<uint64_t> in;
+      for (int i = 0; i < iterations; ++i)
+      {
+        in.push_back((uint64_t{p} << 32) | static_cast<uint32_t>(i));
+        if (in.size() < batch && i + 1 < iterations)
+        {
+          continue;
+        }
+        auto begin = in.begin();
+        while (begin != in.end())
+        {
+          begin += queue.tryPushMany(begin, in.end());
+        }
+        in.clear();
+      }
+    });
+  }
+
+  std::atomic<size_t> total{0};
+  for (size_t c = 0; c < numThreads; ++c)
+  {
+    threads.emplace_back([&] {
+      std::vector<uint64_t> out;
+      std::vector<std::vector<uint64_t>> mine(numThreads);
+      while (total < numThreads * iterations)
+      {
+        out.clear();
+        total += queue.tryPopMany(std::back_inserter(out), batch);
+        for (const auto val : out)
+        {
+          mine[val >> 32].push_back(val & 0xffffffff);
+        }
+      }
+      LockGuard lock(mutex);
+      for (size_t p = 0; p < numThreads; ++p)
+      {
+        seen[p].insert(seen[p].end(), mine[p].begin(), mine[p].end());
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  REQUIRE(0u == queue.size());
+
+  // Nothing lost or doubled
+  for (auto& got : seen)
+  {
+    REQUIRE(static_cast<size_t>(iterations) == got.size());
+    std::sort(got.begin(), got.end());
+    for (int i = 0; i < iterations; ++i)
+    {
+      REQUIRE(static_cast<uint64_t>(i) == got[i]);
+    }
+  }
+}
@@ -0,0 +1,115 @@
+#include <llarp/util/thread/sharded_map.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <catch2/catch.hpp>
+
+using llarp::thread::ShardedMultiMap;
+
+TEST_CASE("ShardedMultiMap lookups", "[sharded_map]")
+{
+  ShardedMultiMap<int, int> map;
+  REQUIRE_FALSE(map.FindIf(1, [](int) { return true; }));
+
+  // enough to grow every shard a few times
+  for (int key = 0; key < 10000; ++key)
+    map.Insert(key, key * 2);
+  map.Insert(7, 100);
+  REQUIRE(map.Size() == 10001);
+
+  for (int key = 0; key < 10000; ++key)
+    REQUIRE(map.FindIf(key, [key](int v) { return v == key * 2; }));
+  // both values under a repeated key are there
+  REQUIRE(map.FindIf(7, [](int v) { return v == 14; }));
+  REQUIRE(map.FindIf(7, [](int v) { return v == 100; }));
+  REQUIRE_FALSE(map.FindIf(7, [](int v) { return v == 15; }));
+  REQUIRE_FALSE(map.FindIf(10000, [](int) { return true; }));
+
+  size_t visited = 0;
+  map.ForEach([&visited](int, int) { ++visited; });
+  REQUIRE(visited == 10001);
+
+  // by key, only the matching value goes
+  REQUIRE(map.EraseIf(7, [](int v) { return v == 100; }) == 1);
+  REQUIRE(map.EraseIf(7, [](int v) { return v == 100; }) == 0);
+  REQUIRE(map.FindIf(7, [](int v) { return v == 14; }));
+  REQUIRE(map.Size() == 10000);
+
+  REQUIRE(map.EraseIf([](int key, int) { return key % 2; }) == 5000);
+  REQUIRE(map.Size() == 5000);
+  REQUIRE_FALSE(map.FindIf(7, [](int) { return true; }));
+  REQUIRE(map.FindIf(8, [](int) { return true; }) == 16);
+  llarp::thread::epoch::Collect();
+}
+
+TEST_CASE("ShardedMultiMap concurrent readers", "[sharded_map]")
+{
+  ShardedMultiMap<int, std::shared_ptr<int>> map;
+  for (int key = 0; key < 1000; ++key)
+    map.Insert(key, std::make_shared<int>(key));
+
+  std::atomic<bool> done{false};
+  std::atomic<bool> bad{false};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t)
+  {
+    readers.emplace_back([&] {
+      while (not done)
+      {
+        // the stable half is always found, with the value it was inserted with
+        for (int key = 0; key < 1000; key += 2)
+        {
+          auto found = map.FindIf(key, [](const auto&) { return true; });
+          if (not found or **found != key)
+            bad = true;
+        }
+        map.ForEach([&](int key, const auto& value) {
+          if (*value != key)
+            bad = true;
+        });
+      }
+    });
+  }
+  // churn the odd half and grow the table underneath the readers
+  for (int round = 0; round < 20; ++round)
+  {
+    map.EraseIf([](int key, const auto&) { return key < 1000 and key % 2; });
+    for (int key = 1; key < 1000; key += 2)
+      map.Insert(key, std::make_shared<int>(key));
+    for (int key = 1000 + round * 1000; key < 2000 + round * 1000; ++key)
+      map.Insert(key, std::make_shared<int>(key));
+  }
+  done = true;
+  for (auto& t : readers)
+    t.join();
+  REQUIRE_FALSE(bad);
+  REQUIRE(map.Size() == 21000);
+  llarp::thread::epoch::Collect();
+}
+
+TEST_CASE("ShardedMultiMap updates in place", "[sharded_map]")
+{
+  ShardedMultiMap<int, int> map;
+  // adds from a default value when there is nothing there
+  map.Update(1, [](int& v) { v += 5; });
+  REQUIRE(map.FindIf(1, [](int) { return true; }) == 5);
+  REQUIRE(map.Size() == 1);
+
+  map.Update(1, [](int& v) { v *= 3; });
+  REQUIRE(map.FindIf(1, [](int) { return true; }) == 15);
+  REQUIRE(map.Size() == 1);
+
+  // and grows the table as Insert does
+  for (int key = 2; key < 1000; ++key)
+    map.Update(key, [key](int& v) { v = key; });
+  REQUIRE(map.Size() == 999);
+  size_t seen = 0;
+  map.ForEach([&seen](int key, int v) {
+    if (key == 1 ? v == 15 : v == key)
+      ++seen;
+  });
+  REQUIRE(seen == 999);
+  llarp::thread::epoch::Collect();
+}
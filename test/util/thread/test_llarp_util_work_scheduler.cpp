@@ -0,0 +1,123 @@
+#include <llarp/util/thread/work_scheduler.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+#include <catch2/catch.hpp>
+
+using llarp::thread::WorkClass;
+using llarp::thread::WorkScheduler;
+
+namespace
+{
+  /// a pool we run by hand, one job at a time
+  struct Pool
+  {
+    std::deque<WorkScheduler::Job> jobs;
+
+    WorkScheduler::Dispatch
+    Dispatch()
+    {
+      return [this](auto job) { jobs.push_back(std::move(job)); };
+    }
+
+    void
+    RunOne()
+    {
+      auto job = std::move(jobs.front());
+      jobs.pop_front();
+      job();
+    }
+  };
+}  // namespace
+
+TEST_CASE("WorkScheduler gives slots out by class weight", "[work_scheduler]")
+{
+  Pool pool;
+  WorkScheduler sched{pool.Dispatch(), 1};
+  std::vector<WorkClass> ran;
+  const auto job = [&ran](WorkClass cls) { return [&ran, cls] { ran.push_back(cls); }; };
+
+  // the one slot is taken, so everything after waits in its class's queue
+  sched.Queue(WorkClass::Background, job(WorkClass::Background));
+  REQUIRE(pool.jobs.size() == 1);
+  for (int i = 0; i < 20; ++i)
+    for (auto cls : {WorkClass::Background, WorkClass::PathBuild, WorkClass::DataPlane})
+      sched.Queue(cls, job(cls));
+  REQUIRE(pool.jobs.size() == 1);
+  REQUIRE(sched.Queued(WorkClass::DataPlane) == 20);
+  pool.RunOne();
+  ran.clear();
+
+  // a whole round of weights, 8 + 4 + 1, with data plane first
+  for (int i = 0; i < 13; ++i)
+    pool.RunOne();
+  REQUIRE(ran.front() == WorkClass::DataPlane);
+  REQUIRE(std::count(ran.begin(), ran.end(), WorkClass::DataPlane) == 8);
+  REQUIRE(std::count(ran.begin(), ran.end(), WorkClass::PathBuild) == 4);
+  REQUIRE(std::count(ran.begin(), ran.end(), WorkClass::Background) == 1);
+
+  // once the others are done the rest get every slot
+  while (not pool.jobs.empty())
+    pool.RunOne();
+  REQUIRE(ran.size() == 60);
+  REQUIRE(sched.Queued(WorkClass::Background) == 0);
+  REQUIRE(sched.Running(WorkClass::Background) == 0);
+}
+
+TEST_CASE("WorkScheduler keeps slow classes to their share", "[work_scheduler]")
+{
+  Pool pool;
+  WorkScheduler sched{pool.Dispatch(), 4};
+  for (int i = 0; i < 4; ++i)
+  {
+    sched.Queue(WorkClass::Background, [] {});
+    sched.Queue(WorkClass::PathBuild, [] {});
+  }
+  REQUIRE(sched.Running(WorkClass::Background) == 1);
+  REQUIRE(sched.Running(WorkClass::PathBuild) == 2);
+  REQUIRE(sched.Queued(WorkClass::Background) == 3);
+  REQUIRE(pool.jobs.size() == 3);
+
+  // which leaves a slot free for data plane work straight away
+  sched.Queue(WorkClass::DataPlane, [] {});
+  REQUIRE(pool.jobs.size() == 4);
+  REQUIRE(sched.Running(WorkClass::DataPlane) == 1);
+
+  // and a job that throws still gives its slot back
+  sched.Queue(WorkClass::DataPlane, [] { throw std::runtime_error{"oops"}; });
+  while (not pool.jobs.empty())
+  {
+    try
+    {
+      pool.RunOne();
+    }
+    catch (const std::runtime_error&)
+    {}
+  }
+  REQUIRE(sched.Queued(WorkClass::Background) == 0);
+  REQUIRE(sched.ExtractStatus()["background"]["ran"] == 4);
+}
+
+TEST_CASE("WorkScheduler drops the oldest past a class's limit", "[work_scheduler]")
+{
+  auto classes = WorkScheduler::DefaultClasses;
+  classes[0].limit = 2;
+  Pool pool;
+  WorkScheduler sched{pool.Dispatch(), 1, classes};
+  std::vector<int> ran;
+
+  sched.Queue(WorkClass::PathBuild, [] {});
+  for (int i = 0; i < 3; ++i)
+    sched.Queue(WorkClass::DataPlane, [&ran, i] { ran.push_back(i); });
+  REQUIRE(sched.Queued(WorkClass::DataPlane) == 2);
+
+  while (not pool.jobs.empty())
+    pool.RunOne();
+  REQUIRE(ran == std::vector<int>{1, 2});
+  const auto status = sched.ExtractStatus();
+  REQUIRE(status["dataPlane"]["dropped"] == 1);
+  REQUIRE(status["dataPlane"]["ran"] == 2);
+  REQUIRE(status["dataPlane"]["waitMicros"]["count"] == 2);
+}
@@ -0,0 +1,121 @@
+#include <llarp/vpn/offload.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <oxenc/endian.h>
+
+#include <cstring>
+
+using llarp::byte_t;
+using llarp::net::IPPacket;
+using llarp::vpn::VNetHeader;
+
+/// an ipv4 tcp packet of payload bytes of n from 10.0.0.1:1000 to 10.0.0.2:2000
+static std::vector<byte_t>
+TCPv4(size_t payload, uint32_t seq, byte_t flags, byte_t n = 0)
+{
+  std::vector<byte_t> pkt(40 + payload, n);
+  std::fill_n(pkt.begin(), 40, 0);
+  pkt[0] = 0x45;
+  oxenc::write_host_as_big<uint16_t>(pkt.size(), pkt.data() + 2);
+  oxenc::write_host_as_big<uint16_t>(0x4000, pkt.data() + 6);
+  pkt[8] = 64;
+  pkt[9] = 6;
+  const byte_t addrs[] = {10, 0, 0, 1, 10, 0, 0, 2};
+  std::copy_n(addrs, sizeof(addrs), pkt.data() + 12);
+  oxenc::write_host_as_big<uint16_t>(1000, pkt.data() + 20);
+  oxenc::write_host_as_big<uint16_t>(2000, pkt.data() + 22);
+  oxenc::write_host_as_big(seq, pkt.data() + 24);
+  pkt[32] = 0x50;
+  pkt[33] = flags;
+  oxenc::write_host_as_big<uint16_t>(512, pkt.data() + 34);
+  return pkt;
+}
+
+/// whether the tcp checksum of an ipv4 packet checks out
+static bool
+GoodChecksum(const byte_t* pkt, size_t sz)
+{
+  uint32_t sum = 0;
+  for (size_t i = 12; i < 20; i += 2)
+  {
+    uint16_t word;
+    std::memcpy(&word, pkt + i, sizeof(word));
+    sum += word;
+  }
+  sum += oxenc::host_to_big<uint16_t>(6);
+  sum += oxenc::host_to_big<uint16_t>(sz - 20);
+  return llarp::net::ipchksum(pkt + 20, sz - 20, sum) == 0
+      and llarp::net::ipchksum(pkt, 20) == 0;
+}
+
+TEST_CASE("tcp super packets are cut into segments", "[offload]")
+{
+  auto super = TCPv4(2500, 1000, 0x18 | 0x01);
+  VNetHeader hdr{};
+  hdr.flags = VNetHeader::NeedsChecksum;
+  hdr.gso_type = VNetHeader::GSOTCPv4;
+  hdr.hdr_len = 40;
+  hdr.gso_size = 1000;
+  hdr.csum_start = 20;
+  hdr.csum_offset = 16;
+
+  std::vector<IPPacket> pkts;
+  llarp::vpn::SegmentOffloaded(hdr, super.data(), super.size(), pkts);
+  REQUIRE(pkts.size() == 3);
+  const size_t sizes[] = {1040, 1040, 540};
+  for (size_t i = 0; i < pkts.size(); ++i)
+  {
+    const byte_t* pkt = pkts[i].data();
+    REQUIRE(pkts[i].size() == sizes[i]);
+    REQUIRE(oxenc::load_big_to_host<uint16_t>(pkt + 2) == sizes[i]);
+    REQUIRE(oxenc::load_big_to_host<uint16_t>(pkt + 4) == i);
+    REQUIRE(oxenc::load_big_to_host<uint32_t>(pkt + 24) == 1000 + i * 1000);
+    // push and fin only on the last one
+    REQUIRE(pkt[33] == (i == 2 ? 0x19 : 0x10));
+    REQUIRE(GoodChecksum(pkt, pkts[i].size()));
+  }
+
+  // unknown gso types are dropped
+  hdr.gso_type = 3;
+  llarp::vpn::SegmentOffloaded(hdr, super.data(), super.size(), pkts);
+  REQUIRE(pkts.size() == 3);
+}
+
+TEST_CASE("segments of one flow are written as one", "[offload]")
+{
+  std::vector<IPPacket> pkts;
+  pkts.emplace_back(TCPv4(1000, 1, 0x10, 1));
+  pkts.emplace_back(TCPv4(1000, 1001, 0x10, 2));
+  pkts.emplace_back(TCPv4(300, 2001, 0x18, 3));
+  // after a short one the run is over
+  pkts.emplace_back(TCPv4(1000, 2301, 0x10, 4));
+  pkts.emplace_back(TCPv4(1000, 9999, 0x10, 5));
+
+  std::vector<byte_t> out;
+  REQUIRE(llarp::vpn::CoalesceSegments(pkts, 0, out) == 3);
+  VNetHeader hdr;
+  std::memcpy(&hdr, out.data(), sizeof(hdr));
+  REQUIRE(hdr.gso_type == VNetHeader::GSOTCPv4);
+  REQUIRE(hdr.gso_size == 1000);
+  REQUIRE(hdr.hdr_len == 40);
+  REQUIRE(out.size() == sizeof(hdr) + 40 + 2300);
+
+  // and cutting that up again gets back what went in
+  std::vector<IPPacket> again;
+  llarp::vpn::SegmentOffloaded(hdr, out.data() + sizeof(hdr), out.size() - sizeof(hdr), again);
+  REQUIRE(again.size() == 3);
+  for (size_t i = 0; i < again.size(); ++i)
+  {
+    REQUIRE(again[i].size() == pkts[i].size());
+    REQUIRE(std::equal(pkts[i].data() + 40, pkts[i].data() + pkts[i].size(), again[i].data() + 40));
+    REQUIRE(again[i].data()[33] == pkts[i].data()[33]);
+    REQUIRE(GoodChecksum(again[i].data(), again[i].size()));
+  }
+
+  // the next one does not follow on from the one before it
+  REQUIRE(llarp::vpn::CoalesceSegments(pkts, 3, out) == 1);
+  std::memcpy(&hdr, out.data(), sizeof(hdr));
+  REQUIRE(hdr.gso_type == VNetHeader::GSONone);
+  REQUIRE(out.size() == sizeof(hdr) + pkts[3].size());
+}
@@ -0,0 +1,95 @@
+#include <llarp/vpn/packet_ring.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <poll.h>
+
+#include <cstring>
+
+using llarp::byte_t;
+using llarp::net::IPPacket;
+using llarp::vpn::PacketRing;
+
+static IPPacket
+Filled(size_t sz, byte_t n)
+{
+  return IPPacket{std::vector<byte_t>(sz, n)};
+}
+
+static bool
+Readable(const PacketRing& ring)
+{
+  pollfd pfd{ring.PollFD(), POLLIN, 0};
+  return ::poll(&pfd, 1, 0) == 1;
+}
+
+TEST_CASE("packet ring slots must be a power of 2", "[vpn]")
+{
+  REQUIRE_THROWS_AS(PacketRing{0}, std::invalid_argument);
+  REQUIRE_THROWS_AS(PacketRing{6}, std::invalid_argument);
+  REQUIRE_NOTHROW(PacketRing{8});
+}
+
+TEST_CASE("packet ring moves packets in order and fills up", "[vpn]")
+{
+  PacketRing ring{4};
+  REQUIRE(ring.Free() == 4);
+  for (byte_t n = 0; n < 4; ++n)
+    REQUIRE(ring.Put(Filled(20 + n, n)));
+  REQUIRE_FALSE(ring.Put(Filled(20, 9)));
+  REQUIRE(ring.Available() == 4);
+
+  for (byte_t n = 0; n < 4; ++n)
+  {
+    const auto pkt = ring.Peek(n);
+    REQUIRE(pkt.size() == 20u + n);
+    REQUIRE(pkt.data()[0] == n);
+  }
+  REQUIRE(ring.Release(3) == 1);
+
+  // the indices wrap around the slots
+  REQUIRE(ring.Put(Filled(30, 7)));
+  REQUIRE(ring.Peek(0).size() == 23);
+  REQUIRE(ring.Peek(1).size() == 30);
+  REQUIRE(ring.Release(2) == 0);
+}
+
+TEST_CASE("packet ring lays out slots as length then packet", "[vpn]")
+{
+  PacketRing ring{2};
+  REQUIRE(ring.Bytes() == 2 * PacketRing::SlotSize);
+  REQUIRE(ring.Put(Filled(40, 1)));
+  REQUIRE(ring.Put(Filled(50, 2)));
+
+  uint32_t len;
+  std::memcpy(&len, ring.Data() + PacketRing::SlotSize, sizeof(len));
+  REQUIRE(len == 50);
+  REQUIRE(ring.Data()[PacketRing::SlotSize + PacketRing::LengthSize] == 2);
+
+  // what the other side would write in place, published as a batch
+  ring.Release(2);
+  const uint32_t bad = PacketRing::MaxPacket + 1;
+  std::memcpy(ring.Data(), &bad, sizeof(bad));
+  ring.Publish(1);
+  REQUIRE(ring.Peek(0).empty());
+}
+
+TEST_CASE("packet ring only wakes the consumer when it was empty", "[vpn]")
+{
+  PacketRing ring{8};
+  REQUIRE_FALSE(Readable(ring));
+
+  REQUIRE(ring.Put(Filled(20, 0)));
+  REQUIRE(Readable(ring));
+  ring.ClearWakeup();
+
+  // the consumer has not caught up, so it will see these without another wakeup
+  REQUIRE(ring.Stage(0, Filled(20, 1)));
+  REQUIRE(ring.Stage(1, Filled(20, 2)));
+  ring.Publish(2);
+  REQUIRE_FALSE(Readable(ring));
+
+  REQUIRE(ring.Release(3) == 0);
+  REQUIRE(ring.Put(Filled(20, 3)));
+  REQUIRE(Readable(ring));
+}
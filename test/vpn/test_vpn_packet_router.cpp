@@ -0,0 +1,43 @@
+#include <llarp/vpn/packet_router.hpp>
+
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+using llarp::huint16_t;
+using llarp::huint32_t;
+using llarp::net::IPPacket;
+
+static IPPacket
+UDPTo(uint16_t port)
+{
+  return IPPacket::make_udp(
+      llarp::net::ToNet(huint32_t{0x0a000001}),
+      llarp::net::ToNet(huint16_t{4000}),
+      llarp::net::ToNet(huint32_t{0x0a000002}),
+      llarp::net::ToNet(huint16_t{port}),
+      std::vector<llarp::byte_t>(32));
+}
+
+TEST_CASE("PacketRouter hands packets to the handler for their port or protocol", "[vpn]")
+{
+  std::vector<std::string> got;
+  llarp::vpn::PacketRouter router{[&got](IPPacket) { got.push_back("base"); }};
+  router.AddUDPHandler(huint16_t{53}, [&got](IPPacket) { got.push_back("dns"); });
+  router.AddUDPHandler(huint16_t{53}, [&got](IPPacket) { got.push_back("second dns"); });
+  router.AddUDPHandler(huint16_t{9000}, [&got](IPPacket) { got.push_back("9000"); });
+
+  router.HandleIPPacket(UDPTo(53));
+  router.HandleIPPacket(UDPTo(9000));
+  router.HandleIPPacket(UDPTo(1234));
+  REQUIRE(got == std::vector<std::string>{"dns", "9000", "base"});
+
+  // udp for no port of ours goes to the protocol's handler, if there is one
+  got.clear();
+  router.AddIProtoHandler(0x11, [&got](IPPacket) { got.push_back("udp"); });
+  router.RemoveUDPHandler(huint16_t{9000});
+  router.HandleIPPacket(UDPTo(53));
+  router.HandleIPPacket(UDPTo(9000));
+  REQUIRE(got == std::vector<std::string>{"dns", "udp"});
+}